@@ -14,8 +14,11 @@ namespace vertexai {
 namespace eventing {
 namespace file {
 
-EventLog::EventLog(const proto::EventLog& config)
-    : config_{config},
+EventLog::EventLog(const proto::EventLog& config) : EventLog{config, GetRandomUUID()} {}
+
+EventLog::EventLog(const proto::EventLog& config, boost::uuids::uuid stream_uuid)
+    : context::EventLog{stream_uuid},
+      config_{config},
       std_file_out_{config.filename(), std::ios::binary},
       ostr_out_{std::make_unique<gpi::OstreamOutputStream>(&std_file_out_)},
       gzip_out_{std::make_unique<gpi::GzipOutputStream>(ostr_out_.get(), gpi::GzipOutputStream::Options())},
@@ -32,16 +35,20 @@ EventLog::EventLog(const proto::EventLog& config)
 EventLog::~EventLog() { FlushAndClose(); }
 
 void EventLog::LogEvent(context::proto::Event event) {
+  proto::Record record;
+  *record.add_event() = std::move(event);
+  LogRecord(std::move(record));
+}
+
+void EventLog::LogRecord(proto::Record record) {
   std::lock_guard<std::mutex> lock{mu_};
-  if (closed_) {
+  if (closed_ || !record.event_size()) {
     return;
   }
   if (!wrote_uuid_) {
-    event.mutable_activity_id()->set_stream_uuid(ToByteString(stream_uuid()));
+    record.mutable_event(0)->mutable_activity_id()->set_stream_uuid(ToByteString(stream_uuid()));
     wrote_uuid_ = true;
   }
-  proto::Record record;
-  *record.add_event() = std::move(event);
   LogRecordLocked(std::move(record));
 }
 
@@ -19,10 +19,14 @@ namespace file {
 class EventLog final : public context::EventLog {
  public:
   explicit EventLog(const proto::EventLog& config);
+  EventLog(const proto::EventLog& config, boost::uuids::uuid stream_uuid);
   ~EventLog();
 
   void LogEvent(context::proto::Event event) override;
 
+  // Writes a batch of events as a single record.
+  void LogRecord(proto::Record record);
+
   void FlushAndClose() override;
 
  private:
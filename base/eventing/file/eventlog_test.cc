@@ -2,12 +2,17 @@
 #include <gtest/gtest.h>
 
 #include <fstream>
+#include <thread>
 #include <utility>
+#include <vector>
 
 #include "base/eventing/file/eventlog.h"
 #include "base/eventing/file/eventlog.pb.h"
+#include "base/eventing/file/ring_eventlog.h"
+#include "base/eventing/file/trace_eventlog.h"
 #include "base/util/compat.h"
 #include "base/util/logging.h"
+#include "json/json.h"
 #include "testing/matchers.h"
 
 using ::testing::Eq;
@@ -49,6 +54,111 @@ TEST_F(EventLogTest, CanReport) {
   }
 }
 
+TEST(RingEventLogTest, DrainsAllThreads) {
+  constexpr int kThreads = 4;
+  constexpr int kEvents = 100;
+  proto::RingEventLog config;
+  config.set_filename(kTestFilename);
+  config.set_events_per_thread(kThreads * kEvents);
+  {
+    RingEventLog eventlog{config};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kThreads; i++) {
+      threads.emplace_back([&eventlog]() {
+        for (int j = 0; j < kEvents; j++) {
+          context::proto::Event event;
+          event.set_verb("Hello, World!");
+          eventlog.LogEvent(std::move(event));
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    eventlog.FlushAndClose();
+    EXPECT_THAT(eventlog.dropped_events(), Eq(0));
+  }
+
+  Reader reader{kTestFilename};
+  context::proto::Event event;
+  int count = 0;
+  while (reader.Read(&event)) {
+    EXPECT_THAT(event.verb(), Eq("Hello, World!"));
+    count++;
+  }
+  EXPECT_THAT(count, Eq(kThreads * kEvents));
+}
+
+TEST(RingEventLogTest, DropsOversizedEvents) {
+  proto::RingEventLog config;
+  config.set_filename(kTestFilename);
+  config.set_max_event_bytes(32);
+  {
+    RingEventLog eventlog{config};
+    context::proto::Event event;
+    event.set_verb(std::string(64, 'x'));
+    eventlog.LogEvent(std::move(event));
+    eventlog.FlushAndClose();
+    EXPECT_THAT(eventlog.dropped_events(), Eq(1));
+  }
+
+  Reader reader{kTestFilename};
+  context::proto::Event event;
+  EXPECT_THAT(reader.Read(&event), Eq(false));
+}
+
+TEST(TraceEventLogTest, WritesCompletedSpans) {
+  constexpr static char kTraceFilename[] = "trace.json";
+  proto::TraceEventLog config;
+  config.set_filename(kTraceFilename);
+  {
+    TraceEventLog eventlog{config};
+    context::proto::Event start;
+    start.mutable_activity_id()->set_index(1);
+    start.set_verb("tile::hal::opencl::Build");
+    start.mutable_start_time()->set_seconds(1);
+    eventlog.LogEvent(std::move(start));
+
+    context::proto::Event unfinished;
+    unfinished.mutable_activity_id()->set_index(2);
+    unfinished.set_verb("Unfinished");
+    unfinished.mutable_start_time()->set_seconds(1);
+    eventlog.LogEvent(std::move(unfinished));
+
+    context::proto::Event end;
+    end.mutable_activity_id()->set_index(1);
+    end.mutable_end_time()->set_seconds(2);
+    eventlog.LogEvent(std::move(end));
+
+    context::proto::Event kernel;
+    kernel.mutable_activity_id()->set_index(3);
+    kernel.mutable_clock_id()->set_index(7);
+    kernel.set_verb("tile::hal::opencl::Executing");
+    kernel.mutable_start_time()->set_nanos(1000);
+    kernel.mutable_end_time()->set_nanos(3000);
+    eventlog.LogEvent(std::move(kernel));
+  }
+
+  std::ifstream in{kTraceFilename};
+  Json::Value root;
+  in >> root;
+  std::vector<Json::Value> spans;
+  for (const auto& record : root["traceEvents"]) {
+    if (record["ph"].asString() == "X") {
+      spans.push_back(record);
+    }
+  }
+  ASSERT_THAT(spans.size(), Eq(2));
+  EXPECT_THAT(spans[0]["cat"].asString(), Eq("compile"));
+  EXPECT_THAT(spans[0]["pid"].asUInt64(), Eq(0));
+  EXPECT_THAT(spans[0]["ts"].asDouble(), Eq(1e6));
+  EXPECT_THAT(spans[0]["dur"].asDouble(), Eq(1e6));
+  EXPECT_THAT(spans[1]["cat"].asString(), Eq("kernel"));
+  EXPECT_THAT(spans[1]["pid"].asUInt64(), Eq(7));
+  EXPECT_THAT(spans[1]["ts"].asDouble(), Eq(1.0));
+  EXPECT_THAT(spans[1]["dur"].asDouble(), Eq(2.0));
+}
+
 }  // namespace
 }  // namespace file
 }  // namespace eventing
@@ -1,6 +1,8 @@
 #include "base/eventing/file/factory.h"
 
 #include "base/eventing/file/eventlog.h"
+#include "base/eventing/file/ring_eventlog.h"
+#include "base/eventing/file/trace_eventlog.h"
 #include "base/util/any_factory_map.h"
 #include "base/util/compat.h"
 
@@ -13,8 +15,20 @@ std::unique_ptr<context::EventLog> EventLogFactory::MakeTypedInstance(const cont
   return std::make_unique<EventLog>(config);
 }
 
+std::unique_ptr<context::EventLog> RingEventLogFactory::MakeTypedInstance(const context::Context& ctx,
+                                                                          const proto::RingEventLog& config) {
+  return std::make_unique<RingEventLog>(config);
+}
+
+std::unique_ptr<context::EventLog> TraceEventLogFactory::MakeTypedInstance(const context::Context& ctx,
+                                                                           const proto::TraceEventLog& config) {
+  return std::make_unique<TraceEventLog>(config);
+}
+
 [[gnu::unused]] char reg = []() -> char {
   AnyFactoryMap<context::EventLog>::Instance()->Register(std::make_unique<EventLogFactory>());
+  AnyFactoryMap<context::EventLog>::Instance()->Register(std::make_unique<RingEventLogFactory>());
+  AnyFactoryMap<context::EventLog>::Instance()->Register(std::make_unique<TraceEventLogFactory>());
   return 0;
 }();
 
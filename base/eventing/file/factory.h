@@ -15,6 +15,18 @@ class EventLogFactory final : public TypedAnyFactory<context::EventLog, proto::E
                                                        const proto::EventLog& config) override;
 };
 
+class TraceEventLogFactory final : public TypedAnyFactory<context::EventLog, proto::TraceEventLog> {
+ public:
+  std::unique_ptr<context::EventLog> MakeTypedInstance(const context::Context& ctx,
+                                                       const proto::TraceEventLog& config) override;
+};
+
+class RingEventLogFactory final : public TypedAnyFactory<context::EventLog, proto::RingEventLog> {
+ public:
+  std::unique_ptr<context::EventLog> MakeTypedInstance(const context::Context& ctx,
+                                                       const proto::RingEventLog& config) override;
+};
+
 }  // namespace file
 }  // namespace eventing
 }  // namespace vertexai
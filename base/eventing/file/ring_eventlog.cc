@@ -0,0 +1,128 @@
+#include "base/eventing/file/ring_eventlog.h"
+
+#include <utility>
+
+#include "base/util/compat.h"
+#include "base/util/logging.h"
+
+namespace vertexai {
+namespace eventing {
+namespace file {
+namespace {
+
+constexpr std::size_t kDefaultEventsPerThread = 1024;
+constexpr std::size_t kDefaultMaxEventBytes = 4096;
+constexpr std::uint32_t kDefaultDrainIntervalMs = 10;
+
+std::atomic<std::uint64_t> next_log_id{1};
+
+proto::EventLog FileConfig(const proto::RingEventLog& config) {
+  proto::EventLog result;
+  result.set_filename(config.filename());
+  return result;
+}
+
+}  // namespace
+
+RingEventLog::Ring::Ring(std::size_t capacity, std::size_t slot_bytes)
+    : slot_bytes{slot_bytes}, sizes(capacity), data(capacity * slot_bytes) {}
+
+RingEventLog::RingEventLog(const proto::RingEventLog& config)
+    : id_{next_log_id++},
+      capacity_{config.events_per_thread() ? config.events_per_thread() : kDefaultEventsPerThread},
+      slot_bytes_{config.max_event_bytes() ? config.max_event_bytes() : kDefaultMaxEventBytes},
+      drain_interval_{config.drain_interval_ms() ? config.drain_interval_ms() : kDefaultDrainIntervalMs},
+      out_{std::make_unique<file::EventLog>(FileConfig(config), stream_uuid())},
+      writer_{[this]() { WriteLoop(); }} {}
+
+RingEventLog::~RingEventLog() { FlushAndClose(); }
+
+void RingEventLog::LogEvent(context::proto::Event event) {
+  if (closed_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  Ring* ring = ThreadRing();
+  auto head = ring->head.load(std::memory_order_relaxed);
+  auto size = static_cast<std::size_t>(event.ByteSize());
+  if (head - ring->tail.load(std::memory_order_acquire) == capacity_ || slot_bytes_ < size) {
+    dropped_events_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  auto slot = head % capacity_;
+  event.SerializeWithCachedSizesToArray(ring->data.data() + slot * slot_bytes_);
+  ring->sizes[slot] = size;
+  ring->head.store(head + 1, std::memory_order_release);
+}
+
+void RingEventLog::FlushAndClose() {
+  std::lock_guard<std::mutex> close_lock{close_mu_};
+  if (closed_.exchange(true)) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock{mu_};
+    closing_ = true;
+  }
+  cv_.notify_all();
+  writer_.join();
+  out_->FlushAndClose();
+  auto dropped = dropped_events();
+  if (dropped) {
+    LOG(WARNING) << "Event log dropped " << dropped << " events";
+  }
+}
+
+RingEventLog::Ring* RingEventLog::ThreadRing() {
+  // Each thread caches the ring it last used; the log id keeps a stale cache
+  // entry from matching a later log.
+  thread_local std::uint64_t cached_id = 0;
+  thread_local Ring* cached_ring = nullptr;
+  if (cached_id == id_) {
+    return cached_ring;
+  }
+  std::lock_guard<std::mutex> lock{mu_};
+  auto& ring = rings_[std::this_thread::get_id()];
+  if (!ring) {
+    ring = std::make_unique<Ring>(capacity_, slot_bytes_);
+  }
+  cached_id = id_;
+  cached_ring = ring.get();
+  return cached_ring;
+}
+
+void RingEventLog::WriteLoop() {
+  std::unique_lock<std::mutex> lock{mu_};
+  while (!closing_) {
+    cv_.wait_for(lock, drain_interval_, [this]() { return closing_; });
+    lock.unlock();
+    Drain();
+    lock.lock();
+  }
+}
+
+void RingEventLog::Drain() {
+  std::vector<Ring*> rings;
+  {
+    std::lock_guard<std::mutex> lock{mu_};
+    for (const auto& it : rings_) {
+      rings.push_back(it.second.get());
+    }
+  }
+  proto::Record record;
+  for (Ring* ring : rings) {
+    auto tail = ring->tail.load(std::memory_order_relaxed);
+    auto head = ring->head.load(std::memory_order_acquire);
+    for (; tail != head; ++tail) {
+      auto slot = tail % capacity_;
+      if (!record.add_event()->ParseFromArray(ring->data.data() + slot * slot_bytes_, ring->sizes[slot])) {
+        record.mutable_event()->RemoveLast();
+      }
+    }
+    ring->tail.store(head, std::memory_order_release);
+  }
+  out_->LogRecord(std::move(record));
+}
+
+}  // namespace file
+}  // namespace eventing
+}  // namespace vertexai
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "base/context/eventlog.h"
+#include "base/eventing/file/eventlog.h"
+#include "base/eventing/file/eventlog.pb.h"
+
+namespace vertexai {
+namespace eventing {
+namespace file {
+
+// An event log for leaving tracing enabled under load.  Each logging thread
+// serializes its events into its own fixed-size ring, without taking any
+// locks; a background thread drains the rings into an event log file.  When a
+// thread's ring is full (or an event is too large for a ring slot), the event
+// is dropped and counted, so memory use stays bounded.
+class RingEventLog final : public context::EventLog {
+ public:
+  explicit RingEventLog(const proto::RingEventLog& config);
+  ~RingEventLog();
+
+  void LogEvent(context::proto::Event event) override;
+
+  void FlushAndClose() override;
+
+  // The number of events dropped so far.
+  std::uint64_t dropped_events() const { return dropped_events_.load(std::memory_order_relaxed); }
+
+ private:
+  // A single-producer, single-consumer ring of serialized events.
+  struct Ring {
+    Ring(std::size_t capacity, std::size_t slot_bytes);
+
+    const std::size_t slot_bytes;
+    std::vector<std::uint32_t> sizes;
+    std::vector<std::uint8_t> data;
+
+    // The next slot to write; advanced only by the owning thread.
+    alignas(64) std::atomic<std::uint64_t> head{0};
+
+    // The next slot to read; advanced only by the writer thread.
+    alignas(64) std::atomic<std::uint64_t> tail{0};
+  };
+
+  Ring* ThreadRing();
+  void WriteLoop();
+  void Drain();
+
+  const std::uint64_t id_;
+  const std::size_t capacity_;
+  const std::size_t slot_bytes_;
+  const std::chrono::milliseconds drain_interval_;
+  std::unique_ptr<file::EventLog> out_;
+  std::atomic<std::uint64_t> dropped_events_{0};
+  std::atomic<bool> closed_{false};
+
+  std::mutex mu_;
+  std::condition_variable cv_;
+  bool closing_ = false;
+  std::map<std::thread::id, std::unique_ptr<Ring>> rings_;
+  std::thread writer_;
+
+  // Serializes FlushAndClose.
+  std::mutex close_mu_;
+};
+
+}  // namespace file
+}  // namespace eventing
+}  // namespace vertexai
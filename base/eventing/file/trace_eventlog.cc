@@ -0,0 +1,143 @@
+#include "base/eventing/file/trace_eventlog.h"
+
+#include <sstream>
+#include <stdexcept>
+
+#include "base/util/logging.h"
+#include "json/json.h"
+
+namespace vertexai {
+namespace eventing {
+namespace file {
+namespace {
+
+// The process used for host activities; device clocks use their clock index.
+constexpr std::uint64_t kHostPid = 0;
+
+enum Lane { kHostLane, kCompileLane, kScheduleLane, kTransferLane, kKernelLane };
+
+const char* kLaneNames[] = {"host", "compile", "schedule", "transfer", "kernel"};
+
+Lane LaneOf(const std::string& verb) {
+  auto has = [&verb](const char* word) { return verb.find(word) != std::string::npos; };
+  if (has("Compile") || has("Build")) {
+    return kCompileLane;
+  }
+  if (has("Queue") || has("Enqueue") || has("Schedule")) {
+    return kScheduleLane;
+  }
+  if (has("Copy") || has("Map") || has("Transfer") || has("Buffer")) {
+    return kTransferLane;
+  }
+  if (has("Executing") || has("Kernel") || has("Run")) {
+    return kKernelLane;
+  }
+  return kHostLane;
+}
+
+double ToMicros(const google::protobuf::Duration& duration) {
+  return duration.seconds() * 1e6 + duration.nanos() / 1e3;
+}
+
+std::string Quote(const std::string& str) { return Json::valueToQuotedString(str.c_str()); }
+
+}  // namespace
+
+TraceEventLog::TraceEventLog(const proto::TraceEventLog& config) : out_{config.filename()} {
+  if (!out_) {
+    throw std::runtime_error(std::string("unable to open \"") + config.filename() + "\" for writing");
+  }
+  LOG(INFO) << "Writing trace events to " << config.filename();
+  out_ << "{\"traceEvents\":[";
+}
+
+TraceEventLog::~TraceEventLog() { FlushAndClose(); }
+
+void TraceEventLog::LogEvent(context::proto::Event event) {
+  std::lock_guard<std::mutex> lock{mu_};
+  if (closed_) {
+    return;
+  }
+  auto id = event.activity_id().index();
+  if (event.has_clock_id()) {
+    // Clock activities arrive complete, measured against the device's clock.
+    WriteSpanLocked(event.clock_id().index(), event.verb(), ToMicros(event.start_time()), ToMicros(event.end_time()),
+                    id, event.parent_id().index(), {});
+    return;
+  }
+  if (event.has_start_time()) {
+    auto& span = open_spans_[id];
+    span.verb = event.verb();
+    span.start_us = ToMicros(event.start_time());
+    span.parent = event.parent_id().index();
+    return;
+  }
+  auto it = open_spans_.find(id);
+  if (it == open_spans_.end()) {
+    return;
+  }
+  for (const auto& metadata : event.metadata()) {
+    auto type = metadata.type_url();
+    it->second.metadata.emplace_back(type.substr(type.rfind('/') + 1));
+  }
+  if (event.has_end_time()) {
+    const auto& span = it->second;
+    WriteSpanLocked(kHostPid, span.verb, span.start_us, ToMicros(event.end_time()), id, span.parent, span.metadata);
+    open_spans_.erase(it);
+  }
+}
+
+void TraceEventLog::FlushAndClose() {
+  std::lock_guard<std::mutex> lock{mu_};
+  if (closed_) {
+    return;
+  }
+  closed_ = true;
+  out_ << "]}\n";
+  out_.close();
+  open_spans_.clear();
+}
+
+void TraceEventLog::WriteSpanLocked(std::uint64_t pid, const std::string& verb, double start_us, double end_us,
+                                    std::uint64_t id, std::uint64_t parent,
+                                    const std::vector<std::string>& metadata) {
+  Lane lane = LaneOf(verb);
+  if (named_lanes_.emplace(pid, -1).second) {
+    std::ostringstream name;
+    name << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"args\":{\"name\":"
+         << Quote(pid == kHostPid ? "host" : "clock " + std::to_string(pid)) << "}}";
+    WriteRecordLocked(name.str());
+  }
+  if (named_lanes_.emplace(pid, lane).second) {
+    std::ostringstream name;
+    name << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << lane
+         << ",\"args\":{\"name\":" << Quote(kLaneNames[lane]) << "}}";
+    WriteRecordLocked(name.str());
+  }
+  std::ostringstream record;
+  record.precision(3);
+  record << std::fixed << "{\"name\":" << Quote(verb) << ",\"cat\":" << Quote(kLaneNames[lane])
+         << ",\"ph\":\"X\",\"ts\":" << start_us << ",\"dur\":" << end_us - start_us << ",\"pid\":" << pid
+         << ",\"tid\":" << lane << ",\"args\":{\"id\":" << id << ",\"parent\":" << parent;
+  if (metadata.size()) {
+    record << ",\"metadata\":[";
+    for (std::size_t i = 0; i < metadata.size(); i++) {
+      record << (i ? "," : "") << Quote(metadata[i]);
+    }
+    record << "]";
+  }
+  record << "}}";
+  WriteRecordLocked(record.str());
+}
+
+void TraceEventLog::WriteRecordLocked(const std::string& record) {
+  if (wrote_record_) {
+    out_ << ",\n";
+  }
+  wrote_record_ = true;
+  out_ << record;
+}
+
+}  // namespace file
+}  // namespace eventing
+}  // namespace vertexai
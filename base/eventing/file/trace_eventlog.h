@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "base/context/eventlog.h"
+#include "base/eventing/file/eventlog.pb.h"
+
+namespace vertexai {
+namespace eventing {
+namespace file {
+
+// An event log which writes Chrome trace-event JSON, viewable in
+// chrome://tracing or the Perfetto UI.  Host activities are written to the
+// "host" process; activities measured by a device clock (queueing and kernel
+// execution times reported by the HALs) are written to a process per clock.
+// Within each process, spans are grouped into compile, schedule, transfer and
+// kernel lanes by verb.  Activities which never complete are not written.
+class TraceEventLog final : public context::EventLog {
+ public:
+  explicit TraceEventLog(const proto::TraceEventLog& config);
+  ~TraceEventLog();
+
+  void LogEvent(context::proto::Event event) override;
+
+  void FlushAndClose() override;
+
+ private:
+  struct Span {
+    std::string verb;
+    double start_us;
+    std::uint64_t parent;
+    std::vector<std::string> metadata;
+  };
+
+  void WriteSpanLocked(std::uint64_t pid, const std::string& verb, double start_us, double end_us,
+                       std::uint64_t id, std::uint64_t parent, const std::vector<std::string>& metadata);
+  void WriteRecordLocked(const std::string& record);
+
+  std::mutex mu_;
+  std::ofstream out_;
+  bool closed_ = false;
+  bool wrote_record_ = false;
+  std::unordered_map<std::uint64_t, Span> open_spans_;
+  std::set<std::pair<std::uint64_t, int>> named_lanes_;
+};
+
+}  // namespace file
+}  // namespace eventing
+}  // namespace vertexai
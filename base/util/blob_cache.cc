@@ -0,0 +1,81 @@
+// Copyright 2020 Intel Corporation.
+
+#include "base/util/blob_cache.h"
+
+#include <cstdint>
+#include <iomanip>
+#include <sstream>
+
+#include "base/util/env.h"
+#include "base/util/file.h"
+#include "base/util/logging.h"
+
+namespace fs = boost::filesystem;
+
+namespace vertexai {
+
+std::string Fnv1aDigest(const std::string& bytes) {
+  std::uint64_t hash = 0xCBF29CE484222325ull;
+  for (unsigned char ch : bytes) {
+    hash ^= ch;
+    hash *= 0x100000001B3ull;
+  }
+  std::stringstream ss;
+  ss << std::hex << std::setfill('0') << std::setw(16) << hash;
+  return ss.str();
+}
+
+std::shared_ptr<BlobCache> BlobCache::FromEnv(const std::string& var, const std::string& extension) {
+  auto dir = env::Get(var);
+  if (dir.empty()) {
+    return nullptr;
+  }
+  boost::system::error_code ec;
+  fs::create_directories(dir, ec);
+  if (ec) {
+    IVLOG(1, "Unable to create " << var << " directory " << dir << ": " << ec.message());
+    return nullptr;
+  }
+  VLOG(1) << "Using " << var << " directory: " << dir;
+  return std::make_shared<BlobCache>(dir, extension);
+}
+
+BlobCache::BlobCache(const fs::path& dir, const std::string& extension) : dir_{dir}, extension_{extension} {}
+
+fs::path BlobCache::PathFor(const std::string& key) const { return dir_ / (Fnv1aDigest(key) + extension_); }
+
+bool BlobCache::Load(const std::string& key, std::string* blob) const {
+  auto path = PathFor(key);
+  boost::system::error_code ec;
+  if (!fs::is_regular_file(path, ec)) {
+    return false;
+  }
+  std::string contents;
+  try {
+    contents = ReadFile(path, true);
+  } catch (const std::exception& ex) {
+    IVLOG(1, "Unable to read cache entry " << path << ": " << ex.what());
+    return false;
+  }
+  // Entries are the key, a NUL, and the blob.
+  if (contents.size() <= key.size() || contents.compare(0, key.size(), key) || contents[key.size()]) {
+    return false;
+  }
+  *blob = contents.substr(key.size() + 1);
+  IVLOG(2, "Loaded cache entry: " << path);
+  return true;
+}
+
+void BlobCache::Store(const std::string& key, const std::string& blob) const {
+  auto path = PathFor(key);
+  std::string contents = key;
+  contents.push_back('\0');
+  contents += blob;
+  try {
+    WriteFileAtomic(path, contents, true);
+  } catch (const std::exception& ex) {
+    IVLOG(1, "Unable to store cache entry " << path << ": " << ex.what());
+  }
+}
+
+}  // namespace vertexai
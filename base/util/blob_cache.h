@@ -0,0 +1,39 @@
+// Copyright 2020 Intel Corporation.
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include <boost/filesystem.hpp>
+
+namespace vertexai {
+
+// The 64-bit FNV-1a digest of bytes, as 16 hex digits.  Unlike std::hash, it's the same in every build and on every
+// platform, so it's safe to use in the names of files that outlive the process.
+std::string Fnv1aDigest(const std::string& bytes);
+
+// A persistent, on-disk store of blobs keyed by arbitrary strings, shared by every process pointed at the same
+// directory.  Files are named by the Fnv1aDigest of their key, and each records its full key, which is compared on
+// load, so a digest collision can only cause a miss.  Entries are written with WriteFileAtomic, so concurrent
+// processes never observe a partially-written entry.  Errors are logged and treated as misses.
+class BlobCache final {
+ public:
+  // Returns a cache in the directory named by the environment variable var, creating the directory if need be, or
+  // nullptr if the variable is unset or the directory can't be created.
+  static std::shared_ptr<BlobCache> FromEnv(const std::string& var, const std::string& extension);
+
+  BlobCache(const boost::filesystem::path& dir, const std::string& extension);
+
+  // Returns true and fills in the blob if the key is present.
+  bool Load(const std::string& key, std::string* blob) const;
+  void Store(const std::string& key, const std::string& blob) const;
+
+  boost::filesystem::path PathFor(const std::string& key) const;
+
+ private:
+  boost::filesystem::path dir_;
+  std::string extension_;
+};
+
+}  // namespace vertexai
@@ -0,0 +1,68 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "base/util/blob_cache.h"
+#include "base/util/file.h"
+
+using ::testing::Eq;
+
+namespace fs = boost::filesystem;
+
+namespace vertexai {
+namespace {
+
+class BlobCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override { fs::create_directories(dir_); }
+  void TearDown() override { fs::remove_all(dir_); }
+
+  fs::path dir_ = fs::temp_directory_path() / fs::unique_path();
+};
+
+TEST_F(BlobCacheTest, DigestIsFnv1a) {
+  EXPECT_THAT(Fnv1aDigest(""), Eq("cbf29ce484222325"));
+  EXPECT_THAT(Fnv1aDigest("a"), Eq("af63dc4c8601ec8c"));
+  EXPECT_THAT(Fnv1aDigest("foobar"), Eq("85944171f73967e8"));
+}
+
+TEST_F(BlobCacheTest, StoresAndLoads) {
+  BlobCache cache{dir_, ".bin"};
+  std::string blob;
+  EXPECT_FALSE(cache.Load("key", &blob));
+
+  cache.Store("key", std::string("a\0b", 3));
+  ASSERT_TRUE(cache.Load("key", &blob));
+  EXPECT_THAT(blob, Eq(std::string("a\0b", 3)));
+  EXPECT_THAT(cache.PathFor("key"), Eq(dir_ / (Fnv1aDigest("key") + ".bin")));
+
+  // Another cache on the same directory sees the entry.
+  BlobCache other{dir_, ".bin"};
+  ASSERT_TRUE(other.Load("key", &blob));
+  EXPECT_FALSE(other.Load("other", &blob));
+}
+
+TEST_F(BlobCacheTest, MismatchedKeyMisses) {
+  BlobCache cache{dir_, ".bin"};
+  // An entry written under one key but found under another's name, as after a digest collision.
+  WriteFile(cache.PathFor("wanted"), std::string("stored\0blob", 11), true);
+  std::string blob;
+  EXPECT_FALSE(cache.Load("wanted", &blob));
+  WriteFile(cache.PathFor("wanted"), "wanted", true);
+  EXPECT_FALSE(cache.Load("wanted", &blob));
+}
+
+TEST_F(BlobCacheTest, WriteFileAtomicReplacesWholeFile) {
+  auto path = dir_ / "file.txt";
+  WriteFileAtomic(path, "first version, which is longer");
+  WriteFileAtomic(path, "second");
+  EXPECT_THAT(ReadFile(path), Eq("second"));
+  size_t files = 0;
+  for (fs::directory_iterator it(dir_); it != fs::directory_iterator(); ++it) {
+    files++;
+  }
+  EXPECT_THAT(files, Eq(1));  // No temporaries are left behind
+  EXPECT_ANY_THROW(WriteFileAtomic(dir_ / "missing" / "nested" / "file.txt", "contents"));
+}
+
+}  // namespace
+}  // namespace vertexai
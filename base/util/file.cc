@@ -46,4 +46,27 @@ void WriteFile(const boost::filesystem::path& path,  //
   WriteFile(path, binary, [contents](std::ofstream& fout) { fout << contents; });
 }
 
+void WriteFileAtomic(const boost::filesystem::path& path,  //
+                     const std::string& contents,          //
+                     bool binary) {
+  auto tmp = path;
+  tmp += boost::filesystem::unique_path(".%%%%%%%%.tmp");
+  try {
+    bool written = false;
+    WriteFile(tmp, binary, [&](std::ofstream& fout) {
+      fout << contents;
+      fout.close();
+      written = !fout.fail();
+    });
+    if (!written) {
+      throw_with_trace(std::runtime_error(str(boost::format("Unable to write file \"%1%\"") % tmp)));
+    }
+    boost::filesystem::rename(tmp, path);
+  } catch (...) {
+    boost::system::error_code ec;
+    boost::filesystem::remove(tmp, ec);
+    throw;
+  }
+}
+
 }  // namespace vertexai
@@ -20,4 +20,10 @@ void WriteFile(const boost::filesystem::path& path,  //
                bool binary,                          //
                const std::function<void(std::ofstream& fout)>& writer);
 
+// Writes contents to a private temporary beside path and renames it into place, so that concurrent readers (and
+// writers) only ever observe a complete file.  Throws if the file can't be written.
+void WriteFileAtomic(const boost::filesystem::path& path,  //
+                     const std::string& contents,          //
+                     bool binary = false);
+
 }  // namespace vertexai
@@ -1,5 +1,6 @@
 #include <gflags/gflags.h>
 
+#include <algorithm>
 #include <string>
 
 #include "base/util/logging.h"
@@ -21,6 +22,27 @@ const char logDirPrefix[] = "logs/";  // NOLINT
 
 namespace vertexai {
 
+std::atomic<int> vlog_bound{PLAIDML_MAX_VLOG_LEVEL};
+
+void SetVerbosity(int level) {
+  el::Loggers::setVerboseLevel(level);
+  SyncVerbosity();
+}
+
+void SetVModules(const std::string& modules) {
+  el::Loggers::setVModules(modules.c_str());
+  SyncVerbosity();
+}
+
+void SyncVerbosity() {
+  auto registry = ELPP->vRegistry();
+  int bound = registry->level();
+  for (const auto& kvp : registry->modules()) {
+    bound = std::max<int>(bound, kvp.second);
+  }
+  vlog_bound.store(bound, std::memory_order_relaxed);
+}
+
 el::Configurations LogConfigurationFromFlags(const std::string& app_name) {
   el::Configurations conf;
   if (FLAGS_logconf.empty()) {
@@ -36,10 +58,10 @@ el::Configurations LogConfigurationFromFlags(const std::string& app_name) {
   if (!FLAGS_v) {
     conf.set(el::Level::Debug, el::ConfigurationType::Enabled, "false");
   } else {
-    el::Loggers::setVerboseLevel(FLAGS_v);
+    SetVerbosity(FLAGS_v);
   }
   if (!FLAGS_vmodule.empty()) {
-    el::Loggers::setVModules(FLAGS_vmodule.c_str());
+    SetVModules(FLAGS_vmodule);
   }
 
   return conf;
@@ -14,11 +14,37 @@
 
 #include <easylogging++.h>
 
+#include <atomic>
 #include <string>
 #include <vector>
 
+// Verbose logging above PLAIDML_MAX_VLOG_LEVEL is compiled out: the IVLOG family
+// of macros reduce to a constant false test, so neither the check nor the
+// arguments cost anything at runtime.  Release builds may pass e.g.
+// --copt=-DPLAIDML_MAX_VLOG_LEVEL=1 to drop the chattier levels.
+#ifndef PLAIDML_MAX_VLOG_LEVEL
+#define PLAIDML_MAX_VLOG_LEVEL 9
+#endif
+
 namespace vertexai {
 
+// An upper bound on the verbosity enabled for any file, kept in step with
+// easylogging's own settings by SetVerbosity, SetVModules and SyncVerbosity.
+// It lets disabled verbose logs be skipped with a relaxed atomic load, ahead of
+// easylogging's check (which takes a lock).  Until the first sync it's the
+// maximum, so that verbosity configured directly through easylogging (e.g. by
+// START_EASYLOGGINGPP) still takes effect.
+extern std::atomic<int> vlog_bound;
+
+// Sets the global verbosity.
+void SetVerbosity(int level);
+
+// Sets per-file verbosity, as with --vmodule.
+void SetVModules(const std::string& modules);
+
+// Recomputes vlog_bound from easylogging's current settings.
+void SyncVerbosity();
+
 // Returns a log configuration built from the command line flags passed to the
 // program.  This should be only be used after command line flag parsing is
 // complete.
@@ -32,9 +58,9 @@ el::Configurations LogConfigurationFromFlags(const std::string& app_name);
 class ScopedVerbosity {
  public:
   explicit ScopedVerbosity(int level) : previous_level_{el::Loggers::verboseLevel()} {
-    el::Loggers::setVerboseLevel(level);
+    SetVerbosity(level);
   }
-  ~ScopedVerbosity() { el::Loggers::setVerboseLevel(previous_level_); }
+  ~ScopedVerbosity() { SetVerbosity(previous_level_); }
   ScopedVerbosity(const ScopedVerbosity&) = delete;
   ScopedVerbosity& operator=(const ScopedVerbosity&) = delete;
 
@@ -44,17 +70,22 @@ class ScopedVerbosity {
 
 }  // namespace vertexai
 
-#define IVLOG(N, rest)   \
-  do {                   \
-    if (VLOG_IS_ON(N)) { \
-      VLOG(N) << rest;   \
-    }                    \
+// Like VLOG_IS_ON, but free for levels compiled out, and cheap for levels
+// disabled at runtime.
+#define IVLOG_IS_ON(N) \
+  ((N) <= PLAIDML_MAX_VLOG_LEVEL && (N) <= ::vertexai::vlog_bound.load(std::memory_order_relaxed) && VLOG_IS_ON(N))
+
+#define IVLOG(N, rest)    \
+  do {                    \
+    if (IVLOG_IS_ON(N)) { \
+      VLOG(N) << rest;    \
+    }                     \
   } while (0);
 
 // printf style logging
 #define PIVLOG(N, ...)                                            \
   do {                                                            \
-    if (VLOG_IS_ON(N)) {                                          \
+    if (IVLOG_IS_ON(N)) {                                         \
       el::Loggers::getLogger("default")->verbose(N, __VA_ARGS__); \
     }                                                             \
   } while (0);
@@ -62,7 +93,7 @@ class ScopedVerbosity {
 // VLOGs and writes to a stream.
 #define SVLOG(s, N, rest) \
   do {                    \
-    if (VLOG_IS_ON(N)) {  \
+    if (IVLOG_IS_ON(N)) { \
       VLOG(N) << rest;    \
     }                     \
     s << rest << "\n";    \
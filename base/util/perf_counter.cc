@@ -1,41 +1,134 @@
-
 #include "base/util/perf_counter.h"
 
+#include <algorithm>
+#include <cctype>
 #include <iostream>
 #include <mutex>
+#include <sstream>
 #include <thread>
+#include <tuple>
+#include <utility>
 
 #include "base/util/error.h"
 
 namespace vertexai {
 
 namespace {
+using Key = std::pair<std::string, PerfLabels>;
+
 std::mutex& GetMutex() {
   static std::mutex mu;
   return mu;
 }
 
-std::map<std::string, std::shared_ptr<std::atomic<int64_t>>>& GetTable() {
-  static std::map<std::string, std::shared_ptr<std::atomic<int64_t>>> table;
+std::map<Key, std::shared_ptr<std::atomic<int64_t>>>& GetTable() {
+  static std::map<Key, std::shared_ptr<std::atomic<int64_t>>> table;
+  return table;
+}
+
+std::map<Key, std::shared_ptr<PerfHistogram::Data>>& GetHistogramTable() {
+  static std::map<Key, std::shared_ptr<PerfHistogram::Data>> table;
   return table;
 }
+
+PerfLabels MergeLabels(PerfLabels labels, const PerfLabels& more) {
+  for (const auto& kvp : more) {
+    labels[kvp.first] = kvp.second;
+  }
+  return labels;
+}
+
+// Prometheus metric and label names are restricted to [a-zA-Z0-9_:].
+std::string MetricName(const std::string& name) {
+  std::string result = name;
+  for (auto& ch : result) {
+    if (!std::isalnum(static_cast<unsigned char>(ch)) && ch != '_' && ch != ':') {
+      ch = '_';
+    }
+  }
+  if (result.empty() || std::isdigit(static_cast<unsigned char>(result[0]))) {
+    result = "_" + result;
+  }
+  return result;
+}
+
+void WriteLabels(std::ostream& os, const PerfLabels& labels, const char* le = nullptr) {
+  if (labels.empty() && !le) {
+    return;
+  }
+  os << '{';
+  bool first = true;
+  for (const auto& kvp : labels) {
+    os << (first ? "" : ",") << MetricName(kvp.first) << "=\"";
+    for (auto ch : kvp.second) {
+      switch (ch) {
+        case '\\':
+          os << "\\\\";
+          break;
+        case '"':
+          os << "\\\"";
+          break;
+        case '\n':
+          os << "\\n";
+          break;
+        default:
+          os << ch;
+      }
+    }
+    os << '"';
+    first = false;
+  }
+  if (le) {
+    os << (first ? "" : ",") << "le=\"" << le << '"';
+  }
+  os << '}';
+}
+
 }  // namespace
 
-PerfCounter::PerfCounter(const std::string& name) {
+PerfCounter::PerfCounter(const std::string& name, const PerfLabels& labels) : name_{name}, labels_{labels} {
   std::lock_guard<std::mutex> lock(GetMutex());
-  auto& table = GetTable();
-  if (table.count(name)) {
-    value_ = table[name];
-  } else {
-    value_ = std::make_shared<std::atomic<int64_t>>();
-    table[name] = value_;
+  auto& value = GetTable()[Key{name, labels}];
+  if (!value) {
+    value = std::make_shared<std::atomic<int64_t>>();
   }
+  value_ = value;
+}
+
+PerfCounter PerfCounter::WithLabels(const PerfLabels& labels) const {
+  return PerfCounter{name_, MergeLabels(labels_, labels)};
+}
+
+PerfHistogram::Data::Data(std::vector<int64_t> bounds) : bounds{std::move(bounds)}, buckets(this->bounds.size() + 1) {}
+
+PerfHistogram::PerfHistogram(const std::string& name, std::vector<int64_t> bounds, const PerfLabels& labels)
+    : name_{name}, labels_{labels} {
+  std::sort(bounds.begin(), bounds.end());
+  std::lock_guard<std::mutex> lock(GetMutex());
+  auto& data = GetHistogramTable()[Key{name, labels}];
+  if (!data) {
+    data = std::make_shared<Data>(std::move(bounds));
+  } else if (data->bounds != bounds) {
+    throw error::InvalidArgument(std::string("Histogram registered with different bounds: ") + name);
+  }
+  data_ = data;
+}
+
+void PerfHistogram::observe(int64_t value) {
+  auto it = std::lower_bound(data_->bounds.begin(), data_->bounds.end(), value);
+  data_->buckets[it - data_->bounds.begin()]++;
+  data_->sum += value;
+  data_->count++;
+}
+
+PerfHistogram PerfHistogram::WithLabels(const PerfLabels& labels) const {
+  return PerfHistogram{name_, data_->bounds, MergeLabels(labels_, labels)};
 }
 
 int64_t GetPerfCounter(const std::string& name) {
   std::lock_guard<std::mutex> lock(GetMutex());
   auto& table = GetTable();
-  auto it = table.find(name);
+  auto it = table.find(Key{name, {}});
   if (it == table.end()) {
     throw error::NotFound(std::string("Unknown performance counter: ") + name);
   }
@@ -45,11 +138,74 @@ int64_t GetPerfCounter(const std::string& name) {
 void SetPerfCounter(const std::string& name, int64_t value) {
   std::lock_guard<std::mutex> lock(GetMutex());
   auto& table = GetTable();
-  auto it = table.find(name);
+  auto it = table.find(Key{name, {}});
   if (it == table.end()) {
     throw error::NotFound(std::string("Unknown performance counter: ") + name);
   }
   *(it->second) = value;
 }
 
+std::vector<PerfSample> SnapshotPerfCounters() {
+  std::vector<PerfSample> result;
+  std::lock_guard<std::mutex> lock(GetMutex());
+  for (const auto& kvp : GetTable()) {
+    PerfSample sample;
+    sample.name = kvp.first.first;
+    sample.labels = kvp.first.second;
+    sample.value = *kvp.second;
+    result.emplace_back(std::move(sample));
+  }
+  for (const auto& kvp : GetHistogramTable()) {
+    const auto& data = *kvp.second;
+    PerfSample sample;
+    sample.name = kvp.first.first;
+    sample.labels = kvp.first.second;
+    sample.is_histogram = true;
+    sample.bounds = data.bounds;
+    int64_t cumulative = 0;
+    for (const auto& bucket : data.buckets) {
+      cumulative += bucket;
+      sample.buckets.push_back(cumulative);
+    }
+    sample.sum = data.sum;
+    sample.count = data.count;
+    result.emplace_back(std::move(sample));
+  }
+  std::stable_sort(result.begin(), result.end(), [](const PerfSample& lhs, const PerfSample& rhs) {
+    return std::tie(lhs.name, lhs.labels) < std::tie(rhs.name, rhs.labels);
+  });
+  return result;
+}
+
+std::string PerfCountersToPrometheusText() {
+  std::ostringstream os;
+  std::string family;
+  for (const auto& sample : SnapshotPerfCounters()) {
+    auto name = MetricName(sample.name);
+    if (name != family) {
+      os << "# TYPE " << name << (sample.is_histogram ? " histogram" : " gauge") << '\n';
+      family = name;
+    }
+    if (!sample.is_histogram) {
+      os << name;
+      WriteLabels(os, sample.labels);
+      os << ' ' << sample.value << '\n';
+      continue;
+    }
+    for (size_t i = 0; i < sample.buckets.size(); i++) {
+      auto le = i < sample.bounds.size() ? std::to_string(sample.bounds[i]) : std::string("+Inf");
+      os << name << "_bucket";
+      WriteLabels(os, sample.labels, le.c_str());
+      os << ' ' << sample.buckets[i] << '\n';
+    }
+    os << name << "_sum";
+    WriteLabels(os, sample.labels);
+    os << ' ' << sample.sum << '\n';
+    os << name << "_count";
+    WriteLabels(os, sample.labels);
+    os << ' ' << sample.count << '\n';
+  }
+  return os.str();
+}
+
 }  // namespace vertexai
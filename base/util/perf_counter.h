@@ -5,26 +5,84 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace vertexai {
 
+// Labels distinguishing the members of a counter family, e.g.
+// {{"device", "opencl_intel_0"}, {"kernel", "kernel_c3_sdk_0"}}.
+using PerfLabels = std::map<std::string, std::string>;
+
 // Construct + register a counter
+// Counters with the same name and labels share a single value; counters with
+// the same name and different labels form a family.
 class PerfCounter {
  public:
-  explicit PerfCounter(const std::string& name);
+  explicit PerfCounter(const std::string& name, const PerfLabels& labels = {});
   inline int64_t get() const { return *value_; }
   inline void set(int64_t value) { (*value_) = value; }
   inline void add(int64_t value) { (*value_) += value; }
   inline void inc() { (*value_)++; }
 
+  // Returns the member of this counter's family with additional labels.
+  PerfCounter WithLabels(const PerfLabels& labels) const;
+
  private:
+  std::string name_;
+  PerfLabels labels_;
   std::shared_ptr<std::atomic<int64_t>> value_;
 };
 
+// Construct + register a histogram
+// Observations are counted in the first bucket whose upper bound is >= the
+// observed value; values above the last bound land in an overflow bucket.
+class PerfHistogram {
+ public:
+  struct Data {
+    explicit Data(std::vector<int64_t> bounds);
+
+    const std::vector<int64_t> bounds;
+    std::vector<std::atomic<int64_t>> buckets;  // bounds.size() + 1
+    std::atomic<int64_t> sum{0};
+    std::atomic<int64_t> count{0};
+  };
+
+  PerfHistogram(const std::string& name, std::vector<int64_t> bounds, const PerfLabels& labels = {});
+  void observe(int64_t value);
+
+  // Returns the member of this histogram's family with additional labels.
+  PerfHistogram WithLabels(const PerfLabels& labels) const;
+
+ private:
+  std::string name_;
+  PerfLabels labels_;
+  std::shared_ptr<Data> data_;
+};
+
+// A point-in-time copy of one registered counter or histogram.
+struct PerfSample {
+  std::string name;
+  PerfLabels labels;
+  bool is_histogram = false;
+  int64_t value = 0;  // For counters
+
+  // For histograms: cumulative counts, one per bound, then the total.
+  std::vector<int64_t> bounds;
+  std::vector<int64_t> buckets;
+  int64_t sum = 0;
+  int64_t count = 0;
+};
+
 // Get or set a counter by name from the global registry
 // Get of nonexistant counter returns -1
 // Set of nonexistant counter is a no-op
 int64_t GetPerfCounter(const std::string& name);
 void SetPerfCounter(const std::string& name, int64_t value);
 
+// Returns every registered counter and histogram, ordered by name then labels.
+std::vector<PerfSample> SnapshotPerfCounters();
+
+// Renders the registry in the Prometheus text exposition format.
+std::string PerfCountersToPrometheusText();
+
 }  // namespace vertexai
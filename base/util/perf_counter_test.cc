@@ -0,0 +1,51 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "base/util/perf_counter.h"
+
+using ::testing::Eq;
+using ::testing::HasSubstr;
+
+namespace vertexai {
+namespace {
+
+TEST(PerfCounterTest, LabeledCountersAreDistinct) {
+  PerfCounter hits{"perf_counter_test_hits"};
+  auto device0 = hits.WithLabels({{"device", "0"}});
+  auto device1 = hits.WithLabels({{"device", "1"}});
+  hits.inc();
+  device0.add(2);
+  device1.add(3);
+  EXPECT_THAT(GetPerfCounter("perf_counter_test_hits"), Eq(1));
+  EXPECT_THAT(PerfCounter("perf_counter_test_hits", {{"device", "1"}}).get(), Eq(3));
+
+  int64_t total = 0;
+  for (const auto& sample : SnapshotPerfCounters()) {
+    if (sample.name == "perf_counter_test_hits") {
+      total += sample.value;
+    }
+  }
+  EXPECT_THAT(total, Eq(6));
+}
+
+TEST(PerfCounterTest, ExportsPrometheusText) {
+  PerfCounter bytes{"perf_counter_test.bytes", {{"device", "gpu \"0\""}}};
+  bytes.add(42);
+  PerfHistogram latency{"perf_counter_test_latency_us", {10, 100}, {{"kernel", "k0"}}};
+  latency.observe(5);
+  latency.observe(50);
+  latency.observe(500);
+
+  auto text = PerfCountersToPrometheusText();
+  EXPECT_THAT(text, HasSubstr("# TYPE perf_counter_test_bytes gauge\n"));
+  EXPECT_THAT(text, HasSubstr("perf_counter_test_bytes{device=\"gpu \\\"0\\\"\"} 42\n"));
+  EXPECT_THAT(text, HasSubstr("# TYPE perf_counter_test_latency_us histogram\n"));
+  EXPECT_THAT(text, HasSubstr("perf_counter_test_latency_us_bucket{kernel=\"k0\",le=\"10\"} 1\n"));
+  EXPECT_THAT(text, HasSubstr("perf_counter_test_latency_us_bucket{kernel=\"k0\",le=\"100\"} 2\n"));
+  EXPECT_THAT(text, HasSubstr("perf_counter_test_latency_us_bucket{kernel=\"k0\",le=\"+Inf\"} 3\n"));
+  EXPECT_THAT(text, HasSubstr("perf_counter_test_latency_us_sum{kernel=\"k0\"} 555\n"));
+  EXPECT_THAT(text, HasSubstr("perf_counter_test_latency_us_count{kernel=\"k0\"} 3\n"));
+}
+
+}  // namespace
+}  // namespace vertexai
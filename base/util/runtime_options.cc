@@ -0,0 +1,54 @@
+// Copyright 2020 Intel Corporation
+
+#include "base/util/runtime_options.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "base/util/env.h"
+
+namespace vertexai {
+namespace {
+
+RuntimeOptions ReadOptions() {
+  RuntimeOptions options;
+  options.ee = env::Get("PLAIDML_EE") == "1";
+  options.coschedule = env::Get("PLAIDML_COSCHEDULE") == "1";
+  options.model_parallel = env::Get("PLAIDML_MODEL_PARALLEL") == "1";
+  options.fold_constants = env::Get("PLAIDML_FOLD_CONSTANTS") != "0";
+  options.build_times = env::Get("PLAIDML_BUILD_TIMES") == "1";
+  options.dump_times = env::Get("PLAIDML_DUMP_TIMES") == "1";
+  options.stripe_output = env::Get("PLAIDML_STRIPE_OUTPUT");
+  options.codegen_profile = env::Get("PLAIDML_CODEGEN_PROFILE");
+  return options;
+}
+
+// Every snapshot ever published is retained, so that readers never need to take a
+// reference count or a lock.  Reloads are rare, so this costs next to nothing.
+std::atomic<const RuntimeOptions*> current{nullptr};
+
+const RuntimeOptions* Publish() {
+  static std::mutex mu;
+  static auto snapshots = new std::vector<std::unique_ptr<const RuntimeOptions>>;
+  std::lock_guard<std::mutex> lock{mu};
+  snapshots->emplace_back(new RuntimeOptions{ReadOptions()});
+  current.store(snapshots->back().get(), std::memory_order_release);
+  return snapshots->back().get();
+}
+
+}  // namespace
+
+const RuntimeOptions& RuntimeOptions::Get() {
+  auto options = current.load(std::memory_order_acquire);
+  if (!options) {
+    // First use; should several threads race here, each publishes an identical snapshot.
+    options = Publish();
+  }
+  return *options;
+}
+
+void RuntimeOptions::Reload() { Publish(); }
+
+}  // namespace vertexai
@@ -0,0 +1,33 @@
+// Copyright 2020 Intel Corporation
+
+#pragma once
+
+#include <string>
+
+namespace vertexai {
+
+// Runtime options read from the environment.
+// Hot paths (per compile, per kernel, per run) consult these typed fields rather
+// than calling env::Get, which copies and scans the environment on every call.
+// The options are read once, on first use; changes made to the environment
+// afterwards take effect only after Reload().
+struct RuntimeOptions {
+  bool ee = false;              // PLAIDML_EE=1: compile EDSL programs with the MLIR ExecutionEngine
+  bool coschedule = false;      // PLAIDML_COSCHEDULE=1
+  bool model_parallel = false;  // PLAIDML_MODEL_PARALLEL=1
+  bool fold_constants = true;   // PLAIDML_FOLD_CONSTANTS=0 disables constant folding
+  bool build_times = false;     // PLAIDML_BUILD_TIMES=1: report kernel build times
+  bool dump_times = false;      // PLAIDML_DUMP_TIMES=1: report kernel execution times
+  std::string stripe_output;    // PLAIDML_STRIPE_OUTPUT
+  std::string codegen_profile;  // PLAIDML_CODEGEN_PROFILE
+
+  // Returns the current options.  This is lock-free; the returned reference stays
+  // valid for the life of the process, even across reloads.
+  static const RuntimeOptions& Get();
+
+  // Re-reads the options from the environment.  Callers which are already holding
+  // the previous options keep seeing them.
+  static void Reload();
+};
+
+}  // namespace vertexai
@@ -21,6 +21,18 @@ bool UnZipArchive::Exist(const std::string& filename) {
   return unzLocateFile(zip_file_, filename.c_str(), nullptr) == UNZ_OK;
 }
 
+std::vector<std::string> UnZipArchive::ListFiles() {
+  std::vector<std::string> filenames;
+  for (int err = unzGoToFirstFile(zip_file_); err == UNZ_OK; err = unzGoToNextFile(zip_file_)) {
+    unz_file_info64 fi;
+    unzGetCurrentFileInfo64(zip_file_, &fi, nullptr, 0, nullptr, 0, nullptr, 0);
+    std::string filename(fi.size_filename, '\0');
+    unzGetCurrentFileInfo64(zip_file_, &fi, &filename[0], filename.size(), nullptr, 0, nullptr, 0);
+    filenames.push_back(filename);
+  }
+  return filenames;
+}
+
 UnZipFile UnZipArchive::OpenFile(const std::string& filename) { return UnZipFile(zip_file_, filename); }
 
 UnZipFile::UnZipFile(unzFile zip_file, const std::string& filename) : zip_file_(zip_file) {
@@ -5,6 +5,7 @@
 #include <unzip.h>
 
 #include <string>
+#include <vector>
 
 namespace vertexai {
 
@@ -31,6 +32,7 @@ class UnZipArchive {
   ~UnZipArchive();
 
   bool Exist(const std::string& filename);
+  std::vector<std::string> ListFiles();
   UnZipFile OpenFile(const std::string& filename);
 
  private:
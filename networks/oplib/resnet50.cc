@@ -1,5 +1,12 @@
 // Copyright 2019, Intel Corporation
 
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
 #include "benchmark/benchmark.h"
 
 #include "plaidml2/exec/exec.h"
@@ -393,6 +400,20 @@ struct resnet50 : public benchmark::Fixture {
     auto program = build(batch_size, I, W, B);
     return exec::Binder(program).compile();
   }
+
+  // Returns an executable for the batch size shared by all benchmark threads,
+  // compiling it on first use, so that concurrent threads model clients of a
+  // single served model.
+  std::shared_ptr<exec::Executable> shared_executable(int64_t batch_size) {
+    static std::mutex mu;
+    static std::map<int64_t, std::shared_ptr<exec::Executable>> executables;
+    std::lock_guard<std::mutex> lock(mu);
+    auto& executable = executables[batch_size];
+    if (!executable) {
+      executable = compile(batch_size);
+    }
+    return executable;
+  }
 };
 
 BENCHMARK_DEFINE_F(resnet50, build)(benchmark::State& state) {  // NOLINT[runtime/references]
@@ -401,23 +422,53 @@ BENCHMARK_DEFINE_F(resnet50, build)(benchmark::State& state) {  // NOLINT[runtim
 
 BENCHMARK_DEFINE_F(resnet50, compile)(benchmark::State& state) {  // NOLINT[runtime/references]
   for (auto _ : state) {
-    compile();
+    compile(state.range(0));
   }
 }
 
 BENCHMARK_DEFINE_F(resnet50, run)(benchmark::State& state) {  // NOLINT[runtime/references]
-  auto executable = compile();
+  auto batch_size = state.range(0);
+  auto executable = shared_executable(batch_size);
+  executable->run();  // Warm up
+  std::vector<double> latencies;
   for (auto _ : state) {
+    auto start = std::chrono::steady_clock::now();
     executable->run();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    state.SetIterationTime(elapsed.count());
+    latencies.push_back(elapsed.count());
   }
-  state.SetItemsProcessed(state.iterations());
+  state.SetItemsProcessed(state.iterations() * batch_size);
+  if (latencies.empty()) {
+    return;
+  }
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile_ms = [&](double p) {
+    auto idx = std::min(latencies.size() - 1, static_cast<size_t>(p * latencies.size()));
+    return benchmark::Counter(latencies[idx] * 1e3, benchmark::Counter::kAvgThreads);
+  };
+  state.counters["p50_ms"] = percentile_ms(0.50);
+  state.counters["p90_ms"] = percentile_ms(0.90);
+  state.counters["p99_ms"] = percentile_ms(0.99);
+  state.counters["peak_mem"] = benchmark::Counter(executable->stats().peak_memory_bytes,
+                                                  benchmark::Counter::kAvgThreads, benchmark::Counter::kIs1024);
 }
 
 BENCHMARK_REGISTER_F(resnet50, build)->Unit(benchmark::kMillisecond)->Iterations(1);
 
-BENCHMARK_REGISTER_F(resnet50, compile)->Unit(benchmark::kMillisecond);
-
-// TODO: get HAL timer results, UseManualTime() instead of UseRealTime()
-BENCHMARK_REGISTER_F(resnet50, run)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_REGISTER_F(resnet50, compile)->Unit(benchmark::kMillisecond)->ArgName("batch")->Arg(1)->Arg(8)->Arg(32);
+
+// Items processed are images, so items_per_second is the throughput.  Threads
+// issue runs of one executable concurrently, modeling a serving workload.  The
+// manual time is each run's host-side latency, which is what a client sees;
+// device kernel times are available from Executable::stats() when needed.
+BENCHMARK_REGISTER_F(resnet50, run)
+    ->Unit(benchmark::kMillisecond)
+    ->UseManualTime()
+    ->ArgName("batch")
+    ->Arg(1)
+    ->Arg(8)
+    ->Arg(32)
+    ->ThreadRange(1, 4);
 
 }  // namespace networks::oplib
@@ -86,6 +86,13 @@ def make_parser():
                         help="Invoke callgrind during timing runs.")
     parser.add_argument('--no-warmup', action='store_true', help="Skip the warmup runs.")
     parser.add_argument('--no-kernel-timing', action='store_true', help="Skip the warmup runs.")
+    parser.add_argument('--latency',
+                        action='store_true',
+                        help="Measure per-batch latency percentiles after the timing run.")
+    parser.add_argument('--clients',
+                        type=int,
+                        default=1,
+                        help="Number of concurrent closed-loop clients used to measure latency.")
     parser.add_argument('-n',
                         '--examples',
                         type=int,
@@ -149,6 +156,10 @@ def main():
         argv.append('--no-kernel-timing')
     if args.print_stacktraces:
         argv.append('--print-stacktraces')
+    if args.latency:
+        argv.append('--latency')
+    if args.clients > 1:
+        argv.append('--clients={}'.format(args.clients))
 
     if args.onnx:
         # onnx arguments
@@ -81,12 +81,19 @@ class _PlaidbenchCommand(click.MultiCommand):
 @click.option('--timeout-secs', type=int, default=None)
 @click.option('--warmup/--no-warmup', default=True, help='Do warmup runs before main timing')
 @click.option('--kernel-timing/--no-kernel-timing', default=True, help='Emit kernel timing info')
+@click.option('--latency/--no-latency',
+              default=False,
+              help='Measure per-batch latency percentiles after the timing run')
+@click.option('--clients',
+              type=click.IntRange(1),
+              default=1,
+              help='Number of concurrent closed-loop clients used to measure latency')
 @click.option('--print-stacktraces/--no-print-stacktraces',
               default=False,
               help='Print a stack trace if an exception occurs')
 @click.pass_context
 def plaidbench(ctx, verbose, examples, blanket_run, results, callgrind, epochs, batch_size,
-               timeout_secs, warmup, print_stacktraces, kernel_timing):
+               timeout_secs, warmup, print_stacktraces, kernel_timing, latency, clients):
     """PlaidML Machine Learning Benchmarks
     
     plaidbench runs benchmarks for a variety of ML framework, framework backend,
@@ -110,3 +117,5 @@ def plaidbench(ctx, verbose, examples, blanket_run, results, callgrind, epochs,
     runner.kernel_timing = kernel_timing
     runner.print_stacktraces = print_stacktraces
     runner.timeout_secs = timeout_secs
+    runner.latency = latency or clients > 1
+    runner.clients = clients
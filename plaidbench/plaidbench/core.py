@@ -20,6 +20,7 @@ import json
 import logging
 import os
 import signal
+import threading
 import time
 from abc import ABCMeta, abstractmethod, abstractproperty
 from collections import namedtuple
@@ -231,6 +232,50 @@ class ProgramTimeFilter(object):
         return True
 
 
+def _percentile(sorted_values, pct):
+    # Nearest-rank percentile of an already-sorted, non-empty list.
+    idx = min(len(sorted_values) - 1, int(pct / 100.0 * len(sorted_values)))
+    return sorted_values[idx]
+
+
+def _measure_latency(model, batches, clients):
+    """Times single-batch runs issued by closed-loop clients.
+
+    Each of `clients` threads issues its share of `batches` runs back to back, starting the next
+    as soon as the previous one returns.
+
+    Returns:
+        (latencies, wall_time) - The sorted per-run latencies and the total elapsed time, in seconds.
+    """
+    latencies = []
+    errors = []
+    lock = threading.Lock()
+
+    def client(count):
+        mine = []
+        try:
+            for _ in range(count):
+                start = time.time()
+                model.run_batch()
+                mine.append(time.time() - start)
+        except Exception as ex:
+            errors.append(ex)
+        with lock:
+            latencies.extend(mine)
+
+    counts = [batches // clients + (1 if i < batches % clients else 0) for i in range(clients)]
+    threads = [threading.Thread(target=client, args=(count,)) for count in counts if count]
+    start = time.time()
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    wall_time = time.time() - start
+    if errors:
+        raise errors[0]
+    return (sorted(latencies), wall_time)
+
+
 def _inner_run(reports,
                frontend,
                network_names,
@@ -239,7 +284,9 @@ def _inner_run(reports,
                kernel_timing,
                callgrind,
                print_stacktraces,
-               tile=None):
+               tile=None,
+               latency=False,
+               clients=1):
     import plaidbench.cli as pb
     model = frontend.model(params)
     click.secho('Running {0} examples with {1}, batch size {2}, on backend {3}'.format(
@@ -336,6 +383,26 @@ def _inner_run(reports,
               (params.network_name, "%.2f ms" % (exec_per_example * 1000), "%.2f ms / %.2f fps" %
                (tile_exec_per_example * 1000, 1.0 / tile_exec_per_example)))
 
+        if latency:
+            click.echo('Measuring latency with {} client(s)...'.format(clients))
+            batches = max(1, params.examples // params.batch_size)
+            latencies, wall_time = _measure_latency(model, batches, clients)
+            # Latencies are per batch, in seconds, as flat keys so that existing result readers
+            # (e.g. plaidplotter.py) are unaffected.
+            benchmark_results['clients'] = clients
+            benchmark_results['latencies'] = latencies
+            benchmark_results['latency_mean'] = sum(latencies) / len(latencies)
+            for pct in (50, 90, 99):
+                benchmark_results['latency_p{}'.format(pct)] = _percentile(latencies, pct)
+            benchmark_results['latency_max'] = latencies[-1]
+            benchmark_results['examples_per_sec'] = len(latencies) * params.batch_size / wall_time
+            print("%-20s %-25s %-20s" %
+                  ("Latency (ms)", "p50 / p90 / p99", "Throughput (%d clients)" % clients))
+            print("%-20s %-25s %-20s" %
+                  (params.network_name, "%.2f / %.2f / %.2f" %
+                   tuple(benchmark_results['latency_p{}'.format(pct)] * 1000 for pct in (50, 90, 99)),
+                   "%.2f examples/s" % benchmark_results['examples_per_sec']))
+
         (golden_output, precision) = model.golden_output()
         (correct, max_error, max_abs_error,
          fail_ratio) = Runner._check_correctness(golden_output, model_output, precision.value)
@@ -393,6 +460,8 @@ class Runner(object):
         self.kernel_timing = True
         self.timeout_secs = None
         self.tile = None
+        self.latency = False
+        self.clients = 1
 
     def run(self, frontend, backend_name, network_names):
         """Runs a set of benchmarks.
@@ -417,6 +486,8 @@ class Runner(object):
                     self.callgrind,
                     self.print_stacktraces,
                     self.tile,
+                    self.latency,
+                    self.clients,
                 )
         except KeyboardInterrupt:
             click.secho("Aborting all runs...", fg="red")
@@ -527,6 +598,15 @@ class Model(object):
         """
         pass
 
+    def run_batch(self):
+        """Runs the model on a single batch; used to measure per-request latency.
+
+        Implementations which can run a batch more cheaply than run(once=True) may override this.
+        When latency is measured with several clients, this is called concurrently from multiple
+        threads.
+        """
+        return self.run(once=True)
+
     def validate(self):
         """An optional hook for the model to use to validate its parameters."""
         pass
@@ -97,6 +97,10 @@ class _C_Composer(ctypes.Structure):
     pass
 
 
+class _C_AllReduce(ctypes.Structure):
+    pass
+
+
 class _C_Applier(ctypes.Structure):
     pass
 
@@ -109,6 +113,10 @@ class _C_Invocation(ctypes.Structure):
     pass
 
 
+class _C_InvokerWarmup(ctypes.Structure):
+    pass
+
+
 class _C_Gradient(ctypes.Structure):
     pass
 
@@ -371,6 +379,12 @@ class _Library(plaidml.library.Library):
             ctypes.c_int  # plaidml_datatype datatype
         ]
 
+        # PLAIDML_API void plaidml_set_float_accumulation(plaidml_datatype datatype);
+        self.plaidml_set_float_accumulation = lib.plaidml_set_float_accumulation
+        self.plaidml_set_float_accumulation.argtypes = [
+            ctypes.c_int  # plaidml_datatype datatype
+        ]
+
         # PLAIDML_API plaidml_shape* plaidml_alloc_shape(vai_ctx* ctx, plaidml_datatype datatype);
         self.plaidml_alloc_shape = lib.plaidml_alloc_shape
         self.plaidml_alloc_shape.argtypes = [
@@ -611,6 +625,36 @@ class _Library(plaidml.library.Library):
         self.plaidml_add_composer_update.restype = ctypes.c_bool
         self.plaidml_add_composer_update.errcheck = self._check_err
 
+        # PLAIDML_API plaidml_allreduce* plaidml_alloc_allreduce(size_t replicas);
+        self.plaidml_alloc_allreduce = lib.plaidml_alloc_allreduce
+        self.plaidml_alloc_allreduce.argtypes = [
+            ctypes.c_size_t  # size_t replicas
+        ]
+        self.plaidml_alloc_allreduce.restype = ctypes.POINTER(_C_AllReduce)
+        self.plaidml_alloc_allreduce.errcheck = self._check_err
+
+        # PLAIDML_API void plaidml_free_allreduce(plaidml_allreduce* allreduce);
+        self.plaidml_free_allreduce = lib.plaidml_free_allreduce
+        self.plaidml_free_allreduce.argtypes = [
+            ctypes.POINTER(_C_AllReduce)  # plaidml_allreduce* allreduce
+        ]
+
+        # PLAIDML_API bool plaidml_add_composer_allreduce_update(
+        #   plaidml_composer* composer,
+        #   plaidml_allreduce* allreduce,
+        #   plaidml_var* dest_tensor,
+        #   plaidml_var* src_tensor
+        # );
+        self.plaidml_add_composer_allreduce_update = lib.plaidml_add_composer_allreduce_update
+        self.plaidml_add_composer_allreduce_update.argtypes = [
+            ctypes.POINTER(_C_Composer),  # plaidml_composer* composer
+            ctypes.POINTER(_C_AllReduce),  # plaidml_allreduce* allreduce
+            ctypes.POINTER(_C_Var),  # plaidml_var* dest_tensor
+            ctypes.POINTER(_C_Var)  # plaidml_var* src_tensor
+        ]
+        self.plaidml_add_composer_allreduce_update.restype = ctypes.c_bool
+        self.plaidml_add_composer_allreduce_update.errcheck = self._check_err
+
         # PLAIDML_API plaidml_function* plaidml_build_composed_function(plaidml_composer* composer);
         self.plaidml_build_composed_function = lib.plaidml_build_composed_function
         self.plaidml_build_composed_function.argtypes = [
@@ -744,6 +788,37 @@ class _Library(plaidml.library.Library):
             ctypes.POINTER(_C_Invocation)  # plaidml_invocation* invocation
         ]
 
+        # PLAIDML_API plaidml_invoker_warmup* plaidml_prepare_invoker(vai_ctx* ctx, plaidml_invoker* invoker, bool dummy_run);
+        self.plaidml_prepare_invoker = lib.plaidml_prepare_invoker
+        self.plaidml_prepare_invoker.argtypes = [
+            ctypes.POINTER(plaidml.library._C_Context),  # vai_ctx* ctx
+            ctypes.POINTER(_C_Invoker),  # plaidml_invoker* invoker
+            ctypes.c_bool  # bool dummy_run
+        ]
+        self.plaidml_prepare_invoker.restype = ctypes.POINTER(_C_InvokerWarmup)
+        self.plaidml_prepare_invoker.errcheck = self._check_err
+
+        # PLAIDML_API bool plaidml_invoker_warmup_is_ready(plaidml_invoker_warmup* warmup);
+        self.plaidml_invoker_warmup_is_ready = lib.plaidml_invoker_warmup_is_ready
+        self.plaidml_invoker_warmup_is_ready.argtypes = [
+            ctypes.POINTER(_C_InvokerWarmup)  # plaidml_invoker_warmup* warmup
+        ]
+        self.plaidml_invoker_warmup_is_ready.restype = ctypes.c_bool
+
+        # PLAIDML_API bool plaidml_wait_for_invoker_warmup(plaidml_invoker_warmup* warmup);
+        self.plaidml_wait_for_invoker_warmup = lib.plaidml_wait_for_invoker_warmup
+        self.plaidml_wait_for_invoker_warmup.argtypes = [
+            ctypes.POINTER(_C_InvokerWarmup)  # plaidml_invoker_warmup* warmup
+        ]
+        self.plaidml_wait_for_invoker_warmup.restype = ctypes.c_bool
+        self.plaidml_wait_for_invoker_warmup.errcheck = self._check_err
+
+        # PLAIDML_API void plaidml_free_invoker_warmup(plaidml_invoker_warmup* warmup);
+        self.plaidml_free_invoker_warmup = lib.plaidml_free_invoker_warmup
+        self.plaidml_free_invoker_warmup.argtypes = [
+            ctypes.POINTER(_C_InvokerWarmup)  # plaidml_invoker_warmup* warmup
+        ]
+
         # PLAIDML_API plaidml_gradient* plaidml_alloc_gradient(plaidml_var* var);
         self.plaidml_alloc_gradient = lib.plaidml_alloc_gradient
         self.plaidml_alloc_gradient.argtypes = [
@@ -872,6 +947,16 @@ def set_floatx(dtype):
     _lib().plaidml_set_floatx(dtype)
 
 
+def set_float_accumulation(dtype):
+    """Sets the datatype in which float contractions accumulate.
+
+    Tensors stored as FLOAT16 or BFLOAT16 are then summed in the wider type,
+    e.g. FLOAT32, and only rounded to their storage type once.  Pass
+    DType.INVALID to accumulate in the storage type.
+    """
+    _lib().plaidml_set_float_accumulation(dtype)
+
+
 _backtraces = None
 
 
@@ -1412,6 +1497,18 @@ class Applier(object):
         return Var(_lib().plaidml_apply_alloc_output(self, name.encode()))
 
 
+class AllReduce(object):
+    """Sums composer updates across the replicas of a data-parallel computation."""
+
+    def __init__(self, replicas):
+        self._as_parameter_ = _lib().plaidml_alloc_allreduce(replicas)
+        self._free = _lib().plaidml_free_allreduce
+
+    def __del__(self):
+        if hasattr(self, '_free'):
+            self._free(self)
+
+
 class Composer(object):
 
     def __init__(self):
@@ -1434,6 +1531,9 @@ class Composer(object):
     def add_update(self, dest, src):
         _lib().plaidml_add_composer_update(self, dest, src)
 
+    def add_allreduce_update(self, allreduce, dest, src):
+        _lib().plaidml_add_composer_allreduce_update(self, allreduce, dest, src)
+
     def build(self):
         return _Function(_lib().plaidml_build_composed_function(self))
 
@@ -1474,6 +1574,18 @@ class Invoker(object):
     def invoke(self):
         return Invocation(self._ctx, self)
 
+    def prepare(self, dummy_run=False):
+        """Starts compiling the invoker's function for its current bindings in the background.
+
+        Args:
+            dummy_run (bool): If True, the compiled function is also run once against scratch
+                outputs, to page in its kernels and buffers.
+
+        Returns:
+            InvokerWarmup: A handle which may be used to wait for the preparation to finish.
+        """
+        return InvokerWarmup(self._ctx, self, dummy_run)
+
     def save(self, filename):
         _lib().plaidml_save_invoker(self, filename.encode(), 1)
 
@@ -1489,6 +1601,24 @@ class Invocation(object):
             self._free(self)
 
 
+class InvokerWarmup(object):
+
+    def __init__(self, ctx, invoker, dummy_run):
+        self._as_parameter_ = _lib().plaidml_prepare_invoker(ctx, invoker, dummy_run)
+        self._free = _lib().plaidml_free_invoker_warmup
+
+    def __del__(self):
+        if hasattr(self, '_free'):
+            self._free(self)
+
+    @property
+    def ready(self):
+        return _lib().plaidml_invoker_warmup_is_ready(self)
+
+    def wait(self):
+        _lib().plaidml_wait_for_invoker_warmup(self)
+
+
 def gradients(loss, variables):
     g = _lib().plaidml_alloc_gradient(loss)
     try:
@@ -63,7 +63,7 @@ void ExternalLogger::handle(const el::LogDispatchData* data) {
 
 }  // namespace vertexai
 
-extern "C" VAI_API void vai_internal_set_vlog(size_t num) { el::Loggers::setVerboseLevel(num); }
+extern "C" VAI_API void vai_internal_set_vlog(size_t num) { vertexai::SetVerbosity(num); }
 
 extern "C" void vai_set_logger(vertexai::ExternalLogger::Callback logger, void* arg) {
   vertexai::ExternalLogger::SetLoggerCallback(logger, arg);
@@ -141,7 +141,7 @@ _POOL_MODE = {
 class _Function(object):
     """Represents a composed function object."""
 
-    def __init__(self, inputs, outputs, updates, name):
+    def __init__(self, inputs, outputs, updates, name, reuse_outputs=False):
         """Initializes a composed function object.
 
         Args:
@@ -149,6 +149,8 @@ class _Function(object):
             outputs ([ptile.Value]): A list of operation outputs.
             updates ([(ptile.Value, ptile.Value)]): A list of (var, newval) tuples.
             name (str): A name for the function (ignored).
+            reuse_outputs (bool): If True, each call returns the same ndarrays (for as long as the
+                output shapes stay the same), overwritten by the next call, instead of new ones.
         """
         self._name = name
         self._input_names = ['I' + str(n) for n in range(len(inputs))]
@@ -160,35 +162,148 @@ class _Function(object):
                                    updates,
                                    name=name)
         self._invoker = plaidml.Invoker(_ctx, self._func)
+        self._reuse_outputs = reuse_outputs
 
         self._input_types = {}
         for name, val in zip(self._input_names, inputs):
             if is_placeholder(val):
                 self._input_types[name] = ptile.convert_pml_dtype_to_np(val.shape.dtype)
 
-    def __call__(self, inputs):
-        # Inputs: a list of bindings for the placeholders.
+        # The device tensors bound by the last call, by name, with the shapes they were made for.
+        # Calls with the same shapes (e.g. successive batches in predict and fit) overwrite them in
+        # place rather than allocating new ones.
+        self._input_tensors = {}
+        self._output_tensors = {}
+
+        # A second set of input tensors, which prefetch fills in the background while the bound
+        # set is in use; and the prefetch in progress, if any, as (inputs, thread, errors).
+        self._spare_tensors = {}
+        self._prefetch = None
+
+    def _upload(self, tensors, name, val):
+        """Copies an input into its tensor in the given set, making a new tensor if the input's
+        shape doesn't match the existing one's.
+
+        Returns:
+            bool: True if a new tensor was made.
+        """
+        dtype = self._input_types[name]
+        val = np.asarray(val)
+        key = (val.shape, np.dtype(dtype))
+        cached = tensors.get(name)
+        made = cached is None or cached[0] != key
+        if made:
+            tensor = plaidml.Tensor(
+                _device(), plaidml.Shape(_ctx, ptile.convert_np_dtype_to_pml(dtype), *val.shape))
+            tensors[name] = (key, tensor)
+        else:
+            tensor = cached[1]
+        with tensor.mmap_discard(_ctx) as view:
+            view.copy_from_ndarray(val)
+            view.writeback()
+        return made
+
+    @staticmethod
+    def _is_scalar_input(val):
+        return isinstance(val, (float, ptile.Value) + six.integer_types)
+
+    def prefetch(self, inputs):
+        """Starts uploading the inputs for the next call in a background thread.
+
+        The upload overlaps whatever the caller does in the meantime -- typically, the current
+        call's run and readback.  If the next call is made with the same input objects, it binds
+        the uploaded tensors instead of uploading its inputs itself; otherwise, the upload is
+        discarded.
+
+        Args:
+            inputs (list): The next call's inputs.
+        """
+        self._finish_prefetch()
+        batch = list(inputs)
+        spare = self._spare_tensors
+        errors = []
+
+        def upload():
+            try:
+                for (name, val) in zip(self._input_names, batch):
+                    if not self._is_scalar_input(val):
+                        self._upload(spare, name, val)
+            except Exception as ex:
+                errors.append(ex)
+
+        thread = threading.Thread(target=upload, name='plaidml-prefetch')
+        thread.daemon = True
+        thread.start()
+        self._prefetch = (batch, thread, errors)
+
+    def _finish_prefetch(self):
+        """Waits for the prefetch in progress, if any.
+
+        Returns:
+            list: The prefetched inputs, or None if there are none.
+        """
+        if self._prefetch is None:
+            return None
+        batch, thread, errors = self._prefetch
+        self._prefetch = None
+        thread.join()
+        if errors:
+            # The call uploads its inputs itself, which reports the error if it recurs.
+            return None
+        return batch
+
+    def _bind_inputs(self, inputs):
+        inputs = list(inputs)
+        prefetched = self._finish_prefetch()
+        if prefetched is not None and len(prefetched) == len(inputs) and builtins.all(
+                p is i for (p, i) in zip(prefetched, inputs)):
+            self._input_tensors, self._spare_tensors = self._spare_tensors, self._input_tensors
+            swapped = True
+        else:
+            swapped = False
 
         for (name, val) in zip(self._input_names, inputs):
             if isinstance(val, six.integer_types):
-                val = plaidml.Integer(val)
+                self._input_tensors.pop(name, None)
+                self._invoker.set_input(name, plaidml.Integer(val))
             elif isinstance(val, float):
-                val = plaidml.Real(val)
-            else:
-                val = variable(val, dtype=self._input_types[name]).var
-            self._invoker.set_input(name, val)
+                self._input_tensors.pop(name, None)
+                self._invoker.set_input(name, plaidml.Real(val))
+            elif isinstance(val, ptile.Value):
+                self._input_tensors.pop(name, None)
+                self._invoker.set_input(name, variable(val, dtype=self._input_types[name]).var)
+            elif swapped or self._upload(self._input_tensors, name, val):
+                self._invoker.set_input(name, self._input_tensors[name][1])
+
+    def _bind_output(self, name):
+        shape = self._invoker.get_output_shape(name)
+        key = (shape.dtype, tuple(d.size for d in shape.dimensions))
+        cached = self._output_tensors.get(name)
+        if cached is None or cached[0] != key:
+            tensor = plaidml.Tensor(_device(), shape)
+            self._output_tensors[name] = (key, tensor)
+            self._invoker.set_output(name, tensor)
+            return tensor
+        return cached[1]
 
-        tensors = [
-            plaidml.Tensor(_device(), self._invoker.get_output_shape(name))
-            for name in self._output_names
-        ]
+    def __call__(self, inputs):
+        # Inputs: a list of bindings for the placeholders.
+        self._bind_inputs(inputs)
 
-        for (name, t) in zip(self._output_names, tensors):
-            self._invoker.set_output(name, t)
+        tensors = [self._bind_output(name) for name in self._output_names]
 
         self._invoker.invoke()
 
-        return [t.as_ndarray(_ctx) for t in tensors]
+        if self._reuse_outputs:
+            return [t.as_ndarray(_ctx) for t in tensors]
+        results = []
+        for t in tensors:
+            result = np.empty(tuple(d.size for d in t.shape.dimensions),
+                              dtype=plaidml._NP_TYPES[t.shape.dtype])
+            with t.mmap_current() as view:
+                view.copy_to_ndarray(result)
+            results.append(result)
+        return results
 
 
 _k_rng_size = 2048
@@ -815,12 +930,12 @@ def foldr(fn, elems, initializer=None, name=None):
 
 
 @_log_call
-def function(inputs, outputs, updates=None, name=None):
+def function(inputs, outputs, updates=None, name=None, reuse_outputs=False):
     if updates == None:
         updates = []
     if name == None:
         name = ''
-    return _Function(inputs, outputs, updates, name)
+    return _Function(inputs, outputs, updates, name, reuse_outputs)
 
 
 gather = op.gather
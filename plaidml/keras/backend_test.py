@@ -436,6 +436,34 @@ class TestBackendOps(unittest.TestCase):
         x = pkb.identity(pkb.variable(data))
         npt.assert_array_equal(x.eval(), data, "x=plaidml, y=input")
 
+    def testFunctionReusesBuffers(self):
+        x = pkb.placeholder(shape=(None, 3))
+        f = pkb.function([x], [x * 2])
+        first = f([m(2, 3)])[0]
+        second = f([m(2, 3) + 1])[0]
+        third = f([m(4, 3)])[0]
+        npt.assert_array_equal(first, m(2, 3) * 2)
+        npt.assert_array_equal(second, (m(2, 3) + 1) * 2)
+        npt.assert_array_equal(third, m(4, 3) * 2)
+
+        g = pkb.function([x], [x * 2], reuse_outputs=True)
+        first = g([m(2, 3)])[0]
+        second = g([m(2, 3) + 1])[0]
+        self.assertIs(first, second)
+        npt.assert_array_equal(second, (m(2, 3) + 1) * 2)
+
+    def testFunctionPrefetch(self):
+        x = pkb.placeholder(shape=(None, 3))
+        f = pkb.function([x], [x * 2])
+        batches = [m(2, 3) + i for i in range(4)] + [m(5, 3)]
+        for (i, batch) in enumerate(batches):
+            if i + 1 < len(batches):
+                f.prefetch([batches[i + 1]])
+            npt.assert_array_equal(f([batch])[0], batch * 2)
+        # A call with inputs other than the prefetched ones uploads its own.
+        f.prefetch([m(2, 3)])
+        npt.assert_array_equal(f([m(2, 3) + 7])[0], (m(2, 3) + 7) * 2)
+
     @compareForwardExact()
     def testPassthrough(self, b):
         return b.variable(m(3, 3))
@@ -694,6 +694,14 @@ class invoker {
     return invocation;
   }
 
+  // Starts compiling the function for the current bindings in the background;
+  // see plaidml_prepare_invoker().
+  std::unique_ptr<plaidml_invoker_warmup> prepare(bool dummy_run = false) {
+    std::unique_ptr<plaidml_invoker_warmup> warmup{plaidml_prepare_invoker(ctx_->get_ctx(), invoker_.get(), dummy_run)};
+    vai_exception::check_and_throw(warmup);
+    return warmup;
+  }
+
  private:
   std::shared_ptr<ctx> ctx_;
   std::unique_ptr<plaidml_invoker> invoker_;
@@ -23,11 +23,14 @@
 #include <mutex>
 #include <set>
 #include <string>
+#include <thread>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 
 #include <boost/filesystem.hpp>
+#include <boost/thread/executors/basic_thread_pool.hpp>
+#include <boost/thread/future.hpp>
 
 #include "base/config/config.h"
 #include "base/util/any_factory_map.h"
@@ -44,6 +47,7 @@
 #include "plaidml/base/status_strings.h"
 #include "plaidml/config.h"
 #include "plaidml/plaidml.pb.h"
+#include "tile/base/allreduce.h"
 #include "tile/base/buffer.h"
 #include "tile/base/lru_cache.h"
 #include "tile/base/program_cache.h"
@@ -146,12 +150,32 @@ extern "C" bool plaidml_query_devconf(vai_ctx* ctx, plaidml_devconf* devconf, pl
 
 // plaidml_device
 
+namespace {
+
+// The memory budget for each device's compiled programs, from PLAIDML_PROGRAM_CACHE_MB.
+std::uint64_t ProgramCacheBytes() {
+  std::uint64_t mb = 1024;
+  auto env_mb = vertexai::env::Get("PLAIDML_PROGRAM_CACHE_MB");
+  if (env_mb.length()) {
+    mb = std::strtoull(env_mb.c_str(), nullptr, 10);
+  }
+  return mb * std::mega::num;
+}
+
+// With PLAIDML_SPECULATIVE_COMPILE=1, programs which ask for tile scanning start
+// running on an untuned build while the tuned one is compiled in the background.
+bool SpeculativeCompile() { return vertexai::env::Get("PLAIDML_SPECULATIVE_COMPILE") == "1"; }
+
+}  // namespace
+
 class Evaluator final {
  public:
   explicit Evaluator(plaidml_devconf* devconf)
       : platform_{devconf->platform},
         id_{devconf->device.dev_id()},
-        program_cache_{std::make_shared<tile::ProgramCache>(platform_, 500 /* TODO: Make this configurable */)} {}
+        program_cache_{std::make_shared<tile::ProgramCache>(platform_, ProgramCacheBytes(),
+                                                            tile::ProgramCache::kDefaultShardCount,
+                                                            SpeculativeCompile())} {}
 
   const std::shared_ptr<tile::Platform>& get_platform() const { return platform_; }
   const std::string& get_id() const { return id_; }
@@ -615,6 +639,15 @@ extern "C" void plaidml_set_floatx(plaidml_datatype datatype) {
   tile::lang::SetFloatX(dt);
 }
 
+extern "C" void plaidml_set_float_accumulation(plaidml_datatype datatype) {
+  tile::DataType dt = MakeTileDataType(datatype);
+  if (datatype != PLAIDML_DATA_INVALID && !tile::is_float(dt)) {
+    vertexai::SetLastStatus(VAI_STATUS_INVALID_ARGUMENT, status_strings::kInvalidArgument);
+    return;
+  }
+  tile::lang::SetFloatAccumulation(dt);
+}
+
 // plaidml_shape
 
 struct plaidml_shape {
@@ -785,10 +818,38 @@ uint64_t plaidml_get_shape_element_count(plaidml_shape* shape) {
   return shape->shape.elem_size();
 }
 
+// plaidml_allreduce
+
+struct plaidml_allreduce {
+  std::shared_ptr<tile::AllReducer> reducer;
+};
+
+extern "C" plaidml_allreduce* plaidml_alloc_allreduce(size_t replicas) {
+  try {
+    return new plaidml_allreduce{std::make_shared<tile::AllReducer>(replicas)};
+  } catch (...) {
+    vertexai::SetLastException(std::current_exception());
+    return nullptr;
+  }
+}
+
+extern "C" void plaidml_free_allreduce(plaidml_allreduce* allreduce) { delete allreduce; }
+
+namespace {
+
+// An update whose destination is summed across the replicas of an all-reduce.
+struct AllReduceUpdate {
+  std::shared_ptr<tile::AllReducer> reducer;
+  std::shared_ptr<TensorValue> dest;
+};
+
+}  // namespace
+
 // plaidml_function
 
 struct plaidml_function {
   std::shared_ptr<BoundFunction> func;
+  std::vector<AllReduceUpdate> allreduce_updates;
 };
 
 extern "C" plaidml_function* plaidml_build_coded_function(const char* code, const char* id) {
@@ -1075,6 +1136,7 @@ extern "C" bool plaidml_tensor_attach_qparams(plaidml_var* tensor, plaidml_var*
 
 struct plaidml_composer {
   std::shared_ptr<BoundFunction> func;
+  std::vector<AllReduceUpdate> allreduce_updates;
 };
 
 // Predeclare applier
@@ -1157,6 +1219,29 @@ extern "C" bool plaidml_add_composer_update(plaidml_composer* composer, plaidml_
   return true;
 }
 
+extern "C" bool plaidml_add_composer_allreduce_update(plaidml_composer* composer, plaidml_allreduce* allreduce,
+                                                      plaidml_var* dest_tensor, plaidml_var* src_tensor) {
+  if (composer == NULL || allreduce == NULL || dest_tensor == NULL || src_tensor == NULL) {
+    vertexai::SetLastOOM();
+    return false;
+  }
+  try {
+    auto tptr = std::dynamic_pointer_cast<TensorValue>(dest_tensor->value);
+    if (!tptr) {
+      throw vertexai::error::InvalidArgument("Composer update dest must be a tensor");
+    }
+    if (!std::dynamic_pointer_cast<BufferState>(tptr->buffer())) {
+      throw vertexai::error::InvalidArgument("All-reduced update dest must be a tensor bound to a buffer");
+    }
+    composer->func->AddUpdate(tptr, src_tensor->value);
+    composer->allreduce_updates.emplace_back(AllReduceUpdate{allreduce->reducer, tptr});
+  } catch (...) {
+    vertexai::SetLastException(std::current_exception());
+    return false;
+  }
+  return true;
+}
+
 extern "C" plaidml_function* plaidml_build_composed_function(plaidml_composer* composer) {
   if (composer == NULL) {
     vertexai::SetLastOOM();
@@ -1164,7 +1249,7 @@ extern "C" plaidml_function* plaidml_build_composed_function(plaidml_composer* c
   }
   try {
     composer->func->Done();
-    return new plaidml_function{composer->func};
+    return new plaidml_function{composer->func, composer->allreduce_updates};
   } catch (...) {
     vertexai::SetLastException(std::current_exception());
     return nullptr;
@@ -1341,6 +1426,7 @@ std::map<std::string, ApplierParameterShape> ToApplierParameterShapes(
 
 struct plaidml_invoker {
   std::shared_ptr<BoundFunction> func;
+  std::vector<AllReduceUpdate> allreduce_updates;
   std::map<std::string, std::shared_ptr<Value>> inputs;
   std::map<std::string, std::shared_ptr<TensorValue>> outputs;
 
@@ -1399,6 +1485,7 @@ extern "C" plaidml_invoker* plaidml_alloc_invoker(vai_ctx* ctx, plaidml_function
   try {
     auto invoker = std::make_unique<plaidml_invoker>();
     invoker->func = function->func;
+    invoker->allreduce_updates = function->allreduce_updates;
     return invoker.release();
   } catch (...) {
     vertexai::SetLastException(std::current_exception());
@@ -1583,87 +1670,151 @@ class PlatformAllocator : public tile::Allocator {
     return platform_->MakeBuffer(ctx, id_, size);
   }
 
+  std::string device_key() const final {
+    return std::to_string(reinterpret_cast<std::uintptr_t>(platform_.get())) + "/" + id_;
+  }
+
  private:
   std::shared_ptr<tile::Platform> platform_;
   std::string id_;
 };
 
-};  // namespace
+// An invoker's program, bound to the buffers it will be run with.
+struct BoundInvokerProgram {
+  std::shared_ptr<Evaluator> evaluator;
+  tile::proto::Program prog;
+  std::map<std::string, std::shared_ptr<tile::Buffer>> in_buffers;
+  std::map<std::string, std::shared_ptr<tile::Buffer>> out_buffers;
+  std::shared_ptr<tile::ConstBufferManager> const_bufs;
+};
 
-extern "C" plaidml_invocation* plaidml_schedule_invocation(vai_ctx* ctx, plaidml_invoker* invoker) {
-  if (!ctx || !invoker) {
-    vertexai::SetLastOOM();
-    return nullptr;
-  }
-  context::Activity activity{ctx->activity.ctx(), "plaidml::invoker::ScheduleInvocation"};
-  try {
-    auto invocation = std::make_unique<plaidml_invocation>();
-    auto rundown = std::make_shared<context::Rundown>();
-    rundown->TryEnterGate(activity.ctx().gate());
-    BuildInvokerRunInfo(invoker, "invoker_program");
+BoundInvokerProgram BindInvokerProgram(plaidml_invoker* invoker) {
+  BuildInvokerRunInfo(invoker, "invoker_program");
 
-    // Gather up the appropriate buffers
-    std::shared_ptr<Evaluator> evaluator;
+  // Gather up the appropriate buffers
+  BoundInvokerProgram bound;
+  auto& evaluator = bound.evaluator;
+  auto& in_buffers = bound.in_buffers;
+  auto& out_buffers = bound.out_buffers;
 
-    auto in_buffers = BindBuffers(invoker->runinfo->input_buffers, invoker->inputs, &evaluator);
-    auto out_buffers = BindBuffers(invoker->runinfo->output_buffers, invoker->outputs, &evaluator);
+  in_buffers = BindBuffers(invoker->runinfo->input_buffers, invoker->inputs, &evaluator);
+  out_buffers = BindBuffers(invoker->runinfo->output_buffers, invoker->outputs, &evaluator);
+
+  std::unordered_set<const tile::Buffer*> output_set;
+  for (const auto& kv : out_buffers) {
+    output_set.insert(kv.second.get());
+  }
+
+  if (!evaluator) {
+    throw vertexai::error::FailedPrecondition{"Function has neither inputs nor outputs"};
+  }
 
-    std::unordered_set<const tile::Buffer*> output_set;
-    for (const auto& kv : out_buffers) {
-      output_set.insert(kv.second.get());
+  auto& prog = bound.prog;
+  prog.set_dev_id(evaluator->get_id());
+  prog.set_code(invoker->runinfo->code);
+  for (const auto& kv : invoker->runinfo->input_shapes) {
+    auto& input = (*prog.mutable_inputs())[kv.first];
+    *input.mutable_shape() = tile::IntoProto(kv.second);
+    if (output_set.count(in_buffers[kv.first].get())) {
+      input.set_consumed(true);
     }
+  }
+  for (const auto& kv : invoker->runinfo->output_shapes) {
+    *(*prog.mutable_outputs())[kv.first].mutable_shape() = tile::IntoProto(kv.second);
+  }
 
-    if (!evaluator) {
-      throw vertexai::error::FailedPrecondition{"Function has neither inputs nor outputs"};
+  size_t max_trials = 1;
+  auto env_trials = vertexai::env::Get("PLAIDML_KERNEL_TRIALS");
+  if (env_trials.length()) {
+    auto env_value = std::atoi(env_trials.c_str());
+    if (env_value) {
+      max_trials = env_value;
     }
+  }
 
-    tile::proto::Program prog;
-    prog.set_dev_id(evaluator->get_id());
-    prog.set_code(invoker->runinfo->code);
-    for (const auto& kv : invoker->runinfo->input_shapes) {
-      auto& input = (*prog.mutable_inputs())[kv.first];
-      *input.mutable_shape() = tile::IntoProto(kv.second);
-      if (output_set.count(in_buffers[kv.first].get())) {
-        input.set_consumed(true);
-      }
+  size_t max_trial_runs = 1;
+  auto env_runs = vertexai::env::Get("PLAIDML_KERNEL_TRIAL_RUNS");
+  if (env_runs.length()) {
+    auto env_value = std::atoi(env_runs.c_str());
+    if (env_value) {
+      max_trial_runs = env_value;
     }
-    for (const auto& kv : invoker->runinfo->output_shapes) {
-      *(*prog.mutable_outputs())[kv.first].mutable_shape() = tile::IntoProto(kv.second);
+  }
+
+  auto* params = prog.mutable_tile_scanning_params();
+  params->set_max_trials(max_trials);
+  params->set_max_trial_runs(max_trial_runs);
+
+  bound.const_bufs = std::make_shared<tile::ConstBufferManager>();
+  bound.const_bufs->allocator = std::make_shared<PlatformAllocator>(*evaluator);
+  for (const auto& kvp : invoker->runinfo->input_shapes) {
+    if (kvp.second.is_const) {
+      bound.const_bufs->buffers[kvp.first] = in_buffers[kvp.first];
     }
+  }
+  return bound;
+}
 
-    size_t max_trials = 1;
-    auto env_trials = vertexai::env::Get("PLAIDML_KERNEL_TRIALS");
-    if (env_trials.length()) {
-      auto env_value = std::atoi(env_trials.c_str());
-      if (env_value) {
-        max_trials = env_value;
-      }
+// Contributes the invocation's all-reduced updates to their all-reduces,
+// once the run which assigns them completes.
+void ContributeAllReduceUpdates(const context::Context& ctx, const plaidml_invoker& invoker,
+                                const boost::shared_future<void>& ready) {
+  std::vector<std::pair<std::shared_ptr<tile::AllReducer>, std::vector<tile::AllReduceValue>>> contributions;
+  for (const auto& update : invoker.allreduce_updates) {
+    auto it = std::find_if(contributions.begin(), contributions.end(),
+                           [&update](const auto& contribution) { return contribution.first == update.reducer; });
+    if (it == contributions.end()) {
+      it = contributions.emplace(contributions.end(), update.reducer, std::vector<tile::AllReduceValue>{});
     }
+    auto bs = std::static_pointer_cast<BufferState>(update.dest->buffer());
+    it->second.emplace_back(tile::AllReduceValue{bs->buffer(), update.dest->shape().type});
+  }
+  for (auto& contribution : contributions) {
+    contribution.first->Contribute(ctx, std::move(contribution.second), ready);
+  }
+}
 
-    size_t max_trial_runs = 1;
-    auto env_runs = vertexai::env::Get("PLAIDML_KERNEL_TRIAL_RUNS");
-    if (env_runs.length()) {
-      auto env_value = std::atoi(env_runs.c_str());
-      if (env_value) {
-        max_trial_runs = env_value;
+// The pool used to prepare invokers in the background.  It's sized by
+// PLAIDML_PREPARE_THREADS, and deliberately leaked so that process exit
+// doesn't wait on compilations nobody is waiting for.
+boost::basic_thread_pool* PreparePool() {
+  static boost::basic_thread_pool* pool = []() {
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    auto env_threads = vertexai::env::Get("PLAIDML_PREPARE_THREADS");
+    if (env_threads.length()) {
+      auto env_value = std::atoi(env_threads.c_str());
+      if (0 < env_value) {
+        threads = env_value;
       }
     }
+    return new boost::basic_thread_pool{threads};
+  }();
+  return pool;
+}
 
-    auto* params = prog.mutable_tile_scanning_params();
-    params->set_max_trials(max_trials);
-    params->set_max_trial_runs(max_trial_runs);
+}  // namespace
 
-    tile::ConstBufferManager const_bufs;
-    const_bufs.allocator = std::make_shared<PlatformAllocator>(*evaluator);
-    for (const auto& kvp : invoker->runinfo->input_shapes) {
-      if (kvp.second.is_const) {
-        const_bufs.buffers[kvp.first] = in_buffers[kvp.first];
-      }
+extern "C" plaidml_invocation* plaidml_schedule_invocation(vai_ctx* ctx, plaidml_invoker* invoker) {
+  if (!ctx || !invoker) {
+    vertexai::SetLastOOM();
+    return nullptr;
+  }
+  context::Activity activity{ctx->activity.ctx(), "plaidml::invoker::ScheduleInvocation"};
+  try {
+    auto invocation = std::make_unique<plaidml_invocation>();
+    auto rundown = std::make_shared<context::Rundown>();
+    rundown->TryEnterGate(activity.ctx().gate());
+    auto bound = BindInvokerProgram(invoker);
+    auto program = bound.evaluator->MakeProgram(activity.ctx(), bound.prog, bound.const_bufs.get());
+
+    // Run the program, once any sums it uses have been written (or, if the program waits for its sums itself, as
+    // each of its steps needs them)
+    if (!program->WaitsForAllReduce()) {
+      tile::WaitForAllReduce(bound.in_buffers);
+      tile::WaitForAllReduce(bound.out_buffers);
     }
-    auto program = evaluator->MakeProgram(activity.ctx(), prog, &const_bufs);
-
-    // Run the program
-    auto result = program->Run(activity.ctx(), in_buffers, out_buffers);
+    auto result = program->Run(activity.ctx(), bound.in_buffers, bound.out_buffers).share();
+    ContributeAllReduceUpdates(activity.ctx(), *invoker, result);
     result.then(boost::launch::async,
                 [rundown = std::move(rundown), program = std::move(program)](decltype(result) fut) {
                   try {
@@ -1684,6 +1835,77 @@ extern "C" plaidml_invocation* plaidml_schedule_invocation(vai_ctx* ctx, plaidml
 
 extern "C" void plaidml_free_invocation(plaidml_invocation* invocation) { delete invocation; }
 
+// plaidml_invoker_warmup
+
+struct plaidml_invoker_warmup {
+  boost::shared_future<void> ready;
+};
+
+extern "C" plaidml_invoker_warmup* plaidml_prepare_invoker(vai_ctx* ctx, plaidml_invoker* invoker, bool dummy_run) {
+  if (!ctx || !invoker) {
+    vertexai::SetLastOOM();
+    return nullptr;
+  }
+  context::Activity activity{ctx->activity.ctx(), "plaidml::invoker::Prepare"};
+  try {
+    auto warmup = std::make_unique<plaidml_invoker_warmup>();
+    auto rundown = std::make_shared<context::Rundown>();
+    rundown->TryEnterGate(activity.ctx().gate());
+
+    // The binding is captured now, so the caller may rebind the invoker as
+    // soon as this call returns.
+    auto bound = std::make_shared<BoundInvokerProgram>(BindInvokerProgram(invoker));
+    if (dummy_run) {
+      // The dummy run must not disturb the caller's data, so it writes to
+      // scratch buffers: fresh outputs, and fresh copies of any inputs that
+      // the program would consume.  The remaining inputs are only read.
+      PlatformAllocator allocator{*bound->evaluator};
+      for (auto& kvp : bound->out_buffers) {
+        auto scratch = allocator.allocate(invoker->runinfo->output_shapes.at(kvp.first).byte_size());
+        for (auto& in : bound->in_buffers) {
+          if (in.second == kvp.second) {
+            in.second = scratch;
+          }
+        }
+        kvp.second = scratch;
+      }
+    }
+
+    auto prepare = [prepare_ctx = activity.ctx(), rundown = std::move(rundown), bound = std::move(bound), dummy_run]() {
+      auto program = bound->evaluator->MakeProgram(prepare_ctx, bound->prog, bound->const_bufs.get());
+      if (dummy_run) {
+        program->Run(prepare_ctx, bound->in_buffers, bound->out_buffers).get();
+      }
+    };
+    warmup->ready = boost::async(*PreparePool(), std::move(prepare)).share();
+
+    return warmup.release();
+  } catch (...) {
+    vertexai::SetLastException(std::current_exception());
+    return nullptr;
+  }
+}
+
+extern "C" bool plaidml_invoker_warmup_is_ready(plaidml_invoker_warmup* warmup) {
+  return warmup && warmup->ready.is_ready();
+}
+
+extern "C" bool plaidml_wait_for_invoker_warmup(plaidml_invoker_warmup* warmup) {
+  if (!warmup) {
+    vertexai::SetLastOOM();
+    return false;
+  }
+  try {
+    warmup->ready.get();
+    return true;
+  } catch (...) {
+    vertexai::SetLastException(std::current_exception());
+    return false;
+  }
+}
+
+extern "C" void plaidml_free_invoker_warmup(plaidml_invoker_warmup* warmup) { delete warmup; }
+
 // plaidml_gradient
 
 struct plaidml_gradient {
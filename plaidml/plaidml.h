@@ -246,6 +246,11 @@ typedef struct plaidml_shape plaidml_shape;
 // Set the default datatype for floating-point computations.
 PLAIDML_API void plaidml_set_floatx(plaidml_datatype datatype);
 
+// Set the datatype in which floating-point contractions accumulate when their
+// outputs are stored at a lower precision, e.g. FLOAT32 for FLOAT16 tensors.
+// PLAIDML_DATA_INVALID accumulates in the output's own datatype (the default).
+PLAIDML_API void plaidml_set_float_accumulation(plaidml_datatype datatype);
+
 // Allocates a shape, or returns NULL if the library cannot allocate sufficient
 // memory.  Note that shapes must have dimensions added before use.
 PLAIDML_API plaidml_shape* plaidml_alloc_shape(vai_ctx* ctx, plaidml_datatype datatype);
@@ -407,6 +412,35 @@ PLAIDML_API bool plaidml_add_composer_dependency(plaidml_composer* composer, pla
 PLAIDML_API bool plaidml_add_composer_update(plaidml_composer* composer, plaidml_var* dest_tensor,
                                              plaidml_var* src_tensor);
 
+// A PlaidML all-reduce sums tensor updates across the replicas of a
+// data-parallel computation, such as a training step whose replicas run on
+// several devices and whose gradients must be summed before they're applied.
+#ifdef __cplusplus
+struct plaidml_allreduce;
+#else
+typedef struct plaidml_allreduce plaidml_allreduce;
+#endif  // __cplusplus
+
+// Allocates an all-reduce over the given number of replicas, or returns NULL
+// if the library cannot allocate sufficient memory.
+PLAIDML_API plaidml_allreduce* plaidml_alloc_allreduce(size_t replicas);
+
+// Frees an all-reduce.  This waits for any reduction in flight.  Freeing a
+// NULL all-reduce is a no-op.
+PLAIDML_API void plaidml_free_allreduce(plaidml_allreduce* allreduce);
+
+// Adds an all-reduced tensor update to a composed function: like
+// plaidml_add_composer_update, the source tensor is assigned to the
+// destination tensor each time the function is invoked; but once each of the
+// all-reduce's replicas has invoked its function, every replica's
+// destination tensor holds the sum of the replicas' assignments.  Each
+// replica's function (typically bound to tensors on its own device) should
+// add the same all-reduced updates, in the same order, and each replica
+// should invoke its function once per round.  Invocations which use the
+// destination tensors wait for their sums.
+PLAIDML_API bool plaidml_add_composer_allreduce_update(plaidml_composer* composer, plaidml_allreduce* allreduce,
+                                                       plaidml_var* dest_tensor, plaidml_var* src_tensor);
+
 // Builds the function described by the composer.  This should be called at
 // most once per composer; after this call, the only valid operation on the
 // composer is plaidml_free_composer().
@@ -548,6 +582,43 @@ PLAIDML_API plaidml_invocation* plaidml_schedule_invocation(vai_ctx* ctx, plaidm
 // used for any subsequent calls.  Freeing a NULL invocation is a no-op.
 PLAIDML_API void plaidml_free_invocation(plaidml_invocation* invocation);
 
+// A PlaidML invoker warmup tracks the ahead-of-time preparation of an
+// invoker's function.
+#ifdef __cplusplus
+struct plaidml_invoker_warmup;
+#else
+typedef struct plaidml_invoker_warmup plaidml_invoker_warmup;
+#endif  // __cplusplus
+
+// Starts preparing an invoker's function for its current input and
+// output bindings, so that a later plaidml_schedule_invocation() with
+// the same shapes doesn't pay for compiling the function.
+//
+// As with plaidml_schedule_invocation(), the invoker must be fully
+// specified.  The bindings are captured when this call returns; the
+// invoker may then be rebound and used as usual.  The function is
+// compiled in the background on a shared thread pool (sized by
+// PLAIDML_PREPARE_THREADS); invocations scheduled while the compilation
+// is in flight wait for it rather than compiling the function again.
+//
+// If dummy_run is true, the compiled function is also run once, reading
+// the bound inputs and writing to scratch outputs, to page in the
+// kernels and buffers; the bound outputs are not modified.
+//
+// Returns NULL if the preparation could not be started.
+PLAIDML_API plaidml_invoker_warmup* plaidml_prepare_invoker(vai_ctx* ctx, plaidml_invoker* invoker, bool dummy_run);
+
+// Returns true iff the warmup has finished, successfully or not.
+PLAIDML_API bool plaidml_invoker_warmup_is_ready(plaidml_invoker_warmup* warmup);
+
+// Waits for the warmup to finish.  Returns false, setting the last
+// status, if the preparation failed.
+PLAIDML_API bool plaidml_wait_for_invoker_warmup(plaidml_invoker_warmup* warmup);
+
+// Frees a warmup.  Freeing a warmup does not cancel the preparation,
+// which continues in the background.  Freeing a NULL warmup is a no-op.
+PLAIDML_API void plaidml_free_invoker_warmup(plaidml_invoker_warmup* warmup);
+
 // A PlaidML gradient computes gradient data for a given scalar.
 #ifdef __cplusplus
 struct plaidml_gradient;
@@ -612,6 +683,11 @@ struct default_delete<::plaidml_composer> {
   void operator()(::plaidml_composer* composer) const noexcept { ::plaidml_free_composer(composer); }
 };
 
+template <>
+struct default_delete<::plaidml_allreduce> {
+  void operator()(::plaidml_allreduce* allreduce) const noexcept { ::plaidml_free_allreduce(allreduce); }
+};
+
 template <>
 struct default_delete<::plaidml_applier> {
   void operator()(::plaidml_applier* applier) const noexcept { ::plaidml_free_applier(applier); }
@@ -627,6 +703,11 @@ struct default_delete<::plaidml_invocation> {
   void operator()(::plaidml_invocation* invocation) const noexcept { ::plaidml_free_invocation(invocation); }
 };
 
+template <>
+struct default_delete<::plaidml_invoker_warmup> {
+  void operator()(::plaidml_invoker_warmup* warmup) const noexcept { ::plaidml_free_invoker_warmup(warmup); }
+};
+
 template <>
 struct default_delete<::plaidml_gradient> {
   void operator()(::plaidml_gradient* gradient) const noexcept { ::plaidml_free_gradient(gradient); }
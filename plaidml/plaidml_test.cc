@@ -171,6 +171,73 @@ TEST(PlaidML_C_API, BroadcastOne) {
   }
 }
 
+TEST(PlaidML_C_API, PrepareInvoker) {
+  vai_clear_status();
+
+  std::unique_ptr<plaidml_function> add{plaidml_build_coded_function("function (A, B) -> (C) { C = A + B; }", nullptr)};
+  EXPECT_THAT(vai_last_status(), IsVaiStatus(VAI_STATUS_OK));
+
+  std::unique_ptr<vai_ctx> ctx{vai_alloc_ctx()};
+  std::unique_ptr<plaidml_device_enumerator> dev_enum{
+      plaidml_alloc_device_enumerator_with_config(ctx.get(), vertexai::testing::PlaidMLConfig(), nullptr, nullptr)};
+  std::unique_ptr<plaidml_device> dev{
+      plaidml_open_device(ctx.get(), plaidml_get_devconf(ctx.get(), dev_enum.get(), 0))};
+  EXPECT_THAT(vai_last_status(), IsVaiStatus(VAI_STATUS_OK));
+
+  std::unique_ptr<plaidml_buffer> bufs[3];
+  for (auto& buf : bufs) {
+    buf.reset(plaidml_alloc_buffer(ctx.get(), dev.get(), 3 * sizeof(float)));
+    EXPECT_THAT(vai_last_status(), IsVaiStatus(VAI_STATUS_OK));
+  }
+  for (size_t idx = 0; idx < 3; ++idx) {
+    std::unique_ptr<plaidml_mapping> map{plaidml_map_buffer_discard(ctx.get(), bufs[idx].get())};
+    float* base = reinterpret_cast<float*>(plaidml_get_mapping_base(ctx.get(), map.get()));
+    ASSERT_THAT(base, NotNull());
+    for (size_t i = 0; i < 3; ++i) {
+      base[i] = idx == 2 ? -1.0 : (idx + 1) * (i + 1);
+    }
+    plaidml_writeback_mapping(ctx.get(), map.get());
+  }
+
+  std::unique_ptr<plaidml_shape> shape{plaidml_alloc_shape(ctx.get(), PLAIDML_DATA_FLOAT32)};
+  plaidml_add_dimension(ctx.get(), shape.get(), 3, 1);
+
+  std::unique_ptr<plaidml_var> a{plaidml_alloc_tensor(ctx.get(), bufs[0].get(), shape.get())};
+  std::unique_ptr<plaidml_var> b{plaidml_alloc_tensor(ctx.get(), bufs[1].get(), shape.get())};
+  std::unique_ptr<plaidml_var> c{plaidml_alloc_tensor(ctx.get(), bufs[2].get(), shape.get())};
+
+  std::unique_ptr<plaidml_invoker> invoker{plaidml_alloc_invoker(ctx.get(), add.get())};
+  plaidml_set_invoker_input(invoker.get(), "A", a.get());
+  plaidml_set_invoker_input(invoker.get(), "B", b.get());
+  plaidml_set_invoker_output(invoker.get(), "C", c.get());
+
+  std::unique_ptr<plaidml_invoker_warmup> warmup{plaidml_prepare_invoker(ctx.get(), invoker.get(), true)};
+  ASSERT_THAT(warmup, NotNull());
+  EXPECT_TRUE(plaidml_wait_for_invoker_warmup(warmup.get()));
+  EXPECT_TRUE(plaidml_invoker_warmup_is_ready(warmup.get()));
+
+  // The dummy run writes to scratch outputs, not to C.
+  {
+    std::unique_ptr<plaidml_mapping> c_map{plaidml_map_buffer_current(bufs[2].get(), nullptr, nullptr)};
+    float* base = reinterpret_cast<float*>(plaidml_get_mapping_base(ctx.get(), c_map.get()));
+    ASSERT_THAT(base, NotNull());
+    EXPECT_FLOAT_EQ(base[0], -1.0);
+    EXPECT_FLOAT_EQ(base[2], -1.0);
+  }
+
+  std::unique_ptr<plaidml_invocation> invocation{plaidml_schedule_invocation(ctx.get(), invoker.get())};
+  EXPECT_THAT(vai_last_status(), IsVaiStatus(VAI_STATUS_OK));
+
+  {
+    std::unique_ptr<plaidml_mapping> c_map{plaidml_map_buffer_current(bufs[2].get(), nullptr, nullptr)};
+    float* base = reinterpret_cast<float*>(plaidml_get_mapping_base(ctx.get(), c_map.get()));
+    ASSERT_THAT(base, NotNull());
+    EXPECT_FLOAT_EQ(base[0], 3.0);
+    EXPECT_FLOAT_EQ(base[1], 6.0);
+    EXPECT_FLOAT_EQ(base[2], 9.0);
+  }
+}
+
 TEST(PlaidML_C_API, BroadcastBoth) {
   vai_clear_status();
 
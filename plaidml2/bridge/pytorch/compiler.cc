@@ -470,11 +470,12 @@ std::map<Symbol, OpFunction> kSupportedOps = {
 
 const at::Symbol Compiler::symbol = Symbol::fromQualString("plaidml::CompilationGroup");
 
-Compiler::Compiler(const std::string& device_id, const std::string& target_id, const Node* node)
-    : device_id_(device_id),                //
-      target_id_(target_id),                //
-      subgraph_(node->g(attr::Subgraph)) {  //
-}
+Compiler::Compiler(const std::string& device_id, const std::string& target_id, const Node* node,
+                   size_t cache_size)
+    : device_id_(device_id),               //
+      target_id_(target_id),               //
+      subgraph_(node->g(attr::Subgraph)),  //
+      cache_size_(cache_size) {}
 
 bool Compiler::is_supported(Node* node) {
   IVLOG(2, "Compiler::is_supported> " << node->kind().toQualString());
@@ -502,21 +503,35 @@ void Compiler::run(Stack* stack) {
   size_t num_inputs = subgraph_->inputs().size();
   at::ArrayRef<IValue> inputs = last(*stack, num_inputs);
 
-  CompleteArgumentSpec spec{false, inputs};
-  auto it = cache_.find(spec);
-  if (it == cache_.end()) {
-    std::tie(it, std::ignore) = cache_.emplace(spec, compile(inputs));
-  }
-
-  auto outputs = it->second->run(inputs);
+  auto outputs = lookup(inputs)->run(inputs);
 
   drop(*stack, num_inputs);
   for (const auto& output : outputs) {
-    auto var = torch::autograd::make_variable(output.toTensor());
+    auto var = torch::autograd::make_variable(output);
     stack->push_back(IValue(var));
   }
 }
 
+std::shared_ptr<Executable> Compiler::lookup(at::ArrayRef<IValue> inputs) {
+  CompleteArgumentSpec spec{false, inputs};
+  auto it = cache_.find(spec);
+  if (it != cache_.end()) {
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return it->second->second;
+  }
+  auto exec = compile(inputs);
+  if (cache_size_) {
+    lru_.emplace_front(spec, exec);
+    cache_.emplace(spec, lru_.begin());
+    while (cache_size_ < lru_.size()) {
+      IVLOG(1, "Compiler::lookup> evicting " << lru_.size() - 1);
+      cache_.erase(lru_.back().first);
+      lru_.pop_back();
+    }
+  }
+  return exec;
+}
+
 std::shared_ptr<Executable> Compiler::compile(at::ArrayRef<IValue> inputs) {
   IVLOG(1, "Compiler::compile>");
   std::vector<edsl::Tensor> input_tensors;
@@ -600,7 +615,38 @@ std::shared_ptr<Executable> Compiler::compile(at::ArrayRef<IValue> inputs) {
 
 static size_t g_program_id = 1;
 
-// TODO: FIXME sometime
+namespace {
+
+// Returns the tensor in the layout PlaidML expects: a dense, row-major CPU
+// float tensor.  Tensors which already have this layout are returned as-is,
+// so that their storage can be bound without a copy.
+at::Tensor AsDenseHostTensor(const at::Tensor& tensor) {
+  if (tensor.device().is_cpu() && tensor.scalar_type() == at::kFloat && tensor.is_contiguous()) {
+    return tensor;
+  }
+  return tensor.to(at::kCPU, at::kFloat).contiguous();
+}
+
+// Binds the tensor's storage to a PlaidML buffer.  Returns true if the buffer
+// aliases the storage; otherwise, the buffer is a device-side allocation, which
+// is initialized from the storage if copy_in is set.
+bool BindHostTensor(const std::string& device_id, const at::Tensor& tensor, bool copy_in, plaidml::Buffer* buffer) {
+  std::vector<int64_t> sizes(tensor.sizes().begin(), tensor.sizes().end());
+  plaidml::TensorShape shape(PLAIDML_DATA_FLOAT32, sizes);
+  auto ptr = plaidml::ffi::call<plaidml_buffer*>(plaidml_buffer_wrap, device_id.c_str(), tensor.data_ptr(),
+                                                 shape.nbytes());
+  if (ptr) {
+    *buffer = plaidml::Buffer(ptr, shape);
+    return true;
+  }
+  *buffer = plaidml::Buffer(device_id, shape);
+  if (copy_in) {
+    buffer->copy_from(tensor.data_ptr());
+  }
+  return false;
+}
+
+}  // namespace
 
 Executable::Executable(                       //
     const std::string& device_id,             //
@@ -609,54 +655,56 @@ Executable::Executable(                       //
     const std::vector<edsl::Tensor>& outputs)
     : device_id_(device_id),  //
       target_id_(target_id),
-      // input_bindings_(inputs.size()),
-      output_ivalues_(outputs.size()) {
-  // for (size_t i = 0; i < inputs.size(); i++) {
-  //   auto shape = inputs[i].shape();
-  //   plaidml::TensorShape tensor_shape(shape.dtype(), shape.int_dims());
-  //   plaidml::Buffer buffer(device_id, tensor_shape);
-  //   input_bindings_[i] = plaidml::exec::Binding{inputs[i], buffer};
-  // }
+      inputs_(inputs) {
   std::stringstream ss;
   ss << "pytorch_" << g_program_id++;
   name_ = ss.str();
   edsl::Program program(name_, outputs);
-  // program_ = std::make_unique<edsl::Program>(name_, outputs);
   IVLOG(1, "Executable::Executable>");
   IVLOG(2, program.str());
-  binder_ = std::make_unique<plaidml::exec::Binder>(program);
-  // for (size_t i = 0; i < outputs.size(); i++) {
-  //   // auto shape = outputs[i].shape();
-  //   // plaidml::TensorShape tensor_shape(shape.dtype(), shape.int_dims());
-  //   // output_bindings_.emplace_back(plaidml::exec::Binding{
-  //   //     program_->outputs().at(i),                // tensor
-  //   //     plaidml::Buffer{device_id, tensor_shape}  // buffer
-  //   // });
-  //   std::vector<int64_t> sizes;
-  //   auto dims = shape.int_dims();
-  //   for (size_t j = 0; j < dims.size(); j++) {
-  //     sizes.push_back(dims[j]);
-  //   }
-  //   output_ivalues_[i] = at::empty(at::IntArrayRef(sizes));
-  // }
-  // exec_ =
-  //     std::make_shared<plaidml::exec::Executable>(*program_, device_id_, target_id_, input_bindings_,
-  //     output_bindings_);
-  exec_ = binder_->compile();
+  outputs_ = program.outputs();
+  plaidml::exec::Binder binder(program);
+  if (!device_id_.empty()) {
+    binder.set_device(device_id_);
+  }
+  if (!target_id_.empty()) {
+    binder.set_target(target_id_);
+  }
+  exec_ = binder.compile();
   IVLOG(1, "Executable::Executable> done");
 }
 
-at::ArrayRef<torch::jit::IValue> Executable::run(at::ArrayRef<torch::jit::IValue> inputs) {
+std::vector<at::Tensor> Executable::run(at::ArrayRef<torch::jit::IValue> inputs) {
   IVLOG(1, "Executable::run> " << name_);
-  // for (size_t i = 0; i < input_bindings_.size(); i++) {
-  //   input_bindings_[i].buffer.copy_from(inputs[i].toTensor().data_ptr());
-  // }
-  exec_->run();
-  // for (size_t i = 0, j = 0; i < output_bindings_.size(); i++) {
-  //   if (output_ivalues_[i].isTensor()) {
-  //     output_bindings_[j++].buffer.copy_into(output_ivalues_[i].toTensor().data_ptr());
-  //   }
-  // }
+  // The host tensors must stay alive until the run has finished, since the
+  // buffers may alias their storage.
+  std::vector<at::Tensor> input_tensors;
+  std::vector<plaidml::exec::Binding> input_bindings;
+  for (size_t i = 0; i < inputs_.size(); i++) {
+    input_tensors.emplace_back(AsDenseHostTensor(inputs[i].toTensor()));
+    plaidml::Buffer buffer;
+    BindHostTensor(device_id_, input_tensors.back(), true, &buffer);
+    input_bindings.emplace_back(plaidml::exec::Binding{inputs_[i], buffer});
+  }
+
+  std::vector<at::Tensor> outputs;
+  std::vector<plaidml::exec::Binding> output_bindings;
+  std::vector<bool> aliased_outputs;
+  for (size_t i = 0; i < outputs_.size(); i++) {
+    auto dims = outputs_[i].shape.int_dims();
+    outputs.emplace_back(at::empty(at::IntArrayRef(dims), at::TensorOptions().dtype(at::kFloat)));
+    plaidml::Buffer buffer;
+    aliased_outputs.push_back(BindHostTensor(device_id_, outputs.back(), false, &buffer));
+    output_bindings.emplace_back(plaidml::exec::Binding{outputs_[i].tensor.tensor, buffer});
+  }
+
+  exec_->run(input_bindings, output_bindings);
+
+  for (size_t i = 0; i < outputs_.size(); i++) {
+    if (!aliased_outputs[i]) {
+      output_bindings[i].buffer.copy_into(outputs[i].data_ptr());
+    }
+  }
   IVLOG(1, "Executable::run> done");
-  return output_ivalues_;
+  return outputs;
 }
@@ -5,9 +5,11 @@
 #include <torch/csrc/jit/argument_spec.h>
 #include <torch/csrc/jit/ir.h>
 
+#include <list>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "plaidml2/edsl/edsl.h"
@@ -20,25 +22,30 @@ class Executable {
              const std::vector<plaidml::edsl::Tensor>& inputs,  //
              const std::vector<plaidml::edsl::Tensor>& outputs);
 
-  at::ArrayRef<torch::jit::IValue> run(at::ArrayRef<torch::jit::IValue> inputs);
+  // Runs the program against the supplied tensors.  Contiguous CPU float
+  // tensors (including those imported via DLPack) are bound without copying
+  // wherever the device can use host memory directly; the outputs are
+  // allocated by ATen and written in place the same way.
+  std::vector<at::Tensor> run(at::ArrayRef<torch::jit::IValue> inputs);
 
  private:
   std::string device_id_;
   std::string target_id_;
-  std::unique_ptr<plaidml::edsl::Program> program_;
-  std::unique_ptr<plaidml::exec::Binder> binder_;
+  std::vector<plaidml::edsl::Tensor> inputs_;
+  std::vector<plaidml::edsl::ProgramArgument> outputs_;
   std::shared_ptr<plaidml::exec::Executable> exec_;
-  // std::vector<plaidml::exec::Binding> input_bindings_;
-  // std::vector<plaidml::exec::Binding> output_bindings_;
-  std::vector<torch::jit::IValue> output_ivalues_;
   std::string name_;
 };
 
 class Compiler {
  public:
+  // The number of argument specializations each compilation group keeps compiled.
+  static constexpr size_t kDefaultCacheSize = 64;
+
   explicit Compiler(const std::string& device_id,  //
                     const std::string& target_id,  //
-                    const torch::jit::Node* node);
+                    const torch::jit::Node* node,  //
+                    size_t cache_size = kDefaultCacheSize);
 
   void run(torch::jit::Stack* stack);
 
@@ -47,10 +54,16 @@ class Compiler {
 
  private:
   std::shared_ptr<Executable> compile(at::ArrayRef<torch::jit::IValue> inputs);
+  std::shared_ptr<Executable> lookup(at::ArrayRef<torch::jit::IValue> inputs);
 
  private:
+  using CacheEntry = std::pair<torch::jit::CompleteArgumentSpec, std::shared_ptr<Executable>>;
+
   std::string device_id_;
   std::string target_id_;
   std::shared_ptr<torch::jit::Graph> subgraph_;
-  std::unordered_map<torch::jit::CompleteArgumentSpec, std::shared_ptr<Executable>> cache_;
+  size_t cache_size_;
+  // Recently used entries are at the front; the next entry to evict is at the back.
+  std::list<CacheEntry> lru_;
+  std::unordered_map<torch::jit::CompleteArgumentSpec, std::list<CacheEntry>::iterator> cache_;
 };
@@ -10,6 +10,7 @@ import plaidml2.bridge.pytorch as plaidml_pytorch
 import skimage
 import torch
 import torch.nn.functional as F
+import torch.utils.dlpack
 from plaidml2.bridge.pytorch.test_utils import TestBase
 
 
@@ -40,6 +41,17 @@ class TestOps(TestBase):
         jit_out, pml_out = self._run_both(mul, [x, y, z])
         assert torch.allclose(jit_out, pml_out)
 
+    def test_noncontiguous_and_dlpack(self):
+        x = torch.randn(64, 32).t()
+        y = torch.utils.dlpack.from_dlpack(torch.utils.dlpack.to_dlpack(torch.randn(32, 64)))
+        z = torch.randn(32, 64)
+
+        def mul(a, b, c):
+            return a * b * c
+
+        jit_out, pml_out = self._run_both(mul, [x, y, z])
+        assert torch.allclose(jit_out, pml_out)
+
     def test_conv_simple(self):
         shape = (1, 3, 224, 224)
         kernel_size = 7
@@ -28,6 +28,7 @@ using namespace torch::jit;  // NOLINT
 static bool g_fusion_enabled = false;
 static std::string g_device_id;  // NOLINT
 static std::string g_target_id;  // NOLINT
+static size_t g_cache_size = Compiler::kDefaultCacheSize;
 
 size_t g_verbosity = 0;
 
@@ -47,7 +48,7 @@ PYBIND11_MODULE(plaidml_pytorch, module) {
   RegisterOperators op({Operator(
       Compiler::symbol,
       [](const Node* node) {
-        auto compiler = std::make_shared<Compiler>(g_device_id, g_target_id, node);
+        auto compiler = std::make_shared<Compiler>(g_device_id, g_target_id, node, g_cache_size);
         return [compiler](Stack& stack) {
           RECORD_FUNCTION("PlaidML", std::vector<c10::IValue>());
           compiler->run(&stack);
@@ -67,4 +68,5 @@ PYBIND11_MODULE(plaidml_pytorch, module) {
       pybind11::arg("target_id"));
   module.def("disable", []() { g_fusion_enabled = false; });
   module.def("set_vlog", [](size_t verbosity) { g_verbosity = verbosity; });
+  module.def("set_cache_size", [](size_t cache_size) { g_cache_size = cache_size; });
 }
@@ -7,7 +7,7 @@ from collections import namedtuple
 
 import numpy as np
 from plaidml2.core._version import PLAIDML_VERSION
-from plaidml2.ffi import Error, ForeignObject, ffi, ffi_call, lib
+from plaidml2.ffi import Error, ForeignObject, decode_str, ffi, ffi_call, lib
 
 
 def __init():
@@ -184,6 +184,21 @@ class _View(ForeignObject):
     def writeback(self):
         ffi_call(lib.plaidml_view_writeback, self.as_ptr())
 
+    @property
+    def __array_interface__(self):
+        # Lets NumPy read and write the mapped memory in place; arrays made from
+        # the view keep it alive, but must not be used after writeback().
+        return {
+            'version': 3,
+            'shape': tuple(self.shape.sizes),
+            'typestr': np.dtype(self.shape.dtype.into_numpy()).str,
+            'data': (int(ffi.cast('uintptr_t', ffi_call(lib.plaidml_view_data, self.as_ptr()))), False),
+        }
+
+    def as_ndarray(self):
+        """Returns an array aliasing the mapped memory, without copying."""
+        return np.asarray(self)
+
     def copy_from_ndarray(self, src):
         dst = np.frombuffer(self.data, dtype=self.shape.dtype.into_numpy())
         dst = dst.reshape(self.shape.sizes)
@@ -201,16 +216,41 @@ class Buffer(ForeignObject):
     def __init__(self, shape, device=None, ptr=None):
         self._shape = shape
         self._ndarray = None
+        self._base = None  # The wrapped array, if any
         if ptr:
             ffi_obj = ptr
         elif device:
             ffi_obj = ffi_call(lib.plaidml_buffer_alloc, device.encode(), shape.nbytes)
         super(Buffer, self).__init__(ffi_obj)
 
+    @staticmethod
+    def from_ndarray(ndarray, device):
+        """Makes a buffer on the device holding the array's contents.  Where the
+        device can use the array's memory directly (e.g. the CPU device, given an
+        aligned, C-contiguous, writeable array), the buffer aliases the array
+        without copying, and keeps a reference to it; writes to either are seen
+        by the other.  Otherwise the buffer is a copy."""
+        shape = TensorShape(DType.from_numpy(ndarray.dtype), list(ndarray.shape))
+        flags = ndarray.flags
+        if flags.c_contiguous and flags.aligned and flags.writeable:
+            ptr = ffi_call(lib.plaidml_buffer_wrap, device.encode(),
+                           ffi.cast('void*', ndarray.ctypes.data), shape.nbytes)
+            if ptr:
+                buffer = Buffer(shape, ptr=ptr)
+                buffer._base = ndarray
+                return buffer
+        buffer = Buffer(shape, device=device)
+        buffer.copy_from_ndarray(ndarray)
+        return buffer
+
     @property
     def shape(self):
         return self._shape
 
+    @property
+    def host_resident(self):
+        return ffi_call(lib.plaidml_buffer_host_resident, self.as_ptr())
+
     @contextlib.contextmanager
     def mmap_current(self):
         yield _View(ffi_call(lib.plaidml_buffer_mmap_current, self.as_ptr()), self.shape)
@@ -231,3 +271,8 @@ class Buffer(ForeignObject):
         with self.mmap_discard() as view:
             view.copy_from_ndarray(ndarray)
             view.writeback()
+
+
+def perf_counters_export():
+    """Returns the current performance counters in the Prometheus text format."""
+    return decode_str(ffi_call(lib.plaidml_perf_counters_export))
@@ -143,10 +143,30 @@ class Buffer {
   explicit Buffer(plaidml_buffer* ptr, const TensorShape& shape)
       : ptr_(details::make_plaidml_buffer(ptr)), shape_(shape) {}
 
+  // Makes a buffer backed by the supplied host memory, which must outlive the
+  // buffer.  Where the device can't use the memory directly (e.g. it isn't
+  // page-aligned, or the device has no unified memory), the buffer is instead
+  // allocated on the device and initialized with a copy of the data.
+  static Buffer wrap(const std::string& device, const TensorShape& shape, void* data) {
+    auto ptr = ffi::call<plaidml_buffer*>(plaidml_buffer_wrap, device.c_str(), data, shape.nbytes());
+    if (ptr) {
+      return Buffer(ptr, shape);
+    }
+    Buffer buffer(device, shape);
+    buffer.copy_from(data);
+    return buffer;
+  }
+
   plaidml_buffer* as_ptr() const {  //
     return ptr_.get();
   }
 
+  // Returns true if the buffer's memory is host memory, which views map
+  // directly, without waiting or copying.
+  bool host_resident() const {  //
+    return ffi::call<bool>(plaidml_buffer_host_resident, ptr_.get());
+  }
+
   View mmap_current() {
     return View(details::make_plaidml_view(ffi::call<plaidml_view*>(plaidml_buffer_mmap_current, ptr_.get())));
   }
@@ -181,4 +201,8 @@ struct Settings {
   }
 };
 
+inline std::string perf_counters_export() {  //
+  return ffi::str(ffi::call<plaidml_string*>(plaidml_perf_counters_export));
+}
+
 }  // namespace plaidml
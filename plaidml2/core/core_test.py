@@ -2,6 +2,8 @@
 
 import unittest
 
+import numpy as np
+
 import plaidml2 as plaidml
 import plaidml2.core as pcore
 
@@ -15,6 +17,16 @@ class TestCore(unittest.TestCase):
         print(settings)
         self.assertIn('FOO', settings)
 
+    def test_buffer_from_ndarray(self):
+        array = np.arange(6, dtype=np.float32).reshape(2, 3)
+        buffer = pcore.Buffer.from_ndarray(array, 'llvm_cpu.0')
+        self.assertTrue(buffer.host_resident)
+        with buffer.mmap_current() as view:
+            mapped = view.as_ndarray()
+            self.assertEqual(mapped.shape, (2, 3))
+            mapped[1, 2] = 42
+        self.assertEqual(array[1, 2], 42)
+
 
 if __name__ == '__main__':
     unittest.main()
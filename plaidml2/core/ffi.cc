@@ -8,15 +8,20 @@
 #include <utility>
 #include <vector>
 
+#include <boost/algorithm/string/predicate.hpp>
 #include <boost/filesystem.hpp>
 
 #include "base/context/context.h"
 #include "base/context/eventlog.h"
 #include "base/eventing/file/eventlog.h"
+#include "base/eventing/file/ring_eventlog.h"
+#include "base/eventing/file/trace_eventlog.h"
 #include "base/util/env.h"
+#include "base/util/perf_counter.h"
 #include "plaidml2/core/internal.h"
 #include "plaidml2/core/settings.h"
 #include "tile/platform/local_machine/platform.h"
+#include "tile/platform/remote/platform.h"
 
 #ifdef PLAIDML_AST
 using vertexai::tile::TensorDimension;
@@ -35,12 +40,21 @@ using plaidml::core::Settings;
 using vertexai::context::Context;
 using vertexai::tile::DataType;
 using LocalPlatform = vertexai::tile::local_machine::Platform;
+using RemotePlatform = vertexai::tile::remote::Platform;
 
 extern const char* PLAIDML_VERSION;
 
 namespace plaidml::core {
 
-PlatformHolder::PlatformHolder() : platform(new LocalPlatform) {}
+// PLAIDML_REMOTE=host:port runs programs on a plaidml_worker instead of this host's devices.
+PlatformHolder::PlatformHolder() {
+  auto remote = vertexai::env::Get("PLAIDML_REMOTE");
+  if (remote.empty()) {
+    platform = std::make_unique<LocalPlatform>();
+  } else {
+    platform = RemotePlatform::Connect(remote);
+  }
+}
 
 PlatformHolder& GetPlatform() {
   static PlatformHolder holder;
@@ -60,9 +74,10 @@ void plaidml_init(plaidml_error* err) {
       if (level_str.size()) {
         auto level = std::atoi(level_str.c_str());
         if (level) {
-          el::Loggers::setVerboseLevel(level);
+          vertexai::SetVerbosity(level);
         }
       }
+      vertexai::SyncVerbosity();
       IVLOG(1, "plaidml_init");
       Settings::Instance()->load();
       auto ctx = GlobalContext::getContext();
@@ -70,9 +85,22 @@ void plaidml_init(plaidml_error* err) {
       auto eventlog_str = vertexai::env::Get("PLAIDML_EVENTLOG_FILENAME");
       if (eventlog_str.size()) {
         IVLOG(1, "Logging events to " << eventlog_str);
-        vertexai::eventing::file::proto::EventLog e_config;
-        e_config.set_filename(eventlog_str);
-        auto eventlog = std::make_shared<vertexai::eventing::file::EventLog>(e_config);
+        std::shared_ptr<vertexai::context::EventLog> eventlog;
+        if (boost::algorithm::ends_with(eventlog_str, ".json")) {
+          // Write a Chrome trace, viewable in chrome://tracing or the Perfetto UI.
+          vertexai::eventing::file::proto::TraceEventLog e_config;
+          e_config.set_filename(eventlog_str);
+          eventlog = std::make_shared<vertexai::eventing::file::TraceEventLog>(e_config);
+        } else if (vertexai::env::Get("PLAIDML_EVENTLOG_BUFFERED").size()) {
+          // Buffer events per thread, so that tracing can be left on under load.
+          vertexai::eventing::file::proto::RingEventLog e_config;
+          e_config.set_filename(eventlog_str);
+          eventlog = std::make_shared<vertexai::eventing::file::RingEventLog>(e_config);
+        } else {
+          vertexai::eventing::file::proto::EventLog e_config;
+          e_config.set_filename(eventlog_str);
+          eventlog = std::make_shared<vertexai::eventing::file::EventLog>(e_config);
+        }
         ctx->set_eventlog(std::move(eventlog));
         ctx->set_is_logging_events(true);
         std::atexit([]() { GlobalContext::getContext()->set_eventlog(nullptr); });
@@ -141,6 +169,13 @@ void plaidml_settings_save(  //
   });
 }
 
+plaidml_string* plaidml_perf_counters_export(  //
+    plaidml_error* err) {
+  return ffi_wrap<plaidml_string*>(err, nullptr, [&]() -> plaidml_string* {  //
+    return new plaidml_string{vertexai::PerfCountersToPrometheusText()};
+  });
+}
+
 plaidml_string* plaidml_settings_get(  //
     plaidml_error* err,                //
     const char* key) {
@@ -327,12 +362,35 @@ plaidml_buffer* plaidml_buffer_alloc(  //
   });
 }
 
+plaidml_buffer* plaidml_buffer_wrap(  //
+    plaidml_error* err,               //
+    const char* device_id,            //
+    void* data,                       //
+    size_t size) {
+  return ffi_wrap<plaidml_buffer*>(err, nullptr, [&]() -> plaidml_buffer* {
+    auto ctx = GlobalContext::getContext();
+    auto buffer = GetPlatform()->WrapBuffer(*ctx, device_id, data, size);
+    if (!buffer) {
+      return nullptr;
+    }
+    return new plaidml_buffer{buffer};
+  });
+}
+
+bool plaidml_buffer_host_resident(  //
+    plaidml_error* err,             //
+    plaidml_buffer* buffer) {
+  return ffi_wrap<bool>(err, false, [&] {  //
+    return buffer->buffer->host_resident();
+  });
+}
+
 plaidml_view* plaidml_buffer_mmap_current(  //
     plaidml_error* err,                     //
     plaidml_buffer* buffer) {
   return ffi_wrap<plaidml_view*>(err, nullptr, [&] {  //
     auto ctx = GlobalContext::getContext();
-    return new plaidml_view{buffer->buffer->MapCurrent(*ctx).get()};
+    return new plaidml_view{buffer->buffer->MapCurrentSync(*ctx)};
   });
 }
 
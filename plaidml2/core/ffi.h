@@ -6,6 +6,7 @@
 #include <cstddef>
 #include <cstdint>
 #else
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 #endif  // __cplusplus
@@ -34,6 +35,8 @@ typedef struct plaidml_device plaidml_device;
 typedef struct plaidml_buffer plaidml_buffer;
 typedef struct plaidml_view plaidml_view;
 typedef struct plaidml_executable plaidml_executable;
+typedef struct plaidml_completion plaidml_completion;
+typedef struct plaidml_snapshot plaidml_snapshot;
 
 //
 // Builder
@@ -120,6 +123,11 @@ void plaidml_settings_load(  //
 void plaidml_settings_save(  //
     plaidml_error* err);
 
+// Returns the current value of every performance counter and histogram, in
+// the Prometheus text exposition format.
+plaidml_string* plaidml_perf_counters_export(  //
+    plaidml_error* err);
+
 //
 // Shape
 //
@@ -199,6 +207,22 @@ plaidml_buffer* plaidml_buffer_alloc(  //
     const char* device_id,             //
     size_t size);
 
+// Makes a buffer that aliases existing host memory, which must outlive the
+// buffer.  Returns NULL without setting an error if the device cannot use the
+// memory without copying it.
+plaidml_buffer* plaidml_buffer_wrap(  //
+    plaidml_error* err,               //
+    const char* device_id,            //
+    void* data,                       //
+    size_t size);
+
+// Returns true if the buffer's memory is host memory which is always current
+// (e.g. a buffer on the CPU device), so that views of it are direct pointers,
+// mapped without waiting or copying.
+bool plaidml_buffer_host_resident(  //
+    plaidml_error* err,             //
+    plaidml_buffer* buffer);
+
 plaidml_view* plaidml_buffer_mmap_current(  //
     plaidml_error* err,                     //
     plaidml_buffer* buffer);
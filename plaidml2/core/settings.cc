@@ -5,6 +5,7 @@
 #include <boost/filesystem.hpp>
 
 #include "base/util/env.h"
+#include "base/util/runtime_options.h"
 #include "plaidml2/core/internal.h"
 
 using plaidml::core::ffi_wrap;
@@ -43,7 +44,8 @@ fs::path settings_path() {
 }  // namespace
 
 Settings::Settings() {  //
-  settings_.emplace("PLAIDML_SETTINGS", settings_path().string());
+  std::lock_guard<std::mutex> lock{mu_};
+  publish(Map{{"PLAIDML_SETTINGS", settings_path().string()}});
 }
 
 Settings* Settings::Instance() {
@@ -51,8 +53,13 @@ Settings* Settings::Instance() {
   return &settings;
 }
 
+void Settings::publish(Map settings) {
+  snapshots_.emplace_back(new Map{std::move(settings)});
+  settings_.store(snapshots_.back().get(), std::memory_order_release);
+}
+
 const std::map<std::string, std::string>& Settings::all() const {  //
-  return settings_;
+  return *settings_.load(std::memory_order_acquire);
 }
 
 std::string Settings::get(const std::string& key) const {
@@ -60,16 +67,21 @@ std::string Settings::get(const std::string& key) const {
   if (env_var.size()) {
     return env_var;
   }
-  auto it = settings_.find(key);
-  if (it == settings_.end()) {
+  const auto& settings = all();
+  auto it = settings.find(key);
+  if (it == settings.end()) {
     return "";
   }
   return it->second;
 }
 
 void Settings::set(const std::string& key, const std::string& value) {
-  settings_[key] = value;
+  std::lock_guard<std::mutex> lock{mu_};
+  auto settings = all();
+  settings[key] = value;
   vertexai::env::Set(key, value);
+  publish(std::move(settings));
+  vertexai::RuntimeOptions::Reload();
 }
 
 void Settings::load() {
@@ -78,7 +90,7 @@ void Settings::load() {
     LOG(WARNING) << "No PlaidML settings found.";
     return;
   }
-  settings_.clear();
+  Map settings;
   fs::ifstream file(settings_path);
   for (std::string line; std::getline(file, line);) {
     auto pos = line.find('=');
@@ -90,16 +102,21 @@ void Settings::load() {
       if (env_var.size()) {
         value = env_var;
       }
-      set(key, value);
+      settings[key] = value;
+      vertexai::env::Set(key, value);
     }
   }
-  settings_["PLAIDML_SETTINGS"] = settings_path.string();
+  settings["PLAIDML_SETTINGS"] = settings_path.string();
+  std::lock_guard<std::mutex> lock{mu_};
+  publish(std::move(settings));
+  vertexai::RuntimeOptions::Reload();
 }
 
 void Settings::save() {
   fs::path settings_path{get("PLAIDML_SETTINGS")};
+  std::lock_guard<std::mutex> lock{mu_};
   fs::ofstream file(settings_path);
-  for (const auto& kvp : settings_) {
+  for (const auto& kvp : all()) {
     if (kvp.first != "PLAIDML_SETTINGS") {
       file << kvp.first << "=" << kvp.second << std::endl;
     }
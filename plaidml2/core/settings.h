@@ -2,13 +2,20 @@
 
 #pragma once
 
+#include <atomic>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include "plaidml2/core/ffi.h"
 
 namespace plaidml::core {
 
+// Settings are published as immutable snapshots, so that get() and all() are
+// lock-free; set(), load() and save() serialize with each other.  Since changing
+// a setting also changes the environment, they reload the RuntimeOptions.
 class Settings {
  public:
   static Settings* Instance();
@@ -21,10 +28,18 @@ class Settings {
   void save();
 
  private:
+  using Map = std::map<std::string, std::string>;
+
   Settings();
 
+  // Publishes a new snapshot; the caller must hold mu_.
+  void publish(Map settings);
+
  private:
-  std::map<std::string, std::string> settings_;
+  std::mutex mu_;
+  std::atomic<const Map*> settings_{nullptr};
+  // Every snapshot is retained, since readers may still be holding the older ones.
+  std::vector<std::unique_ptr<const Map>> snapshots_;
 };
 
 }  // namespace plaidml::core
@@ -618,6 +618,79 @@ class Program(ForeignObject):
         return [x for x in self.args if not x.is_input]
 
 
+class GraphBuilder(object):
+    """Records constants, casts and calls, then builds them with a single FFI call.
+
+    Each method returns a handle for use as an operand of later calls; build() turns the
+    requested handles into Tensors.  Intermediate expressions never get a handle of their own.
+    """
+
+    def __init__(self):
+        self._inputs = []
+        self._ops = []
+        self._keepalive = []
+
+    class _Handle(object):
+        """An expression recorded by a GraphBuilder."""
+
+        def __init__(self, idx):
+            self.idx = idx
+
+    def _add(self, kind, args=(), int_value=0, float_value=0.0, fn=None):
+        raw_args = ffi.new('size_t[]', list(args))
+        self._keepalive.append(raw_args)
+        op = {
+            'kind': kind,
+            'int_value': int_value,
+            'float_value': float_value,
+            'fn': ffi.NULL,
+            'nargs': len(args),
+            'args': raw_args,
+        }
+        if fn is not None:
+            op['fn'] = ffi.new('char[]', fn.encode())
+            self._keepalive.append(op['fn'])
+        self._ops.append(op)
+        return len(self._ops) - 1
+
+    def _operand(self, x):
+        if isinstance(x, GraphBuilder._Handle):
+            return x.idx
+        x = wrap_tensor(x)
+        self._inputs.append(x)
+        return self._add(lib.PLAIDML_EXPR_OP_INPUT, [len(self._inputs) - 1])
+
+    def int(self, value):
+        return GraphBuilder._Handle(self._add(lib.PLAIDML_EXPR_OP_INT, int_value=value))
+
+    def float(self, value):
+        return GraphBuilder._Handle(self._add(lib.PLAIDML_EXPR_OP_FLOAT, float_value=value))
+
+    def cast(self, x, dtype):
+        idx = self._operand(x)
+        return GraphBuilder._Handle(self._add(lib.PLAIDML_EXPR_OP_CAST, [idx], int_value=dtype))
+
+    def call(self, fn, *args):
+        idxs = [self._operand(x) for x in args]
+        return GraphBuilder._Handle(self._add(lib.PLAIDML_EXPR_OP_CALL, idxs, fn=fn))
+
+    def build(self, *outputs):
+        raw_inputs = [x.as_ptr() for x in self._inputs]
+        raw_ops = ffi.new('plaidml_expr_op[]', self._ops)
+        raw_results = ffi.new('plaidml_expr*[]', len(outputs))
+        ffi_call(
+            lib.plaidml_expr_build,
+            len(raw_inputs),
+            raw_inputs,
+            len(self._ops),
+            raw_ops,
+            len(outputs),
+            [x.idx for x in outputs],
+            raw_results,
+        )
+        return [Tensor(expr=x) for x in raw_results]
+
+
 def wrap_tensor(x):
     if isinstance(x, six.integer_types):
         return Tensor(expr=ffi_call(lib.plaidml_expr_int, x))
@@ -709,16 +782,33 @@ def gather(x, y):
     return call('gather', x, y)
 
 
-def gradients(loss, variables):
+def gradients(loss, variables, checkpoints=None):
+    """Computes the gradients of loss with respect to variables.
+
+    If checkpoints is given, only those intermediate tensors are kept alive
+    for the backward pass and the rest are recomputed from them. An empty
+    list chooses the checkpoints automatically.
+    """
     wrts = [x.as_ptr() for x in variables]
     raw_grads = ffi.new('plaidml_expr*[]', len(wrts))
-    ffi_call(
-        lib.plaidml_expr_gradient,
-        len(wrts),
-        wrts,
-        loss.as_ptr(),
-        raw_grads,
-    )
+    if checkpoints is None:
+        ffi_call(
+            lib.plaidml_expr_gradient,
+            len(wrts),
+            wrts,
+            loss.as_ptr(),
+            raw_grads,
+        )
+    else:
+        ffi_call(
+            lib.plaidml_expr_gradient_checkpointed,
+            len(wrts),
+            wrts,
+            loss.as_ptr(),
+            len(checkpoints),
+            [x.as_ptr() for x in checkpoints],
+            raw_grads,
+        )
     return [Tensor(expr=x) for x in raw_grads]
 
 
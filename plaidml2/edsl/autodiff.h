@@ -31,6 +31,36 @@ inline std::vector<Tensor> Gradient(const std::vector<Tensor>& wrt, const Tensor
   return ret;
 }
 
+// Like Gradient, but only the `checkpoints` among the forward pass
+// intermediates are kept alive for the backward pass; the others are recomputed
+// from them, trading FLOPs for memory on deep networks. If no checkpoints are
+// given, they are chosen automatically.
+inline std::vector<Tensor> CheckpointedGradient(const std::vector<Tensor>& wrt, const Tensor& loss,
+                                                const std::vector<Tensor>& checkpoints = {}) {
+  std::vector<plaidml_expr*> wrt_exprs(wrt.size());
+  std::vector<plaidml_expr*> checkpoint_exprs(checkpoints.size());
+  std::vector<plaidml_expr*> deriv_exprs(wrt.size());
+  for (size_t i = 0; i < wrt.size(); ++i) {
+    wrt_exprs[i] = wrt[i].as_ptr();
+  }
+  for (size_t i = 0; i < checkpoints.size(); ++i) {
+    checkpoint_exprs[i] = checkpoints[i].as_ptr();
+  }
+  ffi::call_void(                          //
+      plaidml_expr_gradient_checkpointed,  //
+      wrt_exprs.size(),                    //
+      wrt_exprs.data(),                    //
+      loss.as_ptr(),                       //
+      checkpoint_exprs.size(),             //
+      checkpoint_exprs.data(),             //
+      deriv_exprs.data());
+  std::vector<Tensor> ret(wrt.size());
+  for (size_t i = 0; i < wrt.size(); ++i) {
+    ret[i] = Tensor(deriv_exprs[i]);
+  }
+  return ret;
+}
+
 inline std::vector<Tensor> Jacobian(const std::vector<Tensor>& wrt, const Tensor& loss) {
   std::vector<plaidml_expr*> wrt_exprs(wrt.size());
   std::vector<plaidml_expr*> deriv_exprs(wrt.size());
@@ -10,6 +10,7 @@
 #include "plaidml2/edsl/autodiff.h"
 #include "plaidml2/edsl/edsl.h"
 #include "plaidml2/exec/exec.h"
+#include "plaidml2/exec/serve.h"
 
 using ::testing::ContainerEq;
 using ::testing::Eq;
@@ -113,6 +114,172 @@ TEST(CppEdsl, BitOr) {
   }
 }
 
+TEST(CppEdsl, RunRebound) {
+  auto A = Placeholder(PLAIDML_DATA_UINT64, {3});
+  auto B = Placeholder(PLAIDML_DATA_UINT64, {3});
+  auto C = A | B;
+  Program program("run_rebound", {C});
+
+  std::vector<std::uint64_t> input_a{1, 2, 4};
+  std::vector<std::uint64_t> input_b{8, 16, 32};
+  std::vector<std::uint64_t> input_b2{64, 128, 256};
+
+  auto binder = exec::Binder(program);
+  auto executable = binder.compile();
+  binder.input(A).copy_from(input_a.data());
+  binder.input(B).copy_from(input_b.data());
+
+  auto device = Settings::get("PLAIDML_DEVICE");
+  TensorShape shape(PLAIDML_DATA_UINT64, {3});
+  Buffer other_b(device, shape);
+  Buffer other_c(device, shape);
+  other_b.copy_from(input_b2.data());
+  executable->run_async({{B, other_b}}, {{C, other_c}}).wait();
+  executable->run();
+
+  auto read = [](Buffer buffer) {
+    auto view = buffer.mmap_current();
+    auto data = reinterpret_cast<std::uint64_t*>(view.data());
+    return std::vector<std::uint64_t>(data, data + 3);
+  };
+  EXPECT_THAT(read(other_c), ContainerEq(std::vector<std::uint64_t>{65, 130, 260}));
+  EXPECT_THAT(read(binder.output(C)), ContainerEq(std::vector<std::uint64_t>{9, 18, 36}));
+
+  Buffer wrong_size(device, TensorShape(PLAIDML_DATA_UINT64, {4}));
+  EXPECT_THROW(executable->run({{A, wrong_size}}, {}), std::runtime_error);
+}
+
+TEST(CppEdsl, ExecutableStats) {
+  auto A = Placeholder(PLAIDML_DATA_UINT64, {3});
+  Program program("stats", {A + A});
+  auto executable = exec::Binder(program).compile();
+  executable->enable_stats();
+  executable->run();
+  executable->run();
+  auto stats = executable->stats();
+  // Devices without runtime statistics report no runs at all.
+  if (stats.runs) {
+    EXPECT_THAT(stats.runs, Eq(2));
+    EXPECT_THAT(stats.queue_wait_seconds, ::testing::Ge(0.0));
+    for (const auto& kernel : stats.kernels) {
+      EXPECT_THAT(kernel.recent_seconds.size(), Eq(kernel.runs));
+    }
+  }
+}
+
+TEST(CppEdsl, SubmitChain) {
+  auto A = Placeholder(PLAIDML_DATA_UINT64, {3});
+  auto B = A + A;
+  Program first("submit_first", {B});
+  auto C = Placeholder(PLAIDML_DATA_UINT64, {3});
+  auto D = C + C;
+  Program second("submit_second", {D});
+
+  auto device = Settings::get("PLAIDML_DEVICE");
+  TensorShape shape(PLAIDML_DATA_UINT64, {3});
+  Buffer intermediate(device, shape);
+  auto first_binder = exec::Binder(first);
+  first_binder.set_output(B, intermediate);
+  auto second_binder = exec::Binder(second);
+  second_binder.set_input(C, intermediate);
+  auto first_exec = first_binder.compile();
+  auto second_exec = second_binder.compile();
+
+  std::vector<std::uint64_t> input{1, 2, 3};
+  first_binder.input(A).copy_from(input.data());
+  exec::submit({first_exec, second_exec}).wait();
+  {
+    auto view = second_binder.output(D).mmap_current();
+    auto data = reinterpret_cast<std::uint64_t*>(view.data());
+    std::vector<std::uint64_t> actual(data, data + 3);
+    EXPECT_THAT(actual, ContainerEq(std::vector<std::uint64_t>{4, 8, 12}));
+  }
+}
+
+TEST(CppEdsl, SaveLoad) {
+  auto A = Placeholder(PLAIDML_DATA_UINT64, {3});
+  auto B = Placeholder(PLAIDML_DATA_UINT64, {3});
+  auto C = A | B;
+  Program program("save_load", {C});
+
+  std::vector<std::uint64_t> input_a{1, 2, 4};
+  std::vector<std::uint64_t> input_b{8, 16, 32};
+  auto binder = exec::Binder(program);
+  auto path = ::testing::TempDir() + "save_load.plaidml";
+  binder.compile()->save(path);
+
+  auto device = Settings::get("PLAIDML_DEVICE");
+  TensorShape shape(PLAIDML_DATA_UINT64, {3});
+  Buffer a(device, shape);
+  Buffer b(device, shape);
+  Buffer c(device, shape);
+  a.copy_from(input_a.data());
+  b.copy_from(input_b.data());
+  exec::Executable::load(path, device, {a, b}, {c})->run();
+  {
+    auto view = c.mmap_current();
+    auto data = reinterpret_cast<std::uint64_t*>(view.data());
+    std::vector<std::uint64_t> actual(data, data + 3);
+    EXPECT_THAT(actual, ContainerEq(std::vector<std::uint64_t>{9, 18, 36}));
+  }
+  EXPECT_THROW(exec::Executable::load(path, device, {a}, {c}), std::runtime_error);
+}
+
+TEST(CppEdsl, BatchedExecutable) {
+  int64_t compiles = 0;
+  exec::BatchedExecutable executable(
+      [&](int64_t batch_size) {
+        compiles++;
+        auto A = Placeholder(PLAIDML_DATA_UINT64, {batch_size, 2});
+        return Program("batched", {A + A});
+      },
+      {4, 1, 2});
+  EXPECT_THAT(executable.buckets(), ContainerEq(std::vector<int64_t>{1, 2, 4}));
+  EXPECT_THAT(executable.bucket_for(3), Eq(4));
+  EXPECT_THROW(executable.bucket_for(5), std::runtime_error);
+
+  std::vector<std::uint64_t> input{1, 2, 3, 4, 5, 6, 7, 8};
+  std::vector<std::uint64_t> output(8);
+  executable.run(3, {input.data()}, {output.data()});
+  EXPECT_THAT(output, ContainerEq(std::vector<std::uint64_t>{2, 4, 6, 8, 10, 12, 0, 0}));
+  executable.run(4, {input.data()}, {output.data()});
+  EXPECT_THAT(output, ContainerEq(std::vector<std::uint64_t>{2, 4, 6, 8, 10, 12, 14, 16}));
+  executable.run(1, {input.data()}, {output.data()});
+  EXPECT_THAT(compiles, Eq(2));  // The batch of 3 and 4 share a bucket.
+}
+
+TEST(CppEdsl, BatchQueue) {
+  serve::BatchQueueOptions options;
+  options.max_batch_size = 4;
+  options.max_delay = std::chrono::milliseconds(50);
+  serve::BatchQueue queue(
+      [](int64_t batch_size) {
+        auto A = Placeholder(PLAIDML_DATA_UINT64, {batch_size, 2});
+        return Program("served", {A + A});
+      },
+      {1, 2, 4}, options);
+
+  std::vector<std::future<serve::BatchQueue::Sample>> responses;
+  for (std::uint64_t i = 0; i < 6; i++) {
+    std::uint64_t row[] = {i, 10 * i};
+    std::vector<char> bytes(sizeof(row));
+    memcpy(bytes.data(), row, sizeof(row));
+    responses.push_back(queue.submit({bytes}));
+  }
+  for (std::uint64_t i = 0; i < 6; i++) {
+    auto response = responses[i].get();
+    ASSERT_THAT(response.size(), Eq(1));
+    std::vector<std::uint64_t> row(2);
+    memcpy(row.data(), response[0].data(), response[0].size());
+    EXPECT_THAT(row, ContainerEq(std::vector<std::uint64_t>{2 * i, 20 * i}));
+  }
+  // A full batch of four, then the remaining two once their delay expires.
+  auto stats = queue.stats();
+  EXPECT_THAT(stats.requests, Eq(6));
+  EXPECT_THAT(stats.batches, Eq(2));
+  EXPECT_THROW(queue.submit({std::vector<char>(3)}), std::runtime_error);
+}
+
 TEST(CppEdsl, BitLeft) {
   auto A = Placeholder(PLAIDML_DATA_UINT64, {3, 3});
   auto B = Placeholder(PLAIDML_DATA_UINT64, {3, 3});
@@ -1246,6 +1413,63 @@ TEST(CppEdsl, GradientDotSqrt) {
 }
 #endif
 
+#ifdef PLAIDML_AST
+TEST(CppEdsl, GatherRows) {
+  auto E = Placeholder(PLAIDML_DATA_FLOAT32, {1000, 64}, "E");
+  auto I = Placeholder(PLAIDML_DATA_INT32, {32}, "I");
+  auto O = gather(E, I);
+  EXPECT_THAT(O.shape().int_dims(), Eq(std::vector<int64_t>{32, 64}));
+  Program program("gather_rows", {O});
+  exec::Binder(program).compile()->run();
+}
+#endif
+
+#ifdef PLAIDML_AST
+TEST(CppEdsl, DuplicateContractions) {
+  auto A = Placeholder(PLAIDML_DATA_FLOAT32, {100, 100}, "A");
+  auto B = Placeholder(PLAIDML_DATA_FLOAT32, {100, 100}, "B");
+  auto O = Dot(A, B) + Dot(A, B);
+  Program program("duplicate_contractions", {O});
+  EXPECT_THAT(program, Eq(R"(function (
+  A[A_0, A_1],
+  B[B_0, B_1]
+) -> (
+  _X1
+) {
+  _X0[i, j : 100, 100] = +(A[i, k] * B[k, j]);
+  _X1 = add(_X0, _X0);
+}
+)"));
+  exec::Binder(program).compile()->run();
+}
+#endif
+
+#ifdef PLAIDML_AST
+TEST(CppEdsl, GradientCheckpointed) {
+  auto A = Placeholder(PLAIDML_DATA_FLOAT32, {100, 100}, "A");
+  auto B = Placeholder(PLAIDML_DATA_FLOAT32, {100, 100}, "B");
+  auto C = Dot(A, B);
+  auto O = sqrt(C);
+  auto grads = CheckpointedGradient({A, B}, O, {A, B});
+  Program program("gradient_checkpointed", {grads});
+  // Nothing but the inputs is kept, so the backward pass recomputes C
+  auto str = program.str();
+  llvm::StringRef ref(str);
+  EXPECT_THAT(ref.count("= +(A[i, k] * B[k, j]);"), Eq(2u));
+  exec::Binder(program).compile()->run();
+}
+#endif
+
+#ifdef PLAIDML_MLIR
+TEST(CppEdsl, GradientCheckpointed) {
+  auto A = Placeholder(PLAIDML_DATA_FLOAT32, {100, 100}, "A");
+  auto B = Placeholder(PLAIDML_DATA_FLOAT32, {100, 100}, "B");
+  auto O = sqrt(Dot(A, B));
+  // Recomputation isn't implemented here, so the request fails rather than silently keeping everything alive.
+  EXPECT_THROW(CheckpointedGradient({A, B}, O, {A, B}), std::runtime_error);
+}
+#endif
+
 TEST(CppEdsl, DefractLong) {
   if (vertexai::env::Get("PLAIDML_EE") == "1") {
     FAIL() << "Assertion failed: (map.getNumInputs() == mapOperands.size() && \"inconsistent index info\")";
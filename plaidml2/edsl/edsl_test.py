@@ -1375,6 +1375,21 @@ function (
         self.assertEqual(outputs[0].tolist(), [1, 2, 3])
         self.assertEqual(outputs[1].tolist(), [1, 2, 3])
 
+    def test_graph_builder(self):
+        I = Tensor(LogicalShape(plaidml.DType.FLOAT32, [3]), name='I')
+        O1 = call('add', cast(call('mul', I, 2.0), plaidml.DType.INT32), 1)
+
+        builder = GraphBuilder()
+        X = builder.call('mul', I, builder.float(2.0))
+        O2, = builder.build(builder.call('add', builder.cast(X, plaidml.DType.INT32), builder.int(1)))
+
+        program1 = Program('graph_builder', [O1])
+        program2 = Program('graph_builder', [O2])
+        self.assertMultiLineEqual(str(program1), str(program2))
+
+        outputs = plaidml_exec.run(program2, [(I, np.array([1, 2, 3], dtype=np.float32))])
+        self.assertEqual(outputs[0].tolist(), [3, 5, 7])
+
 
 if __name__ == '__main__':
     parser = argparse.ArgumentParser()
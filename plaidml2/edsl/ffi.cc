@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -150,6 +151,83 @@ mlir::Value MakeAffineOp(plaidml_int_op op, const std::vector<mlir::Value> opera
 }
 #endif
 
+
+plaidml_expr MakeIntExpr(int64_t value) {
+#ifdef PLAIDML_AST
+  return plaidml_expr{std::make_shared<IntConst>(value)};
+#endif
+#ifdef PLAIDML_MLIR
+  return plaidml_expr{GlobalContext::get()->MakeScalarConstantOp(value)};
+#endif
+}
+
+plaidml_expr MakeFloatExpr(double value) {
+#ifdef PLAIDML_AST
+  return plaidml_expr{std::make_shared<FloatConst>(value)};
+#endif
+#ifdef PLAIDML_MLIR
+  return plaidml_expr{GlobalContext::get()->MakeScalarConstantOp(value)};
+#endif
+}
+
+plaidml_expr MakeCastExpr(const plaidml_expr& tensor, plaidml_datatype dtype) {
+#ifdef PLAIDML_AST
+  static ExprPtr bits8 = std::make_shared<IntConst>(8);
+  static ExprPtr bits16 = std::make_shared<IntConst>(16);
+  static ExprPtr bits32 = std::make_shared<IntConst>(32);
+  static ExprPtr bits64 = std::make_shared<IntConst>(64);
+  switch (static_cast<DataType>(dtype)) {
+    case DataType::INT8:
+      return plaidml_expr{MakeCall("as_int", {tensor.expr, bits8})};
+    case DataType::INT16:
+      return plaidml_expr{MakeCall("as_int", {tensor.expr, bits16})};
+    case DataType::INT32:
+      return plaidml_expr{MakeCall("as_int", {tensor.expr, bits32})};
+    case DataType::INT64:
+      return plaidml_expr{MakeCall("as_int", {tensor.expr, bits64})};
+    case DataType::UINT8:
+      return plaidml_expr{MakeCall("as_uint", {tensor.expr, bits8})};
+    case DataType::UINT16:
+      return plaidml_expr{MakeCall("as_uint", {tensor.expr, bits16})};
+    case DataType::UINT32:
+      return plaidml_expr{MakeCall("as_uint", {tensor.expr, bits32})};
+    case DataType::UINT64:
+      return plaidml_expr{MakeCall("as_uint", {tensor.expr, bits64})};
+    case DataType::FLOAT16:
+      return plaidml_expr{MakeCall("as_float", {tensor.expr, bits16})};
+    case DataType::FLOAT32:
+      return plaidml_expr{MakeCall("as_float", {tensor.expr, bits32})};
+    case DataType::FLOAT64:
+      return plaidml_expr{MakeCall("as_float", {tensor.expr, bits64})};
+    default:
+      throw std::runtime_error("Unsupported dtype for cast");
+  }
+#endif
+#ifdef PLAIDML_MLIR
+  return plaidml_expr{GlobalContext::get()->MakeCastOp(tensor.value, static_cast<DataType>(dtype))};
+#endif
+}
+
+plaidml_expr MakeCallExpr(const char* fn, const std::vector<const plaidml_expr*>& args) {
+#ifdef PLAIDML_AST
+  std::vector<ExprPtr> exprs(args.size());
+  for (size_t i = 0; i < args.size(); i++) {
+    if (!args[i]) {
+      throw std::runtime_error(str(boost::format("Undefined tensor in call to %1%()") % fn));
+    }
+    exprs[i] = args[i]->expr;
+  }
+  return plaidml_expr{MakeCall(fn, exprs)};
+#endif
+#ifdef PLAIDML_MLIR
+  std::vector<mlir::Value> values(args.size());
+  for (size_t i = 0; i < args.size(); i++) {
+    values[i] = args[i]->value;
+  }
+  return plaidml_expr{GlobalContext::get()->MakePrimitiveOp(fn, values)};
+#endif
+}
+
 }  // namespace
 
 extern "C" {
@@ -550,12 +628,7 @@ plaidml_expr* plaidml_expr_int(  //
     int64_t value) {
   return ffi_wrap<plaidml_expr*>(err, nullptr, [&] {
     IVLOG(3, "plaidml_expr_int> " << value);
-#ifdef PLAIDML_AST
-    return new plaidml_expr{std::make_shared<IntConst>(value)};
-#endif
-#ifdef PLAIDML_MLIR
-    return new plaidml_expr{GlobalContext::get()->MakeScalarConstantOp(value)};
-#endif
+    return new plaidml_expr{MakeIntExpr(value)};
   });
 }
 
@@ -564,12 +637,7 @@ plaidml_expr* plaidml_expr_float(  //
     double value) {
   return ffi_wrap<plaidml_expr*>(err, nullptr, [&] {
     IVLOG(3, "plaidml_expr_float");
-#ifdef PLAIDML_AST
-    return new plaidml_expr{std::make_shared<FloatConst>(value)};
-#endif
-#ifdef PLAIDML_MLIR
-    return new plaidml_expr{GlobalContext::get()->MakeScalarConstantOp(value)};
-#endif
+    return new plaidml_expr{MakeFloatExpr(value)};
   });
 }
 
@@ -579,41 +647,7 @@ plaidml_expr* plaidml_expr_cast(  //
     plaidml_datatype dtype) {
   return ffi_wrap<plaidml_expr*>(err, nullptr, [&] {
     IVLOG(3, "plaidml_expr_cast");
-#ifdef PLAIDML_AST
-    static ExprPtr bits8 = std::make_shared<IntConst>(8);
-    static ExprPtr bits16 = std::make_shared<IntConst>(16);
-    static ExprPtr bits32 = std::make_shared<IntConst>(32);
-    static ExprPtr bits64 = std::make_shared<IntConst>(64);
-    switch (static_cast<DataType>(dtype)) {
-      case DataType::INT8:
-        return new plaidml_expr{MakeCall("as_int", {tensor->expr, bits8})};
-      case DataType::INT16:
-        return new plaidml_expr{MakeCall("as_int", {tensor->expr, bits16})};
-      case DataType::INT32:
-        return new plaidml_expr{MakeCall("as_int", {tensor->expr, bits32})};
-      case DataType::INT64:
-        return new plaidml_expr{MakeCall("as_int", {tensor->expr, bits64})};
-      case DataType::UINT8:
-        return new plaidml_expr{MakeCall("as_uint", {tensor->expr, bits8})};
-      case DataType::UINT16:
-        return new plaidml_expr{MakeCall("as_uint", {tensor->expr, bits16})};
-      case DataType::UINT32:
-        return new plaidml_expr{MakeCall("as_uint", {tensor->expr, bits32})};
-      case DataType::UINT64:
-        return new plaidml_expr{MakeCall("as_uint", {tensor->expr, bits64})};
-      case DataType::FLOAT16:
-        return new plaidml_expr{MakeCall("as_float", {tensor->expr, bits16})};
-      case DataType::FLOAT32:
-        return new plaidml_expr{MakeCall("as_float", {tensor->expr, bits32})};
-      case DataType::FLOAT64:
-        return new plaidml_expr{MakeCall("as_float", {tensor->expr, bits64})};
-      default:
-        throw std::runtime_error("Unsupported dtype for cast");
-    }
-#endif
-#ifdef PLAIDML_MLIR
-    return new plaidml_expr{GlobalContext::get()->MakeCastOp(tensor->value, static_cast<DataType>(dtype))};
-#endif
+    return new plaidml_expr{MakeCastExpr(*tensor, dtype)};
   });
 }
 
@@ -624,23 +658,73 @@ plaidml_expr* plaidml_expr_call(  //
     plaidml_expr** args) {
   return ffi_wrap<plaidml_expr*>(err, nullptr, [&] {
     IVLOG(3, "plaidml_expr_call");
-#ifdef PLAIDML_AST
-    std::vector<ExprPtr> exprs(nargs);
-    for (size_t i = 0; i < nargs; i++) {
-      if (!args[i]) {
-        throw std::runtime_error(str(boost::format("Undefined tensor in call to %1%()") % fn));
+    std::vector<const plaidml_expr*> exprs(args, args + nargs);
+    return new plaidml_expr{MakeCallExpr(fn, exprs)};
+  });
+}
+
+void plaidml_expr_build(         //
+    plaidml_error* err,          //
+    size_t ninputs,              //
+    plaidml_expr** inputs,       //
+    size_t nops,                 //
+    const plaidml_expr_op* ops,  //
+    size_t noutputs,             //
+    const size_t* outputs,       //
+    plaidml_expr** results) {
+  ffi_wrap_void(err, [&] {
+    IVLOG(3, "plaidml_expr_build> nops: " << nops << ", noutputs: " << noutputs);
+    // The intermediate expressions live only in this vector; handles are allocated for the outputs alone.
+    std::vector<plaidml_expr> exprs;
+    exprs.reserve(nops);
+    auto operand = [&](size_t op_idx, size_t arg) -> const plaidml_expr* {
+      if (arg >= op_idx) {
+        throw std::runtime_error(
+            str(boost::format("plaidml_expr_build: op %1% refers to a later op %2%") % op_idx % arg));
+      }
+      return &exprs[arg];
+    };
+    for (size_t i = 0; i < nops; i++) {
+      const auto& op = ops[i];
+      switch (op.kind) {
+        case PLAIDML_EXPR_OP_INPUT:
+          if (op.nargs != 1 || op.args[0] >= ninputs || !inputs[op.args[0]]) {
+            throw std::runtime_error(str(boost::format("plaidml_expr_build: op %1% refers to an invalid input") % i));
+          }
+          exprs.push_back(*inputs[op.args[0]]);
+          break;
+        case PLAIDML_EXPR_OP_INT:
+          exprs.push_back(MakeIntExpr(op.int_value));
+          break;
+        case PLAIDML_EXPR_OP_FLOAT:
+          exprs.push_back(MakeFloatExpr(op.float_value));
+          break;
+        case PLAIDML_EXPR_OP_CAST:
+          if (op.nargs != 1) {
+            throw std::runtime_error(str(boost::format("plaidml_expr_build: cast op %1% requires one operand") % i));
+          }
+          exprs.push_back(MakeCastExpr(*operand(i, op.args[0]), static_cast<plaidml_datatype>(op.int_value)));
+          break;
+        case PLAIDML_EXPR_OP_CALL: {
+          std::vector<const plaidml_expr*> args(op.nargs);
+          for (size_t j = 0; j < op.nargs; j++) {
+            args[j] = operand(i, op.args[j]);
+          }
+          exprs.push_back(MakeCallExpr(op.fn, args));
+          break;
+        }
+        default:
+          throw std::runtime_error(str(boost::format("plaidml_expr_build: op %1% has an invalid kind") % i));
       }
-      exprs[i] = args[i]->expr;
     }
-    return new plaidml_expr{MakeCall(fn, exprs)};
-#endif
-#ifdef PLAIDML_MLIR
-    std::vector<mlir::Value> values(nargs);
-    for (size_t i = 0; i < nargs; i++) {
-      values[i] = args[i]->value;
+    for (size_t i = 0; i < noutputs; i++) {
+      if (outputs[i] >= nops) {
+        throw std::runtime_error(str(boost::format("plaidml_expr_build: output %1% refers to an invalid op") % i));
+      }
+    }
+    for (size_t i = 0; i < noutputs; i++) {
+      results[i] = new plaidml_expr{exprs[outputs[i]]};
     }
-    return new plaidml_expr{GlobalContext::get()->MakePrimitiveOp(fn, values)};
-#endif
   });
 }
 
@@ -909,6 +993,36 @@ void plaidml_expr_gradient(  //
   });
 }
 
+void plaidml_expr_gradient_checkpointed(  //
+    plaidml_error* err,                   //
+    size_t nwrts,                         //
+    plaidml_expr** wrts,                  //
+    plaidml_expr* loss,                   //
+    size_t ncheckpoints,                  //
+    plaidml_expr** checkpoints,           //
+    plaidml_expr** derivs) {
+  ffi_wrap_void(err, [&] {
+    IVLOG(3, "plaidml_expr_gradient_checkpointed");
+#ifdef PLAIDML_AST
+    std::vector<ExprPtr> wrt_exprs(nwrts);
+    for (size_t i = 0; i < nwrts; i++) {
+      wrt_exprs[i] = wrts[i]->expr;
+    }
+    std::vector<ExprPtr> checkpoint_exprs(ncheckpoints);
+    for (size_t i = 0; i < ncheckpoints; i++) {
+      checkpoint_exprs[i] = checkpoints[i]->expr;
+    }
+    auto deriv_exprs = ComputeGradients(wrt_exprs, loss->expr, &checkpoint_exprs);
+    for (size_t i = 0; i < nwrts; i++) {
+      derivs[i] = new plaidml_expr{deriv_exprs[i]};
+    }
+#endif
+#ifdef PLAIDML_MLIR
+    throw std::runtime_error("Gradient checkpointing not implemented for MLIR");
+#endif
+  });
+}
+
 void plaidml_expr_jacobian(  //
     plaidml_error* err,      //
     size_t nwrts,            //
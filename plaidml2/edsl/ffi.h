@@ -141,6 +141,19 @@ void plaidml_expr_gradient(  //
     plaidml_expr* loss,      //
     plaidml_expr** derivs);
 
+// Like plaidml_expr_gradient, but the backward pass keeps only the
+// `ncheckpoints` forward pass intermediates in `checkpoints` alive and
+// recomputes the rest from them. If `ncheckpoints` is 0, the checkpoints are
+// chosen automatically. Not yet supported under MLIR, where it fails.
+void plaidml_expr_gradient_checkpointed(  //
+    plaidml_error* err,                   //
+    size_t nwrts,                         //
+    plaidml_expr** wrts,                  //
+    plaidml_expr* loss,                   //
+    size_t ncheckpoints,                  //
+    plaidml_expr** checkpoints,           //
+    plaidml_expr** derivs);
+
 void plaidml_expr_jacobian(  //
     plaidml_error* err,      //
     size_t nwrts,            //
@@ -235,6 +248,39 @@ plaidml_expr* plaidml_expr_cast(  //
     plaidml_expr* tensor,         //
     plaidml_datatype dtype);
 
+typedef enum {
+  PLAIDML_EXPR_OP_INPUT,
+  PLAIDML_EXPR_OP_INT,
+  PLAIDML_EXPR_OP_FLOAT,
+  PLAIDML_EXPR_OP_CAST,
+  PLAIDML_EXPR_OP_CALL,
+} plaidml_expr_op_kind;
+
+// One step of a plaidml_expr_build graph.  Operands in args are indices of earlier ops, except for
+// PLAIDML_EXPR_OP_INPUT, whose single arg is an index into the inputs.  PLAIDML_EXPR_OP_CAST takes its target
+// plaidml_datatype from int_value.
+typedef struct plaidml_expr_op {
+  plaidml_expr_op_kind kind;
+  int64_t int_value;
+  double float_value;
+  const char* fn;
+  size_t nargs;
+  const size_t* args;
+} plaidml_expr_op;
+
+// Builds a graph of constants, casts and calls in a single call, storing a new expression in results[i] for the op
+// named by outputs[i].  Equivalent to the corresponding sequence of plaidml_expr_{int,float,cast,call} calls, but
+// without a round trip or a heap-allocated handle per intermediate expression.
+void plaidml_expr_build(         //
+    plaidml_error* err,          //
+    size_t ninputs,              //
+    plaidml_expr** inputs,       //
+    size_t nops,                 //
+    const plaidml_expr_op* ops,  //
+    size_t noutputs,             //
+    const size_t* outputs,       //
+    plaidml_expr** results);
+
 plaidml_expr* plaidml_expr_index_map(  //
     plaidml_error* err,                //
     plaidml_expr* ref,                 //
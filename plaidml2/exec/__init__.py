@@ -1,13 +1,15 @@
 # Copyright 2019 Intel Corporation.
 
+import asyncio
 import logging
+import threading
 
 import numpy as np
 
 import plaidml2 as plaidml
 import plaidml2.edsl as edsl
 import plaidml2.settings as plaidml_settings
-from plaidml2.ffi import ForeignObject, decode_str, ffi, ffi_call, lib
+from plaidml2.ffi import Error, ForeignObject, decode_str, ffi, ffi_call, lib
 
 logger = logging.getLogger(__name__)
 
@@ -35,6 +37,92 @@ def list_targets():
         ffi_call(lib.plaidml_strings_free, strs)
 
 
+def _wrap_bindings(bindings):
+    return [ffi.new('plaidml_binding*', [x.as_ptr(), y.as_ptr()]) for x, y in bindings]
+
+
+# The handles of callbacks passed to plaidml_completion_notify, kept alive until they're invoked.
+_PENDING_CALLBACKS = set()
+_PENDING_LOCK = threading.Lock()
+
+
+@ffi.callback('plaidml_completion_callback')
+def _on_completion(user_ctx, err):
+    fn, handle = ffi.from_handle(user_ctx)
+    with _PENDING_LOCK:
+        _PENDING_CALLBACKS.discard(handle)
+    error = Error(err) if err.code else None
+    try:
+        fn(error)
+    except Exception:
+        logger.exception('Completion callback failed')
+
+
+class Completion(ForeignObject):
+    """The handle of a run in flight.  Completions are awaitable: within a
+    coroutine, `await executable.run_async()` suspends until the run has
+    finished, raising its error if it failed, without blocking the event loop
+    or holding a thread."""
+    __ffi_del__ = lib.plaidml_completion_free
+
+    def done(self):
+        return ffi_call(lib.plaidml_completion_is_done, self.as_ptr())
+
+    def wait(self):
+        ffi_call(lib.plaidml_completion_wait, self.as_ptr())
+
+    def _notify(self, fn):
+        # fn(error) is called once the run has finished, with None on success:
+        # on the calling thread if it already has, otherwise on a thread owned
+        # by the completion.  fn must not hold the last reference to self.
+        state = [fn, None]
+        state[1] = ffi.new_handle(state)
+        with _PENDING_LOCK:
+            _PENDING_CALLBACKS.add(state[1])
+        ffi_call(lib.plaidml_completion_notify, self.as_ptr(), _on_completion, state[1])
+
+    def add_done_callback(self, fn):
+        """Calls fn(self) on a background thread once the run has finished."""
+
+        def waiter():
+            try:
+                self.wait()
+            except Exception:
+                logger.debug('Asynchronous run failed', exc_info=True)
+            fn(self)
+
+        thread = threading.Thread(target=waiter)
+        thread.daemon = True
+        thread.start()
+        return thread
+
+    def as_future(self, loop=None):
+        """Returns an asyncio future, bound to loop (by default, the current
+        event loop), which completes when the run does."""
+        if loop is None:
+            loop = asyncio.get_event_loop()
+        future = loop.create_future()
+        # Freeing a completion waits for its callbacks, so the completion is
+        # kept alive until the loop settles the future, and never released by
+        # the callback itself.
+        keepalive = [self]
+
+        def settle(error):
+            keepalive.clear()
+            if future.cancelled():
+                return
+            if error:
+                future.set_exception(error)
+            else:
+                future.set_result(None)
+
+        self._notify(lambda error: loop.call_soon_threadsafe(settle, error))
+        return future
+
+    def __await__(self):
+        return self.as_future().__await__()
+
+
 class Executable(ForeignObject):
     __ffi_del__ = lib.plaidml_executable_free
 
@@ -44,11 +132,8 @@ class Executable(ForeignObject):
         if target is None:
             target = plaidml_settings.get('PLAIDML_TARGET')
 
-        def wrap(x, y):
-            return ffi.new('plaidml_binding*', [x.as_ptr(), y.as_ptr()])
-
-        inputs = [wrap(x, y) for x, y in inputs]
-        outputs = [wrap(x, y) for x, y in outputs]
+        inputs = _wrap_bindings(inputs)
+        outputs = _wrap_bindings(outputs)
         ffi_obj = ffi_call(
             lib.plaidml_compile,
             program.as_ptr(),
@@ -61,8 +146,145 @@ class Executable(ForeignObject):
         )
         super(Executable, self).__init__(ffi_obj)
 
-    def run(self):
-        ffi_call(lib.plaidml_executable_run, self.as_ptr())
+    @staticmethod
+    def load(path, inputs=[], outputs=[], device=None):
+        """Loads an executable written by save; the buffers are bound in the
+        order of the program's inputs and outputs when it was compiled."""
+        if device is None:
+            device = plaidml_settings.get('PLAIDML_DEVICE')
+        inputs = [x.as_ptr() for x in inputs]
+        outputs = [x.as_ptr() for x in outputs]
+        ffi_obj = ffi_call(
+            lib.plaidml_executable_load,
+            path.encode(),
+            device.encode(),
+            len(inputs),
+            inputs,
+            len(outputs),
+            outputs,
+        )
+        executable = Executable.__new__(Executable)
+        ForeignObject.__init__(executable, ffi_obj)
+        return executable
+
+    def enable_stats(self, enable=True):
+        ffi_call(lib.plaidml_executable_enable_stats, self.as_ptr(), enable)
+
+    def set_memory_quota(self, nbytes):
+        """Limits the temporary device memory held by the executable's runs
+        in flight; zero removes the limit."""
+        ffi_call(lib.plaidml_executable_set_memory_quota, self.as_ptr(), nbytes)
+
+    def stats(self):
+        """Returns the statistics accumulated since the executable was created,
+        as a dict; per-kernel statistics require enable_stats()."""
+        raw = ffi_call(lib.plaidml_executable_get_stats, self.as_ptr())
+        try:
+            kernels = []
+            for i in range(raw.nkernels):
+                kernel = raw.kernels[i]
+                kernels.append({
+                    'name': ffi.string(lib.plaidml_string_ptr(kernel.name)).decode(),
+                    'runs': kernel.runs,
+                    'bytes': kernel.bytes,
+                    'flops': kernel.flops,
+                    'total_seconds': kernel.total_seconds,
+                    'recent_seconds': [kernel.samples[j] for j in range(kernel.nsamples)],
+                })
+            return {
+                'runs': raw.runs,
+                'queue_wait_seconds': raw.queue_wait_seconds,
+                'peak_memory_bytes': raw.peak_memory_bytes,
+                'kernels': kernels,
+            }
+        finally:
+            ffi_call(lib.plaidml_executable_stats_free, raw)
+
+    def save(self, path):
+        ffi_call(lib.plaidml_executable_save, self.as_ptr(), path.encode())
+
+    def run(self, inputs=None, outputs=None):
+        """Runs the program; inputs and outputs optionally rebind (tensor, buffer)
+        pairs to different, same-sized buffers for this run only."""
+        if inputs is None and outputs is None:
+            ffi_call(lib.plaidml_executable_run, self.as_ptr())
+            return
+        inputs = _wrap_bindings(inputs or [])
+        outputs = _wrap_bindings(outputs or [])
+        ffi_call(
+            lib.plaidml_executable_run_with,
+            self.as_ptr(),
+            len(inputs),
+            inputs,
+            len(outputs),
+            outputs,
+        )
+
+    def run_async(self, inputs=None, outputs=None):
+        if inputs is None and outputs is None:
+            return Completion(ffi_call(lib.plaidml_executable_run_async, self.as_ptr()))
+        inputs = _wrap_bindings(inputs or [])
+        outputs = _wrap_bindings(outputs or [])
+        return Completion(
+            ffi_call(
+                lib.plaidml_executable_run_async_with,
+                self.as_ptr(),
+                len(inputs),
+                inputs,
+                len(outputs),
+                outputs,
+            ))
+
+
+def submit(executables):
+    """Runs the executables as one chain, without waiting between them."""
+    execs = [x.as_ptr() for x in executables]
+    return Completion(ffi_call(lib.plaidml_executables_submit, len(execs), execs))
+
+
+class Snapshot(ForeignObject):
+    """A file holding several compiled executables, from which they can be
+    loaded without compiling."""
+    __ffi_del__ = lib.plaidml_snapshot_free
+
+    def __init__(self, path):
+        ffi_obj = ffi_call(lib.plaidml_snapshot_open, path.encode())
+        super(Snapshot, self).__init__(ffi_obj)
+
+    @staticmethod
+    def save(path, executables):
+        """Writes a dict of executables, keyed by name, to path."""
+        names = [ffi.new('char[]', name.encode()) for name in executables.keys()]
+        execs = [x.as_ptr() for x in executables.values()]
+        ffi_call(lib.plaidml_snapshot_save, path.encode(), len(execs), names, execs)
+
+    def names(self):
+        strs = ffi_call(lib.plaidml_snapshot_list, self.as_ptr())
+        try:
+            return [decode_str(strs[0].strs[i]) for i in range(strs.nstrs)]
+        finally:
+            ffi_call(lib.plaidml_strings_free, strs)
+
+    def executable(self, name, inputs=[], outputs=[], device=None):
+        """Loads the named executable, binding the buffers as Executable.load
+        does."""
+        if device is None:
+            device = plaidml_settings.get('PLAIDML_DEVICE')
+        inputs = [x.as_ptr() for x in inputs]
+        outputs = [x.as_ptr() for x in outputs]
+        ffi_obj = ffi_call(
+            lib.plaidml_snapshot_executable,
+            self.as_ptr(),
+            name.encode(),
+            device.encode(),
+            len(inputs),
+            inputs,
+            len(outputs),
+            outputs,
+        )
+        executable = Executable.__new__(Executable)
+        ForeignObject.__init__(executable, ffi_obj)
+        return executable
 
 
 class Binder:
@@ -2,8 +2,14 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <functional>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
@@ -23,7 +29,10 @@ namespace details {
 
 struct Deleter {
   void operator()(plaidml_executable* ptr) { ffi::call_void(plaidml_executable_free, ptr); }
+  void operator()(plaidml_completion* ptr) { ffi::call_void(plaidml_completion_free, ptr); }
+  void operator()(plaidml_executable_stats* ptr) { ffi::call_void(plaidml_executable_stats_free, ptr); }
   void operator()(plaidml_strings* ptr) { ffi::call_void(plaidml_strings_free, ptr); }
+  void operator()(plaidml_snapshot* ptr) { ffi::call_void(plaidml_snapshot_free, ptr); }
 };
 
 template <typename T>
@@ -56,6 +65,58 @@ inline std::vector<std::string> list_targets() {
   return ret;
 }
 
+struct KernelStats {
+  std::string name;
+  uint64_t runs;
+  uint64_t bytes;  // Accessed by a single run of the kernel
+  uint64_t flops;  // Performed by a single run of the kernel
+  double total_seconds;
+  std::vector<double> recent_seconds;  // Oldest first
+};
+
+struct ExecutableStats {
+  uint64_t runs;
+  double queue_wait_seconds;
+  uint64_t peak_memory_bytes;
+  std::vector<KernelStats> kernels;
+};
+
+// Tracks an executable run started by Executable::run_async.
+class Completion {
+ public:
+  using Callback = std::function<void(std::exception_ptr)>;
+
+  explicit Completion(plaidml_completion* ptr) : ptr_(details::make_ptr(ptr)) {}
+
+  bool is_done() const {  //
+    return ffi::call<bool>(plaidml_completion_is_done, ptr_.get());
+  }
+
+  // Blocks until the run has finished, throwing if it failed.
+  void wait() const {  //
+    ffi::call_void(plaidml_completion_wait, ptr_.get());
+  }
+
+  // Invokes fn once the run has finished, passing the run's failure, if any.
+  void on_done(Callback fn) const {
+    auto ctx = std::make_unique<Callback>(std::move(fn));
+    ffi::call_void(plaidml_completion_notify, ptr_.get(), &Completion::Notify, ctx.get());
+    ctx.release();
+  }
+
+ private:
+  static void Notify(void* user_ctx, plaidml_error* err) {
+    std::unique_ptr<Callback> fn{static_cast<Callback*>(user_ctx)};
+    std::exception_ptr ex;
+    if (err->code) {
+      ex = std::make_exception_ptr(std::runtime_error(ffi::str(err->msg)));
+    }
+    (*fn)(ex);
+  }
+
+  std::shared_ptr<plaidml_completion> ptr_;
+};
+
 class Executable {
  public:
   Executable(const edsl::Program& program,        //
@@ -74,20 +135,8 @@ class Executable {
              const std::string& target,           //
              const std::vector<Binding>& inputs,  //
              const std::vector<Binding>& outputs) {
-    std::vector<plaidml_binding> inputs_storage(inputs.size());
-    std::vector<plaidml_binding*> raw_inputs(inputs.size());
-    for (size_t i = 0; i < inputs.size(); i++) {
-      inputs_storage[i].expr = inputs[i].tensor.as_ptr();
-      inputs_storage[i].buffer = inputs[i].buffer.as_ptr();
-      raw_inputs[i] = &inputs_storage[i];
-    }
-    std::vector<plaidml_binding> outputs_storage(outputs.size());
-    std::vector<plaidml_binding*> raw_outputs(outputs.size());
-    for (size_t i = 0; i < raw_outputs.size(); i++) {
-      outputs_storage[i].expr = outputs[i].tensor.as_ptr();
-      outputs_storage[i].buffer = outputs[i].buffer.as_ptr();
-      raw_outputs[i] = &outputs_storage[i];
-    }
+    BindingStorage raw_inputs(inputs);
+    BindingStorage raw_outputs(outputs);
     ptr_ = details::make_ptr(            //
         ffi::call<plaidml_executable*>(  //
             plaidml_compile,             //
@@ -100,14 +149,189 @@ class Executable {
             raw_outputs.data()));
   }
 
+  // Loads an executable written by save; see plaidml_executable_load.
+  static std::shared_ptr<Executable> load(const std::string& path,             //
+                                          const std::string& device,           //
+                                          const std::vector<Buffer>& inputs,  //
+                                          const std::vector<Buffer>& outputs) {
+    std::vector<plaidml_buffer*> raw_inputs(inputs.size());
+    for (size_t i = 0; i < inputs.size(); i++) {
+      raw_inputs[i] = inputs[i].as_ptr();
+    }
+    std::vector<plaidml_buffer*> raw_outputs(outputs.size());
+    for (size_t i = 0; i < outputs.size(); i++) {
+      raw_outputs[i] = outputs[i].as_ptr();
+    }
+    auto ptr = ffi::call<plaidml_executable*>(  //
+        plaidml_executable_load,                //
+        path.c_str(),                           //
+        device.c_str(),                         //
+        raw_inputs.size(),                      //
+        raw_inputs.data(),                      //
+        raw_outputs.size(),                     //
+        raw_outputs.data());
+    return std::shared_ptr<Executable>(new Executable(details::make_ptr(ptr)));
+  }
+
+  // Enables per-kernel statistics; see plaidml_executable_enable_stats.
+  void enable_stats(bool enable = true) {  //
+    ffi::call_void(plaidml_executable_enable_stats, ptr_.get(), enable);
+  }
+
+  // Limits the temporary device memory held by runs in flight; see
+  // plaidml_executable_set_memory_quota.
+  void set_memory_quota(uint64_t bytes) {  //
+    ffi::call_void(plaidml_executable_set_memory_quota, ptr_.get(), bytes);
+  }
+
+  ExecutableStats stats() const {
+    auto raw = ffi::call<plaidml_executable_stats*>(plaidml_executable_get_stats, ptr_.get());
+    std::unique_ptr<plaidml_executable_stats, details::Deleter> holder{raw};
+    ExecutableStats ret{raw->runs, raw->queue_wait_seconds, raw->peak_memory_bytes, {}};
+    for (size_t i = 0; i < raw->nkernels; i++) {
+      const auto& kstats = raw->kernels[i];
+      std::vector<double> samples(kstats.samples, kstats.samples + kstats.nsamples);
+      ret.kernels.emplace_back(KernelStats{
+          plaidml_string_ptr(kstats.name),  //
+          kstats.runs,                      //
+          kstats.bytes,                     //
+          kstats.flops,                     //
+          kstats.total_seconds,             //
+          std::move(samples),               //
+      });
+    }
+    return ret;
+  }
+
+  plaidml_executable* as_ptr() const {  //
+    return ptr_.get();
+  }
+
+  void save(const std::string& path) {  //
+    ffi::call_void(plaidml_executable_save, ptr_.get(), path.c_str());
+  }
+
   void run() {  //
     ffi::call_void(plaidml_executable_run, ptr_.get());
   }
 
+  // Runs with some arguments bound to different, same-sized buffers for this
+  // run only; the remaining arguments keep their compile-time buffers.
+  void run(const std::vector<Binding>& inputs, const std::vector<Binding>& outputs) {
+    BindingStorage in(inputs);
+    BindingStorage out(outputs);
+    ffi::call_void(plaidml_executable_run_with, ptr_.get(), in.size(), in.data(), out.size(), out.data());
+  }
+
+  // Starts a run without waiting for it to finish; the bound buffers must not
+  // be accessed until the returned completion is done.
+  Completion run_async() {  //
+    return Completion(ffi::call<plaidml_completion*>(plaidml_executable_run_async, ptr_.get()));
+  }
+
+  Completion run_async(const std::vector<Binding>& inputs, const std::vector<Binding>& outputs) {
+    BindingStorage in(inputs);
+    BindingStorage out(outputs);
+    return Completion(ffi::call<plaidml_completion*>(  //
+        plaidml_executable_run_async_with,           //
+        ptr_.get(),                                  //
+        in.size(),                                   //
+        in.data(),                                   //
+        out.size(),                                  //
+        out.data()));
+  }
+
  private:
+  friend class Snapshot;
+
+  explicit Executable(const std::shared_ptr<plaidml_executable>& ptr) : ptr_(ptr) {}
+
+  class BindingStorage {
+   public:
+    explicit BindingStorage(const std::vector<Binding>& bindings)
+        : storage_(bindings.size()), ptrs_(bindings.size()) {
+      for (size_t i = 0; i < bindings.size(); i++) {
+        storage_[i].expr = bindings[i].tensor.as_ptr();
+        storage_[i].buffer = bindings[i].buffer.as_ptr();
+        ptrs_[i] = &storage_[i];
+      }
+    }
+
+    size_t size() const { return ptrs_.size(); }
+    plaidml_binding** data() { return ptrs_.data(); }
+
+   private:
+    std::vector<plaidml_binding> storage_;
+    std::vector<plaidml_binding*> ptrs_;
+  };
+
   std::shared_ptr<plaidml_executable> ptr_;
 };
 
+// Runs the executables as one chain, without waiting between them; see
+// plaidml_executables_submit.
+inline Completion submit(const std::vector<std::shared_ptr<Executable>>& executables) {
+  std::vector<plaidml_executable*> raw_execs(executables.size());
+  for (size_t i = 0; i < executables.size(); i++) {
+    raw_execs[i] = executables[i]->as_ptr();
+  }
+  return Completion(ffi::call<plaidml_completion*>(plaidml_executables_submit, raw_execs.size(), raw_execs.data()));
+}
+
+// A file holding several compiled executables, from which they can be loaded
+// without compiling; see plaidml_snapshot_save.
+class Snapshot {
+ public:
+  explicit Snapshot(const std::string& path)
+      : ptr_(details::make_ptr(ffi::call<plaidml_snapshot*>(plaidml_snapshot_open, path.c_str()))) {}
+
+  static void save(const std::string& path, const std::map<std::string, std::shared_ptr<Executable>>& executables) {
+    std::vector<const char*> raw_names;
+    std::vector<plaidml_executable*> raw_execs;
+    for (const auto& kvp : executables) {
+      raw_names.push_back(kvp.first.c_str());
+      raw_execs.push_back(kvp.second->as_ptr());
+    }
+    ffi::call_void(plaidml_snapshot_save, path.c_str(), raw_execs.size(), raw_names.data(), raw_execs.data());
+  }
+
+  std::vector<std::string> names() const {
+    auto strs = details::make_ptr(ffi::call<plaidml_strings*>(plaidml_snapshot_list, ptr_.get()));
+    std::vector<std::string> ret(strs->nstrs);
+    for (size_t i = 0; i < ret.size(); i++) {
+      ret[i] = ffi::str(strs->strs[i]);
+    }
+    return ret;
+  }
+
+  std::shared_ptr<Executable> executable(const std::string& name,             //
+                                         const std::string& device,           //
+                                         const std::vector<Buffer>& inputs,  //
+                                         const std::vector<Buffer>& outputs) const {
+    std::vector<plaidml_buffer*> raw_inputs(inputs.size());
+    for (size_t i = 0; i < inputs.size(); i++) {
+      raw_inputs[i] = inputs[i].as_ptr();
+    }
+    std::vector<plaidml_buffer*> raw_outputs(outputs.size());
+    for (size_t i = 0; i < outputs.size(); i++) {
+      raw_outputs[i] = outputs[i].as_ptr();
+    }
+    auto ptr = ffi::call<plaidml_executable*>(  //
+        plaidml_snapshot_executable,            //
+        ptr_.get(),                             //
+        name.c_str(),                           //
+        device.c_str(),                         //
+        raw_inputs.size(),                      //
+        raw_inputs.data(),                      //
+        raw_outputs.size(),                     //
+        raw_outputs.data());
+    return std::shared_ptr<Executable>(new Executable(details::make_ptr(ptr)));
+  }
+
+ private:
+  std::shared_ptr<plaidml_snapshot> ptr_;
+};
+
 class Binder {
  private:
   using BindingMap = std::map<edsl::TensorRef, Buffer>;
@@ -190,6 +414,164 @@ class Binder {
   std::map<edsl::TensorRef, Buffer> outputs_;
 };
 
+// Runs a program whose leading dimension is a batch size that varies from run
+// to run.  The program is built and compiled lazily for each of a small set of
+// batch sizes ("buckets"); each run uses the smallest bucket that holds its
+// batch, zero-padding the inputs and dropping the padded rows of the outputs.
+// Every non-constant input and every output must lead with the batch dimension.
+class BatchedExecutable {
+ public:
+  using ProgramBuilder = std::function<edsl::Program(int64_t batch_size)>;
+
+  explicit BatchedExecutable(ProgramBuilder builder,  //
+                             std::vector<int64_t> buckets = {1, 2, 4, 8, 16, 32})
+      : BatchedExecutable(                    //
+            std::move(builder),               //
+            std::move(buckets),               //
+            Settings::get("PLAIDML_DEVICE"),  //
+            Settings::get("PLAIDML_TARGET"))  //
+  {}
+
+  BatchedExecutable(ProgramBuilder builder,        //
+                    std::vector<int64_t> buckets,  //
+                    const std::string& device,     //
+                    const std::string& target)
+      : builder_(std::move(builder)), buckets_(std::move(buckets)), device_(device), target_(target) {
+    std::sort(buckets_.begin(), buckets_.end());
+    buckets_.erase(std::unique(buckets_.begin(), buckets_.end()), buckets_.end());
+    if (buckets_.empty() || buckets_.front() <= 0) {
+      throw std::runtime_error("Batch buckets must be positive");
+    }
+  }
+
+  const std::vector<int64_t>& buckets() const { return buckets_; }
+
+  // Returns the batch size of the bucket that would run batch_size items.
+  int64_t bucket_for(int64_t batch_size) const {
+    auto it = std::lower_bound(buckets_.begin(), buckets_.end(), batch_size);
+    if (batch_size <= 0 || it == buckets_.end()) {
+      throw std::runtime_error("Batch size " + std::to_string(batch_size) + " is outside the batch buckets");
+    }
+    return *it;
+  }
+
+  // The bytes in a single row of each non-constant input and of each output,
+  // in program order.  Compiles the smallest bucket if nothing has been
+  // compiled yet.
+  struct RowBytes {
+    std::vector<size_t> inputs;
+    std::vector<size_t> outputs;
+  };
+
+  RowBytes row_bytes() {
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      if (row_bytes_) {
+        return *row_bytes_;
+      }
+    }
+    auto size = buckets_.front();
+    auto bucket = get_bucket(size);
+    std::lock_guard<std::mutex> bucket_lock(bucket->mu);
+    if (!bucket->executable) {
+      compile(size, bucket);
+    }
+    std::lock_guard<std::mutex> lock(mu_);
+    return *row_bytes_;
+  }
+
+  // Runs batch_size items.  inputs holds one host pointer per non-constant
+  // program input and outputs one per program output, each in program order
+  // and each holding batch_size rows.
+  void run(int64_t batch_size, const std::vector<const void*>& inputs, const std::vector<void*>& outputs) {
+    auto size = bucket_for(batch_size);
+    auto bucket = get_bucket(size);
+    std::lock_guard<std::mutex> lock(bucket->mu);
+    if (!bucket->executable) {
+      compile(size, bucket);
+    }
+    if (inputs.size() != bucket->inputs.size() || outputs.size() != bucket->outputs.size()) {
+      throw std::runtime_error("Argument count mismatch running batched program");
+    }
+    for (size_t i = 0; i < inputs.size(); i++) {
+      auto view = bucket->inputs[i].mmap_discard();
+      auto bytes = view.size() / size * batch_size;
+      memcpy(view.data(), inputs[i], bytes);
+      memset(view.data() + bytes, 0, view.size() - bytes);
+      view.writeback();
+    }
+    bucket->executable->run();
+    for (size_t i = 0; i < outputs.size(); i++) {
+      auto view = bucket->outputs[i].mmap_current();
+      memcpy(outputs[i], view.data(), view.size() / size * batch_size);
+    }
+  }
+
+ private:
+  struct Bucket {
+    std::mutex mu;  // Serializes runs, which share the bucket's buffers.
+    std::shared_ptr<Executable> executable;
+    std::vector<Buffer> inputs;
+    std::vector<Buffer> outputs;
+  };
+
+  std::shared_ptr<Bucket> get_bucket(int64_t size) {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto& bucket = compiled_[size];
+    if (!bucket) {
+      bucket = std::make_shared<Bucket>();
+    }
+    return bucket;
+  }
+
+  void compile(int64_t size, const std::shared_ptr<Bucket>& bucket) {
+    auto program = builder_(size);
+    auto check_batched = [size](const edsl::ProgramArgument& arg) {
+      auto dims = arg.shape.int_dims();
+      if (dims.empty() || dims[0] != size) {
+        throw std::runtime_error("Batched program arguments must lead with the batch dimension");
+      }
+    };
+    Binder binder(program);
+    binder.set_device(device_).set_target(target_);
+    auto executable = binder.compile();
+    auto row_size = [size](const edsl::ProgramArgument& arg) {
+      return TensorShape(arg.shape.dtype(), arg.shape.int_dims()).nbytes() / size;
+    };
+    RowBytes row_bytes;
+    std::vector<Buffer> inputs;
+    for (const auto& arg : program.inputs()) {
+      if (!arg.buffer) {
+        check_batched(arg);
+        inputs.push_back(binder.input(arg.tensor));
+        row_bytes.inputs.push_back(row_size(arg));
+      }
+    }
+    std::vector<Buffer> outputs;
+    for (const auto& arg : program.outputs()) {
+      check_batched(arg);
+      outputs.push_back(binder.output(arg.tensor));
+      row_bytes.outputs.push_back(row_size(arg));
+    }
+    bucket->inputs = std::move(inputs);
+    bucket->outputs = std::move(outputs);
+    bucket->executable = executable;
+    std::lock_guard<std::mutex> lock(mu_);
+    if (!row_bytes_) {
+      row_bytes_ = std::make_unique<RowBytes>(std::move(row_bytes));
+    }
+  }
+
+ private:
+  ProgramBuilder builder_;
+  std::vector<int64_t> buckets_;
+  std::string device_;
+  std::string target_;
+  std::mutex mu_;
+  std::map<int64_t, std::shared_ptr<Bucket>> compiled_;
+  std::unique_ptr<RowBytes> row_bytes_;  // Set by the first compile
+};
+
 }  // namespace exec
 
 }  // namespace plaidml
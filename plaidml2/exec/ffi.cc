@@ -3,18 +3,30 @@
 #include "plaidml2/exec/ffi.h"
 
 #include <algorithm>
+#include <cstring>
+#include <functional>
 #include <map>
 #include <memory>
+#include <set>
 #include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include <google/protobuf/util/json_util.h>
+
 #include "llvm/Support/FormatVariadic.h"
 
-#include "base/util/env.h"
+#include "base/util/file.h"
+#include "base/util/runtime_options.h"
 #include "plaidml2/core/internal.h"
+#include "plaidml2/exec/exec.pb.h"
+#include "tile/base/data_parallel_program.h"
+#include "tile/base/pipeline_program.h"
+#include "tile/codegen/stages.h"
+#include "tile/proto/hal.pb.h"
 #include "tile/targets/targets.h"
+#include "tile/util/mapped_archive.h"
 
 #ifdef PLAIDML_AST
 #include "tile/lang/gen_stripe.h"
@@ -22,10 +34,16 @@
 #ifdef PLAIDML_MLIR
 #include "pmlc/compiler/compiler.h"
 #include "pmlc/compiler/registry.h"
+#include "mlir/Dialect/StandardOps/Ops.h"
+#include "mlir/Pass/PassManager.h"
+#include "mlir/Transforms/Passes.h"
 #include "pmlc/conversion/tile_to_stripe/tile_to_stripe.h"
+#include "pmlc/dialect/eltwise/ir/types.h"
 #include "pmlc/dialect/stripe/dialect.h"
 #include "pmlc/dialect/stripe/transcode.h"
+#include "pmlc/dialect/tile/ir/dialect.h"
 #include "pmlc/dialect/tile/program.h"
+#include "pmlc/dialect/tile/transforms/passes.h"
 #endif
 
 using plaidml::core::ffi_wrap;
@@ -34,12 +52,18 @@ using plaidml::core::GetPlatform;
 using plaidml::core::GlobalContext;
 using vertexai::context::Context;
 using vertexai::tile::Allocator;
+using vertexai::tile::ArgumentBinding;
+using vertexai::tile::ArgumentTable;
 using vertexai::tile::Buffer;
 using vertexai::tile::BufferPtr;
 using vertexai::tile::ConstBufferManager;
+using vertexai::tile::DataParallelProgram;
+using vertexai::tile::PipelineProgram;
 using vertexai::tile::Program;
 using vertexai::tile::View;
 using vertexai::tile::targets::GetConfigs;
+using vertexai::tile::util::MappedArchive;
+using vertexai::tile::util::MappedArchiveWriter;
 
 #ifdef PLAIDML_AST
 using vertexai::tile::lang::ast::ExprPtr;
@@ -47,8 +71,11 @@ using vertexai::tile::lang::ast::ParamExpr;
 #endif
 #ifdef PLAIDML_MLIR
 using pmlc::compiler::Executable;
+using pmlc::dialect::eltwise::ScalarType;
 using pmlc::dialect::tile::ProgramArgument;
+using pmlc::dialect::tile::TileProgram;
 using StripeDialect = pmlc::dialect::stripe::Dialect;
+using TileDialect = pmlc::dialect::tile::Dialect;
 using pmlc::dialect::stripe::FromMLIR;
 using pmlc::dialect::tile::LowerIntoStripe;
 using namespace mlir;  // NOLINT[build/namespaces]
@@ -65,10 +92,192 @@ class PlatformAllocator : public Allocator {
     return GetPlatform()->MakeBuffer(*ctx, device_id_, size);
   }
 
+  std::string device_key() const final { return device_id_; }
+
  private:
   std::string device_id_;
 };
 
+// Splits a comma-separated list of devices.
+std::vector<std::string> SplitDevices(const std::string& device) {
+  std::vector<std::string> devices;
+  std::string::size_type pos = 0;
+  while (true) {
+    auto end = device.find(',', pos);
+    devices.emplace_back(device.substr(pos, end - pos));
+    if (end == std::string::npos) {
+      break;
+    }
+    pos = end + 1;
+  }
+  return devices;
+}
+
+BufferPtr CopyBuffer(const Context& ctx, const BufferPtr& src, Allocator* allocator) {
+  auto dst = allocator->allocate(src->size());
+  auto src_view = src->MapCurrentSync(ctx);
+  auto dst_view = dst->MapDiscard(ctx);
+  std::memcpy(dst_view->data(), src_view->data(), src->size());
+  dst_view->WriteBack(ctx);
+  return dst;
+}
+
+// Returns a copy of the constant buffers on the device.
+ConstBufferManager CopyConstBuffers(const Context& ctx, const ConstBufferManager& const_bufs,
+                                    const std::string& device) {
+  ConstBufferManager result;
+  result.allocator = std::make_shared<PlatformAllocator>(device);
+  for (const auto& kvp : const_bufs.buffers) {
+    result.buffers[kvp.first] = CopyBuffer(ctx, kvp.second, result.allocator.get());
+  }
+  return result;
+}
+
+// Compiles a stage of a partitioned program for the device, recording the
+// sizes of the stage's arguments.
+PipelineProgram::Stage CompileStage(                    //
+    const Context& ctx,                                 //
+    const std::string& device,                          //
+    const std::string& target,                          //
+    const vertexai::tile::codegen::ProgramStage& part,  //
+    const ConstBufferManager& const_bufs,               //
+    std::map<std::string, std::uint64_t>* arg_bytes) {
+  for (const auto* shapes : {&part.program->input_shapes, &part.program->output_shapes}) {
+    for (const auto& kvp : *shapes) {
+      (*arg_bytes)[kvp.first] = kvp.second.byte_size();
+    }
+  }
+  // Each stage only gets copies of the constants it uses.
+  ConstBufferManager used_bufs;
+  for (const auto& kvp : const_bufs.buffers) {
+    if (part.program->entry->ref_by_into(kvp.first, false) != part.program->entry->refs.end()) {
+      used_bufs.buffers.insert(kvp);
+    }
+  }
+  auto stage_bufs = CopyConstBuffers(ctx, used_bufs, device);
+  auto program = GetPlatform()->MakeProgram(ctx, device, target, part.program, &stage_bufs);
+  return PipelineProgram::Stage{std::move(program), stage_bufs.allocator, part.inputs, part.outputs};
+}
+
+// Partitions the program into one stage per device, as a PipelineProgram.
+std::shared_ptr<Program> MakePipelineProgram(                        //
+    const Context& ctx,                                              //
+    const std::vector<std::string>& devices,                         //
+    const std::string& target,                                       //
+    const std::shared_ptr<vertexai::tile::stripe::Program>& stripe,  //
+    const ConstBufferManager& const_bufs) {
+  std::vector<PipelineProgram::Stage> stages;
+  std::map<std::string, std::uint64_t> arg_bytes;
+  auto partition = vertexai::tile::codegen::PartitionStages(*stripe, devices.size());
+  for (std::size_t idx = 0; idx < partition.size(); idx++) {
+    const auto& part = partition[idx];
+    IVLOG(1, "Compiling stage " << idx << " (cost " << part.cost << ") for device: " << devices[idx]);
+    stages.emplace_back(CompileStage(ctx, devices[idx], target, part, const_bufs, &arg_bytes));
+  }
+  return std::make_shared<PipelineProgram>(std::move(stages), std::move(arg_bytes));
+}
+
+// The overhead of launching a kernel on a device other than the host.
+constexpr double kDeviceLaunchSec = 10e-6;
+
+// Estimates the rates at which the device runs kernels from its hardware
+// settings.  Devices without settings are the host, running kernels through
+// the LLVM JIT with no launch overhead.
+vertexai::tile::codegen::DeviceCost GetDeviceCost(const Context& ctx, const std::string& device) {
+  vertexai::tile::codegen::DeviceCost cost;
+  vertexai::tile::proto::ListDevicesResponse response;
+  GetPlatform()->ListDevices(ctx, vertexai::tile::proto::ListDevicesRequest{}, &response);
+  for (const auto& dev : response.devices()) {
+    if (dev.dev_id() != device || dev.config().empty()) {
+      continue;
+    }
+    vertexai::tile::hal::proto::HardwareSettings settings;
+    google::protobuf::util::JsonParseOptions options;
+    options.ignore_unknown_fields = true;
+    if (!google::protobuf::util::JsonStringToMessage(dev.config(), &settings, options).ok()) {
+      continue;
+    }
+    if (settings.peak_gflops() > 0) {
+      cost.flops_per_sec = settings.peak_gflops() * 1e9;
+    }
+    if (settings.peak_gbytes_per_sec() > 0) {
+      cost.bytes_per_sec = settings.peak_gbytes_per_sec() * 1e9;
+    }
+    cost.launch_sec = kDeviceLaunchSec;
+  }
+  return cost;
+}
+
+// Places each kernel of the program on whichever device runs it soonest,
+// running the resulting stages in sequence as a PipelineProgram.
+std::shared_ptr<Program> MakePlacedProgram(                          //
+    const Context& ctx,                                              //
+    const std::vector<std::string>& devices,                         //
+    const std::string& target,                                       //
+    const std::shared_ptr<vertexai::tile::stripe::Program>& stripe,  //
+    const ConstBufferManager& const_bufs) {
+  std::vector<vertexai::tile::codegen::DeviceCost> costs;
+  double handoff_bytes_per_sec = 0;
+  for (const auto& device : devices) {
+    costs.emplace_back(GetDeviceCost(ctx, device));
+    // Stages hand off temporaries through host mappings, which on devices
+    // sharing the host's memory are zero-copy; the slowest memory bounds them.
+    if (!handoff_bytes_per_sec || costs.back().bytes_per_sec < handoff_bytes_per_sec) {
+      handoff_bytes_per_sec = costs.back().bytes_per_sec;
+    }
+  }
+  std::vector<PipelineProgram::Stage> stages;
+  std::map<std::string, std::uint64_t> arg_bytes;
+  auto placement = vertexai::tile::codegen::PlaceStages(*stripe, costs, handoff_bytes_per_sec);
+  for (std::size_t idx = 0; idx < placement.size(); idx++) {
+    const auto& part = placement[idx];
+    const auto& device = devices[part.device];
+    IVLOG(1, "Compiling stage " << idx << " (cost " << part.cost << ") for device: " << device);
+    stages.emplace_back(CompileStage(ctx, device, target, part, const_bufs, &arg_bytes));
+  }
+  return std::make_shared<PipelineProgram>(std::move(stages), std::move(arg_bytes));
+}
+
+// Compiles the program for the device.  Given several devices, the program
+// is either replicated across them as a DataParallelProgram, or, if
+// PLAIDML_MODEL_PARALLEL=1, partitioned across them as a PipelineProgram, or,
+// if PLAIDML_COSCHEDULE=1, has each kernel placed on one of them by cost.
+// In each case, the program is generated with shapes for one replica's share
+// (or one micro-batch) of the batch, afresh for each device, and each device
+// gets its own copies of the constant buffers.
+std::shared_ptr<Program> MakeProgram(                                                      //
+    const Context& ctx,                                                                    //
+    const std::vector<std::string>& devices,                                               //
+    const std::string& target,                                                             //
+    const std::function<std::shared_ptr<vertexai::tile::stripe::Program>()>& make_stripe,  //
+    ConstBufferManager* const_bufs) {
+  if (devices.size() == 1) {
+    return GetPlatform()->MakeProgram(ctx, devices[0], target, make_stripe(), const_bufs);
+  }
+  if (vertexai::RuntimeOptions::Get().coschedule) {
+    return MakePlacedProgram(ctx, devices, target, make_stripe(), *const_bufs);
+  }
+  if (vertexai::RuntimeOptions::Get().model_parallel) {
+    return MakePipelineProgram(ctx, devices, target, make_stripe(), *const_bufs);
+  }
+  std::vector<DataParallelProgram::Replica> replicas;
+  std::map<std::string, std::uint64_t> arg_bytes;
+  for (const auto& device : devices) {
+    IVLOG(1, "Compiling replica for device: " << device);
+    auto stripe = make_stripe();
+    for (const auto& kvp : stripe->input_shapes) {
+      arg_bytes[kvp.first] = kvp.second.byte_size();
+    }
+    for (const auto& kvp : stripe->output_shapes) {
+      arg_bytes[kvp.first] = kvp.second.byte_size();
+    }
+    auto replica_bufs = CopyConstBuffers(ctx, *const_bufs, device);
+    auto program = GetPlatform()->MakeProgram(ctx, device, target, stripe, &replica_bufs);
+    replicas.emplace_back(DataParallelProgram::Replica{std::move(program), replica_bufs.allocator});
+  }
+  return std::make_shared<DataParallelProgram>(std::move(replicas), std::move(arg_bytes));
+}
+
 #ifdef PLAIDML_MLIR
 
 std::vector<ProgramArgument> BindProgramArguments(  //
@@ -102,32 +311,331 @@ std::vector<ProgramArgument> BindProgramArguments(  //
       if (it != output_bindings.end()) {
         arg.buffer = it->second;
       }
+      // Unbound outputs are pruned from the program (see PruneOutputs).
       IVLOG(1, "Output[" << i << "]: " << arg.buffer);
-      if (!arg.buffer) {
-        throw std::runtime_error("Unbound output");
-      }
     }
     args[i] = std::move(arg);
   }
   return args;
 }
 
+// Removes the outputs of the program which have no buffer bound, along with
+// the computations which only they depend on, so that unused branches of a
+// program (such as the training heads of an exported inference graph) are
+// neither compiled nor run.  Returns a copy of the program's module without
+// them, and erases them from args.  At least one output must remain bound.
+OwningModuleRef PruneOutputs(TileProgram* program, std::vector<ProgramArgument>* args) {
+  OwningModuleRef module(cast<ModuleOp>(program->module->getOperation()->clone()));
+  auto funcOp = module->lookupSymbol<FuncOp>(program->entry);
+  auto numInputs = funcOp.getNumArguments();
+  auto returnOp = cast<ReturnOp>(funcOp.getBody().front().getTerminator());
+  std::vector<ProgramArgument> kept(args->begin(), args->begin() + numInputs);
+  SmallVector<Value, 4> results;
+  SmallVector<Type, 4> resultTypes;
+  for (unsigned i = 0; i < returnOp.getNumOperands(); i++) {
+    const auto& arg = (*args)[numInputs + i];
+    if (!arg.buffer) {
+      continue;
+    }
+    kept.push_back(arg);
+    results.push_back(returnOp.getOperand(i));
+    resultTypes.push_back(returnOp.getOperand(i)->getType());
+  }
+  if (results.size() == returnOp.getNumOperands()) {
+    return module;
+  }
+  if (results.empty()) {
+    throw std::runtime_error("Unbound output");
+  }
+  IVLOG(1, "Pruning " << returnOp.getNumOperands() - results.size() << " unbound outputs");
+  OpBuilder builder(returnOp);
+  builder.create<ReturnOp>(returnOp.getLoc(), results);
+  returnOp.erase();
+  funcOp.setType(FunctionType::get(funcOp.getType().getInputs(), resultTypes, module->getContext()));
+
+  // The canonicalizer erases the operations left without users.
+  PassManager pm(module->getContext());
+  pm.addPass(createCanonicalizerPass());
+  if (failed(pm.run(*module))) {
+    throw std::runtime_error("Output pruning failure");
+  }
+  *args = std::move(kept);
+  return module;
+}
+
+// Evaluates the computations of the program which depend only on the buffers
+// bound to its placeholders when it was built (typically an inference model's
+// weights), so that they needn't be repeated on every run.  Rewrites module (a
+// copy of the program's, from PruneOutputs) so that its entry function takes
+// the results as additional inputs; these are inserted into args after the
+// existing inputs, and the indices of all constant inputs are recorded in
+// constants.  The results are allocated by const_bufs.
+// Placeholders bound explicitly at compile time or updated by the program are
+// never treated as constant.  Setting PLAIDML_FOLD_CONSTANTS=0 disables this.
+OwningModuleRef FoldConstants(           //
+    TileProgram* program,                //
+    OwningModuleRef module,              //
+    std::vector<ProgramArgument>* args,  //
+    std::set<unsigned>* constants,       //
+    ConstBufferManager* const_bufs) {
+  if (!vertexai::RuntimeOptions::Get().fold_constants) {
+    return module;
+  }
+  auto funcOp = module->lookupSymbol<FuncOp>(program->entry);
+  auto constAttrName = TileDialect::getDialectAttrName("const");
+  auto resultAttrName = TileDialect::getDialectAttrName("const_result");
+  auto constantsAttrName = TileDialect::getDialectAttrName("constants");
+  auto numInputs = funcOp.getNumArguments();
+  std::vector<BufferPtr> inputBuffers;
+  for (unsigned i = 0; i < numInputs; i++) {
+    const auto& arg = (*args)[i];
+    if (!arg.buffer || arg.buffer != program->arguments[i].buffer) {
+      continue;
+    }
+    auto isUpdated = std::any_of(args->begin() + numInputs, args->end(),
+                                 [&](const ProgramArgument& output) { return output.value == arg.value; });
+    if (!isUpdated) {
+      funcOp.setArgAttr(i, constAttrName, UnitAttr::get(module->getContext()));
+      inputBuffers.push_back(arg.buffer);
+      constants->insert(i);
+    }
+  }
+  if (inputBuffers.empty()) {
+    return module;
+  }
+
+  PassManager pm(module->getContext());
+  pm.addPass(pmlc::dialect::tile::createSplitConstantsPass());
+  if (failed(pm.run(*module))) {
+    throw std::runtime_error("Constant folding failure");
+  }
+  for (unsigned i = 0; i < numInputs; i++) {
+    funcOp.removeArgAttr(i, constAttrName);
+  }
+  auto constantsAttr = funcOp.getAttrOfType<FlatSymbolRefAttr>(constantsAttrName);
+  if (!constantsAttr) {
+    constants->clear();
+    return module;
+  }
+  funcOp.removeAttr(constantsAttrName);
+
+  // The constant function is compiled on its own, as the JIT expects a single
+  // function per module.
+  auto constFuncName = constantsAttr.getValue().str();
+  auto constFuncOp = module->lookupSymbol<FuncOp>(constFuncName);
+  OwningModuleRef constModule(ModuleOp::create(constFuncOp.getLoc()));
+  constModule->push_back(constFuncOp.clone());
+  constFuncOp.erase();
+
+  auto ctx = GlobalContext::getContext();
+  std::vector<std::unique_ptr<View>> inputViews;
+  std::vector<std::unique_ptr<View>> resultViews;
+  std::vector<void*> bufptrs;
+  for (const auto& buffer : inputBuffers) {
+    inputViews.emplace_back(buffer->MapCurrentSync(*ctx));
+    bufptrs.push_back(inputViews.back()->data());
+  }
+  std::vector<ProgramArgument> results;
+  for (unsigned i = numInputs; i < funcOp.getNumArguments(); i++) {
+    auto arg = funcOp.getArgument(i);
+    auto type = arg->getType().cast<RankedTensorType>();
+    auto elementType = type.getElementType().cast<ScalarType>();
+    auto size = type.getNumElements() * vertexai::tile::byte_width(elementType.type());
+    auto buffer = const_bufs->allocator->allocate(size);
+    resultViews.emplace_back(buffer->MapDiscard(*ctx));
+    bufptrs.push_back(resultViews.back()->data());
+    funcOp.removeArgAttr(i, resultAttrName);
+    results.push_back(ProgramArgument{true, arg, type, buffer});
+    constants->insert(i);
+  }
+  IVLOG(1, "Folding " << results.size() << " constants from " << inputBuffers.size() << " inputs");
+  Executable exec(constFuncName, "llvm_cpu", *constModule, bufptrs);
+  exec.invoke();
+  for (auto& view : resultViews) {
+    view->WriteBack(*ctx);
+  }
+  args->insert(args->begin() + numInputs, results.begin(), results.end());
+  return module;
+}
+
 #endif  // PLAIDML_MLIR
 
 }  // namespace
 
 extern "C" {
 
+struct plaidml_completion {
+  boost::shared_future<void> future;
+  // Keeps the programs alive until the runs have finished, even if the
+  // executables are freed first.
+  std::vector<std::shared_ptr<Program>> programs;
+  // Callback continuations; each future joins its continuation when destroyed.
+  std::vector<boost::future<void>> notifications;
+};
+
 struct plaidml_executable {
   using BufferMap = std::map<std::string, std::shared_ptr<Buffer>>;
   BufferMap input_bufs;
   BufferMap output_bufs;
+  // The argument names, in binding order.
+  std::vector<std::string> input_names;
+  std::vector<std::string> output_names;
   std::shared_ptr<Program> program;
+  // The arguments pre-bound by slot, if the program supports it, so that runs
+  // with the executable's own buffers need no maps; the table borrows the
+  // buffers held by input_bufs and output_bufs.
+  std::shared_ptr<ArgumentBinding> binding;
+  ArgumentTable args;
+  // The argument name of each bindable expression, used to rebind buffers for
+  // a single run.
+#ifdef PLAIDML_AST
+  std::unordered_map<ExprPtr, std::string> expr_names;
+#endif  // PLAIDML_AST
 #ifdef PLAIDML_MLIR
+  llvm::DenseMap<Value, std::string> value_names;
   std::unique_ptr<Executable> exec;
+  // The JIT's argument order, by name; only used if exec is set.
+  std::vector<std::string> exec_args;
 #endif  // PLAIDML_MLIR
 };
 
+struct plaidml_snapshot {
+  std::shared_ptr<MappedArchive> archive;
+};
+
+namespace {
+
+const char kSnapshotPrefix[] = "executable/";
+
+std::string BoundName(const plaidml_executable* exec, const plaidml_binding* binding) {
+#ifdef PLAIDML_AST
+  {
+    auto it = exec->expr_names.find(binding->expr->expr);
+    if (it != exec->expr_names.end()) {
+      return it->second;
+    }
+  }
+#endif  // PLAIDML_AST
+#ifdef PLAIDML_MLIR
+  {
+    auto it = exec->value_names.find(binding->expr->value);
+    if (it != exec->value_names.end()) {
+      return it->second;
+    }
+  }
+#endif  // PLAIDML_MLIR
+  throw std::runtime_error("Binding does not refer to an argument of this executable");
+}
+
+void Rebind(const plaidml_executable* exec, size_t nbindings, plaidml_binding** bindings,
+            plaidml_executable::BufferMap* bufs) {
+  for (size_t i = 0; i < nbindings; i++) {
+    auto name = BoundName(exec, bindings[i]);
+    auto it = bufs->find(name);
+    if (it == bufs->end()) {
+      throw std::runtime_error(llvm::formatv("Argument '{0}' bound in the wrong direction", name));
+    }
+    const auto& buffer = bindings[i]->buffer->buffer;
+    if (buffer->size() != it->second->size()) {
+      throw std::runtime_error(llvm::formatv("Buffer size mismatch for argument '{0}': expected {1} bytes, got {2}",
+                                             name, it->second->size(), buffer->size()));
+    }
+    it->second = buffer;
+  }
+}
+
+// Pre-binds the executable's own buffers to its program's argument slots.
+void BindArguments(plaidml_executable* exec) {
+  exec->binding = exec->program->Bind(exec->input_names, exec->output_names);
+  if (!exec->binding) {
+    return;
+  }
+  for (const auto& name : exec->input_names) {
+    exec->args.inputs.push_back(exec->input_bufs.at(name).get());
+  }
+  for (const auto& name : exec->output_names) {
+    exec->args.outputs.push_back(exec->output_bufs.at(name).get());
+  }
+}
+
+plaidml::exec::proto::SavedExecutable SaveExecutable(const plaidml_executable* exec) {
+#ifdef PLAIDML_MLIR
+  if (exec->exec) {
+    throw std::runtime_error("Executables built for the MLIR execution engine cannot be saved");
+  }
+#endif  // PLAIDML_MLIR
+  auto ctx = GlobalContext::getContext();
+  plaidml::exec::proto::SavedExecutable saved;
+  *saved.mutable_inputs() = {exec->input_names.begin(), exec->input_names.end()};
+  *saved.mutable_outputs() = {exec->output_names.begin(), exec->output_names.end()};
+  saved.set_program(exec->program->Save(*ctx));
+  return saved;
+}
+
+std::unique_ptr<plaidml_executable> LoadExecutable(const plaidml::exec::proto::SavedExecutable& saved,  //
+                                                   const char* device,                                  //
+                                                   size_t ninputs,                                      //
+                                                   plaidml_buffer** inputs,                             //
+                                                   size_t noutputs,                                     //
+                                                   plaidml_buffer** outputs) {
+  if (SplitDevices(device).size() > 1) {
+    throw std::runtime_error("Saved executables can only be loaded onto a single device");
+  }
+  if (ninputs != static_cast<size_t>(saved.inputs_size()) ||
+      noutputs != static_cast<size_t>(saved.outputs_size())) {
+    throw std::runtime_error(llvm::formatv("The saved executable requires {0} inputs and {1} outputs",
+                                           saved.inputs_size(), saved.outputs_size()));
+  }
+  auto ctx = GlobalContext::getContext();
+  ConstBufferManager const_bufs;
+  const_bufs.allocator = std::make_shared<PlatformAllocator>(device);
+  auto exec = std::make_unique<plaidml_executable>();
+  exec->program = GetPlatform()->LoadProgram(*ctx, device, saved.program(), &const_bufs);
+  for (size_t i = 0; i < ninputs; i++) {
+    exec->input_bufs[saved.inputs(i)] = inputs[i]->buffer;
+    exec->input_names.push_back(saved.inputs(i));
+  }
+  for (size_t i = 0; i < noutputs; i++) {
+    exec->output_bufs[saved.outputs(i)] = outputs[i]->buffer;
+    exec->output_names.push_back(saved.outputs(i));
+  }
+  BindArguments(exec.get());
+  return exec;
+}
+
+boost::future<void> StartRun(const plaidml_executable* exec,                   //
+                             const plaidml_executable::BufferMap& input_bufs,  //
+                             const plaidml_executable::BufferMap& output_bufs) {
+  auto ctx = GlobalContext::getContext();
+#ifdef PLAIDML_MLIR
+  if (exec->exec) {
+    // The JIT executes synchronously on the calling thread.
+    std::vector<void*> bufptrs(exec->exec_args.size());
+    for (size_t i = 0; i < bufptrs.size(); i++) {
+      const auto& name = exec->exec_args[i];
+      auto it = input_bufs.find(name);
+      auto buffer = (it != input_bufs.end()) ? it->second : output_bufs.at(name);
+      auto data = buffer->host_data();
+      bufptrs[i] = data ? data : buffer->MapCurrentSync(*ctx)->data();
+    }
+    exec->exec->invoke(bufptrs);
+    return boost::make_ready_future();
+  }
+#endif  // PLAIDML_MLIR
+  return exec->program->Run(*ctx, input_bufs, output_bufs);
+}
+
+// Runs the executable with its own buffers.
+boost::future<void> StartBoundRun(const plaidml_executable* exec) {
+  if (!exec->binding) {
+    return StartRun(exec, exec->input_bufs, exec->output_bufs);
+  }
+  auto ctx = GlobalContext::getContext();
+  return exec->program->Run(*ctx, *exec->binding, exec->args);
+}
+
+}  // namespace
+
 void plaidml_exec_init(  //
     plaidml_error* err) {
   static std::once_flag is_initialized;
@@ -158,7 +666,7 @@ plaidml_strings* plaidml_targets_get(  //
     plaidml_error* err) {
   return ffi_wrap<plaidml_strings*>(err, nullptr, [&] {
 #ifdef PLAIDML_MLIR
-    if (vertexai::env::Get("PLAIDML_EE") == "1") {
+    if (vertexai::RuntimeOptions::Get().ee) {
       const auto& targets = pmlc::compiler::listTargets();
       auto strs = new plaidml_string*[targets.size()];
       for (unsigned i = 0; i < targets.size(); i++) {
@@ -168,7 +676,7 @@ plaidml_strings* plaidml_targets_get(  //
     }
 #endif
 
-    auto configs = GetConfigs().configs();
+    const auto& configs = GetConfigs().configs();
     auto strs = new plaidml_string*[configs.size()];
     size_t i = 0;
     for (const auto& [key, value] : configs) {
@@ -189,19 +697,20 @@ plaidml_executable* plaidml_compile(  //
     plaidml_binding** outputs) {
   return ffi_wrap<plaidml_executable*>(err, nullptr, [&] {
     IVLOG(1, "Compiling with device: " << device << ", target: " << target);
-    if (vertexai::env::Get("PLAIDML_EE") != "1") {
-      auto configs = GetConfigs().configs();
+    auto devices = SplitDevices(device);
+    if (!vertexai::RuntimeOptions::Get().ee) {
+      const auto& configs = GetConfigs().configs();
       if (!configs.count(target)) {
         throw std::runtime_error(llvm::formatv("Unknown target specified: {0}", target));
       }
     }
 #ifdef PLAIDML_AST
     ConstBufferManager const_bufs;
-    const_bufs.allocator = std::make_shared<PlatformAllocator>(device);
+    const_bufs.allocator = std::make_shared<PlatformAllocator>(devices[0]);
     auto exec = std::make_unique<plaidml_executable>();
-    auto stripe = vertexai::tile::lang::GenerateStripe(program->eval.runinfo);
     Context ctx;
-    exec->program = GetPlatform()->MakeProgram(ctx, device, target, stripe, &const_bufs);
+    auto generate = [&] { return vertexai::tile::lang::GenerateStripe(program->eval.runinfo); };
+    exec->program = MakeProgram(ctx, devices, target, generate, &const_bufs);
     std::unordered_map<ExprPtr, BufferPtr> input_bindings;
     for (size_t i = 0; i < ninputs; i++) {
       auto param_expr = std::dynamic_pointer_cast<ParamExpr>(inputs[i]->expr->expr);
@@ -216,47 +725,67 @@ plaidml_executable* plaidml_compile(  //
       output_bindings[outputs[i]->expr->expr] = outputs[i]->buffer->buffer;
     }
     for (const auto& arg : program->eval.args) {
+      exec->expr_names[arg.expr] = arg.name;
       if (arg.is_input) {
         auto it = input_bindings.find(arg.expr);
         auto param_expr = std::dynamic_pointer_cast<ParamExpr>(arg.expr);
         auto buffer = (it == input_bindings.end()) ? param_expr->buffer : it->second;
         exec->input_bufs[arg.name] = buffer;
+        exec->input_names.push_back(arg.name);
       } else {
         auto it = output_bindings.find(arg.expr);
         if (it == output_bindings.end()) {
           throw std::runtime_error("Invalid program, unbound output");
         }
         exec->output_bufs[arg.name] = it->second;
+        exec->output_names.push_back(arg.name);
       }
     }
     for (const auto& kvp : program->eval.updates) {
       exec->output_bufs[kvp.first] = kvp.second->buffer;
+      exec->output_names.push_back(kvp.first);
     }
+    BindArguments(exec.get());
     return exec.release();
 #endif
 #ifdef PLAIDML_MLIR
     auto ctx = GlobalContext::getContext();
     auto args = BindProgramArguments(program, ninputs, inputs, noutputs, outputs);
-    if (vertexai::env::Get("PLAIDML_EE") == "1") {
+    ConstBufferManager const_bufs;
+    const_bufs.allocator = std::make_shared<PlatformAllocator>(devices[0]);
+    std::set<unsigned> constants;
+    auto pruned = PruneOutputs(program->program.get(), &args);
+    auto folded = FoldConstants(program->program.get(), std::move(pruned), &args, &constants, &const_bufs);
+    if (vertexai::RuntimeOptions::Get().ee) {
+      if (devices.size() > 1) {
+        throw std::runtime_error("The MLIR execution engine does not support multiple devices");
+      }
       auto exec = std::make_unique<plaidml_executable>();
       std::vector<void*> bufptrs(args.size());
       for (unsigned i = 0; i < args.size(); i++) {
-        auto view = args[i].buffer->MapCurrent(*ctx).get();
+        auto view = args[i].buffer->MapCurrentSync(*ctx);
         bufptrs[i] = view->data();
+        auto name = std::to_string(i);
+        exec->exec_args.push_back(name);
+        if (constants.count(i)) {
+          // Constants aren't bindable, as the folded results depend on them.
+          exec->input_bufs[name] = args[i].buffer;
+          continue;
+        }
+        exec->value_names[args[i].value] = name;
+        if (args[i].isInput) {
+          exec->input_bufs[name] = args[i].buffer;
+        } else {
+          exec->output_bufs[name] = args[i].buffer;
+        }
       }
-      exec->exec = std::make_unique<Executable>(program->program->entry, target, *program->program->module, bufptrs);
+      exec->exec = std::make_unique<Executable>(program->program->entry, target, *folded, bufptrs);
       return exec.release();
     }
-    ConstBufferManager const_bufs;
-    const_bufs.allocator = std::make_shared<PlatformAllocator>(device);
     auto exec = std::make_unique<plaidml_executable>();
 
     // 1. lower tile dialect -> stripe dialect
-    auto module = LowerIntoStripe(*program->program->module);
-    // 2. convert MLIR -> stripe
-    auto stripe = FromMLIR(*module);
-    exec->program = GetPlatform()->MakeProgram(*ctx, device, target, stripe, &const_bufs);
-    IVLOG(1, "After make program");
+    auto module = LowerIntoStripe(*folded);
 
     auto attrName = StripeDialect::getDialectAttrName("name");
     auto stripeFuncOp = cast<FuncOp>(module->getBody()->front());
@@ -267,18 +796,57 @@ plaidml_executable* plaidml_compile(  //
         throw std::runtime_error("Missing expected argument attribute");
       }
       auto name = attr.getValue().str();
+      if (constants.count(i)) {
+        const_bufs.buffers[name] = arg.buffer;
+        continue;
+      }
+      exec->value_names[arg.value] = name;
       if (arg.isInput) {
         exec->input_bufs[name] = arg.buffer;
+        exec->input_names.push_back(name);
       } else {
         exec->output_bufs[name] = arg.buffer;
+        exec->output_names.push_back(name);
       }
     }
 
+    // 2. convert MLIR -> stripe, once for each device
+    exec->program = MakeProgram(*ctx, devices, target, [&] { return FromMLIR(*module); }, &const_bufs);
+    IVLOG(1, "After make program");
+    BindArguments(exec.get());
+
     return exec.release();
 #endif
   });
 }
 
+void plaidml_executable_save(  //
+    plaidml_error* err,        //
+    plaidml_executable* exec,  //
+    const char* path) {
+  ffi_wrap_void(err, [&] {  //
+    vertexai::WriteFile(path, SaveExecutable(exec).SerializeAsString(), true);
+  });
+}
+
+plaidml_executable* plaidml_executable_load(  //
+    plaidml_error* err,                       //
+    const char* path,                         //
+    const char* device,                       //
+    size_t ninputs,                           //
+    plaidml_buffer** inputs,                  //
+    size_t noutputs,                          //
+    plaidml_buffer** outputs) {
+  return ffi_wrap<plaidml_executable*>(err, nullptr, [&] {
+    IVLOG(1, "Loading " << path << " with device: " << device);
+    plaidml::exec::proto::SavedExecutable saved;
+    if (!saved.ParseFromString(vertexai::ReadFile(path, true))) {
+      throw std::runtime_error(llvm::formatv("Unable to parse saved executable: {0}", path));
+    }
+    return LoadExecutable(saved, device, ninputs, inputs, noutputs, outputs).release();
+  });
+}
+
 void plaidml_executable_free(  //
     plaidml_error* err,        //
     plaidml_executable* exec) {
@@ -290,17 +858,258 @@ void plaidml_executable_free(  //
 void plaidml_executable_run(  //
     plaidml_error* err,       //
     plaidml_executable* exec) {
+  ffi_wrap_void(err, [&] {  //
+    StartBoundRun(exec).get();
+  });
+}
+
+void plaidml_executable_run_with(  //
+    plaidml_error* err,            //
+    plaidml_executable* exec,      //
+    size_t ninputs,                //
+    plaidml_binding** inputs,      //
+    size_t noutputs,               //
+    plaidml_binding** outputs) {
+  ffi_wrap_void(err, [&] {
+    auto input_bufs = exec->input_bufs;
+    auto output_bufs = exec->output_bufs;
+    Rebind(exec, ninputs, inputs, &input_bufs);
+    Rebind(exec, noutputs, outputs, &output_bufs);
+    StartRun(exec, input_bufs, output_bufs).get();
+  });
+}
+
+plaidml_completion* plaidml_executable_run_async(  //
+    plaidml_error* err,                            //
+    plaidml_executable* exec) {
+  return ffi_wrap<plaidml_completion*>(err, nullptr, [&] {
+    auto future = StartBoundRun(exec);
+    return new plaidml_completion{future.share(), {exec->program}, {}};
+  });
+}
+
+plaidml_completion* plaidml_executable_run_async_with(  //
+    plaidml_error* err,                                 //
+    plaidml_executable* exec,                           //
+    size_t ninputs,                                     //
+    plaidml_binding** inputs,                           //
+    size_t noutputs,                                    //
+    plaidml_binding** outputs) {
+  return ffi_wrap<plaidml_completion*>(err, nullptr, [&] {
+    auto input_bufs = exec->input_bufs;
+    auto output_bufs = exec->output_bufs;
+    Rebind(exec, ninputs, inputs, &input_bufs);
+    Rebind(exec, noutputs, outputs, &output_bufs);
+    auto future = StartRun(exec, input_bufs, output_bufs);
+    return new plaidml_completion{future.share(), {exec->program}, {}};
+  });
+}
+
+void plaidml_executable_enable_stats(  //
+    plaidml_error* err,                //
+    plaidml_executable* exec,          //
+    bool enable) {
   ffi_wrap_void(err, [&] {
-#ifdef PLAIDML_MLIR
-    if (exec->exec) {
-      exec->exec->invoke();
-    } else {
-#endif  // PLAIDML_MLIR
-      auto ctx = GlobalContext::getContext();
-      exec->program->Run(*ctx, exec->input_bufs, exec->output_bufs).get();
-#ifdef PLAIDML_MLIR
+    if (exec->program) {
+      exec->program->EnableStats(enable);
     }
-#endif  // PLAIDML_MLIR
+  });
+}
+
+void plaidml_executable_set_memory_quota(  //
+    plaidml_error* err,                    //
+    plaidml_executable* exec,              //
+    uint64_t bytes) {
+  ffi_wrap_void(err, [&] {
+    if (exec->program) {
+      exec->program->SetMemoryQuota(bytes);
+    }
+  });
+}
+
+plaidml_executable_stats* plaidml_executable_get_stats(  //
+    plaidml_error* err,                                  //
+    plaidml_executable* exec) {
+  return ffi_wrap<plaidml_executable_stats*>(err, nullptr, [&] {
+    auto stats = exec->program ? exec->program->GetStats() : vertexai::tile::ProgramStats{};
+    auto ret = new plaidml_executable_stats{stats.runs, stats.queue_wait_seconds, stats.peak_memory_bytes,
+                                            stats.kernels.size(), new plaidml_kernel_stats[stats.kernels.size()]};
+    for (size_t i = 0; i < stats.kernels.size(); i++) {
+      const auto& kstats = stats.kernels[i];
+      auto samples = new double[kstats.recent_seconds.size()];
+      std::copy(kstats.recent_seconds.begin(), kstats.recent_seconds.end(), samples);
+      ret->kernels[i] = plaidml_kernel_stats{
+          new plaidml_string{kstats.kname},  //
+          kstats.runs,                       //
+          kstats.tot_bytes,                  //
+          kstats.tot_flops,                  //
+          kstats.total_seconds,              //
+          kstats.recent_seconds.size(),      //
+          samples,                           //
+      };
+    }
+    return ret;
+  });
+}
+
+void plaidml_executable_stats_free(  //
+    plaidml_error* err,              //
+    plaidml_executable_stats* stats) {
+  ffi_wrap_void(err, [&] {
+    for (size_t i = 0; i < stats->nkernels; i++) {
+      delete stats->kernels[i].name;
+      delete[] stats->kernels[i].samples;
+    }
+    delete[] stats->kernels;
+    delete stats;
+  });
+}
+
+plaidml_completion* plaidml_executables_submit(  //
+    plaidml_error* err,                          //
+    size_t nexecs,                               //
+    plaidml_executable** execs) {
+  return ffi_wrap<plaidml_completion*>(err, nullptr, [&] {
+    std::vector<boost::future<void>> runs;
+    std::vector<std::shared_ptr<Program>> programs;
+    for (size_t i = 0; i < nexecs; i++) {
+      // Runs wait on the device for the buffers they consume, so there's no
+      // need to wait for one stage to finish before enqueueing the next.
+      runs.emplace_back(StartBoundRun(execs[i]));
+      programs.emplace_back(execs[i]->program);
+    }
+    auto all = boost::when_all(runs.begin(), runs.end());
+    auto future = all.then(boost::launch::sync, [](decltype(all) fut) {
+      for (auto& run : fut.get()) {
+        run.get();
+      }
+    });
+    return new plaidml_completion{future.share(), std::move(programs), {}};
+  });
+}
+
+void plaidml_completion_free(  //
+    plaidml_error* err,        //
+    plaidml_completion* completion) {
+  ffi_wrap_void(err, [&] {  //
+    delete completion;
+  });
+}
+
+bool plaidml_completion_is_done(  //
+    plaidml_error* err,           //
+    plaidml_completion* completion) {
+  return ffi_wrap<bool>(err, false, [&] {  //
+    return completion->future.is_ready();
+  });
+}
+
+void plaidml_completion_wait(  //
+    plaidml_error* err,        //
+    plaidml_completion* completion) {
+  ffi_wrap_void(err, [&] {  //
+    completion->future.get();
+  });
+}
+
+void plaidml_completion_notify(      //
+    plaidml_error* err,              //
+    plaidml_completion* completion,  //
+    plaidml_completion_callback fn,  //
+    void* user_ctx) {
+  ffi_wrap_void(err, [&] {
+    auto invoke = [fn, user_ctx](boost::shared_future<void> fut) {
+      plaidml_error run_err;
+      ffi_wrap_void(&run_err, [&] { fut.get(); });
+      fn(user_ctx, &run_err);
+    };
+    if (completion->future.is_ready()) {
+      invoke(completion->future);
+      return;
+    }
+    completion->notifications.emplace_back(completion->future.then(std::move(invoke)));
+  });
+}
+
+void plaidml_snapshot_save(  //
+    plaidml_error* err,      //
+    const char* path,        //
+    size_t nexecs,           //
+    const char** names,      //
+    plaidml_executable** execs) {
+  ffi_wrap_void(err, [&] {
+    MappedArchiveWriter writer;
+    std::set<std::string> seen;
+    for (size_t i = 0; i < nexecs; i++) {
+      if (!seen.insert(names[i]).second) {
+        throw std::runtime_error(llvm::formatv("Duplicate executable name in snapshot: {0}", names[i]));
+      }
+      // Aligning each entry lets the loader read it straight out of the mapping.
+      writer.Add(kSnapshotPrefix + std::string(names[i]), SaveExecutable(execs[i]).SerializeAsString());
+    }
+    writer.Write(path);
+  });
+}
+
+plaidml_snapshot* plaidml_snapshot_open(  //
+    plaidml_error* err,                   //
+    const char* path) {
+  return ffi_wrap<plaidml_snapshot*>(err, nullptr, [&] {
+    IVLOG(1, "Opening snapshot " << path);
+    if (!MappedArchive::IsMappedArchive(path)) {
+      throw std::runtime_error(llvm::formatv("Not a snapshot: {0}", path));
+    }
+    return new plaidml_snapshot{std::make_shared<MappedArchive>(path)};
+  });
+}
+
+void plaidml_snapshot_free(  //
+    plaidml_error* err,      //
+    plaidml_snapshot* snapshot) {
+  ffi_wrap_void(err, [&] {  //
+    delete snapshot;
+  });
+}
+
+plaidml_strings* plaidml_snapshot_list(  //
+    plaidml_error* err,                  //
+    plaidml_snapshot* snapshot) {
+  return ffi_wrap<plaidml_strings*>(err, nullptr, [&] {
+    std::vector<std::string> names;
+    for (const auto& entry : snapshot->archive->ListEntries()) {
+      if (entry.compare(0, sizeof(kSnapshotPrefix) - 1, kSnapshotPrefix) == 0) {
+        names.push_back(entry.substr(sizeof(kSnapshotPrefix) - 1));
+      }
+    }
+    auto strs = new plaidml_string*[names.size()];
+    for (size_t i = 0; i < names.size(); i++) {
+      strs[i] = new plaidml_string{names[i]};
+    }
+    return new plaidml_strings{names.size(), strs};
+  });
+}
+
+plaidml_executable* plaidml_snapshot_executable(  //
+    plaidml_error* err,                           //
+    plaidml_snapshot* snapshot,                   //
+    const char* name,                             //
+    const char* device,                           //
+    size_t ninputs,                               //
+    plaidml_buffer** inputs,                      //
+    size_t noutputs,                              //
+    plaidml_buffer** outputs) {
+  return ffi_wrap<plaidml_executable*>(err, nullptr, [&] {
+    IVLOG(1, "Loading " << name << " from snapshot with device: " << device);
+    auto key = kSnapshotPrefix + std::string(name);
+    if (!snapshot->archive->Exist(key)) {
+      throw std::runtime_error(llvm::formatv("Executable not found in snapshot: {0}", name));
+    }
+    auto entry = snapshot->archive->Get(key);
+    plaidml::exec::proto::SavedExecutable saved;
+    if (!saved.ParseFromArray(entry.data, entry.size)) {
+      throw std::runtime_error(llvm::formatv("Unable to parse executable from snapshot: {0}", name));
+    }
+    return LoadExecutable(saved, device, ninputs, inputs, noutputs, outputs).release();
   });
 }
 
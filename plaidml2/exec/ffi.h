@@ -29,6 +29,18 @@ plaidml_strings* plaidml_targets_get(  //
 // Executable
 //
 
+// Compiles the program for the device.  The device may instead be a
+// comma-separated list of devices, in which case the program (built with the
+// shapes of one device's share of the batch) is replicated across them: each
+// run splits bound buffers holding one share per device along their leading
+// dimension, and copies other inputs whole to every device.  With
+// PLAIDML_MODEL_PARALLEL=1, the program is instead partitioned into one
+// stage per device, and bound buffers holding several batches are pipelined
+// through the stages as micro-batches.  With PLAIDML_COSCHEDULE=1, each
+// kernel instead runs on whichever device its estimated cost favors (such as
+// the CPU for small kernels and an integrated GPU for large contractions).
+// Outputs of the program which aren't bound are pruned, along with the
+// computations only they depend on; at least one output must be bound.
 plaidml_executable* plaidml_compile(  //
     plaidml_error* err,               //
     plaidml_program* program,         //
@@ -39,6 +51,26 @@ plaidml_executable* plaidml_compile(  //
     size_t noutputs,                  //
     plaidml_binding** outputs);
 
+// Writes the compiled executable, including its device binaries, to a file,
+// from which plaidml_executable_load can reconstruct it without compiling.
+void plaidml_executable_save(  //
+    plaidml_error* err,        //
+    plaidml_executable* exec,  //
+    const char* path);
+
+// Loads an executable written by plaidml_executable_save onto a device of the
+// same kind and configuration as the one it was compiled for.  The buffers are
+// bound positionally, in the order of the program's inputs and outputs at
+// compile time (including any inputs that had buffers at construction).
+plaidml_executable* plaidml_executable_load(  //
+    plaidml_error* err,                       //
+    const char* path,                         //
+    const char* device,                       //
+    size_t ninputs,                           //
+    plaidml_buffer** inputs,                  //
+    size_t noutputs,                          //
+    plaidml_buffer** outputs);
+
 void plaidml_executable_free(  //
     plaidml_error* err,        //
     plaidml_executable* exec);
@@ -47,6 +79,176 @@ void plaidml_executable_run(  //
     plaidml_error* err,       //
     plaidml_executable* exec);
 
+// Starts running the executable without waiting for it to finish.  The
+// returned completion becomes done once the run has finished; until then, the
+// executable's buffers must not be mapped or bound to another run.
+plaidml_completion* plaidml_executable_run_async(  //
+    plaidml_error* err,                            //
+    plaidml_executable* exec);
+
+// Runs the executable with some of its arguments bound to different buffers
+// for this run only.  Each binding must name an input or output of the
+// program, and its buffer must be the same size as the one bound at compile
+// time; arguments that are not rebound use their compile-time buffers.
+void plaidml_executable_run_with(  //
+    plaidml_error* err,            //
+    plaidml_executable* exec,      //
+    size_t ninputs,                //
+    plaidml_binding** inputs,      //
+    size_t noutputs,               //
+    plaidml_binding** outputs);
+
+// The asynchronous form of plaidml_executable_run_with.
+plaidml_completion* plaidml_executable_run_async_with(  //
+    plaidml_error* err,                                 //
+    plaidml_executable* exec,                           //
+    size_t ninputs,                                     //
+    plaidml_binding** inputs,                           //
+    size_t noutputs,                                    //
+    plaidml_binding** outputs);
+
+//
+// Statistics
+//
+
+typedef struct {
+  plaidml_string* name;
+  uint64_t runs;
+  uint64_t bytes;  // Accessed by a single run of the kernel
+  uint64_t flops;  // Performed by a single run of the kernel
+  double total_seconds;
+  // The durations of the most recent runs, oldest first.
+  size_t nsamples;
+  double* samples;
+} plaidml_kernel_stats;
+
+typedef struct {
+  uint64_t runs;
+  // Time runs spent waiting for device memory or a pipeline slot.
+  double queue_wait_seconds;
+  // The most device memory held at once by the executable's runs.
+  uint64_t peak_memory_bytes;
+  size_t nkernels;
+  plaidml_kernel_stats* kernels;
+} plaidml_executable_stats;
+
+// Enables per-kernel statistics, which profiles every kernel the executable
+// runs.  Run counts, queue wait times and memory high-water marks are always
+// collected.
+void plaidml_executable_enable_stats(  //
+    plaidml_error* err,                //
+    plaidml_executable* exec,          //
+    bool enable);
+
+// Limits the temporary device memory which the executable's runs may hold at
+// once, so that many executables can share a device; temporaries are only held
+// while a run is in flight, and runs which would exceed the quota wait for
+// earlier runs to finish.  Zero removes the limit.  Only programs compiled for
+// a device (rather than for the CPU) hold temporaries in device memory.
+void plaidml_executable_set_memory_quota(  //
+    plaidml_error* err,                    //
+    plaidml_executable* exec,              //
+    uint64_t bytes);
+
+// Returns the statistics accumulated since the executable was created.  Not
+// every device supports statistics; those that don't report no runs.
+plaidml_executable_stats* plaidml_executable_get_stats(  //
+    plaidml_error* err,                                  //
+    plaidml_executable* exec);
+
+// Frees the statistics, including their kernel names.
+void plaidml_executable_stats_free(  //
+    plaidml_error* err,              //
+    plaidml_executable_stats* stats);
+
+// Runs a sequence of executables as one chain.  Each run is enqueued without
+// waiting for the previous ones to finish; the device orders runs that share
+// buffers, so an executable may consume buffers produced by the executables
+// before it.  The completion is done once every run has finished, and reports
+// the earliest failing run's error.
+plaidml_completion* plaidml_executables_submit(  //
+    plaidml_error* err,                          //
+    size_t nexecs,                               //
+    plaidml_executable** execs);
+
+//
+// Completion
+//
+
+// Invoked once a run has finished; err describes the run's failure, if any.
+// As with any other call, the callee owns err->msg when err->code is nonzero.
+typedef void (*plaidml_completion_callback)(  //
+    void* user_ctx,                           //
+    plaidml_error* err);
+
+// Frees the completion handle.  If callbacks are still pending, this blocks
+// until the run has finished and they have been invoked.
+void plaidml_completion_free(  //
+    plaidml_error* err,        //
+    plaidml_completion* completion);
+
+bool plaidml_completion_is_done(  //
+    plaidml_error* err,           //
+    plaidml_completion* completion);
+
+// Blocks until the run has finished, reporting its failure, if any, via err.
+void plaidml_completion_wait(  //
+    plaidml_error* err,        //
+    plaidml_completion* completion);
+
+// Arranges for fn to be called once the run has finished -- immediately, on
+// the calling thread, if it has already finished; otherwise on a thread owned
+// by the completion.
+void plaidml_completion_notify(        //
+    plaidml_error* err,                //
+    plaidml_completion* completion,    //
+    plaidml_completion_callback fn,    //
+    void* user_ctx);
+
+//
+// Snapshot
+//
+
+// Writes the executables, keyed by name, to a single file.  Each entry holds
+// what plaidml_executable_save would write: the argument names and the
+// compiled program, including its device binaries and constants.  A process
+// can then open the snapshot and take its executables from it without
+// compiling anything.
+void plaidml_snapshot_save(  //
+    plaidml_error* err,      //
+    const char* path,        //
+    size_t nexecs,           //
+    const char** names,      //
+    plaidml_executable** execs);
+
+// Opens a snapshot by mapping it into memory; entries are only read from disk
+// when their executables are loaded.
+plaidml_snapshot* plaidml_snapshot_open(  //
+    plaidml_error* err,                   //
+    const char* path);
+
+void plaidml_snapshot_free(  //
+    plaidml_error* err,      //
+    plaidml_snapshot* snapshot);
+
+// Returns the names of the snapshot's executables, in sorted order.
+plaidml_strings* plaidml_snapshot_list(  //
+    plaidml_error* err,                  //
+    plaidml_snapshot* snapshot);
+
+// Loads the named executable onto the device, binding the buffers as
+// plaidml_executable_load does.  The executable does not refer to the
+// snapshot, which may be freed once its executables are loaded.
+plaidml_executable* plaidml_snapshot_executable(  //
+    plaidml_error* err,                           //
+    plaidml_snapshot* snapshot,                   //
+    const char* name,                             //
+    const char* device,                           //
+    size_t ninputs,                               //
+    plaidml_buffer** inputs,                      //
+    size_t noutputs,                              //
+    plaidml_buffer** outputs);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
@@ -0,0 +1,305 @@
+// Copyright 2020 Intel Corporation.
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "plaidml2/exec/exec.h"
+
+namespace plaidml {
+namespace serve {
+
+struct BatchQueueOptions {
+  // The most requests run as one batch; clamped to the largest bucket.
+  int64_t max_batch_size = 32;
+  // How long the oldest queued request may wait for others to join its batch.
+  std::chrono::microseconds max_delay{2000};
+  // The most requests which may be queued; submit blocks while the queue is
+  // full, and try_submit fails.
+  size_t max_queued = 1024;
+  // The number of executables which run batches concurrently.  Each compiles
+  // its own copy of the program's buckets.
+  size_t executors = 1;
+  // When nonzero, the latency each request should see from submission to
+  // completion.  Batches are then sized (and dispatched early enough) so that
+  // their measured run times keep the oldest request within the target.
+  std::chrono::microseconds latency_slo{0};
+};
+
+struct BatchQueueStats {
+  uint64_t requests;  // Completed, successfully or not
+  uint64_t batches;
+  std::map<int64_t, double> bucket_seconds;  // Smoothed run time, by bucket
+};
+
+// Serves single-item requests for a BatchedExecutable, coalescing the queued
+// requests into batches.  A batch is dispatched once it reaches the target
+// batch size, or once its oldest request has waited max_delay (or, with a
+// latency SLO, as long as the SLO allows); it then runs on the next idle
+// executable of the pool, and each request's future is fulfilled with its
+// own rows of the outputs.
+//
+// A request holds one row of each non-constant program input, in program
+// order; its response holds one row of each output.
+class BatchQueue {
+ public:
+  using Sample = std::vector<std::vector<char>>;
+  using Clock = std::chrono::steady_clock;
+
+  BatchQueue(exec::BatchedExecutable::ProgramBuilder builder,  //
+             std::vector<int64_t> buckets,                     //
+             BatchQueueOptions options = BatchQueueOptions{})
+      : options_(options) {
+    if (!options_.executors || !options_.max_queued || options_.max_batch_size <= 0) {
+      throw std::runtime_error("A batch queue requires executors, queue space, and a positive batch size");
+    }
+    for (size_t i = 0; i < options_.executors; i++) {
+      pool_.emplace_back(std::make_unique<exec::BatchedExecutable>(builder, buckets));
+    }
+    buckets_ = pool_.front()->buckets();
+    max_batch_ = std::min(options_.max_batch_size, buckets_.back());
+    row_bytes_ = pool_.front()->row_bytes();
+    for (auto& executable : pool_) {
+      workers_.emplace_back([this, executable = executable.get()] { Work(executable); });
+    }
+  }
+
+  // Runs the requests still queued, then stops the workers.
+  ~BatchQueue() {
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      stopping_ = true;
+    }
+    queued_cv_.notify_all();
+    space_cv_.notify_all();
+    for (auto& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  BatchQueue(const BatchQueue&) = delete;
+  BatchQueue& operator=(const BatchQueue&) = delete;
+
+  // Queues a request, blocking while the queue is full.
+  std::future<Sample> submit(Sample request) {
+    CheckRequest(request);
+    std::unique_lock<std::mutex> lock(mu_);
+    space_cv_.wait(lock, [this] { return stopping_ || queue_.size() < options_.max_queued; });
+    if (stopping_) {
+      throw std::runtime_error("The batch queue is shutting down");
+    }
+    return Enqueue(std::move(request));
+  }
+
+  // Queues a request unless the queue is full, in which case the caller
+  // should shed load or retry.
+  bool try_submit(Sample request, std::future<Sample>* response) {
+    CheckRequest(request);
+    std::lock_guard<std::mutex> lock(mu_);
+    if (stopping_ || queue_.size() >= options_.max_queued) {
+      return false;
+    }
+    *response = Enqueue(std::move(request));
+    return true;
+  }
+
+  size_t queued() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return queue_.size();
+  }
+
+  BatchQueueStats stats() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return BatchQueueStats{requests_, batches_, bucket_seconds_};
+  }
+
+ private:
+  struct Request {
+    Sample inputs;
+    std::promise<Sample> response;
+    Clock::time_point queued;
+  };
+
+  void CheckRequest(const Sample& request) const {
+    bool ok = request.size() == row_bytes_.inputs.size();
+    for (size_t i = 0; ok && i < request.size(); i++) {
+      ok = request[i].size() == row_bytes_.inputs[i];
+    }
+    if (!ok) {
+      throw std::runtime_error("A batch queue request must hold one row of each batched input");
+    }
+  }
+
+  // Requires mu_.
+  std::future<Sample> Enqueue(Sample inputs) {
+    queue_.emplace_back(Request{std::move(inputs), std::promise<Sample>{}, Clock::now()});
+    auto future = queue_.back().response.get_future();
+    queued_cv_.notify_one();
+    return future;
+  }
+
+  // The estimated run time of a bucket; zero until it has run.  Requires mu_.
+  std::chrono::microseconds Estimate(int64_t bucket) const {
+    auto it = bucket_seconds_.find(bucket);
+    if (it == bucket_seconds_.end()) {
+      return std::chrono::microseconds{0};
+    }
+    return std::chrono::microseconds{static_cast<int64_t>(it->second * 1e6)};
+  }
+
+  // The batch size to aim for: the largest allowed, or with a latency SLO,
+  // the largest bucket whose run time still fits the oldest request's
+  // remaining budget.  Requires mu_ and a non-empty queue.
+  int64_t TargetBatch(Clock::time_point now) const {
+    if (!options_.latency_slo.count()) {
+      return max_batch_;
+    }
+    auto waited = std::chrono::duration_cast<std::chrono::microseconds>(now - queue_.front().queued);
+    int64_t target = buckets_.front();
+    for (auto bucket : buckets_) {
+      if (bucket > max_batch_) {
+        break;
+      }
+      if (waited + Estimate(bucket) <= options_.latency_slo) {
+        target = bucket;
+      }
+    }
+    return std::min(target, max_batch_);
+  }
+
+  // When the oldest request's batch must be dispatched, whether or not it is
+  // full.  Requires mu_ and a non-empty queue.
+  Clock::time_point Deadline() const {
+    auto delay = options_.max_delay;
+    if (options_.latency_slo.count()) {
+      auto pending = std::min<int64_t>(queue_.size(), max_batch_);
+      auto bucket = *std::lower_bound(buckets_.begin(), buckets_.end(), pending);
+      delay = std::min(delay, std::max(std::chrono::microseconds{0}, options_.latency_slo - Estimate(bucket)));
+    }
+    return queue_.front().queued + delay;
+  }
+
+  void Work(exec::BatchedExecutable* executable) {
+    std::unique_lock<std::mutex> lock(mu_);
+    for (;;) {
+      queued_cv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+      if (queue_.empty()) {
+        return;  // Stopping, with nothing left to run.
+      }
+      auto now = Clock::now();
+      if (!stopping_ && static_cast<int64_t>(queue_.size()) < TargetBatch(now) && now < Deadline()) {
+        queued_cv_.wait_until(lock, Deadline());
+        continue;
+      }
+      auto count = std::min<int64_t>(queue_.size(), TargetBatch(now));
+      std::vector<Request> batch;
+      for (int64_t i = 0; i < count; i++) {
+        batch.emplace_back(std::move(queue_.front()));
+        queue_.pop_front();
+      }
+      space_cv_.notify_all();
+      if (!queue_.empty()) {
+        queued_cv_.notify_one();  // Let an idle worker start on the next batch.
+      }
+      lock.unlock();
+      std::vector<Sample> responses;
+      std::exception_ptr error;
+      auto start = Clock::now();
+      try {
+        responses = Run(executable, batch);
+      } catch (...) {
+        error = std::current_exception();
+      }
+      std::chrono::duration<double> seconds = Clock::now() - start;
+      lock.lock();
+      if (!error) {
+        // Smooth the run time, which steers TargetBatch and Deadline.
+        const double kWeight = 0.2;
+        auto bucket = executable->bucket_for(count);
+        auto it = bucket_seconds_.find(bucket);
+        if (it == bucket_seconds_.end()) {
+          bucket_seconds_[bucket] = seconds.count();
+        } else {
+          it->second += kWeight * (seconds.count() - it->second);
+        }
+      }
+      requests_ += count;
+      batches_++;
+      lock.unlock();
+      for (size_t item = 0; item < batch.size(); item++) {
+        if (error) {
+          batch[item].response.set_exception(error);
+        } else {
+          batch[item].response.set_value(std::move(responses[item]));
+        }
+      }
+      lock.lock();
+    }
+  }
+
+  // Runs a batch, returning each request's response.
+  std::vector<Sample> Run(exec::BatchedExecutable* executable, const std::vector<Request>& batch) {
+    auto count = batch.size();
+    std::vector<std::vector<char>> inputs(row_bytes_.inputs.size());
+    std::vector<const void*> input_ptrs;
+    for (size_t i = 0; i < inputs.size(); i++) {
+      auto bytes = row_bytes_.inputs[i];
+      inputs[i].resize(bytes * count);
+      for (size_t item = 0; item < count; item++) {
+        memcpy(inputs[i].data() + item * bytes, batch[item].inputs[i].data(), bytes);
+      }
+      input_ptrs.push_back(inputs[i].data());
+    }
+    std::vector<std::vector<char>> outputs(row_bytes_.outputs.size());
+    std::vector<void*> output_ptrs;
+    for (size_t i = 0; i < outputs.size(); i++) {
+      outputs[i].resize(row_bytes_.outputs[i] * count);
+      output_ptrs.push_back(outputs[i].data());
+    }
+    executable->run(count, input_ptrs, output_ptrs);
+    std::vector<Sample> responses(count, Sample(outputs.size()));
+    for (size_t item = 0; item < count; item++) {
+      for (size_t i = 0; i < outputs.size(); i++) {
+        auto bytes = row_bytes_.outputs[i];
+        auto src = outputs[i].data() + item * bytes;
+        responses[item][i].assign(src, src + bytes);
+      }
+    }
+    return responses;
+  }
+
+ private:
+  BatchQueueOptions options_;
+  std::vector<std::unique_ptr<exec::BatchedExecutable>> pool_;
+  std::vector<int64_t> buckets_;
+  int64_t max_batch_;
+  exec::BatchedExecutable::RowBytes row_bytes_;
+
+  mutable std::mutex mu_;
+  std::condition_variable queued_cv_;
+  std::condition_variable space_cv_;
+  std::deque<Request> queue_;
+  bool stopping_ = false;
+  uint64_t requests_ = 0;
+  uint64_t batches_ = 0;
+  std::map<int64_t, double> bucket_seconds_;
+
+  std::vector<std::thread> workers_;
+};
+
+}  // namespace serve
+}  // namespace plaidml
@@ -12,8 +12,8 @@ from plaidml2._ffi import ffi
 
 logger = logging.getLogger(__name__)
 
+# Each thread reports errors through its own plaidml_error.
 _TLS = threading.local()
-_TLS.err = ffi.new('plaidml_error*')
 
 _LIBNAME = 'plaidml2'
 if os.getenv('PLAIDML_MLIR') == '1':
@@ -60,10 +60,17 @@ class Error(Exception):
 
 
 def ffi_call(func, *args):
-    """Calls ffi function and propagates foreign errors."""
-    ret = func(_TLS.err, *args)
-    if _TLS.err.code:
-        raise Error(_TLS.err)
+    """Calls ffi function and propagates foreign errors.
+
+    The library is loaded in cffi's ABI mode, so the GIL is released for the
+    duration of the call: long-running calls (compiling, running, waiting)
+    don't hold up the interpreter's other threads."""
+    err = getattr(_TLS, 'err', None)
+    if err is None:
+        err = _TLS.err = ffi.new('plaidml_error*')
+    ret = func(err, *args)
+    if err.code:
+        raise Error(err)
     return ret
 
 
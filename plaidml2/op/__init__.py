@@ -38,6 +38,10 @@ def argmax(x, axis=-1):
     return op('argmax', [x, axis]).as_tensor()
 
 
+def batch_norm_inference(x, mean, variance, gamma=None, beta=None, epsilon=1e-3, axis=-1):
+    return op('batch_norm_inference', [x, mean, variance, gamma, beta, epsilon, axis]).as_tensor()
+
+
 def binary_crossentropy(targets, preds, epsilon):
     return op('binary_crossentropy', [targets, preds, epsilon]).as_tensor()
 
@@ -68,6 +72,8 @@ def convolution(
         autogroup_mode,
         deriv_mode,
         result_shape,
+        bias=None,
+        activation='none',
 ):
     return op("convolution", [
         inputs,
@@ -87,6 +93,8 @@ def convolution(
         autogroup_mode,
         deriv_mode,
         result_shape,
+        bias,
+        activation,
     ]).as_tensor()
 
 
@@ -98,6 +106,10 @@ def cumsum(x, axis):
     return op('cumsum', [x, axis]).as_tensor()
 
 
+def dequantize(x, scale, zero_point=None, axis=-1):
+    return op('dequantize', [x, scale, zero_point, axis]).as_tensor()
+
+
 def dot(x, y):
     return op('dot', [x, y]).as_tensor()
 
@@ -122,6 +134,10 @@ def image_resize(x, factors, interp, layout):
     return op('image_resize', [x, factors, interp, layout]).as_tensor()
 
 
+def layer_norm(x, axis=-1, gamma=None, beta=None, epsilon=1e-3):
+    return op('layer_norm', [x, axis, gamma, beta, epsilon]).as_tensor()
+
+
 def max(x, axis=None, keepdims=False):
     return op('max', [x, axis, keepdims]).as_tensor()
 
@@ -162,6 +178,37 @@ def softmax(x, axis=None):
     return op('softmax', [x, axis]).as_tensor()
 
 
+def sparse_dot(x, values, indices):
+    """Multiplies x by a sparse matrix in the blocked ELLPACK format.
+
+    values[n, j, b] and indices[n, j] describe the j-th nonzero block of B rows
+    in column n; see pack_blocked_sparse.
+    """
+    return op('sparse_dot', [x, values, indices]).as_tensor()
+
+
+def pack_blocked_sparse(w, block_size=1):
+    """Packs a dense K x N numpy matrix for sparse_dot.
+
+    Returns the (values, indices) numpy arrays of its nonzero blocks of
+    block_size rows, padding each column with zero blocks to the largest
+    number of nonzero blocks in any column.
+    """
+    import numpy as np
+    rows, cols = w.shape
+    if rows % block_size:
+        raise ValueError('block_size must divide the rows of w')
+    blocks = w.reshape(rows // block_size, block_size, cols)
+    nonzero = [np.flatnonzero(np.any(blocks[:, :, n] != 0, axis=1)) for n in range(cols)]
+    width = max(1, max(len(nz) for nz in nonzero))
+    values = np.zeros((cols, width, block_size), dtype=w.dtype)
+    indices = np.zeros((cols, width), dtype=np.int32)
+    for n, nz in enumerate(nonzero):
+        values[n, :len(nz), :] = blocks[nz, :, n]
+        indices[n, :len(nz)] = nz
+    return values, indices
+
+
 def reshape(x, shape):
     return op('reshape', [x, shape]).as_tensor()
 
@@ -170,6 +217,59 @@ def prod(x, axis=None, keepdims=False):
     return op('prod', [x, axis, keepdims]).as_tensor()
 
 
+def quantize(x, scale, zero_point=None, axis=-1, dtype='int8'):
+    return op('quantize', [x, scale, zero_point, axis, dtype]).as_tensor()
+
+
+def quantized_convolution(
+        inputs,
+        filters,
+        strides,
+        dilations,
+        data_dilations,
+        filter_shape,
+        groups,
+        autopad_mode,
+        manual_padding,
+        input_layout,
+        filter_layout,
+        group_layout,
+        name,
+        autogroup_mode,
+        inputs_zero_point=None,
+        filters_zero_point=None,
+):
+    return op("quantized_convolution", [
+        inputs,
+        filters,
+        strides,
+        dilations,
+        data_dilations,
+        filter_shape,
+        groups,
+        autopad_mode,
+        manual_padding,
+        input_layout,
+        filter_layout,
+        group_layout,
+        False,
+        name,
+        autogroup_mode,
+        'none',
+        [],
+        inputs_zero_point,
+        filters_zero_point,
+    ]).as_tensor()
+
+
+def quantized_dot(x, y, x_zero_point=None, y_zero_point=None):
+    return op('quantized_dot', [x, y, x_zero_point, y_zero_point]).as_tensor()
+
+
+def requantize(x, scale, zero_point=None, axis=-1, dtype='int8'):
+    return op('requantize', [x, scale, zero_point, axis, dtype]).as_tensor()
+
+
 def pool(
         x,
         pool_mode,
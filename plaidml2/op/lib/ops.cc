@@ -3,6 +3,7 @@
 #include "plaidml2/op/lib/ops.h"
 
 #include <algorithm>
+#include <iterator>
 #include <set>
 #include <utility>
 #include <vector>
@@ -21,18 +22,21 @@ Value abs(const Value&);
 Value all(const Value&);
 Value any(const Value&);
 Value argmax(const Value&);
+Value batch_norm_inference(const Value&);
 Value binary_crossentropy(const Value&);
 Value clip(const Value&);
 Value concatenate(const Value&);
 Value convolution(const Value&);
 Value cumprod(const Value&);
 Value cumsum(const Value&);
+Value dequantize(const Value&);
 Value dot(const Value&);
 Value elu(const Value&);
 Value expand_dims(const Value&);
 Value flip(const Value&);
 Value hard_sigmoid(const Value&);
 Value image_resize(const Value&);
+Value layer_norm(const Value&);
 Value max(const Value&);
 Value maximum(const Value&);
 Value mean(const Value&);
@@ -40,12 +44,17 @@ Value min(const Value&);
 Value minimum(const Value&);
 Value pool(const Value&);
 Value prod(const Value&);
+Value quantize(const Value&);
+Value quantized_convolution(const Value&);
+Value quantized_dot(const Value&);
 Value relu(const Value&);
 Value repeat(const Value&);
+Value requantize(const Value&);
 Value reshape(const Value&);
 Value sigmoid(const Value&);
 Value slice(const Value&);
 Value softmax(const Value&);
+Value sparse_dot(const Value&);
 Value spatial_padding(const Value&);
 Value square(const Value&);
 Value squeeze(const Value&);
@@ -164,6 +173,9 @@ enum class GroupLayout {
   IN_K       // Group included in the output channels dimensiono
 };
 
+// The activation applied to the output of a fused convolution
+enum class FusedActivation { NONE, RELU, RELU6, SIGMOID, HARD_SIGMOID };
+
 enum class InterpolationMode { NEAREST, BILINEAR };
 
 enum class PoolMode : char { AVG = 'A', MAX = '>', MIN = '<', SUM = '+' };
@@ -248,6 +260,25 @@ ConvDerivMode conv_deriv_mode_from_str(const std::string& s) {
   throw std::runtime_error(str(boost::format("Unable to parse string '%1%' as a convolution derivative mode") % s));
 }
 
+FusedActivation fused_activation_from_str(const std::string& s) {
+  if (s.empty() || s == "none") {
+    return FusedActivation::NONE;
+  }
+  if (s == "relu") {
+    return FusedActivation::RELU;
+  }
+  if (s == "relu6") {
+    return FusedActivation::RELU6;
+  }
+  if (s == "sigmoid") {
+    return FusedActivation::SIGMOID;
+  }
+  if (s == "hard_sigmoid") {
+    return FusedActivation::HARD_SIGMOID;
+  }
+  throw std::runtime_error(str(boost::format("Unable to parse string '%1%' as a fused activation") % s));
+}
+
 GroupLayout group_layout_from_str(const std::string& s) {
   if (s == "none") {
     return GroupLayout::NONE;
@@ -523,6 +554,289 @@ std::vector<int64_t>* extend_manual_padding(std::vector<int64_t>* pads, size_t r
   return pads;
 }
 
+// Applies the bias and activation of a fused convolution to its result. These
+// are elementwise operations whose only input besides the bias is the result of
+// the convolution's contraction, so they are fused into its output loop rather
+// than materializing the unbiased or unactivated result.
+Tensor conv_epilogue(            //
+    const Tensor& O,             //
+    const Value& bias,           //
+    FusedActivation activation,  //
+    TensorLayout input_layout,   //
+    size_t spatial_rank) {
+  auto R = O;
+  if (!bias.is_none()) {
+    auto B = bias.as_tensor();
+    if (B.shape().ndims() != 1) {
+      throw std::runtime_error(
+          str(boost::format("Convolution bias must have 1 dimension (received %1%)") % B.shape().ndims()));
+    }
+    if (input_layout == TensorLayout::NCX) {
+      // Broadcast the bias across the spatial dimensions that follow channels
+      TensorDim CO;
+      B.bind_dims(CO);
+      std::vector<TensorDim> B_dims{CO};
+      for (size_t i = 0; i < spatial_rank; ++i) {
+        B_dims.emplace_back(1);
+      }
+      B = reshape(B, B_dims);
+    }
+    R = R + B;
+  }
+  switch (activation) {
+    case FusedActivation::NONE:
+      return R;
+    case FusedActivation::RELU:
+      return select(R < 0.0, Tensor(0.0), R);
+    case FusedActivation::RELU6:
+      R = select(R < 0.0, Tensor(0.0), R);
+      return select(R < 6.0, R, Tensor(6.0));
+    case FusedActivation::SIGMOID:
+      return 1.0 / (1.0 + exp(-R));
+    case FusedActivation::HARD_SIGMOID:
+      // Uses the Keras slope of 0.2
+      return select(R < -2.5, Tensor(0.0), select(R > 2.5, Tensor(1.0), 0.2 * R + 0.5));
+  }
+  throw std::runtime_error("Unrecognized fused activation");
+}
+
+// Builds a constant matrix from its rows. The entries are selected by element
+// index rather than read from a buffer so that the matrix can be part of any
+// program (and folded away along with the tensors it transforms).
+Tensor constant_matrix(const std::vector<std::vector<double>>& rows) {
+  auto num_cols = static_cast<int64_t>(rows.front().size());
+  Tensor One(1);
+  auto T = TensorOutput(TensorDim(static_cast<int64_t>(rows.size())), TensorDim(num_cols));
+  TensorIndex i, j;
+  T(i, j) = One();
+  auto flat_index = index(T, 0) * num_cols + index(T, 1);
+  Tensor M = Tensor{0.0} * T;
+  for (size_t r = 0; r < rows.size(); ++r) {
+    for (size_t c = 0; c < rows[r].size(); ++c) {
+      if (rows[r][c] != 0) {
+        M = select(flat_index == static_cast<int64_t>(r * num_cols + c), Tensor{rows[r][c]}, M);
+      }
+    }
+  }
+  return M;
+}
+
+// Returns the output tile size to use for a Winograd F(m x m, 3 x 3)
+// convolution, or 0 if the convolution is unsuited to Winograd.
+int64_t winograd_tile_size(  //
+    const Tensor& I,         //
+    const Tensor& F,         //
+    TensorLayout input_layout,
+    TensorLayout filter_layout,
+    const std::vector<int64_t>& strides,
+    const std::vector<int64_t>& dilations,
+    const std::vector<int64_t>& data_dilations,
+    const std::vector<int64_t>& filter_shape) {
+  if (strides.size() != 2) {
+    return 0;
+  }
+  for (size_t i = 0; i < 2; ++i) {
+    if (strides[i] != 1 || dilations[i] != 1 || data_dilations[i] != 1) {
+      return 0;
+    }
+    if (filter_shape.size() && filter_shape[i] != 3) {
+      return 0;
+    }
+  }
+  auto F_dims = F.shape().int_dims();
+  size_t F_spatial = (filter_layout == TensorLayout::KCX) ? 2 : 0;
+  if (F_dims.size() != 4 || F_dims[F_spatial] != 3 || F_dims[F_spatial + 1] != 3) {
+    return 0;
+  }
+  // F(4x4, 3x3) needs fewer multiplies than F(2x2, 3x3) but wastes more of its
+  // last tiles on small images and loses more precision; keep it to larger ones.
+  auto I_dims = I.shape().int_dims();
+  size_t I_spatial = (input_layout == TensorLayout::NCX) ? 2 : 1;
+  if (I_dims.size() == 4 && I_dims[I_spatial] >= 16 && I_dims[I_spatial + 1] >= 16) {
+    return 4;
+  }
+  return 2;
+}
+
+// Computes a 2D, 3x3, unit-stride convolution with the Winograd minimal
+// filtering algorithm F(m x m, 3 x 3), i.e. O = A^T [(G F G^T) . (B^T I B)] A
+// over m x m output tiles. The filter transform depends only on the filter, so
+// it is computed once at compile time when the filter is constant.
+Tensor winograd_convolution(  //
+    const Tensor& I,          //
+    const Tensor& F,          //
+    int64_t m,                //
+    TensorLayout input_layout,
+    TensorLayout filter_layout,
+    const std::vector<TensorDim>& pad_before,
+    const std::vector<TensorDim>& O_spatial_dims,
+    const std::string& name) {
+  Tensor AT, BT, G;
+  if (m == 2) {
+    AT = constant_matrix({{1, 1, 1, 0}, {0, 1, -1, -1}});
+    BT = constant_matrix({{1, 0, -1, 0}, {0, 1, 1, 0}, {0, -1, 1, 0}, {0, 1, 0, -1}});
+    G = constant_matrix({{1, 0, 0}, {0.5, 0.5, 0.5}, {0.5, -0.5, 0.5}, {0, 0, 1}});
+  } else {
+    AT = constant_matrix({
+        {1, 1, 1, 1, 1, 0},
+        {0, 1, -1, 2, -2, 0},
+        {0, 1, 1, 4, 4, 0},
+        {0, 1, -1, 8, -8, 1},
+    });
+    BT = constant_matrix({
+        {4, 0, -5, 0, 1, 0},
+        {0, -4, -4, 1, 1, 0},
+        {0, 4, -4, -1, 1, 0},
+        {0, -2, -1, 2, 1, 0},
+        {0, 2, -1, -2, 1, 0},
+        {0, 4, 0, -5, 0, 1},
+    });
+    G = constant_matrix({
+        {1.0 / 4, 0, 0},
+        {-1.0 / 6, -1.0 / 6, -1.0 / 6},
+        {-1.0 / 6, 1.0 / 6, -1.0 / 6},
+        {1.0 / 24, 1.0 / 12, 1.0 / 6},
+        {1.0 / 24, -1.0 / 12, 1.0 / 6},
+        {0, 0, 1},
+    });
+  }
+
+  TensorDim N, X0, X1, CI, CO, S(3), BI(m + 2), BO(m);
+  if (input_layout == TensorLayout::NCX) {
+    I.bind_dims(N, CI, X0, X1);
+  } else {
+    I.bind_dims(N, X0, X1, CI);
+  }
+  if (filter_layout == TensorLayout::KCX) {
+    F.bind_dims(CO, CI, S, S);
+  } else {
+    F.bind_dims(S, S, CI, CO);
+  }
+  auto XB0 = (O_spatial_dims[0] + m - 1) / m;
+  auto XB1 = (O_spatial_dims[1] + m - 1) / m;
+
+  TensorIndex n, i, j, k, x0, x1, ci, co;
+  auto I_at = [&](const TensorIndex& a, const TensorIndex& b) {
+    if (input_layout == TensorLayout::NCX) {
+      return I(n, ci, a, b);
+    }
+    return I(n, a, b, ci);
+  };
+  auto F_at = [&](const TensorIndex& a, const TensorIndex& b) {
+    if (filter_layout == TensorLayout::KCX) {
+      return F(co, ci, a, b);
+    }
+    return F(a, b, ci, co);
+  };
+
+  // Filter transform: U = G F G^T
+  auto U1 = TensorOutput(BI, S, CI, CO);
+  U1(i, j, ci, co) += G(i, k) * F_at(k, j);
+  auto U = TensorOutput(BI, BI, CI, CO);
+  U(i, j, ci, co) += U1(i, k, ci, co) * G(j, k);
+  // Input transform of each tile: V = B^T I B. Reads outside of I are skipped,
+  // which pads with zeros.
+  auto V1 = TensorOutput(N, BI, BI, XB0, XB1, CI);
+  V1(n, i, j, x0, x1, ci) += BT(i, k) * I_at(m * x0 + k - pad_before[0], m * x1 + j - pad_before[1]);
+  auto V = TensorOutput(N, BI, BI, XB0, XB1, CI);
+  V(n, i, j, x0, x1, ci) += V1(n, i, k, x0, x1, ci) * BT(j, k);
+  // The elementwise product, summed over input channels
+  auto M = TensorOutput(N, BI, BI, XB0, XB1, CO);
+  M(n, i, j, x0, x1, co) += V(n, i, j, x0, x1, ci) * U(i, j, ci, co);
+  // Output transform of each tile: O = A^T M A
+  auto O1 = TensorOutput(N, BO, BI, XB0, XB1, CO);
+  O1(n, i, j, x0, x1, co) += AT(i, k) * M(n, k, j, x0, x1, co);
+  if (input_layout == TensorLayout::NCX) {
+    Tensor O{name, {N, CO, O_spatial_dims[0], O_spatial_dims[1]}};
+    O(n, co, m * x0 + i, m * x1 + j) += O1(n, i, k, x0, x1, co) * AT(j, k);
+    O.no_reduce();
+    return O;
+  }
+  Tensor O{name, {N, O_spatial_dims[0], O_spatial_dims[1], CO}};
+  O(n, m * x0 + i, m * x1 + j, co) += O1(n, i, k, x0, x1, co) * AT(j, k);
+  O.no_reduce();
+  return O;
+}
+
+// Reads a quantization parameter, which is either a scalar or a 1D tensor of
+// per-channel values along the given axis of I; the latter is reshaped to
+// broadcast across the dimensions after the channels.
+Tensor quant_param(const Value& param, const Tensor& I, size_t axis) {
+  if (!param.is_tensor()) {
+    return param.as_tensor();
+  }
+  auto P = param.as_tensor();
+  auto ndims = I.shape().ndims();
+  if (P.shape().ndims() == 0 || axis == ndims - 1) {
+    return P;
+  }
+  if (P.shape().ndims() != 1) {
+    throw std::runtime_error(
+        str(boost::format("Per-channel quantization parameters must have 1 dimension (received %1%)") %
+            P.shape().ndims()));
+  }
+  TensorDim C;
+  P.bind_dims(C);
+  std::vector<TensorDim> dims{C};
+  for (size_t i = axis + 1; i < ndims; ++i) {
+    dims.emplace_back(1);
+  }
+  return reshape(P, dims);
+}
+
+// Rounds the real values X to the nearest step of the quantized type,
+// offsets them by the zero point, and saturates them to the type's range.
+Tensor saturate_quantized(const Tensor& X, const Value& zero_point, const std::string& dtype) {
+  auto Q = Call("round", X);
+  if (!zero_point.is_none()) {
+    Q = Q + zero_point.as_tensor();
+  }
+  if (dtype == "int8") {
+    Q = select(Q < -128, Tensor(-128), select(Q > 127, Tensor(127), Q));
+    return as_int(Q, 8);
+  }
+  if (dtype == "uint8") {
+    Q = select(Q < 0, Tensor(0), select(Q > 255, Tensor(255), Q));
+    return as_uint(Q, 8);
+  }
+  if (dtype == "int32") {
+    return as_int(Q, 32);
+  }
+  throw std::runtime_error(str(boost::format("Unable to parse string '%1%' as a quantized dtype") % dtype));
+}
+
+// Widens quantized values to int32 with their zero point removed, so that
+// contractions over them accumulate in int32.
+Tensor widen_quantized(const Tensor& Q, const Value& zero_point) {
+  auto W = as_int(Q, 32);
+  if (zero_point.is_none()) {
+    return W;
+  }
+  return W - zero_point.as_tensor();
+}
+
+// The gradient of a softmax along Axis.  OverrideGrads takes a plain function,
+// so each axis has an instance of its own.
+template <size_t Axis>
+std::vector<Tensor> softmax_deriv(const Tensor& Y, const Tensor& DY, const std::vector<Tensor>& X) {
+  auto ndims = Y.shape().ndims();
+  std::vector<TensorDim> Y_dims(ndims);
+  std::vector<TensorIndex> Y_idxs(ndims);
+  Y.bind_dims(Y_dims);
+  std::vector<TensorDim> R_dims = Y_dims;
+  std::vector<TensorIndex> R_idxs = Y_idxs;
+  R_dims[Axis] = TensorDim{1};
+  R_idxs[Axis] = TensorIndex{0};
+
+  auto YdY = Y * DY;
+  auto T = TensorOutput(R_dims);
+  T(R_idxs) += YdY(Y_idxs);
+  return std::vector<Tensor>{YdY - T * Y};
+}
+
+const TensorDeriv softmax_derivs[] = {softmax_deriv<0>, softmax_deriv<1>, softmax_deriv<2>, softmax_deriv<3>,
+                                      softmax_deriv<4>, softmax_deriv<5>, softmax_deriv<6>, softmax_deriv<7>};
+
 }  // namespace
 
 Value abs(const Value& value) {
@@ -614,6 +928,46 @@ Value argmax(const Value& value) {
   return Value{O};
 }
 
+Value batch_norm_inference(const Value& value) {
+  // Normalizes I with precomputed statistics along the channel axis. The
+  // per-channel scale and shift are folded first, so the full-size tensor is
+  // touched by a single multiply-add.
+  IVLOG(1, "batch_norm_inference");
+  auto args = value.as_tuple();
+  if (args.size() != 7) {
+    throw std::runtime_error("batch_norm_inference expects 7 arguments");
+  }
+  auto I = args[0].as_tensor();
+  auto Mean = args[1].as_tensor();
+  auto Variance = args[2].as_tensor();
+  auto gamma = args[3];
+  auto beta = args[4];
+  auto epsilon = args[5].as_float();
+  auto ndims = I.shape().ndims();
+  auto axis = normalize_axis(args[6].as_int(), ndims, "batch_norm_inference");
+
+  auto Scale = 1.0 / sqrt(Variance + epsilon);
+  if (!gamma.is_none()) {
+    Scale = Scale * gamma.as_tensor();
+  }
+  auto Shift = -Mean * Scale;
+  if (!beta.is_none()) {
+    Shift = Shift + beta.as_tensor();
+  }
+  if (axis != ndims - 1) {
+    // Broadcast the per-channel values across the dimensions after the channels
+    TensorDim C;
+    Mean.bind_dims(C);
+    std::vector<TensorDim> dims{C};
+    for (size_t i = axis + 1; i < ndims; ++i) {
+      dims.emplace_back(1);
+    }
+    Scale = reshape(Scale, dims);
+    Shift = reshape(Shift, dims);
+  }
+  return Value{I * Scale + Shift};
+}
+
 Value binary_crossentropy(const Value& value) {
   IVLOG(1, "binary_crossentropy")
   auto args = value.as_tuple();
@@ -757,11 +1111,13 @@ Value convolution(const Value& value) {
   // 14. Autogrouping (? Unclear if we really need this)
   // 15. Deriv Mode (DATA is equivalent to transposed conv)
   // 16. Result Shape (a.k.a. output shape, used for transposed/derivative convs)
+  // 17. Bias (optional; None or a tensor of the output channels)
+  // 18. Fused Activation (optional; none, relu, relu6, sigmoid, or hard_sigmoid)
 
   // Read Arguments
   auto args = value.as_tuple();
-  if (args.size() != 17) {
-    throw std::runtime_error("Convolution op expects 17 arguments");
+  if (args.size() != 17 && args.size() != 19) {
+    throw std::runtime_error("Convolution op expects 17 or 19 arguments");
   }
   auto I_or_O = args[0].as_tensor();  // O if deriv_mode is DATA, else I
   auto F_or_O = args[1].as_tensor();  // O if deriv_mode is FILTER, else F
@@ -776,11 +1132,13 @@ Value convolution(const Value& value) {
   auto input_layout = tensor_layout_from_str(args[9].as_str());
   auto filter_layout = tensor_layout_from_str(args[10].as_str());
   auto group_layout = group_layout_from_str(args[11].as_str());
-  // auto winograd_allowed = args[12].as_bool();  // TODO: Implement Winograd
+  auto winograd_allowed = args[12].as_bool();
   auto name = args[13].as_str();
   auto autogroup_mode = autogroup_mode_from_str(args[14].as_str());
   auto deriv_mode = conv_deriv_mode_from_str(args[15].as_str());
   auto result_shape = args[16].as_int_tuple();
+  auto bias = (args.size() > 17) ? args[17] : Value{};
+  auto activation = (args.size() > 18) ? fused_activation_from_str(args[18].as_str()) : FusedActivation::NONE;
 
   Tensor I;       // Inputs (i.e. Data) tensor
   Tensor F;       // Filters (i.e. Weights i.e. Kernel) tensor
@@ -854,6 +1212,9 @@ Value convolution(const Value& value) {
   if (!is_filter_layout_with_separate_groups(filter_layout) && group_layout == GroupLayout::SEPARATE) {
     throw std::runtime_error("Filter_layout lacks separate groups but group_layout is SEPARATE");
   }
+  if (deriv_mode != ConvDerivMode::NONE && (!bias.is_none() || activation != FusedActivation::NONE)) {
+    throw std::runtime_error("Bias and fused activations are only supported on forward convolutions");
+  }
   if (result_shape.size() == 0) {
     if (deriv_mode != ConvDerivMode::NONE) {
       throw std::runtime_error("Transposed/gradient convolutions require specifying the result_shape");
@@ -1085,6 +1446,72 @@ Value convolution(const Value& value) {
     O_spatial_dims.emplace_back(local_output_size);
   }
 
+  // Use Winograd for the forward convolutions it suits, if the caller allows it
+  if (winograd_allowed && deriv_mode == ConvDerivMode::NONE && group_layout == GroupLayout::NONE &&
+      (filter_layout == TensorLayout::XCK || filter_layout == TensorLayout::KCX)) {
+    auto m = winograd_tile_size(I, F, input_layout, filter_layout, strides, dilations, data_dilations, filter_shape);
+    if (m) {
+      IVLOG(2, "convolution: using Winograd F(" << m << "x" << m << ", 3x3)");
+      O = winograd_convolution(I, F, m, input_layout, filter_layout, pad_before, O_spatial_dims, name);
+      return Value{conv_epilogue(O, bias, activation, input_layout, spatial_rank)};
+    }
+  }
+
+  // A grouped convolution is depthwise when each group has one input channel
+  bool depthwise = false;
+  if (deriv_mode == ConvDerivMode::NONE && group_layout != GroupLayout::NONE) {
+    if (autogroup_mode == AutogroupMode::DEPTHWISE) {
+      depthwise = true;
+    } else if (autogroup_mode == AutogroupMode::EXPLICIT) {
+      auto I_shape = I.shape().int_dims();
+      auto CI_size = I_shape[(input_layout == TensorLayout::NCX) ? 1 : I_shape.size() - 1];
+      depthwise = (CI_size == groups);
+    }
+  }
+
+  // Other grouped convolutions split the group out of the channel dimensions,
+  // so each group is a batch of an ordinary convolution rather than a slice of
+  // the channels selected by constraints on the contraction.
+  if (deriv_mode == ConvDerivMode::NONE && autogroup_mode == AutogroupMode::EXPLICIT && !depthwise &&
+      (group_layout == GroupLayout::IN_C || group_layout == GroupLayout::IN_K) &&
+      input_layout == TensorLayout::NXC && filter_layout == TensorLayout::XCK) {
+    IVLOG(2, "convolution: batching " << groups << " groups");
+    std::vector<TensorDim> IG_dims{N};
+    std::vector<TensorDim> FG_dims;
+    std::vector<TensorDim> OG_dims{N};
+    std::vector<TensorIndex> IG_idxs{n};
+    std::vector<TensorIndex> FG_idxs;
+    std::vector<TensorIndex> OG_idxs{n};
+    for (size_t i = 0; i < spatial_rank; ++i) {
+      IG_dims.push_back(X[i]);
+      FG_dims.push_back(K[i]);
+      OG_dims.push_back(O_spatial_dims[i]);
+      IG_idxs.emplace_back((strides[i] * x[i] + dilations[i] * k[i] - pad_before[i]) / data_dilations[i]);
+      FG_idxs.push_back(k[i]);
+      OG_idxs.push_back(x[i]);
+    }
+    IG_dims.insert(IG_dims.end(), {G, CI / G});
+    IG_idxs.insert(IG_idxs.end(), {g, ci});
+    if (group_layout == GroupLayout::IN_C) {
+      FG_dims.insert(FG_dims.end(), {G, CI / G, CO / G});
+      FG_idxs.insert(FG_idxs.end(), {g, ci, co});
+    } else {
+      FG_dims.insert(FG_dims.end(), {CI / G, G, CO / G});
+      FG_idxs.insert(FG_idxs.end(), {ci, g, co});
+    }
+    OG_dims.insert(OG_dims.end(), {G, CO / G});
+    OG_idxs.insert(OG_idxs.end(), {g, co});
+    auto IG = reshape(I, IG_dims);
+    auto FG = reshape(F, FG_dims);
+    auto OG = TensorOutput(OG_dims);
+    OG(OG_idxs) += IG(IG_idxs) * FG(FG_idxs);
+    O_dims = {N};
+    O_dims.insert(O_dims.end(), O_spatial_dims.begin(), O_spatial_dims.end());
+    O_dims.push_back(CO);
+    O = reshape(OG, O_dims);
+    return Value{conv_epilogue(O, bias, activation, input_layout, spatial_rank)};
+  }
+
   // Now set up the dimensions of the result to be returned
   switch (deriv_mode) {
     case ConvDerivMode::NONE:
@@ -1167,6 +1594,66 @@ Value convolution(const Value& value) {
       throw std::runtime_error("Invalid deriv_mode");
   }
 
+  // Depthwise convolutions index the channel directly rather than through a
+  // group index and a unit-range input channel index. The channel is then a
+  // parallel index of the contraction, which can be vectorized over, and the
+  // only reduction is over the filter window.
+  if (depthwise) {
+    IVLOG(2, "convolution: depthwise");
+    TensorIndex c("c");
+    TensorIndex m("m");
+    // The channel multiplier, i.e. the number of output channels per group
+    TensorDim M = CO / G;
+    std::vector<TensorIndex> DI_idxs{n};
+    std::vector<TensorIndex> DO_idxs{n};
+    std::vector<TensorIndex> DF_spatial_idxs;
+    std::vector<TensorIndex> DF_channel_idxs;
+    for (size_t i = 0; i < spatial_rank; ++i) {
+      DI_idxs.emplace_back((strides[i] * x[i] + dilations[i] * k[i] - pad_before[i]) / data_dilations[i]);
+      DO_idxs.push_back(x[i]);
+      DF_spatial_idxs.push_back(k[i]);
+    }
+    auto o_channel = M * c + m;
+    if (input_layout == TensorLayout::NCX) {
+      DI_idxs.insert(DI_idxs.begin() + 1, c);
+      DO_idxs.insert(DO_idxs.begin() + 1, o_channel);
+    } else {
+      DI_idxs.push_back(c);
+      DO_idxs.push_back(o_channel);
+    }
+    // The filter's channel indexes in XCK/XGCK order
+    switch (group_layout) {
+      case GroupLayout::IN_C:
+        DF_channel_idxs = {c, m};
+        break;
+      case GroupLayout::IN_K:
+        DF_channel_idxs = {TensorIndex(0), o_channel};
+        break;
+      case GroupLayout::SEPARATE:
+        DF_channel_idxs = {c, TensorIndex(0), m};
+        break;
+      default:
+        throw std::runtime_error("Unrecognized group layout");
+    }
+    std::vector<TensorIndex> DF_idxs;
+    if (filter_layout == TensorLayout::XCK || filter_layout == TensorLayout::XGCK) {
+      DF_idxs = DF_spatial_idxs;
+      DF_idxs.insert(DF_idxs.end(), DF_channel_idxs.begin(), DF_channel_idxs.end());
+    } else {
+      // KCX/GKCX put the channels first, with the group (if any) outermost and
+      // the output channel before the input channel
+      if (group_layout == GroupLayout::SEPARATE) {
+        DF_idxs = {c, m, TensorIndex(0)};
+      } else {
+        DF_idxs = {DF_channel_idxs[1], DF_channel_idxs[0]};
+      }
+      DF_idxs.insert(DF_idxs.end(), DF_spatial_idxs.begin(), DF_spatial_idxs.end());
+    }
+    O(DO_idxs) += I(DI_idxs) * F(DF_idxs);
+    O.add_constraints({m < M});
+    return Value{conv_epilogue(O, bias, activation, input_layout, spatial_rank)};
+  }
+
   // Set up index formulas
   // Input data indexes
   switch (input_layout) {
@@ -1280,7 +1767,7 @@ Value convolution(const Value& value) {
     case ConvDerivMode::NONE:
       O(O_idxs) += I(I_idxs) * F(F_idxs);
       O.add_constraints(constraints);
-      return Value{O};
+      return Value{conv_epilogue(O, bias, activation, input_layout, spatial_rank)};
     case ConvDerivMode::DATA:
       I(I_idxs) += O(O_idxs) * F(F_idxs);
       I.add_constraints(constraints);
@@ -1342,6 +1829,23 @@ Value cumsum(const Value& value) {
   return Value{O};
 }
 
+Value dequantize(const Value& value) {
+  // Maps quantized values back to real ones: (I - zero_point) * scale. The
+  // scale and zero point are either scalars or per-channel along the axis.
+  IVLOG(1, "dequantize");
+  auto args = value.as_tuple();
+  if (args.size() != 4) {
+    throw std::runtime_error("dequantize expects 4 arguments");
+  }
+  auto I = args[0].as_tensor();
+  auto axis = normalize_axis(args[3].as_int(), I.shape().ndims(), "dequantize");
+  auto O = as_float(I, 32);
+  if (!args[2].is_none()) {
+    O = O - quant_param(args[2], I, axis);
+  }
+  return Value{O * quant_param(args[1], I, axis)};
+}
+
 Value dot(const Value& value) {
   IVLOG(1, "dot");
   auto args = value.as_tuple();
@@ -1640,6 +2144,48 @@ Value image_resize(const Value& value) {
   return Value{O};
 }
 
+Value layer_norm(const Value& value) {
+  // Normalizes I over the given axes, then applies the optional elementwise
+  // gamma and beta (which must broadcast against I). The statistics take two
+  // reductions (the mean, then the centered sum of squares, which is more
+  // stable than the one-pass sum of squares); the rest is elementwise and
+  // only the reduced tensors pay for the square root and reciprocal.
+  IVLOG(1, "layer_norm");
+  auto args = value.as_tuple();
+  if (args.size() != 5) {
+    throw std::runtime_error("layer_norm expects 5 arguments");
+  }
+  auto I = args[0].as_tensor();
+  auto axes = args[1];
+  auto gamma = args[2];
+  auto beta = args[3];
+  auto epsilon = args[4].as_float();
+  if (axes.is_tuple() && axes.as_tuple().empty()) {
+    throw std::runtime_error("layer_norm expects nonempty axis list");
+  }
+
+  AggregationAxes agg(I.shape().ndims(), axes, true);
+  I.bind_dims(agg.src_dims);
+  auto denom = Tensor{1};
+  for (const auto& axis : agg.axes) {
+    denom = denom * agg.src_dims.at(axis);
+  }
+  auto Sum = TensorOutput(agg.dst_dims);
+  Sum(agg.dst_idxs) += I(agg.src_idxs);
+  auto Centered = I - Sum / denom;
+  auto SquaredDifference = Centered * Centered;
+  auto SumSqDiff = TensorOutput(agg.dst_dims);
+  SumSqDiff(agg.dst_idxs) += SquaredDifference(agg.src_idxs);
+  auto O = Centered * (1.0 / sqrt(SumSqDiff / denom + epsilon));
+  if (!gamma.is_none()) {
+    O = O * gamma.as_tensor();
+  }
+  if (!beta.is_none()) {
+    O = O + beta.as_tensor();
+  }
+  return Value{O};
+}
+
 Value max(const Value& value) {
   IVLOG(1, "max");
   auto args = value.as_tuple();
@@ -1888,14 +2434,21 @@ Value pool(const Value& value) {
     O.add_constraints(constraints);
     return Value{O};
   } else if (pool_mode == PoolMode::AVG) {
-    O(O_idxs) += I(I_idxs);
+    // Narrow integer (e.g. quantized) inputs are summed in int32, and the
+    // average is cast back to the input's dtype
+    auto dtype = I_shape.dtype();
+    auto narrow = dtype == PLAIDML_DATA_INT8 || dtype == PLAIDML_DATA_UINT8 || dtype == PLAIDML_DATA_INT16 ||
+                  dtype == PLAIDML_DATA_UINT16;
+    auto S = narrow ? as_int(I, 32) : I;
+    O(O_idxs) += S(I_idxs);
     O.add_constraints(constraints);
     if (include_padding_in_avg) {
       int64_t total_pool_size = 1;
       for (const auto& sz : pool_size) {
         total_pool_size *= sz;
       }
-      return Value{O / total_pool_size};
+      auto R = O / total_pool_size;
+      return Value{narrow ? cast(R, dtype) : R};
     } else {
       auto One = Tensor{1};
       auto Ones = TensorOutput(I_dims);
@@ -1907,13 +2460,61 @@ Value pool(const Value& value) {
       Ones(O_idxs) = One(std::vector<TensorIndex>());
       Count(O_idxs) += Ones(I_idxs);
       Count.add_constraints(constraints);
-      return Value{O / Count};
+      auto R = O / Count;
+      return Value{narrow ? cast(R, dtype) : R};
     }
   } else {
     throw std::runtime_error("Unrecognized pool_mode in pool op");
   }
 }
 
+Value quantize(const Value& value) {
+  // Maps real values to the quantized dtype: round(I / scale) + zero_point,
+  // saturated to the range of the dtype.
+  IVLOG(1, "quantize");
+  auto args = value.as_tuple();
+  if (args.size() != 5) {
+    throw std::runtime_error("quantize expects 5 arguments");
+  }
+  auto I = args[0].as_tensor();
+  auto axis = normalize_axis(args[3].as_int(), I.shape().ndims(), "quantize");
+  auto zero_point = args[2].is_none() ? args[2] : Value{quant_param(args[2], I, axis)};
+  return Value{saturate_quantized(I / quant_param(args[1], I, axis), zero_point, args[4].as_str())};
+}
+
+Value quantized_convolution(const Value& value) {
+  // The parameters of quantized_convolution are those of convolution
+  // (without the fused bias and activation) followed by:
+  //    17. Input zero point
+  //    18. Filter zero point
+  // The result is the int32 accumulation of the zero-point-adjusted products;
+  // use requantize to map it to the output's quantized dtype. Padding
+  // contributes zeros after the adjustment, i.e. the input's zero point.
+  IVLOG(1, "quantized_convolution");
+  auto args = value.as_tuple();
+  if (args.size() != 19) {
+    throw std::runtime_error(
+        str(boost::format("PlaidML quantized_convolution op expects 19 arguments (received %1%)") % args.size()));
+  }
+  auto conv_args = std::vector<Value>(args.begin(), args.begin() + 17);
+  conv_args[0] = Value{widen_quantized(args[0].as_tensor(), args[17])};
+  conv_args[1] = Value{widen_quantized(args[1].as_tensor(), args[18])};
+  return convolution(Value{conv_args});
+}
+
+Value quantized_dot(const Value& value) {
+  // Multiplies quantized A and B with their zero points removed, accumulating
+  // in int32.
+  IVLOG(1, "quantized_dot");
+  auto args = value.as_tuple();
+  if (args.size() != 4) {
+    throw std::runtime_error("quantized_dot expects 4 arguments");
+  }
+  auto A = widen_quantized(args[0].as_tensor(), args[2]);
+  auto B = widen_quantized(args[1].as_tensor(), args[3]);
+  return dot(make_tuple(Value{A}, Value{B}));
+}
+
 Value relu(const Value& value) {
   IVLOG(1, "relu");
   auto args = value.as_tuple();
@@ -1972,6 +2573,21 @@ Value repeat(const Value& value) {
   return Value{O};
 }
 
+Value requantize(const Value& value) {
+  // Maps int32 accumulations to the quantized dtype. The scale is the product
+  // of the input scales divided by the output scale, and is typically
+  // per-channel along the output channel axis.
+  IVLOG(1, "requantize");
+  auto args = value.as_tuple();
+  if (args.size() != 5) {
+    throw std::runtime_error("requantize expects 5 arguments");
+  }
+  auto I = args[0].as_tensor();
+  auto axis = normalize_axis(args[3].as_int(), I.shape().ndims(), "requantize");
+  auto zero_point = args[2].is_none() ? args[2] : Value{quant_param(args[2], I, axis)};
+  return Value{saturate_quantized(as_float(I, 32) * quant_param(args[1], I, axis), zero_point, args[4].as_str())};
+}
+
 Value reshape(const Value& value) {
   IVLOG(1, "reshape");
   auto args = value.as_tuple();
@@ -2216,25 +2832,12 @@ Value softmax(const Value& value) {
 
   auto ndims = I.shape().ndims();
   auto axis = normalize_axis(raw_axis, ndims, "softmax");
-
-  // Ensure the axis is the last dimension, to make the derivative code happy
-  bool transposed = false;
-  std::vector<Value> pattern(ndims);  // Will be reused at the end to return to original order
-  if (axis != ndims - 1) {
-    transposed = true;
-    for (size_t i = 0; i < ndims; ++i) {
-      if (i == axis) {
-        pattern[i] = Value{ndims - 1};
-      } else if (i == ndims - 1) {
-        pattern[i] = Value{axis};
-      } else {
-        pattern[i] = Value{i};
-      }
-    }
-    I = transpose(make_tuple(args[0], Value{pattern})).as_tensor();
-    axis = ndims - 1;  // we've moved the softmax axis to be the last axis
+  if (axis >= std::size(softmax_derivs)) {
+    throw std::runtime_error(str(boost::format("softmax supports axes below %1%") % std::size(softmax_derivs)));
   }
 
+  // The reductions run along the softmax axis in place, and their results keep
+  // a unit dimension there so they broadcast without transposing I.
   std::vector<TensorDim> I_dims(ndims);
   std::vector<TensorIndex> I_idxs(ndims);
   I.bind_dims(I_dims);
@@ -2248,31 +2851,85 @@ Value softmax(const Value& value) {
   auto E = exp(I - M);
   auto N = TensorOutput(R_dims);
   N(R_idxs) += E(I_idxs);
-  auto O = E / N;
-  TensorDeriv deriv = [](const Tensor& Y, const Tensor& DY, const std::vector<Tensor>& X) {  //
-    auto I = X[0];
-    auto ndims = I.shape().ndims();
-    std::vector<TensorDim> I_dims(ndims);
-    std::vector<TensorIndex> I_idxs(ndims);
-    I.bind_dims(I_dims);
-    std::vector<TensorDim> R_dims = I_dims;
-    std::vector<TensorIndex> R_idxs = I_idxs;
-    R_dims.back() = TensorDim{1};    // Softmax along last axis
-    R_idxs.back() = TensorIndex{0};  // Softmax along last axis
-
-    auto YdY = Y * DY;
-    auto T = TensorOutput(R_dims);
-    T(R_idxs) += YdY(I_idxs);
-    auto TB = TensorOutput(I_dims);
-    TB(I_idxs) += T(R_idxs);
-    return std::vector<Tensor>{YdY - TB * Y};
-  };
-  auto Overridden = OverrideGrads(deriv, std::vector<Tensor>{I}, O);
-  // If we reordered, return to original order
-  if (transposed) {
-    return transpose(make_tuple(Value{Overridden}, Value{pattern}));
+  // One reciprocal per reduced row rather than a divide per element
+  auto O = E * (1.0 / N);
+  return Value{OverrideGrads(softmax_derivs[axis], std::vector<Tensor>{I}, O)};
+}
+
+Value sparse_dot(const Value& value) {
+  // Multiplies X by a sparse matrix W[K, N] stored in a blocked ELLPACK format:
+  // each column n of W holds J nonzero blocks of B consecutive rows, whose
+  // values are V[n, j, b] and whose block positions (in units of B rows) are
+  // Idx[n, j]. Columns with fewer nonzero blocks are padded with zero-valued
+  // blocks. A 2D V is read as B = 1. The last dimension of X is contracted, so
+  // a 1x1 convolution of NXC data with XCK filters is a sparse_dot as well.
+  //
+  // The rows of X that each block multiplies are gathered first, so the
+  // contraction only performs the multiplies of the stored blocks.
+  IVLOG(1, "sparse_dot");
+  auto args = value.as_tuple();
+  if (args.size() != 3) {
+    throw std::runtime_error("sparse_dot expects 3 arguments");
+  }
+  auto X = args[0].as_tensor();
+  auto V = args[1].as_tensor();
+  auto Idx = args[2].as_tensor();
+  if (Idx.shape().dtype() != PLAIDML_DATA_INT32 || Idx.shape().ndims() != 2) {
+    throw std::runtime_error("sparse_dot expects 2D int32 block indices");
+  }
+  auto ndims = X.shape().ndims();
+  if (ndims < 1) {
+    throw std::runtime_error("sparse_dot expects X to have at least 1 dimension");
+  }
+  if (V.shape().ndims() == 2) {
+    auto V_dims = V.shape().int_dims();
+    V = reshape(V, std::vector<int64_t>{V_dims[0], V_dims[1], 1});
   }
-  return Value{Overridden};
+  if (V.shape().ndims() != 3) {
+    throw std::runtime_error(
+        str(boost::format("sparse_dot expects 2D or 3D values (received %1%D)") % V.shape().ndims()));
+  }
+  auto block_size = V.shape().int_dims()[2];
+  auto X_dims = X.shape().int_dims();
+  auto K = X_dims[ndims - 1];
+  if (K % block_size) {
+    throw std::runtime_error(
+        str(boost::format("sparse_dot block size %1% does not divide the %2% rows of W") % block_size % K));
+  }
+
+  // Move the contracted dimension of X to the front, split into blocks
+  std::vector<TensorDim> D(ndims - 1);
+  std::vector<TensorIndex> d(ndims - 1);
+  TensorDim KD;
+  TensorIndex k;
+  std::vector<TensorDim> X_bind_dims(D.begin(), D.end());
+  X_bind_dims.push_back(KD);
+  X.bind_dims(X_bind_dims);
+  std::vector<TensorDim> XT_dims{KD};
+  XT_dims.insert(XT_dims.end(), D.begin(), D.end());
+  std::vector<TensorIndex> XT_idxs{k};
+  XT_idxs.insert(XT_idxs.end(), d.begin(), d.end());
+  std::vector<TensorIndex> X_idxs(d.begin(), d.end());
+  X_idxs.push_back(k);
+  auto XT = TensorOutput(XT_dims);
+  XT(XT_idxs) = X(X_idxs);
+  std::vector<int64_t> XB_dims{K / block_size, block_size};
+  XB_dims.insert(XB_dims.end(), X_dims.begin(), X_dims.end() - 1);
+  auto G = gather(reshape(XT, XB_dims), Idx);
+
+  // O[d..., n] = sum over j, b of G[n, j, b, d...] * V[n, j, b]
+  TensorDim N, J, B;
+  TensorIndex n("n"), j("j"), b("b");
+  V.bind_dims(N, J, B);
+  std::vector<TensorIndex> G_idxs{n, j, b};
+  G_idxs.insert(G_idxs.end(), d.begin(), d.end());
+  std::vector<TensorDim> O_dims(D.begin(), D.end());
+  O_dims.push_back(N);
+  std::vector<TensorIndex> O_idxs(d.begin(), d.end());
+  O_idxs.push_back(n);
+  auto O = TensorOutput(O_dims);
+  O(O_idxs) += G(G_idxs) * V(n, j, b);
+  return Value{O};
 }
 
 Value spatial_padding(const Value& value) {
@@ -2748,18 +3405,21 @@ void RegisterOps() {
   registry->Register("all", all);
   registry->Register("any", any);
   registry->Register("argmax", argmax);
+  registry->Register("batch_norm_inference", batch_norm_inference);
   registry->Register("binary_crossentropy", binary_crossentropy);
   registry->Register("clip", clip);
   registry->Register("concatenate", concatenate);
   registry->Register("convolution", convolution);
   registry->Register("cumprod", cumprod);
   registry->Register("cumsum", cumsum);
+  registry->Register("dequantize", dequantize);
   registry->Register("dot", dot);
   registry->Register("elu", elu);
   registry->Register("expand_dims", expand_dims);
   registry->Register("flip", flip);
   registry->Register("hard_sigmoid", hard_sigmoid);
   registry->Register("image_resize", image_resize);
+  registry->Register("layer_norm", layer_norm);
   registry->Register("max", max);
   registry->Register("maximum", maximum);
   registry->Register("mean", mean);
@@ -2767,13 +3427,18 @@ void RegisterOps() {
   registry->Register("minimum", minimum);
   registry->Register("pool", pool);
   registry->Register("prod", prod);
+  registry->Register("quantize", quantize);
+  registry->Register("quantized_convolution", quantized_convolution);
+  registry->Register("quantized_dot", quantized_dot);
   registry->Register("relu", relu);
   registry->Register("repeat", repeat);
+  registry->Register("requantize", requantize);
   registry->Register("reshape", reshape);
   registry->Register("scale_gradient", scale_gradient);
   registry->Register("sigmoid", sigmoid);
   registry->Register("slice", slice);
   registry->Register("softmax", softmax);
+  registry->Register("sparse_dot", sparse_dot);
   registry->Register("spatial_padding", spatial_padding);
   registry->Register("square", square);
   registry->Register("squeeze", squeeze);
@@ -50,6 +50,14 @@ inline edsl::Tensor argmax(const edsl::Tensor& I, const edsl::Value& axes = edsl
   return details::op("argmax", args).as_tensor();
 }
 
+inline edsl::Tensor batch_norm_inference(const edsl::Tensor& I, const edsl::Tensor& mean,
+                                         const edsl::Tensor& variance, const edsl::Value& gamma = edsl::None(),
+                                         const edsl::Value& beta = edsl::None(), double epsilon = 1e-3,
+                                         int axis = -1) {
+  auto args = edsl::make_tuple(I, mean, variance, gamma, beta, epsilon, axis);
+  return details::op("batch_norm_inference", args).as_tensor();
+}
+
 inline edsl::Tensor binary_crossentropy(const edsl::Tensor& I, const edsl::Tensor& O, double epsilon) {
   auto args = edsl::make_tuple(I, O, epsilon);
   return details::op("binary_crossentropy", args).as_tensor();
@@ -82,7 +90,9 @@ inline edsl::Tensor convolution(             //
     const std::string& name,                 //
     const std::string& autogroup_mode,       //
     const std::string& deriv_mode,           //
-    const std::vector<int>& result_shape     //
+    const std::vector<int>& result_shape,    //
+    const edsl::Value& bias = edsl::None(),  //
+    const std::string& activation = "none"   //
 ) {
   auto args = edsl::make_tuple(          //
       I_or_O,                            //
@@ -101,7 +111,9 @@ inline edsl::Tensor convolution(             //
       name,                              //
       autogroup_mode,                    //
       deriv_mode,                        //
-      edsl::make_tuple(result_shape));
+      edsl::make_tuple(result_shape),    //
+      bias,                              //
+      activation);
   return details::op("convolution", args).as_tensor();
 }
 
@@ -115,6 +127,12 @@ inline edsl::Tensor cumsum(const edsl::Tensor& I, int axis) {
   return details::op("cumsum", args).as_tensor();
 }
 
+inline edsl::Tensor dequantize(const edsl::Tensor& I, const edsl::Value& scale,
+                               const edsl::Value& zero_point = edsl::None(), int axis = -1) {
+  auto args = edsl::make_tuple(I, scale, zero_point, axis);
+  return details::op("dequantize", args).as_tensor();
+}
+
 inline edsl::Tensor dot(const edsl::Tensor& I, const edsl::Tensor& K) {
   auto args = edsl::make_tuple(I, K);
   return details::op("dot", args).as_tensor();
@@ -146,6 +164,13 @@ inline edsl::Tensor image_resize(const edsl::Tensor& I, const std::vector<int>&
   return details::op("image_resize", args).as_tensor();
 }
 
+inline edsl::Tensor layer_norm(const edsl::Tensor& I, const edsl::Value& axes = edsl::Value(-1),
+                               const edsl::Value& gamma = edsl::None(), const edsl::Value& beta = edsl::None(),
+                               double epsilon = 1e-3) {
+  auto args = edsl::make_tuple(I, axes, gamma, beta, epsilon);
+  return details::op("layer_norm", args).as_tensor();
+}
+
 inline edsl::Tensor max(const edsl::Tensor& I,  // NOLINT(build/include_what_you_use)
                         const edsl::Value& axes = edsl::None(), bool keepdims = false) {
   auto args = edsl::make_tuple(I, axes, keepdims);
@@ -202,6 +227,61 @@ inline edsl::Tensor prod(const edsl::Tensor& I, const edsl::Value& axes = edsl::
   return details::op("prod", args).as_tensor();
 }
 
+inline edsl::Tensor quantize(const edsl::Tensor& I, const edsl::Value& scale,
+                             const edsl::Value& zero_point = edsl::None(), int axis = -1,
+                             const std::string& dtype = "int8") {
+  auto args = edsl::make_tuple(I, scale, zero_point, axis, dtype);
+  return details::op("quantize", args).as_tensor();
+}
+
+inline edsl::Tensor quantized_convolution(           //
+    const edsl::Tensor& I,                           //
+    const edsl::Tensor& F,                           //
+    const std::vector<int>& strides,                 //
+    const std::vector<int>& dilations,               //
+    const std::vector<int>& data_dilations,          //
+    const std::vector<int>& filter_shape,            //
+    int groups,                                      //
+    const std::string& autopad_mode,                 //
+    const std::vector<int>& manual_padding,          //
+    const std::string& input_layout,                 //
+    const std::string& filter_layout,                //
+    const std::string& group_layout,                 //
+    const std::string& name,                         //
+    const std::string& autogroup_mode,               //
+    const edsl::Value& I_zero_point = edsl::None(),  //
+    const edsl::Value& F_zero_point = edsl::None()   //
+) {
+  auto args = edsl::make_tuple(                  //
+      I,                                         //
+      F,                                         //
+      edsl::make_tuple(strides),                 //
+      edsl::make_tuple(dilations),               //
+      edsl::make_tuple(data_dilations),          //
+      edsl::make_tuple(filter_shape),            //
+      groups,                                    //
+      autopad_mode,                              //
+      edsl::make_tuple(manual_padding),          //
+      input_layout,                              //
+      filter_layout,                             //
+      group_layout,                              //
+      false,                                     //
+      name,                                      //
+      autogroup_mode,                            //
+      std::string("none"),                       //
+      edsl::make_tuple(std::vector<int>{}),      //
+      I_zero_point,                              //
+      F_zero_point);
+  return details::op("quantized_convolution", args).as_tensor();
+}
+
+inline edsl::Tensor quantized_dot(const edsl::Tensor& A, const edsl::Tensor& B,
+                                  const edsl::Value& A_zero_point = edsl::None(),
+                                  const edsl::Value& B_zero_point = edsl::None()) {
+  auto args = edsl::make_tuple(A, B, A_zero_point, B_zero_point);
+  return details::op("quantized_dot", args).as_tensor();
+}
+
 class relu {
  protected:
   edsl::Tensor I_;
@@ -239,6 +319,13 @@ inline edsl::Tensor repeat(const edsl::Tensor& I, int repeats, int axis) {
   return details::op("repeat", args).as_tensor();
 }
 
+inline edsl::Tensor requantize(const edsl::Tensor& I, const edsl::Value& scale,
+                               const edsl::Value& zero_point = edsl::None(), int axis = -1,
+                               const std::string& dtype = "int8") {
+  auto args = edsl::make_tuple(I, scale, zero_point, axis, dtype);
+  return details::op("requantize", args).as_tensor();
+}
+
 inline edsl::Tensor reshape(const edsl::Tensor& I, const edsl::Value& dims) {
   auto args = edsl::make_tuple(I, dims);
   return details::op("reshape", args).as_tensor();
@@ -259,6 +346,13 @@ inline edsl::Tensor softmax(const edsl::Tensor& I, int axis) {
   return details::op("softmax", args).as_tensor();
 }
 
+// Multiplies X by a sparse matrix whose nonzero blocks of B rows are given per
+// column: V[N, J, B] holds their values and Idx[N, J] their block positions.
+inline edsl::Tensor sparse_dot(const edsl::Tensor& X, const edsl::Tensor& V, const edsl::Tensor& Idx) {
+  auto args = edsl::make_tuple(X, V, Idx);
+  return details::op("sparse_dot", args).as_tensor();
+}
+
 inline edsl::Tensor square(const edsl::Tensor& x) {  //
   return details::op("square", edsl::Value(x)).as_tensor();
 }
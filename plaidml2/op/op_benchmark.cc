@@ -0,0 +1,153 @@
+// Copyright 2020 Intel Corporation.
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "plaidml2/exec/exec.h"
+#include "plaidml2/op/op.h"
+
+// Benchmarks the ops in plaidml2/op/lib over shapes taken from common
+// networks, on every available device.  Each benchmark reports the FLOP and
+// byte rates implied by the compiled kernels' statistics; run with
+// --benchmark_format=json (or --benchmark_out=<file>) for machine-readable
+// results.
+
+namespace exec = plaidml::exec;
+
+namespace plaidml::op {
+namespace {
+
+constexpr auto F32 = PLAIDML_DATA_FLOAT32;
+
+struct OpCase {
+  std::string name;
+  std::function<edsl::Program()> build;
+};
+
+edsl::Program Conv2D(int64_t n, int64_t hw, int64_t ci, int64_t co, int k, int stride) {
+  auto I = edsl::Placeholder(F32, {n, hw, hw, ci});
+  auto K = edsl::Placeholder(F32, {k, k, ci, co});
+  auto O = op::convolution(I, K, {stride, stride}, {1, 1}, {1, 1}, {}, 1, "same_upper", {}, "nxc", "xck", "none",
+                           false, "", "ungrouped", "none", {});
+  return edsl::Program("convolution", {O});
+}
+
+edsl::Program Pool2D(const std::string& mode, int64_t n, int64_t hw, int64_t c) {
+  auto I = edsl::Placeholder(F32, {n, hw, hw, c});
+  return edsl::Program("pool", {op::pool(I, mode, {3, 3}, {2, 2}, "same_upper", {}, "nxc")});
+}
+
+edsl::Program Dot(int64_t m, int64_t k, int64_t n) {
+  auto A = edsl::Placeholder(F32, {m, k});
+  auto B = edsl::Placeholder(F32, {k, n});
+  return edsl::Program("dot", {op::dot(A, B)});
+}
+
+// Elementwise and reduction ops over an activation-sized tensor.
+edsl::Program Unary(const std::string& name, const std::function<edsl::Tensor(const edsl::Tensor&)>& fn,
+                    const std::vector<int64_t>& dims) {
+  auto I = edsl::Placeholder(F32, dims);
+  return edsl::Program(name, {fn(I)});
+}
+
+std::vector<OpCase> Cases() {
+  const std::vector<int64_t> act = {1, 56, 56, 256};  // ResNet-50 stage 2
+  const std::vector<int64_t> seq = {8, 128, 768};     // BERT-base hidden state
+  const std::vector<int64_t> logits = {64, 1000};     // Classifier output
+  auto spatial = edsl::make_tuple<int64_t>({1, 2});
+  std::vector<OpCase> cases = {
+      {"convolution/3x3_56x56x64", [] { return Conv2D(1, 56, 64, 64, 3, 1); }},
+      {"convolution/1x1_56x56x64x256", [] { return Conv2D(1, 56, 64, 256, 1, 1); }},
+      {"convolution/3x3_28x28x128", [] { return Conv2D(1, 28, 128, 128, 3, 1); }},
+      {"convolution/3x3_14x14x256", [] { return Conv2D(1, 14, 256, 256, 3, 1); }},
+      {"convolution/7x7s2_224x224x3", [] { return Conv2D(1, 224, 3, 64, 7, 2); }},
+      {"convolution/3x3_56x56x64_b32", [] { return Conv2D(32, 56, 64, 64, 3, 1); }},
+      {"dot/1024x768x768", [] { return Dot(1024, 768, 768); }},
+      {"dot/1024x768x3072", [] { return Dot(1024, 768, 3072); }},
+      {"dot/64x2048x1000", [] { return Dot(64, 2048, 1000); }},
+      {"pool/max_112x112x64", [] { return Pool2D("max", 1, 112, 64); }},
+      {"pool/avg_56x56x256", [] { return Pool2D("avg", 1, 56, 256); }},
+      {"abs", [=] { return Unary("abs", [](auto I) { return op::abs(I); }, act); }},
+      {"relu", [=] { return Unary("relu", [](auto I) { return edsl::Tensor(op::relu(I)); }, act); }},
+      {"elu", [=] { return Unary("elu", [](auto I) { return op::elu(I, 1.0); }, act); }},
+      {"sigmoid", [=] { return Unary("sigmoid", [](auto I) { return op::sigmoid(I); }, act); }},
+      {"hard_sigmoid", [=] { return Unary("hard_sigmoid", [](auto I) { return op::hard_sigmoid(I, 0.2); }, act); }},
+      {"square", [=] { return Unary("square", [](auto I) { return op::square(I); }, act); }},
+      {"flip", [=] { return Unary("flip", [](auto I) { return op::flip(I, 1); }, act); }},
+      {"transpose", [=] { return Unary("transpose", [](auto I) { return op::transpose(I); }, act); }},
+      {"tile", [=] { return Unary("tile", [](auto I) { return op::tile(I, {1, 2, 2, 1}); }, act); }},
+      {"repeat", [=] { return Unary("repeat", [](auto I) { return op::repeat(I, 2, 3); }, act); }},
+      {"slice", [=] { return Unary("slice", [](auto I) { return op::slice(I, {0, 1, 1, 0}); }, act); }},
+      {"spatial_padding", [=] {
+         return Unary("spatial_padding", [](auto I) { return op::spatial_padding(I, {1, 1}, {1, 1}, "nxc"); }, act);
+       }},
+      {"image_resize", [=] {
+         return Unary("image_resize", [](auto I) { return op::image_resize(I, {2, 2}, "bilinear", "nxc"); }, act);
+       }},
+      {"concatenate", [=] { return Unary("concatenate", [](auto I) { return op::concatenate({I, I}, 3); }, act); }},
+      {"maximum", [=] { return Unary("maximum", [](auto I) { return op::maximum(I, I); }, act); }},
+      {"minimum", [=] { return Unary("minimum", [](auto I) { return op::minimum(I, I); }, act); }},
+      {"clip", [=] { return Unary("clip", [](auto I) { return op::clip(I, I, I); }, act); }},
+      {"sum", [=] { return Unary("sum", [=](auto I) { return op::sum(I, spatial); }, act); }},
+      {"mean", [=] { return Unary("mean", [=](auto I) { return op::mean(I, spatial); }, act); }},
+      {"max", [=] { return Unary("max", [=](auto I) { return op::max(I, spatial); }, act); }},
+      {"min", [=] { return Unary("min", [=](auto I) { return op::min(I, spatial); }, act); }},
+      {"prod", [=] { return Unary("prod", [=](auto I) { return op::prod(I, spatial); }, act); }},
+      {"variance", [=] { return Unary("variance", [=](auto I) { return op::variance(I, spatial); }, act); }},
+      {"all", [=] { return Unary("all", [=](auto I) { return op::all(I, spatial); }, act); }},
+      {"any", [=] { return Unary("any", [=](auto I) { return op::any(I, spatial); }, act); }},
+      {"argmax", [=] { return Unary("argmax", [](auto I) { return op::argmax(I, edsl::Value(1)); }, logits); }},
+      {"cumsum", [=] { return Unary("cumsum", [](auto I) { return op::cumsum(I, 1); }, logits); }},
+      {"cumprod", [=] { return Unary("cumprod", [](auto I) { return op::cumprod(I, 1); }, logits); }},
+      {"softmax", [=] { return Unary("softmax", [](auto I) { return op::softmax(I, 1); }, logits); }},
+      {"binary_crossentropy", [=] {
+         return Unary("binary_crossentropy", [](auto I) { return op::binary_crossentropy(I, I, 1e-7); }, logits);
+       }},
+      {"layer_norm", [=] { return Unary("layer_norm", [](auto I) { return op::layer_norm(I); }, seq); }},
+      {"batch_norm_inference", [=] {
+         auto I = edsl::Placeholder(F32, act);
+         auto mean = edsl::Placeholder(F32, {act.back()});
+         auto variance = edsl::Placeholder(F32, {act.back()});
+         return edsl::Program("batch_norm_inference", {op::batch_norm_inference(I, mean, variance)});
+       }},
+  };
+  return cases;
+}
+
+void RunOp(benchmark::State& state, const std::string& device, const OpCase& op_case) {  // NOLINT
+  auto executable = exec::Binder(op_case.build()).set_device(device).compile();
+  executable->enable_stats();
+  executable->run();  // Warm up
+  for (auto _ : state) {
+    executable->run();
+  }
+  uint64_t flops = 0;
+  uint64_t bytes = 0;
+  for (const auto& kernel : executable->stats().kernels) {
+    flops += kernel.flops;
+    bytes += kernel.bytes;
+  }
+  state.counters["FLOP/s"] = benchmark::Counter(flops, benchmark::Counter::kIsIterationInvariantRate);
+  state.counters["B/s"] = benchmark::Counter(bytes, benchmark::Counter::kIsIterationInvariantRate);
+}
+
+}  // namespace
+}  // namespace plaidml::op
+
+int main(int argc, char** argv) {
+  plaidml::op::init();
+  plaidml::exec::init();
+  benchmark::Initialize(&argc, argv);
+  for (const auto& device : exec::list_devices()) {
+    for (const auto& op_case : plaidml::op::Cases()) {
+      benchmark::RegisterBenchmark((op_case.name + "/" + device).c_str(), plaidml::op::RunOp, device, op_case)
+          ->Unit(benchmark::kMicrosecond)
+          ->UseRealTime();
+    }
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
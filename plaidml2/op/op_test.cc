@@ -3,12 +3,20 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <string>
+#include <vector>
+
 #include "llvm/ADT/StringRef.h"
 
 #include "base/util/logging.h"
+#include "plaidml2/exec/exec.h"
 #include "plaidml2/op/op.h"
 
 using ::testing::Eq;
+using ::testing::FloatNear;
+using ::testing::HasSubstr;
+using ::testing::Not;
+using ::testing::Pointwise;
 
 using namespace plaidml::edsl;  // NOLINT
 
@@ -23,6 +31,51 @@ bool operator==(const Program& lhs, const std::string& rhs) {  //
 namespace plaidml::op {
 namespace {
 
+// Deterministic values in [-1, 1] for the numeric tests.
+std::vector<float> Fill(size_t count, unsigned seed) {
+  std::vector<float> values(count);
+  for (auto& value : values) {
+    seed = seed * 1103515245u + 12345u;
+    value = ((seed >> 8) % 2001) / 1000.0f - 1.0f;
+  }
+  return values;
+}
+
+std::vector<float> Read(Buffer buffer) {
+  auto view = buffer.mmap_current();
+  auto data = reinterpret_cast<float*>(view.data());
+  return std::vector<float>(data, data + view.size() / sizeof(float));
+}
+
+// Checks a Winograd convolution of an N x X x X image against the direct one.
+void ExpectWinogradMatchesDirect(int64_t X, const std::string& input_layout, const std::string& autopad_mode) {
+  int64_t N = 2, C = 3, K = 5;
+  bool nxc = input_layout == "nxc";
+  auto I = Placeholder(PLAIDML_DATA_FLOAT32, nxc ? std::vector<int64_t>{N, X, X, C} : std::vector<int64_t>{N, C, X, X});
+  auto F = Placeholder(PLAIDML_DATA_FLOAT32, nxc ? std::vector<int64_t>{3, 3, C, K} : std::vector<int64_t>{K, C, 3, 3});
+  auto filter_layout = nxc ? "xck" : "kcx";
+  auto conv = [&](bool winograd_allowed) {
+    return op::convolution(I, F, {1, 1}, {1, 1}, {1, 1}, {}, 1, autopad_mode, {}, input_layout, filter_layout, "none",
+                           winograd_allowed, "", "ungrouped", "none", {});
+  };
+  auto direct = conv(false);
+  auto winograd = conv(true);
+#ifdef PLAIDML_AST
+  // Only the Winograd transforms build their constant matrices from indexes
+  EXPECT_THAT(Program("winograd", {winograd}).str(), HasSubstr("index("));
+#endif
+  Program program("winograd", {direct, winograd});
+  auto binder = exec::Binder(program);
+  auto executable = binder.compile();
+  binder.input(I).copy_from(Fill(N * X * X * C, 1).data());
+  binder.input(F).copy_from(Fill(3 * 3 * C * K, 2).data());
+  executable->run();
+  auto expected = Read(binder.output(direct));
+  auto actual = Read(binder.output(winograd));
+  ASSERT_THAT(actual.size(), Eq(expected.size()));
+  EXPECT_THAT(actual, Pointwise(FloatNear(1e-4), expected));
+}
+
 TEST(Op, Abs) {
   auto I = Placeholder(PLAIDML_DATA_FLOAT32, {1, 224, 224, 3}, "I");
   auto abs = op::abs(I);
@@ -205,6 +258,51 @@ module {
 #endif
 }
 
+TEST(Op, BatchNormInference) {
+  auto I = Placeholder(PLAIDML_DATA_FLOAT32, {1, 4, 3, 3}, "I");
+  auto M = Placeholder(PLAIDML_DATA_FLOAT32, {4}, "M");
+  auto V = Placeholder(PLAIDML_DATA_FLOAT32, {4}, "V");
+  auto G = Placeholder(PLAIDML_DATA_FLOAT32, {4}, "G");
+  auto B = Placeholder(PLAIDML_DATA_FLOAT32, {4}, "B");
+  auto O = op::batch_norm_inference(I, M, V, Value(G), Value(B), 1e-5, 1);
+  Program program("batch_norm_inference", {O});
+  IVLOG(1, program);
+#ifdef PLAIDML_AST
+  // The per-channel scale and shift are folded before touching I, then
+  // reshaped to broadcast over the dimensions after the channels
+  EXPECT_THAT(program, Eq(R"(function (
+  I[I_0, I_1, I_2, I_3],
+  V[V_0],
+  G[G_0],
+  M[M_0],
+  B[B_0]
+) -> (
+  _X18
+) {
+  _X0 = 1.000000;
+  _X1 = 0.000010;
+  _X2 = add(V, _X1);
+  _X3 = sqrt(_X2);
+  _X4 = div(_X0, _X3);
+  _X5 = mul(_X4, G);
+  _X6 = 4;
+  _X7 = 1;
+  _X8 = 1;
+  _X9 = reshape(_X5, _X6, _X7, _X8);
+  _X10 = mul(I, _X9);
+  _X11 = neg(M);
+  _X12 = mul(_X11, _X5);
+  _X13 = add(_X12, B);
+  _X14 = 4;
+  _X15 = 1;
+  _X16 = 1;
+  _X17 = reshape(_X13, _X14, _X15, _X16);
+  _X18 = add(_X10, _X17);
+}
+)"));
+#endif
+}
+
 TEST(Op, BinaryCrossentropy) {
   auto I = Placeholder(PLAIDML_DATA_FLOAT32, {7, 7, 3, 64}, "I");
   auto O = Placeholder(PLAIDML_DATA_FLOAT32, {7, 7, 3, 64}, "O");
@@ -396,6 +494,176 @@ module {
 #endif
 }
 
+TEST(Op, ConvolutionBiasRelu) {
+  auto I = Placeholder(PLAIDML_DATA_FLOAT32, {1, 8, 8, 3}, "I");
+  auto K = Placeholder(PLAIDML_DATA_FLOAT32, {3, 3, 3, 4}, "K");
+  auto B = Placeholder(PLAIDML_DATA_FLOAT32, {4}, "B");
+  auto O = op::convolution(  //
+      I,                     // I_or_O
+      K,                     // F_or_O
+      {1, 1},                // strides
+      {1, 1},                // dilations
+      {1, 1},                // data_dilations
+      {},                    // filter_shape
+      1,                     // groups
+      "same_upper",          // autopad_mode
+      {},                    // manual_padding
+      "nxc",                 // input_layout
+      "xck",                 // filter_layout
+      "none",                // group_layout
+      false,                 // winograd_allowed
+      "",                    // name
+      "ungrouped",           // autogroup_mode
+      "none",                // deriv_mode
+      {},                    // result_shape
+      Value(B),              // bias
+      "relu");               // activation
+  Program program("convolution_bias_relu", {O});
+  IVLOG(1, program);
+#ifdef PLAIDML_AST
+  // The channels are innermost, so the bias broadcasts as is
+  EXPECT_THAT(program, Eq(R"(function (
+  I[I_0, I_1, I_2, I_3],
+  K[K_0, K_1, K_2, K_3],
+  B[B_0]
+) -> (
+  _X4
+) {
+  conv[n, x0, x1, co : 1, 8, 8, 4] = +(I[n, -1 + k0 + x0, -1 + k1 + x1, ci] * K[k0, k1, ci, co]);
+  _X0 = add(conv, B);
+  _X1 = 0.000000;
+  _X2 = cmp_lt(_X0, _X1);
+  _X3 = 0.000000;
+  _X4 = cond(_X2, _X3, _X0);
+}
+)"));
+#endif
+}
+
+TEST(Op, ConvolutionBiasNCX) {
+  auto I = Placeholder(PLAIDML_DATA_FLOAT32, {1, 3, 8, 8}, "I");
+  auto K = Placeholder(PLAIDML_DATA_FLOAT32, {4, 3, 3, 3}, "K");
+  auto B = Placeholder(PLAIDML_DATA_FLOAT32, {4}, "B");
+  auto O = op::convolution(  //
+      I,                     // I_or_O
+      K,                     // F_or_O
+      {1, 1},                // strides
+      {1, 1},                // dilations
+      {1, 1},                // data_dilations
+      {},                    // filter_shape
+      1,                     // groups
+      "valid",               // autopad_mode
+      {},                    // manual_padding
+      "ncx",                 // input_layout
+      "kcx",                 // filter_layout
+      "none",                // group_layout
+      false,                 // winograd_allowed
+      "",                    // name
+      "ungrouped",           // autogroup_mode
+      "none",                // deriv_mode
+      {},                    // result_shape
+      Value(B),              // bias
+      "none");               // activation
+  Program program("convolution_bias_ncx", {O});
+  IVLOG(1, program);
+#ifdef PLAIDML_AST
+  // The bias gains a unit dimension per spatial dimension to broadcast across them
+  EXPECT_THAT(program, Eq(R"(function (
+  I[I_0, I_1, I_2, I_3],
+  K[K_0, K_1, K_2, K_3],
+  B[B_0]
+) -> (
+  _X4
+) {
+  conv[n, co, x0, x1 : 1, 4, 6, 6] = +(I[n, ci, k0 + x0, k1 + x1] * K[co, ci, k0, k1]);
+  _X0 = 4;
+  _X1 = 1;
+  _X2 = 1;
+  _X3 = reshape(B, _X0, _X1, _X2);
+  _X4 = add(conv, _X3);
+}
+)"));
+#endif
+}
+
+TEST(Op, DepthwiseConvolution) {
+  auto I = Placeholder(PLAIDML_DATA_FLOAT32, {1, 112, 112, 32}, "I");
+  auto K = Placeholder(PLAIDML_DATA_FLOAT32, {3, 3, 32, 1}, "K");
+  auto O = op::convolution(  //
+      I,                     // I_or_O
+      K,                     // F_or_O
+      {1, 1},                // strides
+      {1, 1},                // dilations
+      {1, 1},                // data_dilations
+      {},                    // filter_shape
+      1,                     // groups
+      "same_upper",          // autopad_mode
+      {},                    // manual_padding
+      "nxc",                 // input_layout
+      "xck",                 // filter_layout
+      "in_C",                // group_layout
+      false,                 // winograd_allowed
+      "",                    // name
+      "max",                 // autogroup_mode
+      "none",                // deriv_mode
+      {});                   // result_shape
+  Program program("depthwise_convolution", {O});
+  IVLOG(1, program);
+#ifdef PLAIDML_AST
+  // The channel is indexed directly, leaving the filter window as the only reduction
+  EXPECT_THAT(program.str(), HasSubstr("I[n, -1 + k0 + x0, -1 + k1 + x1, c]"));
+  EXPECT_THAT(program.str(), HasSubstr("K[k0, k1, c, m]"));
+  EXPECT_THAT(program.str(), Not(HasSubstr("ci")));
+#endif
+}
+
+TEST(Op, GroupedConvolution) {
+  auto I = Placeholder(PLAIDML_DATA_FLOAT32, {1, 56, 56, 64}, "I");
+  auto K = Placeholder(PLAIDML_DATA_FLOAT32, {3, 3, 16, 128}, "K");
+  auto O = op::convolution(  //
+      I,                     // I_or_O
+      K,                     // F_or_O
+      {1, 1},                // strides
+      {1, 1},                // dilations
+      {1, 1},                // data_dilations
+      {},                    // filter_shape
+      4,                     // groups
+      "same_upper",          // autopad_mode
+      {},                    // manual_padding
+      "nxc",                 // input_layout
+      "xck",                 // filter_layout
+      "in_K",                // group_layout
+      false,                 // winograd_allowed
+      "",                    // name
+      "explicit",            // autogroup_mode
+      "none",                // deriv_mode
+      {});                   // result_shape
+  Program program("grouped_convolution", {O});
+  IVLOG(1, program);
+#ifdef PLAIDML_AST
+  // The group is a dimension of its own rather than a constrained slice of the channels
+  EXPECT_THAT(program.str(), HasSubstr("[n, -1 + k0 + x0, -1 + k1 + x1, g, ci]"));
+  EXPECT_THAT(program.str(), HasSubstr("[k0, k1, ci, g, co]"));
+  EXPECT_THAT(program.str(), Not(HasSubstr("co < ")));
+#endif
+}
+
+TEST(Op, WinogradConvolution2x2) {
+  // Images under 16 wide use F(2x2, 3x3); 7 leaves a partial tile
+  ExpectWinogradMatchesDirect(7, "nxc", "valid");
+  ExpectWinogradMatchesDirect(7, "nxc", "same_upper");
+  ExpectWinogradMatchesDirect(8, "ncx", "valid");
+  ExpectWinogradMatchesDirect(8, "ncx", "same_upper");
+}
+
+TEST(Op, WinogradConvolution4x4) {
+  // Images 16 wide or more use F(4x4, 3x3); 18 leaves a partial tile
+  ExpectWinogradMatchesDirect(18, "nxc", "valid");
+  ExpectWinogradMatchesDirect(18, "nxc", "same_upper");
+  ExpectWinogradMatchesDirect(16, "ncx", "valid");
+  ExpectWinogradMatchesDirect(16, "ncx", "same_upper");
+}
+
 TEST(Op, CumProd) {
   auto I = Placeholder(PLAIDML_DATA_FLOAT32, {7, 7, 3, 64}, "I");
   Program program("cumprod", {op::cumprod(I, 2)});
@@ -679,6 +947,42 @@ TEST(Op, ImageResize) {
 #endif
 }
 
+TEST(Op, LayerNorm) {
+  auto I = Placeholder(PLAIDML_DATA_FLOAT32, {2, 4, 8}, "I");
+  auto G = Placeholder(PLAIDML_DATA_FLOAT32, {8}, "G");
+  auto B = Placeholder(PLAIDML_DATA_FLOAT32, {8}, "B");
+  auto O = op::layer_norm(I, Value(-1), Value(G), Value(B), 1e-5);
+  Program program("layer_norm", {O});
+  IVLOG(1, program);
+#ifdef PLAIDML_AST
+  // Two reductions, for the mean and the centered sum of squares; the rest is elementwise
+  EXPECT_THAT(program, Eq(R"(function (
+  I[I_0, I_1, I_2],
+  G[G_0],
+  B[B_0]
+) -> (
+  _X14
+) {
+  _X0[x0, x1, x3 : 2, 4, 1] = +(I[x0, x1, x2]);
+  _X1 = 8;
+  _X2 = div(_X0, _X1);
+  _X3 = sub(I, _X2);
+  _X4 = 1.000000;
+  _X5 = mul(_X3, _X3);
+  _X6[x0, x1, x3 : 2, 4, 1] = +(_X5[x0, x1, x2]);
+  _X7 = div(_X6, _X1);
+  _X8 = 0.000010;
+  _X9 = add(_X7, _X8);
+  _X10 = sqrt(_X9);
+  _X11 = div(_X4, _X10);
+  _X12 = mul(_X3, _X11);
+  _X13 = mul(_X12, G);
+  _X14 = add(_X13, B);
+}
+)"));
+#endif
+}
+
 TEST(Op, Max) {
   auto I = Placeholder(PLAIDML_DATA_FLOAT32, {1, 224, 224, 3}, "I");
   Program program("max", {op::max(I)});  // NOLINT(build/include_what_you_use)
@@ -907,6 +1211,22 @@ module {
 #endif
 }
 
+TEST(Op, QuantizedDot) {
+  auto A = Placeholder(PLAIDML_DATA_UINT8, {4, 16}, "A");
+  auto B = Placeholder(PLAIDML_DATA_INT8, {16, 8}, "B");
+  auto scales = Placeholder(PLAIDML_DATA_FLOAT32, {8}, "scales");
+  auto O = op::requantize(op::quantized_dot(A, B, Value{128}), Value{scales}, Value{3}, -1, "uint8");
+  Program program("quantized_dot", {O});
+  IVLOG(1, program);
+  EXPECT_THAT(O.shape().dtype(), Eq(PLAIDML_DATA_UINT8));
+#ifdef PLAIDML_AST
+  // The products are accumulated in int32 before the per-channel rescale
+  EXPECT_THAT(program.str(), HasSubstr("as_int("));
+  EXPECT_THAT(program.str(), HasSubstr("round("));
+  EXPECT_THAT(program.str(), HasSubstr("as_uint("));
+#endif
+}
+
 TEST(Op, Relu) {
   auto I = Placeholder(PLAIDML_DATA_FLOAT32, {10, 20}, "I");
   auto A = Placeholder(PLAIDML_DATA_FLOAT32, {10, 20}, "A");
@@ -1252,15 +1572,17 @@ TEST(Op, Softmax) {
   EXPECT_THAT(program, Eq(R"(function (
   A[A_0, A_1]
 ) -> (
-  _X6
+  _X8
 ) {
   _X0 = ident(A);
   _X1[x0, 0 : 10, 1] = >(_X0[x0, x1]);
   _X2 = sub(_X0, _X1);
   _X3 = exp(_X2);
-  _X4[x0, 0 : 10, 1] = +(_X3[x0, x1]);
-  _X5 = div(_X3, _X4);
-  _X6 = ident(_X5);
+  _X4 = 1.000000;
+  _X5[x0, 0 : 10, 1] = +(_X3[x0, x1]);
+  _X6 = div(_X4, _X5);
+  _X7 = mul(_X3, _X6);
+  _X8 = ident(_X7);
 }
 )"));
 #endif
@@ -1273,20 +1595,37 @@ TEST(Op, Softmax) {
 !fp32 = type tensor<!eltwise.fp32>
 module {
   func @softmax(%arg0: tensor<10x20x!eltwise.fp32> {tile.name = "A"}) -> tensor<10x20x!eltwise.fp32> {
-    %cst = "eltwise.sconst"() {value = 0.000000e+00 : f64} : () -> !fp32
+    %cst = "eltwise.sconst"() {value = 1.000000e+00 : f64} : () -> !fp32
+    %cst_0 = "eltwise.sconst"() {value = 0.000000e+00 : f64} : () -> !fp32
     %0 = "eltwise.ident"(%arg0) {type = !eltwise.fp32} : (tensor<10x20x!eltwise.fp32>) -> tensor<10x20x!eltwise.fp32>
-    %1 = tile.cion max, none, %cst, %0 {sink = #map0, srcs = [#map1]} : !fp32, tensor<10x20x!eltwise.fp32> -> tensor<10x1x!eltwise.fp32>
+    %1 = tile.cion max, none, %cst_0, %0 {sink = #map0, srcs = [#map1]} : !fp32, tensor<10x20x!eltwise.fp32> -> tensor<10x1x!eltwise.fp32>
     %2 = "eltwise.sub"(%0, %1) {type = !eltwise.fp32} : (tensor<10x20x!eltwise.fp32>, tensor<10x1x!eltwise.fp32>) -> tensor<10x20x!eltwise.fp32>
     %3 = "eltwise.exp"(%2) {type = !eltwise.fp32} : (tensor<10x20x!eltwise.fp32>) -> tensor<10x20x!eltwise.fp32>
-    %4 = tile.cion add, none, %cst, %3 {sink = #map0, srcs = [#map1]} : !fp32, tensor<10x20x!eltwise.fp32> -> tensor<10x1x!eltwise.fp32>
-    %5 = "eltwise.div"(%3, %4) {type = !eltwise.fp32} : (tensor<10x20x!eltwise.fp32>, tensor<10x1x!eltwise.fp32>) -> tensor<10x20x!eltwise.fp32>
-    return %5 : tensor<10x20x!eltwise.fp32>
+    %4 = tile.cion add, none, %cst_0, %3 {sink = #map0, srcs = [#map1]} : !fp32, tensor<10x20x!eltwise.fp32> -> tensor<10x1x!eltwise.fp32>
+    %5 = "eltwise.div"(%cst, %4) {type = !eltwise.fp32} : (!fp32, tensor<10x1x!eltwise.fp32>) -> tensor<10x1x!eltwise.fp32>
+    %6 = "eltwise.mul"(%3, %5) {type = !eltwise.fp32} : (tensor<10x20x!eltwise.fp32>, tensor<10x1x!eltwise.fp32>) -> tensor<10x20x!eltwise.fp32>
+    return %6 : tensor<10x20x!eltwise.fp32>
   }
 }
 )#"));
 #endif
 }
 
+TEST(Op, SparseDot) {
+  auto X = Placeholder(PLAIDML_DATA_FLOAT32, {1, 7, 7, 64}, "X");
+  auto V = Placeholder(PLAIDML_DATA_FLOAT32, {128, 2, 4}, "V");
+  auto Idx = Placeholder(PLAIDML_DATA_INT32, {128, 2}, "Idx");
+  auto O = op::sparse_dot(X, V, Idx);
+  Program program("sparse_dot", {O});
+  IVLOG(1, program);
+  EXPECT_THAT(O.shape().int_dims(), Eq(std::vector<int64_t>{1, 7, 7, 128}));
+#ifdef PLAIDML_AST
+  // Only the stored blocks are multiplied
+  EXPECT_THAT(program.str(), HasSubstr("gather("));
+  EXPECT_THAT(program.str(), HasSubstr("* V[n, j, b]"));
+#endif
+}
+
 TEST(Op, SpatialPadding) {
   auto A = Placeholder(PLAIDML_DATA_FLOAT32, {64, 4, 32, 32}, "A");
   auto X = op::spatial_padding(  //
@@ -1491,17 +1830,16 @@ TEST(Op, Variance) {
   EXPECT_THAT(program, Eq(R"(function (
   A[A_0, A_1]
 ) -> (
-  _X8
+  _X7
 ) {
   _X0[x2, x3 : 1, 1] = +(A[x0, x1]);
   _X1 = 200;
   _X2 = div(_X0, _X1);
   _X3 = sub(A, _X2);
-  _X4 = sub(A, _X2);
-  _X5 = mul(_X3, _X4);
-  _X6[] = +(_X5[x0, x1]);
-  _X7 = 200;
-  _X8 = div(_X6, _X7);
+  _X4 = mul(_X3, _X3);
+  _X5[] = +(_X4[x0, x1]);
+  _X6 = 200;
+  _X7 = div(_X5, _X6);
 }
 )"));
 #endif
@@ -2,12 +2,18 @@
 
 #include "pmlc/compiler/compiler.h"
 
+#include <deque>
+#include <mutex>
+#include <string>
 #include <unordered_map>
 #include <utility>
 
+#include "llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h"
 #include "llvm/Support/FormatVariadic.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Target/TargetMachine.h"
 
+#include "mlir/Dialect/LLVMIR/LLVMDialect.h"
 #include "mlir/Dialect/StandardOps/Ops.h"
 #include "mlir/ExecutionEngine/ExecutionEngine.h"
 #include "mlir/ExecutionEngine/OptUtils.h"
@@ -16,9 +22,13 @@
 #include "mlir/Target/LLVMIR.h"
 #include "mlir/Transforms/Passes.h"
 
+#include "base/util/env.h"
 #include "base/util/logging.h"
+#include "pmlc/compiler/parallel.h"
 #include "pmlc/compiler/registry.h"
+#include "pmlc/compiler/xsmm.h"
 #include "pmlc/conversion/tile_to_pxa/tile_to_pxa.h"
+#include "pmlc/dialect/pxa/transforms/passes.h"
 
 using namespace mlir;  // NOLINT[build/namespaces]
 using pmlc::conversion::tile_to_pxa::createLowerTileToPXAPass;
@@ -157,6 +167,12 @@ class MemRefDescriptor {
 
   void* ptr() { return memory.data(); }
 
+  void setData(void* data) {
+    auto base = reinterpret_cast<Base*>(memory.data());
+    base->basePtr = data;
+    base->data = data;
+  }
+
  private:
   static unsigned computeSize(MemRefType type) {
     return sizeof(void*) +                     // allocatedPtr
@@ -173,10 +189,24 @@ void Executable::initialize() {
   llvm::InitializeNativeTarget();
   llvm::InitializeNativeTargetAsmPrinter();
   initializeLLVMPasses();
+  registerParallelRuntime();
+  registerXSMMRuntime();
 }
 
-Executable::Executable(StringRef entry, StringRef target, ModuleOp programModule, ArrayRef<void*> bufptrs)
-    : entry(entry), args(bufptrs.size()), ptrs(bufptrs.size()) {
+// The number of compiled programs kept by the cache, beyond which the oldest
+// are evicted.
+static constexpr size_t kMaxCachedModules = 64;
+
+// A program compiled by the ExecutionEngine, along with the descriptors of its
+// arguments.  The compiled code doesn't refer to the MLIR context it was built
+// from, so it may be shared by every Executable built from an identical
+// program.
+struct CompiledModule {
+  std::shared_ptr<ExecutionEngine> engine;
+  std::vector<MemRefDescriptor> descriptors;
+};
+
+static std::shared_ptr<CompiledModule> compileModule(StringRef target, ModuleOp programModule) {
   auto copy = cast<ModuleOp>(programModule.getOperation()->clone());
   OwningModuleRef module(copy);
   PassManager manager(module->getContext());
@@ -185,6 +215,17 @@ Executable::Executable(StringRef entry, StringRef target, ModuleOp programModule
   auto shouldPrintAfterPass = [](auto, auto) { return VLOG_IS_ON(3); };
   manager.enableIRPrinting(shouldPrintBeforePass, shouldPrintAfterPass, true, false, llvm::errs());
 
+  // Passes nested on functions run on each function in parallel, unless
+  // PLAIDML_EE_PASS_THREADING=0 (which also serializes IR printing, making its
+  // output easier to read).  PLAIDML_EE_PASS_TIMING=1 reports the time taken
+  // by each pass.
+  if (vertexai::env::Get("PLAIDML_EE_PASS_THREADING") == "0") {
+    manager.disableMultithreading();
+  }
+  if (vertexai::env::Get("PLAIDML_EE_PASS_TIMING") == "1") {
+    manager.enableTiming();
+  }
+
   manager.addNestedPass<FuncOp>(createCanonicalizerPass());
   manager.addNestedPass<FuncOp>(createCSEPass());
 
@@ -192,6 +233,10 @@ Executable::Executable(StringRef entry, StringRef target, ModuleOp programModule
   manager.addNestedPass<FuncOp>(createCanonicalizerPass());
   manager.addNestedPass<FuncOp>(createCSEPass());
 
+  manager.addNestedPass<FuncOp>(dialect::pxa::createFusionPass());
+  manager.addNestedPass<FuncOp>(createCanonicalizerPass());
+  manager.addNestedPass<FuncOp>(createCSEPass());
+
   std::vector<MemRefType> memRefTypes;
   manager.addPass(ArgumentCollectorPass::create(&memRefTypes));
   if (VLOG_IS_ON(6)) {
@@ -205,11 +250,44 @@ Executable::Executable(StringRef entry, StringRef target, ModuleOp programModule
     throw std::runtime_error("conversion to the LLVM IR dialect failed");
   }
 
-  assert(memRefTypes.size() == bufptrs.size() && "memRefTypes and bufptrs size mismatch");
+  // Functions outlined from parallel loops by the target pipeline.
+  llvm::StringMap<int64_t> parallelGrains;
+  module->walk([&](LLVM::LLVMFuncOp op) {
+    if (auto attr = op.getAttrOfType<IntegerAttr>(kParallelGrainAttrName)) {
+      parallelGrains[op.getName()] = attr.getInt();
+    }
+  });
+
+  // Functions outlined from matrix products by the target pipeline.
+  llvm::StringMap<XSMMKernel> xsmmKernels;
+  module->walk([&](LLVM::LLVMFuncOp op) {
+    if (auto attr = op.getAttrOfType<ArrayAttr>(kXSMMAttrName)) {
+      SmallVector<int32_t, 6> values;
+      for (auto value : attr.getValue()) {
+        values.push_back(value.cast<IntegerAttr>().getInt());
+      }
+      if (values.size() == 6) {
+        xsmmKernels[op.getName()] = XSMMKernel{values[0], values[1], values[2], values[3], values[4], values[5]};
+      }
+    }
+  });
 
+  // Optimize for the host, so that LLVM's loop and SLP vectorizers can use its
+  // full vector width on the loops tiled and unrolled by the target pipeline.
+  auto tmBuilderOrError = llvm::orc::JITTargetMachineBuilder::detectHost();
+  if (!tmBuilderOrError) {
+    llvm::consumeError(tmBuilderOrError.takeError());
+    throw std::runtime_error("could not detect the host target machine");
+  }
+  auto tmOrError = tmBuilderOrError->createTargetMachine();
+  if (!tmOrError) {
+    llvm::consumeError(tmOrError.takeError());
+    throw std::runtime_error("could not create the host target machine");
+  }
+  std::unique_ptr<llvm::TargetMachine> targetMachine = std::move(*tmOrError);
   auto optPipeline = makeOptimizingTransformer(
-      /*optLevel=*/0, /*sizeLevel=*/0,
-      /*targetMachine=*/nullptr);
+      /*optLevel=*/3, /*sizeLevel=*/0,
+      /*targetMachine=*/targetMachine.get());
 
   if (VLOG_IS_ON(6)) {
     auto llvmModule = translateModuleToLLVMIR(*module);
@@ -219,16 +297,77 @@ Executable::Executable(StringRef entry, StringRef target, ModuleOp programModule
     llvmModule->print(llvm::errs(), nullptr);
   }
 
-  auto maybeEngine = ExecutionEngine::create(*module, optPipeline);
+  auto transformer = [&](llvm::Module* llvmModule) {
+    lowerParallelCalls(llvmModule, parallelGrains);
+    lowerXSMMKernels(llvmModule, xsmmKernels);
+    return optPipeline(llvmModule);
+  };
+
+  auto maybeEngine = ExecutionEngine::create(*module, transformer);
   llvm::handleAllErrors(maybeEngine.takeError(), [](const llvm::ErrorInfoBase& b) {
     b.log(llvm::errs());
     throw std::runtime_error("Failed to create ExecutionEngine");
   });
-  engine = std::move(*maybeEngine);
 
-  descriptors.reserve(args.size());
+  auto compiled = std::make_shared<CompiledModule>();
+  compiled->engine = std::move(*maybeEngine);
+  for (auto type : memRefTypes) {
+    compiled->descriptors.emplace_back(nullptr, type);
+  }
+  return compiled;
+}
+
+// Returns the compiled form of the program, compiling it only if an identical
+// program hasn't already been compiled for the same target.  The cache may be
+// disabled by setting PLAIDML_EE_CACHE=0.
+static std::shared_ptr<CompiledModule> getCompiledModule(StringRef target, ModuleOp programModule) {
+  if (vertexai::env::Get("PLAIDML_EE_CACHE") == "0") {
+    return compileModule(target, programModule);
+  }
+
+  static std::mutex mutex;
+  static std::unordered_map<std::string, std::shared_ptr<CompiledModule>> cache;
+  static std::deque<std::string> insertionOrder;
+
+  std::string key;
+  llvm::raw_string_ostream os(key);
+  os << target << '\n';
+  programModule.print(os);
+  os.flush();
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = cache.find(key);
+    if (it != cache.end()) {
+      IVLOG(3, "Reusing the compiled module for target " << target.str());
+      return it->second;
+    }
+  }
+
+  // Compile outside of the lock, so that distinct programs may be compiled
+  // concurrently; should an identical program be compiled meanwhile, the
+  // first to finish is kept.
+  auto compiled = compileModule(target, programModule);
+  std::lock_guard<std::mutex> lock(mutex);
+  auto [it, inserted] = cache.emplace(key, compiled);
+  if (inserted) {
+    insertionOrder.push_back(key);
+    if (insertionOrder.size() > kMaxCachedModules) {
+      cache.erase(insertionOrder.front());
+      insertionOrder.pop_front();
+    }
+  }
+  return it->second;
+}
+
+Executable::Executable(StringRef entry, StringRef target, ModuleOp programModule, ArrayRef<void*> bufptrs)
+    : entry(entry), args(bufptrs.size()), ptrs(bufptrs.size()), boundPtrs(bufptrs.begin(), bufptrs.end()) {
+  auto compiled = getCompiledModule(target, programModule);
+  engine = compiled->engine;
+  descriptors = compiled->descriptors;
+  assert(descriptors.size() == bufptrs.size() && "memRefTypes and bufptrs size mismatch");
   for (unsigned i = 0; i < args.size(); i++) {
-    descriptors.emplace_back(bufptrs[i], memRefTypes[i]);
+    descriptors[i].setData(bufptrs[i]);
     ptrs[i] = descriptors[i].ptr();
     args[i] = &ptrs[i];
   }
@@ -236,7 +375,15 @@ Executable::Executable(StringRef entry, StringRef target, ModuleOp programModule
 
 Executable::~Executable() = default;
 
-void Executable::invoke() {
+void Executable::invoke() { invoke(boundPtrs); }
+
+void Executable::invoke(ArrayRef<void*> bufptrs) {
+  if (bufptrs.size() != descriptors.size()) {
+    throw std::runtime_error("JIT invocation argument count mismatch");
+  }
+  for (unsigned i = 0; i < bufptrs.size(); i++) {
+    descriptors[i].setData(bufptrs[i]);
+  }
   auto result = engine->invoke(entry, llvm::MutableArrayRef<void*>(args));
   if (result) {
     throw std::runtime_error("JIT invocation failed");
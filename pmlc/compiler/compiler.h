@@ -18,19 +18,26 @@ class MemRefDescriptor;
 
 class Executable {
  public:
+  // Compiles the program for the target, or reuses the code compiled for an
+  // identical program and target earlier in the process.
   Executable(mlir::StringRef entry, mlir::StringRef target, mlir::ModuleOp module, mlir::ArrayRef<void*> bufptrs);
   ~Executable();
 
   void invoke();
 
+  // Invokes the program on the specified buffers, which must match the sizes
+  // of the buffers the program was built with.
+  void invoke(mlir::ArrayRef<void*> bufptrs);
+
   static void initialize();
 
  private:
   std::string entry;
-  std::unique_ptr<mlir::ExecutionEngine> engine;
+  std::shared_ptr<mlir::ExecutionEngine> engine;
   std::vector<MemRefDescriptor> descriptors;
   std::vector<void*> args;
   std::vector<void*> ptrs;
+  std::vector<void*> boundPtrs;
 };
 
 }  // namespace pmlc::compiler
@@ -0,0 +1,112 @@
+// Copyright 2020, Intel Corporation
+
+#include "pmlc/compiler/parallel.h"
+
+#include <vector>
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/DynamicLibrary.h"
+
+#include "base/util/logging.h"
+#include "tile/targets/cpu/runtime.h"
+
+namespace rt = vertexai::tile::targets::cpu::rt;
+
+extern "C" void plaidml_rt_parallel_for(void** refs, size_t range, rt::cpu_thread_block func, size_t grain) {
+  rt::ParallelFor(refs, nullptr, range, func, grain, rt::kPartitionAuto);
+}
+
+namespace pmlc::compiler {
+
+namespace {
+
+const char kRuntimeSymbol[] = "plaidml_rt_parallel_for";
+
+llvm::FunctionType* getThreadBlockType(llvm::LLVMContext& ctx) {  // NOLINT[runtime/references]
+  auto i64Ty = llvm::Type::getInt64Ty(ctx);
+  auto refsTy = llvm::Type::getInt8PtrTy(ctx)->getPointerTo();
+  return llvm::FunctionType::get(llvm::Type::getVoidTy(ctx), {refsTy, i64Ty->getPointerTo(), i64Ty, i64Ty}, false);
+}
+
+// Builds a cpu_thread_block which calls the function over [lo + begin,
+// lo + end), where lo and the function's remaining arguments are loaded from
+// the pointers in refs: refs[0] points to lo and refs[i] (for i >= 2) points
+// to the function's i'th argument.
+llvm::Function* buildThreadBlock(llvm::Function* func) {
+  auto& ctx = func->getContext();
+  auto block = llvm::Function::Create(getThreadBlockType(ctx), llvm::Function::InternalLinkage,
+                                      func->getName() + "_block", func->getParent());
+  llvm::IRBuilder<> builder(llvm::BasicBlock::Create(ctx, "entry", block));
+  auto i8PtrTy = builder.getInt8PtrTy();
+  auto refs = block->arg_begin();
+  auto loadRef = [&](unsigned i, llvm::Type* type) {
+    auto ref = builder.CreateLoad(i8PtrTy, builder.CreateConstGEP1_32(i8PtrTy, refs, i));
+    return builder.CreateLoad(type, builder.CreateBitCast(ref, type->getPointerTo()));
+  };
+  auto indexTy = func->getFunctionType()->getParamType(0);
+  auto lo = loadRef(0, indexTy);
+  std::vector<llvm::Value*> args{
+      builder.CreateAdd(lo, builder.CreateZExtOrTrunc(block->arg_begin() + 2, indexTy)),
+      builder.CreateAdd(lo, builder.CreateZExtOrTrunc(block->arg_begin() + 3, indexTy)),
+  };
+  for (unsigned i = 2; i < func->arg_size(); i++) {
+    args.push_back(loadRef(i, func->getFunctionType()->getParamType(i)));
+  }
+  builder.CreateCall(func, args);
+  builder.CreateRetVoid();
+  return block;
+}
+
+}  // namespace
+
+void lowerParallelCalls(llvm::Module* module, const llvm::StringMap<int64_t>& grains) {
+  auto& ctx = module->getContext();
+  auto i8PtrTy = llvm::Type::getInt8PtrTy(ctx);
+  auto i64Ty = llvm::Type::getInt64Ty(ctx);
+  auto runtimeTy = llvm::FunctionType::get(
+      llvm::Type::getVoidTy(ctx), {i8PtrTy->getPointerTo(), i64Ty, getThreadBlockType(ctx)->getPointerTo(), i64Ty},
+      false);
+  for (const auto& kvp : grains) {
+    auto func = module->getFunction(kvp.first());
+    if (!func || func->arg_size() < 2) {
+      continue;
+    }
+    llvm::Function* block = nullptr;
+    for (auto user : llvm::make_early_inc_range(func->users())) {
+      auto call = llvm::dyn_cast<llvm::CallInst>(user);
+      if (!call || call->getCalledFunction() != func) {
+        continue;
+      }
+      if (!block) {
+        block = buildThreadBlock(func);
+      }
+      IVLOG(3, "Dispatching " << func->getName().str() << " to the parallel runtime, grain " << kvp.second);
+      auto& entry = call->getFunction()->getEntryBlock();
+      llvm::IRBuilder<> allocas(&entry, entry.begin());
+      llvm::IRBuilder<> builder(call);
+      auto refs = allocas.CreateAlloca(i8PtrTy, allocas.getInt32(func->arg_size()));
+      for (unsigned i = 0; i < func->arg_size(); i++) {
+        if (i == 1) {
+          // The end of the range is passed to the runtime instead.
+          continue;
+        }
+        auto arg = call->getArgOperand(i);
+        auto slot = allocas.CreateAlloca(arg->getType());
+        builder.CreateStore(arg, slot);
+        builder.CreateStore(builder.CreateBitCast(slot, i8PtrTy), builder.CreateConstGEP1_32(i8PtrTy, refs, i));
+      }
+      auto range = builder.CreateSub(call->getArgOperand(1), call->getArgOperand(0));
+      auto runtime = module->getOrInsertFunction(kRuntimeSymbol, runtimeTy);
+      builder.CreateCall(runtime, {refs, builder.CreateZExtOrTrunc(range, i64Ty), block, builder.getInt64(kvp.second)});
+      call->eraseFromParent();
+    }
+  }
+}
+
+void registerParallelRuntime() {
+  llvm::sys::DynamicLibrary::AddSymbol(kRuntimeSymbol, reinterpret_cast<void*>(&plaidml_rt_parallel_for));
+}
+
+}  // namespace pmlc::compiler
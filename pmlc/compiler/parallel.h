@@ -0,0 +1,28 @@
+// Copyright 2020, Intel Corporation
+
+#pragma once
+
+#include <cstdint>
+
+#include "llvm/ADT/StringMap.h"
+
+namespace llvm {
+class Module;
+}  // namespace llvm
+
+namespace pmlc::compiler {
+
+// Marks a function of the form `(index begin, index end, ...)` outlined from
+// the body of a parallel loop; its value is the minimum number of iterations
+// to run per task.  Calls to such functions are replaced by calls to the
+// runtime's parallel-for by lowerParallelCalls.
+constexpr const char kParallelGrainAttrName[] = "pmlc.parallel_grain";
+
+// Replaces each call to one of the named functions with a call which runs the
+// function's [begin, end) range in parallel, with the specified grain size.
+void lowerParallelCalls(llvm::Module* module, const llvm::StringMap<int64_t>& grains);
+
+// Makes the runtime's parallel-for visible to JIT-compiled code.
+void registerParallelRuntime();
+
+}  // namespace pmlc::compiler
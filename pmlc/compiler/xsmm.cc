@@ -0,0 +1,138 @@
+// Copyright 2020, Intel Corporation
+
+#include "pmlc/compiler/xsmm.h"
+
+#include <string>
+
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/DynamicLibrary.h"
+
+#include "base/util/logging.h"
+#include "tile/targets/cpu/runtime.h"
+
+namespace rt = vertexai::tile::targets::cpu::rt;
+
+namespace pmlc::compiler {
+
+namespace {
+
+const char kCallerSymbol[] = "XSMMRTCaller";
+
+// Returns the libxsmm dispatch function for the element type, or an empty
+// string if libxsmm has no microkernels for it.
+std::string getDispatchSymbol(llvm::Type* elementType) {
+  if (elementType->isFloatTy()) {
+    return "libxsmm_smmdispatch";
+  }
+  if (elementType->isDoubleTy()) {
+    return "libxsmm_dmmdispatch";
+  }
+  return "";
+}
+
+// Returns the type of the memref descriptor to which the argument points, or
+// null if it isn't a pointer to a descriptor: `{ T*, T*, i64, [N x i64],
+// [N x i64] }`, holding the allocated and aligned pointers, offset, sizes and
+// strides.
+llvm::StructType* getDescriptorType(llvm::Type* type) {
+  auto ptrTy = llvm::dyn_cast<llvm::PointerType>(type);
+  if (!ptrTy) {
+    return nullptr;
+  }
+  auto structTy = llvm::dyn_cast<llvm::StructType>(ptrTy->getElementType());
+  if (!structTy || structTy->getNumElements() < 3 || !structTy->getElementType(1)->isPointerTy()) {
+    return nullptr;
+  }
+  return structTy;
+}
+
+}  // namespace
+
+void lowerXSMMKernels(llvm::Module* module, const llvm::StringMap<XSMMKernel>& kernels) {
+  auto& ctx = module->getContext();
+  auto i32Ty = llvm::Type::getInt32Ty(ctx);
+  for (const auto& kvp : kernels) {
+    auto func = module->getFunction(kvp.first());
+    if (!func || func->isDeclaration() || func->arg_size() < 6) {
+      continue;
+    }
+    llvm::StructType* descriptorTys[3];
+    bool valid = true;
+    for (unsigned i = 0; i < 3; i++) {
+      descriptorTys[i] = getDescriptorType(func->getArg(i)->getType());
+      valid &= descriptorTys[i] != nullptr;
+    }
+    if (!valid) {
+      IVLOG(1, "Unexpected memref ABI for " << func->getName().str() << "; not using libxsmm");
+      continue;
+    }
+    auto elementTy = descriptorTys[0]->getElementType(1)->getPointerElementType();
+    auto dispatchSymbol = getDispatchSymbol(elementTy);
+    if (dispatchSymbol.empty()) {
+      continue;
+    }
+    const auto& kernel = kvp.second;
+    IVLOG(3, "Dispatching " << func->getName().str() << " to libxsmm: " << kernel.m << "x" << kernel.n << "x"
+                            << kernel.k);
+
+    // The original body becomes the fallback for shapes which libxsmm won't
+    // generate a kernel for.
+    auto& fallback = func->getEntryBlock();
+    auto entry = llvm::BasicBlock::Create(ctx, "xsmm_entry", func, &fallback);
+    auto call = llvm::BasicBlock::Create(ctx, "xsmm_call", func, &fallback);
+    llvm::IRBuilder<> builder(entry);
+
+    auto elementPtrTy = elementTy->getPointerTo();
+    auto i32PtrTy = i32Ty->getPointerTo();
+    auto kernelTy = llvm::FunctionType::get(builder.getVoidTy(), {elementPtrTy, elementPtrTy, elementPtrTy}, false);
+    auto dispatchTy = llvm::FunctionType::get(kernelTy->getPointerTo(),
+                                              {i32Ty, i32Ty, i32Ty, i32PtrTy, i32PtrTy, i32PtrTy, elementPtrTy,
+                                               elementPtrTy, i32PtrTy, i32PtrTy},
+                                              false);
+    auto callerTy = llvm::FunctionType::get(
+        builder.getVoidTy(), {kernelTy->getPointerTo(), elementPtrTy, elementPtrTy, elementPtrTy}, false);
+
+    auto makeSlot = [&](llvm::Type* type, llvm::Value* value) {
+      auto slot = builder.CreateAlloca(type);
+      builder.CreateStore(value, slot);
+      return slot;
+    };
+    auto lda = makeSlot(i32Ty, builder.getInt32(kernel.lda));
+    auto ldb = makeSlot(i32Ty, builder.getInt32(kernel.ldb));
+    auto ldc = makeSlot(i32Ty, builder.getInt32(kernel.ldc));
+    auto one = llvm::ConstantFP::get(elementTy, 1.0);
+    auto alpha = makeSlot(elementTy, one);
+    auto beta = makeSlot(elementTy, one);
+    auto nullPtr = llvm::ConstantPointerNull::get(i32PtrTy);
+    auto dispatch = module->getOrInsertFunction(dispatchSymbol, dispatchTy);
+    auto fn = builder.CreateCall(dispatch, {builder.getInt32(kernel.m), builder.getInt32(kernel.n),
+                                            builder.getInt32(kernel.k), lda, ldb, ldc, alpha, beta, nullPtr, nullPtr});
+    builder.CreateCondBr(builder.CreateIsNull(fn), &fallback, call);
+
+    builder.SetInsertPoint(call);
+    llvm::Value* ptrs[3];
+    for (unsigned i = 0; i < 3; i++) {
+      auto descriptor = func->getArg(i);
+      auto aligned = builder.CreateLoad(builder.CreateStructGEP(descriptorTys[i], descriptor, 1));
+      auto offset = builder.CreateLoad(builder.CreateStructGEP(descriptorTys[i], descriptor, 2));
+      auto index = builder.CreateAdd(offset, builder.CreateSExtOrTrunc(func->getArg(3 + i), offset->getType()));
+      ptrs[i] = builder.CreateBitCast(builder.CreateGEP(aligned, index), elementPtrTy);
+    }
+    auto caller = module->getOrInsertFunction(kCallerSymbol, callerTy);
+    builder.CreateCall(caller, {fn, ptrs[0], ptrs[1], ptrs[2]});
+    builder.CreateRetVoid();
+  }
+}
+
+void registerXSMMRuntime() {
+  const auto& symbols = rt::Symbols();
+  for (auto name : {kCallerSymbol, "libxsmm_smmdispatch", "libxsmm_dmmdispatch"}) {
+    auto it = symbols.find(name);
+    if (it != symbols.end()) {
+      llvm::sys::DynamicLibrary::AddSymbol(name, it->second);
+    }
+  }
+}
+
+}  // namespace pmlc::compiler
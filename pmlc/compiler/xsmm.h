@@ -0,0 +1,43 @@
+// Copyright 2020, Intel Corporation
+
+#pragma once
+
+#include <cstdint>
+
+#include "llvm/ADT/StringMap.h"
+
+namespace llvm {
+class Module;
+}  // namespace llvm
+
+namespace pmlc::compiler {
+
+// Marks a function of the form `(memref a, memref b, memref c, index aOffset,
+// index bOffset, index cOffset, ...)` whose body accumulates a matrix product
+// into c; its value is the array [m, n, k, lda, ldb, ldc] describing the
+// product in libxsmm's (column-major) terms, with a as libxsmm's first operand.
+// The body of such a function is replaced by a call to a libxsmm microkernel
+// by lowerXSMMKernels; each offset is the element of its memref at which the
+// kernel's operand starts.
+constexpr const char kXSMMAttrName[] = "pmlc.xsmm";
+
+// The shape of a libxsmm matrix product: c (m x n) += a (m x k) * b (k x n),
+// where each operand is column-major with the specified leading dimension.
+struct XSMMKernel {
+  int32_t m;
+  int32_t n;
+  int32_t k;
+  int32_t lda;
+  int32_t ldb;
+  int32_t ldc;
+};
+
+// Replaces the body of each of the named functions with a call to a libxsmm
+// microkernel of the specified shape.  The original body still runs if
+// libxsmm declines to generate a kernel.
+void lowerXSMMKernels(llvm::Module* module, const llvm::StringMap<XSMMKernel>& kernels);
+
+// Makes libxsmm's dispatch functions visible to JIT-compiled code.
+void registerXSMMRuntime();
+
+}  // namespace pmlc::compiler
@@ -78,11 +78,18 @@ struct AffineParallelForOpConversion : public LoweringBase<pxa::AffineParallelFo
     llvm::SmallVector<int64_t, 8> affineSteps;
     auto ranges = op.ranges().getValue();
 
+    // Dynamic ranges are bound by the loop's operands, in order
+    auto dynamicRange = operands.begin();
     for (size_t i = 0; i < ranges.size(); i++) {
       affineIvs.emplace_back(IndexHandle());
       affineIvPtrs.emplace_back(&affineIvs.back());
       affineLbs.emplace_back(constant_index(0));
-      affineUbs.emplace_back(constant_index(ranges[i].cast<IntegerAttr>().getInt()));
+      auto range = ranges[i].cast<IntegerAttr>().getInt();
+      if (mlir::ShapedType::isDynamic(range)) {
+        affineUbs.emplace_back(ValueHandle(*dynamicRange++));
+      } else {
+        affineUbs.emplace_back(constant_index(range));
+      }
       affineSteps.emplace_back(1);
     }
 
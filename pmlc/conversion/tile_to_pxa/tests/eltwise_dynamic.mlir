@@ -0,0 +1,20 @@
+// RUN: pmlc-opt -tile-legalize-to-pxa -canonicalize -cse %s | FileCheck %s
+
+func @eltwise_dynamic(
+  %arg0: tensor<?x20x!eltwise.fp32>,
+  %arg1: tensor<?x20x!eltwise.fp32>
+) -> tensor<?x20x!eltwise.fp32> {
+  %0 = "eltwise.add"(%arg1, %arg0) {type = !eltwise.fp32} : (
+    tensor<?x20x!eltwise.fp32>,
+    tensor<?x20x!eltwise.fp32>
+  ) -> tensor<?x20x!eltwise.fp32>
+  return %0 : tensor<?x20x!eltwise.fp32>
+}
+
+// CHECK-LABEL: func @eltwise_dynamic
+// CHECK: %[[N:.*]] = dim %{{.*}}, 0 : memref<?x20xf32>
+// CHECK: alloc(%[[N]]) : memref<?x20xf32>
+// CHECK: pxa.parallel_for
+// CHECK-SAME: %[[N]]
+// CHECK: addf
+// CHECK: affine.store
@@ -53,6 +53,7 @@ using mlir::CmpFPredicate;
 using mlir::CmpIPredicate;
 using mlir::ConversionPattern;
 using mlir::ConversionPatternRewriter;
+using mlir::DimOp;
 using mlir::FloatAttr;
 using mlir::FloatType;
 using mlir::FuncOp;
@@ -467,13 +468,38 @@ struct EltwiseOpConversion : public OpConversionPattern<FromOpType> {
     auto resultType = op.result()->getType();
     auto resultMemRefType = typeConverter.convertType(resultType).template cast<MemRefType>();
 
+    // Each dynamic dimension of the result takes its runtime size from an
+    // operand which is dynamic in the same (right-aligned) dimension
+    SmallVector<Value, 4> dynamicSizes;
+    for (unsigned i = 0; i < resultMemRefType.getRank(); i++) {
+      if (!resultMemRefType.isDynamicDim(i)) {
+        continue;
+      }
+      Value size;
+      for (auto operand : operands) {
+        auto operandType = operand.getType().template dyn_cast<MemRefType>();
+        if (!operandType) {
+          continue;
+        }
+        int64_t k = static_cast<int64_t>(operandType.getRank()) - resultMemRefType.getRank() + i;
+        if (k >= 0 && operandType.isDynamicDim(k)) {
+          size = rewriter.create<DimOp>(loc, operand, k);
+          break;
+        }
+      }
+      if (!size) {
+        throw std::runtime_error("Unable to determine the size of a dynamic dimension");
+      }
+      dynamicSizes.push_back(size);
+    }
+
     // Allocate the result
-    auto resultMemRef = rewriter.create<AllocOp>(loc, resultMemRefType).getResult();
+    auto resultMemRef = rewriter.create<AllocOp>(loc, resultMemRefType, dynamicSizes).getResult();
 
-    // Make a parallel for loop to fill the result
+    // Make a parallel for loop to fill the result; its dynamic ranges are the
+    // result's dynamic sizes
     auto ranges = rewriter.getI64ArrayAttr(resultMemRefType.getShape());
-    auto dynamicRanges = ArrayRef<Value>();
-    auto forOp = rewriter.create<pxa::AffineParallelForOp>(loc, ranges, dynamicRanges);
+    auto forOp = rewriter.create<pxa::AffineParallelForOp>(loc, ranges, dynamicSizes);
     auto body = rewriter.createBlock(&forOp.inner());
     SmallVector<Value, 8> idxs;
     for (size_t i = 0; i < ranges.size(); i++) {
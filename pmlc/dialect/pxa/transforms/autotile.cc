@@ -0,0 +1,200 @@
+// Copyright 2020, Intel Corporation
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/CommandLine.h"
+
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/Function.h"
+#include "mlir/Pass/Pass.h"
+
+#include "base/util/logging.h"
+#include "pmlc/dialect/pxa/transforms/passes.h"
+#include "pmlc/dialect/pxa/transforms/stride_info.h"
+
+namespace pmlc::dialect::pxa {
+
+namespace {
+
+llvm::cl::opt<unsigned> clCacheSizeKiB(  //
+    "pxa-autotile-cache-size",           //
+    llvm::cl::desc("The cache size (in KiB) targeted by -pxa-autotile"), llvm::cl::init(256));
+
+// Estimates the memory traffic of a tiled loop, in cache lines.  Each tile is
+// charged for the distinct cache lines touched by each of its accesses; writes
+// are charged twice, since their lines are also written back.
+class TileCostModel {
+ public:
+  TileCostModel(ArrayRef<int64_t> ranges, ArrayRef<StrideInfo> accesses) : ranges_(ranges), accesses_(accesses) {}
+
+  // The bytes of cache occupied by a single tile.
+  int64_t footprint(ArrayRef<int64_t> tile) const { return getFootprint(accesses_, tile); }
+
+  double cost(ArrayRef<int64_t> tile) const {
+    double tiles = 1;
+    for (unsigned i = 0; i < ranges_.size(); i++) {
+      tiles *= ranges_[i] / tile[i];
+    }
+    double lines = 0;
+    for (const auto& access : accesses_) {
+      lines += getLinesTouched(access, tile) * (access.isWrite ? 2 : 1);
+    }
+    return tiles * lines;
+  }
+
+ private:
+  ArrayRef<int64_t> ranges_;
+  ArrayRef<StrideInfo> accesses_;
+};
+
+std::vector<int64_t> divisors(int64_t value) {
+  std::vector<int64_t> result;
+  for (int64_t i = 1; i * i <= value; i++) {
+    if (value % i == 0) {
+      result.push_back(i);
+      if (i * i != value) {
+        result.push_back(value / i);
+      }
+    }
+  }
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+// Returns true if some access revisits the same addresses across an index, in
+// which case tiling can improve reuse; loops which only stream through memory
+// are left alone.
+bool hasReuse(ArrayRef<int64_t> ranges, ArrayRef<StrideInfo> accesses) {
+  for (const auto& access : accesses) {
+    for (unsigned i = 0; i < ranges.size(); i++) {
+      if (ranges[i] > 1 && !access.strides[i]) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+// Chooses tile sizes greedily: starting from single-iteration tiles, repeatedly
+// grows the index (to its next divisor, so that no boundary handling is
+// required) which most reduces the estimated traffic while the tile still
+// fits in the cache.  Growth which leaves the traffic unchanged is still taken,
+// preferring inner indices, since larger tiles mean less loop overhead.
+llvm::SmallVector<int64_t, 8> chooseTileSizes(ArrayRef<int64_t> ranges, ArrayRef<StrideInfo> accesses,
+                                              uint64_t cacheBytes) {
+  TileCostModel model(ranges, accesses);
+  std::vector<std::vector<int64_t>> options;
+  for (auto range : ranges) {
+    options.emplace_back(divisors(range));
+  }
+  llvm::SmallVector<int64_t, 8> tile(ranges.size(), 1);
+  llvm::SmallVector<size_t, 8> choice(ranges.size(), 0);
+  auto current = model.cost(tile);
+  while (true) {
+    int best = -1;
+    double bestCost = std::numeric_limits<double>::max();
+    for (int i = ranges.size() - 1; i >= 0; i--) {
+      if (choice[i] + 1 >= options[i].size()) {
+        continue;
+      }
+      auto candidate = tile;
+      candidate[i] = options[i][choice[i] + 1];
+      if (static_cast<uint64_t>(model.footprint(candidate)) > cacheBytes) {
+        continue;
+      }
+      auto cost = model.cost(candidate);
+      if (cost < bestCost) {
+        best = i;
+        bestCost = cost;
+      }
+    }
+    if (best < 0 || current < bestCost) {
+      break;
+    }
+    tile[best] = options[best][++choice[best]];
+    current = bestCost;
+  }
+  return tile;
+}
+
+// Splits the loop into an outer loop over tiles and an inner loop within each
+// tile.  Each of the original indices is rebuilt in the inner loop as
+// `outer * tile + inner`; canonicalization folds these into the accesses.
+void tileLoop(AffineParallelForOp op, ArrayRef<int64_t> tileSizes) {
+  auto loc = op.getLoc();
+  auto ranges = getRanges(op);
+  auto& outerBody = op.inner().front();
+  mlir::OpBuilder builder(&outerBody, outerBody.begin());
+  auto inner = builder.create<AffineParallelForOp>(loc, builder.getI64ArrayAttr(tileSizes), ArrayRef<Value>{});
+  auto innerBody = builder.createBlock(&inner.inner());
+  for (unsigned i = 0; i < ranges.size(); i++) {
+    innerBody->addArgument(builder.getIndexType());
+  }
+
+  // Move the original body, except for its terminator, into the inner loop.
+  innerBody->getOperations().splice(innerBody->end(), outerBody.getOperations(),
+                                    std::next(mlir::Block::iterator(inner.getOperation())),
+                                    std::prev(outerBody.end()));
+  builder.setInsertionPointToEnd(innerBody);
+  builder.create<AffineTerminatorOp>(loc);
+
+  builder.setInsertionPointToStart(innerBody);
+  for (unsigned i = 0; i < ranges.size(); i++) {
+    auto outerArg = outerBody.getArgument(i);
+    auto map = AffineMap::get(2, 0, builder.getAffineDimExpr(0) * tileSizes[i] + builder.getAffineDimExpr(1));
+    llvm::SmallVector<Value, 2> operands{outerArg, innerBody->getArgument(i)};
+    auto apply = builder.create<mlir::AffineApplyOp>(loc, map, operands);
+    for (auto& use : llvm::make_early_inc_range(outerArg.getUses())) {
+      if (use.getOwner() != apply.getOperation()) {
+        use.set(apply.getResult());
+      }
+    }
+    ranges[i] /= tileSizes[i];
+  }
+  op.setAttr("ranges", builder.getI64ArrayAttr(ranges));
+}
+
+struct AutoTilePass : public mlir::FunctionPass<AutoTilePass> {
+  explicit AutoTilePass(uint64_t cacheBytes) : cacheBytes(cacheBytes) {}
+
+  void runOnFunction() override {
+    llvm::SmallVector<AffineParallelForOp, 8> loops;
+    getFunction().walk([&](AffineParallelForOp op) { loops.push_back(op); });
+    for (auto op : loops) {
+      if (!op.dynamic_ranges().empty()) {
+        continue;
+      }
+      auto ranges = getRanges(op);
+      auto accesses = computeStrideInfo(op);
+      TileCostModel model(ranges, accesses);
+      if (static_cast<uint64_t>(model.footprint(ranges)) <= cacheBytes || !hasReuse(ranges, accesses)) {
+        continue;
+      }
+      auto tile = chooseTileSizes(ranges, accesses, cacheBytes);
+      if (tile == llvm::SmallVector<int64_t, 8>(ranges.begin(), ranges.end()) ||
+          std::all_of(tile.begin(), tile.end(), [](int64_t size) { return size == 1; })) {
+        continue;
+      }
+      IVLOG(3, "AutoTilePass> tiling a loop with cost " << model.cost(ranges) << " -> " << model.cost(tile));
+      tileLoop(op, tile);
+    }
+  }
+
+  uint64_t cacheBytes;
+};
+
+}  // namespace
+
+std::unique_ptr<mlir::Pass> createAutoTilePass(uint64_t cacheBytes) {  //
+  return std::make_unique<AutoTilePass>(cacheBytes);
+}
+
+static mlir::PassRegistration<AutoTilePass> pass(  //
+    "pxa-autotile",                                //
+    "Tile each pxa.parallel_for to fit its working set in cache",
+    [] { return std::make_unique<AutoTilePass>(clCacheSizeKiB * 1024); });
+
+}  // namespace pmlc::dialect::pxa
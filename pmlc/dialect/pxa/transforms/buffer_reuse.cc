@@ -0,0 +1,288 @@
+// Copyright 2020, Intel Corporation
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/STLExtras.h"
+
+#include "mlir/Dialect/AffineOps/AffineOps.h"
+#include "mlir/Dialect/StandardOps/Ops.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/Function.h"
+#include "mlir/IR/StandardTypes.h"
+#include "mlir/Pass/Pass.h"
+
+#include "base/util/logging.h"
+#include "pmlc/dialect/pxa/transforms/passes.h"
+
+namespace pmlc::dialect::pxa {
+
+using llvm::Optional;
+using llvm::SmallVector;
+using mlir::AffineLoadOp;
+using mlir::AffineStoreOp;
+using mlir::AllocOp;
+using mlir::Block;
+using mlir::DeallocOp;
+
+namespace {
+
+// Offsets within the arena are aligned to a cache line.
+constexpr int64_t kArenaAlignment = 64;
+
+// The span of top-level operations, by position within the function's block,
+// over which a buffer is live.
+struct LiveRange {
+  unsigned begin;
+  unsigned end;
+
+  bool overlaps(const LiveRange& rhs) const { return begin <= rhs.end && rhs.begin <= end; }
+};
+
+class BufferReusePass : public mlir::FunctionPass<BufferReusePass> {
+ public:
+  void runOnFunction() override {
+    auto& blocks = getFunction().getBody().getBlocks();
+    if (blocks.size() != 1) {
+      return;
+    }
+    block = &blocks.front();
+    while (reuseInPlace()) {
+    }
+    packArena();
+  }
+
+ private:
+  // Returns the live range of the allocation, or None if it's used by
+  // anything other than loops (and deallocations), in which case it may
+  // escape.
+  Optional<LiveRange> getLiveRange(AllocOp alloc) {
+    Optional<LiveRange> range;
+    unsigned position = 0;
+    for (auto& op : *block) {
+      bool used = llvm::any_of(alloc.getResult().getUsers(), [&](Operation* user) {
+        return !llvm::isa<DeallocOp>(user) && block->findAncestorOpInBlock(*user) == &op;
+      });
+      if (used) {
+        if (!llvm::isa<AffineParallelForOp>(op)) {
+          return llvm::None;
+        }
+        if (!range) {
+          range = LiveRange{position, position};
+        }
+        range->end = position;
+      }
+      position++;
+    }
+    return range;
+  }
+
+  SmallVector<AllocOp, 8> getAllocs() {
+    SmallVector<AllocOp, 8> allocs;
+    for (auto op : block->getOps<AllocOp>()) {
+      if (op.getType().hasStaticShape() && op.getType().getAffineMaps().empty()) {
+        allocs.push_back(op);
+      }
+    }
+    return allocs;
+  }
+
+  // Returns true if the loop reads the source at each element at which it
+  // writes the destination, before writing it, touching each element at most
+  // once: in which case the destination may share the source's memory.
+  bool canWriteInPlace(AffineParallelForOp loop, Value source, Value dest) {
+    auto body = &loop.inner().front();
+    Optional<std::pair<AffineMap, SmallVector<Value, 4>>> access;
+    bool stored = false;
+    auto matches = [&](AffineMap map, ValueRange operands) {
+      if (!access) {
+        access.emplace(map, SmallVector<Value, 4>(operands.begin(), operands.end()));
+      }
+      return access->first == map && llvm::equal(access->second, operands);
+    };
+    for (auto user : llvm::concat<Operation*>(llvm::to_vector<4>(source.getUsers()),
+                                              llvm::to_vector<4>(dest.getUsers()))) {
+      if (llvm::isa<DeallocOp>(user)) {
+        continue;
+      }
+      if (user->getBlock() != body) {
+        return false;
+      }
+      if (auto load = llvm::dyn_cast<AffineLoadOp>(user)) {
+        if (load.getMemRef() != source || !matches(load.getAffineMap(), load.getMapOperands())) {
+          return false;
+        }
+      } else if (auto store = llvm::dyn_cast<AffineStoreOp>(user)) {
+        if (store.getMemRef() != dest || store.getValueToStore() == dest ||
+            !matches(store.getAffineMap(), store.getMapOperands())) {
+          return false;
+        }
+        stored = true;
+      } else {
+        return false;
+      }
+    }
+    if (!access || !stored) {
+      return false;
+    }
+    // Every load must precede every store.
+    stored = false;
+    for (auto& op : *body) {
+      if (auto load = llvm::dyn_cast<AffineLoadOp>(op)) {
+        if (load.getMemRef() == source && stored) {
+          return false;
+        }
+      } else if (auto store = llvm::dyn_cast<AffineStoreOp>(op)) {
+        stored |= store.getMemRef() == dest;
+      }
+    }
+    // The access must select a distinct loop index for each dimension, so that
+    // distinct iterations touch distinct elements.
+    llvm::DenseSet<Value> indices;
+    for (auto expr : access->first.getResults()) {
+      auto dim = expr.dyn_cast<mlir::AffineDimExpr>();
+      if (!dim) {
+        return false;
+      }
+      auto arg = access->second[dim.getPosition()].dyn_cast<mlir::BlockArgument>();
+      if (!arg || arg.getOwner() != body || !indices.insert(arg).second) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Writes the result of an elementwise loop into the memory of an input
+  // which dies in that loop, removing the result's allocation.
+  bool reuseInPlace() {
+    auto allocs = getAllocs();
+    for (auto dest : allocs) {
+      auto destRange = getLiveRange(dest);
+      if (!destRange) {
+        continue;
+      }
+      for (auto source : allocs) {
+        if (source == dest || source.getType() != dest.getType()) {
+          continue;
+        }
+        auto sourceRange = getLiveRange(source);
+        if (!sourceRange || sourceRange->end != destRange->begin) {
+          continue;
+        }
+        auto loop = llvm::cast<AffineParallelForOp>(*std::next(block->begin(), destRange->begin));
+        if (!canWriteInPlace(loop, source.getResult(), dest.getResult())) {
+          continue;
+        }
+        IVLOG(3, "BufferReusePass> writing in place at loop " << destRange->begin);
+        // The source now lives as long as the result, which takes over its
+        // deallocations.
+        eraseDeallocs(source);
+        dest.replaceAllUsesWith(source.getResult());
+        dest.erase();
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Places the allocations which are live over disjoint ranges at offsets in
+  // a single arena, so that they share memory and need only one allocation.
+  void packArena() {
+    struct Buffer {
+      AllocOp alloc;
+      LiveRange range;
+      int64_t bytes;
+      int64_t offset;
+    };
+    std::vector<Buffer> buffers;
+    for (auto alloc : getAllocs()) {
+      auto type = alloc.getType();
+      auto range = getLiveRange(alloc);
+      if (!range || !type.getElementType().isIntOrFloat() || type.getElementTypeBitWidth() % 8) {
+        continue;
+      }
+      auto bytes = type.getSizeInBits() / 8;
+      bytes = (bytes + kArenaAlignment - 1) / kArenaAlignment * kArenaAlignment;
+      buffers.push_back(Buffer{alloc, *range, bytes, 0});
+    }
+    if (buffers.size() < 2) {
+      return;
+    }
+
+    // Place the largest buffers first, each at the lowest offset which doesn't
+    // overlap any already-placed buffer whose live range it overlaps.
+    std::stable_sort(buffers.begin(), buffers.end(),
+                     [](const Buffer& lhs, const Buffer& rhs) { return lhs.bytes > rhs.bytes; });
+    int64_t arenaBytes = 0;
+    int64_t unpackedBytes = 0;
+    for (unsigned i = 0; i < buffers.size(); i++) {
+      SmallVector<const Buffer*, 8> conflicts;
+      for (unsigned j = 0; j < i; j++) {
+        if (buffers[j].range.overlaps(buffers[i].range)) {
+          conflicts.push_back(&buffers[j]);
+        }
+      }
+      std::sort(conflicts.begin(), conflicts.end(),
+                [](const Buffer* lhs, const Buffer* rhs) { return lhs->offset < rhs->offset; });
+      int64_t offset = 0;
+      for (auto conflict : conflicts) {
+        if (offset + buffers[i].bytes <= conflict->offset) {
+          break;
+        }
+        offset = std::max(offset, conflict->offset + conflict->bytes);
+      }
+      buffers[i].offset = offset;
+      arenaBytes = std::max(arenaBytes, offset + buffers[i].bytes);
+      unpackedBytes += buffers[i].bytes;
+    }
+    IVLOG(3, "BufferReusePass> packed " << buffers.size() << " buffers of " << unpackedBytes << " bytes into "
+                                        << arenaBytes);
+
+    auto loc = getFunction().getLoc();
+    mlir::OpBuilder builder(block, block->begin());
+    auto arenaType = mlir::MemRefType::get({arenaBytes}, builder.getIntegerType(8));
+    auto arena = builder.create<AllocOp>(loc, arenaType);
+    for (auto& buffer : buffers) {
+      auto type = buffer.alloc.getType();
+      SmallVector<int64_t, 4> strides;
+      int64_t offset;
+      if (failed(mlir::getStridesAndOffset(type, strides, offset))) {
+        throw std::runtime_error("BufferReusePass: unexpected layout");
+      }
+      auto elementBytes = type.getElementTypeBitWidth() / 8;
+      auto map = mlir::makeStridedLinearLayoutMap(strides, buffer.offset / elementBytes, type.getContext());
+      auto viewType = mlir::MemRefType::get(type.getShape(), type.getElementType(), {map});
+      builder.setInsertionPoint(buffer.alloc.getOperation());
+      auto view = builder.create<mlir::ViewOp>(loc, viewType, arena.getResult(), ValueRange{});
+      eraseDeallocs(buffer.alloc);
+      buffer.alloc.replaceAllUsesWith(view.getResult());
+      buffer.alloc.erase();
+    }
+    builder.setInsertionPoint(block->getTerminator());
+    builder.create<DeallocOp>(loc, arena.getResult());
+  }
+
+  void eraseDeallocs(AllocOp alloc) {
+    for (auto user : llvm::make_early_inc_range(alloc.getResult().getUsers())) {
+      if (llvm::isa<DeallocOp>(user)) {
+        user->erase();
+      }
+    }
+  }
+
+  Block* block = nullptr;
+};
+
+}  // namespace
+
+std::unique_ptr<mlir::Pass> createBufferReusePass() {  //
+  return std::make_unique<BufferReusePass>();
+}
+
+static mlir::PassRegistration<BufferReusePass> pass(  //
+    "pxa-buffer-reuse",                             //
+    "Share memory between intermediate buffers with disjoint lifetimes");
+
+}  // namespace pmlc::dialect::pxa
@@ -0,0 +1,347 @@
+// Copyright 2020, Intel Corporation
+
+#include <vector>
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/STLExtras.h"
+
+#include "mlir/Dialect/AffineOps/AffineOps.h"
+#include "mlir/Dialect/StandardOps/Ops.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/Function.h"
+#include "mlir/Pass/Pass.h"
+
+#include "base/util/logging.h"
+#include "pmlc/dialect/pxa/transforms/passes.h"
+#include "pmlc/dialect/pxa/transforms/stride_info.h"
+
+namespace pmlc::dialect::pxa {
+
+using llvm::DenseMap;
+using llvm::DenseSet;
+using llvm::Optional;
+using llvm::SmallVector;
+using mlir::AffineLoadOp;
+using mlir::AffineStoreOp;
+using mlir::AllocOp;
+using mlir::Block;
+using mlir::DeallocOp;
+
+namespace {
+
+using Dims = SmallVector<unsigned, 4>;
+
+// Returns, for each result of an access map, the loop index it selects, or
+// None unless each result is exactly one of the loop's indices.
+Optional<Dims> getAccessDims(AffineMap map, ValueRange operands, Block* body) {
+  Dims dims;
+  for (auto expr : map.getResults()) {
+    auto dim = expr.dyn_cast<mlir::AffineDimExpr>();
+    if (!dim) {
+      return llvm::None;
+    }
+    auto arg = operands[dim.getPosition()].dyn_cast<mlir::BlockArgument>();
+    if (!arg || arg.getOwner() != body) {
+      return llvm::None;
+    }
+    dims.push_back(arg.getArgNumber());
+  }
+  return dims;
+}
+
+// The memory accessed by the body of a loop.
+struct LoopAccesses {
+  // Memrefs which are written, with the loop indices at which they are written,
+  // or None if they're written anywhere other than at a fixed set of indices.
+  DenseMap<Value, Optional<Dims>> writes;
+  // Memrefs which are read, with the loop indices at which they are read
+  // (None as for writes).
+  DenseMap<Value, Optional<Dims>> reads;
+  // The written memrefs which are written by affine.store (rather than only by
+  // pxa.reduce).
+  DenseSet<Value> stored;
+  // True if the body contains operations whose effects aren't understood.
+  bool opaque = false;
+};
+
+void addAccess(DenseMap<Value, Optional<Dims>>* accesses, Value memref, Optional<Dims> dims) {
+  auto it = accesses->find(memref);
+  if (it == accesses->end()) {
+    accesses->try_emplace(memref, dims);
+  } else if (it->second != dims) {
+    it->second = llvm::None;
+  }
+}
+
+LoopAccesses getAccesses(AffineParallelForOp op) {
+  LoopAccesses result;
+  auto body = &op.inner().front();
+  op.getOperation()->walk([&](Operation* inner) {
+    if (auto load = llvm::dyn_cast<AffineLoadOp>(inner)) {
+      addAccess(&result.reads, load.getMemRef(), getAccessDims(load.getAffineMap(), load.getMapOperands(), body));
+    } else if (auto store = llvm::dyn_cast<AffineStoreOp>(inner)) {
+      addAccess(&result.writes, store.getMemRef(), getAccessDims(store.getAffineMap(), store.getMapOperands(), body));
+      result.stored.insert(store.getMemRef());
+    } else if (auto reduce = llvm::dyn_cast<AffineReduceOp>(inner)) {
+      addAccess(&result.writes, reduce.out(), getAccessDims(reduce.map(), reduce.idxs(), body));
+    } else if (!llvm::isa<AffineParallelForOp>(inner) && !llvm::isa<AffineTerminatorOp>(inner) &&
+               !inner->hasNoSideEffect()) {
+      result.opaque = true;
+    }
+  });
+  return result;
+}
+
+// Returns true if the operation may be hoisted above the loop: allocations
+// and constants whose operands are defined before the loop.
+bool canHoistAbove(Operation* op, AffineParallelForOp loop) {
+  if (!llvm::isa<AllocOp>(op) && !(op->hasNoSideEffect() && op->getNumRegions() == 0)) {
+    return false;
+  }
+  for (auto operand : op->getOperands()) {
+    auto defOp = operand.getDefiningOp();
+    if (defOp && defOp->getBlock() == loop.getOperation()->getBlock() &&
+        !defOp->isBeforeInBlock(loop.getOperation())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Forwards values stored within the block to subsequent loads of the same
+// element, so that intermediates needn't make a round trip through memory.
+void forwardStores(Block* block) {
+  struct Key {
+    Value memref;
+    AffineMap map;
+    SmallVector<Value, 4> operands;
+  };
+  std::vector<std::pair<Key, Value>> stored;
+  for (auto& op : llvm::make_early_inc_range(*block)) {
+    if (auto store = llvm::dyn_cast<AffineStoreOp>(op)) {
+      auto memref = store.getMemRef();
+      // Writes through one memref may alias unknown memrefs (such as function
+      // arguments), but never a distinct allocation.
+      bool isAlloc = memref.getDefiningOp() && llvm::isa<AllocOp>(memref.getDefiningOp());
+      llvm::erase_if(stored, [&](const std::pair<Key, Value>& entry) {
+        if (entry.first.memref == memref) {
+          return true;
+        }
+        auto defOp = entry.first.memref.getDefiningOp();
+        return !isAlloc && !(defOp && llvm::isa<AllocOp>(defOp));
+      });
+      auto operands = store.getMapOperands();
+      stored.emplace_back(Key{memref, store.getAffineMap(), {operands.begin(), operands.end()}},
+                          store.getValueToStore());
+    } else if (auto load = llvm::dyn_cast<AffineLoadOp>(op)) {
+      auto operands = load.getMapOperands();
+      for (const auto& [key, value] : stored) {
+        if (key.memref == load.getMemRef() && key.map == load.getAffineMap() &&
+            llvm::equal(key.operands, operands)) {
+          load.replaceAllUsesWith(value);
+          load.erase();
+          break;
+        }
+      }
+    } else if (!op.hasNoSideEffect()) {
+      stored.clear();
+    }
+  }
+}
+
+class FusionPass : public mlir::FunctionPass<FusionPass> {
+ public:
+  void runOnFunction() override {
+    for (auto& block : getFunction().getBody()) {
+      while (fuseOnce(&block)) {
+      }
+    }
+    eraseDeadAllocs();
+  }
+
+ private:
+  // Fuses the first pair of adjacent loops in the block which can be fused.
+  bool fuseOnce(Block* block) {
+    for (auto producer : block->getOps<AffineParallelForOp>()) {
+      auto it = std::next(mlir::Block::iterator(producer.getOperation()));
+      SmallVector<Operation*, 4> between;
+      for (; it != block->end() && !llvm::isa<AffineParallelForOp>(*it); ++it) {
+        between.push_back(&*it);
+      }
+      if (it == block->end()) {
+        return false;
+      }
+      auto consumer = llvm::cast<AffineParallelForOp>(*it);
+      if (!llvm::all_of(between, [&](Operation* op) { return canHoistAbove(op, producer); })) {
+        continue;
+      }
+      if (tryFuse(producer, consumer, between)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Fuses the consumer into the producer if each of the consumer's indices
+  // corresponds to one of the producer's output indices, through which it
+  // reads the producer's results element by element.  Any other indices of the
+  // producer are reductions, which are split into their own inner loop so that
+  // the consumer runs once each output element is complete.
+  bool tryFuse(AffineParallelForOp producer, AffineParallelForOp consumer, ArrayRef<Operation*> between) {
+    if (!producer.dynamic_ranges().empty() || !consumer.dynamic_ranges().empty()) {
+      return false;
+    }
+    auto producerRanges = getRanges(producer);
+    auto consumerRanges = getRanges(consumer);
+    auto producerAccesses = getAccesses(producer);
+    auto consumerAccesses = getAccesses(consumer);
+    if (producerAccesses.opaque || consumerAccesses.opaque) {
+      return false;
+    }
+
+    // Match the consumer's indices to the producer's through the memrefs the
+    // consumer reads from the producer.
+    SmallVector<int, 8> mapping(consumerRanges.size(), -1);
+    bool connected = false;
+    for (const auto& kvp : consumerAccesses.reads) {
+      const auto& readDims = kvp.second;
+      auto it = producerAccesses.writes.find(kvp.first);
+      if (it == producerAccesses.writes.end()) {
+        continue;
+      }
+      const auto& writeDims = it->second;
+      if (!readDims || !writeDims || readDims->size() != writeDims->size()) {
+        return false;
+      }
+      for (unsigned i = 0; i < readDims->size(); i++) {
+        auto& mapped = mapping[(*readDims)[i]];
+        if (mapped >= 0 && mapped != static_cast<int>((*writeDims)[i])) {
+          return false;
+        }
+        mapped = (*writeDims)[i];
+      }
+      connected = true;
+    }
+    if (!connected) {
+      return false;
+    }
+    // The consumer mustn't write anything the producer touches.
+    for (const auto& kvp : consumerAccesses.writes) {
+      if (producerAccesses.writes.count(kvp.first) || producerAccesses.reads.count(kvp.first)) {
+        return false;
+      }
+    }
+    DenseSet<unsigned> outputDims;
+    for (unsigned i = 0; i < mapping.size(); i++) {
+      if (mapping[i] < 0 || producerRanges[mapping[i]] != consumerRanges[i] || !outputDims.insert(mapping[i]).second) {
+        return false;
+      }
+    }
+    SmallVector<unsigned, 8> reductionDims;
+    for (unsigned i = 0; i < producerRanges.size(); i++) {
+      if (!outputDims.count(i)) {
+        reductionDims.push_back(i);
+      }
+    }
+    // A value stored within a reduction is only final after the reduction, so
+    // only reduced outputs may be consumed after one.
+    if (!reductionDims.empty()) {
+      for (const auto& kvp : consumerAccesses.reads) {
+        if (producerAccesses.stored.count(kvp.first)) {
+          return false;
+        }
+      }
+    }
+
+    IVLOG(3, "FusionPass> fusing a loop with " << consumerRanges.size() << " indices into one with "
+                                               << producerRanges.size() << " (" << reductionDims.size()
+                                               << " reduction)");
+    for (auto op : between) {
+      op->moveBefore(producer.getOperation());
+    }
+
+    auto loc = producer.getLoc();
+    Block* outerBody = &producer.inner().front();
+    SmallVector<Value, 8> outerArgs;
+    if (reductionDims.empty()) {
+      for (unsigned i = 0; i < mapping.size(); i++) {
+        outerArgs.push_back(outerBody->getArgument(mapping[i]));
+      }
+    } else {
+      // Split the producer into an outer loop over the consumer's indices and
+      // an inner loop over the reduction indices.
+      mlir::OpBuilder builder(producer.getOperation());
+      SmallVector<int64_t, 8> outerRanges(consumerRanges.begin(), consumerRanges.end());
+      auto outer = builder.create<AffineParallelForOp>(loc, builder.getI64ArrayAttr(outerRanges), ArrayRef<Value>{});
+      auto newOuterBody = builder.createBlock(&outer.inner());
+      for (unsigned i = 0; i < outerRanges.size(); i++) {
+        outerArgs.push_back(newOuterBody->addArgument(builder.getIndexType()));
+      }
+      SmallVector<int64_t, 8> innerRanges;
+      for (auto dim : reductionDims) {
+        innerRanges.push_back(producerRanges[dim]);
+      }
+      auto inner = builder.create<AffineParallelForOp>(loc, builder.getI64ArrayAttr(innerRanges), ArrayRef<Value>{});
+      builder.create<AffineTerminatorOp>(loc);
+      auto innerBody = builder.createBlock(&inner.inner());
+      for (unsigned i = 0; i < innerRanges.size(); i++) {
+        innerBody->addArgument(builder.getIndexType());
+      }
+      innerBody->getOperations().splice(innerBody->end(), outerBody->getOperations());
+      for (unsigned i = 0; i < mapping.size(); i++) {
+        outerBody->getArgument(mapping[i]).replaceAllUsesWith(outerArgs[i]);
+      }
+      for (unsigned i = 0; i < reductionDims.size(); i++) {
+        outerBody->getArgument(reductionDims[i]).replaceAllUsesWith(innerBody->getArgument(i));
+      }
+      producer.erase();
+      producer = outer;
+      outerBody = newOuterBody;
+    }
+
+    auto& consumerBody = consumer.inner().front();
+    for (unsigned i = 0; i < outerArgs.size(); i++) {
+      consumerBody.getArgument(i).replaceAllUsesWith(outerArgs[i]);
+    }
+    outerBody->getOperations().splice(std::prev(outerBody->end()), consumerBody.getOperations(),
+                                      consumerBody.begin(), std::prev(consumerBody.end()));
+    consumer.erase();
+    forwardStores(outerBody);
+    return true;
+  }
+
+  // Removes allocations which are only ever written.
+  void eraseDeadAllocs() {
+    SmallVector<AllocOp, 8> allocs;
+    getFunction().walk([&](AllocOp op) { allocs.push_back(op); });
+    for (auto alloc : allocs) {
+      auto memref = alloc.getResult();
+      bool dead = llvm::all_of(memref.getUsers(), [&](Operation* user) {
+        if (auto store = llvm::dyn_cast<AffineStoreOp>(user)) {
+          return store.getValueToStore() != memref;
+        }
+        return llvm::isa<DeallocOp>(user);
+      });
+      if (!dead) {
+        continue;
+      }
+      for (auto user : llvm::make_early_inc_range(memref.getUsers())) {
+        user->erase();
+      }
+      alloc.erase();
+    }
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<mlir::Pass> createFusionPass() {  //
+  return std::make_unique<FusionPass>();
+}
+
+static mlir::PassRegistration<FusionPass> pass(  //
+    "pxa-fusion",                                //
+    "Fuse each pxa.parallel_for into the loop producing its inputs");
+
+}  // namespace pmlc::dialect::pxa
@@ -0,0 +1,97 @@
+// Copyright 2020, Intel Corporation
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <numeric>
+
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/Function.h"
+#include "mlir/Pass/Pass.h"
+
+#include "base/util/logging.h"
+#include "pmlc/dialect/pxa/transforms/passes.h"
+#include "pmlc/dialect/pxa/transforms/stride_info.h"
+
+namespace pmlc::dialect::pxa {
+
+namespace {
+
+struct LoopOrderPass : public mlir::FunctionPass<LoopOrderPass> {
+  void runOnFunction() override;
+};
+
+// Returns the loop's indices from outermost to innermost.  Indices are ordered
+// by descending minimum stride across the loop's accesses; among indices with
+// equal strides, the one with the most unit-stride accesses (counting writes
+// twice, since they're also written back) goes innermost.  Indices which don't
+// affect any address go outermost.
+llvm::SmallVector<unsigned, 8> chooseOrder(AffineParallelForOp op) {
+  auto ranges = getRanges(op);
+  auto accesses = computeStrideInfo(op);
+  llvm::SmallVector<int64_t, 8> minStrides(ranges.size(), std::numeric_limits<int64_t>::max());
+  llvm::SmallVector<unsigned, 8> unitCounts(ranges.size(), 0);
+  for (const auto& access : accesses) {
+    for (unsigned i = 0; i < ranges.size(); i++) {
+      auto stride = std::abs(access.strides[i]);
+      if (!stride || ranges[i] == 1) {
+        continue;
+      }
+      minStrides[i] = std::min(minStrides[i], stride);
+      if (stride == 1) {
+        unitCounts[i] += access.isWrite ? 2 : 1;
+      }
+    }
+  }
+  llvm::SmallVector<unsigned, 8> order(ranges.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](unsigned lhs, unsigned rhs) {
+    if (minStrides[lhs] != minStrides[rhs]) {
+      return minStrides[lhs] > minStrides[rhs];
+    }
+    return unitCounts[lhs] < unitCounts[rhs];
+  });
+  return order;
+}
+
+// Rewrites the loop in place so that its indices appear in the specified order.
+void permute(AffineParallelForOp op, ArrayRef<unsigned> order) {
+  auto& block = op.inner().front();
+  auto ranges = getRanges(op);
+  llvm::SmallVector<Value, 8> oldArgs(block.getArguments().begin(), block.getArguments().end());
+  llvm::SmallVector<int64_t, 8> newRanges;
+  for (auto idx : order) {
+    newRanges.push_back(ranges[idx]);
+    auto arg = block.addArgument(IndexType::get(op.getContext()));
+    oldArgs[idx].replaceAllUsesWith(arg);
+  }
+  for (unsigned i = 0; i < oldArgs.size(); i++) {
+    block.eraseArgument(0);
+  }
+  op.setAttr("ranges", Builder(op.getContext()).getI64ArrayAttr(newRanges));
+}
+
+void LoopOrderPass::runOnFunction() {
+  getFunction().walk([](AffineParallelForOp op) {
+    if (!op.dynamic_ranges().empty()) {
+      return;
+    }
+    auto order = chooseOrder(op);
+    if (!std::is_sorted(order.begin(), order.end())) {
+      IVLOG(3, "LoopOrderPass> reordering a loop with " << order.size() << " indices");
+      permute(op, order);
+    }
+  });
+}
+
+}  // namespace
+
+std::unique_ptr<mlir::Pass> createLoopOrderPass() {  //
+  return std::make_unique<LoopOrderPass>();
+}
+
+static mlir::PassRegistration<LoopOrderPass> pass(  //
+    "pxa-loop-order",                               //
+    "Order the indices of each pxa.parallel_for so that the stride-1 index is innermost");
+
+}  // namespace pmlc::dialect::pxa
@@ -0,0 +1,140 @@
+// Copyright 2020, Intel Corporation
+
+#include "pmlc/dialect/pxa/transforms/parallel.h"
+
+#include <cstdlib>
+
+#include "mlir/Dialect/AffineOps/AffineOps.h"
+#include "mlir/IR/AffineExpr.h"
+
+#include "pmlc/dialect/pxa/transforms/stride_info.h"
+
+namespace pmlc::dialect::pxa {
+
+using llvm::Optional;
+using llvm::SmallVector;
+using mlir::AffineBinaryOpExpr;
+using mlir::AffineConstantExpr;
+using mlir::AffineDimExpr;
+using mlir::AffineExpr;
+using mlir::AffineExprKind;
+using mlir::AffineLoadOp;
+using mlir::AffineStoreOp;
+using mlir::AffineSymbolExpr;
+using mlir::BlockArgument;
+using mlir::ValueRange;
+
+namespace {
+
+// Returns the coefficient of each map operand (dimensions, then symbols) in a
+// linear expression, or None if the expression isn't linear.
+Optional<SmallVector<int64_t, 8>> getCoefficients(AffineExpr expr, unsigned numDims, unsigned numOperands) {
+  SmallVector<int64_t, 8> result(numOperands, 0);
+  switch (expr.getKind()) {
+    case AffineExprKind::Constant:
+      return result;
+    case AffineExprKind::DimId:
+      result[expr.cast<AffineDimExpr>().getPosition()] = 1;
+      return result;
+    case AffineExprKind::SymbolId:
+      result[numDims + expr.cast<AffineSymbolExpr>().getPosition()] = 1;
+      return result;
+    case AffineExprKind::Add: {
+      auto binary = expr.cast<AffineBinaryOpExpr>();
+      auto lhs = getCoefficients(binary.getLHS(), numDims, numOperands);
+      auto rhs = getCoefficients(binary.getRHS(), numDims, numOperands);
+      if (!lhs || !rhs) {
+        return llvm::None;
+      }
+      for (unsigned i = 0; i < numOperands; i++) {
+        result[i] = (*lhs)[i] + (*rhs)[i];
+      }
+      return result;
+    }
+    case AffineExprKind::Mul: {
+      // Constants are always canonicalized onto the right-hand side.
+      auto binary = expr.cast<AffineBinaryOpExpr>();
+      auto factor = binary.getRHS().dyn_cast<AffineConstantExpr>();
+      auto lhs = getCoefficients(binary.getLHS(), numDims, numOperands);
+      if (!factor || !lhs) {
+        return llvm::None;
+      }
+      for (unsigned i = 0; i < numOperands; i++) {
+        result[i] = (*lhs)[i] * factor.getValue();
+      }
+      return result;
+    }
+    default:
+      return llvm::None;
+  }
+}
+
+// Returns the number of values taken by a pxa.parallel_for index, or None if
+// the value isn't one.
+Optional<int64_t> getIndexRange(Value value) {
+  auto arg = value.dyn_cast<BlockArgument>();
+  if (!arg) {
+    return llvm::None;
+  }
+  auto loop = llvm::dyn_cast_or_null<AffineParallelForOp>(arg.getOwner()->getParentOp());
+  if (!loop || !loop.dynamic_ranges().empty()) {
+    return llvm::None;
+  }
+  return getRanges(loop)[arg.getArgNumber()];
+}
+
+// Returns true if writes through the map at distinct values of the index are
+// guaranteed to touch distinct elements: that is, if some result of the map
+// steps by more with each value of the index than all of its other operands
+// can span together.
+bool separatesWrites(Value index, AffineMap map, ValueRange operands) {
+  for (auto expr : map.getResults()) {
+    auto coefficients = getCoefficients(expr, map.getNumDims(), operands.size());
+    if (!coefficients) {
+      continue;
+    }
+    int64_t step = 0;
+    int64_t span = 0;
+    bool bounded = true;
+    for (unsigned i = 0; i < operands.size() && bounded; i++) {
+      auto coefficient = (*coefficients)[i];
+      if (!coefficient) {
+        continue;
+      }
+      if (operands[i] == index) {
+        step += coefficient;
+        continue;
+      }
+      auto range = getIndexRange(operands[i]);
+      if (!range) {
+        bounded = false;
+        continue;
+      }
+      span += std::abs(coefficient) * (*range - 1);
+    }
+    if (bounded && step && span < std::abs(step)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+bool isParallelIndex(AffineParallelForOp op, unsigned argNumber) {
+  auto index = op.inner().front().getArgument(argNumber);
+  bool parallel = true;
+  op.getOperation()->walk([&](Operation* inner) {
+    if (auto store = llvm::dyn_cast<AffineStoreOp>(inner)) {
+      parallel &= separatesWrites(index, store.getAffineMap(), store.getMapOperands());
+    } else if (auto reduce = llvm::dyn_cast<AffineReduceOp>(inner)) {
+      parallel &= separatesWrites(index, reduce.map(), reduce.idxs());
+    } else if (!llvm::isa<AffineLoadOp>(inner) && !llvm::isa<AffineParallelForOp>(inner) &&
+               !llvm::isa<AffineTerminatorOp>(inner) && !inner->hasNoSideEffect()) {
+      parallel = false;
+    }
+  });
+  return parallel;
+}
+
+}  // namespace pmlc::dialect::pxa
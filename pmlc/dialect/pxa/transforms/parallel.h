@@ -0,0 +1,15 @@
+// Copyright 2020, Intel Corporation
+
+#pragma once
+
+#include "pmlc/dialect/pxa/ir/ops.h"
+
+namespace pmlc::dialect::pxa {
+
+// Returns true if the iterations of the loop at distinct values of the index
+// may run concurrently: that is, if each write within the loop (including
+// those in nested loops) provably touches distinct elements at distinct values
+// of the index, and the loop has no other side effects.
+bool isParallelIndex(AffineParallelForOp op, unsigned argNumber);
+
+}  // namespace pmlc::dialect::pxa
@@ -2,8 +2,41 @@
 
 #pragma once
 
+#include <cstdint>
+#include <memory>
+
+namespace mlir {
+class Pass;
+}  // namespace mlir
+
 namespace pmlc::dialect::pxa {
 
-//
+// Reorders the indices of each pxa.parallel_for so that those with the largest
+// memory strides are outermost, leaving the stride-1 index innermost.
+std::unique_ptr<mlir::Pass> createLoopOrderPass();
+
+// Tiles each pxa.parallel_for into an outer and an inner loop, choosing tile
+// sizes with a cache-line cost model such that the memory touched by a single
+// tile fits within a cache of the specified size.
+std::unique_ptr<mlir::Pass> createAutoTilePass(uint64_t cacheBytes);
+
+// Fuses adjacent pxa.parallel_for ops where the second consumes the output of
+// the first element by element, splitting any reduction indices of the first
+// into an inner loop.  Stores forwarded to loads within the fused body leave
+// intermediate allocations unused, and these are removed.
+std::unique_ptr<mlir::Pass> createFusionPass();
+
+// Reduces the memory used by intermediate buffers: an elementwise loop writes
+// its result in place over an input which dies in that loop, and the remaining
+// buffers are placed in a single arena, sharing memory wherever their
+// lifetimes are disjoint.
+std::unique_ptr<mlir::Pass> createBufferReusePass();
+
+// Splits the largest reduction index of each pxa.parallel_for with fewer than
+// minParallelism parallel iterations into chunks of at least minPartialRange
+// values, each reduced in parallel into its own partial result.  A final loop
+// combines the partial results into the output; it may be split again in turn,
+// so that the partial results are combined as a tree.
+std::unique_ptr<mlir::Pass> createSplitReductionPass(int64_t minParallelism, int64_t minPartialRange);
 
 }  // namespace pmlc::dialect::pxa
@@ -0,0 +1,261 @@
+// Copyright 2020, Intel Corporation
+
+#include <deque>
+#include <limits>
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/CommandLine.h"
+
+#include "mlir/Dialect/AffineOps/AffineOps.h"
+#include "mlir/Dialect/StandardOps/Ops.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/Function.h"
+#include "mlir/Pass/Pass.h"
+
+#include "base/util/logging.h"
+#include "pmlc/dialect/pxa/transforms/parallel.h"
+#include "pmlc/dialect/pxa/transforms/passes.h"
+#include "pmlc/dialect/pxa/transforms/stride_info.h"
+
+namespace pmlc::dialect::pxa {
+
+using llvm::Optional;
+using llvm::SmallVector;
+using mlir::AffineApplyOp;
+using mlir::AffineLoadOp;
+using mlir::AffineStoreOp;
+using mlir::AllocOp;
+using mlir::ConstantOp;
+using mlir::OpBuilder;
+
+namespace {
+
+llvm::cl::opt<unsigned> clMinParallelism(  //
+    "pxa-split-reduction-min-parallelism",  //
+    llvm::cl::desc("The number of parallel iterations sought by -pxa-split-reduction"), llvm::cl::init(16));
+
+llvm::cl::opt<unsigned> clMinPartialRange(  //
+    "pxa-split-reduction-min-partial",      //
+    llvm::cl::desc("The fewest values reduced by each partial reduction of -pxa-split-reduction"),
+    llvm::cl::init(4));
+
+// Returns the identity of the aggregation for the element type: the value
+// which leaves any other unchanged when aggregated with it.
+Attribute getIdentity(OpBuilder* builder, AggregationKind agg, Type type) {
+  if (auto floatType = type.dyn_cast<FloatType>()) {
+    auto infinity = std::numeric_limits<double>::infinity();
+    switch (agg) {
+      case AggregationKind::add:
+        return builder->getFloatAttr(floatType, 0.0);
+      case AggregationKind::mul:
+        return builder->getFloatAttr(floatType, 1.0);
+      case AggregationKind::max:
+        return builder->getFloatAttr(floatType, -infinity);
+      case AggregationKind::min:
+        return builder->getFloatAttr(floatType, infinity);
+      default:
+        return {};
+    }
+  }
+  // Integer comparisons in the lowering of pxa.reduce are signed.
+  auto width = type.cast<IntegerType>().getWidth();
+  switch (agg) {
+    case AggregationKind::add:
+      return builder->getIntegerAttr(type, 0);
+    case AggregationKind::mul:
+      return builder->getIntegerAttr(type, 1);
+    case AggregationKind::max:
+      return builder->getIntegerAttr(type, llvm::APInt::getSignedMinValue(width));
+    case AggregationKind::min:
+      return builder->getIntegerAttr(type, llvm::APInt::getSignedMaxValue(width));
+    default:
+      return {};
+  }
+}
+
+// Returns the pxa.reduce which is the only write performed by the loop, if it
+// is directly within the loop's body.
+AffineReduceOp getOnlyReduce(AffineParallelForOp op) {
+  AffineReduceOp result;
+  bool simple = true;
+  op.getOperation()->walk([&](Operation* inner) {
+    if (auto reduce = llvm::dyn_cast<AffineReduceOp>(inner)) {
+      simple &= !result && reduce.getParentOp() == op.getOperation();
+      result = reduce;
+    } else if (inner != op.getOperation() && !llvm::isa<AffineLoadOp>(inner) &&
+               !llvm::isa<AffineTerminatorOp>(inner) && !(inner->hasNoSideEffect() && !inner->getNumRegions())) {
+      simple = false;
+    }
+  });
+  return simple ? result : AffineReduceOp();
+}
+
+class SplitReductionPass : public mlir::FunctionPass<SplitReductionPass> {
+ public:
+  SplitReductionPass(int64_t minParallelism, int64_t minPartialRange)
+      : minParallelism(minParallelism), minPartialRange(minPartialRange) {}
+
+  void runOnFunction() override {
+    std::deque<AffineParallelForOp> worklist;
+    for (auto& block : getFunction().getBody()) {
+      for (auto op : block.getOps<AffineParallelForOp>()) {
+        worklist.push_back(op);
+      }
+    }
+    // The loop combining the partial results may itself be split, which forms
+    // a tree of partial reductions.
+    while (!worklist.empty()) {
+      auto op = worklist.front();
+      worklist.pop_front();
+      if (auto combine = trySplit(op)) {
+        worklist.push_back(combine);
+      }
+    }
+  }
+
+ private:
+  // Splits the loop's largest reduction index if the loop has too few parallel
+  // iterations, returning the loop which combines the partial results.
+  AffineParallelForOp trySplit(AffineParallelForOp op) {
+    if (!op.dynamic_ranges().empty()) {
+      return {};
+    }
+    auto reduce = getOnlyReduce(op);
+    if (!reduce || reduce.map().getNumSymbols()) {
+      return {};
+    }
+    auto agg = reduce.agg();
+    if (agg == AggregationKind::assign) {
+      return {};
+    }
+    auto outType = reduce.out().getType().cast<MemRefType>();
+    if (!outType.hasStaticShape() || !outType.getAffineMaps().empty()) {
+      return {};
+    }
+
+    auto ranges = getRanges(op);
+    int64_t parallelIterations = 1;
+    Optional<unsigned> reductionIndex;
+    for (unsigned i = 0; i < ranges.size(); i++) {
+      if (isParallelIndex(op, i)) {
+        parallelIterations *= ranges[i];
+      } else if (!reductionIndex || ranges[i] > ranges[*reductionIndex]) {
+        reductionIndex = i;
+      }
+    }
+    if (!reductionIndex || parallelIterations >= minParallelism) {
+      return {};
+    }
+    auto range = ranges[*reductionIndex];
+    auto wanted = (minParallelism + parallelIterations - 1) / parallelIterations;
+    int64_t partials = 1;
+    for (int64_t i = 2; i <= wanted && i * minPartialRange <= range; i++) {
+      if (range % i == 0) {
+        partials = i;
+      }
+    }
+    if (partials < 2) {
+      return {};
+    }
+    auto chunk = range / partials;
+    IVLOG(3, "SplitReductionPass> splitting index " << *reductionIndex << " of " << ranges.size() << " with range "
+                                                    << range << " into " << partials << " partial reductions");
+
+    auto loc = op.getLoc();
+    auto elementType = outType.getElementType();
+    OpBuilder builder(op.getOperation());
+    auto identity = builder.create<ConstantOp>(loc, getIdentity(&builder, agg, elementType));
+    SmallVector<int64_t, 8> partialShape{partials};
+    partialShape.append(outType.getShape().begin(), outType.getShape().end());
+    auto partialType = MemRefType::get(partialShape, elementType);
+    auto partial = builder.create<AllocOp>(loc, partialType).getResult();
+
+    // Fill the partial results with the identity.
+    auto init = createLoop(&builder, loc, partialShape);
+    {
+      auto body = &init.inner().front();
+      OpBuilder inner(body->getTerminator());
+      SmallVector<Value, 8> idxs(body->getArguments().begin(), body->getArguments().end());
+      inner.create<AffineStoreOp>(loc, identity, partial, idxs);
+    }
+
+    // Reduce each chunk of the reduction index into its own partial result,
+    // with the chunk as a new (parallel) index.
+    SmallVector<int64_t, 8> splitRanges(ranges.begin(), ranges.end());
+    splitRanges[*reductionIndex] = chunk;
+    splitRanges.push_back(partials);
+    auto split = builder.create<AffineParallelForOp>(loc, builder.getI64ArrayAttr(splitRanges), ArrayRef<Value>{});
+    auto splitBody = builder.createBlock(&split.inner());
+    for (unsigned i = 0; i < splitRanges.size(); i++) {
+      splitBody->addArgument(builder.getIndexType());
+    }
+    auto body = &op.inner().front();
+    splitBody->getOperations().splice(splitBody->end(), body->getOperations());
+    auto partialIndex = splitBody->getArgument(ranges.size());
+    builder.setInsertionPointToStart(splitBody);
+    auto indexMap = AffineMap::get(2, 0, builder.getAffineDimExpr(0) * chunk + builder.getAffineDimExpr(1));
+    SmallVector<Value, 2> indexOperands{partialIndex, splitBody->getArgument(*reductionIndex)};
+    auto index = builder.create<AffineApplyOp>(loc, indexMap, indexOperands);
+    for (unsigned i = 0; i < ranges.size(); i++) {
+      body->getArgument(i).replaceAllUsesWith(i == *reductionIndex ? index.getResult() : splitBody->getArgument(i));
+    }
+    auto map = reduce.map();
+    SmallVector<mlir::AffineExpr, 8> partialResults{builder.getAffineDimExpr(map.getNumDims())};
+    partialResults.append(map.getResults().begin(), map.getResults().end());
+    auto partialMap = AffineMap::get(map.getNumDims() + 1, 0, partialResults);
+    SmallVector<Value, 8> partialIdxs(reduce.idxs().begin(), reduce.idxs().end());
+    partialIdxs.push_back(partialIndex);
+    builder.setInsertionPoint(reduce.getOperation());
+    builder.create<AffineReduceOp>(loc, agg, reduce.val(), partial, partialMap, partialIdxs);
+    auto out = reduce.out();
+    reduce.erase();
+    builder.setInsertionPointAfter(split.getOperation());
+
+    // Combine the partial results into the output, with the partial index as
+    // the combining loop's only reduction.
+    SmallVector<int64_t, 8> combineRanges(outType.getShape().begin(), outType.getShape().end());
+    combineRanges.push_back(partials);
+    auto combine = createLoop(&builder, loc, combineRanges);
+    {
+      auto body = &combine.inner().front();
+      OpBuilder inner(body->getTerminator());
+      auto args = body->getArguments();
+      SmallVector<Value, 8> outIdxs(args.begin(), std::prev(args.end()));
+      SmallVector<Value, 8> partialIdxs{args.back()};
+      partialIdxs.append(outIdxs.begin(), outIdxs.end());
+      auto value = inner.create<AffineLoadOp>(loc, partial, partialIdxs);
+      auto outMap = inner.getMultiDimIdentityMap(outIdxs.size());
+      inner.create<AffineReduceOp>(loc, agg, value, out, outMap, outIdxs);
+    }
+    op.erase();
+    return combine;
+  }
+
+  // Creates a loop over the ranges whose body holds only its terminator.
+  static AffineParallelForOp createLoop(OpBuilder* builder, Location loc, ArrayRef<int64_t> ranges) {
+    auto loop = builder->create<AffineParallelForOp>(loc, builder->getI64ArrayAttr(ranges), ArrayRef<Value>{});
+    OpBuilder::InsertionGuard guard(*builder);
+    auto body = builder->createBlock(&loop.inner());
+    for (unsigned i = 0; i < ranges.size(); i++) {
+      body->addArgument(builder->getIndexType());
+    }
+    builder->create<AffineTerminatorOp>(loc);
+    return loop;
+  }
+
+  int64_t minParallelism;
+  int64_t minPartialRange;
+};
+
+}  // namespace
+
+std::unique_ptr<mlir::Pass> createSplitReductionPass(int64_t minParallelism, int64_t minPartialRange) {
+  return std::make_unique<SplitReductionPass>(minParallelism, minPartialRange);
+}
+
+static mlir::PassRegistration<SplitReductionPass> pass(  //
+    "pxa-split-reduction",                               //
+    "Split the reductions of loops with little parallelism into parallel partial reductions",
+    [] { return std::make_unique<SplitReductionPass>(clMinParallelism, clMinPartialRange); });
+
+}  // namespace pmlc::dialect::pxa
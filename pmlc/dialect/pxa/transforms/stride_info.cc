@@ -0,0 +1,146 @@
+// Copyright 2020, Intel Corporation
+
+#include "pmlc/dialect/pxa/transforms/stride_info.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "mlir/IR/AffineExpr.h"
+#include "mlir/IR/StandardTypes.h"
+
+namespace pmlc::dialect::pxa {
+
+using mlir::AffineConstantExpr;
+using mlir::AffineExpr;
+using mlir::AffineLoadOp;
+using mlir::AffineStoreOp;
+
+namespace {
+
+// Evaluates the map's results at the specified operand (dimension and symbol)
+// values, or returns None if the map doesn't fold to constants.
+llvm::Optional<llvm::SmallVector<int64_t, 8>> evaluate(AffineMap map, ArrayRef<int64_t> operands) {
+  auto ctx = map.getContext();
+  llvm::SmallVector<AffineExpr, 8> dims;
+  llvm::SmallVector<AffineExpr, 8> syms;
+  for (unsigned i = 0; i < map.getNumDims(); i++) {
+    dims.push_back(mlir::getAffineConstantExpr(operands[i], ctx));
+  }
+  for (unsigned i = 0; i < map.getNumSymbols(); i++) {
+    syms.push_back(mlir::getAffineConstantExpr(operands[map.getNumDims() + i], ctx));
+  }
+  llvm::SmallVector<int64_t, 8> results;
+  for (auto expr : map.getResults()) {
+    auto folded = expr.replaceDimsAndSymbols(dims, syms).dyn_cast<AffineConstantExpr>();
+    if (!folded) {
+      return llvm::None;
+    }
+    results.push_back(folded.getValue());
+  }
+  return results;
+}
+
+void addAccess(AffineParallelForOp op, Value memref, AffineMap map, ValueRange operands, bool isWrite,
+               llvm::SmallVectorImpl<StrideInfo>* accesses) {
+  auto type = memref.getType().dyn_cast<MemRefType>();
+  if (!type) {
+    return;
+  }
+  auto elementType = type.getElementType();
+  if (!elementType.isa<IntegerType>() && !elementType.isa<FloatType>()) {
+    return;
+  }
+  llvm::SmallVector<int64_t, 8> layout;
+  int64_t offset;
+  if (failed(mlir::getStridesAndOffset(type, layout, offset))) {
+    return;
+  }
+  for (auto stride : layout) {
+    if (stride == MemRefType::getDynamicStrideOrOffset()) {
+      return;
+    }
+  }
+
+  llvm::SmallVector<int64_t, 8> values(operands.size(), 0);
+  auto base = evaluate(map, values);
+  if (!base) {
+    return;
+  }
+
+  StrideInfo info{memref, std::max(1u, elementType.getIntOrFloatBitWidth() / 8), isWrite, {}};
+  for (auto arg : op.inner().front().getArguments()) {
+    for (unsigned i = 0; i < operands.size(); i++) {
+      values[i] = operands[i] == arg ? 1 : 0;
+    }
+    auto point = evaluate(map, values);
+    if (!point) {
+      return;
+    }
+    int64_t stride = 0;
+    for (unsigned i = 0; i < point->size(); i++) {
+      stride += layout[i] * ((*point)[i] - (*base)[i]);
+    }
+    info.strides.push_back(stride);
+  }
+  accesses->push_back(info);
+}
+
+}  // namespace
+
+llvm::SmallVector<StrideInfo, 8> computeStrideInfo(AffineParallelForOp op) {
+  llvm::SmallVector<StrideInfo, 8> accesses;
+  op.getOperation()->walk([&](Operation* inner) {
+    if (auto load = llvm::dyn_cast<AffineLoadOp>(inner)) {
+      addAccess(op, load.getMemRef(), load.getAffineMap(), load.getMapOperands(), false, &accesses);
+    } else if (auto store = llvm::dyn_cast<AffineStoreOp>(inner)) {
+      addAccess(op, store.getMemRef(), store.getAffineMap(), store.getMapOperands(), true, &accesses);
+    } else if (auto reduce = llvm::dyn_cast<AffineReduceOp>(inner)) {
+      addAccess(op, reduce.out(), reduce.map(), reduce.idxs(), true, &accesses);
+    }
+  });
+  return accesses;
+}
+
+// The index with the smallest stride walks along cache lines; each other index
+// which affects the address multiplies the number of lines touched.
+int64_t getLinesTouched(const StrideInfo& access, ArrayRef<int64_t> tile) {
+  int inner = -1;
+  for (unsigned i = 0; i < tile.size(); i++) {
+    auto stride = std::abs(access.strides[i]);
+    if (stride && (inner < 0 || stride < std::abs(access.strides[inner]))) {
+      inner = i;
+    }
+  }
+  if (inner < 0) {
+    return 1;
+  }
+  int64_t elementsPerLine = std::max<int64_t>(1, kCacheLineBytes / access.elementBytes);
+  auto innerStride = std::abs(access.strides[inner]);
+  int64_t lines = innerStride < elementsPerLine  //
+                      ? (tile[inner] * innerStride + elementsPerLine - 1) / elementsPerLine
+                      : tile[inner];
+  for (unsigned i = 0; i < tile.size(); i++) {
+    if (i != static_cast<unsigned>(inner) && access.strides[i]) {
+      lines *= tile[i];
+    }
+  }
+  return lines;
+}
+
+int64_t getFootprint(ArrayRef<StrideInfo> accesses, ArrayRef<int64_t> tile) {
+  int64_t lines = 0;
+  for (const auto& access : accesses) {
+    lines += getLinesTouched(access, tile);
+  }
+  return lines * kCacheLineBytes;
+}
+
+llvm::SmallVector<int64_t, 8> getRanges(AffineParallelForOp op) {
+  llvm::SmallVector<int64_t, 8> ranges;
+  for (auto attr : op.ranges().getValue()) {
+    ranges.push_back(attr.cast<IntegerAttr>().getInt());
+  }
+  return ranges;
+}
+
+}  // namespace pmlc::dialect::pxa
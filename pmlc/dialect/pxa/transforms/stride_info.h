@@ -0,0 +1,42 @@
+// Copyright 2020, Intel Corporation
+
+#pragma once
+
+#include "llvm/ADT/SmallVector.h"
+
+#include "pmlc/dialect/pxa/ir/ops.h"
+
+namespace pmlc::dialect::pxa {
+
+// A memory access made from within the body of a pxa.parallel_for, reduced to
+// the linear stride (in elements) that each of the loop's indices contributes
+// to the accessed address.
+struct StrideInfo {
+  Value memref;
+  unsigned elementBytes;
+  bool isWrite;
+  // Indexed by the loop's argument number; zero for indices which don't
+  // affect the address.
+  llvm::SmallVector<int64_t, 8> strides;
+};
+
+// Returns the accesses made within the body of the loop, including those
+// made by nested operations.  Accesses whose layout isn't statically known are
+// skipped.
+llvm::SmallVector<StrideInfo, 8> computeStrideInfo(AffineParallelForOp op);
+
+// The size of a cache line, which is the unit of memory traffic for the cost
+// models built on these accesses.
+constexpr int64_t kCacheLineBytes = 64;
+
+// Returns the number of distinct cache lines touched by the access over a
+// tile of the loop's iteration space (indexed by the loop's argument number).
+int64_t getLinesTouched(const StrideInfo& access, ArrayRef<int64_t> tile);
+
+// Returns the bytes of cache occupied by the accesses over a tile.
+int64_t getFootprint(ArrayRef<StrideInfo> accesses, ArrayRef<int64_t> tile);
+
+// Returns the static ranges of the loop.
+llvm::SmallVector<int64_t, 8> getRanges(AffineParallelForOp op);
+
+}  // namespace pmlc::dialect::pxa
@@ -0,0 +1,40 @@
+// RUN: pmlc-opt -pxa-autotile -pxa-autotile-cache-size=16 %s | FileCheck %s
+
+#map = (i, j, k) -> (i, j)
+
+func @dot(%arg0: memref<64x64xf32>, %arg1: memref<64x64xf32>, %arg2: memref<64x64xf32>) {
+  "pxa.parallel_for"() ( {
+  ^bb0(%i: index, %j: index, %k: index):
+    %0 = affine.load %arg0[%i, %k] : memref<64x64xf32>
+    %1 = affine.load %arg1[%k, %j] : memref<64x64xf32>
+    %2 = mulf %0, %1 : f32
+    "pxa.reduce"(%2, %arg2, %i, %j, %k) {agg = 1 : i64, map = #map} : (f32, memref<64x64xf32>, index, index, index) -> ()
+    "affine.terminator"() : () -> ()
+  }) {ranges = [64, 64, 64]} : () -> ()
+  return
+}
+
+// CHECK-LABEL: func @dot
+// CHECK: pxa.parallel_for
+// CHECK: pxa.parallel_for
+// CHECK: affine.apply
+// CHECK: affine.load %arg0
+// CHECK: affine.load %arg1
+// CHECK: pxa.reduce
+// CHECK: ranges = [16, 32, 64]
+// CHECK: ranges = [4, 2, 1]
+
+func @eltwise(%arg0: memref<64x64xf32>, %arg1: memref<64x64xf32>) {
+  "pxa.parallel_for"() ( {
+  ^bb0(%i: index, %j: index):
+    %0 = affine.load %arg0[%i, %j] : memref<64x64xf32>
+    affine.store %0, %arg1[%i, %j] : memref<64x64xf32>
+    "affine.terminator"() : () -> ()
+  }) {ranges = [64, 64]} : () -> ()
+  return
+}
+
+// CHECK-LABEL: func @eltwise
+// CHECK: pxa.parallel_for
+// CHECK-NOT: pxa.parallel_for
+// CHECK: ranges = [64, 64]
@@ -0,0 +1,62 @@
+// RUN: pmlc-opt -pxa-buffer-reuse %s | FileCheck %s
+
+// CHECK-DAG: #[[BASE:.*]] = (d0, d1) -> (d0 * 8 + d1)
+// CHECK-DAG: #[[SHIFTED:.*]] = (d0, d1) -> (d0 * 8 + d1 + 64)
+
+func @reuse(%arg0: memref<8x8xf32>, %arg1: memref<8x8xf32>) {
+  %0 = alloc() : memref<8x8xf32>
+  %1 = alloc() : memref<8x8xf32>
+  %2 = alloc() : memref<8x8xf32>
+  %3 = alloc() : memref<8x8xf32>
+  "pxa.parallel_for"() ( {
+  ^bb0(%i: index, %j: index):
+    %4 = affine.load %arg0[%i, %j] : memref<8x8xf32>
+    affine.store %4, %0[%i, %j] : memref<8x8xf32>
+    "affine.terminator"() : () -> ()
+  }) {ranges = [8, 8]} : () -> ()
+  "pxa.parallel_for"() ( {
+  ^bb0(%i: index, %j: index):
+    %4 = affine.load %0[%i, %j] : memref<8x8xf32>
+    %5 = mulf %4, %4 : f32
+    affine.store %5, %1[%i, %j] : memref<8x8xf32>
+    "affine.terminator"() : () -> ()
+  }) {ranges = [8, 8]} : () -> ()
+  "pxa.parallel_for"() ( {
+  ^bb0(%i: index, %j: index):
+    %4 = affine.load %1[%j, %i] : memref<8x8xf32>
+    affine.store %4, %2[%i, %j] : memref<8x8xf32>
+    "affine.terminator"() : () -> ()
+  }) {ranges = [8, 8]} : () -> ()
+  "pxa.parallel_for"() ( {
+  ^bb0(%i: index, %j: index):
+    %4 = affine.load %2[%j, %i] : memref<8x8xf32>
+    affine.store %4, %3[%i, %j] : memref<8x8xf32>
+    "affine.terminator"() : () -> ()
+  }) {ranges = [8, 8]} : () -> ()
+  "pxa.parallel_for"() ( {
+  ^bb0(%i: index, %j: index):
+    %4 = affine.load %3[%i, %j] : memref<8x8xf32>
+    affine.store %4, %arg1[%i, %j] : memref<8x8xf32>
+    "affine.terminator"() : () -> ()
+  }) {ranges = [8, 8]} : () -> ()
+  return
+}
+
+// The elementwise result is written in place over its input, and the buffers
+// which remain share an arena: the first and last are never live together.
+// CHECK-LABEL: func @reuse
+// CHECK: %[[ARENA:.*]] = alloc() : memref<512xi8>
+// CHECK-NEXT: %[[A:.*]] = std.view %[[ARENA]][][] : memref<512xi8> to memref<8x8xf32, #[[BASE]]>
+// CHECK-NEXT: %[[B:.*]] = std.view %[[ARENA]][][] : memref<512xi8> to memref<8x8xf32, #[[SHIFTED]]>
+// CHECK-NEXT: %[[C:.*]] = std.view %[[ARENA]][][] : memref<512xi8> to memref<8x8xf32, #[[BASE]]>
+// CHECK-NOT: alloc
+// CHECK: affine.store %{{.*}}, %[[A]]
+// CHECK: affine.load %[[A]]
+// CHECK: affine.store %{{.*}}, %[[A]]
+// CHECK: affine.load %[[A]]
+// CHECK: affine.store %{{.*}}, %[[B]]
+// CHECK: affine.load %[[B]]
+// CHECK: affine.store %{{.*}}, %[[C]]
+// CHECK: affine.load %[[C]]
+// CHECK: dealloc %[[ARENA]]
+// CHECK-NEXT: return
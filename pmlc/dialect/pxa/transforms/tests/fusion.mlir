@@ -0,0 +1,74 @@
+// RUN: pmlc-opt -pxa-fusion %s | FileCheck %s
+
+#map = (i, j, k) -> (i, j)
+
+func @eltwise_chain(%arg0: memref<16x8xf32>, %arg1: memref<16x8xf32>) {
+  %0 = alloc() : memref<16x8xf32>
+  "pxa.parallel_for"() ( {
+  ^bb0(%i: index, %j: index):
+    %1 = affine.load %arg0[%i, %j] : memref<16x8xf32>
+    %2 = addf %1, %1 : f32
+    affine.store %2, %0[%i, %j] : memref<16x8xf32>
+    "affine.terminator"() : () -> ()
+  }) {ranges = [16, 8]} : () -> ()
+  "pxa.parallel_for"() ( {
+  ^bb0(%i: index, %j: index):
+    %1 = affine.load %0[%i, %j] : memref<16x8xf32>
+    %2 = mulf %1, %1 : f32
+    affine.store %2, %arg1[%i, %j] : memref<16x8xf32>
+    "affine.terminator"() : () -> ()
+  }) {ranges = [16, 8]} : () -> ()
+  return
+}
+
+// CHECK-LABEL: func @eltwise_chain
+// CHECK-NOT: alloc
+// CHECK: ^bb0(%[[I:.*]]: index, %[[J:.*]]: index):
+// CHECK-NEXT:   %[[X:.*]] = affine.load %arg0[%[[I]], %[[J]]]
+// CHECK-NEXT:   %[[Y:.*]] = addf %[[X]], %[[X]]
+// CHECK-NEXT:   %[[Z:.*]] = mulf %[[Y]], %[[Y]]
+// CHECK-NEXT:   affine.store %[[Z]], %arg1[%[[I]], %[[J]]]
+// CHECK-NOT: pxa.parallel_for
+// CHECK: return
+
+func @contraction_eltwise(%arg0: memref<16x32xf32>, %arg1: memref<32x8xf32>, %arg2: memref<16x8xf32>, %arg3: memref<16x8xf32>) {
+  %0 = alloc() : memref<16x8xf32>
+  "pxa.parallel_for"() ( {
+  ^bb0(%i: index, %j: index, %k: index):
+    %1 = affine.load %arg0[%i, %k] : memref<16x32xf32>
+    %2 = affine.load %arg1[%k, %j] : memref<32x8xf32>
+    %3 = mulf %1, %2 : f32
+    "pxa.reduce"(%3, %0, %i, %j, %k) {agg = 1 : i64, map = #map} : (f32, memref<16x8xf32>, index, index, index) -> ()
+    "affine.terminator"() : () -> ()
+  }) {ranges = [16, 8, 32]} : () -> ()
+  %4 = alloc() : memref<16x8xf32>
+  "pxa.parallel_for"() ( {
+  ^bb0(%i: index, %j: index):
+    %1 = affine.load %0[%i, %j] : memref<16x8xf32>
+    %2 = affine.load %arg2[%i, %j] : memref<16x8xf32>
+    %3 = addf %1, %2 : f32
+    affine.store %3, %4[%i, %j] : memref<16x8xf32>
+    "affine.terminator"() : () -> ()
+  }) {ranges = [16, 8]} : () -> ()
+  "pxa.parallel_for"() ( {
+  ^bb0(%i: index, %j: index):
+    %1 = affine.load %4[%i, %j] : memref<16x8xf32>
+    affine.store %1, %arg3[%i, %j] : memref<16x8xf32>
+    "affine.terminator"() : () -> ()
+  }) {ranges = [16, 8]} : () -> ()
+  return
+}
+
+// CHECK-LABEL: func @contraction_eltwise
+// CHECK: %[[ACC:.*]] = alloc()
+// CHECK-NOT: alloc
+// CHECK: ^bb0(%[[I:.*]]: index, %[[J:.*]]: index):
+// CHECK:   ^bb0(%[[K:.*]]: index):
+// CHECK:     pxa.reduce
+// CHECK:   ranges = [32]
+// CHECK:   %[[X:.*]] = affine.load %[[ACC]][%[[I]], %[[J]]]
+// CHECK:   %[[Y:.*]] = affine.load %arg2[%[[I]], %[[J]]]
+// CHECK:   %[[Z:.*]] = addf %[[X]], %[[Y]]
+// CHECK-NEXT:   affine.store %[[Z]], %arg3[%[[I]], %[[J]]]
+// CHECK: ranges = [16, 8]
+// CHECK-NOT: pxa.parallel_for
@@ -0,0 +1,32 @@
+// RUN: pmlc-opt -pxa-loop-order %s | FileCheck %s
+
+func @transpose_order(%arg0: memref<64x32xf32>, %arg1: memref<64x32xf32>) {
+  "pxa.parallel_for"() ( {
+  ^bb0(%i: index, %j: index):
+    %0 = affine.load %arg0[%j, %i] : memref<64x32xf32>
+    affine.store %0, %arg1[%j, %i] : memref<64x32xf32>
+    "affine.terminator"() : () -> ()
+  }) {ranges = [32, 64]} : () -> ()
+  return
+}
+
+// CHECK-LABEL: func @transpose_order
+// CHECK: ^bb0(%[[J:.*]]: index, %[[I:.*]]: index):
+// CHECK:   affine.load %arg0[%[[J]], %[[I]]]
+// CHECK:   affine.store %{{.*}}, %arg1[%[[J]], %[[I]]]
+// CHECK: ranges = [64, 32]
+
+func @already_ordered(%arg0: memref<64x32xf32>, %arg1: memref<64x32xf32>) {
+  "pxa.parallel_for"() ( {
+  ^bb0(%i: index, %j: index):
+    %0 = affine.load %arg0[%i, %j] : memref<64x32xf32>
+    affine.store %0, %arg1[%i, %j] : memref<64x32xf32>
+    "affine.terminator"() : () -> ()
+  }) {ranges = [64, 32]} : () -> ()
+  return
+}
+
+// CHECK-LABEL: func @already_ordered
+// CHECK: ^bb0(%[[I:.*]]: index, %[[J:.*]]: index):
+// CHECK:   affine.load %arg0[%[[I]], %[[J]]]
+// CHECK: ranges = [64, 32]
@@ -0,0 +1,50 @@
+// RUN: pmlc-opt -pxa-split-reduction %s | FileCheck %s
+
+#sum = (i) -> (0)
+
+func @global_sum(%arg0: memref<64xf32>, %arg1: memref<1xf32>) {
+  "pxa.parallel_for"() ( {
+  ^bb0(%i: index):
+    %0 = affine.load %arg0[%i] : memref<64xf32>
+    "pxa.reduce"(%0, %arg1, %i) {agg = 1 : i64, map = #sum} : (f32, memref<1xf32>, index) -> ()
+    "affine.terminator"() : () -> ()
+  }) {ranges = [64]} : () -> ()
+  return
+}
+
+// CHECK-LABEL: func @global_sum
+// CHECK: %[[ZERO:.*]] = constant 0.000000e+00 : f32
+// CHECK: %[[P0:.*]] = alloc() : memref<16x1xf32>
+// CHECK: ^bb0(%[[A:.*]]: index, %[[B:.*]]: index):
+// CHECK:   affine.store %[[ZERO]], %[[P0]][%[[A]], %[[B]]]
+// CHECK: }) {ranges = [16, 1]}
+// CHECK: ^bb0(%[[I:.*]]: index, %[[P:.*]]: index):
+// CHECK:   %[[IDX:.*]] = affine.apply #{{.*}}(%[[P]], %[[I]])
+// CHECK:   %[[X:.*]] = affine.load %arg0[%[[IDX]]]
+// CHECK:   "pxa.reduce"(%[[X]], %[[P0]], %[[IDX]], %[[P]])
+// CHECK: }) {ranges = [4, 16]}
+// The combining loop is split in turn.
+// CHECK: alloc() : memref<4x1xf32>
+// CHECK: }) {ranges = [4, 1]}
+// CHECK: }) {ranges = [1, 4, 4]}
+// CHECK: "pxa.reduce"({{.*}}, %arg1,
+// CHECK: }) {ranges = [1, 4]}
+// CHECK: return
+
+#dot = (i, j, k) -> (i, j)
+
+func @wide_output(%arg0: memref<64x32xf32>, %arg1: memref<32x64xf32>, %arg2: memref<64x64xf32>) {
+  "pxa.parallel_for"() ( {
+  ^bb0(%i: index, %j: index, %k: index):
+    %0 = affine.load %arg0[%i, %k] : memref<64x32xf32>
+    %1 = affine.load %arg1[%k, %j] : memref<32x64xf32>
+    %2 = mulf %0, %1 : f32
+    "pxa.reduce"(%2, %arg2, %i, %j, %k) {agg = 1 : i64, map = #dot} : (f32, memref<64x64xf32>, index, index, index) -> ()
+    "affine.terminator"() : () -> ()
+  }) {ranges = [64, 64, 32]} : () -> ()
+  return
+}
+
+// CHECK-LABEL: func @wide_output
+// CHECK-NOT: alloc
+// CHECK: }) {ranges = [64, 64, 32]}
@@ -26,9 +26,8 @@ namespace dialect {
 namespace stripe {
 
 using vertexai::tile::codegen::proto::MLIR_AutoStencilPass;
-using vertexai::tile::targets::cpu::kHeatmapKeys;
-using vertexai::tile::targets::cpu::kHeatmapSize;
-using vertexai::tile::targets::cpu::kHeatmapValues;
+using vertexai::tile::targets::cpu::Heatmap;
+using vertexai::tile::targets::cpu::HostHeatmap;
 using BlockArgumentSet = llvm::SmallPtrSet<mlir::BlockArgument, 8>;
 
 // Number of tensors for the matrix multiplication
@@ -74,7 +73,7 @@ class AutoStencil {
   // Optimization options
   const MLIR_AutoStencilPass& options;
   // Stencil efficiency heatmap
-  std::map<std::tuple<unsigned, unsigned, unsigned>, double> kHeatmap;
+  const Heatmap& kHeatmap;
   // The current op
   ParallelForOp curOp;
   // Tensors' order
@@ -109,11 +108,7 @@ class AutoStencil {
   unsigned bestTiles[kNumIndex];
 };
 
-AutoStencil::AutoStencil(const MLIR_AutoStencilPass& opts) : options(opts) {
-  for (unsigned i = 0; i < kHeatmapSize; ++i) {
-    kHeatmap.emplace(std::make_tuple(kHeatmapKeys[i][0], kHeatmapKeys[i][1], kHeatmapKeys[i][2]), kHeatmapValues[i]);
-  }
-}
+AutoStencil::AutoStencil(const MLIR_AutoStencilPass& opts) : options(opts), kHeatmap(HostHeatmap()) {}
 
 std::pair<double, unsigned> AutoStencil::Throughput(unsigned m, unsigned n, unsigned k) {
   auto iter = kHeatmap.find(std::make_tuple(m, n, k));
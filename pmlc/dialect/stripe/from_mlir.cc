@@ -317,8 +317,7 @@ struct RefinementBuilder {
         for (size_t i = 0; i < ndims; i++) {
           auto range = AffineRange(inner[i]);
           if (!isSpecial) {
-            shape.dims[i].size = range.max - range.min + 1;
-            shape.dims[i].size = std::min(shape.dims[i].size, shape.dims[i].size);
+            shape.dims.set_size(i, range.max - range.min + 1);
           }
           access[i] += constants[i];
           constants[i] = 0;
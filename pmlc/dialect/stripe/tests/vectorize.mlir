@@ -6,6 +6,7 @@
 !fp32_0 = type !stripe<"tensor_ref !eltwise.fp32:0">
 !fp32_1 = type !stripe<"tensor_ref !eltwise.fp32:1">
 !fp32_4 = type !stripe<"tensor_ref !eltwise.fp32:1">
+!fp32_2 = type !stripe<"tensor_ref !eltwise.fp32:2">
 
 // CHECK-LABEL: @simple_accum
 func @simple_accum(
@@ -22,8 +23,11 @@ func @simple_accum(
   stripe.terminate
   // CHECK: stripe.parallel_for ("i":4)
   // CHECK: ^bb0(%[[i1:.*]]: !aff)
+  // CHECK: stripe.constraint
   // CHECK: stripe.parallel_for ("i":32)
   // CHECK: ^bb0(%[[i2:.*]]: !aff)
+  // CHECK-NOT: stripe.constraint
+  // CHECK: stripe.load {{.*}}vector_tx
 
   // JIGSAW: parallel_for ("i":3)
   // JIGSAW: ^bb0(%[[i1:.*]]: !aff)
@@ -38,3 +42,25 @@ func @simple_accum(
   // JIGSAW: terminate
 }
 
+// CHECK-LABEL: @transpose
+func @transpose(
+    %out: !fp32_2 {stripe.layout = !stripe<"tensor !eltwise.fp32([16:64], [64:1])">},
+    %in: !fp32_2 {stripe.layout = !stripe<"tensor !eltwise.fp32([64:16], [16:1])">}) {
+
+  stripe.parallel_for ("i":16, "j":64) {
+  ^bb0(%i: !aff, %j: !aff):
+    %0 = stripe.refine %in (%j, %i) : !fp32_2
+    %1 = stripe.load %0 : !fp32_2
+    %2 = stripe.refine %out (%i, %j) : !fp32_2
+    stripe.store %2, %1 : !fp32_2
+    stripe.terminate
+  }
+  stripe.terminate
+  // Each index is contiguous in one refinement, so the larger one (j) is picked
+  // CHECK: stripe.parallel_for ("i":16, "j":2)
+  // CHECK: stripe.parallel_for ("i":1, "j":32)
+  // CHECK-NOT: stripe.constraint
+  // CHECK: stripe.load
+  // CHECK-NOT: vector_tx
+  // CHECK: stripe.store {{.*}}vector_tx
+}
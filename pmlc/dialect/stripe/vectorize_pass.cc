@@ -0,0 +1,232 @@
+// Copyright 2019, Intel Corporation
+
+#include "pmlc/dialect/stripe/vectorize_pass.h"
+
+#include <algorithm>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "base/util/logging.h"
+#include "pmlc/dialect/stripe/analysis.h"
+#include "pmlc/dialect/stripe/ops.h"
+#include "pmlc/dialect/stripe/transforms.h"
+#include "pmlc/dialect/stripe/util.h"
+#include "tile/stripe/stripe.h"
+
+namespace pmlc {
+namespace dialect {
+namespace stripe {
+
+using vertexai::tile::codegen::proto::MLIR_VectorizePass;
+
+namespace {
+
+// A refinement which is loaded from or stored into within the block being vectorized
+struct VectorRef {
+  RefineOp op;
+  bool read = false;
+  bool write = false;
+  // The access polynomial in elements of the base tensor
+  AffinePolynomial flat;
+  // The element size of the tensor
+  size_t elem_size;
+};
+
+// Convert an alignment in bytes into an alignment in elements, or return 0 if
+// the alignment isn't compatible with the element size.
+int64_t AlignElements(uint32_t align_bytes, size_t elem_size) {
+  if (align_bytes == 0) {
+    return 1;
+  }
+  if (align_bytes >= elem_size) {
+    return align_bytes % elem_size == 0 ? align_bytes / elem_size : 0;
+  }
+  return elem_size % align_bytes == 0 ? 1 : 0;
+}
+
+class Vectorizer {
+ public:
+  explicit Vectorizer(const MLIR_VectorizePass& options)
+      : options_(options), ref_reqs_(vertexai::tile::stripe::FromProto(options.ref_reqs())) {}
+
+  void Vectorize(ParallelForOp op);
+
+ private:
+  // Collect the refinements in op's body which are loaded from or stored into
+  std::vector<VectorRef> CollectRefs(ParallelForOp op);
+  // Whether a contiguous access along idx keeps the remaining terms aligned
+  bool IsAligned(const VectorRef& ref, BlockArgument idx);
+  // Tag the loads and stores of the given refinements as vector transfers
+  void TagTransfers(ParallelForOp op, const std::set<mlir::Operation*>& refs);
+
+  const MLIR_VectorizePass& options_;
+  std::set<std::string> ref_reqs_;
+};
+
+std::vector<VectorRef> Vectorizer::CollectRefs(ParallelForOp op) {
+  std::vector<VectorRef> refs;
+  op.getOperation()->walk([&](RefineOp ref_op) {
+    if (!ref_reqs_.empty() && !hasAttrs(ref_op.getOperation(), ref_reqs_)) {
+      return;
+    }
+    VectorRef ref;
+    ref.op = ref_op;
+    for (auto user : ref_op.result().getUsers()) {
+      if (mlir::isa<LoadOp>(user)) {
+        ref.read = true;
+      } else if (mlir::isa<StoreOp>(user) || mlir::isa<AggregateOp>(user)) {
+        ref.write = true;
+      }
+    }
+    if (!ref.read && !ref.write) {
+      return;
+    }
+    auto access = ComputeAccess(ref_op.result());
+    auto shape = access.base_type.getShape();
+    for (size_t i = 0; i < access.access.size(); i++) {
+      ref.flat += access.access[i] * shape[i].stride;
+    }
+    ref.elem_size = byte_width(tensorElementType(ref_op.result()));
+    refs.push_back(ref);
+  });
+  return refs;
+}
+
+bool Vectorizer::IsAligned(const VectorRef& ref, BlockArgument idx) {
+  if (ref.elem_size == 0) {
+    throw std::runtime_error("Refinement has data type with zero size");
+  }
+  int64_t align = 1;
+  for (auto [dir, align_bytes] : {std::make_pair(ref.read, options_.read_align_bytes()),
+                                  std::make_pair(ref.write, options_.write_align_bytes())}) {
+    if (!dir) {
+      continue;
+    }
+    int64_t elems = AlignElements(align_bytes, ref.elem_size);
+    if (elems == 0) {
+      return false;
+    }
+    align = std::max(align, elems);
+  }
+  if (ref.flat.constant % align != 0) {
+    return false;
+  }
+  for (auto [arg, scale] : ref.flat.terms) {
+    if (arg != idx && scale % align != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void Vectorizer::TagTransfers(ParallelForOp op, const std::set<mlir::Operation*>& refs) {
+  OpBuilder builder(op.getOperation());
+  op.getOperation()->walk([&](mlir::Operation* inner) {
+    Value tensor;
+    if (auto load = mlir::dyn_cast<LoadOp>(inner)) {
+      tensor = load.from();
+    } else if (auto store = mlir::dyn_cast<StoreOp>(inner)) {
+      tensor = store.into();
+    } else {
+      return;
+    }
+    if (refs.count(tensor.getDefiningOp())) {
+      setOpAttrUnit(inner, builder, "vector_tx");
+    }
+  });
+}
+
+// Pick the index which is stride 1 and aligned in the most refinements
+// (breaking ties by the fewest strided accesses, then by the largest range),
+// tile the block so that the index is the only one left in the interior, and
+// lift the remainder constraint of an uneven split out of the vector loop.
+void Vectorizer::Vectorize(ParallelForOp op) {
+  auto refs = CollectRefs(op);
+  auto body = op.getBody();
+  int best_idx = -1;
+  size_t best_contiguous = 0;
+  size_t best_strided = 0;
+  for (unsigned i = 0; i < op.ranges().size(); i++) {
+    if (op.getRange(i) <= 1) {
+      continue;
+    }
+    BlockArgument idx = body->getArgument(i);
+    size_t contiguous = 0;
+    size_t strided = 0;
+    for (const auto& ref : refs) {
+      auto it = ref.flat.terms.find(idx);
+      if (it == ref.flat.terms.end()) {
+        continue;
+      }
+      if (it->second == 1 && IsAligned(ref, idx)) {
+        contiguous++;
+      } else {
+        strided++;
+      }
+    }
+    if (contiguous == 0) {
+      continue;
+    }
+    if (best_idx < 0 || contiguous > best_contiguous ||
+        (contiguous == best_contiguous &&
+         (strided < best_strided || (strided == best_strided && op.getRange(i) > op.getRange(best_idx))))) {
+      best_idx = i;
+      best_contiguous = contiguous;
+      best_strided = strided;
+    }
+  }
+  if (best_idx < 0) {
+    IVLOG(3, "VectorizePass: no stride 1 index, skipping");
+    return;
+  }
+  BlockArgument idx = body->getArgument(best_idx);
+  std::set<mlir::Operation*> vector_refs;
+  for (const auto& ref : refs) {
+    auto it = ref.flat.terms.find(idx);
+    if (it != ref.flat.terms.end() && it->second == 1 && IsAligned(ref, idx)) {
+      vector_refs.insert(ref.op.getOperation());
+    }
+  }
+  int64_t width = std::min<int64_t>(std::max<uint32_t>(options_.vector_width(), 1), op.getRange(best_idx));
+  IVLOG(2, "VectorizePass: index " << best_idx << " by " << width << ", " << vector_refs.size() << " of "
+                                   << refs.size() << " refinements contiguous");
+  llvm::SmallVector<int64_t, 8> tile_sizes(op.ranges().size(), 1);
+  tile_sizes[best_idx] = width;
+  bool uneven = op.getRange(best_idx) % width != 0;
+  Tile(op, tile_sizes);
+  // The tiled interior is the op right before the terminator
+  auto inner = mlir::cast<ParallelForOp>(*std::prev(body->end(), 2));
+  TagTransfers(inner, vector_refs);
+  if (uneven && SafeConstraintInterior(inner)) {
+    LiftConstraint(inner);
+  }
+}
+
+}  // namespace
+
+// Get all of the innermost parallel for ops matching the requirements, pick a
+// dimension to vectorize on, and vectorize.
+void VectorizePass::runOnFunction() {
+  auto reqs = vertexai::tile::stripe::FromProto(options.reqs());
+  mlir::FuncOp f = getFunction();
+  // Collect the ops up front, since vectorizing rewrites the function
+  std::vector<ParallelForOp> ops;
+  f.walk([&](ParallelForOp op) {
+    bool innermost = true;
+    op.getOperation()->walk([&](ParallelForOp inner) { innermost &= inner == op; });
+    if (innermost && (reqs.empty() || hasAttrs(op.getOperation(), reqs))) {
+      ops.push_back(op);
+    }
+  });
+  Vectorizer vectorizer(options);
+  for (auto op : ops) {
+    vectorizer.Vectorize(op);
+  }
+}
+
+static mlir::PassRegistration<VectorizePass> vectorize_pass("stripe-vectorize", "Vectorize a stripe program");
+
+}  // namespace stripe
+}  // namespace dialect
+}  // namespace pmlc
@@ -26,3 +26,24 @@ func @dot(%arg0: tensor<1x784x!eltwise.fp32>, %arg1: tensor<784x512x!eltwise.fp3
 // CHECK-SAME: upper_bounds = [783 : index, 0 : index, 511 : index]
 
 // -----
+
+#map0 = (i, j, k) -> (j, k)
+#map1 = (i, j, k) -> (j, i)
+#map2 = (i, j, k) -> (i, k)
+
+func @dot_twice(%arg0: tensor<1x784x!eltwise.fp32>, %arg1: tensor<784x512x!eltwise.fp32>, %arg2: tensor<784x512x!eltwise.fp32>) -> (tensor<1x512x!eltwise.fp32>, tensor<1x512x!eltwise.fp32>) {
+  %c0 = "eltwise.sconst"() {value = 0.0 : f64} : () -> !fp32
+  %0 = tile.cion add, mul, %c0, %arg0, %arg1 {sink=#map0, srcs=[#map1, #map2]} :
+    !fp32, tensor<1x784x!eltwise.fp32>, tensor<784x512x!eltwise.fp32> -> tensor<1x512x!eltwise.fp32>
+  %1 = tile.cion add, mul, %c0, %arg0, %arg2 {sink=#map0, srcs=[#map1, #map2]} :
+    !fp32, tensor<1x784x!eltwise.fp32>, tensor<784x512x!eltwise.fp32> -> tensor<1x512x!eltwise.fp32>
+  return %0, %1 : tensor<1x512x!eltwise.fp32>, tensor<1x512x!eltwise.fp32>
+}
+
+// CHECK-LABEL: func @dot_twice
+// CHECK: tile.cion
+// CHECK-SAME: lower_bounds = [0 : index, 0 : index, 0 : index]
+// CHECK-SAME: upper_bounds = [783 : index, 0 : index, 511 : index]
+// CHECK: tile.cion
+// CHECK-SAME: lower_bounds = [0 : index, 0 : index, 0 : index]
+// CHECK-SAME: upper_bounds = [783 : index, 0 : index, 511 : index]
@@ -0,0 +1,43 @@
+// RUN: pmlc-opt -tile-split-constants %s | FileCheck %s
+
+!fp32 = type !eltwise.fp32
+
+#transpose_sink = (i, j) -> (j, i)
+#transpose_src = (i, j) -> (i, j)
+
+#dot_sink = (i, j, k) -> (i, j)
+#dot_lhs = (i, j, k) -> (i, k)
+#dot_rhs = (i, j, k) -> (j, k)
+
+func @dense(%arg0: tensor<1x4x!eltwise.fp32>, %arg1: tensor<4x3x!eltwise.fp32> {tile.const}) -> tensor<1x3x!eltwise.fp32> {
+  %c0 = "eltwise.sconst"() {value = 0.0 : f64} : () -> !fp32
+  %0 = tile.cion assign, none, %c0, %arg1 {sink = #transpose_sink, srcs = [#transpose_src]} :
+    !fp32, tensor<4x3x!eltwise.fp32> -> tensor<3x4x!eltwise.fp32>
+  %1 = tile.cion add, mul, %c0, %arg0, %0 {sink = #dot_sink, srcs = [#dot_lhs, #dot_rhs]} :
+    !fp32, tensor<1x4x!eltwise.fp32>, tensor<3x4x!eltwise.fp32> -> tensor<1x3x!eltwise.fp32>
+  return %1 : tensor<1x3x!eltwise.fp32>
+}
+
+// CHECK-LABEL: func @dense
+// CHECK-SAME: %arg1: tensor<4x3x!eltwise.fp32> {tile.const}
+// CHECK-SAME: %arg2: tensor<3x4x!eltwise.fp32> {tile.const_result = 0 : i64}
+// CHECK-SAME: tile.constants = @dense_constants
+// CHECK-NOT: tile.cion assign
+// CHECK: tile.cion add, mul, %{{.*}}, %arg0, %arg2
+// CHECK: return
+
+func @no_constants(%arg0: tensor<4x3x!eltwise.fp32>) -> tensor<3x4x!eltwise.fp32> {
+  %c0 = "eltwise.sconst"() {value = 0.0 : f64} : () -> !fp32
+  %0 = tile.cion assign, none, %c0, %arg0 {sink = #transpose_sink, srcs = [#transpose_src]} :
+    !fp32, tensor<4x3x!eltwise.fp32> -> tensor<3x4x!eltwise.fp32>
+  return %0 : tensor<3x4x!eltwise.fp32>
+}
+
+// CHECK-LABEL: func @no_constants
+// CHECK-NOT: tile.constants
+// CHECK: tile.cion assign
+
+// CHECK-LABEL: func @dense_constants
+// CHECK-SAME: (%arg0: tensor<4x3x!eltwise.fp32>) -> tensor<3x4x!eltwise.fp32>
+// CHECK: %[[T:.*]] = tile.cion assign, none, %{{.*}}, %arg0
+// CHECK: return %[[T]]
@@ -2,8 +2,12 @@
 
 #include "pmlc/dialect/tile/transforms/contraction.h"
 
+#include <algorithm>
 #include <limits>
 #include <list>
+#include <map>
+#include <optional>
+#include <vector>
 
 #include "llvm/Support/FormatVariadic.h"
 
@@ -100,10 +104,55 @@ std::set<std::string> Constraints::VariablesUsed() {
   return ret;
 }
 
+// Computes the bounds without the solver when each variable has a constraint of the form 0 <= a*x + c < r (a > 0),
+// and every other constraint holds over the whole box those describe (as in matmuls, unpadded convolutions and
+// pooling windows).  The feasible region is then the box itself, so its corners are exactly what the solver would
+// find.
+static std::optional<math::IndexBounds> ComputeBoxBounds(const RangeConstraints& constraints,
+                                                         const std::set<std::string>& vars) {
+  math::IndexBounds box;
+  for (const auto& constraint : constraints) {
+    auto var = constraint.poly.GetNonzeroIndex();
+    auto terms = std::count_if(constraint.poly.getMap().begin(), constraint.poly.getMap().end(),
+                               [](const auto& term) { return !term.first.empty() && term.second != 0; });
+    auto coeff = constraint.poly[var];
+    auto constant = constraint.poly.constant();
+    if (terms != 1 || coeff <= 0) {
+      continue;
+    }
+    math::Bound bound{static_cast<int64_t>(math::Ceil(-constant / coeff)),
+                      static_cast<int64_t>(math::Floor((constraint.range - 1 - constant) / coeff))};
+    auto [it, is_new] = box.emplace(var, bound);
+    if (!is_new) {
+      it->second.min = std::max(it->second.min, bound.min);
+      it->second.max = std::min(it->second.max, bound.max);
+    }
+  }
+  if (box.size() != vars.size()) {
+    return std::nullopt;
+  }
+  for (const auto& [var, bound] : box) {
+    if (bound.min > bound.max) {
+      return std::nullopt;
+    }
+  }
+  for (const auto& constraint : constraints) {
+    if (!IsImplied(constraint.lowerBound(), box) || !IsImplied(constraint.upperBound(), box)) {
+      return std::nullopt;
+    }
+  }
+  return box;
+}
+
 // TODO(T133): Check size of integer programming problem to prevent slowdown
 BoundsAndConstraints Constraints::ComputeBounds() {
   auto vars = VariablesUsed();
 
+  if (auto box = ComputeBoxBounds(constraints, vars)) {
+    IVLOG(3, "ComputeBounds: constraints form a box, skipping the solver");
+    return std::make_tuple(*box, SimpleConstraints{});
+  }
+
   // Run the solver for each variable min + max
   bilp::ILPSolver solver;
   math::IndexBounds out;
@@ -729,17 +778,50 @@ struct ComputeBoundsImpl {
   }
 };
 
+// The results of ComputeBoundsImpl for one form of contraction
+struct ComputedBounds {
+  SmallVector<int64_t, 8> lowerBounds;
+  SmallVector<int64_t, 8> upperBounds;
+  SmallVector<AffineMap, 4> affineMaps;
+  IntegerSet constraints;
+};
+
+// The bounds of a contraction depend only on its access maps, constraints, index names, flags and tensor types, so
+// identical contractions (such as a layer repeated throughout a network) share them.  Attributes and types are
+// uniqued by the context, so their addresses identify the contraction's form.
+static std::vector<const void*> getBoundsKey(ContractionOp op) {
+  std::vector<const void*> key;
+  for (auto name : {"sink", "srcs", "cons", "idxs", "no_reduce"}) {
+    key.push_back(op.getAttr(name).getAsOpaquePointer());
+  }
+  key.push_back(op.result()->getType().getAsOpaquePointer());
+  for (auto src : op.operands()) {
+    key.push_back(src->getType().getAsOpaquePointer());
+  }
+  return key;
+}
+
 void ComputeBoundsPass::runOnFunction() {
   auto func = getFunction();
-  func.walk([this](ContractionOp op) {
+  std::map<std::vector<const void*>, ComputedBounds> cache;
+  func.walk([&](ContractionOp op) {
     try {
-      ComputeBoundsImpl impl(op);
-      auto maps = llvm::makeArrayRef(impl.affineMaps);
-      op.setLowerBounds(impl.lowerBounds);
-      op.setUpperBounds(impl.upperBounds);
+      auto key = getBoundsKey(op);
+      auto it = cache.find(key);
+      if (it == cache.end()) {
+        ComputeBoundsImpl impl(op);
+        ComputedBounds computed{impl.lowerBounds, impl.upperBounds, impl.affineMaps, impl.getConstraints()};
+        it = cache.emplace(key, computed).first;
+      } else {
+        IVLOG(3, "ComputeBounds: reusing the bounds of an identical contraction");
+      }
+      const auto& computed = it->second;
+      auto maps = llvm::makeArrayRef(computed.affineMaps);
+      op.setLowerBounds(computed.lowerBounds);
+      op.setUpperBounds(computed.upperBounds);
       op.setSink(maps.front());
       op.setSources(maps.drop_front());
-      op.setConstraints(impl.getConstraints());
+      op.setConstraints(computed.constraints);
     } catch (const std::exception& ex) {
       op.emitError(ex.what());
       signalPassFailure();
@@ -5,6 +5,7 @@
 #include <memory>
 
 namespace mlir {
+class Pass;
 template <typename T>
 class OpPassBase;
 }  // namespace mlir
@@ -15,4 +16,12 @@ class ContractionOp;
 
 std::unique_ptr<mlir::OpPassBase<ContractionOp>> createComputeBoundsPass();
 
+// Moves the operations of each function which depend only on arguments marked
+// with the tile.const attribute into a separate function, named by the
+// tile.constants attribute of the original.  The constant function's results
+// are passed back to the original as new trailing arguments, each marked with
+// tile.const_result giving its result index; evaluating the constant function
+// once lets those computations be skipped on every run.
+std::unique_ptr<mlir::Pass> createSplitConstantsPass();
+
 }  // namespace pmlc::dialect::tile
@@ -0,0 +1,180 @@
+// Copyright 2020, Intel Corporation
+
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SetVector.h"
+
+#include "mlir/Dialect/StandardOps/Ops.h"
+#include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/Function.h"
+#include "mlir/IR/Module.h"
+#include "mlir/IR/StandardTypes.h"
+#include "mlir/IR/SymbolTable.h"
+#include "mlir/Pass/Pass.h"
+
+#include "base/util/logging.h"
+#include "pmlc/dialect/tile/ir/dialect.h"
+#include "pmlc/dialect/tile/transforms/passes.h"
+
+namespace pmlc::dialect::tile {
+
+using llvm::SmallVector;
+using mlir::BlockAndValueMapping;
+using mlir::FuncOp;
+using mlir::ModuleOp;
+using mlir::OpBuilder;
+using mlir::Operation;
+using mlir::Type;
+using mlir::Value;
+
+namespace {
+
+struct SplitConstantsPass : public mlir::ModulePass<SplitConstantsPass> {
+  void runOnModule() override {
+    auto module = getModule();
+    mlir::SymbolTable symbolTable(module);
+    SmallVector<FuncOp, 4> funcs(module.getOps<FuncOp>());
+    for (auto func : funcs) {
+      if (!func.getAttr(Dialect::getDialectAttrName("constants")) && func.getBlocks().size() == 1) {
+        split(func, &symbolTable);
+      }
+    }
+  }
+
+  void split(FuncOp func, mlir::SymbolTable* symbolTable) {
+    auto constAttrName = Dialect::getDialectAttrName("const");
+    auto& block = func.front();
+
+    // Find the operations computed only from constant arguments (and from
+    // operations with no operands, such as scalar constants).
+    SmallVector<Value, 8> constArgs;
+    llvm::DenseSet<Value> constant;
+    llvm::DenseSet<Value> derived;
+    for (auto arg : block.getArguments()) {
+      if (func.getArgAttr(arg.getArgNumber(), constAttrName)) {
+        constArgs.push_back(arg);
+        constant.insert(arg);
+        derived.insert(arg);
+      }
+    }
+    if (constArgs.empty()) {
+      return;
+    }
+    SmallVector<Operation*, 16> foldable;
+    for (auto& op : block) {
+      if (op.isKnownTerminator() || !op.hasNoSideEffect() || op.getNumRegions()) {
+        continue;
+      }
+      // Leave the operations yielding the function's results in place, rather
+      // than have the function return one of its own arguments.
+      if (llvm::any_of(op.getUsers(), [](Operation* user) { return user->isKnownTerminator(); })) {
+        continue;
+      }
+      bool isConstant = llvm::all_of(op.getOperands(), [&](Value operand) { return constant.count(operand); });
+      if (!isConstant) {
+        continue;
+      }
+      bool isDerived = llvm::any_of(op.getOperands(), [&](Value operand) { return derived.count(operand); });
+      for (auto result : op.getResults()) {
+        constant.insert(result);
+        if (isDerived) {
+          derived.insert(result);
+        }
+      }
+      foldable.push_back(&op);
+    }
+
+    // The tensors computed from constant arguments which are needed by the
+    // rest of the function are the results of the constant subgraph.
+    llvm::SetVector<Value> results;
+    for (auto op : foldable) {
+      for (auto result : op->getResults()) {
+        if (!derived.count(result) || !result.getType().isa<mlir::RankedTensorType>()) {
+          continue;
+        }
+        bool needed = llvm::any_of(result.getUsers(), [&](Operation* user) {
+          return llvm::none_of(user->getResults(), [&](Value value) { return constant.count(value); }) ||
+                 user->getNumResults() == 0;
+        });
+        if (needed) {
+          results.insert(result);
+        }
+      }
+    }
+    if (results.empty()) {
+      return;
+    }
+    IVLOG(2, "SplitConstantsPass> " << func.getName().str() << ": " << foldable.size() << " operations yield "
+                                    << results.size() << " constant tensors");
+
+    // Build the function which computes the constant subgraph.
+    auto loc = func.getLoc();
+    OpBuilder builder(func.getContext());
+    SmallVector<Type, 8> argTypes;
+    for (auto arg : constArgs) {
+      argTypes.push_back(arg.getType());
+    }
+    SmallVector<Type, 8> resultTypes;
+    for (auto result : results) {
+      resultTypes.push_back(result.getType());
+    }
+    auto constFunc =
+        FuncOp::create(loc, (func.getName() + "_constants").str(), builder.getFunctionType(argTypes, resultTypes));
+    auto nameAttrName = Dialect::getDialectAttrName("name");
+    for (unsigned i = 0; i < constArgs.size(); i++) {
+      if (auto attr = func.getArgAttr(constArgs[i].cast<mlir::BlockArgument>().getArgNumber(), nameAttrName)) {
+        constFunc.setArgAttr(i, nameAttrName, attr);
+      }
+    }
+    symbolTable->insert(constFunc);
+    auto entry = constFunc.addEntryBlock();
+    builder.setInsertionPointToStart(entry);
+    BlockAndValueMapping mapping;
+    for (unsigned i = 0; i < constArgs.size(); i++) {
+      mapping.map(constArgs[i], entry->getArgument(i));
+    }
+    for (auto op : foldable) {
+      builder.clone(*op, mapping);
+    }
+    SmallVector<Value, 8> returnOperands;
+    for (auto result : results) {
+      returnOperands.push_back(mapping.lookup(result));
+    }
+    builder.create<mlir::ReturnOp>(loc, returnOperands);
+    func.setAttr(Dialect::getDialectAttrName("constants"), builder.getSymbolRefAttr(constFunc));
+
+    // Pass each constant tensor to the original function as a new argument,
+    // marked with its position among the constant function's results.
+    auto funcType = func.getType();
+    SmallVector<Type, 8> inputs(funcType.getInputs().begin(), funcType.getInputs().end());
+    auto resultAttrName = Dialect::getDialectAttrName("const_result");
+    for (unsigned i = 0; i < results.size(); i++) {
+      auto arg = block.addArgument(results[i].getType());
+      inputs.push_back(arg.getType());
+      results[i].replaceAllUsesWith(arg);
+      func.setType(builder.getFunctionType(inputs, funcType.getResults()));
+      func.setArgAttr(arg.getArgNumber(), resultAttrName, builder.getI64IntegerAttr(i));
+    }
+    for (auto op : llvm::reverse(foldable)) {
+      if (op->use_empty()) {
+        op->erase();
+      }
+    }
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<mlir::Pass> createSplitConstantsPass() {  //
+  return std::make_unique<SplitConstantsPass>();
+}
+
+static mlir::PassRegistration<SplitConstantsPass> pass(  //
+    "tile-split-constants",                              //
+    "Move computations on constant arguments into a separate function");
+
+}  // namespace pmlc::dialect::tile
@@ -0,0 +1,242 @@
+// Copyright 2020, Intel Corporation
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+#include "llvm/Support/CommandLine.h"
+
+#include "mlir/Dialect/AffineOps/AffineOps.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/Function.h"
+#include "mlir/Pass/Pass.h"
+
+#include "base/util/logging.h"
+#include "pmlc/dialect/pxa/ir/ops.h"
+#include "pmlc/dialect/pxa/transforms/parallel.h"
+#include "pmlc/dialect/pxa/transforms/stride_info.h"
+#include "pmlc/target/intel_gen/passes.h"
+
+using namespace mlir;  // NOLINT[build/namespaces]
+
+namespace pmlc::target::intel_gen {
+
+namespace pxa = dialect::pxa;
+
+namespace {
+
+constexpr unsigned kGridDims = 3;
+
+llvm::cl::opt<unsigned> clMaxWorkgroupInvocations(  //
+    "intel-gen-max-workgroup-invocations",          //
+    llvm::cl::desc("The maximum number of invocations per workgroup"), llvm::cl::init(256));
+
+llvm::cl::opt<unsigned> clSubgroupSize(  //
+    "intel-gen-subgroup-size",           //
+    llvm::cl::desc("The number of invocations per subgroup"), llvm::cl::init(16));
+
+std::vector<int64_t> divisors(int64_t value) {
+  std::vector<int64_t> result;
+  for (int64_t i = 1; i * i <= value; i++) {
+    if (value % i == 0) {
+      result.push_back(i);
+      if (i * i != value) {
+        result.push_back(value / i);
+      }
+    }
+  }
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+// Returns the largest divisor of the value that doesn't exceed the limit.
+int64_t largestDivisor(int64_t value, int64_t limit) {
+  int64_t result = 1;
+  for (auto divisor : divisors(value)) {
+    if (divisor <= limit) {
+      result = divisor;
+    }
+  }
+  return result;
+}
+
+class MapWorkgroupsPass : public FunctionPass<MapWorkgroupsPass> {
+ public:
+  explicit MapWorkgroupsPass(const DeviceLimits& limits) : limits(limits) {}
+
+  void runOnFunction() override {
+    SmallVector<pxa::AffineParallelForOp, 8> loops;
+    for (auto& block : getFunction().getBody()) {
+      for (auto op : block.getOps<pxa::AffineParallelForOp>()) {
+        loops.push_back(op);
+      }
+    }
+    for (auto op : loops) {
+      if (op.dynamic_ranges().empty()) {
+        map(op);
+      }
+    }
+  }
+
+ private:
+  // Chooses the indices to distribute across invocations: up to three indices
+  // which may run concurrently, ordered by ascending stride so that the x
+  // dimension (within which subgroups are formed) walks contiguous memory.
+  SmallVector<unsigned, 3> chooseIndices(ArrayRef<int64_t> ranges, ArrayRef<pxa::StrideInfo> accesses,
+                                         pxa::AffineParallelForOp op) {
+    SmallVector<unsigned, 8> candidates;
+    SmallVector<int64_t, 8> minStrides(ranges.size(), std::numeric_limits<int64_t>::max());
+    for (unsigned i = 0; i < ranges.size(); i++) {
+      if (ranges[i] > 1 && pxa::isParallelIndex(op, i)) {
+        candidates.push_back(i);
+      }
+      for (const auto& access : accesses) {
+        if (access.strides[i]) {
+          minStrides[i] = std::min(minStrides[i], std::abs(access.strides[i]));
+        }
+      }
+    }
+    // Among equal strides, prefer the innermost index.
+    std::stable_sort(candidates.begin(), candidates.end(), [&](unsigned lhs, unsigned rhs) {
+      return minStrides[lhs] != minStrides[rhs] ? minStrides[lhs] < minStrides[rhs] : lhs > rhs;
+    });
+    if (candidates.size() > kGridDims) {
+      candidates.resize(kGridDims);
+    }
+    return SmallVector<unsigned, 3>(candidates.begin(), candidates.end());
+  }
+
+  // Chooses the workgroup size along each of the distributed indices.  The x
+  // dimension first grows to cover a subgroup; after that, the dimension
+  // which most reduces the memory footprint per invocation grows, so that
+  // invocations within a workgroup share as much of their data as possible,
+  // while the workgroup's footprint fits in the shared local memory.
+  SmallVector<int64_t, 3> chooseSizes(ArrayRef<int64_t> ranges, ArrayRef<pxa::StrideInfo> accesses,
+                                      ArrayRef<unsigned> indices) {
+    auto maxInvocations = std::min<int64_t>(limits.maxWorkgroupInvocations, clMaxWorkgroupInvocations);
+    auto subgroupSize = std::min<int64_t>(limits.subgroupSize, clSubgroupSize);
+    SmallVector<int64_t, 3> sizes(indices.size(), 1);
+    SmallVector<int64_t, 8> tile(ranges.size(), 1);
+    auto invocations = [&] {
+      int64_t product = 1;
+      for (auto size : sizes) {
+        product *= size;
+      }
+      return product;
+    };
+    auto fits = [&](unsigned dim, int64_t size) {
+      auto saved = tile[indices[dim]];
+      tile[indices[dim]] = size;
+      auto footprint = pxa::getFootprint(accesses, tile);
+      tile[indices[dim]] = saved;
+      return size <= limits.maxWorkgroupSize[dim] && invocations() / sizes[dim] * size <= maxInvocations &&
+             footprint <= limits.localMemoryBytes;
+    };
+
+    if (!indices.empty()) {
+      auto size = largestDivisor(ranges[indices[0]], std::min(subgroupSize, limits.maxWorkgroupSize[0]));
+      if (fits(0, size)) {
+        sizes[0] = size;
+        tile[indices[0]] = size;
+      }
+    }
+    while (true) {
+      int best = -1;
+      int64_t bestSize = 0;
+      double bestBytes = std::numeric_limits<double>::max();
+      for (unsigned dim = 0; dim < indices.size(); dim++) {
+        auto options = divisors(ranges[indices[dim]]);
+        auto next = std::upper_bound(options.begin(), options.end(), sizes[dim]);
+        if (next == options.end() || !fits(dim, *next)) {
+          continue;
+        }
+        tile[indices[dim]] = *next;
+        double bytes = static_cast<double>(pxa::getFootprint(accesses, tile)) / (invocations() / sizes[dim] * *next);
+        tile[indices[dim]] = sizes[dim];
+        if (bytes < bestBytes) {
+          best = dim;
+          bestSize = *next;
+          bestBytes = bytes;
+        }
+      }
+      if (best < 0) {
+        break;
+      }
+      sizes[best] = bestSize;
+      tile[indices[best]] = bestSize;
+    }
+    return sizes;
+  }
+
+  void map(pxa::AffineParallelForOp op) {
+    auto loc = op.getLoc();
+    auto ranges = pxa::getRanges(op);
+    auto accesses = pxa::computeStrideInfo(op);
+    auto indices = chooseIndices(ranges, accesses, op);
+    auto sizes = chooseSizes(ranges, accesses, indices);
+
+    SmallVector<int64_t, 3> gridRanges(kGridDims, 1);
+    SmallVector<int64_t, 3> groupRanges(kGridDims, 1);
+    for (unsigned dim = 0; dim < indices.size(); dim++) {
+      gridRanges[dim] = ranges[indices[dim]] / sizes[dim];
+      groupRanges[dim] = sizes[dim];
+    }
+    SmallVector<unsigned, 8> rest;
+    SmallVector<int64_t, 8> restRanges;
+    for (unsigned i = 0; i < ranges.size(); i++) {
+      if (!llvm::is_contained(indices, i)) {
+        rest.push_back(i);
+        restRanges.push_back(ranges[i]);
+      }
+    }
+    IVLOG(3, "MapWorkgroupsPass> grid: " << gridRanges[0] << "x" << gridRanges[1] << "x" << gridRanges[2]
+                                         << ", workgroup: " << groupRanges[0] << "x" << groupRanges[1] << "x"
+                                         << groupRanges[2] << ", sequential indices: " << rest.size());
+
+    OpBuilder builder(op.getOperation());
+    auto makeLoop = [&](ArrayRef<int64_t> loopRanges) {
+      auto loop = builder.create<pxa::AffineParallelForOp>(loc, builder.getI64ArrayAttr(loopRanges), ArrayRef<Value>{});
+      auto block = builder.createBlock(&loop.inner());
+      for (unsigned i = 0; i < loopRanges.size(); i++) {
+        block->addArgument(builder.getIndexType());
+      }
+      builder.create<AffineTerminatorOp>(loc);
+      builder.setInsertionPointToStart(block);
+      return block;
+    };
+    auto grid = makeLoop(gridRanges);
+    auto group = makeLoop(groupRanges);
+    auto body = rest.empty() ? group : makeLoop(restRanges);
+
+    auto& oldBody = op.inner().front();
+    body->getOperations().splice(std::prev(body->end()), oldBody.getOperations(), oldBody.begin(),
+                                 std::prev(oldBody.end()));
+    builder.setInsertionPointToStart(body);
+    for (unsigned dim = 0; dim < indices.size(); dim++) {
+      auto map = AffineMap::get(2, 0, builder.getAffineDimExpr(0) * sizes[dim] + builder.getAffineDimExpr(1));
+      auto apply = builder.create<AffineApplyOp>(
+          loc, map, ValueRange{grid->getArgument(dim), group->getArgument(dim)});
+      oldBody.getArgument(indices[dim]).replaceAllUsesWith(apply.getResult());
+    }
+    for (unsigned i = 0; i < rest.size(); i++) {
+      oldBody.getArgument(rest[i]).replaceAllUsesWith(body->getArgument(i));
+    }
+    op.erase();
+  }
+
+  DeviceLimits limits;
+};
+
+}  // namespace
+
+std::unique_ptr<Pass> createMapWorkgroupsPass(const DeviceLimits& limits) {
+  return std::make_unique<MapWorkgroupsPass>(limits);
+}
+
+static PassRegistration<MapWorkgroupsPass> pass(  //
+    "intel-gen-map-workgroups",                   //
+    "Distribute each pxa.parallel_for across a grid of workgroups",
+    [] { return std::make_unique<MapWorkgroupsPass>(DeviceLimits{}); });
+
+}  // namespace pmlc::target::intel_gen
@@ -0,0 +1,35 @@
+// Copyright 2020, Intel Corporation
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+namespace mlir {
+class Pass;
+}  // namespace mlir
+
+namespace pmlc::target::intel_gen {
+
+// The limits of the device which bound the choice of workgroup sizes.
+struct DeviceLimits {
+  int64_t maxWorkgroupInvocations = 256;
+  int64_t maxWorkgroupSize[3] = {256, 256, 256};
+  // The number of invocations which execute together in a subgroup; the x
+  // dimension of each workgroup is made a multiple of this where possible.
+  int64_t subgroupSize = 16;
+  // The bytes of shared local memory per workgroup.
+  int64_t localMemoryBytes = 64 * 1024;
+};
+
+// Restructures each top-level pxa.parallel_for into a three-dimensional grid
+// of workgroups, each of which is a three-dimensional block of invocations,
+// with any remaining indices run sequentially by each invocation.  The
+// result is suitable for mapping with createSimpleLoopsToGPUPass(3, 3).
+std::unique_ptr<mlir::Pass> createMapWorkgroupsPass(const DeviceLimits& limits);
+
+// Sets the SPIR-V local size of each kernel from the workgroup size it is
+// launched with.
+std::unique_ptr<mlir::Pass> createSetLocalSizePass();
+
+}  // namespace pmlc::target::intel_gen
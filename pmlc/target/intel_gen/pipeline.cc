@@ -12,14 +12,27 @@
 
 #include "pmlc/compiler/registry.h"
 #include "pmlc/conversion/pxa_to_affine/pxa_to_affine.h"
+#include "pmlc/dialect/pxa/transforms/passes.h"
+#include "pmlc/target/intel_gen/passes.h"
 
 using namespace mlir;  // NOLINT[build/namespaces]
 using pmlc::conversion::pxa_to_affine::createLowerPXAToAffinePass;
+using pmlc::dialect::pxa::createLoopOrderPass;
+using pmlc::dialect::pxa::createSplitReductionPass;
 
 namespace pmlc::target::intel_gen {
 
+// Reductions over loops with fewer parallel iterations than this (enough
+// invocations to occupy the device) are split into partial reductions of at
+// least kMinPartialRange values each, combined as a tree.
+static constexpr int64_t kMinInvocations = 8192;
+static constexpr int64_t kMinPartialRange = 16;
+
 static compiler::TargetRegistration pipeline("intel_gen", [](OpPassManager* pm) {
-  // TODO: do optimizations here
+  pm->addNestedPass<FuncOp>(createSplitReductionPass(kMinInvocations, kMinPartialRange));
+  pm->addNestedPass<FuncOp>(createLoopOrderPass());
+  pm->addNestedPass<FuncOp>(createMapWorkgroupsPass(DeviceLimits{}));
+  pm->addNestedPass<FuncOp>(createCanonicalizerPass());
 
   pm->addPass(createLowerPXAToAffinePass());
   pm->addNestedPass<FuncOp>(createCanonicalizerPass());
@@ -29,7 +42,7 @@ static compiler::TargetRegistration pipeline("intel_gen", [](OpPassManager* pm)
   pm->addNestedPass<FuncOp>(createCanonicalizerPass());
   pm->addNestedPass<FuncOp>(createCSEPass());
 
-  pm->addPass(createSimpleLoopsToGPUPass(1, 1));
+  pm->addPass(createSimpleLoopsToGPUPass(3, 3));
   pm->addNestedPass<FuncOp>(createCanonicalizerPass());
   pm->addNestedPass<FuncOp>(createCSEPass());
 
@@ -37,6 +50,7 @@ static compiler::TargetRegistration pipeline("intel_gen", [](OpPassManager* pm)
   // NOTE: canonicalizer/cse at this stage causes later passes to fail
 
   pm->addNestedPass<ModuleOp>(createConvertGPUToSPIRVPass({1, 1}));
+  pm->addPass(createSetLocalSizePass());
   pm->addPass(createCanonicalizerPass());
   pm->addPass(createCSEPass());
 
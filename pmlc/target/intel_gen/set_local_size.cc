@@ -0,0 +1,70 @@
+// Copyright 2020, Intel Corporation
+
+#include "llvm/ADT/StringMap.h"
+
+#include "mlir/Dialect/GPU/GPUDialect.h"
+#include "mlir/Dialect/SPIRV/SPIRVLowering.h"
+#include "mlir/Dialect/SPIRV/SPIRVOps.h"
+#include "mlir/Dialect/StandardOps/Ops.h"
+#include "mlir/IR/Module.h"
+#include "mlir/IR/SymbolTable.h"
+#include "mlir/Pass/Pass.h"
+
+#include "base/util/logging.h"
+#include "pmlc/target/intel_gen/passes.h"
+
+using namespace mlir;  // NOLINT[build/namespaces]
+
+namespace pmlc::target::intel_gen {
+
+namespace {
+
+// The GPU to SPIR-V conversion gives every kernel the same local size; this
+// replaces it with the constant workgroup size of the kernel's launch.
+struct SetLocalSizePass : public ModulePass<SetLocalSizePass> {
+  void runOnModule() override {
+    llvm::StringMap<SmallVector<int32_t, 3>> localSizes;
+    getModule().walk([&](gpu::LaunchFuncOp op) {
+      auto blockSize = op.getBlockSizeOperandValues();
+      SmallVector<int32_t, 3> sizes;
+      for (auto value : {blockSize.x, blockSize.y, blockSize.z}) {
+        auto constant = dyn_cast_or_null<ConstantIndexOp>(value.getDefiningOp());
+        if (!constant) {
+          return;
+        }
+        sizes.push_back(constant.getValue());
+      }
+      localSizes[op.kernel()] = sizes;
+    });
+
+    auto abiName = spirv::getEntryPointABIAttrName();
+    getModule().walk([&](Operation* op) {
+      if (!op->getAttr(abiName) || !op->getParentOfType<spirv::ModuleOp>()) {
+        return;
+      }
+      auto name = op->getAttrOfType<StringAttr>(SymbolTable::getSymbolAttrName());
+      if (!name) {
+        return;
+      }
+      auto it = localSizes.find(name.getValue());
+      if (it == localSizes.end()) {
+        return;
+      }
+      IVLOG(3, "SetLocalSizePass> " << name.getValue().str() << ": " << it->second[0] << "x" << it->second[1] << "x"
+                                    << it->second[2]);
+      op->setAttr(abiName, spirv::getEntryPointABIAttr(it->second, &getContext()));
+    });
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<Pass> createSetLocalSizePass() {  //
+  return std::make_unique<SetLocalSizePass>();
+}
+
+static PassRegistration<SetLocalSizePass> pass(  //
+    "intel-gen-set-local-size",                  //
+    "Set the SPIR-V local size of each kernel from its launch");
+
+}  // namespace pmlc::target::intel_gen
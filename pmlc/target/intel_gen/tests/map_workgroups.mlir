@@ -0,0 +1,44 @@
+// RUN: pmlc-opt -intel-gen-map-workgroups %s | FileCheck %s
+
+#map = (i, j, k) -> (i, j)
+
+func @dot(%arg0: memref<64x64xf32>, %arg1: memref<64x64xf32>, %arg2: memref<64x64xf32>) {
+  "pxa.parallel_for"() ( {
+  ^bb0(%i: index, %j: index, %k: index):
+    %0 = affine.load %arg0[%i, %k] : memref<64x64xf32>
+    %1 = affine.load %arg1[%k, %j] : memref<64x64xf32>
+    %2 = mulf %0, %1 : f32
+    "pxa.reduce"(%2, %arg2, %i, %j, %k) {agg = 1 : i64, map = #map} : (f32, memref<64x64xf32>, index, index, index) -> ()
+    "affine.terminator"() : () -> ()
+  }) {ranges = [64, 64, 64]} : () -> ()
+  return
+}
+
+// The contiguous index j maps to x; the reduction index k runs sequentially.
+// CHECK-LABEL: func @dot
+// CHECK: ^bb0(%[[GX:.*]]: index, %[[GY:.*]]: index, %{{.*}}: index):
+// CHECK: ^bb0(%[[LX:.*]]: index, %[[LY:.*]]: index, %{{.*}}: index):
+// CHECK: ^bb0(%[[K:.*]]: index):
+// CHECK-DAG: %[[J:.*]] = affine.apply #{{.*}}(%[[GX]], %[[LX]])
+// CHECK-DAG: %[[I:.*]] = affine.apply #{{.*}}(%[[GY]], %[[LY]])
+// CHECK: affine.load %arg0[%[[I]], %[[K]]]
+// CHECK: affine.load %arg1[%[[K]], %[[J]]]
+// CHECK: pxa.reduce
+// CHECK: ranges = [64]
+// CHECK: ranges = [64, 4, 1]
+// CHECK: ranges = [1, 16, 1]
+
+func @eltwise(%arg0: memref<256x256xf32>, %arg1: memref<256x256xf32>) {
+  "pxa.parallel_for"() ( {
+  ^bb0(%i: index, %j: index):
+    %0 = affine.load %arg0[%i, %j] : memref<256x256xf32>
+    affine.store %0, %arg1[%i, %j] : memref<256x256xf32>
+    "affine.terminator"() : () -> ()
+  }) {ranges = [256, 256]} : () -> ()
+  return
+}
+
+// CHECK-LABEL: func @eltwise
+// CHECK: affine.store
+// CHECK: ranges = [256, 1, 1]
+// CHECK: ranges = [1, 256, 1]
@@ -0,0 +1,171 @@
+// Copyright 2020, Intel Corporation
+
+#include <functional>
+#include <numeric>
+#include <string>
+
+#include "llvm/ADT/SetVector.h"
+
+#include "mlir/Dialect/AffineOps/AffineOps.h"
+#include "mlir/Dialect/StandardOps/Ops.h"
+#include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/Function.h"
+#include "mlir/IR/Module.h"
+#include "mlir/IR/SymbolTable.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/Transforms/RegionUtils.h"
+
+#include "base/util/logging.h"
+#include "pmlc/compiler/parallel.h"
+#include "pmlc/dialect/pxa/ir/ops.h"
+#include "pmlc/dialect/pxa/transforms/parallel.h"
+#include "pmlc/dialect/pxa/transforms/stride_info.h"
+#include "pmlc/target/x86/passes.h"
+
+using namespace mlir;  // NOLINT[build/namespaces]
+
+namespace pmlc::target::x86 {
+
+namespace pxa = dialect::pxa;
+
+namespace {
+
+// Loops which perform less work than this (in operations executed) run
+// sequentially; loops which perform more are split into tasks which each
+// perform at least kMinTaskWork, so that scheduling overhead stays small.
+constexpr int64_t kMinParallelWork = 1 << 16;
+constexpr int64_t kMinTaskWork = 1 << 14;
+
+// Estimates the number of operations executed by one iteration of a loop body.
+int64_t getBodyCost(Block* block) {
+  int64_t cost = 0;
+  for (auto& op : *block) {
+    if (auto loop = dyn_cast<pxa::AffineParallelForOp>(op)) {
+      auto ranges = pxa::getRanges(loop);
+      auto iterations = std::accumulate(ranges.begin(), ranges.end(), int64_t{1}, std::multiplies<int64_t>());
+      cost += iterations * getBodyCost(&loop.inner().front());
+    } else if (!isa<AffineTerminatorOp>(op)) {
+      cost++;
+    }
+  }
+  return cost;
+}
+
+struct ParallelizePass : public ModulePass<ParallelizePass> {
+  void runOnModule() override {
+    SymbolTable symbolTable(getModule());
+    SmallVector<pxa::AffineParallelForOp, 8> loops;
+    for (auto func : getModule().getOps<FuncOp>()) {
+      for (auto& block : func.getBody()) {
+        for (auto op : block.getOps<pxa::AffineParallelForOp>()) {
+          loops.push_back(op);
+        }
+      }
+    }
+    for (auto op : loops) {
+      if (!op.dynamic_ranges().empty()) {
+        continue;
+      }
+      auto ranges = pxa::getRanges(op);
+      auto iterations = std::accumulate(ranges.begin(), ranges.end(), int64_t{1}, std::multiplies<int64_t>());
+      auto work = iterations * getBodyCost(&op.inner().front());
+      if (work < kMinParallelWork) {
+        continue;
+      }
+      for (unsigned i = 0; i < ranges.size(); i++) {
+        if (ranges[i] > 1 && pxa::isParallelIndex(op, i)) {
+          auto workPerValue = work / ranges[i];
+          auto grain = std::min(ranges[i], std::max(int64_t{1}, (kMinTaskWork + workPerValue - 1) / workPerValue));
+          IVLOG(3, "ParallelizePass> index " << i << " of " << ranges.size() << ", grain " << grain);
+          outline(op, i, grain, &symbolTable);
+          break;
+        }
+      }
+    }
+  }
+
+  // Moves the loop into a new function which runs the specified index over
+  // [begin, end), and replaces it with a call to that function over the
+  // index's full range.  The call is dispatched to the runtime's parallel-for
+  // once the module has been translated to LLVM IR.
+  void outline(pxa::AffineParallelForOp op, unsigned argNumber, int64_t grain, SymbolTable* symbolTable) {
+    auto loc = op.getLoc();
+    auto func = op.getParentOfType<FuncOp>();
+    auto ranges = pxa::getRanges(op);
+
+    // Constants are cloned into the new function; other values from outside
+    // the loop become its arguments.
+    llvm::SetVector<Value> used;
+    getUsedValuesDefinedAbove(op.inner(), used);
+    SmallVector<Operation*, 8> constants;
+    SmallVector<Value, 8> captures;
+    OpBuilder builder(op.getOperation());
+    SmallVector<Type, 8> argTypes{builder.getIndexType(), builder.getIndexType()};
+    for (auto value : used) {
+      auto defOp = value.getDefiningOp();
+      if (defOp && defOp->hasNoSideEffect() && defOp->getNumOperands() == 0) {
+        constants.push_back(defOp);
+      } else {
+        captures.push_back(value);
+        argTypes.push_back(value.getType());
+      }
+    }
+
+    auto name = (func.getName() + "_parallel").str();
+    auto outlined = FuncOp::create(loc, name, builder.getFunctionType(argTypes, {}));
+    outlined.setAttr(compiler::kParallelGrainAttrName, builder.getI64IntegerAttr(grain));
+    symbolTable->insert(outlined);
+
+    auto entry = outlined.addEntryBlock();
+    OpBuilder body(entry);
+    BlockAndValueMapping mapping;
+    for (auto constant : constants) {
+      body.clone(*constant, mapping);
+    }
+    for (unsigned i = 0; i < captures.size(); i++) {
+      mapping.map(captures[i], entry->getArgument(i + 2));
+    }
+    auto identity = body.getDimIdentityMap();
+    auto forOp = body.create<AffineForOp>(loc, ValueRange{entry->getArgument(0)}, identity,
+                                          ValueRange{entry->getArgument(1)}, identity);
+    body.create<ReturnOp>(loc);
+
+    // Clone the loop into the body of the affine.for without the index which
+    // now runs there, inlining the loop's body if no other indices remain.
+    auto inner = forOp.getBodyBuilder();
+    auto clone = cast<pxa::AffineParallelForOp>(inner.clone(*op.getOperation(), mapping));
+    auto& cloneBody = clone.inner().front();
+    cloneBody.getArgument(argNumber).replaceAllUsesWith(forOp.getInductionVar());
+    cloneBody.eraseArgument(argNumber);
+    ranges.erase(ranges.begin() + argNumber);
+    if (ranges.empty()) {
+      auto& ops = forOp.getBody()->getOperations();
+      ops.splice(Block::iterator(clone.getOperation()), cloneBody.getOperations(), cloneBody.begin(),
+                 std::prev(cloneBody.end()));
+      clone.erase();
+    } else {
+      clone.setAttr("ranges", builder.getI64ArrayAttr(ranges));
+    }
+
+    SmallVector<Value, 8> args{
+        builder.create<ConstantIndexOp>(loc, 0),
+        builder.create<ConstantIndexOp>(loc, pxa::getRanges(op)[argNumber]),
+    };
+    args.append(captures.begin(), captures.end());
+    builder.create<CallOp>(loc, outlined, args);
+    op.erase();
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<Pass> createParallelizePass() {  //
+  return std::make_unique<ParallelizePass>();
+}
+
+static PassRegistration<ParallelizePass> pass(  //
+    "x86-parallelize",                          //
+    "Outline parallel loops for dispatch to the runtime's parallel-for");
+
+}  // namespace pmlc::target::x86
@@ -0,0 +1,27 @@
+// Copyright 2020, Intel Corporation
+
+#pragma once
+
+#include <memory>
+
+namespace mlir {
+class Pass;
+}  // namespace mlir
+
+namespace pmlc::target::x86 {
+
+// Outlines the body of each sufficiently large top-level pxa.parallel_for
+// into a function which runs one of its parallel indices over a subrange, and
+// replaces the loop with a call to that function over the full range.  The
+// compiler dispatches these calls to the runtime's parallel-for.
+std::unique_ptr<mlir::Pass> createParallelizePass();
+
+// Outlines each pxa.parallel_for which computes a small matrix product into a
+// function which the compiler lowers to a libxsmm microkernel.
+std::unique_ptr<mlir::Pass> createXSMMPass();
+
+// Unrolls the innermost stride-1 affine.for loops by the host's vector width,
+// so that LLVM's SLP vectorizer can form full-width vector operations.
+std::unique_ptr<mlir::Pass> createVectorUnrollPass();
+
+}  // namespace pmlc::target::x86
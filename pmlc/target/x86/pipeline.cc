@@ -1,5 +1,7 @@
 // Copyright 2019, Intel Corporation
 
+#include <thread>
+
 #include "mlir/Conversion/LoopToStandard/ConvertLoopToStandard.h"
 #include "mlir/Conversion/StandardToLLVM/ConvertStandardToLLVMPass.h"
 #include "mlir/Pass/Pass.h"
@@ -8,18 +10,38 @@
 
 #include "pmlc/compiler/registry.h"
 #include "pmlc/conversion/pxa_to_affine/pxa_to_affine.h"
+#include "pmlc/dialect/pxa/transforms/passes.h"
+#include "pmlc/target/x86/passes.h"
 
 using namespace mlir;  // NOLINT[build/namespaces]
 using pmlc::conversion::pxa_to_affine::createLowerPXAToAffinePass;
+using pmlc::dialect::pxa::createAutoTilePass;
+using pmlc::dialect::pxa::createBufferReusePass;
+using pmlc::dialect::pxa::createLoopOrderPass;
+using pmlc::dialect::pxa::createSplitReductionPass;
 
 namespace pmlc::target::x86 {
 
+// The per-core cache size targeted by tiling.
+static constexpr uint64_t kCacheBytes = 256 * 1024;
+
+// Reductions over loops with fewer parallel iterations than hardware threads
+// are split into partial reductions of at least this many values each.
+static constexpr int64_t kMinPartialRange = 1024;
+
 static compiler::TargetRegistration pipeline("llvm_cpu", [](OpPassManager* pm) {
-  // TODO: do optimizations here
+  pm->addNestedPass<FuncOp>(createSplitReductionPass(std::thread::hardware_concurrency(), kMinPartialRange));
+  pm->addNestedPass<FuncOp>(createLoopOrderPass());
+  pm->addNestedPass<FuncOp>(createAutoTilePass(kCacheBytes));
+  pm->addNestedPass<FuncOp>(createCanonicalizerPass());
+  pm->addNestedPass<FuncOp>(createBufferReusePass());
+  pm->addPass(createParallelizePass());
+  pm->addPass(createXSMMPass());
 
   pm->addPass(createLowerPXAToAffinePass());
   pm->addNestedPass<FuncOp>(createCanonicalizerPass());
   pm->addNestedPass<FuncOp>(createCSEPass());
+  pm->addNestedPass<FuncOp>(createVectorUnrollPass());
 
   pm->addPass(createLowerAffinePass());
   pm->addNestedPass<FuncOp>(createCanonicalizerPass());
@@ -0,0 +1,61 @@
+// RUN: pmlc-opt -x86-parallelize %s | FileCheck %s
+
+#sum = (i, j) -> (j)
+
+func @eltwise(%arg0: memref<256x256xf32>, %arg1: memref<256x256xf32>) {
+  "pxa.parallel_for"() ( {
+  ^bb0(%i: index, %j: index):
+    %0 = affine.load %arg0[%i, %j] : memref<256x256xf32>
+    affine.store %0, %arg1[%i, %j] : memref<256x256xf32>
+    "affine.terminator"() : () -> ()
+  }) {ranges = [256, 256]} : () -> ()
+  return
+}
+
+// CHECK-LABEL: func @eltwise
+// CHECK-DAG: %[[C0:.*]] = constant 0 : index
+// CHECK-DAG: %[[C256:.*]] = constant 256 : index
+// CHECK: call @eltwise_parallel(%[[C0]], %[[C256]], %arg0, %arg1)
+// CHECK-NOT: pxa.parallel_for
+
+func @sum_rows(%arg0: memref<256x256xf32>, %arg1: memref<256xf32>) {
+  "pxa.parallel_for"() ( {
+  ^bb0(%i: index, %j: index):
+    %0 = affine.load %arg0[%i, %j] : memref<256x256xf32>
+    "pxa.reduce"(%0, %arg1, %i, %j) {agg = 1 : i64, map = #sum} : (f32, memref<256xf32>, index, index) -> ()
+    "affine.terminator"() : () -> ()
+  }) {ranges = [256, 256]} : () -> ()
+  return
+}
+
+// CHECK-LABEL: func @sum_rows
+// CHECK: call @sum_rows_parallel
+
+func @small(%arg0: memref<16x16xf32>, %arg1: memref<16x16xf32>) {
+  "pxa.parallel_for"() ( {
+  ^bb0(%i: index, %j: index):
+    %0 = affine.load %arg0[%i, %j] : memref<16x16xf32>
+    affine.store %0, %arg1[%i, %j] : memref<16x16xf32>
+    "affine.terminator"() : () -> ()
+  }) {ranges = [16, 16]} : () -> ()
+  return
+}
+
+// CHECK-LABEL: func @small
+// CHECK-NOT: call
+// CHECK: pxa.parallel_for
+
+// CHECK-LABEL: func @eltwise_parallel
+// CHECK-SAME: (%[[BEGIN:.*]]: index, %[[END:.*]]: index, %{{.*}}: memref<256x256xf32>, %{{.*}}: memref<256x256xf32>)
+// CHECK-SAME: attributes {pmlc.parallel_grain = 32 : i64}
+// CHECK: affine.for %[[I:.*]] = %[[BEGIN]] to %[[END]]
+// CHECK: ^bb0(%[[J:.*]]: index):
+// CHECK: affine.load %{{.*}}[%[[I]], %[[J]]]
+// CHECK: ranges = [256]
+
+// The reduction index can't be split, so the columns are split instead.
+// CHECK-LABEL: func @sum_rows_parallel
+// CHECK: affine.for %[[J:.*]] = %{{.*}} to %{{.*}}
+// CHECK: ^bb0(%[[I:.*]]: index):
+// CHECK: affine.load %{{.*}}[%[[I]], %[[J]]]
+// CHECK: ranges = [256]
@@ -0,0 +1,42 @@
+// RUN: pmlc-opt -x86-xsmm %s | FileCheck %s
+
+#c = (i, j, k) -> (i, j)
+
+func @dot(%arg0: memref<16x32xf32>, %arg1: memref<32x8xf32>, %arg2: memref<16x8xf32>) {
+  "pxa.parallel_for"() ( {
+  ^bb0(%i: index, %j: index, %k: index):
+    %0 = affine.load %arg0[%i, %k] : memref<16x32xf32>
+    %1 = affine.load %arg1[%k, %j] : memref<32x8xf32>
+    %2 = mulf %0, %1 : f32
+    "pxa.reduce"(%2, %arg2, %i, %j, %k) {agg = 1 : i64, map = #c} : (f32, memref<16x8xf32>, index, index, index) -> ()
+    "affine.terminator"() : () -> ()
+  }) {ranges = [16, 8, 32]} : () -> ()
+  return
+}
+
+// CHECK-LABEL: func @dot
+// CHECK: call @dot_xsmm(%arg1, %arg0, %arg2, %{{.*}}, %{{.*}}, %{{.*}})
+// CHECK-NOT: pxa.parallel_for
+// CHECK: return
+
+func @transposed(%arg0: memref<32x16xf32>, %arg1: memref<32x8xf32>, %arg2: memref<16x8xf32>) {
+  "pxa.parallel_for"() ( {
+  ^bb0(%i: index, %j: index, %k: index):
+    %0 = affine.load %arg0[%k, %i] : memref<32x16xf32>
+    %1 = affine.load %arg1[%k, %j] : memref<32x8xf32>
+    %2 = mulf %0, %1 : f32
+    "pxa.reduce"(%2, %arg2, %i, %j, %k) {agg = 1 : i64, map = #c} : (f32, memref<16x8xf32>, index, index, index) -> ()
+    "affine.terminator"() : () -> ()
+  }) {ranges = [16, 8, 32]} : () -> ()
+  return
+}
+
+// A which isn't contiguous along k doesn't match.
+// CHECK-LABEL: func @transposed
+// CHECK: pxa.parallel_for
+// CHECK-NOT: call
+
+// CHECK-LABEL: func @dot_xsmm
+// CHECK-SAME: pmlc.xsmm = [8, 16, 32, 8, 32, 8]
+// CHECK: pxa.parallel_for
+// CHECK: return
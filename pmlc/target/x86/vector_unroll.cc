@@ -0,0 +1,116 @@
+// Copyright 2020, Intel Corporation
+
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Host.h"
+
+#include "mlir/Analysis/LoopAnalysis.h"
+#include "mlir/Dialect/AffineOps/AffineOps.h"
+#include "mlir/IR/Function.h"
+#include "mlir/IR/StandardTypes.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/Transforms/LoopUtils.h"
+
+#include "base/util/logging.h"
+#include "pmlc/target/x86/passes.h"
+
+using namespace mlir;  // NOLINT[build/namespaces]
+
+namespace pmlc::target::x86 {
+
+namespace {
+
+// The width in bytes of the widest vector registers on the host.
+unsigned getHostVectorBytes() {
+  llvm::StringMap<bool> features;
+  if (llvm::sys::getHostCPUFeatures(features)) {
+    if (features.lookup("avx512f")) {
+      return 64;
+    }
+    if (features.lookup("avx")) {
+      return 32;
+    }
+  }
+  return 16;
+}
+
+// Returns the element size in bytes if every load and store in the loop's body
+// is to the loop's induction variable with a unit stride in the innermost
+// dimension of an identity-layout memref; otherwise returns zero.
+unsigned getUnitStrideElementBytes(AffineForOp op) {
+  auto iv = op.getInductionVar();
+  unsigned bytes = 0;
+  bool legal = true;
+  auto check = [&](Value memref, AffineMap map, ValueRange operands) {
+    auto type = memref.getType().cast<MemRefType>();
+    if (!type.getAffineMaps().empty() || !type.getElementType().isIntOrFloat() || !map.getNumResults()) {
+      legal = false;
+      return;
+    }
+    for (unsigned i = 0; i < operands.size(); i++) {
+      if (operands[i] != iv) {
+        continue;
+      }
+      // The induction variable may only appear as the innermost index.
+      auto inner = map.getResult(map.getNumResults() - 1);
+      if (i >= map.getNumDims() || inner != getAffineDimExpr(i, op.getContext())) {
+        legal = false;
+        return;
+      }
+      for (unsigned j = 0; j + 1 < map.getNumResults(); j++) {
+        if (map.getResult(j).isFunctionOfDim(i)) {
+          legal = false;
+          return;
+        }
+      }
+    }
+    auto elementBytes = type.getElementType().getIntOrFloatBitWidth() / 8;
+    if (elementBytes && (!bytes || elementBytes < bytes)) {
+      bytes = elementBytes;
+    }
+  };
+  op.getBody()->walk([&](Operation* inner) {
+    if (isa<AffineForOp>(inner)) {
+      legal = false;
+    } else if (auto load = dyn_cast<AffineLoadOp>(inner)) {
+      check(load.getMemRef(), load.getAffineMap(), load.getMapOperands());
+    } else if (auto store = dyn_cast<AffineStoreOp>(inner)) {
+      check(store.getMemRef(), store.getAffineMap(), store.getMapOperands());
+    }
+  });
+  return legal ? bytes : 0;
+}
+
+struct VectorUnrollPass : public FunctionPass<VectorUnrollPass> {
+  void runOnFunction() override {
+    auto vectorBytes = getHostVectorBytes();
+    SmallVector<AffineForOp, 8> loops;
+    getFunction().walk([&](AffineForOp op) { loops.push_back(op); });
+    for (auto op : loops) {
+      auto elementBytes = getUnitStrideElementBytes(op);
+      if (!elementBytes) {
+        continue;
+      }
+      uint64_t factor = vectorBytes / elementBytes;
+      auto tripCount = getConstantTripCount(op);
+      if (factor < 2 || !tripCount || *tripCount < factor) {
+        continue;
+      }
+      IVLOG(3, "VectorUnrollPass> unrolling by " << factor);
+      if (failed(loopUnrollByFactor(op, factor))) {
+        IVLOG(3, "VectorUnrollPass> unable to unroll loop");
+      }
+    }
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<Pass> createVectorUnrollPass() {  //
+  return std::make_unique<VectorUnrollPass>();
+}
+
+static PassRegistration<VectorUnrollPass> pass(  //
+    "x86-vector-unroll",                         //
+    "Unroll innermost unit-stride loops by the host vector width");
+
+}  // namespace pmlc::target::x86
@@ -0,0 +1,229 @@
+// Copyright 2020, Intel Corporation
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "llvm/ADT/SetVector.h"
+
+#include "mlir/Dialect/AffineOps/AffineOps.h"
+#include "mlir/Dialect/StandardOps/Ops.h"
+#include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/Function.h"
+#include "mlir/IR/Module.h"
+#include "mlir/IR/StandardTypes.h"
+#include "mlir/IR/SymbolTable.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/Transforms/RegionUtils.h"
+
+#include "base/util/logging.h"
+#include "pmlc/compiler/xsmm.h"
+#include "pmlc/dialect/pxa/ir/ops.h"
+#include "pmlc/dialect/pxa/transforms/stride_info.h"
+#include "pmlc/target/x86/passes.h"
+
+using namespace mlir;  // NOLINT[build/namespaces]
+
+namespace pmlc::target::x86 {
+
+namespace pxa = dialect::pxa;
+
+namespace {
+
+// libxsmm only generates microkernels for products up to this size along each
+// dimension; larger products should have been tiled first.
+constexpr int64_t kMaxKernelSize = 256;
+
+// A matrix product C[i, j] += A[i, k] * B[k, j] matched in the body of a loop,
+// in terms of the loop's indices.
+struct Stencil {
+  AffineLoadOp a;
+  AffineLoadOp b;
+  pxa::AffineReduceOp c;
+  compiler::XSMMKernel kernel;
+};
+
+const pxa::StrideInfo* findAccess(ArrayRef<pxa::StrideInfo> accesses, Value memref, bool isWrite) {
+  for (const auto& access : accesses) {
+    if (access.memref == memref && access.isWrite == isWrite) {
+      return &access;
+    }
+  }
+  return nullptr;
+}
+
+// Matches a loop over exactly three indices whose body loads one element of
+// each of A and B, multiplies them, and accumulates the product into C, where
+// j is the unit-stride index of both C and B and k is the unit-stride index of
+// A.  (These are the contiguous dimensions libxsmm needs, viewing each
+// row-major matrix as its column-major transpose.)  Since the body holds
+// nothing else, the accesses depend only on the loop's own indices and values
+// defined outside the loop.
+Optional<Stencil> matchStencil(pxa::AffineParallelForOp op) {
+  auto& body = op.inner().front();
+  if (!op.dynamic_ranges().empty() || body.getNumArguments() != 3 || body.getOperations().size() != 5) {
+    return llvm::None;
+  }
+  auto it = body.begin();
+  auto load0 = dyn_cast<AffineLoadOp>(*it++);
+  auto load1 = dyn_cast<AffineLoadOp>(*it++);
+  auto mul = dyn_cast<MulFOp>(*it++);
+  auto reduce = dyn_cast<pxa::AffineReduceOp>(*it++);
+  if (!load0 || !load1 || !mul || !reduce || reduce.agg() != util::AggregationKind::add ||
+      reduce.val() != mul.getResult() || load0.getMemRef() == load1.getMemRef() ||
+      reduce.out() == load0.getMemRef() || reduce.out() == load1.getMemRef()) {
+    return llvm::None;
+  }
+  auto elementType = mul.getType();
+  if (!elementType.isF32() && !elementType.isF64()) {
+    return llvm::None;
+  }
+  if (!((mul.lhs() == load0.getResult() && mul.rhs() == load1.getResult()) ||
+        (mul.lhs() == load1.getResult() && mul.rhs() == load0.getResult()))) {
+    return llvm::None;
+  }
+  auto ranges = pxa::getRanges(op);
+  auto accesses = pxa::computeStrideInfo(op);
+  auto c = findAccess(accesses, reduce.out(), true);
+  if (!c) {
+    return llvm::None;
+  }
+  for (auto [a, b] : {std::make_pair(load0, load1), std::make_pair(load1, load0)}) {
+    auto aInfo = findAccess(accesses, a.getMemRef(), false);
+    auto bInfo = findAccess(accesses, b.getMemRef(), false);
+    if (!aInfo || !bInfo) {
+      continue;
+    }
+    for (unsigned j = 0; j < 3; j++) {
+      for (unsigned k = 0; k < 3; k++) {
+        auto i = 3 - j - k;
+        if (j == k || i > 2 || i == j || i == k) {
+          continue;
+        }
+        const auto& as = aInfo->strides;
+        const auto& bs = bInfo->strides;
+        const auto& cs = c->strides;
+        if (cs[j] != 1 || bs[j] != 1 || as[j] != 0 ||  //
+            cs[i] <= 0 || as[i] <= 0 || bs[i] != 0 ||  //
+            cs[k] != 0 || as[k] != 1 || bs[k] <= 0 ||  //
+            ranges[i] > kMaxKernelSize || ranges[j] > kMaxKernelSize || ranges[k] > kMaxKernelSize) {
+          continue;
+        }
+        compiler::XSMMKernel kernel{
+            static_cast<int32_t>(ranges[j]),  // m
+            static_cast<int32_t>(ranges[i]),  // n
+            static_cast<int32_t>(ranges[k]),  // k
+            static_cast<int32_t>(bs[k]),      // lda
+            static_cast<int32_t>(as[i]),      // ldb
+            static_cast<int32_t>(cs[i]),      // ldc
+        };
+        return Stencil{a, b, reduce, kernel};
+      }
+    }
+  }
+  return llvm::None;
+}
+
+// Builds the linear offset (in elements) of the access when each of the
+// loop's indices is zero, in terms of values defined outside the loop.
+Value buildBaseOffset(OpBuilder* builder, pxa::AffineParallelForOp op, Value memref, AffineMap map,
+                      ValueRange operands) {
+  auto loc = op.getLoc();
+  auto type = memref.getType().cast<MemRefType>();
+  SmallVector<int64_t, 4> strides;
+  int64_t offset;
+  if (failed(getStridesAndOffset(type, strides, offset))) {
+    throw std::runtime_error("XSMMPass: unexpected memref layout");
+  }
+  auto zero = builder->create<ConstantIndexOp>(loc, 0);
+  SmallVector<Value, 8> outerOperands;
+  for (auto operand : operands) {
+    auto arg = operand.dyn_cast<BlockArgument>();
+    outerOperands.push_back(arg && arg.getOwner() == &op.inner().front() ? zero.getResult() : operand);
+  }
+  auto expr = builder->getAffineConstantExpr(0);
+  for (unsigned i = 0; i < map.getNumResults(); i++) {
+    expr = expr + map.getResult(i) * strides[i];
+  }
+  auto linear = AffineMap::get(map.getNumDims(), map.getNumSymbols(), expr);
+  return builder->create<AffineApplyOp>(loc, linear, outerOperands);
+}
+
+struct XSMMPass : public ModulePass<XSMMPass> {
+  void runOnModule() override {
+    SymbolTable symbolTable(getModule());
+    SmallVector<std::pair<pxa::AffineParallelForOp, Stencil>, 8> matches;
+    for (auto func : getModule().getOps<FuncOp>()) {
+      func.walk([&](pxa::AffineParallelForOp op) {
+        if (auto stencil = matchStencil(op)) {
+          matches.emplace_back(op, *stencil);
+        }
+      });
+    }
+    for (auto& [op, stencil] : matches) {
+      outline(op, stencil, &symbolTable);
+    }
+  }
+
+  // Moves the loop into a new function marked for lowering to a libxsmm
+  // microkernel, and replaces it with a call to that function.
+  void outline(pxa::AffineParallelForOp op, const Stencil& stencil, SymbolTable* symbolTable) {
+    auto loc = op.getLoc();
+    auto func = op.getParentOfType<FuncOp>();
+    OpBuilder builder(op.getOperation());
+
+    // The microkernel's operands, in libxsmm's terms.
+    Value memrefs[] = {stencil.b.getMemRef(), stencil.a.getMemRef(), stencil.c.out()};
+    Value offsets[] = {
+        buildBaseOffset(&builder, op, stencil.b.getMemRef(), stencil.b.getAffineMap(), stencil.b.getMapOperands()),
+        buildBaseOffset(&builder, op, stencil.a.getMemRef(), stencil.a.getAffineMap(), stencil.a.getMapOperands()),
+        buildBaseOffset(&builder, op, stencil.c.out(), stencil.c.map(), stencil.c.idxs()),
+    };
+
+    llvm::SetVector<Value> used;
+    getUsedValuesDefinedAbove(op.inner(), used);
+    for (auto memref : memrefs) {
+      used.remove(memref);
+    }
+    SmallVector<Value, 8> args(std::begin(memrefs), std::end(memrefs));
+    args.append(std::begin(offsets), std::end(offsets));
+    args.append(used.begin(), used.end());
+    SmallVector<Type, 8> argTypes;
+    for (auto arg : args) {
+      argTypes.push_back(arg.getType());
+    }
+
+    auto name = (func.getName() + "_xsmm").str();
+    auto outlined = FuncOp::create(loc, name, builder.getFunctionType(argTypes, {}));
+    const auto& kernel = stencil.kernel;
+    outlined.setAttr(compiler::kXSMMAttrName,
+                     builder.getI64ArrayAttr({kernel.m, kernel.n, kernel.k, kernel.lda, kernel.ldb, kernel.ldc}));
+    symbolTable->insert(outlined);
+
+    auto entry = outlined.addEntryBlock();
+    OpBuilder body(entry);
+    BlockAndValueMapping mapping;
+    for (unsigned i = 0; i < args.size(); i++) {
+      mapping.map(args[i], entry->getArgument(i));
+    }
+    body.clone(*op.getOperation(), mapping);
+    body.create<ReturnOp>(loc);
+
+    IVLOG(3, "XSMMPass> " << name << ": " << kernel.m << "x" << kernel.n << "x" << kernel.k);
+    builder.create<CallOp>(loc, outlined, args);
+    op.erase();
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<Pass> createXSMMPass() {  //
+  return std::make_unique<XSMMPass>();
+}
+
+static PassRegistration<XSMMPass> pass(  //
+    "x86-xsmm",                          //
+    "Outline matrix product loops for lowering to libxsmm microkernels");
+
+}  // namespace pmlc::target::x86
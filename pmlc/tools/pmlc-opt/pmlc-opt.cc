@@ -49,7 +49,7 @@ int main(int argc, char** argv) {
   if (level_str.size()) {
     auto level = std::atoi(level_str.c_str());
     if (level) {
-      el::Loggers::setVerboseLevel(level);
+      vertexai::SetVerbosity(level);
     }
     IVLOG(level, "PLAIDML_VERBOSE=" << level);
   }
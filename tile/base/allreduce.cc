@@ -0,0 +1,275 @@
+// Copyright 2020, Intel Corporation.
+
+#include "tile/base/allreduce.h"
+
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+#include <half.hpp>
+
+#include "base/util/logging.h"
+
+namespace vertexai {
+namespace tile {
+
+struct AllReduceRound {
+  explicit AllReduceRound(std::size_t replicas) : values(replicas), data(replicas) {
+    future = done.get_future().share();
+  }
+
+  std::vector<std::vector<AllReduceValue>> values;    // By replica, then tensor
+  std::vector<std::vector<std::vector<char>>> data;  // By replica, then tensor
+  boost::promise<void> done;
+  boost::shared_future<void> future;
+  std::size_t contributed = 0;  // Guarded by the AllReducer's mutex
+
+  std::mutex mu;
+  std::size_t read = 0;
+  std::exception_ptr error;
+};
+
+namespace {
+
+struct PendingReduce {
+  const AllReduceRound* round;
+  boost::shared_future<void> future;
+};
+
+std::mutex& PendingMutex() {
+  static std::mutex mu;
+  return mu;
+}
+
+std::unordered_map<const Buffer*, PendingReduce>& Pending() {
+  static std::unordered_map<const Buffer*, PendingReduce> pending;
+  return pending;
+}
+
+template <typename T>
+void AccumulateAs(char* dst, const char* src, std::size_t bytes) {
+  auto count = bytes / sizeof(T);
+  auto dst_elems = reinterpret_cast<T*>(dst);
+  auto src_elems = reinterpret_cast<const T*>(src);
+  for (std::size_t idx = 0; idx < count; idx++) {
+    dst_elems[idx] += src_elems[idx];
+  }
+}
+
+// Adds src into dst, elementwise.  The type has already been checked by IsSummable.
+void Accumulate(DataType type, char* dst, const char* src, std::size_t bytes) {
+  switch (type) {
+    case DataType::INT8:
+      AccumulateAs<std::int8_t>(dst, src, bytes);
+      break;
+    case DataType::INT16:
+      AccumulateAs<std::int16_t>(dst, src, bytes);
+      break;
+    case DataType::INT32:
+      AccumulateAs<std::int32_t>(dst, src, bytes);
+      break;
+    case DataType::INT64:
+      AccumulateAs<std::int64_t>(dst, src, bytes);
+      break;
+    case DataType::UINT8:
+      AccumulateAs<std::uint8_t>(dst, src, bytes);
+      break;
+    case DataType::UINT16:
+      AccumulateAs<std::uint16_t>(dst, src, bytes);
+      break;
+    case DataType::UINT32:
+      AccumulateAs<std::uint32_t>(dst, src, bytes);
+      break;
+    case DataType::UINT64:
+      AccumulateAs<std::uint64_t>(dst, src, bytes);
+      break;
+    case DataType::FLOAT16:
+      AccumulateAs<half_float::half>(dst, src, bytes);
+      break;
+    case DataType::FLOAT32:
+      AccumulateAs<float>(dst, src, bytes);
+      break;
+    case DataType::FLOAT64:
+      AccumulateAs<double>(dst, src, bytes);
+      break;
+    default:
+      break;
+  }
+}
+
+bool IsSummable(DataType type) {
+  switch (type) {
+    case DataType::INT8:
+    case DataType::INT16:
+    case DataType::INT32:
+    case DataType::INT64:
+    case DataType::UINT8:
+    case DataType::UINT16:
+    case DataType::UINT32:
+    case DataType::UINT64:
+    case DataType::FLOAT16:
+    case DataType::FLOAT32:
+    case DataType::FLOAT64:
+      return true;
+    default:
+      return false;
+  }
+}
+
+void ClearPending(const AllReduceRound& round) {
+  std::lock_guard<std::mutex> lock{PendingMutex()};
+  auto& pending = Pending();
+  for (const auto& values : round.values) {
+    for (const auto& value : values) {
+      auto it = pending.find(value.buffer.get());
+      if (it != pending.end() && it->second.round == &round) {
+        pending.erase(it);
+      }
+    }
+  }
+}
+
+// Sums the round's values and writes the sums back to every replica.
+void WriteSums(const context::Context& ctx, AllReduceRound* round) {
+  auto sums = round->data[0];
+  for (std::size_t replica = 1; replica < round->data.size(); replica++) {
+    for (std::size_t tensor = 0; tensor < sums.size(); tensor++) {
+      Accumulate(round->values[0][tensor].type, sums[tensor].data(), round->data[replica][tensor].data(),
+                 sums[tensor].size());
+    }
+  }
+  for (const auto& values : round->values) {
+    for (std::size_t tensor = 0; tensor < sums.size(); tensor++) {
+      auto view = values[tensor].buffer->MapDiscard(ctx);
+      std::memcpy(view->data(), sums[tensor].data(), sums[tensor].size());
+      view->WriteBack(ctx);
+    }
+  }
+}
+
+// Reads one replica's contribution; the last replica read finishes the round.
+void ReadContribution(const context::Context& ctx, const std::shared_ptr<AllReduceRound>& round, std::size_t replica,
+                      boost::shared_future<void> ready) {
+  std::vector<std::vector<char>> data;
+  std::exception_ptr error;
+  try {
+    if (ready.valid()) {
+      ready.get();
+    }
+    for (const auto& value : round->values[replica]) {
+      auto view = value.buffer->MapCurrent(ctx).get();
+      data.emplace_back(view->data(), view->data() + view->size());
+    }
+  } catch (...) {
+    error = std::current_exception();
+  }
+  {
+    std::lock_guard<std::mutex> lock{round->mu};
+    round->data[replica] = std::move(data);
+    if (error && !round->error) {
+      round->error = error;
+    }
+    if (++round->read < round->values.size()) {
+      return;
+    }
+  }
+  try {
+    if (round->error) {
+      std::rethrow_exception(round->error);
+    }
+    WriteSums(ctx, round.get());
+    round->done.set_value();
+  } catch (const std::exception& ex) {
+    LOG(ERROR) << "All-reduce failed: " << ex.what();
+    round->done.set_exception(std::current_exception());
+  } catch (...) {
+    round->done.set_exception(std::current_exception());
+  }
+  ClearPending(*round);
+}
+
+}  // namespace
+
+AllReducer::AllReducer(std::size_t replicas) : replicas_{replicas} {
+  if (!replicas_) {
+    throw std::invalid_argument("An all-reduce requires at least one replica");
+  }
+}
+
+AllReducer::~AllReducer() {
+  for (auto& read : reads_) {
+    read.wait();
+  }
+}
+
+boost::shared_future<void> AllReducer::Contribute(const context::Context& ctx, std::vector<AllReduceValue> values,
+                                                  boost::shared_future<void> ready) {
+  std::lock_guard<std::mutex> lock{mu_};
+  reads_.remove_if([](boost::future<void>& read) { return read.is_ready(); });
+  if (!round_) {
+    round_ = std::make_shared<AllReduceRound>(replicas_);
+  }
+  auto replica = round_->contributed;
+  if (replica) {
+    const auto& first = round_->values[0];
+    if (values.size() != first.size()) {
+      throw std::invalid_argument("All-reduce contributions differ in their number of tensors");
+    }
+    for (std::size_t idx = 0; idx < values.size(); idx++) {
+      if (values[idx].type != first[idx].type || values[idx].buffer->size() != first[idx].buffer->size()) {
+        throw std::invalid_argument("All-reduce contributions differ in the type or size of tensor " +
+                                    std::to_string(idx));
+      }
+    }
+  }
+  for (const auto& value : values) {
+    if (!IsSummable(value.type)) {
+      throw std::invalid_argument("All-reduce does not support tensors of type " + to_string(value.type));
+    }
+  }
+  round_->values[replica] = std::move(values);
+  round_->contributed++;
+  {
+    std::lock_guard<std::mutex> pending_lock{PendingMutex()};
+    for (const auto& value : round_->values[replica]) {
+      Pending()[value.buffer.get()] = PendingReduce{round_.get(), round_->future};
+    }
+  }
+  auto round = round_;
+  if (replica + 1 == replicas_) {
+    round_.reset();
+  }
+  reads_.emplace_back(boost::async(boost::launch::async, [ctx, round, replica, ready] {  //
+    ReadContribution(ctx, round, replica, ready);
+  }));
+  return round->future;
+}
+
+void WaitForAllReduce(const std::map<std::string, std::shared_ptr<Buffer>>& buffers) {
+  std::vector<boost::shared_future<void>> futures;
+  {
+    std::lock_guard<std::mutex> lock{PendingMutex()};
+    const auto& pending = Pending();
+    for (const auto& kvp : buffers) {
+      auto it = pending.find(kvp.second.get());
+      if (it != pending.end()) {
+        futures.push_back(it->second.future);
+      }
+    }
+  }
+  for (auto& future : futures) {
+    future.wait();
+  }
+}
+
+boost::shared_future<void> PendingAllReduce(const Buffer* buffer) {
+  std::lock_guard<std::mutex> lock{PendingMutex()};
+  const auto& pending = Pending();
+  auto it = pending.find(buffer);
+  return it == pending.end() ? boost::shared_future<void>{} : it->second.future;
+}
+
+}  // namespace tile
+}  // namespace vertexai
@@ -0,0 +1,76 @@
+// Copyright 2020, Intel Corporation.
+
+#pragma once
+
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <boost/thread/future.hpp>
+
+#include "base/context/context.h"
+#include "tile/base/buffer.h"
+#include "tile/base/shape.h"
+
+namespace vertexai {
+namespace tile {
+
+// One replica's value of a tensor to be summed across the replicas.
+struct AllReduceValue {
+  std::shared_ptr<Buffer> buffer;
+  DataType type;
+};
+
+struct AllReduceRound;
+
+// Sums tensors across the replicas of a data-parallel computation, such as
+// the gradients of a training step run on several devices.
+//
+// Each round, every replica contributes its values of the same tensors, in
+// the same order.  Each contribution is read from its device as soon as the
+// writes pending on its buffers complete, so communication with the replicas
+// which finish early overlaps the computation of those still running.  Once
+// every replica has contributed, the values are summed in replica order (so
+// the sums don't depend on timing), and every contributed buffer is
+// overwritten with the sums.
+//
+// The HALs have no copies between devices, so the values pass through host
+// mappings of the buffers.
+class AllReducer {
+ public:
+  explicit AllReducer(std::size_t replicas);
+
+  // Waits for the reductions in flight.
+  ~AllReducer();
+
+  // Adds one replica's values to the current round, returning a future which
+  // completes once the round's sums have been written back.  If supplied,
+  // the values are read once ready completes (typically, the run which
+  // computes them).
+  boost::shared_future<void> Contribute(const context::Context& ctx, std::vector<AllReduceValue> values,
+                                        boost::shared_future<void> ready = boost::shared_future<void>{});
+
+  std::size_t replicas() const { return replicas_; }
+
+ private:
+  std::size_t replicas_;
+  std::mutex mu_;
+  std::shared_ptr<AllReduceRound> round_;  // The round awaiting contributions
+  std::list<boost::future<void>> reads_;
+};
+
+// Waits for the all-reductions which will overwrite any of the buffers, so
+// that a program run on them sees the sums.
+void WaitForAllReduce(const std::map<std::string, std::shared_ptr<Buffer>>& buffers);
+
+// Returns the all-reduction which will overwrite the buffer, or an invalid
+// future if there's none.  Programs which wait for their buffers' sums
+// themselves (see Program::WaitsForAllReduce) use this to wait for each
+// buffer only when they first need it.
+boost::shared_future<void> PendingAllReduce(const Buffer* buffer);
+
+}  // namespace tile
+}  // namespace vertexai
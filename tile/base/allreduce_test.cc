@@ -0,0 +1,93 @@
+// Copyright 2020, Intel Corporation.
+
+#include <gmock/gmock.h>
+
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "tile/base/allreduce.h"
+
+using ::testing::ElementsAre;
+
+namespace vertexai {
+namespace tile {
+namespace {
+
+template <typename T>
+std::shared_ptr<Buffer> MakeBuffer(const std::vector<T>& values) {
+  std::vector<char> data(values.size() * sizeof(T));
+  std::memcpy(data.data(), values.data(), data.size());
+  return std::make_shared<SimpleBuffer>(data);
+}
+
+template <typename T>
+std::vector<T> ReadBuffer(const std::shared_ptr<Buffer>& buffer) {
+  auto view = buffer->MapCurrent(context::Context{}).get();
+  std::vector<T> values(view->size() / sizeof(T));
+  std::memcpy(values.data(), view->data(), view->size());
+  return values;
+}
+
+TEST(AllReducerTest, SumsEveryReplicasTensors) {
+  AllReducer reducer{3};
+  std::vector<std::shared_ptr<Buffer>> floats;
+  std::vector<std::shared_ptr<Buffer>> ints;
+  std::vector<boost::shared_future<void>> rounds;
+  for (int replica = 0; replica < 3; replica++) {
+    floats.push_back(MakeBuffer<float>({1.5f * replica, 1}));
+    ints.push_back(MakeBuffer<std::int32_t>({replica, 10, 100}));
+    rounds.push_back(reducer.Contribute(context::Context{}, {{floats.back(), DataType::FLOAT32},  //
+                                                             {ints.back(), DataType::INT32}}));
+  }
+  WaitForAllReduce({{"F", floats[1]}});
+  for (auto& round : rounds) {
+    round.get();
+  }
+  for (int replica = 0; replica < 3; replica++) {
+    EXPECT_THAT(ReadBuffer<float>(floats[replica]), ElementsAre(4.5f, 3));
+    EXPECT_THAT(ReadBuffer<std::int32_t>(ints[replica]), ElementsAre(3, 30, 300));
+  }
+}
+
+TEST(AllReducerTest, StartsNewRoundOnceFull) {
+  AllReducer reducer{2};
+  auto a = MakeBuffer<float>({1});
+  auto b = MakeBuffer<float>({2});
+  reducer.Contribute(context::Context{}, {{a, DataType::FLOAT32}});
+  reducer.Contribute(context::Context{}, {{b, DataType::FLOAT32}}).get();
+  reducer.Contribute(context::Context{}, {{a, DataType::FLOAT32}});
+  reducer.Contribute(context::Context{}, {{b, DataType::FLOAT32}}).get();
+  EXPECT_THAT(ReadBuffer<float>(a), ElementsAre(6));
+  EXPECT_THAT(ReadBuffer<float>(b), ElementsAre(6));
+}
+
+TEST(AllReducerTest, TracksPendingReductionsPerBuffer) {
+  AllReducer reducer{2};
+  auto a = MakeBuffer<float>({1});
+  auto b = MakeBuffer<float>({2});
+  auto other = MakeBuffer<float>({3});
+  reducer.Contribute(context::Context{}, {{a, DataType::FLOAT32}});
+  auto pending = PendingAllReduce(a.get());
+  ASSERT_TRUE(pending.valid());
+  EXPECT_FALSE(PendingAllReduce(other.get()).valid());
+  reducer.Contribute(context::Context{}, {{b, DataType::FLOAT32}}).get();
+  pending.get();
+  EXPECT_THAT(ReadBuffer<float>(a), ElementsAre(3));
+}
+
+TEST(AllReducerTest, RejectsMismatchedContributions) {
+  AllReducer reducer{2};
+  reducer.Contribute(context::Context{}, {{MakeBuffer<float>({1, 2}), DataType::FLOAT32}});
+  EXPECT_THROW(reducer.Contribute(context::Context{}, {{MakeBuffer<float>({1}), DataType::FLOAT32}}),
+               std::invalid_argument);
+  EXPECT_THROW(reducer.Contribute(context::Context{}, {{MakeBuffer<float>({1, 2}), DataType::INT32}}),
+               std::invalid_argument);
+  auto flags = MakeBuffer<std::int8_t>({1, 0, 0, 0, 0, 0, 0, 0});
+  EXPECT_THROW(reducer.Contribute(context::Context{}, {{flags, DataType::BOOLEAN}}), std::invalid_argument);
+  reducer.Contribute(context::Context{}, {{MakeBuffer<float>({3, 4}), DataType::FLOAT32}}).get();
+}
+
+}  // namespace
+}  // namespace tile
+}  // namespace vertexai
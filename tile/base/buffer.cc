@@ -0,0 +1,129 @@
+// Copyright 2020, Intel Corporation
+
+#include "tile/base/buffer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include <boost/thread/executors/basic_thread_pool.hpp>
+
+#include "base/util/env.h"
+
+namespace vertexai {
+namespace tile {
+namespace {
+
+// The pool which uploads streamed constant buffers.  Uploads are bound by the transfer bandwidth rather than the
+// host, so a couple of threads suffice; the count can be set with PLAIDML_UPLOAD_THREADS.  It's deliberately leaked,
+// like the other process-wide pools.
+boost::basic_thread_pool* UploadPool() {
+  static boost::basic_thread_pool* pool = []() {
+    unsigned threads = 2;
+    auto env_threads = env::Get("PLAIDML_UPLOAD_THREADS");
+    if (env_threads.length()) {
+      threads = std::max(1, std::atoi(env_threads.c_str()));
+    }
+    return new boost::basic_thread_pool{threads};
+  }();
+  return pool;
+}
+
+// Smaller constants aren't worth hashing and comparing.
+constexpr std::uint64_t kMinSharedConstantBytes = 4096;
+
+// The process-wide index of streamed constants by device and content hash.  Entries are weak, so a constant is freed
+// once the last program using it goes away.
+class SharedConstants {
+ public:
+  static SharedConstants* Instance() {
+    static SharedConstants* instance = new SharedConstants;
+    return instance;
+  }
+
+  // Returns a live constant on device holding exactly bytes if there is one; otherwise uploads bytes into buffer and
+  // records it.
+  BufferPtr Upload(const std::string& device, const BufferPtr& buffer, const std::vector<char>& bytes) {
+    Key key{device, bytes.size(), std::hash<std::string_view>{}(std::string_view{bytes.data(), bytes.size()})};
+    std::vector<BufferPtr> candidates;
+    {
+      std::lock_guard<std::mutex> lock{mu_};
+      auto& entries = index_[key];
+      for (auto it = entries.begin(); it != entries.end();) {
+        if (auto candidate = it->lock()) {
+          candidates.emplace_back(std::move(candidate));
+          ++it;
+        } else {
+          it = entries.erase(it);
+        }
+      }
+    }
+    context::Context ctx;
+    // A matching hash is verified against the contents, so a collision can't alias two constants.
+    for (const auto& candidate : candidates) {
+      auto view = candidate->MapCurrentSync(ctx);
+      if (view->size() >= bytes.size() && !std::memcmp(view->data(), bytes.data(), bytes.size())) {
+        return candidate;
+      }
+    }
+    {
+      auto view = buffer->MapDiscard(ctx);
+      std::copy(bytes.begin(), bytes.end(), view->data());
+      view->WriteBack(ctx);
+    }
+    std::lock_guard<std::mutex> lock{mu_};
+    auto& entries = index_[key];
+    entries.emplace_back(buffer);
+    return buffer;
+  }
+
+ private:
+  using Key = std::tuple<std::string, std::uint64_t, std::size_t>;
+
+  std::mutex mu_;
+  std::map<Key, std::vector<std::weak_ptr<Buffer>>> index_;
+};
+
+}  // namespace
+
+void ConstBufferManager::Stream(const std::string& name, std::uint64_t size, std::function<void(char*)> fill) {
+  auto buffer = allocator->allocate(size);
+  buffers[name] = buffer;
+  auto device = allocator->device_key();
+  uploads[name] = boost::async(*UploadPool(), [buffer, size, device, fill = std::move(fill)]() -> BufferPtr {
+                    context::Context ctx;
+                    if (device.empty() || size < kMinSharedConstantBytes) {
+                      auto view = buffer->MapDiscard(ctx);
+                      fill(view->data());
+                      view->WriteBack(ctx);
+                      return buffer;
+                    }
+                    std::vector<char> bytes(size);
+                    fill(bytes.data());
+                    return SharedConstants::Instance()->Upload(device, buffer, bytes);
+                  }).share();
+}
+
+void ConstBufferManager::Wait(const std::string& name) {
+  auto it = uploads.find(name);
+  if (it != uploads.end()) {
+    auto upload = it->second;
+    uploads.erase(it);
+    buffers[name] = upload.get();
+  }
+}
+
+void ConstBufferManager::Sync() {
+  auto pending = std::move(uploads);
+  uploads.clear();
+  for (auto& kvp : pending) {
+    buffers[kvp.first] = kvp.second.get();
+  }
+}
+
+}  // namespace tile
+}  // namespace vertexai
@@ -2,7 +2,9 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstdint>
+#include <functional>
 #include <map>
 #include <memory>
 #include <string>
@@ -76,19 +78,62 @@ class Buffer {
   // existing contents.
   virtual std::unique_ptr<View> MapDiscard(const context::Context& ctx) = 0;
 
+  // Synchronously maps a read/write view of a buffer's current contents.  Host-resident buffers are mapped directly,
+  // without a future.
+  virtual std::unique_ptr<View> MapCurrentSync(const context::Context& ctx) { return MapCurrent(ctx).get(); }
+
+  // Returns the buffer's memory if the buffer is host-resident -- that is, if its memory is host memory whose contents
+  // are always current, so that it may be read and written directly, without a view -- or nullptr otherwise.
+  virtual char* host_data() { return nullptr; }
+
+  bool host_resident() { return host_data() != nullptr; }
+
   virtual BufferPtr Clone() { throw std::runtime_error("Not implemented"); }
+
+  // Returns a counter which changes whenever the buffer's contents may have changed -- e.g. each time it's mapped, or
+  // written by a program run -- so that results computed from the buffer can tell whether they're still current.
+  std::uint64_t version() const { return version_; }
+
+ protected:
+  // Records a (possible) change to the buffer's contents.
+  void Touch() { ++version_; }
+
+ private:
+  std::atomic<std::uint64_t> version_{0};
 };
 
 class Allocator {
  public:
   virtual ~Allocator() {}
   virtual BufferPtr allocate(size_t size) = 0;
+
+  // Identifies the device the allocator's buffers live on.  Streamed constants with identical contents are shared by
+  // every allocator with the same (non-empty) key.
+  virtual std::string device_key() const { return ""; }
 };
 
-// A mechanism used to modify / optimize constant buffers during compilation
+// A mechanism used to modify / optimize constant buffers during compilation.
+//
+// Constant buffers produced during compilation are streamed: each is uploaded in the background as soon as it's
+// allocated, so that the transfers overlap the rest of compilation (in particular, the HAL build).  A pass must Wait
+// for a buffer before mapping it, and a program must Sync before its first run.
+//
+// Streamed constants are content-hashed as they upload: when a live constant on the same device already holds the
+// same bytes, that buffer replaces the newly allocated one once the upload is waited for, so tied weights and
+// repeated loads of a model share one read-only allocation.
 struct ConstBufferManager {
   std::shared_ptr<Allocator> allocator;
   std::map<std::string, BufferPtr> buffers;
+  std::map<std::string, boost::shared_future<BufferPtr>> uploads;  // Each yields the buffer to use for its name
+
+  // Allocates a new buffer for name, and starts uploading it; fill writes the buffer's contents into a host view.
+  void Stream(const std::string& name, std::uint64_t size, std::function<void(char*)> fill);
+
+  // Waits for the upload of name's buffer, if one is pending, and updates buffers with the buffer it settled on.
+  void Wait(const std::string& name);
+
+  // Waits for every pending upload, updating buffers as Wait does.
+  void Sync();
 };
 
 // A simple buffer backed by a std::vector
@@ -115,11 +160,53 @@ class SimpleBuffer : public Buffer, public std::enable_shared_from_this<SimpleBu
     return std::make_unique<SimpleView>(data_.data(), data_.size());
   }
 
+  std::unique_ptr<View> MapCurrentSync(const context::Context& ctx) final {
+    return std::make_unique<SimpleView>(data_.data(), data_.size());
+  }
+
+  char* host_data() final { return data_.data(); }
+
   BufferPtr Clone() final { return std::make_shared<SimpleBuffer>(data_); }
 
  private:
   std::vector<char> data_;
 };
 
+// A buffer aliasing host memory owned by the caller, which must outlive the buffer.
+class HostBuffer final : public Buffer {
+  class HostView final : public View {
+   public:
+    HostView(char* data, std::size_t size) : View(data, size) {}
+    void WriteBack(const context::Context& ctx) final {}
+  };
+
+ public:
+  HostBuffer(void* data, uint64_t size) : data_(static_cast<char*>(data)), size_(size) {}
+
+  uint64_t size() const final { return size_; }
+
+  boost::future<std::unique_ptr<View>> MapCurrent(const context::Context& ctx) final {
+    std::unique_ptr<View> view(new HostView(data_, size_));
+    return boost::make_ready_future(std::move(view));
+  }
+
+  std::unique_ptr<View> MapDiscard(const context::Context& ctx) final {
+    return std::make_unique<HostView>(data_, size_);
+  }
+
+  std::unique_ptr<View> MapCurrentSync(const context::Context& ctx) final {
+    return std::make_unique<HostView>(data_, size_);
+  }
+
+  char* host_data() final { return data_; }
+
+  // Clones own their memory.
+  BufferPtr Clone() final { return std::make_shared<SimpleBuffer>(std::vector<char>(data_, data_ + size_)); }
+
+ private:
+  char* data_;
+  uint64_t size_;
+};
+
 }  // namespace tile
 }  // namespace vertexai
@@ -0,0 +1,65 @@
+// Copyright 2020, Intel Corporation.
+
+#include <gmock/gmock.h>
+
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include "tile/base/buffer.h"
+
+namespace vertexai {
+namespace tile {
+namespace {
+
+class SimpleAllocator final : public Allocator {
+ public:
+  explicit SimpleAllocator(std::string key) : key_{std::move(key)} {}
+  BufferPtr allocate(size_t size) final { return std::make_shared<SimpleBuffer>(size); }
+  std::string device_key() const final { return key_; }
+
+ private:
+  std::string key_;
+};
+
+ConstBufferManager MakeManager(const std::string& key) {
+  ConstBufferManager manager;
+  manager.allocator = std::make_shared<SimpleAllocator>(key);
+  return manager;
+}
+
+void Fill(ConstBufferManager* manager, const std::string& name, char value) {
+  manager->Stream(name, 8192, [value](char* data) { std::memset(data, value, 8192); });
+}
+
+TEST(ConstBufferManagerTest, SharesIdenticalConstants) {
+  auto first = MakeManager("dev");
+  auto second = MakeManager("dev");
+  Fill(&first, "A", 1);
+  first.Sync();
+  Fill(&second, "B", 1);
+  Fill(&second, "C", 2);
+  second.Sync();
+  EXPECT_EQ(second.buffers.at("B"), first.buffers.at("A"));
+  EXPECT_NE(second.buffers.at("C"), first.buffers.at("A"));
+  context::Context ctx;
+  EXPECT_EQ(second.buffers.at("C")->MapCurrentSync(ctx)->data()[0], 2);
+}
+
+TEST(ConstBufferManagerTest, KeepsDevicesApart) {
+  auto first = MakeManager("dev0");
+  auto second = MakeManager("dev1");
+  auto unkeyed = MakeManager("");
+  Fill(&first, "A", 3);
+  first.Sync();
+  Fill(&second, "A", 3);
+  Fill(&unkeyed, "A", 3);
+  second.Sync();
+  unkeyed.Wait("A");
+  EXPECT_NE(second.buffers.at("A"), first.buffers.at("A"));
+  EXPECT_NE(unkeyed.buffers.at("A"), first.buffers.at("A"));
+}
+
+}  // namespace
+}  // namespace tile
+}  // namespace vertexai
@@ -0,0 +1,182 @@
+// Copyright 2020, Intel Corporation
+
+#include "tile/base/compile_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <exception>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "base/util/env.h"
+
+namespace vertexai {
+namespace tile {
+namespace {
+
+thread_local CompilePriority current_priority = CompilePriority::FOREGROUND;
+
+// A CompileParallelFor call in flight.  Its caller and any helping workers claim indices from next until none remain.
+// A detached job (from CompileAsync) has no caller; it owns its function, and the worker which runs it retires it.
+struct Job {
+  Job(size_t count, size_t max_helpers, const std::function<void(size_t)>* func)
+      : count{count}, max_helpers{max_helpers}, priority{current_priority}, func{func} {}
+
+  explicit Job(std::function<void(size_t)> task)
+      : count{1}, max_helpers{1}, priority{current_priority}, owned{std::move(task)}, func{&owned} {}
+
+  void Work() {
+    for (size_t i = next++; i < count; i = next++) {
+      std::exception_ptr err;
+      try {
+        (*func)(i);
+      } catch (...) {
+        err = std::current_exception();
+      }
+      std::lock_guard<std::mutex> lock{mu};
+      if (err && !error) {
+        error = err;
+      }
+      if (++done == count) {
+        cv.notify_all();
+      }
+    }
+  }
+
+  bool HasWork() const { return next < count; }
+
+  const size_t count;
+  const size_t max_helpers;
+  const CompilePriority priority;
+  const std::function<void(size_t)> owned;
+  const std::function<void(size_t)>* func;
+  std::atomic<size_t> next{0};
+  size_t helpers = 0;  // Guarded by the pool's mutex
+
+  std::mutex mu;
+  std::condition_variable cv;
+  size_t done = 0;
+  std::exception_ptr error;
+};
+
+// The process-wide compile pool.  Since callers work on their own jobs, it starts one worker fewer than the number of
+// compile threads (but at least one, for detached jobs).  It's deliberately leaked, like the other process-wide pools.
+class CompilePool {
+ public:
+  static CompilePool* Instance() {
+    static CompilePool* pool = new CompilePool{std::max<size_t>(1, CompileThreads() - 1)};
+    return pool;
+  }
+
+  void Submit(const std::shared_ptr<Job>& job) {
+    std::lock_guard<std::mutex> lock{mu_};
+    jobs_[job->priority].push_back(job);
+    cv_.notify_all();
+  }
+
+  void Retire(const std::shared_ptr<Job>& job) {
+    std::lock_guard<std::mutex> lock{mu_};
+    jobs_[job->priority].remove(job);
+  }
+
+ private:
+  explicit CompilePool(size_t workers) {
+    for (size_t i = 0; i < workers; i++) {
+      std::thread{[this] { RunWorker(); }}.detach();
+    }
+  }
+
+  void RunWorker() {
+    for (;;) {
+      std::shared_ptr<Job> job;
+      {
+        std::unique_lock<std::mutex> lock{mu_};
+        cv_.wait(lock, [&] { return (job = Pick()) != nullptr; });
+        job->helpers++;
+      }
+      current_priority = job->priority;
+      job->Work();
+      if (job->func == &job->owned) {
+        Retire(job);
+      }
+    }
+  }
+
+  // Returns the oldest job of the highest priority with unclaimed work and room for another helper, if any.
+  std::shared_ptr<Job> Pick() {
+    for (auto it = jobs_.rbegin(); it != jobs_.rend(); ++it) {
+      for (const auto& job : it->second) {
+        if (job->HasWork() && job->helpers < job->max_helpers) {
+          return job;
+        }
+      }
+    }
+    return nullptr;
+  }
+
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::map<CompilePriority, std::list<std::shared_ptr<Job>>> jobs_;
+};
+
+}  // namespace
+
+CompilePriorityScope::CompilePriorityScope(CompilePriority priority) : saved_{current_priority} {
+  current_priority = priority;
+}
+
+CompilePriorityScope::~CompilePriorityScope() { current_priority = saved_; }
+
+CompilePriority CompilePriorityScope::Current() { return current_priority; }
+
+size_t CompileThreads() {
+  static size_t threads = [] {
+    auto env_threads = env::Get("PLAIDML_COMPILE_THREADS");
+    if (env_threads.length()) {
+      return static_cast<size_t>(std::max(1, std::atoi(env_threads.c_str())));
+    }
+    return static_cast<size_t>(std::max(1u, std::thread::hardware_concurrency()));
+  }();
+  return threads;
+}
+
+void CompileParallelFor(size_t count, size_t max_threads, const std::function<void(size_t)>& func) {
+  if (!max_threads) {
+    max_threads = CompileThreads();
+  }
+  max_threads = std::min({max_threads, CompileThreads(), count});
+  if (max_threads <= 1) {
+    for (size_t i = 0; i < count; i++) {
+      func(i);
+    }
+    return;
+  }
+  auto job = std::make_shared<Job>(count, max_threads - 1, &func);
+  auto pool = CompilePool::Instance();
+  pool->Submit(job);
+  job->Work();
+  pool->Retire(job);
+  std::unique_lock<std::mutex> lock{job->mu};
+  job->cv.wait(lock, [&] { return job->done == job->count; });
+  if (job->error) {
+    std::rethrow_exception(job->error);
+  }
+}
+
+void CompileAsync(std::function<void()> task) {
+  auto job = std::make_shared<Job>([task = std::move(task)](size_t) {
+    try {
+      task();
+    } catch (...) {
+    }
+  });
+  CompilePool::Instance()->Submit(job);
+}
+
+}  // namespace tile
+}  // namespace vertexai
@@ -0,0 +1,48 @@
+// Copyright 2020, Intel Corporation
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace vertexai {
+namespace tile {
+
+// The priority of compile work.  When the two compete for the compile pool, work which a live request is waiting for
+// runs ahead of background work (such as compiles made ahead of time).
+enum class CompilePriority {
+  BACKGROUND = 0,
+  FOREGROUND = 1,
+};
+
+// Sets the priority of the compile work started by the current thread while the scope is alive.  Compile work is
+// FOREGROUND by default; work run by the pool's workers inherits the priority of the thread that started it.
+class CompilePriorityScope {
+ public:
+  explicit CompilePriorityScope(CompilePriority priority);
+  ~CompilePriorityScope();
+
+  static CompilePriority Current();
+
+ private:
+  CompilePriority saved_;
+};
+
+// Returns the number of threads compile work may use in total: PLAIDML_COMPILE_THREADS if set, otherwise one per
+// core.
+size_t CompileThreads();
+
+// Invokes func(i) for each i in [0, count) on the process-wide compile pool, on up to max_threads threads (zero
+// meaning CompileThreads()), and returns once every call has finished.  The pool's workers are shared by every
+// compiler in the process, so concurrent compiles divide the cores between them rather than each starting a thread
+// per core.  The calling thread claims work too, so nested calls made from within func always make progress, even
+// when every worker is busy.  The first exception thrown by func is rethrown on the calling thread.
+void CompileParallelFor(size_t count, size_t max_threads, const std::function<void(size_t)>& func);
+
+// Runs task on one of the compile pool's workers, at the current thread's priority, without waiting for it.  The task
+// may itself call CompileParallelFor.  Errors must be reported by the task (e.g. through a promise); any exception
+// which escapes it is dropped.
+void CompileAsync(std::function<void()> task);
+
+}  // namespace tile
+}  // namespace vertexai
@@ -0,0 +1,65 @@
+// Copyright 2020, Intel Corporation.
+
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <future>
+#include <stdexcept>
+#include <vector>
+
+#include "tile/base/compile_pool.h"
+
+namespace vertexai {
+namespace tile {
+namespace {
+
+TEST(CompilePoolTest, RunsEveryIndexOnce) {
+  std::vector<std::atomic<int>> calls(100);
+  CompileParallelFor(calls.size(), 0, [&](size_t i) { calls[i]++; });
+  for (const auto& count : calls) {
+    EXPECT_EQ(count, 1);
+  }
+}
+
+TEST(CompilePoolTest, NestedCallsComplete) {
+  std::atomic<int> calls{0};
+  CompileParallelFor(16, 0, [&](size_t) {  //
+    CompileParallelFor(16, 0, [&](size_t) { calls++; });
+  });
+  EXPECT_EQ(calls, 16 * 16);
+}
+
+TEST(CompilePoolTest, RethrowsErrors) {
+  EXPECT_THROW(CompileParallelFor(8, 0,
+                                  [](size_t i) {
+                                    if (i == 5) {
+                                      throw std::runtime_error("failed");
+                                    }
+                                  }),
+               std::runtime_error);
+}
+
+TEST(CompilePoolTest, WorkersInheritPriority) {
+  CompilePriorityScope scope{CompilePriority::BACKGROUND};
+  std::atomic<int> foreground{0};
+  CompileParallelFor(32, 0, [&](size_t) {
+    if (CompilePriorityScope::Current() != CompilePriority::BACKGROUND) {
+      foreground++;
+    }
+  });
+  EXPECT_EQ(foreground, 0);
+}
+
+TEST(CompilePoolTest, AsyncTasksMayFanOut) {
+  std::promise<int> done;
+  CompileAsync([&] {
+    std::atomic<int> calls{0};
+    CompileParallelFor(16, 0, [&](size_t) { calls++; });
+    done.set_value(calls);
+  });
+  EXPECT_EQ(done.get_future().get(), 16);
+}
+
+}  // namespace
+}  // namespace tile
+}  // namespace vertexai
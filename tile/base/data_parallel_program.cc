@@ -0,0 +1,163 @@
+// Copyright 2020, Intel Corporation.
+
+#include "tile/base/data_parallel_program.h"
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <utility>
+
+#include <boost/format.hpp>
+
+namespace vertexai {
+namespace tile {
+
+DataParallelProgram::DataParallelProgram(std::vector<Replica> replicas, std::map<std::string, std::uint64_t> arg_bytes)
+    : replicas_{std::move(replicas)}, arg_bytes_{std::move(arg_bytes)}, buffers_(replicas_.size()) {
+  if (replicas_.empty()) {
+    throw std::invalid_argument("A data-parallel program requires at least one replica");
+  }
+}
+
+bool DataParallelProgram::IsSplit(const std::string& name, const Buffer& buffer) const {
+  auto it = arg_bytes_.find(name);
+  if (it == arg_bytes_.end()) {
+    throw std::runtime_error("Unknown program argument: " + name);
+  }
+  if (buffer.size() == it->second) {
+    return false;
+  }
+  if (buffer.size() == it->second * replicas_.size()) {
+    return true;
+  }
+  throw std::runtime_error(str(boost::format("The buffer bound to %1% holds %2% bytes; each of the %3% replicas "
+                                             "takes %4% bytes, so it must hold either %4% or %5%") %
+                               name % buffer.size() % replicas_.size() % it->second %
+                               (it->second * replicas_.size())));
+}
+
+const std::shared_ptr<Buffer>& DataParallelProgram::ReplicaBuffer(std::size_t replica, const std::string& name) {
+  auto& buffer = buffers_[replica][name];
+  if (!buffer) {
+    buffer = replicas_[replica].allocator->allocate(arg_bytes_.at(name));
+  }
+  return buffer;
+}
+
+boost::future<void> DataParallelProgram::Run(const context::Context& ctx,                              //
+                                             std::map<std::string, std::shared_ptr<Buffer>> inputs,  //
+                                             std::map<std::string, std::shared_ptr<Buffer>> outputs) {
+  std::lock_guard<std::mutex> lock{mu_};
+  auto count = replicas_.size();
+  std::vector<std::map<std::string, std::shared_ptr<Buffer>>> replica_inputs(count);
+  std::vector<std::map<std::string, std::shared_ptr<Buffer>>> replica_outputs(count);
+
+  // Scatter the inputs.
+  for (const auto& kvp : inputs) {
+    bool split = IsSplit(kvp.first, *kvp.second);
+    auto bytes = arg_bytes_.at(kvp.first);
+    auto src = kvp.second->MapCurrent(ctx).get();
+    for (std::size_t idx = 0; idx < count; idx++) {
+      const auto& buffer = ReplicaBuffer(idx, kvp.first);
+      auto dst = buffer->MapDiscard(ctx);
+      std::memcpy(dst->data(), src->data() + (split ? idx * bytes : 0), bytes);
+      dst->WriteBack(ctx);
+      replica_inputs[idx][kvp.first] = buffer;
+    }
+  }
+  for (const auto& kvp : outputs) {
+    IsSplit(kvp.first, *kvp.second);
+    for (std::size_t idx = 0; idx < count; idx++) {
+      replica_outputs[idx][kvp.first] = ReplicaBuffer(idx, kvp.first);
+    }
+  }
+
+  // Run the replicas concurrently, waiting for all of them even if one fails.
+  std::vector<boost::future<void>> runs;
+  for (std::size_t idx = 0; idx < count; idx++) {
+    runs.emplace_back(replicas_[idx].program->Run(ctx, replica_inputs[idx], replica_outputs[idx]));
+  }
+  std::exception_ptr error;
+  for (auto& run : runs) {
+    try {
+      run.get();
+    } catch (...) {
+      if (!error) {
+        error = std::current_exception();
+      }
+    }
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+
+  // Gather the outputs.
+  for (const auto& kvp : outputs) {
+    bool split = IsSplit(kvp.first, *kvp.second);
+    auto bytes = arg_bytes_.at(kvp.first);
+    auto dst = kvp.second->MapDiscard(ctx);
+    for (std::size_t idx = 0; idx < (split ? count : 1); idx++) {
+      auto src = buffers_[idx][kvp.first]->MapCurrent(ctx).get();
+      std::memcpy(dst->data() + idx * bytes, src->data(), bytes);
+    }
+    dst->WriteBack(ctx);
+  }
+  return boost::make_ready_future();
+}
+
+std::size_t DataParallelProgram::MaxAvailableMemory() {
+  std::size_t result = replicas_[0].program->MaxAvailableMemory();
+  for (const auto& replica : replicas_) {
+    result = std::min(result, replica.program->MaxAvailableMemory());
+  }
+  return result;
+}
+
+void DataParallelProgram::Release() {
+  std::lock_guard<std::mutex> lock{mu_};
+  for (const auto& replica : replicas_) {
+    replica.program->Release();
+  }
+  for (auto& buffers : buffers_) {
+    buffers.clear();
+  }
+}
+
+std::uint64_t DataParallelProgram::MemoryFootprint() const {
+  std::uint64_t result = 0;
+  for (const auto& replica : replicas_) {
+    result += replica.program->MemoryFootprint();
+  }
+  return result;
+}
+
+void DataParallelProgram::SetMemoryQuota(std::uint64_t bytes) {
+  for (const auto& replica : replicas_) {
+    replica.program->SetMemoryQuota(bytes);
+  }
+}
+
+void DataParallelProgram::EnableStats(bool enable) {
+  for (const auto& replica : replicas_) {
+    replica.program->EnableStats(enable);
+  }
+}
+
+ProgramStats DataParallelProgram::GetStats() const {
+  // Every run runs each replica once; kernel times are summed over the replicas.
+  auto result = replicas_[0].program->GetStats();
+  for (std::size_t idx = 1; idx < replicas_.size(); idx++) {
+    auto stats = replicas_[idx].program->GetStats();
+    result.queue_wait_seconds = std::max(result.queue_wait_seconds, stats.queue_wait_seconds);
+    result.peak_memory_bytes += stats.peak_memory_bytes;
+    for (std::size_t kidx = 0; kidx < std::min(result.kernels.size(), stats.kernels.size()); kidx++) {
+      result.kernels[kidx].runs += stats.kernels[kidx].runs;
+      result.kernels[kidx].total_seconds += stats.kernels[kidx].total_seconds;
+    }
+  }
+  return result;
+}
+
+}  // namespace tile
+}  // namespace vertexai
@@ -0,0 +1,70 @@
+// Copyright 2020, Intel Corporation.
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "tile/base/buffer.h"
+#include "tile/base/program.h"
+
+namespace vertexai {
+namespace tile {
+
+// Runs one program, replicated across several devices, over a batch which is
+// split among the replicas.
+//
+// Each replica is the same program compiled for one device, with shapes for
+// its share of the batch.  At run time, every buffer is compared to the size
+// of the replica's argument: a buffer holding N times as much (for N
+// replicas) is split evenly along its leading (batch) dimension; one of the
+// same size is an input copied whole to every replica, or an output taken
+// from the first replica.  The replicas run concurrently on buffers of their
+// own devices, and their outputs are gathered back into the caller's buffers.
+//
+// The HALs have no copies between devices, so scatters and gathers go
+// through host mappings of the buffers.  Runs are serialized, as they share
+// the replicas' buffers.
+class DataParallelProgram final : public Program {
+ public:
+  struct Replica {
+    std::shared_ptr<Program> program;
+    std::shared_ptr<Allocator> allocator;  // Makes buffers on the replica's device
+  };
+
+  // arg_bytes gives the size of each of a replica's inputs and outputs.
+  DataParallelProgram(std::vector<Replica> replicas, std::map<std::string, std::uint64_t> arg_bytes);
+
+  boost::future<void> Run(const context::Context& ctx,                              //
+                          std::map<std::string, std::shared_ptr<Buffer>> inputs,  //
+                          std::map<std::string, std::shared_ptr<Buffer>> outputs) final;
+
+  std::size_t MaxAvailableMemory() final;
+  void Release() final;
+  std::uint64_t MemoryFootprint() const final;
+  // Applies the quota to each replica.
+  void SetMemoryQuota(std::uint64_t bytes) final;
+  void EnableStats(bool enable) final;
+  ProgramStats GetStats() const final;
+
+  std::size_t replica_count() const { return replicas_.size(); }
+
+ private:
+  // Returns true if the buffer is split among the replicas, and false if each
+  // replica uses all of it.
+  bool IsSplit(const std::string& name, const Buffer& buffer) const;
+
+  // Returns the replica's buffer for the named argument.
+  const std::shared_ptr<Buffer>& ReplicaBuffer(std::size_t replica, const std::string& name);
+
+  std::vector<Replica> replicas_;
+  std::map<std::string, std::uint64_t> arg_bytes_;
+  std::mutex mu_;
+  std::vector<std::map<std::string, std::shared_ptr<Buffer>>> buffers_;  // Per replica
+};
+
+}  // namespace tile
+}  // namespace vertexai
@@ -0,0 +1,106 @@
+// Copyright 2020, Intel Corporation.
+
+#include <gmock/gmock.h>
+
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/thread/future.hpp>
+
+#include "tile/base/data_parallel_program.h"
+
+using ::testing::ElementsAre;
+using ::testing::Eq;
+
+namespace vertexai {
+namespace tile {
+namespace {
+
+// Computes Y = X + B over a replica's two floats, recording the replica index in R.
+class FakeProgram final : public Program {
+ public:
+  explicit FakeProgram(float index) : index_{index} {}
+
+  boost::future<void> Run(const context::Context& ctx, std::map<std::string, std::shared_ptr<Buffer>> inputs,
+                          std::map<std::string, std::shared_ptr<Buffer>> outputs) final {
+    auto x = inputs.at("X")->MapCurrent(ctx).get();
+    auto b = inputs.at("B")->MapCurrent(ctx).get();
+    auto y = outputs.at("Y")->MapDiscard(ctx);
+    auto r = outputs.at("R")->MapDiscard(ctx);
+    for (std::size_t idx = 0; idx < 2; idx++) {
+      reinterpret_cast<float*>(y->data())[idx] =
+          reinterpret_cast<const float*>(x->data())[idx] + reinterpret_cast<const float*>(b->data())[0];
+    }
+    reinterpret_cast<float*>(r->data())[0] = index_;
+    return boost::make_ready_future();
+  }
+  std::size_t MaxAvailableMemory() final { return 0; }
+  void Release() final {}
+  std::uint64_t MemoryFootprint() const final { return 100; }
+
+ private:
+  float index_;
+};
+
+class SimpleAllocator final : public Allocator {
+ public:
+  BufferPtr allocate(size_t size) final { return std::make_shared<SimpleBuffer>(size); }
+};
+
+std::shared_ptr<Buffer> MakeFloats(const std::vector<float>& values) {
+  std::vector<char> data(values.size() * sizeof(float));
+  std::memcpy(data.data(), values.data(), data.size());
+  return std::make_shared<SimpleBuffer>(data);
+}
+
+std::vector<float> ReadFloats(const std::shared_ptr<Buffer>& buffer) {
+  auto view = buffer->MapCurrent(context::Context{}).get();
+  std::vector<float> values(view->size() / sizeof(float));
+  std::memcpy(values.data(), view->data(), view->size());
+  return values;
+}
+
+DataParallelProgram MakeProgram(std::size_t replicas) {
+  std::vector<DataParallelProgram::Replica> result;
+  for (std::size_t idx = 0; idx < replicas; idx++) {
+    result.emplace_back(DataParallelProgram::Replica{std::make_shared<FakeProgram>(idx + 1),  //
+                                                     std::make_shared<SimpleAllocator>()});
+  }
+  return DataParallelProgram{std::move(result), {{"X", 8}, {"B", 4}, {"Y", 8}, {"R", 4}}};
+}
+
+TEST(DataParallelProgramTest, SplitsBroadcastsAndGathers) {
+  auto program = MakeProgram(3);
+  auto y = MakeFloats(std::vector<float>(6));
+  auto r = MakeFloats({0});
+  program.Run(context::Context{}, {{"X", MakeFloats({1, 2, 3, 4, 5, 6})}, {"B", MakeFloats({10})}},
+              {{"Y", y}, {"R", r}})
+      .get();
+  EXPECT_THAT(ReadFloats(y), ElementsAre(11, 12, 13, 14, 15, 16));
+  EXPECT_THAT(ReadFloats(r), ElementsAre(1));
+  EXPECT_THAT(program.MemoryFootprint(), Eq(300));
+}
+
+TEST(DataParallelProgramTest, SplitsPerReplicaOutputs) {
+  auto program = MakeProgram(2);
+  auto y = MakeFloats(std::vector<float>(4));
+  auto r = MakeFloats({0, 0});
+  program.Run(context::Context{}, {{"X", MakeFloats({1, 2, 3, 4})}, {"B", MakeFloats({1})}}, {{"Y", y}, {"R", r}})
+      .get();
+  EXPECT_THAT(ReadFloats(y), ElementsAre(2, 3, 4, 5));
+  EXPECT_THAT(ReadFloats(r), ElementsAre(1, 2));
+}
+
+TEST(DataParallelProgramTest, RejectsMismatchedBuffers) {
+  auto program = MakeProgram(2);
+  EXPECT_THROW(program.Run(context::Context{}, {{"X", MakeFloats({1, 2, 3})}, {"B", MakeFloats({1})}},
+                           {{"Y", MakeFloats({0, 0, 0, 0})}, {"R", MakeFloats({0})}}),
+               std::runtime_error);
+}
+
+}  // namespace
+}  // namespace tile
+}  // namespace vertexai
@@ -5,7 +5,9 @@
 // These interfaces define the data model provided by all HAL drivers.
 
 #include <chrono>
+#include <functional>
 #include <initializer_list>
+#include <map>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -49,6 +51,28 @@ class Event {
 
   // Returns a future that will be resolved when the event is complete.
   virtual boost::shared_future<std::shared_ptr<Result>> GetFuture() = 0;
+
+  using CompletionCallback = std::function<void(std::shared_ptr<Result> result, boost::exception_ptr error)>;
+
+  // Invokes the callback once the event is complete, with either its result or the error it failed with.  The
+  // callback may run on any thread -- immediately, if the event has already completed -- and must not block.
+  //
+  // This is the cheap way to wait for many events: the default implementation chains a continuation onto GetFuture(),
+  // but HALs which are notified of completion directly override it to skip the future altogether.  The continuation
+  // runs synchronously, on whichever thread completes the future, rather than on a thread of its own.
+  virtual void OnComplete(CompletionCallback callback) {
+    auto continuation = [callback = std::move(callback)](boost::shared_future<std::shared_ptr<Result>> fut) {
+      std::shared_ptr<Result> result;
+      boost::exception_ptr error;
+      try {
+        result = fut.get();
+      } catch (...) {
+        error = boost::current_exception();
+      }
+      callback(std::move(result), std::move(error));
+    };
+    GetFuture().then(boost::launch::sync, std::move(continuation));
+  }
 };
 
 // Access control flags that can be applied to buffer allocations, indicating the functionality needed by the allocator.
@@ -146,6 +170,13 @@ class Memory {
 
   // Makes an arena for use with the associated device.
   virtual std::shared_ptr<Arena> MakeArena(std::uint64_t size, BufferAccessMask access) = 0;
+
+  // Wraps existing host memory as a buffer for use with the associated device, without copying it.  The memory must
+  // remain valid for the lifetime of the buffer.  Returns nullptr if the memory cannot be wrapped (e.g. because of its
+  // alignment, or because the device cannot address host memory); callers should fall back to MakeBuffer.
+  virtual std::shared_ptr<Buffer> WrapBuffer(void* base, std::uint64_t size, BufferAccessMask access) {
+    return nullptr;
+  }
 };
 
 // A Tile executable program that can be run on a processor.
@@ -194,10 +225,10 @@ class Loader {
  public:
   virtual ~Loader() noexcept {}
 
-  // Loads a program for execution on this device.
-  virtual boost::future<std::unique_ptr<Library>> Deserialize(const context::Context& ctx,
-                                                              const std::string& serialized_executable,
-                                                              const std::vector<lang::KernelInfo>& info) = 0;
+  // Loads a program for execution on this device from the binaries produced by Library::Serialize.
+  virtual boost::future<std::unique_ptr<Library>> Deserialize(
+      const context::Context& ctx, const std::map<std::string, std::string>& serialized_executable,
+      const std::vector<lang::KernelInfo>& info) = 0;
 };
 
 // A Tile Executor is able to allocate memory for a hardware device and run programs on the hardware device.
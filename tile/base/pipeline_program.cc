@@ -0,0 +1,216 @@
+// Copyright 2020, Intel Corporation.
+
+#include "tile/base/pipeline_program.h"
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <set>
+#include <stdexcept>
+#include <utility>
+
+#include <boost/format.hpp>
+
+namespace vertexai {
+namespace tile {
+
+PipelineProgram::PipelineProgram(std::vector<Stage> stages, std::map<std::string, std::uint64_t> arg_bytes)
+    : stages_{std::move(stages)}, arg_bytes_{std::move(arg_bytes)}, buffers_(stages_.size()) {
+  if (stages_.empty()) {
+    throw std::invalid_argument("A pipelined program requires at least one stage");
+  }
+}
+
+std::uint64_t PipelineProgram::ArgBytes(const std::string& name) const {
+  auto it = arg_bytes_.find(name);
+  if (it == arg_bytes_.end() || !it->second) {
+    throw std::runtime_error("Unknown program argument: " + name);
+  }
+  return it->second;
+}
+
+const std::shared_ptr<Buffer>& PipelineProgram::StageBuffer(std::size_t stage, const std::string& name) {
+  auto& buffer = buffers_[stage][name];
+  if (!buffer) {
+    buffer = stages_[stage].allocator->allocate(ArgBytes(name));
+  }
+  return buffer;
+}
+
+boost::future<void> PipelineProgram::Run(const context::Context& ctx,                              //
+                                         std::map<std::string, std::shared_ptr<Buffer>> inputs,  //
+                                         std::map<std::string, std::shared_ptr<Buffer>> outputs) {
+  std::lock_guard<std::mutex> lock{mu_};
+
+  // Count the micro-batches.
+  std::size_t batches = 1;
+  for (const auto* args : {&inputs, &outputs}) {
+    for (const auto& kvp : *args) {
+      batches = std::max<std::size_t>(batches, kvp.second->size() / ArgBytes(kvp.first));
+    }
+  }
+  auto is_split = [&](const std::string& name, const Buffer& buffer) {
+    auto bytes = ArgBytes(name);
+    if (buffer.size() == bytes) {
+      return false;
+    }
+    if (buffer.size() == bytes * batches) {
+      return true;
+    }
+    throw std::runtime_error(str(boost::format("The buffer bound to %1% holds %2% bytes; with %3% micro-batches "
+                                               "of %4% bytes, it must hold either %4% or %5%") %
+                                 name % buffer.size() % batches % bytes % (bytes * batches)));
+  };
+
+  // Stage the caller's inputs in host memory: one slot per micro-batch for
+  // values which differ between micro-batches, and a single slot otherwise.
+  std::set<std::string> written;
+  for (const auto& stage : stages_) {
+    written.insert(stage.outputs.begin(), stage.outputs.end());
+  }
+  std::map<std::string, std::vector<std::vector<char>>> slots;
+  for (const auto& kvp : inputs) {
+    bool split = is_split(kvp.first, *kvp.second);
+    auto bytes = ArgBytes(kvp.first);
+    auto view = kvp.second->MapCurrent(ctx).get();
+    auto& arg_slots = slots[kvp.first];
+    arg_slots.resize((split || written.count(kvp.first)) ? batches : 1);
+    for (std::size_t batch = 0; batch < arg_slots.size(); batch++) {
+      auto src = view->data() + (split ? batch * bytes : 0);
+      arg_slots[batch].assign(src, src + bytes);
+    }
+  }
+  for (const auto& kvp : outputs) {
+    is_split(kvp.first, *kvp.second);
+    if (!written.count(kvp.first)) {
+      throw std::runtime_error("No stage of the program writes " + kvp.first);
+    }
+  }
+  for (const auto& name : written) {
+    slots[name].resize(batches);
+  }
+  auto slot = [&](const std::string& name, std::size_t batch) -> std::vector<char>& {
+    auto it = slots.find(name);
+    if (it == slots.end()) {
+      throw std::runtime_error("No input or earlier stage provides " + name);
+    }
+    return it->second[it->second.size() == 1 ? 0 : batch];
+  };
+
+  // Run the pipeline.  On each step, stage s runs micro-batch (step - s).
+  std::vector<std::map<std::string, const std::vector<char>*>> loaded(stages_.size());
+  for (std::size_t step = 0; step < batches + stages_.size() - 1; step++) {
+    std::vector<std::pair<std::size_t, std::size_t>> active;  // (stage, micro-batch)
+    for (std::size_t idx = 0; idx < stages_.size(); idx++) {
+      if (idx <= step && step - idx < batches) {
+        active.emplace_back(idx, step - idx);
+      }
+    }
+    std::vector<boost::future<void>> runs;
+    for (const auto& [idx, batch] : active) {
+      const auto& stage = stages_[idx];
+      std::map<std::string, std::shared_ptr<Buffer>> stage_inputs;
+      std::map<std::string, std::shared_ptr<Buffer>> stage_outputs;
+      for (const auto& name : stage.inputs) {
+        const auto& buffer = StageBuffer(idx, name);
+        const auto& src = slot(name, batch);
+        // A single-slot value never changes during the run, so it only needs loading once.
+        if (loaded[idx][name] != &src || slots[name].size() != 1) {
+          auto dst = buffer->MapDiscard(ctx);
+          std::memcpy(dst->data(), src.data(), src.size());
+          dst->WriteBack(ctx);
+          loaded[idx][name] = &src;
+        }
+        stage_inputs[name] = buffer;
+      }
+      for (const auto& name : stage.outputs) {
+        stage_outputs[name] = StageBuffer(idx, name);
+      }
+      runs.emplace_back(stage.program->Run(ctx, std::move(stage_inputs), std::move(stage_outputs)));
+    }
+    std::exception_ptr error;
+    for (auto& run : runs) {
+      try {
+        run.get();
+      } catch (...) {
+        if (!error) {
+          error = std::current_exception();
+        }
+      }
+    }
+    if (error) {
+      std::rethrow_exception(error);
+    }
+    for (const auto& [idx, batch] : active) {
+      for (const auto& name : stages_[idx].outputs) {
+        auto view = buffers_[idx][name]->MapCurrent(ctx).get();
+        slot(name, batch).assign(view->data(), view->data() + view->size());
+      }
+    }
+  }
+
+  // Gather the outputs.
+  for (const auto& kvp : outputs) {
+    bool split = is_split(kvp.first, *kvp.second);
+    auto bytes = ArgBytes(kvp.first);
+    auto dst = kvp.second->MapDiscard(ctx);
+    for (std::size_t batch = 0; batch < (split ? batches : 1); batch++) {
+      std::memcpy(dst->data() + batch * bytes, slot(kvp.first, batch).data(), bytes);
+    }
+    dst->WriteBack(ctx);
+  }
+  return boost::make_ready_future();
+}
+
+std::size_t PipelineProgram::MaxAvailableMemory() {
+  std::size_t result = stages_[0].program->MaxAvailableMemory();
+  for (const auto& stage : stages_) {
+    result = std::min(result, stage.program->MaxAvailableMemory());
+  }
+  return result;
+}
+
+void PipelineProgram::Release() {
+  std::lock_guard<std::mutex> lock{mu_};
+  for (const auto& stage : stages_) {
+    stage.program->Release();
+  }
+  for (auto& buffers : buffers_) {
+    buffers.clear();
+  }
+}
+
+std::uint64_t PipelineProgram::MemoryFootprint() const {
+  std::uint64_t result = 0;
+  for (const auto& stage : stages_) {
+    result += stage.program->MemoryFootprint();
+  }
+  return result;
+}
+
+void PipelineProgram::SetMemoryQuota(std::uint64_t bytes) {
+  for (const auto& stage : stages_) {
+    stage.program->SetMemoryQuota(bytes);
+  }
+}
+
+void PipelineProgram::EnableStats(bool enable) {
+  for (const auto& stage : stages_) {
+    stage.program->EnableStats(enable);
+  }
+}
+
+ProgramStats PipelineProgram::GetStats() const {
+  // Every stage runs once per micro-batch; the kernels are listed stage by stage.
+  auto result = stages_[0].program->GetStats();
+  for (std::size_t idx = 1; idx < stages_.size(); idx++) {
+    auto stats = stages_[idx].program->GetStats();
+    result.queue_wait_seconds = std::max(result.queue_wait_seconds, stats.queue_wait_seconds);
+    result.peak_memory_bytes += stats.peak_memory_bytes;
+    result.kernels.insert(result.kernels.end(), stats.kernels.begin(), stats.kernels.end());
+  }
+  return result;
+}
+
+}  // namespace tile
+}  // namespace vertexai
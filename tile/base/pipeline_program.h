@@ -0,0 +1,72 @@
+// Copyright 2020, Intel Corporation.
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "tile/base/buffer.h"
+#include "tile/base/program.h"
+
+namespace vertexai {
+namespace tile {
+
+// Runs a program partitioned into stages, each compiled for its own device,
+// pipelining micro-batches through the stages.
+//
+// The stages are compiled with shapes for one micro-batch.  At run time, a
+// buffer holding M times the size of its argument splits into M
+// micro-batches along its leading (batch) dimension; one of the argument's
+// size is used whole by every micro-batch (an output is taken from the first
+// micro-batch).  On each step of the pipeline, stage s runs micro-batch
+// (step - s), concurrently with the other stages; so with S stages, M
+// micro-batches run in M + S - 1 steps.
+//
+// The HALs have no copies between devices, so the values passing between
+// stages are staged in host memory.  Inputs used whole by every micro-batch
+// (such as weights) are loaded into each stage once per run.  Runs are
+// serialized, as they share the stages' buffers.
+class PipelineProgram final : public Program {
+ public:
+  struct Stage {
+    std::shared_ptr<Program> program;
+    std::shared_ptr<Allocator> allocator;  // Makes buffers on the stage's device
+    std::vector<std::string> inputs;
+    std::vector<std::string> outputs;
+  };
+
+  // arg_bytes gives the size of each of the stages' inputs and outputs for
+  // one micro-batch.
+  PipelineProgram(std::vector<Stage> stages, std::map<std::string, std::uint64_t> arg_bytes);
+
+  boost::future<void> Run(const context::Context& ctx,                              //
+                          std::map<std::string, std::shared_ptr<Buffer>> inputs,  //
+                          std::map<std::string, std::shared_ptr<Buffer>> outputs) final;
+
+  std::size_t MaxAvailableMemory() final;
+  void Release() final;
+  std::uint64_t MemoryFootprint() const final;
+  // Applies the quota to each stage.
+  void SetMemoryQuota(std::uint64_t bytes) final;
+  void EnableStats(bool enable) final;
+  ProgramStats GetStats() const final;
+
+  std::size_t stage_count() const { return stages_.size(); }
+
+ private:
+  std::uint64_t ArgBytes(const std::string& name) const;
+
+  // Returns the stage's buffer for the named argument.
+  const std::shared_ptr<Buffer>& StageBuffer(std::size_t stage, const std::string& name);
+
+  std::vector<Stage> stages_;
+  std::map<std::string, std::uint64_t> arg_bytes_;
+  std::mutex mu_;
+  std::vector<std::map<std::string, std::shared_ptr<Buffer>>> buffers_;  // Per stage
+};
+
+}  // namespace tile
+}  // namespace vertexai
@@ -0,0 +1,120 @@
+// Copyright 2020, Intel Corporation.
+
+#include <gmock/gmock.h>
+
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/thread/future.hpp>
+
+#include "tile/base/pipeline_program.h"
+
+using ::testing::ElementsAre;
+using ::testing::Eq;
+
+namespace vertexai {
+namespace tile {
+namespace {
+
+// Computes one output float from one or two input floats.
+class FakeProgram final : public Program {
+ public:
+  FakeProgram(std::vector<std::string> inputs, std::string output, std::function<float(float, float)> fn)
+      : inputs_{std::move(inputs)}, output_{std::move(output)}, fn_{std::move(fn)} {}
+
+  boost::future<void> Run(const context::Context& ctx, std::map<std::string, std::shared_ptr<Buffer>> inputs,
+                          std::map<std::string, std::shared_ptr<Buffer>> outputs) final {
+    float args[2] = {0, 0};
+    for (std::size_t idx = 0; idx < inputs_.size(); idx++) {
+      auto view = inputs.at(inputs_[idx])->MapCurrent(ctx).get();
+      std::memcpy(&args[idx], view->data(), sizeof(float));
+    }
+    auto result = fn_(args[0], args[1]);
+    auto view = outputs.at(output_)->MapDiscard(ctx);
+    std::memcpy(view->data(), &result, sizeof(float));
+    runs++;
+    return boost::make_ready_future();
+  }
+  std::size_t MaxAvailableMemory() final { return 0; }
+  void Release() final {}
+  std::uint64_t MemoryFootprint() const final { return 100; }
+  void SetMemoryQuota(std::uint64_t bytes) final { quota = bytes; }
+
+  std::size_t runs = 0;
+  std::uint64_t quota = 0;
+
+ private:
+  std::vector<std::string> inputs_;
+  std::string output_;
+  std::function<float(float, float)> fn_;
+};
+
+class SimpleAllocator final : public Allocator {
+ public:
+  BufferPtr allocate(size_t size) final { return std::make_shared<SimpleBuffer>(size); }
+};
+
+std::shared_ptr<Buffer> MakeFloats(const std::vector<float>& values) {
+  std::vector<char> data(values.size() * sizeof(float));
+  std::memcpy(data.data(), values.data(), data.size());
+  return std::make_shared<SimpleBuffer>(data);
+}
+
+std::vector<float> ReadFloats(const std::shared_ptr<Buffer>& buffer) {
+  auto view = buffer->MapCurrent(context::Context{}).get();
+  std::vector<float> values(view->size() / sizeof(float));
+  std::memcpy(values.data(), view->data(), view->size());
+  return values;
+}
+
+class PipelineProgramTest : public ::testing::Test {
+ protected:
+  // T = X * 2, then Y = T + W.
+  PipelineProgramTest()
+      : double_{std::make_shared<FakeProgram>(std::vector<std::string>{"X"}, "T",
+                                              [](float x, float) { return x * 2; })},
+        add_{std::make_shared<FakeProgram>(std::vector<std::string>{"T", "W"}, "Y",
+                                           [](float t, float w) { return t + w; })},
+        program_{{PipelineProgram::Stage{double_, std::make_shared<SimpleAllocator>(), {"X"}, {"T"}},
+                  PipelineProgram::Stage{add_, std::make_shared<SimpleAllocator>(), {"T", "W"}, {"Y"}}},
+                 {{"X", 4}, {"T", 4}, {"W", 4}, {"Y", 4}}} {}
+
+  std::shared_ptr<FakeProgram> double_;
+  std::shared_ptr<FakeProgram> add_;
+  PipelineProgram program_;
+};
+
+TEST_F(PipelineProgramTest, PipelinesMicroBatches) {
+  auto y = MakeFloats({0, 0, 0});
+  program_.Run(context::Context{}, {{"X", MakeFloats({1, 2, 3})}, {"W", MakeFloats({100})}}, {{"Y", y}}).get();
+  EXPECT_THAT(ReadFloats(y), ElementsAre(102, 104, 106));
+  EXPECT_THAT(double_->runs, Eq(3));
+  EXPECT_THAT(add_->runs, Eq(3));
+  EXPECT_THAT(program_.MemoryFootprint(), Eq(200));
+}
+
+TEST_F(PipelineProgramTest, RunsSingleBatch) {
+  auto y = MakeFloats({0});
+  program_.Run(context::Context{}, {{"X", MakeFloats({5})}, {"W", MakeFloats({1})}}, {{"Y", y}}).get();
+  EXPECT_THAT(ReadFloats(y), ElementsAre(11));
+}
+
+TEST_F(PipelineProgramTest, QuotasEveryStage) {
+  program_.SetMemoryQuota(1 << 20);
+  EXPECT_THAT(double_->quota, Eq(1 << 20));
+  EXPECT_THAT(add_->quota, Eq(1 << 20));
+}
+
+TEST_F(PipelineProgramTest, RejectsMismatchedBuffers) {
+  EXPECT_THROW(program_.Run(context::Context{}, {{"X", MakeFloats({1, 2, 3})}, {"W", MakeFloats({1, 2})}},
+                            {{"Y", MakeFloats({0, 0, 0})}}),
+               std::runtime_error);
+}
+
+}  // namespace
+}  // namespace tile
+}  // namespace vertexai
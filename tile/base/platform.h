@@ -31,6 +31,14 @@ class Platform {
       const std::string& device,               //
       std::uint64_t size) = 0;
 
+  // Makes a buffer on the target device that aliases existing host memory, which must outlive the buffer.
+  // Returns nullptr if the device cannot use the memory without copying it.
+  virtual std::shared_ptr<Buffer> WrapBuffer(  //
+      const context::Context& ctx,             //
+      const std::string& device,               //
+      void* base,                              //
+      std::uint64_t size) = 0;
+
   // Builds (pre-compiling if possible) a program for executing the supplied Program
   virtual std::shared_ptr<Program> MakeProgram(  //
       const context::Context& ctx,               //
@@ -58,6 +66,15 @@ class Platform {
       const std::string& target,                        //
       const std::shared_ptr<stripe::Program>& program,  //
       ConstBufferManager* const_bufs) = 0;
+
+  // Reconstructs a program from the output of Program::Save.
+  virtual std::shared_ptr<Program> LoadProgram(  //
+      const context::Context& ctx,               //
+      const std::string& device,                 //
+      const std::string& saved,                  //
+      ConstBufferManager* const_bufs) {
+    throw std::runtime_error("This platform cannot load saved programs");
+  }
 };
 
 }  // namespace tile
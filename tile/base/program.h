@@ -2,10 +2,13 @@
 
 #pragma once
 
+#include <cstdint>
 #include <list>
 #include <map>
 #include <memory>
+#include <stdexcept>
 #include <string>
+#include <vector>
 
 #include "base/context/context.h"
 #include "tile/base/buffer.h"
@@ -13,6 +16,39 @@
 namespace vertexai {
 namespace tile {
 
+// Runtime statistics for one kernel of a program, accumulated over the program's runs.
+struct KernelStats {
+  std::string kname;
+  std::uint64_t runs = 0;
+  std::uint64_t tot_bytes = 0;  // Bytes accessed by a single run of the kernel
+  std::uint64_t tot_flops = 0;  // Operations performed by a single run of the kernel
+  double total_seconds = 0;
+  std::vector<double> recent_seconds;  // The durations of the most recent runs, oldest first
+};
+
+// Runtime statistics for a program, accumulated over its runs.
+struct ProgramStats {
+  std::uint64_t runs = 0;
+  double queue_wait_seconds = 0;        // Time runs spent waiting for device memory or a pipeline slot
+  std::uint64_t peak_memory_bytes = 0;  // The most memory held at once by the program's runs
+  std::vector<KernelStats> kernels;
+};
+
+// The resolution of a program's argument names to its parameters, made once by Program::Bind so that runs need not
+// look arguments up by name.  Each program defines its own.
+class ArgumentBinding {
+ public:
+  virtual ~ArgumentBinding() {}
+};
+
+// The buffers for a bound run, by argument slot: inputs[i] and outputs[i] are the buffers for the i'th input and
+// output names given to Program::Bind.  The buffers are borrowed: the caller keeps them alive until Run returns (the
+// run holds whatever it needs past that itself), so a table can be built once and reused by every run.
+struct ArgumentTable {
+  std::vector<Buffer*> inputs;
+  std::vector<Buffer*> outputs;
+};
+
 // Program represents a Tile program that's been compiled by a Platform.
 class Program {
  public:
@@ -29,11 +65,48 @@ class Program {
       std::map<std::string, std::shared_ptr<Buffer>> inputs,
       std::map<std::string, std::shared_ptr<Buffer>> outputs) = 0;
 
+  // Resolves the argument names for runs through the ArgumentTable overload of Run, which then needs no maps and no
+  // lookups.  Returns nullptr if the program only supports runs by name.
+  virtual std::shared_ptr<ArgumentBinding> Bind(const std::vector<std::string>& input_names,
+                                                const std::vector<std::string>& output_names) {
+    return nullptr;
+  }
+
+  // Runs the program with arguments supplied by slot, as resolved by the binding (which must have come from this
+  // program's Bind).
+  virtual boost::future<void> Run(const context::Context& ctx, const ArgumentBinding& binding,
+                                  const ArgumentTable& args) {
+    throw std::runtime_error("This program does not support bound arguments");
+  }
+
   // The maximum available memory
   virtual std::size_t MaxAvailableMemory() = 0;
 
   // Release resource used by the program
   virtual void Release() = 0;
+
+  // An estimate of the device and host memory held by the compiled program, used to bound caches of programs.
+  virtual std::uint64_t MemoryFootprint() const { return 0; }
+
+  // Serializes the compiled program, including its device binaries, such that Platform::LoadProgram can reconstruct
+  // it on the same kind of device without compiling it again.
+  virtual std::string Save(const context::Context& ctx) { throw std::runtime_error("This program cannot be saved"); }
+
+  // Enables collecting per-kernel statistics, which requires profiling each kernel as it runs.  Program-level
+  // statistics are always collected.
+  virtual void EnableStats(bool enable) {}
+
+  // Limits the temporary device memory which the program's runs may hold at once, so that many programs can share a
+  // device; runs which would exceed the quota wait for earlier runs to release their temporaries.  Zero removes the
+  // limit.
+  virtual void SetMemoryQuota(std::uint64_t bytes) {}
+
+  virtual ProgramStats GetStats() const { return ProgramStats{}; }
+
+  // Whether the program's runs wait themselves for the all-reductions pending on their buffers (see
+  // tile/base/allreduce.h), starting the work which doesn't read the sums before they're written.  Otherwise, callers
+  // must wait for the sums before starting a run.
+  virtual bool WaitsForAllReduce() const { return false; }
 };
 
 }  // namespace tile
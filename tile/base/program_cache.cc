@@ -2,34 +2,111 @@
 
 #include "tile/base/program_cache.h"
 
+#include <algorithm>
+#include <cstring>
 #include <map>
 #include <sstream>
 
 #include "base/util/logging.h"
+#include "base/util/perf_counter.h"
+#include "tile/base/compile_pool.h"
 
 namespace vertexai {
 namespace tile {
 
-ProgramCache::ProgramCache(std::shared_ptr<Platform> platform, std::size_t size_max)
-    : platform_{platform}, cache_{size_max} {}
+namespace {
+
+PerfCounter cache_hits("program_cache_hits");
+PerfCounter cache_misses("program_cache_misses");
+PerfCounter cache_evictions("program_cache_evictions");
+PerfCounter tuned_swaps("program_cache_tuned_swaps");
+
+}  // namespace
+
+ProgramCache::ProgramCache(std::shared_ptr<Platform> platform, std::uint64_t max_bytes, std::size_t shard_count,
+                           bool speculate)
+    : platform_{platform}, shard_max_bytes_{max_bytes / shard_count}, speculate_{speculate}, shards_(shard_count) {}
 
 std::tuple<std::string, std::shared_ptr<Program>> ProgramCache::GetProgram(const context::Context& ctx,
                                                                            const std::string& fallback_id,
                                                                            const tile::proto::Program& program,
                                                                            ConstBufferManager* const_bufs) {
-  auto entry = GetEntry(fallback_id, program);
+  Key key;
+  auto entry = GetEntry(fallback_id, program, &key);
   VLOG(3) << "Using compiled program " << entry->id() << " for user program " << program.id();
-  return std::make_tuple(entry->id(), entry->GetProgram(ctx, platform_.get(), const_bufs));
+  auto compiled = entry->GetProgram(ctx, platform_, const_bufs, speculate_);
+  Charge(key, entry);
+  return std::make_tuple(entry->id(), std::move(compiled));
 }
 
 std::shared_ptr<lang::Program> ProgramCache::GetParsedProgram(const context::Context& ctx,
                                                               const std::string& fallback_id,
                                                               const tile::proto::Program& program) {
-  return GetEntry(fallback_id, program)->GetParsedProgram();
+  Key key;
+  return GetEntry(fallback_id, program, &key)->GetParsedProgram();
+}
+
+std::uint64_t ProgramCache::bytes() const {
+  std::uint64_t total = 0;
+  for (const auto& shard : shards_) {
+    std::lock_guard<std::mutex> lock{shard.mu};
+    total += shard.bytes;
+  }
+  return total;
 }
 
 namespace {
 
+// An incremental 128-bit hash: two independently seeded multiply-rotate lanes
+// over 64-bit words, finalized with the murmur3 mixer.  It only has to make
+// accidental collisions vanishingly rare, since hits are verified.
+class Hasher128 {
+ public:
+  void Update(const std::string& bytes) {
+    const char* data = bytes.data();
+    std::size_t len = bytes.size();
+    for (; len >= 8; data += 8, len -= 8) {
+      std::uint64_t word;
+      std::memcpy(&word, data, 8);
+      Mix(word);
+    }
+    std::uint64_t tail = 0;
+    std::memcpy(&tail, data, len);
+    // Folding in the length keeps adjacent strings from running together.
+    Mix(tail ^ (static_cast<std::uint64_t>(bytes.size()) << 8));
+  }
+
+  void Finish(std::uint64_t* hi, std::uint64_t* lo) const {
+    *hi = Fmix(hi_ ^ count_);
+    *lo = Fmix(lo_ + hi_ * kPrime1);
+  }
+
+ private:
+  static constexpr std::uint64_t kPrime1 = 0x9E3779B185EBCA87ull;
+  static constexpr std::uint64_t kPrime2 = 0xC2B2AE3D27D4EB4Full;
+
+  static std::uint64_t Rotl(std::uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+  static std::uint64_t Fmix(std::uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xFF51AFD7ED558CCDull;
+    k ^= k >> 33;
+    k *= 0xC4CEB9FE1A85EC53ull;
+    k ^= k >> 33;
+    return k;
+  }
+
+  void Mix(std::uint64_t word) {
+    hi_ = Rotl(hi_ ^ (word * kPrime1), 31) * kPrime2;
+    lo_ = Rotl(lo_ + (word * kPrime2), 27) * kPrime1 + 0x52DCE729;
+    count_++;
+  }
+
+  std::uint64_t hi_ = 0x6A09E667F3BCC908ull;
+  std::uint64_t lo_ = 0xBB67AE8584CAA73Bull;
+  std::uint64_t count_ = 0;
+};
+
 template <typename M>
 void SerializeShapemap(std::ostringstream* serialized, const M& m) {
   std::map<std::string, const proto::TensorShape&> shapes;
@@ -48,43 +125,125 @@ void SerializeShapemap(std::ostringstream* serialized, const M& m) {
 
 }  // namespace
 
+ProgramCache::Shard& ProgramCache::ShardFor(const Key& key) {
+  // The low half of the hash picks the bucket within the shard.
+  return shards_[key.hash_hi % shards_.size()];
+}
+
 std::shared_ptr<ProgramCache::Entry> ProgramCache::GetEntry(const std::string& fallback_id,
-                                                            const tile::proto::Program& program) {
+                                                            const tile::proto::Program& program, Key* key) {
+  // N.B. For cache lookup, we only hash the parts of the program that matter
+  // to the actual code generation.  The shapes are small, so they're
+  // serialized; the code is hashed in place.
   std::ostringstream serialized;
-
-  // N.B. For cache lookup, we only serialize the parts of the program that
-  // matter to the actual code generation.
-  serialized << program.code().length() << ':';
-  serialized << program.code();
-
   SerializeShapemap(&serialized, program.inputs());
+  serialized << '|';
   SerializeShapemap(&serialized, program.outputs());
+  std::string shapes = serialized.str();
+
+  Hasher128 hasher;
+  hasher.Update(program.code());
+  hasher.Update(shapes);
+  *key = Key{program.dev_id()};
+  hasher.Finish(&key->hash_hi, &key->hash_lo);
+  auto& shard = ShardFor(*key);
+  std::lock_guard<std::mutex> lock{shard.mu};
+
+  auto it = shard.entries.find(*key);
+  bool collision = false;
+  if (it != shard.entries.end()) {
+    if (it->second.code == program.code() && it->second.shapes == shapes) {
+      cache_hits.inc();
+      shard.lru.splice(shard.lru.begin(), shard.lru, it->second.lru_ent);
+      return it->second.entry;
+    }
+    // Leave the cached program be; this one is compiled without being cached.
+    LOG(WARNING) << "Program cache hash collision with " << it->second.entry->id();
+    collision = true;
+  }
+
+  cache_misses.inc();
+  std::string cid = "c" + std::to_string(next_id_++);
+  if (program.id().size()) {
+    cid = cid + '_' + program.id();
+  } else if (fallback_id.size()) {
+    cid = cid + '_' + fallback_id;
+  }
+  VLOG(3) << "Compiling program as " << cid;
+  tile::proto::Program cprog;
+  cprog.CopyFrom(program);
+  cprog.set_id(cid);
+  auto entry = std::make_shared<ProgramCache::Entry>(cid, cprog);
+  if (shard_max_bytes_ && !collision) {
+    it = shard.entries.emplace(*key, Slot{entry, 0, shard.lru.end(), program.code(), std::move(shapes)}).first;
+    it->second.lru_ent = shard.lru.emplace(shard.lru.begin(), LruEnt{&*it});
+  }
+  return entry;
+}
 
-  // The cache itself must be externally synchronized.
-  std::lock_guard<std::mutex> lock{mu_};
+void ProgramCache::Charge(const Key& key, const std::shared_ptr<Entry>& entry) {
+  auto bytes = entry->bytes();
+  auto& shard = ShardFor(key);
+  std::lock_guard<std::mutex> lock{shard.mu};
+  auto it = shard.entries.find(key);
+  if (it == shard.entries.end() || it->second.entry != entry || it->second.bytes == bytes) {
+    return;
+  }
+  shard.bytes += bytes - it->second.bytes;
+  it->second.bytes = bytes;
+  // Never evict the entry being charged; callers already hold it, and
+  // evicting it would only force a rebuild on the next lookup.
+  while (shard_max_bytes_ < shard.bytes && shard.lru.back().slot != &*it) {
+    auto victim = shard.lru.back().slot;
+    VLOG(3) << "Evicting compiled program " << victim->second.entry->id();
+    shard.bytes -= victim->second.bytes;
+    shard.entries.erase(Key{victim->first});
+    shard.lru.pop_back();
+    cache_evictions.inc();
+  }
+}
 
-  return cache_.Lookup(Key{program.dev_id(), serialized.str()}, [&]() {
-    std::string cid = "c" + std::to_string(next_id_++);
-    if (program.id().size()) {
-      cid = cid + '_' + program.id();
-    } else if (fallback_id.size()) {
-      cid = cid + '_' + fallback_id;
+std::shared_ptr<Program> ProgramCache::Entry::GetProgram(const context::Context& ctx,
+                                                         const std::shared_ptr<Platform>& dev,
+                                                         ConstBufferManager* const_bufs, bool speculate) {
+  std::call_once(compile_once_, [this, ctx, dev, const_bufs, speculate]() {
+    if (!speculate || proto_.tile_scanning_params().max_trials() <= 1) {
+      std::atomic_store(&compiled_, dev->MakeProgram(ctx, proto_, const_bufs));
+      proto_.Clear();
+      return;
     }
-    VLOG(3) << "Compiling program as " << cid;
-    tile::proto::Program cprog;
-    cprog.CopyFrom(program);
-    cprog.set_id(cid);
-    return std::make_shared<ProgramCache::Entry>(cid, cprog);
+    auto quick = proto_;
+    quick.clear_tile_scanning_params();
+    std::atomic_store(&compiled_, dev->MakeProgram(ctx, quick, const_bufs));
+    Tune(ctx, dev, const_bufs);
   });
+  return std::atomic_load(&compiled_);
 }
 
-std::shared_ptr<Program> ProgramCache::Entry::GetProgram(const context::Context& ctx, Platform* dev,
-                                                         ConstBufferManager* const_bufs) {
-  std::call_once(compile_once_, [this, ctx, dev, const_bufs]() {
-    compiled_ = dev->MakeProgram(ctx, proto_, const_bufs);
-    proto_.Clear();
+void ProgramCache::Entry::Tune(const context::Context& ctx, const std::shared_ptr<Platform>& dev,
+                               ConstBufferManager* const_bufs) {
+  // The caller's constants may be gone by the time the tuned build runs, so it
+  // gets its own copy of the manager (which shares the buffers themselves).
+  auto bufs = const_bufs ? std::make_shared<ConstBufferManager>(*const_bufs) : nullptr;
+  CompilePriorityScope background{CompilePriority::BACKGROUND};
+  CompileAsync([weak = weak_from_this(), id = id_, ctx, dev, bufs, proto = std::move(proto_)] {
+    if (weak.expired()) {
+      return;  // Evicted before the tuned build started
+    }
+    std::shared_ptr<Program> tuned;
+    try {
+      tuned = dev->MakeProgram(ctx, proto, bufs.get());
+    } catch (const std::exception& ex) {
+      LOG(WARNING) << "Tuned build of " << id << " failed; keeping the quick build: " << ex.what();
+      return;
+    }
+    if (auto self = weak.lock()) {
+      std::atomic_store(&self->compiled_, tuned);
+      tuned_swaps.inc();
+      VLOG(3) << "Swapped in the tuned build of " << id;
+    }
   });
-  return compiled_;
+  proto_.Clear();
 }
 
 std::shared_ptr<lang::Program> ProgramCache::Entry::GetParsedProgram() {
@@ -95,5 +254,11 @@ std::shared_ptr<lang::Program> ProgramCache::Entry::GetParsedProgram() {
   return parsed_;
 }
 
+std::uint64_t ProgramCache::Entry::bytes() const {
+  auto compiled = std::atomic_load(&compiled_);
+  std::uint64_t footprint = compiled ? compiled->MemoryFootprint() : 0;
+  return std::max(footprint, proto_bytes_);
+}
+
 }  // namespace tile
 }  // namespace vertexai
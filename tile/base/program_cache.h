@@ -2,14 +2,18 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <list>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <tuple>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "base/context/context.h"
-#include "tile/base/lru_cache.h"
 #include "tile/base/platform.h"
 #include "tile/base/program.h"
 #include "tile/lang/parser.h"
@@ -18,10 +22,25 @@
 namespace vertexai {
 namespace tile {
 
-// ProgramCache implements an LRU Tile program cache.
+// ProgramCache implements an LRU Tile program cache, bounded by the memory
+// footprint of the compiled programs.
+//
+// The cache is split into shards, each with its own lock and an equal share of
+// the byte budget.  Locks are only held while looking up or updating a shard's
+// map; programs are compiled outside the lock, so a slow compile only blocks
+// the callers waiting for that same program.
+//
+// With speculation enabled, a program which asks for tile scanning is first
+// compiled without it, so that it can start running right away, while a tuned
+// build is compiled in the background.  The tuned program replaces the quick
+// one in its entry once it's ready; runs already holding the quick program
+// finish with it, and later lookups get the tuned one.
 class ProgramCache final {
  public:
-  ProgramCache(std::shared_ptr<Platform> platform, std::size_t size_max);
+  static constexpr std::size_t kDefaultShardCount = 16;
+
+  ProgramCache(std::shared_ptr<Platform> platform, std::uint64_t max_bytes,
+               std::size_t shard_count = kDefaultShardCount, bool speculate = false);
 
   // Gets the the requested program, looking it up in the cache and building it if necessary.
   // The fallback ID is used as the program ID if the program has no ID -- since GetProgram
@@ -38,49 +57,93 @@ class ProgramCache final {
   std::shared_ptr<lang::Program> GetParsedProgram(const context::Context& ctx, const std::string& fallback_id,
                                                   const tile::proto::Program& program);
 
+  // The total footprint of the programs currently held by the cache.
+  std::uint64_t bytes() const;
+
  private:
+  // Programs are keyed by a 128-bit hash of the parts which matter to code
+  // generation, so lookups don't build or compare the full program text.
   struct Key {
     std::string subdevice;
-    std::string ops;
-  };
+    std::uint64_t hash_hi = 0;
+    std::uint64_t hash_lo = 0;
 
-  struct KeyComp {
-    bool operator()(const Key& lhs, const Key& rhs) const {
-      if (lhs.subdevice < rhs.subdevice) {
-        return true;
-      }
-      if (rhs.subdevice < lhs.subdevice) {
-        return false;
-      }
-      return lhs.ops < rhs.ops;
+    bool operator==(const Key& other) const {
+      return hash_lo == other.hash_lo && hash_hi == other.hash_hi && subdevice == other.subdevice;
     }
   };
 
-  class Entry {
+  struct KeyHash {
+    std::size_t operator()(const Key& key) const { return key.hash_lo; }
+  };
+
+  class Entry : public std::enable_shared_from_this<Entry> {
    public:
-    Entry(std::string id, tile::proto::Program proto) : id_{std::move(id)}, proto_{std::move(proto)} {}
+    Entry(std::string id, tile::proto::Program proto)
+        : id_{std::move(id)}, proto_{std::move(proto)}, proto_bytes_{proto_.ByteSizeLong()} {}
 
     const std::string& id() const { return id_; }
 
-    std::shared_ptr<Program> GetProgram(const context::Context& ctx, Platform* dev, ConstBufferManager* const_bufs);
+    std::shared_ptr<Program> GetProgram(const context::Context& ctx, const std::shared_ptr<Platform>& dev,
+                                        ConstBufferManager* const_bufs, bool speculate);
 
     std::shared_ptr<lang::Program> GetParsedProgram();
 
+    // The bytes this entry is charged against the cache's budget.  Programs
+    // which can't estimate their own footprint are charged for their source.
+    std::uint64_t bytes() const;
+
    private:
+    // Compiles the tuned program in the background, replacing compiled_ with it once it's ready.
+    void Tune(const context::Context& ctx, const std::shared_ptr<Platform>& dev, ConstBufferManager* const_bufs);
+
     std::string id_;
     std::once_flag compile_once_, parse_once_;
     tile::proto::Program proto_;
-    std::shared_ptr<Program> compiled_;
+    std::uint64_t proto_bytes_;
+    std::shared_ptr<Program> compiled_;  // Accessed atomically, since a tuned build may replace it
     std::shared_ptr<lang::Program> parsed_;
   };
 
-  std::shared_ptr<Entry> GetEntry(const std::string& fallback_id, const tile::proto::Program& program);
+  struct LruEnt;
 
-  std::shared_ptr<Platform> platform_;
+  struct Slot {
+    std::shared_ptr<Entry> entry;
+    std::uint64_t bytes = 0;  // What the entry has been charged so far
+    std::list<LruEnt>::iterator lru_ent;
+    // What the key was hashed from, to tell a genuine hit from a hash collision.
+    std::string code;
+    std::string shapes;
+  };
 
-  std::mutex mu_;
-  int next_id_ = 1;
-  LruCache<Key, std::shared_ptr<Entry>, KeyComp> cache_;
+  using EntryMap = std::unordered_map<Key, Slot, KeyHash>;
+
+  struct LruEnt {
+    // Rehashing invalidates the map's iterators but not its elements.
+    EntryMap::value_type* slot;
+  };
+
+  struct Shard {
+    mutable std::mutex mu;
+    EntryMap entries;
+    // Recently used entries are at the front; the next entry to evict is at the back.
+    std::list<LruEnt> lru;
+    std::uint64_t bytes = 0;
+  };
+
+  std::shared_ptr<Entry> GetEntry(const std::string& fallback_id, const tile::proto::Program& program, Key* key);
+
+  // Charges a newly compiled entry against its shard, evicting the least
+  // recently used entries as needed to stay within the budget.
+  void Charge(const Key& key, const std::shared_ptr<Entry>& entry);
+
+  Shard& ShardFor(const Key& key);
+
+  std::shared_ptr<Platform> platform_;
+  std::uint64_t shard_max_bytes_;
+  bool speculate_;
+  std::atomic<int> next_id_{1};
+  std::vector<Shard> shards_;
 };
 
 }  // namespace tile
@@ -0,0 +1,170 @@
+// Copyright 2019, Intel Corp.
+
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/thread/future.hpp>
+
+#include "tile/base/program_cache.h"
+
+using ::testing::Eq;
+
+namespace vertexai {
+namespace tile {
+namespace {
+
+constexpr std::uint64_t kFootprint = 1000;
+
+class FakeProgram final : public Program {
+ public:
+  boost::future<void> Run(const context::Context& ctx, std::map<std::string, std::shared_ptr<Buffer>> inputs,
+                          std::map<std::string, std::shared_ptr<Buffer>> outputs) final {
+    return boost::make_ready_future();
+  }
+  std::size_t MaxAvailableMemory() final { return 0; }
+  void Release() final {}
+  std::uint64_t MemoryFootprint() const final { return kFootprint; }
+};
+
+// A platform which counts builds, and which can hold the build of a
+// particular program until released.
+class FakePlatform final : public Platform {
+ public:
+  std::shared_ptr<Buffer> MakeBuffer(const context::Context& ctx, const std::string& device,
+                                     std::uint64_t size) final {
+    return nullptr;
+  }
+  std::shared_ptr<Buffer> WrapBuffer(const context::Context& ctx, const std::string& device, void* base,
+                                     std::uint64_t size) final {
+    return nullptr;
+  }
+  std::shared_ptr<Program> MakeProgram(const context::Context& ctx, const proto::Program& program,
+                                       ConstBufferManager* const_bufs) final {
+    ++builds;
+    if (program.tile_scanning_params().max_trials() > 1) {
+      ++tuned_builds;
+    }
+    if (program.code() == blocked_code) {
+      release.get_future().wait();
+    }
+    return std::make_shared<FakeProgram>();
+  }
+  void ListDevices(const context::Context& ctx, const proto::ListDevicesRequest& request,
+                   proto::ListDevicesResponse* response) final {}
+  void RegisterCostModel(const lang::TileCostFunction& cost_fn) final {}
+  std::vector<std::string> ListDevices() final { return {}; }
+  std::shared_ptr<Program> MakeProgram(const context::Context& ctx, const std::string& device,
+                                       const std::string& target, const std::shared_ptr<stripe::Program>& program,
+                                       ConstBufferManager* const_bufs) final {
+    return nullptr;
+  }
+
+  std::atomic<int> builds{0};
+  std::atomic<int> tuned_builds{0};
+  std::string blocked_code;
+  boost::promise<void> release;
+};
+
+proto::Program MakeProto(const std::string& code) {
+  proto::Program program;
+  program.set_dev_id("dev");
+  program.set_code(code);
+  return program;
+}
+
+TEST(ProgramCacheTest, HitsReuseCompiledPrograms) {
+  auto platform = std::make_shared<FakePlatform>();
+  ProgramCache cache{platform, 1 << 20};
+  context::Context ctx;
+  auto first = std::get<1>(cache.GetProgram(ctx, "", MakeProto("function (A) -> (B) { B = A; }")));
+  auto second = std::get<1>(cache.GetProgram(ctx, "", MakeProto("function (A) -> (B) { B = A; }")));
+  EXPECT_THAT(second, Eq(first));
+  EXPECT_THAT(platform->builds.load(), Eq(1));
+  EXPECT_THAT(cache.bytes(), Eq(kFootprint));
+}
+
+TEST(ProgramCacheTest, ShapesAreKeyed) {
+  auto platform = std::make_shared<FakePlatform>();
+  ProgramCache cache{platform, 1 << 20};
+  context::Context ctx;
+  auto small = MakeProto("function (A) -> (B) { B = A; }");
+  auto dim = (*small.mutable_inputs())["A"].mutable_shape()->add_dims();
+  dim->set_size(4);
+  dim->set_stride(1);
+  auto large = small;
+  (*large.mutable_inputs())["A"].mutable_shape()->mutable_dims(0)->set_size(8);
+  auto first = std::get<1>(cache.GetProgram(ctx, "", small));
+  auto second = std::get<1>(cache.GetProgram(ctx, "", large));
+  EXPECT_THAT(platform->builds.load(), Eq(2));
+  EXPECT_THAT(std::get<1>(cache.GetProgram(ctx, "", small)), Eq(first));
+  EXPECT_THAT(std::get<1>(cache.GetProgram(ctx, "", large)), Eq(second));
+  EXPECT_THAT(platform->builds.load(), Eq(2));
+}
+
+TEST(ProgramCacheTest, EvictsLeastRecentlyUsedOverBudget) {
+  auto platform = std::make_shared<FakePlatform>();
+  ProgramCache cache{platform, 2 * kFootprint + kFootprint / 2, 1};
+  context::Context ctx;
+  cache.GetProgram(ctx, "", MakeProto("a"));
+  cache.GetProgram(ctx, "", MakeProto("b"));
+  cache.GetProgram(ctx, "", MakeProto("a"));  // Makes "b" the least recently used
+  EXPECT_THAT(platform->builds.load(), Eq(2));
+
+  cache.GetProgram(ctx, "", MakeProto("c"));
+  EXPECT_THAT(platform->builds.load(), Eq(3));
+  EXPECT_THAT(cache.bytes(), Eq(2 * kFootprint));
+
+  cache.GetProgram(ctx, "", MakeProto("a"));
+  EXPECT_THAT(platform->builds.load(), Eq(3));
+  cache.GetProgram(ctx, "", MakeProto("b"));
+  EXPECT_THAT(platform->builds.load(), Eq(4));
+}
+
+TEST(ProgramCacheTest, SlowBuildDoesNotBlockHits) {
+  auto platform = std::make_shared<FakePlatform>();
+  ProgramCache cache{platform, 1 << 20, 1};
+  context::Context ctx;
+  cache.GetProgram(ctx, "", MakeProto("fast"));
+
+  platform->blocked_code = "slow";
+  std::thread builder{[&] { cache.GetProgram(ctx, "", MakeProto("slow")); }};
+  while (platform->builds.load() < 2) {
+    std::this_thread::yield();
+  }
+  // The slow build holds no cache lock, so this hit completes while it runs.
+  cache.GetProgram(ctx, "", MakeProto("fast"));
+  EXPECT_THAT(platform->builds.load(), Eq(2));
+  platform->release.set_value();
+  builder.join();
+}
+
+TEST(ProgramCacheTest, SpeculationSwapsInTunedBuild) {
+  auto platform = std::make_shared<FakePlatform>();
+  ProgramCache cache{platform, 1 << 20, 1, true};
+  context::Context ctx;
+  auto proto = MakeProto("function (A) -> (B) { B = A; }");
+  proto.mutable_tile_scanning_params()->set_max_trials(8);
+
+  auto quick = std::get<1>(cache.GetProgram(ctx, "", proto));
+  auto current = quick;
+  // The tuned build runs in the background; give it ample time, but fail rather than hang if it never lands.
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+  while (current == quick) {
+    ASSERT_LT(std::chrono::steady_clock::now(), deadline) << "The tuned build was never swapped in";
+    std::this_thread::yield();
+    current = std::get<1>(cache.GetProgram(ctx, "", proto));
+  }
+  EXPECT_THAT(platform->builds.load(), Eq(2));
+  EXPECT_THAT(platform->tuned_builds.load(), Eq(1));
+}
+
+}  // namespace
+}  // namespace tile
+}  // namespace vertexai
@@ -69,6 +69,9 @@ void Step::Log(el::base::type::ostream_t& os) const {
     }
     os << ']';
   }
+  if (queue) {
+    os << " queue=" << queue;
+  }
 }
 
 void Schedule::Reindex() {
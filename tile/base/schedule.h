@@ -57,6 +57,7 @@ struct Step {
 
   std::size_t kidx = 0;          // Used for run steps
   std::uint64_t byte_count = 0;  // Used for copy steps
+  std::size_t queue = 0;         // The queue the step was assigned to; steps on one queue run in order
 };
 
 inline MAKE_LOGGABLE(Step, step, os) {
@@ -45,9 +45,10 @@ std::ostream& operator<<(std::ostream& os, const TensorDimension& dim) {
 
 void TensorShape::resize_dim(size_t pos, uint64_t size) {
   assert(pos < dims.size());
-  dims[pos].size = size;
+  std::vector<TensorDimension> resized = dims;
+  resized[pos].size = size;
   std::multimap<int64_t, TensorDimension*> sorted;
-  for (auto& dim : dims) {
+  for (auto& dim : resized) {
     sorted.emplace(dim.stride, &dim);
   }
   int64_t stride = 1;
@@ -55,6 +56,7 @@ void TensorShape::resize_dim(size_t pos, uint64_t size) {
     item.second->stride = stride;
     stride *= item.second->size;
   }
+  dims = std::move(resized);
 }
 
 DataType CommonSupertype(DataType lhs, DataType rhs) {
@@ -1,7 +1,10 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
+#include <initializer_list>
 #include <map>
+#include <memory>
 #include <ostream>
 #include <set>
 #include <string>
@@ -222,20 +225,146 @@ struct TensorDimension {
   }
 };
 
-struct TensorShape {
-  TensorShape() = default;
-  TensorShape(DataType type, const std::vector<TensorDimension>& dims, const std::string& layout = "")
-      : type(type), dims(dims), layout(layout) {}
-
-  DataType type = DataType::INVALID;
-  std::vector<TensorDimension> dims;
-  bool is_const = false;
-  std::string codec;
-  std::string layout;
+// The dimensions of a TensorShape.  Shapes are copied into every refinement, binding and kernel, so copies share one
+// immutable list of dimensions (along with its element count and hash, each computed once) until one of them modifies
+// it.  It reads like a const std::vector; writes go through the mutators below, which copy the list first if it's
+// shared.  No mutable reference to an element is ever handed out, so reads never force a copy.
+class TensorDims {
+ public:
+  using value_type = TensorDimension;
+  using size_type = size_t;
+  using reference = const TensorDimension&;
+  using const_reference = const TensorDimension&;
+  using iterator = std::vector<TensorDimension>::const_iterator;
+  using const_iterator = std::vector<TensorDimension>::const_iterator;
+  using reverse_iterator = std::vector<TensorDimension>::const_reverse_iterator;
+  using const_reverse_iterator = std::vector<TensorDimension>::const_reverse_iterator;
+
+  TensorDims() = default;
+  TensorDims(std::vector<TensorDimension> dims)  // NOLINT(runtime/explicit)
+      : node_{std::make_shared<Node>(std::move(dims))} {}
+  TensorDims(std::initializer_list<TensorDimension> dims) : TensorDims{std::vector<TensorDimension>(dims)} {}
+  TensorDims(const TensorDims& rhs) = default;
+  TensorDims(TensorDims&& rhs) noexcept = default;
+  TensorDims& operator=(const TensorDims& rhs) = default;
+  TensorDims& operator=(TensorDims&& rhs) noexcept = default;
+
+  operator const std::vector<TensorDimension>&() const { return vec(); }  // NOLINT(runtime/explicit)
+
+  size_t size() const { return vec().size(); }
+  bool empty() const { return vec().empty(); }
+
+  const TensorDimension& operator[](size_t pos) const { return vec()[pos]; }
+  const TensorDimension& at(size_t pos) const { return vec().at(pos); }
+  const TensorDimension& front() const { return vec().front(); }
+  const TensorDimension& back() const { return vec().back(); }
+  const TensorDimension* data() const { return vec().data(); }
+  const_iterator begin() const { return vec().begin(); }
+  const_iterator end() const { return vec().end(); }
+  const_iterator cbegin() const { return vec().cbegin(); }
+  const_iterator cend() const { return vec().cend(); }
+  const_reverse_iterator rbegin() const { return vec().rbegin(); }
+  const_reverse_iterator rend() const { return vec().rend(); }
+
+  // Setting a dimension to its current value leaves the list shared.
+  void set(size_t pos, const TensorDimension& dim) {
+    if (!(at(pos) == dim)) {
+      Modify()[pos] = dim;
+    }
+  }
+  void set_size(size_t pos, uint64_t size) { set(pos, TensorDimension{at(pos).stride, size}); }
+  void set_stride(size_t pos, int64_t stride) { set(pos, TensorDimension{stride, at(pos).size}); }
 
-  uint64_t byte_size() const { return elem_size() * byte_width(type); }
+  void push_back(const TensorDimension& dim) { Modify().push_back(dim); }
+  template <typename... Args>
+  void emplace_back(Args&&... args) {
+    Modify().emplace_back(std::forward<Args>(args)...);
+  }
+  void pop_back() { Modify().pop_back(); }
+  const_iterator insert(const_iterator pos, const TensorDimension& dim) {
+    auto offset = pos - vec().begin();
+    auto& dims = Modify();
+    return dims.insert(dims.begin() + offset, dim);
+  }
+  template <typename InputIt>
+  const_iterator insert(const_iterator pos, InputIt first, InputIt last) {
+    auto offset = pos - vec().begin();
+    auto& dims = Modify();
+    return dims.insert(dims.begin() + offset, first, last);
+  }
+  const_iterator erase(const_iterator pos) {
+    auto offset = pos - vec().begin();
+    auto& dims = Modify();
+    return dims.erase(dims.begin() + offset);
+  }
+  const_iterator erase(const_iterator first, const_iterator last) {
+    auto offset = first - vec().begin();
+    auto count = last - first;
+    auto& dims = Modify();
+    return dims.erase(dims.begin() + offset, dims.begin() + offset + count);
+  }
+  void clear() { node_.reset(); }
+  void reserve(size_t count) { Modify().reserve(count); }
+  void resize(size_t count) { Modify().resize(count); }
 
+  // The number of elements spanned by a tensor with these dimensions
   uint64_t elem_size() const {
+    if (!node_) {
+      return 1;
+    }
+    auto elem_size = node_->elem_size.load(std::memory_order_relaxed);
+    if (elem_size == kUnknown) {
+      elem_size = ComputeElemSize(node_->dims);
+      node_->elem_size.store(elem_size, std::memory_order_relaxed);
+    }
+    return elem_size;
+  }
+
+  size_t hash() const {
+    if (!node_) {
+      return 0;
+    }
+    if (!node_->hashed.load(std::memory_order_acquire)) {
+      node_->hash.store(ComputeHash(node_->dims), std::memory_order_relaxed);
+      node_->hashed.store(true, std::memory_order_release);
+    }
+    return node_->hash.load(std::memory_order_relaxed);
+  }
+
+  // Whether rhs still shares this list, rather than holding its own copy of it.
+  bool shares_with(const TensorDims& rhs) const { return node_ && node_ == rhs.node_; }
+
+  // Copies sharing a list are equal without comparing it, and lists with different hashes differ.
+  bool operator==(const TensorDims& rhs) const {
+    if (node_ == rhs.node_) {
+      return true;
+    }
+    if (size() != rhs.size() || (cached_hash() && rhs.cached_hash() && hash() != rhs.hash())) {
+      return false;
+    }
+    return vec() == rhs.vec();
+  }
+  bool operator!=(const TensorDims& rhs) const { return !(*this == rhs); }
+  bool operator<(const TensorDims& rhs) const { return node_ != rhs.node_ && vec() < rhs.vec(); }
+
+  friend bool operator==(const TensorDims& lhs, const std::vector<TensorDimension>& rhs) { return lhs.vec() == rhs; }
+  friend bool operator==(const std::vector<TensorDimension>& lhs, const TensorDims& rhs) { return lhs == rhs.vec(); }
+  friend bool operator!=(const TensorDims& lhs, const std::vector<TensorDimension>& rhs) { return lhs.vec() != rhs; }
+  friend bool operator!=(const std::vector<TensorDimension>& lhs, const TensorDims& rhs) { return lhs != rhs.vec(); }
+
+ private:
+  static constexpr uint64_t kUnknown = UINT64_MAX;
+
+  struct Node {
+    explicit Node(std::vector<TensorDimension> dims) : dims{std::move(dims)} {}
+
+    std::vector<TensorDimension> dims;
+    std::atomic<uint64_t> elem_size{kUnknown};
+    std::atomic<bool> hashed{false};
+    std::atomic<size_t> hash{0};
+  };
+
+  static uint64_t ComputeElemSize(const std::vector<TensorDimension>& dims) {
     uint64_t max_elem = 0;
     for (const auto& dim : dims) {
       if (!dim.size) {
@@ -248,6 +377,54 @@ struct TensorShape {
     return max_elem + 1;
   }
 
+  static size_t ComputeHash(const std::vector<TensorDimension>& dims) {
+    size_t hash = dims.size();
+    for (const auto& dim : dims) {
+      hash = hash * 1000003 ^ static_cast<size_t>(dim.stride);
+      hash = hash * 1000003 ^ static_cast<size_t>(dim.size);
+    }
+    return hash;
+  }
+
+  const std::vector<TensorDimension>& vec() const {
+    static const std::vector<TensorDimension> empty;
+    return node_ ? node_->dims : empty;
+  }
+
+  // Whether hash() is free: hashes are only compared when both sides have one already, to keep equality cheap.
+  bool cached_hash() const { return node_ && node_->hashed.load(std::memory_order_acquire); }
+
+  // Returns dims for modification, copying them first if they're shared.
+  std::vector<TensorDimension>& Modify() {
+    if (!node_) {
+      node_ = std::make_shared<Node>(std::vector<TensorDimension>{});
+    } else if (node_.use_count() > 1) {
+      node_ = std::make_shared<Node>(node_->dims);
+    } else {
+      node_->elem_size.store(kUnknown, std::memory_order_relaxed);
+      node_->hashed.store(false, std::memory_order_relaxed);
+    }
+    return node_->dims;
+  }
+
+  std::shared_ptr<Node> node_;
+};
+
+struct TensorShape {
+  TensorShape() = default;
+  TensorShape(DataType type, TensorDims dims, const std::string& layout = "")
+      : type(type), dims(std::move(dims)), layout(layout) {}
+
+  DataType type = DataType::INVALID;
+  TensorDims dims;
+  bool is_const = false;
+  std::string codec;
+  std::string layout;
+
+  uint64_t byte_size() const { return elem_size() * byte_width(type); }
+
+  uint64_t elem_size() const { return dims.elem_size(); }
+
   std::vector<size_t> sizes() const {
     std::vector<size_t> ret;
     for (const auto& dim : dims) {
@@ -309,10 +486,7 @@ struct TensorShape {
     return cache_lines;
   }
 
-  inline bool operator==(const TensorShape& rhs) const {
-    return std::tie(type, dims) ==  //
-           std::tie(rhs.type, rhs.dims);
-  }
+  inline bool operator==(const TensorShape& rhs) const { return type == rhs.type && dims == rhs.dims; }
 
   inline bool operator<(const TensorShape& rhs) const {
     return std::tie(type, dims) <  //
@@ -0,0 +1,66 @@
+// Copyright 2020, Intel Corporation.
+
+#include <gmock/gmock.h>
+
+#include "tile/base/shape.h"
+
+using ::testing::Eq;
+using ::testing::Not;
+
+namespace vertexai {
+namespace tile {
+namespace {
+
+TEST(TensorShapeTest, CopiesAreIndependent) {
+  auto shape = SimpleShape(DataType::FLOAT32, {2, 3, 4});
+  auto copy = shape;
+  EXPECT_THAT(copy, Eq(shape));
+
+  copy.dims.push_back(TensorDimension{1, 5});
+  copy.resize_dim(0, 6);
+  EXPECT_THAT(shape, Eq(SimpleShape(DataType::FLOAT32, {2, 3, 4})));
+  EXPECT_THAT(copy, Not(Eq(shape)));
+  EXPECT_THAT(shape.byte_size(), Eq(2 * 3 * 4 * 4));
+}
+
+TEST(TensorShapeTest, ReadsKeepSharing) {
+  auto shape = SimpleShape(DataType::INT8, {2, 3});
+  auto copy = shape;
+  uint64_t total = 0;
+  for (const auto& dim : shape.dims) {
+    total += dim.size;
+  }
+  total += shape.dims[0].size + shape.dims.back().stride;
+  EXPECT_THAT(total, Eq(2 + 3 + 2 + 1));
+  EXPECT_TRUE(shape.dims.shares_with(copy.dims));
+  EXPECT_TRUE(shape.dims.shares_with(TensorShape{shape}.dims));
+}
+
+TEST(TensorShapeTest, WritesStayPrivate) {
+  auto shape = SimpleShape(DataType::INT8, {2, 3});
+  EXPECT_THAT(shape.elem_size(), Eq(2 * 3));
+  auto copy = shape;
+  shape.dims.set_size(0, 7);
+  EXPECT_FALSE(shape.dims.shares_with(copy.dims));
+  EXPECT_THAT(shape.dims[0].size, Eq(7));
+  EXPECT_THAT(copy.dims[0].size, Eq(2));
+  EXPECT_THAT(shape.elem_size(), Eq(7 * 3));
+  EXPECT_THAT(copy.elem_size(), Eq(2 * 3));
+  shape.dims.set_stride(0, 0);
+  EXPECT_THAT(shape.elem_size(), Eq(3));
+}
+
+TEST(TensorShapeTest, EqualityComparesDims) {
+  auto shape = SimpleShape(DataType::FLOAT32, {2, 3});
+  shape.dims.hash();
+  auto other = SimpleShape(DataType::FLOAT32, {2, 3});
+  other.dims.hash();
+  EXPECT_THAT(other, Eq(shape));
+  EXPECT_THAT(SimpleShape(DataType::FLOAT32, {3, 2}), Not(Eq(shape)));
+  EXPECT_THAT(SimpleShape(DataType::FLOAT16, {2, 3}), Not(Eq(shape)));
+  EXPECT_THAT(TensorShape{}.elem_size(), Eq(1));
+}
+
+}  // namespace
+}  // namespace tile
+}  // namespace vertexai
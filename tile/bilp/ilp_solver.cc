@@ -1,11 +1,159 @@
 #include "tile/bilp/ilp_solver.h"
 
+#include <limits>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <utility>
+
 namespace vertexai {
 namespace tile {
 namespace bilp {
 
 using namespace math;  // NOLINT
 
+namespace {
+
+// The batch_solve results for one constraint set.
+struct MemoEntry {
+  bool feasible = true;
+  std::map<Polynomial<Rational>, ILPResult> results;
+};
+
+// The same few constraint sets come up repeatedly (e.g. the bounds of a
+// convolution's padded indices), so batch_solve results are memoized by the
+// canonical form of the constraints.  The memo is simply dropped when it grows
+// too large.
+const size_t kMaxMemoEntries = 4096;
+std::mutex memo_mu;
+std::map<std::string, MemoEntry> memo;
+
+// Orders and deduplicates the constraints, neither of which changes the
+// feasible region.
+std::string MemoKey(const std::string& kind, const std::vector<SimpleConstraint>& constraints,
+                    bool throw_infeasible) {
+  std::set<std::string> lines;
+  for (const SimpleConstraint& c : constraints) {
+    lines.insert(c.poly.toString() + " <= " + std::to_string(c.rhs));
+  }
+  std::ostringstream key;
+  key << kind << (throw_infeasible ? " throw" : "");
+  for (const auto& line : lines) {
+    key << "\n" << line;
+  }
+  return key.str();
+}
+
+bool ToInt64(const Rational& r, int64_t* out) {
+  if (denominator(r) != 1) {
+    return false;
+  }
+  const Integer& n = numerator(r);
+  if (n > std::numeric_limits<int64_t>::max() || n < std::numeric_limits<int64_t>::min()) {
+    return false;
+  }
+  *out = static_cast<int64_t>(n);
+  return true;
+}
+
+// Division rounding toward -infinity and +infinity respectively; b must be
+// nonzero, and not -1 when a is the minimum int64.
+int64_t FloorDiv(int64_t a, int64_t b) { return a / b - ((a % b != 0) && ((a < 0) != (b < 0))); }
+int64_t CeilDiv(int64_t a, int64_t b) { return a / b + ((a % b != 0) && ((a < 0) == (b < 0))); }
+
+// The inclusive range of values a variable may take.
+struct Box {
+  int64_t lo = std::numeric_limits<int64_t>::min();
+  int64_t hi = std::numeric_limits<int64_t>::max();
+  bool has_lo = false;
+  bool has_hi = false;
+};
+
+// Solves the common case in which every constraint bounds a single variable
+// with integer coefficients, so the feasible region is a box and each
+// objective is optimized at a corner, using int64 arithmetic rather than a
+// tableau of Rationals.  Returns false (leaving the problem to the tableau) for
+// any other constraints, for objectives unbounded over the box, or on
+// overflow.  As with the tableau, an objective's constant term is not included
+// in its value.
+bool SolveBoxes(const std::vector<SimpleConstraint>& constraints, const std::vector<Polynomial<Rational>>& objectives,
+                MemoEntry* out) {
+  std::map<std::string, Box> boxes;
+  for (const SimpleConstraint& c : constraints) {
+    std::string var;
+    int64_t coeff = 0;
+    int64_t constant = 0;
+    for (const auto& kvp : c.poly.getMap()) {
+      if (kvp.first.empty()) {
+        if (!ToInt64(kvp.second, &constant)) {
+          return false;
+        }
+      } else if (kvp.second != 0) {
+        if (!var.empty() || !ToInt64(kvp.second, &coeff)) {
+          return false;
+        }
+        var = kvp.first;
+      }
+    }
+    // coeff * var <= c.rhs - constant
+    if ((constant > 0 && c.rhs < std::numeric_limits<int64_t>::min() + constant) ||
+        (constant < 0 && c.rhs > std::numeric_limits<int64_t>::max() + constant)) {
+      return false;
+    }
+    int64_t limit = c.rhs - constant;
+    if (var.empty()) {
+      if (limit < 0) {
+        out->feasible = false;
+        return true;
+      }
+      continue;
+    }
+    if (coeff == -1 && limit == std::numeric_limits<int64_t>::min()) {
+      return false;
+    }
+    Box& box = boxes[var];
+    if (coeff > 0) {
+      box.hi = std::min(box.hi, FloorDiv(limit, coeff));
+      box.has_hi = true;
+    } else {
+      box.lo = std::max(box.lo, CeilDiv(limit, coeff));
+      box.has_lo = true;
+    }
+  }
+  for (const auto& kvp : boxes) {
+    if (kvp.second.lo > kvp.second.hi) {
+      out->feasible = false;
+      return true;
+    }
+  }
+
+  std::map<Polynomial<Rational>, ILPResult> results;
+  for (const Polynomial<Rational>& obj : objectives) {
+    ILPResult result;
+    for (const auto& kvp : boxes) {
+      result.soln[kvp.first] = kvp.second.has_lo ? kvp.second.lo : kvp.second.hi;
+    }
+    for (const auto& kvp : obj.getMap()) {
+      if (kvp.first.empty() || kvp.second == 0) {
+        continue;
+      }
+      auto it = boxes.find(kvp.first);
+      if (it == boxes.end() || (kvp.second > 0 ? !it->second.has_lo : !it->second.has_hi)) {
+        return false;
+      }
+      Rational value = kvp.second > 0 ? it->second.lo : it->second.hi;
+      result.soln[kvp.first] = value;
+      result.obj_val += kvp.second * value;
+    }
+    results.emplace(obj, result);
+  }
+  out->feasible = true;
+  out->results = std::move(results);
+  return true;
+}
+
+}  // namespace
+
 std::map<std::string, Rational> ILPSolver::reportSolution() const {
   std::vector<Rational> sym_soln = getSymbolicSolution();
   std::map<std::string, Rational> soln;
@@ -24,16 +172,80 @@ std::map<Polynomial<Rational>, ILPResult> ILPSolver::batch_solve(const std::vect
                                                                  const std::vector<Polynomial<Rational>>& objectives) {
   // Solve a batch of ILP problems, all with the same constraints but different objectives
   // A wrapper for the Tableau version
-  Tableau t = makeStandardFormTableau(constraints);
-  return batch_solve(&t, objectives);
+  std::vector<SimpleConstraint> bounds;
+  for (const RangeConstraint& c : constraints) {
+    bounds.push_back(c.lowerBound());
+    bounds.push_back(c.upperBound());
+  }
+  return memoized_batch_solve("range", bounds, objectives, [&] { return makeStandardFormTableau(constraints); });
 }
 
 std::map<Polynomial<Rational>, ILPResult> ILPSolver::batch_solve(const std::vector<SimpleConstraint>& constraints,
                                                                  const std::vector<Polynomial<Rational>>& objectives) {
   // Solve a batch of ILP problems, all with the same constraints but different objectives
   // A wrapper for the Tableau version
-  Tableau t = makeStandardFormTableau(constraints);
-  return batch_solve(&t, objectives);
+  return memoized_batch_solve("simple", constraints, objectives,
+                              [&] { return makeStandardFormTableau(constraints); });
+}
+
+std::map<Polynomial<Rational>, ILPResult> ILPSolver::memoized_batch_solve(
+    const std::string& kind, const std::vector<SimpleConstraint>& bounds,
+    const std::vector<Polynomial<Rational>>& objectives, const std::function<Tableau()>& make_tableau) {
+  auto key = MemoKey(kind, bounds, throw_infeasible);
+  std::map<Polynomial<Rational>, ILPResult> ret;
+  std::vector<Polynomial<Rational>> todo;
+  bool feasible = true;
+  {
+    std::lock_guard<std::mutex> lock(memo_mu);
+    auto it = memo.find(key);
+    if (it == memo.end()) {
+      todo = objectives;
+    } else if (!it->second.feasible) {
+      feasible = false;
+    } else {
+      for (const auto& obj : objectives) {
+        auto it_obj = it->second.results.find(obj);
+        if (it_obj == it->second.results.end()) {
+          todo.push_back(obj);
+        } else {
+          ret.emplace(*it_obj);
+        }
+      }
+    }
+  }
+
+  if (feasible && !todo.empty()) {
+    MemoEntry solved;
+    if (!SolveBoxes(bounds, todo, &solved)) {
+      Tableau t = make_tableau();
+      solved.results = batch_solve(&t, todo);
+      solved.feasible = !solved.results.empty();
+    }
+    feasible = solved.feasible;
+    ret.insert(solved.results.begin(), solved.results.end());
+
+    std::lock_guard<std::mutex> lock(memo_mu);
+    if (memo.size() >= kMaxMemoEntries && !memo.count(key)) {
+      memo.clear();
+    }
+    MemoEntry& entry = memo[key];
+    entry.feasible = solved.feasible;
+    entry.results.insert(solved.results.begin(), solved.results.end());
+  }
+
+  if (!feasible) {
+    IVLOG(3, "Feasible region empty");
+    if (throw_infeasible) {
+      throw std::runtime_error("Unable to run ILPSolver::batch_solve: Feasible region empty.");
+    }
+    return std::map<Polynomial<Rational>, ILPResult>{};
+  }
+  return ret;
+}
+
+void ILPSolver::clear_memo() {
+  std::lock_guard<std::mutex> lock(memo_mu);
+  memo.clear();
 }
 
 std::map<Polynomial<Rational>, ILPResult> ILPSolver::batch_solve(Tableau* tableau,
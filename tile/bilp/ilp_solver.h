@@ -3,6 +3,7 @@
 #include <gtest/gtest_prod.h>
 
 #include <algorithm>
+#include <functional>
 #include <map>
 #include <string>
 #include <vector>
@@ -44,6 +45,9 @@ class ILPSolver {
 
   void set_throw_infeasible(bool b) { throw_infeasible = b; }
 
+  // Discards the memoized batch_solve results
+  static void clear_memo();
+
  private:
   FRIEND_TEST(BilpTest, BasicTableauTest);
   FRIEND_TEST(BilpTest, SimpleOptimizeTest);
@@ -55,6 +59,13 @@ class ILPSolver {
   std::vector<math::Rational> best_solution;
   std::vector<std::string> var_names_;
 
+  // Implements the constraint-vector versions of batch_solve: looks up the
+  // results memoized for the constraint set, solving the rest directly if every
+  // constraint bounds a single variable, and with make_tableau's tableau if not
+  std::map<math::Polynomial<math::Rational>, ILPResult> memoized_batch_solve(
+      const std::string& kind, const std::vector<math::SimpleConstraint>& bounds,
+      const std::vector<math::Polynomial<math::Rational>>& objectives, const std::function<Tableau()>& make_tableau);
+
   // Solves a tableau representing an ILP problem
   ILPResult solve(Tableau& tableau, bool already_canonical = false);  // NOLINT(runtime/references)
   // Reports the minimized value of the objective for last solved problem
@@ -1,6 +1,8 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
+
 #include "tile/bilp/ilp_solver.h"
 #include "tile/math/bignum.h"
 
@@ -178,6 +180,40 @@ TEST(BilpTest, Subdivision1D) {
   EXPECT_EQ(res[-Polynomial<Rational>("k_0")].obj_val, -2);
 }
 
+TEST(BilpTest, BoxConstraintsTest) {
+  ILPSolver::clear_memo();
+  std::vector<RangeConstraint> constraints;
+  constraints.emplace_back(Polynomial<Rational>("x") + 1, 4);
+  constraints.emplace_back(-2 * Polynomial<Rational>("y") + 3, 8);
+
+  std::vector<Polynomial<Rational>> objectives;
+  objectives.emplace_back(Polynomial<Rational>("x"));
+  objectives.emplace_back(-Polynomial<Rational>("x"));
+  objectives.emplace_back(Polynomial<Rational>("y"));
+  objectives.emplace_back(-3 * Polynomial<Rational>("y") + Polynomial<Rational>("x"));
+  ILPSolver solver;
+  auto res = solver.batch_solve(constraints, objectives);
+  Tableau t = makeStandardFormTableau(constraints);
+  auto expected = solver.batch_solve(&t, objectives);
+  for (const auto& obj : objectives) {
+    EXPECT_EQ(res[obj].obj_val, expected[obj].obj_val);
+  }
+  EXPECT_EQ(res[Polynomial<Rational>("x")].obj_val, -1);
+  EXPECT_EQ(res[-Polynomial<Rational>("x")].obj_val, -2);
+  EXPECT_EQ(res[Polynomial<Rational>("y")].obj_val, -2);
+
+  // Memoized results are returned for the same constraints in another order.
+  std::reverse(constraints.begin(), constraints.end());
+  auto again = solver.batch_solve(constraints, objectives);
+  for (const auto& obj : objectives) {
+    EXPECT_EQ(again[obj].obj_val, res[obj].obj_val);
+  }
+
+  constraints.emplace_back(Polynomial<Rational>("x") - 5, 2);
+  solver.set_throw_infeasible(false);
+  EXPECT_TRUE(solver.batch_solve(constraints, objectives).empty());
+}
+
 TEST(MilpTest, RandomConstraintsTest) {
   const int varSize = 8;
   for (size_t test_count = 0; test_count < 20; ++test_count) {
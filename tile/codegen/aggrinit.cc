@@ -1,7 +1,10 @@
 // Copyright 2018, Intel Corporation
 
+#include <algorithm>
 #include <memory>
 #include <set>
+#include <string>
+#include <tuple>
 #include <vector>
 
 #include "tile/codegen/aggrinit.h"
@@ -15,6 +18,24 @@ namespace codegen {
 using namespace stripe;  // NOLINT
 using namespace math;    // NOLINT
 
+// Traverse blocks
+void RunOnBlocksRecurse(stripe::Block* block, const stripe::Tags& reqs,
+                        const AggregationBlockOutputInitializationPass* aggregationPass) {
+  for (auto stmt_it = block->stmts.rbegin(); stmt_it != block->stmts.rend(); ++stmt_it) {
+    auto inner = stripe::Block::Downcast(*stmt_it);
+    if (inner) {
+      stripe::Block* const innerBlock = inner.get();
+      AggregationBlockOutputInitialization(innerBlock, aggregationPass);
+      AggregationBlockOutputInitializationState& state =
+          const_cast<AggregationBlockOutputInitializationState&>(aggregationPass->state);
+      stripe::Block* pBlock = state.prevBlock;
+      state.prevBlock = innerBlock;
+      RunOnBlocksRecurse(innerBlock, reqs, aggregationPass);
+      state.prevBlock = pBlock;
+    }
+  }
+}
+
 void AggregationBlockOutputInitialization(const stripe::Block* const block,
                                           const AggregationBlockOutputInitializationPass* aggregationPass) {
   if (block == nullptr) {
@@ -68,6 +89,94 @@ void AggregationBlockOutputInitialization(const stripe::Block* const block,
   }
 }
 
+// Whether each iteration of block writes its own tile of outer's view through ref, with the tiles exactly covering
+// that view: every iterating index must step along its own dimension by the tile size, with no gaps, overlaps or
+// overhang.  Initializing each tile inside the block is then equivalent to initializing the whole view outside it.
+static bool TilesOuterView(const Block& block, const Refinement& ref, const Refinement& outer) {
+  if (block.constraints.size() || ref.access.size() != outer.interior_shape.dims.size()) {
+    return false;
+  }
+  std::set<std::string> iterating;
+  for (const auto& idx : block.idxs) {
+    if (idx.range > 1 && idx.affine == Affine{}) {
+      iterating.insert(idx.name);
+    }
+  }
+  std::set<std::string> covered;
+  for (size_t i = 0; i < ref.access.size(); i++) {
+    uint64_t tile = ref.interior_shape.dims[i].size;
+    uint64_t extent = outer.interior_shape.dims[i].size;
+    std::string dim_idx;
+    for (const auto& [name, coeff] : ref.access[i].getMap()) {
+      if (name.empty() || !iterating.count(name)) {
+        if (coeff != 0) {
+          return false;
+        }
+      } else if (!dim_idx.empty() || coeff != static_cast<int64_t>(tile)) {
+        return false;
+      } else {
+        dim_idx = name;
+      }
+    }
+    uint64_t range = dim_idx.empty() ? 1 : block.idx_by_name(dim_idx)->range;
+    if (tile * range != extent) {
+      return false;
+    }
+    if (!dim_idx.empty()) {
+      covered.insert(dim_idx);
+    }
+  }
+  return covered == iterating;
+}
+
+// Moves the initialization of outer_ref (which precedes stmt in block) as far down into stmt's nested blocks as it
+// can go, so that each tile of the output is initialized right before it's reduced, while it's still in cache,
+// rather than in a separate sweep over the whole tensor.
+static std::tuple<Block*, const Refinement*, const Statement*> SinkToTile(Block* block, const Refinement* outer_ref,
+                                                                          const Statement* stmt) {
+  for (;;) {
+    auto inner = dynamic_cast<const Block*>(stmt);
+    if (!inner) {
+      break;
+    }
+    auto ref = std::find_if(inner->refs.begin(), inner->refs.end(), [&](const Refinement& ref) {
+      return ref.from == outer_ref->into() && IsWriteDir(ref.dir);
+    });
+    if (ref == inner->refs.end() || !TilesOuterView(*inner, *ref, *outer_ref)) {
+      break;
+    }
+    // The initialization can only be moved in front of the single statement which uses the tile.
+    const Statement* user = nullptr;
+    size_t users = 0;
+    for (const auto& inner_stmt : inner->stmts) {
+      bool uses = false;
+      if (auto sub = Block::Downcast(inner_stmt)) {
+        for (const auto& sub_ref : sub->refs) {
+          uses |= sub_ref.from == ref->into();
+        }
+      } else {
+        for (const auto& name : inner_stmt->buffer_reads()) {
+          uses |= name == ref->into();
+        }
+        for (const auto& name : inner_stmt->buffer_writes()) {
+          uses |= name == ref->into();
+        }
+      }
+      if (uses) {
+        user = inner_stmt.get();
+        users++;
+      }
+    }
+    if (users != 1) {
+      break;
+    }
+    block = const_cast<Block*>(inner);
+    outer_ref = &*ref;
+    stmt = user;
+  }
+  return std::make_tuple(block, outer_ref, stmt);
+}
+
 void AggregationBlockOutputInitializationPass::Apply(CompilerState* state) const {
   auto reqs = stripe::FromProto(options_.reqs());
   RunOnBlocksRecurse(state->entry(), reqs, this);
@@ -96,16 +205,20 @@ void AggregationBlockOutputInitializationPass::Apply(CompilerState* state) const
       default:
         throw std::runtime_error("Invalid Aggregation Initialization Type value.");
     }
+    auto [blockToAddTo, refToInitialize, statementToAddBefore] =
+        toInit.statementToAddBefore
+            ? SinkToTile(toInit.blockToAddTo, toInit.refToInitialize, toInit.statementToAddBefore)
+            : std::make_tuple(toInit.blockToAddTo, toInit.refToInitialize, toInit.statementToAddBefore);
     aggInit->name = aggInitName;
-    aggInit->outputs.emplace_back(toInit.refToInitialize->into());
-    if (toInit.statementToAddBefore == nullptr) {
-      toInit.blockToAddTo->stmts.emplace_front(aggInit);
+    aggInit->outputs.emplace_back(refToInitialize->into());
+    if (statementToAddBefore == nullptr) {
+      blockToAddTo->stmts.emplace_front(aggInit);
     } else {
-      // Insert the element before the toInit.statementToAddBefore element.
-      auto it = toInit.blockToAddTo->stmts.begin();
-      auto end = toInit.blockToAddTo->stmts.end();
+      // Insert the element before the statementToAddBefore element.
+      auto it = blockToAddTo->stmts.begin();
+      auto end = blockToAddTo->stmts.end();
       for (; it != end; ++it) {
-        if (it->get() == toInit.statementToAddBefore) {
+        if (it->get() == statementToAddBefore) {
           break;
         }
       }
@@ -114,7 +227,7 @@ void AggregationBlockOutputInitializationPass::Apply(CompilerState* state) const
         throw std::runtime_error("The toInit.statementToAddBefore must be in the list.");
       }
 
-      toInit.blockToAddTo->stmts.insert(it, aggInit);
+      blockToAddTo->stmts.insert(it, aggInit);
     }
   }
 
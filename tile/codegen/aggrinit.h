@@ -69,24 +69,6 @@ class AggregationBlockOutputInitializationPass final : public CompilePass {
   proto::AggregationBlockOutputInitializationPass options_;
 };
 
-// Traverse blocks
-void RunOnBlocksRecurse(stripe::Block* block, const stripe::Tags& reqs,
-                        const AggregationBlockOutputInitializationPass* aggregationPass) {
-  for (auto stmt_it = block->stmts.rbegin(); stmt_it != block->stmts.rend(); ++stmt_it) {
-    auto inner = stripe::Block::Downcast(*stmt_it);
-    if (inner) {
-      stripe::Block* const innerBlock = inner.get();
-      AggregationBlockOutputInitialization(innerBlock, aggregationPass);
-      AggregationBlockOutputInitializationState& state =
-          const_cast<AggregationBlockOutputInitializationState&>(aggregationPass->state);
-      stripe::Block* pBlock = state.prevBlock;
-      state.prevBlock = innerBlock;
-      RunOnBlocksRecurse(innerBlock, reqs, aggregationPass);
-      state.prevBlock = pBlock;
-    }
-  }
-}
-
 }  // namespace codegen
 }  // namespace tile
 }  // namespace vertexai
@@ -0,0 +1,87 @@
+// Copyright 2020, Intel Corporation
+
+#include "tile/codegen/analysis.h"
+
+#include <stdexcept>
+
+#include "base/util/throw.h"
+
+namespace vertexai {
+namespace tile {
+namespace codegen {
+
+struct AnalysisManager::Node {
+  std::unique_ptr<AliasMap> map;
+  std::unordered_map<const stripe::Block*, std::unique_ptr<Node>> children;
+  std::unordered_map<std::type_index, std::shared_ptr<void>> analyses;
+  Node* parent = nullptr;
+};
+
+AnalysisManager::AnalysisManager() = default;
+
+AnalysisManager::~AnalysisManager() = default;
+
+const AliasMap& AnalysisManager::RootAliasMap(stripe::Block* root) {
+  if (root_ && root_->map->this_block() != root) {
+    InvalidateAll();
+  }
+  if (!root_) {
+    root_ = std::make_unique<Node>();
+    root_->map = std::make_unique<AliasMap>(base_, root);
+    nodes_[root] = root_.get();
+  }
+  return *root_->map;
+}
+
+const AliasMap& AnalysisManager::InnerAliasMap(const AliasMap& outer, stripe::Block* block) {
+  auto outer_it = nodes_.find(outer.this_block());
+  if (outer_it == nodes_.end() || outer_it->second->map.get() != &outer) {
+    throw_with_trace(std::logic_error{"AnalysisManager: the outer AliasMap isn't cached"});
+  }
+  auto& node = outer_it->second->children[block];
+  if (!node) {
+    node = std::make_unique<Node>();
+    node->map = std::make_unique<AliasMap>(outer, block);
+    node->parent = outer_it->second;
+    nodes_[block] = node.get();
+  }
+  return *node->map;
+}
+
+std::unordered_map<std::type_index, std::shared_ptr<void>>& AnalysisManager::Analyses(const AliasMap& map) {
+  auto it = nodes_.find(map.this_block());
+  if (it == nodes_.end() || it->second->map.get() != &map) {
+    throw_with_trace(std::logic_error{"AnalysisManager: the AliasMap isn't cached"});
+  }
+  return it->second->analyses;
+}
+
+void AnalysisManager::Invalidate(stripe::Block* block) {
+  auto it = nodes_.find(block);
+  if (it == nodes_.end()) {
+    return;
+  }
+  auto node = it->second;
+  Forget(node);
+  if (node->parent) {
+    node->parent->children.erase(block);
+  } else {
+    root_.reset();
+  }
+}
+
+void AnalysisManager::InvalidateAll() {
+  nodes_.clear();
+  root_.reset();
+}
+
+void AnalysisManager::Forget(Node* node) {
+  nodes_.erase(node->map->this_block());
+  for (auto& kvp : node->children) {
+    Forget(kvp.second.get());
+  }
+}
+
+}  // namespace codegen
+}  // namespace tile
+}  // namespace vertexai
@@ -0,0 +1,89 @@
+// Copyright 2020, Intel Corporation
+
+#pragma once
+
+#include <memory>
+#include <typeindex>
+#include <unordered_map>
+
+#include "tile/codegen/alias.h"
+#include "tile/codegen/compile_pass.h"
+#include "tile/stripe/stripe.h"
+
+namespace vertexai {
+namespace tile {
+namespace codegen {
+
+// AnalysisManager caches analyses of a program's blocks across passes, so that a pass which leaves the program's
+// structure unchanged doesn't make the next pass reconstruct them.
+//
+// A block's AliasMap depends on every enclosing block's indexes and refinements, so analyses are cached along the
+// chain of blocks from the root.  They're valid only while those blocks are unchanged: the driver drops them after
+// each pass which doesn't report preserves_analyses(), and a pass which mutates a block while using cached analyses
+// must Invalidate that block itself.
+class AnalysisManager {
+ public:
+  AnalysisManager();
+  ~AnalysisManager();
+
+  // Returns the AliasMap of the root block.
+  const AliasMap& RootAliasMap(stripe::Block* root);
+
+  // Returns the AliasMap of block, a child of the block described by outer (which must itself be cached).
+  const AliasMap& InnerAliasMap(const AliasMap& outer, stripe::Block* block);
+
+  // Returns the analysis T of the block described by map (which must be cached), constructing it as T(map, block).
+  template <typename T>
+  T& Get(const AliasMap& map) {
+    auto& analysis = Analyses(map)[std::type_index(typeid(T))];
+    if (!analysis) {
+      analysis = std::make_shared<T>(map, map.this_block());
+    }
+    return *std::static_pointer_cast<T>(analysis);
+  }
+
+  // Drops the cached analyses of block and its descendants.
+  void Invalidate(stripe::Block* block);
+
+  // Drops every cached analysis.
+  void InvalidateAll();
+
+ private:
+  struct Node;
+
+  std::unordered_map<std::type_index, std::shared_ptr<void>>& Analyses(const AliasMap& map);
+  void Forget(Node* node);
+
+  AliasMap base_;
+  std::unique_ptr<Node> root_;
+  std::unordered_map<const stripe::Block*, Node*> nodes_;
+};
+
+template <typename F>
+void RunOnBlocksRecurse(AnalysisManager* analyses, const AliasMap& map, stripe::Block* block,
+                        const stripe::Tags& reqs, const F& func, bool rec_func) {
+  bool run_func = block->has_tags(reqs) || reqs.count("all") > 0;
+  if (run_func) {
+    func(map, block);
+  }
+  if (!run_func || rec_func) {
+    for (auto& stmt : block->stmts) {
+      auto inner = stripe::Block::Downcast(stmt);
+      if (inner) {
+        RunOnBlocksRecurse(analyses, analyses->InnerAliasMap(map, inner.get()), inner.get(), reqs, func, rec_func);
+      }
+    }
+  }
+}
+
+// Like RunOnBlocks, but with the AliasMaps cached by state's AnalysisManager.  func must not change the indexes or
+// refinements of the blocks it's given, unless it invalidates them.
+template <typename F>
+void RunOnBlocks(CompilerState* state, const stripe::Tags& reqs, const F& func, bool rec_func = false) {
+  auto root = state->entry();
+  RunOnBlocksRecurse(state->analyses.get(), state->analyses->RootAliasMap(root), root, reqs, func, rec_func);
+}
+
+}  // namespace codegen
+}  // namespace tile
+}  // namespace vertexai
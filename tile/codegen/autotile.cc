@@ -3,16 +3,27 @@
 #include "tile/codegen/autotile.h"
 
 #include <algorithm>
+#include <functional>
+#include <iomanip>
 #include <map>
+#include <mutex>
+#include <queue>
 #include <set>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
+
+#include <boost/filesystem.hpp>
 #include <boost/math/special_functions/prime.hpp>
 
+#include "base/util/env.h"
+#include "base/util/file.h"
 #include "base/util/logging.h"
 #include "base/util/stream_container.h"
 #include "base/util/throw.h"
+#include "tile/base/compile_pool.h"
 #include "tile/codegen/alias.h"
 #include "tile/codegen/tile.h"
 #include "tile/math/util.h"
@@ -26,25 +37,6 @@ using namespace stripe;  // NOLINT
 
 namespace {
 
-struct TileMetrics {
-  int64_t input_bytes = 0;
-  int64_t max_input_bytes = 0;
-  double input_bandwidth = 0;
-  int64_t output_bytes = 0;
-  int64_t max_output_bytes = 0;
-  double output_bandwidth = 0;
-  int64_t total_bytes = 0;
-  double total_bandwidth = 0;
-
-  bool IsValid(const proto::AutotilePass& options) const {
-    return !((options.max_output_size() && output_bytes > options.max_output_size()) ||
-             (options.max_per_output_size() && max_output_bytes > options.max_per_output_size()) ||
-             (options.max_input_size() && input_bytes > options.max_input_size()) ||
-             (options.max_per_input_size() && max_input_bytes > options.max_per_input_size()) ||
-             (options.max_total_size() && total_bytes > options.max_total_size()));
-  }
-};
-
 struct TileDimension {
   size_t size = 0;
   size_t count = 0;
@@ -132,12 +124,14 @@ TensorShape MakeOddTile(const TensorShape& tile) {
   TensorShape odd_tile = tile;
   for (size_t i = 0; i < odd_tile.dims.size(); ++i) {
     if ((odd_tile.dims[i].size & 0x1) == 0) {
-      ++odd_tile.dims[i].size;
+      odd_tile.dims.set_size(i, odd_tile.dims[i].size + 1);
     }
   }
   return odd_tile;
 }
 
+}  // namespace
+
 TileMetrics ComputeSizes(const std::map<std::string, size_t>& tile_by_name,  //
                          const Block& block,                                 //
                          const proto::AutotilePass& options) {
@@ -176,6 +170,8 @@ TileMetrics ComputeSizes(const std::map<std::string, size_t>& tile_by_name,  //
   return ret;
 }
 
+namespace {
+
 struct Cost {
   enum Outcome {
     Valid,    // A valid cost
@@ -310,24 +306,99 @@ struct ComputeDensityCostModel {
   }
 };
 
+// Returns the number of parts to partition into, resolving zero to one per core of the compiling host.
+size_t ResolveNumParts(const proto::PartitionComputePass& options) {
+  if (options.num_parts() > 0) {
+    return options.num_parts();
+  }
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Costs a partition by its makespan: the outer iterations of the tile are dealt to the parts, largest first, and the
+// most heavily loaded part's work is compared with an even share of the block's work.  Remainder tiles (where a
+// tile size doesn't divide its range) are smaller than full tiles, so a tiling which leaves some parts idle or gives
+// others an extra tile scores worse than one that balances.
 struct PartitionComputeCostModel {
+  // Each outer iteration costs this fraction of an even share, so that equally balanced tilings prefer fewer,
+  // larger parts.
+  static constexpr double kIterationOverhead = 1e-3;
+  // Tilings with more outer iterations than this are costed by a bound rather than by dealing out each iteration.
+  static constexpr size_t kMaxSimulatedCount = 4096;
+
   size_t num_parts;
   std::set<const Index*> acc_idxs;
-
-  PartitionComputeCostModel(const Block& block, const proto::PartitionComputePass& options)
-      : num_parts(options.num_parts()),  //
-        acc_idxs(block.accumulation_idxs()) {}
+  std::set<std::string> constrained_idxs;
+  double total_work;
+
+  PartitionComputeCostModel(const Block& block, size_t num_parts)
+      : num_parts(num_parts),  //
+        acc_idxs(block.accumulation_idxs()),
+        total_work(1) {
+    for (const auto& constraint : block.constraints) {
+      for (const auto& kvp : constraint.getMap()) {
+        if (!kvp.first.empty()) {
+          constrained_idxs.insert(kvp.first);
+        }
+      }
+    }
+    for (const auto& idx : block.idxs) {
+      total_work *= idx.range;
+    }
+  }
 
   bool IndexFilter(const Block& block, const Index& idx) const {  //
     return !acc_idxs.count(&idx);
   }
 
   Cost ComputeCost(const Block& block, const Tile& tile) const {
+    // The distinct tile works, with how many outer iterations have each.
+    std::vector<std::pair<double, size_t>> classes{{1.0, 1}};
+    bool splits_constrained = false;
+    for (size_t i = 0; i < tile.dims.size(); i++) {
+      const auto& dim = tile.dims[i];
+      auto remainder = block.idxs[i].range - (dim.count - 1) * dim.size;
+      std::vector<std::pair<double, size_t>> next;
+      for (const auto& cls : classes) {
+        if (dim.count > 1) {
+          next.emplace_back(cls.first * dim.size, cls.second * (dim.count - 1));
+        }
+        next.emplace_back(cls.first * remainder, cls.second);
+      }
+      classes.swap(next);
+      splits_constrained |= dim.count > 1 && constrained_idxs.count(block.idxs[i].name);
+    }
+    std::sort(classes.begin(), classes.end(), std::greater<std::pair<double, size_t>>());
     auto count = tile.counts_product();
-    if (count > num_parts) {
-      return (num_parts + 1) * (count - num_parts);
+    auto share = total_work / num_parts;
+    double makespan;
+    if (count <= num_parts) {
+      makespan = classes.front().first;
+    } else if (count > kMaxSimulatedCount) {
+      makespan = share + classes.front().first;  // Graham's bound for list scheduling
+    } else {
+      std::priority_queue<double, std::vector<double>, std::greater<double>> loads;
+      for (size_t part = 0; part < num_parts; part++) {
+        loads.push(0);
+      }
+      for (const auto& cls : classes) {
+        for (size_t n = 0; n < cls.second; n++) {
+          auto load = loads.top() + cls.first;
+          loads.pop();
+          loads.push(load);
+        }
+      }
+      while (loads.size() > 1) {
+        loads.pop();
+      }
+      makespan = loads.top();
     }
-    return num_parts - count;
+    double cost = makespan / share + kIterationOverhead * count;
+    // The work of a constrained index's iterations varies (e.g. at padded edges), so among otherwise equal tilings,
+    // prefer those which leave it whole.
+    if (splits_constrained) {
+      cost += kIterationOverhead / 2;
+    }
+    return cost;
   }
 };
 
@@ -337,15 +408,23 @@ struct TileResult {
 };
 
 struct TileSearchState {
+  explicit TileSearchState(size_t keep) : keep{keep} {}
+
+  size_t keep;
   std::set<Tile> found_tiles;
-  std::optional<TileResult> best_so_far;
+  std::vector<TileResult> best;  // The keep cheapest valid tiles found so far, in order of cost
   std::set<std::pair<double, Tile>> todo;
 
   void AddTile(const Tile& tile, Cost cost) {
     IVLOG(4, "    Found " << cost << ": " << tile);
     found_tiles.emplace(tile);
-    if (cost.outcome == Cost::Valid && (!best_so_far || cost.value < best_so_far->cost)) {
-      best_so_far = TileResult{tile, cost.value};
+    if (cost.outcome == Cost::Valid && (best.size() < keep || cost.value < best.back().cost)) {
+      auto it = std::upper_bound(best.begin(), best.end(), cost.value,
+                                 [](double value, const TileResult& result) { return value < result.cost; });
+      best.insert(it, TileResult{tile, cost.value});
+      if (best.size() > keep) {
+        best.pop_back();
+      }
     }
     if (cost.outcome != Cost::Stop) {
       todo.emplace(cost.outcome == Cost::Valid ? cost.value : 0, tile);
@@ -353,11 +432,12 @@ struct TileSearchState {
   }
 };
 
+// Returns up to keep of the cheapest valid tiles for the block, best first.
 template <typename CostModel>
-std::optional<TileResult> PickBestTile(const Block& block, bool only_po2, bool only_even, bool only_multiple_of_32,
-                                       bool is_fast, const CostModel& model) {
+std::vector<TileResult> PickBestTile(const Block& block, bool only_po2, bool only_even, bool only_multiple_of_32,
+                                     bool is_fast, const CostModel& model, size_t keep = 1) {
   IVLOG(3, "Autotile> PickBestTile> block: " << block.name);
-  TileSearchState state;
+  TileSearchState state(std::max(keep, size_t(1)));
   Tile tile(block, only_multiple_of_32 ? 32 : 1);
 
   for (size_t i = 0; i < block.idxs.size(); i++) {
@@ -407,20 +487,213 @@ std::optional<TileResult> PickBestTile(const Block& block, bool only_po2, bool o
       tile.dims[i] = prev;
     }
   }
-  return state.best_so_far;
+  return state.best;
+}
+
+// Finds up to keep of the best tilings for each of the blocks.  Distinct blocks
+// are searched concurrently; blocks with a signature already seen (in this
+// program, or in the memo) reuse the earlier result.  The memo only records
+// the best tiling, so it is not consulted when more than one is requested.
+std::vector<std::vector<TileResult>> SearchTilings(const std::vector<Block*>& blocks,
+                                                   const proto::AutotilePass& options, size_t keep) {
+  std::vector<std::vector<TileResult>> results(blocks.size());
+  auto memo = TileMemo::Instance();
+  auto cache_path = options.cache_path().empty() ? env::Get("PLAIDML_AUTOTILE_CACHE") : options.cache_path();
+  std::vector<std::string> signatures(blocks.size());
+  std::map<std::string, size_t> searched;
+  std::vector<size_t> todo;
+  std::vector<std::pair<size_t, size_t>> duplicates;
+  for (size_t i = 0; i < blocks.size(); i++) {
+    const auto& block = *blocks[i];
+    if (!options.memoize()) {
+      todo.push_back(i);
+      continue;
+    }
+    signatures[i] = BlockSignature(block, options);
+    auto it = searched.find(signatures[i]);
+    if (it != searched.end()) {
+      duplicates.emplace_back(i, it->second);
+      continue;
+    }
+    auto entry = keep > 1 ? std::nullopt : memo->Lookup(signatures[i], cache_path);
+    if (entry && (!entry->found || entry->sizes.size() == block.idxs.size())) {
+      IVLOG(3, "Autotile> block: " << block.name << " found in tile cache");
+      if (entry->found) {
+        Tile tile(block, 1);
+        for (size_t j = 0; j < block.idxs.size(); j++) {
+          tile.set(j, entry->sizes[j], block.idxs[j].range);
+        }
+        results[i].emplace_back(TileResult{tile, entry->cost});
+      }
+    } else {
+      todo.push_back(i);
+    }
+    searched.emplace(signatures[i], i);
+  }
+
+  CompileParallelFor(todo.size(), options.threads(), [&](size_t n) {
+    const auto& block = *blocks[todo[n]];
+    ComputeDensityCostModel model(block, options);
+    results[todo[n]] = PickBestTile(block, options.only_po2(), options.only_even(), options.only_multiple_of_32(),
+                                    options.fast(), model, keep);
+  });
+
+  if (options.memoize()) {
+    for (auto i : todo) {
+      TileMemoEntry entry;
+      if (!results[i].empty()) {
+        entry.found = true;
+        entry.sizes = results[i].front().tile.sizes();
+        entry.cost = results[i].front().cost;
+      }
+      memo->Insert(signatures[i], entry);
+    }
+    for (const auto& dup : duplicates) {
+      results[dup.first] = results[dup.second];
+    }
+    if (!cache_path.empty() && !todo.empty()) {
+      memo->Save(cache_path);
+    }
+  }
+  return results;
 }
 
 }  // namespace
 
+std::string BlockSignature(const Block& block, const proto::AutotilePass& options) {
+  auto cost_options = options;
+  cost_options.clear_threads();
+  cost_options.clear_memoize();
+  cost_options.clear_cache_path();
+  std::stringstream ss;
+  ss << cost_options.ShortDebugString();
+  // Indexes are named by position, as the memoized tile sizes are.
+  std::map<std::string, Affine> positions;
+  for (size_t i = 0; i < block.idxs.size(); i++) {
+    positions.emplace(block.idxs[i].name, Affine("#" + std::to_string(i)));
+  }
+  for (const auto& idx : block.idxs) {
+    ss << "|" << idx.range << ":" << idx.affine;
+  }
+  std::vector<std::string> refs;
+  for (const auto& ref : block.refs) {
+    std::vector<Affine> access;
+    for (const auto& aff : ref.access) {
+      access.emplace_back(aff.sym_eval(positions));
+    }
+    std::stringstream rs;
+    rs << static_cast<int>(ref.dir) << ":" << ref.location << ":" << ref.interior_shape.codec << ":"
+       << ref.interior_shape << ":" << StreamContainer(access);
+    refs.emplace_back(rs.str());
+  }
+  std::sort(refs.begin(), refs.end());
+  for (const auto& ref : refs) {
+    ss << "|" << ref;
+  }
+  return ss.str();
+}
+
+TileMemo* TileMemo::Instance() {
+  static TileMemo memo;
+  return &memo;
+}
+
+std::optional<TileMemoEntry> TileMemo::Lookup(const std::string& signature, const std::string& path) {
+  std::lock_guard<std::mutex> lock(mu_);
+  if (!path.empty() && loaded_.insert(path).second) {
+    Load(path);
+  }
+  auto it = entries_.find(signature);
+  if (it == entries_.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+void TileMemo::Insert(const std::string& signature, const TileMemoEntry& entry) {
+  std::lock_guard<std::mutex> lock(mu_);
+  entries_[signature] = entry;
+  dirty_ = true;
+}
+
+void TileMemo::Save(const std::string& path) {
+  std::lock_guard<std::mutex> lock(mu_);
+  if (!dirty_) {
+    return;
+  }
+  std::stringstream ss;
+  ss << std::setprecision(17);
+  ss << kFileHeader << "\t" << kFileVersion << "\n";
+  for (const auto& kvp : entries_) {
+    ss << kvp.first << "\t" << kvp.second.cost << "\t";
+    if (kvp.second.found) {
+      for (size_t i = 0; i < kvp.second.sizes.size(); i++) {
+        ss << (i ? "," : "") << kvp.second.sizes[i];
+      }
+    }
+    ss << "\n";
+  }
+  try {
+    WriteFileAtomic(path, ss.str());
+    dirty_ = false;
+  } catch (const std::exception& ex) {
+    LOG(WARNING) << "Autotile> unable to save tile cache " << path << ": " << ex.what();
+  }
+}
+
+void TileMemo::Load(const std::string& path) {
+  boost::system::error_code ec;
+  if (!boost::filesystem::is_regular_file(path, ec)) {
+    return;
+  }
+  std::stringstream file(ReadFile(path));
+  std::string line;
+  std::stringstream expected;
+  expected << kFileHeader << "\t" << kFileVersion;
+  if (!std::getline(file, line) || line != expected.str()) {
+    IVLOG(1, "Autotile> ignoring tile cache " << path << ", which is not version " << kFileVersion);
+    return;
+  }
+  size_t count = 0;
+  while (std::getline(file, line)) {
+    auto sig_end = line.find('\t');
+    auto cost_end = sig_end == std::string::npos ? sig_end : line.find('\t', sig_end + 1);
+    if (cost_end == std::string::npos) {
+      continue;
+    }
+    TileMemoEntry entry;
+    std::stringstream fields(line.substr(sig_end + 1));
+    fields >> entry.cost;
+    std::stringstream sizes(line.substr(cost_end + 1));
+    std::string size;
+    while (std::getline(sizes, size, ',')) {
+      entry.sizes.push_back(std::stoull(size));
+    }
+    entry.found = !entry.sizes.empty();
+    entries_.emplace(line.substr(0, sig_end), entry);
+    count++;
+  }
+  IVLOG(1, "Autotile> loaded " << count << " cached tilings from " << path);
+}
+
 void AutotilePass::Apply(CompilerState* state) const {
   auto reqs = FromProto(options_.reqs());
-  RunOnBlocks(state->entry(), reqs, [this](const AliasMap& map, Block* block) {
-    if (block->has_any_tags(FromProto(options_.exclude()))) {
-      return;
+  auto exclude = FromProto(options_.exclude());
+  std::vector<Block*> blocks;
+  RunOnBlocks(state->entry(), reqs, [&](const AliasMap& map, Block* block) {
+    if (!block->has_any_tags(exclude)) {
+      blocks.push_back(block);
+    }
+  });
+  auto results = SearchTilings(blocks, options_, state->tune_candidates);
+  for (size_t i = 0; i < blocks.size(); i++) {
+    auto block = blocks[i];
+    const auto& candidates = results[i];
+    state->tune_found = std::max(state->tune_found, candidates.size());
+    const TileResult* result = nullptr;
+    if (!candidates.empty()) {
+      result = &candidates[std::min(state->tune_rank, candidates.size() - 1)];
     }
-    ComputeDensityCostModel model(*block, options_);
-    auto result = PickBestTile(*block, options_.only_po2(), options_.only_even(), options_.only_multiple_of_32(),
-                               options_.fast(), model);
     if (result) {
       IVLOG(2, "Autotile> block: " << block->name << ", tile: " << result->tile << ", cost: " << result->cost);
       const TileShape& tiling_shape = options_.flip() ? result->tile.counts() : result->tile.sizes();
@@ -456,15 +729,26 @@ void AutotilePass::Apply(CompilerState* state) const {
       }
       LOG(WARNING) << "Autotile> block: " << block->name << " was NOT split; unable to find a valid tiling";
     }
-  });
+  }
 }
 
 void PartitionComputePass::Apply(CompilerState* state) const {
   auto reqs = FromProto(options_.reqs());
-  RunOnBlocks(state->entry(), reqs, [this](const AliasMap& map, Block* block) {
-    PartitionComputeCostModel model(*block, options_);
-    auto result = PickBestTile(*block, false, false, options_.only_multiple_of_32(), false, model);
-    if (result) {
+  auto num_parts = ResolveNumParts(options_);
+  RunOnBlocks(state->entry(), reqs, [this, num_parts](const AliasMap& map, Block* block) {
+    // Kernels too small to give each part min_part_work iterations get fewer parts.
+    auto parts = num_parts;
+    if (options_.min_part_work() > 0) {
+      parts = std::min<size_t>(parts, std::max<size_t>(1, block->idxs_product() / options_.min_part_work()));
+    }
+    if (parts <= 1) {
+      IVLOG(2, "PartitionCompute> block: " << block->name << " is too small to partition");
+      return;
+    }
+    PartitionComputeCostModel model(*block, parts);
+    auto results = PickBestTile(*block, false, false, options_.only_multiple_of_32(), false, model);
+    if (!results.empty()) {
+      const auto* result = &results.front();
       IVLOG(2, "PartitionCompute> block: " << block->name                 //
                                            << ", tile: " << result->tile  //
                                            << ", cost: " << result->cost);
@@ -2,13 +2,88 @@
 
 #pragma once
 
+#include <map>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+
 #include "tile/codegen/codegen.pb.h"
 #include "tile/codegen/compile_pass.h"
+#include "tile/stripe/stripe.h"
 
 namespace vertexai {
 namespace tile {
 namespace codegen {
 
+struct TileMetrics {
+  int64_t input_bytes = 0;
+  int64_t max_input_bytes = 0;
+  double input_bandwidth = 0;
+  int64_t output_bytes = 0;
+  int64_t max_output_bytes = 0;
+  double output_bandwidth = 0;
+  int64_t total_bytes = 0;
+  double total_bandwidth = 0;
+
+  bool IsValid(const proto::AutotilePass& options) const {
+    return !((options.max_output_size() && output_bytes > options.max_output_size()) ||
+             (options.max_per_output_size() && max_output_bytes > options.max_per_output_size()) ||
+             (options.max_input_size() && input_bytes > options.max_input_size()) ||
+             (options.max_per_input_size() && max_input_bytes > options.max_per_input_size()) ||
+             (options.max_total_size() && total_bytes > options.max_total_size()));
+  }
+};
+
+// Computes the footprint of each refinement of a block when its indexes are
+// tiled by tile_by_name; bandwidths are in cache lines of options.cache_width.
+TileMetrics ComputeSizes(const std::map<std::string, size_t>& tile_by_name,  //
+                         const stripe::Block& block,                         //
+                         const proto::AutotilePass& options);
+
+// Everything the autotile cost model can observe about a block: the index
+// ranges, the shapes and accesses of the refinements, and the pass options.
+// Block and refinement names are left out, and indexes are named by position,
+// so that identical layers share a signature.
+std::string BlockSignature(const stripe::Block& block, const proto::AutotilePass& options);
+
+struct TileMemoEntry {
+  bool found = false;
+  TileShape sizes;
+  double cost = 0;
+};
+
+// A record of autotile results, keyed by BlockSignature.  Entries may be
+// loaded from and saved to a file, so that results survive across compiles.
+// The file starts with a header line naming its version; files of any other
+// version are ignored.  Each following line holds the tab-separated signature,
+// cost, and comma-separated tile sizes; unusable blocks have no sizes.
+class TileMemo {
+ public:
+  static constexpr const char* kFileHeader = "plaidml-autotile-memo";
+  // Bump whenever BlockSignature or the line format changes.
+  static constexpr int kFileVersion = 1;
+
+  // The process-wide memo used by AutotilePass.
+  static TileMemo* Instance();
+
+  // Returns the entry for the signature, first loading the file at path
+  // (unless empty) if this memo hasn't yet.
+  std::optional<TileMemoEntry> Lookup(const std::string& signature, const std::string& path);
+  void Insert(const std::string& signature, const TileMemoEntry& entry);
+  // Writes every entry to the file at path, if any were inserted since the
+  // last save.
+  void Save(const std::string& path);
+
+ private:
+  void Load(const std::string& path);
+
+  std::mutex mu_;
+  std::map<std::string, TileMemoEntry> entries_;
+  std::set<std::string> loaded_;
+  bool dirty_ = false;
+};
+
 class AutotilePass final : public CompilePass {
  public:
   explicit AutotilePass(const proto::AutotilePass& options) : options_{options} {}
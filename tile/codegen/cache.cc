@@ -4,9 +4,14 @@
 #include "tile/codegen/idx_order.h"
 
 #include <algorithm>
+#include <map>
+#include <numeric>
+#include <set>
+#include <vector>
 
 #include <boost/format.hpp>
 
+#include "base/util/logging.h"
 #include "base/util/stream_container.h"
 #include "tile/codegen/localize.h"
 #include "tile/stripe/stripe.h"
@@ -45,6 +50,39 @@ size_t NextOdd(size_t n) {
   return (n & 0x1) ? n : (n + 1);
 }
 
+// Lay out a cache of the given sizes densely, except that the stride of each
+// dimension marked in padded is grown until, measured in banks, it is coprime
+// with bank_count.  Walking such a dimension then visits every bank before
+// revisiting one, so transposed accesses don't serialize on a single bank.
+TensorShape BankPaddedShape(DataType type,                     //
+                            const std::vector<size_t>& sizes,  //
+                            const std::vector<bool>& padded,   //
+                            size_t bank_count,                 //
+                            size_t bank_width) {
+  TensorShape shape = SimpleShape(type, sizes);
+  size_t elem_bytes = byte_width(type);
+  if (bank_count <= 1 || !bank_width || !elem_bytes) {
+    return shape;
+  }
+  // Pad by whole banks when elements are smaller than a bank
+  size_t pad = std::max<size_t>(1, bank_width / elem_bytes);
+  int64_t stride = 1;
+  for (int i = sizes.size() - 1; i >= 0; i--) {
+    if (padded[i] && sizes[i] > 1 && stride > 1) {
+      for (size_t tries = 0; tries < bank_count; tries++) {
+        size_t bytes = stride * elem_bytes;
+        if (bytes % bank_width || std::gcd(bytes / bank_width, bank_count) == 1) {
+          break;
+        }
+        stride += pad;
+      }
+    }
+    shape.dims.set_stride(i, stride);
+    stride *= sizes[i];
+  }
+  return shape;
+}
+
 // Test if outer contains inner
 bool ContainBlock(Block* outer, Block* inner) {
   if (outer == inner) {
@@ -130,7 +168,9 @@ void ApplyCache(const AliasMap& alias_map,    //
                 bool add_constraints,         //
                 bool reorder_idx,             //
                 bool odd_size,                //
-                double odd_limit) {
+                double odd_limit,             //
+                size_t bank_count,            //
+                size_t bank_width) {
 
   auto ref_it = ref_block->ref_by_from(var_name, false);
   if (ref_it == ref_block->refs.end()) {
@@ -285,10 +325,16 @@ void ApplyCache(const AliasMap& alias_map,    //
     }
   }
   
-  TensorShape cached_exterior_ts = SimpleShape(outer_ref_it->interior_shape.type, local_sizes);
+  // Only the dimensions the reference block walks can conflict
+  std::vector<bool> walked;
+  for (const auto& aff : local_access) {
+    walked.push_back(!aff.isConstant());
+  }
+  TensorShape cached_exterior_ts =
+      BankPaddedShape(outer_ref_it->interior_shape.type, local_sizes, walked, bank_count, bank_width);
   TensorShape cached_interior_ts = cached_exterior_ts;
-  for (auto& dim : cached_interior_ts.dims) {
-    dim.size = 1;
+  for (size_t i = 0; i < cached_interior_ts.dims.size(); i++) {
+    cached_interior_ts.dims.set_size(i, 1);
   }
 
   // Build the local/global refs for the cache block
@@ -457,7 +503,9 @@ void ApplySimpleCache(const AliasMap& map,          //
                       bool add_constraints,         //
                       bool reorder_idx,             //
                       bool odd_size,                //
-                      double odd_limit) {
+                      double odd_limit,             //
+                      size_t bank_count,            //
+                      size_t bank_width) {
   auto it = block->ref_by_into(var_name, false);
   if (it == block->refs.end()) {
     throw std::runtime_error("ApplySimpleCache: Invalid var_name");
@@ -472,7 +520,9 @@ void ApplySimpleCache(const AliasMap& map,          //
       sizes[i] = NextOdd(sizes[i]);
     }
   }
-  TensorShape cached_ts = SimpleShape(raw_ts.type, sizes);
+  // Without a reference block, any dimension may be walked
+  TensorShape cached_ts = BankPaddedShape(raw_ts.type, sizes, std::vector<bool>(sizes.size(), true), bank_count,
+                                          bank_width);
   // Make a new name for the raw variable
   std::string raw_name = block->unique_ref_name(var_name + "_raw");
   // Replace the old refinement to rename it.
@@ -500,8 +550,8 @@ void ApplySimpleCache(const AliasMap& map,          //
   TensorShape raw_xfer_shape = raw_ts;
   TensorShape cached_xfer_shape = cached_ts;
   for (size_t i = 0; i < sizes.size(); i++) {
-    raw_xfer_shape.dims[i].size = 1;
-    cached_xfer_shape.dims[i].size = 1;
+    raw_xfer_shape.dims.set_size(i, 1);
+    cached_xfer_shape.dims.set_size(i, 1);
   }
   xfer_block.refs.emplace(Refinement{
       RefDir::In,         // dir
@@ -590,6 +640,124 @@ static Block* LookupRefBlock(Block* block, const std::string& ref_tag) {
   return nullptr;
 }
 
+static bool UsesIndex(const std::vector<Affine>& affines, const std::string& idx) {
+  for (const auto& aff : affines) {
+    if (aff.getMap().count(idx)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Picks the loop index to double buffer over: the last even-ranged index of
+// the block which selects the tile read by one of its cache loads.
+static std::string DoubleBufferIndex(const Block& block) {
+  std::set<std::string> raw_names;
+  for (const auto& stmt : block.stmts) {
+    auto sub = Block::Downcast(stmt);
+    if (sub && sub->has_tag("cache_load")) {
+      for (const auto& ref : sub->refs) {
+        if (IsReadDir(ref.dir)) {
+          raw_names.insert(ref.from);
+        }
+      }
+    }
+  }
+  std::string result;
+  for (const auto& idx : block.idxs) {
+    if (idx.range < 2 || idx.range % 2 || idx.affine != Affine() || UsesIndex(block.constraints, idx.name)) {
+      continue;
+    }
+    for (const auto& name : raw_names) {
+      auto it = block.ref_by_into(name, false);
+      if (it != block.refs.end() && UsesIndex(it->access, idx.name)) {
+        result = idx.name;
+        break;
+      }
+    }
+  }
+  return result;
+}
+
+// Double buffers a block whose cache loads are selected by the loop index
+// idx: each iteration now covers two consecutive tiles, each with its own
+// copy of the block's local buffers, and the loads of the second tile are
+// issued ahead of the compute of the first, so that the two may overlap.
+void ApplyDoubleBuffer(Block* block, const std::string& idx_name) {
+  std::string name = idx_name.empty() ? DoubleBufferIndex(*block) : idx_name;
+  auto idx = block->idx_by_name(name);
+  if (!idx || idx->range < 2 || idx->range % 2 || idx->affine != Affine() ||
+      UsesIndex(block->constraints, name)) {
+    IVLOG(2, "Cannot double buffer " << block->name << " over index '" << name << "'");
+    return;
+  }
+  for (const auto& stmt : block->stmts) {
+    if (stmt->kind() != StmtKind::Block) {
+      IVLOG(2, "Cannot double buffer " << block->name << ": it has statements which are not blocks");
+      return;
+    }
+  }
+  idx->range /= 2;
+  // Each tile's affines substitute for the index alone, leaving the other indexes as they are.
+  Affine phase0 = Affine(name, 2);
+  Affine phase1 = Affine(name, 2) + 1;
+  // Give the second tile its own views of the parent buffers that depend on
+  // the index, and its own copy of each local buffer.
+  std::map<std::string, std::string> rename;
+  std::vector<Refinement> second_refs;
+  for (auto& ref : block->refs) {
+    bool uses_idx = UsesIndex(ref.access, name);
+    if (ref.dir != RefDir::None && !uses_idx) {
+      continue;
+    }
+    auto second = ref.WithInto(block->unique_ref_name(ref.into() + "_1"));
+    for (size_t i = 0; i < ref.access.size(); i++) {
+      ref.mut().access[i].substitute(name, phase0);
+      second.access[i].substitute(name, phase1);
+    }
+    rename[ref.into()] = second.into();
+    second_refs.emplace_back(std::move(second));
+  }
+  for (auto& ref : second_refs) {
+    block->refs.emplace(std::move(ref));
+  }
+  auto rewrite = [&](Block* sub, const Affine& phase, bool second) {
+    for (auto& sub_idx : sub->idxs) {
+      sub_idx.affine.substitute(name, phase);
+    }
+    if (second) {
+      for (auto& ref : sub->refs) {
+        auto it = rename.find(ref.from);
+        if (it != rename.end()) {
+          ref.mut().from = it->second;
+        }
+      }
+    }
+  };
+  StatementList loads;
+  StatementList computes;
+  StatementList second_loads;
+  StatementList second_computes;
+  for (const auto& stmt : block->stmts) {
+    auto sub = Block::Downcast(stmt);
+    auto copy = CloneBlock(*sub);
+    rewrite(sub.get(), phase0, false);
+    rewrite(copy.get(), phase1, true);
+    copy->name = sub->name + "_1";
+    sub->deps.clear();
+    copy->deps.clear();
+    bool is_load = sub->has_tag("cache_load");
+    (is_load ? loads : computes).push_back(sub);
+    (is_load ? second_loads : second_computes).push_back(copy);
+  }
+  block->stmts.clear();
+  block->stmts.splice(block->stmts.end(), loads);
+  block->stmts.splice(block->stmts.end(), second_loads);
+  block->stmts.splice(block->stmts.end(), computes);
+  block->stmts.splice(block->stmts.end(), second_computes);
+  block->add_tags({"double_buffered"});
+}
+
 static void CacheBlock(const AliasMap& map, Block* block, const proto::CachePass& options) {
   std::set<RefDir> dirs;
   for (const auto& dir : options.dirs()) {
@@ -627,7 +795,8 @@ static void CacheBlock(const AliasMap& map, Block* block, const proto::CachePass
       if (dirs.count(ref.dir)) {
         codegen::ApplyCache(map, inout, ref_block, block, ref.into(), mem_loc, xfer_loc, 
           {"cache", "cache_load"}, {"cache", "cache_store"}, options.add_constraints(),
-          options.reorder_idx(), options.odd_size(), options.odd_limit());
+          options.reorder_idx(), options.odd_size(), options.odd_limit(), options.bank_count(),
+          options.bank_width());
       }
     }
   }
@@ -638,10 +807,17 @@ static void CacheBlock(const AliasMap& map, Block* block, const proto::CachePass
       if (dirs.count(ref.dir)) {
         codegen::ApplySimpleCache(map, inout, block, ref.into(), mem_loc, xfer_loc,
           {"cache", "cache_load"}, {"cache", "cache_store"}, options.add_constraints(),
-          options.reorder_idx(), options.odd_size());
+          options.reorder_idx(), options.odd_size(), options.odd_limit(), options.bank_count(),
+          options.bank_width());
       }
     }
   }
+  if (options.double_buffer()) {
+    if (inout != RefDir::In) {
+      throw std::runtime_error("Double buffering is only supported for input caches.");
+    }
+    ApplyDoubleBuffer(block, options.double_buffer_idx());
+  }
 }
 
 void CachePass::Apply(CompilerState* state) const {
@@ -25,7 +25,9 @@ void ApplyCache(const AliasMap& map,                                       //
                 bool add_constraints = true,                               //
                 bool reorder_idx = true,                                   //
                 bool odd_size = false,                                     //
-                double odd_limit = 2.0);
+                double odd_limit = 2.0,                                    //
+                size_t bank_count = 0,                                     //
+                size_t bank_width = 4);
 
 void ApplySimpleCache(const AliasMap& map,                                       //
                       stripe::RefDir dir,                                        //
@@ -38,7 +40,15 @@ void ApplySimpleCache(const AliasMap& map,
                       bool add_constraints = true,                               //
                       bool reorder_idx = true,                                   //
                       bool odd_size = false,                                     //
-                      double odd_limit = 2.0);
+                      double odd_limit = 2.0,                                    //
+                      size_t bank_count = 0,                                     //
+                      size_t bank_width = 4);
+
+// Splits each iteration of a cached block over idx_name into two tiles with
+// alternating local buffers, issuing the loads of the second ahead of the
+// compute of the first.  Picks the index selecting the tile of a cache load if
+// idx_name is empty; blocks which cannot be split are left unchanged.
+void ApplyDoubleBuffer(stripe::Block* block, const std::string& idx_name = "");
 
 class CachePass final : public CompilePass {
  public:
@@ -2,6 +2,11 @@
 
 #include "tile/codegen/codec.h"
 
+#include <algorithm>
+#include <map>
+#include <numeric>
+#include <vector>
+
 #include "tile/codegen/alias.h"
 
 namespace vertexai {
@@ -12,6 +17,19 @@ using namespace stripe;  // NOLINT
 
 namespace {
 
+// A blocked buffer splits one dimension into (blocks, block), with the block innermost, so that a block is a
+// unit-stride, full-width vector.  The tail block is padded, and the padding is part of the shape.
+struct BlockedCodec : Codec {
+  explicit BlockedCodec(const TensorShape* shape) : Codec(shape) {}
+  int64_t byte_size() const final { return shape_->byte_size(); }
+  std::optional<size_t> sparse_dim() const final { return std::nullopt; }
+};
+
+const std::map<std::string, int64_t> kBlockedCodecs = {
+    {"blocked8", 8},
+    {"blocked16", 16},
+};
+
 void AssignCodec(Block* block, const Tags& datatypes, const std::string& codec) {
   IVLOG(2, "  block: " << block->name);
   for (auto& ref : block->refs) {
@@ -29,17 +47,203 @@ void AssignCodec(Block* block, const Tags& datatypes, const std::string& codec)
   }
 }
 
+int64_t FloorDiv(int64_t num, int64_t den) { return num / den - (num % den < 0 ? 1 : 0); }
+
+// A refinement of a blocked buffer, with its access in the blocked dimension split into the block and the position
+// within the block.
+struct BlockedRef {
+  Refinement* ref;
+  Affine outer;
+  Affine inner;
+};
+
+// Blocks the allocations of a program.  A buffer is blocked only if every access to it splits: each affine access in
+// the blocked dimension must be a multiple of the block size plus a part that stays within one block.  Accesses only
+// split once the dimension has been tiled by the block size, so that the innermost blocks sweep single blocks.
+class Blocker {
+ public:
+  Blocker(const Tags& datatypes, const std::string& codec, int64_t block_size, int block_dim)
+      : datatypes_{datatypes}, codec_{codec}, block_size_{block_size}, block_dim_{block_dim} {}
+
+  void Apply(Block* block) {
+    for (auto& ref : block->refs) {
+      size_t dim;
+      if (IsCandidate(ref, &dim)) {
+        Relayout(block, &ref.mut(), dim);
+      }
+    }
+    for (auto stmt : block->stmts) {
+      auto inner = Block::Downcast(stmt);
+      if (inner) {
+        Apply(inner.get());
+      }
+    }
+  }
+
+ private:
+  bool IsCandidate(const Refinement& ref, size_t* dim) const {
+    const auto& shape = ref.interior_shape;
+    if (!ref.from.empty() || ref.dir != RefDir::None || ref.has_tag("user") || shape.is_const) {
+      return false;
+    }
+    if (!datatypes_.count(to_string(shape.type))) {
+      return false;
+    }
+    int rank = shape.dims.size();
+    int block_dim = block_dim_ < 0 ? rank + block_dim_ : block_dim_;
+    if (block_dim < 0 || block_dim >= rank) {
+      return false;
+    }
+    *dim = block_dim;
+    const auto& blocked = shape.dims[block_dim];
+    // A unit-stride dimension is already vectorizable; blocking it would only add padding.
+    return blocked.stride != 1 && static_cast<int64_t>(blocked.size) >= block_size_;
+  }
+
+  // Splits an access in the blocked dimension, widening [lo, hi] by the range of its position within the block.
+  bool Split(const Block& block, const Affine& access, BlockedRef* split, int64_t* lo, int64_t* hi) const {
+    for (const auto& kvp : access.getMap()) {
+      if (kvp.first.empty()) {
+        auto outer = FloorDiv(kvp.second, block_size_);
+        split->outer += outer;
+        split->inner += kvp.second - outer * block_size_;
+        *lo += kvp.second - outer * block_size_;
+        *hi += kvp.second - outer * block_size_;
+      } else if (kvp.second % block_size_ == 0) {
+        split->outer += Affine(kvp.first, kvp.second / block_size_);
+      } else {
+        auto idx = block.idx_by_name(kvp.first);
+        if (!idx || idx->affine != Affine{}) {
+          return false;
+        }
+        split->inner += Affine(kvp.first, kvp.second);
+        auto extent = kvp.second * static_cast<int64_t>(idx->range - 1);
+        *(extent < 0 ? lo : hi) += extent;
+      }
+    }
+    return true;
+  }
+
+  // Collects the refinements which descend from parent, whose position within the block spans [lo, hi].
+  bool Collect(Block* block, const Refinement& parent, size_t dim, int64_t lo, int64_t hi,
+               std::vector<BlockedRef>* refs) const {
+    for (const auto& stmt : block->stmts) {
+      auto special = Special::Downcast(stmt);
+      if (special && special->name != "zero") {
+        for (const auto& name : special->inputs) {
+          if (name == parent.into()) {
+            return false;
+          }
+        }
+        for (const auto& name : special->outputs) {
+          if (name == parent.into()) {
+            return false;
+          }
+        }
+      }
+      auto inner = Block::Downcast(stmt);
+      if (!inner) {
+        continue;
+      }
+      for (auto& ref : inner->refs) {
+        if (ref.from != parent.into()) {
+          continue;
+        }
+        if (ref.bank_dim || ref.cache_unit || ref.access.size() <= dim) {
+          return false;
+        }
+        BlockedRef split{&ref.mut()};
+        auto ref_lo = lo;
+        auto ref_hi = hi;
+        if (!Split(*inner, ref.access[dim], &split, &ref_lo, &ref_hi)) {
+          return false;
+        }
+        // A refinement either views whole blocks, or a single element within one.
+        auto size = static_cast<int64_t>(ref.interior_shape.dims[dim].size);
+        if (size == 1 ? (ref_lo < 0 || ref_hi >= block_size_)
+                      : (ref_lo != 0 || ref_hi != 0 || size % block_size_ != 0)) {
+          return false;
+        }
+        refs->push_back(split);
+        if (!Collect(inner.get(), ref, dim, ref_lo, ref_hi, refs)) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  void Relayout(Block* block, Refinement* alloc, size_t dim) const {
+    std::vector<BlockedRef> refs;
+    if (!Collect(block, *alloc, dim, 0, 0, &refs)) {
+      IVLOG(2, "  Skipping " << alloc->into() << ": its accesses don't split into blocks");
+      return;
+    }
+    IVLOG(2, "  Blocking " << alloc->into() << " by " << block_size_ << " in dimension " << dim);
+
+    // The blocks take the place of the dimension in the buffer's existing layout, and the block goes innermost.
+    auto& dims = alloc->interior_shape.dims;
+    std::vector<size_t> order(dims.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return dims[a].stride > dims[b].stride; });
+    auto blocks = (static_cast<int64_t>(dims[dim].size) + block_size_ - 1) / block_size_;
+    std::vector<int64_t> strides(dims.size());
+    int64_t stride = block_size_;
+    for (auto it = order.rbegin(); it != order.rend(); ++it) {
+      strides[*it] = stride;
+      stride *= *it == dim ? blocks : static_cast<int64_t>(dims[*it].size);
+    }
+
+    auto rewrite = [&](Refinement* ref, uint64_t outer_size, uint64_t inner_size, const Affine& outer,
+                       const Affine& inner) {
+      auto& ref_dims = ref->interior_shape.dims;
+      for (size_t i = 0; i < ref_dims.size(); i++) {
+        ref_dims.set_stride(i, strides[i]);
+      }
+      ref_dims.set_size(dim, outer_size);
+      ref_dims.insert(ref_dims.begin() + dim + 1, TensorDimension{1, inner_size});
+      if (ref->access.size() > dim) {
+        ref->access[dim] = outer;
+        ref->access.insert(ref->access.begin() + dim + 1, inner);
+      }
+      ref->interior_shape.codec = codec_;
+    };
+    rewrite(alloc, blocks, block_size_, Affine{}, Affine{});
+    for (auto& split : refs) {
+      auto size = split.ref->interior_shape.dims[dim].size;
+      if (size == 1) {
+        rewrite(split.ref, 1, 1, split.outer, split.inner);
+      } else {
+        rewrite(split.ref, size / block_size_, block_size_, split.outer, split.inner);
+      }
+    }
+  }
+
+  const Tags& datatypes_;
+  std::string codec_;
+  int64_t block_size_;
+  int block_dim_;
+};
+
 }  // namespace
 
 void AssignCodecPass::Apply(CompilerState* state) const {
   auto datatypes = FromProto(options_.datatypes());
   IVLOG(2, "AssignCodecPass> codec: " << options_.codec());
+  auto blocked = kBlockedCodecs.find(options_.codec());
+  if (blocked != kBlockedCodecs.end()) {
+    Blocker{datatypes, blocked->first, blocked->second, options_.block_dim()}.Apply(state->entry());
+    return;
+  }
   AssignCodec(state->entry(), datatypes, options_.codec());
 }
 
 namespace {
 [[gnu::unused]] char reg = []() -> char {
   CompilePassFactory<AssignCodecPass, proto::AssignCodecPass>::Register();
+  for (const auto& kvp : kBlockedCodecs) {
+    Codec::Register(kvp.first, [](auto shape) { return std::make_unique<BlockedCodec>(shape); });
+  }
   return 0;
 }();
 }  // namespace
@@ -14,6 +14,7 @@ namespace tile {
 namespace codegen {
 
 struct MLIRState;
+class AnalysisManager;
 
 struct CompilerState {
   explicit CompilerState(std::shared_ptr<stripe::Program> prog);
@@ -22,6 +23,15 @@ struct CompilerState {
   std::unique_ptr<MLIRState> mlir;
   std::shared_ptr<stripe::Program> prog;
   ConstBufferManager* const_bufs;
+  // Analyses of prog's blocks, cached across passes which preserve them.
+  std::unique_ptr<AnalysisManager> analyses;
+
+  // Empirical tuning: AutotilePass keeps up to tune_candidates tilings for
+  // each block, applies the one at tune_rank (in order of estimated cost), and
+  // records the largest number of candidates it found for any block.
+  size_t tune_candidates = 1;
+  size_t tune_rank = 0;
+  size_t tune_found = 0;
 
   stripe::Block* entry() { return prog->entry.get(); }
 };
@@ -32,6 +42,9 @@ class CompilePass {
  public:
   virtual ~CompilePass() {}
   virtual bool is_stripe() const { return true; }
+  // Whether Apply leaves every block's indexes, refinements, and statements in place, so that the analyses cached
+  // by CompilerState::analyses remain valid.
+  virtual bool preserves_analyses() const { return false; }
   virtual void Apply(CompilerState* root) const = 0;
 };
 
@@ -106,6 +106,7 @@ void ConstantPropagatePass::Apply(CompilerState* state) const {
   std::map<std::string, void*> buffers;
   context::Context ctx;
   for (const auto& name : all_const) {
+    state->const_bufs->Wait(name);
     std::shared_ptr<tile::Buffer> buf = state->const_bufs->buffers.at(name);
     std::unique_ptr<tile::View> view;
     if (in_const.count(name)) {
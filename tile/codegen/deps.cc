@@ -3,15 +3,18 @@
 #include "tile/codegen/deps.h"
 
 #include <algorithm>
+#include <functional>
 #include <set>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include <boost/format.hpp>
 
 #include "base/util/throw.h"
+#include "tile/codegen/analysis.h"
 #include "tile/stripe/stripe.h"
 
 namespace vertexai {
@@ -22,15 +25,32 @@ using namespace stripe;  // NOLINT
 
 namespace {
 
+// Whether every element a refinement accesses is also accessed by a refinement with the same access.
+bool CoversExact(const AliasInfo& outer, const AliasInfo& inner) {
+  if (outer.shape.dims.size() != inner.shape.dims.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < outer.shape.dims.size(); i++) {
+    if (outer.shape.dims[i].size < inner.shape.dims[i].size) {
+      return false;
+    }
+  }
+  return true;
+}
+
 struct Tracker {
   // Tracks the state of a buffer as it's operated on by the Block's Statements.
   struct BufferInfo {
     // Keep track of a list of all currently active writers.
-    // TODO: remove writers from the list when all written memory has been overwritten by subsequent writers.
     std::unordered_map<StatementIt, AliasInfo> writers;
     std::unordered_set<StatementIt> readers;
   };
 
+  // Whether to stop tracking writers once a later writer (which depends on them) has overwritten all of their memory.
+  // Every later access to that memory depends on the later writer, so this drops only transitively implied
+  // dependencies, and keeps the writer lists short when a buffer is written repeatedly.
+  bool prune_overwritten = false;
+
   // For each scalar: the Statement that wrote the scalar.
   std::unordered_map<std::string, StatementIt> scalars;
 
@@ -65,15 +85,21 @@ struct Tracker {
     const AliasInfo& alias_info = alias_map.at(name);
     BufferInfo& buffer_info = buffers[alias_info.base_name];
 
-    for (const auto& item : buffer_info.writers) {
-      const auto& writer = item.first;
-      if (writer != it && AliasInfo::Compare(alias_info, item.second) != AliasType::None) {
+    for (auto item = buffer_info.writers.begin(); item != buffer_info.writers.end();) {
+      const auto& writer = item->first;
+      auto alias_type = writer == it ? AliasType::None : AliasInfo::Compare(alias_info, item->second);
+      if (alias_type != AliasType::None) {
         IVLOG(4, boost::format("      other writer: %1%") % *writer);
         // For two zero blocks, the order does not matter
         if (!ZeroBlock(*it) || !ZeroBlock(*writer)) {
           dataflow_deps.insert(writer);
+          if (prune_overwritten && alias_type == AliasType::Exact && CoversExact(alias_info, item->second)) {
+            item = buffer_info.writers.erase(item);
+            continue;
+          }
         }
       }
+      ++item;
     }
 
     for (StatementIt reader : buffer_info.readers) {
@@ -199,34 +225,74 @@ void ComputeDataflowDepsForBlock(stripe::Block* block, const AliasMap& alias_map
   }
 }
 
-void ComputeDepsForBlock(Block* block, const AliasMap& alias_map) {
-  IVLOG(3, "ComputeDeps> " << block->name);
+namespace {
+
+// The transitive dependencies of each of a block's statements, as bitsets over statement positions.
+class Closures {
+ public:
+  explicit Closures(size_t count) : words_{(count + 63) / 64}, bits_(count * words_) {}
+
+  bool Test(size_t pos, size_t dep) const { return bits_[pos * words_ + dep / 64] & (uint64_t{1} << (dep % 64)); }
+
+  // Adds dep, and everything dep depends on, to pos's closure.
+  void Add(size_t pos, size_t dep) {
+    auto into = bits_.begin() + pos * words_;
+    auto from = bits_.begin() + dep * words_;
+    // dep precedes pos, so its closure has no bits beyond its own position.
+    for (size_t word = 0; word <= dep / 64; word++) {
+      into[word] |= from[word];
+    }
+    into[dep / 64] |= uint64_t{1} << (dep % 64);
+  }
+
+ private:
+  size_t words_;
+  std::vector<uint64_t> bits_;
+};
+
+void ComputeDeps(Block* block, const AliasMap& alias_map, StatementIt first) {
   Tracker tracker;
-  std::unordered_map<StatementIt, std::set<StatementIt>> transitive_deps;
+  tracker.prune_overwritten = true;
+  std::vector<StatementIt> stmts;
+  std::unordered_map<StatementIt, size_t> positions;
   for (auto it = block->stmts.begin(); it != block->stmts.end(); it++) {
+    positions.emplace(it, stmts.size());
+    stmts.push_back(it);
+  }
+  Closures closures{stmts.size()};
+  bool replaying = true;
+  std::vector<size_t> dep_positions;
+  for (size_t pos = 0; pos < stmts.size(); pos++) {
+    auto it = stmts[pos];
+    replaying &= it != first;
     tracker.ApplyEffectsOf(it, block, alias_map);
+    if (replaying) {
+      // The statement's deps are current; rebuild its closure from them.
+      for (auto dep : (*it)->deps) {
+        auto dep_pos = positions.find(dep);
+        if (dep_pos == positions.end() || dep_pos->second >= pos) {
+          throw_with_trace(std::logic_error(
+              str(boost::format("Statement dependency is out of date before the update point in %s") % block->name)));
+        }
+        closures.Add(pos, dep_pos->second);
+      }
+      tracker.dataflow_deps.clear();
+      continue;
+    }
 
-    // At this point, dataflow_deps describes the dataflow dependencies of the current Statement.
-    // Use it to compute the Statement's transitive dependencies.
-    auto& tdeps = transitive_deps[it];
+    // At this point, dataflow_deps describes the dataflow dependencies of the current Statement.  Visiting them latest
+    // first, each is an actual dependency unless a later one already depends on it.
+    dep_positions.clear();
     for (auto dep : tracker.dataflow_deps) {
-      const auto& dep_tdeps = transitive_deps.at(dep);
-      tdeps.insert(dep_tdeps.begin(), dep_tdeps.end());
+      dep_positions.push_back(positions.at(dep));
     }
-
-    // (dataflow_deps - tdeps) is now the set of actual dependencies for this Statement.
+    std::sort(dep_positions.begin(), dep_positions.end(), std::greater<size_t>());
     (*it)->deps.clear();
-    std::set_difference(tracker.dataflow_deps.begin(),  //
-                        tracker.dataflow_deps.end(),    //
-                        tdeps.begin(),                  //
-                        tdeps.end(),                    //
-                        std::back_inserter((*it)->deps));
-
-    // Add those actual dependencies back into the transitive deps
-    // (note that dataflow_deps that are transitively covered by the
-    // actual dependencies are already in the set of transitive deps).
-    for (auto dep : (*it)->deps) {
-      tdeps.insert(dep);
+    for (auto dep_pos : dep_positions) {
+      if (!closures.Test(pos, dep_pos)) {
+        closures.Add(pos, dep_pos);
+        (*it)->deps.push_front(stmts[dep_pos]);
+      }
     }
 
     // Reset dataflow_deps for the next Statement.
@@ -234,10 +300,53 @@ void ComputeDepsForBlock(Block* block, const AliasMap& alias_map) {
   }
 }
 
+}  // namespace
+
+void ComputeDepsForBlock(Block* block, const AliasMap& alias_map) {
+  IVLOG(3, "ComputeDeps> " << block->name);
+  ComputeDeps(block, alias_map, block->stmts.begin());
+}
+
+void UpdateDepsForBlock(Block* block, const AliasMap& alias_map, StatementIt first) {
+  IVLOG(3, "UpdateDeps> " << block->name);
+  ComputeDeps(block, alias_map, first);
+}
+
+std::vector<std::vector<StatementIt>> IndependentRuns(Block* block,
+                                                      const std::function<bool(const Block&)>& eligible) {
+  std::vector<std::vector<StatementIt>> runs;
+  std::vector<StatementIt> run;
+  std::set<const Statement*> members;
+  auto flush = [&] {
+    if (run.size() > 1) {
+      runs.push_back(run);
+    }
+    run.clear();
+    members.clear();
+  };
+  for (auto it = block->stmts.begin(); it != block->stmts.end(); ++it) {
+    auto inner = Block::Downcast(*it);
+    if (!inner || !eligible(*inner)) {
+      flush();
+      continue;
+    }
+    for (const auto& dep : (*it)->deps) {
+      if (members.count(dep->get())) {
+        flush();
+        break;
+      }
+    }
+    run.push_back(it);
+    members.insert(it->get());
+  }
+  flush();
+  return runs;
+}
+
 // Recomputes Statement dependencies within all matching Blocks.
 void ComputeDepsPass::Apply(CompilerState* state) const {
   auto reqs = stripe::FromProto(options_.reqs());
-  RunOnBlocks(state->entry(), reqs, [](const AliasMap& map, stripe::Block* block) {  //
+  RunOnBlocks(state, reqs, [](const AliasMap& map, stripe::Block* block) {  //
     ComputeDepsForBlock(block, map);
   });
 }
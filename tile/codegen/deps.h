@@ -2,7 +2,9 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
+#include <vector>
 
 #include "tile/codegen/alias.h"
 #include "tile/codegen/codegen.pb.h"
@@ -40,9 +42,21 @@ void ComputeDataflowDepsForBlock(stripe::Block* block, const AliasMap& alias_map
 // A's statement dependencies will be [B].
 void ComputeDepsForBlock(stripe::Block* block, const AliasMap& alias_map);
 
+// Recomputes the dependencies of the Statements from first onwards, after a rewrite which left the Statements before
+// first, and their dependencies, unchanged.  This replays the earlier Statements' effects on buffers and scalars, but
+// skips recomputing their dependencies.  Block::erase_stmt clears every Statement's dependencies, so rewrites which
+// use it need ComputeDepsForBlock instead.
+void UpdateDepsForBlock(stripe::Block* block, const AliasMap& alias_map, stripe::StatementIt first);
+
+// Finds the maximal runs of two or more consecutive sub-blocks of block which eligible accepts, none of which depends
+// on an earlier one in its run, according to the Statements' current dependencies.
+std::vector<std::vector<stripe::StatementIt>> IndependentRuns(
+    stripe::Block* block, const std::function<bool(const stripe::Block&)>& eligible);
+
 class ComputeDepsPass final : public CompilePass {
  public:
   explicit ComputeDepsPass(const proto::ComputeDepsPass& options) : options_{options} {}
+  bool preserves_analyses() const final { return true; }
   void Apply(CompilerState* state) const final;
 
  private:
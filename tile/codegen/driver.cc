@@ -2,15 +2,29 @@
 
 #include "tile/codegen/driver.h"
 
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
 #include <memory>
+#include <mutex>
+#include <sstream>
 #include <unordered_map>
 
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
 #include <boost/format.hpp>
+#include <google/protobuf/util/json_util.h>
 
 #include "base/config/config.h"
 #include "base/util/any_factory_map.h"
+#include "base/util/env.h"
 #include "base/util/throw.h"
 #include "tile/codegen/alias.h"
+#include "tile/codegen/analysis.h"
 #include "tile/codegen/compile_pass.h"
 #include "tile/codegen/emitc.h"
 #include "tile/codegen/mlir_passes.h"
@@ -74,6 +88,84 @@ void ValidateBlock(Block* root) {
       true);
 }
 
+void CountStatements(const Block& block, proto::PassProfile* profile) {
+  profile->set_blocks(profile->blocks() + 1);
+  for (const auto& stmt : block.stmts) {
+    profile->set_statements(profile->statements() + 1);
+    auto inner = Block::Downcast(stmt);
+    if (inner) {
+      CountStatements(*inner, profile);
+    }
+  }
+}
+
+void WriteProfile(const proto::OptimizeProfile& profile, const boost::filesystem::path& path) {
+  // Every Optimize in the process appends its report as one line, so that a
+  // compile of several programs keeps all of them.
+  static std::mutex mu;
+  std::string json;
+  google::protobuf::util::JsonPrintOptions options;
+  options.preserve_proto_field_names = true;
+  google::protobuf::util::MessageToJsonString(profile, &json, options);
+  std::lock_guard<std::mutex> lock{mu};
+  if (path.has_parent_path()) {
+    boost::filesystem::create_directories(path.parent_path());
+  }
+  std::ofstream fout(path.string(), std::ios::app);
+  fout << json << std::endl;
+}
+
+// A 128-bit text digest: FNV-1a alongside std::hash, so that an accidental
+// collision between checkpoint keys would need both to collide at once.
+std::string Digest(const std::string& bytes) {
+  uint64_t fnv = 0xCBF29CE484222325ull;
+  for (unsigned char ch : bytes) {
+    fnv ^= ch;
+    fnv *= 0x100000001B3ull;
+  }
+  std::stringstream ss;
+  ss << std::hex << std::setfill('0') << std::setw(16) << fnv << std::setw(16) << std::hash<std::string>{}(bytes);
+  return ss.str();
+}
+
+// Computes the checkpoint key of the program as it is before each pass runs,
+// followed by the key of the final program.  Each pass is assumed to be a
+// deterministic function of the program it is given and its own config, so
+// the keys chain the digest of the initial program through the passes.
+std::vector<std::string> CheckpointKeys(const CompilerState& state, const Passes& passes) {
+  std::stringstream ss;
+  ss << *state.prog->entry;
+  for (const auto& kvp : state.prog->buffers) {
+    ss << "buffer " << kvp.first << "\n";
+    for (const auto& section : kvp.second.sections) {
+      ss << "section " << section.first << " " << Digest(section.second) << "\n";
+    }
+  }
+  ss << "tune " << state.tune_candidates << ":" << state.tune_rank;
+  std::vector<std::string> keys{Digest(ss.str())};
+  for (const auto& pass : passes) {
+    keys.push_back(Digest(keys.back() + pass.name() + pass.SerializeAsString()));
+  }
+  return keys;
+}
+
+// Checkpoints are never modified, so a checkpoint of a program that no pass will touch again shares its blocks
+// rather than copying them; so does a program restored from a checkpoint that no pass will run on.
+std::shared_ptr<const Program> MakeCheckpoint(const Program& program, bool share) {
+  auto checkpoint = std::make_shared<Program>(program);
+  if (!share) {
+    checkpoint->entry = CloneBlock(*program.entry);
+  }
+  return checkpoint;
+}
+
+void RestoreCheckpoint(const Program& checkpoint, bool share, Program* program) {
+  program->buffers = checkpoint.buffers;
+  program->entry = share ? checkpoint.entry : CloneBlock(*checkpoint.entry);
+  program->input_shapes = checkpoint.input_shapes;
+  program->output_shapes = checkpoint.output_shapes;
+}
+
 class ConfigsRegistry {
  public:
   static ConfigsRegistry* Instance() {
@@ -81,30 +173,110 @@ class ConfigsRegistry {
     return &registry;
   }
 
-  void Register(const std::string& name, const std::string& cfg_bytes) {  //
+  void Register(const std::string& name, const std::string& cfg_bytes) {
+    std::lock_guard<std::mutex> lock(mu_);
     registry_[name] = cfg_bytes;
+    resolved_.erase(name);
   }
 
-  proto::Config Resolve(const std::string& name) {
+  // Configs are parsed on first resolution and cached, so repeated compiles for a target don't re-parse them.
+  const proto::Config& Resolve(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto cached = resolved_.find(name);
+    if (cached != resolved_.end()) {
+      return *cached->second;
+    }
     auto it = registry_.find(name);
     if (it == registry_.end()) {
       throw_with_trace(std::runtime_error(str(boost::format("Could not find config: %s") % name)));
     }
-    return ParseConfig<proto::Config>(it->second);
+    auto config = std::make_shared<proto::Config>(ParseConfig<proto::Config>(it->second));
+    resolved_[name] = config;
+    return *config;
   }
 
  private:
+  std::mutex mu_;
   std::unordered_map<std::string, std::string> registry_;
+  std::unordered_map<std::string, std::shared_ptr<const proto::Config>> resolved_;
 };
 
 }  // namespace
 
+uint64_t PeakRss() {
+#if !defined(_WIN32)
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#if defined(__APPLE__)
+    return usage.ru_maxrss;
+#else
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+  }
+#endif
+  return 0;
+}
+
+void RecordMemoryUsage(uint64_t peak_before, proto::PassProfile* profile) {
+#if defined(__linux__)
+  std::ifstream statm("/proc/self/statm");
+  uint64_t pages = 0;
+  uint64_t resident = 0;
+  if (statm >> pages >> resident) {
+    profile->set_rss_bytes(resident * sysconf(_SC_PAGESIZE));
+  }
+#endif
+  auto peak = PeakRss();
+  if (peak) {
+    profile->set_process_peak_rss_bytes(peak);
+    profile->set_peak_rss_growth_bytes(peak > peak_before ? peak - peak_before : 0);
+  }
+}
+
 void Optimize(CompilerState* state, const Passes& passes, const OptimizeOptions& options) {
+  using clock = std::chrono::steady_clock;
+  bool profiling = !options.profile_path.empty() || options.profile || options.ctx.is_logging_events();
+  proto::OptimizeProfile profile;
+  std::unique_ptr<context::Activity> optimize_activity;
+  if (options.ctx.is_logging_events()) {
+    optimize_activity = std::make_unique<context::Activity>(options.ctx, "tile::codegen::Optimize");
+  }
+  auto optimize_start = clock::now();
   size_t counter = 0;
   DumpProgram(*state->entry(), options, "initial", counter++);
+  // Constant buffers live outside the program and may be rewritten by passes,
+  // and tuning rounds report results back through the state; neither can be
+  // replayed from a checkpoint.
+  bool checkpointing = options.cache && state->tune_candidates <= 1 &&
+                       (!state->const_bufs || state->const_bufs->buffers.empty());
+  std::vector<std::string> keys;
+  int start = 0;
+  if (checkpointing) {
+    keys = CheckpointKeys(*state, passes);
+    for (int i = passes.size(); i > 0; i--) {
+      auto checkpoint = options.cache->Lookup(keys[i]);
+      if (checkpoint) {
+        IVLOG(1, "Resuming optimization from checkpoint after pass " << passes.Get(i - 1).name());
+        RestoreCheckpoint(*checkpoint, i == passes.size(), state->prog.get());
+        start = i;
+        break;
+      }
+    }
+    if (profiling) {
+      profile.set_checkpointed_passes(start);
+    }
+  }
+  counter += start;
   bool in_stripe = true;
-  for (const auto& pass : passes) {
+  for (int i = start; i < passes.size(); i++) {
+    const auto& pass = passes.Get(i);
     IVLOG(1, "Optimization Pass " << pass.name());
+    std::unique_ptr<context::Activity> pass_activity;
+    if (optimize_activity) {
+      pass_activity = std::make_unique<context::Activity>(optimize_activity->ctx(), "tile::codegen::Pass");
+    }
+    uint64_t peak_before = profiling ? PeakRss() : 0;
+    auto pass_start = clock::now();
     std::unique_ptr<CompilePass> compile_pass =
         AnyFactoryMap<CompilePass>::Instance()->MakeInstanceIfSupported(context::Context{}, pass.pass());
     if (!compile_pass) {
@@ -119,6 +291,26 @@ void Optimize(CompilerState* state, const Passes& passes, const OptimizeOptions&
     }
     in_stripe = wants_stripe;
     compile_pass->Apply(state);
+    if (!compile_pass->preserves_analyses()) {
+      state->analyses->InvalidateAll();
+    }
+    if (profiling) {
+      auto pass_profile = profile.add_passes();
+      pass_profile->set_name(pass.name());
+      auto type = pass.pass().type_url();
+      pass_profile->set_type(type.substr(type.rfind('/') + 1));
+      pass_profile->set_seconds(std::chrono::duration<double>(clock::now() - pass_start).count());
+      if (in_stripe) {
+        pass_profile->set_blocks(0);
+        pass_profile->set_statements(0);
+        CountStatements(*state->entry(), pass_profile);
+      }
+      RecordMemoryUsage(peak_before, pass_profile);
+      if (pass_activity) {
+        pass_activity->AddMetadata(*pass_profile);
+      }
+    }
+    pass_activity.reset();
     if (in_stripe) {
       DumpProgram(*state->entry(), options, pass.name(), counter);
     } else {
@@ -126,10 +318,40 @@ void Optimize(CompilerState* state, const Passes& passes, const OptimizeOptions&
     }
     counter++;
     ValidateBlock(state->entry());
+    if (checkpointing && in_stripe && options.checkpoint_passes && i + 1 < passes.size()) {
+      options.cache->Insert(keys[i + 1], MakeCheckpoint(*state->prog, false));
+    }
   }
   if (!in_stripe) {
     ConvertFromMLIR(state);
   }
+  if (checkpointing && start < passes.size()) {
+    options.cache->Insert(keys.back(), MakeCheckpoint(*state->prog, true));
+  }
+  if (profiling) {
+    profile.set_total_seconds(std::chrono::duration<double>(clock::now() - optimize_start).count());
+    if (IVLOG_IS_ON(1)) {
+      std::vector<const proto::PassProfile*> slowest;
+      for (const auto& pass_profile : profile.passes()) {
+        slowest.push_back(&pass_profile);
+      }
+      std::sort(slowest.begin(), slowest.end(), [](auto lhs, auto rhs) { return lhs->seconds() > rhs->seconds(); });
+      IVLOG(1, "Optimization took " << profile.total_seconds() << "s; slowest passes:");
+      for (size_t i = 0; i < std::min(slowest.size(), size_t(10)); i++) {
+        IVLOG(1, "  " << slowest[i]->name() << ": " << slowest[i]->seconds() << "s, " << slowest[i]->statements()
+                      << " statements, peak RSS +" << slowest[i]->peak_rss_growth_bytes() / (1024 * 1024) << " MiB");
+      }
+    }
+    if (!options.profile_path.empty()) {
+      WriteProfile(profile, options.profile_path);
+    }
+    if (optimize_activity) {
+      optimize_activity->AddMetadata(profile);
+    }
+    if (options.profile) {
+      *options.profile = profile;
+    }
+  }
   // Remove constants that are no longer used
   if (state->const_bufs == nullptr) {
     return;
@@ -145,11 +367,49 @@ void Optimize(CompilerState* state, const Passes& passes, const OptimizeOptions&
   IVLOG(3, "All optimization passes complete");
 }
 
+OptimizeCache::OptimizeCache(size_t max_entries) : max_entries_(max_entries) {}
+
+OptimizeCache* OptimizeCache::Global() {
+  static OptimizeCache* cache = env::Get("PLAIDML_CODEGEN_CACHE") == "1" ? new OptimizeCache : nullptr;
+  return cache;
+}
+
+std::shared_ptr<const Program> OptimizeCache::Lookup(const std::string& key) {
+  std::lock_guard<std::mutex> lock(mu_);
+  auto it = index_.find(key);
+  if (it == index_.end()) {
+    return nullptr;
+  }
+  entries_.splice(entries_.begin(), entries_, it->second);
+  return it->second->second;
+}
+
+void OptimizeCache::Insert(const std::string& key, std::shared_ptr<const Program> program) {
+  std::lock_guard<std::mutex> lock(mu_);
+  auto it = index_.find(key);
+  if (it != index_.end()) {
+    it->second->second = std::move(program);
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return;
+  }
+  entries_.emplace_front(key, std::move(program));
+  index_[key] = entries_.begin();
+  while (entries_.size() > max_entries_) {
+    index_.erase(entries_.back().first);
+    entries_.pop_back();
+  }
+}
+
+size_t OptimizeCache::size() const {
+  std::lock_guard<std::mutex> lock(mu_);
+  return entries_.size();
+}
+
 void Configs::Register(const std::string& name, const std::string& pb_bytes) {
   ConfigsRegistry::Instance()->Register(name, pb_bytes);
 }
 
-proto::Config Configs::Resolve(const std::string& name) {  //
+const proto::Config& Configs::Resolve(const std::string& name) {  //
   return ConfigsRegistry::Instance()->Resolve(name);
 }
 
@@ -2,10 +2,16 @@
 
 #pragma once
 
+#include <list>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <utility>
 
 #include <boost/filesystem.hpp>
 
+#include "base/context/context.h"
 #include "tile/codegen/codegen.pb.h"
 #include "tile/codegen/compile_pass.h"
 #include "tile/stripe/stripe.h"
@@ -14,20 +20,69 @@ namespace vertexai {
 namespace tile {
 namespace codegen {
 
+class OptimizeCache;
+
 struct OptimizeOptions {
   bool dump_passes = false;
   bool dump_passes_proto = false;
   bool dump_code = false;
   boost::filesystem::path dbg_dir;
+  // Pass profiling: records the wall time, program size and memory use of each
+  // pass.  The report is appended to profile_path as one line of JSON if it is
+  // set, stored in *profile if that is set, and each pass is logged as an event
+  // if ctx is logging events.
+  boost::filesystem::path profile_path;
+  proto::OptimizeProfile* profile = nullptr;
+  context::Context ctx;
+  // Checkpointing: if cache is set, the program produced by each pass is
+  // stored in it, keyed by the initial program and the passes that have run so
+  // far, and a later Optimize of an identical program resumes from the latest
+  // checkpoint available.  Only the final result is kept unless
+  // checkpoint_passes is set.  The final result shares its blocks with the
+  // optimized program, so a caller that modifies the program afterwards must
+  // work on a CloneBlock of it.
+  OptimizeCache* cache = nullptr;
+  bool checkpoint_passes = false;
+};
+
+// An in-memory store of the intermediate programs produced by Optimize.  It is
+// safe to share between threads; the least recently used entries are evicted
+// once there are more than max_entries of them.
+class OptimizeCache {
+ public:
+  explicit OptimizeCache(size_t max_entries = 256);
+
+  // The process-wide cache, or nullptr unless PLAIDML_CODEGEN_CACHE is set.
+  static OptimizeCache* Global();
+
+  std::shared_ptr<const stripe::Program> Lookup(const std::string& key);
+  void Insert(const std::string& key, std::shared_ptr<const stripe::Program> program);
+  size_t size() const;
+
+ private:
+  using Entry = std::pair<std::string, std::shared_ptr<const stripe::Program>>;
+
+  mutable std::mutex mu_;
+  size_t max_entries_;
+  std::list<Entry> entries_;
+  std::unordered_map<std::string, std::list<Entry>::iterator> index_;
 };
 
 using Passes = google::protobuf::RepeatedPtrField<proto::Pass>;
 
 void Optimize(CompilerState* state, const Passes& passes, const OptimizeOptions& options);
 
+// The peak resident set size of this process so far, or zero if it's unknown.
+uint64_t PeakRss();
+
+// Records the current and peak resident set size of this process in *profile,
+// along with how far the peak has risen above peak_before, a PeakRss() taken
+// when the profiled work began.
+void RecordMemoryUsage(uint64_t peak_before, proto::PassProfile* profile);
+
 struct Configs {
   static void Register(const std::string& name, const std::string& pb_bytes);
-  static proto::Config Resolve(const std::string& name);
+  static const proto::Config& Resolve(const std::string& name);
 };
 
 }  // namespace codegen
@@ -23,8 +23,19 @@ static void DoTranspose(char* out, const char* in, const TensorShape& os, const
   }
 }
 
+void RelayoutConstBuffer(CompilerState* state, const std::string& name, const TensorShape& from,
+                         const TensorShape& to) {
+  // The relaid buffer is uploaded while compilation continues.
+  state->const_bufs->Wait(name);
+  auto old_buffer = state->const_bufs->buffers.at(name);
+  state->const_bufs->Stream(name, to.byte_size(), [old_buffer, from, to](char* data) {
+    context::Context ctx;
+    auto old_view = old_buffer->MapCurrent(ctx).get();
+    DoTranspose(data, old_view->begin(), to, from);
+  });
+}
+
 static void FixStridesBlock(stripe::Block* block, CompilerState* state) {
-  context::Context ctx;
   std::set<std::string> used_in_special;
   for (auto& stmt : block->stmts) {
     auto spec = stripe::Special::Downcast(stmt);
@@ -80,7 +91,7 @@ static void FixStridesBlock(stripe::Block* block, CompilerState* state) {
     size_t inner = 1;
     auto new_shape = shape;
     for (size_t idx : order) {
-      new_shape.dims[idx].stride = inner;
+      new_shape.dims.set_stride(idx, inner);
       inner *= new_shape.dims[idx].size;
     }
     // If we have nothing to adjust, continue
@@ -89,13 +100,7 @@ static void FixStridesBlock(stripe::Block* block, CompilerState* state) {
     }
     // FOr now skip the tricky ones
     if (ref.has_tag("user") && shape.is_const) {
-      auto new_buffer = state->const_bufs->allocator->allocate(new_shape.byte_size());
-      auto old_view = state->const_bufs->buffers.at(ref.into())->MapCurrent(ctx).get();
-      auto new_view = new_buffer->MapDiscard(ctx);
-      const char* old_ptr = old_view->begin();
-      char* new_ptr = new_view->begin();
-      DoTranspose(new_ptr, old_ptr, new_shape, shape);
-      state->const_bufs->buffers[ref.into()] = new_buffer;
+      RelayoutConstBuffer(state, ref.into(), shape, new_shape);
     }
     ref.mut().interior_shape = new_shape;
     FixupRefs(block, ref.into());
@@ -14,6 +14,11 @@ namespace vertexai {
 namespace tile {
 namespace codegen {
 
+// Replaces a constant buffer with a copy whose contents are laid out for the shape to rather than from, which must
+// differ only in their strides.
+void RelayoutConstBuffer(CompilerState* state, const std::string& name, const TensorShape& from,
+                         const TensorShape& to);
+
 class FixStridesPass final : public CompilePass {
  public:
   explicit FixStridesPass(const proto::FixStridesPass& options) : options_{options} {}
@@ -3,6 +3,7 @@
 #include "tile/codegen/fuse.h"
 
 #include <algorithm>
+#include <memory>
 #include <set>
 #include <utility>
 #include <vector>
@@ -11,6 +12,7 @@
 
 #include "base/util/stream_container.h"
 #include "base/util/throw.h"
+#include "tile/codegen/autotile.h"
 #include "tile/codegen/localize.h"
 #include "tile/codegen/tile.h"
 
@@ -338,7 +340,7 @@ std::shared_ptr<Block> FusionRefactor(const stripe::Block& orig,
         }
         affine += Affine(it->second, kvp.second);
       }
-      ref.mut().interior_shape.dims[i].size = max_val - min_val + 1;
+      ref.mut().interior_shape.dims.set_size(i, max_val - min_val + 1);
       acc = affine;
     }
   }
@@ -510,6 +512,91 @@ bool FuseBlocks(const AliasMap& scope, Block* block_a, Block* block_b) {
   return true;
 }
 
+CostFusionStrategy::CostFusionStrategy(const proto::FusionPass& options) : TagFusionStrategy(options) {
+  metrics_.set_cache_width(options.cache_width());
+}
+
+double CostFusionStrategy::BytesMoved(const Block& block) const {
+  std::map<std::string, size_t> full_ranges;
+  for (const auto& idx : block.idxs) {
+    full_ranges[idx.name] = idx.range;
+  }
+  return ComputeSizes(full_ranges, block, metrics_).total_bandwidth * metrics_.cache_width();
+}
+
+int64_t CostFusionStrategy::WorkingSet(const Block& block) const {
+  std::map<std::string, size_t> single;
+  for (const auto& idx : block.idxs) {
+    single[idx.name] = 1;
+  }
+  return ComputeSizes(single, block, metrics_).total_bytes;
+}
+
+bool CostFusionStrategy::AcceptFused(const AliasMap& outer, const Block& fused, const Block& a, const Block& b) {
+  auto max_working_set = Options().max_working_set();
+  auto working_set = WorkingSet(fused);
+  if (max_working_set && working_set > static_cast<int64_t>(max_working_set)) {
+    IVLOG(3, "Fusion working set " << working_set << " exceeds " << max_working_set);
+    return false;
+  }
+  double unfused = BytesMoved(a) + BytesMoved(b);
+  double saved = unfused - BytesMoved(fused);
+  IVLOG(3, "Fusion of " << a.name << " and " << b.name << " saves " << saved << " of " << unfused << " bytes");
+  return saved > 0 && saved >= Options().min_savings() * unfused;
+}
+
+// Statements up to lookahead places after it may be fused into it if nothing
+// in between them conflicts, since the fused block runs at its position.
+static bool CanHoist(const StatementIt& it, const StatementIt& candidate) {
+  std::set<std::string> reads;
+  std::set<std::string> writes;
+  for (const auto& name : (*candidate)->buffer_reads()) {
+    reads.insert(name);
+  }
+  for (const auto& name : (*candidate)->buffer_writes()) {
+    writes.insert(name);
+  }
+  for (auto between = std::next(it); between != candidate; ++between) {
+    for (const auto& dep : (*candidate)->deps) {
+      if (dep == between) {
+        return false;
+      }
+    }
+    for (const auto& name : (*between)->buffer_writes()) {
+      if (reads.count(name) || writes.count(name)) {
+        return false;
+      }
+    }
+    for (const auto& name : (*between)->buffer_reads()) {
+      if (writes.count(name)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Returns the statement to consider fusing into the block at it: the next
+// statement, unless a later block within lookahead statements reads one of its
+// outputs and can be hoisted to follow it.
+static StatementIt NextFusionCandidate(Block* block, const StatementIt& it, const std::set<std::string>& outs,
+                                       size_t lookahead) {
+  auto next = std::next(it);
+  auto candidate = next;
+  for (size_t i = 0; i < lookahead && candidate != block->stmts.end(); i++, ++candidate) {
+    auto inner = Block::Downcast(*candidate);
+    if (!inner) {
+      continue;
+    }
+    for (const auto& ri : inner->ref_ins()) {
+      if (outs.count(ri->from)) {
+        return (candidate == next || CanHoist(it, candidate)) ? candidate : next;
+      }
+    }
+  }
+  return next;
+}
+
 void FusionInner(const AliasMap& scope, Block* block, TagFusionStrategy* strategy, bool no_inner, bool no_constraints) {
   // Start with the first statement, and keep tying to fuse until you can't anymore, then move to the next
   auto it = block->stmts.begin();
@@ -523,9 +610,18 @@ void FusionInner(const AliasMap& scope, Block* block, TagFusionStrategy* strateg
       // Get block everytime in case it's updated
       auto block1 = Block::Downcast(*it);
       IVLOG(3, "Attempting fusion on block:\n" << block1->name);
+      // Get the list of outputs for this block
+      std::set<std::string> outs_for_fuse;
+      // Do not use block1->ref_outs() because we need also InOut refs
+      for (const auto& ro : block1->refs) {
+        if (IsWriteDir(ro.dir)) {
+          IVLOG(3, "Considering output: " << ro.from);
+          outs_for_fuse.emplace(ro.from);
+        }
+      }
+      IVLOG(3, "Outs for fuse size: " << outs_for_fuse.size());
       // Get the next statement
-      auto it_next = it;
-      it_next++;
+      auto it_next = NextFusionCandidate(block, it, outs_for_fuse, strategy->Options().lookahead());
       // If there is no next statement, I'm done with this block
       if (it_next == block->stmts.end()) {
         break;
@@ -540,16 +636,6 @@ void FusionInner(const AliasMap& scope, Block* block, TagFusionStrategy* strateg
         // Too many refinements in a block for the particular platform
         break;
       }
-      // Get the list of outputs for this block
-      std::set<std::string> outs_for_fuse;
-      // Do not use block1->ref_outs() because we need also InOut refs
-      for (const auto& ro : block1->refs) {
-        if (IsWriteDir(ro.dir)) {
-          IVLOG(3, "Considering output: " << ro.from);
-          outs_for_fuse.emplace(ro.from);
-        }
-      }
-      IVLOG(3, "Outs for fuse size: " << outs_for_fuse.size());
       std::string fuse_on = "";
       // Check if it's a match to any of the inputs on the next block
       for (const auto& ri : block2->ref_ins()) {
@@ -635,6 +721,10 @@ void FusionInner(const AliasMap& scope, Block* block, TagFusionStrategy* strateg
         IVLOG(3, "Actual fusion failed");
         break;
       }
+      if (!strategy->AcceptFused(scope, *refactor1, *block1, *block2)) {
+        IVLOG(3, "Fusion rejected by strategy");
+        break;
+      }
       IVLOG(3, "Fused block:\n" << *refactor1);
       // If it worked, update
       *it = refactor1;
@@ -661,8 +751,13 @@ void FusionPass::Apply(CompilerState* state) const {
   AliasMap base;
   AliasMap root_map(base, root);
   // Check if we should fuse this block
-  TagFusionStrategy strategy(options_);
-  FusionPassRecurse(root_map, root, &strategy);
+  std::unique_ptr<TagFusionStrategy> strategy;
+  if (options_.strategy() == proto::FusionPass::COST) {
+    strategy = std::make_unique<CostFusionStrategy>(options_);
+  } else {
+    strategy = std::make_unique<TagFusionStrategy>(options_);
+  }
+  FusionPassRecurse(root_map, root, strategy.get());
 }
 
 namespace {
@@ -44,10 +44,16 @@ bool FuseBlocks(const AliasMap& scope, stripe::Block* a, stripe::Block* b);
 
 class FusionStrategy {
  public:
+  virtual ~FusionStrategy() = default;
   // Called when candidate blocks for fusion are located, returns whether to attempt a fusion
   virtual bool AttemptFuse(const stripe::Block& parent, const stripe::Block& a, const stripe::Block& b) = 0;
   // Called when an attempted fusion fails
   virtual void OnFailed() = 0;
+  // Called with the fused block before it replaces a and b, returns whether to keep it
+  virtual bool AcceptFused(const AliasMap& outer, const stripe::Block& fused, const stripe::Block& a,
+                           const stripe::Block& b) {
+    return true;
+  }
   // Called when a fusion succeeds, with the new fused block (which can be edited)
   virtual void OnFused(const AliasMap& outer, stripe::Block* block, const stripe::Block& a, const stripe::Block& b) = 0;
 };
@@ -88,6 +94,25 @@ class TagFusionStrategy : public FusionStrategy {
   const proto::FusionPass options_;
 };
 
+// Scores each fusion the tags allow with a memory traffic model built on the
+// autotile metrics: a fusion is kept only if the fused block moves enough fewer
+// bytes than a and b do separately, and its working set for each outer
+// iteration fits within max_working_set.
+class CostFusionStrategy : public TagFusionStrategy {
+ public:
+  explicit CostFusionStrategy(const proto::FusionPass& options);
+  bool AcceptFused(const AliasMap& outer, const stripe::Block& fused, const stripe::Block& a,
+                   const stripe::Block& b) override;
+
+  // The estimated bytes moved between the block and its parent over all of its iterations
+  double BytesMoved(const stripe::Block& block) const;
+  // The bytes referenced by a single iteration of the block
+  int64_t WorkingSet(const stripe::Block& block) const;
+
+ private:
+  proto::AutotilePass metrics_;
+};
+
 void FusionInner(const AliasMap& scope, stripe::Block* block, TagFusionStrategy* strategy, bool no_inner = false,
                  bool no_constraints = false);
 
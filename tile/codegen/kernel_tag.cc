@@ -2,6 +2,7 @@
 
 #include <set>
 
+#include "tile/codegen/analysis.h"
 #include "tile/codegen/kernel_tag.h"
 #include "tile/stripe/stripe.h"
 
@@ -71,7 +72,7 @@ void KernelTag(const AliasMap& alias_map, Block* block) {
 
 void KernelTagPass::Apply(CompilerState* state) const {
   auto reqs = stripe::FromProto(options_.reqs());
-  RunOnBlocks(state->entry(), reqs,
+  RunOnBlocks(state, reqs,
               [](const AliasMap& alias_map, stripe::Block* block) {  //
                 KernelTag(alias_map, block);
               },
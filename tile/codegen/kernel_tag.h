@@ -16,6 +16,7 @@ void KernelTag(const AliasMap& alias_map, stripe::Block* block);
 class KernelTagPass final : public CompilePass {
  public:
   explicit KernelTagPass(const proto::KernelTagPass& options) : options_{options} {}
+  bool preserves_analyses() const final { return true; }
   void Apply(CompilerState* state) const final;
 
  private:
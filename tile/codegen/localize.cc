@@ -29,7 +29,7 @@ void FixupRefs(Block* block, const std::string& var_name) {
           ref.mut().offset = it->offset;
           ref.mut().interior_shape.is_const = it->interior_shape.is_const;
           for (size_t i = 0; i < ref.interior_shape.dims.size(); i++) {
-            ref.mut().interior_shape.dims[i].stride = it->interior_shape.dims[i].stride;
+            ref.mut().interior_shape.dims.set_stride(i, it->interior_shape.dims[i].stride);
           }
           FixupRefs(inner.get(), ref.into());
         }
@@ -56,8 +56,8 @@ void LocalizeRef(Block* block, const std::string& var_name) {
   it_ref->mut().interior_shape = SimpleShape(it_ref->interior_shape.type, sizes);
   // Fix the bankdim back up
   if (it_ref->bank_dim) {
-    it_ref->mut().interior_shape.dims[it_ref->bank_dim->dim_pos].size = orig_size;
-    it_ref->mut().interior_shape.dims[it_ref->bank_dim->dim_pos].stride = 0;
+    it_ref->mut().interior_shape.dims.set_size(it_ref->bank_dim->dim_pos, orig_size);
+    it_ref->mut().interior_shape.dims.set_stride(it_ref->bank_dim->dim_pos, 0);
   }
   // Change dir + from
   it_ref->mut().dir = RefDir::None;
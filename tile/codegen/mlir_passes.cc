@@ -2,9 +2,15 @@
 
 #include "tile/codegen/mlir_passes.h"
 
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
 
+#include "llvm/ADT/DenseMap.h"
 #include "mlir/Pass/PassManager.h"
 #include "mlir/Support/DebugStringHelper.h"
 #include "mlir/Transforms/Passes.h"
@@ -15,6 +21,8 @@
 #include "pmlc/dialect/stripe/nop_pass.h"
 #include "pmlc/dialect/stripe/padding_pass.h"
 #include "pmlc/dialect/stripe/transcode.h"
+#include "pmlc/dialect/stripe/vectorize_pass.h"
+#include "tile/codegen/analysis.h"
 #include "tile/codegen/compile_pass.h"
 
 // N.B. We need to confine all definitions to MLIR here.
@@ -31,27 +39,113 @@ struct MLIRState {
   mlir::MLIRContext ctx;
   // Holds a single function or no function depending on if state is in MLIR
   mlir::OwningModuleRef module;
+  // The last point at which the module and the Stripe program were known to match: the text of the program's entry
+  // block, and the structure of the module.  While one side still matches, converting into it is skipped.
+  std::string synced_stripe;
+  std::vector<const void*> synced_module;
 
   MLIRState() : module(mlir::ModuleOp::create(mlir::UnknownLoc::get(&ctx))) {}
 };
 
 CompilerState::CompilerState(std::shared_ptr<stripe::Program> prog)
-    : mlir(std::make_unique<MLIRState>()), prog(prog), const_bufs(nullptr) {}
+    : mlir(std::make_unique<MLIRState>()),
+      prog(prog),
+      const_bufs(nullptr),
+      analyses(std::make_unique<AnalysisManager>()) {}
 
 CompilerState::~CompilerState() = default;
 
+namespace {
+
+std::string StripeText(const stripe::Program& prog) {
+  std::stringstream ss;
+  ss << *prog.entry;
+  return ss.str();
+}
+
+// Flattens the structure of a module: every op's name, attributes, operands and result types, and the shape of its
+// regions.  Names, attributes and types are uniqued by the context, and values are numbered in definition order, so
+// two modules have equal keys exactly when they are structurally identical.
+class ModuleKeyBuilder {
+ public:
+  std::vector<const void*> key;
+
+  // Ops are visited before their regions, so that block arguments are numbered before their uses.
+  void Visit(mlir::Operation* op) {
+    key.push_back(op->getName().getAsOpaquePointer());
+    PushNumber(op->getNumOperands());
+    for (auto operand : op->getOperands()) {
+      auto it = numbers_.find(operand);
+      PushNumber(it == numbers_.end() ? SIZE_MAX : it->second);
+    }
+    PushNumber(op->getAttrs().size());
+    for (const auto& attr : op->getAttrs()) {
+      key.push_back(attr.first.getAsOpaquePointer());
+      key.push_back(attr.second.getAsOpaquePointer());
+    }
+    PushNumber(op->getNumResults());
+    for (auto result : op->getResults()) {
+      key.push_back(result.getType().getAsOpaquePointer());
+      Number(result);
+    }
+    PushNumber(op->getNumRegions());
+    for (auto& region : op->getRegions()) {
+      PushNumber(region.getBlocks().size());
+      for (auto& block : region) {
+        PushNumber(block.getNumArguments());
+        for (auto arg : block.getArguments()) {
+          key.push_back(arg.getType().getAsOpaquePointer());
+          Number(arg);
+        }
+        PushNumber(block.getOperations().size());
+        for (auto& inner : block) {
+          Visit(&inner);
+        }
+      }
+    }
+  }
+
+ private:
+  void Number(mlir::Value value) { numbers_.try_emplace(value, numbers_.size()); }
+  void PushNumber(size_t n) { key.push_back(reinterpret_cast<const void*>(n)); }
+
+  llvm::DenseMap<mlir::Value, size_t> numbers_;
+};
+
+std::vector<const void*> ModuleKey(mlir::ModuleOp module) {
+  ModuleKeyBuilder builder;
+  builder.Visit(module.getOperation());
+  return std::move(builder.key);
+}
+
+}  // namespace
+
 void ConvertFromMLIR(CompilerState* state) {
+  auto key = ModuleKey(*state->mlir->module);
+  if (key == state->mlir->synced_module) {
+    IVLOG(1, "Stripe MLIR is unchanged, keeping the Stripe program");
+    return;
+  }
   IVLOG(1, "Converting from Stripe MLIR");
   *state->prog = *pmlc::dialect::stripe::FromMLIR(*state->mlir->module);
   IVLOG(3, "New\n" << *state->prog->entry);
+  state->mlir->synced_stripe = StripeText(*state->prog);
+  state->mlir->synced_module = std::move(key);
 }
 
 void ConvertIntoMLIR(CompilerState* state) {
+  auto text = StripeText(*state->prog);
+  if (text == state->mlir->synced_stripe) {
+    IVLOG(1, "Stripe program is unchanged, keeping the Stripe MLIR");
+    return;
+  }
   IVLOG(1, "Converting to Stripe MLIR");
-  IVLOG(3, "Original\n" << *state->prog->entry);
+  IVLOG(3, "Original\n" << text);
   state->mlir->module = pmlc::dialect::stripe::IntoMLIR(&state->mlir->ctx, *state->prog);
   auto module = *state->mlir->module;
   IVLOG(3, "New\n" << mlir::debugString(module));
+  state->mlir->synced_stripe = std::move(text);
+  state->mlir->synced_module = ModuleKey(module);
 }
 
 template <typename Pass, typename Config>
@@ -87,6 +181,7 @@ inline void RegisterPass() {
   RegisterPass<pmlc::dialect::stripe::AutoStencilPass, proto::MLIR_AutoStencilPass>();
   RegisterPass<pmlc::dialect::stripe::NopPass, proto::MLIR_NopPass>();
   RegisterPass<pmlc::dialect::stripe::PaddingPass, proto::MLIR_PadPass>();
+  RegisterPass<pmlc::dialect::stripe::VectorizePass, proto::MLIR_VectorizePass>();
   return 0;
 }();
 
@@ -2,6 +2,14 @@
 
 #include "tile/codegen/package.h"
 
+#include <algorithm>
+#include <map>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include "tile/codegen/deps.h"
+
 namespace vertexai {
 namespace tile {
 namespace codegen {
@@ -74,9 +82,90 @@ void PackagePass::Apply(CompilerState* state) const {
   }
 }
 
+namespace {
+
+// The number of innermost iterations a block runs.
+size_t Iterations(const stripe::Block& block) {
+  size_t inner = 0;
+  for (const auto& stmt : block.stmts) {
+    auto sub = stripe::Block::Downcast(stmt);
+    if (sub) {
+      inner += Iterations(*sub);
+    }
+  }
+  return block.idxs_product() * std::max<size_t>(inner, 1);
+}
+
+// Merges a run of kernels of outer into a single kernel, which runs member i for part i.
+void MergeKernels(stripe::Block* outer, const std::vector<stripe::StatementIt>& run, const stripe::Tags& kernel_tags,
+                  const stripe::Tags& pkg_tags) {
+  auto pkg = std::make_shared<stripe::Block>();
+  pkg->set_tags(pkg_tags);
+  pkg->location = outer->location;
+  pkg->idxs.emplace_back("part", run.size());
+  std::map<std::string, stripe::RefDir> dirs;
+  for (size_t i = 0; i < run.size(); i++) {
+    auto kernel = stripe::Block::Downcast(*run[i]);
+    pkg->name += (i ? "+" : "") + kernel->name;
+    pkg->comments += kernel->comments;
+    for (const auto& ref : kernel->refs) {
+      if (ref.dir != stripe::RefDir::None) {
+        dirs[ref.from] = stripe::UnionDir(dirs[ref.from], ref.dir);
+      }
+    }
+    auto part = kernel->unique_idx_name("part");
+    kernel->idxs.emplace_back(part, 1, stripe::Affine("part"));
+    kernel->constraints.emplace_back(stripe::Affine(part) - static_cast<int64_t>(i));
+    kernel->constraints.emplace_back(static_cast<int64_t>(i) - stripe::Affine(part));
+    kernel->remove_tags(kernel_tags);
+    pkg->stmts.push_back(kernel);
+  }
+  // Propagate the refinements used by the kernels to the package block, as PackagePass does.
+  for (const auto& kvp : dirs) {
+    auto outer_ref = outer->ref_by_into(kvp.first);
+    pkg->refs.emplace(stripe::Refinement{kvp.second,                                                // dir
+                                         kvp.first,                                                 // from
+                                         kvp.first,                                                 // into
+                                         std::vector<stripe::Affine>(outer_ref->access.size(), 0),  // access
+                                         outer_ref->interior_shape});                               // interior_shape
+  }
+  *run.front() = pkg;
+  outer->erase_stmts(std::next(run.front()), std::next(run.back()));
+}
+
+}  // namespace
+
+void PackKernelsPass::Apply(CompilerState* state) const {
+  auto reqs = stripe::FromProto(options_.reqs());
+  auto kernel_tags = stripe::FromProto(options_.kernel_reqs());
+  auto pkg_tags = stripe::FromProto(options_.package_set());
+  size_t max_iterations = options_.max_iterations();
+  int64_t group = 0;
+  RunOnBlocks(state->entry(), reqs, [&](const AliasMap& map, stripe::Block* block) {
+    ComputeDepsForBlock(block, map);
+    // Zero and copy kernels have their own lowerings on some targets, so they're left alone.
+    auto runs = IndependentRuns(block, [&](const stripe::Block& kernel) {
+      return kernel.has_tags(kernel_tags) && !kernel.has_any_tags({"zero", "copy", "xsmm"}) &&
+             Iterations(kernel) <= max_iterations;
+    });
+    for (const auto& run : runs) {
+      IVLOG(2, "PackKernelsPass> packing " << run.size() << " kernels of " << block->name);
+      if (options_.tasks()) {
+        for (const auto& it : run) {
+          stripe::Block::Downcast(*it)->set_attr("cpu_task_group", group);
+        }
+        group++;
+      } else {
+        MergeKernels(block, run, kernel_tags, pkg_tags);
+      }
+    }
+  });
+}
+
 namespace {
 [[gnu::unused]] char reg = []() -> char {
   CompilePassFactory<PackagePass, proto::PackagePass>::Register();
+  CompilePassFactory<PackKernelsPass, proto::PackKernelsPass>::Register();
   return 0;
 }();
 }  // namespace
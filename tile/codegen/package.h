@@ -20,6 +20,17 @@ class PackagePass final : public CompilePass {
   proto::PackagePass options_;
 };
 
+// Packs runs of small kernels which don't depend on one another into a single launch: either one kernel, whose
+// "part" index selects the member to run, or a CPU task group.
+class PackKernelsPass final : public CompilePass {
+ public:
+  explicit PackKernelsPass(const proto::PackKernelsPass& options) : options_{options} {}
+  void Apply(CompilerState* state) const final;
+
+ private:
+  proto::PackKernelsPass options_;
+};
+
 }  // namespace codegen
 }  // namespace tile
 }  // namespace vertexai
@@ -172,8 +172,8 @@ void ModifyBlockIdxs(Block* block, const std::map<std::string, size_t>& new_idxs
         parent->stmts.push_front(zero);
       }
       access.push_back(Affine(idx_name));
-      src_inner_shape.dims[i].size = 1;
-      dst_inner_shape.dims[i].size = 1;
+      src_inner_shape.dims.set_size(i, 1);
+      dst_inner_shape.dims.set_size(i, 1);
     }
     Refinement src_outer_ref(RefDir::None, "", src_ref_name, parent_ref_it->access, src_outer_shape,
                              parent_ref_it->agg_op, parent_ref_it->location, parent_ref_it->offset,
@@ -332,7 +332,7 @@ void Pad(Block* block, const AliasMap& map, const RefDefineMap& ref_def_map) {
     const auto& exts = extents.at(bname);
     int64_t stride = 1;
     for (int i = exts.size() - 1; i >= 0; i--) {
-      ref.mut().interior_shape.dims[i].stride = stride;
+      ref.mut().interior_shape.dims.set_stride(i, stride);
       // When padding the new buffer should be bigger and there should not be negative offsets.
       int64_t padSize = -exts[i].load.min;
       if (padSize < 0) {
@@ -342,7 +342,7 @@ void Pad(Block* block, const AliasMap& map, const RefDefineMap& ref_def_map) {
       uint64_t new_size = exts[i].load.max + 1 - exts[i].load.min;
       // N.B. Adding padSize to the interior_shape.size keeps the load block within bounds.
       new_size = std::max(new_size, ref.interior_shape.dims[i].size + padSize);
-      ref.mut().interior_shape.dims[i].size = new_size;
+      ref.mut().interior_shape.dims.set_size(i, new_size);
       stride *= new_size;
       // Bump all the interior pointers!
       for (auto stmt : block->stmts) {
@@ -10,6 +10,7 @@
 #include "base/util/logging.h"
 #include "base/util/throw.h"
 #include "tile/codegen/alias.h"
+#include "tile/codegen/cache.h"
 #include "tile/codegen/tidy.h"
 #include "tile/codegen/tile.h"
 #include "tile/math/util.h"
@@ -336,7 +337,7 @@ void CollectBankInfo(std::map<std::string, BankInfo>* bank_infos,  //
       dim_pos = i;
     }
   }
-  if (VLOG_IS_ON(2)) {
+  if (IVLOG_IS_ON(2)) {
     if (dim_pos) {
       IVLOG(2, "    dim_pos: " << *dim_pos << ", base_ref: " << *big_alias.base_ref);
     } else {
@@ -364,6 +365,114 @@ void CollectBankInfo(std::map<std::string, BankInfo>* bank_infos,  //
   base_ref->bank_dim = BankDimension{bank_info.dim_pos};
 }
 
+// The bytes of the block's tensors touched by a tile of its iteration space.
+uint64_t Footprint(const Block& block, const std::map<std::string, size_t>& tile_by_name) {
+  uint64_t total = 0;
+  for (const auto& ref : block.refs) {
+    if (ref.dir != RefDir::None) {
+      total += ref.ApplyTile(tile_by_name).byte_size();
+    }
+  }
+  return total;
+}
+
+struct StreamPlan {
+  std::string idx_name;
+  size_t tile;
+  size_t num_slices;
+};
+
+// Picks the index to slice a block along, and the largest slice for which num_buffers slices fit within mem_limit
+// bytes, preferring the plan with the fewest slices.  Only indexes which select a disjoint part of every output are
+// candidates, so that each slice's results can be written back independently.
+std::optional<StreamPlan> PlanStream(const Block& block, uint64_t mem_limit, uint64_t num_buffers) {
+  std::map<std::string, size_t> tile_by_name;
+  for (const auto& idx : block.idxs) {
+    tile_by_name[idx.name] = idx.range;
+  }
+  if (Footprint(block, tile_by_name) <= mem_limit) {
+    return std::nullopt;
+  }
+  std::optional<StreamPlan> best;
+  for (const auto& idx : block.idxs) {
+    if (idx.range < 2 || idx.affine != Affine{}) {
+      continue;
+    }
+    bool splits_outputs = true;
+    for (const auto& ref : block.ref_outs(true)) {
+      if (!ref->FlatAccess().get(idx.name)) {
+        splits_outputs = false;
+      }
+    }
+    if (!splits_outputs) {
+      continue;
+    }
+    // The footprint grows with the slice, so search for the largest slice that fits.
+    auto fits = [&](size_t tile) {
+      auto tile_map = tile_by_name;
+      tile_map[idx.name] = tile;
+      return Footprint(block, tile_map) * num_buffers <= mem_limit;
+    };
+    if (!fits(1)) {
+      continue;
+    }
+    size_t lo = 1;
+    size_t hi = idx.range - 1;
+    while (lo < hi) {
+      size_t mid = lo + (hi - lo + 1) / 2;
+      if (fits(mid)) {
+        lo = mid;
+      } else {
+        hi = mid - 1;
+      }
+    }
+    size_t num_slices = math::RoundUp(idx.range, lo);
+    if (!best || num_slices < best->num_slices) {
+      best = StreamPlan{idx.name, lo, num_slices};
+    }
+  }
+  return best;
+}
+
+void StreamBlock(const AliasMap& map, Block* block, const proto::StreamMemoryPass& options, const Tags& set_tags) {
+  auto plan = PlanStream(*block, options.mem_limit(), options.double_buffer() ? 2 : 1);
+  if (!plan) {
+    IVLOG(2, "Stream> skipped " << block->name << ": it fits in memory, or has no index to slice it along");
+    return;
+  }
+  IVLOG(2, "Stream> " << block->name << ": " << plan->num_slices << " slices of " << plan->tile << " along "
+                      << plan->idx_name);
+  if (!map.parent_alias_map()) {
+    throw_with_trace(std::runtime_error(str(boost::format("Cannot stream the root block %1%") % block->name)));
+  }
+  TileShape tile;
+  for (const auto& idx : block->idxs) {
+    tile.push_back(idx.name == plan->idx_name ? plan->tile : idx.range);
+  }
+  ApplyTile(block, tile, false);
+
+  // The outer block now iterates over the slices, and its refinements are views of one slice.
+  auto mem_loc = stripe::FromProto(options.mem_loc());
+  auto xfer_loc = stripe::FromProto(options.xfer_loc());
+  AliasMap outer_map(*map.parent_alias_map(), block);
+  auto refs = block->refs;
+  bool has_inputs = false;
+  for (const auto& ref : refs) {
+    auto dir = ref.dir;
+    // A slice which aggregates into its output must start from the output's current contents.
+    if (dir == RefDir::Out && !ref.agg_op.empty() && ref.agg_op != Intrinsic::ASSIGN) {
+      dir = RefDir::InOut;
+    }
+    has_inputs |= IsReadDir(dir);
+    ApplySimpleCache(outer_map, dir, block, ref.into(), mem_loc, xfer_loc,  //
+                     {"cache", "cache_load", "stream"}, {"cache", "cache_store", "stream"});
+  }
+  if (options.double_buffer() && has_inputs) {
+    ApplyDoubleBuffer(block, plan->idx_name);
+  }
+  block->add_tags(set_tags);
+}
+
 }  // namespace
 
 void PartitionMemoryPass::Apply(CompilerState* state) const {
@@ -379,9 +488,18 @@ void PartitionMemoryPass::Apply(CompilerState* state) const {
   });
 }
 
+void StreamMemoryPass::Apply(CompilerState* state) const {
+  auto reqs = FromProto(options_.reqs());
+  auto set_tags = FromProto(options_.set_tags());
+  RunOnBlocks(state->entry(), reqs, [&](const AliasMap& map, Block* block) {  //
+    StreamBlock(map, block, options_, set_tags);
+  });
+}
+
 namespace {
 [[gnu::unused]] char reg = []() -> char {
   CompilePassFactory<PartitionMemoryPass, proto::PartitionMemoryPass>::Register();
+  CompilePassFactory<StreamMemoryPass, proto::StreamMemoryPass>::Register();
   return 0;
 }();
 }  // namespace
@@ -18,6 +18,15 @@ class PartitionMemoryPass final : public CompilePass {
   proto::PartitionMemoryPass options_;
 };
 
+class StreamMemoryPass final : public CompilePass {
+ public:
+  explicit StreamMemoryPass(const proto::StreamMemoryPass& options) : options_{options} {}
+  void Apply(CompilerState* state) const final;
+
+ private:
+  proto::StreamMemoryPass options_;
+};
+
 }  // namespace codegen
 }  // namespace tile
 }  // namespace vertexai
@@ -1,7 +1,9 @@
 // Copyright 2019, Intel Corp.
 
 #include <algorithm>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <regex>
 #include <string>
 #include <utility>
@@ -11,6 +13,7 @@
 
 #include "base/util/stream_container.h"
 #include "tile/codegen/alias.h"
+#include "tile/codegen/analysis.h"
 #include "tile/codegen/pattern.h"
 
 namespace vertexai {
@@ -226,24 +229,25 @@ std::ostream& operator<<(std::ostream& os, const std::vector<Term>& terms) {
   return os;
 }
 
+static Atom DirAtom(RefDir dir) {
+  switch (dir) {
+    case RefDir::In:
+      return "in";
+    case RefDir::Out:
+      return "out";
+    case RefDir::InOut:
+      return "inout";
+    default:
+      throw std::runtime_error("Invalid dir");
+  }
+}
+
 Term IntoTerm(const Block& block) {
   auto p_block = std::make_shared<Struct>("block");
   auto refs_list = std::make_shared<List>();
   for (const auto& ref : block.refs) {
     auto p_ref = std::make_shared<Struct>("ref");
-    switch (ref.dir) {
-      case RefDir::In:
-        p_ref->args.emplace_back("in");
-        break;
-      case RefDir::Out:
-        p_ref->args.emplace_back("out");
-        break;
-      case RefDir::InOut:
-        p_ref->args.emplace_back("inout");
-        break;
-      default:
-        throw std::runtime_error("Invalid dir");
-    }
+    p_ref->args.emplace_back(DirAtom(ref.dir));
     auto dims_list = std::make_shared<List>();
     for (size_t i = 0; i < ref.access.size(); i++) {
       auto p_dim = std::make_shared<Struct>("dim");
@@ -283,13 +287,6 @@ Term IntoTerm(const Block& block) {
   return std::move(p_block);
 }
 
-struct TermCompare {
-  bool operator()(const Term& lhs, const Term& rhs) {
-    // N.B.: This isn't the best way to do this but it should work for now.
-    return to_string(lhs) < to_string(rhs);
-  }
-};
-
 // lhs is always the pattern.
 // rhs is always the value to match against.
 class MatchVisitor {
@@ -317,17 +314,35 @@ class MatchVisitor {
   }
 
   bool operator()(const std::shared_ptr<Set>& lhs, const std::shared_ptr<List>& rhs) {
-    std::sort(rhs->elts.begin(), rhs->elts.end(), TermCompare());
+    if (lhs->elts.size() != rhs->elts.size()) {
+      return false;
+    }
+    // Permute indices into the value rather than the value itself, so that values (which may be cached) are never
+    // modified, and order them by their printed form once instead of on every comparison.
+    std::vector<std::string> keys;
+    for (const auto& elt : rhs->elts) {
+      keys.emplace_back(to_string(elt));
+    }
+    auto less = [&](size_t a, size_t b) { return keys[a] < keys[b]; };
+    std::vector<size_t> order(keys.size());
+    for (size_t i = 0; i < order.size(); i++) {
+      order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), less);
+    std::vector<Term> elts(order.size());
     std::list<MatchResult> merged;
     do {
+      for (size_t i = 0; i < order.size(); i++) {
+        elts[i] = rhs->elts[order[i]];
+      }
       MatchVisitor branch(*this);
-      if (compare_terms(&branch, lhs->elts, rhs->elts)) {
+      if (compare_terms(&branch, lhs->elts, elts)) {
         // TODO: handle duplicates when merging branches
         for (const auto& match : branch.matches()) {
           merged.emplace_back(match);
         }
       }
-    } while (std::next_permutation(rhs->elts.begin(), rhs->elts.end(), TermCompare()));
+    } while (std::next_permutation(order.begin(), order.end(), less));
     choices_ = merged;
     return choices_.size();
   }
@@ -390,6 +405,122 @@ std::list<MatchResult> MatchAll(const Term& pattern, const Term& value) {
   return std::list<MatchResult>{};
 }
 
+Signature BlockSignature(const Block& block) {
+  Signature sig;
+  for (const auto& ref : block.refs) {
+    sig.refs.emplace_back(DirAtom(ref.dir), ref.access.size());
+  }
+  for (const auto& idx : block.idxs) {
+    if (idx.affine == Affine{}) {
+      sig.idxs++;
+    }
+  }
+  return sig;
+}
+
+// Returns the elements of a list or set term, or nullptr for anything else (such as a variable).
+static const std::vector<Term>* Elements(const Term& term) {
+  if (auto list = std::get_if<std::shared_ptr<List>>(&term)) {
+    return &(*list)->elts;
+  }
+  if (auto set = std::get_if<std::shared_ptr<Set>>(&term)) {
+    return &(*set)->elts;
+  }
+  return nullptr;
+}
+
+Matcher::Matcher(const std::string& code) : pattern_{Parse(code)} {
+  // Patterns which aren't shaped like IntoTerm's output are left unconstrained, so they behave exactly as before.
+  auto block = std::get_if<std::shared_ptr<Struct>>(&pattern_);
+  if (!block || (*block)->functor != "block" || (*block)->args.size() != 2) {
+    return;
+  }
+  is_block_ = true;
+  const auto& args = (*block)->args;
+  if (auto refs = Elements(args[0])) {
+    refs_.emplace();
+    refs_ordered_ = std::holds_alternative<std::shared_ptr<List>>(args[0]);
+    for (const auto& ref_term : *refs) {
+      RefFilter filter;
+      auto ref = std::get_if<std::shared_ptr<Struct>>(&ref_term);
+      if (ref && (*ref)->functor == "ref" && (*ref)->args.size() == 2) {
+        if (auto dir = std::get_if<Atom>(&(*ref)->args[0])) {
+          filter.dir = *dir;
+        }
+        if (auto dims = Elements((*ref)->args[1])) {
+          filter.ndims = dims->size();
+        }
+      }
+      refs_->emplace_back(filter);
+    }
+  }
+  if (auto idxs = Elements(args[1])) {
+    idxs_ = idxs->size();
+  }
+}
+
+std::shared_ptr<const Matcher> Matcher::Get(const std::string& code) {
+  static std::mutex mu;
+  static std::map<std::string, std::shared_ptr<const Matcher>> matchers;
+  std::lock_guard<std::mutex> lock{mu};
+  auto& matcher = matchers[code];
+  if (!matcher) {
+    matcher = std::make_shared<Matcher>(code);
+  }
+  return matcher;
+}
+
+bool Matcher::Admits(const Signature& sig) const {
+  if (!is_block_) {
+    return true;
+  }
+  if (idxs_ && *idxs_ != sig.idxs) {
+    return false;
+  }
+  if (!refs_) {
+    return true;
+  }
+  if (refs_->size() != sig.refs.size()) {
+    return false;
+  }
+  auto admits = [](const RefFilter& filter, const std::pair<Atom, size_t>& ref) {
+    return (!filter.dir || *filter.dir == ref.first) && (!filter.ndims || *filter.ndims == ref.second);
+  };
+  if (refs_ordered_) {
+    for (size_t i = 0; i < refs_->size(); i++) {
+      if (!admits(refs_->at(i), sig.refs[i])) {
+        return false;
+      }
+    }
+    return true;
+  }
+  // For a set of refinements, each filter must be satisfied by some refinement, and no more filters may share a
+  // constraint than there are refinements satisfying it.  This is necessary (but not sufficient) for a match, which
+  // is all a prefilter needs.
+  for (const auto& filter : *refs_) {
+    size_t needed = 0;
+    for (const auto& other : *refs_) {
+      bool implied = (!filter.dir || (other.dir && *other.dir == *filter.dir)) &&
+                     (!filter.ndims || (other.ndims && *other.ndims == *filter.ndims));
+      needed += implied;
+    }
+    size_t available = std::count_if(sig.refs.begin(), sig.refs.end(), [&](const auto& ref) {  //
+      return admits(filter, ref);
+    });
+    if (available < needed) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::optional<MatchResult> Matcher::MatchFirst(const Signature& sig, const Term& value) const {
+  if (!Admits(sig)) {
+    return std::nullopt;
+  }
+  return pattern::MatchFirst(pattern_, value);
+}
+
 std::string to_string(const MatchResult& result) {
   std::stringstream ss;
   ss << StreamContainer(result.vars);
@@ -406,12 +537,26 @@ std::vector<std::string> to_string(const std::list<MatchResult>& results) {
 
 }  // namespace pattern
 
+namespace {
+
+// A block's term and signature, cached across pattern passes for as long as the block's refinements and indexes are
+// unchanged.
+struct BlockTerm {
+  BlockTerm(const AliasMap& map, Block* block)
+      : term{pattern::IntoTerm(*block)}, sig{pattern::BlockSignature(*block)} {}
+
+  pattern::Term term;
+  pattern::Signature sig;
+};
+
+}  // namespace
+
 void PatternPass::Apply(CompilerState* state) const {
   auto reqs = FromProto(options_.reqs());
-  auto pattern = pattern::Parse(options_.pattern());
-  RunOnBlocks(state->entry(), reqs, [&](const AliasMap& map, Block* block) {
-    auto term = pattern::IntoTerm(*block);
-    auto match = pattern::MatchFirst(pattern, term);
+  auto matcher = pattern::Matcher::Get(options_.pattern());
+  RunOnBlocks(state, reqs, [&](const AliasMap& map, Block* block) {
+    const auto& cached = state->analyses->Get<BlockTerm>(map);
+    auto match = matcher->MatchFirst(cached.sig, cached.term);
     if (match) {
       IVLOG(2, "PatternPass> block: " << block->name);
       for (const auto& kvp : options_.set_vars()) {
@@ -8,6 +8,7 @@
 #include <optional>
 #include <sstream>
 #include <string>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -88,6 +89,46 @@ Term Parse(const std::string& code);
 // ])
 Term IntoTerm(const stripe::Block& block);
 
+// The shape of a block which a pattern must agree with to have any chance of matching it: the direction and number
+// of dimensions of each refinement, in order, and the number of (non-affine) indexes.
+struct Signature {
+  std::vector<std::pair<Atom, size_t>> refs;
+  size_t idxs = 0;
+};
+
+Signature BlockSignature(const stripe::Block& block);
+
+// A parsed pattern along with the constraints it places on the signature of the blocks it can match.  Checking the
+// signature is cheap, and lets the caller skip the full unification for the (usually many) blocks that can't match.
+class Matcher {
+ public:
+  explicit Matcher(const std::string& code);
+
+  // Returns the matcher for the given pattern, parsing it only the first time it's seen in this process.
+  static std::shared_ptr<const Matcher> Get(const std::string& code);
+
+  const Term& pattern() const { return pattern_; }
+
+  // Returns false if no block with the given signature can match the pattern.
+  bool Admits(const Signature& sig) const;
+
+  // Attempts to match the pattern against the term of a block with the given signature.
+  std::optional<MatchResult> MatchFirst(const Signature& sig, const Term& value) const;
+
+ private:
+  // A constraint on a refinement; unset fields (from variables in the pattern) match anything.
+  struct RefFilter {
+    std::optional<Atom> dir;
+    std::optional<size_t> ndims;
+  };
+
+  Term pattern_;
+  bool is_block_ = false;
+  std::optional<std::vector<RefFilter>> refs_;
+  bool refs_ordered_ = false;
+  std::optional<size_t> idxs_;
+};
+
 std::ostream& operator<<(std::ostream& os, const Term& term);
 
 inline std::string to_string(const Term& term) {
@@ -104,6 +145,7 @@ std::vector<std::string> to_string(const std::list<MatchResult>& results);
 class PatternPass final : public CompilePass {
  public:
   explicit PatternPass(const proto::PatternPass& options) : options_{options} {}
+  bool preserves_analyses() const final { return true; }
   void Apply(CompilerState* state) const final;
 
  private:
@@ -0,0 +1,242 @@
+// Copyright 2020, Intel Corporation
+
+#include "tile/codegen/peel.h"
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/format.hpp>
+
+#include "base/util/any_factory_map.h"
+
+namespace vertexai {
+namespace tile {
+namespace codegen {
+
+using namespace stripe;  // NOLINT
+
+namespace {
+
+// The constraints of a block and its sub-blocks, in terms of the block's indexes and the sub-blocks' own indexes,
+// which are prefixed to tell them apart.
+struct Constraints {
+  struct Entry {
+    Block* owner;
+    size_t pos;
+    Affine poly;
+  };
+
+  explicit Constraints(Block* block) {
+    for (const auto& idx : block->idxs) {
+      if (idx.affine == Affine{}) {
+        ranges[idx.name] = idx.range;
+      }
+    }
+    for (size_t pos = 0; pos < block->constraints.size(); pos++) {
+      entries.push_back(Entry{block, pos, block->constraints[pos]});
+    }
+    size_t count = 0;
+    for (const auto& stmt : block->stmts) {
+      auto inner = Block::Downcast(stmt);
+      if (!inner || inner->constraints.empty()) {
+        continue;
+      }
+      auto prefix = str(boost::format("%1%:") % count++);
+      std::map<std::string, Affine> sources;
+      for (const auto& idx : inner->idxs) {
+        if (idx.affine == Affine{}) {
+          sources[idx.name] = Affine(prefix + idx.name);
+          ranges[prefix + idx.name] = idx.range;
+        } else {
+          sources[idx.name] = idx.affine;
+        }
+      }
+      for (size_t pos = 0; pos < inner->constraints.size(); pos++) {
+        entries.push_back(Entry{inner.get(), pos, inner->constraints[pos].sym_eval(sources)});
+      }
+    }
+  }
+
+  // Gets the smallest value of poly over the ranges of its indexes, if they're all known.
+  bool Min(const Affine& poly, int64_t* min) const {
+    *min = 0;
+    for (const auto& kvp : poly.getMap()) {
+      if (kvp.first.empty()) {
+        *min += kvp.second;
+        continue;
+      }
+      auto it = ranges.find(kvp.first);
+      if (it == ranges.end()) {
+        return false;
+      }
+      if (kvp.second < 0) {
+        *min += kvp.second * static_cast<int64_t>(it->second - 1);
+      }
+    }
+    return true;
+  }
+
+  std::vector<Entry> entries;
+  std::map<std::string, uint64_t> ranges;
+};
+
+// Whether the iterations of block which differ in idx write disjoint elements, so that they may be split between
+// blocks without turning a write into a reduction.
+bool WritesDisjoint(const Block& block, const std::string& idx) {
+  auto outs = block.ref_outs(true);
+  for (const auto& ref : outs) {
+    if (ref->FlatAccess().get(idx) == 0) {
+      return false;
+    }
+  }
+  return !outs.empty();
+}
+
+// Finds the range [lo, hi) of idx over which every constraint on idx always holds, if it's a proper part of idx's
+// range.
+bool InteriorRange(Block* block, const Index& idx, uint64_t* lo, uint64_t* hi) {
+  Constraints constraints(block);
+  int64_t first = 0;
+  int64_t limit = idx.range;
+  for (const auto& entry : constraints.entries) {
+    auto coeff = entry.poly.get(idx.name);
+    int64_t min;
+    if (coeff == 0 || !constraints.Min(entry.poly - Affine(idx.name, coeff), &min)) {
+      continue;
+    }
+    if (coeff > 0) {
+      // coeff * idx + min >= 0
+      first = std::max(first, min >= 0 ? 0 : (-min + coeff - 1) / coeff);
+    } else {
+      // min >= -coeff * idx
+      limit = std::min(limit, min < 0 ? 0 : min / -coeff + 1);
+    }
+  }
+  *lo = first;
+  *hi = limit;
+  return first < limit && (first > 0 || limit < static_cast<int64_t>(idx.range));
+}
+
+// Restricts idx of block to [start, start + range), by renumbering it from zero.
+void Restrict(Block* block, const std::string& name, uint64_t start, uint64_t range) {
+  block->idx_by_name(name)->range = range;
+  if (!start) {
+    return;
+  }
+  auto shifted = Affine(name) + static_cast<int64_t>(start);
+  for (auto& ref : block->refs) {
+    for (auto& access : ref.mut().access) {
+      access.substitute(name, shifted);
+    }
+  }
+  for (auto& constraint : block->constraints) {
+    constraint.substitute(name, shifted);
+  }
+  for (const auto& stmt : block->stmts) {
+    auto load_index = LoadIndex::Downcast(stmt);
+    if (load_index) {
+      load_index->from.substitute(name, shifted);
+    }
+    auto inner = Block::Downcast(stmt);
+    if (inner) {
+      for (auto& idx : inner->idxs) {
+        idx.affine.substitute(name, shifted);
+      }
+    }
+  }
+}
+
+// Removes the constraints of block and its sub-blocks which always hold.
+void RemoveSatisfied(Block* block) {
+  Constraints constraints(block);
+  for (auto it = constraints.entries.rbegin(); it != constraints.entries.rend(); ++it) {
+    int64_t min;
+    if (constraints.Min(it->poly, &min) && min >= 0) {
+      auto& owned = it->owner->constraints;
+      owned.erase(owned.begin() + it->pos);
+    }
+  }
+}
+
+}  // namespace
+
+void PeelBoundaries(Block* parent, StatementIt pos) {
+  auto block = Block::Downcast(*pos);
+  auto next = std::next(pos);
+  std::vector<StatementIt> edges;
+  auto add_edge = [&](StatementIt at, const std::string& name, const std::string& suffix, uint64_t start,
+                      uint64_t range) {
+    auto edge = CloneBlock(*block);
+    edge->name = block->name + "_" + name + suffix;
+    edge->deps = block->deps;
+    Restrict(edge.get(), name, start, range);
+    RemoveSatisfied(edge.get());
+    edges.push_back(parent->stmts.insert(at, edge));
+  };
+  for (size_t i = 0; i < block->idxs.size(); i++) {
+    auto name = block->idxs[i].name;
+    auto range = block->idxs[i].range;
+    uint64_t lo;
+    uint64_t hi;
+    if (block->idxs[i].affine != Affine{} || !WritesDisjoint(*block, name) ||
+        !InteriorRange(block.get(), block->idxs[i], &lo, &hi)) {
+      continue;
+    }
+    IVLOG(3, "Peeling " << block->name << " on " << name << ": interior [" << lo << ", " << hi << ") of " << range);
+    if (lo > 0) {
+      add_edge(pos, name, "_lo", 0, lo);
+    }
+    if (hi < range) {
+      add_edge(next, name, "_hi", hi, range - hi);
+    }
+    Restrict(block.get(), name, lo, hi - lo);
+  }
+  RemoveSatisfied(block.get());
+  if (edges.empty()) {
+    return;
+  }
+  // Whatever waited for the block now waits for its edges as well.
+  for (auto& stmt : parent->stmts) {
+    if (std::find(stmt->deps.begin(), stmt->deps.end(), pos) != stmt->deps.end()) {
+      stmt->deps.insert(stmt->deps.end(), edges.begin(), edges.end());
+    }
+  }
+}
+
+void PeelPass::Apply(CompilerState* state) const {
+  auto reqs = stripe::FromProto(options_.reqs());
+  // Collect the blocks up front, so that their edges aren't peeled in turn.
+  std::vector<std::pair<Block*, StatementIt>> found;
+  std::function<void(Block*)> collect = [&](Block* parent) {
+    for (auto it = parent->stmts.begin(); it != parent->stmts.end(); ++it) {
+      auto inner = Block::Downcast(*it);
+      if (!inner) {
+        continue;
+      }
+      if (inner->has_tags(reqs)) {
+        found.emplace_back(parent, it);
+      } else {
+        collect(inner.get());
+      }
+    }
+  };
+  collect(state->entry());
+  for (const auto& kvp : found) {
+    PeelBoundaries(kvp.first, kvp.second);
+  }
+}
+
+namespace {
+[[gnu::unused]] char reg = []() -> char {
+  CompilePassFactory<PeelPass, proto::PeelPass>::Register();
+  return 0;
+}();
+}  // namespace
+
+}  // namespace codegen
+}  // namespace tile
+}  // namespace vertexai
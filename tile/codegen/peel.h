@@ -0,0 +1,30 @@
+// Copyright 2020, Intel Corporation
+
+#pragma once
+
+#include "tile/codegen/alias.h"
+#include "tile/codegen/codegen.pb.h"
+#include "tile/codegen/compile_pass.h"
+#include "tile/stripe/stripe.h"
+
+namespace vertexai {
+namespace tile {
+namespace codegen {
+
+// Peels the boundary iterations of the block at pos in parent into separate blocks, so that the remaining interior
+// block's sub-blocks are free of the constraints which only the boundary needs.  Each of the block's indexes is
+// peeled in turn, from the interior left by the previous one.
+void PeelBoundaries(stripe::Block* parent, stripe::StatementIt pos);
+
+class PeelPass final : public CompilePass {
+ public:
+  explicit PeelPass(const proto::PeelPass& options) : options_{options} {}
+  void Apply(CompilerState* state) const final;
+
+ private:
+  proto::PeelPass options_;
+};
+
+}  // namespace codegen
+}  // namespace tile
+}  // namespace vertexai
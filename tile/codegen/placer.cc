@@ -2,14 +2,19 @@
 
 #include "tile/codegen/placer.h"
 
+#include <algorithm>
 #include <list>
+#include <queue>
 #include <set>
 #include <stack>
+#include <unordered_map>
+#include <vector>
 
 #include <boost/dynamic_bitset.hpp>
 #include <boost/graph/undirected_graph.hpp>
 
 #include "tile/base/shape.h"
+#include "base/util/logging.h"
 #include "tile/codegen/alias.h"
 #include "tile/math/util.h"
 #include "tile/stripe/stripe.h"
@@ -66,6 +71,16 @@
 //   we take the set of temporally-overlapping chunks, sort them by
 //   existing offset, and then walk the list in order, looking for the
 //   smallest free range that's big enough for the chunk.
+//
+// * Optionally (eltwise_inplace), an elementwise block may write its
+//   output chunk over one of its input chunks, when the input is dead
+//   once the block completes and both are accessed identically.  Such
+//   chunks are merged before the graph is built, and placed as one.
+//
+// * Likewise (reshape_inplace), a reshape may alias its output chunk to
+//   its input chunk, when the input is dead once the reshape completes.
+//   Since a reshape copies the bytes unchanged, the merged reshape is
+//   then a no-op; it's tagged "inplace" so that backends can skip it.
 
 namespace vertexai {
 namespace tile {
@@ -91,6 +106,7 @@ struct Chunk {
         subsequent_accessor_deps{stmt_limit} {}
 
   stripe::Refinement* ref;
+  std::vector<stripe::Refinement*> inplace_refs;  // Chunks sharing this chunk's memory
   std::size_t size;
   bool placed = false;
   bool saw_first_accessor = false;
@@ -101,6 +117,16 @@ struct Chunk {
   InterferenceGraph::vertex_descriptor interference_vertex;
 };
 
+// An elementwise block or reshape which might write the output chunk over the input chunk.
+struct InplaceCandidate {
+  std::size_t idx;
+  std::size_t stmt_count;
+  boost::dynamic_bitset<> transitive_deps;
+  Chunk* input;
+  Chunk* output;
+  stripe::Special* reshape;  // The reshape to elide, if the candidate is one
+};
+
 struct StmtInfo {
   StmtInfo(std::size_t idx_, std::size_t stmt_limit) : idx{idx_}, transitive_deps{stmt_limit} {}
 
@@ -180,8 +206,79 @@ class ChunkUseRecorder : public stripe::MutableStmtVisitor {
   stripe::Block* block_ = nullptr;
 };
 
+void FindInplaceCandidates(const stripe::Block& block, const AliasMap& alias_map, const StmtInfo& info,
+                           const std::unordered_map<std::string, Chunk*>& chunks,
+                           std::vector<InplaceCandidate>* candidates) {
+  if (!block.has_tag("eltwise")) {
+    return;
+  }
+  for (const auto& stmt : block.stmts) {
+    if (stmt->kind() == stripe::StmtKind::Block) {
+      return;
+    }
+  }
+  auto chunk_for = [&](const stripe::Refinement& ref) -> Chunk* {
+    auto it = chunks.find(alias_map.at(ref.into()).base_name);
+    return it == chunks.end() ? nullptr : it->second;
+  };
+  for (const auto& out : block.refs) {
+    if (out.dir != stripe::RefDir::Out) {
+      continue;
+    }
+    Chunk* output = chunk_for(out);
+    if (!output) {
+      continue;
+    }
+    const auto& out_info = alias_map.at(out.into());
+    // Whether an instance of the block reads exactly the bytes of the input chunk which it writes in the output, so
+    // that no instance overwrites another's input.
+    auto same_bytes = [&](const stripe::Refinement& in) {
+      return alias_map.at(in.into()).access == out_info.access && in.interior_shape == out.interior_shape;
+    };
+    for (const auto& in : block.refs) {
+      if (in.dir != stripe::RefDir::In) {
+        continue;
+      }
+      Chunk* input = chunk_for(in);
+      if (!input || input == output || !(input->ref->interior_shape == output->ref->interior_shape)) {
+        continue;
+      }
+      // Every read of the input chunk must qualify: a second view of it at another access (say, O[i] = A[i] + A[0])
+      // would read bytes which another instance has already overwritten.
+      bool all_same = true;
+      for (const auto& other : block.refs) {
+        if (other.dir != stripe::RefDir::Out && chunk_for(other) == input && !same_bytes(other)) {
+          all_same = false;
+          break;
+        }
+      }
+      if (all_same) {
+        candidates->emplace_back(
+            InplaceCandidate{info.idx, block.stmts.size(), info.transitive_deps, input, output, nullptr});
+        break;
+      }
+    }
+  }
+}
+
+void FindReshapeCandidate(stripe::Special* special, const AliasMap& alias_map, const StmtInfo& info,
+                          const std::unordered_map<std::string, Chunk*>& chunks,
+                          std::vector<InplaceCandidate>* candidates) {
+  if (special->name != "reshape" || special->inputs.size() != 1 || special->outputs.size() != 1) {
+    return;
+  }
+  auto input = chunks.find(alias_map.at(special->inputs[0]).base_name);
+  auto output = chunks.find(alias_map.at(special->outputs[0]).base_name);
+  if (input == chunks.end() || output == chunks.end() || input->second == output->second) {
+    return;
+  }
+  candidates->emplace_back(InplaceCandidate{info.idx, 0, info.transitive_deps, input->second, output->second, special});
+}
+
 std::list<Chunk> BuildChunkList(stripe::Block* outermost_block, const std::set<stripe::Location>& locations,
-                                std::size_t alignment, std::size_t stmt_limit, const stripe::Tags& skip_tags) {
+                                std::size_t alignment, std::size_t stmt_limit, const stripe::Tags& skip_tags,
+                                const proto::MemoryPlacementPass& options,
+                                std::vector<InplaceCandidate>* inplace_candidates) {
   // This function:
   //
   // * Logically numbers each statement within the block
@@ -240,11 +337,19 @@ std::list<Chunk> BuildChunkList(stripe::Block* outermost_block, const std::set<s
       }
       ChunkUseRecorder recorder{&info, alias_map, &chunks};
       (*it)->Accept(&recorder);
+      if (options.reshape_inplace()) {
+        if (auto special = stripe::Special::Downcast(*it)) {
+          FindReshapeCandidate(special.get(), *alias_map, info, chunks, inplace_candidates);
+        }
+      }
       ++it;
       if (recorder.block()) {
         stripe::Block* sub_block = recorder.block();
         todo.emplace(ToDo{sub_block, sub_block->stmts.begin(), AliasMap{*alias_map, sub_block}});
         add_block_chunks(sub_block, todo.top().alias_map);
+        if (options.eltwise_inplace()) {
+          FindInplaceCandidates(*sub_block, todo.top().alias_map, info, chunks, inplace_candidates);
+        }
         break;
       }
     }
@@ -274,9 +379,49 @@ std::size_t CountStatements(stripe::Block* outermost_block) {
   return result;
 }
 
+// Merges the output chunk of each in-place candidate into its input chunk
+// when that is safe: every other accessor of the input must be known to have
+// completed before the block (or reshape) runs, and the output must not be
+// used before it.  Returns the number of chunks merged away.
+std::size_t MergeInplaceChunks(const std::vector<InplaceCandidate>& candidates, std::list<Chunk>* chunks) {
+  std::unordered_map<Chunk*, Chunk*> merged_into;
+  auto find = [&](Chunk* chunk) {
+    for (auto it = merged_into.find(chunk); it != merged_into.end(); it = merged_into.find(chunk)) {
+      chunk = it->second;
+    }
+    return chunk;
+  };
+  for (const auto& candidate : candidates) {
+    Chunk* input = find(candidate.input);
+    Chunk* output = find(candidate.output);
+    if (input == output || input->size != output->size || input->ref->location != output->ref->location ||
+        output->first_accessor_idx != candidate.idx) {
+      continue;
+    }
+    boost::dynamic_bitset<> allowed = candidate.transitive_deps;
+    for (std::size_t idx = candidate.idx; idx <= candidate.idx + candidate.stmt_count; idx++) {
+      allowed.set(idx);
+    }
+    if (!input->accessors.is_subset_of(allowed)) {
+      continue;
+    }
+    IVLOG(3, "Placing " << output->ref->into() << " in place of " << input->ref->into());
+    if (candidate.reshape) {
+      candidate.reshape->set_tag("inplace");
+    }
+    input->accessors |= output->accessors;
+    input->transitive_accessor_deps &= output->transitive_accessor_deps;
+    input->inplace_refs.push_back(output->ref);
+    input->inplace_refs.insert(input->inplace_refs.end(), output->inplace_refs.begin(), output->inplace_refs.end());
+    merged_into[output] = input;
+  }
+  chunks->remove_if([&](const Chunk& chunk) { return merged_into.count(const_cast<Chunk*>(&chunk)); });
+  return merged_into.size();
+}
+
 }  // namespace
 
-void PlaceRefinements(stripe::Block* outermost_block, const proto::MemoryPlacementPass& options) {
+PlacementReport PlaceRefinements(stripe::Block* outermost_block, const proto::MemoryPlacementPass& options) {
   std::set<stripe::Location> locations;
   for (const auto& loc : options.locs()) {
     locations.emplace(stripe::FromProto(loc));
@@ -286,14 +431,25 @@ void PlaceRefinements(stripe::Block* outermost_block, const proto::MemoryPlaceme
   auto alignment = options.alignment() ? options.alignment() : kDefaultAlignment;
   auto skip_tags = stripe::FromProto(options.skip_tags());
 
-  std::list<Chunk> chunks = BuildChunkList(outermost_block, locations, alignment, stmt_limit, skip_tags);
+  std::vector<InplaceCandidate> inplace_candidates;
+  std::list<Chunk> chunks =
+      BuildChunkList(outermost_block, locations, alignment, stmt_limit, skip_tags, options, &inplace_candidates);
+
+  PlacementReport report;
+  for (const auto& chunk : chunks) {
+    auto& arena = report.arenas[chunk.ref->location];
+    arena.chunks++;
+    arena.total_bytes += chunk.size;
+  }
 
   // Edge case: no chunks means nothing to do.  And then after this,
   // we can assume there's at least one chunk.
   if (!chunks.size()) {
-    return;
+    return report;
   }
 
+  report.inplace = MergeInplaceChunks(inplace_candidates, &chunks);
+
   // Ensure chunks are sorted by earliest accessor.
   chunks.sort([](const Chunk& lhs, const Chunk& rhs) { return lhs.first_accessor_idx < rhs.first_accessor_idx; });
 
@@ -423,13 +579,29 @@ void PlaceRefinements(stripe::Block* outermost_block, const proto::MemoryPlaceme
     chunk.ref->offset = gap_offset;
     chunk.ref->set_tag("placed");
     chunk.placed = true;
+    for (auto* ref : chunk.inplace_refs) {
+      ref->offset = gap_offset;
+      ref->set_tag("placed");
+    }
+    auto& arena = report.arenas[chunk.ref->location];
+    arena.peak_bytes = std::max(arena.peak_bytes, gap_offset + chunk.size);
   }
+
+  return report;
 }
 
 void MemoryPlacementPass::Apply(CompilerState* state) const {
   auto reqs = stripe::FromProto(options_.reqs());
-  RunOnBlocks(state->entry(), reqs,
-              [&](const AliasMap& map, stripe::Block* block) { PlaceRefinements(block, options_); });
+  RunOnBlocks(state->entry(), reqs, [&](const AliasMap& map, stripe::Block* block) {
+    auto report = PlaceRefinements(block, options_);
+    for (const auto& kvp : report.arenas) {
+      IVLOG(1, "Placed " << kvp.second.chunks << " buffers in " << kvp.first << " of block " << block->name << ": "
+                         << kvp.second.peak_bytes << " bytes peak, " << kvp.second.total_bytes << " bytes total");
+    }
+    if (report.inplace) {
+      IVLOG(1, "  " << report.inplace << " buffers placed in place of an elementwise or reshape input");
+    }
+  });
 }
 
 namespace {
@@ -2,6 +2,8 @@
 
 #pragma once
 
+#include <map>
+
 #include "tile/codegen/codegen.pb.h"
 #include "tile/codegen/compile_pass.h"
 #include "tile/stripe/stripe.h"
@@ -10,10 +12,24 @@ namespace vertexai {
 namespace tile {
 namespace codegen {
 
+// The memory used by the buffers placed in each location: peak_bytes is the
+// size of the arena after packing, and total_bytes what it would be if no two
+// buffers shared memory.
+struct PlacementReport {
+  struct Arena {
+    std::size_t chunks = 0;
+    std::size_t total_bytes = 0;
+    std::size_t peak_bytes = 0;
+  };
+  std::map<stripe::Location, Arena> arenas;
+  // The number of buffers which reuse the memory of an elementwise or reshape input.
+  std::size_t inplace = 0;
+};
+
 // Assigns locations to all Refinements within a Block, including all
 // nested sub-Blocks.  Note that all dependencies for the block and
 // sub-blocks should be established when this function is called.
-void PlaceRefinements(stripe::Block* outermost_block, const proto::MemoryPlacementPass& options);
+PlacementReport PlaceRefinements(stripe::Block* outermost_block, const proto::MemoryPlacementPass& options);
 
 class MemoryPlacementPass final : public CompilePass {
  public:
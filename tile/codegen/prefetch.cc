@@ -0,0 +1,77 @@
+// Copyright 2020, Intel Corporation
+
+#include "tile/codegen/prefetch.h"
+
+#include <set>
+#include <string>
+
+#include "base/util/any_factory_map.h"
+
+namespace vertexai {
+namespace tile {
+namespace codegen {
+
+using namespace stripe;  // NOLINT
+
+void InsertPrefetches(Block* block, const proto::PrefetchPass& options) {
+  if (block->has_tag("xsmm")) {
+    return;
+  }
+  // Blocks are lowered to loop nests with their last index innermost.
+  const Index* inner = nullptr;
+  for (const auto& idx : block->idxs) {
+    if (idx.range > 1 && idx.affine == Affine{}) {
+      inner = &idx;
+    }
+  }
+  if (!inner) {
+    return;
+  }
+  std::set<std::string> loaded;
+  std::set<std::string> prefetched;
+  for (const auto& stmt : block->stmts) {
+    auto load = Load::Downcast(stmt);
+    if (load) {
+      loaded.insert(load->from);
+    }
+    auto special = Special::Downcast(stmt);
+    if (special && special->name == "prefetch") {
+      prefetched.insert(special->inputs.begin(), special->inputs.end());
+    }
+  }
+  for (const auto& ref : block->refs) {
+    if (!loaded.count(ref.into()) || prefetched.count(ref.into())) {
+      continue;
+    }
+    auto stride = ref.FlatAccess().get(inner->name);
+    auto stride_bytes = std::abs(stride) * static_cast<int64_t>(byte_width(ref.interior_shape.type));
+    if (stride_bytes < options.min_stride()) {
+      continue;
+    }
+    IVLOG(3, "Prefetching " << ref.into() << " in " << block->name << ": " << stride_bytes << " bytes per "
+                            << inner->name);
+    auto prefetch = std::make_shared<Special>();
+    prefetch->name = "prefetch";
+    prefetch->inputs.push_back(ref.into());
+    prefetch->int_params["offset"] = options.distance() * stride;
+    prefetch->int_params["locality"] = options.locality();
+    block->stmts.push_front(prefetch);
+  }
+}
+
+void PrefetchPass::Apply(CompilerState* state) const {
+  auto reqs = stripe::FromProto(options_.reqs());
+  RunOnBlocks(state->entry(), reqs, [this](const AliasMap& map, Block* block) {  //
+    InsertPrefetches(block, options_);
+  });
+}
+
+namespace {
+[[gnu::unused]] char reg = []() -> char {
+  CompilePassFactory<PrefetchPass, proto::PrefetchPass>::Register();
+  return 0;
+}();
+}  // namespace
+}  // namespace codegen
+}  // namespace tile
+}  // namespace vertexai
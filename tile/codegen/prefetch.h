@@ -0,0 +1,29 @@
+// Copyright 2020, Intel Corporation
+
+#pragma once
+
+#include "tile/codegen/alias.h"
+#include "tile/codegen/codegen.pb.h"
+#include "tile/codegen/compile_pass.h"
+#include "tile/stripe/stripe.h"
+
+namespace vertexai {
+namespace tile {
+namespace codegen {
+
+// Inserts a "prefetch" special at the top of block for each refinement it loads with a large stride along its
+// innermost index.  The special's "offset" is in elements, relative to the refinement's current element.
+void InsertPrefetches(stripe::Block* block, const proto::PrefetchPass& options);
+
+class PrefetchPass final : public CompilePass {
+ public:
+  explicit PrefetchPass(const proto::PrefetchPass& options) : options_{options} {}
+  void Apply(CompilerState* state) const final;
+
+ private:
+  proto::PrefetchPass options_;
+};
+
+}  // namespace codegen
+}  // namespace tile
+}  // namespace vertexai
@@ -2,6 +2,8 @@
 
 #include "tile/codegen/reg_cache.h"
 
+#include <algorithm>
+
 #include "base/util/throw.h"
 #include "tile/math/bignum.h"
 #include "tile/stripe/stripe.h"
@@ -26,8 +28,61 @@ struct RegisterPassOptions {
   size_t reg_lat;
   std::string comp_parent_tag;
   bool cache_index_order;
+  size_t reg_file_size;
+  size_t max_threads;
+  double min_occupancy;
 };
 
+// Records the register bytes each thread of comp_parent uses for caching, so
+// that later candidates (and later passes) see what is already taken.
+const char kRegCacheBytes[] = "reg_cache_bytes";
+
+size_t RegisterBytesInUse(const Block& comp_parent) {
+  return comp_parent.has_attr(kRegCacheBytes) ? comp_parent.get_attr_int(kRegCacheBytes) : 0;
+}
+
+// The fraction of a unit's thread slots which can stay resident when each
+// thread holds reg_bytes of cached registers; 1 when no register file is
+// modeled.
+double Occupancy(size_t reg_bytes, const RegisterPassOptions& opt) {
+  if (!opt.reg_file_size || !opt.max_threads || !reg_bytes) {
+    return 1.0;
+  }
+  size_t resident = std::min(opt.max_threads, opt.reg_file_size / reg_bytes);
+  return static_cast<double>(resident) / opt.max_threads;
+}
+
+// Decides whether caching load_size more bytes per thread pays off.  Without
+// the cache each compute access goes to local memory and each cache access
+// to local and global memory; with it, compute accesses hit registers and the
+// new cache block loads from global memory.  Memory latencies are divided by
+// the occupancy, since fewer resident threads hide less of them; a candidate
+// which leaves the unit below min_occupancy, or pushes a thread past the
+// register budget, is rejected outright.
+bool RegisterCacheWorthwhile(const Block& comp_parent, size_t load_size,  //
+                             double comp_accesses, double cache_accesses, double new_cache_accesses,
+                             const RegisterPassOptions& opt) {
+  size_t in_use = opt.reg_file_size ? RegisterBytesInUse(comp_parent) : 0;
+  if (in_use + load_size > opt.reg_size) {
+    return false;
+  }
+  double occ_before = Occupancy(in_use, opt);
+  double occ_after = Occupancy(in_use + load_size, opt);
+  if (occ_after < opt.min_occupancy) {
+    IVLOG(3, "Register caching " << load_size << " bytes would drop occupancy to " << occ_after);
+    return false;
+  }
+  double before = (opt.lmem_lat * comp_accesses + (opt.lmem_lat + opt.gmem_lat) * cache_accesses) / occ_before;
+  double after = opt.reg_lat * (comp_accesses + new_cache_accesses) + opt.gmem_lat * new_cache_accesses / occ_after;
+  return before >= after;
+}
+
+void CommitRegisters(Block* comp_parent, size_t load_size, const RegisterPassOptions& opt) {
+  if (opt.reg_file_size) {
+    comp_parent->set_attr(kRegCacheBytes, static_cast<int64_t>(RegisterBytesInUse(*comp_parent) + load_size));
+  }
+}
+
 // Get the outer and inner (outer's first sub-block) loop count
 void OuterInnerLoopCount(Block* outer, size_t* outer_loop, size_t* inner_loop) {
   *outer_loop = outer->idxs_product();
@@ -67,7 +122,7 @@ void FixRefLoc(const Refinement& src, const Refinement& dst) {
   dst.mut().location = src.location;
   dst.mut().offset = src.offset;
   for (size_t i = 0; i < dst.interior_shape.dims.size(); i++) {
-    dst.mut().interior_shape.dims[i].stride = src.interior_shape.dims[i].stride;
+    dst.mut().interior_shape.dims.set_stride(i, src.interior_shape.dims[i].stride);
   }
 }
 
@@ -257,10 +312,6 @@ bool ReferenceComputingBlock(const AliasMap& parent_map,          //
   auto comp_reg_shape = SimpleShape(tmp_reg_ref.interior_shape.type,
                                     comp_reg_sizes, tmp_reg_ref.interior_shape.layout);
 
-  if (load_size > opt.reg_size) {
-    return false;
-  }
-
   if (cache->has_tag("eltwise") &&
      !(CheckEltwiseAccess(cache, n_dim, *cache_outer_local_ref) &&
        CheckEltwiseAccess(cache_inner.get(), n_dim, *cache_inner_local_ref))) {
@@ -277,11 +328,11 @@ bool ReferenceComputingBlock(const AliasMap& parent_map,          //
   size_t comp_iloop;
   OuterInnerLoopCount(comp, &comp_oloop, &comp_iloop);
   size_t new_cache_iloop = IndexProduct(inner_used_idxs);
-  double benefit = opt.lmem_lat * comp_iloop * comp_oloop + (opt.lmem_lat + opt.gmem_lat) * cache_iloop * cache_oloop;
-  double cost = opt.reg_lat * comp_iloop * comp_oloop + (opt.reg_lat + opt.gmem_lat) * new_cache_iloop * comp_oloop;
-  if (benefit < cost) {
+  if (!RegisterCacheWorthwhile(*comp_parent, load_size, comp_iloop * comp_oloop, cache_iloop * cache_oloop,
+                               new_cache_iloop * comp_oloop, opt)) {
     return false;
   }
+  CommitRegisters(comp_parent, load_size, opt);
 
   // Determine the new shapes and accesses
   std::vector<Affine> new_inner_access = comp_inner_local_ref->access;
@@ -313,8 +364,8 @@ bool ReferenceComputingBlock(const AliasMap& parent_map,          //
   cache_inner_reg_ref.from = rref_short_name;
   cache_inner_reg_ref.dir = rref_dir;
   cache_inner_reg_ref.agg_op = "";
-  for (auto& dim : cache_inner_reg_ref.interior_shape.dims) {
-    dim.size = 1;
+  for (size_t i = 0; i < cache_inner_reg_ref.interior_shape.dims.size(); ++i) {
+    cache_inner_reg_ref.interior_shape.dims.set_size(i, 1);
   }
   cache_inner->refs.erase(cache_inner_local_ref);
   cache_inner->refs.insert(cache_inner_reg_ref);
@@ -355,13 +406,12 @@ bool ReferenceComputingBlock(const AliasMap& parent_map,          //
     auto& inner_dims = inner_ref.mut().interior_shape.dims;
     size_t inner_dims_size = inner_dims.size();
     for (size_t i = 0; i < inner_dims_size; ++i) {
-      inner_dims[i].size = 1;
+      inner_dims.set_size(i, 1);
     }
     auto& outer_dims = outer_ref->mut().interior_shape.dims;
     size_t outer_dims_size = outer_dims.size();
     for (size_t i = 0; i < outer_dims_size; ++i) {
-      outer_dims[i].size = outer_access[i] == Affine() ?
-          1 : new_cache_sizes[n_dim - outer_dims_size + i];
+      outer_dims.set_size(i, outer_access[i] == Affine() ? 1 : new_cache_sizes[n_dim - outer_dims_size + i]);
     }
   }
 
@@ -369,8 +419,8 @@ bool ReferenceComputingBlock(const AliasMap& parent_map,          //
   Refinement comp_inner_reg_ref = *comp_inner_local_ref;
   Refinement comp_outer_reg_ref = *comp_outer_local_ref;
   comp_inner_reg_ref.interior_shape = comp_reg_shape;
-  for (auto& dim : comp_inner_reg_ref.interior_shape.dims) {
-    dim.size = 1;
+  for (size_t i = 0; i < comp_inner_reg_ref.interior_shape.dims.size(); ++i) {
+    comp_inner_reg_ref.interior_shape.dims.set_size(i, 1);
   }
   comp_inner_reg_ref.location.devs[0].name = "REGISTER";
   comp_inner_reg_ref.access = comp_reg_access;
@@ -432,10 +482,6 @@ bool ReplaceLocalRefinement(const AliasMap& parent_map,          //
   auto comp_reg_shape = SimpleShape(tmp_reg_ref.interior_shape.type,
                                     comp_reg_sizes, tmp_reg_ref.interior_shape.layout);
 
-  if (load_size > opt.reg_size) {
-    return false;
-  }
-
   size_t cache_oloop;
   size_t cache_iloop;
   OuterInnerLoopCount(cache, &cache_oloop, &cache_iloop);
@@ -443,17 +489,17 @@ bool ReplaceLocalRefinement(const AliasMap& parent_map,          //
   size_t comp_iloop;
   OuterInnerLoopCount(comp, &comp_oloop, &comp_iloop);
   size_t new_cache_iloop = IndexProduct(inner_used_idxs);
-  double benefit = opt.lmem_lat * comp_iloop * comp_oloop + (opt.lmem_lat + opt.gmem_lat) * cache_iloop * cache_oloop;
-  double cost = opt.reg_lat * comp_iloop * comp_oloop + (opt.reg_lat + opt.gmem_lat) * new_cache_iloop * comp_oloop;
-  if (benefit < cost) {
-    return false;
-  }
 
   if (cache->has_tag("eltwise") &&
      !(CheckEltwiseAccess(cache, n_dim, *cache_outer_local_ref) &&
        CheckEltwiseAccess(cache_inner.get(), n_dim, *cache_inner_local_ref))) {
     return false;
   }
+  if (!RegisterCacheWorthwhile(*comp_parent, load_size, comp_iloop * comp_oloop, cache_iloop * cache_oloop,
+                               new_cache_iloop * comp_oloop, opt)) {
+    return false;
+  }
+  CommitRegisters(comp_parent, load_size, opt);
 
   // Before index conversion, compute the index multiple before and after conversion
   std::map<std::string, Rational> multiple;
@@ -484,8 +530,8 @@ bool ReplaceLocalRefinement(const AliasMap& parent_map,          //
   cache_inner_reg_ref.location.devs[0].name = "REGISTER";
   cache_inner_reg_ref.from = rref_short_name;
   cache_inner_reg_ref.dir = rref_dir;
-  for (auto& dim : cache_inner_reg_ref.interior_shape.dims) {
-    dim.size = 1;
+  for (size_t i = 0; i < cache_inner_reg_ref.interior_shape.dims.size(); ++i) {
+    cache_inner_reg_ref.interior_shape.dims.set_size(i, 1);
   }   
   cache_inner->refs.erase(cache_inner_local_ref);
   cache_inner->refs.insert(cache_inner_reg_ref);
@@ -513,7 +559,7 @@ bool ReplaceLocalRefinement(const AliasMap& parent_map,          //
     }
     std::vector<Extent> extents = inner_ref.Extents(cache_inner->idxs);
     for (size_t i = 0; i < extents.size(); ++i) {
-      outer_ref->mut().interior_shape.dims[i].size = extents[i].max;
+      outer_ref->mut().interior_shape.dims.set_size(i, extents[i].max);
     }
   }
 
@@ -521,8 +567,8 @@ bool ReplaceLocalRefinement(const AliasMap& parent_map,          //
   Refinement comp_inner_reg_ref = *comp_inner_local_ref;
   Refinement comp_outer_reg_ref = *comp_outer_local_ref;
   comp_inner_reg_ref.interior_shape = comp_reg_shape;
-  for (auto& dim : comp_inner_reg_ref.interior_shape.dims) {
-    dim.size = 1;
+  for (size_t i = 0; i < comp_inner_reg_ref.interior_shape.dims.size(); ++i) {
+    comp_inner_reg_ref.interior_shape.dims.set_size(i, 1);
   }
   comp_inner_reg_ref.location.devs[0].name = "REGISTER";
   comp_inner_reg_ref.access = comp_reg_access;
@@ -617,8 +663,8 @@ bool AppendRegCacheBlock(const AliasMap& parent_map,          //
   cache_inner_reg_ref.from = rref_short_name;
   cache_inner_reg_ref.dir = rref_dir;
   cache_inner_reg_ref.agg_op = "";
-  for (auto& dim : cache_inner_reg_ref.interior_shape.dims) {
-    dim.size = 1;
+  for (size_t i = 0; i < cache_inner_reg_ref.interior_shape.dims.size(); ++i) {
+    cache_inner_reg_ref.interior_shape.dims.set_size(i, 1);
   }
   cache_inner->refs.insert(cache_inner_reg_ref);
   cache_outer_reg_ref.interior_shape = comp_reg_shape;
@@ -656,8 +702,8 @@ bool AppendRegCacheBlock(const AliasMap& parent_map,          //
   Refinement comp_inner_reg_ref = *comp_inner_local_ref;
   Refinement comp_outer_reg_ref = *comp_outer_local_ref;
   comp_inner_reg_ref.interior_shape = comp_reg_shape;
-  for (auto& dim : comp_inner_reg_ref.interior_shape.dims) {
-    dim.size = 1;
+  for (size_t i = 0; i < comp_inner_reg_ref.interior_shape.dims.size(); ++i) {
+    comp_inner_reg_ref.interior_shape.dims.set_size(i, 1);
   }
   comp_inner_reg_ref.location.devs[0].name = "REGISTER";
   comp_inner_reg_ref.access = comp_reg_access;
@@ -887,6 +933,9 @@ void RegisterCachePass::Apply(CompilerState* state) const {
   opt.dir = stripe::FromProto(static_cast<stripe::proto::Refinement::Dir>(options_.dir()));
   opt.comp_parent_tag = options_.comp_parent_tag();
   opt.align_size = options_.align_size();
+  opt.reg_file_size = options_.register_file_size();
+  opt.max_threads = options_.max_threads_per_unit();
+  opt.min_occupancy = options_.min_occupancy();
 
   AliasMap base;
   RegisterCacheRecurse(base, nullptr, state->entry(), reqs, opt);
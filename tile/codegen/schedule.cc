@@ -78,9 +78,9 @@ struct RefInfo {
     // Convert the cached shape to use natural striding.
     std::uint64_t stride = 1;
     for (std::size_t idx = 0; idx < exterior_cache_shape.dims.size(); ++idx) {
-      auto& dim = exterior_cache_shape.dims.at(exterior_cache_shape.dims.size() - idx - 1);
-      dim.stride = stride;
-      stride *= dim.size;
+      auto pos = exterior_cache_shape.dims.size() - idx - 1;
+      exterior_cache_shape.dims.set_stride(pos, stride);
+      stride *= exterior_cache_shape.dims[pos].size;
     }
 
     auto sizes = exterior_cache_shape.sizes();
@@ -96,8 +96,8 @@ struct RefInfo {
     ref_swap_shape = ref.interior_shape;
     cache_swap_shape = exterior_cache_shape;
     for (size_t i = 0; i < sizes.size(); i++) {
-      ref_swap_shape.dims[i].size = 1;
-      cache_swap_shape.dims[i].size = 1;
+      ref_swap_shape.dims.set_size(i, 1);
+      cache_swap_shape.dims.set_size(i, 1);
     }
   }
 
@@ -440,7 +440,7 @@ struct IO {
     // compact form.
     std::size_t stride = 1;
     for (std::size_t i = interior_shape.dims.size(); i; --i) {
-      interior_shape.dims[i - 1].stride = stride;
+      interior_shape.dims.set_stride(i - 1, stride);
       stride *= interior_shape.dims[i - 1].size;
     }
   }
@@ -503,7 +503,7 @@ class StatementBinder final {
         ref->agg_op = "";
       } else {
         for (size_t i = 0; i < ref->interior_shape.dims.size(); i++) {
-          ref->interior_shape.dims[i].stride = ri->exterior_cache_shape.dims[i].stride;
+          ref->interior_shape.dims.set_stride(i, ri->exterior_cache_shape.dims[i].stride);
         }
       }
       FixupRefs(block_, ref->into());
@@ -837,7 +837,7 @@ void Scheduler::Run() {
 
     stripe::Block* current_block = dynamic_cast<stripe::Block*>(si->get());
 
-    if (VLOG_IS_ON(2)) {
+    if (IVLOG_IS_ON(2)) {
       if (current_block) {
         VLOG(2) << "Scheduling " << current_block->name;
       } else {
@@ -1088,7 +1088,7 @@ void Scheduler::Run() {
                                          << " is now completely covered; removing from active entries");
             IVLOG(3, "    Active iterator is " << &*future_ent->active_iterator << " active_entlist is at "
                                                << &active_entlist << ", contains:");
-            if (VLOG_IS_ON(3)) {
+            if (IVLOG_IS_ON(3)) {
               for (auto entp = active_entlist.begin(); entp != active_entlist.end(); ++entp) {
                 IVLOG(3, "    " << &*entp << ": " << (*entp)->name << " at " << (*entp)->range);
               }
@@ -1124,7 +1124,7 @@ void Scheduler::Run() {
       active_entlist.sort([](CacheEntry* lhs, CacheEntry* rhs) { return lhs->range.begin < rhs->range.begin; });
     }
 
-    if (VLOG_IS_ON(3)) {
+    if (IVLOG_IS_ON(3)) {
       IVLOG(3, "active_entries_ now contains:");
       for (auto& affine_entlist : active_entries_) {
         IVLOG(3, "  Affine: " << affine_entlist.first);
@@ -1355,7 +1355,7 @@ std::optional<PlacementPlan> Scheduler::TryMakePlan(stripe::Block* current_block
   std::vector<IO> todos;
   std::tie(existing_entry_plan, todos) = GatherPlacementState(current_block, ios);
 
-  if (VLOG_IS_ON(3)) {
+  if (IVLOG_IS_ON(3)) {
     IVLOG(3, "  Existing entries in plan:");
     for (auto& pkey_placement : existing_entry_plan) {
       IVLOG(3, "    " << pkey_placement.first.ri->name << " -> " << pkey_placement.second);
@@ -0,0 +1,386 @@
+// Copyright 2020, Intel Corporation.
+
+#include "tile/codegen/stages.h"
+
+#include <algorithm>
+#include <limits>
+#include <list>
+#include <set>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace vertexai {
+namespace tile {
+namespace codegen {
+
+using namespace stripe;  // NOLINT
+
+namespace {
+
+using NameSet = std::set<std::string>;
+
+// The number of innermost iterations run by a block.
+double Iterations(const Block& block) {
+  double inner = 0;
+  for (const auto& stmt : block.stmts) {
+    if (stmt->kind() == StmtKind::Block) {
+      inner += Iterations(*Block::Downcast(stmt));
+    }
+  }
+  return block.idxs_product() * std::max(inner, 1.0);
+}
+
+// Splits the weights into contiguous runs, minimizing the largest sum of a
+// run, and returns the end of each run.
+std::vector<std::size_t> SplitWeights(const std::vector<double>& weights, std::size_t parts) {
+  auto count = weights.size();
+  std::vector<double> prefix(count + 1);
+  for (std::size_t idx = 0; idx < count; idx++) {
+    prefix[idx + 1] = prefix[idx] + weights[idx];
+  }
+  // best[part][idx] is the least largest run when the first idx weights make part runs.
+  std::vector<std::vector<double>> best(parts + 1,
+                                        std::vector<double>(count + 1, std::numeric_limits<double>::infinity()));
+  std::vector<std::vector<std::size_t>> split(parts + 1, std::vector<std::size_t>(count + 1));
+  best[0][0] = 0;
+  for (std::size_t part = 1; part <= parts; part++) {
+    for (std::size_t idx = part; idx <= count; idx++) {
+      for (std::size_t mid = part - 1; mid < idx; mid++) {
+        auto cost = std::max(best[part - 1][mid], prefix[idx] - prefix[mid]);
+        if (cost < best[part][idx]) {
+          best[part][idx] = cost;
+          split[part][idx] = mid;
+        }
+      }
+    }
+  }
+  std::vector<std::size_t> ends(parts);
+  for (std::size_t part = parts, idx = count; part > 0; part--) {
+    ends[part - 1] = idx;
+    idx = split[part][idx];
+  }
+  return ends;
+}
+
+std::shared_ptr<stripe::Program> MakeStageProgram(const stripe::Program& program,                        //
+                                                  const Block& main,                                     //
+                                                  const std::vector<std::shared_ptr<Statement>>& stmts,  //
+                                                  const NameSet& touched,                                //
+                                                  const NameSet& inputs,                                 //
+                                                  const NameSet& outputs) {
+  auto result = std::make_shared<stripe::Program>();
+  result->entry = CloneBlock(*program.entry, 0);
+  auto stage_main = CloneBlock(main, 0);
+  result->entry->stmts = {stage_main};
+
+  // Keep each statement's dependencies on the statements of its own stage.
+  stage_main->stmts.clear();
+  std::unordered_map<const Statement*, StatementIt> moved;
+  for (const auto& stmt : stmts) {
+    auto it = stage_main->stmts.insert(stage_main->stmts.end(), stmt);
+    std::list<StatementIt> deps;
+    for (const auto& dep : stmt->deps) {
+      auto dep_it = moved.find(dep->get());
+      if (dep_it != moved.end()) {
+        deps.push_back(dep_it->second);
+      }
+    }
+    stmt->deps = std::move(deps);
+    moved[stmt.get()] = it;
+  }
+
+  // Temporaries crossing the stage's boundary become user buffers.
+  NameSet froms;
+  for (auto it = stage_main->refs.begin(); it != stage_main->refs.end();) {
+    const auto& name = it->into();
+    if (!touched.count(name)) {
+      it = stage_main->refs.erase(it);
+      continue;
+    }
+    bool is_input = inputs.count(name);
+    bool is_output = outputs.count(name);
+    if (is_input || is_output) {
+      it->mut().dir = is_input ? (is_output ? RefDir::InOut : RefDir::In) : RefDir::Out;
+      it->mut().remove_tag("tmp");
+    }
+    froms.insert(it->from);
+    ++it;
+  }
+  for (auto it = result->entry->refs.begin(); it != result->entry->refs.end();) {
+    const auto& name = it->into();
+    if (!froms.count(name)) {
+      it = result->entry->refs.erase(it);
+      continue;
+    }
+    if ((inputs.count(name) || outputs.count(name)) && it->has_tag("tmp")) {
+      it->mut().remove_tag("tmp");
+      it->mut().set_tag("user");
+    }
+    ++it;
+  }
+
+  auto shape_of = [&](const std::string& name) {
+    auto it = program.input_shapes.find(name);
+    if (it != program.input_shapes.end()) {
+      return it->second;
+    }
+    it = program.output_shapes.find(name);
+    if (it != program.output_shapes.end()) {
+      return it->second;
+    }
+    return result->entry->ref_by_into(name)->interior_shape;
+  };
+  for (const auto& name : inputs) {
+    result->input_shapes.emplace(name, shape_of(name));
+  }
+  for (const auto& name : outputs) {
+    result->output_shapes.emplace(name, shape_of(name));
+  }
+  for (const auto& kvp : program.buffers) {
+    if (froms.count(kvp.first)) {
+      result->buffers.insert(kvp);
+    }
+  }
+  return result;
+}
+
+// Main's statements, with what each reads, writes, and costs.
+struct MainAnalysis {
+  std::shared_ptr<Block> main;
+  std::vector<std::shared_ptr<Statement>> stmts;
+  std::vector<NameSet> reads;
+  std::vector<NameSet> writes;
+  std::vector<double> compute;  // Innermost iterations
+  std::vector<double> memory;   // Bytes of the buffers touched
+  NameSet program_inputs;
+  NameSet program_outputs;
+};
+
+MainAnalysis AnalyzeMain(const stripe::Program& program) {
+  MainAnalysis result;
+  if (program.entry->stmts.size() == 1 && program.entry->stmts.front()->kind() == StmtKind::Block) {
+    result.main = Block::Downcast(program.entry->stmts.front());
+  }
+  if (!result.main) {
+    throw std::runtime_error("Only a program with a single main block can be partitioned");
+  }
+  const auto& main = result.main;
+  result.stmts.assign(main->stmts.begin(), main->stmts.end());
+  auto count = result.stmts.size();
+  result.reads.resize(count);
+  result.writes.resize(count);
+  result.compute.resize(count);
+  result.memory.resize(count);
+  for (std::size_t idx = 0; idx < count; idx++) {
+    for (const auto& name : result.stmts[idx]->buffer_reads()) {
+      result.reads[idx].insert(name);
+    }
+    for (const auto& name : result.stmts[idx]->buffer_writes()) {
+      result.writes[idx].insert(name);
+    }
+    NameSet touched = result.reads[idx];
+    touched.insert(result.writes[idx].begin(), result.writes[idx].end());
+    for (const auto& name : touched) {
+      auto it = main->ref_by_into(name, false);
+      if (it != main->refs.end()) {
+        result.memory[idx] += it->interior_shape.byte_size();
+      }
+    }
+    if (result.stmts[idx]->kind() == StmtKind::Block) {
+      result.compute[idx] = Iterations(*Block::Downcast(result.stmts[idx]));
+    }
+  }
+  for (const auto& ref : main->refs) {
+    if (ref.has_tag("tmp")) {
+      continue;
+    }
+    if (IsReadDir(ref.dir)) {
+      result.program_inputs.insert(ref.into());
+    }
+    if (IsWriteDir(ref.dir)) {
+      result.program_outputs.insert(ref.into());
+    }
+  }
+  return result;
+}
+
+// Builds a stage for each contiguous run of statements, given the end of each run.
+std::vector<ProgramStage> MakeStages(const stripe::Program& program,    //
+                                     const MainAnalysis& analysis,      //
+                                     const std::vector<double>& costs,  //
+                                     const std::vector<std::size_t>& ends) {
+  const auto& reads = analysis.reads;
+  const auto& writes = analysis.writes;
+  const auto& stmts = analysis.stmts;
+  auto count = stmts.size();
+  std::vector<ProgramStage> stages;
+  NameSet written_before;
+  std::size_t begin = 0;
+  for (auto end : ends) {
+    NameSet touched;
+    NameSet stage_writes;
+    NameSet used_after;
+    ProgramStage stage;
+    stage.device = stages.size();
+    for (std::size_t idx = begin; idx < end; idx++) {
+      touched.insert(reads[idx].begin(), reads[idx].end());
+      touched.insert(writes[idx].begin(), writes[idx].end());
+      stage_writes.insert(writes[idx].begin(), writes[idx].end());
+      stage.cost += costs[idx];
+    }
+    for (std::size_t idx = end; idx < count; idx++) {
+      used_after.insert(reads[idx].begin(), reads[idx].end());
+      used_after.insert(writes[idx].begin(), writes[idx].end());
+    }
+    // A stage also reads what it writes after an earlier stage, as its
+    // writes may be partial or accumulate into the earlier values.
+    NameSet inputs;
+    NameSet outputs;
+    for (const auto& name : touched) {
+      if (analysis.program_inputs.count(name) || written_before.count(name)) {
+        inputs.insert(name);
+      }
+      if (stage_writes.count(name) && (analysis.program_outputs.count(name) || used_after.count(name))) {
+        outputs.insert(name);
+      }
+    }
+    stage.program = MakeStageProgram(program, *analysis.main, {stmts.begin() + begin, stmts.begin() + end},  //
+                                     touched, inputs, outputs);
+    stage.inputs = {inputs.begin(), inputs.end()};
+    stage.outputs = {outputs.begin(), outputs.end()};
+    stages.emplace_back(std::move(stage));
+    written_before.insert(stage_writes.begin(), stage_writes.end());
+    begin = end;
+  }
+  return stages;
+}
+
+}  // namespace
+
+std::vector<ProgramStage> PartitionStages(const stripe::Program& program, std::size_t num_stages) {
+  auto analysis = AnalyzeMain(program);
+  auto count = analysis.stmts.size();
+  double total_compute = 0;
+  double total_memory = 0;
+  for (std::size_t idx = 0; idx < count; idx++) {
+    total_compute += analysis.compute[idx];
+    total_memory += analysis.memory[idx];
+  }
+  std::vector<double> weights(count);
+  double norm = (total_compute > 0) + (total_memory > 0);
+  for (std::size_t idx = 0; idx < count; idx++) {
+    if (total_compute > 0) {
+      weights[idx] += analysis.compute[idx] / total_compute / norm;
+    }
+    if (total_memory > 0) {
+      weights[idx] += analysis.memory[idx] / total_memory / norm;
+    }
+  }
+
+  std::vector<std::size_t> ends{count};
+  if (count > 1 && num_stages > 1) {
+    ends = SplitWeights(weights, std::min(num_stages, count));
+  }
+  return MakeStages(program, analysis, weights, ends);
+}
+
+std::vector<ProgramStage> PlaceStages(const stripe::Program& program, const std::vector<DeviceCost>& devices,
+                                      double handoff_bytes_per_sec) {
+  if (devices.empty()) {
+    throw std::invalid_argument("Placing a program requires at least one device");
+  }
+  auto analysis = AnalyzeMain(program);
+  auto count = analysis.stmts.size();
+  auto num_devices = devices.size();
+  auto time_on = [&](std::size_t idx, const DeviceCost& device) {
+    double time = std::max(2 * analysis.compute[idx] / device.flops_per_sec,  //
+                           analysis.memory[idx] / device.bytes_per_sec);
+    if (analysis.stmts[idx]->kind() == StmtKind::Block) {
+      time += device.launch_sec;
+    }
+    return time;
+  };
+
+  // handoff[idx] is the time to hand the temporaries live before statement idx to another device.
+  std::vector<double> handoff(count);
+  NameSet touched_after;
+  std::vector<NameSet> live_after(count);
+  for (std::size_t idx = count; idx-- > 0;) {
+    live_after[idx] = touched_after;
+    touched_after.insert(analysis.reads[idx].begin(), analysis.reads[idx].end());
+    touched_after.insert(analysis.writes[idx].begin(), analysis.writes[idx].end());
+  }
+  NameSet written_before;
+  for (std::size_t idx = 0; idx < count; idx++) {
+    written_before.insert(analysis.writes[idx].begin(), analysis.writes[idx].end());
+    if (idx + 1 == count) {
+      break;
+    }
+    double bytes = 0;
+    for (const auto& name : written_before) {
+      if (live_after[idx].count(name)) {
+        auto it = analysis.main->ref_by_into(name, false);
+        if (it != analysis.main->refs.end()) {
+          bytes += it->interior_shape.byte_size();
+        }
+      }
+    }
+    handoff[idx + 1] = bytes / handoff_bytes_per_sec;
+  }
+
+  // best[idx][dev] is the least time to run the first idx + 1 statements, ending on dev.
+  std::vector<std::vector<double>> best(count, std::vector<double>(num_devices));
+  std::vector<std::vector<std::size_t>> from(count, std::vector<std::size_t>(num_devices));
+  for (std::size_t idx = 0; idx < count; idx++) {
+    for (std::size_t dev = 0; dev < num_devices; dev++) {
+      double prior = 0;
+      if (idx) {
+        prior = std::numeric_limits<double>::infinity();
+        for (std::size_t prev = 0; prev < num_devices; prev++) {
+          double time = best[idx - 1][prev] + (prev == dev ? 0 : handoff[idx]);
+          if (time < prior) {
+            prior = time;
+            from[idx][dev] = prev;
+          }
+        }
+      }
+      best[idx][dev] = prior + time_on(idx, devices[dev]);
+    }
+  }
+
+  std::vector<std::size_t> placement(count);
+  double total = 0;
+  if (count) {
+    auto last = std::min_element(best.back().begin(), best.back().end());
+    total = *last;
+    placement[count - 1] = last - best.back().begin();
+    for (std::size_t idx = count - 1; idx > 0; idx--) {
+      placement[idx - 1] = from[idx][placement[idx]];
+    }
+  }
+  std::vector<double> costs(count);
+  std::vector<std::size_t> ends;
+  std::vector<std::size_t> stage_devices;
+  for (std::size_t idx = 0; idx < count; idx++) {
+    if (total > 0) {
+      costs[idx] = time_on(idx, devices[placement[idx]]) / total;
+    }
+    if (idx + 1 == count || placement[idx + 1] != placement[idx]) {
+      ends.push_back(idx + 1);
+      stage_devices.push_back(placement[idx]);
+    }
+  }
+  if (ends.empty()) {
+    ends.push_back(0);
+    stage_devices.push_back(0);
+  }
+  auto stages = MakeStages(program, analysis, costs, ends);
+  for (std::size_t idx = 0; idx < stages.size(); idx++) {
+    stages[idx].device = stage_devices[idx];
+  }
+  return stages;
+}
+
+}  // namespace codegen
+}  // namespace tile
+}  // namespace vertexai
@@ -0,0 +1,58 @@
+// Copyright 2020, Intel Corporation.
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tile/stripe/stripe.h"
+
+namespace vertexai {
+namespace tile {
+namespace codegen {
+
+// One stage of a partitioned program.
+struct ProgramStage {
+  std::shared_ptr<stripe::Program> program;
+  std::vector<std::string> inputs;   // Read from the caller, or from earlier stages
+  std::vector<std::string> outputs;  // Written for the caller, or for later stages
+  double cost = 0;                   // The stage's share of the program's cost, from 0 to 1
+  std::size_t device = 0;            // The index of the device which runs the stage
+};
+
+// The rates at which a device runs kernels, for placing them.
+struct DeviceCost {
+  double flops_per_sec = 1e10;  // An iteration counts as two flops (a multiply-accumulate)
+  double bytes_per_sec = 1e10;  // Memory bandwidth
+  double launch_sec = 0;        // The overhead of launching a kernel
+};
+
+// Splits a program, as generated from Tile (an entry block holding a single
+// main block), into at most num_stages programs which run in sequence.  Each
+// stage runs a contiguous run of main's statements.  Splits are placed to
+// minimize the cost of the costliest stage, where a statement's cost is its
+// share of the program's compute (the iterations of its blocks) plus its
+// share of the program's memory (the bytes of the buffers it touches).
+//
+// Temporaries which cross a split become outputs of the stages which write
+// them and inputs of the later stages which use them.  The stages share
+// statements with the original program, which should not be used afterwards.
+std::vector<ProgramStage> PartitionStages(const stripe::Program& program, std::size_t num_stages);
+
+// Places each of main's statements on one of the devices, and splits the
+// program into stages wherever the device changes.  A statement's time on a
+// device is its launch overhead plus the longer of its compute time and its
+// memory time (as on the device's roofline); moving from one device to
+// another costs the time to hand off the temporaries live across the move,
+// at handoff_bytes_per_sec.  Placements minimize the program's total time,
+// so small kernels stay on the device with the least launch overhead while
+// large ones move to the fastest device.
+//
+// The stages are as for PartitionStages, with each stage's device set.
+std::vector<ProgramStage> PlaceStages(const stripe::Program& program, const std::vector<DeviceCost>& devices,
+                                      double handoff_bytes_per_sec);
+
+}  // namespace codegen
+}  // namespace tile
+}  // namespace vertexai
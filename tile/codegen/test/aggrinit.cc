@@ -0,0 +1,122 @@
+// Copyright 2020, Intel Corporation
+
+#include <gmock/gmock.h>
+
+#include <memory>
+#include <vector>
+
+#include "tile/codegen/aggrinit.h"
+
+namespace vertexai {
+namespace tile {
+namespace codegen {
+namespace test {
+
+using ::testing::ElementsAre;
+using ::testing::Eq;
+using ::testing::IsEmpty;
+using ::testing::SizeIs;
+
+namespace {
+
+// A sum into O[32]: main holds the tensor, kernel writes an 8-element tile of it per iteration of x, and inner
+// reduces each element of the tile over k.
+struct Sum {
+  Sum() {
+    kernel->name = "kernel";
+    kernel->idxs = {{"x", 4}};
+    kernel->refs.emplace(stripe::RefDir::Out, "O", "O", std::vector<stripe::Affine>{stripe::Affine("x", 8)},
+                         SimpleShape(DataType::FLOAT32, {8}), "add");
+    kernel->stmts.push_back(Inner());
+    main->name = "main";
+    main->refs.emplace(stripe::RefDir::Out, "O", "O", std::vector<stripe::Affine>{stripe::Affine()},
+                       SimpleShape(DataType::FLOAT32, {32}));
+    main->stmts.push_back(kernel);
+    prog->entry = std::make_shared<stripe::Block>();
+    prog->entry->stmts.push_back(main);
+  }
+
+  static std::shared_ptr<stripe::Block> Inner() {
+    auto inner = std::make_shared<stripe::Block>();
+    inner->name = "inner";
+    inner->idxs = {{"i", 8}, {"k", 16}};
+    inner->refs.emplace(stripe::RefDir::Out, "O", "O", std::vector<stripe::Affine>{stripe::Affine("i")},
+                        SimpleShape(DataType::FLOAT32, {1}), "add");
+    return inner;
+  }
+
+  void Run() {
+    CompilerState state(prog);
+    AggregationBlockOutputInitializationPass pass{proto::AggregationBlockOutputInitializationPass{}};
+    pass.Apply(&state);
+  }
+
+  std::shared_ptr<stripe::Program> prog = std::make_shared<stripe::Program>();
+  std::shared_ptr<stripe::Block> main = std::make_shared<stripe::Block>();
+  std::shared_ptr<stripe::Block> kernel = std::make_shared<stripe::Block>();
+};
+
+// The agg_init specials among block's statements.
+std::vector<std::shared_ptr<stripe::Special>> Inits(const stripe::Block& block) {
+  std::vector<std::shared_ptr<stripe::Special>> inits;
+  for (const auto& stmt : block.stmts) {
+    auto special = stripe::Special::Downcast(stmt);
+    if (special && special->name == "agg_init_add") {
+      inits.push_back(special);
+    }
+  }
+  return inits;
+}
+
+}  // namespace
+
+TEST(AggInit, SinksIntoTile) {
+  Sum sum;
+  sum.Run();
+  // The init moves into the tile loop, in front of the reduction, but no further: inner also iterates over k.
+  EXPECT_THAT(Inits(*sum.main), IsEmpty());
+  ASSERT_THAT(sum.kernel->stmts, SizeIs(2));
+  auto init = stripe::Special::Downcast(sum.kernel->stmts.front());
+  ASSERT_TRUE(init);
+  EXPECT_THAT(init->name, Eq("agg_init_add"));
+  EXPECT_THAT(init->outputs, ElementsAre("O"));
+  EXPECT_THAT(Inits(*stripe::Block::Downcast(sum.kernel->stmts.back())), IsEmpty());
+}
+
+TEST(AggInit, ConstraintsStayOutside) {
+  Sum sum;
+  sum.kernel->constraints = {stripe::Affine("x", -1) + 2};
+  sum.Run();
+  EXPECT_THAT(Inits(*sum.main), SizeIs(1));
+  EXPECT_THAT(Inits(*sum.kernel), IsEmpty());
+}
+
+TEST(AggInit, OverhangStaysOutside) {
+  Sum sum;
+  sum.kernel->idxs[0].range = 5;  // 5 tiles of 8 run past the end of O
+  sum.Run();
+  EXPECT_THAT(Inits(*sum.main), SizeIs(1));
+  EXPECT_THAT(Inits(*sum.kernel), IsEmpty());
+}
+
+TEST(AggInit, ReductionIndexStaysOutside) {
+  Sum sum;
+  // Every iteration of k revisits the same tile, so initializing it in the loop would discard earlier sums.
+  sum.kernel->idxs.emplace_back("k", 2);
+  sum.Run();
+  EXPECT_THAT(Inits(*sum.main), SizeIs(1));
+  EXPECT_THAT(Inits(*sum.kernel), IsEmpty());
+}
+
+TEST(AggInit, MultipleUsersStayOutside) {
+  Sum sum;
+  sum.kernel->stmts.push_back(Sum::Inner());
+  sum.Run();
+  EXPECT_THAT(Inits(*sum.main), SizeIs(1));
+  EXPECT_THAT(Inits(*sum.kernel), IsEmpty());
+}
+
+}  // namespace test
+}  // namespace codegen
+}  // namespace tile
+}  // namespace vertexai
@@ -0,0 +1,58 @@
+// Copyright 2020, Intel Corporation
+
+#include <gmock/gmock.h>
+
+#include "tile/codegen/analysis.h"
+
+namespace vertexai {
+namespace tile {
+namespace codegen {
+namespace test {
+
+using ::testing::Eq;
+
+// Counts its constructions, to observe the cache.
+struct CountingAnalysis {
+  CountingAnalysis(const AliasMap& map, stripe::Block* block) { constructions++; }
+  static int constructions;
+};
+
+int CountingAnalysis::constructions = 0;
+
+TEST(Codegen, AnalysisManagerCachesAliasMaps) {
+  auto root = std::make_shared<stripe::Block>();
+  auto main = std::make_shared<stripe::Block>();
+  auto kernel = std::make_shared<stripe::Block>();
+  root->stmts.push_back(main);
+  main->stmts.push_back(kernel);
+
+  AnalysisManager analyses;
+  const auto* root_map = &analyses.RootAliasMap(root.get());
+  const auto* main_map = &analyses.InnerAliasMap(*root_map, main.get());
+  const auto* kernel_map = &analyses.InnerAliasMap(*main_map, kernel.get());
+  EXPECT_THAT(&analyses.RootAliasMap(root.get()), Eq(root_map));
+  EXPECT_THAT(&analyses.InnerAliasMap(*root_map, main.get()), Eq(main_map));
+  EXPECT_THAT(kernel_map->parent_alias_map(), Eq(main_map));
+
+  CountingAnalysis::constructions = 0;
+  analyses.Get<CountingAnalysis>(*kernel_map);
+  analyses.Get<CountingAnalysis>(*kernel_map);
+  EXPECT_THAT(CountingAnalysis::constructions, Eq(1));
+
+  // Invalidating a block drops its descendants' analyses, but not its ancestors'.
+  analyses.Invalidate(main.get());
+  EXPECT_THAT(&analyses.RootAliasMap(root.get()), Eq(root_map));
+  main_map = &analyses.InnerAliasMap(*root_map, main.get());
+  kernel_map = &analyses.InnerAliasMap(*main_map, kernel.get());
+  analyses.Get<CountingAnalysis>(*kernel_map);
+  EXPECT_THAT(CountingAnalysis::constructions, Eq(2));
+
+  // A different root replaces everything.
+  auto other = std::make_shared<stripe::Block>();
+  EXPECT_THAT(analyses.RootAliasMap(other.get()).this_block(), Eq(other.get()));
+}
+
+}  // namespace test
+}  // namespace codegen
+}  // namespace tile
+}  // namespace vertexai
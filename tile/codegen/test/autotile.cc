@@ -0,0 +1,192 @@
+// Copyright 2020, Intel Corporation
+
+#include <gmock/gmock.h>
+
+#include <cctype>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "base/proto/proto.h"
+#include "base/util/file.h"
+#include "tile/codegen/autotile.h"
+#include "tile/stripe/stripe.h"
+#include "tile/stripe/stripe.pb.h"
+
+using ::testing::ContainerEq;
+using ::testing::Eq;
+using ::testing::Ne;
+
+namespace vertexai {
+namespace tile {
+namespace codegen {
+namespace test {
+
+using namespace stripe;  // NOLINT
+
+// The refinements of C[i, j] = +(A[i, k] * B[k, j]) over an MxNxK space, with suffix appended to the tensor names.
+// A kernel's refinements (named a, b, and c) select elements of the program's (named A, B, and C) by the kernel's
+// index names, given in i, j, k order.
+std::string MatMulRefs(const std::vector<std::string>& names, size_t m, size_t n, size_t k, const std::string& suffix,
+                       bool kernel) {
+  auto ref = [&](const std::string& tensor, size_t row, size_t col, size_t rows, size_t cols, const std::string& dir) {
+    std::string key = kernel ? tensor : std::string(1, std::toupper(tensor[0]));
+    std::string from = kernel ? "from: \"" + std::string(1, std::toupper(tensor[0])) + suffix + "\" " : "";
+    std::string access = "access [{}, {}]";
+    auto stride = cols;
+    if (kernel) {
+      access = "access [{terms {key: \"" + names[row] + "\" value: 1}}, {terms {key: \"" + names[col] +
+               "\" value: 1}}]";
+      rows = cols = 1;
+    }
+    return "{key: \"" + key + suffix + "\" value { " + from + (kernel ? dir : "") + " loc {} " + access +
+           " interior_shape {type: FLOAT32 dims: [{size:" + std::to_string(rows) + " stride:" +
+           std::to_string(stride) + "}, {size:" + std::to_string(cols) + " stride:1}]} }}";
+  };
+  return "refs [" + ref("a", 0, 2, m, k, "dir: In") + ", " + ref("b", 2, 1, k, n, "dir: In") + ", " +
+         ref("c", 0, 1, m, n, "dir: Out agg_op: \"add\"") + "]";
+}
+
+std::string MatMulKernel(const std::string& name, const std::vector<std::string>& names, size_t m, size_t n, size_t k,
+                         const std::string& suffix) {
+  return R"(
+    name: ")" + name + R"(" loc {}
+    idxs [{name: ")" + names[0] + R"(" range: )" + std::to_string(m) + R"( affine {}},
+          {name: ")" + names[1] + R"(" range: )" + std::to_string(n) + R"( affine {}},
+          {name: ")" + names[2] + R"(" range: )" + std::to_string(k) + R"( affine {}}]
+    )" + MatMulRefs(names, m, n, k, suffix, true) + R"(
+    stmts [{load {from: "a)" + suffix + R"(" into: "$a"}},
+           {load {from: "b)" + suffix + R"(" into: "$b"}},
+           {intrinsic {name: "mul" type: FLOAT32 inputs: ["$a", "$b"] outputs: ["$c"]}},
+           {store {from: "$c" into: "c)" + suffix + R"("}}]
+  )";
+}
+
+std::shared_ptr<Block> ParseBlock(const std::string& text) {
+  return stripe::FromProto(ParseProtoText<stripe::proto::Block>(text));
+}
+
+proto::AutotilePass AutotileOptions(const std::string& extra) {
+  return ParseProtoText<proto::AutotilePass>(R"(
+    reqs: ["kernel"]
+    only_po2: true
+    max_total_size: 4096
+  )" + extra);
+}
+
+TEST(Autotile, SignatureIgnoresNames) {
+  auto options = AutotileOptions("");
+  auto block = ParseBlock(MatMulKernel("first", {"i", "j", "k"}, 64, 32, 16, ""));
+  auto renamed = ParseBlock(MatMulKernel("second", {"x", "y", "z"}, 64, 32, 16, "_2"));
+  EXPECT_THAT(BlockSignature(*block, options), Eq(BlockSignature(*renamed, options)));
+
+  // Options which don't affect the cost don't affect the signature.
+  auto threaded = AutotileOptions("threads: 8 memoize: true cache_path: \"/tmp/elsewhere\"");
+  EXPECT_THAT(BlockSignature(*block, threaded), Eq(BlockSignature(*block, options)));
+
+  // But ranges, accesses, and costed options do.
+  auto resized = ParseBlock(MatMulKernel("first", {"i", "j", "k"}, 64, 32, 8, ""));
+  EXPECT_THAT(BlockSignature(*resized, options), Ne(BlockSignature(*block, options)));
+  auto transposed = ParseBlock(MatMulKernel("first", {"i", "j", "k"}, 64, 32, 16, ""));
+  auto& access = transposed->ref_by_into("a")->mut().access;
+  std::swap(access[0], access[1]);
+  EXPECT_THAT(BlockSignature(*transposed, options), Ne(BlockSignature(*block, options)));
+  EXPECT_THAT(BlockSignature(*block, AutotileOptions("input_cost: 2")), Ne(BlockSignature(*block, options)));
+}
+
+class TileMemoTest : public ::testing::Test {
+ protected:
+  void SetUp() override { boost::filesystem::create_directories(dir_); }
+  void TearDown() override { boost::filesystem::remove_all(dir_); }
+
+  boost::filesystem::path dir_ = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+  std::string path_ = (dir_ / "tiles.memo").string();
+};
+
+TEST_F(TileMemoTest, SavesAndLoads) {
+  TileMemo memo;
+  TileMemoEntry found;
+  found.found = true;
+  found.sizes = {4, 8, 16};
+  found.cost = 0.125;
+  memo.Insert("found", found);
+  memo.Insert("unusable", TileMemoEntry{});
+  memo.Save(path_);
+  EXPECT_THAT(ReadFile(path_).substr(0, ReadFile(path_).find('\n')),
+              Eq(std::string(TileMemo::kFileHeader) + "\t" + std::to_string(TileMemo::kFileVersion)));
+
+  TileMemo loaded;
+  auto entry = loaded.Lookup("found", path_);
+  ASSERT_TRUE(entry);
+  EXPECT_TRUE(entry->found);
+  EXPECT_THAT(entry->sizes, ContainerEq(found.sizes));
+  EXPECT_THAT(entry->cost, Eq(found.cost));
+  entry = loaded.Lookup("unusable", path_);
+  ASSERT_TRUE(entry);
+  EXPECT_FALSE(entry->found);
+  EXPECT_FALSE(loaded.Lookup("missing", path_));
+}
+
+TEST_F(TileMemoTest, IgnoresOtherVersions) {
+  // A file from before the memo was versioned, and one from a later version.
+  for (const auto& header : {std::string(), std::string(TileMemo::kFileHeader) + "\t" +
+                                                std::to_string(TileMemo::kFileVersion + 1) + "\n"}) {
+    WriteFile(path_, header + "found\t0.5\t4,8,16\n");
+    TileMemo memo;
+    EXPECT_FALSE(memo.Lookup("found", path_));
+  }
+}
+
+// Runs AutotilePass over a program of matmul kernels, returning each kernel's tile sizes.
+std::vector<std::vector<size_t>> AutotileKernels(const proto::AutotilePass& options) {
+  struct Kernel {
+    std::vector<std::string> names;
+    size_t m, n, k;
+  };
+  // The third kernel is the first under other names, so memoized searches reuse the first's result.
+  std::vector<Kernel> kernels{{{"i", "j", "k"}, 64, 64, 64},
+                              {{"i", "j", "k"}, 32, 128, 16},
+                              {{"x", "y", "z"}, 64, 64, 64},
+                              {{"i", "j", "k"}, 16, 16, 256},
+                              {{"i", "j", "k"}, 128, 8, 32}};
+  std::string text = R"(name: "program" loc {} )";
+  std::string stmts;
+  for (size_t n = 0; n < kernels.size(); n++) {
+    const auto& kernel = kernels[n];
+    auto suffix = std::to_string(n);
+    text += MatMulRefs(kernel.names, kernel.m, kernel.n, kernel.k, suffix, false);
+    stmts += R"({attrs: { key: "kernel" value {} } block {)" +
+             MatMulKernel("kernel" + suffix, kernel.names, kernel.m, kernel.n, kernel.k, suffix) + "}},";
+  }
+  stmts.pop_back();
+  text += "stmts [" + stmts + "]";
+
+  auto prog = std::make_shared<Program>();
+  prog->entry = ParseBlock(text);
+  CompilerState state(prog);
+  AutotilePass(options).Apply(&state);
+  std::vector<std::vector<size_t>> sizes;
+  for (const auto& stmt : prog->entry->stmts) {
+    auto inner = Block::Downcast(stmt)->SubBlock(0);
+    sizes.emplace_back();
+    for (const auto& idx : inner->idxs) {
+      sizes.back().push_back(idx.range);
+    }
+  }
+  return sizes;
+}
+
+TEST(Autotile, ParallelSearchMatchesSerial) {
+  auto serial = AutotileKernels(AutotileOptions("threads: 1"));
+  ASSERT_THAT(serial.size(), Eq(5));
+  EXPECT_THAT(serial[2], ContainerEq(serial[0]));
+  EXPECT_THAT(AutotileKernels(AutotileOptions("threads: 4")), ContainerEq(serial));
+  EXPECT_THAT(AutotileKernels(AutotileOptions("threads: 4 memoize: true")), ContainerEq(serial));
+}
+
+}  // namespace test
+}  // namespace codegen
+}  // namespace tile
+}  // namespace vertexai
@@ -2,6 +2,8 @@
 
 #include <gmock/gmock.h>
 
+#include <google/protobuf/text_format.h>
+
 #include "plaidml2/edsl/helper.h"
 #include "tile/codegen/cache.h"
 #include "tile/codegen/tile.h"
@@ -10,6 +12,9 @@
 #include "tile/lang/runinfo.h"
 #include "tile/lib/lib.h"
 #include "tile/stripe/stripe.h"
+#include "tile/stripe/stripe.pb.h"
+
+namespace gp = google::protobuf;
 
 using ::testing::ContainerEq;
 using ::testing::Eq;
@@ -88,6 +93,196 @@ TEST(Codegen, Cache) {
   // EXPECT_THAT(data["C"], ContainerEq(expected));
 }
 
+TEST(Codegen, CacheDoubleBuffer) {
+  auto tileProgram = lib::LoadMatMul(              //
+      "matmul",                                    //
+      LogicalShape(PLAIDML_DATA_FLOAT32, {8, 8}),  //
+      LogicalShape(PLAIDML_DATA_FLOAT32, {8, 8}));
+  auto program = plaidml::edsl::ConvertIntoStripe(tileProgram);
+  auto main = program->entry->SubBlock(0);
+  auto kernel = main->SubBlock(0);
+  ApplyTile(kernel.get(), {2, 2, 2});
+  auto inner = kernel->SubBlock(0);
+  AliasMap program_map(AliasMap(), program->entry.get());
+  AliasMap main_map(program_map, main.get());
+  AliasMap am(main_map, kernel.get());
+  ApplyCache(am, RefDir::In, inner.get(), kernel.get(), "A", {{{"CACHE"}}}, {{{"TX"}}});
+  size_t product = kernel->idxs_product();
+  ApplyDoubleBuffer(kernel.get());
+  IVLOG(2, "Double buffered\n" << *program->entry);
+
+  EXPECT_TRUE(kernel->has_tag("double_buffered"));
+  EXPECT_THAT(kernel->idxs_product(), Eq(product / 2));
+  ASSERT_THAT(kernel->stmts.size(), Eq(4));
+  std::vector<bool> loads;
+  for (const auto& stmt : kernel->stmts) {
+    loads.push_back(Block::Downcast(stmt)->has_tag("cache_load"));
+  }
+  EXPECT_THAT(loads, ContainerEq(std::vector<bool>{true, true, false, false}));
+  // The prefetched tile lands in its own buffer
+  auto load0 = Block::Downcast(kernel->stmts.front());
+  auto load1 = Block::Downcast(*std::next(kernel->stmts.begin()));
+  auto dst0 = load0->ref_by_into("dst")->from;
+  auto dst1 = load1->ref_by_into("dst")->from;
+  EXPECT_NE(dst0, dst1);
+  EXPECT_THAT(kernel->ref_by_into(dst1)->dir, Eq(RefDir::None));
+}
+
+TEST(Codegen, CacheDoubleBufferKeepsOtherIndexes) {
+  // A cached block whose accesses mix the double-buffered index k with the other index i.
+  stripe::proto::Block input_proto;
+  gp::TextFormat::ParseFromString(R"(
+    name: "kernel"
+    idxs [{name: "i" range: 2}, {name: "k" range: 4}]
+    refs [
+      {
+        key: "A"
+        value: {
+          dir: In from: "A"
+          access [{terms {key: "i" value: 2}}, {terms [{key: "i" value: 1}, {key: "k" value: 2}]}]
+          interior_shape { type: FLOAT32 dims: [{size: 2 stride: 16}, {size: 2 stride: 1}] }
+        }
+      },
+      {
+        key: "A_c"
+        value: {
+          access [{}, {}]
+          interior_shape { type: FLOAT32 dims: [{size: 2 stride: 2}, {size: 2 stride: 1}] }
+        }
+      },
+      {
+        key: "C"
+        value: {
+          dir: Out from: "C" access [{terms {key: "i" value: 2}}, {}] agg_op: "add"
+          interior_shape { type: FLOAT32 dims: [{size: 2 stride: 2}, {size: 2 stride: 1}] }
+        }
+      }
+    ]
+    stmts {
+      attrs { key: "cache_load" value {} }
+      block {
+        name: "load"
+        idxs [{name: "x" range: 1 affine {terms [{key: "i" value: 1}, {key: "k" value: 2}]}}]
+        refs [
+          {key: "src" value: {dir: In from: "A" access [{}, {}]
+                              interior_shape { type: FLOAT32 dims: [{size: 2 stride: 16}, {size: 2 stride: 1}] }}},
+          {key: "dst" value: {dir: Out from: "A_c" access [{}, {}]
+                              interior_shape { type: FLOAT32 dims: [{size: 2 stride: 2}, {size: 2 stride: 1}] }}}
+        ]
+        stmts { load { from: "src" into: "$x" } }
+        stmts { store { from: "$x" into: "dst" } }
+      }
+    }
+    stmts {
+      deps: 0
+      block {
+        name: "compute"
+        idxs [{name: "y" range: 1 affine {terms [{key: "i" value: 1}]}}]
+        refs [
+          {key: "src" value: {dir: In from: "A_c" access [{}, {}]
+                              interior_shape { type: FLOAT32 dims: [{size: 2 stride: 2}, {size: 2 stride: 1}] }}},
+          {key: "dst" value: {dir: Out from: "C" access [{}, {}] agg_op: "add"
+                              interior_shape { type: FLOAT32 dims: [{size: 2 stride: 2}, {size: 2 stride: 1}] }}}
+        ]
+        stmts { load { from: "src" into: "$x" } }
+        stmts { store { from: "$x" into: "dst" } }
+      }
+    }
+  )",
+                                  &input_proto);
+  auto kernel = stripe::FromProto(input_proto);
+  ApplyDoubleBuffer(kernel.get(), "k");
+  IVLOG(2, "Double buffered\n" << *kernel);
+
+  EXPECT_TRUE(kernel->has_tag("double_buffered"));
+  EXPECT_THAT(kernel->idx_by_name("k")->range, Eq(2));
+  auto first = kernel->ref_by_into("A");
+  EXPECT_THAT(first->access[0], Eq(Affine("i", 2)));
+  EXPECT_THAT(first->access[1], Eq(Affine("i") + Affine("k", 4)));
+  auto second = kernel->ref_by_into("A_1");
+  ASSERT_TRUE(second != kernel->refs.end());
+  EXPECT_THAT(second->access[0], Eq(Affine("i", 2)));
+  EXPECT_THAT(second->access[1], Eq(Affine("i") + Affine("k", 4) + 2));
+  ASSERT_THAT(kernel->stmts.size(), Eq(4));
+  auto load0 = Block::Downcast(kernel->stmts.front());
+  auto load1 = Block::Downcast(*std::next(kernel->stmts.begin()));
+  EXPECT_THAT(load0->idxs[0].affine, Eq(Affine("i") + Affine("k", 4)));
+  EXPECT_THAT(load1->idxs[0].affine, Eq(Affine("i") + Affine("k", 4) + 2));
+  EXPECT_THAT(load1->ref_by_into("src")->from, Eq("A_1"));
+  EXPECT_THAT(load1->ref_by_into("dst")->from, Eq("A_c_1"));
+}
+
+TEST(Codegen, CacheKeepsShapesShared) {
+  // Shapes only read by a pass keep sharing their dimensions with copies taken before it.
+  stripe::proto::Block input_proto;
+  gp::TextFormat::ParseFromString(R"(
+    name: "program"
+    refs [{key: "A" value: {access [{}, {}]
+                            interior_shape { type: FLOAT32 dims: [{size: 4 stride: 4}, {size: 4 stride: 1}] }}}]
+    stmts {
+      block {
+        name: "kernel"
+        refs [{key: "A" value: {dir: In from: "A" access [{}, {}]
+                                interior_shape { type: FLOAT32 dims: [{size: 4 stride: 4}, {size: 4 stride: 1}] }}}]
+        stmts {
+          block {
+            name: "compute"
+            idxs [{name: "i" range: 4}, {name: "j" range: 4}]
+            refs [{key: "a" value: {dir: In from: "A" access [{terms {key: "i" value: 1}}, {terms {key: "j" value: 1}}]
+                                    interior_shape { type: FLOAT32 dims: [{size: 1 stride: 4}, {size: 1 stride: 1}] }}}]
+            stmts { load { from: "a" into: "$a" } }
+          }
+        }
+      }
+    }
+  )",
+                                  &input_proto);
+  auto program = stripe::FromProto(input_proto);
+  auto kernel = program->SubBlock(0);
+  auto compute = kernel->SubBlock(0);
+  auto raw = kernel->ref_by_into("A")->interior_shape;
+  auto inner = compute->ref_by_into("a")->interior_shape;
+
+  AliasMap program_map(AliasMap(), program.get());
+  AliasMap am(program_map, kernel.get());
+  ApplySimpleCache(am, RefDir::In, kernel.get(), "A", {{{"CACHE"}}}, {{{"TX"}}});
+  IVLOG(2, "Cached\n" << *program);
+
+  auto raw_ref = kernel->ref_by_into("A_raw");
+  ASSERT_TRUE(raw_ref != kernel->refs.end());
+  EXPECT_TRUE(raw_ref->interior_shape.dims.shares_with(raw.dims));
+  // The cache has the same strides as A, so restriding the compute block's refinement leaves it alone.
+  EXPECT_THAT(compute->ref_by_into("a")->location.devs[0].name, Eq("CACHE"));
+  EXPECT_TRUE(compute->ref_by_into("a")->interior_shape.dims.shares_with(inner.dims));
+  auto load = Block::Downcast(kernel->stmts.front());
+  EXPECT_THAT(load->ref_by_into("src")->from, Eq("A_raw"));
+  EXPECT_FALSE(load->ref_by_into("src")->interior_shape.dims.shares_with(raw.dims));
+}
+
+TEST(Codegen, CacheBankPadding) {
+  auto tileProgram = lib::LoadMatMul(                //
+      "matmul",                                      //
+      LogicalShape(PLAIDML_DATA_FLOAT32, {32, 32}),  //
+      LogicalShape(PLAIDML_DATA_FLOAT32, {32, 32}));
+  auto program = plaidml::edsl::ConvertIntoStripe(tileProgram);
+  auto main = program->entry->SubBlock(0);
+  auto kernel = main->SubBlock(0);
+  ApplyTile(kernel.get(), {16, 16, 16});
+  auto inner = kernel->SubBlock(0);
+  AliasMap program_map(AliasMap(), program->entry.get());
+  AliasMap main_map(program_map, main.get());
+  AliasMap am(main_map, kernel.get());
+  ApplyCache(am, RefDir::In, inner.get(), kernel.get(), "A", {{{"CACHE"}}}, {{{"TX"}}}, {"cache", "cache_load"},
+             {"cache", "cache_store"}, true, true, false, 2.0, 32, 4);
+  IVLOG(2, "Cached\n" << *program->entry);
+
+  // A row of 16 floats spans 16 of the 32 banks, so rows are padded by one bank
+  auto decl = kernel->ref_by_into("A");
+  EXPECT_THAT(decl->dir, Eq(RefDir::None));
+  EXPECT_THAT(decl->interior_shape.sizes(), ContainerEq(std::vector<size_t>{16, 16}));
+  EXPECT_THAT(decl->interior_shape.strides(), ContainerEq(std::vector<size_t>{17, 1}));
+}
+
 TEST(Codegen, CacheConv2d) {
   auto tileProgram = lib::LoadConv2d(                        //
       "conv2d",                                              //
@@ -197,6 +197,86 @@ TEST(DepsTest, Subregion) {
   EXPECT_THAT(output_proto, EqualsProtoText(expected));
 }
 
+
+TEST(DepsTest, UpdateAfterRewrite) {
+  auto input_text = R"(
+    loc {}
+    stmts {
+      attrs: { key: "main" value {} }
+      block {
+        loc {}
+        refs: [{
+          key: "b1"
+          value: {
+            loc {}
+            interior_shape { type: FLOAT32 dims: {size:1 stride:1} }
+          }
+        }, {
+          key: "b2"
+          value: {
+            loc {}
+            interior_shape { type: FLOAT32 dims: {size:1 stride:1} }
+          }
+        }]
+        stmts { load { from:"b1" into:"$1" } }
+        stmts { store { from:"$1" into:"b2" } }
+        stmts { store { from:"$1" into:"b2" } }
+        stmts { load { from:"b2" into:"$2" } }
+        stmts { store { from:"$2" into:"b1" } }
+      }
+    }
+  )";
+  stripe::proto::Block input_proto;
+  gp::TextFormat::ParseFromString(input_text, &input_proto);
+
+  auto prog = std::make_shared<stripe::Program>();
+  prog->entry = stripe::FromProto(input_proto);
+  auto main = prog->entry->SubBlock(0);
+  AliasMap base;
+  AliasMap root_map(base, prog->entry.get());
+  AliasMap alias_map(root_map, main.get());
+  ComputeDepsForBlock(main.get(), alias_map);
+
+  // Replace the final store with a load of b2, and store that instead.
+  auto first = std::prev(main->stmts.end());
+  *first = std::make_shared<stripe::Load>("b2", "$3");
+  main->stmts.push_back(std::make_shared<stripe::Store>("$3", "b1"));
+  UpdateDepsForBlock(main.get(), alias_map, first);
+
+  // The second store to b2 overwrites the first, so later reads of b2 depend only on it.
+  const char* expected = R"(
+    loc {}
+    stmts {
+      attrs: { key: "main" value {} }
+      block {
+        loc {}
+        refs: [{
+          key: "b1"
+          value: {
+            loc {}
+            interior_shape { type: FLOAT32 dims: {size:1 stride:1} }
+          }
+        }, {
+          key: "b2"
+          value: {
+            loc {}
+            interior_shape { type: FLOAT32 dims: {size:1 stride:1} }
+          }
+        }]
+        stmts { load { from:"b1" into:"$1" } }
+        stmts { store { from:"$1" into:"b2" } deps: 0 }
+        stmts { store { from:"$1" into:"b2" } deps: 1 }
+        stmts { load { from:"b2" into:"$2" } deps: 2 }
+        stmts { load { from:"b2" into:"$3" } deps: 2 }
+        stmts { store { from:"$3" into:"b1" } deps: 4 }
+      }
+    }
+  )";
+
+  auto output_proto = IntoProto(*prog->entry);
+  EXPECT_THAT(output_proto, EqualsProtoText(expected));
+}
+
 }  // namespace codegen
 }  // namespace tile
 }  // namespace vertexai
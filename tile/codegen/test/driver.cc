@@ -0,0 +1,155 @@
+// Copyright 2019, Intel Corp.
+
+#include <gmock/gmock.h>
+#include <google/protobuf/util/json_util.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "base/proto/proto.h"
+#include "tile/codegen/codegen.pb.h"
+#include "tile/codegen/driver.h"
+#include "tile/lang/gen_stripe.h"
+#include "tile/lang/runinfo.h"
+#include "tile/stripe/stripe.h"
+
+namespace vertexai {
+namespace tile {
+namespace codegen {
+namespace test {
+
+using ::testing::Eq;
+using ::testing::Ge;
+using ::testing::Gt;
+
+namespace {
+
+std::shared_ptr<stripe::Program> MakeProgram(size_t batch) {
+  lang::RunInfo runinfo;
+  runinfo.program_name = "driver_test";
+  runinfo.code = R"***(
+    function (A[I, J]) -> (B) {
+      B = A + A;
+    }
+  )***";
+  runinfo.input_shapes.emplace("A", SimpleShape(DataType::FLOAT32, {batch, 8}));
+  runinfo.output_shapes.emplace("B", SimpleShape(DataType::FLOAT32, {batch, 8}));
+  return GenerateStripe(runinfo);
+}
+
+proto::Stage MakeStage() {
+  return ParseProtoText<proto::Stage>(R"(
+    passes: [
+      {
+        name: "loc_prog"
+        pass: {
+          [type.vertex.ai/vertexai.tile.codegen.proto.LocateMemoryPass] {
+            reqs: ["program"]
+            loc: { devs: [{name: "DRAM"}] }
+          }
+        }
+      }, {
+        name: "dead_code_elimination"
+        pass: {
+          [type.vertex.ai/vertexai.tile.codegen.proto.DeadCodeEliminationPass] {
+            reqs: ["all"]
+          }
+        }
+      }
+    ]
+  )");
+}
+
+std::string ToString(const stripe::Block& block) {
+  std::stringstream ss;
+  ss << block;
+  return ss.str();
+}
+
+}  // namespace
+
+TEST(DriverTest, ProfilePasses) {
+  auto program = MakeProgram(8);
+  auto stage = MakeStage();
+  proto::OptimizeProfile profile;
+  OptimizeOptions options;
+  options.profile = &profile;
+  CompilerState state(program);
+  Optimize(&state, stage.passes(), options);
+
+  ASSERT_THAT(profile.passes_size(), Eq(2));
+  EXPECT_THAT(profile.passes(0).name(), Eq("loc_prog"));
+  EXPECT_THAT(profile.passes(0).type(), Eq("vertexai.tile.codegen.proto.LocateMemoryPass"));
+  EXPECT_THAT(profile.passes(1).name(), Eq("dead_code_elimination"));
+  for (const auto& pass : profile.passes()) {
+    EXPECT_TRUE(pass.has_statements());
+    EXPECT_THAT(pass.blocks(), Ge(3));  // program, main, and at least one kernel
+    EXPECT_THAT(pass.statements(), Gt(pass.blocks()));
+    EXPECT_THAT(pass.seconds(), Ge(0.0));
+  }
+  EXPECT_THAT(profile.total_seconds(), Ge(profile.passes(0).seconds()));
+}
+
+TEST(DriverTest, ProfileFileKeepsEveryRun) {
+  auto dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+  auto stage = MakeStage();
+  OptimizeOptions options;
+  options.profile_path = dir / "profile.json";
+  for (size_t batch : {8, 16}) {
+    CompilerState state(MakeProgram(batch));
+    Optimize(&state, stage.passes(), options);
+  }
+
+  std::ifstream fin(options.profile_path.string());
+  std::string line;
+  size_t runs = 0;
+  while (std::getline(fin, line)) {
+    proto::OptimizeProfile profile;
+    ASSERT_TRUE(google::protobuf::util::JsonStringToMessage(line, &profile).ok());
+    ASSERT_THAT(profile.passes_size(), Eq(2));
+    for (const auto& pass : profile.passes()) {
+      EXPECT_THAT(pass.process_peak_rss_bytes(), Ge(pass.peak_rss_growth_bytes()));
+    }
+    runs++;
+  }
+  EXPECT_THAT(runs, Eq(2));
+  boost::filesystem::remove_all(dir);
+}
+
+TEST(DriverTest, ResumeFromCheckpoint) {
+  OptimizeCache cache;
+  auto stage = MakeStage();
+  OptimizeOptions options;
+  options.cache = &cache;
+  options.checkpoint_passes = true;
+
+  auto first = MakeProgram(8);
+  CompilerState first_state(first);
+  Optimize(&first_state, stage.passes(), options);
+  EXPECT_THAT(cache.size(), Eq(2));  // one checkpoint per pass
+
+  proto::OptimizeProfile profile;
+  options.profile = &profile;
+  auto second = MakeProgram(8);
+  CompilerState second_state(second);
+  Optimize(&second_state, stage.passes(), options);
+  EXPECT_THAT(profile.checkpointed_passes(), Eq(2));
+  EXPECT_THAT(profile.passes_size(), Eq(0));
+  EXPECT_THAT(ToString(*second->entry), Eq(ToString(*first->entry)));
+  // Neither program is modified after optimization, so both share the final checkpoint's blocks.
+  EXPECT_THAT(second->entry.get(), Eq(first->entry.get()));
+
+  // A different batch size is a different program.
+  auto third = MakeProgram(16);
+  CompilerState third_state(third);
+  Optimize(&third_state, stage.passes(), options);
+  EXPECT_THAT(profile.checkpointed_passes(), Eq(0));
+  EXPECT_THAT(profile.passes_size(), Eq(2));
+  EXPECT_THAT(cache.size(), Eq(4));
+}
+
+}  // namespace test
+}  // namespace codegen
+}  // namespace tile
+}  // namespace vertexai
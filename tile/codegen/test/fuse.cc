@@ -324,6 +324,74 @@ TEST(Codegen, FuseAuto) {
   IVLOG(2, "After>\n" << *program->entry);
 }
 
+static std::shared_ptr<Program> MakeLookaheadProgram() {
+  lang::RunInfo runinfo;
+  runinfo.program_name = "lookahead_fuse";
+  runinfo.code = R"***(
+    function (A, B) -> (C, D) {
+      [[pid(add)]] T = A + B;
+      [[pid(mul)]] D = A * B;
+      [[pid(cmp_lt)]] C = T < 0;
+    }
+  )***";
+  runinfo.input_shapes.emplace("A", SimpleShape(DataType::FLOAT32, {128, 20}));
+  runinfo.input_shapes.emplace("B", SimpleShape(DataType::FLOAT32, {20}));
+  runinfo.output_shapes.emplace("C", SimpleShape(DataType::BOOLEAN, {128, 20}));
+  runinfo.output_shapes.emplace("D", SimpleShape(DataType::FLOAT32, {128, 20}));
+  return GenerateStripe(runinfo);
+}
+
+static std::vector<std::string> KernelNames(const Program& program) {
+  std::vector<std::string> names;
+  for (const auto& stmt : program.entry->SubBlock(0)->stmts) {
+    names.push_back(Block::Downcast(stmt)->name);
+  }
+  return names;
+}
+
+TEST(Codegen, FuseLookahead) {
+  auto program = MakeLookaheadProgram();
+  CompilerState state(program);
+  proto::FusionPass pass;
+  pass.add_a_reqs("eltwise_add");
+  pass.add_b_reqs("eltwise_cmp_lt");
+  FusionPass(pass).Apply(&state);
+  // The consumer is not adjacent, so nothing fuses by default
+  EXPECT_THAT(KernelNames(*program).size(), Eq(3));
+
+  pass.set_lookahead(2);
+  FusionPass(pass).Apply(&state);
+  EXPECT_THAT(KernelNames(*program), ContainerEq(std::vector<std::string>{"add(A,B)+cmp_lt(T,_T1)", "mul(A,B)"}));
+}
+
+TEST(Codegen, FuseCostModel) {
+  proto::FusionPass pass;
+  pass.add_a_reqs("eltwise_add");
+  pass.add_b_reqs("eltwise_cmp_lt");
+  pass.set_lookahead(2);
+  pass.set_strategy(proto::FusionPass::COST);
+
+  // Fusing keeps T from being read back, which saves traffic
+  auto program = MakeLookaheadProgram();
+  auto main = program->entry->SubBlock(0);
+  CostFusionStrategy strategy(pass);
+  auto stmt = main->stmts.begin();
+  auto add = Block::Downcast(*stmt++);
+  auto cmp = Block::Downcast(*++stmt);
+  EXPECT_THAT(strategy.WorkingSet(*add), Eq(4 + 4 + 4));
+  EXPECT_GT(strategy.BytesMoved(*add), strategy.BytesMoved(*cmp));
+  CompilerState state(program);
+  FusionPass(pass).Apply(&state);
+  EXPECT_THAT(KernelNames(*program).size(), Eq(2));
+
+  // But not if the fused working set is too large
+  program = MakeLookaheadProgram();
+  CompilerState limited(program);
+  pass.set_max_working_set(8);
+  FusionPass(pass).Apply(&limited);
+  EXPECT_THAT(KernelNames(*program).size(), Eq(3));
+}
+
 }  // namespace test
 }  // namespace codegen
 }  // namespace tile
@@ -0,0 +1,71 @@
+// Copyright 2020, Intel Corporation
+
+#include <gmock/gmock.h>
+
+#include "tile/codegen/package.h"
+
+namespace vertexai {
+namespace tile {
+namespace codegen {
+namespace test {
+
+using ::testing::ElementsAre;
+using ::testing::Eq;
+using ::testing::SizeIs;
+
+std::shared_ptr<stripe::Block> Kernel(const std::string& name, const std::string& in, const std::string& out,
+                                      size_t range) {
+  auto shape = SimpleShape(DataType::FLOAT32, {range});
+  auto kernel = std::make_shared<stripe::Block>();
+  kernel->name = name;
+  kernel->set_tag("kernel");
+  kernel->idxs = {{"i", range}};
+  kernel->refs.emplace(stripe::RefDir::In, in, "in", std::vector<stripe::Affine>{stripe::Affine("i")}, shape);
+  kernel->refs.emplace(stripe::RefDir::Out, out, "out", std::vector<stripe::Affine>{stripe::Affine("i")}, shape);
+  kernel->stmts.push_back(std::make_shared<stripe::Load>("in", "$x"));
+  kernel->stmts.push_back(std::make_shared<stripe::Store>("$x", "out"));
+  return kernel;
+}
+
+TEST(Codegen, PackKernelsMergesIndependentKernels) {
+  auto shape = SimpleShape(DataType::FLOAT32, {1024});
+  auto root = std::make_shared<stripe::Block>();
+  auto main = std::make_shared<stripe::Block>();
+  main->set_tag("main");
+  for (const auto& name : {"A", "B", "C", "D", "E"}) {
+    root->refs.emplace(stripe::RefDir::None, "", name, std::vector<stripe::Affine>{0}, shape);
+    main->refs.emplace(stripe::RefDir::InOut, name, name, std::vector<stripe::Affine>{0}, shape);
+  }
+  root->stmts.push_back(main);
+  main->stmts.push_back(Kernel("k1", "A", "B", 16));
+  main->stmts.push_back(Kernel("k2", "C", "D", 16));
+  main->stmts.push_back(Kernel("k3", "B", "C", 16));    // Depends on k1, and overwrites k2's input
+  main->stmts.push_back(Kernel("k4", "A", "E", 1024));  // Too large
+
+  auto program = std::make_shared<stripe::Program>();
+  program->entry = root;
+  CompilerState state(program);
+  proto::PackKernelsPass options;
+  options.add_reqs("main");
+  options.add_kernel_reqs("kernel");
+  options.add_package_set("kernel");
+  options.set_max_iterations(64);
+  PackKernelsPass(options).Apply(&state);
+
+  ASSERT_THAT(main->stmts, SizeIs(3));
+  auto pkg = stripe::Block::Downcast(main->stmts.front());
+  EXPECT_THAT(pkg->name, Eq("k1+k2"));
+  EXPECT_TRUE(pkg->has_tag("kernel"));
+  ASSERT_THAT(pkg->idxs, SizeIs(1));
+  EXPECT_THAT(pkg->idxs[0].range, Eq(2));
+  EXPECT_THAT(pkg->refs, SizeIs(4));
+  auto k2 = pkg->SubBlock(1);
+  EXPECT_FALSE(k2->has_tag("kernel"));
+  EXPECT_THAT(k2->constraints, ElementsAre(stripe::Affine("part") - 1, 1 - stripe::Affine("part")));
+  EXPECT_THAT(stripe::Block::Downcast(*std::next(main->stmts.begin()))->name, Eq("k3"));
+}
+
+}  // namespace test
+}  // namespace codegen
+}  // namespace tile
+}  // namespace vertexai
@@ -0,0 +1,139 @@
+// Copyright 2020, Intel Corporation
+
+#include <gmock/gmock.h>
+
+#include <string>
+
+#include "base/proto/proto.h"
+#include "tile/codegen/partition.h"
+#include "tile/stripe/stripe.h"
+#include "tile/stripe/stripe.pb.h"
+
+using ::testing::Eq;
+
+namespace vertexai {
+namespace tile {
+namespace codegen {
+namespace test {
+
+using namespace stripe;  // NOLINT
+
+// O[i, j] = A[i, j] + B[j], over 64x16 float32 tensors: 4KiB of A, 4KiB of O, and 64 bytes of B.
+std::shared_ptr<Block> MakeAddProgram() {
+  return stripe::FromProto(ParseProtoText<stripe::proto::Block>(R"(
+    name: "program" loc {}
+    refs [{
+      key: "A" value { loc {devs: [{name: "RAM"}]} access [{}, {}]
+                       interior_shape {type: FLOAT32 dims: [{size:64 stride:16}, {size:16 stride:1}]} }
+    }, {
+      key: "B" value { loc {devs: [{name: "RAM"}]} access {}
+                       interior_shape {type: FLOAT32 dims: {size:16 stride:1}} }
+    }, {
+      key: "O" value { loc {devs: [{name: "RAM"}]} access [{}, {}]
+                       interior_shape {type: FLOAT32 dims: [{size:64 stride:16}, {size:16 stride:1}]} }
+    }]
+    stmts [{
+      attrs: { key: "main" value {} }
+      block {
+        name: "main" loc {}
+        refs [{
+          key: "A" value { from: "A" dir: In loc {devs: [{name: "RAM"}]} access [{}, {}]
+                           interior_shape {type: FLOAT32 dims: [{size:64 stride:16}, {size:16 stride:1}]} }
+        }, {
+          key: "B" value { from: "B" dir: In loc {devs: [{name: "RAM"}]} access {}
+                           interior_shape {type: FLOAT32 dims: {size:16 stride:1}} }
+        }, {
+          key: "O" value { from: "O" dir: Out loc {devs: [{name: "RAM"}]} access [{}, {}]
+                           interior_shape {type: FLOAT32 dims: [{size:64 stride:16}, {size:16 stride:1}]} }
+        }]
+        stmts [{
+          attrs: { key: "kernel" value {} }
+          block {
+            name: "add" loc {}
+            idxs [{name: "i" range: 64 affine {}}, {name: "j" range: 16 affine {}}]
+            refs [{
+              key: "a" value { from: "A" dir: In loc {devs: [{name: "RAM"}]}
+                               access [{terms {key: "i" value: 1}}, {terms {key: "j" value: 1}}]
+                               interior_shape {type: FLOAT32 dims: [{size:1 stride:16}, {size:1 stride:1}]} }
+            }, {
+              key: "b" value { from: "B" dir: In loc {devs: [{name: "RAM"}]}
+                               access {terms {key: "j" value: 1}}
+                               interior_shape {type: FLOAT32 dims: {size:1 stride:1}} }
+            }, {
+              key: "o" value { from: "O" dir: Out loc {devs: [{name: "RAM"}]}
+                               access [{terms {key: "i" value: 1}}, {terms {key: "j" value: 1}}]
+                               interior_shape {type: FLOAT32 dims: [{size:1 stride:16}, {size:1 stride:1}]} }
+            }]
+            stmts [{load {from: "a" into: "$a"}},
+                   {load {from: "b" into: "$b"}},
+                   {intrinsic {name: "add" type: FLOAT32 inputs: ["$a", "$b"] outputs: ["$o"]}},
+                   {store {from: "$o" into: "o"}}]
+          }
+        }]
+      }
+    }]
+  )"));
+}
+
+proto::StreamMemoryPass StreamOptions(int64_t mem_limit) {
+  return ParseProtoText<proto::StreamMemoryPass>(R"(
+    reqs: ["kernel"],
+    set_tags: ["streamed"],
+    mem_limit: )" + std::to_string(mem_limit) + R"(,
+    mem_loc: { devs: [{name: "DEVICE"}] },
+    xfer_loc: { devs: [{name: "DMA"}] }
+  )");
+}
+
+TEST(Codegen, StreamMemoryLeavesFittingBlocks) {
+  auto prog = std::make_shared<Program>();
+  prog->entry = MakeAddProgram();
+  CompilerState state(prog);
+  StreamMemoryPass(StreamOptions(1 << 20)).Apply(&state);
+  auto kernel = prog->entry->SubBlock(0)->SubBlock(0);
+  EXPECT_FALSE(kernel->has_tag("streamed"));
+  EXPECT_THAT(kernel->idxs.size(), Eq(2));
+}
+
+TEST(Codegen, StreamMemorySlicesOversizedBlocks) {
+  auto prog = std::make_shared<Program>();
+  prog->entry = MakeAddProgram();
+  CompilerState state(prog);
+  // Two slices of 16 rows (1KiB of A, 1KiB of O, and all of B) fit; two slices of 17 don't.
+  StreamMemoryPass(StreamOptions(2 * (2 * 16 * 16 * 4 + 16 * 4))).Apply(&state);
+  IVLOG(2, "Streamed>\n" << *prog->entry);
+
+  auto kernel = prog->entry->SubBlock(0)->SubBlock(0);
+  EXPECT_TRUE(kernel->has_tag("streamed"));
+  EXPECT_TRUE(kernel->has_tag("double_buffered"));
+  // Four slices, computed two per iteration.
+  EXPECT_THAT(kernel->idxs_product(), Eq(2));
+  size_t loads = 0;
+  size_t stores = 0;
+  size_t computes = 0;
+  for (const auto& stmt : kernel->stmts) {
+    auto inner = Block::Downcast(stmt);
+    ASSERT_TRUE(inner);
+    if (inner->has_tag("cache_load")) {
+      loads++;
+    } else if (inner->has_tag("cache_store")) {
+      stores++;
+    } else {
+      computes++;
+    }
+  }
+  EXPECT_THAT(loads, Eq(4));
+  EXPECT_THAT(stores, Eq(2));
+  EXPECT_THAT(computes, Eq(2));
+  // Each slice's tensors live in device memory.
+  for (const auto& ref : kernel->refs) {
+    if (ref.dir == RefDir::None) {
+      EXPECT_THAT(ref.location.devs[0].name, Eq("DEVICE"));
+    }
+  }
+}
+
+}  // namespace test
+}  // namespace codegen
+}  // namespace tile
+}  // namespace vertexai
@@ -31,7 +31,7 @@ int main(int argc, char* argv[]) {
       return EXIT_SUCCESS;
     }
     if (args.count("verbose")) {
-      el::Loggers::setVerboseLevel(args["verbose"].as<int>());
+      vertexai::SetVerbosity(args["verbose"].as<int>());
     }
     args.notify();
 
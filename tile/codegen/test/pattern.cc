@@ -200,6 +200,17 @@ TEST(Pattern, MatchBlock) {
       }));
 }
 
+TEST(Pattern, Signature) {
+  Signature sig{{{"in", 2}, {"in", 1}, {"out", 2}}, 2};
+  EXPECT_TRUE(Matcher("block([ref(in, [_, _]), ref(in, [_]), ref(out, [_, _])], [_, _])").Admits(sig));
+  EXPECT_TRUE(Matcher("block({ref(out, {_, _}), ref(in, [_, _]), ref(D, [_])}, {_, _})").Admits(sig));
+  EXPECT_TRUE(Matcher("block(Refs, Idxs)").Admits(sig));
+  EXPECT_FALSE(Matcher("block([ref(in, [_, _]), ref(in, [_]), ref(out, [_, _])], [_])").Admits(sig));
+  EXPECT_FALSE(Matcher("block([ref(in, [_]), ref(in, [_, _]), ref(out, [_, _])], [_, _])").Admits(sig));
+  EXPECT_FALSE(Matcher("block({ref(out, [_, _]), ref(out, [_, _]), ref(in, [_])}, [_, _])").Admits(sig));
+  EXPECT_FALSE(Matcher("block({ref(in, [_, _]), ref(out, [_, _])}, [_, _])").Admits(sig));
+}
+
 TEST(Pattern, Conv1x1s1) {
   auto I = Placeholder(PLAIDML_DATA_INT8, {1, 100, 100, 56}, "I");
   auto K = Placeholder(PLAIDML_DATA_INT8, {1, 1, 56, 56}, "K");
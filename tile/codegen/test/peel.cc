@@ -0,0 +1,59 @@
+// Copyright 2020, Intel Corporation
+
+#include <gmock/gmock.h>
+
+#include "tile/codegen/peel.h"
+
+namespace vertexai {
+namespace tile {
+namespace codegen {
+namespace test {
+
+using ::testing::ElementsAre;
+using ::testing::Eq;
+using ::testing::IsEmpty;
+using ::testing::SizeIs;
+
+TEST(Codegen, PeelBoundaryTiles) {
+  // Tiles of 8 over a padded input: x * 8 + i must lie within [2, 30).
+  auto shape = SimpleShape(DataType::FLOAT32, {32});
+  auto inner = std::make_shared<stripe::Block>();
+  inner->name = "inner";
+  inner->idxs = {{"x_0", 1, stripe::Affine("x")}, {"i", 8}};
+  inner->constraints = {stripe::Affine("x_0", 8) + stripe::Affine("i") - 2,
+                        stripe::Affine("x_0", -8) - stripe::Affine("i") + 29};
+  auto outer = std::make_shared<stripe::Block>();
+  outer->name = "outer";
+  outer->idxs = {{"x", 4}};
+  outer->refs.emplace(stripe::RefDir::Out, "O", "O", std::vector<stripe::Affine>{stripe::Affine("x", 8)}, shape);
+  outer->stmts.push_back(inner);
+  stripe::Block parent;
+  parent.stmts.push_back(outer);
+
+  PeelBoundaries(&parent, parent.stmts.begin());
+
+  ASSERT_THAT(parent.stmts, SizeIs(3));
+  auto it = parent.stmts.begin();
+  auto lo = stripe::Block::Downcast(*it++);
+  auto mid = stripe::Block::Downcast(*it++);
+  auto hi = stripe::Block::Downcast(*it++);
+  EXPECT_THAT(lo->name, Eq("outer_x_lo"));
+  EXPECT_THAT(lo->idxs[0].range, Eq(1));
+  EXPECT_THAT(lo->SubBlock(0)->constraints, SizeIs(1));
+
+  EXPECT_THAT(mid.get(), Eq(outer.get()));
+  EXPECT_THAT(mid->idxs[0].range, Eq(2));
+  EXPECT_THAT(mid->refs.begin()->access, ElementsAre(stripe::Affine("x", 8) + 8));
+  EXPECT_THAT(mid->SubBlock(0)->idxs[0].affine, Eq(stripe::Affine("x") + 1));
+  EXPECT_THAT(mid->SubBlock(0)->constraints, IsEmpty());
+
+  EXPECT_THAT(hi->name, Eq("outer_x_hi"));
+  EXPECT_THAT(hi->idxs[0].range, Eq(1));
+  EXPECT_THAT(hi->refs.begin()->access, ElementsAre(stripe::Affine("x", 8) + 24));
+  EXPECT_THAT(hi->SubBlock(0)->constraints, SizeIs(1));
+}
+
+}  // namespace test
+}  // namespace codegen
+}  // namespace tile
+}  // namespace vertexai
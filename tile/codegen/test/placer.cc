@@ -283,6 +283,179 @@ TEST(PlacerTest, LocationSubsetCanBePlaced) {
   EXPECT_THAT(output_proto, EqualsProtoText(expected));
 }
 
+// Builds b1 = 0; b2[i] = b1[i] (+ b1[0], if read_first); o = b2.
+static std::shared_ptr<stripe::Block> MakeEltwiseChain(bool read_first = false) {
+  stripe::proto::Block input_proto;
+  gp::TextFormat::ParseFromString(R"(
+    loc {}
+    refs [
+      {
+        key: "b1"
+        value: {
+          loc { devs: [{name: "loc_1"}]}
+          access {}
+          interior_shape { type: FLOAT32 dims: {size:16 stride:1} }
+        }
+      },
+      {
+        key: "b2"
+        value: {
+          loc { devs: [{name: "loc_1"}]}
+          access {}
+          interior_shape { type: FLOAT32 dims: {size:16 stride:1} }
+        }
+      },
+      {
+        key: "o"
+        value: {
+          loc { devs: [{name: "loc_2"}]}
+          access {}
+          interior_shape { type: FLOAT32 dims: {size:16 stride:1} }
+        }
+      }
+    ]
+    stmts { special { name:"zero" outputs:"b1"} }
+    stmts {
+      attrs { key: "eltwise" value {} }
+      block {
+        idxs { name: "i" range: 16 }
+        refs [
+          {
+            key: "x"
+            value: {
+              dir: In
+              from: "b1"
+              access { terms { key: "i" value: 1 } }
+              interior_shape { type: FLOAT32 dims: {size:1 stride:1} }
+            }
+          },
+          {
+            key: "y"
+            value: {
+              dir: Out
+              from: "b2"
+              access { terms { key: "i" value: 1 } }
+              interior_shape { type: FLOAT32 dims: {size:1 stride:1} }
+            }
+          }
+        ]
+        stmts { load { from:"x" into:"$x" } }
+        stmts { store { from:"$x" into:"y" } deps: 0 }
+      }
+      deps: 0
+    }
+    stmts { special { name:"copy" inputs:"b2" outputs:"o"} deps: 1 }
+  )",
+                                  &input_proto);
+  if (read_first) {
+    gp::TextFormat::ParseFromString(R"(
+      dir: In
+      from: "b1"
+      access {}
+      interior_shape { type: FLOAT32 dims: {size:1 stride:1} }
+    )",
+                                    &(*input_proto.mutable_stmts(1)->mutable_block()->mutable_refs())["x0"]);
+  }
+  return stripe::FromProto(input_proto);
+}
+
+TEST(PlacerTest, EltwiseOutputsInterfereWithInputs) {
+  auto block = MakeEltwiseChain();
+  proto::MemoryPlacementPass options;
+  options.add_locs()->add_devs()->set_name("loc_1");
+
+  auto report = PlaceRefinements(block.get(), options);
+
+  EXPECT_NE(block->ref_by_into("b1")->offset, block->ref_by_into("b2")->offset);
+  ASSERT_EQ(report.arenas.size(), 1);
+  const auto& arena = report.arenas.begin()->second;
+  EXPECT_EQ(arena.chunks, 2);
+  EXPECT_EQ(arena.total_bytes, 128);
+  EXPECT_EQ(arena.peak_bytes, 128);
+  EXPECT_EQ(report.inplace, 0);
+}
+
+TEST(PlacerTest, EltwiseInplaceReusesDeadInputs) {
+  auto block = MakeEltwiseChain();
+  proto::MemoryPlacementPass options;
+  options.add_locs()->add_devs()->set_name("loc_1");
+  options.set_eltwise_inplace(true);
+
+  auto report = PlaceRefinements(block.get(), options);
+
+  EXPECT_EQ(block->ref_by_into("b1")->offset, block->ref_by_into("b2")->offset);
+  EXPECT_TRUE(block->ref_by_into("b2")->has_tag("placed"));
+  ASSERT_EQ(report.arenas.size(), 1);
+  const auto& arena = report.arenas.begin()->second;
+  EXPECT_EQ(arena.chunks, 2);
+  EXPECT_EQ(arena.total_bytes, 128);
+  EXPECT_EQ(arena.peak_bytes, 64);
+  EXPECT_EQ(report.inplace, 1);
+}
+
+TEST(PlacerTest, EltwiseInplaceRequiresEveryReadToMatch) {
+  // Instance i would overwrite b1[i], which instance 0 wrote but every other instance still reads as b1[0].
+  auto block = MakeEltwiseChain(true);
+  proto::MemoryPlacementPass options;
+  options.add_locs()->add_devs()->set_name("loc_1");
+  options.set_eltwise_inplace(true);
+
+  auto report = PlaceRefinements(block.get(), options);
+
+  EXPECT_NE(block->ref_by_into("b1")->offset, block->ref_by_into("b2")->offset);
+  EXPECT_EQ(report.inplace, 0);
+}
+
+TEST(PlacerTest, ReshapeInplaceAliasesDeadInputs) {
+  stripe::proto::Block input_proto;
+  gp::TextFormat::ParseFromString(R"(
+    loc {}
+    refs [
+      {
+        key: "b1"
+        value: {
+          loc { devs: [{name: "loc_1"}]}
+          access {}
+          interior_shape { type: FLOAT32 dims: {size:16 stride:1} }
+        }
+      },
+      {
+        key: "b2"
+        value: {
+          loc { devs: [{name: "loc_1"}]}
+          access [{}, {}]
+          interior_shape { type: FLOAT32 dims: {size:4 stride:4} dims: {size:4 stride:1} }
+        }
+      },
+      {
+        key: "o"
+        value: {
+          loc { devs: [{name: "loc_2"}]}
+          access [{}, {}]
+          interior_shape { type: FLOAT32 dims: {size:4 stride:4} dims: {size:4 stride:1} }
+        }
+      }
+    ]
+    stmts { special { name:"zero" outputs:"b1"} }
+    stmts { special { name:"reshape" inputs:"b1" outputs:"b2"} deps: 0 }
+    stmts { special { name:"copy" inputs:"b2" outputs:"o"} deps: 1 }
+  )",
+                                  &input_proto);
+  auto block = stripe::FromProto(input_proto);
+  proto::MemoryPlacementPass options;
+  options.add_locs()->add_devs()->set_name("loc_1");
+  options.set_reshape_inplace(true);
+
+  auto report = PlaceRefinements(block.get(), options);
+
+  EXPECT_EQ(block->ref_by_into("b1")->offset, block->ref_by_into("b2")->offset);
+  EXPECT_TRUE(block->ref_by_into("b2")->has_tag("placed"));
+  EXPECT_TRUE((*std::next(block->stmts.begin()))->has_tag("inplace"));
+  ASSERT_EQ(report.arenas.size(), 1);
+  EXPECT_EQ(report.arenas.begin()->second.peak_bytes, 64);
+  EXPECT_EQ(report.inplace, 1);
+}
+
 }  // namespace codegen
 }  // namespace tile
 }  // namespace vertexai
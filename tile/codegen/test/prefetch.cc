@@ -0,0 +1,43 @@
+// Copyright 2020, Intel Corporation
+
+#include <gmock/gmock.h>
+
+#include "tile/codegen/prefetch.h"
+
+namespace vertexai {
+namespace tile {
+namespace codegen {
+namespace test {
+
+using ::testing::ElementsAre;
+using ::testing::Eq;
+
+TEST(Codegen, PrefetchStridedLoads) {
+  // Reads A transposed and B in order; the inner index j strides A by a row.
+  auto shape = SimpleShape(DataType::FLOAT32, {64, 64});
+  stripe::Block block;
+  block.idxs = {{"i", 64}, {"j", 64}};
+  std::vector<stripe::Affine> transposed{stripe::Affine("j"), stripe::Affine("i")};
+  std::vector<stripe::Affine> in_order{stripe::Affine("i"), stripe::Affine("j")};
+  block.refs.emplace(stripe::RefDir::In, "A", "A", transposed, shape);
+  block.refs.emplace(stripe::RefDir::In, "B", "B", in_order, shape);
+  block.stmts.push_back(std::make_shared<stripe::Load>("A", "$a"));
+  block.stmts.push_back(std::make_shared<stripe::Load>("B", "$b"));
+
+  proto::PrefetchPass options;
+  options.set_distance(4);
+  InsertPrefetches(&block, options);
+  InsertPrefetches(&block, options);
+
+  ASSERT_THAT(block.stmts.size(), Eq(3));
+  auto prefetch = stripe::Special::Downcast(block.stmts.front());
+  ASSERT_TRUE(prefetch);
+  EXPECT_THAT(prefetch->name, Eq("prefetch"));
+  EXPECT_THAT(prefetch->inputs, ElementsAre("A"));
+  EXPECT_THAT(prefetch->int_params.at("offset"), Eq(4 * 64));
+}
+
+}  // namespace test
+}  // namespace codegen
+}  // namespace tile
+}  // namespace vertexai
@@ -0,0 +1,102 @@
+// Copyright 2020, Intel Corporation.
+
+#include <gmock/gmock.h>
+
+#include "plaidml2/edsl/helper.h"
+#include "tile/codegen/stages.h"
+#include "tile/codegen/vm.h"
+#include "tile/lib/lib.h"
+#include "tile/stripe/stripe.h"
+
+using ::testing::ContainerEq;
+using ::testing::ElementsAre;
+using ::testing::Eq;
+using ::testing::SizeIs;
+
+namespace vertexai {
+namespace tile {
+namespace codegen {
+namespace test {
+
+using plaidml::edsl::LogicalShape;
+
+std::shared_ptr<stripe::Program> MakeProgram() {
+  auto shape = LogicalShape(PLAIDML_DATA_FLOAT32, {4});
+  return plaidml::edsl::ConvertIntoStripe(lib::LoadEltwiseMultiAdd("sum", shape, shape, shape, shape));
+}
+
+std::map<std::string, Buffer> MakeInputs() {
+  return {
+      {"A", {1, 2, 3, 4}},
+      {"B", {10, 20, 30, 40}},
+      {"C", {100, 200, 300, 400}},
+      {"D", {1000, 2000, 3000, 4000}},
+  };
+}
+
+TEST(Stages, SplitsKernelsAndRunsInSequence) {
+  auto whole = MakeProgram();
+  auto expected = MakeInputs();
+  for (const auto& kvp : whole->output_shapes) {
+    expected[kvp.first] = Buffer(kvp.second.elem_size());
+  }
+  ExecuteProgram(*whole->entry, &expected);
+
+  auto program = MakeProgram();
+  auto stages = PartitionStages(*program, 2);
+  ASSERT_THAT(stages, SizeIs(2));
+  // The three additions split evenly as can be, passing one temporary between the stages.
+  EXPECT_THAT(stages[0].program->entry->SubBlock(0)->stmts.size() +
+                  stages[1].program->entry->SubBlock(0)->stmts.size(),
+              Eq(program->entry->SubBlock(0)->stmts.size()));
+  ASSERT_THAT(stages[0].outputs, SizeIs(1));
+  EXPECT_THAT(stages[1].inputs, testing::Contains(stages[0].outputs[0]));
+  EXPECT_THAT(stages[0].program->output_shapes.count(stages[0].outputs[0]), Eq(1));
+  EXPECT_THAT(stages[1].outputs, ElementsAre(whole->output_shapes.begin()->first));
+
+  auto actual = MakeInputs();
+  for (const auto& stage : stages) {
+    for (const auto& kvp : stage.program->output_shapes) {
+      actual.emplace(kvp.first, Buffer(kvp.second.elem_size()));
+    }
+    ExecuteProgram(*stage.program->entry, &actual);
+  }
+  const auto& name = whole->output_shapes.begin()->first;
+  EXPECT_THAT(actual[name], ContainerEq(expected[name]));
+}
+
+TEST(Stages, LimitsStagesToStatements) {
+  auto program = MakeProgram();
+  auto count = program->entry->SubBlock(0)->stmts.size();
+  auto stages = PartitionStages(*program, count + 4);
+  EXPECT_THAT(stages, SizeIs(count));
+  double cost = 0;
+  for (const auto& stage : stages) {
+    EXPECT_THAT(stage.program->entry->SubBlock(0)->stmts, SizeIs(1));
+    cost += stage.cost;
+  }
+  EXPECT_NEAR(cost, 1.0, 1e-9);
+}
+
+TEST(Stages, PlacesKernelsByCost) {
+  std::vector<DeviceCost> devices(2);
+  devices[1].flops_per_sec = devices[0].flops_per_sec * 100;
+  devices[1].bytes_per_sec = devices[0].bytes_per_sec * 100;
+
+  // Without launch overheads, every kernel runs on the faster device.
+  auto stages = PlaceStages(*MakeProgram(), devices, devices[0].bytes_per_sec);
+  ASSERT_THAT(stages, SizeIs(1));
+  EXPECT_THAT(stages[0].device, Eq(1));
+  EXPECT_NEAR(stages[0].cost, 1.0, 1e-9);
+
+  // Small kernels stay where they launch quickly.
+  devices[1].launch_sec = 1;
+  stages = PlaceStages(*MakeProgram(), devices, devices[0].bytes_per_sec);
+  ASSERT_THAT(stages, SizeIs(1));
+  EXPECT_THAT(stages[0].device, Eq(0));
+}
+
+}  // namespace test
+}  // namespace codegen
+}  // namespace tile
+}  // namespace vertexai
@@ -0,0 +1,115 @@
+// Copyright 2020, Intel Corporation
+
+#include <gmock/gmock.h>
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "base/util/env.h"
+#include "base/util/runtime_options.h"
+#include "tile/lang/gen_trivial.h"
+#include "tile/lang/runinfo.h"
+#include "tile/ocl_exec/stripe_gen.h"
+
+using ::testing::Eq;
+using ::testing::IsEmpty;
+using ::testing::Ne;
+using ::testing::SizeIs;
+
+namespace vertexai {
+namespace tile {
+namespace codegen {
+namespace test {
+
+// A program of one kernel zeroing a buffer of size elements, with the given workgroup size.
+lang::KernelList ZeroProgram(size_t size, size_t lwork, const std::string& buffer = "B") {
+  lang::KernelList kernels;
+  auto shape = SimpleShape(DataType::FLOAT32, {size});
+  kernels.types[buffer] = shape;
+  kernels.kernels.push_back(lang::GenZero(shape, buffer, "kernel_0"));
+  kernels.kernels.back().lwork[0] = lwork;
+  return kernels;
+}
+
+TEST(StripeGen, KernelDigestIgnoresName) {
+  auto shape = SimpleShape(DataType::FLOAT32, {64});
+  EXPECT_THAT(KernelDigest(lang::GenZero(shape, "B", "kernel_0")), Eq(KernelDigest(lang::GenZero(shape, "B", "k1"))));
+  // The code and launch dimensions count.
+  auto resized = SimpleShape(DataType::FLOAT32, {32});
+  EXPECT_THAT(KernelDigest(lang::GenZero(resized, "B", "kernel_0")),
+              Ne(KernelDigest(lang::GenZero(shape, "B", "kernel_0"))));
+  EXPECT_THAT(KernelDigest(ZeroProgram(64, 8).kernels[0]), Ne(KernelDigest(ZeroProgram(64, 16).kernels[0])));
+}
+
+TEST(StripeGen, AddCandidatesKeepsDistinctVersions) {
+  auto kernels = ZeroProgram(64, 8);
+  std::vector<lang::KernelList> rounds{
+      ZeroProgram(64, 8),        // The same as the default kernel
+      ZeroProgram(64, 16),       // A new version
+      ZeroProgram(64, 16),       // The same as the first candidate
+      ZeroProgram(64, 32, "C"),  // Writes another buffer, so it can't stand in for the default kernel
+      ZeroProgram(64, 4),        // Another new version
+  };
+  AddCandidates(&kernels, rounds);
+
+  const auto& ki = kernels.kernels[0];
+  EXPECT_THAT(ki.key, Eq("stripe:" + std::to_string(KernelDigest(ki))));
+  EXPECT_THAT(ki.variant, Eq(std::to_string(KernelDigest(ki))));
+  EXPECT_THAT(ki.tile.shape, IsEmpty());
+  ASSERT_THAT(ki.candidates, SizeIs(2));
+  std::set<std::string> variants{ki.variant};
+  for (const auto& candidate : ki.candidates) {
+    EXPECT_THAT(candidate.key, Eq(ki.key));
+    EXPECT_THAT(candidate.kname, Eq(ki.kname));
+    EXPECT_THAT(candidate.kfunc->name, Eq(ki.kname));
+    EXPECT_THAT(candidate.variant, Eq(std::to_string(KernelDigest(candidate))));
+    EXPECT_THAT(candidate.tile.shape, IsEmpty());
+    variants.insert(candidate.variant);
+  }
+  EXPECT_THAT(variants, SizeIs(3));
+  EXPECT_THAT(ki.candidates[0].lwork[0], Eq(16));
+  EXPECT_THAT(ki.candidates[1].lwork[0], Eq(4));
+}
+
+TEST(StripeGen, TuningRoundsAttachCandidates) {
+  lang::RunInfo runinfo;
+  runinfo.program_name = "matmul";
+  runinfo.code = "function (A[M, K], B[K, N]) -> (C) { C[m, n : M, N] = +(A[m, k] * B[k, n]); }";
+  runinfo.input_shapes.emplace("A", SimpleShape(DataType::FLOAT32, {256, 256}));
+  runinfo.input_shapes.emplace("B", SimpleShape(DataType::FLOAT32, {256, 256}));
+  runinfo.output_shapes.emplace("C", SimpleShape(DataType::FLOAT32, {256, 256}));
+  context::Context ctx;
+  // Don't append to the user's codegen profile.
+  env::Set("PLAIDML_CODEGEN_PROFILE", "");
+  RuntimeOptions::Reload();
+  // The constant passes expect a buffer manager, as every real caller has one.
+  ConstBufferManager const_bufs;
+
+  auto plain = GenerateProgram(ctx, runinfo, "intel_gen9_opencl", "", &const_bufs);
+  for (const auto& ki : plain.kernels) {
+    EXPECT_THAT(ki.candidates, IsEmpty());
+  }
+
+  auto tuned = GenerateProgram(ctx, runinfo, "intel_gen9_opencl", "", &const_bufs, 4);
+  ASSERT_THAT(tuned.kernels.size(), Eq(plain.kernels.size()));
+  size_t candidates = 0;
+  for (const auto& ki : tuned.kernels) {
+    EXPECT_THAT(ki.variant, Ne(""));
+    EXPECT_THAT(ki.candidates.size(), ::testing::Le(3));
+    std::set<std::string> variants{ki.variant};
+    for (const auto& candidate : ki.candidates) {
+      EXPECT_THAT(candidate.key, Eq(ki.key));
+      EXPECT_THAT(candidate.kname, Eq(ki.kname));
+      EXPECT_TRUE(variants.insert(candidate.variant).second);
+    }
+    candidates += ki.candidates.size();
+  }
+  // The matmul's autotile search has more than one valid tiling.
+  EXPECT_THAT(candidates, ::testing::Gt(0));
+}
+
+}  // namespace test
+}  // namespace codegen
+}  // namespace tile
+}  // namespace vertexai
@@ -0,0 +1,83 @@
+// Copyright 2020, Intel Corp.
+
+#include <gmock/gmock.h>
+
+#include "plaidml2/edsl/helper.h"
+#include "tile/codegen/tile.h"
+#include "tile/codegen/vm.h"
+#include "tile/lib/lib.h"
+#include "tile/stripe/stripe.h"
+#include "tile/targets/cpu/profile.h"
+
+using ::testing::Eq;
+using ::testing::Ge;
+
+namespace vertexai {
+namespace tile {
+namespace codegen {
+namespace test {
+
+using plaidml::edsl::LogicalShape;
+
+TEST(VM, ProfileProgram) {
+  auto tileProgram = lib::LoadMatMul(                //
+      "matmul",                                      //
+      LogicalShape(PLAIDML_DATA_FLOAT32, {4, 4}),  //
+      LogicalShape(PLAIDML_DATA_FLOAT32, {4, 4}));
+  auto program = plaidml::edsl::ConvertIntoStripe(tileProgram);
+  auto main = program->entry->SubBlock(0);
+  auto kernel = main->SubBlock(0);
+  ApplyTile(kernel.get(), {2, 2, 4});
+  kernel->SubBlock(0)->name = "inner";
+
+  std::map<std::string, Buffer> data = {
+      {"A", Buffer(16, 1)},
+      {"B", Buffer(16, 1)},
+      {"C", Buffer(16, 0)},
+  };
+  ProfileProgram(program->entry.get(), &data);
+  EXPECT_THAT(data["C"], Eq(Buffer(16, 4)));
+
+  EXPECT_THAT(main->get_attr_int("execution_count"), Eq(1));
+  EXPECT_THAT(kernel->get_attr_int("execution_count"), Eq(1));
+  // The outer kernel runs a 2x2x1 space, entering its inner block once per point.
+  EXPECT_THAT(kernel->SubBlock(0)->get_attr_int("execution_count"), Eq(4));
+  EXPECT_THAT(main->get_attr_int("wall_ns"), Ge(kernel->get_attr_int("wall_ns")));
+
+  auto profiles = targets::cpu::AggregateBlockProfiles(*program->entry);
+  ASSERT_THAT(profiles.count("inner"), Eq(1));
+  EXPECT_THAT(profiles["inner"].blocks, Eq(1));
+  EXPECT_THAT(profiles["inner"].executions, Eq(4));
+  EXPECT_THAT(profiles["inner"].self_ns, Eq(profiles["inner"].wall_ns));
+  EXPECT_THAT(profiles[kernel->name].self_ns, Eq(kernel->get_attr_int("wall_ns") - profiles["inner"].wall_ns));
+}
+
+TEST(VM, MatchesReference) {
+  const int64_t dim = 32;
+  auto tileProgram = lib::LoadMatMul(                  //
+      "matmul",                                        //
+      LogicalShape(PLAIDML_DATA_FLOAT32, {dim, dim}),  //
+      LogicalShape(PLAIDML_DATA_FLOAT32, {dim, dim}));
+  auto program = plaidml::edsl::ConvertIntoStripe(tileProgram);
+  auto kernel = program->entry->SubBlock(0)->SubBlock(0);
+  ApplyTile(kernel.get(), {4, 8, 2});
+
+  std::map<std::string, Buffer> expected = {
+      {"A", Buffer(dim * dim)},
+      {"B", Buffer(dim * dim)},
+      {"C", Buffer(dim * dim, 0)},
+  };
+  for (int64_t i = 0; i < dim * dim; i++) {
+    expected["A"][i] = i % 7 - 3;
+    expected["B"][i] = i % 5 - 2;
+  }
+  auto actual = expected;
+  ExecuteProgramReference(*program->entry, &expected);
+  ExecuteProgram(*program->entry, &actual);
+  EXPECT_THAT(actual["C"], Eq(expected["C"]));
+}
+
+}  // namespace test
+}  // namespace codegen
+}  // namespace tile
+}  // namespace vertexai
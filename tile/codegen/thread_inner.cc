@@ -3,10 +3,12 @@
 #include "tile/codegen/thread_inner.h"
 
 #include <algorithm>
+#include <vector>
 
 #include <boost/format.hpp>
 
 #include "base/util/throw.h"
+#include "tile/codegen/deps.h"
 #include "tile/codegen/tile.h"
 #include "tile/math/util.h"
 #include "tile/stripe/stripe.h"
@@ -19,6 +21,26 @@ using namespace stripe;  // NOLINT
 using math::NearestPo2;
 using math::RoundUp;
 
+namespace {
+
+// Gives each run of consecutive sub-blocks which don't depend on one another the same "cpu_task_group" attribute,
+// so that the CPU backend may run them concurrently.
+void AssignTaskGroups(const AliasMap& scope, Block* block) {
+  AliasMap map(scope, block);
+  ComputeDepsForBlock(block, map);
+  auto runs = IndependentRuns(block, [](const Block& inner) { return !inner.has_tag("xsmm"); });
+  for (size_t group = 0; group < runs.size(); group++) {
+    for (const auto& it : runs[group]) {
+      Block::Downcast(*it)->set_attr("cpu_task_group", static_cast<int64_t>(group));
+    }
+  }
+  if (runs.size()) {
+    IVLOG(3, "Task groups in " << block->name << ": " << runs.size());
+  }
+}
+
+}  // namespace
+
 void DoThreadInnerPass(const AliasMap& scope, Block* block, const proto::ThreadInnerPass& options) {
   if (block->has_any_tags(FromProto(options.exclude()))) {
     return;
@@ -89,6 +111,9 @@ void DoThreadInnerPass(const AliasMap& scope, Block* block, const proto::ThreadI
   ApplyTile(block, tile, false, false, true);
   block->add_tags(FromProto(options.outer_set()));
   block->SubBlock(0)->add_tags(FromProto(options.inner_set()));
+  if (options.task_parallel() && threads > 1) {
+    AssignTaskGroups(AliasMap(scope, block), block->SubBlock(0).get());
+  }
 }
 
 // Localize starting from root for things that match reqs
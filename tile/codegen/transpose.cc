@@ -2,6 +2,12 @@
 
 #include "tile/codegen/transpose.h"
 
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "tile/codegen/fix_strides.h"
 #include "tile/codegen/localize.h"
 
 namespace vertexai {
@@ -53,9 +59,145 @@ struct DimCompare {
   }
 };
 
+// One block's access to a buffer, as seen by the layout search.
+struct LayoutAccess {
+  const Block* block;
+  std::vector<Affine> access;
+  double weight;  // The block's iteration count
+};
+
+struct LayoutUsage {
+  Block* base_block;
+  Refinement* base_ref;
+  std::vector<LayoutAccess> accesses;
+};
+
+// Collects every producer and consumer of the buffers whose layouts may be searched: allocations in blocks matching
+// alloc_reqs, and (with transform_consts) constant program inputs.
+void CollectLayoutUsage(std::map<std::string, LayoutUsage>* usages, const Block& block, const AliasMap& map,
+                        const Tags& alloc_reqs, bool transform_consts) {
+  for (const auto& ref : block.refs) {
+    if (ref.dir == RefDir::None) {
+      continue;
+    }
+    const auto& alias = map.at(ref.into());
+    const auto& base_ref = *alias.base_ref;
+    bool searchable = base_ref.has_tag("user") ? transform_consts && base_ref.interior_shape.is_const
+                                               : alias.base_block->has_tags(alloc_reqs);
+    if (!searchable || ref.access.size() != base_ref.interior_shape.dims.size()) {
+      continue;
+    }
+    auto it = usages->emplace(alias.base_name, LayoutUsage{alias.base_block, alias.base_ref, {}}).first;
+    it->second.accesses.emplace_back(
+        LayoutAccess{&block, ref.access, static_cast<double>(std::max<size_t>(block.idxs_product(), 1))});
+  }
+}
+
+// The fraction of a vector an access fills when dim is stride-1: the longest run of elements along dim that one of
+// the block's indexes steps through, touching no other dimension.
+double VectorFill(const LayoutAccess& access, size_t dim, size_t vec_elems) {
+  uint64_t run = 1;
+  for (const auto& kvp : access.access[dim].getMap()) {
+    if (kvp.first.empty() || kvp.second != 1) {
+      continue;
+    }
+    bool only_dim = true;
+    for (size_t other = 0; other < access.access.size(); other++) {
+      if (other != dim && access.access[other].get(kvp.first)) {
+        only_dim = false;
+      }
+    }
+    const auto* idx = access.block->idx_by_name(kvp.first);
+    if (only_dim && idx) {
+      run = std::max(run, idx->range);
+    }
+  }
+  return static_cast<double>(std::min<uint64_t>(run, vec_elems)) / vec_elems;
+}
+
+// Makes dim stride-1, keeping the other dimensions in their current order.
+TensorShape MakeInnermost(const TensorShape& shape, size_t dim) {
+  std::vector<size_t> order;
+  for (size_t i = 0; i < shape.dims.size(); i++) {
+    if (i != dim) {
+      order.push_back(i);
+    }
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [&](size_t lhs, size_t rhs) { return shape.dims[lhs].stride < shape.dims[rhs].stride; });
+  auto ret = shape;
+  int64_t stride = 1;
+  ret.dims.set_stride(dim, stride);
+  stride *= shape.dims[dim].size;
+  for (auto i : order) {
+    ret.dims.set_stride(i, stride);
+    stride *= shape.dims[i].size;
+  }
+  return ret;
+}
+
+void SearchLayouts(CompilerState* state, const proto::TransposePass& options) {
+  auto reqs = FromProto(options.reqs());
+  auto alloc_reqs = FromProto(options.alloc_reqs());
+  bool transform_consts = options.transform_consts() && state->const_bufs;
+  std::map<std::string, LayoutUsage> usages;
+  RunOnBlocks(state->entry(), reqs, [&](const AliasMap& map, Block* block) {  //
+    CollectLayoutUsage(&usages, *block, map, alloc_reqs, transform_consts);
+  });
+  for (auto& item : usages) {
+    auto& usage = item.second;
+    auto* base_ref = usage.base_ref;
+    const auto& shape = base_ref->interior_shape;
+    if (shape.dims.size() < 2 || shape.type == DataType::PRNG || shape.type == DataType::BOOLEAN) {
+      continue;
+    }
+    bool is_const = base_ref->has_tag("user");
+    if (is_const && !state->const_bufs->buffers.count(base_ref->into())) {
+      continue;
+    }
+    auto vec_elems = std::max<size_t>(1, options.vector_bytes() / byte_width(shape.type));
+    std::vector<double> scores(shape.dims.size());
+    for (const auto& access : usage.accesses) {
+      for (size_t dim = 0; dim < scores.size(); dim++) {
+        scores[dim] += access.weight * VectorFill(access, dim, vec_elems);
+      }
+    }
+    size_t current = shape.dims.size();
+    size_t best = 0;
+    for (size_t dim = 0; dim < scores.size(); dim++) {
+      if (shape.dims[dim].stride == 1 && shape.dims[dim].size > 1) {
+        current = dim;
+      }
+      if (scores[dim] > scores[best]) {
+        best = dim;
+      }
+    }
+    double current_score = current < scores.size() ? scores[current] : 0;
+    IVLOG(3, "TransposePass> base: " << item.first << ", scores: " << scores << ", current: " << current
+                                      << ", best: " << best);
+    if (best == current || scores[best] <= current_score * (1 + options.min_gain())) {
+      continue;
+    }
+    auto new_shape = MakeInnermost(shape, best);
+    if (new_shape == shape) {
+      continue;
+    }
+    IVLOG(2, "TransposePass> " << item.first << ": " << shape << " -> " << new_shape);
+    if (is_const) {
+      RelayoutConstBuffer(state, base_ref->into(), shape, new_shape);
+    }
+    base_ref->interior_shape = new_shape;
+    FixupRefs(usage.base_block, base_ref->into());
+  }
+}
+
 }  // namespace
 
 void TransposePass::Apply(CompilerState* state) const {
+  if (options_.search()) {
+    SearchLayouts(state, options_);
+    return;
+  }
   auto reqs = FromProto(options_.reqs());
   auto alloc_reqs = FromProto(options_.alloc_reqs());
   BufferUsageMap usages;
@@ -88,15 +230,11 @@ void TransposePass::Apply(CompilerState* state) const {
     auto old_ref = *base_ref;
     // Adjust strides
     int64_t stride = 1;
-    {
-      auto& dim = base_ref->interior_shape.dims[stride_one_idx];
-      dim.stride = stride;
-      stride *= dim.size;
-    }
+    base_ref->interior_shape.dims.set_stride(stride_one_idx, stride);
+    stride *= base_ref->interior_shape.dims[stride_one_idx].size;
     for (const auto& idx : idxs_by_size) {
-      auto& dim = base_ref->interior_shape.dims[idx.second];
-      dim.stride = stride;
-      stride *= dim.size;
+      base_ref->interior_shape.dims.set_stride(idx.second, stride);
+      stride *= base_ref->interior_shape.dims[idx.second].size;
     }
     if (!(old_ref.interior_shape == base_ref->interior_shape)) {
       IVLOG(3, "    old_ref: " << old_ref);
@@ -2,8 +2,12 @@
 
 #include "tile/codegen/unroll.h"
 
+#include <algorithm>
 #include <list>
 #include <map>
+#include <memory>
+#include <optional>
+#include <set>
 #include <string>
 #include <tuple>
 #include <unordered_map>
@@ -309,10 +313,301 @@ void UnrollBlock(Block* outer,                     //
   }
 }
 
+// Unroll and jam.
+//
+// The CPU backend flattens a leaf block's indexes into a single loop, recovering each index by division on every
+// iteration, so a small body pays a large per-iteration overhead; and a body which aggregates into the same element on
+// consecutive iterations is bound by the latency of that chain.  Unrolling one index by a factor and jamming the copies
+// (emitting each statement's copies together) amortizes the overhead over the copies and gives the backend one
+// independent chain per copy, at the cost of registers and code size.
+
+constexpr double kIssueWidth = 2;      // Statements issued per cycle.
+constexpr double kAggLatency = 4;      // Cycles between aggregations into one element.
+constexpr double kIndexOverhead = 3;   // Statements per index to advance the flattened loop.
+constexpr double kBranchOverhead = 2;  // Statements to test and branch on the flattened loop.
+
+bool DependsOn(const Refinement& ref, const std::string& idx_name) {
+  for (const auto& aff : ref.access) {
+    if (aff[idx_name]) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool IsChained(const std::string& agg_op) { return !agg_op.empty() && agg_op != "assign"; }
+
+// How one candidate index splits a leaf block's statements.
+struct JamShape {
+  // Loads from refinements which don't depend on the index, and which the block doesn't write: jammed copies share
+  // these.
+  std::set<std::string> shared;
+  std::size_t shared_loads = 0;
+  std::size_t copied_stmts = 0;
+  std::size_t copied_live = 0;  // Loads and chained stores which each copy keeps live.
+  std::vector<const Refinement*> chained;
+};
+
+std::optional<JamShape> ShapeJam(const Block& block, const Index& idx) {
+  if (idx.range < 2 || idx.affine != Affine{}) {
+    return std::nullopt;
+  }
+  for (const auto& constraint : block.constraints) {
+    if (constraint[idx.name]) {
+      return std::nullopt;
+    }
+  }
+  std::set<std::string> loaded;
+  std::set<std::string> stored;
+  for (const auto& stmt : block.stmts) {
+    switch (stmt->kind()) {
+      case StmtKind::Load:
+        loaded.insert(Load::Downcast(stmt)->from);
+        break;
+      case StmtKind::Store:
+        stored.insert(Store::Downcast(stmt)->into);
+        break;
+      case StmtKind::Constant:
+      case StmtKind::LoadIndex:
+      case StmtKind::Intrinsic:
+        break;
+      default:
+        return std::nullopt;
+    }
+  }
+  JamShape shape;
+  for (const auto& ref : block.refs) {
+    if (!DependsOn(ref, idx.name)) {
+      continue;
+    }
+    if (ref.cache_unit || ref.bank_dim) {
+      return std::nullopt;
+    }
+  }
+  // Jamming reorders the copies' accesses, so they mustn't communicate through memory.
+  for (const auto& name : loaded) {
+    if (stored.count(name)) {
+      return std::nullopt;
+    }
+  }
+  // Consecutive iterations of the flattened loop step its first nontrivial index.
+  const Index* innermost = nullptr;
+  for (const auto& other : block.idxs) {
+    if (other.range > 1) {
+      innermost = &other;
+      break;
+    }
+  }
+  for (const auto& stmt : block.stmts) {
+    auto load = Load::Downcast(stmt);
+    if (load && !DependsOn(*block.ref_by_into(load->from), idx.name)) {
+      shape.shared.insert(load->into);
+      shape.shared_loads++;
+      continue;
+    }
+    shape.copied_stmts++;
+    if (load) {
+      shape.copied_live++;
+    }
+    auto store = Store::Downcast(stmt);
+    if (store) {
+      const auto& ref = *block.ref_by_into(store->into);
+      if (IsChained(ref.agg_op) && !(innermost && DependsOn(ref, innermost->name))) {
+        shape.chained.push_back(&ref);
+        if (DependsOn(ref, idx.name)) {
+          shape.copied_live++;
+        }
+      }
+    }
+  }
+  return shape;
+}
+
+// Estimates the cycles per original iteration of a block jammed by factor.
+double EstimateCycles(const Block& block, const Index& idx, const JamShape& shape, std::size_t factor) {
+  double overhead = kIndexOverhead * block.idxs.size() + kBranchOverhead;
+  double throughput = (shape.shared_loads + factor * shape.copied_stmts + overhead) / factor / kIssueWidth;
+  double latency = 0;
+  for (const auto* ref : shape.chained) {
+    // Copies aggregating into distinct elements form independent chains; copies aggregating into one element chain.
+    latency = std::max(latency, DependsOn(*ref, idx.name) ? kAggLatency / factor : kAggLatency);
+  }
+  return std::max(throughput, latency);
+}
+
+struct JamPlan {
+  const Index* idx = nullptr;
+  std::size_t factor = 1;
+  double cycles = 0;
+  std::size_t stmts = 0;
+};
+
+// Picks the index and factor which minimize the estimated cycles within the register and statement budgets.
+JamPlan PlanJam(const Block& block, const proto::UnrollPass& options, std::size_t max_stmts) {
+  JamPlan best;
+  best.stmts = block.stmts.size();
+  for (const auto& idx : block.idxs) {
+    auto shape = ShapeJam(block, idx);
+    if (!shape) {
+      continue;
+    }
+    if (!best.idx) {
+      best.cycles = EstimateCycles(block, idx, *shape, 1);
+    }
+    for (std::size_t factor = 2; factor <= options.max_factor() && factor <= idx.range; factor++) {
+      if (idx.range % factor) {
+        continue;
+      }
+      auto stmts = shape->shared_loads + factor * shape->copied_stmts;
+      auto live = shape->shared_loads + factor * shape->copied_live;
+      if (stmts > max_stmts || live > options.num_registers()) {
+        continue;
+      }
+      auto cycles = EstimateCycles(block, idx, *shape, factor);
+      if (cycles < best.cycles) {
+        best = JamPlan{&idx, factor, cycles, stmts};
+      }
+    }
+  }
+  return best;
+}
+
+// Unrolls idx_name by factor, emitting each statement's copies together.
+void Jam(Block* block, const std::string& idx_name, std::size_t factor) {
+  auto idx = block->idx_by_name(idx_name);
+  auto shape = *ShapeJam(*block, *idx);
+  idx->range /= factor;
+
+  std::map<std::string, std::vector<std::string>> ref_copies;
+  std::set<Refinement> refs;
+  for (const auto& ref : block->refs) {
+    if (!DependsOn(ref, idx_name)) {
+      refs.insert(ref);
+      continue;
+    }
+    for (std::size_t copy = 0; copy < factor; copy++) {
+      auto jammed = ref.WithInto(block->unique_ref_name(ref.into() + "_" + idx_name + std::to_string(copy)));
+      for (auto& aff : jammed.access) {
+        aff.substitute(idx_name, Affine(idx_name, factor) + copy);
+      }
+      ref_copies[ref.into()].push_back(jammed.into());
+      refs.emplace(std::move(jammed));
+    }
+  }
+
+  auto jam_ref = [&](const std::string& name, std::size_t copy) {
+    auto it = ref_copies.find(name);
+    return it == ref_copies.end() ? name : it->second[copy];
+  };
+  auto jam_scalar = [&](const std::string& name, std::size_t copy) {
+    return shape.shared.count(name) ? name : name + "_" + idx_name + std::to_string(copy);
+  };
+
+  StatementList stmts;
+  for (const auto& stmt : block->stmts) {
+    switch (stmt->kind()) {
+      case StmtKind::Load: {
+        auto load = Load::Downcast(stmt);
+        for (std::size_t copy = 0; copy < (shape.shared.count(load->into) ? 1 : factor); copy++) {
+          auto jammed = std::make_shared<Load>(*load);
+          jammed->from = jam_ref(load->from, copy);
+          jammed->into = jam_scalar(load->into, copy);
+          stmts.push_back(jammed);
+        }
+      } break;
+      case StmtKind::Store: {
+        auto store = Store::Downcast(stmt);
+        for (std::size_t copy = 0; copy < factor; copy++) {
+          auto jammed = std::make_shared<Store>(*store);
+          jammed->from = jam_scalar(store->from, copy);
+          jammed->into = jam_ref(store->into, copy);
+          stmts.push_back(jammed);
+        }
+      } break;
+      case StmtKind::Constant:
+        for (std::size_t copy = 0; copy < factor; copy++) {
+          auto constant = std::make_shared<Constant>(*Constant::Downcast(stmt));
+          constant->name = jam_scalar(constant->name, copy);
+          stmts.push_back(constant);
+        }
+        break;
+      case StmtKind::LoadIndex:
+        for (std::size_t copy = 0; copy < factor; copy++) {
+          auto load_index = std::make_shared<LoadIndex>(*LoadIndex::Downcast(stmt));
+          load_index->from.substitute(idx_name, Affine(idx_name, factor) + copy);
+          load_index->into = jam_scalar(load_index->into, copy);
+          stmts.push_back(load_index);
+        }
+        break;
+      case StmtKind::Intrinsic:
+        for (std::size_t copy = 0; copy < factor; copy++) {
+          auto intrinsic = std::make_shared<Intrinsic>(*Intrinsic::Downcast(stmt));
+          for (auto& input : intrinsic->inputs) {
+            input = jam_scalar(input, copy);
+          }
+          for (auto& output : intrinsic->outputs) {
+            output = jam_scalar(output, copy);
+          }
+          stmts.push_back(intrinsic);
+        }
+        break;
+      default:
+        throw_with_trace(std::logic_error{"Unexpected statement in jammed block: " + block->name});
+    }
+  }
+  for (auto& stmt : stmts) {
+    stmt->deps.clear();
+  }
+  block->refs = std::move(refs);
+  block->stmts = std::move(stmts);
+}
+
+void CollectLeaves(Block* block, std::vector<Block*>* leaves) {
+  bool leaf = true;
+  for (const auto& stmt : block->stmts) {
+    auto inner = Block::Downcast(stmt);
+    if (inner) {
+      leaf = false;
+      CollectLeaves(inner.get(), leaves);
+    }
+  }
+  if (leaf) {
+    leaves->push_back(block);
+  }
+}
+
+// Jams the leaf blocks of a kernel, keeping their total statements within max_stmts.
+void JamKernel(Block* kernel, const proto::UnrollPass& options) {
+  std::vector<Block*> leaves;
+  CollectLeaves(kernel, &leaves);
+  std::size_t total = 0;
+  for (const auto* leaf : leaves) {
+    total += leaf->stmts.size();
+  }
+  for (auto* leaf : leaves) {
+    auto current = leaf->stmts.size();
+    if (total > options.max_stmts()) {
+      break;
+    }
+    auto plan = PlanJam(*leaf, options, options.max_stmts() - total + current);
+    if (!plan.idx) {
+      continue;
+    }
+    IVLOG(2, "UnrollPass> jam " << leaf->name << " by " << plan.factor << " on " << plan.idx->name
+                                << ", est. cycles/iter: " << plan.cycles);
+    Jam(leaf, plan.idx->name, plan.factor);
+    total += leaf->stmts.size() - current;
+  }
+}
+
 }  // namespace
 
 void UnrollPass::Apply(CompilerState* state) const {
   auto reqs = FromProto(options_.reqs());
+  if (options_.unroll_jam()) {
+    RunOnBlocks(state->entry(), reqs, [&](const AliasMap& map, Block* block) { JamKernel(block, options_); });
+    return;
+  }
   Block* root = state->entry();
   AliasMap base_alias_map;
   AliasMap alias_map{base_alias_map, root};
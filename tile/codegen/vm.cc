@@ -3,6 +3,15 @@
 #include "tile/codegen/vm.h"
 
 #include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <set>
+#include <thread>
+#include <utility>
 
 #include <boost/format.hpp>
 
@@ -29,10 +38,18 @@ std::map<std::string, std::function<float(float, float, float)>> TERNARY_OPS = {
     {"cond", [](float c, float t, float f) { return c ? t : f; }},
 };
 
+struct BlockTiming {
+  int64_t executions = 0;
+  std::chrono::steady_clock::duration elapsed{};
+};
+
+using Profile = std::map<const Block*, BlockTiming>;
+
 class Scope {
  public:
   Scope() {}
-  explicit Scope(Scope* outer) : outer_(outer), depth_(outer->depth_ + 1) {}
+  explicit Scope(Scope* outer) : outer_(outer), depth_(outer->depth_ + 1), profile_(outer->profile_) {}
+  explicit Scope(Profile* profile) : profile_(profile) {}
 
   void ExecuteProgram(const Block& block, std::map<std::string, Buffer>* buffers) {
     Scope outer;
@@ -208,8 +225,15 @@ class Scope {
           }
         } break;
         case StmtKind::Block: {
+          const auto& inner = *Block::Downcast(stmt);
+          auto start = std::chrono::steady_clock::now();
           Scope scope(this);
-          scope.ExecuteBlock(*Block::Downcast(stmt));
+          scope.ExecuteBlock(inner);
+          if (profile_) {
+            auto& timing = (*profile_)[&inner];
+            timing.executions++;
+            timing.elapsed += std::chrono::steady_clock::now() - start;
+          }
         } break;
         default:
           break;
@@ -222,18 +246,626 @@ class Scope {
  private:
   Scope* outer_ = nullptr;
   size_t depth_ = 0;
+  Profile* profile_ = nullptr;
   std::map<std::string, int64_t> idxs_;
   std::map<std::string, Buffer*> refs_;
   std::map<std::string, size_t> offsets_;
 };
 
+// The compiled VM.
+
+// An affine function of a block's indices, by index slot.
+struct FlatAffine {
+  int64_t constant = 0;
+  std::vector<std::pair<size_t, int64_t>> terms;  // (slot, coefficient)
+
+  int64_t Eval(const int64_t* idxs) const {
+    int64_t result = constant;
+    for (const auto& term : terms) {
+      result += idxs[term.first] * term.second;
+    }
+    return result;
+  }
+
+  int64_t Coefficient(size_t slot) const {
+    int64_t result = 0;
+    for (const auto& term : terms) {
+      if (term.first == slot) {
+        result += term.second;
+      }
+    }
+    return result;
+  }
+
+  void Add(const FlatAffine& other, int64_t scale) {
+    constant += other.constant * scale;
+    for (const auto& term : other.terms) {
+      terms.emplace_back(term.first, term.second * scale);
+    }
+  }
+};
+
+FlatAffine Flatten(const Affine& affine, const std::map<std::string, size_t>& slots) {
+  FlatAffine result;
+  for (const auto& kvp : affine.getMap()) {
+    if (kvp.first.empty()) {
+      result.constant += kvp.second;
+      continue;
+    }
+    auto it = slots.find(kvp.first);
+    if (it == slots.end()) {
+      throw_with_trace(std::runtime_error(
+          str(boost::format("Failed to find value for %s, when evaluating %s") % kvp.first % affine.toString())));
+    }
+    result.terms.emplace_back(it->second, kvp.second);
+  }
+  return result;
+}
+
+enum class OpCode {
+  LOAD,
+  STORE,
+  STORE_SUM,
+  LOAD_INDEX,
+  CONSTANT,
+  ADD,
+  SUB,
+  MUL,
+  DIV,
+  MIN,
+  MAX,
+  CMP_LT,
+  CMP_LE,
+  CMP_GT,
+  CMP_GE,
+  CMP_EQ,
+  CMP_NE,
+  COND,
+  NEG,
+  IDENT,
+  EXP,
+  LOG,
+  SQRT,
+  TANH,
+  BLOCK,
+};
+
+const std::map<std::string, OpCode> UNARY_OPCODES = {
+    {"neg", OpCode::NEG},  {"ident", OpCode::IDENT}, {"assign", OpCode::IDENT}, {"exp", OpCode::EXP},
+    {"log", OpCode::LOG},  {"sqrt", OpCode::SQRT},   {"tanh", OpCode::TANH},
+};
+
+const std::map<std::string, OpCode> BINARY_OPCODES = {
+    {"add", OpCode::ADD},       {"sub", OpCode::SUB},       {"mul", OpCode::MUL},       {"div", OpCode::DIV},
+    {"min", OpCode::MIN},       {"max", OpCode::MAX},       {"cmp_lt", OpCode::CMP_LT}, {"cmp_le", OpCode::CMP_LE},
+    {"cmp_gt", OpCode::CMP_GT}, {"cmp_ge", OpCode::CMP_GE}, {"cmp_eq", OpCode::CMP_EQ}, {"cmp_ne", OpCode::CMP_NE},
+};
+
+struct Instr {
+  OpCode op;
+  size_t dst = 0;  // The output register
+  size_t a = 0;    // An input register, or for loads and stores, the ref slot
+  size_t b = 0;
+  size_t c = 0;
+  size_t aux = 0;  // For LOAD_INDEX, the affine; for BLOCK, the child; for STORE, the input register
+  float value = 0;
+};
+
+// Blocks whose loops do fewer instructions than this run on the calling thread.
+constexpr uint64_t kMinParallelWork = 1 << 16;
+
+struct CompiledBlock {
+  struct Ref {
+    std::string name;
+    bool user = false;   // A program buffer (top level only)
+    bool local = false;  // Allocated afresh (zeroed) each time the block runs
+    size_t from = 0;     // The parent's ref slot, if neither user nor local
+    size_t elem_size = 0;
+    FlatAffine offset;  // Relative to the parent ref's offset
+    int64_t step = 0;   // The offset's coefficient for the innermost index
+  };
+
+  std::string name;
+  std::vector<uint64_t> ranges;
+  std::vector<FlatAffine> idx_bases;  // Over the parent's index slots
+  std::vector<FlatAffine> constraints;
+  std::vector<int64_t> constraint_steps;
+  std::vector<Ref> refs;
+  std::vector<FlatAffine> load_indexes;
+  size_t num_regs = 0;
+  size_t num_locals = 0;
+  std::vector<Instr> code;
+  std::vector<std::unique_ptr<CompiledBlock>> children;
+  std::set<size_t> written;  // The ref slots written by the block or its children
+  uint64_t work = 0;         // Roughly, the instructions one run of the block executes
+  bool parallel = false;     // Whether to split the outermost loop across threads
+};
+
+// Returns whether distinct values of the block's outermost index address disjoint parts of the refinement.
+bool DisjointAlongOuterIndex(const Block& block, const Refinement& ref) {
+  const auto& idx_name = block.idxs[0].name;
+  for (size_t i = 0; i < ref.access.size() && i < ref.interior_shape.dims.size(); i++) {
+    const auto& terms = ref.access[i].getMap();
+    auto it = terms.find(idx_name);
+    if (it == terms.end() || terms.size() - terms.count("") != 1) {
+      continue;
+    }
+    if (static_cast<uint64_t>(std::abs(it->second)) >= ref.interior_shape.dims[i].size) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::unique_ptr<CompiledBlock> Compile(const Block& block, const CompiledBlock* parent,
+                                       const std::map<std::string, size_t>& parent_idxs, bool inside_parallel) {
+  auto result = std::make_unique<CompiledBlock>();
+  auto& cb = *result;
+  cb.name = block.name;
+
+  std::map<std::string, size_t> idxs;
+  for (const auto& idx : block.idxs) {
+    cb.ranges.push_back(idx.range);
+    cb.idx_bases.push_back(Flatten(idx.affine, parent_idxs));
+    idxs.emplace(idx.name, idxs.size());
+  }
+  size_t innermost = block.idxs.size() - 1;  // Unused when the block has no indices
+  for (const auto& constraint : block.constraints) {
+    cb.constraints.push_back(Flatten(constraint, idxs));
+    cb.constraint_steps.push_back(block.idxs.empty() ? 0 : cb.constraints.back().Coefficient(innermost));
+  }
+
+  std::map<std::string, size_t> refs;
+  std::map<std::string, size_t> parent_refs;
+  if (parent) {
+    for (size_t i = 0; i < parent->refs.size(); i++) {
+      parent_refs.emplace(parent->refs[i].name, i);
+    }
+  }
+  for (const auto& ref : block.refs) {
+    CompiledBlock::Ref cref;
+    cref.name = ref.into();
+    if (!parent) {
+      cref.user = ref.has_tag("user");
+      cref.local = !cref.user;
+    } else if (ref.from.empty()) {
+      cref.local = true;
+    } else {
+      cref.from = safe_at(parent_refs, ref.from);
+    }
+    if (cref.local) {
+      cb.num_locals++;
+    }
+    cref.elem_size = ref.interior_shape.elem_size();
+    if (ref.interior_shape.dims.size() != ref.access.size()) {
+      throw_with_trace(std::runtime_error(
+          str(boost::format("Refinement '%s' of block '%s' has %zu access dimensions but a shape with %zu") %
+              ref.into() % block.name % ref.access.size() % ref.interior_shape.dims.size())));
+    }
+    for (size_t i = 0; i < ref.access.size(); i++) {
+      cref.offset.Add(Flatten(ref.access[i], idxs), ref.interior_shape.dims[i].stride);
+    }
+    cref.step = block.idxs.empty() ? 0 : cref.offset.Coefficient(innermost);
+    refs.emplace(cref.name, cb.refs.size());
+    cb.refs.emplace_back(std::move(cref));
+  }
+  auto ref_slot = [&](const std::string& name) {
+    auto it = refs.find(name);
+    if (it == refs.end()) {
+      throw_with_trace(std::runtime_error("Unknown buffer"));
+    }
+    return it->second;
+  };
+
+  std::map<std::string, size_t> regs;
+  auto reg = [&](const std::string& name) { return regs.emplace(name, regs.size()).first->second; };
+
+  bool parallel = !inside_parallel && !block.idxs.empty() && block.idxs[0].range >= 2 && !cb.num_locals;
+  uint64_t child_work = 0;
+  for (const auto& stmt : block.stmts) {
+    Instr instr;
+    switch (stmt->kind()) {
+      case StmtKind::Load: {
+        const auto& op = Load::Downcast(stmt);
+        instr.op = OpCode::LOAD;
+        instr.a = ref_slot(op->from);
+        instr.dst = reg(op->into);
+      } break;
+      case StmtKind::Store: {
+        const auto& op = Store::Downcast(stmt);
+        auto it = block.ref_by_into(op->into, false);
+        if (it == block.refs.end()) {
+          throw_with_trace(std::runtime_error("Missing agg_op"));
+        }
+        instr.op = it->agg_op == Intrinsic::SUM ? OpCode::STORE_SUM : OpCode::STORE;
+        instr.a = ref_slot(op->into);
+        instr.aux = reg(op->from);
+        cb.written.insert(instr.a);
+      } break;
+      case StmtKind::LoadIndex: {
+        const auto& op = LoadIndex::Downcast(stmt);
+        instr.op = OpCode::LOAD_INDEX;
+        instr.aux = cb.load_indexes.size();
+        cb.load_indexes.push_back(Flatten(op->from, idxs));
+        instr.dst = reg(op->into);
+      } break;
+      case StmtKind::Intrinsic: {
+        const auto& op = Intrinsic::Downcast(stmt);
+        const std::map<std::string, OpCode>* opcodes = nullptr;
+        switch (op->inputs.size()) {
+          case 1:
+            opcodes = &UNARY_OPCODES;
+            break;
+          case 2:
+            opcodes = &BINARY_OPCODES;
+            break;
+          case 3:
+            if (op->name != Intrinsic::COND) {
+              throw_with_trace(std::runtime_error(str(boost::format("Unsupported ternary intrinsic: %s") % op->name)));
+            }
+            instr.op = OpCode::COND;
+            break;
+          default:
+            throw_with_trace(
+                std::runtime_error(str(boost::format("Unsupported number of operands for intrinsic: %s") % op->name)));
+        }
+        if (opcodes) {
+          auto it = opcodes->find(op->name);
+          if (it == opcodes->end()) {
+            throw_with_trace(std::runtime_error(str(boost::format("Unsupported %s intrinsic: %s") %
+                                                    (op->inputs.size() == 1 ? "unary" : "binary") % op->name)));
+          }
+          instr.op = it->second;
+        }
+        instr.a = reg(op->inputs[0]);
+        instr.b = op->inputs.size() > 1 ? reg(op->inputs[1]) : 0;
+        instr.c = op->inputs.size() > 2 ? reg(op->inputs[2]) : 0;
+        instr.dst = reg(op->outputs[0]);
+      } break;
+      case StmtKind::Constant: {
+        const auto& op = Constant::Downcast(stmt);
+        instr.op = OpCode::CONSTANT;
+        instr.value = op->type == ConstType::Integer ? static_cast<float>(op->iconst) : static_cast<float>(op->fconst);
+        instr.dst = reg(op->name);
+      } break;
+      case StmtKind::Block: {
+        const auto& inner = *Block::Downcast(stmt);
+        instr.op = OpCode::BLOCK;
+        instr.aux = cb.children.size();
+        cb.children.emplace_back(Compile(inner, &cb, idxs, inside_parallel));
+        const auto& child = *cb.children.back();
+        for (auto slot : child.written) {
+          if (!child.refs[slot].local) {
+            cb.written.insert(child.refs[slot].from);
+          }
+        }
+        child_work += child.work;
+      } break;
+      default:
+        continue;
+    }
+    cb.code.push_back(instr);
+  }
+  cb.num_regs = regs.size();
+
+  uint64_t iterations = 1;
+  for (auto range : cb.ranges) {
+    iterations *= range;
+  }
+  cb.work = iterations * (cb.code.size() + child_work);
+
+  if (parallel && cb.work >= kMinParallelWork) {
+    // Each written refinement must be split by the outer index, and be the block's only view of its buffer, so that no
+    // iteration reads what another writes.
+    for (const auto& ref : block.refs) {
+      if (!cb.written.count(refs.at(ref.into()))) {
+        continue;
+      }
+      bool shared = false;
+      for (const auto& other : block.refs) {
+        shared |= &other != &ref && other.from == ref.from;
+      }
+      if (shared || !DisjointAlongOuterIndex(block, ref)) {
+        parallel = false;
+        break;
+      }
+    }
+    if (parallel) {
+      // The children were compiled before this was known, and may have marked themselves parallel; only the outermost
+      // parallel block on each path splits its loop.
+      std::function<void(CompiledBlock*)> clear = [&](CompiledBlock* b) {
+        for (auto& child : b->children) {
+          child->parallel = false;
+          clear(child.get());
+        }
+      };
+      clear(&cb);
+      cb.parallel = true;
+    }
+  }
+  return result;
+}
+
+struct RefState {
+  float* data = nullptr;
+  size_t size = 0;
+  int64_t base = 0;    // The parent ref's offset when the block started
+  int64_t offset = 0;  // The offset for the current iteration
+};
+
+struct Frame {
+  std::vector<int64_t> idxs;
+  std::vector<int64_t> constraints;
+  std::vector<float> regs;
+  std::vector<RefState> refs;
+  std::vector<Buffer> locals;
+};
+
+class Machine {
+ public:
+  void RunProgram(const CompiledBlock& cb, std::map<std::string, Buffer>* buffers) {
+    Frame frame;
+    frame.locals.reserve(cb.num_locals);
+    for (const auto& ref : cb.refs) {
+      RefState state;
+      if (ref.user) {
+        auto& buf = safe_at(buffers, ref.name);
+        state.data = buf.data();
+        state.size = buf.size();
+      } else {
+        frame.locals.emplace_back(ref.elem_size);
+        state.data = frame.locals.back().data();
+        state.size = ref.elem_size;
+      }
+      frame.refs.push_back(state);
+    }
+    Run(cb, &frame, {});
+  }
+
+ private:
+  void Enter(const CompiledBlock& cb, const Frame& parent) {
+    Frame frame;
+    frame.locals.reserve(cb.num_locals);
+    for (const auto& ref : cb.refs) {
+      RefState state;
+      if (ref.local) {
+        frame.locals.emplace_back(ref.elem_size);
+        state.data = frame.locals.back().data();
+        state.size = ref.elem_size;
+      } else {
+        const auto& from = parent.refs[ref.from];
+        state.data = from.data;
+        state.size = from.size;
+        state.base = from.offset;
+      }
+      frame.refs.push_back(state);
+    }
+    Run(cb, &frame, parent.idxs);
+  }
+
+  void Run(const CompiledBlock& cb, Frame* frame, const std::vector<int64_t>& parent_idxs) {
+    frame->idxs.resize(cb.ranges.size());
+    frame->constraints.resize(cb.constraints.size());
+    frame->regs.assign(cb.num_regs, 0);
+    if (cb.ranges.empty()) {
+      for (auto& ref : frame->refs) {
+        ref.offset = ref.base;
+      }
+      for (size_t i = 0; i < cb.refs.size(); i++) {
+        frame->refs[i].offset += cb.refs[i].offset.constant;
+      }
+      for (const auto& constraint : cb.constraints) {
+        if (constraint.constant < 0) {
+          return;
+        }
+      }
+      Execute(cb, frame);
+      return;
+    }
+    std::vector<int64_t> bases(cb.ranges.size());
+    for (size_t i = 0; i < bases.size(); i++) {
+      bases[i] = cb.idx_bases[i].Eval(parent_idxs.data());
+    }
+    if (!cb.parallel) {
+      Loop(cb, frame, bases, 0, 0, cb.ranges[0]);
+      return;
+    }
+    size_t threads = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), cb.ranges[0]);
+    std::vector<std::thread> workers;
+    std::vector<std::exception_ptr> errors(threads);
+    for (size_t t = 0; t < threads; t++) {
+      uint64_t begin = cb.ranges[0] * t / threads;
+      uint64_t end = cb.ranges[0] * (t + 1) / threads;
+      workers.emplace_back([&, t, begin, end] {
+        try {
+          Frame local = *frame;
+          Loop(cb, &local, bases, 0, begin, end);
+        } catch (...) {
+          errors[t] = std::current_exception();
+        }
+      });
+    }
+    for (auto& worker : workers) {
+      worker.join();
+    }
+    for (const auto& error : errors) {
+      if (error) {
+        std::rethrow_exception(error);
+      }
+    }
+  }
+
+  void Loop(const CompiledBlock& cb, Frame* frame, const std::vector<int64_t>& bases, size_t depth, uint64_t begin,
+            uint64_t end) {
+    auto& idxs = frame->idxs;
+    if (depth + 1 < cb.ranges.size()) {
+      for (uint64_t i = begin; i < end; i++) {
+        idxs[depth] = bases[depth] + i;
+        Loop(cb, frame, bases, depth + 1, 0, cb.ranges[depth + 1]);
+      }
+      return;
+    }
+    // The innermost loop: evaluate the offsets and constraints once, then step them.
+    idxs[depth] = bases[depth] + begin;
+    for (size_t i = 0; i < cb.refs.size(); i++) {
+      frame->refs[i].offset = frame->refs[i].base + cb.refs[i].offset.Eval(idxs.data());
+    }
+    for (size_t i = 0; i < cb.constraints.size(); i++) {
+      frame->constraints[i] = cb.constraints[i].Eval(idxs.data());
+    }
+    for (uint64_t i = begin; i < end; i++) {
+      bool in_bounds = true;
+      for (auto value : frame->constraints) {
+        if (value < 0) {
+          in_bounds = false;
+          break;
+        }
+      }
+      if (in_bounds) {
+        Execute(cb, frame);
+      }
+      idxs[depth]++;
+      for (size_t r = 0; r < cb.refs.size(); r++) {
+        frame->refs[r].offset += cb.refs[r].step;
+      }
+      for (size_t c = 0; c < cb.constraints.size(); c++) {
+        frame->constraints[c] += cb.constraint_steps[c];
+      }
+    }
+  }
+
+  static size_t CheckedOffset(const char* what, const CompiledBlock& cb, const Frame& frame, size_t slot) {
+    const auto& ref = frame.refs[slot];
+    if (ref.offset < 0 || static_cast<uint64_t>(ref.offset) >= ref.size) {
+      throw_with_trace(
+          std::runtime_error(str(boost::format("%s: Out of bounds access on '%s', offset: %zu, size: %zu") %  //
+                                 what % cb.refs[slot].name % static_cast<size_t>(ref.offset) % ref.size)));
+    }
+    return ref.offset;
+  }
+
+  void Execute(const CompiledBlock& cb, Frame* frame) {
+    auto& r = frame->regs;
+    for (const auto& instr : cb.code) {
+      switch (instr.op) {
+        case OpCode::LOAD:
+          r[instr.dst] = frame->refs[instr.a].data[CheckedOffset("LOAD", cb, *frame, instr.a)];
+          break;
+        case OpCode::STORE:
+          frame->refs[instr.a].data[CheckedOffset("STORE", cb, *frame, instr.a)] = r[instr.aux];
+          break;
+        case OpCode::STORE_SUM:
+          frame->refs[instr.a].data[CheckedOffset("STORE", cb, *frame, instr.a)] += r[instr.aux];
+          break;
+        case OpCode::LOAD_INDEX:
+          r[instr.dst] = cb.load_indexes[instr.aux].Eval(frame->idxs.data());
+          break;
+        case OpCode::CONSTANT:
+          r[instr.dst] = instr.value;
+          break;
+        case OpCode::ADD:
+          r[instr.dst] = r[instr.a] + r[instr.b];
+          break;
+        case OpCode::SUB:
+          r[instr.dst] = r[instr.a] - r[instr.b];
+          break;
+        case OpCode::MUL:
+          r[instr.dst] = r[instr.a] * r[instr.b];
+          break;
+        case OpCode::DIV:
+          r[instr.dst] = r[instr.a] / r[instr.b];
+          break;
+        case OpCode::MIN:
+          r[instr.dst] = std::min(r[instr.a], r[instr.b]);
+          break;
+        case OpCode::MAX:
+          r[instr.dst] = std::max(r[instr.a], r[instr.b]);
+          break;
+        case OpCode::CMP_LT:
+          r[instr.dst] = r[instr.a] < r[instr.b];
+          break;
+        case OpCode::CMP_LE:
+          r[instr.dst] = r[instr.a] <= r[instr.b];
+          break;
+        case OpCode::CMP_GT:
+          r[instr.dst] = r[instr.a] > r[instr.b];
+          break;
+        case OpCode::CMP_GE:
+          r[instr.dst] = r[instr.a] >= r[instr.b];
+          break;
+        case OpCode::CMP_EQ:
+          r[instr.dst] = r[instr.a] == r[instr.b];
+          break;
+        case OpCode::CMP_NE:
+          r[instr.dst] = r[instr.a] != r[instr.b];
+          break;
+        case OpCode::COND:
+          r[instr.dst] = r[instr.a] ? r[instr.b] : r[instr.c];
+          break;
+        case OpCode::NEG:
+          r[instr.dst] = -r[instr.a];
+          break;
+        case OpCode::IDENT:
+          r[instr.dst] = r[instr.a];
+          break;
+        case OpCode::EXP:
+          r[instr.dst] = std::exp(r[instr.a]);
+          break;
+        case OpCode::LOG:
+          r[instr.dst] = std::log(r[instr.a]);
+          break;
+        case OpCode::SQRT:
+          r[instr.dst] = std::sqrt(r[instr.a]);
+          break;
+        case OpCode::TANH:
+          r[instr.dst] = std::tanh(r[instr.a]);
+          break;
+        case OpCode::BLOCK:
+          Enter(*cb.children[instr.aux], *frame);
+          break;
+      }
+    }
+  }
+};
+
+void ApplyProfile(Block* block, const Profile& profile) {
+  auto it = profile.find(block);
+  if (it != profile.end()) {
+    auto wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(it->second.elapsed).count();
+    block->set_attr("execution_count", it->second.executions);
+    block->set_attr("wall_ns", static_cast<int64_t>(wall_ns));
+  }
+  for (const auto& stmt : block->stmts) {
+    if (auto inner = Block::Downcast(stmt)) {
+      ApplyProfile(inner.get(), profile);
+    }
+  }
+}
+
 }  // namespace
 
 void ExecuteProgram(const Block& program, std::map<std::string, Buffer>* buffers) {
+  auto compiled = Compile(program, nullptr, {}, false);
+  Machine machine;
+  machine.RunProgram(*compiled, buffers);
+}
+
+void ExecuteProgramReference(const Block& program, std::map<std::string, Buffer>* buffers) {
   Scope scope;
   scope.ExecuteProgram(program, buffers);
 }
 
+void ProfileProgram(Block* program, std::map<std::string, Buffer>* buffers) {
+  Profile profile;
+  auto start = std::chrono::steady_clock::now();
+  Scope scope(&profile);
+  scope.ExecuteProgram(*program, buffers);
+  auto& timing = profile[program];
+  timing.executions++;
+  timing.elapsed += std::chrono::steady_clock::now() - start;
+  ApplyProfile(program, profile);
+}
+
 }  // namespace codegen
 }  // namespace tile
 }  // namespace vertexai
@@ -14,8 +14,21 @@ namespace codegen {
 
 using Buffer = std::vector<float>;
 
+// Executes the program on the host.  The program is first compiled to a flat form: indices, refinements, and
+// scalars are resolved to slots, each refinement's access to one affine offset (updated incrementally across the
+// innermost loop of its block), and statements to bytecode.  The outer loop of each large block whose iterations write
+// disjoint data is split across threads.
 void ExecuteProgram(const stripe::Block& program, std::map<std::string, Buffer>* buffers);
 
+// Executes the program by walking its blocks directly, as the reference for ExecuteProgram.  This is much slower.
+void ExecuteProgramReference(const stripe::Block& program, std::map<std::string, Buffer>* buffers);
+
+// Executes the program while timing every block, then annotates each block
+// which ran with execution_count and wall_ns (inclusive of nested blocks),
+// the attributes the CPU JIT's profile_block_execution mode writes.  See
+// targets::cpu::AggregateBlockProfiles to total them by block name.
+void ProfileProgram(stripe::Block* program, std::map<std::string, Buffer>* buffers);
+
 }  // namespace codegen
 }  // namespace tile
 }  // namespace vertexai
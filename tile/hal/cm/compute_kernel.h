@@ -34,8 +34,7 @@ class ComputeKernel final : public Kernel {
   std::mutex mu_;
   std::shared_ptr<DeviceState> device_state_;
   CmKernel* kernel_;
-  CmTask* pKernelArray_;
-  CmThreadGroupSpace* pts_;
+  CmThreadGroupSpace* pts_;  // Created on the first run, and associated with the kernel
   lang::KernelInfo ki_;
   context::proto::ActivityID kernel_id_;
   std::shared_ptr<Emit> cm_;
@@ -22,11 +22,53 @@ namespace tile {
 namespace hal {
 namespace cm {
 
+namespace {
+
+// The most kernels gathered into one task; submitting long programs in
+// several tasks lets the device start on them while the rest are gathered.
+constexpr std::size_t kMaxBatchKernels = 64;
+
+}  // namespace
+
+TaskBatch::~TaskBatch() {
+  if (event_) {
+    queue_->DestroyEvent(event_);
+  }
+}
+
+void TaskBatch::Enqueued(CmEvent* event) {
+  std::lock_guard<std::mutex> lock{mu_};
+  event_ = event;
+}
+
+CmEvent* TaskBatch::event() {
+  std::lock_guard<std::mutex> lock{mu_};
+  return event_;
+}
+
+boost::shared_future<void> TaskBatch::Finished() {
+  std::lock_guard<std::mutex> lock{mu_};
+  if (!finished_.valid()) {
+    if (!event_) {
+      throw error::Internal{"Waiting on a CM task which hasn't been enqueued"};
+    }
+    finished_ = boost::async(boost::launch::async, [event = event_] {
+                  cm_result_check(event->WaitForTaskFinished());
+                }).share();
+  }
+  return finished_;
+}
+
 DeviceState::DeviceState(const context::Context& ctx, proto::DeviceInfo dinfo)
     : info_{std::move(dinfo)}, clock_{}, id_{ctx.activity_id()} {}
 
 DeviceState::~DeviceState() {
-  RecoverEnv();
+  if (shell_env_) {
+    RecoverEnv();
+  }
+  if (batch_task_) {
+    pCmDev_->DestroyTask(batch_task_);
+  }
   if (pCmDev_) cm_result_check(::DestroyCmDevice(pCmDev_));
 }
 
@@ -51,6 +93,50 @@ void DeviceState::MakeQueue() {
 
 void DeviceState::FlushCommandQueue() { cm_result_check(pCmDev_->FlushPrintBuffer()); }
 
+std::shared_ptr<TaskBatch> DeviceState::AddToBatch(CmKernel* kernel, const std::function<void()>& prepare,
+                                                   bool isolate) {
+  std::lock_guard<std::mutex> lock{batch_mu_};
+  // A kernel's arguments are read when its task is enqueued, so a kernel
+  // already in the batch must be submitted before it's rebound.
+  if (isolate || batch_kernels_.count(kernel)) {
+    SubmitBatchLocked();
+  }
+  if (!batch_task_) {
+    cm_result_check(cmdev()->CreateTask(batch_task_));
+  }
+  if (!batch_) {
+    batch_ = std::make_shared<TaskBatch>(pCmQueue_);
+  } else {
+    // Later kernels may read what earlier ones write.
+    cm_result_check(batch_task_->AddSync());
+  }
+  prepare();
+  cm_result_check(batch_task_->AddKernel(kernel));
+  batch_kernels_.insert(kernel);
+  auto batch = batch_;
+  if (isolate || batch_kernels_.size() >= kMaxBatchKernels) {
+    SubmitBatchLocked();
+  }
+  return batch;
+}
+
+void DeviceState::SubmitBatch() {
+  std::lock_guard<std::mutex> lock{batch_mu_};
+  SubmitBatchLocked();
+}
+
+void DeviceState::SubmitBatchLocked() {
+  if (!batch_) {
+    return;
+  }
+  CmEvent* event = nullptr;
+  cm_result_check(pCmQueue_->Enqueue(batch_task_, event));
+  batch_->Enqueued(event);
+  cm_result_check(batch_task_->Reset());
+  batch_.reset();
+  batch_kernels_.clear();
+}
+
 void DeviceState::ConfigEnv() {
   shell_env_ = std::make_unique<ShellEnv>();
 
@@ -2,8 +2,13 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_set>
+
+#include <boost/thread/future.hpp>
 
 #include "base/context/context.h"
 #include "tile/hal/cm/cm.pb.h"
@@ -15,6 +20,28 @@ namespace tile {
 namespace hal {
 namespace cm {
 
+// Kernels submitted to the device together, as one enqueued task.
+class TaskBatch {
+ public:
+  explicit TaskBatch(CmQueue* queue) : queue_{queue} {}
+  ~TaskBatch();
+
+  // Records the task's event, once the task has been enqueued.
+  void Enqueued(CmEvent* event);
+
+  // The event of the enqueued task, or nullptr if it's still being gathered.
+  CmEvent* event();
+
+  // Completes once the task has finished running.  The task must have been enqueued.
+  boost::shared_future<void> Finished();
+
+ private:
+  CmQueue* queue_;
+  std::mutex mu_;
+  CmEvent* event_ = nullptr;
+  boost::shared_future<void> finished_;
+};
+
 class DeviceState {
  public:
   struct ShellEnv {
@@ -40,7 +67,18 @@ class DeviceState {
 
   void FlushCommandQueue();
 
+  // Adds the kernel to the task being gathered, calling prepare (which sets the
+  // kernel's arguments) once the kernel may be rebound.  Kernels run in the
+  // order they're added.  If isolate is set (e.g. to time the kernel), the
+  // kernel is enqueued as a task of its own.
+  std::shared_ptr<TaskBatch> AddToBatch(CmKernel* kernel, const std::function<void()>& prepare, bool isolate = false);
+
+  // Enqueues the task being gathered, if any.
+  void SubmitBatch();
+
  private:
+  void SubmitBatchLocked();
+
   void Initialize();
   void MakeDevice();
   void MakeQueue();
@@ -49,6 +87,10 @@ class DeviceState {
 
   CmDevice* pCmDev_ = nullptr;
   CmQueue* pCmQueue_;
+  std::mutex batch_mu_;
+  CmTask* batch_task_ = nullptr;                 // Reset and reused for each batch
+  std::shared_ptr<TaskBatch> batch_;             // The batch being gathered, if any
+  std::unordered_set<CmKernel*> batch_kernels_;  // The kernels in the batch being gathered
   std::unique_ptr<ShellEnv> shell_env_;
   const proto::DeviceInfo info_;
   const context::Clock clock_;
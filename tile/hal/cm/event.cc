@@ -34,29 +34,27 @@ std::vector<CmEvent*> Event::Downcast(const std::vector<std::shared_ptr<hal::Eve
 
 boost::future<std::vector<std::shared_ptr<hal::Result>>> Event::WaitFor(
     const std::vector<std::shared_ptr<hal::Event>>& events, std::shared_ptr<DeviceState> device_state) {
-  std::vector<CmEvent*> mdeps;
+  std::vector<boost::shared_future<std::shared_ptr<hal::Result>>> futures;
   std::vector<std::shared_ptr<Event>> hal_events;
   for (const auto& event : events) {
     std::shared_ptr<Event> evt = Downcast(event);
-    if (evt->cm_event_) {
-      mdeps.emplace_back(evt->cm_event_);
+    if (evt->cm_event_ || evt->batch_) {
+      futures.emplace_back(evt->GetFuture());
       hal_events.emplace_back(std::move(evt));
     }
   }
-  if (!mdeps.size()) {
+  if (!futures.size()) {
     std::vector<std::shared_ptr<hal::Result>> results;
     return boost::make_ready_future(std::move(results));
   }
-  CmEvent* e = nullptr;
-  const auto& queue = device_state->cmqueue();
-  context::Context ctx{};
-  Event event{ctx, device_state, e, queue};
-  auto future = event.GetFuture();
-  auto results = future.then([ hal_events = std::move(hal_events), device_state ](decltype(future) fut) {
+  auto all_futures = boost::when_all(futures.begin(), futures.end());
+  auto results = all_futures.then([hal_events = std::move(hal_events)](decltype(all_futures) fut) {
     std::vector<std::shared_ptr<hal::Result>> results;
     results.reserve(hal_events.size());
     try {
-      fut.get();
+      for (auto& event_fut : fut.get()) {
+        event_fut.get();
+      }
     } catch (...) {
       LOG(ERROR) << boost::current_exception();
     }
@@ -84,14 +82,44 @@ Event::Event(const context::Context& ctx, std::shared_ptr<DeviceState> device_st
   }
 }
 
+Event::Event(const context::Context& ctx, std::shared_ptr<DeviceState> device_state, std::shared_ptr<TaskBatch> batch,
+             const CmQueue* queue, const std::shared_ptr<hal::Result>& result)
+    : ctx_{ctx},
+      device_state_{std::move(device_state)},
+      batch_{std::move(batch)},
+      queue_{queue},
+      cm_event_{nullptr},
+      state_{std::make_shared<FutureState>()} {
+  state_->result = result;
+}
+
 Event::~Event() {
-  if (cm_event_ && !started_) {
+  if ((cm_event_ || batch_) && !started_) {
     state_->prom.set_value(std::shared_ptr<hal::Result>());
   }
 }
 
 boost::shared_future<std::shared_ptr<hal::Result>> Event::GetFuture() {
   std::lock_guard<std::mutex> lock{mu_};
+  if (batch_) {
+    if (!started_) {
+      fut_ = state_->prom.get_future().share();
+      if (!batch_->event()) {
+        device_state_->SubmitBatch();
+      }
+      auto finished = batch_->Finished();
+      finished.then([state = state_, batch = batch_](decltype(finished) fut) {
+        try {
+          fut.get();
+          state->prom.set_value(state->result);
+        } catch (...) {
+          state->prom.set_exception(boost::current_exception());
+        }
+      });
+      started_ = true;
+    }
+    return fut_;
+  }
   if (!cm_event_) {
     return boost::make_ready_future(state_->result);
   }
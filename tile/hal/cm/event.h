@@ -43,6 +43,11 @@ class Event final : public hal::Event {
   Event(const context::Context& ctx, std::shared_ptr<DeviceState> device_state, CmEvent* cm_event, const CmQueue* queue,
         const std::shared_ptr<hal::Result>& result);
 
+  // An event which completes once the batch of kernels finishes.  Waiting on
+  // the event submits the batch, if it's still being gathered.
+  Event(const context::Context& ctx, std::shared_ptr<DeviceState> device_state, std::shared_ptr<TaskBatch> batch,
+        const CmQueue* queue, const std::shared_ptr<hal::Result>& result);
+
   ~Event() final;
 
   boost::shared_future<std::shared_ptr<hal::Result>> GetFuture() final;
@@ -59,6 +64,8 @@ class Event final : public hal::Event {
   static void EventComplete(CmEvent* evt, int32_t status, void* data);
 
   context::Context ctx_;
+  std::shared_ptr<DeviceState> device_state_;
+  std::shared_ptr<TaskBatch> batch_;
   const CmQueue* queue_;
   std::mutex mu_;
   bool started_ = false;
@@ -129,7 +129,10 @@ boost::future<std::unique_ptr<hal::Executable>> Executor::Prepare(hal::Library*
   return boost::make_ready_future(std::unique_ptr<hal::Executable>(std::make_unique<Executable>(std::move(kernels))));
 }
 
-void Executor::Flush() { device_state_->FlushCommandQueue(); }
+void Executor::Flush() {
+  device_state_->SubmitBatch();
+  device_state_->FlushCommandQueue();
+}
 
 boost::future<std::vector<std::shared_ptr<hal::Result>>> Executor::WaitFor(
     const std::vector<std::shared_ptr<hal::Event>>& events) {
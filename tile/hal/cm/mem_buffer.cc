@@ -37,13 +37,18 @@ void CMMemBuffer::SetKernelArg(CmKernel* kernel, std::size_t index) {
 }
 
 boost::future<void*> CMMemBuffer::MapCurrent(const std::vector<std::shared_ptr<hal::Event>>& deps) {
-  ReleaseDeviceBuffer();
-  return boost::make_ready_future(base_);
+  // Kernels run asynchronously, keeping the buffer's surface; it may only be
+  // released once the kernels using it have finished.
+  auto results = Event::WaitFor(deps, device_state_);
+  return results.then([self = shared_from_this()](decltype(results) fut) {
+    fut.get();
+    self->ReleaseDeviceBuffer();
+    return self->base_;
+  });
 }
 
 boost::future<void*> CMMemBuffer::MapDiscard(const std::vector<std::shared_ptr<hal::Event>>& deps) {
-  ReleaseDeviceBuffer();
-  return boost::make_ready_future(base_);
+  return MapCurrent(deps);
 }
 
 std::shared_ptr<hal::Event> CMMemBuffer::Unmap(const context::Context& ctx) {
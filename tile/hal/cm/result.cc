@@ -7,8 +7,8 @@
 #include <utility>
 
 #include "base/util/compat.h"
-#include "base/util/env.h"
 #include "base/util/error.h"
+#include "base/util/runtime_options.h"
 #include "tile/hal/cm/err.h"
 #include "tile/lang/semprinter.h"
 
@@ -71,17 +71,17 @@ void Result::LogStatistics() const {
   }
 }
 
-KernelResult::KernelResult(const context::Context& ctx, std::shared_ptr<DeviceState> device_state, CmEvent* event,
-                           const lang::KernelInfo& ki)
-    : ctx_{ctx}, device_state_{std::move(device_state)}, event_{std::move(event)}, ki_(ki) {}
+KernelResult::KernelResult(const context::Context& ctx, std::shared_ptr<DeviceState> device_state,
+                           std::shared_ptr<TaskBatch> batch, const lang::KernelInfo& ki)
+    : ctx_{ctx}, device_state_{std::move(device_state)}, batch_{std::move(batch)}, ki_(ki) {}
 
 std::chrono::high_resolution_clock::duration KernelResult::GetDuration() const {
-  std::call_once(once_, [this]() { info_ = MakeResultInfo(event_); });
+  std::call_once(once_, [this]() { info_ = MakeResultInfo(batch_->event()); });
   return info_->execution_duration;
 }
 
 void KernelResult::LogStatistics() const {
-  std::call_once(once_, [this]() { info_ = MakeResultInfo(event_); });
+  std::call_once(once_, [this]() { info_ = MakeResultInfo(batch_->event()); });
   if (info_->status < 0) {
     LOG(ERROR) << "Kernel " << ki_.kname << " failed with: ";
 
@@ -96,7 +96,7 @@ void KernelResult::LogStatistics() const {
       // Prevent division by 0
       duration = 1;
     }
-    if (env::Get("PLAIDML_DUMP_TIMES") == "1") {
+    if (RuntimeOptions::Get().dump_times) {
       std::string rcom = ki_.comments;
       if (rcom.size() > 2 && rcom[0] == '/' && rcom[1] == '/') {
         rcom = rcom.substr(2, rcom.size() - 2);
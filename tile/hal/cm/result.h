@@ -36,10 +36,12 @@ class Result final : public hal::Result {
   mutable std::once_flag once_;
 };
 
+// The result of a kernel.  Unless the kernel was run on its own (as when
+// profiling), the timings are those of the whole batch it ran in.
 class KernelResult final : public hal::Result {
  public:
-  KernelResult(const context::Context& ctx, std::shared_ptr<DeviceState> device_state, CmEvent* event,
-               const lang::KernelInfo& ki);
+  KernelResult(const context::Context& ctx, std::shared_ptr<DeviceState> device_state,
+               std::shared_ptr<TaskBatch> batch, const lang::KernelInfo& ki);
 
   std::chrono::high_resolution_clock::duration GetDuration() const final;
   void LogStatistics() const final;
@@ -47,7 +49,7 @@ class KernelResult final : public hal::Result {
  private:
   context::Context ctx_;
   std::shared_ptr<DeviceState> device_state_;
-  CmEvent* event_;
+  std::shared_ptr<TaskBatch> batch_;
   mutable std::unique_ptr<ResultInfo> info_;
   mutable std::once_flag once_;
 
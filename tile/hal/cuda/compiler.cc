@@ -1,9 +1,13 @@
 // Copyright 2018, Intel Corporation.
 
+#include <string>
+#include <vector>
+
 #include "cuda/include/nvrtc.h"
 #include "tile/hal/cuda/emit.h"
 #include "tile/hal/cuda/error.h"
 #include "tile/hal/cuda/hal.h"
+#include "tile/hal/cuda/ptx_cache.h"
 
 namespace vertexai {
 namespace tile {
@@ -50,17 +54,7 @@ std::string WithLineNumbers(const std::string& src) {
 
 }  // namespace
 
-Compiler::Compiler(Device* device) : device_(device) {}
-
-boost::future<std::unique_ptr<hal::Library>> Compiler::Build(const context::Context& ctx,
-                                                             const std::vector<lang::KernelInfo>& kernels,
-                                                             const hal::proto::HardwareSettings& settings) {
-  if (!kernels.size()) {
-    return boost::make_ready_future(
-        std::unique_ptr<hal::Library>{std::make_unique<Library>(std::vector<std::shared_ptr<Kernel>>{})});
-  }
-
-  auto src = EmitCudaC(kernels);
+std::string Compiler::CompilePtx(const std::string& src, const std::string& arch) {
   VLOG(3) << "Compiling CUDA C:\n" << WithLineNumbers(src);
 
   nvrtcProgram program;
@@ -72,7 +66,9 @@ boost::future<std::unique_ptr<hal::Library>> Compiler::Build(const context::Cont
                                               nullptr);     // includeNames
   nvrtc::Error::Check(nvrtc_err, "nvrtcCreateProgram() failed");
 
-  nvrtc::Error compile_err = nvrtcCompileProgram(program, 0, nullptr);
+  auto arch_option = "--gpu-architecture=" + arch;
+  const char* options[] = {arch_option.c_str()};
+  nvrtc::Error compile_err = nvrtcCompileProgram(program, 1, options);
 
   size_t log_size;
   nvrtc_err = nvrtcGetProgramLogSize(program, &log_size);
@@ -96,14 +92,38 @@ boost::future<std::unique_ptr<hal::Library>> Compiler::Build(const context::Cont
 
   VLOG(2) << "PTX: " << ptx_size << " bytes";
 
-  std::vector<char> ptx;
+  std::string ptx;
   ptx.resize(ptx_size);
-  nvrtc_err = nvrtcGetPTX(program, ptx.data());
+  nvrtc_err = nvrtcGetPTX(program, &ptx[0]);
   nvrtc::Error::Check(nvrtc_err, "nvrtcGetPTX() failed");
 
   nvrtc_err = nvrtcDestroyProgram(&program);
   nvrtc::Error::Check(nvrtc_err, "nvrtcDestroyProgram() failed");
 
+  return ptx;
+}
+
+Compiler::Compiler(Device* device) : device_(device), ptx_cache_{PtxCache::FromEnv()} {}
+
+boost::future<std::unique_ptr<hal::Library>> Compiler::Build(const context::Context& ctx,
+                                                             const std::vector<lang::KernelInfo>& kernels,
+                                                             const hal::proto::HardwareSettings& settings) {
+  if (!kernels.size()) {
+    return boost::make_ready_future(
+        std::unique_ptr<hal::Library>{std::make_unique<Library>(device_, std::vector<std::shared_ptr<Kernel>>{})});
+  }
+
+  auto src = EmitCudaC(kernels);
+  auto arch = device_->arch();
+  std::string ptx;
+  auto key = ptx_cache_ ? PtxCache::Key(src, arch) : std::string{};
+  if (!ptx_cache_ || !ptx_cache_->Load(key, &ptx)) {
+    ptx = CompilePtx(src, arch);
+    if (ptx_cache_) {
+      ptx_cache_->Store(key, ptx);
+    }
+  }
+
   device_->SetCurrentContext();
 
   CUmodule module;
@@ -118,10 +138,10 @@ boost::future<std::unique_ptr<hal::Library>> Compiler::Build(const context::Cont
       CUfunction function;
       cuda_err = cuModuleGetFunction(&function, module, ki.kname.c_str());
       Error::Check(cuda_err, "cuModuleGetFunction() failed");
-      result.emplace_back(std::make_shared<CodeKernel>(device_, ki, function));
+      result.emplace_back(std::make_shared<ComputeKernel>(device_, ki, function));
     }
   }
-  std::unique_ptr<hal::Library> lib(new Library(std::move(result)));
+  std::unique_ptr<hal::Library> lib(new Library(device_, std::move(result)));
   return boost::make_ready_future(std::move(lib));
 }
 
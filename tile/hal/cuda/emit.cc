@@ -3,7 +3,9 @@
 #include "tile/hal/cuda/emit.h"
 
 #include <map>
+#include <memory>
 #include <set>
+#include <tuple>
 #include <utility>
 
 #include <boost/format.hpp>
@@ -325,9 +327,20 @@ class Emitter : public sem::Visitor {
     emit(";\n");
   }
 
+  void Visit(const sem::SpecialStmt& node) override {
+    if (node.name == "MAC_INIT" || node.name == "MAC_INNER" || node.name == "MAC_FINISH") {
+      emitMac(node);
+      return;
+    }
+    throw std::runtime_error("CUDA code emitter special statement not defined: " + node.name);
+  }
+
   void Visit(const sem::Function& node) override {
     lang::Scope<sem::Type> scope;
     scope_ = &scope;
+    for (const auto& p : node.params) {
+      scope.Bind(p.second, p.first);
+    }
 
     emit("extern \"C\" __global__\n");
     emitType(node.ret);
@@ -351,7 +364,108 @@ class Emitter : public sem::Visitor {
     scope_ = nullptr;
   }
 
+  bool uses_wmma() const { return uses_wmma_; }
+
  private:
+  // A matrix operand of a MAC special: buffer, offset, row stride, column stride
+  struct MacMatrix {
+    sem::ExprPtr buf;
+    sem::ExprPtr offset;
+    int64_t ld;
+    bool row_major;
+    DataType dtype;
+  };
+
+  static int64_t macConst(const sem::SpecialStmt& node, size_t i) {
+    auto value = std::dynamic_pointer_cast<sem::IntConst>(node.params.at(i));
+    if (!value) {
+      throw std::runtime_error("Non-constant parameter to " + node.name);
+    }
+    return value->value;
+  }
+
+  MacMatrix macMatrix(const sem::SpecialStmt& node, size_t i) {
+    MacMatrix matrix{node.params.at(i), node.params.at(i + 1)};
+    int64_t row_stride = macConst(node, i + 2);
+    int64_t col_stride = macConst(node, i + 3);
+    matrix.row_major = col_stride == 1;
+    matrix.ld = matrix.row_major ? row_stride : col_stride;
+    if (!matrix.row_major && row_stride != 1) {
+      throw std::runtime_error("WMMA operands must be contiguous along rows or columns");
+    }
+    matrix.dtype = typeOf(matrix.buf).dtype;
+    return matrix;
+  }
+
+  void emitPointer(const MacMatrix& matrix) {
+    matrix.buf->Accept(*this);
+    emit(" + (");
+    matrix.offset->Accept(*this);
+    emit(")");
+  }
+
+  // Maps the MAC specials onto the warp-level matrix multiply-accumulate
+  // (WMMA) API: MAC_INIT loads the output tile into an accumulator fragment,
+  // MAC_INNER multiplies a tile of each input into it, and MAC_FINISH stores it
+  // back.  The inputs must be half precision; the accumulator follows the
+  // output, which may be half or float.
+  void emitMac(const sem::SpecialStmt& node) {
+    int64_t m = macConst(node, 0);
+    int64_t n = macConst(node, 1);
+    int64_t k = macConst(node, 2);
+    if (k != 16 || !((m == 16 && n == 16) || (m == 32 && n == 8) || (m == 8 && n == 32))) {
+      throw std::runtime_error(str(boost::format("Unsupported WMMA shape: %1%x%2%x%3%") % m % n % k));
+    }
+    uses_wmma_ = true;
+    auto shape = str(boost::format("%1%, %2%, %3%") % m % n % k);
+    if (node.name == "MAC_INNER") {
+      auto a = macMatrix(node, 3);
+      auto b = macMatrix(node, 7);
+      if (a.dtype != DataType::FLOAT16 || b.dtype != DataType::FLOAT16) {
+        throw std::runtime_error("WMMA inputs must be half precision");
+      }
+      emitTab();
+      emit("{\n");
+      ++indent_;
+      for (const auto& [matrix, name, use] : {std::make_tuple(a, "mac_a", "matrix_a"),  //
+                                              std::make_tuple(b, "mac_b", "matrix_b")}) {
+        emitTab();
+        emit(str(boost::format("nvcuda::wmma::fragment<nvcuda::wmma::%1%, %2%, half, nvcuda::wmma::%3%> %4%;\n") %
+                 use % shape % (matrix.row_major ? "row_major" : "col_major") % name));
+        emitTab();
+        emit(str(boost::format("nvcuda::wmma::load_matrix_sync(%1%, ") % name));
+        emitPointer(matrix);
+        emit(", " + std::to_string(matrix.ld) + ");\n");
+      }
+      emitTab();
+      emit("nvcuda::wmma::mma_sync(mac_acc, mac_a, mac_b, mac_acc);\n");
+      --indent_;
+      emitTab();
+      emit("}\n");
+      return;
+    }
+    auto c = macMatrix(node, 3);
+    if (c.dtype != DataType::FLOAT16 && c.dtype != DataType::FLOAT32) {
+      throw std::runtime_error("WMMA outputs must be half or float");
+    }
+    auto layout = std::string{c.row_major ? "nvcuda::wmma::mem_row_major" : "nvcuda::wmma::mem_col_major"};
+    emitTab();
+    if (node.name == "MAC_INIT") {
+      emit(str(boost::format("nvcuda::wmma::fragment<nvcuda::wmma::accumulator, %1%, %2%> mac_acc;\n") % shape %
+               c_dtype(c.dtype)));
+      emitTab();
+      emit("nvcuda::wmma::load_matrix_sync(mac_acc, ");
+    } else {
+      emit("nvcuda::wmma::store_matrix_sync(");
+    }
+    emitPointer(c);
+    if (node.name == "MAC_INIT") {
+      emit(", " + std::to_string(c.ld) + ", " + layout + ");\n");
+    } else {
+      emit(", mac_acc, " + std::to_string(c.ld) + ", " + layout + ");\n");
+    }
+  }
+
   void emit(const std::string& str) { oss_ << str; }
 
   void emitTab() { oss_ << std::string(indent_ << 1, ' '); }
@@ -380,9 +494,9 @@ class Emitter : public sem::Visitor {
     }
   }
 
-  sem::Type typeOf(const sem::ExprPtr& expr) { return lang::ExprType::TypeOf(scope_, false, expr); }
+  sem::Type typeOf(const sem::ExprPtr& expr) { return lang::ExprType::TypeOf(scope_, false, false, expr); }
 
-  sem::Type typeOf(const sem::LValPtr& lvalue) { return lang::ExprType::TypeOf(scope_, false, lvalue); }
+  sem::Type typeOf(const sem::LValPtr& lvalue) { return lang::ExprType::TypeOf(scope_, false, false, lvalue); }
 
   void emitCast(const sem::Type& to, const sem::ExprPtr& expr) {
     emitType(to);
@@ -395,6 +509,7 @@ class Emitter : public sem::Visitor {
   std::ostringstream& oss_;
   size_t indent_ = 0;
   lang::Scope<sem::Type>* scope_;
+  bool uses_wmma_ = false;
 };
 
 std::string EmitClamp() {
@@ -408,21 +523,28 @@ __device__ T clamp(T val, U min, U max) {
 }
 
 std::string EmitCudaC(const std::vector<lang::KernelInfo>& kernels) {
-  std::ostringstream src;
-
-  src << EmitClamp() << "\n";
+  std::ostringstream body;
+  bool uses_wmma = false;
 
   std::set<std::string> seen;
   for (const auto& ki : kernels) {
     if (ki.ktype == lang::KernelType::kFunction) {
       if (!seen.count(ki.kname)) {
-        Emitter emitter(&src);
+        Emitter emitter(&body);
         emitter.Visit(*ki.kfunc);
-        src << "\n\n";
+        body << "\n\n";
+        uses_wmma |= emitter.uses_wmma();
         seen.insert(ki.kname);
       }
     }
   }
+
+  std::ostringstream src;
+  if (uses_wmma) {
+    src << "#include <mma.h>\n";
+  }
+  src << EmitClamp() << "\n";
+  src << body.str();
   return src.str();
 }
 
@@ -2,8 +2,13 @@
 
 #include "tile/hal/cuda/hal.h"
 
+#include <algorithm>
+#include <string>
+#include <utility>
+
 #include <boost/format.hpp>
 
+#include "base/util/env.h"
 #include "base/util/error.h"
 #include "base/util/factory.h"
 #include "tile/hal/cuda/error.h"
@@ -12,6 +17,18 @@ namespace vertexai {
 namespace tile {
 namespace hal {
 namespace cuda {
+namespace {
+
+// The number of streams each program's kernels are spread across.
+std::size_t StreamCount() {
+  auto count = env::Get("PLAIDML_CUDA_STREAMS");
+  if (count.empty()) {
+    return 4;
+  }
+  return std::max<std::size_t>(std::stoull(count), 1);
+}
+
+}  // namespace
 
 [[gnu::unused]] char reg = []() -> char {
   FactoryRegistrar<hal::Driver>::Instance()->Register(
@@ -84,12 +101,17 @@ Device::Device(int didx) {
   err = cuCtxCreate(&context_, 0, device_);
   Error::Check(err, "cuCtxCreate() failed");
 
+  err = cuStreamCreate(&transfer_stream_, CU_STREAM_NON_BLOCKING);
+  Error::Check(err, "cuStreamCreate() failed");
+
   compiler_.reset(new Compiler(this));
   executor_.reset(new Executor(this));
 }
 
 Device::~Device() {
   if (compiler_) {
+    SetCurrentContext();
+    cuStreamDestroy(transfer_stream_);
     Error err = cuCtxDestroy(context_);
     if (err) {
       LOG(ERROR) << "cuCtxDestroy() failed: " << err.str();
@@ -133,6 +155,49 @@ hal::proto::HardwareInfo Device::GetHardwareInfo() {
   return info;
 }
 
+std::string Device::arch() {
+  int major;
+  int minor;
+  Error err = cuDeviceGetAttribute(&major, CU_DEVICE_ATTRIBUTE_COMPUTE_CAPABILITY_MAJOR, device_);
+  Error::Check(err, "cuDeviceGetAttribute() failed");
+  err = cuDeviceGetAttribute(&minor, CU_DEVICE_ATTRIBUTE_COMPUTE_CAPABILITY_MINOR, device_);
+  Error::Check(err, "cuDeviceGetAttribute() failed");
+  return str(boost::format("compute_%d%d") % major % minor);
+}
+
+StreamPool::StreamPool(Device* device, std::size_t count) : device_{device} {
+  device_->SetCurrentContext();
+  for (std::size_t idx = 0; idx < count; ++idx) {
+    CUstream stream;
+    Error err = cuStreamCreate(&stream, CU_STREAM_NON_BLOCKING);
+    Error::Check(err, "cuStreamCreate() failed");
+    streams_.push_back(stream);
+  }
+}
+
+StreamPool::~StreamPool() {
+  device_->SetCurrentContext();
+  for (auto stream : streams_) {
+    // Outstanding work still completes; the stream is released afterwards.
+    cuStreamDestroy(stream);
+  }
+}
+
+CUstream StreamPool::Pick(const std::vector<std::shared_ptr<hal::Event>>& deps) {
+  for (const auto& dep : deps) {
+    auto evt = Event::Downcast(dep);
+    if (!evt->pending()) {
+      continue;
+    }
+    for (auto stream : streams_) {
+      if (evt->stream() == stream) {
+        return stream;
+      }
+    }
+  }
+  return streams_[next_++ % streams_.size()];
+}
+
 DeviceMemory::DeviceMemory(Device* device)  //
     : device_(device)                       //
 {}
@@ -165,37 +230,58 @@ DeviceBuffer::DeviceBuffer(Device* device, CUdeviceptr dptr, std::uint64_t size)
 
 DeviceBuffer::~DeviceBuffer() {
   device_->SetCurrentContext();
+  if (host_) {
+    cuMemFreeHost(host_);
+  }
   cuMemFree(dptr_);
 }
 
+void* DeviceBuffer::EnsureHost() {
+  if (!host_) {
+    device_->SetCurrentContext();
+    Error err = cuMemAllocHost(&host_, size_);
+    Error::Check(err, "cuMemAllocHost() failed");
+  }
+  return host_;
+}
+
 boost::future<void*> DeviceBuffer::MapCurrent(const std::vector<std::shared_ptr<hal::Event>>& deps) {
-  buf_.resize(size_);
+  void* ptr = EnsureHost();
+  auto stream = device_->transfer_stream();
   device_->SetCurrentContext();
-  Error err = cuMemcpyDtoH(buf_.data(), dptr_, size_);
-  Error::Check(err, "cuMemcpyDtoH() failed");
-  void* ptr = buf_.data();
-  return boost::make_ready_future(ptr);
+  Event::Enqueue(deps, stream);
+  Error err = cuMemcpyDtoHAsync(ptr, dptr_, size_, stream);
+  Error::Check(err, "cuMemcpyDtoHAsync() failed");
+  context::Context ctx;
+  Event evt{ctx, "tile::hal::cuda::DeviceBuffer::MapCurrent", device_, stream};
+  return evt.GetFuture().then([ptr](boost::shared_future<std::shared_ptr<hal::Result>> f) {
+    f.get();
+    return ptr;
+  });
 }
 
 boost::future<void*> DeviceBuffer::MapDiscard(const std::vector<std::shared_ptr<hal::Event>>& deps) {
-  buf_.resize(size_);
-  void* ptr = buf_.data();
-  return boost::make_ready_future(ptr);
+  // The host memory may still be feeding an earlier upload, so wait for the
+  // dependencies before handing it out.
+  void* ptr = EnsureHost();
+  return Event::WaitFor(deps).then([ptr](boost::future<std::vector<std::shared_ptr<hal::Result>>> f) {
+    f.get();
+    return ptr;
+  });
 }
 
 std::shared_ptr<hal::Event> DeviceBuffer::Unmap(const context::Context& ctx) {
+  void* ptr = EnsureHost();
+  auto stream = device_->transfer_stream();
   device_->SetCurrentContext();
-  auto start = std::chrono::high_resolution_clock::now();
-  Error err = cuMemcpyHtoD(dptr_, buf_.data(), size_);
-  Error::Check(err, "cuMemcpyHtoD() failed");
-  auto end = std::chrono::high_resolution_clock::now();
-  std::shared_ptr<hal::Result> result =
-      std::make_shared<Result>(ctx, "tile::hal::cuda::DeviceBuffer::Unmap", start, end);
-  return std::make_shared<Event>(std::move(result));
+  Error err = cuMemcpyHtoDAsync(dptr_, ptr, size_, stream);
+  Error::Check(err, "cuMemcpyHtoDAsync() failed");
+  return std::make_shared<Event>(ctx, "tile::hal::cuda::DeviceBuffer::Unmap", device_, stream);
 }
 
 Executor::Executor(Device* device)              //
-    : info_{device->GetHardwareInfo()},         //
+    : device_{device},                          //
+      info_{device->GetHardwareInfo()},         //
       device_memory_(new DeviceMemory(device))  //
 {}
 
@@ -209,9 +295,9 @@ std::shared_ptr<hal::Event> Executor::Copy(const context::Context& ctx,
   throw error::Unimplemented("Not implemented: Executor::Copy");
 }
 
-boost::future<std::unique_ptr<hal::Executable>> Executor::Prepare(hal::Library* library, std::size_t kidx) {
+boost::future<std::unique_ptr<hal::Executable>> Executor::Prepare(hal::Library* library) {
   auto lib = Library::Downcast(library);
-  return lib->Prepare(kidx);
+  return lib->Prepare();
 }
 
 boost::future<std::vector<std::shared_ptr<hal::Result>>> Executor::WaitFor(
@@ -221,13 +307,14 @@ boost::future<std::vector<std::shared_ptr<hal::Result>>> Executor::WaitFor(
 
 void Executor::Flush() {}
 
-Executable::Executable(std::vector<std::shared_ptr<Kernel>> kernels) : kernels_{std::move(kernels)} {}
+Executable::Executable(std::vector<std::shared_ptr<Kernel>> kernels, std::unique_ptr<StreamPool> streams)
+    : kernels_{std::move(kernels)}, streams_{std::move(streams)} {}
 
 std::shared_ptr<hal::Event> Executable::Run(const context::Context& ctx, std::size_t kernel_index,
-                                            const std::vector<std::shared_ptr<Buffer>>& params,
-                                            const std::vector<std::shared_ptr<Event>>& dependencies,
-                                            bool enable_profiling = false) {
-  return kernels_[kernel_index]->Run(ctx, params, dependencies, enable_profiling);
+                                            const std::vector<std::shared_ptr<hal::Buffer>>& params,
+                                            const std::vector<std::shared_ptr<hal::Event>>& dependencies,
+                                            bool enable_profiling) {
+  return kernels_[kernel_index]->Run(ctx, params, dependencies, enable_profiling, streams_.get());
 }
 
 ComputeKernel::ComputeKernel(Device* device, const lang::KernelInfo& ki, CUfunction function)
@@ -239,7 +326,8 @@ ComputeKernel::ComputeKernel(Device* device, const lang::KernelInfo& ki, CUfunct
 std::shared_ptr<hal::Event> ComputeKernel::Run(const context::Context& ctx,                              //
                                                const std::vector<std::shared_ptr<hal::Buffer>>& params,  //
                                                const std::vector<std::shared_ptr<hal::Event>>& deps,     //
-                                               bool enable_profiling) {
+                                               bool enable_profiling,                                    //
+                                               StreamPool* streams) {
   size_t shared_bytes = 0;
 
   lang::GridSize block{{
@@ -261,7 +349,8 @@ std::shared_ptr<hal::Event> ComputeKernel::Run(const context::Context& ctx,
 
   device_->SetCurrentContext();
 
-  auto start = std::chrono::high_resolution_clock::now();
+  auto stream = streams->Pick(deps);
+  Event::Enqueue(deps, stream);
   Error err = cuLaunchKernel(function_,     // f
                              grid[0],       // gridDimX
                              grid[1],       // gridDimY
@@ -270,15 +359,11 @@ std::shared_ptr<hal::Event> ComputeKernel::Run(const context::Context& ctx,
                              block[1],      // blockDimY
                              block[2],      // blockDimZ
                              shared_bytes,  // sharedMemBytes
-                             nullptr,       // hStream
+                             stream,        // hStream
                              args.data(),   // kernelParams
                              nullptr);      // extra
   Error::Check(err, "cuLaunchKernel() failed");
-  err = cuCtxSynchronize();
-  Error::Check(err, "cuCtxSynchronize() failed");
-  auto end = std::chrono::high_resolution_clock::now();
-  std::shared_ptr<hal::Result> result = std::make_shared<Result>(ctx, "tile::hal::cuda::Kernel::Run", start, end);
-  return std::make_shared<Event>(std::move(result));
+  return std::make_shared<Event>(ctx, "tile::hal::cuda::Kernel::Run", device_, stream);
 }
 
 ZeroKernel::ZeroKernel(Device* device, const lang::KernelInfo& ki)  //
@@ -289,38 +374,84 @@ ZeroKernel::ZeroKernel(Device* device, const lang::KernelInfo& ki)  //
 std::shared_ptr<hal::Event> ZeroKernel::Run(const context::Context& ctx,
                                             const std::vector<std::shared_ptr<hal::Buffer>>& params,
                                             const std::vector<std::shared_ptr<hal::Event>>& deps,
-                                            bool enable_profiling) {
+                                            bool enable_profiling, StreamPool* streams) {
   auto buf = DeviceBuffer::Downcast(params[0]);
   auto dptr = buf->dptr();
 
   device_->SetCurrentContext();
 
-  auto start = std::chrono::high_resolution_clock::now();
+  auto stream = streams->Pick(deps);
+  Event::Enqueue(deps, stream);
+  Error err = cuMemsetD8Async(dptr, 0, buf->size(), stream);
+  Error::Check(err, "cuMemsetD8Async() failed");
 
-  Error err = cuMemsetD8(dptr, 0, buf->size());
-  Error::Check(err, "cuMemsetD8() failed");
-
-  err = cuCtxSynchronize();
-  Error::Check(err, "cuCtxSynchronize() failed");
-
-  auto end = std::chrono::high_resolution_clock::now();
-  std::shared_ptr<hal::Result> result = std::make_shared<Result>(ctx, "tile::hal::cuda::ZeroKernel::Run", start, end);
-  return std::make_shared<Event>(std::move(result));
+  return std::make_shared<Event>(ctx, "tile::hal::cuda::ZeroKernel::Run", device_, stream);
 }
 
-Library::Library(std::vector<std::shared_ptr<Kernel>> kernels) : kernels_{std::move(kernels)} {}
+Library::Library(Device* device, std::vector<std::shared_ptr<Kernel>> kernels)
+    : device_{device}, kernels_{std::move(kernels)} {}
 
 Library* Library::Downcast(hal::Library* library) {  //
   return dynamic_cast<Library*>(library);
 }
 
 boost::future<std::unique_ptr<hal::Executable>> Library::Prepare() {
-  return boost::make_ready_future<std::unique_ptr<hal::Executable>>(std::make_unique<Executable>(kernels_));
+  return boost::make_ready_future<std::unique_ptr<hal::Executable>>(
+      std::make_unique<Executable>(kernels_, std::make_unique<StreamPool>(device_, StreamCount())));
 }
 
+namespace {
+
+struct Completion {
+  context::Context ctx;
+  const char* verb;
+  std::chrono::high_resolution_clock::time_point start;
+  boost::promise<std::shared_ptr<hal::Result>> prom;
+};
+
+// Runs on a CUDA driver thread; it must not call into the driver API.
+void CUDA_CB OnStreamComplete(CUstream /* stream */, CUresult status, void* data) {
+  std::unique_ptr<Completion> completion{static_cast<Completion*>(data)};
+  if (status != CUDA_SUCCESS) {
+    completion->prom.set_exception(std::make_exception_ptr(
+        std::runtime_error(std::string(completion->verb) + " failed: " + Error{status}.str())));
+    return;
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  completion->prom.set_value(std::make_shared<Result>(completion->ctx, completion->verb, completion->start, end));
+}
+
+}  // namespace
+
 Event::Event(std::shared_ptr<hal::Result> result)  //
-    : result_(std::move(result))                   //
-{}
+    : fut_(boost::make_ready_future(std::move(result)).share()) {}
+
+Event::Event(const context::Context& ctx, const char* verb, Device* device, CUstream stream)
+    : device_{device}, stream_{stream} {
+  auto completion = std::make_unique<Completion>();
+  completion->ctx = ctx;
+  completion->verb = verb;
+  completion->start = std::chrono::high_resolution_clock::now();
+  fut_ = completion->prom.get_future().share();
+
+  device_->SetCurrentContext();
+  Error err = cuEventCreate(&event_, CU_EVENT_DISABLE_TIMING);
+  Error::Check(err, "cuEventCreate() failed");
+  err = cuEventRecord(event_, stream_);
+  Error::Check(err, "cuEventRecord() failed");
+  err = cuStreamAddCallback(stream_, OnStreamComplete, completion.get(), 0);
+  Error::Check(err, "cuStreamAddCallback() failed");
+  completion.release();
+}
+
+Event::~Event() {
+  if (event_) {
+    device_->SetCurrentContext();
+    cuEventDestroy(event_);
+  }
+}
+
+bool Event::pending() const { return event_ && cuEventQuery(event_) == CUDA_ERROR_NOT_READY; }
 
 std::shared_ptr<Event> Event::Downcast(const std::shared_ptr<hal::Event>& event) {
   auto evt = std::dynamic_pointer_cast<Event>(event);
@@ -347,8 +478,19 @@ boost::future<std::vector<std::shared_ptr<hal::Result>>> Event::WaitFor(
   return results;
 }
 
+void Event::Enqueue(const std::vector<std::shared_ptr<hal::Event>>& events, CUstream stream) {
+  for (const auto& event : events) {
+    auto evt = Downcast(event);
+    if (!evt->event_ || evt->stream_ == stream) {
+      continue;
+    }
+    Error err = cuStreamWaitEvent(stream, evt->event_, 0);
+    Error::Check(err, "cuStreamWaitEvent() failed");
+  }
+}
+
 boost::shared_future<std::shared_ptr<hal::Result>> Event::GetFuture() {  //
-  return boost::make_ready_future(result_);
+  return fut_;
 }
 
 Result::Result(const context::Context& ctx,                           //
@@ -2,6 +2,9 @@
 
 #pragma once
 
+#include <atomic>
+#include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -82,12 +85,36 @@ class Device final : public hal::Device {
   void SetCurrentContext();
   hal::proto::HardwareInfo GetHardwareInfo();
 
+  // The virtual architecture to compile for, e.g. "compute_70".
+  std::string arch();
+
+  // The stream used for host<->device copies.
+  CUstream transfer_stream() const { return transfer_stream_; }
+
  private:
   std::unique_ptr<hal::Compiler> compiler_;
   std::unique_ptr<hal::Executor> executor_;
   const std::unordered_map<std::string, std::unique_ptr<hal::Loader>> il_loader_map_;
   CUdevice device_;
   CUcontext context_;
+  CUstream transfer_stream_ = nullptr;
+};
+
+// The streams a program's kernels are spread across.  Each launch goes to the
+// stream of its first pending dependency, so chains of dependent kernels run
+// in order on one stream; independent launches are dealt out round-robin, and
+// dependencies on other streams become stream waits on their events.
+class StreamPool final {
+ public:
+  StreamPool(Device* device, std::size_t count);
+  ~StreamPool();
+
+  CUstream Pick(const std::vector<std::shared_ptr<hal::Event>>& deps);
+
+ private:
+  Device* device_;
+  std::vector<CUstream> streams_;
+  std::atomic<std::size_t> next_{0};
 };
 
 class DeviceMemory final : public hal::Memory {
@@ -121,12 +148,16 @@ class DeviceBuffer : public hal::Buffer {
   void* dptr_arg() { return &dptr_; }
 
  private:
+  void* EnsureHost();
+
   std::uint64_t size_;
-  std::vector<char> buf_;
+  void* host_ = nullptr;  // Pinned, so that copies can run asynchronously
   CUdeviceptr dptr_;
   Device* device_;
 };
 
+class PtxCache;
+
 class Compiler final : public hal::Compiler {
  public:
   explicit Compiler(Device* device);
@@ -136,7 +167,10 @@ class Compiler final : public hal::Compiler {
                                                      const hal::proto::HardwareSettings& /* settings */) final;
 
  private:
+  std::string CompilePtx(const std::string& src, const std::string& arch);
+
   Device* device_;
+  std::shared_ptr<PtxCache> ptx_cache_;
 };
 
 class Executor : public hal::Executor {
@@ -149,7 +183,7 @@ class Executor : public hal::Executor {
 
   Memory* shared_memory() final { return nullptr; }
 
-  bool is_synchronous() const final { return true; }
+  bool is_synchronous() const final { return false; }
 
   std::shared_ptr<hal::Event> Copy(const context::Context& ctx, const std::shared_ptr<hal::Buffer>& from,
                                    std::size_t from_offset, const std::shared_ptr<hal::Buffer>& to,
@@ -164,6 +198,7 @@ class Executor : public hal::Executor {
   void Flush() final;
 
  private:
+  Device* device_;
   const hal::proto::HardwareInfo info_;
   std::unique_ptr<hal::Memory> device_memory_;
 };
@@ -175,12 +210,12 @@ class Kernel {
   virtual std::shared_ptr<hal::Event> Run(const context::Context& ctx,
                                           const std::vector<std::shared_ptr<hal::Buffer>>& params,
                                           const std::vector<std::shared_ptr<hal::Event>>& dependencies,
-                                          bool enable_profiling) = 0;
+                                          bool enable_profiling, StreamPool* streams) = 0;
 };
 
 class Executable final : public hal::Executable {
  public:
-  explicit Executable(std::vector<std::unique_ptr<hal::Kernel>> kernels);
+  Executable(std::vector<std::shared_ptr<Kernel>> kernels, std::unique_ptr<StreamPool> streams);
 
   std::shared_ptr<hal::Event> Run(const context::Context& ctx, std::size_t kernel_index,
                                   const std::vector<std::shared_ptr<hal::Buffer>>& params,
@@ -189,6 +224,7 @@ class Executable final : public hal::Executable {
 
  private:
   std::vector<std::shared_ptr<Kernel>> kernels_;
+  std::unique_ptr<StreamPool> streams_;
 };
 
 class ComputeKernel final : public Kernel {
@@ -196,8 +232,8 @@ class ComputeKernel final : public Kernel {
   ComputeKernel(Device* device, const lang::KernelInfo& ki, CUfunction function);
 
   std::shared_ptr<hal::Event> Run(const context::Context& ctx, const std::vector<std::shared_ptr<hal::Buffer>>& params,
-                                  const std::vector<std::shared_ptr<hal::Event>>& dependencies,
-                                  bool enable_profiling) final;
+                                  const std::vector<std::shared_ptr<hal::Event>>& dependencies, bool enable_profiling,
+                                  StreamPool* streams) final;
 
  private:
   lang::KernelInfo ki_;
@@ -210,8 +246,8 @@ class ZeroKernel final : public Kernel {
   explicit ZeroKernel(Device* device, const lang::KernelInfo& ki);
 
   std::shared_ptr<hal::Event> Run(const context::Context& ctx, const std::vector<std::shared_ptr<hal::Buffer>>& params,
-                                  const std::vector<std::shared_ptr<hal::Event>>& dependencies,
-                                  bool enable_profiling) final;
+                                  const std::vector<std::shared_ptr<hal::Event>>& dependencies, bool enable_profiling,
+                                  StreamPool* streams) final;
 
  private:
   lang::KernelInfo ki_;
@@ -222,29 +258,44 @@ class Library final : public hal::Library {
  public:
   static Library* Downcast(hal::Library* library);
 
-  explicit Library(std::vector<std::shared_ptr<Kernel>> kernels);
+  Library(Device* device, std::vector<std::shared_ptr<Kernel>> kernels);
 
-  std::string Serialize() final { return ""; }
+  std::map<std::string, std::string> Serialize() final { return {}; }
 
   boost::future<std::unique_ptr<hal::Executable>> Prepare();
 
  private:
+  Device* device_;
   std::vector<std::shared_ptr<Kernel>> kernels_;
 };
 
 class Event final : public hal::Event {
  public:
+  // An event which has already completed.
   explicit Event(std::shared_ptr<hal::Result> result);
 
+  // An event which completes once the work enqueued so far on the stream has finished.
+  Event(const context::Context& ctx, const char* verb, Device* device, CUstream stream);
+  ~Event();
+
   static std::shared_ptr<Event> Downcast(const std::shared_ptr<hal::Event>& event);
 
   static boost::future<std::vector<std::shared_ptr<hal::Result>>> WaitFor(
       const std::vector<std::shared_ptr<hal::Event>>& events);
 
+  // Makes the stream wait for each of the events enqueued on another stream.
+  static void Enqueue(const std::vector<std::shared_ptr<hal::Event>>& events, CUstream stream);
+
   boost::shared_future<std::shared_ptr<hal::Result>> GetFuture() final;
 
+  CUstream stream() const { return stream_; }
+  bool pending() const;
+
  private:
-  std::shared_ptr<hal::Result> result_;
+  Device* device_ = nullptr;
+  CUstream stream_ = nullptr;
+  CUevent event_ = nullptr;
+  boost::shared_future<std::shared_ptr<hal::Result>> fut_;
 };
 
 class Result final : public hal::Result {
@@ -0,0 +1,43 @@
+// Copyright 2019, Intel Corp.
+
+#include "tile/hal/cuda/ptx_cache.h"
+
+#include <sstream>
+#include <utility>
+
+#include "cuda/include/nvrtc.h"
+
+namespace vertexai {
+namespace tile {
+namespace hal {
+namespace cuda {
+namespace {
+
+// Bump this whenever the cache's file format or key changes.
+const char kPtxCacheFormat[] = "1";
+
+}  // namespace
+
+std::shared_ptr<PtxCache> PtxCache::FromEnv() {
+  auto blobs = BlobCache::FromEnv("PLAIDML_CUDA_PTX_CACHE", ".ptx");
+  return blobs ? std::make_shared<PtxCache>(*blobs) : nullptr;
+}
+
+PtxCache::PtxCache(BlobCache blobs) : blobs_{std::move(blobs)} {}
+
+std::string PtxCache::Key(const std::string& src, const std::string& arch) {
+  int major = 0;
+  int minor = 0;
+  nvrtcVersion(&major, &minor);
+  std::stringstream ss;
+  ss << "format " << kPtxCacheFormat << "\n"
+     << "arch " << arch << "\n"
+     << "nvrtc " << major << "." << minor << "\n"
+     << src;
+  return ss.str();
+}
+
+}  // namespace cuda
+}  // namespace hal
+}  // namespace tile
+}  // namespace vertexai
@@ -0,0 +1,40 @@
+// Copyright 2019, Intel Corp.
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "base/util/blob_cache.h"
+
+namespace vertexai {
+namespace tile {
+namespace hal {
+namespace cuda {
+
+// A persistent, on-disk store of the PTX produced by NVRTC, so that kernels
+// needn't be recompiled from CUDA C in every process.  Entries are keyed by
+// the kernel source, the target architecture, and the NVRTC version, and
+// stored in a BlobCache.
+class PtxCache final {
+ public:
+  // Returns the cache named by PLAIDML_CUDA_PTX_CACHE, or nullptr if the
+  // variable is unset.
+  static std::shared_ptr<PtxCache> FromEnv();
+
+  explicit PtxCache(BlobCache blobs);
+
+  static std::string Key(const std::string& src, const std::string& arch);
+
+  // Returns true and fills in the PTX if the key is present.
+  bool Load(const std::string& key, std::string* ptx) const { return blobs_.Load(key, ptx); }
+  void Store(const std::string& key, const std::string& ptx) const { blobs_.Store(key, ptx); }
+
+ private:
+  BlobCache blobs_;
+};
+
+}  // namespace cuda
+}  // namespace hal
+}  // namespace tile
+}  // namespace vertexai
@@ -2,6 +2,8 @@
 
 #include "tile/hal/metal/hal.h"
 
+#include <algorithm>
+
 #include "base/util/env.h"
 #include "base/util/error.h"
 #include "base/util/file.h"
@@ -17,6 +19,17 @@ namespace tile {
 namespace hal {
 namespace metal {
 
+namespace {
+
+// The most commands batched into one command buffer; committing long programs
+// in several pieces lets the device start on them while the rest is encoded.
+constexpr std::size_t kMaxBatchCommands = 256;
+
+// The smallest heap from which device-only buffers are sub-allocated.
+constexpr std::uint64_t kMinHeapSize = 64 * std::mega::num;
+
+}  // namespace
+
 [[gnu::unused]] char reg = []() -> char {
   FactoryRegistrar<hal::Driver>::Instance()->Register(
       "metal",                                                                    //
@@ -89,19 +102,82 @@ id<MTLCommandQueue> Device::queue() {
   return queue_;
 }
 
+void Device::Encode(const std::function<void(id<MTLCommandBuffer>)>& encode, bool isolate) {
+  auto queue = this->queue();
+  std::lock_guard<std::mutex> guard(batch_mutex_);
+  if (isolate) {
+    if (batch_) {
+      [batch_ commit];
+      batch_ = nil;
+    }
+    auto cmdbuf = [queue commandBuffer];
+    encode(cmdbuf);
+    [cmdbuf commit];
+    return;
+  }
+  if (!batch_) {
+    batch_ = [queue commandBuffer];
+    batch_commands_ = 0;
+  }
+  encode(batch_);
+  if (++batch_commands_ >= kMaxBatchCommands) {
+    [batch_ commit];
+    batch_ = nil;
+  }
+}
+
+void Device::Commit() {
+  std::lock_guard<std::mutex> guard(batch_mutex_);
+  if (batch_) {
+    [batch_ commit];
+    batch_ = nil;
+  }
+}
+
+id<MTLBuffer> Device::MakePrivateBuffer(std::uint64_t size) {
+  if (@available(macOS 10.15, *)) {
+    // Heap resources are untracked by default; tracking them keeps the
+    // kernels batched into one command buffer ordered by their buffers.
+    auto options = MTLResourceStorageModePrivate | MTLResourceHazardTrackingModeTracked;
+    auto size_align = [device_ heapBufferSizeAndAlignWithLength:size options:options];
+    std::lock_guard<std::mutex> guard(mutex_);
+    for (const auto& heap : heaps_) {
+      if ([heap maxAvailableSizeWithAlignment:size_align.align] >= size_align.size) {
+        id<MTLBuffer> buf = [heap newBufferWithLength:size options:options];
+        if (buf) {
+          return buf;
+        }
+      }
+    }
+    auto desc = [[MTLHeapDescriptor alloc] init];
+    desc.storageMode = MTLStorageModePrivate;
+    desc.hazardTrackingMode = MTLHazardTrackingModeTracked;
+    desc.size = std::max<std::uint64_t>(size_align.size, kMinHeapSize);
+    id<MTLHeap> heap = [device_ newHeapWithDescriptor:desc];
+    if (heap) {
+      IVLOG(2, "Allocated a Metal heap of " << desc.size << " bytes");
+      heaps_.push_back(heap);
+      id<MTLBuffer> buf = [heap newBufferWithLength:size options:options];
+      if (buf) {
+        return buf;
+      }
+    }
+  }
+  return [device_ newBufferWithLength:size options:MTLResourceStorageModePrivate];
+}
+
 Memory::Memory(Device* device)  //
     : device_(device)           //
 {}
 
 std::shared_ptr<hal::Buffer> Memory::MakeBuffer(std::uint64_t size, BufferAccessMask access) {
-  MTLResourceOptions options;
+  id<MTLBuffer> buf;
   if ((access & BufferAccessMask::LOCATION_MASK) == BufferAccessMask::DEVICE) {
-    // This is a device-only accessible buffer.
-    options = MTLResourceStorageModePrivate;
+    // This is a device-only accessible buffer, such as a temporary.
+    buf = device_->MakePrivateBuffer(size);
   } else {
-    options = MTLResourceStorageModeManaged;
+    buf = [device_->dev() newBufferWithLength:size options:MTLResourceStorageModeManaged];
   }
-  auto buf = [device_->dev() newBufferWithLength:size options:options];
   return std::make_shared<Buffer>(device_, buf, size, access);
 }
 
@@ -135,6 +211,8 @@ boost::future<void*> Buffer::MapCurrent(const std::vector<std::shared_ptr<hal::E
   auto handler = [buffer = buffer_, promise](id<MTLCommandBuffer> cmdbuf) mutable {
     promise->set_value([buffer contents]);
   };
+  // The queue runs command buffers in order, so the synchronization follows the kernels already batched.
+  device_->Commit();
   @autoreleasepool {
     auto cmdbuf = [device_->queue() commandBuffer];
     auto encoder = [cmdbuf blitCommandEncoder];
@@ -157,6 +235,7 @@ std::shared_ptr<hal::Event> Buffer::Unmap(const context::Context& ctx) {
   if ((access_ & BufferAccessMask::LOCATION_MASK) == BufferAccessMask::DEVICE) {
     throw error::Unimplemented("Not Implemented: Buffer::Unmap for device-only accessible memory");
   }
+  device_->Commit();
   @autoreleasepool {
     [buffer_ didModifyRange:NSMakeRange(0, size_)];
     // NOTE: This encoder which seems to do nothing appears to be required for some Metal devices.
@@ -354,10 +433,15 @@ boost::future<std::unique_ptr<hal::Executable>> Library::Prepare() {
 }
 
 Executor::Executor(Device* device)       //
-    : info_(device->GetHardwareInfo()),  //
+    : device_(device),                   //
+      info_(device->GetHardwareInfo()),  //
       memory_(new Memory(device))        //
 {}
 
+void Executor::Flush() {  //
+  device_->Commit();
+}
+
 std::shared_ptr<hal::Event> Executor::Copy(const context::Context& ctx,               //
                                            const std::shared_ptr<hal::Buffer>& from,  //
                                            std::size_t from_offset,                   //
@@ -375,6 +459,7 @@ boost::future<std::unique_ptr<hal::Executable>> Executor::Prepare(hal::Library*
 
 boost::future<std::vector<std::shared_ptr<hal::Result>>> Executor::WaitFor(
     const std::vector<std::shared_ptr<hal::Event>>& events) {
+  device_->Commit();
   std::vector<boost::shared_future<std::shared_ptr<hal::Result>>> futures;
   for (auto& event : events) {
     futures.emplace_back(event->GetFuture());
@@ -437,25 +522,29 @@ std::shared_ptr<hal::Event> ComputeKernel::Run(const context::Context& ctx,
     MTLSize groups = MTLSizeMake(ki_.gwork[0] / threads.width,   //
                                  ki_.gwork[1] / threads.height,  //
                                  ki_.gwork[2] / threads.depth);
-    auto cmdbuf = [device_->queue() commandBuffer];
-    auto encoder = [cmdbuf computeCommandEncoder];
-    [encoder setComputePipelineState:state_];
-    for (size_t i = 0; i < params.size(); i++) {
-      auto buf = Buffer::Downcast(params[i]);
-      [encoder setBuffer:buf->buffer()  //
-                  offset:0
-                 atIndex:i];
-    }
-    [encoder dispatchThreadgroups:groups threadsPerThreadgroup:threads];
-    [encoder endEncoding];
     context::Activity activity{ctx, "tile::hal::opencl::Kernel::Run"};
     if (ctx.is_logging_events()) {
       opencl::proto::RunInfo rinfo;
       *rinfo.mutable_kernel_id() = kernel_id_;
       activity.AddMetadata(rinfo);
     }
-    auto event = std::make_shared<Event>(activity.ctx(), cmdbuf, "tile::hal::opencl::Executing");
-    [cmdbuf commit];
+    std::shared_ptr<hal::Event> event;
+    device_->Encode(
+        [&](id<MTLCommandBuffer> cmdbuf) {
+          auto encoder = [cmdbuf computeCommandEncoder];
+          [encoder setComputePipelineState:state_];
+          for (size_t i = 0; i < params.size(); i++) {
+            auto buf = Buffer::Downcast(params[i]);
+            [encoder setBuffer:buf->buffer()  //
+                        offset:0
+                       atIndex:i];
+          }
+          [encoder dispatchThreadgroups:groups threadsPerThreadgroup:threads];
+          [encoder endEncoding];
+          event = std::make_shared<Event>(activity.ctx(), cmdbuf, "tile::hal::opencl::Executing",
+                                          enable_profiling ? nullptr : device_);
+        },
+        enable_profiling);
     return event;
   }
 }
@@ -473,24 +562,28 @@ std::shared_ptr<hal::Event> CopyKernel::Run(const context::Context& ctx,
                                             const std::vector<std::shared_ptr<hal::Event>>& deps,
                                             bool enable_profiling) {
   @autoreleasepool {
-    auto cmdbuf = [device_->queue() commandBuffer];
-    auto encoder = [cmdbuf blitCommandEncoder];
     auto dst_buf = Buffer::Downcast(params[0]);
     auto src_buf = Buffer::Downcast(params[1]);
-    [encoder copyFromBuffer:src_buf->buffer()
-               sourceOffset:0
-                   toBuffer:dst_buf->buffer()
-          destinationOffset:0
-                       size:src_buf->size()];
-    [encoder endEncoding];
     context::Activity activity{ctx, "tile::hal::opencl::Buffer::Copy"};
     if (ctx.is_logging_events()) {
       opencl::proto::RunInfo rinfo;
       *rinfo.mutable_kernel_id() = kernel_id_;
       activity.AddMetadata(rinfo);
     }
-    auto event = std::make_shared<Event>(activity.ctx(), cmdbuf, "tile::hal::opencl::Executing");
-    [cmdbuf commit];
+    std::shared_ptr<hal::Event> event;
+    device_->Encode(
+        [&](id<MTLCommandBuffer> cmdbuf) {
+          auto encoder = [cmdbuf blitCommandEncoder];
+          [encoder copyFromBuffer:src_buf->buffer()
+                     sourceOffset:0
+                         toBuffer:dst_buf->buffer()
+                destinationOffset:0
+                             size:src_buf->size()];
+          [encoder endEncoding];
+          event = std::make_shared<Event>(activity.ctx(), cmdbuf, "tile::hal::opencl::Executing",
+                                          enable_profiling ? nullptr : device_);
+        },
+        enable_profiling);
     return event;
   }
 }
@@ -508,30 +601,36 @@ std::shared_ptr<hal::Event> ZeroKernel::Run(const context::Context& ctx,
                                             const std::vector<std::shared_ptr<hal::Event>>& deps,
                                             bool enable_profiling) {
   @autoreleasepool {
-    auto cmdbuf = [device_->queue() commandBuffer];
-    auto encoder = [cmdbuf blitCommandEncoder];
     auto buf = Buffer::Downcast(params[0]);
-    [encoder fillBuffer:buf->buffer()  //
-                  range:NSMakeRange(0, buf->size())
-                  value:0];
-    [encoder endEncoding];
     context::Activity activity{ctx, "tile::hal::opencl::Buffer::Fill"};
     if (ctx.is_logging_events()) {
       opencl::proto::RunInfo rinfo;
       *rinfo.mutable_kernel_id() = kernel_id_;
       activity.AddMetadata(rinfo);
     }
-    auto event = std::make_shared<Event>(activity.ctx(), cmdbuf, "tile::hal::opencl::Executing");
-    [cmdbuf commit];
+    std::shared_ptr<hal::Event> event;
+    device_->Encode(
+        [&](id<MTLCommandBuffer> cmdbuf) {
+          auto encoder = [cmdbuf blitCommandEncoder];
+          [encoder fillBuffer:buf->buffer()  //
+                        range:NSMakeRange(0, buf->size())
+                        value:0];
+          [encoder endEncoding];
+          event = std::make_shared<Event>(activity.ctx(), cmdbuf, "tile::hal::opencl::Executing",
+                                          enable_profiling ? nullptr : device_);
+        },
+        enable_profiling);
     return event;
   }
 }
 
 Event::Event(const context::Context& ctx,  //
              id<MTLCommandBuffer> cmdbuf,  //
-             const char* verb)             //
+             const char* verb,             //
+             Device* batched)              //
     : ctx_(ctx),                           //
-      verb_(verb) {                        //
+      verb_(verb),                         //
+      batched_(batched) {                  //
   auto promise = std::make_shared<boost::promise<std::shared_ptr<hal::Result>>>();
   future_ = promise->get_future();
   auto start = std::chrono::high_resolution_clock::now();
@@ -579,6 +678,14 @@ Result::Result(const context::Context& ctx,                           //
       end_{end}                                                       //
 {}
 
+boost::shared_future<std::shared_ptr<hal::Result>> Event::GetFuture() {
+  if (batched_) {
+    // Waiting on a batched command requires its command buffer to be committed.
+    batched_->Commit();
+  }
+  return future_;
+}
+
 std::chrono::high_resolution_clock::duration Result::GetDuration() const {  //
   return end_ - start_;
 }
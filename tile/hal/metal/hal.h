@@ -7,8 +7,11 @@
 #include <Metal/MTLCommandQueue.h>
 #include <Metal/MTLComputePipeline.h>
 #include <Metal/MTLDevice.h>
+#include <Metal/MTLHeap.h>
 #include <Metal/MTLLibrary.h>
 
+#include <functional>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -66,9 +69,26 @@ class Device final : public hal::Device {
   id<MTLDevice> dev() const { return device_; }
   id<MTLCommandQueue> queue();
 
+  // Encodes commands into the device's open command buffer, which batches the
+  // commands of successive kernels until Commit.  If isolate is set (e.g. to
+  // time the commands), the commands get a command buffer of their own,
+  // committed at once.  Either way, encode must register its completion
+  // handlers itself, as the buffer may be committed as soon as it returns.
+  void Encode(const std::function<void(id<MTLCommandBuffer>)>& encode, bool isolate = false);
+
+  // Commits the open command buffer, if any.
+  void Commit();
+
+  // Makes a device-only buffer, sub-allocated from the device's heaps.
+  id<MTLBuffer> MakePrivateBuffer(std::uint64_t size);
+
  private:
   id<MTLDevice> device_;
   id<MTLCommandQueue> queue_;
+  std::mutex batch_mutex_;
+  id<MTLCommandBuffer> batch_;      // Guarded by batch_mutex_
+  std::size_t batch_commands_ = 0;  // Guarded by batch_mutex_
+  std::vector<id<MTLHeap>> heaps_;  // Guarded by mutex_
   std::unique_ptr<hal::Compiler> compiler_;
   std::unique_ptr<hal::Executor> executor_;
   const std::unordered_map<std::string, std::unique_ptr<hal::Loader>> il_loader_map_;
@@ -151,11 +171,10 @@ class Executor : public hal::Executor {
   boost::future<std::vector<std::shared_ptr<hal::Result>>> WaitFor(
       const std::vector<std::shared_ptr<hal::Event>>& events) final;
 
-  void Flush() final {
-    // NOP
-  }
+  void Flush() final;
 
  private:
+  Device* device_;
   const hal::proto::HardwareInfo info_;
   std::unique_ptr<hal::Memory> memory_;
 };
@@ -257,18 +276,22 @@ class Library final : public hal::Library {
 
 class Event final : public hal::Event {
  public:
+  // If batched, the command buffer is the device's open command buffer, which
+  // is committed once the event is waited upon.
   Event(const context::Context& ctx,  //
         id<MTLCommandBuffer> cmdbuf,  //
-        const char* verb);
+        const char* verb,             //
+        Device* batched = nullptr);
 
   Event(const context::Context& ctx,  //
         const char* verb);
 
-  boost::shared_future<std::shared_ptr<hal::Result>> GetFuture() final { return future_; }
+  boost::shared_future<std::shared_ptr<hal::Result>> GetFuture() final;
 
  private:
   context::Context ctx_;
   const char* verb_;
+  Device* batched_ = nullptr;
   boost::shared_future<std::shared_ptr<hal::Result>> future_;
 };
 
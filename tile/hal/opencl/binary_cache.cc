@@ -0,0 +1,77 @@
+// Copyright 2019, Intel Corp.
+
+#include "tile/hal/opencl/binary_cache.h"
+
+#include <sstream>
+#include <utility>
+
+#include "base/util/logging.h"
+
+namespace vertexai {
+namespace tile {
+namespace hal {
+namespace opencl {
+namespace {
+
+// Bump this whenever the cache's file format or key changes.
+const char kBinaryCacheFormat[] = "1";
+
+}  // namespace
+
+const char kBuildOptions[] = "-cl-fast-relaxed-math -cl-mad-enable -cl-unsafe-math-optimizations";
+
+std::string GetProgramBinary(cl_program program, const std::string& name) {
+  std::size_t size;
+  Err::Check(ocl::GetProgramInfo(program, CL_PROGRAM_BINARY_SIZES, sizeof(size), &size, nullptr),
+             "Unable to compute binary size for " + name);
+  std::string binary;
+  binary.resize(size);
+  const char* datum = binary.data();
+  Err::Check(ocl::GetProgramInfo(program, CL_PROGRAM_BINARIES, sizeof(datum), &datum, nullptr),
+             "Unable to serialize binary for " + name);
+  return binary;
+}
+
+CLObj<cl_program> LoadProgramBinary(const DeviceState& device_state, const std::string& binary) {
+  Err err;
+  cl_int binary_status;
+  cl_device_id did = device_state.did();
+  std::size_t length = binary.size();
+  auto* data = reinterpret_cast<const unsigned char*>(binary.data());
+  CLObj<cl_program> program = ocl::CreateProgramWithBinary(device_state.cl_ctx().get(), 1, &did, &length, &data,
+                                                           &binary_status, err.ptr());
+  if (!program || err || binary_status != CL_SUCCESS) {
+    IVLOG(1, "OpenCL program binary rejected: " << err.str());
+    return CLObj<cl_program>{};
+  }
+  // Binaries still need to be built, but this skips compiling the source.
+  err = ocl::BuildProgram(program.get(), 1, &did, kBuildOptions, nullptr, nullptr);
+  if (err) {
+    IVLOG(1, "Unable to build OpenCL program binary: " << err.str());
+    return CLObj<cl_program>{};
+  }
+  return program;
+}
+
+std::shared_ptr<BinaryCache> BinaryCache::FromEnv() {
+  auto blobs = BlobCache::FromEnv("PLAIDML_OPENCL_BINARY_CACHE", ".clbin");
+  return blobs ? std::make_shared<BinaryCache>(*blobs) : nullptr;
+}
+
+BinaryCache::BinaryCache(BlobCache blobs) : blobs_{std::move(blobs)} {}
+
+std::string BinaryCache::Key(const std::string& src, const proto::DeviceInfo& info) {
+  std::stringstream ss;
+  ss << "format " << kBinaryCacheFormat << "\n"
+     << "device " << info.name() << "\n"
+     << "version " << info.version() << "\n"
+     << "driver " << info.driver_version() << "\n"
+     << "options " << kBuildOptions << "\n"
+     << src;
+  return ss.str();
+}
+
+}  // namespace opencl
+}  // namespace hal
+}  // namespace tile
+}  // namespace vertexai
@@ -0,0 +1,52 @@
+// Copyright 2019, Intel Corp.
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "base/util/blob_cache.h"
+#include "tile/hal/opencl/device_state.h"
+#include "tile/hal/opencl/ocl.h"
+
+namespace vertexai {
+namespace tile {
+namespace hal {
+namespace opencl {
+
+// The options used to build every Tile OpenCL program.
+extern const char kBuildOptions[];
+
+// Returns the device binary of a built program.
+std::string GetProgramBinary(cl_program program, const std::string& name);
+
+// Creates and builds a program from a device binary, returning a null
+// program if the binary is rejected (e.g. it came from another driver).
+CLObj<cl_program> LoadProgramBinary(const DeviceState& device_state, const std::string& binary);
+
+// A persistent, on-disk store of OpenCL program binaries, so that kernels
+// needn't be rebuilt from source in every process.  Entries are keyed by the
+// program source, the device name, device and driver versions, and the build
+// options, and stored in a BlobCache.
+class BinaryCache final {
+ public:
+  // Returns the cache named by PLAIDML_OPENCL_BINARY_CACHE, or nullptr if
+  // the variable is unset.
+  static std::shared_ptr<BinaryCache> FromEnv();
+
+  explicit BinaryCache(BlobCache blobs);
+
+  static std::string Key(const std::string& src, const proto::DeviceInfo& info);
+
+  // Returns true and fills in the binary if the key is present.
+  bool Load(const std::string& key, std::string* binary) const { return blobs_.Load(key, binary); }
+  void Store(const std::string& key, const std::string& binary) const { blobs_.Store(key, binary); }
+
+ private:
+  BlobCache blobs_;
+};
+
+}  // namespace opencl
+}  // namespace hal
+}  // namespace tile
+}  // namespace vertexai
@@ -12,8 +12,12 @@ namespace tile {
 namespace hal {
 namespace opencl {
 
-CLMemBuffer::CLMemBuffer(const std::shared_ptr<DeviceState>& device_state, std::uint64_t size, CLObj<cl_mem> mem)
-    : Buffer{device_state->cl_ctx(), size}, device_state_{device_state}, mem_{std::move(mem)} {}
+CLMemBuffer::CLMemBuffer(const std::shared_ptr<DeviceState>& device_state, std::uint64_t size, CLObj<cl_mem> mem,
+                         std::shared_ptr<StagingPool> staging_pool)
+    : Buffer{device_state->cl_ctx(), size},
+      device_state_{device_state},
+      mem_{std::move(mem)},
+      staging_pool_{std::move(staging_pool)} {}
 
 void CLMemBuffer::SetKernelArg(const CLObj<cl_kernel>& kernel, std::size_t index) {
   cl_mem m = mem_.get();
@@ -46,6 +50,16 @@ boost::future<void*> CLMemBuffer::MapCurrent(const std::vector<std::shared_ptr<h
 }
 
 boost::future<void*> CLMemBuffer::MapDiscard(const std::vector<std::shared_ptr<hal::Event>>& deps) {
+  if (staging_pool_) {
+    staging_ = staging_pool_->Acquire(size());
+    if (staging_) {
+      // The host may fill the staging buffer right away; only the upload
+      // needs to wait for the buffer's current users.
+      staging_deps_ = deps;
+      base_ = staging_->base;
+      return boost::make_ready_future(base_);
+    }
+  }
   const auto& queue = device_state_->cl_normal_queue();
   auto mdeps = Event::Downcast(deps, device_state_->cl_ctx(), queue);
   Err err;
@@ -64,6 +78,9 @@ boost::future<void*> CLMemBuffer::MapDiscard(const std::vector<std::shared_ptr<h
 }
 
 std::shared_ptr<hal::Event> CLMemBuffer::Unmap(const context::Context& ctx) {
+  if (staging_) {
+    return UploadStaging(ctx);
+  }
   const auto& queue = device_state_->cl_normal_queue();
   context::Activity activity{ctx, "tile::hal::opencl::Buffer::Unmap"};
   CLObj<cl_event> evt;
@@ -80,6 +97,29 @@ std::shared_ptr<hal::Event> CLMemBuffer::Unmap(const context::Context& ctx) {
   return result;
 }
 
+std::shared_ptr<hal::Event> CLMemBuffer::UploadStaging(const context::Context& ctx) {
+  const auto& queue = device_state_->cl_transfer_queue();
+  context::Activity activity{ctx, "tile::hal::opencl::Buffer::Upload"};
+  auto mdeps = Event::Downcast(staging_deps_, device_state_->cl_ctx(), queue);
+  CLObj<cl_event> evt;
+  Err err = ocl::EnqueueWriteBuffer(queue.cl_queue.get(),                   // command_queue
+                                    mem_.get(),                             // buffer
+                                    CL_FALSE,                               // blocking_write
+                                    0,                                      // offset
+                                    size(),                                 // size
+                                    staging_->base,                         // ptr
+                                    mdeps.size(),                           // num_events_in_wait_list
+                                    mdeps.size() ? mdeps.data() : nullptr,  // event_wait_list
+                                    evt.LvaluePtr());                       // event
+  Err::Check(err, "Unable to upload memory");
+  auto result = std::make_shared<Event>(activity.ctx(), device_state_, std::move(evt), queue);
+  queue.Flush();
+  staging_pool_->Release(std::move(staging_), result);
+  staging_deps_.clear();
+  base_ = nullptr;
+  return result;
+}
+
 }  // namespace opencl
 }  // namespace hal
 }  // namespace tile
@@ -8,6 +8,7 @@
 #include "tile/hal/opencl/buffer.h"
 #include "tile/hal/opencl/device_state.h"
 #include "tile/hal/opencl/ocl.h"
+#include "tile/hal/opencl/staging_pool.h"
 
 namespace vertexai {
 namespace tile {
@@ -15,9 +16,14 @@ namespace hal {
 namespace opencl {
 
 // A Buffer implemented using a cl_mem object.
+//
+// If given a staging pool, MapDiscard hands out a pinned staging buffer
+// instead of mapping the cl_mem, and Unmap uploads it asynchronously on the
+// device's transfer queue.
 class CLMemBuffer final : public Buffer, public std::enable_shared_from_this<CLMemBuffer> {
  public:
-  CLMemBuffer(const std::shared_ptr<DeviceState>& device_state, std::uint64_t size, CLObj<cl_mem> mem);
+  CLMemBuffer(const std::shared_ptr<DeviceState>& device_state, std::uint64_t size, CLObj<cl_mem> mem,
+              std::shared_ptr<StagingPool> staging_pool = nullptr);
 
   void SetKernelArg(const CLObj<cl_kernel>& kernel, std::size_t index) final;
 
@@ -29,10 +35,14 @@ class CLMemBuffer final : public Buffer, public std::enable_shared_from_this<CLM
 
  private:
   static CLObj<cl_mem> MakeMem(const std::shared_ptr<DeviceState>& device_state, std::uint64_t size);
+  std::shared_ptr<hal::Event> UploadStaging(const context::Context& ctx);
 
   const std::shared_ptr<DeviceState> device_state_;
   const CLObj<cl_mem> mem_;
+  const std::shared_ptr<StagingPool> staging_pool_;
   void* base_ = nullptr;
+  std::shared_ptr<StagingPool::Staging> staging_;          // Set while a staged MapDiscard is outstanding
+  std::vector<std::shared_ptr<hal::Event>> staging_deps_;  // What the upload must wait for
 };
 
 }  // namespace opencl
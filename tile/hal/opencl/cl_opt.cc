@@ -25,13 +25,14 @@ class InsnOptimizer : public sem::Visitor {
 
   void Visit(const sem::LoadExpr& node) override {}
 
-  void Visit(const sem::StoreStmt& node) override {}
+  void Visit(const sem::StoreStmt& node) override { NarrowConstants(node.rhs); }
 
   void Visit(const sem::SubscriptLVal& node) override {}
 
   void Visit(const sem::DeclareStmt& node) override {
     using namespace sem::builder;  // NOLINT
     if (node.init) {
+      NarrowConstants(node.init);
       auto add = FindBinaryExpr("+", node.init);
       if (add) {
         auto add_ty = TypeOf(add);
@@ -129,6 +130,75 @@ class InsnOptimizer : public sem::Visitor {
 
   void EvalStmt(const sem::StmtPtr& stmt) { stmt->Accept(*this); }
 
+  // Float constants are single precision, so an operation between a half value
+  // and a constant is computed in float.  On devices with native half support,
+  // cast such constants to half instead.
+  void NarrowConstants(const sem::ExprPtr& expr) {
+    if (!cl_khr_fp16_) {
+      return;
+    }
+    if (auto unary_expr = std::dynamic_pointer_cast<sem::UnaryExpr>(expr)) {
+      NarrowConstants(unary_expr->inner);
+    } else if (auto binary_expr = std::dynamic_pointer_cast<sem::BinaryExpr>(expr)) {
+      NarrowConstants(binary_expr->lhs);
+      NarrowConstants(binary_expr->rhs);
+      NarrowPair(&binary_expr->lhs, &binary_expr->rhs);
+    } else if (auto cond_expr = std::dynamic_pointer_cast<sem::CondExpr>(expr)) {
+      NarrowConstants(cond_expr->cond);
+      NarrowConstants(cond_expr->tcase);
+      NarrowConstants(cond_expr->fcase);
+      NarrowPair(&cond_expr->tcase, &cond_expr->fcase);
+    } else if (auto select_expr = std::dynamic_pointer_cast<sem::SelectExpr>(expr)) {
+      NarrowConstants(select_expr->cond);
+      NarrowConstants(select_expr->tcase);
+      NarrowConstants(select_expr->fcase);
+      NarrowPair(&select_expr->tcase, &select_expr->fcase);
+    } else if (auto cast_expr = std::dynamic_pointer_cast<sem::CastExpr>(expr)) {
+      NarrowConstants(cast_expr->val);
+    } else if (auto call_expr = std::dynamic_pointer_cast<sem::CallExpr>(expr)) {
+      bool has_half = false;
+      for (const auto& val : call_expr->vals) {
+        NarrowConstants(val);
+        has_half |= IsHalf(val);
+      }
+      if (has_half) {
+        for (auto& val : call_expr->vals) {
+          val = NarrowConstant(val);
+        }
+      }
+    }
+  }
+
+  void NarrowPair(sem::ExprPtr* lhs, sem::ExprPtr* rhs) {
+    if (IsHalf(*rhs)) {
+      *lhs = NarrowConstant(*lhs);
+    }
+    if (IsHalf(*lhs)) {
+      *rhs = NarrowConstant(*rhs);
+    }
+  }
+
+  bool IsHalf(const sem::ExprPtr& expr) {
+    auto ty = TypeOf(expr);
+    return ty.base == sem::Type::VALUE && ty.dtype == DataType::FLOAT16;
+  }
+
+  // Returns the expression cast to half if it is a float constant.
+  sem::ExprPtr NarrowConstant(const sem::ExprPtr& expr) {
+    using namespace sem::builder;  // NOLINT
+    if (std::dynamic_pointer_cast<sem::FloatConst>(expr)) {
+      return _Cast(sem::Type{sem::Type::VALUE, DataType::FLOAT16}, expr);
+    }
+    auto cast_expr = std::dynamic_pointer_cast<sem::CastExpr>(expr);
+    if (cast_expr && std::dynamic_pointer_cast<sem::FloatConst>(cast_expr->val) &&
+        cast_expr->type.dtype == DataType::FLOAT32) {
+      auto type = cast_expr->type;
+      type.dtype = DataType::FLOAT16;
+      return _Cast(type, cast_expr->val);
+    }
+    return expr;
+  }
+
   std::shared_ptr<sem::BinaryExpr> FindBinaryExpr(std::string op, const sem::ExprPtr& expr) {
     auto cast_expr = std::dynamic_pointer_cast<sem::CastExpr>(expr);
     if (cast_expr) {
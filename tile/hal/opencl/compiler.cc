@@ -2,8 +2,11 @@
 
 #include "tile/hal/opencl/compiler.h"
 
+#include <algorithm>
 #include <exception>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
 #include <utility>
@@ -11,18 +14,20 @@
 
 #include <boost/filesystem.hpp>
 #include <boost/thread.hpp>
-#include <boost/bind.hpp>
-#include <boost/asio.hpp>
 
 #include "base/util/callback_map.h"
 #include "base/util/compat.h"
 #include "base/util/env.h"
 #include "base/util/file.h"
 #include "base/util/logging.h"
+#include "base/util/runtime_options.h"
 #include "base/util/uuid.h"
+#include "tile/base/compile_pool.h"
+#include "tile/hal/opencl/binary_cache.h"
 #include "tile/hal/opencl/cl_opt.h"
 #include "tile/hal/opencl/emitocl.h"
 #include "tile/hal/opencl/library.h"
+#include "tile/hal/opencl/occupancy.h"
 #include "tile/lang/semprinter.h"
 
 namespace fs = boost::filesystem;
@@ -35,15 +40,27 @@ namespace {
 
 struct BuildState;
 
+// Emits the OpenCL source of a kernel, requiring the given workgroup size if it's nonzero.
+using EmitKernel = std::function<std::string(const lang::KernelInfo& ki, size_t reqd_threads)>;
+
+// Kernels whose estimated occupancy falls below this are rebuilt with a larger workgroup, if that improves it.
+constexpr double kMinOccupancy = 0.5;
+
 // Represents a build-in-flight
-class Build {
+class Build : public std::enable_shared_from_this<Build> {
  public:
   Build(context::Activity activity, const std::shared_ptr<DeviceState>& device_state, 
         const std::map<std::string, CLObj<cl_program>>& program,
         const std::vector<lang::KernelInfo>& kernel_info,
         const std::map<std::string, proto::BuildInfo>& binfo,
-        std::vector<context::proto::ActivityID> kernel_ids);
-
+        std::vector<context::proto::ActivityID> kernel_ids,
+        const std::shared_ptr<BinaryCache>& cache,
+        std::map<std::string, std::string> cache_keys,
+        std::set<std::string> prebuilt,
+        std::string header,
+        EmitKernel emit);
+
+  // Starts building on the shared compile pool; the future is ready once every program has been built.
   boost::future<std::unique_ptr<hal::Library>> Start();
   std::unique_ptr<Library>& library() { return library_; }
   std::shared_ptr<DeviceState>& device_state() { return device_state_; }
@@ -52,12 +69,25 @@ class Build {
   static void OnBuildComplete(cl_program program, void* handle) noexcept;
 
  private:
+  void Run();
+  void Retune();
+  // Rebuilds ki for the given number of threads; returns false if the rebuilt kernel doesn't improve on occupancy.
+  bool Rebuild(const lang::KernelInfo& ki, size_t threads, double occupancy, CLObj<cl_program>* program,
+               lang::KernelInfo* retuned, std::string* src);
+  void Fail(boost::exception_ptr error);
   void OnError(const std::string& current);
   context::Activity activity_;
   std::shared_ptr<DeviceState> device_state_;
   std::unique_ptr<Library> library_;
   boost::promise<std::unique_ptr<hal::Library>> prom_;
+  std::mutex fail_mu_;
+  bool failed_ = false;  // Set once prom_ holds an error
   std::map<std::string, proto::BuildInfo> binfo_;
+  std::shared_ptr<BinaryCache> cache_;
+  std::map<std::string, std::string> cache_keys_;  // Programs to store in the cache once built
+  std::set<std::string> prebuilt_;                 // Programs loaded from the cache
+  std::string header_;
+  EmitKernel emit_;
 };
 
 struct BuildState {
@@ -71,11 +101,10 @@ void Build::CompileKernel(std::shared_ptr<BuildState> build_state) {
   auto prog_it = build_state->build->library()->program().find(build_state->current);
   cl_device_id device_id = build_state->build->device_state()->did();
   clock_t build_start = clock();
-  Err err = ocl::BuildProgram(prog_it->second.get(), 1, &device_id,
-    "-cl-fast-relaxed-math -cl-mad-enable -cl-unsafe-math-optimizations", 
+  Err err = ocl::BuildProgram(prog_it->second.get(), 1, &device_id, kBuildOptions,
     &OnBuildComplete, (void *)(build_state.get()));
   clock_t build_end = clock();
-  if (env::Get("PLAIDML_BUILD_TIMES") == "1") {
+  if (RuntimeOptions::Get().build_times) {
     double elapsed_secs = double(build_end - build_start) / CLOCKS_PER_SEC;
     std::cout << "Built " << prog_it->first << " in " << elapsed_secs << " seconds.\n";
   }
@@ -87,43 +116,174 @@ void Build::CompileKernel(std::shared_ptr<BuildState> build_state) {
 
 boost::future<std::unique_ptr<hal::Library>> Build::Start() {
   auto result = prom_.get_future();
-  boost::thread_group threads;
-  boost::asio::io_service io_service;
+  CompileAsync([self = shared_from_this()] { self->Run(); });
+  return result;
+}
 
-  // Allocate tasks
-  auto& program_map = library_->program();
-  clock_t build_start = clock();
-  for (auto& prog_it : program_map) {
-    auto bs = std::make_shared<BuildState>(this, prog_it.first);
-    io_service.post(boost::bind(&(Build::CompileKernel), bs));
+void Build::Run() {
+  try {
+    // Allocate tasks
+    auto& program_map = library_->program();
+    std::vector<std::shared_ptr<BuildState>> states;
+    clock_t build_start = clock();
+    for (auto& prog_it : program_map) {
+      if (prebuilt_.count(prog_it.first)) {
+        continue;
+      }
+      states.emplace_back(std::make_shared<BuildState>(this, prog_it.first));
+    }
+    // OPENCL_BUILD_THREADS further limits the compile pool threads used.
+    auto env_threads = env::Get("OPENCL_BUILD_THREADS");
+    size_t n_threads = env_threads.empty() ? 0 : std::max(1, std::atoi(env_threads.c_str()));
+    CompileParallelFor(states.size(), n_threads, [&](size_t i) { CompileKernel(states[i]); });
+    clock_t build_end = clock();
+    if (RuntimeOptions::Get().build_times) {
+      double elapsed_secs = double(build_end - build_start) / CLOCKS_PER_SEC;
+      std::cout << "Total compilation time: " << elapsed_secs << " seconds\n";
+    }
+    bool failed;
+    {
+      std::lock_guard<std::mutex> lock{fail_mu_};
+      failed = failed_;
+    }
+    if (!failed) {
+      Retune();
+    }
+  } catch (...) {
+    Fail(boost::current_exception());
   }
-  // Create thread pool and threads
-  unsigned int n_threads = (env::Get("OPENCL_BUILD_THREADS") == "") ? 
-    boost::thread::hardware_concurrency() : std::atoi(env::Get("OPENCL_BUILD_THREADS").c_str());
-  for (size_t i = 0; i < n_threads; ++i) {
-    threads.create_thread(boost::bind(&boost::asio::io_service::run, &io_service));
+  std::lock_guard<std::mutex> lock{fail_mu_};
+  if (!failed_) {
+    prom_.set_value(std::move(library_));
   }
-  
-  threads.join_all();
-  io_service.stop();
-  clock_t build_end = clock();
-  if (env::Get("PLAIDML_BUILD_TIMES") == "1") {
-    double elapsed_secs = double(build_end - build_start) / CLOCKS_PER_SEC;
-    std::cout << "Total compilation time: " << elapsed_secs << " seconds\n";
+}
+
+// Contraction kernels are generated for the thread count in the hardware settings, which takes no account of the
+// registers and local memory the kernel turns out to use.  Once built, check how many threads each one keeps resident
+// and, where that's poor, rebuild it once with the largest workgroup the kernel can launch.  OpenCL doesn't report
+// register use directly, but CL_KERNEL_WORK_GROUP_SIZE is bounded by it.
+void Build::Retune() {
+  if (env::Get("PLAIDML_OPENCL_RETUNE") == "0") {
+    return;
+  }
+  const auto& info = device_state_->info();
+  std::vector<const lang::KernelInfo*> candidates;
+  for (const auto& ki : library_->kernel_info()) {
+    if (ki.ktype == lang::KernelType::kFunction && ki.regenerate && ki.lwork[1] == 1 && ki.lwork[2] == 1 &&
+        library_->program().count(ki.kname)) {
+      candidates.push_back(&ki);
+    }
+  }
+  struct Replacement {
+    bool valid = false;
+    CLObj<cl_program> program;
+    lang::KernelInfo ki;
+    std::string src;
+  };
+  std::vector<Replacement> replacements(candidates.size());
+  CompileParallelFor(candidates.size(), 0, [&](size_t i) {
+    const auto& ki = *candidates[i];
+    KernelUsage usage;
+    if (!QueryKernelUsage(*device_state_, library_->program().at(ki.kname).get(), ki.kname, &usage) ||
+        usage.compile_work_group_size) {
+      return;
+    }
+    double occupancy = EstimateOccupancy(info, usage, ki.lwork[0]);
+    if (occupancy >= kMinOccupancy) {
+      return;
+    }
+    size_t limit = std::min<size_t>(usage.max_work_group_size, info.max_work_group_size());
+    size_t threads = 1;
+    while (threads * 2 <= limit) {
+      threads *= 2;
+    }
+    if (threads == ki.lwork[0] || EstimateOccupancy(info, usage, threads) <= occupancy) {
+      return;
+    }
+    IVLOG(1, "Kernel " << ki.kname << " occupancy " << occupancy << " at " << ki.lwork[0] << " threads; retrying with "
+                       << threads);
+    auto& repl = replacements[i];
+    repl.valid = Rebuild(ki, threads, occupancy, &repl.program, &repl.ki, &repl.src);
+  });
+  for (size_t i = 0; i < candidates.size(); i++) {
+    auto& repl = replacements[i];
+    if (!repl.valid) {
+      continue;
+    }
+    auto& binfo = binfo_[repl.ki.kname];
+    binfo.set_src(repl.src);
+    activity_.AddMetadata(binfo);
+    library_->Replace(repl.ki.kname, std::move(repl.program), repl.ki);
+  }
+}
+
+bool Build::Rebuild(const lang::KernelInfo& ki, size_t threads, double occupancy, CLObj<cl_program>* program,
+                    lang::KernelInfo* retuned, std::string* src) {
+  *retuned = ki.regenerate(threads);
+  if (retuned->lwork[0] == ki.lwork[0] || retuned->lwork[1] != 1 || retuned->lwork[2] != 1) {
+    return false;
+  }
+  *src = header_ + emit_(*retuned, retuned->lwork[0]);
+  std::string key;
+  if (cache_) {
+    key = BinaryCache::Key(*src, device_state_->info());
+    std::string binary;
+    if (cache_->Load(key, &binary)) {
+      *program = LoadProgramBinary(*device_state_, binary);
+    }
+  }
+  if (!*program) {
+    Err err;
+    const char* buf = src->c_str();
+    *program = ocl::CreateProgramWithSource(device_state_->cl_ctx().get(), 1, &buf, nullptr, err.ptr());
+    if (!*program) {
+      return false;
+    }
+    cl_device_id device_id = device_state_->did();
+    if (ocl::BuildProgram(program->get(), 1, &device_id, kBuildOptions, nullptr, nullptr)) {
+      IVLOG(1, "Unable to rebuild kernel " << ki.kname << " for " << retuned->lwork[0] << " threads");
+      return false;
+    }
+    if (cache_) {
+      cache_->Store(key, GetProgramBinary(program->get(), ki.kname));
+    }
+  }
+  KernelUsage usage;
+  if (!QueryKernelUsage(*device_state_, program->get(), ki.kname, &usage)) {
+    return false;
+  }
+  double retuned_occupancy = EstimateOccupancy(device_state_->info(), usage, retuned->lwork[0]);
+  IVLOG(1, "Kernel " << ki.kname << " occupancy " << retuned_occupancy << " at " << retuned->lwork[0] << " threads");
+  return retuned_occupancy > occupancy;
+}
+
+void Build::Fail(boost::exception_ptr error) {
+  std::lock_guard<std::mutex> lock{fail_mu_};
+  if (!failed_) {
+    failed_ = true;
+    prom_.set_exception(error);
   }
-  prom_.set_value(std::move(library_));
-  return result;
 }
 
 Build::Build(context::Activity activity, const std::shared_ptr<DeviceState>& device_state,
              const std::map<std::string, CLObj<cl_program>>& program,
              const std::vector<lang::KernelInfo>& kernel_info,
              const std::map<std::string, proto::BuildInfo>& binfo,
-             std::vector<context::proto::ActivityID> kernel_ids)
+             std::vector<context::proto::ActivityID> kernel_ids,
+             const std::shared_ptr<BinaryCache>& cache,
+             std::map<std::string, std::string> cache_keys,
+             std::set<std::string> prebuilt,
+             std::string header,
+             EmitKernel emit)
     : activity_{std::move(activity)},
       device_state_{device_state},
       library_{std::make_unique<Library>(device_state, std::move(program), kernel_info, std::move(kernel_ids))},
-      binfo_{std::move(binfo)} {}
+      binfo_{std::move(binfo)},
+      cache_{cache},
+      cache_keys_{std::move(cache_keys)},
+      prebuilt_{std::move(prebuilt)},
+      header_{std::move(header)},
+      emit_{std::move(emit)} {}
 
 void Build::OnBuildComplete(cl_program program, void* handle) noexcept {
   BuildState* build_state = static_cast<BuildState *>(handle);
@@ -143,9 +303,13 @@ void Build::OnBuildComplete(cl_program program, void* handle) noexcept {
       build->binfo_[build_state->current].set_cl_build_status(status);
       build->OnError(build_state->current);
     }
+    auto key_it = build->cache_keys_.find(build_state->current);
+    if (build->cache_ && key_it != build->cache_keys_.end()) {
+      build->cache_->Store(key_it->second, GetProgramBinary(program, build_state->current));
+    }
     build->activity_.AddMetadata(build->binfo_[build_state->current]);
   } catch (...) {
-    build->prom_.set_exception(boost::current_exception());
+    build->Fail(boost::current_exception());
   }
 }
 
@@ -187,7 +351,8 @@ void Build::OnError(const std::string& current) {
 
 }  // namespace
 
-Compiler::Compiler(const std::shared_ptr<DeviceState>& device_state) : device_state_{device_state} {}
+Compiler::Compiler(const std::shared_ptr<DeviceState>& device_state)
+    : device_state_{device_state}, binary_cache_{BinaryCache::FromEnv()} {}
 
 std::string k_subgroup_microkernels =  // NOLINT
     R"***(
@@ -199,6 +364,45 @@ std::string k_subgroup_microkernels =  // NOLINT
 
 )***";                                 // NOLINT
 
+// The MAC specials (see SemtreeEmitter::make_special) on Intel's subgroup matrix
+// engine (DPAS).  Each work item of a subgroup of 8 holds one column of the
+// 8x8 float accumulator; the 8x16 tile of A is held a row per int8 element,
+// two halves per work item, and the 16x8 tile of B a column per work item,
+// with pairs of rows packed into each int.
+std::string k_subgroup_mac_microkernels =  // NOLINT
+    R"***(
+
+#pragma OPENCL EXTENSION cl_intel_subgroup_matrix_multiply_accumulate : enable
+
+#define MAC_INIT(M, N, K, C, c_off, c_rs, c_cs)                                                      \
+  float mac_c[8];                                                                                    \
+  for (int mac_i = 0; mac_i < 8; mac_i++) {                                                          \
+    mac_c[mac_i] = C[(c_off) + mac_i * (c_rs) + get_sub_group_local_id() * (c_cs)];                  \
+  }                                                                                                  \
+  float8 mac_acc = vload8(0, mac_c)
+
+#define MAC_INNER(M, N, K, A, a_off, a_rs, a_cs, B, b_off, b_rs, b_cs)                               \
+  do {                                                                                               \
+    int mac_a[8];                                                                                    \
+    int mac_b[8];                                                                                    \
+    int mac_l = get_sub_group_local_id();                                                            \
+    for (int mac_i = 0; mac_i < 8; mac_i++) {                                                        \
+      mac_a[mac_i] = as_int((half2)(A[(a_off) + mac_i * (a_rs) + 2 * mac_l * (a_cs)],                \
+                                    A[(a_off) + mac_i * (a_rs) + (2 * mac_l + 1) * (a_cs)]));        \
+      mac_b[mac_i] = as_int((half2)(B[(b_off) + 2 * mac_i * (b_rs) + mac_l * (b_cs)],                \
+                                    B[(b_off) + (2 * mac_i + 1) * (b_rs) + mac_l * (b_cs)]));        \
+    }                                                                                                \
+    mac_acc = intel_sub_group_f16_f16_matrix_mad_k16(vload8(0, mac_a), vload8(0, mac_b), mac_acc);   \
+  } while (0)
+
+#define MAC_FINISH(M, N, K, C, c_off, c_rs, c_cs)                                                    \
+  vstore8(mac_acc, 0, mac_c);                                                                        \
+  for (int mac_i = 0; mac_i < 8; mac_i++) {                                                          \
+    C[(c_off) + mac_i * (c_rs) + get_sub_group_local_id() * (c_cs)] = mac_c[mac_i];                  \
+  }
+
+)***";                                     // NOLINT
+
 boost::future<std::unique_ptr<hal::Library>> Compiler::Build(const context::Context& ctx,
                                                              const std::vector<lang::KernelInfo>& kernel_info,
                                                              const hal::proto::HardwareSettings& settings) {
@@ -228,6 +432,10 @@ boost::future<std::unique_ptr<hal::Library>> Compiler::Build(const context::Cont
     header << k_subgroup_microkernels;
   }
 
+  if (cl_khr_fp16 && device_state_->HasDeviceExtension("cl_intel_subgroup_matrix_multiply_accumulate")) {
+    header << k_subgroup_mac_microkernels;
+  }
+
   auto env_cache = env::Get("PLAIDML_OPENCL_CACHE");
   fs::path cache_dir;
   if (env_cache.length()) {
@@ -236,8 +444,29 @@ boost::future<std::unique_ptr<hal::Library>> Compiler::Build(const context::Cont
   }
   std::set<std::string> knames;
 
+  EmitKernel emit = [cl_khr_fp16, cl_khr_fp64, cl_intel_subgroups, settings](const lang::KernelInfo& ki,
+                                                                              size_t reqd_threads) {
+    OptimizeKernel(ki, cl_khr_fp16, settings);
+
+    Emit ocl{cl_khr_fp16, cl_khr_fp64, cl_intel_subgroups};
+    ocl.Visit(*ki.kfunc);
+
+    std::stringstream src;
+    src << "// gid: " << ki.gwork[0] << " " << ki.gwork[1] << " " << ki.gwork[2] << "\n";
+    src << "// lid: " << ki.lwork[0] << " " << ki.lwork[1] << " " << ki.lwork[2] << "\n";
+    src << ki.comments;
+    if (reqd_threads) {
+      // Recorded in the binary, so the launch dimensions can be recovered when it's loaded (see Loader).
+      src << "__attribute__((reqd_work_group_size(" << reqd_threads << ", 1, 1)))\n";
+    }
+    src << ocl.str();
+    return src.str();
+  };
+
   std::map<std::string, CLObj<cl_program>> program_map;
   std::map<std::string, proto::BuildInfo> binfo_map;
+  std::map<std::string, std::string> cache_keys;
+  std::set<std::string> prebuilt;
 
   for (const auto& ki : kernel_info) {
     std::ostringstream code;
@@ -251,15 +480,8 @@ boost::future<std::unique_ptr<hal::Library>> Compiler::Build(const context::Cont
       kinfo.set_src("// Builtin zero kernel");
     } else if (!knames.count(ki.kfunc->name)) {
       knames.insert(ki.kfunc->name);
-      OptimizeKernel(ki, cl_khr_fp16, settings);
-
-      Emit ocl{cl_khr_fp16, cl_khr_fp64};
-      ocl.Visit(*ki.kfunc);
-
       std::stringstream src;
-      src << "// gid: " << ki.gwork[0] << " " << ki.gwork[1] << " " << ki.gwork[2] << "\n";
-      src << "// lid: " << ki.lwork[0] << " " << ki.lwork[1] << " " << ki.lwork[2] << "\n";
-      src << ki.comments << ocl.str();
+      src << emit(ki, 0);
 
       if (is_directory(cache_dir)) {
         fs::path src_path = (cache_dir / ki.kname).replace_extension("cl");
@@ -293,10 +515,25 @@ boost::future<std::unique_ptr<hal::Library>> Compiler::Build(const context::Cont
         fs::path src_path = (out_path / ki.kname).replace_extension("cl");
         WriteFile(src_path, code.str());
       }
-      Err err;
-      CLObj<cl_program> program = ocl::CreateProgramWithSource(device_state_->cl_ctx().get(), 1, &buf, nullptr, err.ptr());
+      CLObj<cl_program> program;
+      if (binary_cache_) {
+        auto key = BinaryCache::Key(code.str(), device_state_->info());
+        std::string binary;
+        if (binary_cache_->Load(key, &binary)) {
+          program = LoadProgramBinary(*device_state_, binary);
+        }
+        if (program) {
+          prebuilt.insert(ki.kname);
+        } else {
+          cache_keys.emplace(ki.kname, std::move(key));
+        }
+      }
       if (!program) {
-        throw std::runtime_error(std::string("Creating an OpenCL program object for ") + ki.kname + ": " + err.str());
+        Err err;
+        program = ocl::CreateProgramWithSource(device_state_->cl_ctx().get(), 1, &buf, nullptr, err.ptr());
+        if (!program) {
+          throw std::runtime_error(std::string("Creating an OpenCL program object for ") + ki.kname + ": " + err.str());
+        }
       }
       program_map.emplace(ki.kname, std::move(program));
       binfo_map.emplace(ki.kname, std::move(binfo));
@@ -309,8 +546,11 @@ boost::future<std::unique_ptr<hal::Library>> Compiler::Build(const context::Cont
 
     kernel_ids.emplace_back(kbuild.ctx().activity_id());
   }
-  opencl::Build build(std::move(activity), device_state_, std::move(program_map), kernel_info, std::move(binfo_map), std::move(kernel_ids));
-  return build.Start();
+  auto build = std::make_shared<opencl::Build>(std::move(activity), device_state_, std::move(program_map), kernel_info,
+                                              std::move(binfo_map), std::move(kernel_ids), binary_cache_,
+                                              std::move(cache_keys), std::move(prebuilt), header.str(),
+                                              std::move(emit));
+  return build->Start();
 }
 
 }  // namespace opencl
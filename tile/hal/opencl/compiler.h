@@ -6,6 +6,7 @@
 #include <vector>
 
 #include "tile/base/hal.h"
+#include "tile/hal/opencl/binary_cache.h"
 #include "tile/hal/opencl/device_state.h"
 
 namespace vertexai {
@@ -23,6 +24,7 @@ class Compiler final : public hal::Compiler {
 
  private:
   std::shared_ptr<DeviceState> device_state_;
+  std::shared_ptr<BinaryCache> binary_cache_;  // May be null
 };
 
 }  // namespace opencl
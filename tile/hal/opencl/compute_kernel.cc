@@ -15,9 +15,15 @@ namespace tile {
 namespace hal {
 namespace opencl {
 
-ComputeKernel::ComputeKernel(const std::shared_ptr<DeviceState>& device_state, CLObj<cl_kernel> kernel,
-                             const lang::KernelInfo& info, context::proto::ActivityID kernel_id)
-    : device_state_{device_state}, kernel_{std::move(kernel)}, ki_(info), kernel_id_(kernel_id) {
+ComputeKernel::ComputeKernel(const std::shared_ptr<DeviceState>& device_state, CLObj<cl_program> program,
+                             CLObj<cl_kernel> kernel, const lang::KernelInfo& info,
+                             context::proto::ActivityID kernel_id)
+    : device_state_{device_state},
+      program_{std::move(program)},
+      kernel_{std::move(kernel)},
+      ki_(info),
+      kernel_id_(kernel_id) {
+  idle_.emplace_back(std::make_unique<Instance>(Instance{kernel_, {}}));
   if (VLOG_IS_ON(3)) {
     size_t work_group_size;
     Err::Check(ocl::GetKernelWorkGroupInfo(kernel_.get(), device_state_->did(), CL_KERNEL_WORK_GROUP_SIZE,
@@ -53,21 +59,37 @@ ComputeKernel::ComputeKernel(const std::shared_ptr<DeviceState>& device_state, C
   }
 }
 
+std::unique_ptr<ComputeKernel::Instance> ComputeKernel::Acquire() {
+  {
+    std::lock_guard<std::mutex> lock{mu_};
+    if (idle_.size()) {
+      auto instance = std::move(idle_.back());
+      idle_.pop_back();
+      return instance;
+    }
+  }
+  // Every instance is in use by another run; make one more.
+  Err err;
+  CLObj<cl_kernel> kernel = ocl::CreateKernel(program_.get(), ki_.kname.c_str(), err.ptr());
+  if (!kernel) {
+    throw std::runtime_error(std::string("Unable to initialize OpenCL kernel: ") + err.str());
+  }
+  return std::make_unique<Instance>(Instance{std::move(kernel), {}});
+}
+
+void ComputeKernel::Release(std::unique_ptr<Instance> instance) {
+  std::lock_guard<std::mutex> lock{mu_};
+  idle_.emplace_back(std::move(instance));
+}
+
 std::shared_ptr<hal::Event> ComputeKernel::Run(const context::Context& ctx,
                                                const std::vector<std::shared_ptr<hal::Buffer>>& params,
                                                const std::vector<std::shared_ptr<hal::Event>>& dependencies,
                                                bool enable_profiling) {
-  const auto& queue = device_state_->cl_queue(enable_profiling);
+  const auto& queue = Event::PickQueue(dependencies, *device_state_, enable_profiling);
   auto deps = Event::Downcast(dependencies, device_state_->cl_ctx(), queue);
   VLOG(4) << "Running kernel " << ki_.kname;
 
-  std::lock_guard<std::mutex> lock{mu_};
-  for (std::size_t i = 0; i < params.size(); ++i) {
-    Buffer* buf = Buffer::Downcast(params[i].get(), device_state_->cl_ctx());
-    VLOG(4) << "  Param: " << buf;
-    buf->SetKernelArg(kernel_, i);
-  }
-
   if (VLOG_IS_ON(4)) {
     VLOG(4) << "  Deps.size(): " << deps.size();
     for (auto dep : deps) {
@@ -82,19 +104,35 @@ std::shared_ptr<hal::Event> ComputeKernel::Run(const context::Context& ctx,
     activity.AddMetadata(rinfo);
   }
   CLObj<cl_event> done;
-  auto local_work_size = ki_.lwork[0] ? ki_.lwork.data() : nullptr;
-  auto event_wait_list = deps.size() ? deps.data() : nullptr;
-  IVLOG(4, "Running kernel,  gwork = " << ki_.gwork << ", lwork = " << (local_work_size ? local_work_size[0] : 0));
-  Err err = ocl::EnqueueNDRangeKernel(queue.cl_queue.get(),  // command_queue
-                                      kernel_.get(),         // kernel
-                                      3,                     // work_dim
-                                      nullptr,               // global_work_offset
-                                      ki_.gwork.data(),      // global_work_size
-                                      local_work_size,       // local_work_size
-                                      deps.size(),           // num_events_in_wait_list
-                                      event_wait_list,       // event_wait_list
-                                      done.LvaluePtr());     // event
-  Err::Check(err, "unable to run OpenCL kernel " + ki_.kname);
+  {
+    // The arguments are captured when the kernel is enqueued, so another run may rebind them once this scope ends.
+    Lease instance{this};
+    instance->args.resize(params.size());
+    for (std::size_t i = 0; i < params.size(); ++i) {
+      Buffer* buf = Buffer::Downcast(params[i].get(), device_state_->cl_ctx());
+      VLOG(4) << "  Param: " << buf;
+      // A weak pointer keeps its control block alive, so a new buffer never matches a freed one.
+      auto& arg = instance->args[i];
+      if (arg.owner_before(params[i]) || params[i].owner_before(arg)) {
+        buf->SetKernelArg(instance->kernel, i);
+        arg = params[i];
+      }
+    }
+
+    auto local_work_size = ki_.lwork[0] ? ki_.lwork.data() : nullptr;
+    auto event_wait_list = deps.size() ? deps.data() : nullptr;
+    IVLOG(4, "Running kernel,  gwork = " << ki_.gwork << ", lwork = " << (local_work_size ? local_work_size[0] : 0));
+    Err err = ocl::EnqueueNDRangeKernel(queue.cl_queue.get(),   // command_queue
+                                        instance->kernel.get(),  // kernel
+                                        3,                       // work_dim
+                                        nullptr,                 // global_work_offset
+                                        ki_.gwork.data(),        // global_work_size
+                                        local_work_size,         // local_work_size
+                                        deps.size(),             // num_events_in_wait_list
+                                        event_wait_list,         // event_wait_list
+                                        done.LvaluePtr());       // event
+    Err::Check(err, "unable to run OpenCL kernel " + ki_.kname);
+  }
 
   VLOG(4) << "  Produced dep: " << done.get();
 
@@ -4,6 +4,7 @@
 
 #include <array>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -18,16 +19,42 @@ namespace opencl {
 
 class ComputeKernel final : public Kernel {
  public:
-  ComputeKernel(const std::shared_ptr<DeviceState>& device_state, CLObj<cl_kernel> kernel, const lang::KernelInfo& info,
-                context::proto::ActivityID kernel_id);
+  ComputeKernel(const std::shared_ptr<DeviceState>& device_state, CLObj<cl_program> program, CLObj<cl_kernel> kernel,
+                const lang::KernelInfo& info, context::proto::ActivityID kernel_id);
 
   std::shared_ptr<hal::Event> Run(const context::Context& ctx, const std::vector<std::shared_ptr<hal::Buffer>>& params,
                                   const std::vector<std::shared_ptr<hal::Event>>& dependencies,
                                   bool enable_profiling) final;
 
  private:
-  std::mutex mu_;
+  // A kernel object, along with the buffers last bound to its arguments.  Each run takes an instance to itself, so
+  // concurrent runs of the kernel don't contend for its argument state; arguments which are already bound to the
+  // right buffer aren't set again.
+  struct Instance {
+    CLObj<cl_kernel> kernel;
+    std::vector<std::weak_ptr<hal::Buffer>> args;
+  };
+
+  // Holds an instance for a run, returning it to the idle pool on scope exit, whether the run was enqueued or failed.
+  // A failed run leaves the instance's args recording exactly the arguments it did bind, so it's safe to reuse.
+  class Lease final {
+   public:
+    explicit Lease(ComputeKernel* owner) : owner_{owner}, instance_{owner->Acquire()} {}
+    ~Lease() { owner_->Release(std::move(instance_)); }
+    Instance* operator->() const { return instance_.get(); }
+
+   private:
+    ComputeKernel* owner_;
+    std::unique_ptr<Instance> instance_;
+  };
+
+  std::unique_ptr<Instance> Acquire();
+  void Release(std::unique_ptr<Instance> instance);
+
+  std::mutex mu_;  // Guards idle_
+  std::vector<std::unique_ptr<Instance>> idle_;
   std::shared_ptr<DeviceState> device_state_;
+  CLObj<cl_program> program_;
   CLObj<cl_kernel> kernel_;
   lang::KernelInfo ki_;
   context::proto::ActivityID kernel_id_;
@@ -7,6 +7,7 @@
 #include "base/util/compat.h"
 #include "tile/hal/opencl/compiler.h"
 #include "tile/hal/opencl/executor.h"
+#include "tile/hal/opencl/loader.h"
 
 namespace vertexai {
 namespace tile {
@@ -16,6 +17,7 @@ namespace opencl {
 Device::Device(const context::Context& ctx, const CLObj<cl_context>& cl_ctx, cl_device_id did, proto::DeviceInfo info)
     : device_state_{std::make_shared<DeviceState>(ctx, cl_ctx, did, std::move(info))},
       compiler_{std::make_unique<Compiler>(device_state_)},
+      loader_{std::make_unique<Loader>(device_state_)},
       executor_{std::make_unique<Executor>(device_state_)} {}
 
 void Device::Initialize(const hal::proto::HardwareSettings& settings) { device_state_->Initialize(settings); }
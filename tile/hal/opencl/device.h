@@ -29,7 +29,7 @@ class Device final : public hal::Device {
 
   hal::Compiler* compiler() final { return compiler_.get(); }
 
-  hal::Loader* loader() final { return nullptr; /* TODO: Support offline compilation */ }
+  hal::Loader* loader() final { return loader_.get(); }
 
   const std::unordered_map<std::string, std::unique_ptr<hal::Loader>>& il_loader_map() final { return il_loader_map_; }
 
@@ -40,6 +40,7 @@ class Device final : public hal::Device {
  private:
   const std::shared_ptr<DeviceState> device_state_;
   const std::unique_ptr<hal::Compiler> compiler_;
+  const std::unique_ptr<hal::Loader> loader_;
   const std::unordered_map<std::string, std::unique_ptr<hal::Loader>> il_loader_map_;
   const std::unique_ptr<hal::Executor> executor_;
 };
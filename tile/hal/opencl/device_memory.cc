@@ -18,7 +18,7 @@ std::shared_ptr<hal::Buffer> DeviceMemory::MakeBuffer(std::uint64_t size, Buffer
   Err err;
   CLObj<cl_mem> mem = ocl::CreateBuffer(device_state_->cl_ctx().get(), CL_MEM_READ_WRITE, size, nullptr, err.ptr());
   Err::Check(err, "Unable to allocate device-local memory");
-  return std::make_shared<CLMemBuffer>(device_state_, size, std::move(mem));
+  return std::make_shared<CLMemBuffer>(device_state_, size, std::move(mem), device_state_->staging_pool());
 }
 
 std::shared_ptr<hal::Arena> DeviceMemory::MakeArena(std::uint64_t size, BufferAccessMask /* access */) {
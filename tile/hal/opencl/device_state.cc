@@ -2,12 +2,15 @@
 
 #include "tile/hal/opencl/device_state.h"
 
+#include <ratio>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "base/util/env.h"
 #include "base/util/error.h"
 #include "tile/hal/opencl/info.h"
+#include "tile/hal/opencl/staging_pool.h"
 #include "tile/hal/util/selector.h"
 
 namespace vertexai {
@@ -16,6 +19,9 @@ namespace hal {
 namespace opencl {
 namespace {
 
+// The most pinned host memory to use for staging uploads.
+constexpr std::uint64_t kMaxStagingBytes = 256 * std::mega::num;
+
 DeviceState::Queue MakeQueue(cl_device_id did, const CLObj<cl_context>& cl_ctx,
                              const hal::proto::HardwareSettings& settings,
                              cl_command_queue_properties extra_properties = 0) {
@@ -52,11 +58,30 @@ DeviceState::DeviceState(const context::Context& ctx, const CLObj<cl_context>& c
 void DeviceState::Initialize(const hal::proto::HardwareSettings& settings) {
   cl_normal_queue_ = std::make_unique<Queue>(MakeQueue(did_, cl_ctx_, settings));
   cl_profiling_queue_ = std::make_unique<Queue>(MakeQueue(did_, cl_ctx_, settings, CL_QUEUE_PROFILING_ENABLE));
+  cl_transfer_queue_ = std::make_unique<Queue>(MakeQueue(did_, cl_ctx_, settings));
+  cl_lanes_.clear();
+  cl_lanes_.emplace_back(nullptr);
+  auto lanes = env::Get("PLAIDML_OPENCL_QUEUES");
+  if (!settings.is_synchronous() && !(cl_normal_queue_->props & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE) &&
+      !lanes.empty()) {
+    // Without out-of-order execution, independent kernels can only overlap
+    // by running on separate queues.
+    for (std::size_t idx = 1; idx < std::stoull(lanes); ++idx) {
+      cl_lanes_.emplace_back(std::make_unique<Queue>(MakeQueue(did_, cl_ctx_, settings)));
+    }
+  }
+  if (!settings.is_synchronous() && !info_.host_unified_memory()) {
+    staging_pool_ = std::make_shared<StagingPool>(cl_ctx_, cl_transfer_queue_->cl_queue, kMaxStagingBytes);
+  }
 }
 
 void DeviceState::FlushCommandQueue() {
   cl_normal_queue_->Flush();
   cl_profiling_queue_->Flush();
+  cl_transfer_queue_->Flush();
+  for (std::size_t idx = 1; idx < cl_lanes_.size(); ++idx) {
+    cl_lanes_[idx]->Flush();
+  }
 }
 
 bool DeviceState::HasDeviceExtension(const char* extension) {
@@ -2,7 +2,9 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
+#include <vector>
 
 #include "base/context/context.h"
 #include "tile/hal/opencl/ocl.h"
@@ -14,6 +16,8 @@ namespace tile {
 namespace hal {
 namespace opencl {
 
+class StagingPool;
+
 // DeviceState represents the state of a device, including all OpenCL objects needed to control the device.
 class DeviceState {
  public:
@@ -39,6 +43,15 @@ class DeviceState {
     }
     return cl_normal_queue();
   }
+  // The in-order queues kernels may be spread across; the first is the normal
+  // queue.  There is only one lane if the normal queue executes out of order.
+  std::size_t lane_count() const { return cl_lanes_.size(); }
+  const Queue& cl_lane(std::size_t idx) const { return idx ? *cl_lanes_[idx] : cl_normal_queue(); }
+  std::size_t NextLane() const { return next_lane_++ % cl_lanes_.size(); }
+  // The queue used for staged uploads, so they can overlap kernels.
+  const Queue& cl_transfer_queue() const { return *cl_transfer_queue_; }
+  // Null unless device-local buffers should stage their uploads.
+  const std::shared_ptr<StagingPool>& staging_pool() const { return staging_pool_; }
   const context::Clock& clock() const { return clock_; }
   const context::proto::ActivityID& id() const { return id_; }
 
@@ -54,6 +67,10 @@ class DeviceState {
   const CLObj<cl_context> cl_ctx_;
   std::unique_ptr<const Queue> cl_normal_queue_;
   std::unique_ptr<const Queue> cl_profiling_queue_;
+  std::unique_ptr<const Queue> cl_transfer_queue_;
+  std::vector<std::unique_ptr<const Queue>> cl_lanes_;  // cl_lanes_[0] is unused; lane 0 is the normal queue
+  mutable std::atomic<std::size_t> next_lane_{0};
+  std::shared_ptr<StagingPool> staging_pool_;
   const context::Clock clock_;
   const context::proto::ActivityID id_;
 };
@@ -17,7 +17,8 @@ namespace hal {
 namespace opencl {
 
 static std::map<std::string, std::string> FuncNameMap = {
-    {"recip", "native_recip"}, {"exp", "native_exp"}, {"log", "native_log"}, {"sqrt", "native_sqrt"}};
+    {"recip", "native_recip"}, {"exp", "native_exp"}, {"log", "native_log"}, {"sqrt", "native_sqrt"},
+    {"sub_group_shuffle_xor", "intel_sub_group_shuffle_xor"}};
 
 void Emit::Visit(const sem::LoadExpr& n) {
   auto ty = TypeOf(n.inner);
@@ -186,7 +187,18 @@ void Emit::Visit(const sem::ClampExpr& n) {
   emit(")");
 }
 
-void Emit::Visit(const sem::CastExpr& n) { n.val->Accept(*this); }
+void Emit::Visit(const sem::CastExpr& n) {
+  if (cl_khr_fp16_ && n.type.dtype == DataType::FLOAT16 && std::dynamic_pointer_cast<sem::FloatConst>(n.val)) {
+    // Float literals are single precision; narrow them so that the arithmetic stays in half.
+    emit("((");
+    EmitC::emitType(n.type);
+    emit(")");
+    n.val->Accept(*this);
+    emit(")");
+    return;
+  }
+  n.val->Accept(*this);
+}
 
 void Emit::Visit(const sem::CallExpr& n) {
   switch (n.function) {
@@ -276,7 +288,9 @@ void Emit::Visit(const sem::ForStmt& n) {
 void Emit::Visit(const sem::BarrierStmt& n) {
   emitTab();
   if (n.subgroup) {
-    // emit("sub_group_barrier(CLK_LOCAL_MEM_FENCE | CLK_GLOBAL_MEM_FENCE);\n");
+    if (cl_intel_subgroups_) {
+      emit("sub_group_barrier(CLK_LOCAL_MEM_FENCE);\n");
+    }
   } else {
     emit("barrier(CLK_LOCAL_MEM_FENCE);\n");
   }
@@ -15,8 +15,11 @@ namespace opencl {
 
 class Emit : public lang::EmitC {
  public:
-  explicit Emit(bool cl_khr_fp16, bool cl_khr_fp64)
-      : cl_khr_fp16_{cl_khr_fp16}, cl_khr_fp64_{cl_khr_fp64}, scope_{nullptr} {}
+  Emit(bool cl_khr_fp16, bool cl_khr_fp64, bool cl_intel_subgroups = false)
+      : cl_khr_fp16_{cl_khr_fp16},
+        cl_khr_fp64_{cl_khr_fp64},
+        cl_intel_subgroups_{cl_intel_subgroups},
+        scope_{nullptr} {}
 
   void Visit(const sem::LoadExpr&) final;
   void Visit(const sem::StoreStmt&) final;
@@ -45,6 +48,7 @@ class Emit : public lang::EmitC {
 
   bool cl_khr_fp16_;
   bool cl_khr_fp64_;
+  bool cl_intel_subgroups_;
   lang::Scope<sem::Type>* scope_;
 };
 
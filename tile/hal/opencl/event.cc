@@ -38,6 +38,34 @@ std::vector<cl_event> Event::Downcast(const std::vector<std::shared_ptr<hal::Eve
   return result;
 }
 
+const DeviceState::Queue& Event::PickQueue(const std::vector<std::shared_ptr<hal::Event>>& events,
+                                           const DeviceState& device_state, bool enable_profiling) {
+  if (enable_profiling) {
+    return device_state.cl_profiling_queue();
+  }
+  if (device_state.lane_count() == 1) {
+    return device_state.cl_normal_queue();
+  }
+  for (const auto& event : events) {
+    auto evt = Downcast(event, device_state.cl_ctx());
+    if (!evt->cl_event_) {
+      continue;
+    }
+    {
+      std::lock_guard<std::mutex> lock{evt->state_->mu};
+      if (evt->state_->completed) {
+        continue;
+      }
+    }
+    for (std::size_t idx = 0; idx < device_state.lane_count(); ++idx) {
+      if (evt->queue_ == &device_state.cl_lane(idx)) {
+        return *evt->queue_;
+      }
+    }
+  }
+  return device_state.cl_lane(device_state.NextLane());
+}
+
 boost::future<std::vector<std::shared_ptr<hal::Result>>> Event::WaitFor(
     const std::vector<std::shared_ptr<hal::Event>>& events, const std::shared_ptr<DeviceState>& device_state) {
   std::vector<cl_event> mdeps;
@@ -109,46 +137,62 @@ boost::shared_future<std::shared_ptr<hal::Result>> Event::GetFuture() {
   if (!cl_event_) {
     return boost::make_ready_future(state_->result);
   }
+  Start();
+  return fut_;
+}
 
-  if (!started_) {
-    {
-      // Technically, we don't need to hold this lock while accessing
-      // state_->self, since there's no way we can access it unsafely
-      // -- but it's nice to be explicit and careful with our
-      // synchronization.
-      std::lock_guard<std::mutex> lock{state_->mu};
-      if (!fut_.valid()) {
-        fut_ = state_->prom.get_future().share();
+void Event::OnComplete(CompletionCallback callback) {
+  {
+    std::lock_guard<std::mutex> lock{mu_};
+    if (cl_event_) {
+      {
+        std::lock_guard<std::mutex> state_lock{state_->mu};
+        if (!state_->completed) {
+          state_->waiters.emplace_back(std::move(callback));
+          callback = nullptr;
+        }
+      }
+      if (!callback) {
+        Start();
+        return;
       }
-      state_->self = state_;
     }
+  }
+  callback(state_->result, state_->error);
+}
 
-    try {
-      Err err = ocl::SetEventCallback(cl_event_.get(), CL_COMPLETE, &EventComplete, state_.get());
-      Err::Check(err, "Unable to register an event callback");
-    } catch (...) {
-      std::lock_guard<std::mutex> lock{state_->mu};
-      state_->self.reset();
-      throw;
+void Event::Start() {
+  if (started_) {
+    return;
+  }
+  {
+    // Technically, we don't need to hold this lock while accessing
+    // state_->self, since there's no way we can access it unsafely
+    // -- but it's nice to be explicit and careful with our
+    // synchronization.
+    std::lock_guard<std::mutex> lock{state_->mu};
+    if (!fut_.valid()) {
+      fut_ = state_->prom.get_future().share();
     }
+    state_->self = state_;
+  }
 
-    started_ = true;
+  try {
+    Err err = ocl::SetEventCallback(cl_event_.get(), CL_COMPLETE, &EventComplete, state_.get());
+    Err::Check(err, "Unable to register an event callback");
+  } catch (...) {
+    std::lock_guard<std::mutex> lock{state_->mu};
+    state_->self.reset();
+    throw;
   }
 
-  return fut_;
+  started_ = true;
 }
 
 void Event::EventComplete(cl_event evt, cl_int status, void* data) {
   auto state = static_cast<FutureState*>(data);
 
-  std::shared_ptr<FutureState> self_ref;
-
-  {
-    std::lock_guard<std::mutex> lock{state->mu};
-    state->completed = true;
-    self_ref = std::move(state->self);
-  }
-
+  boost::exception_ptr error;
   try {
     if (status < 0) {
       Err err(status);
@@ -157,9 +201,28 @@ void Event::EventComplete(cl_event evt, cl_int status, void* data) {
       LOG(ERROR) << "Event " << EventCommandTypeStr(type) << " failed with: " << err.str();
       Err::Check(err, "Event completed with failure");
     }
-    state->prom.set_value(state->result);
   } catch (...) {
-    state->prom.set_exception(boost::current_exception());
+    error = boost::current_exception();
+  }
+
+  std::shared_ptr<FutureState> self_ref;
+  std::vector<CompletionCallback> waiters;
+
+  {
+    std::lock_guard<std::mutex> lock{state->mu};
+    state->completed = true;
+    state->error = error;
+    self_ref = std::move(state->self);
+    waiters.swap(state->waiters);
+  }
+
+  if (error) {
+    state->prom.set_exception(error);
+  } else {
+    state->prom.set_value(state->result);
+  }
+  for (auto& waiter : waiters) {
+    waiter(state->result, error);
   }
 
   // N.B. state may be deleted as we leave this context.
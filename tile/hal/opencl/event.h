@@ -31,6 +31,14 @@ class Event final : public hal::Event {
   static std::vector<cl_event> Downcast(const std::vector<std::shared_ptr<hal::Event>>& events,
                                         const CLObj<cl_context>& cl_ctx, const DeviceState::Queue& queue);
 
+  // Chooses the queue for a kernel launch with the supplied dependencies.
+  // Profiled launches use the profiling queue.  Otherwise, a launch continues
+  // the lane of its first pending dependency -- so chains of dependent kernels
+  // stay on one in-order queue and need no cross-queue waits -- and
+  // independent launches are dealt round-robin across the device's lanes.
+  static const DeviceState::Queue& PickQueue(const std::vector<std::shared_ptr<hal::Event>>& events,
+                                             const DeviceState& device_state, bool enable_profiling);
+
   // Returns a future that waits for all of the supplied events to complete.
   static boost::future<std::vector<std::shared_ptr<hal::Result>>> WaitFor(
       const std::vector<std::shared_ptr<hal::Event>>& events, const std::shared_ptr<DeviceState>& device_state);
@@ -45,15 +53,22 @@ class Event final : public hal::Event {
 
   boost::shared_future<std::shared_ptr<hal::Result>> GetFuture() final;
 
+  void OnComplete(CompletionCallback callback) final;
+
  private:
   struct FutureState {
     std::mutex mu;
     bool completed = false;
     std::shared_ptr<FutureState> self;  // Set iff clSetEventCallback is in flight
     std::shared_ptr<hal::Result> result;
+    boost::exception_ptr error;               // Set on failure, once completed
+    std::vector<CompletionCallback> waiters;  // Invoked on completion
     boost::promise<std::shared_ptr<hal::Result>> prom;
   };
 
+  // Registers the OpenCL completion callback, if that hasn't already been done.  mu_ must be held.
+  void Start();
+
   static void EventComplete(cl_event evt, cl_int status, void* data);
 
   const DeviceState::Queue* queue_;
@@ -161,13 +161,14 @@ boost::future<std::unique_ptr<hal::Executable>> Executor::Prepare(hal::Library*
 
     Err err;
     std::string kname = kinfo.kname;
-    CLObj<cl_kernel> kernel = ocl::CreateKernel(exe->program().at(kname).get(), kname.c_str(), err.ptr());
+    const auto& program = exe->program().at(kname);
+    CLObj<cl_kernel> kernel = ocl::CreateKernel(program.get(), kname.c_str(), err.ptr());
     if (!kernel) {
       throw std::runtime_error(std::string("Unable to initialize OpenCL kernel: ") + err.str());
     }
 
     kernels.emplace_back(
-        std::make_unique<ComputeKernel>(device_state_, std::move(kernel), exe->kernel_info()[kidx], kid));
+        std::make_unique<ComputeKernel>(device_state_, program, std::move(kernel), exe->kernel_info()[kidx], kid));
   }
 
   return boost::make_ready_future(std::unique_ptr<hal::Executable>(std::make_unique<Executable>(std::move(kernels))));
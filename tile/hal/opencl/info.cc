@@ -68,6 +68,10 @@ hal::proto::HardwareInfo GetHardwareInfo(const proto::DeviceInfo& info) {
   // Maximum local memory
   settings->set_max_mem(info.local_mem_size());
 
+  // Global memory cache and compute units, from which stripe configs may derive their limits
+  settings->set_cache_size(info.global_mem_cache_size());
+  settings->set_compute_units(info.max_compute_units());
+
   // Maximum register size
   settings->set_max_regs(16 * 1024);
 
@@ -91,6 +95,23 @@ hal::proto::HardwareInfo GetHardwareInfo(const proto::DeviceInfo& info) {
   // Enable input/output buffer aliasing by default.  This may be overridden.
   settings->set_disable_io_aliasing(false);
 
+  // Compute half-precision kernels in half precision where the device can.
+  settings->set_native_half(std::count(info.extension().begin(), info.extension().end(), "cl_khr_fp16") != 0);
+
+  // Use subgroup shuffles for reductions on devices which support them.  Every
+  // Intel GPU supports a subgroup size of eight.
+  if (vendor == "Intel" && info.type() == hal::proto::HardwareType::GPU &&
+      std::count(info.extension().begin(), info.extension().end(), "cl_intel_subgroups")) {
+    settings->set_subgroup_size(8);
+  }
+
+  // Estimate peak compute for Intel GPUs, whose compute units are EUs issuing
+  // two SIMD-4 FMAs (sixteen flops) per clock.  Bandwidth isn't reported by
+  // OpenCL; it may be supplied as an override.
+  if (vendor == "Intel" && info.type() == hal::proto::HardwareType::GPU) {
+    settings->set_peak_gflops(info.max_compute_units() * 16.0 * info.max_clock_frequency_mhz() / 1000);
+  }
+
   return result;
 }
 
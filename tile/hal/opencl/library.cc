@@ -5,6 +5,7 @@
 #include <utility>
 
 #include "base/util/error.h"
+#include "tile/hal/opencl/binary_cache.h"
 #include "tile/hal/opencl/ocl.h"
 
 namespace vertexai {
@@ -30,19 +31,24 @@ Library::Library(const std::shared_ptr<DeviceState>& device_state, const std::ma
 std::map<std::string, std::string> Library::Serialize() {
   std::map<std::string, std::string> result;
   for (auto& prog_it : program_) {
-    std::size_t size;
-    Err::Check(ocl::GetProgramInfo(prog_it.second.get(), CL_PROGRAM_BINARY_SIZES, sizeof(size), &size, nullptr),
-               "Unable to compute binary size for " + prog_it.first);
-    std::string prog_str;
-    prog_str.resize(size);
-    const char* datum = prog_str.data();
-    Err::Check(ocl::GetProgramInfo(prog_it.second.get(), CL_PROGRAM_BINARIES, sizeof(datum), &datum, nullptr),
-               "Unable to serialize binary for " + prog_it.first);
-    result.emplace(prog_it.first, prog_str);
+    result.emplace(prog_it.first, GetProgramBinary(prog_it.second.get(), prog_it.first));
   }
   return result;
 }
 
+void Library::Replace(const std::string& kname, CLObj<cl_program> program, const lang::KernelInfo& retuned) {
+  program_[kname] = std::move(program);
+  for (auto& ki : kernel_info_) {
+    if (ki.kname != kname) {
+      continue;
+    }
+    ki.kfunc = retuned.kfunc;
+    ki.gwork = retuned.gwork;
+    ki.lwork = retuned.lwork;
+    ki.settings = retuned.settings;
+  }
+}
+
 }  // namespace opencl
 }  // namespace hal
 }  // namespace tile
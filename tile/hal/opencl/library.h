@@ -25,6 +25,9 @@ class Library final : public hal::Library {
 
   std::map<std::string, std::string> Serialize() final;
 
+  // Replaces the program for kname with one built from a retuned version of the kernel, adopting its launch dimensions.
+  void Replace(const std::string& kname, CLObj<cl_program> program, const lang::KernelInfo& retuned);
+
   const std::shared_ptr<DeviceState>& device_state() const { return device_state_; }
   const std::map<std::string, CLObj<cl_program>>& program() const { return program_; }
   const std::vector<lang::KernelInfo>& kernel_info() const { return kernel_info_; }
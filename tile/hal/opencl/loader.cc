@@ -0,0 +1,54 @@
+// Copyright 2019, Intel Corp.
+
+#include "tile/hal/opencl/loader.h"
+
+#include <map>
+#include <utility>
+
+#include "tile/hal/opencl/binary_cache.h"
+#include "tile/hal/opencl/library.h"
+#include "tile/hal/opencl/occupancy.h"
+
+namespace vertexai {
+namespace tile {
+namespace hal {
+namespace opencl {
+
+Loader::Loader(const std::shared_ptr<DeviceState>& device_state) : device_state_{device_state} {}
+
+boost::future<std::unique_ptr<hal::Library>> Loader::Deserialize(
+    const context::Context& ctx, const std::map<std::string, std::string>& serialized_executable,
+    const std::vector<lang::KernelInfo>& info) {
+  context::Activity activity{ctx, "tile::hal::opencl::Load"};
+  std::map<std::string, CLObj<cl_program>> program_map;
+  std::vector<context::proto::ActivityID> kernel_ids;
+  // Kernels retuned when they were built require a different workgroup size than the one they were generated with.
+  std::vector<lang::KernelInfo> kernel_info{info};
+  for (auto& ki : kernel_info) {
+    context::Activity kload{activity.ctx(), "tile::hal::opencl::LoadKernel"};
+    if (ki.ktype != lang::KernelType::kZero && !program_map.count(ki.kname)) {
+      auto it = serialized_executable.find(ki.kname);
+      if (it == serialized_executable.end()) {
+        throw std::runtime_error{"Missing OpenCL program binary for " + ki.kname};
+      }
+      CLObj<cl_program> program = LoadProgramBinary(*device_state_, it->second);
+      if (!program) {
+        throw std::runtime_error{"Unable to load the OpenCL program binary for " + ki.kname};
+      }
+      program_map.emplace(ki.kname, std::move(program));
+    }
+    KernelUsage usage;
+    if (ki.ktype != lang::KernelType::kZero &&
+        QueryKernelUsage(*device_state_, program_map.at(ki.kname).get(), ki.kname, &usage)) {
+      ApplyCompileWorkGroupSize(usage, &ki);
+    }
+    kernel_ids.emplace_back(kload.ctx().activity_id());
+  }
+  return boost::make_ready_future(std::unique_ptr<hal::Library>{
+      std::make_unique<Library>(device_state_, std::move(program_map), kernel_info, std::move(kernel_ids))});
+}
+
+}  // namespace opencl
+}  // namespace hal
+}  // namespace tile
+}  // namespace vertexai
@@ -0,0 +1,36 @@
+// Copyright 2019, Intel Corp.
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tile/base/hal.h"
+#include "tile/hal/opencl/device_state.h"
+
+namespace vertexai {
+namespace tile {
+namespace hal {
+namespace opencl {
+
+// Loads libraries from OpenCL program binaries, as produced by
+// Library::Serialize.  The serialized executable is a single program binary
+// defining every (non-zero) kernel in the supplied kernel info.
+class Loader final : public hal::Loader {
+ public:
+  explicit Loader(const std::shared_ptr<DeviceState>& device_state);
+
+  boost::future<std::unique_ptr<hal::Library>> Deserialize(
+      const context::Context& ctx, const std::map<std::string, std::string>& serialized_executable,
+      const std::vector<lang::KernelInfo>& info) final;
+
+ private:
+  std::shared_ptr<DeviceState> device_state_;
+};
+
+}  // namespace opencl
+}  // namespace hal
+}  // namespace tile
+}  // namespace vertexai
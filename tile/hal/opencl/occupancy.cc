@@ -0,0 +1,66 @@
+// Copyright 2019, Intel Corp.
+
+#include "tile/hal/opencl/occupancy.h"
+
+#include <algorithm>
+
+#include "base/util/logging.h"
+
+namespace vertexai {
+namespace tile {
+namespace hal {
+namespace opencl {
+
+bool QueryKernelUsage(const DeviceState& device_state, cl_program program, const std::string& kname,
+                      KernelUsage* usage) {
+  Err err;
+  CLObj<cl_kernel> kernel = ocl::CreateKernel(program, kname.c_str(), err.ptr());
+  if (!kernel) {
+    IVLOG(1, "Unable to create kernel " << kname << " to query its usage: " << err.str());
+    return false;
+  }
+  size_t compile_sizes[3] = {0, 0, 0};
+  if (ocl::GetKernelWorkGroupInfo(kernel.get(), device_state.did(), CL_KERNEL_WORK_GROUP_SIZE,
+                                  sizeof(usage->max_work_group_size), &usage->max_work_group_size, nullptr) ||
+      ocl::GetKernelWorkGroupInfo(kernel.get(), device_state.did(), CL_KERNEL_LOCAL_MEM_SIZE,
+                                  sizeof(usage->local_mem_size), &usage->local_mem_size, nullptr) ||
+      ocl::GetKernelWorkGroupInfo(kernel.get(), device_state.did(), CL_KERNEL_COMPILE_WORK_GROUP_SIZE,
+                                  sizeof(compile_sizes), compile_sizes, nullptr)) {
+    IVLOG(1, "Unable to query the usage of kernel " << kname);
+    return false;
+  }
+  usage->compile_work_group_size = compile_sizes[0];
+  return true;
+}
+
+double EstimateOccupancy(const proto::DeviceInfo& info, const KernelUsage& usage, size_t threads) {
+  if (!threads || threads > usage.max_work_group_size) {
+    return 0;
+  }
+  size_t capacity = info.max_work_group_size();
+  if (!capacity) {
+    return 1;
+  }
+  // The register file bounds the threads resident at once, and local memory the workgroups.
+  size_t limit = std::min<size_t>(capacity, usage.max_work_group_size);
+  size_t groups = std::max<size_t>(1, limit / threads);
+  if (usage.local_mem_size) {
+    groups = std::min<size_t>(groups, std::max<uint64_t>(1, info.local_mem_size() / usage.local_mem_size));
+  }
+  return std::min(1.0, static_cast<double>(groups * threads) / capacity);
+}
+
+void ApplyCompileWorkGroupSize(const KernelUsage& usage, lang::KernelInfo* ki) {
+  size_t threads = usage.compile_work_group_size;
+  if (!threads || !ki->lwork[0] || threads == ki->lwork[0]) {
+    return;
+  }
+  IVLOG(2, "Kernel " << ki->kname << " was built for " << threads << " threads, not " << ki->lwork[0]);
+  ki->gwork[0] = ki->gwork[0] / ki->lwork[0] * threads;
+  ki->lwork[0] = threads;
+}
+
+}  // namespace opencl
+}  // namespace hal
+}  // namespace tile
+}  // namespace vertexai
@@ -0,0 +1,40 @@
+// Copyright 2019, Intel Corp.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "tile/hal/opencl/device_state.h"
+#include "tile/hal/opencl/ocl.h"
+#include "tile/lang/generate.h"
+
+namespace vertexai {
+namespace tile {
+namespace hal {
+namespace opencl {
+
+// The resources a built kernel uses, as reported by the driver.
+struct KernelUsage {
+  size_t max_work_group_size = 0;      // CL_KERNEL_WORK_GROUP_SIZE; reflects the kernel's register use
+  uint64_t local_mem_size = 0;         // CL_KERNEL_LOCAL_MEM_SIZE
+  size_t compile_work_group_size = 0;  // The first dimension of CL_KERNEL_COMPILE_WORK_GROUP_SIZE, if required
+};
+
+// Queries the usage of the kernel kname in a built program; returns false if the kernel can't be created.
+bool QueryKernelUsage(const DeviceState& device_state, cl_program program, const std::string& kname,
+                      KernelUsage* usage);
+
+// Estimates the fraction of a compute unit's threads which workgroups of the given size keep resident, taking the
+// kernel's register and local memory use into account.  Zero means the kernel can't launch with that many threads.
+double EstimateOccupancy(const proto::DeviceInfo& info, const KernelUsage& usage, size_t threads);
+
+// Kernels retuned after building require their workgroup size, so a program loaded from a binary can recover its
+// launch dimensions; this adjusts ki to match.
+void ApplyCompileWorkGroupSize(const KernelUsage& usage, lang::KernelInfo* ki);
+
+}  // namespace opencl
+}  // namespace hal
+}  // namespace tile
+}  // namespace vertexai
@@ -7,8 +7,8 @@
 #include <utility>
 
 #include "base/util/compat.h"
-#include "base/util/env.h"
 #include "base/util/error.h"
+#include "base/util/runtime_options.h"
 #include "tile/lang/semprinter.h"
 
 namespace vertexai {
@@ -112,7 +112,7 @@ void KernelResult::LogStatistics() const {
       // Prevent division by 0
       duration = 1;
     }
-    if (env::Get("PLAIDML_DUMP_TIMES") == "1") {
+    if (RuntimeOptions::Get().dump_times) {
       std::string rcom = ki_.comments;
       if (rcom.size() > 2 && rcom[0] == '/' && rcom[1] == '/') {
         rcom = rcom.substr(2, rcom.size() - 2);
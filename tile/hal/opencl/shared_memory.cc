@@ -1,6 +1,9 @@
 // Copyright 2017-2018 Intel Corporation.
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
+#include <memory>
 #include <mutex>
 #include <vector>
 
@@ -9,6 +12,7 @@
 #include "base/util/logging.h"
 #include "tile/base/hal.h"
 #include "tile/hal/opencl/buffer.h"
+#include "tile/hal/opencl/cl_mem_buffer.h"
 #include "tile/hal/opencl/device_state.h"
 #include "tile/hal/opencl/event.h"
 #include "tile/hal/opencl/executor.h"
@@ -20,6 +24,15 @@ namespace hal {
 namespace opencl {
 namespace {
 
+// Small buffers are carved out of SVM chunks of this size, so that clSVMAlloc
+// (and the lock around it) is only needed once per chunk.
+constexpr std::uint64_t kChunkBytes = 64 * std::mega::num;
+
+// Wrapped host memory must be page-aligned (and, for CL_MEM_USE_HOST_PTR, a
+// whole number of cache lines) for the runtime to use it without copying.
+constexpr std::uintptr_t kHostPtrAlignment = 4096;
+constexpr std::uint64_t kHostSizeAlignment = 64;
+
 // Class declarations
 
 class SharedArena final : public Arena, public std::enable_shared_from_this<SharedArena> {
@@ -29,7 +42,9 @@ class SharedArena final : public Arena, public std::enable_shared_from_this<Shar
 
   std::shared_ptr<hal::Buffer> MakeBuffer(std::uint64_t offset, std::uint64_t size) final;
 
-  const std::shared_ptr<DeviceState> device_state() const { return device_state_; }
+  // Reserves the next aligned range of the arena without locking, returning
+  // nullptr once the arena is exhausted.
+  void* Carve(std::uint64_t size, std::uint64_t alignment);
 
  private:
   // A lock to guard clSVMAlloc/clSVMFree calls.  This shouldn't be necessary, but
@@ -39,11 +54,14 @@ class SharedArena final : public Arena, public std::enable_shared_from_this<Shar
   const std::shared_ptr<DeviceState> device_state_;
   void* base_ = nullptr;
   std::uint64_t size_;
+  std::atomic<std::uint64_t> next_{0};
 };
 
 class SharedBuffer final : public Buffer {
  public:
-  SharedBuffer(std::shared_ptr<SharedArena> arena, void* base, std::uint64_t size);
+  // The arena keeps the buffer's memory alive; it is null for wrapped host memory, which the caller owns.
+  SharedBuffer(std::shared_ptr<DeviceState> device_state, std::shared_ptr<SharedArena> arena, void* base,
+               std::uint64_t size);
 
   void SetKernelArg(const CLObj<cl_kernel>& kernel, std::size_t index) final;
 
@@ -54,6 +72,7 @@ class SharedBuffer final : public Buffer {
   void* base() const final { return base_; }
 
  private:
+  std::shared_ptr<DeviceState> device_state_;
   std::shared_ptr<SharedArena> arena_;
   void* base_ = nullptr;
 };
@@ -75,8 +94,12 @@ class SharedMemory final : public Memory {
 
   std::shared_ptr<hal::Arena> MakeArena(std::uint64_t size, BufferAccessMask access) final;
 
+  std::shared_ptr<hal::Buffer> WrapBuffer(void* base, std::uint64_t size, BufferAccessMask access) final;
+
  private:
   std::shared_ptr<DeviceState> device_state_;
+  bool system_svm_ = false;
+  std::shared_ptr<SharedArena> chunk_;  // Only accessed via std::atomic_* functions
 };
 
 // SharedArena implementation
@@ -104,13 +127,29 @@ std::shared_ptr<hal::Buffer> SharedArena::MakeBuffer(std::uint64_t offset, std::
     throw error::OutOfRange{"Requesting memory outside arena bounds"};
   }
 
-  return std::make_shared<SharedBuffer>(shared_from_this(), static_cast<char*>(base_) + offset, size);
+  return std::make_shared<SharedBuffer>(device_state_, shared_from_this(), static_cast<char*>(base_) + offset, size);
+}
+
+void* SharedArena::Carve(std::uint64_t size, std::uint64_t alignment) {
+  std::uint64_t offset = next_.load();
+  std::uint64_t aligned;
+  do {
+    aligned = (offset + alignment - 1) / alignment * alignment;
+    if (size_ < aligned || size_ - aligned < size) {
+      return nullptr;
+    }
+  } while (!next_.compare_exchange_weak(offset, aligned + size));
+  return static_cast<char*>(base_) + aligned;
 }
 
 // SharedBuffer implementation
 
-SharedBuffer::SharedBuffer(std::shared_ptr<SharedArena> arena, void* base, std::uint64_t size)
-    : Buffer{arena->device_state()->cl_ctx(), size}, arena_{std::move(arena)}, base_{base} {}
+SharedBuffer::SharedBuffer(std::shared_ptr<DeviceState> device_state, std::shared_ptr<SharedArena> arena, void* base,
+                           std::uint64_t size)
+    : Buffer{device_state->cl_ctx(), size},
+      device_state_{std::move(device_state)},
+      arena_{std::move(arena)},
+      base_{base} {}
 
 void SharedBuffer::SetKernelArg(const CLObj<cl_kernel>& kernel, std::size_t index) {
   Err::Check(ocl::SetKernelArgSVMPointer(kernel.get(), index, base_), "Unable to set a kernel SVM pointer");
@@ -118,7 +157,7 @@ void SharedBuffer::SetKernelArg(const CLObj<cl_kernel>& kernel, std::size_t inde
 
 boost::future<void*> SharedBuffer::MapCurrent(const std::vector<std::shared_ptr<hal::Event>>& deps) {
   VLOG(4) << "OCL SharedBuffer MapCurrent: waiting this: " << this;
-  return Event::WaitFor(deps, arena_->device_state())
+  return Event::WaitFor(deps, device_state_)
       .then([this, base = base_](boost::shared_future<std::vector<std::shared_ptr<hal::Result>>> f) {
         VLOG(4) << "OCL SharedBuffer MapCurrent: complete this: " << this;
         f.get();
@@ -133,22 +172,69 @@ boost::future<void*> SharedBuffer::MapDiscard(const std::vector<std::shared_ptr<
 }
 
 std::shared_ptr<hal::Event> SharedBuffer::Unmap(const context::Context& ctx) {
-  return std::make_shared<Event>(ctx, arena_->device_state(), CLObj<cl_event>(),
-                                 arena_->device_state()->cl_normal_queue());
+  return std::make_shared<Event>(ctx, device_state_, CLObj<cl_event>(), device_state_->cl_normal_queue());
 }
 
 // SharedMemory implementation
 
-SharedMemory::SharedMemory(const std::shared_ptr<DeviceState>& device_state) : device_state_{device_state} {}
+SharedMemory::SharedMemory(const std::shared_ptr<DeviceState>& device_state) : device_state_{device_state} {
+  for (auto cap : device_state_->info().svm_capability()) {
+    if (cap == proto::SvmCapability::FineGrainSystem) {
+      system_svm_ = true;
+    }
+  }
+}
 
 std::shared_ptr<hal::Buffer> SharedMemory::MakeBuffer(std::uint64_t size, BufferAccessMask access) {
-  return MakeArena(size, access)->MakeBuffer(0, size);
+  if (kChunkBytes / 4 < size) {
+    return MakeArena(size, access)->MakeBuffer(0, size);
+  }
+  std::uint64_t alignment = std::max<std::uint64_t>(ArenaBufferAlignment(), 1);
+  auto chunk = std::atomic_load(&chunk_);
+  for (;;) {
+    if (chunk) {
+      void* base = chunk->Carve(size, alignment);
+      if (base) {
+        return std::make_shared<SharedBuffer>(device_state_, chunk, base, size);
+      }
+    }
+    // The current chunk is exhausted; it stays alive until its last buffer is
+    // released.  If another thread installs a fresh chunk first, ours is
+    // simply dropped and we carve from theirs.
+    auto fresh = std::make_shared<SharedArena>(device_state_, kChunkBytes);
+    if (std::atomic_compare_exchange_strong(&chunk_, &chunk, fresh)) {
+      chunk = std::move(fresh);
+    }
+  }
 }
 
 std::shared_ptr<hal::Arena> SharedMemory::MakeArena(std::uint64_t size, BufferAccessMask /* access */) {
   return std::make_shared<SharedArena>(device_state_, size);
 }
 
+std::shared_ptr<hal::Buffer> SharedMemory::WrapBuffer(void* base, std::uint64_t size, BufferAccessMask /* access */) {
+  if (reinterpret_cast<std::uintptr_t>(base) % kHostPtrAlignment) {
+    return nullptr;
+  }
+  if (system_svm_) {
+    // With system SVM, any host allocation is directly usable by kernels.
+    return std::make_shared<SharedBuffer>(device_state_, nullptr, base, size);
+  }
+  if (size % kHostSizeAlignment) {
+    return nullptr;
+  }
+  // On unified memory, a CL_MEM_USE_HOST_PTR buffer aliases the host
+  // allocation, and mapping it hands back the original pointer.
+  Err err;
+  CLObj<cl_mem> mem =
+      ocl::CreateBuffer(device_state_->cl_ctx().get(), CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR, size, base, err.ptr());
+  if (err) {
+    IVLOG(1, "Unable to wrap host memory: " << err.str());
+    return nullptr;
+  }
+  return std::make_shared<CLMemBuffer>(device_state_, size, std::move(mem));
+}
+
 }  // namespace
 
 // Implements Executor::InitSharedMemory on systems that support the
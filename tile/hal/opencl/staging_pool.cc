@@ -0,0 +1,105 @@
+// Copyright 2019, Intel Corp.
+
+#include "tile/hal/opencl/staging_pool.h"
+
+#include <utility>
+
+namespace vertexai {
+namespace tile {
+namespace hal {
+namespace opencl {
+
+StagingPool::StagingPool(const CLObj<cl_context>& cl_ctx, const CLObj<cl_command_queue>& cl_queue,
+                         std::uint64_t max_bytes)
+    : cl_ctx_{cl_ctx}, cl_queue_{cl_queue}, max_bytes_{max_bytes} {}
+
+StagingPool::~StagingPool() {
+  std::lock_guard<std::mutex> lock{mu_};
+  for (auto& in_flight : in_flight_) {
+    in_flight.done.wait();
+    free_.emplace_back(std::move(in_flight.staging));
+  }
+  for (const auto& staging : free_) {
+    Err err = ocl::EnqueueUnmapMemObject(cl_queue_.get(), staging->mem.get(), staging->base, 0, nullptr, nullptr);
+    LOG_IF(err, ERROR) << "clEnqueueUnmapMemObject: " << err.str();
+  }
+  ocl::Finish(cl_queue_.get());
+}
+
+void StagingPool::ReclaimCompleted() {
+  for (auto it = in_flight_.begin(); it != in_flight_.end();) {
+    if (it->done.is_ready()) {
+      free_.emplace_back(std::move(it->staging));
+      it = in_flight_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+std::shared_ptr<StagingPool::Staging> StagingPool::Acquire(std::uint64_t size) {
+  std::lock_guard<std::mutex> lock{mu_};
+  ReclaimCompleted();
+
+  // Take the smallest free buffer that fits, as long as it isn't wastefully large.
+  auto best = free_.end();
+  for (auto it = free_.begin(); it != free_.end(); ++it) {
+    if (size <= (*it)->size && (*it)->size <= 2 * size && (best == free_.end() || (*it)->size < (*best)->size)) {
+      best = it;
+    }
+  }
+  if (best != free_.end()) {
+    auto result = std::move(*best);
+    free_.erase(best);
+    return result;
+  }
+
+  // Make room by dropping idle buffers, oldest first.
+  while (max_bytes_ < total_bytes_ + size && free_.size()) {
+    auto& victim = free_.front();
+    Err err = ocl::EnqueueUnmapMemObject(cl_queue_.get(), victim->mem.get(), victim->base, 0, nullptr, nullptr);
+    LOG_IF(err, ERROR) << "clEnqueueUnmapMemObject: " << err.str();
+    total_bytes_ -= victim->size;
+    free_.pop_front();
+  }
+  if (max_bytes_ < total_bytes_ + size) {
+    return nullptr;
+  }
+
+  Err err;
+  auto staging = std::make_shared<Staging>();
+  staging->size = size;
+  staging->mem =
+      ocl::CreateBuffer(cl_ctx_.get(), CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR, size, nullptr, err.ptr());
+  if (err) {
+    IVLOG(1, "Unable to allocate a " << size << " byte staging buffer: " << err.str());
+    return nullptr;
+  }
+  staging->base = ocl::EnqueueMapBuffer(cl_queue_.get(),            // command_queue
+                                        staging->mem.get(),          // buffer
+                                        CL_TRUE,                     // blocking_map
+                                        CL_MAP_READ | CL_MAP_WRITE,  // map_flags
+                                        0,                           // offset
+                                        size,                        // size
+                                        0,                           // num_events_in_wait_list
+                                        nullptr,                     // event_wait_list
+                                        nullptr,                     // event
+                                        err.ptr());                  // errcode_ret
+  if (err) {
+    IVLOG(1, "Unable to map a " << size << " byte staging buffer: " << err.str());
+    return nullptr;
+  }
+  total_bytes_ += size;
+  return staging;
+}
+
+void StagingPool::Release(std::shared_ptr<Staging> staging, std::shared_ptr<hal::Event> done) {
+  auto fut = done->GetFuture();
+  std::lock_guard<std::mutex> lock{mu_};
+  in_flight_.emplace_back(InFlight{std::move(staging), std::move(fut)});
+}
+
+}  // namespace opencl
+}  // namespace hal
+}  // namespace tile
+}  // namespace vertexai
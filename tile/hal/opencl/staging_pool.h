@@ -0,0 +1,62 @@
+// Copyright 2019, Intel Corp.
+
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+
+#include "tile/base/hal.h"
+#include "tile/hal/opencl/ocl.h"
+
+namespace vertexai {
+namespace tile {
+namespace hal {
+namespace opencl {
+
+// A pool of pinned (CL_MEM_ALLOC_HOST_PTR) host buffers, kept mapped, used to
+// stage uploads to device-local buffers on devices without unified memory.
+// Writing through a staging buffer lets the host fill in new contents without
+// waiting for the device to finish with the old ones, and lets the upload run
+// as an asynchronous DMA instead of a synchronous pageable copy at unmap time.
+class StagingPool final {
+ public:
+  struct Staging {
+    CLObj<cl_mem> mem;
+    void* base;
+    std::uint64_t size;
+  };
+
+  StagingPool(const CLObj<cl_context>& cl_ctx, const CLObj<cl_command_queue>& cl_queue, std::uint64_t max_bytes);
+  ~StagingPool();
+
+  // Returns a mapped staging buffer of at least the requested size, or nullptr
+  // if the pool cannot supply one without exceeding its limit.
+  std::shared_ptr<Staging> Acquire(std::uint64_t size);
+
+  // Returns a staging buffer to the pool once the supplied event (the upload
+  // reading from it) has completed.
+  void Release(std::shared_ptr<Staging> staging, std::shared_ptr<hal::Event> done);
+
+ private:
+  struct InFlight {
+    std::shared_ptr<Staging> staging;
+    boost::shared_future<std::shared_ptr<hal::Result>> done;
+  };
+
+  void ReclaimCompleted();  // Requires mu_
+
+  const CLObj<cl_context> cl_ctx_;
+  const CLObj<cl_command_queue> cl_queue_;
+  const std::uint64_t max_bytes_;
+  std::mutex mu_;
+  std::uint64_t total_bytes_ = 0;
+  std::list<std::shared_ptr<Staging>> free_;
+  std::list<InFlight> in_flight_;
+};
+
+}  // namespace opencl
+}  // namespace hal
+}  // namespace tile
+}  // namespace vertexai
@@ -34,6 +34,10 @@ void Validate(const proto::HardwareSettings& settings) {
     throw error::InvalidArgument("Memory width must be >= 8 and <= 4096 and a power of two: " +
                                  std::to_string(settings.mem_width()));
   }
+  if (settings.subgroup_size() > 64 || ((settings.subgroup_size() - 1) & settings.subgroup_size()) != 0) {
+    throw error::InvalidArgument("Subgroup size must be <= 64 and zero or a power of two: " +
+                                 std::to_string(settings.subgroup_size()));
+  }
   if (settings.max_mem() < 1024) {
     throw error::InvalidArgument("Max mem must be >= 1024: " + std::to_string(settings.max_mem()));
   }
@@ -67,6 +71,9 @@ lang::HardwareSettings ToHardwareSettings(const proto::HardwareSettings& setting
   result.goal_flops_per_byte = settings.goal_flops_per_byte();
   result.goal_dimension_sizes = std::move(dim_sizes);
   result.disable_io_aliasing = settings.disable_io_aliasing();
+  result.subgroup_size = settings.subgroup_size();
+  result.native_half = settings.native_half();
+  result.fp32_accumulation = settings.fp32_accumulation();
 
   return result;
 }
@@ -3,6 +3,7 @@
 #include "tile/lang/ast/ast.h"
 
 #include <algorithm>
+#include <unordered_map>
 #include <unordered_set>
 
 #include <boost/format.hpp>
@@ -631,9 +632,120 @@ class ExprOptimizer : public AstPass {
   }
 };
 
+// Writes index polynomials structurally, with the indexes numbered in order of
+// first appearance so that equivalent contractions built from distinct
+// TensorIndex objects are written alike.
+class CanonicalPolyWriter : public PolyVisitor {
+ public:
+  std::string Write(const PolyExprPtr& expr) {
+    ss_.str("");
+    expr->Accept(this);
+    return ss_.str();
+  }
+
+ private:
+  Polynomial Visit(const PolyDimExpr& expr) final {
+    DimExprEvaluator dim_eval;
+    ss_ << expr.expr->Accept(&dim_eval);
+    return Polynomial();
+  }
+
+  Polynomial Visit(const PolyIndex& expr) final {
+    auto it = idxs_.emplace(expr.idx_id, idxs_.size()).first;
+    ss_ << "i" << it->second;
+    return Polynomial();
+  }
+
+  Polynomial Visit(const PolyLiteral& expr) final {
+    ss_ << expr.value;
+    return Polynomial();
+  }
+
+  Polynomial Visit(const PolyOpExpr& expr) final {
+    ss_ << "(" << static_cast<int>(expr.op);
+    for (const auto& operand : expr.operands) {
+      ss_ << " ";
+      operand->Accept(this);
+    }
+    ss_ << ")";
+    return Polynomial();
+  }
+
+ private:
+  std::stringstream ss_;
+  std::unordered_map<size_t, size_t> idxs_;
+};
+
+// Eliminates common subexpressions: calls and contractions which are
+// structurally identical to an earlier one (with the same operands) are
+// replaced by it. The replaced expressions are then dead, and as only the
+// expressions reachable from the outputs are evaluated, they are dropped.
+// Scalar constants are left alone, being free to duplicate.
+class ExprDeduplicator : public AstPass {
+ private:
+  ExprPtr Visit(const CallExpr& expr) final {
+    // Random number generation yields new values on every call
+    if (expr.fn.compare(0, 4, "prng") == 0) {
+      return GenericVisit(expr);
+    }
+    std::stringstream ss;
+    ss << "call " << expr.fn << " " << expr.name << " " << expr.shape.str();
+    for (const auto& arg : expr.args) {
+      ss << " " << static_cast<const void*>(arg.get());
+    }
+    return Deduplicate(expr, ss.str());
+  }
+
+  ExprPtr Visit(const ContractionExpr& expr) final {
+    CanonicalPolyWriter writer;
+    DimExprEvaluator dim_eval;
+    std::stringstream ss;
+    ss << "cion " << to_string(expr.agg_op) << " " << to_string(expr.combo_op) << " " << expr.no_defract << " "
+       << expr.name << " " << expr.shape.str() << " " << static_cast<const void*>(expr.use_default.get()) << " [";
+    for (const auto& idx : expr.sink_idxs->idxs) {
+      ss << writer.Write(idx) << ",";
+    }
+    ss << "] [";
+    for (const auto& dim : expr.sink_dims->dims) {
+      ss << dim->Accept(&dim_eval) << ",";
+    }
+    ss << "]";
+    for (const auto& src : expr.srcs) {
+      ss << " " << static_cast<const void*>(src->ref.get()) << "[";
+      for (const auto& idx : src->idxs) {
+        ss << writer.Write(idx) << ",";
+      }
+      ss << "]";
+    }
+    for (const auto& constraint : expr.constraints) {
+      ss << " " << writer.Write(constraint->lhs) << "<" << constraint->rhs->Accept(&dim_eval);
+    }
+    return Deduplicate(expr, ss.str());
+  }
+
+ private:
+  template <typename T>
+  ExprPtr Deduplicate(const T& expr, const std::string& key) {
+    auto it = exprs_.find(key);
+    if (it != exprs_.end()) {
+      IVLOG(4, "ExprDeduplicator> " << &expr << " -> " << it->second);
+      return it->second;
+    }
+    auto ptr = GenericVisit(expr);
+    exprs_.emplace(key, ptr);
+    return ptr;
+  }
+
+ private:
+  std::unordered_map<std::string, ExprPtr> exprs_;
+};
+
 ProgramEvaluation Evaluate(const std::string& name, ProgramMutations mutations) {
   std::unordered_set<Expr*> dups;
   mutations.originals = mutations.outputs;
+  // Deduplicate first so that outputs which become identical are told apart below
+  ExprDeduplicator deduplicator;
+  mutations = RunAstPass(mutations, &deduplicator);
   for (size_t i = 0; i < mutations.outputs.size(); i++) {
     auto output = mutations.outputs[i];
     auto ptr = output.get();
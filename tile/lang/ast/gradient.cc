@@ -2,6 +2,8 @@
 
 #include "tile/lang/ast/gradient.h"
 
+#include <algorithm>
+#include <cmath>
 #include <map>
 #include <memory>
 #include <stack>
@@ -39,6 +41,49 @@ class ComputeUses : public AstVisitor<void> {
 
   const std::vector<UseInfo>& uses(const Expr* expr) const { return uses_.at(expr); }
 
+  // The contractions reachable from the source, each after those it uses.
+  std::vector<ExprPtr> SortedContractions(const ExprPtr& src) const {
+    std::vector<ExprPtr> result;
+    std::unordered_set<const Expr*> visited;
+    std::stack<std::pair<ExprPtr, bool>> stack;
+    stack.emplace(src, false);
+    while (stack.size()) {
+      auto [expr, expanded] = stack.top();
+      stack.pop();
+      if (expanded) {
+        if (std::dynamic_pointer_cast<ContractionExpr>(expr)) {
+          result.push_back(expr);
+        }
+        continue;
+      }
+      if (!visited.insert(expr.get()).second) {
+        continue;
+      }
+      stack.emplace(expr, true);
+      for (const auto& used : Inputs(expr)) {
+        stack.emplace(used, false);
+      }
+    }
+    return result;
+  }
+
+  static std::vector<ExprPtr> Inputs(const ExprPtr& expr) {
+    std::vector<ExprPtr> result;
+    if (auto call_expr = std::dynamic_pointer_cast<CallExpr>(expr)) {
+      result = call_expr->args;
+    } else if (auto cion_expr = std::dynamic_pointer_cast<ContractionExpr>(expr)) {
+      for (const auto& src : cion_expr->srcs) {
+        result.push_back(src->ref);
+      }
+      if (cion_expr->use_default) {
+        result.push_back(cion_expr->use_default);
+      }
+    } else if (auto grad_override_expr = std::dynamic_pointer_cast<GradOverrideExpr>(expr)) {
+      result = grad_override_expr->ins;
+    }
+    return result;
+  }
+
  private:
   void Visit(const CallExpr& expr) final {
     for (size_t i = 0; i < expr.args.size(); i++) {
@@ -87,6 +132,24 @@ class Gradient {
     seen_[err.get()] = std::make_shared<FloatConst>(1.0);
   }
 
+  Gradient(const ExprPtr& err, const std::vector<ExprPtr>& checkpoints) : Gradient(err) {
+    checkpointing_ = true;
+    if (checkpoints.size()) {
+      for (const auto& checkpoint : checkpoints) {
+        checkpoints_.insert(checkpoint.get());
+      }
+      return;
+    }
+    // Keep every sqrt(n)th contraction, which bounds both the number of kept
+    // activations and the length of each recomputed segment by sqrt(n).
+    auto cions = uses_.SortedContractions(err);
+    auto stride = std::max<size_t>(1, std::ceil(std::sqrt(cions.size())));
+    for (size_t i = stride - 1; i < cions.size(); i += stride) {
+      checkpoints_.insert(cions[i].get());
+    }
+    IVLOG(2, "Gradient> checkpointing " << checkpoints_.size() << " of " << cions.size() << " contractions");
+  }
+
   ExprPtr GetDerivative(const ExprPtr& expr) {
     IVLOG(4, "Gradient::GetDerivative> " << expr);
     auto it = seen_.find(expr.get());
@@ -127,6 +190,57 @@ class Gradient {
   }
 
  private:
+  // Returns a forward pass expression for use by the backward pass. When
+  // checkpointing, only checkpoints are kept alive for the backward pass;
+  // anything else is recomputed from the nearest checkpoints (or parameters).
+  ExprPtr Recompute(const ExprPtr& expr) {
+    if (!checkpointing_ || checkpoints_.count(expr.get())) {
+      return expr;
+    }
+    auto it = recomputed_.find(expr.get());
+    if (it != recomputed_.end()) {
+      return it->second;
+    }
+    ExprPtr result = expr;
+    if (auto call_expr = std::dynamic_pointer_cast<CallExpr>(expr)) {
+      // Random number generation must not be repeated
+      if (call_expr->fn.compare(0, 4, "prng") != 0) {
+        std::vector<ExprPtr> args;
+        for (const auto& arg : call_expr->args) {
+          args.push_back(Recompute(arg));
+        }
+        result = MakeCall(call_expr->fn, args);
+      }
+    } else if (auto cion_expr = std::dynamic_pointer_cast<ContractionExpr>(expr)) {
+      auto cion = std::make_shared<ContractionExpr>(*cion_expr);
+      cion->srcs.clear();
+      for (const auto& src : cion_expr->srcs) {
+        cion->srcs.push_back(std::make_shared<IndexMapExpr>(Recompute(src->ref), src->idxs));
+      }
+      if (cion_expr->use_default) {
+        cion->use_default = Recompute(cion_expr->use_default);
+      }
+      cion->ComputeShape(cion_expr->shape.layout);
+      result = cion;
+    } else if (auto grad_override_expr = std::dynamic_pointer_cast<GradOverrideExpr>(expr)) {
+      result = Recompute(grad_override_expr->out);
+    }
+    if (result != expr) {
+      // Keep the recomputation distinct from the original when deduplicating
+      result->name = expr->name.empty() ? "recomputed" : expr->name + "_recomputed";
+    }
+    recomputed_.emplace(expr.get(), result);
+    return result;
+  }
+
+  std::vector<ExprPtr> Recompute(const std::vector<ExprPtr>& exprs) {
+    std::vector<ExprPtr> result;
+    for (const auto& expr : exprs) {
+      result.push_back(Recompute(expr));
+    }
+    return result;
+  }
+
   ExprPtr DeriveContraction(const ExprPtr& dout, const std::shared_ptr<ContractionExpr>& expr, size_t idx) {
     if (expr->use_default && idx == expr->srcs.size()) {
       return dout;
@@ -158,7 +272,7 @@ class Gradient {
       return MakeCall("reshape", args);
     }
     auto deriv = DerivRegistry::Instance()->Resolve(op->fn);
-    return deriv.fn(op, dout, op->args, deriv.user_fn, deriv.user_ctx)[idx];
+    return deriv.fn(Recompute(op), dout, Recompute(op->args), deriv.user_fn, deriv.user_ctx)[idx];
   }
 
   ExprPtr DeriveSum(const ExprPtr& dout, const std::shared_ptr<ContractionExpr>& op, size_t idx) {
@@ -179,7 +293,7 @@ class Gradient {
         switch (op->combo_op) {
           case CombinationOp::MULTIPLY:
             // For *, we multiply by the other (non-differentiated) input
-            dop->srcs.push_back(op->srcs[i]);
+            dop->srcs.push_back(std::make_shared<IndexMapExpr>(Recompute(op->srcs[i]->ref), op->srcs[i]->idxs));
             dop->combo_op = CombinationOp::MULTIPLY;
             break;
           case CombinationOp::PLUS:
@@ -207,7 +321,7 @@ class Gradient {
 
   ExprPtr DeriveOverride(const ExprPtr& dout, const std::shared_ptr<GradOverrideExpr>& op, size_t idx) {
     // TODO: Ideally we'd cache this call somehow so when the only difference is `idx` we don't recompute
-    return op->fn->fn(op->out, dout, op->ins, op->fn->user_fn, op->fn->user_ctx)[idx];
+    return op->fn->fn(Recompute(op->out), dout, Recompute(op->ins), op->fn->user_fn, op->fn->user_ctx)[idx];
   }
 
   ExprPtr DeriveExtreme(const ExprPtr& dout, const std::shared_ptr<ContractionExpr>& op, size_t idx) {
@@ -222,8 +336,8 @@ class Gradient {
     dop->constraints = op->constraints;
     // Anywhere the forward pass hits the default, the derivative w.r.t. any other tensor is 0;
     // thus, for the corresponding gradient, the default is everywhere zero i.e. the standard unspecified default
-    dop->srcs.push_back(input);
-    dop->srcs.push_back(std::make_shared<IndexMapExpr>(op, op->sink_idxs->idxs));
+    dop->srcs.push_back(std::make_shared<IndexMapExpr>(Recompute(input->ref), input->idxs));
+    dop->srcs.push_back(std::make_shared<IndexMapExpr>(Recompute(op), op->sink_idxs->idxs));
     dop->srcs.push_back(std::make_shared<IndexMapExpr>(dout, op->sink_idxs->idxs));
     dop->sink_idxs = std::make_shared<IndexMapExpr>(nullptr, input->idxs);
     dop->sink_dims = std::make_shared<SizeMapExpr>(input->ref->shape.dims_as_exprs());
@@ -234,11 +348,15 @@ class Gradient {
  private:
   ComputeUses uses_;
   std::map<const Expr*, ExprPtr> seen_;
+  bool checkpointing_ = false;
+  std::unordered_set<const Expr*> checkpoints_;
+  std::map<const Expr*, ExprPtr> recomputed_;
 };
 
 }  // namespace
 
-std::vector<ExprPtr> ComputeGradients(const std::vector<ExprPtr>& wrts, const ExprPtr& loss) {
+std::vector<ExprPtr> ComputeGradients(const std::vector<ExprPtr>& wrts, const ExprPtr& loss,
+                                      const std::vector<ExprPtr>* checkpoints) {
   ExprPtr value = loss;
   auto ndims = loss->shape.dims.size();
   if (ndims) {
@@ -255,7 +373,7 @@ std::vector<ExprPtr> ComputeGradients(const std::vector<ExprPtr>& wrts, const Ex
     cion->ComputeShape("");
     value = cion;
   }
-  Gradient grad(value);
+  auto grad = checkpoints ? Gradient(value, *checkpoints) : Gradient(value);
   std::vector<ExprPtr> ret(wrts.size());
   for (size_t i = 0; i < wrts.size(); i++) {
     ret[i] = grad.GetDerivative(wrts[i]);
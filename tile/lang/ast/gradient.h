@@ -40,7 +40,13 @@ class DerivRegistry {
   std::unordered_map<std::string, ExprDerivEntry> registry_;
 };
 
-std::vector<ExprPtr> ComputeGradients(const std::vector<ExprPtr>& wrts, const ExprPtr& loss);
+// Computes the gradients of the loss with respect to each of `wrts`. By default
+// the backward pass uses every forward pass intermediate it needs, keeping them
+// all alive. If `checkpoints` is given, only those intermediates are kept and
+// the others are recomputed from them during the backward pass, trading FLOPs
+// for memory; an empty list of checkpoints selects them automatically.
+std::vector<ExprPtr> ComputeGradients(const std::vector<ExprPtr>& wrts, const ExprPtr& loss,
+                                      const std::vector<ExprPtr>* checkpoints = nullptr);
 
 }  // namespace ast
 }  // namespace lang
@@ -124,6 +124,7 @@ class AstPassRunner : AstVisitor<void> {
   void Visit(const CallExpr& expr) final {
     IVLOG(4, "AstPassRunner::Visit(CallExpr)> " << &expr);
     auto new_expr = std::make_shared<CallExpr>(expr.fn, expr.args);
+    new_expr->name = expr.name;
     for (size_t i = 0; i < expr.args.size(); i++) {
       new_expr->args[i] = Translate(expr.args[i]);
     }
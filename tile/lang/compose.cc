@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <sstream>
 #include <stack>
+#include <unordered_map>
 
 #include "tile/lang/builtins.h"
 #include "tile/lang/fpconv.h"
@@ -36,6 +37,23 @@ IDMap* GetIDMap() {
   return &idmap;
 }
 
+// Caches the parsed programs of functions built from code, and the output
+// bindings of typechecking each such program against concrete inputs.
+// Frameworks rebuild the same op functions over and over while composing a
+// graph, so both are keyed by the function's code.
+struct ComposeCache {
+  static constexpr std::size_t kMaxEntries = 4096;
+
+  std::mutex mu;
+  std::unordered_map<std::string, std::shared_ptr<const Program>> parsed;
+  std::unordered_map<std::string, std::shared_ptr<const Bindings>> typechecked;
+};
+
+ComposeCache* GetComposeCache() {
+  static ComposeCache cache;
+  return &cache;
+}
+
 std::shared_ptr<Value> FunctionValue::make(std::string fn, std::vector<std::shared_ptr<Value>> inputs) {
   static std::shared_ptr<Value> zeroi = IConstValue::make(0);
   static std::shared_ptr<Value> onei = IConstValue::make(1);
@@ -337,9 +355,26 @@ std::shared_ptr<Value> ContractionValue::make(CombinationOp comb_op, Aggregation
   return result;
 }
 
-BoundFunction::BoundFunction(const std::string& code, const std::string& id) {
-  Parser p;
-  prog_ = p.Parse(code, id);
+BoundFunction::BoundFunction(const std::string& code, const std::string& id) : code_key_{id + '\n' + code} {
+  auto* cache = GetComposeCache();
+  std::shared_ptr<const Program> parsed;
+  {
+    std::lock_guard<std::mutex> lock{cache->mu};
+    auto it = cache->parsed.find(code_key_);
+    if (it != cache->parsed.end()) {
+      parsed = it->second;
+    }
+  }
+  if (!parsed) {
+    Parser p;
+    parsed = std::make_shared<const Program>(p.Parse(code, id));
+    std::lock_guard<std::mutex> lock{cache->mu};
+    if (cache->parsed.size() >= ComposeCache::kMaxEntries) {
+      cache->parsed.clear();
+    }
+    cache->parsed.emplace(code_key_, parsed);
+  }
+  prog_ = *parsed;
   for (size_t i = 0; i < prog_.inputs.size(); i++) {
     in_pos_[prog_.inputs[i].name] = i;
   }
@@ -1101,7 +1136,41 @@ TensorShape FunctionApplication::GetOutputShape(const std::string& name) {
       }
     }
 
-    TypeCheck(&prog, &typecheck_bindings);
+    // Functions built from code typecheck identically for identical inputs.
+    std::string key;
+    if (!func_->code_key().empty()) {
+      std::ostringstream ss;
+      ss << func_->code_key();
+      for (const auto& kvp : typecheck_bindings) {
+        ss << '\n' << kvp.first << ' ' << kvp.second;
+        if (kvp.second.tag != Binding::TENSOR) {
+          ss << ' ' << to_string(kvp.second.shape.type);
+        }
+      }
+      key = ss.str();
+    }
+    auto* cache = GetComposeCache();
+    std::shared_ptr<const Bindings> cached;
+    if (!key.empty()) {
+      std::lock_guard<std::mutex> lock{cache->mu};
+      auto it = cache->typechecked.find(key);
+      if (it != cache->typechecked.end()) {
+        cached = it->second;
+      }
+    }
+
+    if (cached) {
+      typecheck_bindings = *cached;
+    } else {
+      TypeCheck(&prog, &typecheck_bindings);
+      if (!key.empty()) {
+        std::lock_guard<std::mutex> lock{cache->mu};
+        if (cache->typechecked.size() >= ComposeCache::kMaxEntries) {
+          cache->typechecked.clear();
+        }
+        cache->typechecked.emplace(key, std::make_shared<const Bindings>(typecheck_bindings));
+      }
+    }
 
     typecheck_bindings_.swap(typecheck_bindings);
     is_typechecked_ = true;
@@ -251,6 +251,8 @@ class BoundFunction final : public ValueVisitor<std::string> {
 
   // Accessors
   const Program& prog() const { return prog_; }
+  // Identifies the code the function was built from; empty for composites.
+  const std::string& code_key() const { return code_key_; }
   const std::map<std::string, size_t> in_pos() const { return in_pos_; }
   const std::map<std::string, size_t> out_pos() const { return out_pos_; }
   const std::map<std::string, std::shared_ptr<TensorValue>> in_bound() const { return in_bound_; }
@@ -284,6 +286,7 @@ class BoundFunction final : public ValueVisitor<std::string> {
   std::set<std::shared_ptr<TensorValue>> updated_;
   std::map<std::shared_ptr<Value>, std::string> bindings_;
 
+  std::string code_key_;
   Program prog_;
   std::map<std::string, size_t> in_pos_;
   std::map<std::string, size_t> out_pos_;
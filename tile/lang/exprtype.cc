@@ -219,6 +219,11 @@ void ExprType::Visit(const sem::CastExpr& n) {
   // only actually-semantically-useful casts remain, allowing this
   // code to insert those casts.
   n.val->Accept(*this);
+  if (std::dynamic_pointer_cast<sem::FloatConst>(n.val) && is_float(n.type.dtype) &&
+      (n.type.dtype != DataType::FLOAT16 || enable_fp16_)) {
+    // Float constants take on the precision they're cast to.
+    ty_.dtype = n.type.dtype;
+  }
   IVLOG(5, "ExprType(CastExpr): " << ty_);
 }
 
@@ -82,6 +82,15 @@ TEST_F(ExprTypeTest, SmallConstCompareIndex) {
   EXPECT_THAT(TypeOf(_Const(8) <= _("idx")), IsType(sem::Type{sem::Type::VALUE, DataType::INT32}));
 }
 
+TEST_F(ExprTypeTest, HalfMulCastFloatConst) {
+  scope_.Bind("val_half", sem::Type{sem::Type::VALUE, DataType::FLOAT16});
+  auto half_const = _Cast(sem::Type{sem::Type::VALUE, DataType::FLOAT16}, _Const(2.0));
+  EXPECT_THAT(TypeOf(_("val_half") * half_const), IsValueType(DataType::FLOAT32));
+  enable_fp16_ = true;
+  EXPECT_THAT(TypeOf(_("val_half") * half_const), IsValueType(DataType::FLOAT16));
+  EXPECT_THAT(TypeOf(_("val_half") * _Const(2.0)), IsValueType(DataType::FLOAT32));
+}
+
 }  // namespace
 }  // namespace lang
 }  // namespace tile
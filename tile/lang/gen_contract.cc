@@ -191,6 +191,7 @@ KernelInfo GenContract(const string& kname, const DirectSettings& settings, cons
   }
   auto tid = _Declare(kblock, {sem::Type::INDEX}, "tid", _Index(sem::IndexExpr::LOCAL, 0));
   auto agg = _("agg");
+  size_t subgroup_size = 0;
 
   if (op.generate_contraction) {
     // There's a contraction, so initialize the aggregation output and
@@ -423,21 +424,49 @@ KernelInfo GenContract(const string& kname, const DirectSettings& settings, cons
     uint64_t comp_threads = threads / rthreads;
     if (out_threads < comp_threads) {
       auto mblock = _Block({});
-      sem::Type ltype = {sem::Type::VALUE, op.access[0].type, op.access[0].vector, threads, sem::Type::LOCAL};
 
-      // OpenCL requires that __local variables be defined at kernel function scope.
-      auto merge_shared = _Declare(kblock, ltype, "merge_shared", sem::ExprPtr());
+      // The last steps of the merge may be done with subgroup shuffles when
+      // the first subgroup is made up of the first work items, and the
+      // hardware can shuffle the aggregation type.
+      uint64_t sg_size = settings.subgroup_size;
+      bool use_subgroups = sg_size > 1 && out_threads < sg_size && threads % sg_size == 0 &&
+                           byte_width(op.agg_type) == 4 && op.agg_op != AggregationOp::ASSIGN;
 
-      mblock->append(merge_shared[tid] = agg[_Const(0)]);
       uint64_t x = comp_threads;
-      while (x > out_threads) {
+      uint64_t shared_limit = use_subgroups ? std::max(out_threads, sg_size) : out_threads;
+      sem::ExprPtr merged = agg[_Const(0)];
+      if (x > shared_limit || !use_subgroups) {
+        sem::Type ltype = {sem::Type::VALUE, op.agg_type, op.access[0].vector, threads, sem::Type::LOCAL};
+
+        // OpenCL requires that __local variables be defined at kernel function scope.
+        auto merge_shared = _Declare(kblock, ltype, "merge_shared", sem::ExprPtr());
+
+        mblock->append(merge_shared[tid] = agg[_Const(0)]);
+        while (x > shared_limit) {
+          mblock->append(_Barrier());
+          x /= 2;
+          auto merge_agg = aggregate(op.agg_op, merge_shared[tid], merge_shared[tid + x]);
+          mblock->append(_If(tid < x, merge_shared[tid] = merge_agg));
+        }
         mblock->append(_Barrier());
-        x /= 2;
-        auto merge_agg = aggregate(op.agg_op, merge_shared[tid], merge_shared[tid + x]);
-        mblock->append(_If(tid < x, merge_shared[tid] = merge_agg));
+        merged = merge_shared[tid];
+      }
+      if (use_subgroups) {
+        // Work items at or beyond x hold stale values, but xor shuffles by
+        // strides below x never carry those into work items below x.
+        auto sblock = _Block({});
+        sem::Type vtype = {sem::Type::VALUE, op.agg_type, op.agg_vec};
+        auto merge_val = _Declare(sblock, vtype, "merge_val", merged);
+        for (uint64_t y = x / 2; y >= out_threads && y > 0; y /= 2) {
+          auto shuffled = _("sub_group_shuffle_xor")(merge_val, _Const(y));
+          sblock->append(merge_val = aggregate(op.agg_op, merge_val, shuffled));
+        }
+        sblock->append(_If(tid < out_threads, agg[_Const(0)] = merge_val));
+        mblock->append(_If(tid < sg_size, sblock));
+        subgroup_size = sg_size;
+      } else {
+        mblock->append(_If(tid < out_threads, agg[_Const(0)] = merged));
       }
-      mblock->append(_Barrier());
-      mblock->append(_If(tid < out_threads, agg[_Const(0)] = merge_shared[tid]));
       kblock->push_back(mblock);
     }
   } else {
@@ -665,6 +694,7 @@ KernelInfo GenContract(const string& kname, const DirectSettings& settings, cons
     func->params.emplace_back(in_type, op_input.name);
   }
   func->body = kblock;
+  func->subgroup_size = subgroup_size;
 
   // Assign function to kernel
   ki.comments = comments;
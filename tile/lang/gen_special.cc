@@ -29,13 +29,14 @@ static void GenGather(KernelList& r, const Op& op, const Bindings& bindings,  //
   // Make an empty function body
   auto body = _Block({});
 
-  // Generate expressions for the GIDs.
+  // Generate expressions for the GIDs: one thread per output element, i.e. per
+  // index and element of the data row it selects.
   std::vector<size_t> lidx_sizes;
   for (const auto& d : idx_shape.dims) {
     lidx_sizes.push_back(d.size);
   }
-  for (const auto& d : data_shape.dims) {
-    lidx_sizes.push_back(d.size);
+  for (size_t i = 1; i < data_shape.dims.size(); i++) {
+    lidx_sizes.push_back(data_shape.dims[i].size);
   }
   auto gids = gid::MakeMap(settings.goal_dimension_sizes, lidx_sizes);
   std::vector<sem::ExprPtr> gid_vars;
@@ -59,11 +60,7 @@ static void GenGather(KernelList& r, const Op& op, const Bindings& bindings,  //
   // Generate the output offset
   sem::ExprPtr out_offset = _Const(0);
   for (size_t i = 0; i < out_shape.dims.size(); i++) {
-    if (i < idx_shape.dims.size()) {
-      out_offset = out_offset + lid_vars[i] * out_shape.dims[i].stride;
-    } else {
-      out_offset = out_offset + lid_vars[i + 1] * out_shape.dims[i].stride;
-    }
+    out_offset = out_offset + lid_vars[i] * out_shape.dims[i].stride;
   }
 
   // Generate the index offset
@@ -76,7 +73,7 @@ static void GenGather(KernelList& r, const Op& op, const Bindings& bindings,  //
   sem::ExprPtr data_offset = _Clamp(_("idx")[idx_offset], _Const(0), _Const(data_shape.dims[0].size - 1));
   data_offset = data_offset * data_shape.dims[0].stride;
   for (size_t i = 1; i < data_shape.dims.size(); i++) {
-    data_offset = data_offset + lid_vars[idx_shape.dims.size() + i] * data_shape.dims[i].stride;
+    data_offset = data_offset + lid_vars[idx_shape.dims.size() + i - 1] * data_shape.dims[i].stride;
   }
 
   // Copy the data across
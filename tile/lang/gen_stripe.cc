@@ -1,11 +1,15 @@
 #include "tile/lang/gen_stripe.h"
 
+#include <exception>
+#include <map>
 #include <set>
+#include <sstream>
 #include <utility>
 #include <vector>
 
 #include <boost/format.hpp>
 
+#include "tile/base/compile_pool.h"
 #include "tile/lang/bound.h"
 #include "tile/lang/defract.h"
 #include "tile/lang/parser.h"
@@ -63,6 +67,8 @@ class StripeGenerator {
     // Add decls for external inputs/outputs
     AddDecls(entry.get(), main.get(), runinfo_.input_shapes, true);
     AddDecls(entry.get(), main.get(), runinfo_.output_shapes, false);
+    AddAccumulators();
+    CompileContractions();
     // Add decls for temporaries
     for (const auto& item : runinfo_.vars) {
       if (externals_.count(item.first) == 0) {
@@ -125,6 +131,15 @@ class StripeGenerator {
   }
 
  private:
+  // A contraction compiled down to its final index polynomials, with the bounds of its indices
+  struct CompiledContraction {
+    Contraction cion;
+    IndexBounds bounds;
+    std::vector<SimpleConstraint> simple_cons;
+    std::exception_ptr error;
+    bool bounds_failed = false;
+  };
+
   void AddDecls(Block* program, Block* main, const ShapeMap& shapes, bool is_input) {
     for (const auto& item : shapes) {
       externals_.insert(item.first);
@@ -210,25 +225,72 @@ class StripeGenerator {
     return stmt;
   }
 
+  // Binds a temporary for each contraction whose output is stored at a lower precision than it should accumulate
+  // in; the contraction accumulates into the temporary, which is then narrowed into the output.
+  void AddAccumulators() {
+    for (const auto& op : runinfo_.program.ops) {
+      if (op.tag != Op::CONTRACTION) {
+        continue;
+      }
+      auto it = runinfo_.vars.find(op.output);
+      if (it == runinfo_.vars.end() || it->second.tag != Binding::TENSOR) {
+        continue;
+      }
+      auto acc_type = AccumulationType(it->second.shape.type, op.c.agg_op);
+      if (acc_type == it->second.shape.type) {
+        continue;
+      }
+      auto acc_name = op.output + "_acc";
+      while (runinfo_.vars.count(acc_name)) {
+        acc_name += "_";
+      }
+      auto binding = it->second;
+      binding.shape.type = acc_type;
+      IVLOG(2, "Accumulating " << op.output << " in " << to_string(acc_type) << " as " << acc_name);
+      runinfo_.vars.emplace(acc_name, binding);
+      accumulators_.emplace(op.output, acc_name);
+    }
+  }
+
   void ProcessContraction(Block* main, const Op& op) {
     if (GetShape(op.output).byte_size() == 0) {
       IVLOG(3, "Contraction output " << op.output << " size==0; skipping");
       return;
     }
-    Contraction cion;
-    std::vector<math::RangeConstraint> range_cons;
+    auto acc_it = accumulators_.find(op.output);
+    if (acc_it != accumulators_.end()) {
+      Op acc_op = op;
+      acc_op.output = acc_it->second;
+      acc_op.c.specs[0].id = acc_it->second;
+      ProcessContraction(main, acc_op);
+      Op narrow_op;
+      narrow_op.tag = Op::FUNCTION;
+      narrow_op.output = op.output;
+      narrow_op.inputs = {acc_it->second};
+      narrow_op.f.fn = "ident";
+      ProcessElementwise(nullptr, main, narrow_op);
+      return;
+    }
     auto shapes = MakeShapes(op.c);
-    std::tie(cion, range_cons) = CompileContraction(op.c, shapes);
-
-    // Compute bounds
-    IndexBounds bounds;
-    std::vector<SimpleConstraint> simple_cons;
-    try {
-      std::tie(bounds, simple_cons) = ComputeBounds(range_cons);
-    } catch (const std::runtime_error& ex) {
-      LOG(WARNING) << "Unable to compute bounds for contraction: " << to_string(cion);
-      throw;
+    auto compiled_it = compiled_.find(op.output);
+    if (compiled_it == compiled_.end()) {
+      auto compiled = std::make_shared<CompiledContraction>(CompileAndBound(op.c, shapes));
+      compiled_it = compiled_.emplace(op.output, compiled).first;
+    }
+    const auto& compiled = *compiled_it->second;
+    if (compiled.error) {
+      if (compiled.bounds_failed) {
+        LOG(WARNING) << "Unable to compute bounds for contraction: " << to_string(compiled.cion);
+      }
+      std::rethrow_exception(compiled.error);
+    }
+    // The compiled form may be shared with other contractions; give it this contraction's tensors
+    auto cion = compiled.cion;
+    for (size_t i = 0; i < cion.specs.size(); i++) {
+      cion.specs[i].id = op.c.specs[i].id;
     }
+    const auto& bounds = compiled.bounds;
+    const auto& simple_cons = compiled.simple_cons;
 
     auto kernel = AddKernel(main, op);
     auto agg_op = GetAggOp(cion.agg_op);
@@ -325,7 +387,11 @@ class StripeGenerator {
       } else {
         auto combo_op = GetComboOp(cion.comb_op);
         if (!combo_op.empty()) {
-          AddIntrinsic(kernel.get(), combo_op, input_based_type, scalar_inputs, {ScalarName(op.output)});
+          // When accumulating at a higher precision than the inputs, combine at that precision too
+          auto combo_type = is_float(input_based_type) && bit_width(output_type) > bit_width(input_based_type)
+                                ? output_type
+                                : input_based_type;
+          AddIntrinsic(kernel.get(), combo_op, combo_type, scalar_inputs, {ScalarName(op.output)});
           kernel->set_tag("comb_op_" + combo_op);
           if (agg_op == Intrinsic::SUM && combo_op == Intrinsic::MUL) {
             total_macs_ += kernel->idxs_product();
@@ -342,6 +408,67 @@ class StripeGenerator {
     kernel->stmts.push_back(std::make_shared<Store>(ScalarName(op.output), op.output));
   }
 
+  // Compiles every contraction and solves for its index bounds up front.  Contractions are independent once their
+  // shapes are bound, so the distinct forms are compiled in parallel on the compile pool, and contractions which repeat
+  // a form (e.g. the same convolution at several layers) share a single compile.  Errors are held until the
+  // contraction's kernel is generated, so that they surface in program order.
+  void CompileContractions() {
+    std::map<std::string, std::shared_ptr<CompiledContraction>> forms;
+    std::vector<std::pair<const Op*, std::shared_ptr<CompiledContraction>>> work;
+    for (const auto& op : runinfo_.program.ops) {
+      if (op.tag != Op::CONTRACTION || GetShape(op.output).byte_size() == 0) {
+        continue;
+      }
+      auto acc_it = accumulators_.find(op.output);
+      const auto& output = acc_it == accumulators_.end() ? op.output : acc_it->second;
+      auto& compiled = forms[ContractionForm(op.c, MakeShapes(op.c))];
+      if (!compiled) {
+        compiled = std::make_shared<CompiledContraction>();
+        work.emplace_back(&op, compiled);
+      }
+      compiled_.emplace(output, compiled);
+    }
+    IVLOG(2, "Compiling " << work.size() << " distinct contraction forms for " << compiled_.size() << " contractions");
+    CompileParallelFor(work.size(), 0, [&](size_t i) {
+      const auto& op = *work[i].first;
+      *work[i].second = CompileAndBound(op.c, MakeShapes(op.c));
+    });
+  }
+
+  // Everything a compiled contraction depends on: its operations, index polynomials and constraints, and the dimensions
+  // of its tensors (but not their names or element types).
+  std::string ContractionForm(const Contraction& cion, const std::vector<TensorShape>& shapes) {
+    std::ostringstream form;
+    form << static_cast<int>(cion.agg_op) << "," << static_cast<int>(cion.comb_op) << "," << cion.no_defract;
+    for (size_t i = 0; i < cion.specs.size(); i++) {
+      form << "|" << cion.specs[i].spec << ":";
+      for (const auto& dim : shapes[i].dims) {
+        form << dim.size << "/" << dim.stride << ",";
+      }
+    }
+    for (const auto& con : cion.constraints) {
+      form << "|" << to_string(con.bound.poly) << "<" << con.bound.range;
+    }
+    return form.str();
+  }
+
+  CompiledContraction CompileAndBound(const Contraction& op_cion, const std::vector<TensorShape>& shapes) {
+    CompiledContraction compiled;
+    try {
+      std::vector<math::RangeConstraint> range_cons;
+      std::tie(compiled.cion, range_cons) = CompileContraction(op_cion, shapes);
+      try {
+        std::tie(compiled.bounds, compiled.simple_cons) = ComputeBounds(range_cons);
+      } catch (const std::runtime_error&) {
+        compiled.bounds_failed = true;
+        throw;
+      }
+    } catch (...) {
+      compiled.error = std::current_exception();
+    }
+    return compiled;
+  }
+
   bool NeedsInitialize(const Block& block, const std::string& out_ref_name, const TensorShape& out_shape) {
     // Check if have a simple output: 1 unique index per dimension, each full range
     // If not, presume we need initialization for safety
@@ -787,6 +914,8 @@ class StripeGenerator {
   RunInfo runinfo_;
   std::set<std::string> externals_;
   std::set<size_t> to_skip_;
+  std::map<std::string, std::string> accumulators_;  // contraction output -> wider accumulation temporary
+  std::map<std::string, std::shared_ptr<CompiledContraction>> compiled_;  // contraction output -> compiled form
   bool i8_mode_;
   int64_t total_macs_ = 0;
 };
@@ -3,14 +3,20 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <set>
+#include <string>
 #include <vector>
 
 #include "plaidml2/edsl/edsl.h"
 #include "plaidml2/edsl/helper.h"
 #include "testing/matchers.h"
 #include "tile/lang/gen_stripe.h"
+#include "tile/lang/runinfo.h"
 
+using ::testing::ElementsAre;
 using ::testing::EqualsProtoText;
+using ::testing::HasSubstr;
+using ::testing::Not;
 
 namespace vertexai {
 namespace tile {
@@ -25,6 +31,24 @@ std::shared_ptr<stripe::Program> Evaluate(const std::string& name, const std::ve
   return plaidml::edsl::ConvertIntoStripe(program);
 }
 
+std::shared_ptr<stripe::Program> Generate(const std::string& code, const ShapeMap& inputs, const ShapeMap& outputs) {
+  RunInfo runinfo;
+  runinfo.program_name = "gen_stripe_test";
+  runinfo.code = code;
+  runinfo.input_shapes = inputs;
+  runinfo.output_shapes = outputs;
+  return GenerateStripe(runinfo);
+}
+
+// The tensors a kernel reads and writes.
+std::set<std::string> KernelTensors(const stripe::Block& kernel) {
+  std::set<std::string> tensors;
+  for (const auto& ref : kernel.refs) {
+    tensors.insert(ref.from);
+  }
+  return tensors;
+}
+
 Tensor ContractPlusElementwise(const Tensor& A, const Tensor& B) {
   TensorDim M, N, K;
   A.bind_dims(M, K);
@@ -197,6 +221,69 @@ TEST(GenStripeTest, ContractPlusElementwise) {
   )***"));
 }
 
+TEST(GenStripeTest, MixedPrecisionAccumulation) {
+  using plaidml::edsl::LogicalShape;
+  LogicalShape shape(PLAIDML_DATA_FLOAT16, {10, 10});
+  auto A = Placeholder(shape);
+  auto B = Placeholder(shape);
+  SetFloatAccumulation(DataType::FLOAT32);
+  auto program = Evaluate("MixedPrecisionAccumulation", {ContractPlusElementwise(A, B)});
+  SetFloatAccumulation(DataType::INVALID);
+  LOG(INFO) << "Block: " << *program->entry;
+  // The contraction accumulates into a FLOAT32 temporary, which is narrowed into its FLOAT16 output
+  EXPECT_EQ(program->entry->ref_by_into("_X2")->interior_shape.type, DataType::FLOAT16);
+  EXPECT_EQ(program->entry->ref_by_into("_X2_acc")->interior_shape.type, DataType::FLOAT32);
+  auto main = stripe::Block::Downcast(program->entry->stmts.front());
+  ASSERT_EQ(main->stmts.size(), 3);
+  auto contraction = stripe::Block::Downcast(main->stmts.front());
+  EXPECT_EQ(contraction->ref_outs()[0]->from, "_X2_acc");
+  auto narrow = stripe::Block::Downcast(*std::next(main->stmts.begin()));
+  EXPECT_EQ(narrow->ref_ins()[0]->from, "_X2_acc");
+  EXPECT_EQ(narrow->ref_outs()[0]->from, "_X2");
+}
+
+TEST(GenStripeTest, SharedFormsKeepTheirTensors) {
+  // Both contractions have the same form, so they share a compile, but each kernel must use its own tensors.
+  auto shape = SimpleShape(DataType::FLOAT32, {8, 8});
+  auto program = Generate(R"***(
+    function (A[M, K], B[K, N], C[M, K], D[K, N]) -> (X, Y) {
+      X[m, n : M, N] = +(A[m, k] * B[k, n]);
+      Y[m, n : M, N] = +(C[m, k] * D[k, n]);
+    }
+  )***",
+                          {{"A", shape}, {"B", shape}, {"C", shape}, {"D", shape}}, {{"X", shape}, {"Y", shape}});
+  auto main = stripe::Block::Downcast(program->entry->stmts.front());
+  std::vector<std::set<std::string>> kernels;
+  for (const auto& stmt : main->stmts) {
+    auto kernel = stripe::Block::Downcast(stmt);
+    if (kernel) {
+      kernels.push_back(KernelTensors(*kernel));
+    }
+  }
+  EXPECT_THAT(kernels, ElementsAre(std::set<std::string>{"A", "B", "X"}, std::set<std::string>{"C", "D", "Y"}));
+}
+
+TEST(GenStripeTest, CompileErrorsInProgramOrder) {
+  // Both contractions read a fixed element past the end of their inputs.  Their forms are compiled in parallel, but the
+  // first contraction's error is the one reported.
+  auto in = SimpleShape(DataType::FLOAT32, {10});
+  auto out = SimpleShape(DataType::FLOAT32, {5});
+  std::string error;
+  try {
+    Generate(R"***(
+      function (A[N], B[N]) -> (X, Y) {
+        X[i : 5] = +(A[20]);
+        Y[i : 5] = +(B[40]);
+      }
+    )***",
+             {{"A", in}, {"B", in}}, {{"X", out}, {"Y", out}});
+  } catch (const std::exception& ex) {
+    error = ex.what();
+  }
+  EXPECT_THAT(error, HasSubstr("Constraint poly: 20"));
+  EXPECT_THAT(error, Not(HasSubstr("40")));
+}
+
 }  // namespace
 }  // namespace lang
 }  // namespace tile
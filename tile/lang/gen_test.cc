@@ -223,6 +223,31 @@ TEST(GenContractTest, SmallMatMul) {
   });
 }
 
+TEST(GenerateTest, DeduplicateKernels) {
+  using namespace sem::builder;  // NOLINT
+  sem::Type index_type{sem::Type::INDEX};
+  sem::Type in_float_type{sem::Type::POINTER_CONST, DataType::FLOAT32};
+  sem::Type out_float_type{sem::Type::POINTER_MUT, DataType::FLOAT32};
+  auto make_kernel = [&](const std::string& kname, const std::string& out, size_t gwork) {
+    KernelInfo ki;
+    ki.kname = kname;
+    ki.gwork = {{gwork, 1, 1}};
+    ki.lwork = {{gwork, 1, 1}};
+    ki.kfunc = _Function(kname, sem::Type{}, {{out_float_type, out}, {in_float_type, "in1"}},
+                         {_Declare(index_type, "tid", _Index(sem::IndexExpr::LOCAL, 0)),
+                          _(out)[_("tid")] = _("in1")[_("tid")] * 2});
+    return ki;
+  };
+
+  std::vector<KernelInfo> kernels{make_kernel("kernel_0", "X_T1", 16), make_kernel("kernel_1", "X_T2", 16),
+                                  make_kernel("kernel_2", "X_T3", 32)};
+  DeduplicateKernels(&kernels);
+
+  EXPECT_EQ(kernels[1].kname, "kernel_0");
+  EXPECT_EQ(kernels[1].kfunc.get(), kernels[0].kfunc.get());
+  EXPECT_EQ(kernels[2].kname, "kernel_2");
+}
+
 }  // namespace lang
 }  // namespace tile
 }  // namespace vertexai
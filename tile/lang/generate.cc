@@ -2,7 +2,9 @@
 
 #include <algorithm>
 #include <cctype>
+#include <future>
 #include <iterator>
+#include <map>
 #include <memory>
 #include <set>
 #include <string>
@@ -19,6 +21,7 @@
 #include "tile/lang/gen_trivial.h"
 #include "tile/lang/ops.h"
 #include "tile/lang/parser.h"
+#include "tile/lang/semprinter.h"
 #include "tile/lang/simplifier.h"
 #include "tile/lang/tile_opt.h"
 #include "tile/lang/type.h"
@@ -139,6 +142,32 @@ static KernelInfo GenerateContractionKernel(const std::string& kname, const Hard
   ki.info.set_flops(ki.tot_flops);
   ki.info.set_bytes(ki.tot_bytes);
 
+  // Keep only the bindings the kernel reads, so that the regenerate closure doesn't hold on to the whole program's.
+  // The variable rewrites only affect ki.inputs, which retuning leaves alone.
+  Bindings used;
+  for (const auto& name : inputs) {
+    auto it = vars.find(name);
+    if (it != vars.end()) {
+      used.emplace(*it);
+    }
+  }
+  for (const auto& op_input : flat.post_op_inputs) {
+    used.emplace(op_input.name, vars.at(op_input.name));
+  }
+  for (const auto& post_op : flat.post_ops) {
+    for (const auto& name : post_op.inputs) {
+      used.emplace(name, vars.at(name));
+    }
+    used.emplace(post_op.output, vars.at(post_op.output));
+  }
+  used.emplace(flat.output, vars.at(flat.output));
+  auto contraction = c ? std::make_shared<Contraction>(*c) : nullptr;
+  ki.regenerate = [kname, settings, contraction, flat, option, inputs, used](uint64_t threads) {
+    HardwareSettings retuned = settings;
+    retuned.threads = threads;
+    return GenerateContractionKernel(kname, retuned, contraction.get(), flat, option, inputs, used, VarRewrites{});
+  };
+
   return ki;
 }
 
@@ -258,6 +287,12 @@ static void ContractionWrap(KernelList& r, const Contraction* c, FlatContraction
   while (SimplifyFlat(&flat)) {
   }
 
+  // Half-precision sums and products lose precision quickly; accumulate them as floats if configured.
+  if (settings.fp32_accumulation && flat.agg_type == DataType::FLOAT16 &&
+      (flat.agg_op == AggregationOp::SUM || flat.agg_op == AggregationOp::PROD)) {
+    flat.agg_type = DataType::FLOAT32;
+  }
+
   bool do_vectorization = true;
   auto is_small_data_element = [&](const std::string& name) {
     auto it = vars.find(name);
@@ -284,8 +319,22 @@ static void ContractionWrap(KernelList& r, const Contraction* c, FlatContraction
     do_vectorization &= is_small_data_element(*it);
   }
   if (do_vectorization) {
+    // Every tensor moves the same number of lanes, so the widest element
+    // decides how far a narrow-typed contraction can widen its vectors.
+    uint64_t elem_bytes = byte_width(flat.access[0].type);
+    for (const auto& a : flat.access) {
+      elem_bytes = std::max<uint64_t>(elem_bytes, byte_width(a.type));
+    }
+    for (const auto& op_input : flat.post_op_inputs) {
+      elem_bytes = std::max<uint64_t>(elem_bytes, byte_width(op_input.access.type));
+    }
+    auto start_size = settings.vec_size > 1 ? VectorWidth(settings.vec_size, elem_bytes) : settings.vec_size;
+    if (start_size == 1 && settings.native_half && elem_bytes == 2 && flat.access[0].type == DataType::FLOAT16) {
+      // Packed half math executes two lanes per instruction.
+      start_size = 2;
+    }
     // Do memory based tile optimization
-    for (auto vec_size = settings.vec_size; flat.agg_vec == 1 && 1 < vec_size; vec_size /= 2) {
+    for (auto vec_size = start_size; flat.agg_vec == 1 && 1 < vec_size; vec_size /= 2) {
       flat = Vectorize(flat, vec_size);
     }
   }
@@ -322,15 +371,20 @@ static void ContractionWrap(KernelList& r, const Contraction* c, FlatContraction
   IVLOG(4, "Optimizing " << kname);
   auto options = optimizer.OptionsFor(kname, settings, flat, tile_trials);
 
+  // Each tile option is lowered independently, so when scanning several of
+  // them the kernels are generated concurrently.
+  std::vector<std::future<KernelInfo>> pending;
+  for (size_t i = 1; i < options.size(); i++) {
+    pending.emplace_back(std::async(std::launch::async, [&, i] {
+      return GenerateContractionKernel(kname, settings, c, flat, options[i], inputs, vars, var_rewrites);
+    }));
+  }
   KernelInfo primary;
-  for (size_t i = 0; i < options.size(); i++) {
-    const auto& option = options[i];
-    KernelInfo ki = GenerateContractionKernel(kname, settings, c, flat, option, inputs, vars, var_rewrites);
-    if (i == 0) {
-      primary = ki;
-    } else {
-      primary.candidates.push_back(ki);
-    }
+  if (!options.empty()) {
+    primary = GenerateContractionKernel(kname, settings, c, flat, options[0], inputs, vars, var_rewrites);
+  }
+  for (auto& candidate : pending) {
+    primary.candidates.push_back(candidate.get());
   }
   flat_cache->emplace(flat_key, primary);
   r.kernels.emplace_back(std::move(primary));
@@ -464,6 +518,25 @@ static void ConsiderConsumers(const Program& prog, const Bindings& vars, std::si
   }
 }
 
+// The most distinct tensors a kernel may take as parameters once ConnectedComponents has absorbed independent ops into
+// it; this keeps well within the devices' kernel argument limits.
+static constexpr std::size_t kMaxSiblingKernelParams = 32;
+
+// Returns the tensors read or written by the given ops.
+static std::set<std::string> KernelTensors(const Program& prog, const Bindings& vars, const std::set<size_t>& opidxs) {
+  std::set<std::string> tensors;
+  for (auto opidx : opidxs) {
+    const Op& op = prog.ops[opidx];
+    for (const auto& input : op.inputs) {
+      if (vars.at(input).tag == Binding::TENSOR) {
+        tensors.insert(input);
+      }
+    }
+    tensors.insert(op.output);
+  }
+  return tensors;
+}
+
 static std::set<size_t> ConnectedComponents(const Program& prog, const Bindings& vars, std::size_t root_opidx,
                                             const std::set<size_t>& previously_computed, const UseDef& ud) {
   // This function computes the set of function operations that can be unified with the indicated initial operation,
@@ -518,11 +591,67 @@ static std::set<size_t> ConnectedComponents(const Program& prog, const Bindings&
   }
   seen_vars.emplace(prog.ops[root_opidx].output);
   unified_frontier.push(prog.ops[root_opidx].output);
-  while (!unified_frontier.empty()) {
-    std::string var = std::move(unified_frontier.top());
-    unified_frontier.pop();
-    ConsiderConsumers(prog, vars, root_opidx, previously_computed, ud, &unified, &unified_frontier, &seen_vars, var);
+  auto drain_frontier = [&] {
+    while (!unified_frontier.empty()) {
+      std::string var = std::move(unified_frontier.top());
+      unified_frontier.pop();
+      ConsiderConsumers(prog, vars, root_opidx, previously_computed, ud, &unified, &unified_frontier, &seen_vars, var);
+    }
+  };
+  drain_frontier();
+
+  // Independent elementwise chains of the root's shape -- such as the per-variable weight updates of an optimizer step
+  // -- share no variables for the frontier to follow, but they can still join the kernel if their inputs are available
+  // when the root is issued, saving a kernel launch per chain.  Each absorbed op then extends the set through its own
+  // consumers, as above.  This is limited to elementwise roots, so contraction kernels keep their shape, and by the
+  // number of distinct tensors the kernel would take as parameters.
+#ifndef __APPLE__  // Metal's kernel argument limit (see ConsiderConsumers) leaves no room for this.
+  if (prog.ops[root_opidx].tag == Op::FUNCTION) {
+    const auto& root_dims = vars.at(prog.ops[root_opidx].output).shape.dims;
+    std::set<std::string> params = KernelTensors(prog, vars, unified);
+    for (std::size_t opidx = root_opidx + 1; opidx < prog.ops.size(); ++opidx) {
+      const Op& op = prog.ops[opidx];
+      if (op.tag != Op::FUNCTION || op.f.is_special() || unified.count(opidx) || previously_computed.count(opidx) ||
+          vars.at(op.output).tag != Binding::TENSOR || vars.at(op.output).shape.dims != root_dims ||
+          !CanUnifyOp(prog, vars, root_opidx, opidx)) {
+        continue;
+      }
+      bool available = true;
+      std::set<std::string> added{op.output};
+      for (const auto& input : op.inputs) {
+        if (vars.at(input).tag != Binding::TENSOR) {
+          continue;
+        }
+        auto it = ud.op_defs().find(input);
+        if (it != ud.op_defs().end() && root_opidx < it->second && !unified.count(it->second) &&
+            !previously_computed.count(it->second) && prog.ops[it->second].tag != Op::CONSTANT) {
+          available = false;
+          break;
+        }
+        if (!params.count(input)) {
+          added.insert(input);
+        }
+      }
+      if (!available) {
+        continue;
+      }
+      if (params.size() + added.size() > kMaxSiblingKernelParams) {
+        break;
+      }
+      IVLOG(4, "Unifying independent op " << op << " with " << prog.ops[root_opidx]);
+      unified.insert(opidx);
+      for (const auto& var : op.inputs) {
+        if (vars.at(var).tag == Binding::TENSOR && seen_vars.emplace(var).second) {
+          unified_frontier.push(var);
+        }
+      }
+      seen_vars.emplace(op.output);
+      unified_frontier.push(op.output);
+      drain_frontier();
+      params = KernelTensors(prog, vars, unified);
+    }
   }
+#endif
 
   return unified;
 }
@@ -803,6 +932,42 @@ static void DoUnification(FlatContraction* flat, std::set<std::size_t>* computed
   }
 }
 
+// Whether a partial contraction may write straight into the buffer of its default (already rewritten to dflt), rather
+// than into a fresh copy of it.  This is what lets a chain of partial updates -- such as the per-timestep outputs of an
+// unrolled recurrence -- fill in one persistent buffer instead of copying it at every step.  It requires that nothing
+// else ever reads the default's buffer, since the scheduler orders writes after earlier writes but not after earlier
+// reads, and that neither side is a program input or output.
+static bool CanUpdateDefaultInPlace(const Program& prog, size_t opidx, const std::string& dflt, const Bindings& vars,
+                                    const ShapeMap& inputs, const ShapeMap& outputs, const VarRewrites& var_rewrites) {
+  const Op& op = prog.ops[opidx];
+  if (inputs.count(dflt) || outputs.count(op.output)) {
+    return false;
+  }
+  const auto& dflt_binding = vars.at(dflt);
+  if (dflt_binding.tag != Binding::TENSOR || !(dflt_binding.shape == vars.at(op.output).shape)) {
+    return false;
+  }
+  for (const auto& kvp : outputs) {
+    if (var_rewrites.Lookup(kvp.first) == dflt) {
+      return false;
+    }
+  }
+  for (size_t i = 0; i < prog.ops.size(); i++) {
+    const Op& other = prog.ops[i];
+    for (const auto& input : other.inputs) {
+      if (var_rewrites.Lookup(input) == dflt) {
+        return false;
+      }
+    }
+    // Earlier in-place updates of the same buffer are writes, which the scheduler does order.
+    if (i != opidx && other.tag == Op::CONTRACTION && other.c.use_default != "" &&
+        var_rewrites.Lookup(other.c.use_default) == dflt && var_rewrites.Lookup(other.output) != dflt) {
+      return false;
+    }
+  }
+  return true;
+}
+
 static KernelList Compile(const Program& orig_prog, const ShapeMap& inputs, const ShapeMap& outputs,
                           const HardwareSettings& settings, const std::string& kid, size_t tile_trials,
                           const TileOptimizer& optimizer) {
@@ -852,11 +1017,20 @@ static KernelList Compile(const Program& orig_prog, const ShapeMap& inputs, cons
         // N.B. We currently don't unify kernels with subsequent
         // operations unless they cover the entire output space.
         if (op.c.use_default != "") {
-          r.kernels.push_back(GenCopy(tshapes[0], op.output, op.c.use_default, "copy_" + kname));
+          std::string dflt = r.var_rewrites.Lookup(op.c.use_default);
+          if (CanUpdateDefaultInPlace(prog, i, dflt, vars, inputs, outputs, r.var_rewrites)) {
+            IVLOG(3, "Updating " << dflt << " in place to produce " << op.output);
+            r.var_rewrites.Insert(op.output, dflt);
+            flat.output = dflt;
+            flat.kernel_outputs.push_back(dflt);
+          } else {
+            r.kernels.push_back(GenCopy(tshapes[0], op.output, dflt, "copy_" + kname));
+            flat.kernel_outputs.push_back(op.output);
+          }
         } else {
           r.kernels.push_back(GenZero(tshapes[0], op.output, "zero_" + kname));
+          flat.kernel_outputs.push_back(op.output);
         }
-        flat.kernel_outputs.push_back(op.output);
       } else {
         DoUnification(&flat, &computed, &r.var_rewrites, prog, i, ud, vars, inputs, outputs, out_poly, settings);
       }
@@ -979,6 +1153,49 @@ static KernelList Compile(const Program& orig_prog, const ShapeMap& inputs, cons
   return r;
 }
 
+namespace {
+
+// Prints a kernel function with each name replaced by its order of first
+// appearance, so that kernels which differ only in the names of the kernel,
+// its parameters, and its locals print identically.
+class CanonicalPrint : public sem::Print {
+ protected:
+  void emitName(const std::string& name) final {
+    auto it = names_.emplace(name, names_.size()).first;
+    emit("$" + std::to_string(it->second));
+  }
+
+ private:
+  std::map<std::string, size_t> names_;
+};
+
+}  // namespace
+
+void DeduplicateKernels(std::vector<KernelInfo>* kernels) {
+  std::map<std::string, const KernelInfo*> canonical;
+  size_t shared = 0;
+  for (auto& ki : *kernels) {
+    if (ki.ktype != KernelType::kFunction || !ki.kfunc || !ki.candidates.empty()) {
+      continue;
+    }
+    CanonicalPrint print;
+    print.Visit(*ki.kfunc);
+    std::ostringstream key;
+    key << ki.gwork[0] << " " << ki.gwork[1] << " " << ki.gwork[2] << " " << ki.lwork[0] << " " << ki.lwork[1] << " "
+        << ki.lwork[2] << "\n"
+        << print.str();
+    auto it = canonical.emplace(key.str(), &ki).first;
+    if (it->second != &ki) {
+      // Parameters bind positionally, so this kernel may run the other's code.
+      IVLOG(3, "Kernel " << ki.kname << " duplicates " << it->second->kname);
+      ki.kname = it->second->kname;
+      ki.kfunc = it->second->kfunc;
+      shared++;
+    }
+  }
+  IVLOG(1, "Deduplicated " << shared << " of " << kernels->size() << " kernels");
+}
+
 KernelList GenerateProgram(const Program& prog, const ShapeMap& inputs, const ShapeMap& outputs,
                            const HardwareSettings& settings, const TileOptimizer& optimizer, const std::string& id,
                            size_t tile_trials) {
@@ -998,6 +1215,7 @@ KernelList GenerateProgram(const Program& prog, const ShapeMap& inputs, const Sh
   KernelList result;
   result = Compile(prog, inputs, outputs, settings, kid, tile_trials, optimizer);
   Simplify(result.kernels);
+  DeduplicateKernels(&result.kernels);
   return result;
 }
 
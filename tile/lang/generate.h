@@ -1,6 +1,7 @@
 #pragma once
 
 #include <array>
+#include <functional>
 #include <limits>
 #include <map>
 #include <memory>
@@ -29,6 +30,8 @@ struct DirectSettings {
   bool use_global;   // Use only global memory? (No local)
   // Memory width effects cache estimates and kernel loop orders
   uint64_t mem_width;  // How wide is a cache line
+  // Subgroup width for reductions (zero if unsupported); a device property, so not cached
+  uint64_t subgroup_size = 0;
 
   TRANSFER_OBJECT {
     VERSION(0);
@@ -49,6 +52,8 @@ struct HardwareSettings : public DirectSettings {
   uint64_t goal_flops_per_byte;                   // Where do we hit the ceiling on flops/byte
   std::vector<std::size_t> goal_dimension_sizes;  // How big to make each dimension in a work group
   bool disable_io_aliasing;
+  bool native_half = false;        // Does the device have native half-precision arithmetic?
+  bool fp32_accumulation = false;  // Accumulate half-precision contractions as floats
 };
 
 typedef std::array<size_t, 3> GridSize;
@@ -85,6 +90,9 @@ struct KernelInfo {
   std::string kname;
   std::string comments;
   std::string key;
+  // Tells apart alternative versions of a kernel (its candidates) which share its key, settings, and tile, so that
+  // the TileCache times each separately.  Empty unless the versions differ in some other way.
+  std::string variant;
   DirectSettings settings;
   TileOption tile;
   std::shared_ptr<sem::Function> kfunc;
@@ -101,6 +109,9 @@ struct KernelInfo {
   // The map from each output to the set of inputs it's allowed to alias.
   // TODO: Consider unifying this map with outputs.
   std::map<std::string, std::set<std::string>> safe_self_aliases;
+  // Regenerates the kernel for a different number of threads per workgroup, for backends which tune the launch
+  // dimensions after building.  Only set for contraction kernels.
+  std::function<KernelInfo(uint64_t threads)> regenerate;
 };
 
 class VarRewrites {
@@ -115,6 +126,8 @@ class VarRewrites {
 
   void Insert(const std::string& from, const std::string& to) { rewrites_.emplace(from, to); }
 
+  const std::unordered_map<std::string, std::string>& rewrites() const { return rewrites_; }
+
  private:
   std::unordered_map<std::string, std::string> rewrites_;
 };
@@ -141,6 +154,12 @@ class TileOptimizer {
   std::vector<TileCostFunction> models_;
 };
 
+// Points each kernel which matches an earlier kernel up to the names of its
+// function, parameters, and locals at the earlier kernel's name and function,
+// so that the HAL compiles the shared code once.  Kernels which still carry
+// tiling candidates are left alone.
+void DeduplicateKernels(std::vector<KernelInfo>* kernels);
+
 KernelList GenerateProgram(const Program& prog, const ShapeMap& inputs, const ShapeMap& outputs,
                            const HardwareSettings& settings, const TileOptimizer& optimizer,
                            const std::string& id = "no_id", size_t tile_trials = 1);
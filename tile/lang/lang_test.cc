@@ -160,6 +160,46 @@ TEST_CASE("Optimization of Convolution", "[conv_opt][opt]") {
   REQUIRE(score2 > .4);
 }
 
+TEST_CASE("Vector width by element size", "[opt]") {
+  REQUIRE(VectorWidth(4, 4) == 4);
+  REQUIRE(VectorWidth(4, 8) == 4);
+  REQUIRE(VectorWidth(4, 2) == 8);
+  REQUIRE(VectorWidth(4, 1) == 16);
+  REQUIRE(VectorWidth(8, 1) == 16);
+}
+
+TEST_CASE("Subgroup merge", "[emit]") {
+  FlatContraction op;
+  op.names = {"x"};
+  op.ranges = {256};
+  op.access.resize(2);
+  op.access[0].type = DataType::FLOAT32;
+  op.access[0].strides = {0};
+  op.access[1].type = DataType::FLOAT32;
+  op.access[1].strides = {1};
+  op.agg_type = DataType::FLOAT32;
+  op.agg_op = AggregationOp::SUM;
+  op.comb_op = CombinationOp::NONE;
+  op.output = "O";
+  op.kernel_outputs = {"O"};
+  Bindings vars;
+  vars.emplace("O", Binding(TensorShape(DataType::FLOAT32, {})));
+  vars.emplace("A", Binding(TensorShape(DataType::FLOAT32, {{1, 256}})));
+  DirectSettings settings = TestGPU();
+  proto::PerfStats perf;
+
+  auto plain = GenContract("plain", settings, op, {256}, vars, {"A"}, perf);
+  REQUIRE(plain.kfunc->subgroup_size == 0);
+  REQUIRE(sem::Print(*plain.kfunc).str().find("sub_group_shuffle_xor") == std::string::npos);
+
+  settings.subgroup_size = 8;
+  auto shuffled = GenContract("shuffled", settings, op, {256}, vars, {"A"}, perf);
+  REQUIRE(shuffled.kfunc->subgroup_size == 8);
+  std::string code = sem::Print(*shuffled.kfunc).str();
+  REQUIRE(code.find("sub_group_shuffle_xor(merge_val, 4)") != std::string::npos);
+  REQUIRE(code.find("sub_group_shuffle_xor(merge_val, 8)") == std::string::npos);
+}
+
 TEST_CASE("Vectorized Flop Computation", "[conv_opt][opt]") {
   Parser p;
   auto c = p.ParseContraction("O[n, x, y, co] = +(K[i, j, co, ci] * I[n, x+i, y+j, ci])");
@@ -505,6 +545,58 @@ TEST_CASE("JustRelu", "[emit]") {
   REQUIRE(r.kernels[0].outputs == std::vector<std::string>({"Y"}));
 }
 
+TEST_CASE("UnifiesIndependentUpdates", "[emit]") {
+  Parser parser;
+  Program prog = parser.Parse(
+      "function (A[N], B[N], C[M], GA[N], GB[N], GC[M]) -> (NA, NB, NC) { "
+      "  NA = A - 0.1 * GA; "
+      "  NB = B - 0.1 * GB; "
+      "  NC = C - 0.1 * GC; "
+      "}");
+  ShapeMap inputs;
+  inputs.emplace("A", SimpleShape(DataType::FLOAT32, {100}));
+  inputs.emplace("B", SimpleShape(DataType::FLOAT32, {100}));
+  inputs.emplace("C", SimpleShape(DataType::FLOAT32, {7}));
+  inputs.emplace("GA", SimpleShape(DataType::FLOAT32, {100}));
+  inputs.emplace("GB", SimpleShape(DataType::FLOAT32, {100}));
+  inputs.emplace("GC", SimpleShape(DataType::FLOAT32, {7}));
+  ShapeMap outputs;
+  outputs.emplace("NA", SimpleShape(DataType::FLOAT32, {100}));
+  outputs.emplace("NB", SimpleShape(DataType::FLOAT32, {100}));
+  outputs.emplace("NC", SimpleShape(DataType::FLOAT32, {7}));
+  TileOptimizer optimizer;
+  KernelList r = GenerateProgram(prog, inputs, outputs, TestGPU(), optimizer, "ID");
+  // The two updates of the same shape share a kernel; the third can't.
+  REQUIRE(r.kernels.size() == 2);
+  REQUIRE(r.kernels[0].outputs == std::vector<std::string>({"NA", "NB"}));
+  REQUIRE(r.kernels[1].outputs == std::vector<std::string>({"NC"}));
+}
+
+TEST_CASE("UpdatesDefaultsInPlace", "[emit]") {
+  Parser parser;
+  Program prog = parser.Parse(
+      "function (A[N], B[N], C[N]) -> (O) { "
+      "  T0[0, i : 3, N] = =(A[i]); "
+      "  T1[1, i : 3, N] = =(B[i]) default T0; "
+      "  O[2, i : 3, N] = =(C[i]) default T1; "
+      "}");
+  ShapeMap inputs;
+  inputs.emplace("A", SimpleShape(DataType::FLOAT32, {100}));
+  inputs.emplace("B", SimpleShape(DataType::FLOAT32, {100}));
+  inputs.emplace("C", SimpleShape(DataType::FLOAT32, {100}));
+  ShapeMap outputs;
+  outputs.emplace("O", SimpleShape(DataType::FLOAT32, {3, 100}));
+  TileOptimizer optimizer;
+  KernelList r = GenerateProgram(prog, inputs, outputs, TestGPU(), optimizer, "ID");
+  // T1 is written into T0's buffer rather than a copy of it; the program output still gets its own copy.
+  REQUIRE(r.kernels.size() == 5);
+  REQUIRE(r.kernels[1].outputs == std::vector<std::string>({"T0"}));
+  REQUIRE(r.kernels[2].outputs == std::vector<std::string>({"T0"}));
+  REQUIRE(r.kernels[3].inputs == std::vector<std::string>({"T0"}));
+  REQUIRE(r.kernels[3].outputs == std::vector<std::string>({"O"}));
+  REQUIRE(r.var_rewrites.Lookup("T1") == "T0");
+}
+
 TEST_CASE("NoRedeclare", "[emit]") {
   Parser parser;
   Program prog = parser.Parse("function (X[N]) -> (X) { X = 2*X; }");
@@ -610,6 +702,20 @@ TEST_CASE("ProgGrad", "[deriv]") {
   Program p = ProgGrad(bf.prog());
 }
 
+TEST_CASE("Cached function shapes", "[compose]") {
+  const char* code = "function (A[I,K], B[K,J]) -> (C) { C[i,j : I,J] = +(A[i,k] * B[k,j]); }";
+  auto output_shape = [&](size_t i, size_t j, size_t k) {
+    FunctionApplication app(std::make_shared<BoundFunction>(code));
+    app.SetInput("A", TensorValue::make(nullptr, SimpleShape(DataType::FLOAT32, {i, k})));
+    app.SetInput("B", TensorValue::make(nullptr, SimpleShape(DataType::FLOAT32, {k, j})));
+    return app.GetOutputShape("C");
+  };
+  // The second application of each shape reuses the cached parse and typecheck.
+  REQUIRE(output_shape(2, 3, 4) == SimpleShape(DataType::FLOAT32, {2, 3}));
+  REQUIRE(output_shape(2, 3, 4) == SimpleShape(DataType::FLOAT32, {2, 3}));
+  REQUIRE(output_shape(5, 7, 4) == SimpleShape(DataType::FLOAT32, {5, 7}));
+}
+
 TEST_CASE("Basic Infeasible Constraints", "[infeasible]") {
   IVLOG(1, "We expect the infeasibility test to throw a warning.");
   Parser p;
@@ -87,7 +87,7 @@ void Print::Visit(const FloatConst& n) {
   emit(c + "f");
 }
 
-void Print::Visit(const LookupLVal& n) { emit(n.name); }
+void Print::Visit(const LookupLVal& n) { emitName(n.name); }
 
 void Print::Visit(const LoadExpr& n) { n.inner->Accept(*this); }
 
@@ -110,7 +110,7 @@ void Print::Visit(const DeclareStmt& n) {
   emitTab();
   emitType(n.type);
   emit(" ");
-  emit(n.name);
+  emitName(n.name);
   if (n.type.array) {
     emit("[" + std::to_string(n.type.array) + "]");
   }
@@ -283,13 +283,13 @@ void Print::Visit(const IfStmt& n) {
 void Print::Visit(const ForStmt& n) {
   emitTab();
   emit("for(int ");
-  emit(n.var);
+  emitName(n.var);
   emit(" = 0; ");
-  emit(n.var);
+  emitName(n.var);
   emit(" < ");
   emit(std::to_string(n.num * n.step));
   emit("; ");
-  emit(n.var);
+  emitName(n.var);
   emit(" += ");
   emit(std::to_string(n.step));
   emit(")\n");
@@ -336,7 +336,7 @@ void Print::Visit(const SpecialStmt& n) {
 void Print::Visit(const Function& n) {
   emitType(n.ret);
   emit(" ");
-  emit(n.name);
+  emitName(n.name);
   emit("(");
   bool first_param = true;
   for (const auto& p : n.params) {
@@ -347,7 +347,7 @@ void Print::Visit(const Function& n) {
     }
     emitType(p.first);
     emit(" ");
-    emit(p.second);
+    emitName(p.second);
   }
   emit(")\n");
   n.body->Accept(*this);
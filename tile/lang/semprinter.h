@@ -43,6 +43,8 @@ class Print : public Visitor {
  protected:
   void emit(const std::string& s) { result_ << s; }
   virtual void emitType(const Type& t);
+  // Emits the name of a function, parameter, or variable.
+  virtual void emitName(const std::string& name) { emit(name); }
   void emitTab() { result_ << std::string(indent_ << 1, ' '); }
   std::ostringstream result_;
   size_t indent_ = 0;
@@ -76,6 +76,7 @@ CallExpr::CallExpr(Function f, const std::vector<ExprPtr>& v) : function(f), val
       {Function::POW, "pow"},   {Function::ROUND, "round"},
       {Function::SIN, "sin"},   {Function::SINH, "sinh"},
       {Function::SQRT, "sqrt"}, {Function::SUB_GROUP_BROADCAST, "sub_group_broadcast"},
+      {Function::SUB_GROUP_SHUFFLE_XOR, "sub_group_shuffle_xor"},
       {Function::TAN, "tan"},   {Function::TANH, "tanh"},
   };
   name = names.at(f);
@@ -105,6 +106,7 @@ CallExpr::CallExpr(ExprPtr f, const std::vector<ExprPtr>& v) : vals(v) {
       {"pow", Function::POW},   {"round", Function::ROUND},
       {"sin", Function::SIN},   {"sinh", Function::SINH},
       {"sqrt", Function::SQRT}, {"sub_group_broadcast", Function::SUB_GROUP_BROADCAST},
+      {"sub_group_shuffle_xor", Function::SUB_GROUP_SHUFFLE_XOR},
       {"tan", Function::TAN},   {"tanh", Function::TANH},
   };
   auto it = functions.find(name);
@@ -196,6 +196,7 @@ struct CallExpr : public Expression {
     SINH,
     SQRT,
     SUB_GROUP_BROADCAST,
+    SUB_GROUP_SHUFFLE_XOR,
     TAN,
     TANH,
   };
@@ -1,7 +1,9 @@
 #include "tile/lang/simplifier.h"
 
+#include <map>
 #include <memory>
 #include <string>
+#include <tuple>
 
 #include "tile/lang/scope.h"
 #include "tile/lang/sembuilder.h"
@@ -30,11 +32,31 @@ struct Symbol {
   std::optional<std::string> alias;
 };
 
+// Identifies a simplified expression by its operator and its (already
+// canonical) operands, so that equal expressions share a key regardless of the
+// scope they were simplified in.
+struct ExprKey {
+  char kind;
+  std::string op;
+  int64_t value;
+  const Expression* lhs;
+  const Expression* rhs;
+
+  bool operator<(const ExprKey& other) const {
+    return std::tie(kind, op, value, lhs, rhs) < std::tie(other.kind, other.op, other.value, other.lhs, other.rhs);
+  }
+};
+
+// Maps each simplified expression to its canonical node.  Simplified subtrees
+// are hash-consed through this table, so identical index expressions within
+// and across kernels are simplified once and then shared.
+typedef std::map<ExprKey, ExprPtr> ExprMemo;
+
 class Simplifier : public Visitor {
  public:
-  explicit Simplifier(lang::Scope<Symbol>* scope) : scope_{scope} {}
+  Simplifier(lang::Scope<Symbol>* scope, ExprMemo* memo) : scope_{scope}, memo_{memo} {}
 
-  void Visit(const IntConst& node) override {}
+  void Visit(const IntConst& node) override { Memoize(ExprKey{'i', "", node.value, nullptr, nullptr}); }
 
   void Visit(const FloatConst& node) override {}
 
@@ -56,7 +78,14 @@ class Simplifier : public Visitor {
     // Check if a symbol exists that refers to an IntConst value.
     if (symbol && (*symbol).const_value) {
       // If such a symbol exists, substitute the IntConst expr in directly.
-      new_expr_ = std::make_shared<IntConst>(*(*symbol).const_value);
+      new_expr_ = MakeIntConst(*(*symbol).const_value);
+      return;
+    }
+    auto subscript = std::dynamic_pointer_cast<SubscriptLVal>(node.inner);
+    if (!subscript) {
+      Memoize(ExprKey{'L', ref, 0, nullptr, nullptr});
+    } else if (std::dynamic_pointer_cast<LookupLVal>(subscript->ptr)) {
+      Memoize(ExprKey{'S', ref, 0, subscript->offset.get(), nullptr});
     }
   }
 
@@ -104,10 +133,13 @@ class Simplifier : public Visitor {
 
   void Visit(const UnaryExpr& node) override {
     const_cast<UnaryExpr&>(node).inner = EvalExpr(node.inner);
+    if (Memoize(ExprKey{'u', node.op, 0, node.inner.get(), nullptr})) {
+      return;
+    }
     auto int_const = std::dynamic_pointer_cast<IntConst>(node.inner);
     if (node.op == "!") {
       if (int_const) {
-        new_expr_ = std::make_shared<IntConst>(!int_const->value);
+        new_expr_ = MakeIntConst(!int_const->value);
       }
     }
   }
@@ -115,13 +147,16 @@ class Simplifier : public Visitor {
   void Visit(const BinaryExpr& node) override {
     const_cast<BinaryExpr&>(node).lhs = EvalExpr(node.lhs);
     const_cast<BinaryExpr&>(node).rhs = EvalExpr(node.rhs);
+    if (Memoize(ExprKey{'b', node.op, 0, node.lhs.get(), node.rhs.get()})) {
+      return;
+    }
 
     auto lhs_int_const = std::dynamic_pointer_cast<IntConst>(node.lhs);
     auto rhs_int_const = std::dynamic_pointer_cast<IntConst>(node.rhs);
 
     if (node.op == "*") {
       if (lhs_int_const && rhs_int_const) {
-        new_expr_ = std::make_shared<IntConst>(lhs_int_const->value * rhs_int_const->value);
+        new_expr_ = MakeIntConst(lhs_int_const->value * rhs_int_const->value);
       } else {
         if (CheckIntConstValue(rhs_int_const, 1)) {
           // Check for (L * 1), return (L)
@@ -139,7 +174,7 @@ class Simplifier : public Visitor {
       }
     } else if (node.op == "/") {
       if (lhs_int_const && rhs_int_const) {
-        new_expr_ = std::make_shared<IntConst>(lhs_int_const->value / rhs_int_const->value);
+        new_expr_ = MakeIntConst(lhs_int_const->value / rhs_int_const->value);
       } else {
         if (CheckIntConstValue(rhs_int_const, 1)) {
           // Check for (L / 1), return (L)
@@ -151,7 +186,7 @@ class Simplifier : public Visitor {
       }
     } else if (node.op == "+") {
       if (lhs_int_const && rhs_int_const) {
-        new_expr_ = std::make_shared<IntConst>(lhs_int_const->value + rhs_int_const->value);
+        new_expr_ = MakeIntConst(lhs_int_const->value + rhs_int_const->value);
       } else {
         if (CheckIntConstValue(rhs_int_const, 0)) {
           // Check for (L + 0), return (L)
@@ -163,7 +198,7 @@ class Simplifier : public Visitor {
       }
     } else if (node.op == "-") {
       if (lhs_int_const && rhs_int_const) {
-        new_expr_ = std::make_shared<IntConst>(lhs_int_const->value - rhs_int_const->value);
+        new_expr_ = MakeIntConst(lhs_int_const->value - rhs_int_const->value);
       } else {
         if (CheckIntConstValue(rhs_int_const, 0)) {
           // Check for (L - 0), return (L)
@@ -173,31 +208,31 @@ class Simplifier : public Visitor {
     } else if (node.op == "%") {
       if (CheckIntConstValue(rhs_int_const, 1)) {
         // Check for (L % 1), return (0)
-        new_expr_ = std::make_shared<IntConst>(0);
+        new_expr_ = MakeIntConst(0);
       }
     } else if (node.op == "<") {
       if (lhs_int_const && rhs_int_const) {
-        new_expr_ = std::make_shared<IntConst>(lhs_int_const->value < rhs_int_const->value);
+        new_expr_ = MakeIntConst(lhs_int_const->value < rhs_int_const->value);
       }
     } else if (node.op == ">") {
       if (lhs_int_const && rhs_int_const) {
-        new_expr_ = std::make_shared<IntConst>(lhs_int_const->value > rhs_int_const->value);
+        new_expr_ = MakeIntConst(lhs_int_const->value > rhs_int_const->value);
       }
     } else if (node.op == "<=") {
       if (lhs_int_const && rhs_int_const) {
-        new_expr_ = std::make_shared<IntConst>(lhs_int_const->value <= rhs_int_const->value);
+        new_expr_ = MakeIntConst(lhs_int_const->value <= rhs_int_const->value);
       }
     } else if (node.op == ">=") {
       if (lhs_int_const && rhs_int_const) {
-        new_expr_ = std::make_shared<IntConst>(lhs_int_const->value >= rhs_int_const->value);
+        new_expr_ = MakeIntConst(lhs_int_const->value >= rhs_int_const->value);
       }
     } else if (node.op == "==") {
       if (lhs_int_const && rhs_int_const) {
-        new_expr_ = std::make_shared<IntConst>(lhs_int_const->value == rhs_int_const->value);
+        new_expr_ = MakeIntConst(lhs_int_const->value == rhs_int_const->value);
       }
     } else if (node.op == "&&") {
       if (lhs_int_const && rhs_int_const) {
-        new_expr_ = std::make_shared<IntConst>(lhs_int_const->value && rhs_int_const->value);
+        new_expr_ = MakeIntConst(lhs_int_const->value && rhs_int_const->value);
       } else if (lhs_int_const) {
         if (lhs_int_const->value == 0) {
           // Check for (0 && R), return (0)
@@ -217,7 +252,7 @@ class Simplifier : public Visitor {
       }
     } else if (node.op == "||") {
       if (lhs_int_const && rhs_int_const) {
-        new_expr_ = std::make_shared<IntConst>(lhs_int_const->value && rhs_int_const->value);
+        new_expr_ = MakeIntConst(lhs_int_const->value && rhs_int_const->value);
       } else if (lhs_int_const) {
         if (lhs_int_const->value == 0) {
           // Check for (0 || R), return (R)
@@ -237,7 +272,7 @@ class Simplifier : public Visitor {
       }
     } else if (node.op == "&") {
       if (lhs_int_const && rhs_int_const) {
-        new_expr_ = std::make_shared<IntConst>(lhs_int_const->value & rhs_int_const->value);
+        new_expr_ = MakeIntConst(lhs_int_const->value & rhs_int_const->value);
       } else if (lhs_int_const) {
         if (lhs_int_const->value == 0) {
           // Check for (0 & R), return (0)
@@ -300,7 +335,9 @@ class Simplifier : public Visitor {
 
   void Visit(const LimitConst& node) override {}
 
-  void Visit(const IndexExpr& node) override {}
+  void Visit(const IndexExpr& node) override {
+    Memoize(ExprKey{'x', std::to_string(node.type), static_cast<int64_t>(node.dim), nullptr, nullptr});
+  }
 
   void Visit(const Block& node) override {
     lang::Scope<Symbol> scope{scope_};
@@ -373,6 +410,27 @@ class Simplifier : public Visitor {
   void Visit(const Function& node) override { const_cast<Function&>(node).body = EvalStmt(node.body); }
 
  private:
+  // Looks up the canonical node for the expression being visited.  On a hit,
+  // that node becomes the result; otherwise the key is remembered so that
+  // EvalExpr can record the simplified result under it.
+  bool Memoize(const ExprKey& key) {
+    auto it = memo_->find(key);
+    if (it != memo_->end()) {
+      new_expr_ = it->second;
+      return true;
+    }
+    key_ = key;
+    return false;
+  }
+
+  ExprPtr MakeIntConst(int64_t value) {
+    auto& entry = (*memo_)[ExprKey{'i', "", value, nullptr, nullptr}];
+    if (!entry) {
+      entry = std::make_shared<IntConst>(value);
+    }
+    return entry;
+  }
+
   bool CheckIntConstValue(const std::shared_ptr<IntConst> int_const, int64_t value) {
     return (int_const && int_const->value == value);
   }
@@ -419,18 +477,19 @@ class Simplifier : public Visitor {
   }
 
   ExprPtr EvalExpr(const ExprPtr& expr) {
-    Simplifier eval(scope_);
+    Simplifier eval(scope_, memo_);
     expr->Accept(eval);
-    if (eval.new_expr_) {
-      return eval.new_expr_;
+    ExprPtr result = eval.new_expr_ ? eval.new_expr_ : expr;
+    if (eval.key_) {
+      memo_->emplace(*eval.key_, result);
     }
-    return expr;
+    return result;
   }
 
   StmtPtr EvalStmt(const StmtPtr& stmt) { return EvalStmt(stmt, scope_); }
 
   StmtPtr EvalStmt(const StmtPtr& stmt, lang::Scope<Symbol>* scope) {
-    Simplifier eval(scope);
+    Simplifier eval(scope, memo_);
     stmt->Accept(eval);
     if (eval.new_stmt_) {
       auto ifstmt = std::dynamic_pointer_cast<IfStmt>(eval.new_stmt_);
@@ -443,7 +502,7 @@ class Simplifier : public Visitor {
   }
 
   std::string Resolve(const LValPtr& ptr) {
-    Simplifier eval(scope_);
+    Simplifier eval(scope_, memo_);
     ptr->Accept(eval);
     return eval.ref_;
   }
@@ -452,8 +511,10 @@ class Simplifier : public Visitor {
   ExprPtr new_expr_;
   StmtPtr new_stmt_;
   std::string ref_;
+  std::optional<ExprKey> key_;
 
   lang::Scope<Symbol>* scope_;
+  ExprMemo* memo_;
 };
 
 }  // namespace sem
@@ -461,11 +522,15 @@ class Simplifier : public Visitor {
 namespace lang {
 void Simplify(sem::StmtPtr stmt) {
   lang::Scope<sem::Symbol> scope;
-  sem::Simplifier simplifier{&scope};
+  sem::ExprMemo memo;
+  sem::Simplifier simplifier{&scope, &memo};
   stmt->Accept(simplifier);
 }
 
 void Simplify(const std::vector<KernelInfo>& kernels) {
+  // One memo serves every kernel, so the many near-identical kernels of a
+  // program share their simplified index expressions.
+  sem::ExprMemo memo;
   for (const auto& ki : kernels) {
     if (VLOG_IS_ON(4)) {
       sem::Print emit_debug(*ki.kfunc);
@@ -475,12 +540,12 @@ void Simplify(const std::vector<KernelInfo>& kernels) {
     }
     {
       lang::Scope<sem::Symbol> scope;
-      sem::Simplifier simplifier{&scope};
+      sem::Simplifier simplifier{&scope, &memo};
       ki.kfunc->Accept(simplifier);
     }
     for (auto& candidate : ki.candidates) {
       lang::Scope<sem::Symbol> scope;
-      sem::Simplifier simplifier{&scope};
+      sem::Simplifier simplifier{&scope, &memo};
       candidate.kfunc->Accept(simplifier);
     }
   }
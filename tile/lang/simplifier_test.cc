@@ -346,6 +346,33 @@ TestParam Contraction() {
 
 INSTANTIATE_TEST_CASE_P(Samples, SimplifierTest, ::testing::Values(Basic(), Contraction()));
 
+TEST(SimplifierTest, SharesIdenticalExpressions) {
+  using namespace sem::builder;  // NOLINT
+
+  sem::Type index_type{sem::Type::INDEX};
+  auto make_kernel = [&](const std::string& name) {
+    auto tid = _("tid");
+    return _Function(name, sem::Type{}, {},
+                     {_Declare(index_type, "tid", _Index(sem::IndexExpr::LOCAL, 0)),
+                      _DeclareConst(index_type, "one", 1),
+                      _Declare(index_type, "idx", ((tid / 4) * _("one")) + (tid % 4))});
+  };
+  auto init_of = [](const KernelInfo& ki) {
+    auto body = std::dynamic_pointer_cast<sem::Block>(ki.kfunc->body);
+    return std::dynamic_pointer_cast<sem::DeclareStmt>(body->statements.back())->init;
+  };
+
+  KernelInfo k1;
+  k1.kfunc = make_kernel("k1");
+  KernelInfo k2;
+  k2.kfunc = make_kernel("k2");
+  std::vector<KernelInfo> kernels{k1, k2};
+  Simplify(kernels);
+
+  EXPECT_EQ(sem::Print(*init_of(k1)).str(), "((tid / 4) + (tid % 4))");
+  EXPECT_EQ(init_of(k1).get(), init_of(k2).get());
+}
+
 }  // namespace lang
 }  // namespace tile
 }  // namespace vertexai
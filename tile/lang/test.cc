@@ -15,7 +15,7 @@
 int main(int argc, char* const argv[]) {
   // This is nearly the worst possible command line parsing
   if (memcmp(argv[argc - 1], "-v", 2) == 0) {
-    el::Loggers::setVerboseLevel(std::atoi(argv[argc - 1] + 2));
+    vertexai::SetVerbosity(std::atoi(argv[argc - 1] + 2));
     return Catch::Session().run(argc - 1, argv);
   } else {
     // el::Loggers::setVerboseLevel(1);
@@ -1,15 +1,38 @@
-
 #include "tile/lang/tile_cache.h"
 
+#include <sstream>
+
 #include "base/util/env.h"
 #include "base/util/json_transfer.h"
+#include "base/util/logging.h"
 
 namespace vertexai {
 namespace tile {
 namespace lang {
 
+namespace {
+
+#ifdef _WIN32
+const char kPathListSeparator = ';';
+#else
+const char kPathListSeparator = ':';
+#endif
+
+std::string CacheKey(const std::string& device, const std::string& key) { return device + "\n" + key; }
+
+}  // namespace
+
 TileCache::TileCache(const std::string& filename, bool use_env) {
   std::string openname = filename;
+  if (use_env) {
+    std::stringstream readonly{env::Get("PLAIDML_TILE_CACHE_READONLY")};
+    std::string path;
+    while (std::getline(readonly, path, kPathListSeparator)) {
+      if (path.length()) {
+        Merge(path);
+      }
+    }
+  }
   if (filename == "") {
     if (!use_env) {
       return;
@@ -21,15 +44,7 @@ TileCache::TileCache(const std::string& filename, bool use_env) {
   }
   file_.exceptions(std::fstream::failbit | std::fstream::badbit);
   file_.open(openname, std::fstream::in | std::fstream::out | std::fstream::app);
-  file_.seekp(0);
-  std::string line;
-  file_.exceptions(std::fstream::badbit);
-  while (std::getline(file_, line)) {
-    Entry e = inline_json_deserialize<Entry>(line);
-    AddEntry(e.key, e.subkey, e.value);
-  }
-  file_.clear();
-  file_.exceptions(std::fstream::failbit | std::fstream::badbit);
+  ReadNewEntries();
 }
 
 TileCache* TileCache::Instance() {
@@ -37,38 +52,103 @@ TileCache* TileCache::Instance() {
   return &instance;
 }
 
-void TileCache::AddEntry(const std::string& key, const DirectSettings& settings, const std::vector<uint64_t>& tile_size,
-                         int64_t dur) {
+void TileCache::AddEntry(const std::string& device, const std::string& key, const DirectSettings& settings,
+                         const std::vector<uint64_t>& tile_size, int64_t dur) {
   Entry e;
+  e.device = device;
   e.key = key;
   e.subkey = Subkey(settings, tile_size);
   e.value = dur;
-  AddEntry(key, e.subkey, dur);
-  if (file_.is_open()) {
-    std::string row = json_serialize(e);
-    file_.write(row.data(), row.size());
-    file_.flush();
-  }
+  std::lock_guard<std::mutex> lock(mu_);
+  AddEntry(e);
+  WriteEntry(e);
 }
 
-int64_t TileCache::GetDuration(const std::string& key, const DirectSettings& settings,
+int64_t TileCache::GetDuration(const std::string& device, const std::string& key, const DirectSettings& settings,
                                const std::vector<uint64_t>& tile_size) {
-  auto it = cache_.find(key);
-  if (it == cache_.end()) {
-    return -1;
+  std::lock_guard<std::mutex> lock(mu_);
+  Subkey subkey(settings, tile_size);
+  auto lookup = [&]() -> int64_t {
+    auto it = cache_.find(CacheKey(device, key));
+    if (it == cache_.end()) {
+      return -1;
+    }
+    auto it2 = it->second.times.find(subkey);
+    if (it2 == it->second.times.end()) {
+      return -1;
+    }
+    return it2->second;
+  };
+  int64_t dur = lookup();
+  if (dur < 0 && file_.is_open()) {
+    // Another process sharing the file may have timed it since.
+    ReadNewEntries();
+    dur = lookup();
   }
-  auto it2 = it->second.times.find(Subkey(settings, tile_size));
-  if (it2 == it->second.times.end()) {
-    return -1;
+  return dur;
+}
+
+void TileCache::Merge(const std::string& filename, bool persist) {
+  std::ifstream in(filename);
+  if (!in) {
+    LOG(WARNING) << "Unable to open tile cache " << filename;
+    return;
   }
-  return it2->second;
+  std::lock_guard<std::mutex> lock(mu_);
+  std::string line;
+  while (std::getline(in, line)) {
+    try {
+      Entry e = inline_json_deserialize<Entry>(line);
+      if (AddEntry(e) && persist) {
+        WriteEntry(e);
+      }
+    } catch (const std::exception& ex) {
+      IVLOG(1, "Skipping malformed tile cache entry in " << filename << ": " << ex.what());
+    }
+  }
+}
+
+bool TileCache::AddEntry(const Entry& e) {
+  PerFC& p = cache_[CacheKey(e.device, e.key)];
+  auto it = p.times.find(e.subkey);
+  if (it != p.times.end() && it->second <= e.value) {
+    return false;
+  }
+  p.times[e.subkey] = e.value;
+  if (p.times.size() == 1 || p.times[p.best] > e.value) {
+    p.best = e.subkey;
+  }
+  return true;
+}
+
+void TileCache::ReadNewEntries() {
+  file_.exceptions(std::fstream::badbit);
+  file_.clear();
+  file_.seekg(read_pos_);
+  std::string line;
+  while (std::getline(file_, line)) {
+    if (file_.eof()) {
+      // A trailing line without its newline is still being written.
+      break;
+    }
+    read_pos_ = file_.tellg();
+    try {
+      AddEntry(inline_json_deserialize<Entry>(line));
+    } catch (const std::exception& ex) {
+      IVLOG(1, "Skipping malformed tile cache entry: " << ex.what());
+    }
+  }
+  file_.clear();
+  file_.exceptions(std::fstream::failbit | std::fstream::badbit);
 }
 
-void TileCache::AddEntry(const std::string& key, const Subkey& subkey, int64_t dur) {
-  PerFC& p = cache_[key];
-  p.times[subkey] = dur;
-  if (p.times.size() == 1 || p.times[p.best] > dur) {
-    p.best = subkey;
+void TileCache::WriteEntry(const Entry& e) {
+  if (file_.is_open()) {
+    // Each entry is written with a single call, so appends from concurrent
+    // writers do not interleave.
+    std::string row = json_serialize(e);
+    file_.write(row.data(), row.size());
+    file_.flush();
   }
 }
 
@@ -4,6 +4,7 @@
 #include <fstream>
 #include <limits>
 #include <map>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -14,17 +15,30 @@ namespace vertexai {
 namespace tile {
 namespace lang {
 
+// Records measured kernel durations by tile size, so tile scans need not be
+// repeated.  Timings are keyed by a device fingerprint (supplied by the caller,
+// and expected to cover the driver version) as well as the kernel, so one cache
+// may be shared by several machines.  The cache file holds one JSON entry per
+// line and is only ever appended to; concurrent writers each append whole
+// lines, and entries written by other processes are picked up on a miss.
 class TileCache {
  public:
   // Construct a cache, if given a filename, use that for storage
   explicit TileCache(const std::string& filename = "", bool use_env = false);
-  // Get the 'singlton' instance, loads for PLAIDML_TILE_CACHE if set
+  // Get the 'singlton' instance, which loads the read-only caches listed in
+  // PLAIDML_TILE_CACHE_READONLY (e.g. pre-tuned caches shipped with a
+  // release), and stores new timings in PLAIDML_TILE_CACHE if set
   static TileCache* Instance();
   // Add a new entry with a duration
-  void AddEntry(const std::string& key, const DirectSettings& settings, const std::vector<uint64_t>& tile_size,
-                int64_t dur);
+  void AddEntry(const std::string& device, const std::string& key, const DirectSettings& settings,
+                const std::vector<uint64_t>& tile_size, int64_t dur);
   // Checks for an exact matching entry (to skip tile scan for repeats), or -1 if not found
-  int64_t GetDuration(const std::string& key, const DirectSettings& settings, const std::vector<uint64_t>& tile_size);
+  int64_t GetDuration(const std::string& device, const std::string& key, const DirectSettings& settings,
+                      const std::vector<uint64_t>& tile_size);
+  // Loads the entries of another cache file, keeping the faster time for any
+  // entry present in both.  If persist is set, entries which improve on this
+  // cache are also appended to its own file, merging the two on disk.
+  void Merge(const std::string& filename, bool persist = false);
 
  private:
   struct Subkey {
@@ -43,15 +57,21 @@ class TileCache {
   };
 
   struct Entry {
+    std::string device;
     std::string key;
     TileCache::Subkey subkey;
     int64_t value;
 
+    // Version 0 entries predate the device fingerprint; they load with an
+    // empty device, which no lookup matches.
     TRANSFER_OBJECT {
-      VERSION(0);
+      VERSION(1);
       FIELD(key);
       FIELD(subkey);
       FIELD(value);
+      if (GET_VERSION() >= 1) {
+        FIELD(device);
+      }
     }
   };
 
@@ -60,11 +80,17 @@ class TileCache {
     std::map<Subkey, int64_t> times;
   };
 
-  void AddEntry(const std::string& key, const Subkey& subkey, int64_t dur);
+  // Returns true if the entry was new or faster than the one it replaced.
+  bool AddEntry(const Entry& e);
+  // Loads the complete entries appended to the file since it was last read.
+  void ReadNewEntries();
+  void WriteEntry(const Entry& e);
 
+  std::mutex mu_;
   std::map<const std::string, PerFC> cache_;
 
   std::fstream file_;
+  std::streamoff read_pos_ = 0;
 };
 
 }  // namespace lang
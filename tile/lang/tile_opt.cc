@@ -135,6 +135,14 @@ FlatContraction Vectorize(const FlatContraction& iop, uint64_t vec_size) {  // N
   return op;
 }
 
+uint64_t VectorWidth(uint64_t vec_size, uint64_t elem_bytes) {
+  uint64_t width = vec_size;
+  for (uint64_t bytes = elem_bytes; bytes && bytes < 4 && width < 16; bytes *= 2) {
+    width *= 2;
+  }
+  return width;
+}
+
 proto::PerfStats ComputeTileStats(const DirectSettings& settings, const FlatContraction& op,
                                   const std::vector<uint64_t>& tile) {
   proto::PerfStats r;
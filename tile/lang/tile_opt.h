@@ -16,6 +16,11 @@ namespace lang {
 // Do vectorization if it's easy, otherwise punt
 FlatContraction Vectorize(const FlatContraction& op, uint64_t vector_size);
 
+// The vector width to try for tensors of at most elem_bytes per element.  The
+// hardware vec_size counts 32-bit lanes, so narrower elements get the same
+// vector byte width (e.g. half8 instead of half4), up to 16 lanes.
+uint64_t VectorWidth(uint64_t vec_size, uint64_t elem_bytes);
+
 // Compute the stats for a given tile size
 proto::PerfStats ComputeTileStats(const DirectSettings& settings, const FlatContraction& op,
                                   const std::vector<uint64_t>& tile);
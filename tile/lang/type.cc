@@ -25,10 +25,25 @@ using namespace math;  // NOLINT
 
 namespace {
 DataType g_floatx = DataType::FLOAT32;
+DataType g_float_accumulation = DataType::INVALID;
 }  // namespace
 
 void SetFloatX(DataType dtype) { g_floatx = dtype; }
 
+void SetFloatAccumulation(DataType dtype) { g_float_accumulation = dtype; }
+
+DataType AccumulationType(DataType output_type, AggregationOp agg_op) {
+  // Only sums and products lose precision as they accumulate; max and min are exact in any type
+  if (agg_op != AggregationOp::SUM && agg_op != AggregationOp::PROD) {
+    return output_type;
+  }
+  if (!is_float(output_type) || !is_float(g_float_accumulation) ||
+      bit_width(g_float_accumulation) <= bit_width(output_type)) {
+    return output_type;
+  }
+  return g_float_accumulation;
+}
+
 std::string Binding::key() const {
   switch (tag) {
     case Binding::TENSOR:
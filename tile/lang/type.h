@@ -61,6 +61,13 @@ Bindings BindProgram(Program* p, const ShapeMap& inputs, const ShapeMap& outputs
 // Set the default data type for floating-point computations
 void SetFloatX(DataType dtype);
 
+// Set the data type in which floating-point contractions accumulate when their outputs are stored at a lower
+// precision (e.g. FLOAT32 for FLOAT16 or BFLOAT16 outputs); INVALID accumulates in the output type
+void SetFloatAccumulation(DataType dtype);
+
+// Returns the data type in which a contraction producing the given output type accumulates
+DataType AccumulationType(DataType output_type, AggregationOp agg_op);
+
 }  // namespace lang
 }  // namespace tile
 }  // namespace vertexai
@@ -1,13 +1,45 @@
 
 #include "tile/math/bignum.h"
 
+#include <limits>
+#include <string>
+
 #include <boost/math/common_factor_rt.hpp>
 
 namespace vertexai {
 namespace tile {
 namespace math {
 
+void Rational::SetBig(const BigRational& value) {
+  const Integer& num = numerator(value);
+  const Integer& den = denominator(value);
+  if (num >= std::numeric_limits<int64_t>::min() && num <= std::numeric_limits<int64_t>::max() &&
+      den <= std::numeric_limits<int64_t>::max()) {
+    num_ = static_cast<int64_t>(num);
+    den_ = static_cast<int64_t>(den);
+    big_.reset();
+  } else {
+    big_ = std::make_shared<const BigRational>(value);
+  }
+}
+
+std::string Rational::str() const {
+  if (big_) {
+    return big_->str();
+  }
+  std::string result = std::to_string(num_);
+  if (den_ != 1) {
+    result += "/" + std::to_string(den_);
+  }
+  return result;
+}
+
+std::ostream& operator<<(std::ostream& os, const Rational& x) { return os << x.str(); }
+
 Integer Floor(const Rational& x) {
+  if (!x.big_) {
+    return x.num_ / x.den_ - (x.num_ % x.den_ < 0);
+  }
   if (x < 0) {
     return (numerator(x) - denominator(x) + 1) / denominator(x);
   } else {
@@ -15,7 +47,7 @@ Integer Floor(const Rational& x) {
   }
 }
 
-Integer Ceil(const Rational& x) { return Floor(Rational(numerator(x) - 1, denominator(x))) + 1; }
+Integer Ceil(const Rational& x) { return -Floor(-x); }
 
 int ToInteger(const Rational& x) {
   if (Floor(x) != Ceil(x)) {
@@ -1,6 +1,12 @@
 #pragma once
 
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
 #include <string>
+#include <type_traits>
 
 #include <boost/multiprecision/cpp_int.hpp>
 
@@ -11,7 +17,260 @@ namespace math {
 typedef boost::multiprecision::cpp_int_backend<> IntegerBackend;
 typedef boost::multiprecision::rational_adaptor<IntegerBackend> RationalBackend;
 typedef boost::multiprecision::number<IntegerBackend, boost::multiprecision::et_off> Integer;
-typedef boost::multiprecision::number<RationalBackend, boost::multiprecision::et_off> Rational;
+typedef boost::multiprecision::number<RationalBackend, boost::multiprecision::et_off> BigRational;
+
+namespace detail {
+
+// Checked int64 arithmetic: each returns false instead of overflowing.
+inline bool CheckedAdd(int64_t a, int64_t b, int64_t* r) {
+#if defined(__GNUC__) || defined(__clang__)
+  return !__builtin_add_overflow(a, b, r);
+#else
+  if ((b > 0 && a > std::numeric_limits<int64_t>::max() - b) ||
+      (b < 0 && a < std::numeric_limits<int64_t>::min() - b)) {
+    return false;
+  }
+  *r = a + b;
+  return true;
+#endif
+}
+
+inline bool CheckedMul(int64_t a, int64_t b, int64_t* r) {
+#if defined(__GNUC__) || defined(__clang__)
+  return !__builtin_mul_overflow(a, b, r);
+#else
+  if (a && b) {
+    int64_t q = a * b;  // May wrap; checked below.
+    if ((a == -1 && b == std::numeric_limits<int64_t>::min()) ||
+        (b == -1 && a == std::numeric_limits<int64_t>::min()) || q / b != a) {
+      return false;
+    }
+  }
+  *r = a * b;
+  return true;
+#endif
+}
+
+// The gcd of two values neither of which is the minimum int64.
+inline int64_t SmallGCD(int64_t a, int64_t b) {
+  a = a < 0 ? -a : a;
+  b = b < 0 ? -b : b;
+  while (b) {
+    int64_t t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+}  // namespace detail
+
+// A rational number of unlimited precision.  Values whose numerator and
+// denominator both fit in an int64 are held inline and computed with checked
+// int64 arithmetic, so the bounds and constraint computations (which almost
+// never leave that range) avoid multiprecision arithmetic; an operation which
+// would overflow is redone as a BigRational.  Values are always kept
+// normalized, with a positive denominator, and a value is held as a
+// BigRational exactly when it does not fit inline.
+class Rational {
+ public:
+  Rational() = default;
+
+  template <typename T, typename = typename std::enable_if<std::is_integral<T>::value>::type>
+  Rational(T value) {  // NOLINT(runtime/explicit)
+    if (std::is_signed<T>::value ||
+        static_cast<uint64_t>(value) <= static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+      num_ = static_cast<int64_t>(value);
+    } else {
+      SetBig(BigRational(Integer(value)));
+    }
+  }
+  Rational(const Integer& value) { SetBig(BigRational(value)); }      // NOLINT(runtime/explicit)
+  Rational(const BigRational& value) { SetBig(value); }               // NOLINT(runtime/explicit)
+  Rational(const Integer& num, const Integer& den) { SetBig(BigRational(num, den)); }
+
+  template <typename N, typename D,
+            typename = typename std::enable_if<std::is_integral<N>::value && std::is_integral<D>::value>::type>
+  Rational(N num, D den) {
+    if (!den) {
+      throw std::overflow_error("Division by zero.");
+    }
+    if (!SetSmall(num, den)) {
+      SetBig(BigRational(Integer(num), Integer(den)));
+    }
+  }
+
+  friend Rational operator+(const Rational& a, const Rational& b) {
+    Rational r;
+    if (!a.big_ && !b.big_ && AddSmall(a.num_, a.den_, b.num_, b.den_, &r)) {
+      return r;
+    }
+    return Rational(a.ToBig() + b.ToBig());
+  }
+
+  friend Rational operator-(const Rational& a, const Rational& b) {
+    Rational r;
+    if (!a.big_ && !b.big_ && b.num_ != std::numeric_limits<int64_t>::min() &&
+        AddSmall(a.num_, a.den_, -b.num_, b.den_, &r)) {
+      return r;
+    }
+    return Rational(a.ToBig() - b.ToBig());
+  }
+
+  friend Rational operator*(const Rational& a, const Rational& b) {
+    Rational r;
+    if (!a.big_ && !b.big_ && MulSmall(a.num_, a.den_, b.num_, b.den_, &r)) {
+      return r;
+    }
+    return Rational(a.ToBig() * b.ToBig());
+  }
+
+  friend Rational operator/(const Rational& a, const Rational& b) {
+    if (!b.big_) {
+      if (!b.num_) {
+        throw std::overflow_error("Division by zero.");
+      }
+      // Multiply by the reciprocal, keeping its denominator positive.
+      Rational r;
+      if (!a.big_ && b.num_ != std::numeric_limits<int64_t>::min() &&
+          MulSmall(a.num_, a.den_, b.num_ < 0 ? -b.den_ : b.den_, b.num_ < 0 ? -b.num_ : b.num_, &r)) {
+        return r;
+      }
+    }
+    return Rational(a.ToBig() / b.ToBig());
+  }
+
+  Rational operator-() const {
+    if (!big_ && num_ != std::numeric_limits<int64_t>::min()) {
+      Rational r;
+      r.num_ = -num_;
+      r.den_ = den_;
+      return r;
+    }
+    return Rational(-ToBig());
+  }
+  Rational operator+() const { return *this; }
+
+  Rational& operator+=(const Rational& rhs) { return *this = *this + rhs; }
+  Rational& operator-=(const Rational& rhs) { return *this = *this - rhs; }
+  Rational& operator*=(const Rational& rhs) { return *this = *this * rhs; }
+  Rational& operator/=(const Rational& rhs) { return *this = *this / rhs; }
+
+  friend bool operator==(const Rational& a, const Rational& b) {
+    if (!a.big_ && !b.big_) {
+      return a.num_ == b.num_ && a.den_ == b.den_;
+    }
+    // Normalized values of different sizes always differ.
+    return a.big_ && b.big_ && *a.big_ == *b.big_;
+  }
+  friend bool operator!=(const Rational& a, const Rational& b) { return !(a == b); }
+
+  friend bool operator<(const Rational& a, const Rational& b) {
+    if (!a.big_ && !b.big_) {
+      int64_t lhs;
+      int64_t rhs;
+      if (a.den_ == b.den_) {
+        return a.num_ < b.num_;
+      }
+      if (detail::CheckedMul(a.num_, b.den_, &lhs) && detail::CheckedMul(b.num_, a.den_, &rhs)) {
+        return lhs < rhs;
+      }
+    }
+    return a.ToBig() < b.ToBig();
+  }
+  friend bool operator>(const Rational& a, const Rational& b) { return b < a; }
+  friend bool operator<=(const Rational& a, const Rational& b) { return !(b < a); }
+  friend bool operator>=(const Rational& a, const Rational& b) { return !(a < b); }
+
+  // True iff the value is nonzero
+  explicit operator bool() const { return big_ || num_; }
+
+  // Converts to an arithmetic type, truncating toward zero for integral types.
+  template <typename T, typename = typename std::enable_if<std::is_arithmetic<T>::value &&
+                                                           !std::is_same<T, bool>::value>::type>
+  explicit operator T() const {
+    if (big_) {
+      return big_->convert_to<T>();
+    }
+    if (std::is_integral<T>::value) {
+      return static_cast<T>(num_ / den_);
+    }
+    return static_cast<T>(num_) / static_cast<T>(den_);
+  }
+
+  friend Integer numerator(const Rational& r) { return r.big_ ? numerator(*r.big_) : Integer(r.num_); }
+  friend Integer denominator(const Rational& r) { return r.big_ ? denominator(*r.big_) : Integer(r.den_); }
+
+  std::string str() const;
+
+  friend Integer Floor(const Rational& x);
+
+  // Returns the value as a BigRational
+  BigRational ToBig() const { return big_ ? *big_ : BigRational(Integer(num_), Integer(den_)); }
+
+ private:
+  // Sets the value to num / den if both fit in an int64 once normalized.
+  template <typename N, typename D>
+  bool SetSmall(N num, D den) {
+    const auto max = static_cast<uint64_t>(std::numeric_limits<int64_t>::max());
+    if ((!std::is_signed<N>::value && static_cast<uint64_t>(num) > max) ||
+        (!std::is_signed<D>::value && static_cast<uint64_t>(den) > max)) {
+      return false;
+    }
+    return Normalize(static_cast<int64_t>(num), static_cast<int64_t>(den), this);
+  }
+
+  // Sets *r to num / den in lowest terms, if the result fits in an int64.
+  static bool Normalize(int64_t num, int64_t den, Rational* r) {
+    if (num == std::numeric_limits<int64_t>::min() || den == std::numeric_limits<int64_t>::min()) {
+      return false;
+    }
+    if (den < 0) {
+      num = -num;
+      den = -den;
+    }
+    int64_t g = detail::SmallGCD(num, den);
+    r->num_ = num / g;
+    r->den_ = den / g;
+    r->big_.reset();
+    return true;
+  }
+
+  static bool AddSmall(int64_t an, int64_t ad, int64_t bn, int64_t bd, Rational* r) {
+    if (ad == 1 && bd == 1) {
+      r->den_ = 1;
+      return detail::CheckedAdd(an, bn, &r->num_);
+    }
+    int64_t lhs;
+    int64_t rhs;
+    int64_t num;
+    int64_t den;
+    int64_t g = detail::SmallGCD(ad, bd);
+    return detail::CheckedMul(an, bd / g, &lhs) && detail::CheckedMul(bn, ad / g, &rhs) &&
+           detail::CheckedAdd(lhs, rhs, &num) && detail::CheckedMul(ad / g, bd, &den) && Normalize(num, den, r);
+  }
+
+  static bool MulSmall(int64_t an, int64_t ad, int64_t bn, int64_t bd, Rational* r) {
+    if (an == std::numeric_limits<int64_t>::min() || bn == std::numeric_limits<int64_t>::min()) {
+      return false;
+    }
+    // Cancel across the operands first, so the products stay small.
+    int64_t g1 = detail::SmallGCD(an, bd);
+    int64_t g2 = detail::SmallGCD(bn, ad);
+    int64_t num;
+    int64_t den;
+    return detail::CheckedMul(an / g1, bn / g2, &num) && detail::CheckedMul(ad / g2, bd / g1, &den) &&
+           Normalize(num, den, r);
+  }
+
+  void SetBig(const BigRational& value);
+
+  int64_t num_ = 0;
+  int64_t den_ = 1;
+  std::shared_ptr<const BigRational> big_;
+};
+
+std::ostream& operator<<(std::ostream& os, const Rational& x);
 
 inline std::string to_string(const Integer& x) { return x.str(); }
 inline std::string to_string(const Rational& x) { return x.str(); }
@@ -28,6 +287,7 @@ Rational FracPart(const Rational& x);
 Integer Abs(const Integer& x);
 // Compute the absolute value
 Rational Abs(const Rational& x);
+inline Rational abs(const Rational& x) { return Abs(x); }
 // Modulo like reduction, that is, find r, 0 <= v < m, such that r = k*m + v for some integer k
 Rational Reduce(const Rational& v, const Rational& m);  // NOLINT(runtime/references)
 // Compute the extended common denominator over rational.  That is, find a return value r,
@@ -1,4 +1,7 @@
 
+#include <limits>
+#include <string>
+
 #include "base/util/catch.h"
 #include "base/util/logging.h"
 #include "tile/math/basis.h"
@@ -42,6 +45,24 @@ TEST_CASE("Reduce", "[lattice]") {
   REQUIRE(Reduce(Rational(13, 4), Rational(1, 5)) == Rational(1, 20));
 }
 
+TEST_CASE("Rational overflow", "[lattice]") {
+  const int64_t big = std::numeric_limits<int64_t>::max();
+  Rational a(big, 3);
+  REQUIRE(a.str() == std::to_string(big) + "/3");
+  // Each result overflows int64 and is carried out in multiple precision.
+  REQUIRE(a * 3 == Rational(big));
+  REQUIRE(numerator(a + a) == 2 * Integer(big));
+  REQUIRE((a + a) - a == a);
+  REQUIRE(-Rational(std::numeric_limits<int64_t>::min()) == Integer(big) + 1);
+  REQUIRE(Rational(big) + 1 > Rational(big));
+  REQUIRE(Floor(Rational(Integer(big) * 4, 3)) == Integer(big) + Integer(big) / 3);
+  // Results which fit again compare equal to values which always did.
+  REQUIRE((Rational(big) + 1) - 2 == Rational(big - 1));
+  REQUIRE(Rational(Integer(big) * 2, Integer(big) * 4) == Rational(1, 2));
+  REQUIRE(!Rational(0, 5));
+  REQUIRE(static_cast<bool>(Rational(1, 5)));
+}
+
 static void ValidateXGCD(const Rational& a, const Rational& b) {
   Integer x, y;
   Rational o = XGCD(a, b, x, y);
@@ -118,6 +139,22 @@ TEST_CASE("Basic Polynomial<Rational> evaluation", "[poly]") {
   REQUIRE(r.eval({{"a0", 5}, {"a1", 9}}) == 33);
 }
 
+TEST_CASE("Polynomial arithmetic merges terms", "[poly]") {
+  Affine a = Affine("i", 2) + Affine("k", 3) + 5;
+  Affine b = Affine("j", 1) - Affine("k", 3) - 5;
+  REQUIRE(to_string(a + b) == "2*i + j");
+  REQUIRE(to_string(a - a) == "0");
+  Affine c = a;
+  c += c;
+  REQUIRE(to_string(c) == "10 + 4*i + 6*k");
+  c -= c;
+  REQUIRE(c == Affine());
+  REQUIRE(to_string(-b) == "5 - j + 3*k");
+  a.substitute("k", Affine("j", 2) - 1);
+  REQUIRE(to_string(a) == "2 + 2*i + 6*j");
+  REQUIRE(to_string(a.sym_eval({{"", Affine(1)}, {"i", Affine("x")}, {"j", Affine("x", -1)}})) == "2 - 4*x");
+}
+
 TEST_CASE("IntersectParallelConstraintPair", "[poly]") {
   Polynomial<Rational> i("i"), j("j");
   RangeConstraint c1{2 * i + j + 1, 8};
@@ -145,13 +145,36 @@ std::map<std::string, T>& Polynomial<T>::mutateMap() {
 }
 
 template <typename T>
-Polynomial<T>& Polynomial<T>::operator+=(const Polynomial<T>& rhs) {
+void Polynomial<T>::AddScaled(const Polynomial<T>& rhs, const T& scale) {
+  if (&rhs == this) {
+    *this *= (1 + scale);
+    return;
+  }
+  if (scale == 0) {
+    return;
+  }
+  auto it = map_.begin();
   for (const auto& kvp : rhs.map_) {
-    T new_val = (map_[kvp.first] += kvp.second);
-    if (new_val == 0) {
-      map_.erase(kvp.first);
+    T value = (scale == 1 ? kvp.second : kvp.second * scale);
+    while (it != map_.end() && it->first < kvp.first) {
+      ++it;
+    }
+    if (it != map_.end() && it->first == kvp.first) {
+      it->second += value;
+      if (it->second == 0) {
+        it = map_.erase(it);
+      } else {
+        ++it;
+      }
+    } else {
+      map_.emplace_hint(it, kvp.first, value);
     }
   }
+}
+
+template <typename T>
+Polynomial<T>& Polynomial<T>::operator+=(const Polynomial<T>& rhs) {
+  AddScaled(rhs, 1);
   return *this;
 }
 
@@ -167,12 +190,17 @@ bool Polynomial<T>::operator<(const Polynomial<T>& rhs) const {
 
 template <typename T>
 Polynomial<T>& Polynomial<T>::operator-=(const Polynomial<T>& rhs) {
-  return *this += -1 * rhs;
+  AddScaled(rhs, -1);
+  return *this;
 }
 
 template <typename T>
 Polynomial<T> Polynomial<T>::operator-() const {
-  return -1 * (*this);
+  Polynomial<T> ret = *this;
+  for (auto& kvp : ret.map_) {
+    kvp.second = -kvp.second;
+  }
+  return ret;
 }
 
 template <typename T>
@@ -236,13 +264,14 @@ T Polynomial<T>::tryDivide(const Polynomial<T>& p, bool ignoreConst) const {
 
 template <typename T>
 void Polynomial<T>::substitute(const std::string& var, const Polynomial<T>& replacement) {
-  if (map_.count(var) == 0) {
+  auto it = map_.find(var);
+  if (it == map_.end()) {
     // If var isn't in this polynomial, nothing needs to be done
     return;
   }
-  T coeff = safe_at(map_, var);
-  map_.erase(var);
-  (*this) += coeff * replacement;
+  T coeff = it->second;
+  map_.erase(it);
+  AddScaled(replacement, coeff);
 }
 
 template <typename T>
@@ -251,10 +280,10 @@ void Polynomial<T>::substitute(const std::map<std::string, Polynomial<T>>& repla
   for (const auto& name_value : map_) {
     auto replacement = replacements.find(name_value.first);
     if (replacement == replacements.end()) {
-      result += Polynomial{name_value.first, name_value.second};
+      result.AddScaled(Polynomial{name_value.first, name_value.second}, 1);
       continue;
     }
-    result += replacement->second * name_value.second;
+    result.AddScaled(replacement->second, name_value.second);
   }
   map_.swap(result.map_);
 }
@@ -265,13 +294,13 @@ void Polynomial<T>::substitute(const std::string& var, const T& replacement) {
 }
 
 template <typename T>
-Polynomial<T> Polynomial<T>::sym_eval(const std::map<std::string, Polynomial> values) const {
+Polynomial<T> Polynomial<T>::sym_eval(const std::map<std::string, Polynomial>& values) const {
   Polynomial<T> out;
   for (const auto& kvp : map_) {
     if (kvp.first.empty()) {
-      out += Polynomial<T>(kvp.second);
+      out.AddScaled(Polynomial<T>(kvp.second), 1);
     } else {
-      out += safe_at(values, kvp.first) * kvp.second;
+      out.AddScaled(safe_at(values, kvp.first), kvp.second);
     }
   }
   return out;
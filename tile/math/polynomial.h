@@ -54,7 +54,7 @@ class Polynomial : boost::additive<Polynomial<T>>,
   void substitute(const std::map<std::string, Polynomial<T>>& replacements);
   void substitute(const std::string& var, const T& replacement);
   // Symbolically evaluate a polynomial
-  Polynomial sym_eval(const std::map<std::string, Polynomial<T>> values) const;
+  Polynomial sym_eval(const std::map<std::string, Polynomial<T>>& values) const;
   // If the string has a nonzero coefficient for at least one of its nonconstant
   // indices, it will return the index name of one such index. No promises about
   // which index you'll get. Returns empty string if no index w/ nonconst coeff
@@ -65,6 +65,10 @@ class Polynomial : boost::additive<Polynomial<T>>,
   std::string toString() const;  // Pretty-print to string
 
  private:
+  // Adds scale * rhs to this polynomial, merging the two sorted term maps in a
+  // single pass rather than looking up each term.
+  void AddScaled(const Polynomial& rhs, const T& scale);
+
   // Map from index -> coefficient
   // Constant offset is a coefficent of empty string
   std::map<std::string, T> map_;
@@ -415,28 +415,142 @@ void SemtreeEmitter::do_gids(const stripe::Block& block) {
   tot_stores_ = 0;
 }
 
-sem::StmtPtr SemtreeEmitter::make_special(const std::string& name, const stripe::Block& block,
-                                          std::vector<const stripe::Refinement*> args) {
-  std::stringstream ss;
-  ss << "TODO: Special: " << name;
-  throw std::runtime_error(ss.str());
-  /*
-  std::vector<sem::ExprPtr> params;
-  for (const stripe::Refinement* ref : args) {
-    int64_t lda = 0;
-    for (const auto d : block.exterior_shape(ref->into()).dims) {
-      if (d.size > 1 && d.stride > 1) {
-        lda = d.stride / 4;
+namespace {
+
+// The roles of a mac_inner block's indexes and refinements: C[m, n] += A[m, k] * B[k, n]
+struct MacShape {
+  std::string m;
+  std::string n;
+  std::string k;
+  const stripe::Refinement* a = nullptr;
+  const stripe::Refinement* b = nullptr;
+  const stripe::Refinement* c = nullptr;
+};
+
+const stripe::Block* FindMacInner(const stripe::Block& block) {
+  if (block.has_tag("mac_inner")) {
+    return &block;
+  }
+  for (const auto& stmt : block.stmts) {
+    auto inner = stripe::Block::Downcast(stmt);
+    if (inner) {
+      auto found = FindMacInner(*inner);
+      if (found) {
+        return found;
+      }
+    }
+  }
+  return nullptr;
+}
+
+MacShape AnalyzeMac(const stripe::Block& block) {
+  if (block.ref_ins().size() != 2 || block.ref_outs().size() != 1) {
+    throw std::runtime_error("Matrix multiply-accumulate blocks must have two inputs and one output");
+  }
+  MacShape mac;
+  mac.c = block.ref_outs()[0];
+  auto c_flat = mac.c->FlatAccess();
+  std::vector<std::string> outs;
+  for (const auto& idx : block.idxs) {
+    if (idx.affine != stripe::Affine() || idx.range <= 1) {
+      continue;
+    }
+    if (c_flat[idx.name]) {
+      outs.push_back(idx.name);
+    } else if (mac.k.empty()) {
+      mac.k = idx.name;
+    } else {
+      throw std::runtime_error("Matrix multiply-accumulate blocks must have a single reduction index");
+    }
+  }
+  if (outs.size() != 2 || mac.k.empty()) {
+    throw std::runtime_error("Matrix multiply-accumulate blocks must have m, n and k indexes");
+  }
+  // The output rows are the index with the larger stride
+  bool swap = c_flat[outs[0]] < c_flat[outs[1]];
+  mac.m = outs[swap ? 1 : 0];
+  mac.n = outs[swap ? 0 : 1];
+  for (const auto* ref : block.ref_ins()) {
+    auto flat = ref->FlatAccess();
+    if (flat[mac.m] && flat[mac.k] && !flat[mac.n]) {
+      mac.a = ref;
+    } else if (flat[mac.k] && flat[mac.n] && !flat[mac.m]) {
+      mac.b = ref;
+    }
+  }
+  if (!mac.a || !mac.b) {
+    throw std::runtime_error("Matrix multiply-accumulate inputs must be indexed by (m, k) and (k, n)");
+  }
+  return mac;
+}
+
+// The flat offset of the first element of ref's tile within block, relative
+// to the index of the refinement it's taken from.
+stripe::Affine TileOrigin(const stripe::Refinement& ref, const stripe::Block& block,
+                          const std::map<std::string, stripe::Affine>& outer_sources) {
+  stripe::Affine origin;
+  for (const auto& kvp : ref.FlatAccess().getMap()) {
+    if (kvp.first.empty()) {
+      origin += kvp.second;
+      continue;
+    }
+    auto idx = block.idx_by_name(kvp.first);
+    if (idx && idx->affine != stripe::Affine()) {
+      origin += idx->affine.sym_eval(outer_sources) * kvp.second;
+    }
+  }
+  return origin;
+}
+
+}  // namespace
+
+// Matrix multiply-accumulate stencils (blocks tagged mac_inner, within a block
+// tagged mac_middle which runs the reduction over a single output tile) become
+// the specials MAC_INIT, MAC_INNER and MAC_FINISH, for the target's emitter to
+// map onto its matrix engine.  Each of them takes the M, N and K of the
+// stencil, followed by a buffer, a flat offset, a row stride and a column
+// stride for each matrix it touches: the accumulator C for MAC_INIT and
+// MAC_FINISH, and the inputs A and B for MAC_INNER.  Every thread of the
+// subgroup issues the same call.
+sem::StmtPtr SemtreeEmitter::make_special(const std::string& name, const stripe::Block& block) {
+  const stripe::Block* inner = FindMacInner(block);
+  if (!inner) {
+    throw std::runtime_error("Special " + name + " requires a mac_inner block");
+  }
+  auto mac = AnalyzeMac(*inner);
+  std::vector<sem::ExprPtr> params = {
+      _Const(inner->idx_by_name(mac.m)->range),
+      _Const(inner->idx_by_name(mac.n)->range),
+      _Const(inner->idx_by_name(mac.k)->range),
+  };
+  auto add_matrix = [&](const std::string& buf, sem::ExprPtr offset, const stripe::Refinement& strides,
+                        const std::string& row, const std::string& col) {
+    auto flat = strides.FlatAccess();
+    params.push_back(_(ref_buf(buf)));
+    params.push_back(offset);
+    params.push_back(_Const(flat[row]));
+    params.push_back(_Const(flat[col]));
+  };
+  if (name == "MAC_INNER") {
+    // The block isn't in scope; its refinements come from the enclosing one
+    auto offset = [&](const stripe::Refinement* ref) {
+      return _(ref_idx(ref->from)) + convert_affine(TileOrigin(*ref, block, scope_->idx_sources()));
+    };
+    add_matrix(mac.a->from, offset(mac.a), *mac.a, mac.m, mac.k);
+    add_matrix(mac.b->from, offset(mac.b), *mac.b, mac.k, mac.n);
+    tot_ops_ += loop_mul_ * inner->idxs_product();
+  } else {
+    auto out = block.ref_outs(true)[0];
+    for (const auto& idx : block.idxs) {
+      if (idx.affine == stripe::Affine() && idx.range > 1 && out->FlatAccess()[idx.name]) {
+        throw std::runtime_error("mac_middle blocks must accumulate into a single output tile");
       }
     }
-    params.push_back(_(ref_buf(ref->from)));
-    std::string idx = generate_name(ref->from);
-    process_affine(idx, scope_->at(ref->from).flat());
-    params.push_back(_(idx));
-    params.push_back(_Const(lda));
+    const auto& outer_sources = scopes_[scopes_.size() - 2].idx_sources();
+    auto offset = _(ref_idx(out->from, -1)) + convert_affine(TileOrigin(*out, block, outer_sources));
+    add_matrix(out->into(), offset, *mac.c, mac.m, mac.n);
   }
   return std::make_shared<sem::SpecialStmt>(name, params);
-  */
 }
 
 void SemtreeEmitter::compute_thread_count(const stripe::Block& block) {
@@ -621,8 +735,7 @@ class Unroller : public stripe::ConstStmtVisitor {
 void SemtreeEmitter::Visit(const stripe::Block& block) {
   std::shared_ptr<sem::Block> outer = cur_;
   if (block.has_tag("mac_inner")) {
-    std::vector<const stripe::Refinement*> args = {block.ref_ins()[0], block.ref_ins()[1]};
-    cur_->push_back(make_special("MAC_INNER", block, args));
+    cur_->push_back(make_special("MAC_INNER", block));
     return;
   }
   size_t this_block_threads = block.has_tag("gpu_thread") ? block.idxs_product() : 1;
@@ -756,8 +869,8 @@ void SemtreeEmitter::Visit(const stripe::Block& block) {
           sblock = std::make_shared<sem::Block>();
           sblock->push_back(wrapped);
         }
-        sblock->push_front(make_special("MAC_INIT", block, {}));
-        sblock->push_back(make_special("MAC_FINISH", block, {block.ref_outs(true)[0]}));
+        sblock->push_front(make_special("MAC_INIT", block));
+        sblock->push_back(make_special("MAC_FINISH", block));
         wrapped = sblock;
       }
     }
@@ -43,8 +43,7 @@ class SemtreeEmitter : public stripe::ConstStmtVisitor {
   size_t inner_blocks(const stripe::Block& block);
   sem::StmtPtr add_loops(const stripe::Block&);
   void do_gids(const stripe::Block&);
-  sem::StmtPtr make_special(const std::string& name, const stripe::Block& block,
-                            std::vector<const stripe::Refinement*> args);
+  sem::StmtPtr make_special(const std::string& name, const stripe::Block& block);
   void compute_thread_count(const stripe::Block& block);
   sem::StmtPtr do_lids(const stripe::Block&);
   void init_loop_local(const std::string& buf, DataType type,  //
@@ -2,9 +2,16 @@
 
 #include <stdio.h>
 
+#include <algorithm>
+#include <sstream>
+#include <utility>
+#include <vector>
+
 #include "base/util/file.h"
+#include "base/util/runtime_options.h"
 #include "tile/codegen/codegen.pb.h"
 #include "tile/codegen/driver.h"
+#include "tile/lang/fnv1a64.h"
 #include "tile/lang/gen_stripe.h"
 #include "tile/lang/semprinter.h"
 #include "tile/lang/simplifier.h"
@@ -17,11 +24,33 @@ namespace codegen {
 
 using namespace lang;  // NOLINT
 
-lang::KernelList GenerateProgram(                    //
+namespace {
+
+bool SameTypes(const KernelList& lhs, const KernelList& rhs, const std::vector<std::string>& names) {
+  for (const auto& name : names) {
+    auto lhs_it = lhs.types.find(name);
+    auto rhs_it = rhs.types.find(name);
+    if (lhs_it == lhs.types.end() || rhs_it == rhs.types.end() || !(lhs_it->second == rhs_it->second)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+struct TuneRound {
+  size_t candidates = 1;
+  size_t rank = 0;
+  size_t found = 0;
+};
+
+lang::KernelList GenerateKernels(                    //
+    const context::Context& ctx,                     //
     const std::shared_ptr<stripe::Program>& stripe,  //
     const std::string& cfg_name,                     //
     const std::string& out_dir,                      //
-    ConstBufferManager* const_bufs) {
+    ConstBufferManager* const_bufs,                  //
+    const hal::proto::HardwareSettings* device,      //
+    TuneRound* tune) {
   codegen::OptimizeOptions options;
   options.dump_passes = !out_dir.empty();
   options.dump_passes_proto = !out_dir.empty();
@@ -29,13 +58,22 @@ lang::KernelList GenerateProgram(                    //
   if (options.dump_passes) {
     IVLOG(2, "Write passes to: " << options.dbg_dir);
   }
+  options.profile_path = RuntimeOptions::Get().codegen_profile;
+  options.ctx = ctx;
+  options.cache = codegen::OptimizeCache::Global();
   IVLOG(2, *stripe->entry);
-  const auto& cfgs = targets::GetConfigs();
-  const auto& cfg = cfgs.configs().at(cfg_name);
+  auto cfg = targets::GetConfig(cfg_name, device);
   const auto& stage = cfg.stages().at("default");
   codegen::CompilerState state(stripe);
   state.const_bufs = const_bufs;
+  if (tune) {
+    state.tune_candidates = tune->candidates;
+    state.tune_rank = tune->rank;
+  }
   codegen::Optimize(&state, stage.passes(), options);
+  if (tune) {
+    tune->found = state.tune_found;
+  }
   IVLOG(2, *stripe->entry);
   codegen::SemtreeEmitter emit(codegen::AliasMap{}, 256);
   emit.Visit(*stripe->entry);
@@ -72,16 +110,105 @@ lang::KernelList GenerateProgram(                    //
   return emit.kernels_;
 }
 
+}  // namespace
+
+uint64_t KernelDigest(const KernelInfo& ki) {
+  auto func = *ki.kfunc;
+  func.name = "kernel";
+  sem::Print p(func);
+  std::stringstream ss;
+  ss << p.str();
+  for (size_t i = 0; i < ki.gwork.size(); i++) {
+    ss << ":" << ki.gwork[i] << "/" << ki.lwork[i];
+  }
+  return fnv1a64::hash(ss.str().c_str());
+}
+
+void AddCandidates(KernelList* kernels, const std::vector<KernelList>& rounds) {
+  for (auto& ki : kernels->kernels) {
+    auto digest = KernelDigest(ki);
+    ki.key = "stripe:" + std::to_string(digest);
+    ki.variant = std::to_string(digest);
+  }
+  for (size_t r = 0; r < rounds.size(); r++) {
+    const auto& round = rounds[r];
+    bool matches = round.kernels.size() == kernels->kernels.size();
+    for (size_t i = 0; matches && i < round.kernels.size(); i++) {
+      const auto& ki = kernels->kernels[i];
+      const auto& alt = round.kernels[i];
+      matches = alt.inputs == ki.inputs && alt.outputs == ki.outputs && SameTypes(*kernels, round, alt.inputs) &&
+                SameTypes(*kernels, round, alt.outputs);
+    }
+    if (!matches) {
+      IVLOG(1, "Stripe tuning: discarding candidate round " << r + 1 << ", its kernels don't match the default ones");
+      continue;
+    }
+    for (size_t i = 0; i < round.kernels.size(); i++) {
+      auto& ki = kernels->kernels[i];
+      auto alt = round.kernels[i];
+      auto variant = std::to_string(KernelDigest(alt));
+      if (variant == ki.variant ||
+          std::any_of(ki.candidates.begin(), ki.candidates.end(),
+                      [&variant](const KernelInfo& candidate) { return candidate.variant == variant; })) {
+        continue;
+      }
+      alt.key = ki.key;
+      alt.kname = ki.kname;
+      alt.kfunc = std::make_shared<sem::Function>(*alt.kfunc);
+      alt.kfunc->name = ki.kname;
+      alt.variant = variant;
+      ki.candidates.emplace_back(std::move(alt));
+    }
+  }
+}
+
+lang::KernelList GenerateProgram(                    //
+    const context::Context& ctx,                     //
+    const std::shared_ptr<stripe::Program>& stripe,  //
+    const std::string& cfg_name,                     //
+    const std::string& out_dir,                      //
+    ConstBufferManager* const_bufs,                  //
+    const hal::proto::HardwareSettings* device) {
+  return GenerateKernels(ctx, stripe, cfg_name, out_dir, const_bufs, device, nullptr);
+}
+
 KernelList GenerateProgram(       //
+    const context::Context& ctx,  //
     const RunInfo& runinfo,       //
     const std::string& cfg_name,  //
     const std::string& out_dir,   //
-    ConstBufferManager* const_bufs) {
+    ConstBufferManager* const_bufs,
+    size_t tune_candidates,
+    const hal::proto::HardwareSettings* device) {
   IVLOG(2, runinfo.input_shapes);
   IVLOG(2, runinfo.output_shapes);
   IVLOG(2, to_string(runinfo.program));
-  auto stripe = GenerateStripe(runinfo);
-  return GenerateProgram(stripe, cfg_name, out_dir, const_bufs);
+  if (tune_candidates <= 1) {
+    auto stripe = GenerateStripe(runinfo);
+    return GenerateProgram(ctx, stripe, cfg_name, out_dir, const_bufs, device);
+  }
+
+  // Compile the program once for each alternative tiling rank.  Passes rewrite
+  // both the program and the constant buffers in place, so each round starts
+  // from a fresh program and a private copy of the constant buffer map; the
+  // default round, which owns the real buffers, goes last.
+  std::vector<KernelList> rounds;
+  for (size_t rank = 1; rank < tune_candidates; rank++) {
+    ConstBufferManager scratch;
+    if (const_bufs) {
+      scratch = *const_bufs;
+    }
+    TuneRound tune{tune_candidates, rank};
+    auto kernels =
+        GenerateKernels(ctx, GenerateStripe(runinfo), cfg_name, "", const_bufs ? &scratch : nullptr, device, &tune);
+    if (rank >= tune.found) {
+      break;  // No block had this many candidates; later rounds would repeat the last one.
+    }
+    rounds.emplace_back(std::move(kernels));
+  }
+  auto kernels = GenerateProgram(ctx, GenerateStripe(runinfo), cfg_name, out_dir, const_bufs, device);
+  AddCandidates(&kernels, rounds);
+  return kernels;
 }
 
 }  // End namespace codegen
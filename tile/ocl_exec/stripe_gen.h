@@ -2,27 +2,55 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
+#include "base/context/context.h"
 #include "tile/base/buffer.h"
 #include "tile/lang/generate.h"
 #include "tile/lang/runinfo.h"
+#include "tile/proto/hal.pb.h"
 #include "tile/stripe/stripe.h"
 
 namespace vertexai {
 namespace tile {
 namespace codegen {
 
-lang::KernelList GenerateProgram(     //
-    const lang::RunInfo& runinfo,     //
-    const std::string& cfg_name,      //
-    const std::string& out_dir = "",  //
-    ConstBufferManager* const_bufs = {});
-
-lang::KernelList GenerateProgram(                     //
-    const std::shared_ptr<stripe::Program>& program,  //
-    const std::string& cfg_name,                      //
-    const std::string& out_dir = "",                  //
-    ConstBufferManager* const_bufs = {});
+// If tune_candidates is greater than one, the program is also compiled with
+// up to that many alternative tilings from the AutotilePass, and the resulting
+// kernels are attached as candidates of the default kernels so that they can
+// be timed on the device.  If the device's settings are supplied, the config
+// may be derived from them (see targets::GetConfig).
+lang::KernelList GenerateProgram(                          //
+    const context::Context& ctx,                           //
+    const lang::RunInfo& runinfo,                          //
+    const std::string& cfg_name,                           //
+    const std::string& out_dir = "",                       //
+    ConstBufferManager* const_bufs = {},                   //
+    size_t tune_candidates = 1,                            //
+    const hal::proto::HardwareSettings* device = nullptr);
+
+lang::KernelList GenerateProgram(                          //
+    const context::Context& ctx,                           //
+    const std::shared_ptr<stripe::Program>& program,       //
+    const std::string& cfg_name,                           //
+    const std::string& out_dir = "",                       //
+    ConstBufferManager* const_bufs = {},                   //
+    const hal::proto::HardwareSettings* device = nullptr);
+
+// A digest of everything about a kernel that affects how it runs: its code and
+// launch dimensions.  The kernel name depends on its position in the program,
+// so it's left out.
+uint64_t KernelDigest(const lang::KernelInfo& ki);
+
+// Attaches the kernels produced by alternative tilings (one KernelList per
+// round) as candidates of the corresponding default kernels, and keys each
+// kernel by its digest: every version of a kernel shares the default one's
+// key and name, and is told apart by its variant.  Kernels are matched by
+// position; a round whose kernels don't line up with the default ones
+// (different buffers or buffer layouts) is discarded, since its kernels can't
+// be swapped in individually.  Candidates identical to the default kernel or
+// to an earlier candidate are dropped.
+void AddCandidates(lang::KernelList* kernels, const std::vector<lang::KernelList>& rounds);
 
 }  // End namespace codegen
 }  // End namespace tile
@@ -6,10 +6,17 @@
 
 #include "base/util/error.h"
 #include "base/util/logging.h"
+#include "base/util/perf_counter.h"
 
 namespace vertexai {
 namespace tile {
 namespace local_machine {
+namespace {
+
+// Bytes mapped for host access, by device and direction.
+PerfCounter mapped_bytes("buffer_mapped_bytes");
+
+}  // namespace
 
 std::shared_ptr<Buffer> Buffer::Downcast(const std::shared_ptr<tile::Buffer>& buffer,
                                          const std::shared_ptr<DevInfo>& devinfo) {
@@ -23,6 +30,17 @@ std::shared_ptr<Buffer> Buffer::Downcast(const std::shared_ptr<tile::Buffer>& bu
   return result;
 }
 
+Buffer* Buffer::Downcast(tile::Buffer* buffer, const std::shared_ptr<DevInfo>& devinfo) {
+  auto result = dynamic_cast<Buffer*>(buffer);
+  if (!result) {
+    throw error::InvalidArgument("incompatible buffer type");
+  }
+  if (result->devinfo_ != devinfo) {
+    throw error::InvalidArgument("incompatible buffer for device");
+  }
+  return result;
+}
+
 Buffer::Buffer(const std::shared_ptr<DevInfo>& devinfo, const std::shared_ptr<MemStrategy>& mem_strategy,
                std::shared_ptr<MemChunk> chunk)
     : devinfo_{devinfo}, mem_strategy_{mem_strategy}, size_{chunk->size()}, chunk_{std::move(chunk)} {}
@@ -33,11 +51,15 @@ Buffer::Buffer(const std::shared_ptr<DevInfo>& devinfo, const std::shared_ptr<Me
 
 boost::future<std::unique_ptr<View>> Buffer::MapCurrent(const context::Context& ctx) {
   EnsureChunk(ctx);
+  Touch();
+  mapped_bytes.WithLabels({{"device", devinfo_->dev->description()}, {"direction", "device_to_host"}}).add(size_);
   return chunk()->MapCurrent(ctx);
 }
 
 std::unique_ptr<View> Buffer::MapDiscard(const context::Context& ctx) {
   EnsureChunk(ctx);
+  Touch();
+  mapped_bytes.WithLabels({{"device", devinfo_->dev->description()}, {"direction", "host_to_device"}}).add(size_);
   return chunk()->MapDiscard(ctx);
 }
 
@@ -49,6 +71,7 @@ void Buffer::RemapTo(std::shared_ptr<MemChunk> chunk) {
   }
   std::lock_guard<std::mutex> lock{mu_};
   chunk_ = std::move(chunk);
+  Touch();
 }
 
 void Buffer::EnsureChunk(const context::Context& ctx) {
@@ -5,88 +5,165 @@
 #include <memory>
 
 #include "base/util/env.h"
+#include "base/util/runtime_options.h"
 #include "tile/codegen/driver.h"
 #include "tile/lang/gen_stripe.h"
 #include "tile/targets/cpu/jit.h"
+#include "tile/targets/cpu/profile.h"
 #include "tile/targets/targets.h"
 
 namespace vertexai {
 namespace tile {
 namespace local_machine {
+namespace {
+
+targets::cpu::Config CpuConfig() {
+  targets::cpu::Config config;
+  config.object_cache_dir = env::Get("PLAIDML_CPU_CACHE_DIR");
+  auto max_mb = env::Get("PLAIDML_CPU_CACHE_MAX_MB");
+  if (!max_mb.empty()) {
+    config.object_cache_max_bytes = std::stoull(max_mb) << 20;
+  }
+  if (env::Get("PLAIDML_CPU_FAST_MATH") == "1") {
+    config.math_accuracy = targets::cpu::MathAccuracy::FAST;
+  }
+  auto partitioner = env::Get("PLAIDML_CPU_PARTITIONER");
+  if (partitioner == "static") {
+    config.partitioner = targets::cpu::Partitioner::STATIC;
+  } else if (partitioner == "affinity") {
+    config.partitioner = targets::cpu::Partitioner::AFFINITY;
+  }
+  auto grain_size = env::Get("PLAIDML_CPU_GRAIN_SIZE");
+  if (!grain_size.empty()) {
+    config.grain_size = std::stoull(grain_size);
+  }
+  config.numa_arenas = env::Get("PLAIDML_CPU_NUMA") == "1";
+  auto numa_device = env::Get("PLAIDML_CPU_NUMA_DEVICE");
+  if (!numa_device.empty()) {
+    config.numa_device = numa_device;
+  }
+  config.pin_threads = env::Get("PLAIDML_CPU_PIN_THREADS") == "1";
+  config.lazy_compile = env::Get("PLAIDML_CPU_LAZY") == "1";
+  auto compile_threads = env::Get("PLAIDML_CPU_COMPILE_THREADS");
+  if (!compile_threads.empty()) {
+    config.compile_threads = std::stoull(compile_threads);
+  }
+  return config;
+}
+
+}  // namespace
 
 CpuProgram::CpuProgram(            //
     const std::string& target,     //
     const lang::RunInfo& runinfo,  //
     ConstBufferManager* const_bufs)
-    : executable_{new targets::cpu::Native} {
+    : target_{target}, executable_{new targets::cpu::Native} {
   auto stripe = GenerateStripe(runinfo);
-  auto out_dir = boost::filesystem::path(env::Get("PLAIDML_STRIPE_OUTPUT"));
+  auto out_dir = boost::filesystem::path(RuntimeOptions::Get().stripe_output);
   codegen::OptimizeOptions options = {
-      !out_dir.empty(),    // dump_passes
-      false,               // dump_passes_proto
-      false,               // dump_code
-      out_dir / "passes",  // dbg_dir
+      !out_dir.empty(),                       // dump_passes
+      false,                                  // dump_passes_proto
+      false,                                  // dump_code
+      out_dir / "passes",                     // dbg_dir
+      RuntimeOptions::Get().codegen_profile,  // profile_path
   };
   const auto& cfgs = targets::GetConfigs();
   const auto& cfg = cfgs.configs().at(target);
   const auto& stage = cfg.stages().at("default");
+  options.cache = codegen::OptimizeCache::Global();
   codegen::CompilerState state(stripe);
   state.const_bufs = const_bufs;
   codegen::Optimize(&state, stage.passes(), options);
-  targets::cpu::Config config;
-  if (!env::Get("PLAIDML_CPU_PROFILE").empty()) {
-    config.profile_block_execution = true;
-    source_ = stripe->entry;
-  }
-  executable_->compile(*stripe->entry, config);
+  program_ = stripe;
+  Compile();
+  const_bufs->Sync();
 }
 
 CpuProgram::CpuProgram(                              //
     const std::string& target,                       //
     const std::shared_ptr<stripe::Program>& stripe,  //
     ConstBufferManager* const_bufs)
-    : executable_{new targets::cpu::Native} {
-  auto out_dir = boost::filesystem::path(env::Get("PLAIDML_STRIPE_OUTPUT"));
+    : target_{target}, executable_{new targets::cpu::Native} {
+  auto out_dir = boost::filesystem::path(RuntimeOptions::Get().stripe_output);
   codegen::OptimizeOptions options = {
-      !out_dir.empty(),    // dump_passes
-      false,               // dump_passes_proto
-      false,               // dump_code
-      out_dir / "passes",  // dbg_dir
+      !out_dir.empty(),                       // dump_passes
+      false,                                  // dump_passes_proto
+      false,                                  // dump_code
+      out_dir / "passes",                     // dbg_dir
+      RuntimeOptions::Get().codegen_profile,  // profile_path
   };
   const auto& cfgs = targets::GetConfigs();
   const auto& cfg = cfgs.configs().at(target);
   const auto& stage = cfg.stages().at("default");
+  options.cache = codegen::OptimizeCache::Global();
   codegen::CompilerState state(stripe);
   state.const_bufs = const_bufs;
   codegen::Optimize(&state, stage.passes(), options);
-  targets::cpu::Config config;
+  program_ = stripe;
+  Compile();
+  const_bufs->Sync();
+}
+
+CpuProgram::CpuProgram(const proto::SavedProgram& saved)
+    : target_{saved.cpu_target()}, executable_{new targets::cpu::Native} {
+  if (!saved.stripe_binary().empty()) {
+    program_ = stripe::FromBinary(saved.stripe_binary());
+  } else {
+    program_ = stripe::FromProto(saved.stripe());
+    for (const auto& kvp : saved.input_shapes()) {
+      program_->input_shapes.emplace(kvp.first, FromProto(kvp.second));
+    }
+    for (const auto& kvp : saved.output_shapes()) {
+      program_->output_shapes.emplace(kvp.first, FromProto(kvp.second));
+    }
+  }
+  Compile();
+}
+
+CpuProgram::~CpuProgram() {}
+
+void CpuProgram::Compile() {
+  auto config = CpuConfig();
   if (!env::Get("PLAIDML_CPU_PROFILE").empty()) {
     config.profile_block_execution = true;
-    source_ = CloneBlock(*stripe->entry);
+    config.profile_hw_counters = env::Get("PLAIDML_CPU_PROFILE_HW") == "1";
+    // Profiling annotates the block, which may be shared with the caller.
+    source_ = CloneBlock(*program_->entry);
   }
-  executable_->compile(*(source_ ? source_ : stripe->entry), config);
+  executable_->compile(*(source_ ? source_ : program_->entry), config);
 }
 
-CpuProgram::~CpuProgram() {}
+std::string CpuProgram::Save(const context::Context& ctx) {
+  proto::SavedProgram saved;
+  saved.set_cpu_target(target_);
+  saved.set_stripe_binary(stripe::IntoBinary(*program_));
+  return saved.SerializeAsString();
+}
 
 boost::future<void> CpuProgram::Run(  //
     const context::Context& ctx,      //
     std::map<std::string, std::shared_ptr<tile::Buffer>> inputs,
     std::map<std::string, std::shared_ptr<tile::Buffer>> outputs) {
   std::map<std::string, void*> buffers;
-  // map in the input buffers, preserving contents
+  // map in the input buffers, preserving contents; host-resident buffers are used directly
   for (auto& kvp : inputs) {
     IVLOG(2, "Input: " << kvp.first);
-    auto view = kvp.second->MapCurrent(ctx).get();
-    buffers.emplace(kvp.first, view->data());
+    void* data = kvp.second->host_data();
+    if (!data) {
+      data = kvp.second->MapCurrentSync(ctx)->data();
+    }
+    buffers.emplace(kvp.first, data);
   }
   // map in output buffers, discarding contents
   for (auto& kvp : outputs) {
     IVLOG(2, "Output: " << kvp.first);
     // don't overwrite the buffer if it's already been mapped in
     if (buffers.find(kvp.first) == buffers.end()) {
-      auto view = kvp.second->MapDiscard(ctx);
-      buffers.emplace(kvp.first, view->data());
+      void* data = kvp.second->host_data();
+      if (!data) {
+        data = kvp.second->MapDiscard(ctx)->data();
+      }
+      buffers.emplace(kvp.first, data);
     }
   }
   executable_->run(buffers);
@@ -102,6 +179,19 @@ boost::future<void> CpuProgram::Run(  //
     // dump annotated stripe block contents to disk
     std::ofstream fout(path.string());
     fout << *source_ << std::endl;
+    // Total the counters by block name, so that blocks which were split or
+    // cloned are reported together.
+    std::ofstream blocks(path.string() + ".blocks");
+    targets::cpu::WriteBlockProfileReport(*source_, &blocks);
+    if (env::Get("PLAIDML_CPU_PROFILE_HW") == "1") {
+      // Summarize the hardware counters as a roofline table; peak compute
+      // and bandwidth, when known, let the table classify each block.
+      auto peak_gflops = env::Get("PLAIDML_CPU_PEAK_GFLOPS");
+      auto peak_gbps = env::Get("PLAIDML_CPU_PEAK_GBPS");
+      std::ofstream report(path.string() + ".roofline");
+      targets::cpu::WriteRooflineReport(*source_, &report, peak_gflops.empty() ? 0 : std::stod(peak_gflops),
+                                        peak_gbps.empty() ? 0 : std::stod(peak_gbps));
+    }
   }
   return boost::make_ready_future();
 }
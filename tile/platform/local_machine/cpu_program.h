@@ -8,6 +8,7 @@
 
 #include "tile/base/program.h"
 #include "tile/lang/runinfo.h"
+#include "tile/platform/local_machine/local_machine.pb.h"
 #include "tile/proto/tile.pb.h"
 #include "tile/stripe/stripe.h"
 
@@ -35,6 +36,9 @@ class CpuProgram final : public tile::Program {
       const std::shared_ptr<stripe::Program>& stripe,  //
       ConstBufferManager* const_bufs);
 
+  // Reconstructs a program written by Save, skipping the optimization passes.
+  explicit CpuProgram(const proto::SavedProgram& saved);
+
   ~CpuProgram();
 
   boost::future<void> Run(          //
@@ -48,7 +52,13 @@ class CpuProgram final : public tile::Program {
   // Release resource used by the program
   void Release() final;
 
+  std::string Save(const context::Context& ctx) final;
+
  private:
+  void Compile();
+
+  std::string target_;
+  std::shared_ptr<stripe::Program> program_;  // The optimized program.
   std::unique_ptr<tile::targets::cpu::Native> executable_;
   std::shared_ptr<stripe::Block> source_;
 };
@@ -31,7 +31,8 @@ class DirectMemView final : public View {
 class DirectMemChunk final : public MemChunk {
  public:
   DirectMemChunk(const context::Context& ctx, const std::shared_ptr<DevInfo>& devinfo, std::uint64_t size,
-                 hal::Memory* source);
+                 hal::Memory* source, MemCharge charge);
+  DirectMemChunk(const std::shared_ptr<DevInfo>& devinfo, std::uint64_t size, std::shared_ptr<hal::Buffer> mem);
 
   // Buffer implementation
   boost::future<std::unique_ptr<View>> MapCurrent(const context::Context& ctx) final;
@@ -47,6 +48,7 @@ class DirectMemChunk final : public MemChunk {
   std::shared_ptr<DevInfo> devinfo_;
   std::shared_ptr<MemDeps> deps_;
   std::shared_ptr<hal::Buffer> mem_;
+  MemCharge charge_;
 };
 
 // Implementation
@@ -67,11 +69,15 @@ void DirectMemView::WriteBack(const context::Context& ctx) {
 }
 
 DirectMemChunk::DirectMemChunk(const context::Context& ctx, const std::shared_ptr<DevInfo>& devinfo, std::uint64_t size,
-                               hal::Memory* source)
-    : size_{size}, devinfo_{devinfo}, deps_{std::make_shared<MemDeps>()} {
+                               hal::Memory* source, MemCharge charge)
+    : size_{size}, devinfo_{devinfo}, deps_{std::make_shared<MemDeps>()}, charge_{std::move(charge)} {
   mem_ = source->MakeBuffer(size_, hal::BufferAccessMask::ALL);
 }
 
+DirectMemChunk::DirectMemChunk(const std::shared_ptr<DevInfo>& devinfo, std::uint64_t size,
+                               std::shared_ptr<hal::Buffer> mem)
+    : size_{size}, devinfo_{devinfo}, deps_{std::make_shared<MemDeps>()}, mem_{std::move(mem)} {}
+
 boost::future<std::unique_ptr<View>> DirectMemChunk::MapCurrent(const context::Context& ctx) {
   context::Context ctx_copy{ctx};
   std::vector<std::shared_ptr<hal::Event>> deps;
@@ -93,14 +99,23 @@ std::unique_ptr<View> DirectMemChunk::MapDiscard(const context::Context& ctx) {
 }  // namespace
 
 DirectMemStrategy::DirectMemStrategy(const std::shared_ptr<DevInfo>& devinfo, hal::Memory* source)
-    : devinfo_{devinfo}, source_{source} {
+    : devinfo_{devinfo}, source_{source}, account_{MemOwner{devinfo->dev->description(), "user", ""}} {
   if (!source_) {
     throw std::logic_error{"The direct memory management strategy requires source memory"};
   }
 }
 
 std::shared_ptr<MemChunk> DirectMemStrategy::MakeChunk(const context::Context& ctx, std::uint64_t size) const {
-  return std::make_shared<DirectMemChunk>(ctx, devinfo_, size, source_);
+  return std::make_shared<DirectMemChunk>(ctx, devinfo_, size, source_, account_.Charge(size));
+}
+
+std::shared_ptr<MemChunk> DirectMemStrategy::WrapChunk(const context::Context& ctx, void* base,
+                                                       std::uint64_t size) const {
+  auto mem = source_->WrapBuffer(base, size, hal::BufferAccessMask::ALL);
+  if (!mem) {
+    return nullptr;
+  }
+  return std::make_shared<DirectMemChunk>(devinfo_, size, std::move(mem));
 }
 
 }  // namespace local_machine
@@ -6,21 +6,25 @@
 
 #include "tile/platform/local_machine/devinfo.h"
 #include "tile/platform/local_machine/mem_strategy.h"
+#include "tile/platform/local_machine/mem_usage.h"
 
 namespace vertexai {
 namespace tile {
 namespace local_machine {
 
 // DirectMemStrategy manages memory by copying buffers to and from devices.
+// The buffers it allocates are charged to the device's "user" account.
 class DirectMemStrategy final : public MemStrategy {
  public:
   DirectMemStrategy(const std::shared_ptr<DevInfo>& devinfo, hal::Memory* source);
 
   std::shared_ptr<MemChunk> MakeChunk(const context::Context& ctx, std::uint64_t size) const final;
+  std::shared_ptr<MemChunk> WrapChunk(const context::Context& ctx, void* base, std::uint64_t size) const final;
 
  private:
   std::shared_ptr<DevInfo> devinfo_;
   hal::Memory* source_ = nullptr;
+  MemAccount account_;
 };
 
 }  // namespace local_machine
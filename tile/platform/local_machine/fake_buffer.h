@@ -0,0 +1,29 @@
+// Copyright 2020, Intel Corp.
+
+#pragma once
+
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "tile/base/hal.h"
+
+namespace vertexai {
+namespace tile {
+namespace local_machine {
+
+// A hal::Buffer with no storage, for tests which only track buffers' identity, such as the memory cache's.
+class FakeBuffer final : public hal::Buffer {
+ public:
+  boost::future<void*> MapCurrent(const std::vector<std::shared_ptr<hal::Event>>& deps) final {
+    throw std::runtime_error("unimplemented");
+  }
+  boost::future<void*> MapDiscard(const std::vector<std::shared_ptr<hal::Event>>& deps) final {
+    throw std::runtime_error("unimplemented");
+  }
+  std::shared_ptr<hal::Event> Unmap(const context::Context& ctx) final { return nullptr; }
+};
+
+}  // namespace local_machine
+}  // namespace tile
+}  // namespace vertexai
@@ -4,6 +4,8 @@
 
 #include <vector>
 
+#include <boost/dynamic_bitset.hpp>
+
 #include "base/util/error.h"
 
 namespace vertexai {
@@ -532,21 +534,31 @@ bool IsBetterPlan(Build* b, const StepPlan& lhs, const StepPlan& rhs) {
   return lhs.pending_step()->distance > rhs.pending_step()->distance;
 }
 
+// Returns the sum over a step's inputs of the memtime since each was last loaded.
+std::uint64_t InputDeltatimeSum(Build* b, PendingStep* ps) {
+  std::uint64_t sum = 0;
+  for (schedule::Alloc* input : ps->step->inputs) {
+    sum += b->current_memtime - b->value_locs[input]->cache_memtime;
+  }
+  return sum;
+}
+
 // Attempt to schedule at least one runnable step, returning true iff a step was scheduled.
 bool ScheduleRunnableStep(Build* b) {
   StepPlan best;
-  for (StepPlan& plan : StepPlanner{b}) {
-    if (b->running != b->scheduled.end()) {
-      // Not everything has been retired, so we want a couple of additional checks in order
-      // to prioritize useful work.
-      if (b->mem_available < plan.mem_needed()) {
-        // Don't bother with over-the-limit plans.
-        continue;
-      }
-      if (kMaxInputDeltatime < plan.input_deltatime_sum()) {
-        // Don't bother with plans whose inputs are ancient.
-        continue;
-      }
+  bool busy = b->running != b->scheduled.end();
+  for (PendingStep* ps : RunnableSteps{&b->pending}) {
+    // Not everything has been retired, so we want a couple of additional checks in order
+    // to prioritize useful work.  The input check is cheap, so it's made before planning the
+    // step's outputs; with thousands of runnable steps, most plans would be thrown away.
+    if (busy && kMaxInputDeltatime < InputDeltatimeSum(b, ps)) {
+      // Don't bother with plans whose inputs are ancient.
+      continue;
+    }
+    StepPlan plan{b, ps};
+    if (busy && b->mem_available < plan.mem_needed()) {
+      // Don't bother with over-the-limit plans.
+      continue;
     }
     if (!best || IsBetterPlan(b, plan, best)) {
       best = std::move(plan);
@@ -595,7 +607,10 @@ void AddDeps(schedule::Schedule* schedule) {
     std::unordered_set<schedule::Step*> active_readers;
   };
   std::unordered_map<schedule::Alloc*, BusyInfo> busy_infos;
-  std::vector<std::set<schedule::Step*>> transitive_deps{schedule->steps.size()};
+  // Bitsets rather than sets of steps: each step's set holds all of its ancestors, so for long
+  // chains of kernels the sets themselves are quadratic in the number of steps.
+  std::size_t step_count = schedule->steps.size();
+  std::vector<boost::dynamic_bitset<>> transitive_deps{step_count, boost::dynamic_bitset<>(step_count)};
   for (auto& step : schedule->steps) {
     std::set<schedule::Step*> deps;
     IVLOG(3, "Adding dataflow deps to s" << step.idx);
@@ -640,16 +655,19 @@ void AddDeps(schedule::Schedule* schedule) {
       res.first->second.latest_writer = &step;
       res.first->second.active_readers.clear();
     }
-    std::set<schedule::Step*>& tdeps = transitive_deps[step.idx];
+    auto& tdeps = transitive_deps[step.idx];
     for (schedule::Step* depstep : deps) {
-      tdeps.insert(transitive_deps[depstep->idx].begin(), transitive_deps[depstep->idx].end());
+      tdeps |= transitive_deps[depstep->idx];
     }
 
-    std::set_difference(deps.begin(), deps.end(), tdeps.begin(), tdeps.end(),
-                        std::inserter(step.deps, step.deps.end()));
+    for (schedule::Step* dep : deps) {
+      if (!tdeps.test(dep->idx)) {
+        step.deps.insert(dep);
+      }
+    }
 
     for (schedule::Step* dep : deps) {
-      tdeps.insert(dep);
+      tdeps.set(dep->idx);
     }
   }
 }
@@ -948,10 +966,7 @@ StepPlan::StepPlan(Build* b, PendingStep* ps) : ps_{ps} {
     mem_needed_ += mem_size;
   }
 
-  // Compute input deltatime sum.
-  for (schedule::Alloc* input : ps->step->inputs) {
-    input_deltatime_sum_ += b->current_memtime - b->value_locs[input]->cache_memtime;
-  }
+  input_deltatime_sum_ = InputDeltatimeSum(b, ps);
 }
 
 void StepPlan::Apply(Build* b) {
@@ -0,0 +1,87 @@
+// Copyright 2019, Intel Corp.
+
+#include "tile/platform/local_machine/launch_plan.h"
+
+#include <map>
+
+namespace vertexai {
+namespace tile {
+namespace local_machine {
+
+LaunchPlan CaptureLaunchPlan(const schedule::Schedule& schedule) {
+  LaunchPlan plan;
+  plan.steps.reserve(schedule.steps.size());
+  std::vector<bool> has_dependents(schedule.steps.size(), false);
+  for (const auto& step : schedule.steps) {
+    LaunchStep launch;
+    launch.step = &step;
+    launch.deps.reserve(step.deps.size());
+    for (const auto* dep : step.deps) {
+      launch.deps.push_back(dep->idx);
+      has_dependents[dep->idx] = true;
+    }
+    launch.params.reserve(step.outputs.size() + step.inputs.size());
+    for (const auto& out : step.outputs) {
+      launch.params.push_back(out.allocp);
+      if (!out.allocp->is_tmp()) {
+        launch.sync_in.push_back(out.allocp);
+        if (out.add_dep) {
+          launch.sync_out.push_back(out.allocp);
+        }
+      }
+    }
+    for (auto* in : step.inputs) {
+      launch.params.push_back(in);
+      if (!in->is_tmp()) {
+        launch.sync_in.push_back(in);
+      }
+    }
+    plan.steps.emplace_back(std::move(launch));
+  }
+  for (std::size_t sidx = 0; sidx < has_dependents.size(); ++sidx) {
+    if (!has_dependents[sidx]) {
+      plan.terminal.push_back(sidx);
+    }
+  }
+  return plan;
+}
+
+void MarkMemoized(LaunchPlan* plan, const std::set<std::string>& constants) {
+  std::map<const schedule::Alloc*, std::size_t> writers;
+  for (const auto& launch : plan->steps) {
+    for (const auto& out : launch.step->outputs) {
+      writers[out.allocp]++;
+    }
+  }
+  // The steps are in dependency order, so each step's inputs have been classified before the step is.
+  std::set<const schedule::Alloc*> memo_allocs;
+  std::set<schedule::Alloc*> memo_inputs;
+  for (auto& launch : plan->steps) {
+    const auto& step = *launch.step;
+    bool memoized = true;
+    for (const auto& out : step.outputs) {
+      memoized &= out.allocp->is_tmp() && writers[out.allocp] == 1;
+    }
+    for (const auto* in : step.inputs) {
+      bool constant = in->is_input() && !in->is_output() && constants.count(in->input);
+      memoized &= constant || memo_allocs.count(in);
+    }
+    if (!memoized) {
+      continue;
+    }
+    launch.memoized = true;
+    for (const auto& out : step.outputs) {
+      memo_allocs.insert(out.allocp);
+      plan->memo_allocs.push_back(out.allocp);
+    }
+    for (auto* in : step.inputs) {
+      if (in->is_input() && memo_inputs.insert(in).second) {
+        plan->memo_inputs.push_back(in);
+      }
+    }
+  }
+}
+
+}  // namespace local_machine
+}  // namespace tile
+}  // namespace vertexai
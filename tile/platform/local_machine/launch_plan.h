@@ -0,0 +1,49 @@
+// Copyright 2019, Intel Corp.
+
+#pragma once
+
+#include <cstddef>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "tile/base/schedule.h"
+
+namespace vertexai {
+namespace tile {
+namespace local_machine {
+
+// A LaunchPlan is a schedule captured into the form RunSchedule consumes, so
+// that each run replays a flat list of launches and only looks up the run's
+// memory chunks.
+//
+// Temporaries are private to a run and the schedule's own dependencies
+// already order every access to them, so only program inputs and outputs
+// consult (and update) their chunks' MemDeps.
+struct LaunchStep {
+  const schedule::Step* step;
+  std::vector<std::size_t> deps;           // Indices of the steps this step waits for
+  std::vector<schedule::Alloc*> params;    // Outputs, then inputs
+  std::vector<schedule::Alloc*> sync_in;   // Program I/O whose pending writes this step waits for
+  std::vector<schedule::Alloc*> sync_out;  // Program outputs whose readers must wait for this step
+  bool memoized = false;                   // Whether runs may reuse the step's results from an earlier run
+};
+
+struct LaunchPlan {
+  std::vector<LaunchStep> steps;
+  std::vector<std::size_t> terminal;          // Steps no other step waits for
+  std::vector<schedule::Alloc*> memo_inputs;  // The constant inputs the memoized steps read
+  std::vector<schedule::Alloc*> memo_allocs;  // The temporaries holding the memoized steps' results
+};
+
+// Captures a validated schedule.
+LaunchPlan CaptureLaunchPlan(const schedule::Schedule& schedule);
+
+// Marks the steps whose results are the same on every run for as long as the named constant inputs are unchanged:
+// those which read only those inputs and the results of other such steps.  A step qualifies only if its outputs are
+// temporaries which no other step writes, so that its results can be kept from one run to the next.
+void MarkMemoized(LaunchPlan* plan, const std::set<std::string>& constants);
+
+}  // namespace local_machine
+}  // namespace tile
+}  // namespace vertexai
@@ -0,0 +1,110 @@
+// Copyright 2019, Intel Corp.
+
+#include <gmock/gmock.h>
+
+#include "tile/platform/local_machine/launch_plan.h"
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+namespace vertexai {
+namespace tile {
+namespace local_machine {
+namespace {
+
+TEST(LaunchPlanTest, OnlyProgramIOIsSynchronized) {
+  // in -> k0 -> tmp -> k1 -> out
+  schedule::Schedule schedule;
+  schedule.allocs.emplace_back();
+  auto* in = &schedule.allocs.back();
+  in->input = "I";
+  schedule.allocs.emplace_back();
+  auto* tmp = &schedule.allocs.back();
+  schedule.allocs.emplace_back();
+  auto* out = &schedule.allocs.back();
+  out->output = "O";
+
+  schedule.steps.emplace_back(schedule::Step::Tag::kRun);
+  auto* k0 = &schedule.steps.back();
+  k0->inputs.push_back(in);
+  k0->outputs.push_back(schedule::OutputInfo{tmp, true});
+  schedule.steps.emplace_back(schedule::Step::Tag::kRun);
+  auto* k1 = &schedule.steps.back();
+  k1->kidx = 1;
+  k1->inputs.push_back(tmp);
+  k1->outputs.push_back(schedule::OutputInfo{out, true});
+  k1->deps.insert(k0);
+  schedule.Reindex();
+
+  auto plan = CaptureLaunchPlan(schedule);
+  ASSERT_EQ(plan.steps.size(), 2);
+  EXPECT_THAT(plan.steps[0].deps, IsEmpty());
+  EXPECT_THAT(plan.steps[0].params, ElementsAre(tmp, in));
+  EXPECT_THAT(plan.steps[0].sync_in, ElementsAre(in));
+  EXPECT_THAT(plan.steps[0].sync_out, IsEmpty());
+  EXPECT_THAT(plan.steps[1].deps, ElementsAre(0));
+  EXPECT_THAT(plan.steps[1].params, ElementsAre(out, tmp));
+  EXPECT_THAT(plan.steps[1].sync_in, ElementsAre(out));
+  EXPECT_THAT(plan.steps[1].sync_out, ElementsAre(out));
+  EXPECT_THAT(plan.terminal, ElementsAre(1));
+}
+
+TEST(LaunchPlanTest, StepsReadingOnlyConstantsAreMemoized) {
+  // C -> k0 -> t0 -> k1 -> t1 -> k2 -> out
+  //                           I -/
+  schedule::Schedule schedule;
+  schedule.allocs.emplace_back();
+  auto* c = &schedule.allocs.back();
+  c->input = "C";
+  schedule.allocs.emplace_back();
+  auto* in = &schedule.allocs.back();
+  in->input = "I";
+  schedule.allocs.emplace_back();
+  auto* t0 = &schedule.allocs.back();
+  schedule.allocs.emplace_back();
+  auto* t1 = &schedule.allocs.back();
+  schedule.allocs.emplace_back();
+  auto* out = &schedule.allocs.back();
+  out->output = "O";
+
+  schedule.steps.emplace_back(schedule::Step::Tag::kRun);
+  auto* k0 = &schedule.steps.back();
+  k0->inputs.push_back(c);
+  k0->outputs.push_back(schedule::OutputInfo{t0, true});
+  schedule.steps.emplace_back(schedule::Step::Tag::kRun);
+  auto* k1 = &schedule.steps.back();
+  k1->kidx = 1;
+  k1->inputs.push_back(t0);
+  k1->outputs.push_back(schedule::OutputInfo{t1, true});
+  k1->deps.insert(k0);
+  schedule.steps.emplace_back(schedule::Step::Tag::kRun);
+  auto* k2 = &schedule.steps.back();
+  k2->kidx = 2;
+  k2->inputs.push_back(t1);
+  k2->inputs.push_back(in);
+  k2->outputs.push_back(schedule::OutputInfo{out, true});
+  k2->deps.insert(k1);
+  schedule.Reindex();
+
+  auto plan = CaptureLaunchPlan(schedule);
+  MarkMemoized(&plan, {"C"});
+  ASSERT_EQ(plan.steps.size(), 3);
+  EXPECT_TRUE(plan.steps[0].memoized);
+  EXPECT_TRUE(plan.steps[1].memoized);
+  EXPECT_FALSE(plan.steps[2].memoized);
+  EXPECT_THAT(plan.memo_inputs, ElementsAre(c));
+  EXPECT_THAT(plan.memo_allocs, ElementsAre(t0, t1));
+
+  // Without constants, nothing is memoized.
+  auto plain = CaptureLaunchPlan(schedule);
+  MarkMemoized(&plain, {});
+  for (const auto& launch : plain.steps) {
+    EXPECT_FALSE(launch.memoized);
+  }
+  EXPECT_THAT(plain.memo_allocs, IsEmpty());
+}
+
+}  // namespace
+}  // namespace local_machine
+}  // namespace tile
+}  // namespace vertexai
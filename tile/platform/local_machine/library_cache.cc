@@ -0,0 +1,65 @@
+// Copyright 2019, Intel Corp.
+
+#include "tile/platform/local_machine/library_cache.h"
+
+#include <sstream>
+#include <utility>
+
+#include "base/util/logging.h"
+#include "tile/platform/local_machine/local_machine.pb.h"
+
+namespace vertexai {
+namespace tile {
+namespace local_machine {
+namespace {
+
+// Bump this whenever the cache's file format or key changes, or when the
+// compilers change in a way that makes previously cached libraries incorrect.
+const char kLibraryCacheFormat[] = "2";
+
+}  // namespace
+
+std::shared_ptr<LibraryCache> LibraryCache::FromEnv() {
+  auto blobs = BlobCache::FromEnv("PLAIDML_PROGRAM_CACHE_DIR", ".lib");
+  return blobs ? std::make_shared<LibraryCache>(*blobs) : nullptr;
+}
+
+LibraryCache::LibraryCache(BlobCache blobs) : blobs_{std::move(blobs)} {}
+
+std::string LibraryCache::Key(const DevInfo& devinfo, const std::string& ops) {
+  std::stringstream ss;
+  ss << "format " << kLibraryCacheFormat << "\n"
+     << "device " << devinfo.dev->description() << "\n"
+     << "settings " << devinfo.settings.ShortDebugString() << "\n"
+     << ops;
+  return ss.str();
+}
+
+bool LibraryCache::Load(const std::string& key, std::map<std::string, std::string>* binaries) const {
+  std::string blob;
+  if (!blobs_.Load(key, &blob)) {
+    return false;
+  }
+  proto::LibraryCacheEntry entry;
+  if (!entry.ParseFromString(blob)) {
+    IVLOG(1, "Unable to parse program cache entry " << blobs_.PathFor(key));
+    return false;
+  }
+  binaries->clear();
+  for (const auto& kvp : entry.binaries()) {
+    binaries->emplace(kvp.first, kvp.second);
+  }
+  return true;
+}
+
+void LibraryCache::Store(const std::string& key, const std::map<std::string, std::string>& binaries) const {
+  proto::LibraryCacheEntry entry;
+  for (const auto& kvp : binaries) {
+    (*entry.mutable_binaries())[kvp.first] = kvp.second;
+  }
+  blobs_.Store(key, entry.SerializeAsString());
+}
+
+}  // namespace local_machine
+}  // namespace tile
+}  // namespace vertexai
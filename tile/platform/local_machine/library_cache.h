@@ -0,0 +1,40 @@
+// Copyright 2019, Intel Corp.
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include "base/util/blob_cache.h"
+#include "tile/platform/local_machine/devinfo.h"
+
+namespace vertexai {
+namespace tile {
+namespace local_machine {
+
+// A persistent, on-disk store of compiled HAL libraries, shared by every
+// process pointed at the same directory.  Entries are keyed by the program's
+// ops and shapes, the device and its hardware settings, and a fingerprint of
+// the cache format, and stored in a BlobCache.
+class LibraryCache final {
+ public:
+  // Returns the cache named by PLAIDML_PROGRAM_CACHE_DIR, or nullptr if the
+  // variable is unset.
+  static std::shared_ptr<LibraryCache> FromEnv();
+
+  explicit LibraryCache(BlobCache blobs);
+
+  static std::string Key(const DevInfo& devinfo, const std::string& ops);
+
+  // Returns true and fills in the binaries if the key is present.
+  bool Load(const std::string& key, std::map<std::string, std::string>* binaries) const;
+  void Store(const std::string& key, const std::map<std::string, std::string>& binaries) const;
+
+ private:
+  BlobCache blobs_;
+};
+
+}  // namespace local_machine
+}  // namespace tile
+}  // namespace vertexai
@@ -2,26 +2,173 @@
 
 #include "tile/platform/local_machine/mem_cache.h"
 
+#include <algorithm>
 #include <utility>
+#include <vector>
+
+#include "base/util/logging.h"
+#include "base/util/perf_counter.h"
 
 namespace vertexai {
 namespace tile {
 namespace local_machine {
+namespace {
+
+PerfCounter cache_hits("mem_cache_hits");
+PerfCounter cache_misses("mem_cache_misses");
+PerfCounter cached_bytes_counter("mem_cache_cached_bytes");  // Summed over all caches
+PerfCounter trimmed_bytes("mem_cache_trimmed_bytes");
+PerfCounter defrags("mem_cache_defrags");
+PerfCounter defrag_bytes("mem_cache_defrag_bytes");
+
+constexpr std::uint64_t kMinClassSize = 256;
+
+}  // namespace
+
+MemCache::MemCache(std::uint64_t max_cached_bytes, MemOwner owner)
+    : max_cached_bytes_{max_cached_bytes}, account_{std::move(owner)} {}
+
+std::size_t MemCache::ClassIndex(std::uint64_t size) {
+  if (size <= kMinClassSize) {
+    return 0;
+  }
+  // Sizes in (2^n, 2^(n+1)] are split into kClassesPerDoubling classes, each
+  // ending on a multiple of 2^(n-2).
+  std::size_t log2 = 63 - __builtin_clzll(size - 1);
+  std::size_t sub = ((size - 1) >> (log2 - 2)) & (kClassesPerDoubling - 1);
+  return 1 + (log2 - 8) * kClassesPerDoubling + sub;
+}
+
+std::uint64_t MemCache::ClassSize(std::size_t index) {
+  if (index == 0) {
+    return kMinClassSize;
+  }
+  std::size_t log2 = (index - 1) / kClassesPerDoubling + 8;
+  std::size_t sub = (index - 1) % kClassesPerDoubling;
+  return (std::uint64_t{1} << log2) + (sub + 1) * (std::uint64_t{1} << (log2 - 2));
+}
+
+std::uint64_t MemCache::SizeClass(std::uint64_t size) { return ClassSize(ClassIndex(size)); }
 
 std::shared_ptr<hal::Buffer> MemCache::TryAlloc(std::size_t size) {
-  std::lock_guard<std::mutex> lock{mu_};
-  auto& l = mem_[size];
-  if (l.size()) {
-    std::shared_ptr<hal::Buffer> result{std::move(l.top())};
-    l.pop();
-    return result;
+  auto& pool = pools_[ClassIndex(size)];
+  std::shared_ptr<hal::Buffer> result;
+  {
+    std::lock_guard<std::mutex> lock{pool.mu};
+    if (pool.entries.size()) {
+      result = std::move(pool.entries.back().buffer);
+      pool.entries.pop_back();
+      cached_bytes_ -= SizeClass(size);
+    }
+  }
+  if (result) {
+    cached_bytes_counter.add(-static_cast<std::int64_t>(SizeClass(size)));
+    cache_hits.inc();
+  } else {
+    cache_misses.inc();
   }
-  return std::shared_ptr<hal::Buffer>{};
+  return result;
 }
 
 void MemCache::Free(std::size_t size, std::shared_ptr<hal::Buffer> mem) {
-  std::lock_guard<std::mutex> lock{mu_};
-  mem_[size].push(std::move(mem));
+  auto& pool = pools_[ClassIndex(size)];
+  std::uint64_t cached;
+  {
+    // The byte count changes under the pool's lock, so a TryAlloc which takes
+    // this entry can't subtract it before it has been added.
+    std::lock_guard<std::mutex> lock{pool.mu};
+    pool.entries.emplace_back(Entry{clock_++, std::move(mem), account_.Charge(SizeClass(size))});
+    cached = cached_bytes_ += SizeClass(size);
+  }
+  cached_bytes_counter.add(SizeClass(size));
+  if (cached > max_cached_bytes_) {
+    Trim(max_cached_bytes_);
+  }
+  // Checking for stale buffers scans every size class, so it's only done every
+  // few frees; buffers don't become stale any faster than that.
+  if (defrag_threshold_ > 0 && clock_ % std::max<std::uint64_t>(1, stale_frees_ / 4) == 0 &&
+      Fragmentation() > defrag_threshold_) {
+    Defragment();
+  }
+}
+
+void MemCache::EnableDefrag(double threshold, std::uint64_t stale_frees) {
+  defrag_threshold_ = threshold;
+  stale_frees_ = stale_frees;
+}
+
+double MemCache::Fragmentation() {
+  std::uint64_t now = clock_;
+  std::uint64_t cached = 0;
+  std::uint64_t stale = 0;
+  for (std::size_t idx = 0; idx < kNumClasses; ++idx) {
+    std::lock_guard<std::mutex> lock{pools_[idx].mu};
+    const auto& entries = pools_[idx].entries;
+    cached += entries.size() * ClassSize(idx);
+    for (auto it = entries.begin(); it != entries.end() && it->freed_at + stale_frees_ < now; ++it) {
+      stale += ClassSize(idx);
+    }
+  }
+  return cached ? static_cast<double>(stale) / cached : 0.0;
+}
+
+std::uint64_t MemCache::Defragment() {
+  std::lock_guard<std::mutex> trim_lock{trim_mu_};
+  std::uint64_t now = clock_;
+  std::uint64_t released = 0;
+  std::vector<std::shared_ptr<hal::Buffer>> victims;
+  for (std::size_t idx = 0; idx < kNumClasses; ++idx) {
+    std::lock_guard<std::mutex> lock{pools_[idx].mu};
+    auto& entries = pools_[idx].entries;
+    // Entries are oldest first, so the stale ones are at the front.
+    while (entries.size() && entries.front().freed_at + stale_frees_ < now) {
+      victims.emplace_back(std::move(entries.front().buffer));
+      entries.pop_front();
+      released += ClassSize(idx);
+    }
+  }
+  cached_bytes_ -= released;
+  cached_bytes_counter.add(-static_cast<std::int64_t>(released));
+  if (released) {
+    defrags.inc();
+    defrag_bytes.add(released);
+    IVLOG(1, "MemCache: released " << victims.size() << " stale buffers (" << released << " bytes)");
+  }
+  return released;
+}
+
+std::uint64_t MemCache::Trim(std::uint64_t target) {
+  std::lock_guard<std::mutex> trim_lock{trim_mu_};
+  std::uint64_t released = 0;
+  while (cached_bytes_ > target) {
+    // Find the class holding the least recently freed buffer.
+    std::size_t oldest = kNumClasses;
+    std::uint64_t oldest_at = UINT64_MAX;
+    for (std::size_t idx = 0; idx < kNumClasses; ++idx) {
+      std::lock_guard<std::mutex> lock{pools_[idx].mu};
+      if (pools_[idx].entries.size() && pools_[idx].entries.front().freed_at < oldest_at) {
+        oldest = idx;
+        oldest_at = pools_[idx].entries.front().freed_at;
+      }
+    }
+    if (oldest == kNumClasses) {
+      break;
+    }
+    std::shared_ptr<hal::Buffer> victim;
+    {
+      std::lock_guard<std::mutex> lock{pools_[oldest].mu};
+      if (pools_[oldest].entries.empty()) {
+        continue;  // Taken by TryAlloc in the meantime
+      }
+      victim = std::move(pools_[oldest].entries.front().buffer);
+      pools_[oldest].entries.pop_front();
+      cached_bytes_ -= ClassSize(oldest);
+    }
+    released += ClassSize(oldest);
+  }
+  cached_bytes_counter.add(-static_cast<std::int64_t>(released));
+  trimmed_bytes.add(released);
+  return released;
 }
 
 }  // namespace local_machine
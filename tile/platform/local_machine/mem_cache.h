@@ -2,27 +2,96 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <cstdint>
+#include <deque>
 #include <memory>
 #include <mutex>
-#include <stack>
-#include <unordered_map>
+#include <utility>
 
 #include "tile/base/hal.h"
+#include "tile/platform/local_machine/mem_usage.h"
 
 namespace vertexai {
 namespace tile {
 namespace local_machine {
 
 // Caches device memory allocations.
+//
+// Allocations are rounded up to size classes -- four per power of two, so no
+// more than a quarter of any buffer is wasted -- which lets programs whose
+// temporaries change size slightly (e.g. with the batch size) reuse each
+// other's buffers.  Each size class has its own lock.  Once the free buffers
+// held by the cache exceed max_cached_bytes, the least recently freed ones
+// are released; Trim releases them on demand, e.g. when the device runs out
+// of memory.
+//
+// Optionally, the cache also defragments itself: once too much of what it
+// holds is stale -- buffers which have sat idle while many others were freed,
+// typically left behind by workloads which no longer run -- the stale buffers
+// are released, so that the device can coalesce their memory for the sizes
+// now in use, rather than failing allocations while holding plenty of memory.
+//
+// Activity is exported through the mem_cache_* performance counters, and the
+// cached buffers are charged to the owner's account.
 class MemCache {
  public:
+  static constexpr std::uint64_t kUnlimited = UINT64_MAX;
+  static constexpr std::uint64_t kDefaultStaleFrees = 1024;
+
+  explicit MemCache(std::uint64_t max_cached_bytes = kUnlimited, MemOwner owner = MemOwner{"", "cache", ""});
+
+  // The size of the buffer which will actually be allocated for a request.
+  static std::uint64_t SizeClass(std::uint64_t size);
+
   std::shared_ptr<hal::Buffer> TryAlloc(std::size_t size);
   void Free(std::size_t size, std::shared_ptr<hal::Buffer>);
 
+  // Releases free buffers until no more than target bytes remain cached.
+  // Returns the number of bytes released.
+  std::uint64_t Trim(std::uint64_t target = 0);
+
+  // Enables defragmentation: a buffer is stale once stale_frees others have
+  // been freed since it was, and the stale buffers are released whenever they
+  // exceed threshold (a fraction) of the cached bytes.  Must be called before
+  // the cache is used.
+  void EnableDefrag(double threshold, std::uint64_t stale_frees = kDefaultStaleFrees);
+
+  // The fraction of the cached bytes held by stale buffers.
+  double Fragmentation();
+
+  // Releases the stale buffers.  Returns the number of bytes released.
+  std::uint64_t Defragment();
+
+  std::uint64_t cached_bytes() const { return cached_bytes_; }
+
  private:
-  std::mutex mu_;
-  std::unordered_map<std::size_t, std::stack<std::shared_ptr<hal::Buffer>>> mem_;
+  static constexpr std::size_t kClassesPerDoubling = 4;
+  static constexpr std::size_t kNumClasses = 64 * kClassesPerDoubling;
+
+  struct Entry {
+    std::uint64_t freed_at;
+    std::shared_ptr<hal::Buffer> buffer;
+    MemCharge charge;
+  };
+
+  struct SizeClassPool {
+    std::mutex mu;
+    std::deque<Entry> entries;  // Oldest first
+  };
+
+  static std::size_t ClassIndex(std::uint64_t size);
+  static std::uint64_t ClassSize(std::size_t index);
+
+  std::uint64_t max_cached_bytes_;
+  double defrag_threshold_ = 0;  // Zero when defragmentation is disabled
+  std::uint64_t stale_frees_ = kDefaultStaleFrees;
+  MemAccount account_;
+  std::atomic<std::uint64_t> cached_bytes_{0};
+  std::atomic<std::uint64_t> clock_{0};
+  std::mutex trim_mu_;
+  std::array<SizeClassPool, kNumClasses> pools_;
 };
 
 }  // namespace local_machine
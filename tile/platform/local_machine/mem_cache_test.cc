@@ -0,0 +1,88 @@
+// Copyright 2019, Intel Corp.
+
+#include <gmock/gmock.h>
+
+#include <memory>
+#include <vector>
+
+#include "tile/platform/local_machine/fake_buffer.h"
+#include "tile/platform/local_machine/mem_cache.h"
+
+using ::testing::Eq;
+using ::testing::Ge;
+using ::testing::IsNull;
+using ::testing::Le;
+using ::testing::Ne;
+
+namespace vertexai {
+namespace tile {
+namespace local_machine {
+namespace {
+
+TEST(MemCacheTest, SizeClassesBoundWaste) {
+  EXPECT_THAT(MemCache::SizeClass(1), Eq(256));
+  EXPECT_THAT(MemCache::SizeClass(256), Eq(256));
+  EXPECT_THAT(MemCache::SizeClass(257), Eq(320));
+  EXPECT_THAT(MemCache::SizeClass(1024), Eq(1024));
+  EXPECT_THAT(MemCache::SizeClass(1025), Eq(1280));
+  for (std::uint64_t size = 1; size < (1 << 20); size = size * 3 / 2 + 1) {
+    auto rounded = MemCache::SizeClass(size);
+    EXPECT_THAT(rounded, Ge(size));
+    EXPECT_THAT(MemCache::SizeClass(rounded), Eq(rounded));
+    if (size > 256) {
+      EXPECT_THAT(rounded - size, Le(size / 4));
+    }
+  }
+}
+
+TEST(MemCacheTest, ReusesBuffersWithinASizeClass) {
+  MemCache cache;
+  EXPECT_THAT(cache.TryAlloc(1000), IsNull());
+  auto buffer = std::make_shared<FakeBuffer>();
+  cache.Free(1000, buffer);
+  EXPECT_THAT(cache.cached_bytes(), Eq(1024));
+  EXPECT_THAT(cache.TryAlloc(2000), IsNull());
+  EXPECT_THAT(cache.TryAlloc(1010), Eq(buffer));
+  EXPECT_THAT(cache.cached_bytes(), Eq(0));
+}
+
+TEST(MemCacheTest, EvictsOldestBuffersOverLimit) {
+  MemCache cache{2048};
+  auto first = std::make_shared<FakeBuffer>();
+  auto second = std::make_shared<FakeBuffer>();
+  auto third = std::make_shared<FakeBuffer>();
+  cache.Free(1024, first);
+  cache.Free(1024, second);
+  cache.Free(512, third);
+  EXPECT_THAT(cache.cached_bytes(), Eq(1536));
+  EXPECT_THAT(first.use_count(), Eq(1));
+  EXPECT_THAT(cache.TryAlloc(1024), Eq(second));
+  EXPECT_THAT(cache.Trim(), Eq(512));
+  EXPECT_THAT(cache.TryAlloc(512), IsNull());
+}
+
+TEST(MemCacheTest, DefragmentReleasesStaleBuffers) {
+  MemCache cache;
+  cache.EnableDefrag(0.75, 4);
+  auto stale = std::make_shared<FakeBuffer>();
+  cache.Free(4096, stale);
+  EXPECT_THAT(cache.Fragmentation(), Eq(0.0));
+  for (int i = 0; i < 3; i++) {
+    cache.Free(256, std::make_shared<FakeBuffer>());
+    EXPECT_THAT(cache.TryAlloc(256), Ne(nullptr));
+  }
+  EXPECT_THAT(stale.use_count(), Eq(2));
+  EXPECT_THAT(cache.Fragmentation(), Eq(0.0));
+
+  // The fourth free makes the first buffer stale; it holds all of the cached
+  // bytes but one small buffer, which is over the threshold.
+  cache.Free(256, std::make_shared<FakeBuffer>());
+  EXPECT_THAT(stale.use_count(), Eq(1));
+  EXPECT_THAT(cache.cached_bytes(), Eq(256));
+  EXPECT_THAT(cache.Defragment(), Eq(0));
+}
+
+}  // namespace
+}  // namespace local_machine
+}  // namespace tile
+}  // namespace vertexai
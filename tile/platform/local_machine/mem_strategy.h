@@ -18,6 +18,12 @@ class MemStrategy {
 
   // Allocates a memory object for kernels to use.
   virtual std::shared_ptr<MemChunk> MakeChunk(const context::Context& ctx, std::uint64_t size) const = 0;
+
+  // Makes a memory object aliasing existing host memory, or returns nullptr if
+  // the strategy cannot use the memory without copying it.
+  virtual std::shared_ptr<MemChunk> WrapChunk(const context::Context& ctx, void* base, std::uint64_t size) const {
+    return nullptr;
+  }
 };
 
 }  // namespace local_machine
@@ -0,0 +1,151 @@
+// Copyright 2020, Intel Corporation.
+
+#include "tile/platform/local_machine/mem_usage.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <tuple>
+#include <utility>
+
+#include "base/util/env.h"
+#include "tile/platform/local_machine/local_machine.pb.h"
+
+namespace vertexai {
+namespace tile {
+namespace local_machine {
+
+struct MemAccountState {
+  explicit MemAccountState(MemOwner owner) : owner{std::move(owner)} {}
+
+  const MemOwner owner;
+  std::atomic<bool> owner_alive{true};
+  std::atomic<std::uint64_t> live_bytes{0};
+  std::atomic<std::uint64_t> live_buffers{0};
+  std::atomic<std::uint64_t> peak_bytes{0};
+};
+
+namespace {
+
+std::mutex& RegistryMutex() {
+  static std::mutex mu;
+  return mu;
+}
+
+std::vector<std::weak_ptr<MemAccountState>>& Registry() {
+  static std::vector<std::weak_ptr<MemAccountState>> registry;
+  return registry;
+}
+
+std::chrono::seconds LogInterval() {
+  auto secs = env::Get("PLAIDML_MEM_USAGE_LOG_SECS");
+  return std::chrono::seconds{secs.empty() ? 60 : std::stoll(secs)};
+}
+
+}  // namespace
+
+MemCharge::MemCharge(std::shared_ptr<MemAccountState> account, std::uint64_t bytes)
+    : account_{std::move(account)}, bytes_{bytes} {
+  auto live = account_->live_bytes += bytes_;
+  account_->live_buffers++;
+  auto peak = account_->peak_bytes.load();
+  while (peak < live && !account_->peak_bytes.compare_exchange_weak(peak, live)) {
+  }
+}
+
+MemCharge::MemCharge(MemCharge&& other) noexcept : account_{std::move(other.account_)}, bytes_{other.bytes_} {
+  other.bytes_ = 0;
+}
+
+MemCharge& MemCharge::operator=(MemCharge&& other) noexcept {
+  if (this != &other) {
+    Release();
+    account_ = std::move(other.account_);
+    bytes_ = other.bytes_;
+    other.bytes_ = 0;
+  }
+  return *this;
+}
+
+MemCharge::~MemCharge() { Release(); }
+
+void MemCharge::Release() {
+  if (account_) {
+    account_->live_bytes -= bytes_;
+    account_->live_buffers--;
+    account_.reset();
+  }
+  bytes_ = 0;
+}
+
+MemAccount::MemAccount(MemOwner owner) : state_{std::make_shared<MemAccountState>(std::move(owner))} {
+  std::lock_guard<std::mutex> lock{RegistryMutex()};
+  Registry().emplace_back(state_);
+}
+
+MemAccount::~MemAccount() { state_->owner_alive = false; }
+
+MemCharge MemAccount::Charge(std::uint64_t bytes) const { return MemCharge{state_, bytes}; }
+
+std::uint64_t MemAccount::live_bytes() const { return state_->live_bytes; }
+
+std::vector<MemUsageSample> SnapshotMemUsage() {
+  std::vector<MemUsageSample> result;
+  {
+    std::lock_guard<std::mutex> lock{RegistryMutex()};
+    auto& registry = Registry();
+    registry.erase(std::remove_if(registry.begin(), registry.end(),
+                                  [](const std::weak_ptr<MemAccountState>& account) { return account.expired(); }),
+                   registry.end());
+    for (const auto& weak : registry) {
+      auto account = weak.lock();
+      if (!account || !account->peak_bytes) {
+        continue;
+      }
+      MemUsageSample sample;
+      sample.owner = account->owner;
+      sample.owner_alive = account->owner_alive;
+      sample.live_bytes = account->live_bytes;
+      sample.live_buffers = account->live_buffers;
+      sample.peak_bytes = account->peak_bytes;
+      result.emplace_back(std::move(sample));
+    }
+  }
+  std::stable_sort(result.begin(), result.end(), [](const MemUsageSample& lhs, const MemUsageSample& rhs) {
+    return std::tie(lhs.owner.device, lhs.owner.kind, lhs.owner.name) <
+           std::tie(rhs.owner.device, rhs.owner.kind, rhs.owner.name);
+  });
+  return result;
+}
+
+void MaybeLogMemUsage(const context::Context& ctx) {
+  if (!ctx.is_logging_events()) {
+    return;
+  }
+  static const auto interval = LogInterval();
+  static std::atomic<std::chrono::steady_clock::rep> next_log{0};
+  auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+  auto next = next_log.load();
+  auto after = now + std::chrono::steady_clock::duration{interval}.count();
+  if (now < next || !next_log.compare_exchange_strong(next, after)) {
+    return;
+  }
+  proto::MemUsage usage;
+  for (const auto& sample : SnapshotMemUsage()) {
+    auto entry = usage.add_entries();
+    entry->set_device(sample.owner.device);
+    entry->set_kind(sample.owner.kind);
+    entry->set_name(sample.owner.name);
+    entry->set_owner_alive(sample.owner_alive);
+    entry->set_live_bytes(sample.live_bytes);
+    entry->set_live_buffers(sample.live_buffers);
+    entry->set_peak_bytes(sample.peak_bytes);
+  }
+  context::Activity activity{ctx, "tile::local_machine::MemUsage"};
+  activity.AddMetadata(usage);
+}
+
+}  // namespace local_machine
+}  // namespace tile
+}  // namespace vertexai
@@ -0,0 +1,86 @@
+// Copyright 2020, Intel Corporation.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/context/context.h"
+
+namespace vertexai {
+namespace tile {
+namespace local_machine {
+
+// Identifies the holder of device memory.  The local machine uses the kinds
+//   user   buffers allocated through the platform
+//   tmp    a program's temporaries, while its runs hold them
+//   cache  a program's idle temporaries, held by its MemCache
+// and names temporaries after the program that owns them.
+struct MemOwner {
+  std::string device;
+  std::string kind;
+  std::string name;
+};
+
+// One owner's memory, as of a snapshot.  An account whose owner has been
+// destroyed remains in the snapshot for as long as any of its charges is
+// alive; those bytes have leaked.
+struct MemUsageSample {
+  MemOwner owner;
+  bool owner_alive = true;
+  std::uint64_t live_bytes = 0;
+  std::uint64_t live_buffers = 0;
+  std::uint64_t peak_bytes = 0;
+};
+
+struct MemAccountState;
+
+// A live allocation's charge against its owner's account, released when the
+// charge is destroyed; allocations keep their charge alongside the buffer.
+class MemCharge {
+ public:
+  MemCharge() = default;
+  MemCharge(std::shared_ptr<MemAccountState> account, std::uint64_t bytes);
+  MemCharge(MemCharge&& other) noexcept;
+  MemCharge& operator=(MemCharge&& other) noexcept;
+  ~MemCharge();
+
+  std::uint64_t bytes() const { return bytes_; }
+
+ private:
+  void Release();
+
+  std::shared_ptr<MemAccountState> account_;
+  std::uint64_t bytes_ = 0;
+};
+
+// An owner's account of the device memory it allocates.  Accounts are
+// registered for SnapshotMemUsage for as long as they, or any charge made
+// against them, are alive.
+class MemAccount {
+ public:
+  explicit MemAccount(MemOwner owner);
+  ~MemAccount();
+
+  MemCharge Charge(std::uint64_t bytes) const;
+
+  std::uint64_t live_bytes() const;
+
+ private:
+  std::shared_ptr<MemAccountState> state_;
+};
+
+// Returns the live memory of every registered account, ordered by device,
+// kind, and name.  Accounts which have never held memory are omitted.
+std::vector<MemUsageSample> SnapshotMemUsage();
+
+// Logs the snapshot to the context's eventlog as a
+// tile::local_machine::MemUsage activity, at most once every
+// PLAIDML_MEM_USAGE_LOG_SECS seconds (default 60; zero logs every call).
+void MaybeLogMemUsage(const context::Context& ctx);
+
+}  // namespace local_machine
+}  // namespace tile
+}  // namespace vertexai
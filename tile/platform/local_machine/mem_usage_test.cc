@@ -0,0 +1,81 @@
+// Copyright 2020, Intel Corp.
+
+#include <gmock/gmock.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tile/platform/local_machine/fake_buffer.h"
+#include "tile/platform/local_machine/mem_cache.h"
+#include "tile/platform/local_machine/mem_usage.h"
+
+using ::testing::Eq;
+using ::testing::IsFalse;
+using ::testing::IsTrue;
+
+namespace vertexai {
+namespace tile {
+namespace local_machine {
+namespace {
+
+// Returns the snapshot of the named owner's account, or nullptr if it isn't reported.
+std::unique_ptr<MemUsageSample> Find(const std::string& device, const std::string& kind, const std::string& name) {
+  for (const auto& sample : SnapshotMemUsage()) {
+    if (sample.owner.device == device && sample.owner.kind == kind && sample.owner.name == name) {
+      return std::make_unique<MemUsageSample>(sample);
+    }
+  }
+  return nullptr;
+}
+
+TEST(MemUsageTest, TracksLiveAndPeakBytes) {
+  MemAccount account{MemOwner{"dev", "tmp", "live_and_peak"}};
+  EXPECT_THAT(Find("dev", "tmp", "live_and_peak"), Eq(nullptr));
+  {
+    auto first = account.Charge(100);
+    auto second = account.Charge(50);
+    auto sample = Find("dev", "tmp", "live_and_peak");
+    ASSERT_THAT(sample, ::testing::NotNull());
+    EXPECT_THAT(sample->live_bytes, Eq(150));
+    EXPECT_THAT(sample->live_buffers, Eq(2));
+    EXPECT_THAT(sample->owner_alive, IsTrue());
+  }
+  auto sample = Find("dev", "tmp", "live_and_peak");
+  ASSERT_THAT(sample, ::testing::NotNull());
+  EXPECT_THAT(sample->live_bytes, Eq(0));
+  EXPECT_THAT(sample->live_buffers, Eq(0));
+  EXPECT_THAT(sample->peak_bytes, Eq(150));
+}
+
+TEST(MemUsageTest, ReportsChargesOutlivingTheirOwner) {
+  MemCharge leaked;
+  {
+    MemAccount account{MemOwner{"dev", "tmp", "leaky"}};
+    leaked = account.Charge(4096);
+  }
+  auto sample = Find("dev", "tmp", "leaky");
+  ASSERT_THAT(sample, ::testing::NotNull());
+  EXPECT_THAT(sample->owner_alive, IsFalse());
+  EXPECT_THAT(sample->live_bytes, Eq(4096));
+
+  leaked = MemCharge{};
+  EXPECT_THAT(Find("dev", "tmp", "leaky"), Eq(nullptr));
+}
+
+TEST(MemUsageTest, ChargesCachedBuffersToTheCache) {
+  MemCache cache{MemCache::kUnlimited, MemOwner{"dev", "cache", "cached"}};
+  auto buffer = std::make_shared<FakeBuffer>();
+  cache.Free(1000, buffer);
+  auto sample = Find("dev", "cache", "cached");
+  ASSERT_THAT(sample, ::testing::NotNull());
+  EXPECT_THAT(sample->live_bytes, Eq(1024));
+
+  EXPECT_THAT(cache.TryAlloc(1000), Eq(buffer));
+  EXPECT_THAT(Find("dev", "cache", "cached")->live_bytes, Eq(0));
+}
+
+}  // namespace
+}  // namespace local_machine
+}  // namespace tile
+}  // namespace vertexai
@@ -0,0 +1,48 @@
+// Copyright 2020, Intel Corporation
+
+#include "tile/platform/local_machine/memo_cache.h"
+
+#include <utility>
+
+namespace vertexai {
+namespace tile {
+namespace local_machine {
+
+std::shared_ptr<MemoCache::Entry> MemoCache::Lookup(const context::Context& ctx, const LaunchPlan& plan,
+                                                    std::vector<std::pair<const tile::Buffer*, std::uint64_t>> inputs,
+                                                    const MemStrategy& mem_strategy, bool* compute) {
+  {
+    std::lock_guard<std::mutex> lock{mu_};
+    if (current_ && current_->inputs == inputs) {
+      *compute = false;
+      return current_;
+    }
+  }
+  *compute = true;
+  auto entry = std::make_shared<Entry>();
+  entry->inputs = std::move(inputs);
+  for (const auto* alloc : plan.memo_allocs) {
+    if (entry->chunks.size() <= alloc->idx) {
+      entry->chunks.resize(alloc->idx + 1);
+    }
+    entry->chunks[alloc->idx] = mem_strategy.MakeChunk(ctx, alloc->byte_size);
+  }
+  entry->events.resize(plan.steps.size());
+  return entry;
+}
+
+void MemoCache::Publish(const std::shared_ptr<Entry>& entry) {
+  std::lock_guard<std::mutex> lock{mu_};
+  current_ = entry;
+}
+
+void MemoCache::Invalidate(const std::shared_ptr<Entry>& entry) {
+  std::lock_guard<std::mutex> lock{mu_};
+  if (current_ == entry) {
+    current_.reset();
+  }
+}
+
+}  // namespace local_machine
+}  // namespace tile
+}  // namespace vertexai
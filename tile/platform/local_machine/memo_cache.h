@@ -0,0 +1,54 @@
+// Copyright 2020, Intel Corporation
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "base/context/context.h"
+#include "tile/base/buffer.h"
+#include "tile/base/hal.h"
+#include "tile/platform/local_machine/launch_plan.h"
+#include "tile/platform/local_machine/mem_chunk.h"
+#include "tile/platform/local_machine/mem_strategy.h"
+
+namespace vertexai {
+namespace tile {
+namespace local_machine {
+
+// Keeps the results of a program's memoized steps (see MarkMemoized) from one run to the next.  Each run looks up the
+// results computed from the current versions of the constants the steps read: if an earlier run computed them, the
+// run waits on that run's steps instead of repeating them; otherwise the run computes them into fresh chunks (so that
+// runs still reading older results are undisturbed), and publishes them for later runs.
+class MemoCache {
+ public:
+  // The memoized steps' results for one version of their constant inputs.
+  struct Entry {
+    std::vector<std::pair<const tile::Buffer*, std::uint64_t>> inputs;  // The constants read, and their versions
+    std::vector<std::shared_ptr<MemChunk>> chunks;                      // By alloc index; null if not memoized
+    std::vector<std::shared_ptr<hal::Event>> events;                    // By step index, of the computing run
+  };
+
+  // Returns the results computed from inputs by an earlier run, or fresh results for the caller to compute (in which
+  // case *compute is set).
+  std::shared_ptr<Entry> Lookup(const context::Context& ctx, const LaunchPlan& plan,
+                                std::vector<std::pair<const tile::Buffer*, std::uint64_t>> inputs,
+                                const MemStrategy& mem_strategy, bool* compute);
+
+  // Makes results available to later runs, once the run computing them has queued its steps.
+  void Publish(const std::shared_ptr<Entry>& entry);
+
+  // Forgets results whose computation failed.
+  void Invalidate(const std::shared_ptr<Entry>& entry);
+
+ private:
+  std::mutex mu_;
+  std::shared_ptr<Entry> current_;
+};
+
+}  // namespace local_machine
+}  // namespace tile
+}  // namespace vertexai
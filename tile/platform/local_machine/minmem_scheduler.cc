@@ -0,0 +1,171 @@
+// Copyright 2019, Intel Corp.
+
+#include "tile/platform/local_machine/minmem_scheduler.h"
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include "base/util/error.h"
+#include "base/util/logging.h"
+
+namespace vertexai {
+namespace tile {
+namespace local_machine {
+namespace {
+
+// The temporaries a step reads or writes, without duplicates.
+std::set<schedule::Alloc*> TmpAccesses(const schedule::Step& step) {
+  std::set<schedule::Alloc*> result;
+  for (const auto& out : step.outputs) {
+    if (out.allocp->is_tmp()) {
+      result.insert(out.allocp);
+    }
+  }
+  for (auto* in : step.inputs) {
+    if (in->is_tmp()) {
+      result.insert(in);
+    }
+  }
+  return result;
+}
+
+}  // namespace
+
+std::uint64_t PeakTmpBytes(const schedule::Schedule& schedule) {
+  std::unordered_map<schedule::Alloc*, std::size_t> remaining;
+  for (const auto& step : schedule.steps) {
+    for (auto* alloc : TmpAccesses(step)) {
+      ++remaining[alloc];
+    }
+  }
+  std::set<schedule::Alloc*> live;
+  std::uint64_t live_bytes = 0;
+  std::uint64_t peak = 0;
+  for (const auto& step : schedule.steps) {
+    auto accesses = TmpAccesses(step);
+    for (auto* alloc : accesses) {
+      if (live.insert(alloc).second) {
+        live_bytes += alloc->byte_size;
+      }
+    }
+    peak = std::max(peak, live_bytes);
+    for (auto* alloc : accesses) {
+      if (!--remaining[alloc]) {
+        live_bytes -= alloc->byte_size;
+      }
+    }
+  }
+  return peak;
+}
+
+void OrderForMemory(schedule::Schedule* schedule) {
+  struct StepInfo {
+    std::set<schedule::Alloc*> accesses;
+    std::vector<schedule::Step*> dependents;
+    std::size_t pending = 0;
+  };
+  std::unordered_map<schedule::Step*, StepInfo> infos;
+  std::unordered_map<schedule::Alloc*, std::size_t> remaining;
+  std::set<schedule::Alloc*> live;
+  for (auto& step : schedule->steps) {
+    auto& info = infos[&step];
+    info.accesses = TmpAccesses(step);
+    info.pending = step.deps.size();
+    for (auto* dep : step.deps) {
+      infos[dep].dependents.push_back(&step);
+    }
+    for (auto* alloc : info.accesses) {
+      ++remaining[alloc];
+    }
+  }
+
+  // Ready steps, keyed by their original index so that ties keep program order.
+  std::map<std::size_t, schedule::Step*> ready;
+  for (auto& step : schedule->steps) {
+    if (step.deps.empty()) {
+      ready.emplace(step.idx, &step);
+    }
+  }
+
+  std::unordered_map<const schedule::Step*, std::size_t> position;
+  while (ready.size()) {
+    auto best = ready.end();
+    std::int64_t best_delta = 0;
+    for (auto it = ready.begin(); it != ready.end(); ++it) {
+      std::int64_t delta = 0;
+      for (auto* alloc : infos[it->second].accesses) {
+        if (!live.count(alloc)) {
+          delta += alloc->byte_size;
+        }
+        if (remaining[alloc] == 1) {
+          delta -= alloc->byte_size;
+        }
+      }
+      if (best == ready.end() || delta < best_delta) {
+        best = it;
+        best_delta = delta;
+      }
+    }
+    schedule::Step* step = best->second;
+    ready.erase(best);
+    std::size_t pos = position.size();
+    position[step] = pos;
+    auto& info = infos[step];
+    for (auto* alloc : info.accesses) {
+      live.insert(alloc);
+      if (!--remaining[alloc]) {
+        live.erase(alloc);
+      }
+    }
+    for (auto* dependent : info.dependents) {
+      if (!--infos[dependent].pending) {
+        ready.emplace(dependent->idx, dependent);
+      }
+    }
+  }
+
+  if (position.size() != schedule->steps.size()) {
+    throw error::Internal{"Schedule dependencies contain a cycle"};
+  }
+  schedule->steps.sort(
+      [&](const schedule::Step& lhs, const schedule::Step& rhs) { return position[&lhs] < position[&rhs]; });
+  schedule->Reindex();
+}
+
+MinMemScheduler::MinMemScheduler(const std::shared_ptr<Placer>& placer, std::size_t max_in_flight)
+    : placer_{placer}, max_in_flight_{max_in_flight} {
+  if (!max_in_flight_) {
+    throw error::InvalidArgument{"The minimum-memory scheduler requires at least one step in flight"};
+  }
+}
+
+schedule::Schedule MinMemScheduler::BuildSchedule(const tile::proto::Program& program, const lang::KernelList& kl) {
+  if (IVLOG_IS_ON(1)) {
+    // Report what the program-order schedule would have needed.
+    schedule::Schedule baseline = ToScheduleSteps(program, kl);
+    AddDataflowDeps(&baseline);
+    AddLinearDeps(&baseline, max_in_flight_);
+    auto baseline_peak = PeakTmpBytes(baseline);
+    placer_->PlaceSchedule(program, &baseline)->Apply();
+    VLOG(1) << "Program-order schedule: peak tmp bytes=" << baseline_peak
+            << ", total alloc bytes=" << TotalAllocSize(baseline);
+  }
+
+  schedule::Schedule schedule = ToScheduleSteps(program, kl);
+  AddDataflowDeps(&schedule);
+  OrderForMemory(&schedule);
+  AddLinearDeps(&schedule, max_in_flight_);
+  auto peak = PeakTmpBytes(schedule);
+  placer_->PlaceSchedule(program, &schedule)->Apply();
+  VLOG(1) << "Minimum-memory schedule: peak tmp bytes=" << peak << ", total alloc bytes=" << TotalAllocSize(schedule);
+  return schedule;
+}
+
+const char* MinMemScheduler::name() const { return "MinMem"; }
+
+}  // namespace local_machine
+}  // namespace tile
+}  // namespace vertexai
@@ -0,0 +1,48 @@
+// Copyright 2019, Intel Corp.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "tile/platform/local_machine/placer.h"
+#include "tile/platform/local_machine/scheduler.h"
+
+namespace vertexai {
+namespace tile {
+namespace local_machine {
+
+// The minimum-memory scheduler reorders the program's independent steps to
+// keep as few temporaries live as possible, greedily choosing the ready step
+// that allocates the fewest new bytes net of the bytes it lets go.  Each step
+// then depends on the step max_in_flight positions before it: one gives a
+// strictly sequential schedule whose placement can reuse the most memory,
+// and larger values trade memory back for overlap between kernels.
+//
+// This is intended for fitting large batches onto devices whose memory the
+// program would otherwise exceed.
+//
+class MinMemScheduler final : public Scheduler {
+ public:
+  MinMemScheduler(const std::shared_ptr<Placer>& placer, std::size_t max_in_flight);
+
+  schedule::Schedule BuildSchedule(const tile::proto::Program& program, const lang::KernelList& kl) final;
+
+  const char* name() const final;
+
+ private:
+  std::shared_ptr<Placer> placer_;
+  std::size_t max_in_flight_;
+};
+
+// Reorders a schedule's steps (consistent with their dependencies) to
+// minimize the peak bytes of live temporaries, and reindexes it.
+void OrderForMemory(schedule::Schedule* schedule);
+
+// Returns the peak bytes of live temporaries when the schedule's steps run
+// one at a time in order.
+std::uint64_t PeakTmpBytes(const schedule::Schedule& schedule);
+
+}  // namespace local_machine
+}  // namespace tile
+}  // namespace vertexai
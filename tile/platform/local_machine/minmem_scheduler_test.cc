@@ -0,0 +1,75 @@
+// Copyright 2019, Intel Corp.
+
+#include <gmock/gmock.h>
+
+#include "tile/platform/local_machine/minmem_scheduler.h"
+
+#include <ratio>
+
+#include "tile/platform/local_machine/block_placer.h"
+#include "tile/platform/local_machine/naive_placer.h"
+#include "tile/platform/local_machine/scheduler_test.h"
+
+using ::testing::Combine;
+using ::testing::Eq;
+using ::testing::Values;
+using ::testing::ValuesIn;
+
+namespace vertexai {
+namespace tile {
+namespace local_machine {
+namespace {
+
+INSTANTIATE_TEST_CASE_P(
+    MinMemScheduler, SchedulerTest,
+    Combine(Values(std::make_shared<MinMemScheduler>(std::make_shared<NaivePlacer>(std::kilo::num), 1),
+                   std::make_shared<MinMemScheduler>(std::make_shared<BlockPlacer>(std::kilo::num), 1),
+                   std::make_shared<MinMemScheduler>(std::make_shared<BlockPlacer>(std::kilo::num), 4)),
+            ValuesIn(SchedulerTest::GetTestPrograms())));
+
+schedule::Step* AddStep(schedule::Schedule* schedule, schedule::Alloc* in, schedule::Alloc* out) {
+  schedule->steps.emplace_back(schedule::Step::Tag::kCopy);
+  auto* step = &schedule->steps.back();
+  step->inputs.push_back(in);
+  step->outputs.push_back(schedule::OutputInfo{out, true});
+  return step;
+}
+
+TEST(MinMemSchedulerTest, FinishesBranchesBeforeStartingOthers) {
+  // Two independent chains, each producing a large temporary, listed
+  // breadth-first: a0 b0 a1 b1.
+  schedule::Schedule schedule;
+  auto add_alloc = [&](std::uint64_t size) {
+    schedule.allocs.emplace_back();
+    schedule.allocs.back().byte_size = size;
+    return &schedule.allocs.back();
+  };
+  auto* in = add_alloc(16);
+  in->input = "I";
+  auto* a_tmp = add_alloc(1024);
+  auto* b_tmp = add_alloc(1024);
+  auto* a_out = add_alloc(16);
+  a_out->output = "A";
+  auto* b_out = add_alloc(16);
+  b_out->output = "B";
+  auto* a0 = AddStep(&schedule, in, a_tmp);
+  auto* b0 = AddStep(&schedule, in, b_tmp);
+  auto* a1 = AddStep(&schedule, a_tmp, a_out);
+  auto* b1 = AddStep(&schedule, b_tmp, b_out);
+  a1->deps.insert(a0);
+  b1->deps.insert(b0);
+  schedule.Reindex();
+  EXPECT_THAT(PeakTmpBytes(schedule), Eq(2048));
+
+  OrderForMemory(&schedule);
+  EXPECT_THAT(PeakTmpBytes(schedule), Eq(1024));
+  EXPECT_THAT(a0->idx, Eq(0));
+  EXPECT_THAT(a1->idx, Eq(1));
+  EXPECT_THAT(b0->idx, Eq(2));
+  EXPECT_THAT(b1->idx, Eq(3));
+}
+
+}  // namespace
+}  // namespace local_machine
+}  // namespace tile
+}  // namespace vertexai
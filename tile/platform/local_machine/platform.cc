@@ -5,12 +5,16 @@
 #include <google/protobuf/util/json_util.h>
 
 #include <algorithm>
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <string>
 #include <utility>
 
 #include <boost/process/environment.hpp>
 
 #include "base/util/compat.h"
+#include "base/util/env.h"
 #include "base/util/error.h"
 #include "base/util/factory.h"
 #include "base/util/logging.h"
@@ -24,7 +28,9 @@
 #include "tile/platform/local_machine/direct_mem_strategy.h"
 #include "tile/platform/local_machine/fifo_scheduler.h"
 #include "tile/platform/local_machine/loose_scheduler.h"
+#include "tile/platform/local_machine/minmem_scheduler.h"
 #include "tile/platform/local_machine/program.h"
+#include "tile/platform/local_machine/stealing_scheduler.h"
 #include "tile/platform/local_machine/tdep_scheduler.h"
 #include "tile/platform/local_machine/tmp_mem_strategy.h"
 #include "tile/proto/support.h"
@@ -36,24 +42,29 @@ namespace {
 
 const char* kCpuDevice = "llvm_cpu.0";
 
+// Names a program for memory accounting: by its id when it has one, and
+// otherwise by the order in which programs were made.
+std::string ProgramOwnerName(const std::string& id) {
+  static std::atomic<std::uint64_t> next_program{0};
+  return id.empty() ? "program_" + std::to_string(next_program++) : id;
+}
+
 void GetMemStrategy(const std::shared_ptr<DevInfo>& devinfo, Platform::PlatformDev* pd) {
   if (devinfo->dev->executor() && devinfo->dev->executor()->shared_memory()) {
     IVLOG(2, "Using shared memory for data transfer");
     pd->mem_strategy = std::make_shared<DirectMemStrategy>(devinfo, devinfo->dev->executor()->shared_memory());
     pd->tmp_mem_source = devinfo->dev->executor()->shared_memory();
-    return;
-  }
-
-  if (devinfo->dev->executor() && devinfo->dev->executor()->device_memory()) {
+  } else if (devinfo->dev->executor() && devinfo->dev->executor()->device_memory()) {
     IVLOG(2, "Using device memory and direct memory strategy");
     pd->mem_strategy = std::make_shared<DirectMemStrategy>(devinfo, devinfo->dev->executor()->device_memory());
     pd->tmp_mem_source = devinfo->dev->executor()->device_memory();
-    return;
+  } else {
+    IVLOG(2, "Using host memory for data transfer");
+    pd->mem_strategy = std::make_shared<DirectMemStrategy>(devinfo, devinfo->devset->host_memory());
+    pd->tmp_mem_source = devinfo->devset->host_memory();
   }
-
-  IVLOG(2, "Using host memory for data transfer");
-  pd->mem_strategy = std::make_shared<DirectMemStrategy>(devinfo, devinfo->devset->host_memory());
-  pd->tmp_mem_source = devinfo->devset->host_memory();
+  // Every program on the device returns its idle temporaries to the same cache.
+  pd->tmp_cache = TmpMemStrategy::MakeCache(devinfo, pd->tmp_mem_source);
 }
 
 bool MatchConfig(const proto::Platform& config, const hal::proto::HardwareInfo& info,
@@ -70,140 +81,120 @@ bool MatchConfig(const proto::Platform& config, const hal::proto::HardwareInfo&
   return false;
 }
 
+// Asynchronous devices may opt into spreading independent kernels across
+// queues by setting PLAIDML_SCHEDULE_QUEUES to the number of queues.  Any
+// device may opt into ordering steps for minimal memory by setting
+// PLAIDML_MINMEM_SCHEDULE to the number of steps allowed in flight.
+std::shared_ptr<Scheduler> MakeScheduler(bool synchronous, hal::Memory* memory,
+                                         const hal::proto::HardwareSettings& settings) {
+  if (synchronous) {
+    IVLOG(2, "Device is synchronous");
+  }
+  auto minmem = env::Get("PLAIDML_MINMEM_SCHEDULE");
+  if (!minmem.empty() && std::stoull(minmem)) {
+    IVLOG(2, "Using minimum-memory scheduler; max_in_flight=" << minmem);
+    return std::make_shared<MinMemScheduler>(std::make_shared<BlockPlacer>(memory->ArenaBufferAlignment()),
+                                             std::stoull(minmem));
+  }
+  auto queues = env::Get("PLAIDML_SCHEDULE_QUEUES");
+  if (!synchronous && !queues.empty() && std::stoull(queues) > 1) {
+    IVLOG(2, "Using work-stealing scheduler; queues=" << queues);
+    return std::make_shared<WorkStealingScheduler>(std::make_shared<BlockPlacer>(memory->ArenaBufferAlignment()),
+                                                   std::stoull(queues));
+  }
+  auto size_goal = memory->size_goal() * kGoalMemPercentage;
+  IVLOG(2, "Using fifo scheduler; size_goal=" << size_goal);
+  return std::make_shared<fifo_scheduler::FifoScheduler>(memory->ArenaBufferAlignment(),
+                                                         std::lround(std::floor(size_goal)), settings);
+}
+
 }  // namespace
 
 Platform::Platform() {
-  context::Context ctx;
   auto env = boost::this_process::environment();
   if (env.count("PLAIDML_DEBUG")) {
     LOG(INFO) << "Press any key after attaching a debugger to pid: " << boost::this_process::get_id();
     std::getchar();
   }
-
-  for (auto& item : FactoryRegistrar<hal::Driver>::Instance()->Factories()) {
-    try {
-      VLOG(1) << "Creating HAL: " << item.second.name;
-      auto driver = item.second.factory(ctx);
-      drivers_.emplace_back(std::move(driver));
-    } catch (const std::exception& ex) {
-      VLOG(1) << "Failed to initialize HAL: " << ex.what();
-    }
-  }
-
-  for (const auto& driver : drivers_) {
-    for (const auto& devset : driver->device_sets()) {
-      for (const auto& dev : devset->devices()) {
-        if (dev->executor()) {
-          const hal::proto::HardwareInfo& info = dev->executor()->info();
-          hal::proto::HardwareSettings settings = info.settings();
-
-          // Loop over identical devices and ensure each one gets a unique id
-          int ididx = 0;
-          std::string id;
-          do {
-            std::stringstream ss;
-            ss << info.name() << "." << ididx++;
-            id = ss.str();
-            std::replace(id.begin(), id.end(), ' ', '_');
-            std::transform(id.begin(), id.end(), id.begin(), ::tolower);
-          } while (devs_.find(id) != devs_.end());
-
-          try {
-            dev->Initialize(settings);
-          } catch (const std::exception& e) {
-            VLOG(1) << "Failed to initialize device " << info.name() << ": " << e.what();
-            continue;
-          } catch (...) {
-            VLOG(1) << "Failed to initialize device " << info.name();
-            continue;
-          }
-          auto devinfo = std::make_shared<DevInfo>(DevInfo{devset, dev, settings});
-          PlatformDev pd{id, devinfo};
-          VLOG(2) << settings.DebugString();
-          GetMemStrategy(devinfo, &pd);
-
-          auto memory = (dev->executor() && dev->executor()->device_memory() ? dev->executor()->device_memory()
-                                                                             : devset->host_memory());
-          if (dev->executor() && dev->executor()->is_synchronous()) {
-            IVLOG(2, "Device is synchronous");
-          }
-          auto size_goal = memory->size_goal() * kGoalMemPercentage;
-          IVLOG(2, "Using fifo scheduler; size_goal=" << size_goal);
-          pd.scheduler = std::make_shared<fifo_scheduler::FifoScheduler>(memory->ArenaBufferAlignment(),
-                                                                         std::lround(std::floor(size_goal)), settings);
-          devs_[id] = std::move(pd);
-        }
-      }
-    }
-  }
 }
 
-Platform::Platform(const context::Context& ctx, const proto::Platform& config) {
+Platform::Platform(const context::Context& ctx, const proto::Platform& config) : ctx_{ctx}, config_{config} {
   auto env = boost::this_process::environment();
   if (env.count("PLAIDML_DEBUG")) {
     LOG(INFO) << "Press any key after attaching a debugger to pid: " << boost::this_process::get_id();
     std::getchar();
   }
+}
 
+// HAL drivers are created lazily, since initializing one (e.g. enumerating every OpenCL ICD and creating their
+// contexts) can take much longer than the program needs.  A device id starts with the name of the driver which
+// provides it (e.g. "opencl_..." or "cm_..."), so looking up a device only needs that driver; listing devices, or
+// looking up an id which names no driver, needs them all.
+void Platform::LoadDrivers(const std::string& device_id) {
   for (auto& item : FactoryRegistrar<hal::Driver>::Instance()->Factories()) {
+    const auto& name = item.second.name;
+    if (!device_id.empty() && device_id.compare(0, name.size() + 1, name + "_") != 0) {
+      continue;
+    }
+    if (!loaded_drivers_.insert(name).second) {
+      continue;
+    }
     try {
-      VLOG(1) << "Creating HAL: " << item.second.name;
-      auto driver = item.second.factory(ctx);
+      VLOG(1) << "Creating HAL: " << name;
+      auto driver = item.second.factory(ctx_);
+      AddDevices(driver.get());
       drivers_.emplace_back(std::move(driver));
     } catch (const std::exception& ex) {
       VLOG(1) << "Failed to initialize HAL: " << ex.what();
     }
   }
+  if (!device_id.empty() && !devs_.count(device_id)) {
+    LoadDrivers("");
+  }
+}
 
-  for (const auto& driver : drivers_) {
-    for (const auto& devset : driver->device_sets()) {
-      for (const auto& dev : devset->devices()) {
-        if (dev->executor()) {
-          const hal::proto::HardwareInfo& info = dev->executor()->info();
-          hal::proto::HardwareSettings settings = info.settings();
-          // TODO(T1101): Move ids into the hal
-
-          // Loop over identical devices and ensure each one gets a unique id
-          int ididx = 0;
-          std::string id;
-          do {
-            std::stringstream ss;
-            ss << info.name() << "." << ididx++;
-            id = ss.str();
-            std::replace(id.begin(), id.end(), ' ', '_');
-            std::transform(id.begin(), id.end(), id.begin(), ::tolower);
-          } while (devs_.find(id) != devs_.end());
-
-          bool found_hardware_config = MatchConfig(config, info, &settings);
-          try {
-            dev->Initialize(settings);
-          } catch (const std::exception& e) {
-            VLOG(1) << "Failed to initialize device " << info.name() << ": " << e.what();
-            continue;
-          } catch (...) {
-            VLOG(1) << "Failed to initialize device " << info.name();
-            continue;
-          }
-          auto devinfo = std::make_shared<DevInfo>(DevInfo{devset, dev, settings});
-          PlatformDev pd{id, devinfo};
-          if (!found_hardware_config) {
-            unmatched_devs_[id] = std::move(pd);
-            continue;
-          }
-          VLOG(2) << settings.DebugString();
-          GetMemStrategy(devinfo, &pd);
-
-          auto memory = (dev->executor() && dev->executor()->device_memory() ? dev->executor()->device_memory()
-                                                                             : devset->host_memory());
-          if (dev->executor() && dev->executor()->is_synchronous()) {
-            IVLOG(2, "Device is synchronous");
-          }
-          auto size_goal = memory->size_goal() * kGoalMemPercentage;
-          IVLOG(2, "Using fifo scheduler; size_goal=" << size_goal);
-          pd.scheduler = std::make_shared<fifo_scheduler::FifoScheduler>(memory->ArenaBufferAlignment(),
-                                                                         std::lround(std::floor(size_goal)), settings);
-          devs_[id] = std::move(pd);
+void Platform::AddDevices(hal::Driver* driver) {
+  for (const auto& devset : driver->device_sets()) {
+    for (const auto& dev : devset->devices()) {
+      if (dev->executor()) {
+        const hal::proto::HardwareInfo& info = dev->executor()->info();
+        hal::proto::HardwareSettings settings = info.settings();
+        // TODO(T1101): Move ids into the hal
+
+        // Loop over identical devices and ensure each one gets a unique id
+        int ididx = 0;
+        std::string id;
+        do {
+          std::stringstream ss;
+          ss << info.name() << "." << ididx++;
+          id = ss.str();
+          std::replace(id.begin(), id.end(), ' ', '_');
+          std::transform(id.begin(), id.end(), id.begin(), ::tolower);
+        } while (devs_.find(id) != devs_.end());
+
+        bool found_hardware_config = !config_ || MatchConfig(*config_, info, &settings);
+        try {
+          dev->Initialize(settings);
+        } catch (const std::exception& e) {
+          VLOG(1) << "Failed to initialize device " << info.name() << ": " << e.what();
+          continue;
+        } catch (...) {
+          VLOG(1) << "Failed to initialize device " << info.name();
+          continue;
         }
+        auto devinfo = std::make_shared<DevInfo>(DevInfo{devset, dev, settings});
+        PlatformDev pd{id, devinfo};
+        if (!found_hardware_config) {
+          unmatched_devs_[id] = std::move(pd);
+          continue;
+        }
+        VLOG(2) << settings.DebugString();
+        GetMemStrategy(devinfo, &pd);
+
+        auto memory = (dev->executor() && dev->executor()->device_memory() ? dev->executor()->device_memory()
+                                                                           : devset->host_memory());
+        pd.scheduler = MakeScheduler(dev->executor() && dev->executor()->is_synchronous(), memory, settings);
+        devs_[id] = std::move(pd);
       }
     }
   }
@@ -220,6 +211,19 @@ std::shared_ptr<tile::Buffer> Platform::MakeBuffer(const context::Context& ctx,
   return std::make_shared<Buffer>(platform_dev.devinfo, platform_dev.mem_strategy, size);
 }
 
+std::shared_ptr<tile::Buffer> Platform::WrapBuffer(const context::Context& ctx, const std::string& device_id,
+                                                   void* base, std::uint64_t size) {
+  if (device_id == kCpuDevice) {
+    return std::make_shared<HostBuffer>(base, size);
+  }
+  auto& platform_dev = LookupDevice(device_id);
+  auto chunk = platform_dev.mem_strategy->WrapChunk(ctx, base, size);
+  if (!chunk) {
+    return nullptr;
+  }
+  return std::make_shared<Buffer>(platform_dev.devinfo, platform_dev.mem_strategy, std::move(chunk));
+}
+
 std::shared_ptr<tile::Program> Platform::MakeProgram(  //
     const context::Context& ctx,                       //
     const tile::proto::Program& program,               //
@@ -234,7 +238,8 @@ std::shared_ptr<tile::Program> Platform::MakeProgram(  //
     return std::make_shared<CpuProgram>("llvm_cpu", runinfo, const_bufs);
   }
   const auto& platform_dev = LookupDevice(program.dev_id());
-  auto tmp_strategy = std::make_shared<TmpMemStrategy>(platform_dev.devinfo, platform_dev.tmp_mem_source);
+  auto tmp_strategy = std::make_shared<TmpMemStrategy>(platform_dev.devinfo, platform_dev.tmp_mem_source,
+                                                       ProgramOwnerName(program.id()), platform_dev.tmp_cache);
   return std::make_shared<Program>(  //
       ctx,                           //
       program,                       //
@@ -257,7 +262,8 @@ std::shared_ptr<tile::Program> Platform::MakeProgram(  //
     return std::make_shared<CpuProgram>(target, program, const_bufs);
   }
   const auto& platform_dev = LookupDevice(device);
-  auto tmp_strategy = std::make_shared<TmpMemStrategy>(platform_dev.devinfo, platform_dev.tmp_mem_source);
+  auto tmp_strategy = std::make_shared<TmpMemStrategy>(platform_dev.devinfo, platform_dev.tmp_mem_source,
+                                                       ProgramOwnerName(""), platform_dev.tmp_cache);
   return std::make_shared<Program>(  //
       ctx,                           //
       program,                       //
@@ -270,6 +276,34 @@ std::shared_ptr<tile::Program> Platform::MakeProgram(  //
       const_bufs);
 }
 
+std::shared_ptr<tile::Program> Platform::LoadProgram(  //
+    const context::Context& ctx,                       //
+    const std::string& device,                         //
+    const std::string& saved,                          //
+    ConstBufferManager* const_bufs) {
+  proto::SavedProgram pb;
+  if (!pb.ParseFromString(saved)) {
+    throw std::runtime_error("Unable to parse the saved program");
+  }
+  if (device == kCpuDevice) {
+    if (pb.cpu_target().empty()) {
+      throw std::runtime_error("The saved program was not compiled for the CPU");
+    }
+    return std::make_shared<CpuProgram>(pb);
+  }
+  const auto& platform_dev = LookupDevice(device);
+  auto tmp_strategy = std::make_shared<TmpMemStrategy>(platform_dev.devinfo, platform_dev.tmp_mem_source,
+                                                       ProgramOwnerName(pb.program().id()), platform_dev.tmp_cache);
+  return std::make_shared<Program>(  //
+      ctx,                           //
+      pb,                            //
+      platform_dev.devinfo,          //
+      platform_dev.scheduler,        //
+      platform_dev.mem_strategy,     //
+      tmp_strategy,                  //
+      const_bufs);
+}
+
 void _fill_device(const Platform::PlatformDev& pdev, tile::proto::Device* dev) {
   google::protobuf::util::JsonPrintOptions options;
   options.add_whitespace = true;
@@ -291,6 +325,8 @@ void Platform::ListDevices(                          //
   tile::proto::Device* dev = response->add_devices();
   dev->set_dev_id(kCpuDevice);
   dev->set_description("CPU (via LLVM)");
+  std::lock_guard<std::mutex> lock{mu_};
+  LoadDrivers("");
   for (const auto& dev : devs_) {
     _fill_device(dev.second, response->add_devices());
   }
@@ -301,6 +337,8 @@ void Platform::ListDevices(                          //
 
 std::vector<std::string> Platform::ListDevices() {
   std::vector<std::string> device_ids{kCpuDevice};
+  std::lock_guard<std::mutex> lock{mu_};
+  LoadDrivers("");
   for (const auto& kvp : devs_) {
     device_ids.push_back(kvp.first);
   }
@@ -308,6 +346,10 @@ std::vector<std::string> Platform::ListDevices() {
 }
 
 const Platform::PlatformDev& Platform::LookupDevice(const std::string& id) {
+  std::lock_guard<std::mutex> lock{mu_};
+  if (!id.length() || !devs_.count(id)) {
+    LoadDrivers(id);
+  }
   if (!id.length()) {
     if (!devs_.size()) {
       throw error::NotFound{"No Tile compute devices available"};
@@ -3,6 +3,8 @@
 #pragma once
 
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <set>
 #include <string>
 #include <unordered_map>
@@ -12,6 +14,7 @@
 #include "tile/base/platform.h"
 #include "tile/platform/local_machine/devinfo.h"
 #include "tile/platform/local_machine/local_machine.pb.h"
+#include "tile/platform/local_machine/mem_cache.h"
 #include "tile/platform/local_machine/mem_strategy.h"
 #include "tile/platform/local_machine/scheduler.h"
 
@@ -30,6 +33,7 @@ class Platform : public tile::Platform {
     std::shared_ptr<DevInfo> devinfo;
     std::shared_ptr<MemStrategy> mem_strategy;
     hal::Memory* tmp_mem_source;
+    std::shared_ptr<MemCache> tmp_cache;  // Idle temporaries, shared by the device's programs
     std::shared_ptr<Scheduler> scheduler;
   };
 
@@ -43,6 +47,12 @@ class Platform : public tile::Platform {
       const std::string& device,             //
       std::uint64_t size) final;
 
+  std::shared_ptr<tile::Buffer> WrapBuffer(  //
+      const context::Context& ctx,           //
+      const std::string& device,             //
+      void* base,                            //
+      std::uint64_t size) final;
+
   std::shared_ptr<tile::Program> MakeProgram(  //
       const context::Context& ctx,             //
       const tile::proto::Program& program,     //
@@ -55,6 +65,12 @@ class Platform : public tile::Platform {
       const std::shared_ptr<stripe::Program>& program,  //
       ConstBufferManager* const_bufs) final;
 
+  std::shared_ptr<tile::Program> LoadProgram(  //
+      const context::Context& ctx,             //
+      const std::string& device,               //
+      const std::string& saved,                //
+      ConstBufferManager* const_bufs) final;
+
   void ListDevices(                                    //
       const context::Context& ctx,                     //
       const tile::proto::ListDevicesRequest& request,  //
@@ -65,6 +81,14 @@ class Platform : public tile::Platform {
  private:
   const PlatformDev& LookupDevice(const std::string& id);
 
+  // Creates the HAL drivers which may provide device_id (all of them, if it's empty), and adds their devices.
+  void LoadDrivers(const std::string& device_id);
+  void AddDevices(hal::Driver* driver);
+
+  context::Context ctx_;
+  std::optional<proto::Platform> config_;
+  std::mutex mu_;  // Guards the drivers and devices, which are loaded lazily
+  std::set<std::string> loaded_drivers_;
   std::vector<std::unique_ptr<hal::Driver>> drivers_;
   std::unordered_map<std::string, PlatformDev> devs_;
   std::unordered_map<std::string, PlatformDev> unmatched_devs_;
@@ -3,10 +3,14 @@
 #include "tile/platform/local_machine/program.h"
 
 #include <algorithm>
+#include <chrono>
 #include <forward_list>
+#include <functional>
 #include <limits>
 #include <numeric>
 #include <set>
+#include <sstream>
+#include <string>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -14,12 +18,16 @@
 #include "base/util/env.h"
 #include "base/util/error.h"
 #include "base/util/perf_counter.h"
+#include "base/util/runtime_options.h"
 #include "tile/hal/util/settings.h"
 #include "tile/lang/parser.h"
+#include "tile/lang/semtree.h"
 #include "tile/lang/tile_cache.h"
 #include "tile/ocl_exec/stripe_gen.h"
 #include "tile/platform/local_machine/buffer.h"
+#include "tile/platform/local_machine/library_cache.h"
 #include "tile/platform/local_machine/run_request.h"
+#include "tile/platform/local_machine/slot_binding.h"
 #include "tile/proto/support.h"
 
 namespace vertexai {
@@ -35,7 +43,29 @@ std::condition_variable cond_var;
 std::mutex mutex;
 
 static PerfCounter pre_scan_time("pre_scan_time");
+static PerfCounter runs_in_flight("program_runs_in_flight");
 static PerfCounter post_scan_time("post_scan_time");
+static PerfHistogram compile_time_ms("program_compile_time_ms", {1, 10, 100, 1000, 10000, 100000});
+
+// The number of runs of a single program which may be in flight at once; by
+// default, runs are limited only by the memory available for them.
+std::size_t MaxInFlightRuns() {
+  auto max_runs = env::Get("PLAIDML_MAX_IN_FLIGHT_RUNS");
+  if (max_runs.empty()) {
+    return 0;
+  }
+  return std::stoull(max_runs);
+}
+
+// The temporary memory each program's runs may hold at once, unless set by
+// Program::SetMemoryQuota; by default, only the device's memory limits it.
+std::uint64_t TmpMemoryQuota() {
+  auto quota_mb = env::Get("PLAIDML_TMP_QUOTA_MB");
+  if (quota_mb.empty()) {
+    return 0;
+  }
+  return std::stoull(quota_mb) << 20;
+}
 
 void AllocateBuffers(const std::vector<std::string>& names, const ShapeMap& types, hal::Memory* memory,
                      std::vector<std::shared_ptr<hal::Buffer>>* buffers) {
@@ -45,16 +75,30 @@ void AllocateBuffers(const std::vector<std::string>& names, const ShapeMap& type
   }
 }
 
+// Identifies the device for the tile cache: timings are only reused on the
+// same kind of device, with the same driver.
+std::string TileCacheDevice(const DevInfo& devinfo) {
+  std::stringstream ss;
+  ss << devinfo.dev->description() << " " << std::hex
+     << std::hash<std::string>{}(devinfo.dev->executor()->info().SerializeAsString());
+  return ss.str();
+}
+
+// The tile cache key for a kernel: its key, and its variant if it's one of several versions of the kernel.
+std::string TileCacheKey(const lang::KernelInfo& ki) { return ki.variant.empty() ? ki.key : ki.key + "#" + ki.variant; }
+
 int64_t TryKernel(const context::Context& ctx, const lang::KernelInfo& ki,
-                  const std::vector<std::shared_ptr<hal::Buffer>>& buffers, const DevInfo& devinfo, size_t trial_runs) {
+                  const std::vector<std::shared_ptr<hal::Buffer>>& buffers, const DevInfo& devinfo,
+                  const std::string& device_key, size_t trial_runs) {
   // Check in cache, and early return if found
-  int64_t cached_time = lang::TileCache::Instance()->GetDuration(ki.key, ki.settings, ki.tile.shape);
+  auto cache_key = TileCacheKey(ki);
+  int64_t cached_time = lang::TileCache::Instance()->GetDuration(device_key, cache_key, ki.settings, ki.tile.shape);
   if (cached_time >= 0) {
-    LOG(DEBUG) << "Cached kernel: " << ki.kname << ", key: " << ki.key << ", tile: " << ki.tile.shape;
+    LOG(DEBUG) << "Cached kernel: " << ki.kname << ", key: " << cache_key << ", tile: " << ki.tile.shape;
     return cached_time;
   }
 
-  LOG(DEBUG) << "Trying kernel: " << ki.kname << ", key: " << ki.key << ", tile: " << ki.tile.shape;
+  LOG(DEBUG) << "Trying kernel: " << ki.kname << ", key: " << cache_key << ", tile: " << ki.tile.shape;
   try {
     // Prep to do a real run
     auto& device = *devinfo.dev;
@@ -72,7 +116,7 @@ int64_t TryKernel(const context::Context& ctx, const lang::KernelInfo& ki,
     }
 
     // Save in cache and return
-    lang::TileCache::Instance()->AddEntry(ki.key, ki.settings, ki.tile.shape, best_time);
+    lang::TileCache::Instance()->AddEntry(device_key, cache_key, ki.settings, ki.tile.shape, best_time);
     return best_time;
   } catch (const std::exception& ex) {
     LOG(ERROR) << "Skipping kernel failure: " << ex.what();
@@ -82,7 +126,80 @@ int64_t TryKernel(const context::Context& ctx, const lang::KernelInfo& ki,
   return std::numeric_limits<int64_t>::max();
 }
 
+// Times each of the kernels, which are alternative tilings of the same
+// operation.  The kernels missing from the tile cache are built together, so
+// the device compiler can work on all of them at once, and then run back to
+// back; if the batch fails to build, each kernel is tried on its own so a bad
+// candidate only costs itself.
+std::vector<int64_t> TryKernels(const context::Context& ctx, const std::vector<lang::KernelInfo>& kernels,
+                                const std::vector<std::shared_ptr<hal::Buffer>>& buffers, const DevInfo& devinfo,
+                                size_t trial_runs) {
+  auto device_key = TileCacheDevice(devinfo);
+  std::vector<int64_t> times(kernels.size(), std::numeric_limits<int64_t>::max());
+  std::vector<size_t> uncached;
+  std::vector<lang::KernelInfo> trials;
+  for (size_t i = 0; i < kernels.size(); i++) {
+    const auto& ki = kernels[i];
+    auto cache_key = TileCacheKey(ki);
+  int64_t cached_time = lang::TileCache::Instance()->GetDuration(device_key, cache_key, ki.settings, ki.tile.shape);
+    if (cached_time >= 0) {
+      LOG(DEBUG) << "Cached kernel: " << ki.kname << ", key: " << TileCacheKey(ki) << ", tile: " << ki.tile.shape;
+      times[i] = cached_time;
+      continue;
+    }
+    // The compiler keys kernels by name, so each trial gets a distinct one.
+    lang::KernelInfo trial = ki;
+    trial.kname = ki.kname + "_trial" + std::to_string(i);
+    if (ki.kfunc) {
+      trial.kfunc = std::make_shared<sem::Function>(*ki.kfunc);
+      trial.kfunc->name = trial.kname;
+    }
+    uncached.push_back(i);
+    trials.emplace_back(std::move(trial));
+  }
+  if (trials.size() < 2) {
+    for (auto i : uncached) {
+      times[i] = TryKernel(ctx, kernels[i], buffers, devinfo, device_key, trial_runs);
+    }
+    return times;
+  }
+
+  auto& device = *devinfo.dev;
+  std::unique_ptr<hal::Executable> executable;
+  try {
+    LOG(DEBUG) << "Building " << trials.size() << " trial kernels for: " << kernels[0].kname;
+    auto library = device.compiler()->Build(ctx, trials, devinfo.settings).get();
+    executable = device.executor()->Prepare(library.get()).get();
+  } catch (const std::exception& ex) {
+    LOG(DEBUG) << "Batched trial build failed, trying kernels individually: " << ex.what();
+    for (auto i : uncached) {
+      times[i] = TryKernel(ctx, kernels[i], buffers, devinfo, device_key, trial_runs);
+    }
+    return times;
+  }
+
+  for (size_t t = 0; t < trials.size(); t++) {
+    const auto& ki = kernels[uncached[t]];
+    LOG(DEBUG) << "Trying kernel: " << ki.kname << ", key: " << TileCacheKey(ki) << ", tile: " << ki.tile.shape;
+    try {
+      int64_t best_time = std::numeric_limits<int64_t>::max();
+      for (size_t i = 0; i < trial_runs; i++) {
+        auto evt = executable->Run(ctx, t, buffers, {}, true);
+        device.executor()->Flush();
+        auto result = evt->GetFuture().get();
+        best_time = std::min<int64_t>(result->GetDuration().count(), best_time);
+      }
+      lang::TileCache::Instance()->AddEntry(device_key, TileCacheKey(ki), ki.settings, ki.tile.shape, best_time);
+      times[uncached[t]] = best_time;
+    } catch (const std::exception& ex) {
+      LOG(ERROR) << "Skipping kernel failure: " << ex.what();
+    }
+  }
+  return times;
+}
+
 lang::KernelList CompileProgram(           //
+    const context::Context& ctx,           //
     const tile::proto::Program& program,   //
     const DevInfo& devinfo,                //
     const lang::TileOptimizer& optimizer,  //
@@ -95,7 +212,6 @@ lang::KernelList CompileProgram(           //
     trial_runs = program.tile_scanning_params().max_trial_runs();
   }
 
-  context::Context ctx;
   lang::Parser parser;
   auto parsed = parser.Parse(program.code());
   auto inputs = FromProto(program.inputs());
@@ -103,12 +219,13 @@ lang::KernelList CompileProgram(           //
 
   auto use_stripe_default = devinfo.settings.use_stripe() ? "1" : "0";
   auto use_stripe = env::Get("PLAIDML_USE_STRIPE", use_stripe_default) == "1";
+  lang::KernelList kernel_list;
   if (use_stripe) {
     auto stripe_cfg = devinfo.settings.stripe_config();
     if (stripe_cfg.empty()) {
       throw std::runtime_error("Selected device must have a stripe_config when PLAIDML_USE_STRIPE is enabled");
     }
-    auto out_path = env::Get("PLAIDML_STRIPE_OUTPUT");
+    auto out_path = RuntimeOptions::Get().stripe_output;
     lang::RunInfo runinfo;
     runinfo.program = parsed;
     runinfo.input_shapes = inputs;
@@ -119,11 +236,18 @@ lang::KernelList CompileProgram(           //
         runinfo.const_inputs.emplace(kvp.first);
       }
     }
-    return codegen::GenerateProgram(runinfo, stripe_cfg, out_path, const_bufs);
+    // With tile scanning enabled, the stripe kernels carry candidates built
+    // from alternative autotile choices, which are timed like the legacy ones.
+    auto tune_trials = env::Get("PLAIDML_STRIPE_TUNE");
+    if (!tune_trials.empty()) {
+      tile_trials = std::max<size_t>(tile_trials, std::stoull(tune_trials));
+    }
+    kernel_list = codegen::GenerateProgram(ctx, runinfo, stripe_cfg, out_path, const_bufs, tile_trials,
+                                           &devinfo.settings);
+  } else {
+    auto settings = hal::settings::ToHardwareSettings(devinfo.settings);
+    kernel_list = lang::GenerateProgram(parsed, inputs, outputs, settings, optimizer, program.id(), tile_trials);
   }
-
-  auto settings = hal::settings::ToHardwareSettings(devinfo.settings);
-  auto kernel_list = lang::GenerateProgram(parsed, inputs, outputs, settings, optimizer, program.id(), tile_trials);
   if (tile_trials == 1) {
     return kernel_list;
   }
@@ -151,17 +275,17 @@ lang::KernelList CompileProgram(           //
 
     std::vector<lang::KernelInfo> candidates;
     std::swap(candidates, ki.candidates);
+    candidates.insert(candidates.begin(), ki);
 
-    size_t cur_num = 0;
+    auto times = TryKernels(ctx, candidates, buffers, devinfo, trial_runs);
     size_t best_num = 0;
-    uint64_t best_time = TryKernel(ctx, ki, buffers, devinfo, trial_runs);
+    uint64_t best_time = times[0];
     pre_scan_time.add(best_time);
-    for (const auto& candidate : candidates) {
-      cur_num++;
-      uint64_t time = TryKernel(ctx, candidate, buffers, devinfo, trial_runs);
+    for (size_t cur_num = 1; cur_num < candidates.size(); cur_num++) {
+      uint64_t time = times[cur_num];
       if (time < best_time) {
         best_time = time;
-        ki = candidate;
+        ki = candidates[cur_num];
         best_num = cur_num;
       }
     }
@@ -171,9 +295,77 @@ lang::KernelList CompileProgram(           //
                                  << ", post_scan_time: " << double(post_scan_time.get()) / 1e9);
   }
 
+  // The chosen candidates may now duplicate each other.
+  lang::DeduplicateKernels(&kernel_list.kernels);
   return kernel_list;
 }
 
+// Describes the program for the on-disk library cache.
+std::string OpsKey(const tile::proto::Program& program) {
+  std::stringstream ss;
+  ss << program.code();
+  std::map<std::string, std::string> shapes;
+  for (const auto& kvp : program.inputs()) {
+    shapes.emplace("input " + kvp.first, kvp.second.shape().ShortDebugString());
+  }
+  for (const auto& kvp : program.outputs()) {
+    shapes.emplace("output " + kvp.first, kvp.second.shape().ShortDebugString());
+  }
+  for (const auto& kvp : shapes) {
+    ss << "\n" << kvp.first << ": " << kvp.second;
+  }
+  return ss.str();
+}
+
+const std::shared_ptr<LibraryCache>& GetLibraryCache() {
+  static std::shared_ptr<LibraryCache> cache = LibraryCache::FromEnv();
+  return cache;
+}
+
+// Identifies the device and settings a saved program was compiled for.
+std::string DeviceKey(const DevInfo& devinfo) { return LibraryCache::Key(devinfo, ""); }
+
+proto::SavedKernel SaveKernel(const lang::KernelInfo& ki) {
+  proto::SavedKernel pb;
+  pb.set_kname(ki.kname);
+  pb.set_key(ki.key);
+  pb.set_comments(ki.comments);
+  *pb.mutable_outputs() = {ki.outputs.begin(), ki.outputs.end()};
+  *pb.mutable_inputs() = {ki.inputs.begin(), ki.inputs.end()};
+  *pb.mutable_gwork() = {ki.gwork.begin(), ki.gwork.end()};
+  *pb.mutable_lwork() = {ki.lwork.begin(), ki.lwork.end()};
+  pb.set_tot_bytes(ki.tot_bytes);
+  pb.set_tot_flops(ki.tot_flops);
+  *pb.mutable_info() = ki.info;
+  pb.set_ktype(static_cast<std::uint32_t>(ki.ktype));
+  for (const auto& kvp : ki.safe_self_aliases) {
+    *(*pb.mutable_safe_self_aliases())[kvp.first].mutable_values() = {kvp.second.begin(), kvp.second.end()};
+  }
+  return pb;
+}
+
+lang::KernelInfo LoadKernel(const proto::SavedKernel& pb) {
+  lang::KernelInfo ki;
+  ki.kname = pb.kname();
+  ki.key = pb.key();
+  ki.comments = pb.comments();
+  ki.outputs.assign(pb.outputs().begin(), pb.outputs().end());
+  ki.inputs.assign(pb.inputs().begin(), pb.inputs().end());
+  if (pb.gwork_size() != ki.gwork.size() || pb.lwork_size() != ki.lwork.size()) {
+    throw std::runtime_error("Malformed saved kernel: " + pb.kname());
+  }
+  std::copy(pb.gwork().begin(), pb.gwork().end(), ki.gwork.begin());
+  std::copy(pb.lwork().begin(), pb.lwork().end(), ki.lwork.begin());
+  ki.tot_bytes = pb.tot_bytes();
+  ki.tot_flops = pb.tot_flops();
+  ki.info = pb.info();
+  ki.ktype = static_cast<lang::KernelType>(pb.ktype());
+  for (const auto& kvp : pb.safe_self_aliases()) {
+    ki.safe_self_aliases[kvp.first].insert(kvp.second.values().begin(), kvp.second.values().end());
+  }
+  return ki;
+}
+
 }  // namespace
 
 Program::Program(                                             //
@@ -189,7 +381,9 @@ Program::Program(                                             //
     : devinfo_{devinfo},  //
       output_mem_strategy_{output_mem_strategy},
       tmp_mem_strategy_{tmp_mem_strategy},
-      num_runs_{0} {
+      num_runs_{0},
+      max_in_flight_{MaxInFlightRuns()},
+      tmp_quota_{TmpMemoryQuota()} {
   // TODO: Make this path asynchronous.
   // Asynchronous programming is a little tricky in this case, since if we compile asynchronously, the
   // compilation may not be complete when we're first asked to run a program, which means we'd need to save the run
@@ -198,10 +392,13 @@ Program::Program(                                             //
   // straightforward dataflow-ish way to describe the resulting system, but it's more complicated than just
   // compiling everything synchronously, so we just do everything synchronously for now.
 
-  kernel_list_ = CompileProgram(program, *devinfo_.get(), optimizer, const_bufs);
+  kernel_list_ = CompileProgram(ctx, program, *devinfo_.get(), optimizer, const_bufs);
   const_bufs_ = const_bufs->buffers;
 
-  Initialize(ctx, program, scheduler);
+  // Constants rewritten during compilation upload while the kernels build.
+  Initialize(ctx, program, OpsKey(program), scheduler);
+  const_bufs->Sync();
+  const_bufs_ = const_bufs->buffers;  // Uploads may have settled on shared copies of their constants
 }
 
 Program::Program(                                             //
@@ -217,22 +414,77 @@ Program::Program(                                             //
     : devinfo_{devinfo},  //
       output_mem_strategy_{output_mem_strategy},
       tmp_mem_strategy_{tmp_mem_strategy},
-      num_runs_{0} {
-  auto out_path = env::Get("PLAIDML_STRIPE_OUTPUT");
-  kernel_list_ = codegen::GenerateProgram(stripe, target, out_path, const_bufs);
+      num_runs_{0},
+      max_in_flight_{MaxInFlightRuns()},
+      tmp_quota_{TmpMemoryQuota()} {
+  auto out_path = RuntimeOptions::Get().stripe_output;
+  kernel_list_ = codegen::GenerateProgram(ctx, stripe, target, out_path, const_bufs, &devinfo_->settings);
   const_bufs_ = const_bufs->buffers;
 
   tile::proto::Program program;
   *program.mutable_inputs() = IntoProtoInput(stripe->input_shapes);
   *program.mutable_outputs() = IntoProtoOutput(stripe->output_shapes);
-  Initialize(ctx, program, scheduler);
+  std::stringstream ops;
+  ops << "target " << target << "\n" << *stripe->entry;
+  Initialize(ctx, program, ops.str(), scheduler);
+  const_bufs->Sync();
+  const_bufs_ = const_bufs->buffers;
+}
+
+Program::Program(                                             //
+    const context::Context& ctx,                              //
+    const proto::SavedProgram& saved,                         //
+    const std::shared_ptr<DevInfo>& devinfo,                  //
+    const std::shared_ptr<Scheduler>& scheduler,              //
+    const std::shared_ptr<MemStrategy>& output_mem_strategy,  //
+    const std::shared_ptr<MemStrategy>& tmp_mem_strategy,     //
+    ConstBufferManager* const_bufs)
+    : devinfo_{devinfo},  //
+      output_mem_strategy_{output_mem_strategy},
+      tmp_mem_strategy_{tmp_mem_strategy},
+      num_runs_{0},
+      max_in_flight_{MaxInFlightRuns()},
+      tmp_quota_{TmpMemoryQuota()} {
+  if (saved.device_key() != DeviceKey(*devinfo_)) {
+    throw std::runtime_error("The saved program was compiled for a different device or device configuration");
+  }
+  for (const auto& kernel : saved.kernels()) {
+    kernel_list_.kernels.emplace_back(LoadKernel(kernel));
+  }
+  for (const auto& kvp : saved.types()) {
+    kernel_list_.types.emplace(kvp.first, FromProto(kvp.second));
+  }
+  for (const auto& kvp : saved.var_rewrites()) {
+    kernel_list_.var_rewrites.Insert(kvp.first, kvp.second);
+  }
+  // The saved constants upload while the kernels load.  The uploads read from saved, so they're synced before this
+  // returns, even if loading fails.
+  for (const auto& kvp : saved.const_buffers()) {
+    const auto* bytes = &kvp.second;
+    const_bufs->Stream(kvp.first, bytes->size(),
+                       [bytes](char* data) { std::copy(bytes->begin(), bytes->end(), data); });
+  }
+  const_bufs_ = const_bufs->buffers;
+
+  try {
+    Initialize(ctx, saved.program(), "", scheduler, &saved);
+  } catch (...) {
+    for (auto& kvp : const_bufs->uploads) {
+      kvp.second.wait();
+    }
+    throw;
+  }
+  const_bufs->Sync();
+  const_bufs_ = const_bufs->buffers;
 }
 
 void Program::Initialize(          //
     const context::Context& ctx,   //
     tile::proto::Program program,  //
-    const std::shared_ptr<Scheduler>& scheduler) {
-  if (!devinfo_->dev->compiler() || !devinfo_->dev->executor()) {
+    const std::string& ops,        //
+    const std::shared_ptr<Scheduler>& scheduler,
+    const proto::SavedProgram* saved) {
+  if ((!saved && !devinfo_->dev->compiler()) || !devinfo_->dev->executor()) {
     // TODO: Implement a mechanism for providing a pre-compiled program.
     throw error::Unavailable{"The requested device is unavailable for running Tile programs"};
   }
@@ -250,8 +502,27 @@ void Program::Initialize(          //
   }
 
   context::Activity activity{ctx, "tile::local_machine::Compile"};
-  auto lib = devinfo_->dev->compiler()->Build(activity.ctx(), kernel_list_.kernels, devinfo_->settings).get();
-  executable_ = devinfo_->dev->executor()->Prepare(lib.get()).get();
+  auto compile_start = std::chrono::steady_clock::now();
+  boost::future<std::unique_ptr<hal::Library>> library;
+  if (saved) {
+    auto* loader = devinfo_->dev->loader();
+    if (!loader) {
+      throw error::Unavailable{"The requested device is unable to load saved programs"};
+    }
+    std::map<std::string, std::string> binaries{saved->binaries().begin(), saved->binaries().end()};
+    library = boost::make_ready_future(loader->Deserialize(activity.ctx(), binaries, kernel_list_.kernels).get());
+  } else {
+    library = BuildLibrary(activity.ctx(), ops);
+  }
+  // The kernels finish building in the background, overlapping whatever the caller does next; runs wait for them.
+  auto finish = [kernels = kernels_, devinfo = devinfo_, compile_start](decltype(library) built) {
+    kernels->library = built.get();
+    kernels->executable = devinfo->dev->executor()->Prepare(kernels->library.get()).get();
+    auto compile_time = std::chrono::steady_clock::now() - compile_start;
+    compile_time_ms.WithLabels({{"device", devinfo->dev->description()}})
+        .observe(std::chrono::duration_cast<std::chrono::milliseconds>(compile_time).count());
+  };
+  kernels_ready_ = library.then(std::move(finish)).share();
   schedule_ = scheduler->BuildSchedule(program, kernel_list_);
 
   if (activity.ctx().is_logging_events()) {
@@ -270,7 +541,58 @@ void Program::Initialize(          //
     activity.AddMetadata(sched_pb);
   }
 
-  ValidateSchedule(program, kernel_list_, schedule_);
+  if (ShouldValidateSchedule()) {
+    ValidateSchedule(program, kernel_list_, schedule_);
+  }
+  launch_plan_ = CaptureLaunchPlan(schedule_);
+  std::set<std::string> constants;
+  for (const auto& kvp : const_bufs_) {
+    constants.insert(kvp.first);
+  }
+  MarkMemoized(&launch_plan_, constants);
+  program_ = std::move(program);
+  program_.clear_code();
+}
+
+boost::future<std::unique_ptr<hal::Library>> Program::BuildLibrary(const context::Context& ctx,
+                                                                   const std::string& ops) {
+  auto* loader = devinfo_->dev->loader();
+  const auto& cache = GetLibraryCache();
+  if (!loader || !cache) {
+    return devinfo_->dev->compiler()->Build(ctx, kernel_list_.kernels, devinfo_->settings);
+  }
+
+  // Kernel selection may depend on timing trials, so the chosen kernels are
+  // part of the key as well as the program they were generated from.
+  std::stringstream ss;
+  ss << ops;
+  for (const auto& ki : kernel_list_.kernels) {
+    ss << "\nkernel " << ki.kname << " " << ki.key << " " << static_cast<int>(ki.ktype) << " gwork";
+    for (auto size : ki.gwork) {
+      ss << " " << size;
+    }
+    ss << " lwork";
+    for (auto size : ki.lwork) {
+      ss << " " << size;
+    }
+  }
+  auto key = LibraryCache::Key(*devinfo_, ss.str());
+
+  std::map<std::string, std::string> binaries;
+  if (cache->Load(key, &binaries)) {
+    try {
+      return boost::make_ready_future(loader->Deserialize(ctx, binaries, kernel_list_.kernels).get());
+    } catch (const std::exception& ex) {
+      IVLOG(1, "Unable to load cached library; rebuilding: " << ex.what());
+    }
+  }
+  return devinfo_->dev->compiler()
+      ->Build(ctx, kernel_list_.kernels, devinfo_->settings)
+      .then([cache, key](boost::future<std::unique_ptr<hal::Library>> built) {
+        auto lib = built.get();
+        cache->Store(key, lib->Serialize());
+        return lib;
+      });
 }
 
 void Program::Release() {
@@ -281,14 +603,15 @@ void Program::Release() {
   if (num_runs_ > 0) {
     avail_mem += alloc_mem_;
     --num_runs_;
-    cond_var.notify_one();
+    runs_in_flight.add(-1);
+    // Waiters may be blocked on memory or on their own program's in-flight
+    // limit, so they all need to re-check.
+    cond_var.notify_all();
   }
 }
 
-boost::future<void> Program::Run(const context::Context& ctx,
-                                 std::map<std::string, std::shared_ptr<tile::Buffer>> inputs,
-                                 std::map<std::string, std::shared_ptr<tile::Buffer>> outputs) {
-  IVLOG(2, "Program::Run>");
+void Program::Admit() {
+  kernels_ready_.get();
 
   // This is the first program instance. Initialize the available memory and sync variables.
   std::call_once(first_run, [&]() { avail_mem = MaxAvailableMemory(); });
@@ -296,17 +619,44 @@ boost::future<void> Program::Run(const context::Context& ctx,
   alloc_mem_ = TotalAllocSize(schedule_, memory_->ArenaBufferAlignment());
   if (alloc_mem_ <= MaxAvailableMemory()) {
     std::unique_lock<std::mutex> guard(mutex);
+    if (tmp_quota_ && alloc_mem_ > tmp_quota_) {
+      throw std::runtime_error(
+          str(boost::format("A run requires %1% bytes of memory, over the program's quota of %2%") % alloc_mem_ %
+              tmp_quota_));
+    }
     // TODO: could be asynchronous later
-    // Wait for enough memory
-    cond_var.wait(guard, [&] { return alloc_mem_ <= avail_mem; });
+    // Wait for enough memory, and for a slot in this program's pipeline.  Each
+    // run gets its own temporaries (see Shim), so up to max_in_flight_ runs can
+    // overlap -- e.g. the next run's input uploads with this run's kernels --
+    // as long as together they stay within the program's quota.
+    auto wait_start = std::chrono::steady_clock::now();
+    cond_var.wait(guard, [&] {
+      return alloc_mem_ <= avail_mem && (!max_in_flight_ || num_runs_ < max_in_flight_) &&
+             (!tmp_quota_ || (num_runs_ + 1) * alloc_mem_ <= tmp_quota_);
+    });
+    std::chrono::duration<double> waited = std::chrono::steady_clock::now() - wait_start;
     // Reduce the available memory
     avail_mem -= alloc_mem_;
     ++num_runs_;
+    runs_in_flight.inc();
+    {
+      std::lock_guard<std::mutex> stats_lock(stats_mu_);
+      ++stats_runs_;
+      stats_queue_wait_seconds_ += waited.count();
+      stats_peak_memory_ = std::max<std::uint64_t>(stats_peak_memory_, num_runs_ * alloc_mem_);
+    }
   } else {
     throw std::runtime_error(
         str(boost::format("No enough memory for the current schedule: required %1%, available %2%") % alloc_mem_ %
             MaxAvailableMemory()));
   }
+}
+
+boost::future<void> Program::Run(const context::Context& ctx,
+                                 std::map<std::string, std::shared_ptr<tile::Buffer>> inputs,
+                                 std::map<std::string, std::shared_ptr<tile::Buffer>> outputs) {
+  IVLOG(2, "Program::Run>");
+  Admit();
 
   IVLOG(2, "  Inputs:");
   for (const auto& kvp : inputs) {
@@ -323,11 +673,113 @@ boost::future<void> Program::Run(const context::Context& ctx,
   for (const auto& kvp : const_bufs_) {
     inputs[kvp.first] = kvp.second;
   }
-  return RunRequest::Run(ctx, shared_from_this(), std::move(inputs), std::move(rewrite_outputs));
+  return RunRequest::Run(ctx, shared_from_this(), Shim::NamedArguments{inputs, rewrite_outputs});
+}
+
+std::shared_ptr<tile::ArgumentBinding> Program::Bind(const std::vector<std::string>& input_names,
+                                                     const std::vector<std::string>& output_names) {
+  std::vector<std::string> rewritten_outputs;
+  for (const auto& name : output_names) {
+    rewritten_outputs.push_back(kernel_list_.var_rewrites.Lookup(name));
+  }
+  return std::make_shared<SlotBinding>(this, schedule_, const_bufs_, input_names, rewritten_outputs);
+}
+
+boost::future<void> Program::Run(const context::Context& ctx, const tile::ArgumentBinding& binding,
+                                 const tile::ArgumentTable& args) {
+  IVLOG(2, "Program::Run> (bound)");
+  const auto& slots = SlotBinding::Check(binding, this, args);
+  Admit();
+  return RunRequest::Run(ctx, shared_from_this(), SlotArguments{slots, args});
+}
+
+void Program::SetMemoryQuota(std::uint64_t bytes) {
+  std::lock_guard<std::mutex> guard(mutex);
+  tmp_quota_ = bytes;
+  cond_var.notify_all();
 }
 
 std::size_t Program::MaxAvailableMemory() { return memory_->size_goal() * kGoalMemPercentage; }
 
+std::uint64_t Program::MemoryFootprint() const {
+  std::uint64_t bytes = 0;
+  for (const auto& kvp : const_bufs_) {
+    bytes += kvp.second->size();
+  }
+  // The HAL doesn't expose the size of device code, so kernels are charged
+  // for their host-side descriptions.
+  for (const auto& ki : kernel_list_.kernels) {
+    bytes += sizeof(ki) + ki.key.size() + ki.comments.size();
+  }
+  bytes += schedule_.steps.size() * sizeof(schedule::Step) + launch_plan_.steps.size() * sizeof(LaunchStep);
+  return bytes;
+}
+
+ProgramStats Program::GetStats() const {
+  ProgramStats stats;
+  std::lock_guard<std::mutex> lock(stats_mu_);
+  stats.runs = stats_runs_;
+  stats.queue_wait_seconds = stats_queue_wait_seconds_;
+  std::uint64_t const_bytes = 0;
+  for (const auto& kvp : const_bufs_) {
+    const_bytes += kvp.second->size();
+  }
+  stats.peak_memory_bytes = stats_peak_memory_ + const_bytes;
+  for (std::size_t kidx = 0; kidx < kernel_list_.kernels.size(); ++kidx) {
+    const auto& ki = kernel_list_.kernels[kidx];
+    KernelStats kstats;
+    kstats.kname = ki.kname;
+    kstats.tot_bytes = ki.tot_bytes;
+    kstats.tot_flops = ki.tot_flops;
+    if (kidx < kernel_records_.size()) {
+      const auto& record = kernel_records_[kidx];
+      kstats.runs = record.runs;
+      kstats.total_seconds = record.total_seconds;
+      kstats.recent_seconds.assign(record.recent_seconds.begin(), record.recent_seconds.end());
+    }
+    stats.kernels.emplace_back(std::move(kstats));
+  }
+  return stats;
+}
+
+void Program::RecordKernelDurations(const std::vector<std::pair<std::size_t, double>>& durations) {
+  std::lock_guard<std::mutex> lock(stats_mu_);
+  kernel_records_.resize(kernel_list_.kernels.size());
+  for (const auto& kvp : durations) {
+    auto& record = kernel_records_.at(kvp.first);
+    ++record.runs;
+    record.total_seconds += kvp.second;
+    record.recent_seconds.push_back(kvp.second);
+    if (record.recent_seconds.size() > kRecentKernelDurations) {
+      record.recent_seconds.pop_front();
+    }
+  }
+}
+
+std::string Program::Save(const context::Context& ctx) {
+  proto::SavedProgram saved;
+  saved.set_device_key(DeviceKey(*devinfo_));
+  *saved.mutable_program() = program_;
+  for (const auto& ki : kernel_list_.kernels) {
+    *saved.add_kernels() = SaveKernel(ki);
+  }
+  for (const auto& kvp : kernel_list_.types) {
+    (*saved.mutable_types())[kvp.first] = IntoProto(kvp.second);
+  }
+  for (const auto& kvp : kernel_list_.var_rewrites.rewrites()) {
+    (*saved.mutable_var_rewrites())[kvp.first] = kvp.second;
+  }
+  for (const auto& kvp : const_bufs_) {
+    auto view = kvp.second->MapCurrent(ctx).get();
+    (*saved.mutable_const_buffers())[kvp.first] = view->str();
+  }
+  kernels_ready_.get();
+  for (const auto& kvp : kernels_->library->Serialize()) {
+    (*saved.mutable_binaries())[kvp.first] = kvp.second;
+  }
+  return saved.SerializeAsString();
+}
+
 }  // namespace local_machine
 }  // namespace tile
 }  // namespace vertexai
@@ -2,21 +2,29 @@
 
 #pragma once
 
+#include <atomic>
 #include <condition_variable>
 #include <cstddef>
+#include <deque>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <set>
 #include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "tile/base/buffer.h"
 #include "tile/base/program.h"
 #include "tile/base/schedule.h"
 #include "tile/lang/runinfo.h"
 #include "tile/platform/local_machine/devinfo.h"
+#include "tile/platform/local_machine/launch_plan.h"
+#include "tile/platform/local_machine/local_machine.pb.h"
 #include "tile/platform/local_machine/mem_strategy.h"
+#include "tile/platform/local_machine/memo_cache.h"
+#include "tile/platform/local_machine/run_scratch.h"
 #include "tile/platform/local_machine/scheduler.h"
 #include "tile/proto/tile.pb.h"
 #include "tile/stripe/stripe.h"
@@ -47,41 +55,113 @@ class Program final : public tile::Program, public std::enable_shared_from_this<
           hal::Memory* tmp_memory,                                  //
           ConstBufferManager* const_bufs);
 
+  // Reconstructs a program written by Save, loading its kernels from the saved binaries.
+  Program(const context::Context& ctx,                              //
+          const proto::SavedProgram& saved,                         //
+          const std::shared_ptr<DevInfo>& devinfo,                  //
+          const std::shared_ptr<Scheduler>& scheduler,              //
+          const std::shared_ptr<MemStrategy>& output_mem_strategy,  //
+          const std::shared_ptr<MemStrategy>& tmp_mem_strategy,     //
+          ConstBufferManager* const_bufs);
+
   boost::future<void> Run(          //
       const context::Context& ctx,  //
       std::map<std::string, std::shared_ptr<tile::Buffer>> inputs,
       std::map<std::string, std::shared_ptr<tile::Buffer>> outputs) final;
 
+  std::shared_ptr<tile::ArgumentBinding> Bind(const std::vector<std::string>& input_names,
+                                              const std::vector<std::string>& output_names) final;
+
+  boost::future<void> Run(const context::Context& ctx, const tile::ArgumentBinding& binding,
+                          const tile::ArgumentTable& args) final;
+
   // The maximum available memory
   std::size_t MaxAvailableMemory() final;
 
   // Release resource used by the program
   void Release() final;
 
+  std::uint64_t MemoryFootprint() const final;
+
+  std::string Save(const context::Context& ctx) final;
+
+  void SetMemoryQuota(std::uint64_t bytes) final;
+
+  void EnableStats(bool enable) final { stats_enabled_ = enable; }
+  bool stats_enabled() const { return stats_enabled_; }
+  ProgramStats GetStats() const final;
+
+  // Each run's steps wait only for the sums of the inputs they read.
+  bool WaitsForAllReduce() const final { return true; }
+
+  // Records the durations of one run's kernels, as (kernel index, seconds) pairs.
+  void RecordKernelDurations(const std::vector<std::pair<std::size_t, double>>& durations);
+
   const std::shared_ptr<DevInfo>& devinfo() const { return devinfo_; }
   const std::shared_ptr<MemStrategy>& output_mem_strategy() const { return output_mem_strategy_; }
   const std::shared_ptr<MemStrategy>& tmp_mem_strategy() const { return tmp_mem_strategy_; }
   const schedule::Schedule& schedule() const { return schedule_; }
+  const LaunchPlan& launch_plan() const { return launch_plan_; }
   const lang::KernelList& kernel_list() const { return kernel_list_; }
-  const std::unique_ptr<hal::Executable>& executable() const { return executable_; }
+  RunScratchPool* scratch_pool() { return &scratch_pool_; }
+  MemoCache* memo_cache() { return &memo_cache_; }
+  // Valid once a run has started.
+  const std::unique_ptr<hal::Executable>& executable() const { return kernels_->executable; }
 
  private:
   void Initialize(                   //
       const context::Context& ctx,   //
       tile::proto::Program program,  //
-      const std::shared_ptr<Scheduler>& scheduler);
+      const std::string& ops,        //
+      const std::shared_ptr<Scheduler>& scheduler,
+      const proto::SavedProgram* saved = nullptr);
+
+  boost::future<std::unique_ptr<hal::Library>> BuildLibrary(const context::Context& ctx, const std::string& ops);
+
+  // Waits for the program's kernels, and for the memory and in-flight slot a run needs, and claims them; the run's
+  // Shim gives them back through Release.
+  void Admit();
 
  private:
+  // The number of recent durations kept for each kernel.
+  static constexpr std::size_t kRecentKernelDurations = 1024;
+
+  struct KernelRecord {
+    std::uint64_t runs = 0;
+    double total_seconds = 0;
+    std::deque<double> recent_seconds;
+  };
+
   std::shared_ptr<DevInfo> devinfo_;
   std::shared_ptr<MemStrategy> output_mem_strategy_;
   std::shared_ptr<MemStrategy> tmp_mem_strategy_;
   lang::KernelList kernel_list_;
+  tile::proto::Program program_;  // The program's inputs and outputs, for Save.
   schedule::Schedule schedule_;
+  LaunchPlan launch_plan_;
   std::map<std::string, std::shared_ptr<tile::Buffer>> const_bufs_;
-  std::unique_ptr<hal::Executable> executable_;
+  // The kernels are built in the background, and held apart from the program so that a build may finish after the
+  // program is gone.
+  struct Kernels {
+    std::unique_ptr<hal::Library> library;
+    std::unique_ptr<hal::Executable> executable;
+  };
+  std::shared_ptr<Kernels> kernels_ = std::make_shared<Kernels>();
+  boost::shared_future<void> kernels_ready_;  // Rethrows any build failure
   std::size_t alloc_mem_;
-  std::size_t num_runs_;
+  std::size_t num_runs_;       // Runs in flight
+  std::size_t max_in_flight_;  // Zero if unlimited
+  std::uint64_t tmp_quota_;    // Bytes of temporaries held by runs in flight; zero if unlimited
   hal::Memory* memory_;
+  RunScratchPool scratch_pool_;
+  MemoCache memo_cache_;
+
+  std::atomic<bool> stats_enabled_{false};
+  mutable std::mutex stats_mu_;  // Guards the statistics below
+  std::uint64_t stats_runs_ = 0;
+  double stats_queue_wait_seconds_ = 0;
+  std::uint64_t stats_peak_memory_ = 0;
+  std::vector<KernelRecord> kernel_records_;
 };
 
 }  // namespace local_machine
@@ -0,0 +1,81 @@
+// Copyright 2020, Intel Corp.
+
+#include "tile/platform/local_machine/roofline.h"
+
+#include <algorithm>
+#include <map>
+
+#include <boost/format.hpp>
+
+namespace vertexai {
+namespace tile {
+namespace local_machine {
+
+std::vector<RooflineEntry> BuildRoofline(const lang::KernelList& kernel_list,
+                                         const hal::proto::HardwareSettings& settings,
+                                         const std::vector<std::pair<std::size_t, double>>& durations) {
+  std::map<std::size_t, RooflineEntry> by_kidx;
+  for (const auto& duration : durations) {
+    if (kernel_list.kernels.size() <= duration.first) {
+      continue;
+    }
+    auto& entry = by_kidx[duration.first];
+    entry.runs++;
+    entry.seconds += duration.second;
+  }
+
+  std::vector<RooflineEntry> entries;
+  for (auto& kvp : by_kidx) {
+    const auto& ki = kernel_list.kernels[kvp.first];
+    auto& entry = kvp.second;
+    entry.kname = ki.kname;
+    entry.flops = ki.tot_flops;
+    entry.bytes = ki.tot_bytes;
+    entry.intensity = entry.bytes ? static_cast<double>(entry.flops) / entry.bytes : 0;
+    double per_run = entry.seconds / entry.runs;
+    if (0 < per_run) {
+      entry.achieved_gflops = entry.flops / per_run / 1e9;
+      entry.achieved_gbytes_per_sec = entry.bytes / per_run / 1e9;
+    }
+
+    // The kernel can go no faster than its flops at the peak compute rate,
+    // nor than its traffic at the peak bandwidth; an unknown peak bounds nothing.
+    double compute_seconds = 0 < settings.peak_gflops() ? entry.flops / (settings.peak_gflops() * 1e9) : 0;
+    double memory_seconds =
+        0 < settings.peak_gbytes_per_sec() ? entry.bytes / (settings.peak_gbytes_per_sec() * 1e9) : 0;
+    double ideal_seconds = std::max(compute_seconds, memory_seconds);
+    entry.memory_bound = compute_seconds < memory_seconds;
+    if (0 < ideal_seconds) {
+      entry.attainable_gflops = entry.flops / ideal_seconds / 1e9;
+      entry.lost_seconds = std::max(0.0, entry.seconds - ideal_seconds * entry.runs);
+    }
+    entries.emplace_back(std::move(entry));
+  }
+
+  std::stable_sort(entries.begin(), entries.end(), [](const RooflineEntry& lhs, const RooflineEntry& rhs) {
+    if (lhs.lost_seconds != rhs.lost_seconds) {
+      return lhs.lost_seconds > rhs.lost_seconds;
+    }
+    return lhs.seconds > rhs.seconds;
+  });
+  return entries;
+}
+
+std::string FormatRoofline(const std::vector<RooflineEntry>& entries) {
+  std::string result = str(boost::format("%-32s %5s %10s %10s %8s %10s %10s %10s %7s %8s %10s\n") % "kernel" % "runs" %
+                           "time_ms" % "lost_ms" % "flop/B" % "GFLOP/s" % "GB/s" % "attain" % "% roof" % "bound" %
+                           "MFLOP");
+  for (const auto& entry : entries) {
+    double pct = 0 < entry.attainable_gflops ? 100 * entry.achieved_gflops / entry.attainable_gflops : 0;
+    const char* bound = entry.attainable_gflops <= 0 ? "-" : (entry.memory_bound ? "memory" : "compute");
+    result += str(boost::format("%-32s %5u %10.3f %10.3f %8.2f %10.2f %10.2f %10.2f %7.1f %8s %10.3f\n") %
+                  entry.kname % entry.runs % (entry.seconds * 1e3) % (entry.lost_seconds * 1e3) % entry.intensity %
+                  entry.achieved_gflops % entry.achieved_gbytes_per_sec % entry.attainable_gflops % pct % bound %
+                  (entry.flops / 1e6));
+  }
+  return result;
+}
+
+}  // namespace local_machine
+}  // namespace tile
+}  // namespace vertexai
@@ -0,0 +1,50 @@
+// Copyright 2020, Intel Corp.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tile/lang/generate.h"
+#include "tile/proto/hal.pb.h"
+
+namespace vertexai {
+namespace tile {
+namespace local_machine {
+
+// One kernel's measured performance, placed on the device's roofline.
+//
+// A kernel's attainable rate is min(peak_gflops, intensity * peak_gbytes_per_sec),
+// where intensity is its flops per byte of global memory traffic; kernels
+// below the ridge point are memory-bound.  Time lost is the measured time
+// beyond what the kernel would take running at its attainable rate.
+struct RooflineEntry {
+  std::string kname;
+  std::size_t runs = 0;
+  double seconds = 0;        // Total measured time over all runs
+  std::uint64_t flops = 0;   // Per run
+  std::uint64_t bytes = 0;   // Per run
+  double intensity = 0;      // Flops per byte
+  double achieved_gflops = 0;
+  double achieved_gbytes_per_sec = 0;
+  double attainable_gflops = 0;  // Zero if the device's peaks are unknown
+  bool memory_bound = false;
+  double lost_seconds = 0;
+};
+
+// Builds the roofline report for a run's (kernel index, seconds) durations,
+// ordered by time lost, most first.  When the settings give no peak rates,
+// attainable rates and time lost are zero and the entries are ordered by time.
+std::vector<RooflineEntry> BuildRoofline(const lang::KernelList& kernel_list,
+                                         const hal::proto::HardwareSettings& settings,
+                                         const std::vector<std::pair<std::size_t, double>>& durations);
+
+// Renders the report as a table, one kernel per line.
+std::string FormatRoofline(const std::vector<RooflineEntry>& entries);
+
+}  // namespace local_machine
+}  // namespace tile
+}  // namespace vertexai
@@ -0,0 +1,65 @@
+// Copyright 2020, Intel Corp.
+
+#include <gmock/gmock.h>
+
+#include "tile/platform/local_machine/roofline.h"
+
+using ::testing::DoubleNear;
+using ::testing::HasSubstr;
+
+namespace vertexai {
+namespace tile {
+namespace local_machine {
+namespace {
+
+lang::KernelInfo Kernel(const std::string& kname, std::size_t flops, std::size_t bytes) {
+  lang::KernelInfo ki;
+  ki.kname = kname;
+  ki.tot_flops = flops;
+  ki.tot_bytes = bytes;
+  return ki;
+}
+
+TEST(RooflineTest, ClassifiesAndOrdersByTimeLost) {
+  lang::KernelList kernel_list;
+  kernel_list.kernels.push_back(Kernel("dense", 100000000, 1000000));  // 100 flop/B
+  kernel_list.kernels.push_back(Kernel("eltwise", 1000000, 8000000));  // 0.125 flop/B
+  hal::proto::HardwareSettings settings;
+  settings.set_peak_gflops(100);
+  settings.set_peak_gbytes_per_sec(10);
+
+  // dense: ideal 1ms, measured 2ms twice.  eltwise: ideal 0.8ms, measured 1ms.
+  auto entries = BuildRoofline(kernel_list, settings, {{0, 0.002}, {1, 0.001}, {0, 0.002}});
+  ASSERT_EQ(entries.size(), 2);
+
+  EXPECT_EQ(entries[0].kname, "dense");
+  EXPECT_EQ(entries[0].runs, 2);
+  EXPECT_FALSE(entries[0].memory_bound);
+  EXPECT_THAT(entries[0].attainable_gflops, DoubleNear(100, 1e-9));
+  EXPECT_THAT(entries[0].achieved_gflops, DoubleNear(50, 1e-9));
+  EXPECT_THAT(entries[0].lost_seconds, DoubleNear(0.002, 1e-12));
+
+  EXPECT_EQ(entries[1].kname, "eltwise");
+  EXPECT_TRUE(entries[1].memory_bound);
+  EXPECT_THAT(entries[1].attainable_gflops, DoubleNear(1.25, 1e-9));
+  EXPECT_THAT(entries[1].achieved_gbytes_per_sec, DoubleNear(8, 1e-9));
+  EXPECT_THAT(entries[1].lost_seconds, DoubleNear(0.0002, 1e-12));
+
+  EXPECT_THAT(FormatRoofline(entries), HasSubstr("memory"));
+}
+
+TEST(RooflineTest, UnknownPeaksOrderByTime) {
+  lang::KernelList kernel_list;
+  kernel_list.kernels.push_back(Kernel("fast", 1000, 1000));
+  kernel_list.kernels.push_back(Kernel("slow", 1000, 1000));
+  auto entries = BuildRoofline(kernel_list, hal::proto::HardwareSettings{}, {{0, 0.001}, {1, 0.003}});
+  ASSERT_EQ(entries.size(), 2);
+  EXPECT_EQ(entries[0].kname, "slow");
+  EXPECT_EQ(entries[0].attainable_gflops, 0);
+  EXPECT_EQ(entries[0].lost_seconds, 0);
+}
+
+}  // namespace
+}  // namespace local_machine
+}  // namespace tile
+}  // namespace vertexai
@@ -2,197 +2,316 @@
 
 #include "tile/platform/local_machine/run_request.h"
 
-#include <unordered_set>
+#include <chrono>
+#include <string>
 #include <utility>
+#include <vector>
 
 #include "base/util/error.h"
-#include "tile/platform/local_machine/shim.h"
+#include "tile/base/allreduce.h"
+#include "tile/platform/local_machine/mem_usage.h"
+#include "tile/platform/local_machine/roofline.h"
 
 namespace vertexai {
 namespace tile {
 namespace local_machine {
+
 namespace {
 
-// Runs the schedule for a particular program.
-boost::future<std::vector<std::shared_ptr<hal::Result>>> RunSchedule(  //
-    const context::Context& ctx, RunRequest* req, Shim* shim) {
-  std::vector<std::shared_ptr<hal::Event>> deps;
-  deps.resize(req->program()->schedule().steps.size());
-  std::unordered_set<std::shared_ptr<hal::Event>> dep_set;
+// The runs' activity verbs, made once rather than per run.
+const std::string kRunVerb = "tile::local_machine::Program::Run";
+const std::string kEnqueueVerb = "tile::local_machine::Program::Enqueue";
+
+}  // namespace
+
+boost::future<void> RunRequest::Run(          //
+    const context::Context& ctx,              //
+    const std::shared_ptr<Program>& program,  //
+    const Shim::Arguments& args) {
+  LogRequest(program, args);
+
+  auto req = std::shared_ptr<RunRequest>{new RunRequest{ctx, program}};
+  auto complete = req->prom_.get_future();
+  req->Launch(args);
+  return complete;
+}
+
+RunRequest::RunRequest(const context::Context& ctx, const std::shared_ptr<Program>& program)
+    : program_{program}, running_{ctx, kRunVerb}, scratch_{program->scratch_pool()->Acquire()} {}
+
+void RunRequest::Launch(const Shim::Arguments& args) {
+  const LaunchPlan& plan = program_->launch_plan();
+
+  // Find the all-reductions which will overwrite the run's buffers.  The steps which read an input wait for its sums
+  // as they're queued, so the steps ahead of them (say, the first layers of a training step, whose weights were summed
+  // early) start while the later sums are still being written.  An output's sums are only waited for before the output
+  // is remapped to the run's results, so that they don't overwrite them.  The memoized steps' inputs are waited for
+  // up front, since their versions pick the memoized results.
+  std::vector<boost::shared_future<void>> output_reduces;
+  for (const auto& alloc : program_->schedule().allocs) {
+    if (alloc.is_input()) {
+      auto reduce = PendingAllReduce(args.Input(alloc));
+      if (reduce.valid()) {
+        scratch_->reduces.resize(program_->schedule().allocs.size());
+        scratch_->reduces[alloc.idx] = std::move(reduce);
+      }
+    }
+    if (alloc.is_output()) {
+      auto reduce = PendingAllReduce(args.Output(alloc));
+      if (reduce.valid()) {
+        output_reduces.emplace_back(std::move(reduce));
+      }
+    }
+  }
+
+  if (plan.memo_allocs.size()) {
+    if (scratch_->reduces.size()) {
+      for (const auto* alloc : plan.memo_inputs) {
+        WaitForReduce(&scratch_->reduces[alloc->idx]);
+      }
+    }
+    std::vector<std::pair<const tile::Buffer*, std::uint64_t>> inputs;
+    inputs.reserve(plan.memo_inputs.size());
+    for (const auto* alloc : plan.memo_inputs) {
+      const tile::Buffer* input = args.Input(*alloc);
+      inputs.emplace_back(input, input ? input->version() : 0);
+    }
+    memo_ = program_->memo_cache()->Lookup(running_.ctx(), plan, std::move(inputs), *program_->output_mem_strategy(),
+                                           &memo_compute_);
+  }
+  shim_ = std::make_unique<Shim>(running_.ctx(), program_, args, scratch_.get(), memo_.get());
+  MaybeLogMemUsage(running_.ctx());
+
+  {
+    context::Activity queueing{running_.ctx(), kEnqueueVerb};
+    // NOTE: IVLOG_IS_ON(1) is needed here because LogResults depends on profiling
+    // being enabled in order to print durations.
+    record_stats_ = program_->stats_enabled();
+    profile_ = record_stats_ || queueing.ctx().is_logging_events() || IVLOG_IS_ON(1);
 
-  for (const auto& step : req->program()->schedule().steps) {
+    try {
+      QueueSteps(queueing.ctx());
+      for (auto& reduce : output_reduces) {
+        WaitForReduce(&reduce);
+      }
+    } catch (...) {
+      shim_->SetLaunchException(std::current_exception());
+      // If this happens, it's probably an OOM.
+      // TODO: Synchronize with the HAL to ensure all ongoing activity is complete,
+      // so that we can safely release any memory we're holding onto.
+      shim_.reset();
+      program_->scratch_pool()->Release(std::move(scratch_));
+      prom_.set_value();
+      return;
+    }
+    shim_->OnLaunchSuccess();
+    if (memo_compute_) {
+      program_->memo_cache()->Publish(memo_);
+    }
+  }
+
+  // N.B. It's important to keep the shim referenced until the run is complete, because it's the thing that's actually
+  // holding onto all of our chunk references; if those go away, unfortunate things happen.  The request holds itself
+  // (and so the shim) until Finish; that keeps each callback down to a plain pointer and slot, which std::function
+  // stores without allocating.
+  auto& watched = scratch_->watched;
+  scratch_->results.resize(watched.size());
+  remaining_ = watched.size() + 1;  // One extra, dropped below, so that no callback finishes the run early
+  self_ = shared_from_this();
+  for (std::size_t slot = 0; slot < watched.size(); ++slot) {
+    watched[slot]->OnComplete([this, slot](std::shared_ptr<hal::Result> result, boost::exception_ptr error) {  //
+      OnStepComplete(slot, std::move(result), std::move(error));
+    });
+  }
+  program_->devinfo()->dev->executor()->Flush();
+  OnStepComplete(watched.size(), nullptr, boost::exception_ptr{});
+}
+
+void RunRequest::QueueSteps(const context::Context& ctx) {
+  const LaunchPlan& plan = program_->launch_plan();
+  auto& deps = scratch_->step_events;
+  auto& current_deps = scratch_->step_deps;
+  auto& current_params = scratch_->step_params;
+  deps.resize(plan.steps.size());
+
+  for (const auto& launch : plan.steps) {
+    const schedule::Step& step = *launch.step;
+    if (launch.memoized && !memo_compute_) {
+      // An earlier run computed this step's results; steps which read them wait on that run's step instead.
+      IVLOG(2, "Reusing s" << step.idx << ": " << step);
+      deps[step.idx] = memo_->events[step.idx];
+      continue;
+    }
     IVLOG(2, "Queueing s" << step.idx << ": " << step);
-    std::vector<std::shared_ptr<hal::Event>> current_deps;
-    std::vector<std::shared_ptr<hal::Buffer>> current_params;
-    std::vector<std::shared_ptr<MemChunk>> current_dep_chunks;
-
-    auto add_chunk_param = [shim, &current_deps](std::size_t sidx, schedule::Alloc* alloc) {
-      std::shared_ptr<MemChunk> chunk = shim->LookupAlloc(sidx, alloc);
-      chunk->deps()->GetReadDependencies(&current_deps);
-      return chunk;
-    };
-
-    for (const auto& dep : step.deps) {
-      current_deps.emplace_back(deps[dep->idx]);
-    }
-    current_params.reserve(step.outputs.size() + step.inputs.size());
-    current_dep_chunks.reserve(step.outputs.size());
-    for (const auto& out : step.outputs) {
-      std::shared_ptr<MemChunk> chunk = add_chunk_param(step.idx, out.allocp);
-      current_params.emplace_back(chunk->hal_buffer());
-      if (out.add_dep) {
-        current_dep_chunks.push_back(chunk);
+    if (scratch_->reduces.size()) {
+      for (auto* alloc : launch.sync_in) {
+        WaitForReduce(&scratch_->reduces[alloc->idx]);
       }
     }
-    for (const auto& in : step.inputs) {
-      current_params.emplace_back(add_chunk_param(step.idx, in)->hal_buffer());
+    current_deps.clear();
+    current_params.clear();
+    for (auto dep : launch.deps) {
+      current_deps.emplace_back(deps[dep]);
+    }
+    for (auto* alloc : launch.sync_in) {
+      shim_->LookupAlloc(step.idx, alloc)->deps()->GetReadDependencies(&current_deps);
+    }
+    for (auto* alloc : launch.params) {
+      current_params.emplace_back(shim_->LookupAlloc(step.idx, alloc)->hal_buffer());
     }
     std::shared_ptr<hal::Event> event;
     switch (step.tag) {
       case schedule::Step::Tag::kRun:
-        // NOTE: VLOG_IS_ON(1) is needed here because LogResults depends on profiling
-        // being enabled in order to print durations.
-        event = req->program()->executable()->Run(ctx, step.kidx, current_params, current_deps,
-                                                  ctx.is_logging_events() || VLOG_IS_ON(1));
+        event = program_->executable()->Run(ctx, step.kidx, current_params, current_deps, profile_);
         break;
       case schedule::Step::Tag::kCopy:
         if (current_params.size() != 2) {
           throw error::Internal{"Invalid parameter count for copy step s" + std::to_string(step.idx)};
         }
-        event = req->program()->devinfo()->dev->executor()->Copy(ctx, current_params[1], 0, current_params[0], 0,
-                                                                 step.byte_count, current_deps);
+        event = program_->devinfo()->dev->executor()->Copy(ctx, current_params[1], 0, current_params[0], 0,
+                                                           step.byte_count, current_deps);
         break;
       default:
         throw error::Internal{"Invalid schedule step s" + std::to_string(step.idx)};
     }
-    for (const auto& chunk : current_dep_chunks) {
-      chunk->deps()->AddReadDependency(event);
-    }
-    dep_set.insert(event);
-    for (const auto& dep : current_deps) {
-      dep_set.erase(dep);
+    for (auto* alloc : launch.sync_out) {
+      shim_->LookupAlloc(step.idx, alloc)->deps()->AddReadDependency(event);
     }
     deps[step.idx] = std::move(event);
   }
+  current_deps.clear();
+  current_params.clear();
+  if (memo_compute_) {
+    for (const auto& launch : plan.steps) {
+      if (launch.memoized) {
+        memo_->events[launch.step->idx] = deps[launch.step->idx];
+      }
+    }
+  }
 
-  boost::future<std::vector<std::shared_ptr<hal::Result>>> results;
-
-  if (!dep_set.size()) {
-    results = boost::make_ready_future<std::vector<std::shared_ptr<hal::Result>>>();
-  } else {
-    std::vector<std::shared_ptr<hal::Event>> terminal_deps;
-    terminal_deps.reserve(dep_set.size());
-    for (const auto& dep : dep_set) {
-      terminal_deps.emplace_back(dep);
-    }
-    results = req->program()->devinfo()->dev->executor()->WaitFor(std::move(terminal_deps));
-  }
-  if (ctx.is_logging_events() || VLOG_IS_ON(1)) {
-    // We want to return results for *all* of the steps.
-    std::vector<boost::shared_future<std::shared_ptr<hal::Result>>> dep_futures;
-    for (const auto& dep : deps) {
-      dep_futures.emplace_back(dep->GetFuture());
-    }
-    results = results.then(
-        [dep_futures = std::move(dep_futures)](boost::future<std::vector<std::shared_ptr<hal::Result>>> r) {
-          r.get();
-          // N.B. All of the step futures should be ready.
-          std::vector<std::shared_ptr<hal::Result>> results;
-          for (auto& dep : dep_futures) {
-            results.push_back(dep.get());
-          }
-          return results;
-        });
-  }
-  return results;
+  // Wait on the terminal steps -- or, if profiling, on every step, so as to report results for *all* of them.
+  auto& watched = scratch_->watched;
+  if (profile_) {
+    watched.swap(deps);
+    return;
+  }
+  for (auto sidx : plan.terminal) {
+    watched.emplace_back(deps[sidx]);
+  }
+  deps.clear();
 }
 
-}  // namespace
-
-boost::future<void> RunRequest::Run(          //
-    const context::Context& ctx,              //
-    const std::shared_ptr<Program>& program,  //
-    std::map<std::string, std::shared_ptr<tile::Buffer>> inputs,
-    std::map<std::string, std::shared_ptr<tile::Buffer>> outputs) {
-  LogRequest(program, inputs, outputs);
-
-  RunRequest req{program};
-
-  context::Activity running{ctx, "tile::local_machine::Program::Run"};
-  boost::future<void> complete;
-  auto shim = std::make_unique<Shim>(running.ctx(), program, std::move(inputs), std::move(outputs));
+void RunRequest::WaitForReduce(boost::shared_future<void>* reduce) {
+  if (!reduce->valid()) {
+    return;
+  }
+  if (!reduce->is_ready()) {
+    // Start the steps queued so far while the sums are written.
+    program_->devinfo()->dev->executor()->Flush();
+    reduce->wait();
+  }
+  *reduce = boost::shared_future<void>{};
+}
 
-  {
-    context::Activity queueing{running.ctx(), "tile::local_machine::Program::Enqueue"};
-    boost::future<std::vector<std::shared_ptr<hal::Result>>> results;
+void RunRequest::OnStepComplete(std::size_t slot, std::shared_ptr<hal::Result> result, boost::exception_ptr error) {
+  if (slot < scratch_->results.size()) {
+    scratch_->results[slot] = std::move(result);
+  }
+  if (error && !failed_.exchange(true)) {
+    error_ = std::move(error);
+  }
+  // The release half publishes this slot (and any error) to whichever callback finishes last.
+  if (remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    Finish();
+  }
+}
 
+void RunRequest::Finish() {
+  auto self = std::move(self_);  // Keeps the request alive until Finish returns
+  boost::exception_ptr error = error_;
+  if (!error) {
     try {
-      results = RunSchedule(queueing.ctx(), &req, shim.get());
+      LogResults();
     } catch (...) {
-      shim->SetLaunchException(std::current_exception());
-      // If this happens, it's probably an OOM.
-      // TODO: Synchronize with the HAL to ensure all ongoing activity is complete,
-      // so that we can safely release any memory we're holding onto.
-      return boost::make_ready_future();
+      error = boost::current_exception();
     }
-    shim->OnLaunchSuccess();
-    complete = req.LogResults(queueing.ctx(), std::move(results));
   }
-
-  // Keep the shim and activity referenced until the program is complete.
-  // N.B. It's important to keep the shim referenced because it's the thing that's actually holding
-  // onto all of our chunk references; if those go away, unfortunate things happen.
-  return complete.then([shim = std::move(shim), running = std::move(running)](decltype(complete) fut) {  //
-    fut.get();
-  });
+  if (error && memo_compute_) {
+    program_->memo_cache()->Invalidate(memo_);
+  }
+  memo_.reset();
+  // Release the run's memory before resolving the promise, so that a caller which starts another run as soon as this
+  // one completes finds the memory available.
+  shim_.reset();
+  program_->scratch_pool()->Release(std::move(scratch_));
+  running_ = context::Activity{};
+  if (error) {
+    prom_.set_exception(error);
+  } else {
+    prom_.set_value();
+  }
 }
 
-void RunRequest::LogRequest(                  //
-    const std::shared_ptr<Program>& program,  //
-    const std::map<std::string, std::shared_ptr<tile::Buffer>>& inputs,
-    const std::map<std::string, std::shared_ptr<tile::Buffer>>& outputs) {
+void RunRequest::LogRequest(const std::shared_ptr<Program>& program, const Shim::Arguments& args) {
   VLOG(1) << "Running program " << program;
-  if (VLOG_IS_ON(2)) {
-    for (const auto& it : inputs) {
-      std::shared_ptr<Buffer> buffer = Buffer::Downcast(it.second, program->devinfo());
-      std::shared_ptr<MemChunk> chunk = buffer->chunk();
-      if (chunk) {
-        VLOG(2) << "Input  " << it.first << " -> Buffer " << buffer.get() << " -> HAL Buffer "
-                << chunk->hal_buffer().get() << ", size=" << chunk->size() << " bytes";
-      } else {
-        VLOG(2) << "Input  " << it.first << " -> Buffer " << buffer.get() << " -> No chunk, size=" << buffer->size()
-                << " bytes";
-      }
+  if (!IVLOG_IS_ON(2)) {
+    return;
+  }
+  auto log_arg = [&](const char* kind, const std::string& name, tile::Buffer* arg) {
+    if (!arg) {
+      VLOG(2) << kind << name << " -> Unbound";
+      return;
     }
-    for (const auto& it : outputs) {
-      std::shared_ptr<Buffer> buffer = Buffer::Downcast(it.second, program->devinfo());
-      std::shared_ptr<MemChunk> chunk = buffer->chunk();
-      if (chunk) {
-        VLOG(2) << "Output " << it.first << " -> Buffer " << buffer.get() << " -> HAL Buffer "
-                << chunk->hal_buffer().get() << ", size=" << chunk->size() << " bytes";
-      } else {
-        VLOG(2) << "Output " << it.first << " -> Buffer " << buffer.get() << " -> No chunk, size=" << buffer->size()
-                << " bytes";
-      }
+    Buffer* buffer = Buffer::Downcast(arg, program->devinfo());
+    std::shared_ptr<MemChunk> chunk = buffer->chunk();
+    if (chunk) {
+      VLOG(2) << kind << name << " -> Buffer " << buffer << " -> HAL Buffer " << chunk->hal_buffer().get()
+              << ", size=" << chunk->size() << " bytes";
+    } else {
+      VLOG(2) << kind << name << " -> Buffer " << buffer << " -> No chunk, size=" << buffer->size() << " bytes";
+    }
+  };
+  for (const auto& alloc : program->schedule().allocs) {
+    if (alloc.is_input()) {
+      log_arg("Input  ", alloc.input, args.Input(alloc));
+    }
+    if (alloc.is_output()) {
+      log_arg("Output ", alloc.output, args.Output(alloc));
     }
   }
 }
 
-boost::future<void> RunRequest::LogResults(  //
-    const context::Context& ctx,             //
-    boost::future<std::vector<std::shared_ptr<hal::Result>>> results) {
-  context::Context ctx_copy{ctx};
-  return results.then([ctx = std::move(ctx_copy)](decltype(results) future) {
-    auto results = future.get();
-    if (VLOG_IS_ON(1) || ctx.is_logging_events()) {
-      std::chrono::high_resolution_clock::duration total{std::chrono::high_resolution_clock::duration::zero()};
-      for (const auto& result : results) {
-        total += result->GetDuration();
-        result->LogStatistics();
+void RunRequest::LogResults() {
+  std::vector<std::pair<std::size_t, double>> durations;
+  if (record_stats_ || IVLOG_IS_ON(1)) {
+    for (const auto& launch : program_->launch_plan().steps) {
+      const schedule::Step& step = *launch.step;
+      if (launch.memoized && !memo_compute_) {
+        continue;  // The step ran (and was recorded) in an earlier run
+      }
+      if (step.tag == schedule::Step::Tag::kRun && step.idx < scratch_->results.size()) {
+        std::chrono::duration<double> duration = scratch_->results[step.idx]->GetDuration();
+        durations.emplace_back(step.kidx, duration.count());
       }
-      VLOG(1) << "Total program execution duration: " << total.count();
     }
-  });
+  }
+  if (record_stats_) {
+    program_->RecordKernelDurations(durations);
+  }
+  if (IVLOG_IS_ON(1) || running_.ctx().is_logging_events()) {
+    std::chrono::high_resolution_clock::duration total{std::chrono::high_resolution_clock::duration::zero()};
+    for (const auto& result : scratch_->results) {
+      total += result->GetDuration();
+      result->LogStatistics();
+    }
+    VLOG(1) << "Total program execution duration: " << total.count();
+  }
+  if (IVLOG_IS_ON(1) && durations.size()) {
+    auto entries = BuildRoofline(program_->kernel_list(), program_->devinfo()->settings, durations);
+    VLOG(1) << "Kernel roofline (peak " << program_->devinfo()->settings.peak_gflops() << " GFLOP/s, "
+            << program_->devinfo()->settings.peak_gbytes_per_sec() << " GB/s):\n"
+            << FormatRoofline(entries);
+  }
 }
 
 }  // namespace local_machine
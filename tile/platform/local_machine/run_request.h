@@ -2,53 +2,84 @@
 
 #pragma once
 
-#include <map>
+#include <atomic>
 #include <memory>
 #include <string>
-#include <vector>
 
 #include "base/context/context.h"
 #include "tile/base/buffer.h"
 #include "tile/base/hal.h"
+#include "tile/platform/local_machine/memo_cache.h"
 #include "tile/platform/local_machine/program.h"
+#include "tile/platform/local_machine/run_scratch.h"
+#include "tile/platform/local_machine/shim.h"
 
 namespace vertexai {
 namespace tile {
 namespace local_machine {
 
 // Represents the state of a Program::Run request.
-class RunRequest {
+//
+// A run is a small state machine driven by HAL completion callbacks rather than by chained futures: Launch queues
+// every step and registers a callback on each event the run must wait for; each callback records its result and counts
+// down; and the last one to arrive runs Finish, which logs the results, releases the run's memory, and resolves the
+// single future returned by Run.  Nothing blocks between launch and completion, so concurrent runs' transfers and
+// kernels overlap freely.
+//
+// A run keeps its host-side bookkeeping in RunScratch recycled through its program, so that in the steady state --
+// repeated runs of a program with the same bindings -- its lists reuse the capacity earlier runs left behind rather
+// than growing afresh.  A run still allocates on the host: the request itself, its future's shared state, and whatever
+// the HAL allocates for the events and transfers it queues, at least.
+class RunRequest final : public std::enable_shared_from_this<RunRequest> {
  public:
+  // Starts a run.  The arguments are only borrowed for the duration of the call.
   static boost::future<void> Run(               //
       const context::Context& ctx,              //
       const std::shared_ptr<Program>& program,  //
-      std::map<std::string, std::shared_ptr<tile::Buffer>> inputs,
-      std::map<std::string, std::shared_ptr<tile::Buffer>> outputs);
-
-  void AddProgramDoneDep(const std::shared_ptr<hal::Event>& event);
+      const Shim::Arguments& args);
 
   const Program* program() const { return program_.get(); }
 
  private:
-  struct KernelLogInfo {
-    std::shared_ptr<hal::Event> done;
-    std::string kname;
-    std::size_t tot_bytes;
-    std::size_t tot_flops;
-  };
+  RunRequest(const context::Context& ctx, const std::shared_ptr<Program>& program);
 
-  explicit RunRequest(const std::shared_ptr<Program>& program) : program_{program} {}
+  // Looks up the memoized steps' results, builds the shim, queues the steps, and starts waiting for them.
+  void Launch(const Shim::Arguments& args);
 
-  static void LogRequest(                       //
-      const std::shared_ptr<Program>& program,  //
-      const std::map<std::string, std::shared_ptr<tile::Buffer>>& inputs,
-      const std::map<std::string, std::shared_ptr<tile::Buffer>>& outputs);
+  // Queues every step of the launch plan, collecting the events the run must wait for in the scratch's watched list:
+  // every step's if profiling (in step order), and otherwise just the terminal steps'.
+  void QueueSteps(const context::Context& ctx);
+
+  // Waits for an all-reduction pending on one of the run's buffers, first starting the steps already queued, and
+  // clears it so that later steps don't wait for it again.
+  void WaitForReduce(boost::shared_future<void>* reduce);
+
+  // Records the completion of the watched event in the given slot, finishing the run if it was the last.
+  void OnStepComplete(std::size_t slot, std::shared_ptr<hal::Result> result, boost::exception_ptr error);
 
-  boost::future<void> LogResults(   //
-      const context::Context& ctx,  //
-      boost::future<std::vector<std::shared_ptr<hal::Result>>> results);
+  void Finish();
+
+  // Logs the start of a run and, at verbosity 2, the buffers supplied for its program inputs and outputs.
+  static void LogRequest(const std::shared_ptr<Program>& program, const Shim::Arguments& args);
+
+  // Logs the results of a run and, if record_stats_ is set, records its kernel durations; record_stats_ requires that
+  // the results hold every step of the launch plan, in step order.
+  void LogResults();
 
   const std::shared_ptr<Program> program_;
+  context::Activity running_;
+  std::unique_ptr<RunScratch> scratch_;
+  std::unique_ptr<Shim> shim_;
+  std::shared_ptr<RunRequest> self_;  // Keeps the request alive while its callbacks are registered
+  bool profile_ = false;
+  bool record_stats_ = false;
+  std::shared_ptr<MemoCache::Entry> memo_;  // The results of the program's memoized steps, if it has any
+  bool memo_compute_ = false;               // Whether this run computes memo_, rather than reusing it
+
+  std::atomic<std::size_t> remaining_{0};
+  std::atomic<bool> failed_{false};
+  boost::exception_ptr error_;  // The first error reported
+  boost::promise<void> prom_;
 };
 
 }  // namespace local_machine
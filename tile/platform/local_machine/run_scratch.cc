@@ -0,0 +1,49 @@
+// Copyright 2020, Intel Corporation
+
+#include "tile/platform/local_machine/run_scratch.h"
+
+#include <utility>
+
+namespace vertexai {
+namespace tile {
+namespace local_machine {
+
+void RunScratch::Clear() {
+  chunks.clear();
+  updates.clear();
+  step_events.clear();
+  step_deps.clear();
+  step_params.clear();
+  watched.clear();
+  results.clear();
+  reduces.clear();
+}
+
+std::unique_ptr<RunScratch> RunScratchPool::Acquire() {
+  {
+    std::lock_guard<std::mutex> lock{mu_};
+    if (idle_.size()) {
+      auto scratch = std::move(idle_.back());
+      idle_.pop_back();
+      return scratch;
+    }
+  }
+  return std::make_unique<RunScratch>();
+}
+
+void RunScratchPool::Release(std::unique_ptr<RunScratch> scratch) noexcept {
+  if (!scratch) {
+    return;
+  }
+  scratch->Clear();
+  std::lock_guard<std::mutex> lock{mu_};
+  try {
+    idle_.emplace_back(std::move(scratch));
+  } catch (...) {
+    // Out of memory; the scratch is simply freed.
+  }
+}
+
+}  // namespace local_machine
+}  // namespace tile
+}  // namespace vertexai
@@ -0,0 +1,58 @@
+// Copyright 2020, Intel Corporation
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <boost/thread/future.hpp>
+
+#include "tile/base/hal.h"
+#include "tile/platform/local_machine/buffer.h"
+#include "tile/platform/local_machine/mem_chunk.h"
+
+namespace vertexai {
+namespace tile {
+namespace local_machine {
+
+// The host-side working storage of a program run: its chunk map, output updates, and the event and parameter lists
+// used while queueing its steps.  Each program recycles its runs' scratch, so once a program's runs have warmed it up,
+// a run fills vectors which already have the capacity it needs instead of allocating them afresh.
+struct RunScratch {
+  struct AliasUpdate {
+    Buffer* buffer;  // Borrowed until the run's Shim applies the update
+    std::shared_ptr<MemChunk> chunk;
+  };
+
+  // Empties the scratch, releasing everything it refers to but keeping its capacity.
+  void Clear();
+
+  std::vector<std::shared_ptr<MemChunk>> chunks;          // By alloc index
+  std::vector<AliasUpdate> updates;
+  std::vector<std::shared_ptr<hal::Event>> step_events;   // By step index
+  std::vector<std::shared_ptr<hal::Event>> step_deps;     // The current step's dependencies
+  std::vector<std::shared_ptr<hal::Buffer>> step_params;  // The current step's parameters
+  std::vector<std::shared_ptr<hal::Event>> watched;       // The events the run waits for
+  std::vector<std::shared_ptr<hal::Result>> results;      // By watched event
+  std::vector<boost::shared_future<void>> reduces;        // By alloc index: all-reductions pending on the inputs
+};
+
+// A free list of RunScratch.  Acquire and Release do not allocate once the pool holds as much scratch as there are
+// concurrent runs.
+class RunScratchPool {
+ public:
+  // Returns idle scratch, or new scratch if none is idle.
+  std::unique_ptr<RunScratch> Acquire();
+
+  // Clears the scratch and returns it to the pool.
+  void Release(std::unique_ptr<RunScratch> scratch) noexcept;
+
+ private:
+  std::mutex mu_;
+  std::vector<std::unique_ptr<RunScratch>> idle_;
+};
+
+}  // namespace local_machine
+}  // namespace tile
+}  // namespace vertexai
@@ -0,0 +1,96 @@
+// Copyright 2020, Intel Corporation
+
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "tile/platform/local_machine/run_scratch.h"
+
+namespace {
+
+// Counts the test's heap allocations.
+std::atomic<std::size_t> allocations{0};
+
+}  // namespace
+
+void* operator new(std::size_t size) {
+  allocations++;
+  void* ptr = std::malloc(size ? size : 1);
+  if (!ptr) {
+    throw std::bad_alloc{};
+  }
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+namespace vertexai {
+namespace tile {
+namespace local_machine {
+namespace {
+
+// Fills the scratch with as many entries as a run of a program with the given numbers of allocs and steps would.
+// This only stands in for a run's use of its scratch: these tests cover the pool and the scratch, not RunRequest.
+void FillLikeARun(RunScratch* scratch, std::size_t allocs, std::size_t steps) {
+  scratch->chunks.resize(allocs);
+  scratch->updates.resize(allocs / 2);
+  scratch->step_events.resize(steps);
+  for (std::size_t i = 0; i < steps; ++i) {
+    scratch->step_deps.clear();
+    scratch->step_params.clear();
+    scratch->step_deps.resize(3);
+    scratch->step_params.resize(4);
+  }
+  scratch->watched.resize(steps);
+  scratch->results.resize(steps);
+}
+
+TEST(RunScratchTest, WarmPoolReuseDoesNotAllocate) {
+  RunScratchPool pool;
+  {
+    // Warm up with two concurrent users.
+    auto first = pool.Acquire();
+    auto second = pool.Acquire();
+    FillLikeARun(first.get(), 64, 100);
+    FillLikeARun(second.get(), 64, 100);
+    pool.Release(std::move(first));
+    pool.Release(std::move(second));
+  }
+
+  std::size_t before = allocations;
+  for (int run = 0; run < 10; ++run) {
+    auto first = pool.Acquire();
+    auto second = pool.Acquire();
+    FillLikeARun(first.get(), 64, 100);
+    FillLikeARun(second.get(), 64, 100);
+    pool.Release(std::move(second));
+    pool.Release(std::move(first));
+  }
+  EXPECT_EQ(allocations - before, 0);
+}
+
+TEST(RunScratchTest, ReleaseClearsScratch) {
+  RunScratchPool pool;
+  auto scratch = pool.Acquire();
+  FillLikeARun(scratch.get(), 8, 8);
+  auto raw = scratch.get();
+  pool.Release(std::move(scratch));
+
+  scratch = pool.Acquire();
+  EXPECT_EQ(scratch.get(), raw);
+  EXPECT_TRUE(scratch->chunks.empty());
+  EXPECT_TRUE(scratch->updates.empty());
+  EXPECT_TRUE(scratch->step_events.empty());
+  EXPECT_TRUE(scratch->watched.empty());
+  EXPECT_TRUE(scratch->results.empty());
+  EXPECT_GE(scratch->chunks.capacity(), 8);
+}
+
+}  // namespace
+}  // namespace local_machine
+}  // namespace tile
+}  // namespace vertexai
@@ -2,6 +2,7 @@
 
 #include "tile/platform/local_machine/scheduler.h"
 
+#include <atomic>
 #include <iterator>
 #include <map>
 #include <set>
@@ -10,6 +11,7 @@
 #include <boost/dynamic_bitset.hpp>
 
 #include "base/util/compat.h"
+#include "base/util/env.h"
 #include "base/util/error.h"
 
 namespace vertexai {
@@ -19,9 +21,9 @@ namespace local_machine {
 namespace {
 
 struct AllocInfo {
-  explicit AllocInfo(std::size_t sidx_limit) : accessors(sidx_limit) {}
-
-  boost::dynamic_bitset<> accessors;
+  // The steps which have accessed the alloc since its last write.  Kept as a list rather than a bitset over every
+  // step, since most allocs are only touched by a handful of steps.
+  std::vector<std::size_t> accessors;
   std::string contents;
   bool program_input = false;
   bool read_only = false;
@@ -33,7 +35,7 @@ struct AllocInfo {
 // based
 // on the program input allocs.
 std::vector<AllocInfo> GetAllocContents(const tile::proto::Program& program, const schedule::Schedule& schedule) {
-  std::vector<AllocInfo> alloc_infos{schedule.allocs.size(), AllocInfo{schedule.steps.size()}};
+  std::vector<AllocInfo> alloc_infos{schedule.allocs.size()};
   for (const auto& alloc : schedule.allocs) {
     AllocInfo& ai = alloc_infos[alloc.idx];
     ai.byte_size = alloc.byte_size;
@@ -302,7 +304,7 @@ void ValidateSchedule(const tile::proto::Program& program, const lang::KernelLis
         throw error::Internal{"Schedule reads tensor a" + std::to_string(aidx) + " \"" + ainfo.contents + "\" at s" +
                               std::to_string(sidx) + " prior to its write"};
       }
-      ainfo.accessors.set(sidx);
+      ainfo.accessors.push_back(sidx);
     }
 
     for (std::size_t oidx = 0; oidx < new_contents.size(); ++oidx) {
@@ -322,10 +324,11 @@ void ValidateSchedule(const tile::proto::Program& program, const lang::KernelLis
       // Note that we add the current step as a self-dependency in this check, to account for steps
       // that reuse allocs for different temporaries.  TODO: Only add the self-dep for cases where codegen
       // says it's okay to reuse an input alloc for an output.
-      auto deps = transitive_deps[sidx];
-      deps.set(sidx);
-      if (((deps & ainfo.accessors) ^ ainfo.accessors).any()) {
-        throw error::Internal{"Schedule writes a tensor to a live alloc at s" + std::to_string(sidx)};
+      const auto& deps = transitive_deps[sidx];
+      for (std::size_t accessor : ainfo.accessors) {
+        if (accessor != sidx && !deps.test(accessor)) {
+          throw error::Internal{"Schedule writes a tensor to a live alloc at s" + std::to_string(sidx)};
+        }
       }
       std::uint64_t tensor_size = kl.types.at(new_contents[oidx]).byte_size();
       if (ainfo.byte_size < tensor_size) {
@@ -337,8 +340,8 @@ void ValidateSchedule(const tile::proto::Program& program, const lang::KernelLis
       // The current step becomes the last writer and the only current
       // accessor.
       ainfo.last_writer_sidx = sidx;
-      ainfo.accessors.reset();
-      ainfo.accessors.set(sidx);
+      ainfo.accessors.clear();
+      ainfo.accessors.push_back(sidx);
       ainfo.contents = new_contents[oidx];
     }
 
@@ -382,6 +385,31 @@ void ValidateSchedule(const tile::proto::Program& program, const lang::KernelLis
   }
 }
 
+bool ShouldValidateSchedule() {
+  static const std::string mode = [] {
+    auto env = env::Get("PLAIDML_SCHEDULE_VALIDATION");
+    if (env.length()) {
+      return env;
+    }
+#ifdef NDEBUG
+    return std::string{"sampled"};
+#else
+    return std::string{"full"};
+#endif
+  }();
+  if (mode == "full") {
+    return true;
+  }
+  if (mode == "sampled") {
+    static std::atomic<std::size_t> schedules{0};
+    return schedules++ % kScheduleValidationSampleRate == 0;
+  }
+  if (mode != "none") {
+    LOG(WARNING) << "Unrecognized PLAIDML_SCHEDULE_VALIDATION \"" << mode << "\"; not validating schedules";
+  }
+  return false;
+}
+
 inline std::size_t AlignUp(std::size_t byte_size, std::size_t alignment) {
   return ((byte_size + alignment - 1) / alignment) * alignment;
 }
@@ -52,6 +52,15 @@ void AddLinearDeps(schedule::Schedule* schedule, std::size_t delta);
 void ValidateSchedule(const tile::proto::Program& program, const lang::KernelList& kl,
                       const schedule::Schedule& schedule);
 
+// Under sampled validation, the number of schedules built per schedule validated.
+constexpr std::size_t kScheduleValidationSampleRate = 16;
+
+// Returns whether the schedule about to be run should be validated, per PLAIDML_SCHEDULE_VALIDATION:
+// "full" validates every schedule (the default in debug builds), "sampled" validates the first schedule
+// and one in every kScheduleValidationSampleRate after it (the default in release builds), and "none"
+// validates none.
+bool ShouldValidateSchedule();
+
 // Return the total size of all allocs
 std::size_t TotalAllocSize(const schedule::Schedule& schedule, std::size_t alignment = 1);
 
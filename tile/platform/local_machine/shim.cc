@@ -14,12 +14,10 @@ namespace local_machine {
 namespace {
 
 // Builds a memory allocation map for a particular program run.
-std::pair<std::vector<std::shared_ptr<MemChunk>>, std::list<Shim::AliasUpdate>> BuildChunkMap(
-    const context::Context& ctx, const Program* program,
-    const std::map<std::string, std::shared_ptr<tile::Buffer>>& inputs,
-    const std::map<std::string, std::shared_ptr<tile::Buffer>>& outputs) {
-  std::vector<std::shared_ptr<MemChunk>> chunk_infos;
-  std::list<Shim::AliasUpdate> updates;
+void BuildChunkMap(const context::Context& ctx, const Program* program, const Shim::Arguments& args,
+                   const MemoCache::Entry* memo, RunScratch* scratch) {
+  auto& chunk_infos = scratch->chunks;
+  auto& updates = scratch->updates;
   chunk_infos.reserve(program->schedule().allocs.size());
   for (const auto& alloc : program->schedule().allocs) {
     std::shared_ptr<MemChunk> chunk;
@@ -29,36 +27,42 @@ std::pair<std::vector<std::shared_ptr<MemChunk>>, std::list<Shim::AliasUpdate>>
       // might not have a chunk; this is unusual, but it's technically allowed;
       // this can be useful when a caller's just testing to see whether it's correctly
       // composed a Tile program.
-      auto iit = inputs.find(alloc.input);
-      if (iit == inputs.end()) {
+      auto input = args.Input(alloc);
+      if (!input) {
         throw error::NotFound{"Missing program input: " + alloc.input};
       }
-      std::shared_ptr<Buffer> input_buffer = Buffer::Downcast(iit->second, program->devinfo());
+      Buffer* input_buffer = Buffer::Downcast(input, program->devinfo());
       input_buffer->EnsureChunk(ctx);
       chunk = input_buffer->chunk();
+      IVLOG(2, "Input  " << alloc.input << " -> Buffer " << input_buffer << ", size=" << input_buffer->size()
+                         << " bytes");
 
       if (alloc.is_output()) {
         // The chunk is also being used as a program output; the corresponding output buffer
         // must wind up pointing to this chunk if launch succeeds, regardless of whether it
         // already has a chunk.
-        auto oit = outputs.find(alloc.output);
-        if (oit == outputs.end()) {
+        auto output = args.Output(alloc);
+        if (!output) {
           throw error::NotFound{"Missing program output: " + alloc.output};
         }
-        std::shared_ptr<Buffer> output_buffer = Buffer::Downcast(oit->second, program->devinfo());
-        updates.emplace_back(Shim::AliasUpdate{std::move(output_buffer), chunk});
+        updates.emplace_back(Shim::AliasUpdate{Buffer::Downcast(output, program->devinfo()), chunk});
       }
     } else if (alloc.is_output()) {
       // This is a program output, but not a program input.  So we'll be creating a new chunk
       // for it here -- typically, the output buffer will not already have a chunk, but if it does,
       // it's okay to go ahead and replace it iff launch succeeds.
-      auto oit = outputs.find(alloc.output);
-      if (oit == outputs.end()) {
+      auto output = args.Output(alloc);
+      if (!output) {
         throw error::NotFound{"Missing program output: " + alloc.output};
       }
-      std::shared_ptr<Buffer> output_buffer = Buffer::Downcast(oit->second, program->devinfo());
+      Buffer* output_buffer = Buffer::Downcast(output, program->devinfo());
       chunk = program->output_mem_strategy()->MakeChunk(ctx, output_buffer->size());
-      updates.emplace_back(Shim::AliasUpdate{std::move(output_buffer), chunk});
+      IVLOG(2, "Output " << alloc.output << " -> Buffer " << output_buffer << ", size=" << output_buffer->size()
+                         << " bytes");
+      updates.emplace_back(Shim::AliasUpdate{output_buffer, chunk});
+    } else if (memo && alloc.idx < memo->chunks.size() && memo->chunks[alloc.idx]) {
+      // This temporary holds a memoized result, which is kept from one run to the next.
+      chunk = memo->chunks[alloc.idx];
     } else {
       // This is neither a program input nor a program output; the alloc is purely internal
       // to the program.  Make a temporary buffer for it.
@@ -67,7 +71,6 @@ std::pair<std::vector<std::shared_ptr<MemChunk>>, std::list<Shim::AliasUpdate>>
 
     chunk_infos.emplace_back(std::move(chunk));
   }
-  return std::make_pair(std::move(chunk_infos), std::move(updates));
 }
 
 }  // namespace
@@ -75,35 +78,38 @@ std::pair<std::vector<std::shared_ptr<MemChunk>>, std::list<Shim::AliasUpdate>>
 Shim::Shim(                                   //
     const context::Context& ctx,              //
     const std::shared_ptr<Program>& program,  //
-    std::map<std::string, std::shared_ptr<tile::Buffer>> inputs,
-    std::map<std::string, std::shared_ptr<tile::Buffer>> outputs)
-    : program_{program} {
-  std::tie(chunk_infos_, updates_) = BuildChunkMap(ctx, program.get(), inputs, outputs);
+    const Arguments& args,                    //
+    RunScratch* scratch,                      //
+    const MemoCache::Entry* memo)
+    : scratch_{scratch}, program_{program} {
+  scratch_->chunks.clear();
+  scratch_->updates.clear();
+  BuildChunkMap(ctx, program.get(), args, memo, scratch_);
 }
 
 Shim::~Shim() {
   // Release the resource manually first
   // Then tell program that the resource is released
-  chunk_infos_.clear();
-  updates_.clear();
+  scratch_->chunks.clear();
+  scratch_->updates.clear();
   program_->Release();
 }
 
-std::shared_ptr<MemChunk> Shim::LookupAlloc(std::size_t /* sidx */, schedule::Alloc* alloc) const {
-  return chunk_infos_[alloc->idx];
+const std::shared_ptr<MemChunk>& Shim::LookupAlloc(std::size_t /* sidx */, schedule::Alloc* alloc) const {
+  return scratch_->chunks[alloc->idx];
 }
 
 void Shim::SetLaunchException(std::exception_ptr ep) const noexcept {
   // Any error in the launch poisons all output buffers.
-  for (const auto& chunk : chunk_infos_) {
+  for (const auto& chunk : scratch_->chunks) {
     chunk->deps()->Poison(ep);
   }
 }
 
 void Shim::OnLaunchSuccess() noexcept {
   // Apply updates to outputs.
-  for (const auto& update : updates_) {
-    update.buffer->RemapTo(std::move(update.chunk));
+  for (const auto& update : scratch_->updates) {
+    update.buffer->RemapTo(update.chunk);
   }
 }
 
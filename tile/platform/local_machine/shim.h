@@ -3,16 +3,16 @@
 #pragma once
 
 #include <cstddef>
-#include <list>
 #include <map>
 #include <memory>
 #include <string>
-#include <vector>
 
 #include "base/context/context.h"
 #include "tile/platform/local_machine/buffer.h"
 #include "tile/platform/local_machine/mem_chunk.h"
+#include "tile/platform/local_machine/memo_cache.h"
 #include "tile/platform/local_machine/program.h"
+#include "tile/platform/local_machine/run_scratch.h"
 
 namespace vertexai {
 namespace tile {
@@ -25,25 +25,57 @@ namespace local_machine {
 // program (e.g. dealiasing input and output buffers).
 class Shim {
  public:
-  struct AliasUpdate {
-    std::shared_ptr<Buffer> buffer;
-    std::shared_ptr<MemChunk> chunk;
+  using AliasUpdate = RunScratch::AliasUpdate;
+
+  // Supplies the buffers for a run's program inputs and outputs.  The buffers are only borrowed, through the Shim's
+  // construction and OnLaunchSuccess; the Shim keeps their chunks.
+  class Arguments {
+   public:
+    virtual ~Arguments() {}
+
+    // Returns the buffer for an input or output alloc, or nullptr if none was supplied.
+    virtual tile::Buffer* Input(const schedule::Alloc& alloc) const = 0;
+    virtual tile::Buffer* Output(const schedule::Alloc& alloc) const = 0;
+  };
+
+  // Arguments supplied by name.
+  class NamedArguments final : public Arguments {
+   public:
+    NamedArguments(const std::map<std::string, std::shared_ptr<tile::Buffer>>& inputs,
+                   const std::map<std::string, std::shared_ptr<tile::Buffer>>& outputs)
+        : inputs_{inputs}, outputs_{outputs} {}
+
+    tile::Buffer* Input(const schedule::Alloc& alloc) const final { return Find(inputs_, alloc.input); }
+    tile::Buffer* Output(const schedule::Alloc& alloc) const final { return Find(outputs_, alloc.output); }
+
+   private:
+    static tile::Buffer* Find(const std::map<std::string, std::shared_ptr<tile::Buffer>>& bufs,
+                              const std::string& name) {
+      auto it = bufs.find(name);
+      return it == bufs.end() ? nullptr : it->second.get();
+    }
+
+    const std::map<std::string, std::shared_ptr<tile::Buffer>>& inputs_;
+    const std::map<std::string, std::shared_ptr<tile::Buffer>>& outputs_;
   };
 
   // Construct the Shim.  This should be done at the start of queueing
-  // the program's steps.
+  // the program's steps.  The Shim keeps its chunk map and output updates in
+  // the supplied scratch, which must outlive it.  The temporaries holding
+  // memoized results use the chunks of memo, if supplied.
   Shim(                                         //
       const context::Context& ctx,              //
       const std::shared_ptr<Program>& program,  //
-      std::map<std::string, std::shared_ptr<tile::Buffer>> inputs,
-      std::map<std::string, std::shared_ptr<tile::Buffer>> outputs);
+      const Arguments& args,                    //
+      RunScratch* scratch,                      //
+      const MemoCache::Entry* memo = nullptr);
 
   // Destroys the Shim.  Note that this does not apply side-effects;
   // OnLaunchSuccess must be invoked in order to remap program output buffers.
   ~Shim();
 
   // Translate an input or output for a step.
-  std::shared_ptr<MemChunk> LookupAlloc(std::size_t sidx, schedule::Alloc* alloc) const;
+  const std::shared_ptr<MemChunk>& LookupAlloc(std::size_t sidx, schedule::Alloc* alloc) const;
 
   // Handle execution errors.
   void SetLaunchException(std::exception_ptr ep) const noexcept;
@@ -53,8 +85,7 @@ class Shim {
   void OnLaunchSuccess() noexcept;
 
  private:
-  std::vector<std::shared_ptr<MemChunk>> chunk_infos_;
-  std::list<AliasUpdate> updates_;
+  RunScratch* scratch_;
   std::shared_ptr<Program> program_;
 };
 
@@ -0,0 +1,77 @@
+// Copyright 2020, Intel Corporation
+
+#include "tile/platform/local_machine/slot_binding.h"
+
+#include <boost/format.hpp>
+
+#include "base/util/error.h"
+
+namespace vertexai {
+namespace tile {
+namespace local_machine {
+
+SlotBinding::SlotBinding(const Program* program, const schedule::Schedule& schedule,
+                         const std::map<std::string, std::shared_ptr<tile::Buffer>>& constants,
+                         const std::vector<std::string>& input_names, const std::vector<std::string>& output_names)
+    : program_{program}, input_count_{input_names.size()}, output_count_{output_names.size()} {
+  std::map<std::string, std::size_t> input_slots;
+  for (std::size_t i = 0; i < input_names.size(); ++i) {
+    input_slots.emplace(input_names[i], i);
+  }
+  std::map<std::string, std::size_t> output_slots;
+  for (std::size_t i = 0; i < output_names.size(); ++i) {
+    output_slots.emplace(output_names[i], i);
+  }
+  allocs_.resize(schedule.allocs.size());
+  for (const auto& alloc : schedule.allocs) {
+    auto& entry = allocs_[alloc.idx];
+    if (alloc.is_input()) {
+      auto cit = constants.find(alloc.input);
+      if (cit != constants.end()) {
+        entry.constant = cit->second.get();
+      } else {
+        auto it = input_slots.find(alloc.input);
+        if (it != input_slots.end()) {
+          entry.input = it->second;
+        }
+      }
+    }
+    if (alloc.is_output()) {
+      auto it = output_slots.find(alloc.output);
+      if (it != output_slots.end()) {
+        entry.output = it->second;
+      }
+    }
+  }
+}
+
+const SlotBinding& SlotBinding::Check(const tile::ArgumentBinding& binding, const Program* program,
+                                      const tile::ArgumentTable& args) {
+  auto slots = dynamic_cast<const SlotBinding*>(&binding);
+  if (!slots || slots->program_ != program) {
+    throw error::InvalidArgument{"Argument binding was made for a different program"};
+  }
+  if (args.inputs.size() != slots->input_count_ || args.outputs.size() != slots->output_count_) {
+    throw error::InvalidArgument{
+        str(boost::format("Argument table has %1% inputs and %2% outputs; the binding has %3% and %4%") %
+            args.inputs.size() % args.outputs.size() % slots->input_count_ % slots->output_count_)};
+  }
+  return *slots;
+}
+
+tile::Buffer* SlotArguments::Input(const schedule::Alloc& alloc) const {
+  const auto& entry = binding_.alloc(alloc.idx);
+  if (entry.constant) {
+    return entry.constant;
+  }
+  return entry.input == SlotBinding::kNone ? nullptr : args_.inputs[entry.input];
+}
+
+tile::Buffer* SlotArguments::Output(const schedule::Alloc& alloc) const {
+  const auto& entry = binding_.alloc(alloc.idx);
+  return entry.output == SlotBinding::kNone ? nullptr : args_.outputs[entry.output];
+}
+
+}  // namespace local_machine
+}  // namespace tile
+}  // namespace vertexai
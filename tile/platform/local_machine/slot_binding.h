@@ -0,0 +1,67 @@
+// Copyright 2020, Intel Corporation
+
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tile/base/buffer.h"
+#include "tile/base/program.h"
+#include "tile/base/schedule.h"
+#include "tile/platform/local_machine/shim.h"
+
+namespace vertexai {
+namespace tile {
+namespace local_machine {
+
+// Where a run finds the buffer for each alloc of a program's schedule, resolved once by Program::Bind.
+class SlotBinding final : public tile::ArgumentBinding {
+ public:
+  static constexpr std::size_t kNone = static_cast<std::size_t>(-1);
+
+  struct AllocArgs {
+    std::size_t input = kNone;         // The input slot, if the alloc is a bound program input
+    std::size_t output = kNone;        // The output slot, if the alloc is a bound program output
+    tile::Buffer* constant = nullptr;  // The program's own constant buffer, if the alloc is one
+  };
+
+  // Resolves the argument names against the schedule's allocs; the output names must already be rewritten to the
+  // schedule's.  The program's constants take the place of inputs of the same name.  Names which match no alloc, and
+  // allocs which match no name, are left unbound, so that runs report them just as runs by name do.
+  SlotBinding(const Program* program, const schedule::Schedule& schedule,
+              const std::map<std::string, std::shared_ptr<tile::Buffer>>& constants,
+              const std::vector<std::string>& input_names, const std::vector<std::string>& output_names);
+
+  // Returns the binding as a SlotBinding, checking that it was made by the given program and that the table has a
+  // buffer for each of its names; throws error::InvalidArgument if not.
+  static const SlotBinding& Check(const tile::ArgumentBinding& binding, const Program* program,
+                                  const tile::ArgumentTable& args);
+
+  const AllocArgs& alloc(std::size_t idx) const { return allocs_[idx]; }
+
+ private:
+  const Program* program_;
+  std::size_t input_count_;
+  std::size_t output_count_;
+  std::vector<AllocArgs> allocs_;  // By alloc index
+};
+
+// A bound run's arguments, looked up by slot.  Both the binding and the table are borrowed.
+class SlotArguments final : public Shim::Arguments {
+ public:
+  SlotArguments(const SlotBinding& binding, const tile::ArgumentTable& args) : binding_{binding}, args_{args} {}
+
+  tile::Buffer* Input(const schedule::Alloc& alloc) const final;
+  tile::Buffer* Output(const schedule::Alloc& alloc) const final;
+
+ private:
+  const SlotBinding& binding_;
+  const tile::ArgumentTable& args_;
+};
+
+}  // namespace local_machine
+}  // namespace tile
+}  // namespace vertexai
@@ -0,0 +1,118 @@
+// Copyright 2020, Intel Corporation
+
+#include <gmock/gmock.h>
+
+#include <memory>
+
+#include "base/util/error.h"
+#include "tile/platform/local_machine/slot_binding.h"
+
+using ::testing::Eq;
+using ::testing::IsNull;
+
+namespace vertexai {
+namespace tile {
+namespace local_machine {
+namespace {
+
+// A buffer whose identity is all that matters: bindings never touch their buffers' contents.
+class FakeBuffer final : public tile::Buffer {
+ public:
+  uint64_t size() const final { return 0; }
+  boost::future<std::unique_ptr<View>> MapCurrent(const context::Context& ctx) final {
+    throw std::runtime_error("unimplemented");
+  }
+  std::unique_ptr<View> MapDiscard(const context::Context& ctx) final { throw std::runtime_error("unimplemented"); }
+};
+
+class SlotBindingTest : public ::testing::Test {
+ protected:
+  SlotBindingTest() {
+    AddAlloc("A", "");
+    AddAlloc("W", "");
+    AddAlloc("", "C");
+    AddAlloc("", "");
+    AddAlloc("Missing", "");
+    constants_["W"] = std::make_shared<FakeBuffer>();
+  }
+
+  const schedule::Alloc& AddAlloc(const std::string& input, const std::string& output) {
+    schedule_.allocs.emplace_back();
+    auto& alloc = schedule_.allocs.back();
+    alloc.idx = schedule_.allocs.size() - 1;
+    alloc.input = input;
+    alloc.output = output;
+    return alloc;
+  }
+
+  const schedule::Alloc& Alloc(std::size_t idx) const { return *std::next(schedule_.allocs.begin(), idx); }
+
+  // Only a program's identity is checked, so any address stands in for one.
+  const Program* program_ = reinterpret_cast<const Program*>(&schedule_);
+  schedule::Schedule schedule_;
+  std::map<std::string, std::shared_ptr<tile::Buffer>> constants_;
+};
+
+TEST_F(SlotBindingTest, ResolvesAllocsToSlots) {
+  // W is a constant, so the program supplies it even though it's named; Extra matches no alloc.
+  SlotBinding binding{program_, schedule_, constants_, {"Extra", "A", "W"}, {"C"}};
+  FakeBuffer a, w, c, extra;
+  tile::ArgumentTable table{{&extra, &a, &w}, {&c}};
+  SlotArguments args{SlotBinding::Check(binding, program_, table), table};
+
+  EXPECT_THAT(args.Input(Alloc(0)), Eq(&a));
+  EXPECT_THAT(args.Input(Alloc(1)), Eq(constants_["W"].get()));
+  EXPECT_THAT(args.Output(Alloc(2)), Eq(&c));
+  EXPECT_THAT(args.Input(Alloc(3)), IsNull());
+  EXPECT_THAT(args.Output(Alloc(3)), IsNull());
+  EXPECT_THAT(args.Input(Alloc(4)), IsNull());  // Left for the run to report, as a run by name would
+}
+
+TEST_F(SlotBindingTest, RejectsMismatchedBindings) {
+  SlotBinding binding{program_, schedule_, constants_, {"A"}, {"C"}};
+  FakeBuffer a, c;
+
+  // A binding made by another program.
+  const Program* other = reinterpret_cast<const Program*>(&constants_);
+  EXPECT_THROW(SlotBinding::Check(binding, other, {{&a}, {&c}}), error::InvalidArgument);
+
+  // A binding made by another kind of program.
+  class OtherBinding final : public tile::ArgumentBinding {};
+  EXPECT_THROW(SlotBinding::Check(OtherBinding{}, program_, {{&a}, {&c}}), error::InvalidArgument);
+
+  // Tables which don't have one buffer per bound name.
+  EXPECT_THROW(SlotBinding::Check(binding, program_, {{}, {&c}}), error::InvalidArgument);
+  EXPECT_THROW(SlotBinding::Check(binding, program_, {{&a, &a}, {&c}}), error::InvalidArgument);
+  EXPECT_THROW(SlotBinding::Check(binding, program_, {{&a}, {}}), error::InvalidArgument);
+  EXPECT_NO_THROW(SlotBinding::Check(binding, program_, {{&a}, {&c}}));
+}
+
+TEST_F(SlotBindingTest, RepeatedRunsFollowTheTable) {
+  // One binding serves every run; each run sees the buffers its table holds at the time.
+  SlotBinding binding{program_, schedule_, constants_, {"A"}, {"C"}};
+  std::vector<FakeBuffer> as(3);
+  std::vector<FakeBuffer> cs(3);
+  tile::ArgumentTable table{{nullptr}, {nullptr}};
+  for (std::size_t run = 0; run < as.size(); ++run) {
+    table.inputs[0] = &as[run];
+    table.outputs[0] = &cs[run];
+    SlotArguments args{SlotBinding::Check(binding, program_, table), table};
+    EXPECT_THAT(args.Input(Alloc(0)), Eq(&as[run]));
+    EXPECT_THAT(args.Output(Alloc(2)), Eq(&cs[run]));
+  }
+
+  // Concurrent runs each have their own table.
+  tile::ArgumentTable first{{&as[0]}, {&cs[0]}};
+  tile::ArgumentTable second{{&as[1]}, {&cs[1]}};
+  SlotArguments first_args{binding, first};
+  SlotArguments second_args{binding, second};
+  EXPECT_THAT(first_args.Input(Alloc(0)), Eq(&as[0]));
+  EXPECT_THAT(second_args.Input(Alloc(0)), Eq(&as[1]));
+  EXPECT_THAT(first_args.Output(Alloc(2)), Eq(&cs[0]));
+  EXPECT_THAT(second_args.Output(Alloc(2)), Eq(&cs[1]));
+}
+
+}  // namespace
+}  // namespace local_machine
+}  // namespace tile
+}  // namespace vertexai
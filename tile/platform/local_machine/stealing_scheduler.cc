@@ -0,0 +1,147 @@
+// Copyright 2019, Intel Corp.
+
+#include "tile/platform/local_machine/stealing_scheduler.h"
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <queue>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "base/util/error.h"
+#include "base/util/logging.h"
+
+namespace vertexai {
+namespace tile {
+namespace local_machine {
+namespace {
+
+std::uint64_t StepCost(const lang::KernelList& kl, const schedule::Step& step) {
+  switch (step.tag) {
+    case schedule::Step::Tag::kRun: {
+      const auto& ki = kl.kernels[step.kidx];
+      return 1 + ki.tot_flops + ki.tot_bytes;
+    }
+    case schedule::Step::Tag::kCopy:
+      return 1 + step.byte_count;
+    default:
+      throw error::Internal{"Invalid schedule step s" + std::to_string(step.idx)};
+  }
+}
+
+}  // namespace
+
+void AssignQueues(const lang::KernelList& kl, std::size_t queue_count, schedule::Schedule* schedule) {
+  if (!queue_count) {
+    throw error::InvalidArgument{"The work-stealing scheduler requires at least one queue"};
+  }
+
+  std::unordered_map<schedule::Step*, std::size_t> pending;
+  std::unordered_map<schedule::Step*, std::vector<schedule::Step*>> dependents;
+  std::vector<std::deque<schedule::Step*>> ready(queue_count);
+  std::size_t initial = 0;
+  for (auto& step : schedule->steps) {
+    pending[&step] = step.deps.size();
+    for (auto* dep : step.deps) {
+      dependents[dep].push_back(&step);
+    }
+    if (step.deps.empty()) {
+      // Spread the program's roots across the queues.
+      ready[initial++ % queue_count].push_back(&step);
+    }
+  }
+
+  // (finish time, queue, step); the queue index breaks ties deterministically.
+  typedef std::tuple<std::uint64_t, std::size_t, schedule::Step*> Completion;
+  std::priority_queue<Completion, std::vector<Completion>, std::greater<Completion>> running;
+  std::vector<bool> busy(queue_count, false);
+  std::vector<schedule::Step*> last_on_queue(queue_count, nullptr);
+  std::vector<schedule::Step*> order;
+  order.reserve(schedule->steps.size());
+  std::uint64_t now = 0;
+  std::size_t steals = 0;
+
+  auto dispatch = [&]() {
+    for (std::size_t qidx = 0; qidx < queue_count; ++qidx) {
+      if (busy[qidx]) {
+        continue;
+      }
+      schedule::Step* step = nullptr;
+      if (ready[qidx].size()) {
+        // Run the most recently readied step: its inputs are the freshest.
+        step = ready[qidx].back();
+        ready[qidx].pop_back();
+      } else {
+        auto victim = std::max_element(ready.begin(), ready.end(),
+                                       [](const std::deque<schedule::Step*>& lhs,
+                                          const std::deque<schedule::Step*>& rhs) { return lhs.size() < rhs.size(); });
+        if (victim->empty()) {
+          continue;
+        }
+        step = victim->front();
+        victim->pop_front();
+        ++steals;
+      }
+      step->queue = qidx;
+      if (last_on_queue[qidx]) {
+        step->deps.insert(last_on_queue[qidx]);
+      }
+      last_on_queue[qidx] = step;
+      busy[qidx] = true;
+      order.push_back(step);
+      running.emplace(now + StepCost(kl, *step), qidx, step);
+    }
+  };
+
+  dispatch();
+  while (running.size()) {
+    std::size_t qidx;
+    schedule::Step* step;
+    std::tie(now, qidx, step) = running.top();
+    running.pop();
+    busy[qidx] = false;
+    for (auto* dependent : dependents[step]) {
+      if (!--pending[dependent]) {
+        ready[qidx].push_back(dependent);
+      }
+    }
+    if (running.empty() || std::get<0>(running.top()) != now) {
+      dispatch();
+    }
+  }
+
+  if (order.size() != schedule->steps.size()) {
+    throw error::Internal{"Schedule dependencies contain a cycle"};
+  }
+
+  // Dispatch order is a topological order; rebuild the step list in it.
+  std::unordered_map<const schedule::Step*, std::size_t> position;
+  for (std::size_t pos = 0; pos < order.size(); ++pos) {
+    position[order[pos]] = pos;
+  }
+  schedule->steps.sort([&](const schedule::Step& lhs, const schedule::Step& rhs) {
+    return position[&lhs] < position[&rhs];
+  });
+  schedule->Reindex();
+  IVLOG(2, "Assigned " << order.size() << " steps to " << queue_count << " queues with " << steals << " steals");
+}
+
+WorkStealingScheduler::WorkStealingScheduler(const std::shared_ptr<Placer>& placer, std::size_t queue_count)
+    : placer_{placer}, queue_count_{queue_count} {}
+
+schedule::Schedule WorkStealingScheduler::BuildSchedule(const tile::proto::Program& program,
+                                                        const lang::KernelList& kl) {
+  schedule::Schedule schedule = ToScheduleSteps(program, kl);
+  AddDataflowDeps(&schedule);
+  AssignQueues(kl, queue_count_, &schedule);
+  placer_->PlaceSchedule(program, &schedule)->Apply();
+  return schedule;
+}
+
+const char* WorkStealingScheduler::name() const { return "WorkStealing"; }
+
+}  // namespace local_machine
+}  // namespace tile
+}  // namespace vertexai
@@ -0,0 +1,47 @@
+// Copyright 2019, Intel Corp.
+
+#pragma once
+
+#include <memory>
+
+#include "tile/platform/local_machine/placer.h"
+#include "tile/platform/local_machine/scheduler.h"
+
+namespace vertexai {
+namespace tile {
+namespace local_machine {
+
+// The work-stealing scheduler spreads the program's dataflow graph across a
+// fixed number of queues.  It simulates execution using the kernels' flop and
+// byte counts as costs: when a step completes, the steps it unblocks are
+// queued on the same queue (keeping producers and consumers together), and a
+// queue with nothing ready steals the oldest ready step from the busiest
+// queue.  Steps are then ordered by their simulated start time, and each step
+// depends on the previous step assigned to its queue, so at most queue_count
+// independent chains of kernels are in flight at once.
+//
+// This is intended for asynchronous devices that can overlap independent
+// kernels, where it lets branchy networks keep several kernels running while
+// bounding the number of outstanding commands.
+//
+class WorkStealingScheduler final : public Scheduler {
+ public:
+  WorkStealingScheduler(const std::shared_ptr<Placer>& placer, std::size_t queue_count);
+
+  schedule::Schedule BuildSchedule(const tile::proto::Program& program, const lang::KernelList& kl) final;
+
+  const char* name() const final;
+
+ private:
+  std::shared_ptr<Placer> placer_;
+  std::size_t queue_count_;
+};
+
+// Assigns each of the schedule's steps to one of queue_count queues by
+// simulating work-stealing execution of its existing dependencies, then
+// reorders and reindexes the steps and serializes each queue.
+void AssignQueues(const lang::KernelList& kl, std::size_t queue_count, schedule::Schedule* schedule);
+
+}  // namespace local_machine
+}  // namespace tile
+}  // namespace vertexai
@@ -0,0 +1,63 @@
+// Copyright 2019, Intel Corp.
+
+#include <gmock/gmock.h>
+
+#include "tile/platform/local_machine/stealing_scheduler.h"
+
+#include <vector>
+
+#include "tile/platform/local_machine/block_placer.h"
+#include "tile/platform/local_machine/naive_placer.h"
+#include "tile/platform/local_machine/scheduler_test.h"
+
+using ::testing::Combine;
+using ::testing::Eq;
+using ::testing::Ne;
+using ::testing::Values;
+using ::testing::ValuesIn;
+
+namespace vertexai {
+namespace tile {
+namespace local_machine {
+namespace {
+
+INSTANTIATE_TEST_CASE_P(
+    WorkStealingScheduler, SchedulerTest,
+    Combine(Values(std::make_shared<WorkStealingScheduler>(std::make_shared<NaivePlacer>(std::kilo::num), 1),
+                   std::make_shared<WorkStealingScheduler>(std::make_shared<BlockPlacer>(std::kilo::num), 4)),
+            ValuesIn(SchedulerTest::GetTestPrograms())));
+
+schedule::Step* AddStep(schedule::Schedule* schedule, std::uint64_t cost, std::vector<schedule::Step*> deps) {
+  schedule->steps.emplace_back(schedule::Step::Tag::kCopy);
+  auto* step = &schedule->steps.back();
+  step->byte_count = cost;
+  step->deps.insert(deps.begin(), deps.end());
+  return step;
+}
+
+TEST(WorkStealingSchedulerTest, OverlapsIndependentBranches) {
+  // A diamond whose long branch is listed first, and whose short branch
+  // should be stolen by the second queue.
+  schedule::Schedule schedule;
+  auto* root = AddStep(&schedule, 10, {});
+  auto* long_branch = AddStep(&schedule, 1000, {root});
+  auto* short_branch = AddStep(&schedule, 10, {root});
+  auto* join = AddStep(&schedule, 10, {long_branch, short_branch});
+  schedule.Reindex();
+
+  AssignQueues(lang::KernelList{}, 2, &schedule);
+
+  EXPECT_THAT(short_branch->queue, Ne(long_branch->queue));
+  EXPECT_THAT(join->queue, Eq(long_branch->queue));
+  EXPECT_THAT(short_branch->deps.count(long_branch), Eq(0));
+  for (const auto& step : schedule.steps) {
+    for (const auto* dep : step.deps) {
+      EXPECT_LT(dep->idx, step.idx);
+    }
+  }
+}
+
+}  // namespace
+}  // namespace local_machine
+}  // namespace tile
+}  // namespace vertexai
@@ -3,8 +3,12 @@
 #include "tile/platform/local_machine/tmp_mem_strategy.h"
 
 #include <exception>
+#include <string>
 #include <utility>
 
+#include "base/util/env.h"
+#include "base/util/logging.h"
+
 namespace vertexai {
 namespace tile {
 namespace local_machine {
@@ -13,7 +17,8 @@ namespace {
 // A MemChunk implementation that frees its underlying memory to a MemCache when the chunk is deleted.
 class TmpMemChunk final : public MemChunk {
  public:
-  TmpMemChunk(std::uint64_t size, const std::shared_ptr<MemCache>& mem_cache, std::shared_ptr<hal::Buffer> hal_buffer);
+  TmpMemChunk(std::uint64_t size, const std::shared_ptr<MemCache>& mem_cache, std::shared_ptr<hal::Buffer> hal_buffer,
+              MemCharge charge);
   virtual ~TmpMemChunk();
 
   std::uint64_t size() const final;
@@ -27,13 +32,21 @@ class TmpMemChunk final : public MemChunk {
   std::shared_ptr<MemCache> mem_cache_;
   std::shared_ptr<hal::Buffer> hal_buffer_;
   std::shared_ptr<MemDeps> deps_;
+  MemCharge charge_;
 };
 
 TmpMemChunk::TmpMemChunk(std::uint64_t size, const std::shared_ptr<MemCache>& mem_cache,
-                         std::shared_ptr<hal::Buffer> hal_buffer)
-    : size_{size}, mem_cache_{mem_cache}, hal_buffer_{hal_buffer}, deps_{std::make_shared<MemDeps>()} {}
-
-TmpMemChunk::~TmpMemChunk() { mem_cache_->Free(size_, std::move(hal_buffer_)); }
+                         std::shared_ptr<hal::Buffer> hal_buffer, MemCharge charge)
+    : size_{size},
+      mem_cache_{mem_cache},
+      hal_buffer_{hal_buffer},
+      deps_{std::make_shared<MemDeps>()},
+      charge_{std::move(charge)} {}
+
+TmpMemChunk::~TmpMemChunk() {
+  charge_ = MemCharge{};
+  mem_cache_->Free(size_, std::move(hal_buffer_));
+}
 
 std::uint64_t TmpMemChunk::size() const { return size_; }
 
@@ -49,22 +62,72 @@ std::shared_ptr<MemDeps> TmpMemChunk::deps() { return deps_; }
 
 std::shared_ptr<hal::Buffer> TmpMemChunk::hal_buffer() { return hal_buffer_; }
 
+// By default, idle temporaries may occupy up to half of the device's memory;
+// PLAIDML_TMP_MEM_CACHE_MB overrides the limit.
+std::uint64_t MaxCachedBytes(hal::Memory* source) {
+  auto max_mb = env::Get("PLAIDML_TMP_MEM_CACHE_MB");
+  if (!max_mb.empty()) {
+    return std::stoull(max_mb) << 20;
+  }
+  return source->size_goal() / 2;
+}
+
+// Defragmentation of the cache is off unless PLAIDML_TMP_MEM_DEFRAG_THRESHOLD
+// sets the fraction of stale cached bytes which triggers it.
+double DefragThreshold() {
+  auto threshold = env::Get("PLAIDML_TMP_MEM_DEFRAG_THRESHOLD");
+  if (threshold.empty()) {
+    return 0;
+  }
+  return std::stod(threshold);
+}
+
 }  // namespace
 
-TmpMemStrategy::TmpMemStrategy(const std::shared_ptr<DevInfo>& devinfo, hal::Memory* source)
-    : devinfo_{devinfo}, source_{source}, cache_{std::make_shared<MemCache>()} {
+TmpMemStrategy::TmpMemStrategy(const std::shared_ptr<DevInfo>& devinfo, hal::Memory* source,
+                               const std::string& program_name, std::shared_ptr<MemCache> cache)
+    : devinfo_{devinfo},
+      source_{source},
+      cache_{std::move(cache)},
+      account_{MemOwner{devinfo->dev->description(), "tmp", program_name}} {
   if (!source_) {
     throw std::logic_error{"The temporary memory management strategy requires memory"};
   }
+  if (!cache_) {
+    cache_ = MakeCache(devinfo, source, program_name);
+  }
+}
+
+std::shared_ptr<MemCache> TmpMemStrategy::MakeCache(const std::shared_ptr<DevInfo>& devinfo, hal::Memory* source,
+                                                    const std::string& program_name) {
+  auto cache =
+      std::make_shared<MemCache>(MaxCachedBytes(source), MemOwner{devinfo->dev->description(), "cache", program_name});
+  auto defrag_threshold = DefragThreshold();
+  if (defrag_threshold > 0) {
+    cache->EnableDefrag(defrag_threshold);
+  }
+  return cache;
 }
 
 std::shared_ptr<MemChunk> TmpMemStrategy::MakeChunk(const context::Context& ctx, std::uint64_t size) const {
   auto hal_buffer = cache_->TryAlloc(size);
   if (!hal_buffer) {
-    auto buffer = source_->MakeBuffer(size, hal::BufferAccessMask::DEVICE_RW);
-    hal_buffer = buffer;
+    auto alloc_size = MemCache::SizeClass(size);
+    try {
+      hal_buffer = source_->MakeBuffer(alloc_size, hal::BufferAccessMask::DEVICE_RW);
+    } catch (const std::exception& ex) {
+      // The device may be out of memory because the cache is holding it; release
+      // everything and try once more.
+      auto released = cache_->Trim();
+      if (!released) {
+        throw;
+      }
+      IVLOG(1, "Temporary allocation of " << alloc_size << " bytes failed (" << ex.what() << "); released "
+                                          << released << " cached bytes and retrying");
+      hal_buffer = source_->MakeBuffer(alloc_size, hal::BufferAccessMask::DEVICE_RW);
+    }
   }
-  return std::make_shared<TmpMemChunk>(size, cache_, std::move(hal_buffer));
+  return std::make_shared<TmpMemChunk>(size, cache_, std::move(hal_buffer), account_.Charge(MemCache::SizeClass(size)));
 }
 
 }  // namespace local_machine
@@ -3,11 +3,13 @@
 #pragma once
 
 #include <memory>
+#include <string>
 
 #include "tile/base/hal.h"
 #include "tile/platform/local_machine/devinfo.h"
 #include "tile/platform/local_machine/mem_cache.h"
 #include "tile/platform/local_machine/mem_strategy.h"
+#include "tile/platform/local_machine/mem_usage.h"
 
 namespace vertexai {
 namespace tile {
@@ -19,9 +21,20 @@ namespace local_machine {
 //
 // Memory described by chunks may be reused when the chunk is deleted; callers must make sure to maintain chunk
 // references as long as the underlying memory is in use.
+//
+// Chunks are charged to the "tmp" account of the named program.  Freed chunks
+// return to a cache, which may be shared by all of the programs on a device:
+// temporaries are only held while a program runs, so programs which run at
+// different times reuse the same device memory.
 class TmpMemStrategy final : public MemStrategy {
  public:
-  TmpMemStrategy(const std::shared_ptr<DevInfo>& devinfo, hal::Memory* source);
+  TmpMemStrategy(const std::shared_ptr<DevInfo>& devinfo, hal::Memory* source, const std::string& program_name = "",
+                 std::shared_ptr<MemCache> cache = nullptr);
+
+  // Makes a cache of idle temporaries from the source, charged to the "cache"
+  // account of the named program (or of the device, if unnamed).
+  static std::shared_ptr<MemCache> MakeCache(const std::shared_ptr<DevInfo>& devinfo, hal::Memory* source,
+                                             const std::string& program_name = "");
 
   std::shared_ptr<MemChunk> MakeChunk(const context::Context& ctx, std::uint64_t size) const final;
 
@@ -29,6 +42,7 @@ class TmpMemStrategy final : public MemStrategy {
   std::shared_ptr<DevInfo> devinfo_;
   hal::Memory* source_ = nullptr;
   std::shared_ptr<MemCache> cache_;
+  MemAccount account_;
 };
 
 }  // namespace local_machine
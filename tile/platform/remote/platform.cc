@@ -0,0 +1,422 @@
+// Copyright 2020, Intel Corporation.
+
+#include "tile/platform/remote/platform.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "base/util/logging.h"
+#include "tile/platform/remote/transport.h"
+
+namespace vertexai {
+namespace tile {
+namespace remote {
+
+// The client end of a connection, shared by the platform and the buffers and programs it has made.
+class Client {
+ public:
+  Client(std::unique_ptr<Connection> conn, const Options& options)
+      : conn_{std::move(conn)}, options_{options}, flusher_{[this] { FlushLoop(); }} {}
+
+  // Sends the queued runs, then stops.
+  ~Client() {
+    {
+      std::lock_guard<std::mutex> lock{mu_};
+      stopping_ = true;
+    }
+    cv_.notify_all();
+    flusher_.join();
+  }
+
+  // Sends a request, after the queued runs, returning its response.
+  proto::Response Call(proto::Request* req) {
+    std::lock_guard<std::mutex> lock{mu_};
+    FlushRuns();
+    Send(req);
+    return Receive();
+  }
+
+  // Streams data, elements of plane_width bytes (or 0 if unknown), to a buffer.
+  void Write(std::uint64_t buffer, const char* data, std::uint64_t size, std::uint32_t plane_width) {
+    std::lock_guard<std::mutex> lock{mu_};
+    FlushRuns();
+    plane_width = options_.byte_planes ? plane_width : 0;
+    ForEachChunk(data, size, options_.compress, plane_width, [this, buffer](proto::Chunk* chunk) {
+      proto::Request req;
+      req.mutable_write_buffer()->set_buffer(buffer);
+      req.mutable_write_buffer()->mutable_chunk()->Swap(chunk);
+      Send(&req);
+    });
+    Receive();
+  }
+
+  // Streams a buffer's contents, elements of plane_width bytes (or 0 if unknown), into data.
+  void Read(std::uint64_t buffer, char* data, std::uint64_t size, std::uint32_t plane_width) {
+    std::lock_guard<std::mutex> lock{mu_};
+    FlushRuns();
+    proto::Request req;
+    req.mutable_read_buffer()->set_buffer(buffer);
+    req.mutable_read_buffer()->set_plane_width(options_.byte_planes ? plane_width : 0);
+    Send(&req);
+    for (;;) {
+      auto resp = Receive();
+      UnpackChunk(resp.chunk(), data, size);
+      if (resp.chunk().last()) {
+        return;
+      }
+    }
+  }
+
+  // Queues a run, returning a future which completes once the server has run it.
+  boost::future<void> Run(proto::Run run) {
+    std::lock_guard<std::mutex> lock{mu_};
+    if (runs_.empty()) {
+      first_queued_ = std::chrono::steady_clock::now();
+    }
+    runs_.emplace_back(QueuedRun{std::move(run), boost::promise<void>{}});
+    auto future = runs_.back().done.get_future();
+    if (runs_.size() >= options_.max_batch_runs) {
+      FlushRuns();
+    } else {
+      cv_.notify_one();
+    }
+    return future;
+  }
+
+  // Releases are sent with the next request.  They take their own lock, since completing a run may drop buffers.
+  void ReleaseBuffer(std::uint64_t id) {
+    std::lock_guard<std::mutex> lock{release_mu_};
+    released_buffers_.push_back(id);
+  }
+
+  void ReleaseProgram(std::uint64_t id) {
+    std::lock_guard<std::mutex> lock{release_mu_};
+    released_programs_.push_back(id);
+  }
+
+ private:
+  struct QueuedRun {
+    proto::Run run;
+    boost::promise<void> done;
+  };
+
+  // Requires mu_.
+  void Send(proto::Request* req) {
+    {
+      std::lock_guard<std::mutex> lock{release_mu_};
+      for (auto id : released_buffers_) {
+        req->add_released_buffers(id);
+      }
+      for (auto id : released_programs_) {
+        req->add_released_programs(id);
+      }
+      released_buffers_.clear();
+      released_programs_.clear();
+    }
+    conn_->Send(*req);
+  }
+
+  // Requires mu_.
+  proto::Response Receive() {
+    proto::Response resp;
+    if (!conn_->Receive(&resp)) {
+      throw std::runtime_error("The remote platform closed its connection");
+    }
+    if (!resp.error().empty()) {
+      throw std::runtime_error(resp.error());
+    }
+    return resp;
+  }
+
+  // Sends the queued runs as one batch, completing their futures.  Requires mu_.
+  void FlushRuns() {
+    if (runs_.empty()) {
+      return;
+    }
+    auto runs = std::move(runs_);
+    runs_.clear();
+    proto::Request req;
+    for (auto& run : runs) {
+      req.mutable_run_batch()->add_runs()->Swap(&run.run);
+    }
+    try {
+      Send(&req);
+      auto resp = Receive();
+      const auto& errors = resp.run_batch().errors();
+      for (int idx = 0; idx < static_cast<int>(runs.size()); idx++) {
+        if (idx >= errors.size()) {
+          runs[idx].done.set_exception(std::runtime_error("The remote platform did not report a run's result"));
+        } else if (!errors[idx].empty()) {
+          runs[idx].done.set_exception(std::runtime_error(errors[idx]));
+        } else {
+          runs[idx].done.set_value();
+        }
+      }
+    } catch (...) {
+      for (auto& run : runs) {
+        run.done.set_exception(std::current_exception());
+      }
+    }
+  }
+
+  // Sends queued runs once the first has waited batch_delay for others to join it.
+  void FlushLoop() {
+    std::unique_lock<std::mutex> lock{mu_};
+    for (;;) {
+      cv_.wait(lock, [this] { return stopping_ || !runs_.empty(); });
+      if (runs_.empty()) {
+        return;
+      }
+      auto deadline = first_queued_ + options_.batch_delay;
+      if (!stopping_ && std::chrono::steady_clock::now() < deadline) {
+        cv_.wait_until(lock, deadline);
+        continue;
+      }
+      FlushRuns();
+    }
+  }
+
+  std::unique_ptr<Connection> conn_;
+  Options options_;
+  std::mutex mu_;
+  std::condition_variable cv_;
+  bool stopping_ = false;
+  std::vector<QueuedRun> runs_;
+  std::chrono::steady_clock::time_point first_queued_;
+  std::mutex release_mu_;
+  std::vector<std::uint64_t> released_buffers_;
+  std::vector<std::uint64_t> released_programs_;
+  std::thread flusher_;
+};
+
+namespace {
+
+class RemoteView final : public View {
+ public:
+  RemoteView(std::shared_ptr<Client> client, std::uint64_t id, std::uint64_t size, std::uint32_t plane_width)
+      : client_{std::move(client)}, id_{id}, plane_width_{plane_width}, storage_(size) {
+    set_contents(storage_.data(), storage_.size());
+  }
+
+  void WriteBack(const context::Context& ctx) final { client_->Write(id_, data(), size(), plane_width_); }
+
+ private:
+  std::shared_ptr<Client> client_;
+  std::uint64_t id_;
+  std::uint32_t plane_width_;
+  std::vector<char> storage_;
+};
+
+class RemoteBuffer final : public Buffer {
+ public:
+  RemoteBuffer(std::shared_ptr<Client> client, std::uint64_t id, std::uint64_t size)
+      : client_{std::move(client)}, id_{id}, size_{size} {}
+
+  ~RemoteBuffer() { client_->ReleaseBuffer(id_); }
+
+  std::uint64_t size() const final { return size_; }
+
+  boost::future<std::unique_ptr<View>> MapCurrent(const context::Context& ctx) final {
+    auto view = std::make_unique<RemoteView>(client_, id_, size_, plane_width_);
+    client_->Read(id_, view->data(), size_, plane_width_);
+    return boost::make_ready_future(std::unique_ptr<View>(std::move(view)));
+  }
+
+  std::unique_ptr<View> MapDiscard(const context::Context& ctx) final {
+    return std::make_unique<RemoteView>(client_, id_, size_, plane_width_);
+  }
+
+  std::uint64_t id() const { return id_; }
+
+  // Records the width of the buffer's elements, as shown by the program it's bound to.
+  void set_plane_width(std::uint32_t plane_width) { plane_width_ = plane_width; }
+
+ private:
+  std::shared_ptr<Client> client_;
+  std::uint64_t id_;
+  std::uint64_t size_;
+  std::atomic<std::uint32_t> plane_width_{0};
+};
+
+// The widths of a program's input and output elements, by name.
+using PlaneWidths = std::map<std::string, std::uint32_t>;
+
+class RemoteProgram final : public Program {
+ public:
+  RemoteProgram(std::shared_ptr<Client> client, const proto::MakeProgramResponse& resp, PlaneWidths plane_widths)
+      : client_{std::move(client)},
+        id_{resp.program()},
+        plane_widths_{std::move(plane_widths)},
+        max_available_memory_{resp.max_available_memory()},
+        memory_footprint_{resp.memory_footprint()} {}
+
+  ~RemoteProgram() { client_->ReleaseProgram(id_); }
+
+  boost::future<void> Run(const context::Context& ctx, std::map<std::string, std::shared_ptr<Buffer>> inputs,
+                          std::map<std::string, std::shared_ptr<Buffer>> outputs) final {
+    proto::Run run;
+    run.set_program(id_);
+    for (const auto& kvp : inputs) {
+      (*run.mutable_inputs())[kvp.first] = RemoteId(kvp.first, kvp.second);
+    }
+    for (const auto& kvp : outputs) {
+      (*run.mutable_outputs())[kvp.first] = RemoteId(kvp.first, kvp.second);
+    }
+    return client_->Run(std::move(run));
+  }
+
+  std::size_t MaxAvailableMemory() final { return max_available_memory_; }
+
+  void Release() final {}
+
+  std::uint64_t MemoryFootprint() const final { return memory_footprint_; }
+
+ private:
+  std::uint64_t RemoteId(const std::string& name, const std::shared_ptr<Buffer>& buffer) const {
+    auto remote = std::dynamic_pointer_cast<RemoteBuffer>(buffer);
+    if (!remote) {
+      throw std::runtime_error("Remote programs can only run on buffers made by the remote platform");
+    }
+    auto it = plane_widths_.find(name);
+    if (it != plane_widths_.end()) {
+      remote->set_plane_width(it->second);
+    }
+    return remote->id();
+  }
+
+  std::shared_ptr<Client> client_;
+  std::uint64_t id_;
+  PlaneWidths plane_widths_;
+  std::size_t max_available_memory_;
+  std::uint64_t memory_footprint_;
+};
+
+std::shared_ptr<RemoteBuffer> MakeRemoteBuffer(const std::shared_ptr<Client>& client, const std::string& device,
+                                               std::uint64_t size) {
+  proto::Request req;
+  req.mutable_make_buffer()->set_device(device);
+  req.mutable_make_buffer()->set_size(size);
+  auto resp = client->Call(&req);
+  return std::make_shared<RemoteBuffer>(client, resp.buffer(), size);
+}
+
+// Compiles a program on the server.  Constant buffers are uploaded first if they were made elsewhere, and the
+// buffer manager is updated with any the compilation replaced or added.
+std::shared_ptr<Program> MakeRemoteProgram(const context::Context& ctx, const std::shared_ptr<Client>& client,
+                                           proto::Request* req, ConstBufferManager* const_bufs,
+                                           PlaneWidths plane_widths) {
+  auto make = req->mutable_make_program();
+  if (const_bufs) {
+    for (auto& kvp : const_bufs->buffers) {
+      auto remote = std::dynamic_pointer_cast<RemoteBuffer>(kvp.second);
+      if (!remote) {
+        auto view = kvp.second->MapCurrent(ctx).get();
+        remote = MakeRemoteBuffer(client, make->device(), view->size());
+        client->Write(remote->id(), view->data(), view->size(), 0);
+        kvp.second = remote;
+      }
+      auto& const_buf = (*make->mutable_const_buffers())[kvp.first];
+      const_buf.set_buffer(remote->id());
+      const_buf.set_size(remote->size());
+    }
+  }
+  auto resp = client->Call(req);
+  const auto& made = resp.make_program();
+  if (const_bufs) {
+    for (const auto& kvp : made.const_buffers()) {
+      auto it = const_bufs->buffers.find(kvp.first);
+      auto remote = it == const_bufs->buffers.end() ? nullptr : std::dynamic_pointer_cast<RemoteBuffer>(it->second);
+      if (!remote || remote->id() != kvp.second.buffer()) {
+        const_bufs->buffers[kvp.first] = std::make_shared<RemoteBuffer>(client, kvp.second.buffer(), kvp.second.size());
+      }
+    }
+  }
+  return std::make_shared<RemoteProgram>(client, made, std::move(plane_widths));
+}
+
+}  // namespace
+
+Platform::Platform(const std::string& host, const std::string& port, const Options& options)
+    : client_{std::make_shared<Client>(Connection::Connect(host, port), options)} {}
+
+std::unique_ptr<Platform> Platform::Connect(const std::string& address) {
+  auto colon = address.rfind(':');
+  if (colon == std::string::npos || colon == 0 || colon + 1 == address.size()) {
+    throw std::invalid_argument("A remote platform address must be host:port, not \"" + address + "\"");
+  }
+  LOG(INFO) << "Connecting to remote platform at " << address;
+  return std::make_unique<Platform>(address.substr(0, colon), address.substr(colon + 1));
+}
+
+std::vector<std::string> Platform::ListDevices() {
+  proto::Request req;
+  req.mutable_list_devices();
+  auto resp = client_->Call(&req);
+  const auto& devices = resp.list_devices().devices();
+  return std::vector<std::string>(devices.begin(), devices.end());
+}
+
+std::shared_ptr<tile::Buffer> Platform::MakeBuffer(const context::Context& ctx, const std::string& device,
+                                                   std::uint64_t size) {
+  return MakeRemoteBuffer(client_, device, size);
+}
+
+std::shared_ptr<tile::Buffer> Platform::WrapBuffer(const context::Context& ctx, const std::string& device, void* base,
+                                                   std::uint64_t size) {
+  return nullptr;
+}
+
+std::shared_ptr<tile::Program> Platform::MakeProgram(const context::Context& ctx, const tile::proto::Program& program,
+                                                     ConstBufferManager* const_bufs) {
+  proto::Request req;
+  req.mutable_make_program()->set_device(program.dev_id());
+  *req.mutable_make_program()->mutable_legacy() = program;
+  PlaneWidths plane_widths;
+  for (const auto& kvp : program.inputs()) {
+    plane_widths[kvp.first] = byte_width(tile::FromProto(kvp.second.shape().type()));
+  }
+  for (const auto& kvp : program.outputs()) {
+    plane_widths[kvp.first] = byte_width(tile::FromProto(kvp.second.shape().type()));
+  }
+  return MakeRemoteProgram(ctx, client_, &req, const_bufs, std::move(plane_widths));
+}
+
+std::shared_ptr<tile::Program> Platform::MakeProgram(const context::Context& ctx, const std::string& device,
+                                                     const std::string& target,
+                                                     const std::shared_ptr<stripe::Program>& program,
+                                                     ConstBufferManager* const_bufs) {
+  proto::Request req;
+  auto make = req.mutable_make_program();
+  make->set_device(device);
+  make->set_target(target);
+  *make->mutable_stripe() = stripe::IntoProto(*program);
+  PlaneWidths plane_widths;
+  for (const auto& kvp : program->input_shapes) {
+    (*make->mutable_input_shapes())[kvp.first] = tile::IntoProto(kvp.second);
+    plane_widths[kvp.first] = byte_width(kvp.second.type);
+  }
+  for (const auto& kvp : program->output_shapes) {
+    (*make->mutable_output_shapes())[kvp.first] = tile::IntoProto(kvp.second);
+    plane_widths[kvp.first] = byte_width(kvp.second.type);
+  }
+  return MakeRemoteProgram(ctx, client_, &req, const_bufs, std::move(plane_widths));
+}
+
+void Platform::ListDevices(const context::Context& ctx, const tile::proto::ListDevicesRequest& request,
+                           tile::proto::ListDevicesResponse* response) {
+  proto::Request req;
+  *req.mutable_list_devices()->mutable_legacy() = request;
+  auto resp = client_->Call(&req);
+  *response = resp.list_devices().legacy();
+}
+
+}  // namespace remote
+}  // namespace tile
+}  // namespace vertexai
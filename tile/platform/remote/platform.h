@@ -0,0 +1,85 @@
+// Copyright 2020, Intel Corporation.
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tile/base/platform.h"
+
+namespace vertexai {
+namespace tile {
+namespace remote {
+
+class Client;
+
+struct Options {
+  // Whether buffer contents are compressed in transit.
+  bool compress = true;
+  // Whether the compressed contents of a buffer which has been bound to a program's input or output are split into
+  // byte planes by the width of that tensor's elements, which makes activations compress several times better.
+  bool byte_planes = true;
+  // How long a run may wait for others to share its round trip.
+  std::chrono::microseconds batch_delay{500};
+  // The most runs sent in one round trip.
+  std::size_t max_batch_runs = 64;
+};
+
+// Platform implements tile::Platform by forwarding buffers and programs to a remote::Server, so that a thin client can
+// run programs on another host's devices without linking their drivers.
+//
+// Buffer contents are streamed in compressed chunks, split into byte planes once a program has shown the width of a
+// buffer's elements.  Runs are queued and sent in batches, so that a stream of small
+// runs costs one round trip per batch; any other request (such as mapping a buffer) first sends the queued runs, so it
+// observes their results.
+class Platform final : public tile::Platform {
+ public:
+  // Connects to the server at host:port.
+  Platform(const std::string& host, const std::string& port, const Options& options = Options{});
+
+  // Parses "host:port", as given by PLAIDML_REMOTE.
+  static std::unique_ptr<Platform> Connect(const std::string& address);
+
+  std::vector<std::string> ListDevices() final;
+
+  std::shared_ptr<tile::Buffer> MakeBuffer(  //
+      const context::Context& ctx,           //
+      const std::string& device,             //
+      std::uint64_t size) final;
+
+  // Host memory cannot be shared with a remote device, so this always returns nullptr.
+  std::shared_ptr<tile::Buffer> WrapBuffer(  //
+      const context::Context& ctx,           //
+      const std::string& device,             //
+      void* base,                            //
+      std::uint64_t size) final;
+
+  std::shared_ptr<tile::Program> MakeProgram(  //
+      const context::Context& ctx,             //
+      const tile::proto::Program& program,     //
+      ConstBufferManager* const_bufs) final;
+
+  std::shared_ptr<tile::Program> MakeProgram(           //
+      const context::Context& ctx,                      //
+      const std::string& device,                        //
+      const std::string& target,                        //
+      const std::shared_ptr<stripe::Program>& program,  //
+      ConstBufferManager* const_bufs) final;
+
+  void ListDevices(                                    //
+      const context::Context& ctx,                     //
+      const tile::proto::ListDevicesRequest& request,  //
+      tile::proto::ListDevicesResponse* response) final;
+
+  // Cost models are functions of the client process, so the server's are used.
+  void RegisterCostModel(const lang::TileCostFunction& cost_fn) final {}
+
+ private:
+  std::shared_ptr<Client> client_;
+};
+
+}  // namespace remote
+}  // namespace tile
+}  // namespace vertexai
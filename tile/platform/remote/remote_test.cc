@@ -0,0 +1,229 @@
+// Copyright 2020, Intel Corporation.
+
+#include <gmock/gmock.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tile/platform/remote/platform.h"
+#include "tile/platform/remote/server.h"
+#include "tile/platform/remote/transport.h"
+
+using ::testing::ElementsAre;
+using ::testing::Eq;
+
+namespace vertexai {
+namespace tile {
+namespace remote {
+namespace {
+
+// Adds the constant buffer "C" (if any) to twice the input "X", writing "Y".
+class FakeProgram final : public tile::Program {
+ public:
+  explicit FakeProgram(std::shared_ptr<Buffer> constant) : constant_{std::move(constant)} {}
+
+  boost::future<void> Run(const context::Context& ctx, std::map<std::string, std::shared_ptr<Buffer>> inputs,
+                          std::map<std::string, std::shared_ptr<Buffer>> outputs) final {
+    float x;
+    float c = 0;
+    std::memcpy(&x, inputs.at("X")->MapCurrent(ctx).get()->data(), sizeof(float));
+    if (constant_) {
+      std::memcpy(&c, constant_->MapCurrent(ctx).get()->data(), sizeof(float));
+    }
+    auto y = 2 * x + c;
+    auto view = outputs.at("Y")->MapDiscard(ctx);
+    std::memcpy(view->data(), &y, sizeof(float));
+    view->WriteBack(ctx);
+    return boost::make_ready_future();
+  }
+  std::size_t MaxAvailableMemory() final { return 1 << 20; }
+  void Release() final {}
+
+ private:
+  std::shared_ptr<Buffer> constant_;
+};
+
+class FakePlatform final : public tile::Platform {
+ public:
+  std::shared_ptr<Buffer> MakeBuffer(const context::Context& ctx, const std::string& device,
+                                     std::uint64_t size) final {
+    return std::make_shared<SimpleBuffer>(size);
+  }
+  std::shared_ptr<Buffer> WrapBuffer(const context::Context& ctx, const std::string& device, void* base,
+                                     std::uint64_t size) final {
+    return nullptr;
+  }
+  std::shared_ptr<tile::Program> MakeProgram(const context::Context& ctx, const tile::proto::Program& program,
+                                             ConstBufferManager* const_bufs) final {
+    auto it = const_bufs->buffers.find("C");
+    return std::make_shared<FakeProgram>(it == const_bufs->buffers.end() ? nullptr : it->second);
+  }
+  std::shared_ptr<tile::Program> MakeProgram(const context::Context& ctx, const std::string& device,
+                                             const std::string& target,
+                                             const std::shared_ptr<stripe::Program>& program,
+                                             ConstBufferManager* const_bufs) final {
+    throw std::runtime_error("Unsupported");
+  }
+  void ListDevices(const context::Context& ctx, const tile::proto::ListDevicesRequest& request,
+                   tile::proto::ListDevicesResponse* response) final {}
+  void RegisterCostModel(const lang::TileCostFunction& cost_fn) final {}
+  std::vector<std::string> ListDevices() final { return {"fake.0", "fake.1"}; }
+};
+
+void WriteFloats(const std::shared_ptr<Buffer>& buffer, const std::vector<float>& values) {
+  auto view = buffer->MapDiscard(context::Context{});
+  std::memcpy(view->data(), values.data(), values.size() * sizeof(float));
+  view->WriteBack(context::Context{});
+}
+
+std::vector<float> ReadFloats(const std::shared_ptr<Buffer>& buffer) {
+  auto view = buffer->MapCurrent(context::Context{}).get();
+  std::vector<float> values(view->size() / sizeof(float));
+  std::memcpy(values.data(), view->data(), view->size());
+  return values;
+}
+
+class RemotePlatformTest : public ::testing::Test {
+ protected:
+  RemotePlatformTest()
+      : server_{std::make_shared<FakePlatform>(), 0},
+        serving_{[this] { server_.Serve(); }},
+        platform_{"127.0.0.1", std::to_string(server_.port())} {}
+
+  ~RemotePlatformTest() {
+    server_.Stop();
+    serving_.join();
+  }
+
+  Server server_;
+  std::thread serving_;
+  Platform platform_;
+};
+
+TEST_F(RemotePlatformTest, ListsDevices) {
+  EXPECT_THAT(platform_.ListDevices(), ElementsAre("fake.0", "fake.1"));
+}
+
+TEST_F(RemotePlatformTest, StreamsLargeBuffers) {
+  // Spans several chunks, mixing compressible and incompressible data.
+  std::vector<float> values(1 << 20);
+  for (std::size_t idx = 0; idx < values.size(); idx++) {
+    values[idx] = idx < values.size() / 2 ? 1.0f : static_cast<float>(idx * 2654435761u);
+  }
+  auto buffer = platform_.MakeBuffer(context::Context{}, "fake.0", values.size() * sizeof(float));
+  WriteFloats(buffer, values);
+  EXPECT_THAT(ReadFloats(buffer), Eq(values));
+}
+
+TEST_F(RemotePlatformTest, BatchesRuns) {
+  auto c = std::make_shared<SimpleBuffer>(sizeof(float));
+  WriteFloats(c, {100});
+  ConstBufferManager const_bufs{nullptr, {{"C", c}}};
+  tile::proto::Program source;
+  source.set_dev_id("fake.0");
+  auto program = platform_.MakeProgram(context::Context{}, source, &const_bufs);
+  EXPECT_THAT(ReadFloats(const_bufs.buffers.at("C")), ElementsAre(100));
+  EXPECT_THAT(program->MaxAvailableMemory(), Eq(1 << 20));
+
+  std::vector<std::shared_ptr<Buffer>> xs;
+  std::vector<std::shared_ptr<Buffer>> ys;
+  std::vector<boost::future<void>> runs;
+  for (int idx = 0; idx < 10; idx++) {
+    xs.push_back(platform_.MakeBuffer(context::Context{}, "fake.0", sizeof(float)));
+    ys.push_back(platform_.MakeBuffer(context::Context{}, "fake.0", sizeof(float)));
+    WriteFloats(xs.back(), {static_cast<float>(idx)});
+  }
+  for (int idx = 0; idx < 10; idx++) {
+    runs.push_back(program->Run(context::Context{}, {{"X", xs[idx]}}, {{"Y", ys[idx]}}));
+  }
+  for (int idx = 0; idx < 10; idx++) {
+    EXPECT_THAT(ReadFloats(ys[idx]), ElementsAre(100 + 2 * idx));
+  }
+  for (auto& run : runs) {
+    run.get();
+  }
+}
+
+TEST_F(RemotePlatformTest, ReportsRunErrors) {
+  tile::proto::Program source;
+  ConstBufferManager const_bufs;
+  auto program = platform_.MakeProgram(context::Context{}, source, &const_bufs);
+  auto y = platform_.MakeBuffer(context::Context{}, "fake.0", sizeof(float));
+  EXPECT_THROW(program->Run(context::Context{}, {}, {{"Y", y}}).get(), std::runtime_error);
+  EXPECT_THROW(program->Run(context::Context{}, {{"X", std::make_shared<SimpleBuffer>(4)}}, {{"Y", y}}),
+               std::runtime_error);
+}
+
+TEST_F(RemotePlatformTest, ListensOnLoopbackByDefault) { EXPECT_TRUE(server_.address().is_loopback()); }
+
+TEST_F(RemotePlatformTest, ReapsFinishedSessions) {
+  platform_.ListDevices();  // Ensures the fixture's own session has started
+  EXPECT_THAT(server_.active_sessions(), Eq(1));
+  for (int idx = 0; idx < 3; idx++) {
+    Platform client{"127.0.0.1", std::to_string(server_.port())};
+    EXPECT_THAT(client.ListDevices(), ElementsAre("fake.0", "fake.1"));
+  }
+  // The clients' sessions finish once they notice their disconnects.
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (server_.active_sessions() > 1 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_THAT(server_.active_sessions(), Eq(1));
+}
+
+TEST(RemoteServerTest, StopDisconnectsIdleClients) {
+  Server server{std::make_shared<FakePlatform>(), 0};
+  std::thread serving{[&server] { server.Serve(); }};
+  auto client = Connection::Connect("127.0.0.1", std::to_string(server.port()));
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (server.active_sessions() < 1 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  ASSERT_THAT(server.active_sessions(), Eq(1));
+
+  // The client never sends anything, so only Stop can end its session.
+  server.Stop();
+  serving.join();
+  while (server.active_sessions() > 0 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_THAT(server.active_sessions(), Eq(0));
+  proto::Response resp;
+  EXPECT_FALSE(client->Receive(&resp));
+}
+
+TEST(RemoteTransportTest, SplitsBytePlanes) {
+  // A smoothly varying activation, whose elements' high bytes are nearly constant.
+  std::vector<float> values(kChunkSize / sizeof(float) + 100);
+  for (std::size_t idx = 0; idx < values.size(); idx++) {
+    values[idx] = std::sin(idx * 0.001f);
+  }
+  auto data = reinterpret_cast<const char*>(values.data());
+  auto size = values.size() * sizeof(float);
+  auto transfer = [&](std::uint32_t plane_width, std::vector<float>* out) {
+    std::size_t sent = 0;
+    ForEachChunk(data, size, true, plane_width, [&](proto::Chunk* chunk) {
+      sent += chunk->data().size();
+      UnpackChunk(*chunk, reinterpret_cast<char*>(out->data()), size);
+    });
+    return sent;
+  };
+  std::vector<float> plain(values.size());
+  std::vector<float> planes(values.size());
+  auto plain_bytes = transfer(0, &plain);
+  auto plane_bytes = transfer(sizeof(float), &planes);
+  EXPECT_THAT(plain, Eq(values));
+  EXPECT_THAT(planes, Eq(values));
+  EXPECT_LT(plane_bytes, plain_bytes);
+}
+
+}  // namespace
+}  // namespace remote
+}  // namespace tile
+}  // namespace vertexai
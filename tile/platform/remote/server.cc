@@ -0,0 +1,322 @@
+// Copyright 2020, Intel Corporation.
+
+#include "tile/platform/remote/server.h"
+
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+#include "base/util/logging.h"
+#include "tile/platform/remote/transport.h"
+
+namespace vertexai {
+namespace tile {
+namespace remote {
+
+namespace {
+
+class DeviceAllocator final : public Allocator {
+ public:
+  DeviceAllocator(tile::Platform* platform, std::string device) : platform_{platform}, device_{std::move(device)} {}
+
+  BufferPtr allocate(size_t size) final { return platform_->MakeBuffer(context::Context{}, device_, size); }
+
+  std::string device_key() const final {
+    return std::to_string(reinterpret_cast<std::uintptr_t>(platform_)) + "/" + device_;
+  }
+
+ private:
+  tile::Platform* platform_;
+  std::string device_;
+};
+
+// Serves one client connection.
+class Session {
+ public:
+  Session(tile::Platform* platform, Connection* conn) : platform_{platform}, conn_{conn} {}
+
+  void Serve() {
+    proto::Request req;
+    while (conn_->Receive(&req)) {
+      proto::Response resp;
+      bool respond = true;
+      try {
+        respond = Handle(req, &resp);
+      } catch (const std::exception& ex) {
+        resp.Clear();
+        resp.set_error(ex.what());
+      }
+      // Releases follow the request, whose runs may still use the released buffers.
+      for (auto id : req.released_buffers()) {
+        buffers_.erase(id);
+      }
+      for (auto id : req.released_programs()) {
+        programs_.erase(id);
+      }
+      if (respond) {
+        conn_->Send(resp);
+      }
+    }
+  }
+
+ private:
+  // Handles a request, returning whether its response remains to be sent.
+  bool Handle(const proto::Request& req, proto::Response* resp) {
+    switch (req.kind_case()) {
+      case proto::Request::kListDevices:
+        ListDevices(req.list_devices(), resp->mutable_list_devices());
+        return true;
+      case proto::Request::kMakeBuffer: {
+        const auto& make = req.make_buffer();
+        resp->set_buffer(AddBuffer(platform_->MakeBuffer(ctx_, make.device(), make.size())));
+        return true;
+      }
+      case proto::Request::kWriteBuffer:
+        return WriteBuffer(req.write_buffer(), resp);
+      case proto::Request::kReadBuffer:
+        return ReadBuffer(req.read_buffer(), resp);
+      case proto::Request::kMakeProgram:
+        MakeProgram(req.make_program(), resp->mutable_make_program());
+        return true;
+      case proto::Request::kRunBatch:
+        RunBatch(req.run_batch(), resp->mutable_run_batch());
+        return true;
+      default:
+        return true;  // Carries only releases.
+    }
+  }
+
+  void ListDevices(const proto::ListDevicesRequest& req, proto::ListDevicesResponse* resp) {
+    if (req.has_legacy()) {
+      platform_->ListDevices(ctx_, req.legacy(), resp->mutable_legacy());
+      return;
+    }
+    for (const auto& device : platform_->ListDevices()) {
+      resp->add_devices(device);
+    }
+  }
+
+  // Applies one chunk of a streamed write; the write is answered once its last chunk arrives.
+  bool WriteBuffer(const proto::WriteBufferRequest& req, proto::Response* resp) {
+    auto& pending = writes_[req.buffer()];
+    if (!pending.view && pending.error.empty()) {
+      try {
+        pending.view = GetBuffer(req.buffer())->MapDiscard(ctx_);
+      } catch (const std::exception& ex) {
+        pending.error = ex.what();
+      }
+    }
+    if (pending.error.empty()) {
+      try {
+        UnpackChunk(req.chunk(), pending.view->data(), pending.view->size());
+      } catch (const std::exception& ex) {
+        pending.error = ex.what();
+      }
+    }
+    if (!req.chunk().last()) {
+      return false;
+    }
+    auto view = std::move(pending.view);
+    auto error = std::move(pending.error);
+    writes_.erase(req.buffer());
+    if (!error.empty()) {
+      throw std::runtime_error(error);
+    }
+    view->WriteBack(ctx_);
+    return true;
+  }
+
+  // Streams a buffer's contents back as chunks.
+  bool ReadBuffer(const proto::ReadBufferRequest& req, proto::Response* resp) {
+    auto view = GetBuffer(req.buffer())->MapCurrent(ctx_).get();
+    ForEachChunk(view->data(), view->size(), true, req.plane_width(), [this](proto::Chunk* chunk) {
+      proto::Response part;
+      part.mutable_chunk()->Swap(chunk);
+      conn_->Send(part);
+    });
+    return false;
+  }
+
+  void MakeProgram(const proto::MakeProgramRequest& req, proto::MakeProgramResponse* resp) {
+    ConstBufferManager const_bufs;
+    const_bufs.allocator = std::make_shared<DeviceAllocator>(platform_, req.device());
+    for (const auto& kvp : req.const_buffers()) {
+      const_bufs.buffers[kvp.first] = GetBuffer(kvp.second.buffer());
+    }
+    std::shared_ptr<tile::Program> program;
+    if (req.has_legacy()) {
+      program = platform_->MakeProgram(ctx_, req.legacy(), &const_bufs);
+    } else {
+      auto stripe = stripe::FromProto(req.stripe());
+      for (const auto& kvp : req.input_shapes()) {
+        stripe->input_shapes[kvp.first] = tile::FromProto(kvp.second);
+      }
+      for (const auto& kvp : req.output_shapes()) {
+        stripe->output_shapes[kvp.first] = tile::FromProto(kvp.second);
+      }
+      program = platform_->MakeProgram(ctx_, req.device(), req.target(), stripe, &const_bufs);
+    }
+    // Compilation may have replaced or added constant buffers; the client learns their ids.
+    for (const auto& kvp : const_bufs.buffers) {
+      auto it = req.const_buffers().find(kvp.first);
+      std::uint64_t id;
+      if (it != req.const_buffers().end() && GetBuffer(it->second.buffer()) == kvp.second) {
+        id = it->second.buffer();
+      } else {
+        id = AddBuffer(kvp.second);
+      }
+      auto& const_buf = (*resp->mutable_const_buffers())[kvp.first];
+      const_buf.set_buffer(id);
+      const_buf.set_size(kvp.second->size());
+    }
+    resp->set_max_available_memory(program->MaxAvailableMemory());
+    resp->set_memory_footprint(program->MemoryFootprint());
+    auto id = next_id_++;
+    programs_[id] = std::move(program);
+    resp->set_program(id);
+  }
+
+  // Starts every run of the batch, then waits for them all, so that the client's next request observes their results.
+  void RunBatch(const proto::RunBatchRequest& req, proto::RunBatchResponse* resp) {
+    std::vector<boost::future<void>> runs;
+    for (const auto& run : req.runs()) {
+      try {
+        auto it = programs_.find(run.program());
+        if (it == programs_.end()) {
+          throw std::runtime_error("Unknown remote program");
+        }
+        std::map<std::string, std::shared_ptr<Buffer>> inputs;
+        std::map<std::string, std::shared_ptr<Buffer>> outputs;
+        for (const auto& kvp : run.inputs()) {
+          inputs[kvp.first] = GetBuffer(kvp.second);
+        }
+        for (const auto& kvp : run.outputs()) {
+          outputs[kvp.first] = GetBuffer(kvp.second);
+        }
+        runs.emplace_back(it->second->Run(ctx_, std::move(inputs), std::move(outputs)));
+      } catch (...) {
+        runs.emplace_back(boost::make_exceptional_future<void>(std::current_exception()));
+      }
+    }
+    for (auto& run : runs) {
+      auto error = resp->add_errors();
+      try {
+        run.get();
+      } catch (const std::exception& ex) {
+        *error = ex.what();
+      } catch (...) {
+        *error = "Remote run failed";
+      }
+    }
+  }
+
+  std::uint64_t AddBuffer(std::shared_ptr<Buffer> buffer) {
+    auto id = next_id_++;
+    buffers_[id] = std::move(buffer);
+    return id;
+  }
+
+  const std::shared_ptr<Buffer>& GetBuffer(std::uint64_t id) {
+    auto it = buffers_.find(id);
+    if (it == buffers_.end()) {
+      throw std::runtime_error("Unknown remote buffer");
+    }
+    return it->second;
+  }
+
+  struct PendingWrite {
+    std::unique_ptr<View> view;
+    std::string error;
+  };
+
+  tile::Platform* platform_;
+  Connection* conn_;
+  context::Context ctx_;
+  std::uint64_t next_id_ = 1;
+  std::unordered_map<std::uint64_t, std::shared_ptr<Buffer>> buffers_;
+  std::unordered_map<std::uint64_t, std::shared_ptr<tile::Program>> programs_;
+  std::unordered_map<std::uint64_t, PendingWrite> writes_;
+};
+
+}  // namespace
+
+Server::Server(std::shared_ptr<tile::Platform> platform, unsigned short port, const std::string& address)
+    : platform_{std::move(platform)},
+      io_{std::make_shared<boost::asio::io_context>()},
+      acceptor_{*io_, boost::asio::ip::tcp::endpoint{boost::asio::ip::make_address(address), port}} {
+  port_ = acceptor_.local_endpoint().port();
+  wake_address_ = acceptor_.local_endpoint().address();
+  if (wake_address_.is_unspecified()) {
+    wake_address_ = wake_address_.is_v6() ? boost::asio::ip::address{boost::asio::ip::address_v6::loopback()}
+                                          : boost::asio::ip::address{boost::asio::ip::address_v4::loopback()};
+  }
+}
+
+Server::~Server() {
+  Stop();
+  std::unique_lock<std::mutex> lock{mu_};
+  sessions_done_.wait(lock, [this] { return sessions_ == 0; });
+}
+
+void Server::Serve() {
+  while (!stopping_) {
+    boost::asio::ip::tcp::socket socket{*io_};
+    acceptor_.accept(socket);
+    auto conn = std::make_unique<Connection>(io_, std::move(socket));
+    {
+      // Checked under the lock, so that Stop either sees this connection or keeps it from starting.
+      std::lock_guard<std::mutex> lock{mu_};
+      if (stopping_) {
+        break;
+      }
+      sessions_++;
+      connections_.insert(conn.get());
+    }
+    // Sessions are detached, so that a long-running server doesn't accumulate finished threads; the count lets the
+    // destructor wait for the ones still running.  The thread owns the connection, and unregisters it before
+    // releasing it.
+    std::thread{[this, conn = std::move(conn)]() mutable {
+      try {
+        Session{platform_.get(), conn.get()}.Serve();
+      } catch (const std::exception& ex) {
+        LOG(WARNING) << "Remote session failed: " << ex.what();
+      }
+      std::lock_guard<std::mutex> lock{mu_};
+      connections_.erase(conn.get());
+      if (--sessions_ == 0) {
+        sessions_done_.notify_all();
+      }
+    }}.detach();
+  }
+}
+
+std::size_t Server::active_sessions() {
+  std::lock_guard<std::mutex> lock{mu_};
+  return sessions_;
+}
+
+void Server::Stop() {
+  if (stopping_.exchange(true)) {
+    return;
+  }
+  // Wakes Serve from its blocking accept.
+  try {
+    boost::asio::io_context io;
+    boost::asio::ip::tcp::socket socket{io};
+    socket.connect(boost::asio::ip::tcp::endpoint{wake_address_, port_});
+  } catch (const std::exception&) {
+    // Serve isn't waiting.
+  }
+  // Idle clients would otherwise keep their sessions, and so the destructor, waiting forever.
+  std::lock_guard<std::mutex> lock{mu_};
+  for (auto* conn : connections_) {
+    conn->Shutdown();
+  }
+}
+
+}  // namespace remote
+}  // namespace tile
+}  // namespace vertexai
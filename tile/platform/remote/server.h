@@ -0,0 +1,65 @@
+// Copyright 2020, Intel Corporation.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+
+#include <boost/asio.hpp>
+
+#include "tile/base/platform.h"
+
+namespace vertexai {
+namespace tile {
+namespace remote {
+
+class Connection;
+
+// Serves a platform to remote::Platform clients, so that thin clients can run programs on this host's devices.
+// Each client connection is served on its own thread, and owns the buffers and programs it creates; they're released
+// when the client drops them or disconnects.
+//
+// The protocol is unauthenticated and unencrypted: anyone who can connect may allocate buffers and run programs on
+// this host.  So the server listens on the loopback interface unless told otherwise; expose it more widely only on a
+// trusted network.
+class Server {
+ public:
+  // Listens on the port of the given local address; port 0 picks an unused port.
+  Server(std::shared_ptr<tile::Platform> platform, unsigned short port, const std::string& address = "127.0.0.1");
+
+  // Stops serving, and waits for the sessions to finish.
+  ~Server();
+
+  unsigned short port() const { return port_; }
+  boost::asio::ip::address address() const { return acceptor_.local_endpoint().address(); }
+
+  // The number of client connections being served.
+  std::size_t active_sessions();
+
+  // Accepts and serves connections until Stop is called.
+  void Serve();
+
+  // Stops accepting connections, and disconnects the connected clients.
+  void Stop();
+
+ private:
+  std::shared_ptr<tile::Platform> platform_;
+  std::shared_ptr<boost::asio::io_context> io_;
+  boost::asio::ip::tcp::acceptor acceptor_;
+  unsigned short port_;
+  boost::asio::ip::address wake_address_;  // Where Stop connects to wake Serve
+  std::atomic<bool> stopping_{false};
+  std::mutex mu_;
+  std::condition_variable sessions_done_;
+  std::size_t sessions_ = 0;  // The sessions still running; each runs on its own detached thread
+  std::unordered_set<Connection*> connections_;  // The running sessions' connections, which Stop shuts down
+};
+
+}  // namespace remote
+}  // namespace tile
+}  // namespace vertexai
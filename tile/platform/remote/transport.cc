@@ -0,0 +1,171 @@
+// Copyright 2020, Intel Corporation.
+
+#include "tile/platform/remote/transport.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <zlib.h>
+
+namespace vertexai {
+namespace tile {
+namespace remote {
+
+namespace {
+
+// Messages larger than this are rejected, guarding against a corrupt length prefix.
+constexpr std::uint32_t kMaxMessageSize = 256 << 20;
+
+// Byte planes wider than this aren't worth splitting.
+constexpr std::uint32_t kMaxPlaneWidth = 16;
+
+// Splits size bytes of elements of width bytes into byte planes.
+void SplitPlanes(const char* src, std::uint64_t size, std::uint32_t width, char* dst) {
+  auto count = size / width;
+  for (std::uint64_t elem = 0; elem < count; elem++) {
+    for (std::uint32_t byte = 0; byte < width; byte++) {
+      dst[byte * count + elem] = src[elem * width + byte];
+    }
+  }
+}
+
+// Joins byte planes back into size bytes of elements of width bytes.
+void JoinPlanes(const char* src, std::uint64_t size, std::uint32_t width, char* dst) {
+  auto count = size / width;
+  for (std::uint64_t elem = 0; elem < count; elem++) {
+    for (std::uint32_t byte = 0; byte < width; byte++) {
+      dst[elem * width + byte] = src[byte * count + elem];
+    }
+  }
+}
+
+}  // namespace
+
+Connection::Connection(std::shared_ptr<boost::asio::io_context> io, boost::asio::ip::tcp::socket socket)
+    : io_{std::move(io)}, socket_{std::move(socket)} {
+  socket_.set_option(boost::asio::ip::tcp::no_delay(true));
+}
+
+std::unique_ptr<Connection> Connection::Connect(const std::string& host, const std::string& port) {
+  auto io = std::make_shared<boost::asio::io_context>();
+  boost::asio::ip::tcp::resolver resolver{*io};
+  boost::asio::ip::tcp::socket socket{*io};
+  boost::asio::connect(socket, resolver.resolve(host, port));
+  return std::make_unique<Connection>(std::move(io), std::move(socket));
+}
+
+void Connection::Send(const google::protobuf::MessageLite& msg) {
+  auto size = msg.ByteSizeLong();
+  if (size > kMaxMessageSize) {
+    throw std::runtime_error("Remote message too large");
+  }
+  std::vector<char> frame(4 + size);
+  for (int idx = 0; idx < 4; idx++) {
+    frame[idx] = static_cast<char>((size >> (8 * idx)) & 0xff);
+  }
+  msg.SerializeWithCachedSizesToArray(reinterpret_cast<std::uint8_t*>(frame.data() + 4));
+  boost::asio::write(socket_, boost::asio::buffer(frame));
+}
+
+bool Connection::Receive(google::protobuf::MessageLite* msg) {
+  std::uint8_t header[4];
+  boost::system::error_code err;
+  boost::asio::read(socket_, boost::asio::buffer(header), err);
+  if (err == boost::asio::error::eof) {
+    return false;
+  }
+  if (err) {
+    throw boost::system::system_error{err};
+  }
+  std::uint32_t size = header[0] | (header[1] << 8) | (header[2] << 16) | (static_cast<std::uint32_t>(header[3]) << 24);
+  if (size > kMaxMessageSize) {
+    throw std::runtime_error("Remote message too large");
+  }
+  std::vector<char> body(size);
+  boost::asio::read(socket_, boost::asio::buffer(body));
+  if (!msg->ParseFromArray(body.data(), body.size())) {
+    throw std::runtime_error("Unable to parse remote message");
+  }
+  return true;
+}
+
+void Connection::Shutdown() {
+  boost::system::error_code err;
+  socket_.shutdown(boost::asio::ip::tcp::socket::shutdown_both, err);
+}
+
+void ForEachChunk(const char* data, std::uint64_t size, bool compress, std::uint32_t plane_width,
+                  const std::function<void(proto::Chunk*)>& fn) {
+  std::uint64_t offset = 0;
+  std::vector<char> planes;
+  do {
+    auto len = std::min<std::uint64_t>(size - offset, kChunkSize);
+    proto::Chunk chunk;
+    chunk.set_offset(offset);
+    chunk.set_size(len);
+    chunk.set_last(offset + len == size);
+    std::string packed;
+    if (compress && len) {
+      const char* src = data + offset;
+      bool split = plane_width > 1 && plane_width <= kMaxPlaneWidth && len % plane_width == 0;
+      if (split) {
+        planes.resize(len);
+        SplitPlanes(src, len, plane_width, planes.data());
+        src = planes.data();
+      }
+      uLongf packed_len = compressBound(len);
+      packed.resize(packed_len);
+      if (compress2(reinterpret_cast<Bytef*>(&packed[0]), &packed_len, reinterpret_cast<const Bytef*>(src), len,
+                    Z_BEST_SPEED) == Z_OK &&
+          packed_len < len) {
+        packed.resize(packed_len);
+        chunk.set_compressed(true);
+        if (split) {
+          chunk.set_plane_width(plane_width);
+        }
+      }
+    }
+    if (chunk.compressed()) {
+      chunk.set_data(std::move(packed));
+    } else {
+      chunk.set_data(data + offset, len);
+    }
+    fn(&chunk);
+    offset += len;
+  } while (offset < size);
+}
+
+void UnpackChunk(const proto::Chunk& chunk, char* dst, std::uint64_t size) {
+  if (chunk.offset() > size || chunk.size() > size - chunk.offset()) {
+    throw std::runtime_error("Remote chunk exceeds its buffer");
+  }
+  if (!chunk.compressed()) {
+    if (chunk.data().size() != chunk.size()) {
+      throw std::runtime_error("Remote chunk is truncated");
+    }
+    std::copy(chunk.data().begin(), chunk.data().end(), dst + chunk.offset());
+    return;
+  }
+  auto width = chunk.plane_width();
+  bool split = width > 1;
+  if (split && (width > kMaxPlaneWidth || chunk.size() % width)) {
+    throw std::runtime_error("Remote chunk has invalid byte planes");
+  }
+  std::vector<char> planes(split ? chunk.size() : 0);
+  char* out = split ? planes.data() : dst + chunk.offset();
+  uLongf len = chunk.size();
+  if (uncompress(reinterpret_cast<Bytef*>(out), &len, reinterpret_cast<const Bytef*>(chunk.data().data()),
+                 chunk.data().size()) != Z_OK ||
+      len != chunk.size()) {
+    throw std::runtime_error("Unable to decompress remote chunk");
+  }
+  if (split) {
+    JoinPlanes(planes.data(), chunk.size(), width, dst + chunk.offset());
+  }
+}
+
+}  // namespace remote
+}  // namespace tile
+}  // namespace vertexai
@@ -0,0 +1,55 @@
+// Copyright 2020, Intel Corporation.
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include <boost/asio.hpp>
+#include <google/protobuf/message_lite.h>
+
+#include "tile/platform/remote/remote.pb.h"
+
+namespace vertexai {
+namespace tile {
+namespace remote {
+
+// Buffer contents are streamed in chunks of this many bytes, so that neither end holds a second copy of a large
+// buffer in one message, and compression overlaps transfer.
+constexpr std::size_t kChunkSize = 1 << 20;
+
+// A TCP connection carrying length-framed protobuf messages.  Not thread-safe; callers serialize their use.
+class Connection {
+ public:
+  Connection(std::shared_ptr<boost::asio::io_context> io, boost::asio::ip::tcp::socket socket);
+
+  // Connects to host:port.
+  static std::unique_ptr<Connection> Connect(const std::string& host, const std::string& port);
+
+  void Send(const google::protobuf::MessageLite& msg);
+
+  // Receives the next message, returning false if the peer has closed the connection.
+  bool Receive(google::protobuf::MessageLite* msg);
+
+  // Shuts the connection down in both directions, so that a Receive blocked on another thread returns.
+  void Shutdown();
+
+ private:
+  std::shared_ptr<boost::asio::io_context> io_;
+  boost::asio::ip::tcp::socket socket_;
+};
+
+// Splits data into chunks, calling fn with each in turn.  Chunks are compressed when that makes them smaller.  If
+// plane_width is above 1, data is taken to hold elements of that many bytes, which are split into byte planes before
+// compression: the high bytes of numeric elements vary little, so the planes compress far better than the elements.
+void ForEachChunk(const char* data, std::uint64_t size, bool compress, std::uint32_t plane_width,
+                  const std::function<void(proto::Chunk*)>& fn);
+
+// Copies a chunk's contents into dst, a buffer of size bytes.
+void UnpackChunk(const proto::Chunk& chunk, char* dst, std::uint64_t size);
+
+}  // namespace remote
+}  // namespace tile
+}  // namespace vertexai
@@ -0,0 +1,65 @@
+// Copyright 2020, Intel Corporation.
+
+// plaidml_worker: serves this host's devices to thin clients, which run their
+// programs here by setting PLAIDML_REMOTE=host:port.
+//
+//   plaidml_worker [--port=N] [--bind=ADDRESS]
+//
+// The protocol is unauthenticated: any client which can reach the port may
+// allocate memory and run programs on this host.  So the worker only listens
+// on the loopback interface by default; pass --bind=0.0.0.0 (or a specific
+// interface's address) to serve other hosts, on a trusted network only.
+
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include <boost/program_options.hpp>
+
+#include "base/util/logging.h"
+#include "tile/platform/local_machine/platform.h"
+#include "tile/platform/remote/server.h"
+
+namespace po = boost::program_options;
+
+namespace vertexai {
+namespace tile {
+namespace remote {
+namespace {
+
+int Main(int argc, char* argv[]) {
+  po::options_description opts{"Options"};
+  opts.add_options()                                                             //
+      ("help", "Show this help")                                                 //
+      ("port", po::value<unsigned short>()->default_value(9741), "Port to serve")  //
+      ("bind", po::value<std::string>()->default_value("127.0.0.1"),
+       "Local address to listen on; the protocol is unauthenticated, so bind other interfaces only on a trusted "
+       "network");
+  po::variables_map args;
+  po::store(po::parse_command_line(argc, argv, opts), args);
+  po::notify(args);
+  if (args.count("help")) {
+    std::cout << opts << std::endl;
+    return 0;
+  }
+  Server server{std::make_shared<local_machine::Platform>(), args["port"].as<unsigned short>(),
+                args["bind"].as<std::string>()};
+  LOG(INFO) << "Serving remote platform clients on " << args["bind"].as<std::string>() << " port " << server.port();
+  server.Serve();
+  return 0;
+}
+
+}  // namespace
+}  // namespace remote
+}  // namespace tile
+}  // namespace vertexai
+
+int main(int argc, char* argv[]) {
+  try {
+    START_EASYLOGGINGPP(argc, argv);
+    return vertexai::tile::remote::Main(argc, argv);
+  } catch (const std::exception& ex) {
+    std::cerr << "Caught unhandled exception: " << ex.what() << std::endl;
+    return -1;
+  }
+}
@@ -0,0 +1,246 @@
+// Copyright 2020, Intel Corporation
+
+// compile_bench: measures compile time and memory use, stage by stage, for
+// saved Tile programs under each target configuration.
+//
+//   compile_bench [--target=NAME ...] [--baseline=FILE] [--out=FILE] INPUT...
+//
+// Each INPUT is a *.tile file (as written by `plaidbench --tile`) or a
+// directory of them.  For every input and target, the report records parse
+// (loading the Tile file), gen_stripe, each codegen pass, and, for the LLVM
+// CPU target, hal_build (JIT compilation).  With --baseline, the run fails if
+// any total or stage is more than --threshold slower than the baseline's.
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/format.hpp>
+#include <boost/program_options.hpp>
+
+#include "base/config/config.h"
+#include "base/util/file.h"
+#include "base/util/logging.h"
+#include "json/json.h"
+#include "tile/codegen/driver.h"
+#include "tile/lang/gen_stripe.h"
+#ifdef ENABLE_LLVM_BITCODE
+#include "tile/targets/cpu/jit.h"
+#endif
+#include "tile/targets/targets.h"
+#include "tile/util/tile_file.h"
+
+namespace fs = boost::filesystem;
+namespace po = boost::program_options;
+
+namespace vertexai {
+namespace tile {
+namespace pmlc {
+namespace {
+
+using clock = std::chrono::steady_clock;
+
+// Times fn as the named stage, recording memory use once it completes.
+template <typename F>
+void RunStage(const std::string& name, codegen::proto::OptimizeProfile* profile, F fn) {
+  auto peak_before = codegen::PeakRss();
+  auto start = clock::now();
+  fn();
+  auto stage = profile->add_passes();
+  stage->set_name(name);
+  stage->set_seconds(std::chrono::duration<double>(clock::now() - start).count());
+  codegen::RecordMemoryUsage(peak_before, stage);
+}
+
+codegen::proto::OptimizeProfile CompileOne(const fs::path& path, const std::string& target_name,
+                                           const codegen::proto::Config& target, const std::string& stage_name) {
+  codegen::proto::OptimizeProfile profile;
+  auto start = clock::now();
+  lang::RunInfo runinfo;
+  RunStage("parse", &profile, [&] { runinfo = util::TileFile(path).Load(); });
+  std::shared_ptr<stripe::Program> program;
+  RunStage("gen_stripe", &profile, [&] { program = lang::GenerateStripe(runinfo); });
+  codegen::proto::OptimizeProfile passes;
+  codegen::OptimizeOptions options;
+  options.profile = &passes;
+  codegen::CompilerState state(program);
+  codegen::Optimize(&state, target.stages().at(stage_name).passes(), options);
+  for (const auto& pass : passes.passes()) {
+    *profile.add_passes() = pass;
+  }
+#ifdef ENABLE_LLVM_BITCODE
+  if (target_name == "llvm_cpu") {
+    RunStage("hal_build", &profile, [&] {
+      targets::cpu::Native native;
+      native.compile(*program->entry, targets::cpu::Config{});
+    });
+  }
+#endif
+  profile.set_total_seconds(std::chrono::duration<double>(clock::now() - start).count());
+  return profile;
+}
+
+Json::Value ToJson(const std::string& network, const std::string& target,
+                   const codegen::proto::OptimizeProfile& profile) {
+  Json::Value run;
+  run["network"] = network;
+  run["target"] = target;
+  run["total_seconds"] = profile.total_seconds();
+  uint64_t peak_rss = 0;
+  for (const auto& pass : profile.passes()) {
+    Json::Value stage;
+    stage["name"] = pass.name();
+    stage["seconds"] = pass.seconds();
+    stage["rss_bytes"] = Json::UInt64(pass.rss_bytes());
+    run["stages"].append(stage);
+    peak_rss = std::max(peak_rss, pass.process_peak_rss_bytes());
+  }
+  run["peak_rss_bytes"] = Json::UInt64(peak_rss);
+  return run;
+}
+
+// Compares a run against the matching baseline run, returning the number of
+// regressions found.  Times below min_seconds are too noisy to compare.
+int CheckRegressions(const Json::Value& run, const Json::Value& baseline, double threshold, double min_seconds) {
+  int regressions = 0;
+  auto check = [&](const std::string& what, double seconds, double base) {
+    if (base >= min_seconds && seconds > base * (1 + threshold)) {
+      std::cerr << boost::format("REGRESSION %1%/%2% %3%: %4$.3fs vs. %5$.3fs baseline") %
+                       run["network"].asString() % run["target"].asString() % what % seconds % base
+                << std::endl;
+      regressions++;
+    }
+  };
+  check("total", run["total_seconds"].asDouble(), baseline["total_seconds"].asDouble());
+  std::map<std::string, double> base_stages;
+  for (const auto& stage : baseline["stages"]) {
+    base_stages[stage["name"].asString()] += stage["seconds"].asDouble();
+  }
+  std::map<std::string, double> stages;
+  for (const auto& stage : run["stages"]) {
+    stages[stage["name"].asString()] += stage["seconds"].asDouble();
+  }
+  for (const auto& kvp : stages) {
+    auto it = base_stages.find(kvp.first);
+    if (it != base_stages.end()) {
+      check(kvp.first, kvp.second, it->second);
+    }
+  }
+  return regressions;
+}
+
+std::vector<fs::path> FindInputs(const std::vector<fs::path>& paths) {
+  std::vector<fs::path> result;
+  for (const auto& path : paths) {
+    if (!fs::is_directory(path)) {
+      result.push_back(path);
+      continue;
+    }
+    for (const auto& entry : fs::recursive_directory_iterator(path)) {
+      if (entry.path().extension() == ".tile") {
+        result.push_back(entry.path());
+      }
+    }
+  }
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+int Main(int argc, char* argv[]) {
+  po::options_description opts{"Allowed options"};
+  opts.add_options()                                                                                    //
+      ("help,h", "produce help message")                                                                //
+      ("verbose,v", po::value<int>()->default_value(0), "increase verbosity")                           //
+      ("input", po::value<std::vector<fs::path>>()->required(), "*.tile files or directories")          //
+      ("config,c", po::value<fs::path>(), "config file path (default: the built-in targets)")           //
+      ("target,t", po::value<std::vector<std::string>>(), "targets to compile for (default: all)")      //
+      ("stage,s", po::value<std::string>()->default_value("default"), "name of stage within config")    //
+      ("out,o", po::value<fs::path>()->default_value("compile_bench.json"), "report file path")         //
+      ("baseline,b", po::value<fs::path>(), "baseline report to check for regressions")                 //
+      ("threshold", po::value<double>()->default_value(0.25), "allowed slowdown relative to baseline")  //
+      ("min-seconds", po::value<double>()->default_value(0.05), "ignore baseline times below this");
+  po::positional_options_description pos_opts;
+  pos_opts.add("input", -1);
+  po::variables_map args;
+  po::store(po::command_line_parser(argc, argv).options(opts).positional(pos_opts).run(), args);
+  if (args.count("help")) {
+    std::cout << opts << std::endl;
+    return 0;
+  }
+  SetVerbosity(args["verbose"].as<int>());
+  args.notify();
+
+  auto configs = args.count("config") ? ParseConfig<codegen::proto::Configs>(ReadFile(args["config"].as<fs::path>()))
+                                      : targets::GetConfigs();
+  std::vector<std::string> target_names;
+  if (args.count("target")) {
+    target_names = args["target"].as<std::vector<std::string>>();
+  } else {
+    for (const auto& kvp : configs.configs()) {
+      target_names.push_back(kvp.first);
+    }
+    std::sort(target_names.begin(), target_names.end());
+  }
+  auto stage_name = args["stage"].as<std::string>();
+
+  Json::Value report;
+  report["runs"] = Json::Value(Json::arrayValue);
+  for (const auto& path : FindInputs(args["input"].as<std::vector<fs::path>>())) {
+    auto network = path.stem().string();
+    for (const auto& target_name : target_names) {
+      std::cout << network << " / " << target_name << "... " << std::flush;
+      auto profile = CompileOne(path, target_name, configs.configs().at(target_name), stage_name);
+      std::cout << boost::format("%1$.3fs") % profile.total_seconds() << std::endl;
+      report["runs"].append(ToJson(network, target_name, profile));
+    }
+  }
+  WriteFile(args["out"].as<fs::path>(), false, [&report](std::ofstream& fout) {  //
+    fout << report << std::endl;
+  });
+
+  if (!args.count("baseline")) {
+    return 0;
+  }
+  Json::Value baseline;
+  std::istringstream{ReadFile(args["baseline"].as<fs::path>())} >> baseline;
+  std::map<std::pair<std::string, std::string>, Json::Value> base_runs;
+  for (const auto& run : baseline["runs"]) {
+    base_runs[std::make_pair(run["network"].asString(), run["target"].asString())] = run;
+  }
+  int regressions = 0;
+  for (const auto& run : report["runs"]) {
+    auto it = base_runs.find(std::make_pair(run["network"].asString(), run["target"].asString()));
+    if (it != base_runs.end()) {
+      regressions += CheckRegressions(run, it->second, args["threshold"].as<double>(),  //
+                                      args["min-seconds"].as<double>());
+    }
+  }
+  if (regressions) {
+    std::cerr << regressions << " compile time regression(s) against " << args["baseline"].as<fs::path>()
+              << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+}  // namespace
+}  // namespace pmlc
+}  // namespace tile
+}  // namespace vertexai
+
+int main(int argc, char* argv[]) {
+  try {
+    START_EASYLOGGINGPP(argc, argv);
+    return vertexai::tile::pmlc::Main(argc, argv);
+  } catch (const std::exception& ex) {
+    std::cerr << "Caught unhandled exception: " << ex.what() << std::endl;
+    return -1;
+  }
+}
@@ -47,7 +47,7 @@ bool App::parse(int argc, char* argv[]) {
     return false;
   }
   if (args.count("verbose")) {
-    el::Loggers::setVerboseLevel(args["verbose"].as<int>());
+    SetVerbosity(args["verbose"].as<int>());
   }
   args.notify();
   return true;
@@ -66,6 +66,7 @@ bool App::parse(int argc, char* argv[]) {
       ("internal", "input specifies an internally defined network")                       //
       ("dump-passes", "dump passes in *.txt format")                                      //
       ("dump-passes-proto", "dump passes in *.pb format")                                 //
+      ("profile-passes", "write per-pass timing and memory use to profile.json")          //
 #ifdef ENABLE_LLVM_BITCODE
       ("llvm", "enable LLVM bitcode output")  //
 #endif
@@ -96,14 +97,14 @@ std::shared_ptr<Program> DefaultStage(const App& app,                      //
   for (const auto& kvp : runinfo.input_buffers) {
     auto buf = std::dynamic_pointer_cast<util::SimpleBuffer>(kvp.second);
     if (buf) {
-      std::string str(reinterpret_cast<const char*>(buf->bytes.data()), buf->bytes.size());
+      std::string str(reinterpret_cast<const char*>(buf->data()), buf->size());
       program->buffers[kvp.first].sections.emplace("data", str);
     }
   }
   for (const auto& kvp : runinfo.qparams_buffers) {
     auto buf = std::dynamic_pointer_cast<util::SimpleBuffer>(kvp.second);
     if (buf) {
-      std::string str(reinterpret_cast<const char*>(buf->bytes.data()), buf->bytes.size());
+      std::string str(reinterpret_cast<const char*>(buf->data()), buf->size());
       program->buffers[kvp.first].sections.emplace("qparams", str);
     }
   }
@@ -150,6 +151,11 @@ std::shared_ptr<Program> Main() {
     options.dump_passes_proto = true;
     options.dbg_dir = out_dir / "passes";
   }
+  if (app->args.count("profile-passes")) {
+    options.profile_path = out_dir / "profile.json";
+    // Reports are appended, so start afresh rather than adding to an earlier run's.
+    fs::remove(options.profile_path);
+  }
   return DefaultStage(*app, input_path, out_dir, stage, options);
 }
 
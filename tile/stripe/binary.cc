@@ -0,0 +1,583 @@
+// Copyright 2020, Intel Corporation
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+
+#include "tile/stripe/impl.h"
+#include "tile/stripe/stripe.h"
+
+namespace vertexai {
+namespace tile {
+namespace stripe {
+
+// The binary encoding is:
+//
+//   magic, version
+//   string table: count, then each string's length and bytes
+//   program: entry block, buffers, input shapes, output shapes
+//
+// Every integer is a varint (signed ones zigzag-encoded), and every name is an index into the string table, so the
+// names which a program repeats throughout (indexes, refinements, scalars, tags) are stored once.  Statements are
+// stored in order, each followed by its deps as indexes of earlier statements in the same block.
+
+namespace {
+
+const char kMagic[4] = {'S', 'T', 'R', 'B'};
+const uint64_t kVersion = 1;
+
+enum class AttrKind : uint8_t { Void, Bool, Int, Float, String, Any };
+
+class Writer {
+ public:
+  void Uint(uint64_t value) {
+    while (value >= 0x80) {
+      body_.push_back(static_cast<char>(value | 0x80));
+      value >>= 7;
+    }
+    body_.push_back(static_cast<char>(value));
+  }
+
+  void Int(int64_t value) { Uint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63)); }
+
+  void Float(double value) {
+    char bytes[sizeof(value)];
+    std::memcpy(bytes, &value, sizeof(value));
+    body_.append(bytes, sizeof(bytes));
+  }
+
+  void Str(const std::string& str) {
+    auto it = ids_.emplace(str, strings_.size()).first;
+    if (it->second == strings_.size()) {
+      strings_.push_back(&it->first);
+    }
+    Uint(it->second);
+  }
+
+  void Bytes(const std::string& bytes) {
+    Uint(bytes.size());
+    body_.append(bytes);
+  }
+
+  void Affine(const stripe::Affine& affine) {
+    const auto& map = affine.getMap();
+    auto offset = map.find("");
+    Int(offset == map.end() ? 0 : offset->second);
+    Uint(map.size() - (offset == map.end() ? 0 : 1));
+    for (const auto& kvp : map) {
+      if (!kvp.first.empty()) {
+        Str(kvp.first);
+        Int(kvp.second);
+      }
+    }
+  }
+
+  void Attrs(const Taggable& taggable) {
+    const auto& attrs = Accessor::impl(taggable)->attrs;
+    Uint(attrs.size());
+    for (const auto& kvp : attrs) {
+      Str(kvp.first);
+      std::visit(*this, kvp.second);
+    }
+  }
+
+  void operator()(const Void&) { Kind(AttrKind::Void); }
+  void operator()(bool value) {
+    Kind(AttrKind::Bool);
+    Uint(value);
+  }
+  void operator()(int64_t value) {
+    Kind(AttrKind::Int);
+    Int(value);
+  }
+  void operator()(double value) {
+    Kind(AttrKind::Float);
+    Float(value);
+  }
+  void operator()(const std::string& value) {
+    Kind(AttrKind::String);
+    Str(value);
+  }
+  void operator()(const google::protobuf::Any& value) {
+    Kind(AttrKind::Any);
+    Str(value.type_url());
+    Bytes(value.value());
+  }
+
+  void Shape(const TensorShape& shape) {
+    Uint(tile::IntoProto(shape.type));
+    Uint(shape.is_const);
+    Str(shape.codec);
+    Str(shape.layout);
+    Uint(shape.dims.size());
+    for (const auto& dim : shape.dims) {
+      Int(dim.stride);
+      Uint(dim.size);
+    }
+  }
+
+  void Shapes(const ShapeMap& shapes) {
+    Uint(shapes.size());
+    for (const auto& kvp : shapes) {
+      Str(kvp.first);
+      Shape(kvp.second);
+    }
+  }
+
+  void Location(const stripe::Location& loc) {
+    Uint(loc.devs.size());
+    for (const auto& dev : loc.devs) {
+      Str(dev.name);
+      Uint(dev.units.size());
+      for (const auto& unit : dev.units) {
+        Affine(unit);
+      }
+    }
+  }
+
+  void Strs(const std::vector<std::string>& strs) {
+    Uint(strs.size());
+    for (const auto& str : strs) {
+      Str(str);
+    }
+  }
+
+  void Block(const stripe::Block& block) {
+    Str(block.name);
+    Str(block.comments);
+    Location(block.location);
+    Uint(block.idxs.size());
+    for (const auto& idx : block.idxs) {
+      Str(idx.name);
+      Uint(idx.range);
+      Affine(idx.affine);
+      Attrs(idx);
+    }
+    Uint(block.constraints.size());
+    for (const auto& con : block.constraints) {
+      Affine(con);
+    }
+    Uint(block.refs.size());
+    for (const auto& ref : block.refs) {
+      Str(ref.into());
+      Uint(static_cast<uint64_t>(ref.dir));
+      Str(ref.from);
+      Uint(ref.access.size());
+      for (const auto& access : ref.access) {
+        Affine(access);
+      }
+      Shape(ref.interior_shape);
+      Str(ref.agg_op);
+      Location(ref.location);
+      Uint(ref.offset);
+      Attrs(ref);
+    }
+    Uint(block.stmts.size());
+    std::unordered_map<const stripe::Statement*, uint64_t> ids;
+    for (const auto& stmt : block.stmts) {
+      ids.emplace(stmt.get(), ids.size());
+      Statement(*stmt);
+      std::vector<uint64_t> deps;
+      for (const auto& dep : stmt->deps) {
+        deps.push_back(ids.at(dep->get()));
+      }
+      std::sort(deps.begin(), deps.end());
+      Uint(deps.size());
+      for (auto dep : deps) {
+        Uint(dep);
+      }
+      Attrs(*stmt);
+    }
+  }
+
+  void Statement(const stripe::Statement& stmt) {
+    Uint(static_cast<uint64_t>(stmt.kind()));
+    switch (stmt.kind()) {
+      case StmtKind::Load: {
+        const auto& load = static_cast<const Load&>(stmt);
+        Str(load.from);
+        Str(load.into);
+      } break;
+      case StmtKind::Store: {
+        const auto& store = static_cast<const Store&>(stmt);
+        Str(store.from);
+        Str(store.into);
+      } break;
+      case StmtKind::LoadIndex: {
+        const auto& load_index = static_cast<const LoadIndex&>(stmt);
+        Affine(load_index.from);
+        Str(load_index.into);
+      } break;
+      case StmtKind::Constant: {
+        const auto& constant = static_cast<const Constant&>(stmt);
+        Str(constant.name);
+        Uint(static_cast<uint64_t>(constant.type));
+        if (constant.type == ConstType::Integer) {
+          Int(constant.iconst);
+        } else {
+          Float(constant.fconst);
+        }
+      } break;
+      case StmtKind::Special: {
+        const auto& special = static_cast<const Special&>(stmt);
+        Str(special.name);
+        Strs(special.inputs);
+        Strs(special.outputs);
+        Uint(special.int_params.size());
+        for (const auto& kvp : special.int_params) {
+          Str(kvp.first);
+          Int(kvp.second);
+        }
+        Uint(special.str_params.size());
+        for (const auto& kvp : special.str_params) {
+          Str(kvp.first);
+          Str(kvp.second);
+        }
+      } break;
+      case StmtKind::Intrinsic: {
+        const auto& intrinsic = static_cast<const Intrinsic&>(stmt);
+        Str(intrinsic.name);
+        Uint(tile::IntoProto(intrinsic.type));
+        Strs(intrinsic.inputs);
+        Strs(intrinsic.outputs);
+      } break;
+      case StmtKind::Block:
+        Block(static_cast<const stripe::Block&>(stmt));
+        break;
+    }
+  }
+
+  std::string Finish() {
+    std::string body;
+    std::swap(body, body_);
+    body_.append(kMagic, sizeof(kMagic));
+    Uint(kVersion);
+    Uint(strings_.size());
+    for (const auto* str : strings_) {
+      Bytes(*str);
+    }
+    return body_ + body;
+  }
+
+ private:
+  void Kind(AttrKind kind) { body_.push_back(static_cast<char>(kind)); }
+
+  std::string body_;
+  std::unordered_map<std::string, uint64_t> ids_;
+  std::vector<const std::string*> strings_;
+};
+
+// Reads the binary encoding in place: the string table holds views of the input, which are only copied into the
+// program's own strings.
+class Reader {
+ public:
+  explicit Reader(std::string_view bytes) : bytes_{bytes} {
+    if (bytes_.size() < sizeof(kMagic) || std::memcmp(bytes_.data(), kMagic, sizeof(kMagic))) {
+      throw std::runtime_error("Not a binary Stripe program");
+    }
+    pos_ = sizeof(kMagic);
+    if (Uint() != kVersion) {
+      throw std::runtime_error("Unsupported binary Stripe program version");
+    }
+    auto count = Uint();
+    strings_.reserve(count);
+    for (uint64_t i = 0; i < count; i++) {
+      strings_.push_back(Bytes());
+    }
+  }
+
+  uint64_t Uint() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      auto byte = static_cast<uint8_t>(Take(1)[0]);
+      value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if (!(byte & 0x80)) {
+        return value;
+      }
+    }
+    throw std::runtime_error("Invalid varint in binary Stripe program");
+  }
+
+  int64_t Int() {
+    auto value = Uint();
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+  }
+
+  double Float() {
+    double value;
+    std::memcpy(&value, Take(sizeof(value)), sizeof(value));
+    return value;
+  }
+
+  std::string Str() {
+    auto id = Uint();
+    if (id >= strings_.size()) {
+      throw std::runtime_error("Invalid string in binary Stripe program");
+    }
+    return std::string(strings_[id]);
+  }
+
+  std::string_view Bytes() {
+    auto size = Uint();
+    return std::string_view(Take(size), size);
+  }
+
+  stripe::Affine Affine() {
+    stripe::Affine affine = Int();
+    auto count = Uint();
+    for (uint64_t i = 0; i < count; i++) {
+      auto name = Str();
+      affine += stripe::Affine(name, Int());
+    }
+    return affine;
+  }
+
+  void Attrs(Taggable* into) {
+    auto count = Uint();
+    for (uint64_t i = 0; i < count; i++) {
+      auto name = Str();
+      switch (static_cast<AttrKind>(static_cast<uint8_t>(Take(1)[0]))) {
+        case AttrKind::Void:
+          into->set_attr(name);
+          break;
+        case AttrKind::Bool:
+          into->set_attr(name, Uint() != 0);
+          break;
+        case AttrKind::Int:
+          into->set_attr(name, Int());
+          break;
+        case AttrKind::Float:
+          into->set_attr(name, Float());
+          break;
+        case AttrKind::String:
+          into->set_attr(name, Str());
+          break;
+        case AttrKind::Any: {
+          google::protobuf::Any any;
+          any.set_type_url(Str());
+          auto value = Bytes();
+          any.set_value(value.data(), value.size());
+          into->set_attr(name, any);
+        } break;
+        default:
+          throw std::runtime_error("Invalid attribute in binary Stripe program");
+      }
+    }
+  }
+
+  TensorShape Shape() {
+    TensorShape shape;
+    shape.type = tile::FromProto(static_cast<tile::proto::TensorShape_DataType>(Uint()));
+    shape.is_const = Uint() != 0;
+    shape.codec = Str();
+    shape.layout = Str();
+    auto count = Uint();
+    shape.dims.reserve(count);
+    for (uint64_t i = 0; i < count; i++) {
+      auto stride = Int();
+      shape.dims.emplace_back(stride, Uint());
+    }
+    return shape;
+  }
+
+  ShapeMap Shapes() {
+    ShapeMap shapes;
+    auto count = Uint();
+    for (uint64_t i = 0; i < count; i++) {
+      auto name = Str();
+      shapes.emplace(name, Shape());
+    }
+    return shapes;
+  }
+
+  stripe::Location Location() {
+    stripe::Location loc;
+    auto count = Uint();
+    for (uint64_t i = 0; i < count; i++) {
+      Device dev;
+      dev.name = Str();
+      auto units = Uint();
+      for (uint64_t j = 0; j < units; j++) {
+        dev.units.emplace_back(Affine());
+      }
+      loc.devs.emplace_back(std::move(dev));
+    }
+    return loc;
+  }
+
+  std::vector<std::string> Strs() {
+    std::vector<std::string> strs(Uint());
+    for (auto& str : strs) {
+      str = Str();
+    }
+    return strs;
+  }
+
+  std::shared_ptr<stripe::Block> Block() {
+    auto block = std::make_shared<stripe::Block>();
+    block->name = Str();
+    block->comments = Str();
+    block->location = Location();
+    auto count = Uint();
+    for (uint64_t i = 0; i < count; i++) {
+      auto name = Str();
+      auto range = Uint();
+      Index idx{name, range, Affine()};
+      Attrs(&idx);
+      block->idxs.emplace_back(std::move(idx));
+    }
+    count = Uint();
+    for (uint64_t i = 0; i < count; i++) {
+      block->constraints.emplace_back(Affine());
+    }
+    count = Uint();
+    for (uint64_t i = 0; i < count; i++) {
+      auto ref = Refinement::FromInto(Str());
+      auto dir = Uint();
+      if (dir > static_cast<uint64_t>(RefDir::InOut)) {
+        throw std::runtime_error("Invalid RefDir");
+      }
+      ref.dir = static_cast<RefDir>(dir);
+      ref.from = Str();
+      auto accesses = Uint();
+      for (uint64_t j = 0; j < accesses; j++) {
+        ref.access.emplace_back(Affine());
+      }
+      ref.interior_shape = Shape();
+      ref.agg_op = Str();
+      ref.location = Location();
+      ref.offset = Uint();
+      Attrs(&ref);
+      block->refs.emplace(std::move(ref));
+    }
+    count = Uint();
+    std::vector<StatementIt> stmts;
+    stmts.reserve(count);
+    for (uint64_t i = 0; i < count; i++) {
+      auto stmt = Statement();
+      stmts.push_back(block->stmts.emplace(block->stmts.end(), stmt));
+      auto deps = Uint();
+      for (uint64_t j = 0; j < deps; j++) {
+        auto dep = Uint();
+        if (dep >= i) {
+          throw std::runtime_error("Invalid dependency in binary Stripe program");
+        }
+        stmt->deps.push_back(stmts[dep]);
+      }
+      Attrs(stmt.get());
+    }
+    return block;
+  }
+
+  std::shared_ptr<stripe::Statement> Statement() {
+    switch (static_cast<StmtKind>(Uint())) {
+      case StmtKind::Load: {
+        auto from = Str();
+        return std::make_shared<Load>(from, Str());
+      }
+      case StmtKind::Store: {
+        auto from = Str();
+        return std::make_shared<Store>(from, Str());
+      }
+      case StmtKind::LoadIndex: {
+        auto from = Affine();
+        return std::make_shared<LoadIndex>(from, Str());
+      }
+      case StmtKind::Constant: {
+        auto name = Str();
+        if (static_cast<ConstType>(Uint()) == ConstType::Integer) {
+          return std::make_shared<Constant>(name, Int());
+        }
+        return std::make_shared<Constant>(name, Float());
+      }
+      case StmtKind::Special: {
+        auto special = std::make_shared<Special>();
+        special->name = Str();
+        special->inputs = Strs();
+        special->outputs = Strs();
+        auto count = Uint();
+        for (uint64_t i = 0; i < count; i++) {
+          auto name = Str();
+          special->int_params.emplace(name, Int());
+        }
+        count = Uint();
+        for (uint64_t i = 0; i < count; i++) {
+          auto name = Str();
+          special->str_params.emplace(name, Str());
+        }
+        return special;
+      }
+      case StmtKind::Intrinsic: {
+        auto intrinsic = std::make_shared<Intrinsic>();
+        intrinsic->name = Str();
+        intrinsic->type = tile::FromProto(static_cast<tile::proto::TensorShape_DataType>(Uint()));
+        intrinsic->inputs = Strs();
+        intrinsic->outputs = Strs();
+        return intrinsic;
+      }
+      case StmtKind::Block:
+        return Block();
+      default:
+        throw std::runtime_error("Invalid statement in binary Stripe program");
+    }
+  }
+
+ private:
+  const char* Take(std::size_t size) {
+    if (bytes_.size() - pos_ < size) {
+      throw std::runtime_error("Truncated binary Stripe program");
+    }
+    auto data = bytes_.data() + pos_;
+    pos_ += size;
+    return data;
+  }
+
+  std::string_view bytes_;
+  std::size_t pos_ = 0;
+  std::vector<std::string_view> strings_;
+};
+
+}  // namespace
+
+std::string IntoBinary(const Program& program) {
+  Writer writer;
+  writer.Block(*program.entry);
+  writer.Attrs(*program.entry);
+  writer.Uint(program.buffers.size());
+  for (const auto& buf : program.buffers) {
+    writer.Str(buf.first);
+    writer.Uint(buf.second.sections.size());
+    for (const auto& section : buf.second.sections) {
+      writer.Str(section.first);
+      writer.Bytes(section.second);
+    }
+  }
+  writer.Shapes(program.input_shapes);
+  writer.Shapes(program.output_shapes);
+  return writer.Finish();
+}
+
+std::shared_ptr<Program> FromBinary(std::string_view bytes) {
+  Reader reader{bytes};
+  auto program = std::make_shared<Program>();
+  program->entry = reader.Block();
+  reader.Attrs(program->entry.get());
+  auto count = reader.Uint();
+  for (uint64_t i = 0; i < count; i++) {
+    auto& buf = program->buffers[reader.Str()];
+    auto sections = reader.Uint();
+    for (uint64_t j = 0; j < sections; j++) {
+      auto name = reader.Str();
+      buf.sections.emplace(name, std::string(reader.Bytes()));
+    }
+  }
+  program->input_shapes = reader.Shapes();
+  program->output_shapes = reader.Shapes();
+  return program;
+}
+
+}  // namespace stripe
+}  // namespace tile
+}  // namespace vertexai
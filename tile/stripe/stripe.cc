@@ -31,7 +31,10 @@ const char* Intrinsic::ADD = "add";
 const char* Intrinsic::EQ = "cmp_eq";
 const char* Intrinsic::COND = "cond";
 
-const Taggable::Impl* Accessor::impl(const Taggable& taggable) { return taggable.impl_.get(); }
+const Taggable::Impl* Accessor::impl(const Taggable& taggable) {
+  static const Taggable::Impl empty;
+  return taggable.impl_ ? taggable.impl_.get() : &empty;
+}
 
 namespace {
 
@@ -242,45 +245,73 @@ class CodecRegistry {
 
 }  // namespace
 
-Taggable::Taggable() : impl_(new Impl()) {}
+// Most statements, indexes and refinements carry no attributes at all, so the
+// attribute map is only allocated once the first attribute is set.
+Taggable::Taggable() = default;
 
 Taggable::~Taggable() = default;
 
 Taggable::Taggable(const Taggable& rhs) { set_attrs(rhs); }
 
+Taggable::Taggable(Taggable&& rhs) noexcept = default;
+
 Taggable& Taggable::operator=(const Taggable& rhs) {
   set_attrs(rhs);
   return *this;
 }
 
-void Taggable::set_tag(const std::string& tag) { impl_->attrs.emplace(tag, Void{}); }
+Taggable& Taggable::operator=(Taggable&& rhs) noexcept = default;
+
+Taggable::Impl* Taggable::mutable_impl() {
+  if (!impl_) {
+    impl_ = std::make_shared<Impl>();
+  } else if (impl_.use_count() > 1) {
+    // Copies share their attributes until one of them is modified.
+    impl_ = std::make_shared<Impl>(*impl_);
+  }
+  return impl_.get();
+}
+
+void Taggable::set_tag(const std::string& tag) { mutable_impl()->attrs.emplace(tag, Void{}); }
 
 void Taggable::add_tags(const Tags& to_add) {
+  if (to_add.empty()) {
+    return;
+  }
+  auto impl = mutable_impl();
   for (const auto& tag : to_add) {
-    impl_->attrs.emplace(tag, Void{});
+    impl->attrs.emplace(tag, Void{});
   }
 }
 
-void Taggable::clear_tags() { impl_->attrs.clear(); }
+void Taggable::clear_tags() { impl_.reset(); }
 
-void Taggable::remove_tag(const std::string& tag) { impl_->attrs.erase(tag); }
+void Taggable::remove_tag(const std::string& tag) {
+  if (has_tag(tag)) {
+    mutable_impl()->attrs.erase(tag);
+  }
+}
 
 void Taggable::remove_tags(const Tags& to_remove) {
+  if (!has_any_tags(to_remove)) {
+    return;
+  }
+  auto impl = mutable_impl();
   for (const auto& tag : to_remove) {
-    impl_->attrs.erase(tag);
+    impl->attrs.erase(tag);
   }
 }
 
 void Taggable::set_tags(const Tags& tags) {
-  impl_->attrs.clear();
+  impl_.reset();
   add_tags(tags);
 }
 
-bool Taggable::has_tag(const std::string& tag) const { return impl_->attrs.count(tag); }
+bool Taggable::has_tag(const std::string& tag) const { return impl_ && impl_->attrs.count(tag); }
 
 bool Taggable::has_tags(const Tags& to_find) const {
   for (const auto& tag : to_find) {
-    if (impl_->attrs.count(tag) == 0) {
+    if (!has_tag(tag)) {
       return false;
     }
   }
@@ -288,6 +319,9 @@ bool Taggable::has_tags(const Tags& to_find) const {
 }
 
 bool Taggable::has_any_tags(const Tags& to_find) const {
+  if (!impl_) {
+    return false;
+  }
   for (const auto& tag : to_find) {
     if (impl_->attrs.count(tag) == 1) {
       return true;
@@ -308,9 +342,12 @@ class TagVisitorVisitor {
   void operator()(const google::protobuf::Any& v) const { inner->Visit(name, v); }
 };
 
-bool Taggable::any_tags() const { return !impl_->attrs.empty(); }
+bool Taggable::any_tags() const { return impl_ && !impl_->attrs.empty(); }
 
 void Taggable::visit_tags(TagVisitor* visitor) const {
+  if (!impl_) {
+    return;
+  }
   TagVisitorVisitor outer;
   outer.inner = visitor;
   for (const auto& kvp : impl_->attrs) {
@@ -319,35 +356,56 @@ void Taggable::visit_tags(TagVisitor* visitor) const {
   }
 }
 
-void Taggable::set_attr(const std::string& name) { impl_->attrs.emplace(name, Void{}); }
+void Taggable::set_attr(const std::string& name) { mutable_impl()->attrs.emplace(name, Void{}); }
 
-void Taggable::set_attr(const std::string& name, bool value) { impl_->attrs.emplace(name, value); }
+void Taggable::set_attr(const std::string& name, bool value) { mutable_impl()->attrs.emplace(name, value); }
 
-void Taggable::set_attr(const std::string& name, int64_t value) { impl_->attrs.emplace(name, value); }
+void Taggable::set_attr(const std::string& name, int64_t value) { mutable_impl()->attrs.emplace(name, value); }
 
-void Taggable::set_attr(const std::string& name, double value) { impl_->attrs.emplace(name, value); }
+void Taggable::set_attr(const std::string& name, double value) { mutable_impl()->attrs.emplace(name, value); }
 
-void Taggable::set_attr(const std::string& name, const std::string& value) { impl_->attrs.emplace(name, value); }
+void Taggable::set_attr(const std::string& name, const std::string& value) {
+  mutable_impl()->attrs.emplace(name, value);
+}
 
-void Taggable::set_attr(const std::string& name, const Any& value) { impl_->attrs.emplace(name, value); }
+void Taggable::set_attr(const std::string& name, const Any& value) { mutable_impl()->attrs.emplace(name, value); }
 
-bool Taggable::has_attr(const std::string& name) const { return impl_->attrs.count(name); }
+bool Taggable::has_attr(const std::string& name) const { return impl_ && impl_->attrs.count(name); }
 
 void Taggable::set_attrs(const Taggable& rhs) {
   if (this != &rhs) {
-    impl_.reset(new Impl(*rhs.impl_));
+    if (rhs.impl_ && !rhs.impl_->attrs.empty()) {
+      impl_ = rhs.impl_;
+    } else {
+      impl_.reset();
+    }
   }
 }
 
-bool Taggable::get_attr_bool(const std::string& name) const { return std::get<bool>(impl_->attrs[name]); }
+namespace {
 
-int64_t Taggable::get_attr_int(const std::string& name) const { return std::get<int64_t>(impl_->attrs[name]); }
+// A missing attribute reads as Void, so that the typed accessors throw
+// std::bad_variant_access.
+const AttrValue& GetAttr(const Taggable& taggable, const std::string& name) {
+  static const AttrValue missing;
+  const auto& attrs = Accessor::impl(taggable)->attrs;
+  auto it = attrs.find(name);
+  return it == attrs.end() ? missing : it->second;
+}
 
-double Taggable::get_attr_float(const std::string& name) const { return std::get<double>(impl_->attrs[name]); }
+}  // namespace
+
+bool Taggable::get_attr_bool(const std::string& name) const { return std::get<bool>(GetAttr(*this, name)); }
+
+int64_t Taggable::get_attr_int(const std::string& name) const { return std::get<int64_t>(GetAttr(*this, name)); }
 
-std::string Taggable::get_attr_str(const std::string& name) const { return std::get<std::string>(impl_->attrs[name]); }
+double Taggable::get_attr_float(const std::string& name) const { return std::get<double>(GetAttr(*this, name)); }
+
+std::string Taggable::get_attr_str(const std::string& name) const {
+  return std::get<std::string>(GetAttr(*this, name));
+}
 
-Any Taggable::get_attr_any(const std::string& name) const { return std::get<Any>(impl_->attrs[name]); }
+Any Taggable::get_attr_any(const std::string& name) const { return std::get<Any>(GetAttr(*this, name)); }
 
 bool Taggable::get_attr_bool(const std::string& name, bool def) const {
   return has_attr(name) ? get_attr_bool(name) : def;
@@ -366,31 +424,31 @@ std::string Taggable::get_attr_str(const std::string& name, const std::string& d
 }
 
 std::shared_ptr<Load> Load::Downcast(const std::shared_ptr<Statement>& stmt) {  //
-  return std::dynamic_pointer_cast<Load>(stmt);
+  return stmt && stmt->kind() == StmtKind::Load ? std::static_pointer_cast<Load>(stmt) : nullptr;
 }
 
 std::shared_ptr<Store> Store::Downcast(const std::shared_ptr<Statement>& stmt) {  //
-  return std::dynamic_pointer_cast<Store>(stmt);
+  return stmt && stmt->kind() == StmtKind::Store ? std::static_pointer_cast<Store>(stmt) : nullptr;
 }
 
 std::shared_ptr<LoadIndex> LoadIndex::Downcast(const std::shared_ptr<Statement>& stmt) {  //
-  return std::dynamic_pointer_cast<LoadIndex>(stmt);
+  return stmt && stmt->kind() == StmtKind::LoadIndex ? std::static_pointer_cast<LoadIndex>(stmt) : nullptr;
 }
 
 std::shared_ptr<Intrinsic> Intrinsic::Downcast(const std::shared_ptr<Statement>& stmt) {  //
-  return std::dynamic_pointer_cast<Intrinsic>(stmt);
+  return stmt && stmt->kind() == StmtKind::Intrinsic ? std::static_pointer_cast<Intrinsic>(stmt) : nullptr;
 }
 
 std::shared_ptr<Special> Special::Downcast(const std::shared_ptr<Statement>& stmt) {  //
-  return std::dynamic_pointer_cast<Special>(stmt);
+  return stmt && stmt->kind() == StmtKind::Special ? std::static_pointer_cast<Special>(stmt) : nullptr;
 }
 
 std::shared_ptr<Constant> Constant::Downcast(const std::shared_ptr<Statement>& stmt) {  //
-  return std::dynamic_pointer_cast<Constant>(stmt);
+  return stmt && stmt->kind() == StmtKind::Constant ? std::static_pointer_cast<Constant>(stmt) : nullptr;
 }
 
 std::shared_ptr<Block> Block::Downcast(const std::shared_ptr<Statement>& stmt) {  //
-  return std::dynamic_pointer_cast<Block>(stmt);
+  return stmt && stmt->kind() == StmtKind::Block ? std::static_pointer_cast<Block>(stmt) : nullptr;
 }
 
 std::string to_string(RefDir dir) {
@@ -927,6 +985,7 @@ class CloneVisitor : RewriteStmtVisitor {
     }
     depth_--;
     std::unordered_map<Statement*, StatementIt> dep_map;  // src-block ptr -> clone-block StatementIt
+    dep_map.reserve(ret->stmts.size());
     for (StatementIt sit = ret->stmts.begin(); sit != ret->stmts.end(); ++sit) {
       Statement* clone = (*sit)->Accept(this);
       for (auto& dit : clone->deps) {
@@ -1140,8 +1199,7 @@ TensorShape Refinement::ApplyTile(const std::map<std::string, size_t>& tile_by_n
         neg += kvp.second * (tile_by_name.at(kvp.first) - 1);
       }
     }
-    auto& dim = shape.dims[i];
-    dim.size = (dim.size - 1) + pos - neg + 1;
+    shape.dims.set_size(i, (shape.dims[i].size - 1) + pos - neg + 1);
   }
   return shape;
 }
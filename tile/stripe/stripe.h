@@ -9,6 +9,7 @@
 #include <optional>
 #include <set>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -98,9 +99,11 @@ class Taggable {
  public:
   // Copy constructor
   Taggable(const Taggable& rhs);
+  Taggable(Taggable&& rhs) noexcept;
 
   // Copy assignment
   Taggable& operator=(const Taggable& rhs);
+  Taggable& operator=(Taggable&& rhs) noexcept;
 
   ~Taggable();
 
@@ -140,7 +143,11 @@ class Taggable {
 
  private:
   struct Impl;
-  std::unique_ptr<Impl> impl_;
+  Impl* mutable_impl();
+  // Allocated when the first attribute is set.  Copies share it until one of them is modified, so cloning a block
+  // (e.g. to try an alternative transformation) doesn't copy the attributes of every statement, index and
+  // refinement in it.
+  std::shared_ptr<Impl> impl_;
 };
 
 class Codec {
@@ -160,6 +167,11 @@ class Codec {
 };
 
 struct Statement : Taggable {
+  Statement() = default;
+  Statement(const Statement&) = default;
+  Statement(Statement&&) = default;
+  Statement& operator=(const Statement&) = default;
+  Statement& operator=(Statement&&) = default;
   virtual ~Statement() = default;
   virtual StmtKind kind() const = 0;
   virtual std::vector<std::string> buffer_reads() const { return {}; }
@@ -579,6 +591,11 @@ Tags FromProto(const google::protobuf::RepeatedPtrField<std::string>& pb_tags);
 proto::Block IntoProto(const Block& block);
 proto::Program IntoProto(const Program& program);
 
+// A compact binary encoding of a program (see binary.cc), which loads much faster than its protobuf; the protobuf form
+// remains the one to use for debugging.  Unlike the protobuf, it also holds the program's input and output shapes.
+std::string IntoBinary(const Program& program);
+std::shared_ptr<Program> FromBinary(std::string_view bytes);
+
 std::shared_ptr<Block> CloneBlock(const Block& orig, int depth = -1);
 const Block* FindBlockByTag(const Block& block, const std::string& tag);
 void FindBlocksByTag(std::vector<const Block*>* into, const Block& block, const std::string& tag);
@@ -1,8 +1,13 @@
 // Copyright 2019, Intel Corporation
 
 #include <gmock/gmock.h>
+#include <google/protobuf/util/message_differencer.h>
 #include <gtest/gtest.h>
 
+#include <memory>
+#include <utility>
+#include <variant>
+
 #include "tile/stripe/stripe.h"
 
 using ::testing::Combine;
@@ -93,6 +98,126 @@ TEST_P(StripeLocThrowTest, ParserThrows) {
 INSTANTIATE_TEST_CASE_P(InvalidPatterns, StripeLocThrowTest,
                         Values("foo[1, *  ]qux/bar", "foo[1, florp ]/bar", "foo[1, 2* ]/bar"));
 
+TEST(StripeTaggableTest, CopyMoveAndClear) {
+  Index idx{"i", 4};
+  EXPECT_FALSE(idx.any_tags());
+  EXPECT_FALSE(idx.has_tag("foo"));
+  EXPECT_THROW(idx.get_attr_int("foo"), std::bad_variant_access);
+  EXPECT_FALSE(idx.has_attr("foo"));  // Reading a missing attribute doesn't create it
+
+  idx.set_tag("foo");
+  idx.set_attr("bar", int64_t{7});
+  Index copy = idx;
+  EXPECT_TRUE(copy.has_tags({"foo", "bar"}));
+  EXPECT_THAT(copy.get_attr_int("bar"), Eq(7));
+
+  Index moved = std::move(copy);
+  EXPECT_TRUE(moved.has_tag("foo"));
+  EXPECT_THAT(moved.get_attr_int("bar", 0), Eq(7));
+
+  moved.clear_tags();
+  EXPECT_FALSE(moved.any_tags());
+  EXPECT_TRUE(idx.has_tag("foo"));
+  idx.set_attrs(moved);
+  EXPECT_FALSE(idx.any_tags());
+}
+
+TEST(StripeTaggableTest, CopiesAreIndependent) {
+  Block block;
+  block.set_tag("kernel");
+  block.stmts.push_back(std::make_shared<Load>("A", "$a"));
+  block.stmts.back()->set_attr("hint", std::string{"x"});
+
+  auto clone = CloneBlock(block);
+  clone->set_tag("cloned");
+  clone->remove_tag("kernel");
+  clone->stmts.back()->set_attr("extra", int64_t{1});
+  EXPECT_TRUE(block.has_tag("kernel"));
+  EXPECT_FALSE(block.has_tag("cloned"));
+  EXPECT_FALSE(block.stmts.back()->has_attr("extra"));
+  EXPECT_THAT(clone->stmts.back()->get_attr_str("hint"), Eq("x"));
+
+  block.stmts.back()->remove_tag("hint");
+  EXPECT_TRUE(clone->stmts.back()->has_attr("hint"));
+}
+
+TEST(StripeCloneTest, DeepCopiesStatementsAndDeps) {
+  Block block;
+  block.name = "outer";
+  auto inner = std::make_shared<Block>();
+  inner->set_tag("kernel");
+  block.stmts.push_back(std::make_shared<Load>("A", "$a"));
+  block.stmts.push_back(inner);
+  block.stmts.back()->deps.push_back(block.stmts.begin());
+
+  auto clone = CloneBlock(block);
+  ASSERT_THAT(clone->stmts.size(), Eq(2));
+  auto cloned_inner = Block::Downcast(clone->stmts.back());
+  ASSERT_TRUE(cloned_inner);
+  EXPECT_THAT(cloned_inner.get(), Ne(inner.get()));
+  EXPECT_TRUE(cloned_inner->has_tag("kernel"));
+  ASSERT_THAT(cloned_inner->deps.size(), Eq(1));
+  EXPECT_THAT(cloned_inner->deps.front(), Eq(clone->stmts.begin()));
+  EXPECT_FALSE(Load::Downcast(clone->stmts.back()));
+  EXPECT_TRUE(Load::Downcast(clone->stmts.front()));
+}
+
+TEST(StripeBinaryTest, RoundTrips) {
+  Program program;
+  program.entry = std::make_shared<Block>();
+  program.entry->name = "root";
+  program.entry->set_tag("program");
+  program.buffers["W"].sections.emplace("data", std::string("\0\1\2", 3));
+  program.input_shapes.emplace("X", SimpleShape(DataType::FLOAT32, {4, 8}));
+
+  auto kernel = std::make_shared<Block>();
+  kernel->name = "kernel";
+  kernel->comments = "a kernel";
+  kernel->location = Location{{{"CPU", {Affine("i", 2) + 1}}}};
+  kernel->idxs.emplace_back(Index{"i", 4});
+  kernel->idxs.back().set_attr("stride", int64_t{-3});
+  kernel->idxs.emplace_back(Index{"j", 1, Affine("x", 8)});
+  kernel->constraints.emplace_back(Affine("i", -1) + 3);
+  kernel->refs.emplace(RefDir::In, "X", "X", std::vector<Affine>{Affine("i"), Affine()},
+                       SimpleShape(DataType::FLOAT32, {1, 8}));
+  kernel->refs.emplace(RefDir::Out, "Y", "Y", std::vector<Affine>{Affine("i")}, SimpleShape(DataType::INT8, {1}),
+                       "add");
+  kernel->stmts.push_back(std::make_shared<Load>("X", "$x"));
+  kernel->stmts.push_back(std::make_shared<Constant>("$c", 0.5));
+  kernel->stmts.push_back(std::make_shared<Constant>("$n", int64_t{-7}));
+  auto mul = std::make_shared<Intrinsic>();
+  mul->name = "mul";
+  mul->type = DataType::FLOAT32;
+  mul->inputs = {"$x", "$c"};
+  mul->outputs = {"$y"};
+  mul->deps = {kernel->stmts.begin(), std::next(kernel->stmts.begin())};
+  mul->set_attr("vector", 0.25);
+  kernel->stmts.push_back(mul);
+  kernel->stmts.push_back(std::make_shared<Store>("$y", "Y"));
+  kernel->stmts.back()->deps.push_back(std::prev(kernel->stmts.end(), 2));
+  kernel->stmts.push_back(std::make_shared<LoadIndex>(Affine("i", 2), "$i"));
+  auto special = std::make_shared<Special>();
+  special->name = "zero";
+  special->outputs = {"Y"};
+  special->int_params.emplace("n", 1);
+  special->str_params.emplace("mode", "fast");
+  kernel->stmts.push_back(special);
+  kernel->set_attr("note", std::string("kept"));
+  program.entry->stmts.push_back(kernel);
+
+  auto loaded = FromBinary(IntoBinary(program));
+  EXPECT_TRUE(google::protobuf::util::MessageDifferencer::Equals(IntoProto(*loaded), IntoProto(program)));
+  EXPECT_THAT(loaded->input_shapes, Eq(program.input_shapes));
+  auto loaded_kernel = Block::Downcast(loaded->entry->stmts.front());
+  ASSERT_TRUE(loaded_kernel);
+  EXPECT_THAT(loaded_kernel->get_attr_str("note"), Eq("kept"));
+  EXPECT_THAT(IntoBinary(*loaded), Eq(IntoBinary(program)));
+
+  auto bytes = IntoBinary(program);
+  EXPECT_THROW(FromBinary(std::string_view(bytes).substr(0, bytes.size() - 1)), std::runtime_error);
+  EXPECT_THROW(FromBinary("nonsense"), std::runtime_error);
+}
+
 }  // namespace
 }  // namespace stripe
 }  // namespace tile
@@ -0,0 +1,81 @@
+// Copyright 2019, Intel Corp.
+
+#include "tile/targets/cpu/aot.h"
+
+#if !defined(_WIN32)
+#include <dlfcn.h>
+#endif
+
+#include <stdexcept>
+
+#include "base/util/logging.h"
+#include "base/util/lookup.h"
+#include "tile/targets/cpu/link_names.h"
+#include "tile/targets/cpu/runtime.h"
+
+namespace vertexai {
+namespace tile {
+namespace targets {
+namespace cpu {
+
+#if defined(_WIN32)
+
+AotExecutable::AotExecutable(const std::string& path) {
+  throw std::runtime_error("Ahead-of-time CPU programs are not supported on Windows");
+}
+
+AotExecutable::~AotExecutable() {}
+
+#else  // !_WIN32
+
+AotExecutable::AotExecutable(const std::string& path) {
+  handle_ = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+  if (!handle_) {
+    throw std::runtime_error("Unable to load CPU program \"" + path + "\": " + dlerror());
+  }
+  entrypoint_ = reinterpret_cast<void (*)(void*)>(dlsym(handle_, invoker_name_));
+  auto params = static_cast<const char*>(dlsym(handle_, parameters_name_));
+  if (!entrypoint_ || !params) {
+    dlclose(handle_);
+    throw std::runtime_error("\"" + path + "\" is not an exported CPU program");
+  }
+  // The parameter names are packed into a single string table, each name
+  // terminated by a NUL, with an empty name marking the end of the table.
+  for (; *params; params += parameters_.back().size() + 1) {
+    parameters_.emplace_back(params);
+  }
+  auto arena_size = static_cast<const uint64_t*>(dlsym(handle_, arena_size_name_));
+  auto arena_flags = static_cast<const uint32_t*>(dlsym(handle_, arena_flags_name_));
+  auto arena_nodes = static_cast<const uint64_t*>(dlsym(handle_, arena_nodes_name_));
+  arenas_.reset(new rt::ArenaPool(arena_size ? *arena_size : 0, arena_flags ? *arena_flags : 0,
+                                  rt::ReadArenaPlacements(arena_nodes)));
+  IVLOG(1, "Loaded CPU program " << path << " with " << parameters_.size() << " parameter(s)");
+}
+
+AotExecutable::~AotExecutable() {
+  arenas_.reset();
+  dlclose(handle_);
+}
+
+#endif  // _WIN32
+
+std::vector<void*> AotExecutable::Bind(const std::map<std::string, void*>& buffers) const {
+  std::vector<void*> args(parameters_.size());
+  for (size_t i = 0; i < args.size(); ++i) {
+    args[i] = safe_at(buffers, parameters_[i]);
+  }
+  return args;
+}
+
+void AotExecutable::Run(const std::vector<void*>& args) {
+  if (args.size() != parameters_.size()) {
+    throw std::runtime_error("CPU program expects " + std::to_string(parameters_.size()) + " buffer(s), got " +
+                             std::to_string(args.size()));
+  }
+  rt::Invoke(entrypoint_, args, arenas_.get());
+}
+
+}  // namespace cpu
+}  // namespace targets
+}  // namespace tile
+}  // namespace vertexai
@@ -0,0 +1,52 @@
+// Copyright 2019, Intel Corp.
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tile/targets/cpu/runtime.h"
+
+namespace vertexai {
+namespace tile {
+namespace targets {
+namespace cpu {
+
+// Runs a program which Native::save exported as a shared library. This has no
+// dependency on LLVM; the library's references to the runtime support
+// functions are satisfied either by the runtime archive linked into the
+// library itself, or by the copy linked alongside this loader.
+class AotExecutable {
+ public:
+  explicit AotExecutable(const std::string& path);
+  ~AotExecutable();
+
+  AotExecutable(const AotExecutable&) = delete;
+  AotExecutable& operator=(const AotExecutable&) = delete;
+
+  // The names of the buffers the program expects, in invocation order.
+  const std::vector<std::string>& parameters() const { return parameters_; }
+
+  // Resolves named buffers into the argument vector the program expects.
+  std::vector<void*> Bind(const std::map<std::string, void*>& buffers) const;
+  // Runs the program; safe to call from several threads at once.
+  void Run(const std::vector<void*>& args);
+  void Run(const std::map<std::string, void*>& buffers) { Run(Bind(buffers)); }
+
+  // The size of the scratch arena each concurrent run of the program uses.
+  uint64_t arena_bytes() const { return arenas_ ? arenas_->size() : 0; }
+
+ private:
+  void* handle_ = nullptr;
+  void (*entrypoint_)(void*) = nullptr;
+  std::unique_ptr<rt::ArenaPool> arenas_;
+  std::vector<std::string> parameters_;
+};
+
+}  // namespace cpu
+}  // namespace targets
+}  // namespace tile
+}  // namespace vertexai
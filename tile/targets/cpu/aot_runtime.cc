@@ -0,0 +1,70 @@
+// Copyright 2019, Intel Corp.
+
+// C-linkage definitions of the runtime support functions, under the names the
+// code generator emits calls to. The JIT binds these names itself, so they
+// are only needed by programs compiled ahead of time into a shared library.
+
+#include <cstring>
+
+#include "tile/targets/cpu/runtime.h"
+
+namespace rt = vertexai::tile::targets::cpu::rt;
+
+extern "C" {
+
+float __gnu_h2f_ieee(uint16_t n) {
+  half_float::half h;
+  std::memcpy(&h, &n, sizeof(n));
+  return rt::h2f(h);
+}
+
+uint16_t __gnu_f2h_ieee(float n) {
+  half_float::half h = rt::f2h(n);
+  uint16_t ret;
+  std::memcpy(&ret, &h, sizeof(ret));
+  return ret;
+}
+
+void prng_step(uint32_t* in_state, uint32_t* out_state, float* buf, size_t count, size_t streams) {
+  rt::prng_step(in_state, out_state, buf, count, streams);
+}
+
+void RunTimeLogEntry(char* str, char* extra, float address) { rt::RunTimeLogEntry(str, extra, address); }
+
+void XSMMRTCaller(rt::libxsmm_function func, const void* aPtr, const void* bPtr, void* cPtr) {
+  rt::XSMMRTCaller(func, aPtr, bPtr, cPtr);
+}
+
+void XSMMReduceRTCaller(rt::libxsmm_reduce_function func, const void** aPtrs, const void** bPtrs, void* cPtr,
+                        size_t count) {
+  rt::XSMMReduceRTCaller(func, aPtrs, bPtrs, cPtr, count);
+}
+
+void ParallelFor(void** refs, ssize_t* inits, size_t range_size, rt::cpu_thread_block func, size_t grain_size,
+                 uint32_t flags) {
+  rt::ParallelFor(refs, inits, range_size, func, grain_size, flags);
+}
+
+void ParallelTasks(void*** refs, ssize_t** inits, rt::cpu_thread_block* funcs, size_t* ranges, size_t count,
+                   uint32_t flags) {
+  rt::ParallelTasks(refs, inits, funcs, ranges, count, flags);
+}
+
+void GatherRows(void* dest, const void* data, const int32_t* indices, size_t count, size_t data_rows,
+                size_t row_bytes, uint32_t flags) {
+  rt::GatherRows(dest, data, indices, count, data_rows, row_bytes, flags);
+}
+
+void CopyRows(void* dest, const void* src, size_t rows, size_t row_bytes, ssize_t dest_stride, ssize_t src_stride,
+              uint32_t flags) {
+  rt::CopyRows(dest, src, rows, row_bytes, dest_stride, src_stride, flags);
+}
+
+void ScatterAddRows(float* dest, const float* data, const int32_t* indices, size_t count, size_t dest_rows,
+                    size_t row_elems, uint32_t flags) {
+  rt::ScatterAddRows(dest, data, indices, count, dest_rows, row_elems, flags);
+}
+
+void AccumulateHwCounters(int64_t* totals, int64_t sign) { rt::AccumulateHwCounters(totals, sign); }
+
+}  // extern "C"
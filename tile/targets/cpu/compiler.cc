@@ -5,6 +5,7 @@
 #include <llvm/Bitcode/BitcodeWriter.h>
 #include <llvm/ExecutionEngine/ExecutionEngine.h>
 #include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Intrinsics.h>
 #include <llvm/IR/LegacyPassManager.h>
 #include <llvm/IR/Module.h>
 #include <llvm/IR/Verifier.h>
@@ -17,6 +18,7 @@
 #include <algorithm>
 #include <deque>
 #include <memory>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -26,6 +28,7 @@
 #include "tile/stripe/stripe.h"
 #include "tile/targets/cpu/executable.h"
 #include "tile/targets/cpu/link_names.h"
+#include "tile/targets/cpu/runtime.h"
 
 namespace vertexai {
 namespace tile {
@@ -39,6 +42,30 @@ class Error : public std::runtime_error {
   using std::runtime_error::runtime_error;
 };
 
+// Consecutive sibling blocks with equal values of this attribute are
+// independent, and may run concurrently.
+const char kTaskGroup[] = "cpu_task_group";
+
+// Contiguous copies up to this size are emitted inline rather than through
+// the runtime, which would only divide larger ones among threads.
+const size_t kInlineCopyBytes = 65536;
+
+// The most tile pairs a batch-reduce GEMM takes at once; larger blocks are
+// reduced in several calls.
+const size_t kXSMMReduceBatch = 512;
+
+// Whether a shape's elements are laid out contiguously in row-major order.
+static bool IsDense(const TensorShape& shape) {
+  uint64_t stride = 1;
+  for (size_t i = shape.dims.size(); i-- > 0;) {
+    if (shape.dims[i].size != 1 && shape.dims[i].stride != static_cast<int64_t>(stride)) {
+      return false;
+    }
+    stride *= shape.dims[i].size;
+  }
+  return true;
+}
+
 Compiler::Compiler(llvm::LLVMContext* context, const Config& config)
     : context_(*context), builder_{context_}, config_{config}, arenaSize_(0) {
   static std::once_flag init_once;
@@ -50,19 +77,29 @@ Compiler::Compiler(llvm::LLVMContext* context, const Config& config)
   });
 }
 
-ProgramModule Compiler::CompileProgram(const stripe::Block& program) {
+ProgramModule Compiler::DeclareProgram(const stripe::Block& program, const std::string& name) {
+  // Create an empty module configured for the host, along with the list of
+  // parameters the program expects; the caller can supply the code for the
+  // module from elsewhere, e.g. a previously compiled object.
+  ProgramModule ret;
+  ret.module = std::make_unique<llvm::Module>(name, context_);
+  auto machine = CreateTargetMachine();
+  ret.module->setDataLayout(machine->createDataLayout());
+  ret.module->setTargetTriple(machine->getTargetTriple().str());
+  for (auto& ref : program.refs) {
+    if (ref.has_tag("user")) {
+      ret.parameters.push_back(ref.into());
+    }
+  }
+  return ret;
+}
+
+ProgramModule Compiler::CompileProgram(const stripe::Block& program, const std::string& name) {
   IVLOG(4, program);
   // Compile each block in this program into a function within an LLVM module.
-  ProgramModule ret;
-  ret.module = std::make_unique<llvm::Module>("stripe", context_);
+  ProgramModule ret = DeclareProgram(program, name);
   module_ = ret.module.get();
-
-  auto targetTriple = llvm::sys::getProcessTriple();
-  std::string errorMessage;
-  auto target = llvm::TargetRegistry::lookupTarget(targetTriple, errorMessage);
-  std::unique_ptr<llvm::TargetMachine> machine(target->createTargetMachine(targetTriple, "generic", "", {}, {}));
-  module_->setDataLayout(machine->createDataLayout());
-  module_->setTargetTriple(targetTriple);
+  auto machine = CreateTargetMachine();
 
   GenerateArena(program);
   llvm::Function* main = CompileBlock(program);
@@ -70,17 +107,6 @@ ProgramModule Compiler::CompileProgram(const stripe::Block& program) {
   // Generate a stub function we can invoke from the outside, passing buffers
   // as an array of generic pointers.
   GenerateInvoker(program, main);
-  // Improve the simple-minded IR we've just generated by running module-level
-  // optimization passes; among many other things, this will streamline our
-  // loops to eliminate most branches and inline most block function calls.
-  llvm::PassManagerBuilder pmb;
-  pmb.OptLevel = 3;
-  pmb.SizeLevel = 0;
-  pmb.SLPVectorize = true;
-  pmb.LoopVectorize = true;
-  pmb.MergeFunctions = true;
-  llvm::legacy::PassManager modopt;
-  pmb.populateModulePassManager(modopt);
   if (config_.print_llvm_ir_simple) {
     llvm::errs() << "LLVM IR, unoptimized: ================\n";
     module_->print(llvm::errs(), nullptr);
@@ -88,7 +114,12 @@ ProgramModule Compiler::CompileProgram(const stripe::Block& program) {
   if (llvm::verifyModule(*module_, &llvm::errs())) {
     throw std::runtime_error("Byte");
   }
-  modopt.run(*module_);
+  if (config_.lazy_compile) {
+    // The lazy JIT optimizes each function as it is materialized.
+    module_ = nullptr;
+    return ret;
+  }
+  Optimize(module_);
   if (config_.print_llvm_ir_optimized) {
     llvm::errs() << "LLVM IR, after optimization: ================\n";
     module_->print(llvm::errs(), nullptr);
@@ -97,17 +128,36 @@ ProgramModule Compiler::CompileProgram(const stripe::Block& program) {
     llvm::errs() << "Assembly code: ================\n";
     PrintOutputAssembly(machine.get());
   }
-  // Wrap the finished module and the parameter names into a ProgramModule.
-  for (auto& ref : program.refs) {
-    if (ref.has_tag("user")) {
-      ret.parameters.push_back(ref.into());
-    }
-  }
   module_ = nullptr;
   assert(ret.module);
   return ret;
 }
 
+void Compiler::Optimize(llvm::Module* module) {
+  // Improve the simple-minded IR we've just generated by running module-level
+  // optimization passes; among many other things, this will streamline our
+  // loops to eliminate most branches and inline most block function calls.
+  llvm::PassManagerBuilder pmb;
+  pmb.OptLevel = 3;
+  pmb.SizeLevel = 0;
+  pmb.SLPVectorize = true;
+  pmb.LoopVectorize = true;
+  pmb.MergeFunctions = true;
+  llvm::legacy::PassManager modopt;
+  pmb.populateModulePassManager(modopt);
+  modopt.run(*module);
+}
+
+std::unique_ptr<llvm::TargetMachine> Compiler::CreateTargetMachine() {
+  auto targetTriple = llvm::sys::getProcessTriple();
+  std::string errorMessage;
+  auto target = llvm::TargetRegistry::lookupTarget(targetTriple, errorMessage);
+  if (!target) {
+    throw Error("Unable to find target for " + targetTriple + ": " + errorMessage);
+  }
+  return std::unique_ptr<llvm::TargetMachine>(target->createTargetMachine(targetTriple, "generic", "", {}, {}));
+}
+
 Compiler::Compiler(llvm::LLVMContext* context, llvm::Module* module, const Config& config)
     : context_(*context), builder_{context_}, module_(module), config_{config}, arenaSize_(0) {
   // This private constructor sets up a nested instance which will
@@ -121,7 +171,9 @@ void Compiler::GenerateInvoker(const stripe::Block& program, llvm::Function* mai
   // buffer parameters it expects. From C, we will prepare a vector of void*,
   // containing the parameter buffer data pointers; the wrapper will extract
   // each data pointer, then pass each one as a parameter when it calls the
-  // program's top-level block function.
+  // program's top-level block function. The vector ends with one more
+  // pointer, to the scratch arena for this invocation; the caller owns the
+  // arena, so that concurrent invocations never share one.
   assert(!program.has_tag("cpu_thread"));
   // LLVM doesn't have the notion of a void pointer, so we'll pretend all of
   // these buffers are arrays of int8, then bitcast later.
@@ -142,15 +194,7 @@ void Compiler::GenerateInvoker(const stripe::Block& program, llvm::Function* mai
   std::vector<llvm::Value*> args;
   std::vector<llvm::Value*> allocs;
   {
-    if (arenaSize_) {
-      IVLOG(1, "Arena size: " << arenaSize_);
-      // allocate the arena on the heap. This way static initialization order is never an issue.
-      auto buffer = Malloc(arenaSize_);
-      auto arena_gval = module_->getNamedGlobal(arena_name_);
-      auto arenatype = llvm::ArrayType::get(builder_.getInt8Ty(), 1)->getPointerTo();
-      builder_.CreateStore(builder_.CreateBitCast(buffer, arenatype), arena_gval);
-      allocs.push_back(buffer);
-    }
+    IVLOG(1, "Arena size: " << arenaSize_);
     unsigned i = 0;
     for (auto& ref : program.refs) {
       if (ref.has_tag("user")) {
@@ -178,6 +222,17 @@ void Compiler::GenerateInvoker(const stripe::Block& program, llvm::Function* mai
   for (unsigned i = 0; i < program.idxs.size(); ++i) {
     args.push_back(IndexConst(0));
   }
+  // Finally, the arena follows the user parameters in the argument vector.
+  {
+    unsigned arena_slot = 0;
+    for (auto& ref : program.refs) {
+      if (ref.has_tag("user")) {
+        arena_slot++;
+      }
+    }
+    llvm::Value* elptr = builder_.CreateGEP(argvec, {builder_.getInt32(arena_slot)});
+    args.push_back(builder_.CreateLoad(elptr, "arena"));
+  }
   // Having built the argument list, we'll call the actual kernel using the
   // parameter signature it expects.
   builder_.CreateCall(main, args, "");
@@ -186,6 +241,18 @@ void Compiler::GenerateInvoker(const stripe::Block& program, llvm::Function* mai
     Free(ptr);
   }
   builder_.CreateRetVoid();
+  // Record the parameter names in invocation order, so that a program saved
+  // ahead of time can be invoked without access to its Stripe source. The
+  // names are NUL-terminated, with an empty name marking the end of the table.
+  std::string param_table;
+  for (auto& ref : program.refs) {
+    if (ref.has_tag("user")) {
+      param_table += ref.into();
+      param_table.push_back('\0');
+    }
+  }
+  auto params = llvm::ConstantDataArray::getString(context_, param_table, true);
+  new llvm::GlobalVariable(*module_, params->getType(), true, linkage, params, parameters_name_);
 }
 
 uint64_t Compiler::MeasureArena(const stripe::Block& block) {
@@ -211,12 +278,59 @@ uint64_t Compiler::MeasureArena(const stripe::Block& block) {
   return extent;
 }
 
+void Compiler::PlaceArena(const stripe::Block& block, std::vector<uint64_t>* table) {
+  // Collect the arena ranges of the placed refinements assigned to a node.
+  for (const auto& ref : block.refs) {
+    if (!ref.has_tag("placed") || ref.dir != stripe::RefDir::None || !ref.from.empty()) {
+      continue;
+    }
+    auto node = NumaNode(ref.location);
+    if (node >= 0) {
+      table->insert(table->end(), {ref.offset, ref.interior_shape.byte_size(), static_cast<uint64_t>(node)});
+    }
+  }
+  for (const auto& stmt : block.stmts) {
+    if (auto inner = stripe::Block::Downcast(stmt)) {
+      PlaceArena(*inner, table);
+    }
+  }
+}
+
+int64_t Compiler::NumaNode(const stripe::Location& location) const {
+  // The node is the constant unit of the configured NUMA device, if any.
+  for (const auto& dev : location.devs) {
+    if (dev.name != config_.numa_device) {
+      continue;
+    }
+    for (const auto& unit : dev.units) {
+      if (unit.isConstant()) {
+        return unit.constant();
+      }
+    }
+  }
+  return -1;
+}
+
 void Compiler::GenerateArena(const stripe::Block& block) {
   arenaSize_ = MeasureArena(block);
-  auto arenatype = llvm::ArrayType::get(builder_.getInt8Ty(), 1)->getPointerTo();
-  module_->getOrInsertGlobal(arena_name_, arenatype);
-  auto gval = module_->getNamedGlobal(arena_name_);
-  gval->setInitializer(llvm::Constant::getNullValue(arenatype));
+  // Publish the arena size and allocation flags; whoever invokes the program
+  // allocates (and may reuse) an arena for each invocation.
+  auto linkage = llvm::GlobalValue::ExternalLinkage;
+  auto sizetype = builder_.getInt64Ty();
+  auto size = llvm::ConstantInt::get(sizetype, arenaSize_);
+  new llvm::GlobalVariable(*module_, sizetype, true, linkage, size, arena_size_name_);
+  auto flagstype = builder_.getInt32Ty();
+  auto flags = llvm::ConstantInt::get(flagstype, ParallelForFlags());
+  new llvm::GlobalVariable(*module_, flagstype, true, linkage, flags, arena_flags_name_);
+  // Publish the NUMA placements of the arena's refinements, as a count
+  // followed by (offset, size, node) triples; see rt::ReadArenaPlacements.
+  std::vector<uint64_t> table{0};
+  if (config_.numa_arenas) {
+    PlaceArena(block, &table);
+    table[0] = (table.size() - 1) / 3;
+  }
+  auto nodes = llvm::ConstantDataArray::get(context_, table);
+  new llvm::GlobalVariable(*module_, nodes->getType(), true, linkage, nodes, arena_nodes_name_);
 }
 
 llvm::Function* Compiler::CompileXSMMBlock(const stripe::Block& block, const XSMMDispatch xsmmDispatch,
@@ -250,6 +364,11 @@ llvm::Function* Compiler::CompileXSMMBlock(const stripe::Block& block, const XSM
   // Associate parameter values with buffers and indexes
   for (auto ai = function->arg_begin(); ai != function->arg_end(); ++ai) {
     unsigned idx = ai->getArgNo();
+    if (idx == block.refs.size() + block.idxs.size()) {
+      ai->setName("arena");
+      arena_ = &(*ai);
+      continue;
+    }
     if (idx < block.refs.size()) {
       auto it = block.refs.begin();
       std::advance(it, idx);
@@ -521,6 +640,8 @@ llvm::Function* Compiler::CompileThreadedBlock(const stripe::Block& block) {
     std::string refName = it->into();
     buffers_[refName].base = builder_.CreateBitCast(refPtr, buftype);
   }
+  // The arena follows the refinements.
+  arena_ = builder_.CreateLoad(builder_.CreateConstGEP1_32(refsArray, block.refs.size()), "arena");
   // Second parameter points to an array of index init values.
   llvm::Value* initsArray = function->getArg(1);
   for (unsigned i = 0; i < block.idxs.size(); ++i) {
@@ -565,10 +686,7 @@ llvm::Function* Compiler::CompileThreadedBlock(const stripe::Block& block) {
 
   // process each statement in the block body, generating code to modify the
   // parameter buffer contents
-  std::shared_ptr<stripe::Block> pBlock = std::make_shared<stripe::Block>(block);
-  for (const auto& stmt : block.stmts) {
-    stmt->Accept(this);
-  }
+  VisitStatements(block);
 
   // rejoin instruction flow after the constraint check
   builder_.CreateBr(block_done);
@@ -581,8 +699,207 @@ llvm::Function* Compiler::CompileThreadedBlock(const stripe::Block& block) {
   return function;
 }
 
+const stripe::Block* Compiler::GetXSMMReduceChild(const stripe::Block& block, XSMMCallData* xsmmCallData) {
+  // A block qualifies for a batch-reduce GEMM when its only statement is an
+  // SMM-compatible XSMM block and every one of its own indexes is a
+  // reduction index: the output tile stays put while the input tiles move.
+  // The whole loop nest then collapses into a single libxsmm call which
+  // accumulates all of the tile products.
+  if (block.has_tag("xsmm") || block.has_tag("cpu_thread") || config_.profile_loop_body) {
+    return nullptr;
+  }
+  if (block.stmts.size() != 1 || !block.constraints.empty() || block.idxs_product() < 2) {
+    return nullptr;
+  }
+  auto inner = stripe::Block::Downcast(block.stmts.front());
+  if (!inner || getCompileFor(*inner) != XSMM_BLOCK || GetXSMMDispatch(*inner) != XSMMDispatch::SMM ||
+      !GetXSMMCallData(xsmmCallData, *inner)) {
+    return nullptr;
+  }
+  for (const auto& ref : block.refs) {
+    if (ref.dir == stripe::RefDir::None && ref.from.empty()) {
+      return nullptr;  // Local allocations are not supported here.
+    }
+  }
+  for (const auto& ref : inner->refs) {
+    if (ref.dir == stripe::RefDir::None && ref.from.empty()) {
+      return nullptr;
+    }
+  }
+  for (const auto& idx : inner->idxs) {
+    if (!(idx.affine == stripe::Affine())) {
+      return nullptr;  // The tile offsets must not depend on this block's indexes.
+    }
+  }
+  const auto& out = *xsmmCallData->out0;
+  auto out_ref = block.ref_by_into(out.from.empty() ? out.into() : out.from, false);
+  if (out_ref == block.refs.end() || (out.agg_op != "add" && out_ref->agg_op != "add")) {
+    return nullptr;
+  }
+  auto out_access = out_ref->FlatAccess();
+  for (const auto& idx : block.idxs) {
+    if (out_access[idx.name] != 0) {
+      return nullptr;
+    }
+  }
+  return inner.get();
+}
+
+llvm::Function* Compiler::CompileXSMMReduceBlock(const stripe::Block& block, const stripe::Block& inner,
+                                                 const XSMMCallData& xsmmCallData) {
+  // Generate a function with the signature of a normal block, whose loops
+  // gather the address of each pair of input tiles, then hand the whole
+  // batch to a single batch-reduce GEMM.
+  for (const auto& ref : block.refs) {
+    buffers_[ref.into()] = Buffer{&ref};
+  }
+  for (const auto& idx : block.idxs) {
+    indexes_[idx.name] = Index{&idx};
+  }
+  auto linkage = llvm::Function::ExternalLinkage;
+  auto function = llvm::Function::Create(BlockType(block), linkage, block.name, module_);
+  auto bb = llvm::BasicBlock::Create(context_, "entry", function);
+  builder_.SetInsertPoint(bb);
+  for (auto ai = function->arg_begin(); ai != function->arg_end(); ++ai) {
+    unsigned idx = ai->getArgNo();
+    if (idx == block.refs.size() + block.idxs.size()) {
+      ai->setName("arena");
+      arena_ = &(*ai);
+      continue;
+    }
+    if (idx < block.refs.size()) {
+      auto it = block.refs.begin();
+      std::advance(it, idx);
+      ai->setName(it->into());
+      buffers_[it->into()].base = &(*ai);
+    } else {
+      std::string param_name = block.idxs[idx - block.refs.size()].name;
+      ai->setName(param_name);
+      indexes_[param_name].init = &(*ai);
+    }
+  }
+  for (auto& idx : block.idxs) {
+    llvm::Value* variable = builder_.CreateAlloca(IndexType());
+    variable->setName(idx.name);
+    indexes_[idx.name].variable = variable;
+  }
+
+  // The element pointer for one of the inner block's refinements, at the
+  // current values of this block's indexes.
+  auto i32t = builder_.getInt32Ty();
+  auto tilePtr = [&](const stripe::Refinement* ref, int32_t offset) {
+    auto from = ref->from.empty() ? ref->into() : ref->from;
+    llvm::Value* ptr = ElementPtr(buffers_[from]);
+    if (offset) {
+      ptr = builder_.CreateGEP(ptr, llvm::ConstantInt::get(i32t, offset));
+    }
+    return ptr;
+  };
+
+  // The output tile does not depend on any of this block's indexes.
+  llvm::Value* out_ptr = tilePtr(xsmmCallData.out0, xsmmCallData.offset_out0);
+
+  // The pointer arrays live on the stack, so batches larger than
+  // kXSMMReduceBatch are handed to the kernel in chunks; since beta is one,
+  // each chunk accumulates into the output tile.
+  size_t count = block.idxs_product();
+  size_t batch = std::min<size_t>(count, kXSMMReduceBatch);
+  auto floatPtrType = llvm::Type::getFloatPtrTy(context_);
+  auto ptrArrayType = llvm::ArrayType::get(floatPtrType, batch);
+  llvm::Value* a_ptrs = builder_.CreateBitCast(builder_.CreateAlloca(ptrArrayType), floatPtrType->getPointerTo());
+  llvm::Value* b_ptrs = builder_.CreateBitCast(builder_.CreateAlloca(ptrArrayType), floatPtrType->getPointerTo());
+  llvm::Value* slot = builder_.CreateAlloca(IndexType());
+  builder_.CreateStore(IndexConst(0), slot);
+
+  llvm::Value* lda = builder_.CreateAlloca(i32t);
+  llvm::Value* ldb = builder_.CreateAlloca(i32t);
+  llvm::Value* ldc = builder_.CreateAlloca(i32t);
+  builder_.CreateStore(llvm::ConstantInt::get(i32t, xsmmCallData.lda_a_value), lda);
+  builder_.CreateStore(llvm::ConstantInt::get(i32t, xsmmCallData.lda_b_value), ldb);
+  builder_.CreateStore(llvm::ConstantInt::get(i32t, xsmmCallData.lda_c_value), ldc);
+  llvm::Value* alpha = builder_.CreateAlloca(builder_.getFloatTy());
+  llvm::Value* beta = builder_.CreateAlloca(builder_.getFloatTy());
+  builder_.CreateStore(FloatConst(1.0f), alpha);
+  builder_.CreateStore(FloatConst(1.0f), beta);
+  llvm::Value* nptr = llvm::ConstantPointerNull::get(llvm::Type::getInt32PtrTy(context_));
+
+  // libxsmm_smmfunction_reducebatch takes (const float** a, const float** b,
+  // float* c, const unsigned long long* count).
+  auto u64PtrType = builder_.getInt64Ty()->getPointerTo();
+  std::vector<llvm::Type*> kernel_params{floatPtrType->getPointerTo(), floatPtrType->getPointerTo(), floatPtrType,
+                                         u64PtrType};
+  auto kernelType = llvm::FunctionType::get(builder_.getVoidTy(), kernel_params, false);
+  std::vector<llvm::Type*> dispatch_params{
+      i32t, i32t, i32t, lda->getType(), ldb->getType(), ldc->getType(), floatPtrType, floatPtrType, nptr->getType(),
+      nptr->getType()};
+  auto dispatchType = llvm::FunctionType::get(kernelType->getPointerTo(), dispatch_params, false);
+  auto dispatch = module_->getOrInsertFunction("libxsmm_smmdispatch_reducebatch", dispatchType).getCallee();
+  std::vector<llvm::Value*> dispatch_args{
+      llvm::ConstantInt::get(i32t, FindIndexByTag(inner, "stencil_m")->range),
+      llvm::ConstantInt::get(i32t, FindIndexByTag(inner, "stencil_n")->range),
+      llvm::ConstantInt::get(i32t, FindIndexByTag(inner, "stencil_k")->range),
+      lda,
+      ldb,
+      ldc,
+      alpha,
+      beta,
+      nptr,
+      nptr};
+  llvm::Value* kernel = builder_.CreateCall(dispatch, dispatch_args);
+
+  std::vector<llvm::Type*> caller_params{kernel->getType(), floatPtrType->getPointerTo(),
+                                         floatPtrType->getPointerTo(), floatPtrType, IndexType()};
+  auto callerType = llvm::FunctionType::get(builder_.getVoidTy(), caller_params, false);
+  auto caller = module_->getOrInsertFunction("XSMMReduceRTCaller", callerType).getCallee();
+  out_ptr = builder_.CreateBitCast(out_ptr, floatPtrType);
+
+  std::vector<Loop> loops(block.idxs.size());
+  for (size_t i = 0; i < block.idxs.size(); ++i) {
+    const auto& idx = indexes_[block.idxs[i].name];
+    CreateLoop(&loops[i], block.idxs[i].name);
+    EnterLoop(&loops[i], idx.variable, idx.init, builder_.CreateAdd(idx.init, IndexConst(block.idxs[i].range)));
+  }
+  // As with XSMM_BLOCK, libxsmm's A operand is the refinement tagged "B".
+  llvm::Value* cur = builder_.CreateLoad(slot);
+  builder_.CreateStore(tilePtr(xsmmCallData.in1, xsmmCallData.offset_in1), builder_.CreateGEP(a_ptrs, cur));
+  builder_.CreateStore(tilePtr(xsmmCallData.in0, xsmmCallData.offset_in0), builder_.CreateGEP(b_ptrs, cur));
+  llvm::Value* next = builder_.CreateAdd(cur, IndexConst(1));
+  builder_.CreateStore(next, slot);
+  if (batch < count) {
+    auto flush = llvm::BasicBlock::Create(context_, "flush", function);
+    auto resume = llvm::BasicBlock::Create(context_, "resume", function);
+    builder_.CreateCondBr(builder_.CreateICmpEQ(next, IndexConst(batch)), flush, resume);
+    builder_.SetInsertPoint(flush);
+    builder_.CreateCall(callerType, caller, {kernel, a_ptrs, b_ptrs, out_ptr, IndexConst(batch)});
+    builder_.CreateStore(IndexConst(0), slot);
+    builder_.CreateBr(resume);
+    builder_.SetInsertPoint(resume);
+  }
+  for (size_t i = block.idxs.size(); i-- > 0;) {
+    LeaveLoop(&loops[i], indexes_[block.idxs[i].name].variable);
+  }
+
+  // Whatever remains after the last full batch (all of it, if count fits).
+  llvm::Value* rest = builder_.CreateLoad(slot);
+  auto tail = llvm::BasicBlock::Create(context_, "tail", function);
+  auto done = llvm::BasicBlock::Create(context_, "done", function);
+  builder_.CreateCondBr(builder_.CreateICmpNE(rest, IndexConst(0)), tail, done);
+  builder_.SetInsertPoint(tail);
+  builder_.CreateCall(callerType, caller, {kernel, a_ptrs, b_ptrs, out_ptr, rest});
+  builder_.CreateBr(done);
+  builder_.SetInsertPoint(done);
+  builder_.CreateRetVoid();
+  return function;
+}
+
 llvm::Function* Compiler::CompileBlock(const stripe::Block& block) {
   CompileFor compileFor = getCompileFor(block);
+  if (compileFor == NORMAL_BLOCK) {
+    XSMMCallData xsmmCallData;
+    if (auto inner = GetXSMMReduceChild(block, &xsmmCallData)) {
+      return CompileXSMMReduceBlock(block, *inner, xsmmCallData);
+    }
+  }
   if (compileFor == XSMM_BLOCK) {
     assert(!block.has_tag("cpu_thread"));
     const XSMMDispatch xsmmDispatch = GetXSMMDispatch(block);
@@ -620,6 +937,11 @@ llvm::Function* Compiler::CompileBlock(const stripe::Block& block) {
   // Then, a parameter for each index, containing the initial value.
   for (auto ai = function->arg_begin(); ai != function->arg_end(); ++ai) {
     unsigned idx = ai->getArgNo();
+    if (idx == block.refs.size() + block.idxs.size()) {
+      ai->setName("arena");
+      arena_ = &(*ai);
+      continue;
+    }
     if (idx < block.refs.size()) {
       auto it = block.refs.begin();
       std::advance(it, idx);
@@ -680,10 +1002,7 @@ llvm::Function* Compiler::CompileBlock(const stripe::Block& block) {
 
   // process each statement in the block body, generating code to modify the
   // parameter buffer contents
-  std::shared_ptr<stripe::Block> pBlock = std::make_shared<stripe::Block>(block);
-  for (const auto& stmt : block.stmts) {
-    stmt->Accept(this);
-  }
+  VisitStatements(block);
 
   ProfileLoopLeave(block);
 
@@ -817,6 +1136,7 @@ void Compiler::Visit(const stripe::Special& special) {
       {"agg_init_max", &Compiler::AggInitMax},  //
       {"scatter", &Compiler::Scatter},          //
       {"gather", &Compiler::Gather},            //
+      {"prefetch", &Compiler::Prefetch},        //
   };
   auto it = handlers.find(special.name);
   if (it == handlers.end()) {
@@ -904,35 +1224,33 @@ void Compiler::Visit(const stripe::Intrinsic& intrinsic) {
   }
 }
 
-void Compiler::Visit(const stripe::Block& block) {
+llvm::Function* Compiler::CompileNested(const stripe::Block& block) {
   // Compile a nested block as a function in the same module
   Compiler nested(&context_, module_, config_);
   auto function = nested.CompileBlock(block);
   for (auto& fptr_iter : nested.external_funcptrs_) {
     external_funcptrs_.emplace(fptr_iter);
   }
+  return function;
+}
 
-  ProfileBlockEnter(block);
-  // Generate a list of args.
+void Compiler::BlockArgs(const stripe::Block& block, std::vector<llvm::Value*>* refs, std::vector<llvm::Value*>* idxs,
+                         std::vector<llvm::Value*>* allocs) {
   // The argument list begins with a pointer to each refinement. We will either
   // pass along the address of a refinement from the current block, or allocate
   // a new buffer for the nested block's use.
-  std::vector<llvm::Value*> refs;
-  std::vector<llvm::Value*> allocs;
   for (auto& ref : block.refs) {
     llvm::Value* buffer = nullptr;
     // When a refinement is neither in nor out, and it has no "from"
     // name, it represents a local allocation.
     if (ref.dir == stripe::RefDir::None && ref.from.empty()) {
       if (ref.has_tag("placed")) {
-        auto arena = module_->getNamedGlobal(arena_name_);
-        auto baseArenaAddress = builder_.CreateLoad(arena);
         std::vector<llvm::Value*> idxList{IndexConst(ref.offset)};
-        buffer = builder_.CreateGEP(baseArenaAddress, idxList);
+        buffer = builder_.CreateGEP(arena_, idxList);
       } else {
         // Allocate new storage for the buffer.
         buffer = Malloc(ref.interior_shape.byte_size());
-        allocs.push_back(buffer);
+        allocs->push_back(buffer);
       }
       llvm::Type* buftype = CType(ref.interior_shape.type)->getPointerTo();
       buffer = builder_.CreateBitCast(buffer, buftype, ref.into());
@@ -943,54 +1261,102 @@ void Compiler::Visit(const stripe::Block& block) {
       std::string name = ref.from.empty() ? ref.into() : ref.from;
       buffer = ElementPtr(buffers_[name]);
     }
-    refs.push_back(buffer);
+    refs->push_back(buffer);
   }
   // Following the list of refinement args, we will provide a list of initial
   // values for each of the block's indexes, which are specified as an affine
   // in terms of the current block's indexes.
-  std::vector<llvm::Value*> idxs;
   for (auto& idx : block.idxs) {
-    idxs.push_back(Eval(idx.affine));
+    idxs->push_back(Eval(idx.affine));
+  }
+}
+
+llvm::Value* Compiler::ThreadedRefs(const std::vector<llvm::Value*>& refs) {
+  // Combine the bufs into an array, followed by the arena.
+  auto int8PtrType = builder_.getInt8Ty()->getPointerTo();
+  auto int8PtrArrayType = llvm::ArrayType::get(int8PtrType, refs.size() + 1);
+  llvm::Value* bufsArg = builder_.CreateAlloca(int8PtrArrayType);
+  bufsArg = builder_.CreateBitCast(bufsArg, int8PtrType->getPointerTo());
+  for (size_t i = 0; i < refs.size(); ++i) {
+    llvm::Value* castRef = builder_.CreateBitCast(refs[i], int8PtrType);
+    llvm::Value* elementPtr = builder_.CreateConstGEP1_32(bufsArg, i);
+    builder_.CreateStore(castRef, elementPtr);
+  }
+  builder_.CreateStore(arena_, builder_.CreateConstGEP1_32(bufsArg, refs.size()));
+  return bufsArg;
+}
+
+llvm::Value* Compiler::ThreadedInits(const std::vector<llvm::Value*>& idxs) {
+  // Combine the idx inits into an array.
+  auto indexArrayType = llvm::ArrayType::get(IndexType(), idxs.size());
+  llvm::Value* initsArg = builder_.CreateAlloca(indexArrayType);
+  initsArg = builder_.CreateBitCast(initsArg, IndexType()->getPointerTo());
+  for (size_t i = 0; i < idxs.size(); ++i) {
+    llvm::Value* elementPtr = builder_.CreateConstGEP1_32(initsArg, i);
+    builder_.CreateStore(idxs[i], elementPtr);
+  }
+  return initsArg;
+}
+
+void Compiler::VisitStatements(const stripe::Block& block) {
+  // Consecutive sub-blocks of the same task group were found independent of
+  // one another by ThreadInnerPass, and run concurrently.
+  std::vector<const stripe::Block*> tasks;
+  auto flush = [&] {
+    if (tasks.size() == 1) {
+      Visit(*tasks.front());
+    } else if (tasks.size() > 1) {
+      VisitTasks(tasks);
+    }
+    tasks.clear();
+  };
+  for (const auto& stmt : block.stmts) {
+    auto inner = stripe::Block::Downcast(stmt);
+    if (inner && inner->has_attr(kTaskGroup) && getCompileFor(*inner) == THREADED_BLOCK) {
+      if (!tasks.empty() && tasks.back()->get_attr_int(kTaskGroup) != inner->get_attr_int(kTaskGroup)) {
+        flush();
+      }
+      tasks.push_back(inner.get());
+      continue;
+    }
+    flush();
+    stmt->Accept(this);
   }
+  flush();
+}
+
+void Compiler::Visit(const stripe::Block& block) {
+  auto function = CompileNested(block);
+
+  ProfileBlockEnter(block);
+  // Generate a list of args.
+  std::vector<llvm::Value*> refs;
+  std::vector<llvm::Value*> idxs;
+  std::vector<llvm::Value*> allocs;
+  BlockArgs(block, &refs, &idxs, &allocs);
 
   // Assemble the argument list and invoke the function.
   if (getCompileFor(block) == THREADED_BLOCK) {
     assert(!block.has_tag("xsmm"));
-    // Combine the bufs into an array; pass it as the first parameter.
-    auto int8PtrType = builder_.getInt8Ty()->getPointerTo();
-    auto int8PtrArrayType = llvm::ArrayType::get(int8PtrType, refs.size());
-    llvm::Value* bufsArg = builder_.CreateAlloca(int8PtrArrayType);
-    bufsArg = builder_.CreateBitCast(bufsArg, int8PtrType->getPointerTo());
-    for (size_t i = 0; i < refs.size(); ++i) {
-      llvm::Value* castRef = builder_.CreateBitCast(refs[i], int8PtrType);
-      llvm::Value* elementPtr = builder_.CreateConstGEP1_32(bufsArg, i);
-      builder_.CreateStore(castRef, elementPtr);
-    }
-    // Combine the idx inits into an array; pass it as the second parameter.
-    auto indexArrayType = llvm::ArrayType::get(IndexType(), idxs.size());
-    llvm::Value* initsArg = builder_.CreateAlloca(indexArrayType);
-    initsArg = builder_.CreateBitCast(initsArg, IndexType()->getPointerTo());
-    for (size_t i = 0; i < idxs.size(); ++i) {
-      llvm::Value* elementPtr = builder_.CreateConstGEP1_32(initsArg, i);
-      builder_.CreateStore(idxs[i], elementPtr);
-    }
-    if (!block.idxs.empty()) {
-      size_t total_range = 1;
-      for (auto& idx : block.idxs) {
-        total_range *= idx.range;
-      }
-      ParallelFor(bufsArg, initsArg, total_range, function);
+    // The bufs array is the first parameter; the idx inits array is the second.
+    llvm::Value* bufsArg = ThreadedRefs(refs);
+    llvm::Value* initsArg = ThreadedInits(idxs);
+    size_t total_range = block.idxs_product();
+    if (total_range > 1) {
+      ParallelFor(bufsArg, initsArg, total_range, function, ParallelForFlags(block.location));
     } else {
-      // There is no point in using ParallelFor to invoke a block which has no
-      // indexes, since there is no way to divide the work among threads.
-      auto zero = IndexConst(0);
-      builder_.CreateCall(function, {bufsArg, initsArg, zero, zero});
+      // There is no point in using ParallelFor to invoke a block with a
+      // single iteration, since there is no way to divide the work among
+      // threads.
+      builder_.CreateCall(function, {bufsArg, initsArg, IndexConst(0), IndexConst(total_range)});
     }
   } else {
-    // Argument list consists of the refinements, followed by the index inits.
+    // Argument list consists of the refinements, followed by the index inits
+    // and the arena.
     std::vector<llvm::Value*> args;
     args.insert(args.end(), refs.begin(), refs.end());
     args.insert(args.end(), idxs.begin(), idxs.end());
+    args.push_back(arena_);
     // Invoke the function. It does not return a value.
     builder_.CreateCall(function, args, "");
   }
@@ -1003,6 +1369,52 @@ void Compiler::Visit(const stripe::Block& block) {
   ProfileBlockLeave(block);
 }
 
+void Compiler::VisitTasks(const std::vector<const stripe::Block*>& tasks) {
+  // Each task is compiled as a threaded block; their argument arrays, entry
+  // points, and ranges are gathered into arrays for the runtime. Profiling
+  // charges each task with the time of the whole group.
+  auto refsType = builder_.getInt8Ty()->getPointerTo()->getPointerTo();
+  auto initsType = IndexType()->getPointerTo();
+  std::vector<llvm::Type*> blockArgTypes{refsType, initsType, IndexType(), IndexType()};
+  auto blockPtrType = llvm::FunctionType::get(builder_.getVoidTy(), blockArgTypes, false)->getPointerTo();
+  auto allocArray = [&](llvm::Type* type) {
+    llvm::Value* array = builder_.CreateAlloca(llvm::ArrayType::get(type, tasks.size()));
+    return builder_.CreateBitCast(array, type->getPointerTo());
+  };
+  llvm::Value* refsArg = allocArray(refsType);
+  llvm::Value* initsArg = allocArray(initsType);
+  llvm::Value* funcsArg = allocArray(blockPtrType);
+  llvm::Value* rangesArg = allocArray(IndexType());
+  std::vector<llvm::Value*> allocs;
+  for (size_t i = 0; i < tasks.size(); ++i) {
+    const auto& block = *tasks[i];
+    assert(!block.has_tag("xsmm"));
+    auto function = CompileNested(block);
+    ProfileBlockEnter(block);
+    std::vector<llvm::Value*> refs;
+    std::vector<llvm::Value*> idxs;
+    BlockArgs(block, &refs, &idxs, &allocs);
+    builder_.CreateStore(ThreadedRefs(refs), builder_.CreateConstGEP1_32(refsArg, i));
+    builder_.CreateStore(ThreadedInits(idxs), builder_.CreateConstGEP1_32(initsArg, i));
+    builder_.CreateStore(function, builder_.CreateConstGEP1_32(funcsArg, i));
+    builder_.CreateStore(IndexConst(block.idxs_product()), builder_.CreateConstGEP1_32(rangesArg, i));
+  }
+  std::vector<llvm::Type*> fnArgTypes{refsType->getPointerTo(), initsType->getPointerTo(),
+                                      blockPtrType->getPointerTo(), IndexType()->getPointerTo(), IndexType(),
+                                      builder_.getInt32Ty()};
+  auto fnType = llvm::FunctionType::get(builder_.getVoidTy(), fnArgTypes, false);
+  auto fn = module_->getOrInsertFunction("ParallelTasks", fnType).getCallee();
+  std::vector<llvm::Value*> argvals{refsArg,   initsArg, funcsArg, rangesArg, IndexConst(tasks.size()),
+                                    builder_.getInt32(ParallelForFlags(tasks.front()->location))};
+  builder_.CreateCall(fn, argvals, "");
+  for (auto ptr : allocs) {
+    Free(ptr);
+  }
+  for (size_t i = tasks.size(); i-- > 0;) {
+    ProfileBlockLeave(*tasks[i]);
+  }
+}
+
 void Compiler::Intrinsic(const stripe::Intrinsic& intrinsic, External handler) {
   // Process an intrinsic statement using an external handler function.
   // Load all the input scalars. Create a vector containing their types.
@@ -1469,13 +1881,31 @@ void Compiler::BitRight(const stripe::Intrinsic& stmt) {
 
 void Compiler::Sqrt(const stripe::Intrinsic& stmt) { CallIntrinsicFunc(stmt, "sqrtf", "sqrt"); }
 
-void Compiler::Exp(const stripe::Intrinsic& stmt) { CallIntrinsicFunc(stmt, "expf", "exp"); }
+void Compiler::Exp(const stripe::Intrinsic& stmt) {
+  if (UseFastMath(stmt)) {
+    CallFastMathFunc(stmt, &Compiler::FastExp);
+  } else {
+    CallIntrinsicFunc(stmt, "expf", "exp");
+  }
+}
 
-void Compiler::Log(const stripe::Intrinsic& stmt) { CallIntrinsicFunc(stmt, "logf", "log"); }
+void Compiler::Log(const stripe::Intrinsic& stmt) {
+  if (UseFastMath(stmt)) {
+    CallFastMathFunc(stmt, &Compiler::FastLog);
+  } else {
+    CallIntrinsicFunc(stmt, "logf", "log");
+  }
+}
 
 void Compiler::Pow(const stripe::Intrinsic& stmt) { CallIntrinsicFunc(stmt, "powf", "pow", 2); }
 
-void Compiler::Tanh(const stripe::Intrinsic& stmt) { CallIntrinsicFunc(stmt, "tanhf", "tanh"); }
+void Compiler::Tanh(const stripe::Intrinsic& stmt) {
+  if (UseFastMath(stmt)) {
+    CallFastMathFunc(stmt, &Compiler::FastTanh);
+  } else {
+    CallIntrinsicFunc(stmt, "tanhf", "tanh");
+  }
+}
 
 void Compiler::Cos(const stripe::Intrinsic& stmt) { CallIntrinsicFunc(stmt, "cosf", "cos"); }
 
@@ -1507,6 +1937,23 @@ void Compiler::Sinh(const stripe::Intrinsic& stmt) { CallIntrinsicFunc(stmt, "si
 
 void Compiler::Tan(const stripe::Intrinsic& stmt) { CallIntrinsicFunc(stmt, "tanf", "tan"); }
 
+void Compiler::Prefetch(const stripe::Special& prefetch) {
+  // Prefetch the element "offset" elements past the current one. A prefetch
+  // never faults, so running off the end of the buffer is harmless.
+  assert(1 == prefetch.inputs.size());
+  assert(0 == prefetch.outputs.size());
+  Buffer src = buffers_[prefetch.inputs[0]];
+  auto offset = prefetch.int_params.count("offset") ? prefetch.int_params.at("offset") : 0;
+  auto locality = prefetch.int_params.count("locality") ? prefetch.int_params.at("locality") : 3;
+  llvm::Value* element = builder_.CreateGEP(ElementPtr(src), IndexConst(offset));
+  auto int8PtrType = builder_.getInt8PtrTy();
+  llvm::Value* addr = builder_.CreateBitCast(element, int8PtrType);
+  // Arguments: address, read (0) or write (1), locality (0-3), data (1) or
+  // instruction (0) cache.
+  builder_.CreateIntrinsic(llvm::Intrinsic::prefetch, {int8PtrType},
+                           {addr, builder_.getInt32(0), builder_.getInt32(locality), builder_.getInt32(1)});
+}
+
 void Compiler::Zero(const stripe::Special& zero) {
   assert(0 == zero.inputs.size());
   assert(1 == zero.outputs.size());
@@ -1516,11 +1963,93 @@ void Compiler::Zero(const stripe::Special& zero) {
 }
 
 void Compiler::Copy(const stripe::Special& copy) {
-  // present in stripe.proto but not defined in the specification
-  throw Error("Special operation COPY is not yet specified");
+  // One input and one output, with the same element type and dimension sizes
+  // but possibly different strides; each element of the input is copied to the
+  // same position in the output.
+  assert(1 == copy.inputs.size());
+  Buffer src = buffers_[copy.inputs[0]];
+  auto& src_shape = src.refinement->interior_shape;
+  assert(1 == copy.outputs.size());
+  Buffer dst = buffers_[copy.outputs[0]];
+  auto& dst_shape = dst.refinement->interior_shape;
+  if (src_shape.type != dst_shape.type || src_shape.sizes() != dst_shape.sizes()) {
+    throw Error("Special operation COPY requires matching input and output shapes");
+  }
+  ssize_t elem_bytes = byte_width(src_shape.type);
+
+  // Drop unit dimensions, and merge each dimension into the next inner one
+  // wherever both tensors lay the pair out contiguously, so that a dense copy
+  // becomes a single run and a slice becomes a set of strided rows.
+  struct CopyDim {
+    size_t size;
+    ssize_t src_stride;
+    ssize_t dst_stride;
+  };
+  std::vector<CopyDim> dims;
+  for (size_t i = 0; i < src_shape.dims.size(); ++i) {
+    if (src_shape.dims[i].size == 1) {
+      continue;
+    }
+    CopyDim dim{src_shape.dims[i].size, src_shape.dims[i].stride, dst_shape.dims[i].stride};
+    if (dims.size() && dims.back().src_stride == dim.src_stride * static_cast<ssize_t>(dim.size) &&
+        dims.back().dst_stride == dim.dst_stride * static_cast<ssize_t>(dim.size)) {
+      dim.size *= dims.back().size;
+      dims.pop_back();
+    }
+    dims.push_back(dim);
+  }
+
+  // The innermost dimension forms the rows when it's contiguous in both
+  // tensors; otherwise each row is a single element.
+  size_t row_bytes = elem_bytes;
+  if (dims.size() && dims.back().src_stride == 1 && dims.back().dst_stride == 1) {
+    row_bytes *= dims.back().size;
+    dims.pop_back();
+  }
+  if (dims.empty()) {
+    if (row_bytes <= kInlineCopyBytes) {
+      builder_.CreateMemCpy(dst.base, llvm::MaybeAlign(0), src.base, llvm::MaybeAlign(0), row_bytes);
+      return;
+    }
+    dims.push_back(CopyDim{1, 0, 0});
+  }
+  CopyDim rows = dims.back();
+  dims.pop_back();
+
+  // Loop over any remaining outer dimensions, handing the runtime a set of
+  // rows at a time.
+  std::vector<llvm::Value*> idx_vars(dims.size());
+  std::vector<Loop> loops(dims.size());
+  llvm::Value* src_idx = IndexConst(0);
+  llvm::Value* dst_idx = IndexConst(0);
+  for (size_t i = 0; i < dims.size(); ++i) {
+    std::string name = std::to_string(i);
+    idx_vars[i] = builder_.CreateAlloca(IndexType(), nullptr, "idx_" + name);
+    CreateLoop(&loops[i], name);
+    EnterLoop(&loops[i], idx_vars[i], IndexConst(0), IndexConst(dims[i].size));
+    llvm::Value* idx_val = builder_.CreateLoad(idx_vars[i]);
+    src_idx = builder_.CreateAdd(src_idx, builder_.CreateMul(idx_val, IndexConst(dims[i].src_stride)));
+    dst_idx = builder_.CreateAdd(dst_idx, builder_.CreateMul(idx_val, IndexConst(dims[i].dst_stride)));
+  }
+  llvm::Type* int8PtrType = builder_.getInt8PtrTy();
+  std::vector<llvm::Value*> args{builder_.CreateBitCast(builder_.CreateGEP(dst.base, dst_idx), int8PtrType),
+                                 builder_.CreateBitCast(builder_.CreateGEP(src.base, src_idx), int8PtrType),
+                                 IndexConst(rows.size),
+                                 IndexConst(row_bytes),
+                                 IndexConst(rows.dst_stride * elem_bytes),
+                                 IndexConst(rows.src_stride * elem_bytes),
+                                 builder_.getInt32(ParallelForFlags())};
+  builder_.CreateCall(CopyRowsFunction(), args, "");
+  for (size_t i = dims.size(); i-- > 0;) {
+    LeaveLoop(&loops[i], idx_vars[i]);
+  }
 }
 
 void Compiler::Reshape(const stripe::Special& reshape) {
+  if (reshape.has_tag("inplace")) {
+    // The placer put the output in the same arena bytes as the input
+    return;
+  }
   assert(1 == reshape.inputs.size());
   Buffer src = buffers_[reshape.inputs[0]];
   assert(1 == reshape.outputs.size());
@@ -1543,7 +2072,9 @@ void Compiler::PrngStep(const stripe::Special& prng_step) {
   llvm::Value* dest_arg = builder_.CreateBitCast(dest.base, floatPtrType);
   size_t dest_bytes = dest.refinement->interior_shape.byte_size();
   llvm::Value* count = IndexConst(dest_bytes / sizeof(uint32_t));
-  std::vector<llvm::Value*> args{in_state.base, out_state.base, dest_arg, count};
+  // The state holds three words per stream.
+  llvm::Value* streams = IndexConst(in_state.refinement->interior_shape.elem_size() / 3);
+  std::vector<llvm::Value*> args{in_state.base, out_state.base, dest_arg, count, streams};
   builder_.CreateCall(PrngStepFunction(), args, "");
 }
 
@@ -1701,19 +2232,57 @@ void Compiler::AggInit(const Buffer& dest, llvm::Value* init_val) {
   }
 }
 
-void Compiler::ParallelFor(llvm::Value* refs, llvm::Value* idxs, size_t range, llvm::Function* block) {
+void Compiler::ParallelFor(llvm::Value* refs, llvm::Value* idxs, size_t range, llvm::Function* block,
+                           uint32_t flags) {
   llvm::Type* ptrArrayType = builder_.getInt8Ty()->getPointerTo()->getPointerTo();
   llvm::Type* idxArrayType = IndexType()->getPointerTo();
   std::vector<llvm::Type*> blockArgTypes{ptrArrayType, idxArrayType, IndexType(), IndexType()};
   llvm::Type* blockType = llvm::FunctionType::get(builder_.getVoidTy(), blockArgTypes, false);
   llvm::Type* blockPtrType = blockType->getPointerTo();
-  std::vector<llvm::Type*> fnArgTypes{ptrArrayType, idxArrayType, IndexType(), blockPtrType};
+  std::vector<llvm::Type*> fnArgTypes{ptrArrayType, idxArrayType, IndexType(), blockPtrType, IndexType(),
+                                      builder_.getInt32Ty()};
   auto fnType = llvm::FunctionType::get(builder_.getVoidTy(), fnArgTypes, false);
   auto fn = module_->getOrInsertFunction("ParallelFor", fnType).getCallee();
-  std::vector<llvm::Value*> argvals{refs, idxs, IndexConst(range), block};
+  size_t grain = config_.grain_size;
+  if (!grain) {
+    // Aim for a few tasks per hardware thread, which leaves the partitioner
+    // room to balance load without paying per-iteration scheduling costs.
+    const size_t kTasksPerThread = 4;
+    size_t threads = std::max(1U, std::thread::hardware_concurrency());
+    grain = std::max<size_t>(1, range / (threads * kTasksPerThread));
+  }
+  std::vector<llvm::Value*> argvals{refs, idxs, IndexConst(range), block, IndexConst(grain),
+                                    builder_.getInt32(flags)};
   builder_.CreateCall(fn, argvals, "");
 }
 
+uint32_t Compiler::ParallelForFlags(const stripe::Location& location) {
+  uint32_t flags = 0;
+  switch (config_.partitioner) {
+    case Partitioner::STATIC:
+      flags |= rt::kPartitionStatic;
+      break;
+    case Partitioner::AFFINITY:
+      flags |= rt::kPartitionAffinity;
+      break;
+    default:
+      flags |= rt::kPartitionAuto;
+      break;
+  }
+  if (config_.numa_arenas) {
+    flags |= rt::kNumaArenas;
+    // A block placed on a node runs entirely within that node's arena.
+    auto node = NumaNode(location);
+    if (node >= 0) {
+      flags |= static_cast<uint32_t>(node % 255 + 1) << rt::kNumaNodeShift;
+    }
+  }
+  if (config_.pin_threads) {
+    flags |= rt::kPinThreads;
+  }
+  return flags;
+}
+
 void Compiler::Scatter(const stripe::Special& scatter) {
   // Three inputs: "data", "indices", "shape"; one output.
   // For each value in "data", look up the corresponding location from
@@ -1731,6 +2300,24 @@ void Compiler::Scatter(const stripe::Special& scatter) {
   auto& output_shape = output.refinement->interior_shape;
   assert(output_shape == buffers_[scatter.inputs[2]].refinement->interior_shape);
 
+  // When float rows are scattered between dense tensors, add them a whole row
+  // at a time in the runtime, which divides the columns among threads.
+  size_t count = indices_shape.elem_size();
+  if (data_shape.type == DataType::FLOAT32 && output_shape.type == DataType::FLOAT32 &&
+      indices_shape.type == DataType::INT32 && IsDense(data_shape) && IsDense(indices_shape) &&
+      IsDense(output_shape) && count && output_shape.dims.size() &&
+      data_shape.elem_size() / count == output_shape.elem_size() / output_shape.dims[0].size) {
+    std::vector<llvm::Value*> args{output.base,
+                                   data.base,
+                                   indices.base,
+                                   IndexConst(count),
+                                   IndexConst(output_shape.dims[0].size),
+                                   IndexConst(data_shape.elem_size() / count),
+                                   builder_.getInt32(ParallelForFlags())};
+    builder_.CreateCall(ScatterAddRowsFunction(), args, "");
+    return;
+  }
+
   // Build a loop nest over each dimension of the data.
   size_t data_ndims = data_shape.dims.size();
   std::vector<llvm::Value*> limits(data_ndims);
@@ -1778,7 +2365,7 @@ void Compiler::Scatter(const stripe::Special& scatter) {
   bool ind_signed = !is_uint(indices_shape.type);
   auto cast_op = llvm::CastInst::getCastOpcode(indirect_val, ind_signed, IndexType(), false);
   indirect_val = builder_.CreateCast(cast_op, indirect_val, IndexType());
-  llvm::Value* ind_limit = IndexConst(output_shape.dims[0].size);
+  llvm::Value* ind_limit = IndexConst(output_shape.dims[0].size - 1);
   llvm::Value* must_clamp = builder_.CreateICmpUGT(indirect_val, ind_limit);
   indirect_val = builder_.CreateSelect(must_clamp, ind_limit, indirect_val);
 
@@ -1832,6 +2419,24 @@ void Compiler::Gather(const stripe::Special& gather) {
   size_t dest_ndims = dest_shape.dims.size();
   assert(dest_ndims == outer_ndims + inner_ndims);
 
+  // When all three tensors are dense, each index selects a contiguous row of
+  // "data" which lands in a contiguous row of "dest"; the runtime copies the
+  // rows whole, divided among threads.
+  if (indices_shape.type == DataType::INT32 && IsDense(data_shape) && IsDense(indices_shape) && IsDense(dest_shape) &&
+      data_shape.dims.size()) {
+    size_t row_bytes = data_shape.byte_size() / data_shape.dims[0].size;
+    llvm::Type* int8PtrType = builder_.getInt8PtrTy();
+    std::vector<llvm::Value*> args{builder_.CreateBitCast(dest.base, int8PtrType),
+                                   builder_.CreateBitCast(data.base, int8PtrType),
+                                   indices.base,
+                                   IndexConst(indices_shape.elem_size()),
+                                   IndexConst(data_shape.dims[0].size),
+                                   IndexConst(row_bytes),
+                                   builder_.getInt32(ParallelForFlags())};
+    builder_.CreateCall(GatherRowsFunction(), args, "");
+    return;
+  }
+
   // Compute the limit for each loop based on the tensor shape extents
   std::vector<llvm::Value*> limits(dest_ndims);
   for (size_t i = 0; i < outer_ndims; ++i) {
@@ -1875,7 +2480,7 @@ void Compiler::Gather(const stripe::Special& gather) {
   bool ind_signed = !is_uint(indices_shape.type);
   auto cast_op = llvm::CastInst::getCastOpcode(indirect_val, ind_signed, IndexType(), false);
   indirect_val = builder_.CreateCast(cast_op, indirect_val, IndexType());
-  llvm::Value* ind_limit = IndexConst(data_shape.dims[0].size);
+  llvm::Value* ind_limit = IndexConst(data_shape.dims[0].size - 1);
   llvm::Value* must_clamp = builder_.CreateICmpUGT(indirect_val, ind_limit);
   indirect_val = builder_.CreateSelect(must_clamp, ind_limit, indirect_val);
 
@@ -2066,6 +2671,106 @@ void Compiler::CallIntrinsicFunc(const stripe::Intrinsic& stmt, const char* name
   OutputType(ret, stmt);
 }
 
+bool Compiler::UseFastMath(const stripe::Intrinsic& stmt) {
+  // The inline approximations are single-precision; half-precision values
+  // are computed in single precision anyway, while doubles keep using libm.
+  return config_.math_accuracy == MathAccuracy::FAST && stmt.inputs.size() == 1 &&
+         (stmt.type == DataType::FLOAT16 || stmt.type == DataType::FLOAT32);
+}
+
+void Compiler::CallFastMathFunc(const stripe::Intrinsic& stmt, llvm::Value* (Compiler::*func)(llvm::Value*)) {
+  // Unlike a libm call, the inline sequence is made only of arithmetic and
+  // vectorizable intrinsics, so the loop vectorizer can widen it.
+  Scalar op = Cast(scalars_[stmt.inputs[0]], DataType::FLOAT32);
+  llvm::Value* ret = (this->*func)(op.value);
+  Scalar out = Cast(Scalar{ret, DataType::FLOAT32}, stmt.type);
+  OutputType(out.value, stmt);
+}
+
+llvm::Value* Compiler::FloatConst(float val) { return llvm::ConstantFP::get(builder_.getFloatTy(), val); }
+
+llvm::Value* Compiler::Polynomial(llvm::Value* x, const std::vector<float>& coeffs) {
+  // Horner's rule; coefficients are listed from the highest degree down.
+  llvm::Value* ret = FloatConst(coeffs[0]);
+  for (size_t i = 1; i < coeffs.size(); ++i) {
+    ret = builder_.CreateFAdd(builder_.CreateFMul(ret, x), FloatConst(coeffs[i]));
+  }
+  return ret;
+}
+
+llvm::Value* Compiler::FastExp(llvm::Value* x) {
+  // Cephes expf: exp(x) = 2^n * exp(r), where n = round(x / ln(2)) and
+  // r = x - n * ln(2) is evaluated in two parts to preserve precision.
+  // Inputs are clamped to the range where the result is a normal float.
+  auto i32 = builder_.getInt32Ty();
+  x = builder_.CreateBinaryIntrinsic(llvm::Intrinsic::minnum, x, FloatConst(88.3762626647949f));
+  x = builder_.CreateBinaryIntrinsic(llvm::Intrinsic::maxnum, x, FloatConst(-87.3365447504f));
+  llvm::Value* fx = builder_.CreateFAdd(builder_.CreateFMul(x, FloatConst(1.44269504088896341f)), FloatConst(0.5f));
+  fx = builder_.CreateUnaryIntrinsic(llvm::Intrinsic::floor, fx);
+  // At the upper clamp x / ln(2) is 127.5, which can round up to n = 128 and
+  // overflow the exponent; exp(r) absorbs the difference, so cap n at 127.
+  fx = builder_.CreateBinaryIntrinsic(llvm::Intrinsic::minnum, fx, FloatConst(127.0f));
+  x = builder_.CreateFSub(x, builder_.CreateFMul(fx, FloatConst(0.693359375f)));
+  x = builder_.CreateFSub(x, builder_.CreateFMul(fx, FloatConst(-2.12194440e-4f)));
+  llvm::Value* z = builder_.CreateFMul(x, x);
+  llvm::Value* y = Polynomial(x, {1.9875691500E-4f, 1.3981999507E-3f, 8.3334519073E-3f, 4.1665795894E-2f,
+                                  1.6666665459E-1f, 5.0000001201E-1f});
+  y = builder_.CreateFAdd(builder_.CreateFAdd(builder_.CreateFMul(y, z), x), FloatConst(1.0f));
+  // Build 2^n directly from its IEEE-754 bit pattern.
+  llvm::Value* n = builder_.CreateFPToSI(fx, i32);
+  llvm::Value* bits = builder_.CreateShl(builder_.CreateAdd(n, builder_.getInt32(127)), 23);
+  llvm::Value* pow2n = builder_.CreateBitCast(bits, builder_.getFloatTy());
+  return builder_.CreateFMul(y, pow2n);
+}
+
+llvm::Value* Compiler::FastLog(llvm::Value* x) {
+  // Cephes logf: split x into 2^e * m with m in [sqrt(0.5), sqrt(2)), then
+  // log(x) = e * ln(2) + log(m), with log(m) from a polynomial in (m - 1).
+  // Denormal inputs are not handled precisely.
+  auto i32 = builder_.getInt32Ty();
+  auto f32 = builder_.getFloatTy();
+  llvm::Value* xi = builder_.CreateBitCast(x, i32);
+  llvm::Value* e = builder_.CreateSub(builder_.CreateLShr(xi, 23), builder_.getInt32(126));
+  llvm::Value* mi = builder_.CreateAnd(xi, builder_.getInt32(0x807fffff));
+  mi = builder_.CreateOr(mi, builder_.getInt32(0x3f000000));
+  llvm::Value* m = builder_.CreateBitCast(mi, f32);
+  llvm::Value* small = builder_.CreateFCmpOLT(m, FloatConst(0.707106781186547524f));
+  e = builder_.CreateSelect(small, builder_.CreateSub(e, builder_.getInt32(1)), e);
+  m = builder_.CreateFSub(builder_.CreateSelect(small, builder_.CreateFAdd(m, m), m), FloatConst(1.0f));
+  llvm::Value* z = builder_.CreateFMul(m, m);
+  llvm::Value* y = Polynomial(m, {7.0376836292E-2f, -1.1514610310E-1f, 1.1676998740E-1f, -1.2420140846E-1f,
+                                  1.4249322787E-1f, -1.6668057665E-1f, 2.0000714765E-1f, -2.4999993993E-1f,
+                                  3.3333331174E-1f});
+  y = builder_.CreateFMul(builder_.CreateFMul(y, m), z);
+  llvm::Value* fe = builder_.CreateSIToFP(e, f32);
+  y = builder_.CreateFAdd(y, builder_.CreateFMul(fe, FloatConst(-2.12194440e-4f)));
+  y = builder_.CreateFSub(y, builder_.CreateFMul(z, FloatConst(0.5f)));
+  llvm::Value* ret = builder_.CreateFAdd(builder_.CreateFAdd(m, y), builder_.CreateFMul(fe, FloatConst(0.693359375f)));
+  // Patch up the special cases: log(0) = -inf, log(inf) = inf, and log of a
+  // negative number (or NaN) is NaN.
+  auto inf = llvm::ConstantFP::getInfinity(f32, false);
+  ret = builder_.CreateSelect(builder_.CreateFCmpOEQ(x, inf), inf, ret);
+  ret = builder_.CreateSelect(builder_.CreateFCmpOEQ(x, FloatConst(0.0f)), llvm::ConstantFP::getInfinity(f32, true),
+                              ret);
+  ret = builder_.CreateSelect(builder_.CreateFCmpULT(x, FloatConst(0.0f)), llvm::ConstantFP::getNaN(f32), ret);
+  return ret;
+}
+
+llvm::Value* Compiler::FastTanh(llvm::Value* x) {
+  // Cephes tanhf: an odd polynomial near zero, and 1 - 2 / (exp(2|x|) + 1)
+  // elsewhere. Both sides are evaluated and selected without branching.
+  llvm::Value* ax = builder_.CreateUnaryIntrinsic(llvm::Intrinsic::fabs, x);
+  llvm::Value* z = builder_.CreateFMul(x, x);
+  llvm::Value* p = Polynomial(z, {-5.70498872745E-3f, 2.06390887954E-2f, -5.37397155531E-2f, 1.33314422036E-1f,
+                                  -3.33332819422E-1f});
+  llvm::Value* near = builder_.CreateFAdd(builder_.CreateFMul(builder_.CreateFMul(p, z), x), x);
+  llvm::Value* e = FastExp(builder_.CreateFAdd(ax, ax));
+  llvm::Value* far = builder_.CreateFDiv(FloatConst(2.0f), builder_.CreateFAdd(e, FloatConst(1.0f)));
+  far = builder_.CreateFSub(FloatConst(1.0f), far);
+  far = builder_.CreateBinaryIntrinsic(llvm::Intrinsic::copysign, far, x);
+  return builder_.CreateSelect(builder_.CreateFCmpOLT(ax, FloatConst(0.625f)), near, far);
+}
+
 llvm::Type* Compiler::IndexType() {
   unsigned archbits = module_->getDataLayout().getPointerSizeInBits();
   return llvm::IntegerType::get(context_, archbits);
@@ -2090,9 +2795,12 @@ llvm::FunctionType* Compiler::BlockType(const stripe::Block& block) {
     for (size_t i = 0; i < block.idxs.size(); ++i) {
       param_types.push_back(IndexType());
     }
+    // The last parameter is the base address of the program's arena.
+    param_types.push_back(builder_.getInt8PtrTy());
   } else {
     // This block function will be executed via ParallelFor.
-    // First parameter is a pointer to an array of refinement base addresses.
+    // First parameter is a pointer to an array of refinement base addresses,
+    // followed by the base address of the program's arena.
     // Since all block functions must have the same type signature, we will
     // define this as int8_t** instead and bitcast whenever we use it.
     auto int8PtrType = builder_.getInt8Ty()->getPointerTo();
@@ -2209,13 +2917,60 @@ void Compiler::Free(llvm::Value* buffer) {
 llvm::Value* Compiler::PrngStepFunction(void) {
   llvm::Type* floatPtrType = builder_.getFloatTy()->getPointerTo();
   llvm::Type* int32ptrType = builder_.getInt32Ty()->getPointerTo();
-  std::vector<llvm::Type*> argtypes{int32ptrType, int32ptrType, floatPtrType, IndexType()};
+  std::vector<llvm::Type*> argtypes{int32ptrType, int32ptrType, floatPtrType, IndexType(), IndexType()};
   llvm::Type* rettype = llvm::Type::getVoidTy(context_);
   auto functype = llvm::FunctionType::get(rettype, argtypes, false);
   const char* funcname = "prng_step";
   return module_->getOrInsertFunction(funcname, functype).getCallee();
 }
 
+llvm::Value* Compiler::GatherRowsFunction() {
+  llvm::Type* int8PtrType = builder_.getInt8PtrTy();
+  llvm::Type* int32PtrType = builder_.getInt32Ty()->getPointerTo();
+  std::vector<llvm::Type*> argtypes{
+      int8PtrType,            // dest
+      int8PtrType,            // data
+      int32PtrType,           // indices
+      IndexType(),            // count
+      IndexType(),            // data_rows
+      IndexType(),            // row_bytes
+      builder_.getInt32Ty(),  // flags
+  };
+  auto functype = llvm::FunctionType::get(builder_.getVoidTy(), argtypes, false);
+  return module_->getOrInsertFunction("GatherRows", functype).getCallee();
+}
+
+llvm::Value* Compiler::CopyRowsFunction() {
+  llvm::Type* int8PtrType = builder_.getInt8PtrTy();
+  std::vector<llvm::Type*> argtypes{
+      int8PtrType,            // dest
+      int8PtrType,            // src
+      IndexType(),            // rows
+      IndexType(),            // row_bytes
+      IndexType(),            // dest_stride
+      IndexType(),            // src_stride
+      builder_.getInt32Ty(),  // flags
+  };
+  auto functype = llvm::FunctionType::get(builder_.getVoidTy(), argtypes, false);
+  return module_->getOrInsertFunction("CopyRows", functype).getCallee();
+}
+
+llvm::Value* Compiler::ScatterAddRowsFunction() {
+  llvm::Type* floatPtrType = builder_.getFloatTy()->getPointerTo();
+  llvm::Type* int32PtrType = builder_.getInt32Ty()->getPointerTo();
+  std::vector<llvm::Type*> argtypes{
+      floatPtrType,           // dest
+      floatPtrType,           // data
+      int32PtrType,           // indices
+      IndexType(),            // count
+      IndexType(),            // dest_rows
+      IndexType(),            // row_elems
+      builder_.getInt32Ty(),  // flags
+  };
+  auto functype = llvm::FunctionType::get(builder_.getVoidTy(), argtypes, false);
+  return module_->getOrInsertFunction("ScatterAddRows", functype).getCallee();
+}
+
 llvm::Value* Compiler::ReadCycleCounter(void) {
   auto functype = llvm::FunctionType::get(builder_.getInt64Ty(), {}, false);
   const char* funcname = "llvm.readcyclecounter";
@@ -2249,6 +3004,15 @@ void Compiler::ProfileBlockEnter(const stripe::Block& block) {
   // the ending rdtsc value back in when the block finishes.
   builder_.CreateAtomicRMW(llvm::AtomicRMWInst::BinOp::Sub, profile_ticks_gval, ReadCycleCounter(),
                            llvm::AtomicOrdering::Monotonic);
+  if (config_.profile_hw_counters) {
+    // The hardware counters use the same bias trick, in the runtime.
+    auto hwtype = llvm::ArrayType::get(builder_.getInt64Ty(), rt::kHwCounterCount);
+    std::string profile_hw_name = profile_hw_name_ + block_id;
+    module_->getOrInsertGlobal(profile_hw_name, hwtype);
+    auto profile_hw_gval = module_->getNamedGlobal(profile_hw_name);
+    profile_hw_gval->setInitializer(llvm::Constant::getNullValue(hwtype));
+    AccumulateHwCounters(profile_hw_gval, -1);
+  }
 }
 
 void Compiler::ProfileBlockLeave(const stripe::Block& block) {
@@ -2263,6 +3027,16 @@ void Compiler::ProfileBlockLeave(const stripe::Block& block) {
   auto profile_ticks_gval = module_->getNamedGlobal(profile_ticks_name);
   builder_.CreateAtomicRMW(llvm::AtomicRMWInst::BinOp::Add, profile_ticks_gval, ReadCycleCounter(),
                            llvm::AtomicOrdering::Monotonic);
+  if (config_.profile_hw_counters) {
+    AccumulateHwCounters(module_->getNamedGlobal(profile_hw_name_ + block_id), 1);
+  }
+}
+
+void Compiler::AccumulateHwCounters(llvm::Value* counters, int64_t sign) {
+  auto i64ptr = builder_.getInt64Ty()->getPointerTo();
+  auto fnType = llvm::FunctionType::get(builder_.getVoidTy(), {i64ptr, builder_.getInt64Ty()}, false);
+  auto fn = module_->getOrInsertFunction("AccumulateHwCounters", fnType).getCallee();
+  builder_.CreateCall(fn, {builder_.CreateBitCast(counters, i64ptr), builder_.getInt64(sign)}, "");
 }
 
 void Compiler::ProfileLoopEnter(const stripe::Block& block) {
@@ -2314,6 +3088,9 @@ CompileFor Compiler::getCompileFor(const stripe::Block& block) {
     return XSMM_BLOCK;
   } else if (block.has_tag("cpu_thread") && block.idxs_product() > 1) {
     return THREADED_BLOCK;
+  } else if (block.has_attr(kTaskGroup)) {
+    // Task group members are invoked through ParallelTasks.
+    return THREADED_BLOCK;
   }
 
   return NORMAL_BLOCK;
@@ -12,6 +12,7 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "tile/stripe/stripe.h"
 #include "tile/targets/cpu/config.h"
@@ -41,7 +42,11 @@ enum CompileFor {
 class Compiler : private stripe::ConstStmtVisitor {
  public:
   Compiler(llvm::LLVMContext* context, const Config& config);
-  ProgramModule CompileProgram(const stripe::Block& program);
+  ProgramModule CompileProgram(const stripe::Block& program, const std::string& name = "stripe");
+  // Declares the module for a program without generating any code for it.
+  ProgramModule DeclareProgram(const stripe::Block& program, const std::string& name);
+  // Runs the optimization pipeline over a module of generated code.
+  static void Optimize(llvm::Module* module);
 
   // Internal data type definitions.
  private:
@@ -63,9 +68,13 @@ class Compiler : private stripe::ConstStmtVisitor {
   explicit Compiler(llvm::LLVMContext* context, llvm::Module* module, const Config& config);
   void GenerateInvoker(const stripe::Block& program, llvm::Function* main);
   uint64_t MeasureArena(const stripe::Block& block);
+  void PlaceArena(const stripe::Block& block, std::vector<uint64_t>* table);
+  int64_t NumaNode(const stripe::Location& location) const;
   void GenerateArena(const stripe::Block& block);
   llvm::Function* CompileXSMMBlock(const stripe::Block& block, const XSMMDispatch xsmmDispatch,
                                    const XSMMCallData& xsmmCallData);
+  llvm::Function* CompileXSMMReduceBlock(const stripe::Block& block, const stripe::Block& inner,
+                                         const XSMMCallData& xsmmCallData);
   llvm::Function* CompileThreadedBlock(const stripe::Block& block);
   llvm::Function* CompileBlock(const stripe::Block& block);
   void Visit(const stripe::Load&) override;
@@ -75,6 +84,13 @@ class Compiler : private stripe::ConstStmtVisitor {
   void Visit(const stripe::Special&) override;
   void Visit(const stripe::Intrinsic&) override;
   void Visit(const stripe::Block&) override;
+  void VisitStatements(const stripe::Block& block);
+  void VisitTasks(const std::vector<const stripe::Block*>& tasks);
+  llvm::Function* CompileNested(const stripe::Block& block);
+  void BlockArgs(const stripe::Block& block, std::vector<llvm::Value*>* refs, std::vector<llvm::Value*>* idxs,
+                 std::vector<llvm::Value*>* allocs);
+  llvm::Value* ThreadedRefs(const std::vector<llvm::Value*>& refs);
+  llvm::Value* ThreadedInits(const std::vector<llvm::Value*>& idxs);
   void Intrinsic(const stripe::Intrinsic&, External handler);
   void Add(const stripe::Intrinsic&);
   void Subtract(const stripe::Intrinsic&);
@@ -127,6 +143,7 @@ class Compiler : private stripe::ConstStmtVisitor {
   void AggInitMax(const stripe::Special&);
   void Scatter(const stripe::Special&);
   void Gather(const stripe::Special&);
+  void Prefetch(const stripe::Special&);
   void AsFloat(const stripe::Intrinsic&);
   void AsInt(const stripe::Intrinsic&);
   void AsUInt(const stripe::Intrinsic&);
@@ -156,6 +173,7 @@ class Compiler : private stripe::ConstStmtVisitor {
   };
 
  private:
+  std::unique_ptr<llvm::TargetMachine> CreateTargetMachine();
   void CreateLoop(Loop* loop, std::string name);
   void EnterLoop(Loop* loop, llvm::Value* variable, llvm::Value* init, llvm::Value* limit);
   void LeaveLoop(Loop* loop, llvm::Value* variable);
@@ -168,6 +186,13 @@ class Compiler : private stripe::ConstStmtVisitor {
   void OutputBool(llvm::Value* ret, const stripe::Intrinsic&);
   void CallIntrinsicFunc(const stripe::Intrinsic&, const char* name_f32, const char* name_f64,
                          const size_t numParams = 1);
+  bool UseFastMath(const stripe::Intrinsic&);
+  void CallFastMathFunc(const stripe::Intrinsic&, llvm::Value* (Compiler::*func)(llvm::Value*));
+  llvm::Value* FloatConst(float val);
+  llvm::Value* Polynomial(llvm::Value* x, const std::vector<float>& coeffs);
+  llvm::Value* FastExp(llvm::Value* x);
+  llvm::Value* FastLog(llvm::Value* x);
+  llvm::Value* FastTanh(llvm::Value* x);
   llvm::Type* IndexType();
   llvm::Value* IndexConst(ssize_t val);
   llvm::FunctionType* BlockType(const stripe::Block&);
@@ -176,9 +201,13 @@ class Compiler : private stripe::ConstStmtVisitor {
   llvm::Value* Malloc(size_t size);
   void Free(llvm::Value* buffer);
   llvm::Value* PrngStepFunction();
+  llvm::Value* GatherRowsFunction();
+  llvm::Value* CopyRowsFunction();
+  llvm::Value* ScatterAddRowsFunction();
   llvm::Value* ReadCycleCounter();
   void ProfileBlockEnter(const stripe::Block& block);
   void ProfileBlockLeave(const stripe::Block& block);
+  void AccumulateHwCounters(llvm::Value* counters, int64_t sign);
   void ProfileLoopEnter(const stripe::Block& block);
   void ProfileLoopLeave(const stripe::Block& block);
   std::string ProfileBlockID(const stripe::Block& block);
@@ -187,13 +216,18 @@ class Compiler : private stripe::ConstStmtVisitor {
   void EmitRunTimeLogEntry(const std::string& str, const std::string& extra, llvm::Value* value = nullptr);
   void PrintOutputAssembly(llvm::TargetMachine* machine);
   void AggInit(const Buffer& dest, llvm::Value* init_val);
-  void ParallelFor(llvm::Value* refs, llvm::Value* idxs, size_t range, llvm::Function* func);
+  void ParallelFor(llvm::Value* refs, llvm::Value* idxs, size_t range, llvm::Function* func, uint32_t flags);
+  uint32_t ParallelForFlags(const stripe::Location& location = stripe::Location{});
   CompileFor getCompileFor(const stripe::Block& block);
 
   // Gets the leading dimensions and the buffers for an XSMM call if available.
   // @returns true if the XSMM call is applicable, otherwise false.
   bool GetXSMMCallData(XSMMCallData* xsmmCallData, const stripe::Block& block);
 
+  // Returns the XSMM block nested within this block if the block's loops can
+  // be replaced by a single batch-reduce GEMM, otherwise nullptr.
+  const stripe::Block* GetXSMMReduceChild(const stripe::Block& block, XSMMCallData* xsmmCallData);
+
   llvm::LLVMContext& context_;
   llvm::IRBuilder<> builder_;
   llvm::Module* module_ = nullptr;
@@ -204,6 +238,8 @@ class Compiler : private stripe::ConstStmtVisitor {
   std::map<std::string, Buffer> buffers_;
   std::map<std::string, Index> indexes_;
   uint64_t arenaSize_ = 0;
+  // The base address of the program arena, within the current block function.
+  llvm::Value* arena_ = nullptr;
 };
 
 }  // namespace cpu
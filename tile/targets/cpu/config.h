@@ -20,13 +20,57 @@ namespace cpu {
 //
 typedef std::function<void*(std::vector<DataType>*, DataType*)> External;
 
+// How transcendental functions are evaluated.
+enum class MathAccuracy {
+  PRECISE,  // Calls into libm, one element at a time
+  FAST,     // Inline polynomial approximations (within a few ulps for exp,
+            // log, and tanh on float32) which the loop vectorizer can widen
+};
+
+// How the iterations of a threaded block are divided among worker threads.
+enum class Partitioner {
+  AUTO,      // TBB's adaptive default
+  STATIC,    // Evenly sized chunks, one per worker
+  AFFINITY,  // Replays the previous run's chunk-to-thread assignment
+};
+
 struct Config {
   bool profile_block_execution = false;
   bool profile_loop_body = false;
+  // With profile_block_execution, also samples hardware counters and the
+  // wall clock around each block (see ApplyPerfAttrs in profile.h).
+  bool profile_hw_counters = false;
   bool print_llvm_ir_simple = VLOG_IS_ON(3);
   bool print_llvm_ir_optimized = VLOG_IS_ON(4);
   bool print_assembly = VLOG_IS_ON(4);
   std::map<std::string, External> externals;
+  // When set, compiled objects are persisted under this directory and reused
+  // by later compilations of the same program, even across processes.
+  std::string object_cache_dir;
+  // Once the object cache grows past this size, the least recently used
+  // objects are evicted.
+  uint64_t object_cache_max_bytes = 1ULL << 30;
+  MathAccuracy math_accuracy = MathAccuracy::PRECISE;
+  // Scheduling of blocks tagged cpu_thread.
+  Partitioner partitioner = Partitioner::AUTO;
+  // Minimum iterations per task; zero derives a grain size from each
+  // block's idxs_product and the number of hardware threads.
+  size_t grain_size = 0;
+  // Runs each NUMA node's share of a threaded block in its own arena, and
+  // spreads first-touch placement of the program arena across nodes.
+  bool numa_arenas = false;
+  // With numa_arenas, the device through which locations place blocks and
+  // refinements on NUMA nodes (as assigned by a SchedulePass with a NumaMap):
+  // a constant unit of this device names the node. Placed blocks run within
+  // their node's arena, and placed refinements are bound to their node.
+  std::string numa_device = "NUMA";
+  // Pins worker threads to individual cores.
+  bool pin_threads = false;
+  // Defers optimizing and compiling each block function until it is first
+  // called, using a pool of compile_threads threads (zero uses as many as
+  // the shared compile pool, per PLAIDML_COMPILE_THREADS). Programs compiled lazily bypass the object cache.
+  bool lazy_compile = false;
+  size_t compile_threads = 0;
 };
 
 }  // namespace cpu
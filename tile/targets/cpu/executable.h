@@ -3,6 +3,7 @@
 #pragma once
 
 #include <llvm/ExecutionEngine/ExecutionEngine.h>
+#include <llvm/ExecutionEngine/ObjectCache.h>
 
 #include <map>
 #include <memory>
@@ -11,6 +12,7 @@
 
 #include "tile/stripe/stripe.h"
 #include "tile/targets/cpu/programmodule.h"
+#include "tile/targets/cpu/runtime.h"
 
 namespace vertexai {
 namespace tile {
@@ -19,14 +21,31 @@ namespace cpu {
 
 class Executable {
  public:
-  explicit Executable(const ProgramModule& module);
-  void Run(const std::map<std::string, void*>& buffers);
+  explicit Executable(const ProgramModule& module, llvm::ObjectCache* cache = nullptr);
+
+  // The names of the buffers the program expects, in invocation order.
+  const std::vector<std::string>& parameters() const { return parameters_; }
+  // Resolves named buffers into the argument vector the program expects, so
+  // that repeated runs over the same buffers need no lookups.
+  std::vector<void*> Bind(const std::map<std::string, void*>& buffers) const;
+  // Runs the program; safe to call from several threads at once, since each
+  // run gets its own arena.
+  void Run(const std::vector<void*>& args);
+  void Run(const std::map<std::string, void*>& buffers) { Run(Bind(buffers)); }
+  // Returns true if the engine was able to resolve the program entrypoint.
+  bool HasInvoker();
   void Save(const std::string& filename);
+  // Applies the program's profile counters to the blocks they measured, and
+  // records the size of the program's scratch arena on the top-level block.
   void SetPerfAttrs(stripe::Block* block);
+  // The size of the scratch arena each concurrent run of the program uses.
+  uint64_t ArenaBytes() const { return arenas_->size(); }
 
  private:
   std::unique_ptr<llvm::ExecutionEngine> engine_;
   std::vector<std::string> parameters_;
+  void (*entrypoint_)(void*) = nullptr;
+  std::unique_ptr<rt::ArenaPool> arenas_;
 };
 
 }  // namespace cpu
@@ -0,0 +1,119 @@
+// Copyright 2019, Intel Corporation
+
+#include "tile/targets/cpu/heatmap.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include "base/util/env.h"
+#include "base/util/file.h"
+#include "base/util/logging.h"
+
+namespace vertexai::tile::targets::cpu {
+
+namespace fs = boost::filesystem;
+
+namespace {
+
+Heatmap BuiltinHeatmap() {
+  Heatmap heatmap;
+  for (unsigned i = 0; i < kHeatmapSize; ++i) {
+    heatmap.emplace(std::make_tuple(kHeatmapKeys[i][0], kHeatmapKeys[i][1], kHeatmapKeys[i][2]), kHeatmapValues[i]);
+  }
+  return heatmap;
+}
+
+Heatmap FindHostHeatmap() {
+  auto path = env::Get("PLAIDML_CPU_HEATMAP");
+  if (!path.empty()) {
+    IVLOG(1, "Using CPU heatmap " << path);
+    return LoadHeatmap(path);
+  }
+  auto dir = env::Get("PLAIDML_CPU_HEATMAP_DIR");
+  if (!dir.empty()) {
+    auto calibrated = fs::path(dir) / (HostCpuKey() + ".csv");
+    if (fs::exists(calibrated)) {
+      IVLOG(1, "Using calibrated CPU heatmap " << calibrated);
+      return LoadHeatmap(calibrated);
+    }
+    IVLOG(1, "No calibrated CPU heatmap at " << calibrated << "; using the builtin heatmap");
+  }
+  return BuiltinHeatmap();
+}
+
+}  // namespace
+
+std::string HostCpuKey() {
+#if defined(__x86_64__) || defined(__i386__)
+  unsigned eax, ebx, ecx, edx;
+  if (__get_cpuid(0, &eax, &ebx, &ecx, &edx)) {
+    char vendor[13];
+    std::memcpy(vendor, &ebx, 4);
+    std::memcpy(vendor + 4, &edx, 4);
+    std::memcpy(vendor + 8, &ecx, 4);
+    vendor[12] = '\0';
+    __get_cpuid(1, &eax, &ebx, &ecx, &edx);
+    unsigned family = (eax >> 8) & 0xf;
+    unsigned model = (eax >> 4) & 0xf;
+    if (family == 0xf) {
+      family += (eax >> 20) & 0xff;
+    }
+    if (family == 0x6 || family >= 0xf) {
+      model += ((eax >> 16) & 0xf) << 4;
+    }
+    std::stringstream ss;
+    ss << vendor << "-" << family << "-" << model;
+    return ss.str();
+  }
+#endif
+  return "unknown";
+}
+
+Heatmap LoadHeatmap(const fs::path& path) {
+  std::ifstream fin(path.string());
+  if (!fin) {
+    throw std::runtime_error("Unable to open CPU heatmap " + path.string());
+  }
+  std::string line;
+  std::getline(fin, line);
+  if (line.find("M,N,K,GFLOPS") != 0) {
+    throw std::runtime_error("Malformed CPU heatmap " + path.string() + ": expected an M,N,K,GFLOPS header");
+  }
+  Heatmap heatmap;
+  while (std::getline(fin, line)) {
+    if (line.empty()) {
+      continue;
+    }
+    unsigned m, n, k;
+    double gflops;
+    char c1, c2, c3;
+    std::stringstream ss(line);
+    if (!(ss >> m >> c1 >> n >> c2 >> k >> c3 >> gflops) || c1 != ',' || c2 != ',' || c3 != ',') {
+      throw std::runtime_error("Malformed CPU heatmap " + path.string() + ": \"" + line + "\"");
+    }
+    heatmap[std::make_tuple(m, n, k)] = gflops;
+  }
+  return heatmap;
+}
+
+void SaveHeatmap(const Heatmap& heatmap, const fs::path& path) {
+  WriteFile(path, false, [&](std::ofstream& fout) {
+    fout << "M,N,K,GFLOPS\n";
+    for (const auto& kvp : heatmap) {
+      fout << std::get<0>(kvp.first) << "," << std::get<1>(kvp.first) << "," << std::get<2>(kvp.first) << ","
+           << kvp.second << "\n";
+    }
+  });
+}
+
+const Heatmap& HostHeatmap() {
+  static const Heatmap heatmap = FindHostHeatmap();
+  return heatmap;
+}
+
+}  // namespace vertexai::tile::targets::cpu
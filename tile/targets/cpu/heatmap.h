@@ -3,12 +3,32 @@
 #pragma once
 
 #include <map>
+#include <string>
 #include <tuple>
 
+#include <boost/filesystem.hpp>
+
 namespace vertexai::tile::targets::cpu {
 
+// The builtin heatmap, generated at build time from a calibration CSV.
 extern uint64_t kHeatmapSize;
 extern uint16_t kHeatmapKeys[][3];
 extern float kHeatmapValues[];
 
+// Measured GEMM throughput, in GFLOP/s, keyed by (M, N, K) tile shape.
+using Heatmap = std::map<std::tuple<unsigned, unsigned, unsigned>, double>;
+
+// Identifies the host microarchitecture, e.g. "GenuineIntel-6-85", from
+// CPUID's vendor, family, and model; calibrated heatmaps are named by it.
+std::string HostCpuKey();
+
+// Reads and writes heatmaps as CSV, with an "M,N,K,GFLOPS" header.
+Heatmap LoadHeatmap(const boost::filesystem::path& path);
+void SaveHeatmap(const Heatmap& heatmap, const boost::filesystem::path& path);
+
+// Returns the heatmap for the host, loaded once: the file named by
+// PLAIDML_CPU_HEATMAP if set, else <HostCpuKey()>.csv from the directory
+// named by PLAIDML_CPU_HEATMAP_DIR if it exists, else the builtin heatmap.
+const Heatmap& HostHeatmap();
+
 }  // namespace vertexai::tile::targets::cpu
@@ -8,22 +8,32 @@
 #include <llvm/IR/LegacyPassManager.h>
 #include <llvm/IR/Module.h>
 #include <llvm/Support/DynamicLibrary.h>
+#include <llvm/Support/Program.h>
+#include <llvm/Support/TargetRegistry.h>
 #include <llvm/Support/ToolOutputFile.h>
+#include <llvm/Target/TargetMachine.h>
 #include <llvm/Transforms/IPO/PassManagerBuilder.h>
 #include <llvm/Transforms/Utils/Cloning.h>
 
 #include <algorithm>
 #include <deque>
 #include <memory>
+#include <sstream>
 #include <utility>
+#include <vector>
 
+#include <boost/filesystem.hpp>
 #include <half.hpp>
 
+#include "base/util/env.h"
 #include "base/util/lookup.h"
 #include "tile/stripe/stripe.h"
 #include "tile/targets/cpu/compiler.h"
 #include "tile/targets/cpu/executable.h"
+#include "tile/targets/cpu/lazy_executable.h"
 #include "tile/targets/cpu/link_names.h"
+#include "tile/targets/cpu/object_cache.h"
+#include "tile/targets/cpu/profile.h"
 
 namespace vertexai {
 namespace tile {
@@ -33,31 +43,158 @@ namespace cpu {
 struct Native::Impl {
   llvm::LLVMContext context;
   ProgramModule module;
+  std::unique_ptr<ObjectCache> cache;
   std::unique_ptr<Executable> executable;
+  std::unique_ptr<LazyExecutable> lazy;
 
   void compile(const stripe::Block& program, const Config& config) {
+    if (config.lazy_compile) {
+      // The lazy JIT compiles on its own threads, so the module needs a
+      // context of its own, which the JIT takes over.
+      auto lazy_context = std::make_unique<llvm::LLVMContext>();
+      Compiler compiler(lazy_context.get(), config);
+      lazy.reset(new LazyExecutable(compiler.CompileProgram(program), std::move(lazy_context), config));
+      return;
+    }
     Compiler compiler(&context, config);
-    module = compiler.CompileProgram(program);
-    assert(module.module);
-    executable.reset(new Executable(module));
+    if (config.object_cache_dir.empty() || !ObjectCache::IsCacheable(config)) {
+      module = compiler.CompileProgram(program);
+      assert(module.module);
+      executable.reset(new Executable(module));
+      return;
+    }
+    cache.reset(new ObjectCache(config.object_cache_dir, config.object_cache_max_bytes));
+    // The cache key names the module; on a hit, MCJIT loads the object for
+    // this (empty) module from the cache instead of generating any code.
+    auto key = ObjectCache::Key(program, config);
+    if (cache->Contains(key)) {
+      IVLOG(1, "CPU object cache hit: " << key);
+      module = compiler.DeclareProgram(program, key);
+      executable.reset(new Executable(module, cache.get()));
+      if (executable->HasInvoker()) {
+        return;
+      }
+      // The entry was evicted or unreadable; drop it and fall back to a full
+      // compile which bypasses the cache, so that MCJIT can't hand back the
+      // same unusable object.
+      IVLOG(1, "CPU object cache entry unusable, recompiling: " << key);
+      cache->Remove(key);
+      module = compiler.CompileProgram(program, key);
+      assert(module.module);
+      executable.reset(new Executable(module));
+    } else {
+      module = compiler.CompileProgram(program, key);
+      assert(module.module);
+      executable.reset(new Executable(module, cache.get()));
+    }
+    if (!executable->HasInvoker()) {
+      throw std::runtime_error("Unable to find the entry point of the CPU program " + key);
+    }
   }
 
-  void run(const std::map<std::string, void*>& buffers) { executable->Run(buffers); }
+  std::vector<void*> bind(const std::map<std::string, void*>& buffers) {
+    return lazy ? lazy->Bind(buffers) : executable->Bind(buffers);
+  }
+
+  void run(const std::vector<void*>& args) {
+    if (lazy) {
+      lazy->Run(args);
+    } else {
+      executable->Run(args);
+    }
+  }
 
   void save(const std::string& filename) {
+    if (lazy) {
+      throw std::runtime_error("Unable to save a lazily compiled CPU program");
+    }
+    if (module.module->empty()) {
+      throw std::runtime_error("Unable to save a CPU program which was loaded from the object cache");
+    }
+    auto ext = boost::filesystem::path(filename).extension();
+    if (ext == ".o" || ext == ".obj") {
+      SaveObject(filename);
+    } else if (ext == ".so" || ext == ".dylib") {
+      SaveSharedLibrary(filename);
+    } else {
+      std::error_code ec;
+      llvm::ToolOutputFile result(filename, ec, llvm::sys::fs::F_None);
+      WriteBitcodeToFile(*module.module, result.os());
+      result.keep();
+    }
+  }
+
+  void SaveObject(const std::string& filename) {
+    if (!module.externals.empty()) {
+      // External intrinsics are bound to function pointers in this process.
+      throw std::runtime_error("Unable to save a CPU program which uses external intrinsics");
+    }
+    auto triple = module.module->getTargetTriple();
+    std::string err;
+    auto target = llvm::TargetRegistry::lookupTarget(triple, err);
+    if (!target) {
+      throw std::runtime_error("Unable to find target for " + triple + ": " + err);
+    }
+    // Use position-independent code so the object can be linked into a
+    // shared library.
+    std::unique_ptr<llvm::TargetMachine> machine(
+        target->createTargetMachine(triple, "generic", "", {}, llvm::Reloc::PIC_));
     std::error_code ec;
     llvm::ToolOutputFile result(filename, ec, llvm::sys::fs::F_None);
-    WriteBitcodeToFile(*module.module, result.os());
+    if (ec) {
+      throw std::runtime_error("Unable to open " + filename + ": " + ec.message());
+    }
+    llvm::legacy::PassManager pm;
+    if (machine->addPassesToEmitFile(pm, result.os(), nullptr, llvm::CGFT_ObjectFile)) {
+      throw std::runtime_error("The CPU target is unable to emit object files");
+    }
+    std::unique_ptr<llvm::Module> clone(llvm::CloneModule(*module.module));
+    pm.run(*clone);
     result.keep();
   }
 
-  void set_perf_attrs(stripe::Block* program) { executable->SetPerfAttrs(program); }
+  void SaveSharedLibrary(const std::string& filename) {
+    // Emit an object, then link it with the host toolchain. When provided, the
+    // static runtime archive (the //tile/targets/cpu:aot target) is linked in
+    // as well, making the library self-contained.
+    auto object = boost::filesystem::path(filename);
+    object += boost::filesystem::unique_path(".%%%%%%%%.o");
+    SaveObject(object.string());
+    auto linker_name = env::Get("PLAIDML_CPU_LINKER", "cc");
+    auto linker = llvm::sys::findProgramByName(linker_name);
+    if (!linker) {
+      boost::filesystem::remove(object);
+      throw std::runtime_error("Unable to find linker \"" + linker_name + "\"");
+    }
+    std::string object_name = object.string();
+    std::vector<llvm::StringRef> args{*linker, "-shared", "-o", filename, object_name};
+    auto runtime = env::Get("PLAIDML_CPU_AOT_RUNTIME");
+    if (!runtime.empty()) {
+      args.push_back(runtime);
+    }
+    std::string err;
+    int rc = llvm::sys::ExecuteAndWait(*linker, args, llvm::None, {}, 0, 0, &err);
+    boost::filesystem::remove(object);
+    if (rc) {
+      throw std::runtime_error("Unable to link " + filename + ": " + (err.empty() ? std::to_string(rc) : err));
+    }
+  }
+
+  void set_perf_attrs(stripe::Block* program) {
+    if (lazy) {
+      lazy->SetPerfAttrs(program);
+    } else {
+      executable->SetPerfAttrs(program);
+    }
+  }
 };
 
 Native::Native() : m_impl(new Native::Impl) {}
 Native::~Native() {}
 void Native::compile(const stripe::Block& program, const Config& config) { m_impl->compile(program, config); }
-void Native::run(const std::map<std::string, void*>& buffers) { m_impl->run(buffers); }
+void Native::run(const std::map<std::string, void*>& buffers) { m_impl->run(m_impl->bind(buffers)); }
+std::vector<void*> Native::bind(const std::map<std::string, void*>& buffers) { return m_impl->bind(buffers); }
+void Native::run(const std::vector<void*>& args) { m_impl->run(args); }
 void Native::save(const std::string& filename) { m_impl->save(filename); }
 void Native::set_perf_attrs(stripe::Block* program) { m_impl->set_perf_attrs(program); }
 
@@ -78,11 +215,19 @@ void JitProfile(stripe::Block* program, const std::map<std::string, void*>& buff
   llvm::LLVMContext context;
   Config config;
   config.profile_block_execution = true;
+  config.profile_hw_counters = true;
   Compiler compiler(&context, config);
   auto module = compiler.CompileProgram(*program);
   Executable executable(std::move(module));
   executable.Run(buffers);
   executable.SetPerfAttrs(program);
+  if (VLOG_IS_ON(1)) {
+    std::stringstream report;
+    WriteRooflineReport(*program, &report);
+    report << "\n";
+    WriteBlockProfileReport(*program, &report);
+    IVLOG(1, "CPU profile:\n" << report.str());
+  }
 }
 
 }  // namespace cpu
@@ -25,6 +25,10 @@ class Native {
 
   void compile(const stripe::Block& program, const Config& config);
   void run(const std::map<std::string, void*>& buffers);
+  // Resolves named buffers once, for repeated runs through run(args). Runs
+  // of one compiled program may proceed concurrently from several threads.
+  std::vector<void*> bind(const std::map<std::string, void*>& buffers);
+  void run(const std::vector<void*>& args);
   void save(const std::string& filename);
   void set_perf_attrs(stripe::Block* program);
 };
@@ -0,0 +1,129 @@
+// Copyright 2019, Intel Corp.
+
+#include "tile/targets/cpu/lazy_executable.h"
+
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/Support/Error.h>
+
+#include <utility>
+
+#include "base/util/logging.h"
+#include "base/util/lookup.h"
+#include "tile/base/compile_pool.h"
+#include "tile/targets/cpu/compiler.h"
+#include "tile/targets/cpu/link_names.h"
+#include "tile/targets/cpu/profile.h"
+#include "tile/targets/cpu/runtime.h"
+
+namespace vertexai {
+namespace tile {
+namespace targets {
+namespace cpu {
+
+namespace {
+
+template <typename T>
+T Check(llvm::Expected<T> value, const std::string& what) {
+  if (!value) {
+    throw std::runtime_error(what + ": " + llvm::toString(value.takeError()));
+  }
+  return std::move(*value);
+}
+
+void Check(llvm::Error err, const std::string& what) {
+  if (err) {
+    throw std::runtime_error(what + ": " + llvm::toString(std::move(err)));
+  }
+}
+
+}  // namespace
+
+LazyExecutable::LazyExecutable(ProgramModule module, std::unique_ptr<llvm::LLVMContext> context,
+                               const Config& config)
+    : parameters_(module.parameters) {
+  // LLJIT owns its compile threads; size them by the shared compile pool's limit.
+  size_t threads = config.compile_threads ? config.compile_threads : CompileThreads();
+  auto jtmb = Check(llvm::orc::JITTargetMachineBuilder::detectHost(), "Unable to detect the host target");
+  jit_ = Check(llvm::orc::LLLazyJITBuilder()  //
+                   .setJITTargetMachineBuilder(std::move(jtmb))
+                   .setNumCompileThreads(threads)
+                   .create(),
+               "Failed to create lazy JIT");
+  // Resolve the runtime and any external intrinsics directly, and everything
+  // else (libc, libm) from the process.
+  auto& dylib = jit_->getMainJITDylib();
+  llvm::orc::SymbolMap symbols;
+  auto define = [&](const std::string& name, void* ptr) {
+    symbols[jit_->mangleAndIntern(name)] =
+        llvm::JITEvaluatedSymbol(reinterpret_cast<uintptr_t>(ptr), llvm::JITSymbolFlags::Exported);
+  };
+  for (const auto& kvp : rt::Symbols()) {
+    if (kvp.first[0] != '_') {  // mangleAndIntern adds any platform prefix
+      define(kvp.first, kvp.second);
+    }
+  }
+  for (const auto& kvp : module.externals) {
+    define(kvp.first, kvp.second);
+  }
+  Check(dylib.define(llvm::orc::absoluteSymbols(std::move(symbols))), "Unable to define runtime symbols");
+  dylib.addGenerator(Check(llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(
+                               jit_->getDataLayout().getGlobalPrefix()),
+                           "Unable to search the process for symbols"));
+  // Each function is split into its own module before it is compiled; run
+  // the optimization pipeline on each piece as it is materialized.
+  jit_->setLazyCompileTransform(
+      [](llvm::orc::ThreadSafeModule tsm,
+         const llvm::orc::MaterializationResponsibility&) -> llvm::Expected<llvm::orc::ThreadSafeModule> {
+        tsm.withModuleDo([](llvm::Module& m) { Compiler::Optimize(&m); });
+        return std::move(tsm);
+      });
+  Check(jit_->addLazyIRModule(llvm::orc::ThreadSafeModule(std::move(module.module), std::move(context))),
+        "Unable to add program to lazy JIT");
+  entrypoint_ = reinterpret_cast<void (*)(void*)>(Lookup(invoker_name_));
+  if (!entrypoint_) {
+    throw std::runtime_error("Lazily compiled program has no entrypoint");
+  }
+  auto size_addr = Lookup(arena_size_name_);
+  auto flags_addr = Lookup(arena_flags_name_);
+  auto nodes_addr = Lookup(arena_nodes_name_);
+  arenas_.reset(new rt::ArenaPool(size_addr ? *reinterpret_cast<const uint64_t*>(size_addr) : 0,
+                                  flags_addr ? *reinterpret_cast<const uint32_t*>(flags_addr) : 0,
+                                  rt::ReadArenaPlacements(reinterpret_cast<const uint64_t*>(nodes_addr))));
+}
+
+uint64_t LazyExecutable::Lookup(const std::string& name) {
+  auto sym = jit_->lookup(name);
+  if (!sym) {
+    llvm::consumeError(sym.takeError());
+    return 0;
+  }
+  return sym->getAddress();
+}
+
+std::vector<void*> LazyExecutable::Bind(const std::map<std::string, void*>& buffers) const {
+  std::vector<void*> args(parameters_.size());
+  for (size_t i = 0; i < args.size(); ++i) {
+    args[i] = safe_at(buffers, parameters_[i]);
+  }
+  return args;
+}
+
+void LazyExecutable::Run(const std::vector<void*>& args) {
+  if (args.size() != parameters_.size()) {
+    throw std::runtime_error("CPU program expects " + std::to_string(parameters_.size()) + " buffer(s), got " +
+                             std::to_string(args.size()));
+  }
+  rt::Invoke(entrypoint_, args, arenas_.get());
+}
+
+void LazyExecutable::SetPerfAttrs(stripe::Block* block) {
+  block->set_attr("arena_bytes", static_cast<int64_t>(arenas_->size()));
+  ApplyPerfAttrs(block, [this](const std::string& name) { return Lookup(name); });
+}
+
+}  // namespace cpu
+}  // namespace targets
+}  // namespace tile
+}  // namespace vertexai
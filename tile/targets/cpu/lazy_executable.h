@@ -0,0 +1,55 @@
+// Copyright 2019, Intel Corp.
+
+#pragma once
+
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tile/stripe/stripe.h"
+#include "tile/targets/cpu/config.h"
+#include "tile/targets/cpu/programmodule.h"
+#include "tile/targets/cpu/runtime.h"
+
+namespace vertexai {
+namespace tile {
+namespace targets {
+namespace cpu {
+
+// Runs a program through ORC's lazy JIT. Each block function is replaced by a
+// stub which, on the first call, optimizes and compiles that function alone on
+// a pool of compile threads; the first run of a large program therefore only
+// pays for the kernels it reaches, and independent kernels compile in
+// parallel once ParallelFor fans out. The module must be unoptimized, as
+// produced by Compiler::CompileProgram with Config::lazy_compile set, and
+// must own its context, since compilation may happen on any thread.
+class LazyExecutable {
+ public:
+  LazyExecutable(ProgramModule module, std::unique_ptr<llvm::LLVMContext> context, const Config& config);
+
+  const std::vector<std::string>& parameters() const { return parameters_; }
+  std::vector<void*> Bind(const std::map<std::string, void*>& buffers) const;
+  // Safe to call concurrently; a kernel reached by several runs at once is
+  // compiled once while the others wait for it.
+  void Run(const std::vector<void*>& args);
+  void Run(const std::map<std::string, void*>& buffers) { Run(Bind(buffers)); }
+  void SetPerfAttrs(stripe::Block* block);
+  uint64_t ArenaBytes() const { return arenas_->size(); }
+
+ private:
+  // Returns the address of the named symbol, or zero if there is none.
+  uint64_t Lookup(const std::string& name);
+
+  std::unique_ptr<llvm::orc::LLLazyJIT> jit_;
+  std::vector<std::string> parameters_;
+  void (*entrypoint_)(void*) = nullptr;
+  std::unique_ptr<rt::ArenaPool> arenas_;
+};
+
+}  // namespace cpu
+}  // namespace targets
+}  // namespace tile
+}  // namespace vertexai
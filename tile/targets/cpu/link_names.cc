@@ -8,10 +8,14 @@ namespace targets {
 namespace cpu {
 
 const char invoker_name_[] = "__invoke_";
-const char arena_name_[] = "__arena";
+const char arena_size_name_[] = "__arena_size_";
+const char arena_flags_name_[] = "__arena_flags_";
+const char arena_nodes_name_[] = "__arena_nodes_";
+const char parameters_name_[] = "__parameters_";
 const char profile_count_name_[] = "__profile_count_";
 const char profile_ticks_name_[] = "__profile_ticks_";
 const char profile_loop_body_name_[] = "__profile_loop_body_";
+const char profile_hw_name_[] = "__profile_hw_";
 
 }  // namespace cpu
 }  // namespace targets
@@ -8,10 +8,14 @@ namespace targets {
 namespace cpu {
 
 extern const char invoker_name_[];
-extern const char arena_name_[];
+extern const char arena_size_name_[];
+extern const char arena_flags_name_[];
+extern const char arena_nodes_name_[];
+extern const char parameters_name_[];
 extern const char profile_count_name_[];
 extern const char profile_ticks_name_[];
 extern const char profile_loop_body_name_[];
+extern const char profile_hw_name_[];
 
 }  // namespace cpu
 }  // namespace targets
@@ -0,0 +1,194 @@
+// Copyright 2019, Intel Corp.
+
+#include "tile/targets/cpu/object_cache.h"
+
+#include <llvm/Config/llvm-config.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/Host.h>
+#include <llvm/Support/MD5.h>
+#include <llvm/Support/MemoryBuffer.h>
+
+#include <algorithm>
+#include <ctime>
+#include <regex>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#include "base/util/file.h"
+#include "base/util/logging.h"
+
+namespace vertexai {
+namespace tile {
+namespace targets {
+namespace cpu {
+
+namespace fs = boost::filesystem;
+
+namespace {
+
+// Bump this whenever the code generator changes in a way that would make
+// previously cached objects incorrect.
+const char kObjectCacheFormat[] = "5";
+
+std::string VersionDirName() { return std::string("v") + kObjectCacheFormat + "-llvm" + LLVM_VERSION_STRING; }
+
+// Whether a directory name is one VersionDirName may have produced, for any format or LLVM version.
+bool IsVersionDirName(const std::string& name) {
+  static const std::regex pattern{R"(v[0-9]+-llvm[0-9][0-9A-Za-z.+_-]*)"};
+  return std::regex_match(name, pattern);
+}
+
+}  // namespace
+
+ObjectCache::ObjectCache(const fs::path& dir, uint64_t max_bytes)
+    : dir_(dir / VersionDirName()), max_bytes_(max_bytes) {
+  boost::system::error_code ec;
+  fs::create_directories(dir_, ec);
+  if (ec) {
+    IVLOG(1, "Unable to create CPU object cache directory " << dir_ << ": " << ec.message());
+    return;
+  }
+  RemoveStaleVersions();
+}
+
+bool ObjectCache::IsCacheable(const Config& config) {
+  // External intrinsics resolve to process-specific function pointers, and
+  // profile counters are named by stripe::Block addresses; neither survives
+  // across processes.
+  return config.externals.empty() && !config.profile_block_execution && !config.profile_loop_body;
+}
+
+std::string ObjectCache::Key(const stripe::Block& program, const Config& config) {
+  std::stringstream ss;
+  ss << program;
+  llvm::MD5 hash;
+  hash.update(ss.str());
+  hash.update(VersionDirName());
+  // Codegen options which change the generated code.
+  std::stringstream opts;
+  opts << static_cast<int>(config.math_accuracy) << ":" << static_cast<int>(config.partitioner) << ":"
+       << config.grain_size << ":" << config.numa_arenas << ":" << config.numa_device << ":"
+       << config.pin_threads;
+  hash.update(opts.str());
+  hash.update(llvm::sys::getHostCPUName());
+  llvm::StringMap<bool> features;
+  if (llvm::sys::getHostCPUFeatures(features)) {
+    std::vector<std::string> enabled;
+    for (const auto& kvp : features) {
+      if (kvp.second) {
+        enabled.push_back(kvp.first().str());
+      }
+    }
+    std::sort(enabled.begin(), enabled.end());
+    for (const auto& feature : enabled) {
+      hash.update(feature);
+    }
+  }
+  llvm::MD5::MD5Result result;
+  hash.final(result);
+  return result.digest().str().str();
+}
+
+bool ObjectCache::Contains(const std::string& key) const {
+  boost::system::error_code ec;
+  return fs::is_regular_file(PathFor(key), ec);
+}
+
+void ObjectCache::Remove(const std::string& key) {
+  boost::system::error_code ec;
+  fs::remove(PathFor(key), ec);
+}
+
+void ObjectCache::notifyObjectCompiled(const llvm::Module* module, llvm::MemoryBufferRef obj) {
+  if (module->empty()) {
+    // A module which only declares the program (see Compiler::DeclareProgram)
+    // compiles to an object without any code; storing it would shadow the
+    // real entry.
+    return;
+  }
+  auto path = PathFor(module->getModuleIdentifier());
+  // Write to a private temporary and rename it into place, so that concurrent
+  // processes never observe a partially-written object.
+  auto tmp = path;
+  tmp += fs::unique_path(".%%%%%%%%.tmp");
+  try {
+    WriteFile(tmp, obj.getBuffer().str(), true);
+    fs::rename(tmp, path);
+  } catch (const std::exception& ex) {
+    IVLOG(1, "Unable to store CPU object cache entry " << path << ": " << ex.what());
+    boost::system::error_code ec;
+    fs::remove(tmp, ec);
+    return;
+  }
+  Prune();
+}
+
+std::unique_ptr<llvm::MemoryBuffer> ObjectCache::getObject(const llvm::Module* module) {
+  auto path = PathFor(module->getModuleIdentifier());
+  auto buffer = llvm::MemoryBuffer::getFile(path.string());
+  if (!buffer) {
+    return nullptr;
+  }
+  IVLOG(2, "Loaded CPU object from cache: " << path);
+  // Touch the entry so that pruning evicts the least recently used objects.
+  boost::system::error_code ec;
+  fs::last_write_time(path, std::time(nullptr), ec);
+  return std::move(*buffer);
+}
+
+fs::path ObjectCache::PathFor(const std::string& key) const { return dir_ / (key + ".o"); }
+
+void ObjectCache::RemoveStaleVersions() {
+  boost::system::error_code ec;
+  for (fs::directory_iterator it(dir_.parent_path(), ec), end; !ec && it != end; it.increment(ec)) {
+    // Only the cache's own version directories are removed; the cache directory may be shared with other data.
+    auto name = it->path().filename();
+    if (fs::is_directory(it->path()) && name != dir_.filename() && IsVersionDirName(name.string())) {
+      IVLOG(1, "Removing stale CPU object cache: " << it->path());
+      boost::system::error_code rm_ec;
+      fs::remove_all(it->path(), rm_ec);
+    }
+  }
+}
+
+void ObjectCache::Prune() {
+  struct Entry {
+    fs::path path;
+    std::time_t mtime;
+    uint64_t size;
+  };
+  std::vector<Entry> entries;
+  uint64_t total = 0;
+  boost::system::error_code ec;
+  for (fs::directory_iterator it(dir_, ec), end; !ec && it != end; it.increment(ec)) {
+    if (it->path().extension() != ".o") {
+      continue;
+    }
+    boost::system::error_code stat_ec;
+    Entry entry{it->path(), fs::last_write_time(it->path(), stat_ec), fs::file_size(it->path(), stat_ec)};
+    if (!stat_ec) {
+      total += entry.size;
+      entries.emplace_back(std::move(entry));
+    }
+  }
+  if (total <= max_bytes_) {
+    return;
+  }
+  std::sort(entries.begin(), entries.end(), [](const Entry& lhs, const Entry& rhs) { return lhs.mtime < rhs.mtime; });
+  for (const auto& entry : entries) {
+    if (total <= max_bytes_) {
+      break;
+    }
+    boost::system::error_code rm_ec;
+    if (fs::remove(entry.path, rm_ec)) {
+      IVLOG(2, "Evicted CPU object cache entry: " << entry.path);
+      total -= entry.size;
+    }
+  }
+}
+
+}  // namespace cpu
+}  // namespace targets
+}  // namespace tile
+}  // namespace vertexai
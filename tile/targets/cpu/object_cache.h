@@ -0,0 +1,59 @@
+// Copyright 2019, Intel Corp.
+
+#pragma once
+
+#include <llvm/ExecutionEngine/ObjectCache.h>
+
+#include <memory>
+#include <string>
+
+#include <boost/filesystem.hpp>
+
+#include "tile/stripe/stripe.h"
+#include "tile/targets/cpu/config.h"
+
+namespace vertexai {
+namespace tile {
+namespace targets {
+namespace cpu {
+
+// A persistent, on-disk store of relocatable objects produced by the JIT.
+// Each object is keyed by a digest of the program text, the codegen-relevant
+// parts of the Config, the host CPU, and the LLVM version; the key doubles as
+// the llvm::Module identifier, which is how MCJIT asks us for an object.
+// Objects live in a subdirectory named for the cache format and LLVM version;
+// subdirectories left behind by other versions (and only those: the directory
+// may hold other data) are removed when the cache is opened, and the least
+// recently used objects are evicted once the total size exceeds the configured
+// limit.
+class ObjectCache final : public llvm::ObjectCache {
+ public:
+  ObjectCache(const boost::filesystem::path& dir, uint64_t max_bytes);
+
+  // Returns true if the program can be cached at all under this config.
+  static bool IsCacheable(const Config& config);
+
+  // Computes the cache key for a program compiled with the specified config.
+  static std::string Key(const stripe::Block& program, const Config& config);
+
+  bool Contains(const std::string& key) const;
+
+  // Discards the entry for the specified key, if there is one.
+  void Remove(const std::string& key);
+
+  void notifyObjectCompiled(const llvm::Module* module, llvm::MemoryBufferRef obj) override;
+  std::unique_ptr<llvm::MemoryBuffer> getObject(const llvm::Module* module) override;
+
+ private:
+  boost::filesystem::path PathFor(const std::string& key) const;
+  void RemoveStaleVersions();
+  void Prune();
+
+  boost::filesystem::path dir_;
+  uint64_t max_bytes_;
+};
+
+}  // namespace cpu
+}  // namespace targets
+}  // namespace tile
+}  // namespace vertexai
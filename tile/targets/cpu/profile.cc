@@ -0,0 +1,215 @@
+// Copyright 2019, Intel Corp.
+
+#include "tile/targets/cpu/profile.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "tile/targets/cpu/link_names.h"
+#include "tile/targets/cpu/runtime.h"
+
+namespace vertexai {
+namespace tile {
+namespace targets {
+namespace cpu {
+
+namespace {
+
+const double kCacheLineBytes = 64;
+
+bool IsArithmetic(const std::string& op) {
+  return op == "add" || op == "sub" || op == "mul" || op == "div" || op == "neg" || op == "min" || op == "max" ||
+         op == "exp" || op == "log" || op == "sqrt" || op == "tanh" || op == "pow";
+}
+
+int64_t Counter(const GlobalLookup& lookup, const std::string& name) {
+  uint64_t addr = lookup(name);
+  return addr ? *reinterpret_cast<int64_t*>(addr) : 0;
+}
+
+void CollectProfiled(const stripe::Block& block, std::vector<const stripe::Block*>* blocks) {
+  if (block.has_attr("wall_ns")) {
+    blocks->push_back(&block);
+  }
+  for (const auto& stmt : block.stmts) {
+    if (auto inner = stripe::Block::Downcast(stmt)) {
+      CollectProfiled(*inner, blocks);
+    }
+  }
+}
+
+void AggregateInto(const stripe::Block& block, std::map<std::string, BlockProfile>* profiles) {
+  int64_t nested_ticks = 0;
+  int64_t nested_ns = 0;
+  for (const auto& stmt : block.stmts) {
+    if (auto inner = stripe::Block::Downcast(stmt)) {
+      nested_ticks += inner->get_attr_int("execution_ticks", 0);
+      nested_ns += inner->get_attr_int("wall_ns", 0);
+      AggregateInto(*inner, profiles);
+    }
+  }
+  if (!block.has_attr("execution_count")) {
+    return;
+  }
+  auto& profile = (*profiles)[block.name];
+  auto ticks = block.get_attr_int("execution_ticks", 0);
+  auto wall_ns = block.get_attr_int("wall_ns", 0);
+  profile.blocks++;
+  profile.executions += block.get_attr_int("execution_count");
+  profile.ticks += ticks;
+  profile.wall_ns += wall_ns;
+  // Nested blocks run on worker threads may add up to more than their parent.
+  profile.self_ticks += std::max<int64_t>(0, ticks - nested_ticks);
+  profile.self_ns += std::max<int64_t>(0, wall_ns - nested_ns);
+}
+
+}  // namespace
+
+void ApplyPerfAttrs(stripe::Block* block, const GlobalLookup& lookup) {
+  // Look up the performance counters for this block.
+  // Apply their values as tags.
+  std::string block_id = block->name + "@" + std::to_string((uintptr_t)block);
+  std::string count_name = profile_count_name_ + block_id;
+  uint64_t count_addr = lookup(count_name);
+  int64_t executions = 0;
+  if (count_addr) {
+    executions = *reinterpret_cast<int64_t*>(count_addr);
+    block->set_attr("execution_count", executions);
+  }
+  std::string ticks_name = profile_ticks_name_ + block_id;
+  uint64_t ticks_addr = lookup(ticks_name);
+  if (ticks_addr) {
+    block->set_attr("execution_ticks", *reinterpret_cast<int64_t*>(ticks_addr));
+  }
+  std::string loop_body_name = profile_loop_body_name_ + block_id;
+  uint64_t loop_ticks_addr = lookup(loop_body_name);
+  if (loop_ticks_addr) {
+    block->set_attr("loop_body_ticks", *reinterpret_cast<int64_t*>(loop_ticks_addr));
+  }
+  uint64_t hw_addr = lookup(profile_hw_name_ + block_id);
+  if (hw_addr) {
+    auto hw = reinterpret_cast<const int64_t*>(hw_addr);
+    block->set_attr("hw_cycles", hw[rt::kHwCycles]);
+    block->set_attr("hw_instructions", hw[rt::kHwInstructions]);
+    block->set_attr("hw_llc_misses", hw[rt::kHwCacheMisses]);
+    block->set_attr("wall_ns", hw[rt::kHwWallNanos]);
+    if (hw[rt::kHwWallNanos]) {
+      block->set_attr("gflops", executions * BlockFlops(*block) / hw[rt::kHwWallNanos]);
+    }
+  }
+  // Recurse through nested blocks.
+  for (const auto& stmt : block->stmts) {
+    if (stmt->kind() == stripe::StmtKind::Block) {
+      ApplyPerfAttrs(stripe::Block::Downcast(stmt).get(), lookup);
+    }
+  }
+}
+
+double BlockFlops(const stripe::Block& block) {
+  double per_iteration = 0;
+  for (const auto& stmt : block.stmts) {
+    switch (stmt->kind()) {
+      case stripe::StmtKind::Intrinsic: {
+        auto intrinsic = stripe::Intrinsic::Downcast(stmt);
+        if (is_float(intrinsic->type) && IsArithmetic(intrinsic->name)) {
+          per_iteration += 1;
+        }
+      } break;
+      case stripe::StmtKind::Store: {
+        // Aggregating stores perform one operation each.
+        auto store = stripe::Store::Downcast(stmt);
+        auto ref = block.ref_by_into(store->into, false);
+        if (ref != block.refs.end() && is_float(ref->interior_shape.type) && IsArithmetic(ref->agg_op)) {
+          per_iteration += 1;
+        }
+      } break;
+      case stripe::StmtKind::Block:
+        per_iteration += BlockFlops(*stripe::Block::Downcast(stmt));
+        break;
+      default:
+        break;
+    }
+  }
+  return per_iteration * block.idxs_product();
+}
+
+void WriteRooflineReport(const stripe::Block& program, std::ostream* os, double peak_gflops, double peak_gbps) {
+  std::vector<const stripe::Block*> blocks;
+  CollectProfiled(program, &blocks);
+  std::sort(blocks.begin(), blocks.end(), [](const stripe::Block* lhs, const stripe::Block* rhs) {
+    return lhs->get_attr_int("wall_ns") > rhs->get_attr_int("wall_ns");
+  });
+  double ridge = (peak_gflops > 0 && peak_gbps > 0) ? peak_gflops / peak_gbps : 0;
+  auto& out = *os;
+  out << std::left << std::setw(40) << "block" << std::right  //
+      << std::setw(10) << "count"                             //
+      << std::setw(12) << "ms"                                //
+      << std::setw(10) << "GFLOP/s"                           //
+      << std::setw(8) << "IPC"                                //
+      << std::setw(14) << "LLC misses"                        //
+      << std::setw(10) << "flop/B"                            //
+      << (ridge ? "  bound" : "") << "\n";
+  for (const auto* block : blocks) {
+    auto executions = block->get_attr_int("execution_count");
+    auto wall_ns = block->get_attr_int("wall_ns");
+    auto cycles = block->get_attr_int("hw_cycles");
+    auto instructions = block->get_attr_int("hw_instructions");
+    auto misses = block->get_attr_int("hw_llc_misses");
+    double flops = executions * BlockFlops(*block);
+    double gflops = wall_ns ? flops / wall_ns : 0;
+    double intensity = misses ? flops / (misses * kCacheLineBytes) : 0;
+    out << std::left << std::setw(40) << block->name.substr(0, 39) << std::right  //
+        << std::setw(10) << executions                                          //
+        << std::setw(12) << std::fixed << std::setprecision(3) << wall_ns / 1e6  //
+        << std::setw(10) << std::setprecision(2) << gflops                       //
+        << std::setw(8) << (cycles ? static_cast<double>(instructions) / cycles : 0.0)  //
+        << std::setw(14) << misses                                                   //
+        << std::setw(10) << intensity;
+    if (ridge) {
+      out << "  " << ((misses && intensity < ridge) ? "memory" : "compute");
+    }
+    out << "\n";
+  }
+}
+
+std::map<std::string, BlockProfile> AggregateBlockProfiles(const stripe::Block& program) {
+  std::map<std::string, BlockProfile> profiles;
+  AggregateInto(program, &profiles);
+  return profiles;
+}
+
+void WriteBlockProfileReport(const stripe::Block& program, std::ostream* os) {
+  auto profiles = AggregateBlockProfiles(program);
+  std::vector<std::pair<std::string, BlockProfile>> rows(profiles.begin(), profiles.end());
+  std::stable_sort(rows.begin(), rows.end(), [](const auto& lhs, const auto& rhs) {
+    return std::tie(lhs.second.self_ns, lhs.second.self_ticks) > std::tie(rhs.second.self_ns, rhs.second.self_ticks);
+  });
+  auto& out = *os;
+  out << std::left << std::setw(40) << "block" << std::right  //
+      << std::setw(8) << "blocks"                             //
+      << std::setw(12) << "count"                             //
+      << std::setw(14) << "kticks"                            //
+      << std::setw(14) << "self kticks"                       //
+      << std::setw(12) << "ms"                                //
+      << std::setw(12) << "self ms"                           //
+      << "\n";
+  for (const auto& row : rows) {
+    const auto& profile = row.second;
+    out << std::left << std::setw(40) << row.first.substr(0, 39) << std::right  //
+        << std::setw(8) << profile.blocks                                       //
+        << std::setw(12) << profile.executions                                  //
+        << std::setw(14) << profile.ticks                                       //
+        << std::setw(14) << profile.self_ticks                                  //
+        << std::setw(12) << std::fixed << std::setprecision(3) << profile.wall_ns / 1e6  //
+        << std::setw(12) << profile.self_ns / 1e6                                        //
+        << "\n";
+  }
+}
+
+}  // namespace cpu
+}  // namespace targets
+}  // namespace tile
+}  // namespace vertexai
@@ -0,0 +1,68 @@
+// Copyright 2019, Intel Corp.
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <ostream>
+#include <string>
+
+#include "tile/stripe/stripe.h"
+
+namespace vertexai {
+namespace tile {
+namespace targets {
+namespace cpu {
+
+// Resolves the address of a global in a loaded program, or zero if the
+// program does not define it.
+typedef std::function<uint64_t(const std::string&)> GlobalLookup;
+
+// Copies the profile counters of a loaded program onto the blocks they
+// measured, as attributes:
+//   execution_count, execution_ticks, loop_body_ticks  (profile_block_execution,
+//                                                       profile_loop_body)
+//   hw_cycles, hw_instructions, hw_llc_misses, wall_ns, gflops
+//                                                      (profile_hw_counters)
+// Hardware counts are inclusive of nested blocks and are sampled on the
+// thread which invoked the block, so for cpu_thread blocks they only reflect
+// the caller's share of the work; wall_ns and gflops are exact either way.
+void ApplyPerfAttrs(stripe::Block* block, const GlobalLookup& lookup);
+
+// The number of floating point operations one execution of the block
+// performs, including nested blocks. This counts every iteration of the
+// block's index space, so blocks with constraints are overestimated.
+double BlockFlops(const stripe::Block& block);
+
+// Writes a roofline-style table of the blocks annotated by ApplyPerfAttrs,
+// hottest first. Arithmetic intensity is measured against last-level cache
+// misses, i.e. DRAM traffic; when the machine's peak compute and bandwidth
+// are given, each block is also classified as memory or compute bound.
+void WriteRooflineReport(const stripe::Block& program, std::ostream* os, double peak_gflops = 0,
+                         double peak_gbps = 0);
+
+// Profile totals for the blocks sharing a name.  Inclusive times cover nested
+// blocks; self times exclude them, which is what points at the hot sub-block
+// of a large fused kernel.
+struct BlockProfile {
+  int64_t blocks = 0;      // Profiled blocks with this name
+  int64_t executions = 0;  // execution_count
+  int64_t ticks = 0;       // execution_ticks (kilocycles), inclusive
+  int64_t self_ticks = 0;
+  int64_t wall_ns = 0;  // wall_ns, inclusive
+  int64_t self_ns = 0;
+};
+
+// Sums the profile attributes of the program's blocks by block name.  This
+// reads the attributes written by ApplyPerfAttrs as well as those written by
+// the Stripe VM's profiling mode (codegen::ProfileProgram).
+std::map<std::string, BlockProfile> AggregateBlockProfiles(const stripe::Block& program);
+
+// Writes the aggregated block profile as a table, by self time, most first.
+void WriteBlockProfileReport(const stripe::Block& program, std::ostream* os);
+
+}  // namespace cpu
+}  // namespace targets
+}  // namespace tile
+}  // namespace vertexai
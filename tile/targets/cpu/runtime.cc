@@ -0,0 +1,728 @@
+// Copyright 2019, Intel Corp.
+
+#include "tile/targets/cpu/runtime.h"
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <linux/perf_event.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "base/util/logging.h"
+#include "tbb/tbb.h"
+
+#if defined(_WIN32)
+// As of 2019-08-01, libxsmm doesn't compile on Windows if UNICODE is defined, since it passes
+// an ANSI string to CreateMutexW().  So we rewrite it.
+#undef CreateMutex
+#define CreateMutex CreateMutexA
+#endif
+
+// libxsmm
+#include "libxsmm_source.h"  // NOLINT
+
+namespace vertexai {
+namespace tile {
+namespace targets {
+namespace cpu {
+namespace rt {
+
+float h2f(half_float::half n) { return n; }
+half_float::half f2h(float n) { return half_float::half_cast<half_float::half>(n); }
+namespace {
+
+// The PRNG streams are stepped in groups of this many lanes, which the compiler
+// can keep in vector registers.
+constexpr size_t kPrngLanes = 16;
+
+// Below this many outputs, splitting the streams among threads isn't worth it.
+constexpr size_t kPrngParallelCount = 1 << 16;
+
+// Steps streams [first, last) through every output they produce.
+void PrngStreams(const uint32_t* in_state, uint32_t* out_state, float* buf, size_t count, size_t streams,
+                 size_t first, size_t last) {
+  for (size_t base = first; base < last; base += kPrngLanes) {
+    size_t lanes = std::min(kPrngLanes, last - base);
+    uint32_t s1[kPrngLanes];
+    uint32_t s2[kPrngLanes];
+    uint32_t s3[kPrngLanes];
+    for (size_t l = 0; l < lanes; ++l) {
+      s1[l] = in_state[base + l];
+      s2[l] = in_state[streams + base + l];
+      s3[l] = in_state[2 * streams + base + l];
+    }
+    for (size_t offset = base; offset < count; offset += streams) {
+      // Only the streams with an output left in this row advance.
+      size_t active = std::min(lanes, count - offset);
+      for (size_t l = 0; l < active; ++l) {
+        s1[l] = (((s1[l] & 4294967294) << 12) ^ (((s1[l] << 13) ^ s1[l]) >> 19));
+        s2[l] = (((s2[l] & 4294967288) << 4) ^ (((s2[l] << 2) ^ s2[l]) >> 25));
+        s3[l] = (((s3[l] & 4294967280) << 17) ^ (((s3[l] << 3) ^ s3[l]) >> 11));
+        buf[offset + l] = static_cast<float>(s1[l] ^ s2[l] ^ s3[l]) * (1.0f / 4294967296.0f);
+      }
+    }
+    for (size_t l = 0; l < lanes; ++l) {
+      out_state[base + l] = s1[l];
+      out_state[streams + base + l] = s2[l];
+      out_state[2 * streams + base + l] = s3[l];
+    }
+  }
+}
+
+}  // namespace
+
+void prng_step(uint32_t* in_state, uint32_t* out_state, float* buf, size_t count, size_t streams) {
+  // A reimplementation of the PRNG from tile/lang/gen_special.cc.  The state
+  // holds three rows of one word per stream; stream j produces the outputs
+  // j, j + streams, j + 2 * streams, ..., stepping the state before each one:
+  // s1_{n+1} = (((s1_n & 4294967294) <<12) ^ (((s1_n <<13) ^ s1_n) >>19))
+  // s2_{n+1} = (((s2_n & 4294967288) << 4) ^ (((s2_n << 2) ^ s2_n) >>25))
+  // s3_{n+1} = (((s3_n & 4294967280) <<17) ^ (((s3_n << 3) ^ s3_n) >>11))
+  // x_{n+1} = (s1_{n+1} ^ s2_{n+1} ^ s3_{n+1})
+  // The streams are independent, so they're stepped in parallel.
+  if (count < kPrngParallelCount || streams <= kPrngLanes) {
+    PrngStreams(in_state, out_state, buf, count, streams, 0, streams);
+    return;
+  }
+  size_t groups = (streams + kPrngLanes - 1) / kPrngLanes;
+  tbb::parallel_for(size_t(0), groups, [&](size_t group) {
+    size_t first = group * kPrngLanes;
+    PrngStreams(in_state, out_state, buf, count, streams, first, std::min(streams, first + kPrngLanes));
+  });
+}
+
+void RunTimeLogEntry(char* str, char* extra, float address) {
+  IVLOG(1, "RunTimeLogEntry: " << str << ":" << extra << ":" /* 0x" << std::hex */ << address);
+}
+
+void XSMMRTCaller(libxsmm_function func, const void* aPtr, const void* bPtr, void* cPtr) { func(aPtr, bPtr, cPtr); }
+
+void XSMMReduceRTCaller(libxsmm_reduce_function func, const void** aPtrs, const void** bPtrs, void* cPtr,
+                        size_t count) {
+  unsigned long long batch = count;  // NOLINT(runtime/int)
+  func(aPtrs, bPtrs, cPtr, &batch);
+}
+
+std::vector<std::vector<int>> NumaNodes(const std::string& sysfs_dir) {
+  std::vector<std::vector<int>> nodes;
+#if defined(__linux__)
+  // Node ids may be sparse (say, node0 and node2), so the directory is listed rather than probed in order.
+  std::vector<int> ids;
+  if (DIR* dir = opendir(sysfs_dir.c_str())) {
+    while (auto* entry = readdir(dir)) {
+      std::string name = entry->d_name;
+      if (name.size() > 4 && name.compare(0, 4, "node") == 0 &&
+          name.find_first_not_of("0123456789", 4) == std::string::npos) {
+        ids.push_back(std::stoi(name.substr(4)));
+      }
+    }
+    closedir(dir);
+  }
+  std::sort(ids.begin(), ids.end());
+  for (int node : ids) {
+    std::ifstream cpulist(sysfs_dir + "/node" + std::to_string(node) + "/cpulist");
+    if (!cpulist) {
+      continue;
+    }
+    // The list looks like "0-27,56-83".
+    std::vector<int> cpus;
+    std::string range;
+    while (std::getline(cpulist, range, ',')) {
+      auto dash = range.find('-');
+      int first = std::stoi(range.substr(0, dash));
+      int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+      for (int cpu = first; cpu <= last; ++cpu) {
+        cpus.push_back(cpu);
+      }
+    }
+    if (!cpus.empty()) {
+      nodes.emplace_back(std::move(cpus));
+    }
+  }
+#endif
+  if (nodes.empty()) {
+    std::vector<int> cpus(std::max(1U, std::thread::hardware_concurrency()));
+    std::iota(cpus.begin(), cpus.end(), 0);
+    nodes.emplace_back(std::move(cpus));
+  }
+  return nodes;
+}
+
+namespace {
+
+size_t NumaNodeCount() {
+  static const size_t count = NumaNodes("/sys/devices/system/node").size();
+  return count;
+}
+
+// Pins each worker thread entering an arena to one of the arena's CPUs,
+// chosen by the thread's slot within the arena.  Application threads which
+// join the arena (such as the one running the program) are left alone, since
+// their affinity is theirs to manage and would outlive the arena's work.
+class PinningObserver : public tbb::task_scheduler_observer {
+ public:
+  PinningObserver(tbb::task_arena* arena, std::vector<int> cpus)
+      : tbb::task_scheduler_observer(*arena), cpus_(std::move(cpus)) {
+    observe(true);
+  }
+
+  void on_scheduler_entry(bool is_worker) override {
+#if defined(__linux__)
+    if (!is_worker) {
+      return;
+    }
+    int slot = tbb::this_task_arena::current_thread_index();
+    if (slot < 0) {
+      return;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpus_[slot % cpus_.size()], &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+  }
+
+ private:
+  std::vector<int> cpus_;
+};
+
+// A set of explicit task arenas: one per NUMA node for the NUMA executor, or
+// a single machine-wide arena when only pinning is requested.
+class Executor {
+ public:
+  static Executor& Instance(uint32_t flags) {
+    static Executor numa_pinned{true, true};
+    static Executor numa{true, false};
+    static Executor pinned{false, true};
+    if (flags & kNumaArenas) {
+      return (flags & kPinThreads) ? numa_pinned : numa;
+    }
+    return pinned;
+  }
+
+  // Splits [0, range_size) into one contiguous share per arena, running each
+  // share within its arena, and waits for all of them to complete. When the
+  // flags name a node, the whole range runs within that node's arena.
+  void Run(size_t range_size, uint32_t flags, const std::function<void(size_t, size_t)>& body) {
+    size_t count = arenas_.size();
+    uint32_t node = (flags & kNumaNodeMask) >> kNumaNodeShift;
+    if (node) {
+      arenas_[(node - 1) % count]->execute([&] { body(0, range_size); });
+      return;
+    }
+    std::vector<tbb::task_group> groups(count);
+    for (size_t i = 0; i < count; ++i) {
+      size_t begin = range_size * i / count;
+      size_t end = range_size * (i + 1) / count;
+      if (begin == end) {
+        continue;
+      }
+      arenas_[i]->execute([&, i, begin, end] { groups[i].run([&body, begin, end] { body(begin, end); }); });
+    }
+    for (size_t i = 0; i < count; ++i) {
+      arenas_[i]->execute([&, i] { groups[i].wait(); });
+    }
+  }
+
+ private:
+  Executor(bool per_node, bool pin) {
+    auto nodes = NumaNodes("/sys/devices/system/node");
+    if (!per_node) {
+      std::vector<int> all;
+      for (const auto& node : nodes) {
+        all.insert(all.end(), node.begin(), node.end());
+      }
+      nodes = {all};
+    }
+    for (auto& cpus : nodes) {
+      arenas_.emplace_back(std::make_unique<tbb::task_arena>(cpus.size()));
+      arenas_.back()->initialize();
+      if (pin) {
+        observers_.emplace_back(std::make_unique<PinningObserver>(arenas_.back().get(), cpus));
+      }
+    }
+    IVLOG(1, "CPU executor: " << arenas_.size() << " arena(s)" << (pin ? ", pinned" : ""));
+  }
+
+  std::vector<std::unique_ptr<tbb::task_arena>> arenas_;
+  std::vector<std::unique_ptr<PinningObserver>> observers_;
+};
+
+// Affinity partitioners only pay off when the same one is reused across
+// invocations of the same loop, so we keep one per block function.
+tbb::affinity_partitioner* AffinityPartitioner(cpu_thread_block func) {
+  static std::mutex mu;
+  static std::map<cpu_thread_block, std::unique_ptr<tbb::affinity_partitioner>> partitioners;
+  std::lock_guard<std::mutex> lock(mu);
+  auto& ptr = partitioners[func];
+  if (!ptr) {
+    ptr = std::make_unique<tbb::affinity_partitioner>();
+  }
+  return ptr.get();
+}
+
+void PartitionedFor(size_t begin, size_t end, size_t grain_size, uint32_t flags, cpu_thread_block func,
+                    const std::function<void(size_t, size_t)>& body) {
+  tbb::blocked_range<size_t> range(begin, end, std::max<size_t>(grain_size, 1));
+  auto fn = [&body](const tbb::blocked_range<size_t>& r) { body(r.begin(), r.end()); };
+  switch (flags & kPartitionMask) {
+    case kPartitionStatic:
+      tbb::parallel_for(range, fn, tbb::static_partitioner());
+      break;
+    case kPartitionAffinity:
+      tbb::parallel_for(range, fn, *AffinityPartitioner(func));
+      break;
+    default:
+      tbb::parallel_for(range, fn, tbb::auto_partitioner());
+      break;
+  }
+}
+
+void Dispatch(size_t range_size, size_t grain_size, uint32_t flags, cpu_thread_block func,
+              const std::function<void(size_t, size_t)>& body) {
+  if (!(flags & (kNumaArenas | kPinThreads))) {
+    PartitionedFor(0, range_size, grain_size, flags, func, body);
+    return;
+  }
+  Executor::Instance(flags).Run(range_size, flags, [&](size_t begin, size_t end) {  //
+    PartitionedFor(begin, end, grain_size, flags, func, body);
+  });
+}
+
+}  // namespace
+
+void ParallelFor(void** refs, ssize_t* inits, size_t range_size, cpu_thread_block func, size_t grain_size,
+                 uint32_t flags) {
+  Dispatch(range_size, grain_size, flags, func, [=](size_t begin, size_t end) {  //
+    func(refs, inits, begin, end);
+  });
+}
+
+void ParallelTasks(void*** refs, ssize_t** inits, cpu_thread_block* funcs, size_t* ranges, size_t count,
+                   uint32_t flags) {
+  // The tasks are placed as a whole; within a task only the partitioner
+  // applies, since its range already runs inside an arena.
+  Dispatch(count, 1, flags & ~kPartitionAffinity, nullptr, [=](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      PartitionedFor(0, ranges[i], 1, flags & kPartitionMask, funcs[i], [=](size_t first, size_t last) {  //
+        funcs[i](refs[i], inits[i], first, last);
+      });
+    }
+  });
+}
+
+void FirstTouch(void* buffer, size_t size, uint32_t flags) {
+  // Touch the buffer in page-sized units, scheduled the same way as the
+  // blocks which will use it.
+  const size_t kPageSize = 4096;
+  auto bytes = static_cast<char*>(buffer);
+  size_t pages = (size + kPageSize - 1) / kPageSize;
+  Dispatch(pages, 1, flags & ~kPartitionAffinity, nullptr, [=](size_t begin, size_t end) {
+    size_t first = begin * kPageSize;
+    size_t last = std::min(end * kPageSize, size);
+    std::memset(bytes + first, 0, last - first);
+  });
+}
+
+void BindToNode(void* buffer, size_t size, uint64_t node, uint32_t flags) {
+  const size_t kPageSize = 4096;
+  auto addr = reinterpret_cast<uintptr_t>(buffer);
+  uintptr_t first = (addr + kPageSize - 1) & ~(kPageSize - 1);
+  uintptr_t last = (addr + size) & ~(kPageSize - 1);
+  if (first >= last) {
+    return;
+  }
+  node %= NumaNodeCount();
+#if defined(__linux__) && defined(__NR_mbind)
+  // Bind the range to the node (MPOL_BIND), migrating any pages which have
+  // already been faulted in (MPOL_MF_MOVE).
+  const int kMpolBind = 2;
+  const unsigned kMpolMfMove = 1 << 1;
+  uint64_t mask[16] = {0};
+  mask[node / 64] |= uint64_t{1} << (node % 64);
+  if (syscall(__NR_mbind, first, last - first, kMpolBind, mask, sizeof(mask) * 8, kMpolMfMove) == 0) {
+    return;
+  }
+  IVLOG(2, "mbind failed; placing " << (last - first) << " bytes on node " << node << " by first touch");
+#endif
+  // Otherwise, touch the pages from the node's own threads.
+  auto bytes = reinterpret_cast<char*>(first);
+  size_t pages = (last - first) / kPageSize;
+  uint32_t node_flags = (flags & ~(kNumaNodeMask | kPartitionAffinity)) | kNumaArenas |
+                        static_cast<uint32_t>((node + 1) << kNumaNodeShift);
+  Dispatch(pages, 1, node_flags, nullptr, [=](size_t begin, size_t end) {
+    std::memset(bytes + begin * kPageSize, 0, (end - begin) * kPageSize);
+  });
+}
+
+std::vector<ArenaPlacement> ReadArenaPlacements(const uint64_t* table) {
+  std::vector<ArenaPlacement> placements;
+  if (!table) {
+    return placements;
+  }
+  for (uint64_t i = 0; i < table[0]; ++i) {
+    const uint64_t* entry = table + 1 + 3 * i;
+    placements.push_back(ArenaPlacement{entry[0], entry[1], entry[2]});
+  }
+  return placements;
+}
+
+namespace {
+
+// Clamps a gather or scatter index to the rows of the indexed tensor.
+size_t ClampRow(int32_t index, size_t rows) {
+  if (index < 0) {
+    return 0;
+  }
+  return std::min(static_cast<size_t>(index), rows - 1);
+}
+
+}  // namespace
+
+void GatherRows(void* dest, const void* data, const int32_t* indices, size_t count, size_t data_rows,
+                size_t row_bytes, uint32_t flags) {
+  // Give each task at least a few pages' worth of rows to copy.
+  const size_t kTaskBytes = 16384;
+  auto dest_bytes = static_cast<char*>(dest);
+  auto data_bytes = static_cast<const char*>(data);
+  size_t grain = std::max<size_t>(1, kTaskBytes / std::max<size_t>(row_bytes, 1));
+  Dispatch(count, grain, flags & ~kPartitionAffinity, nullptr, [=](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      std::memcpy(dest_bytes + i * row_bytes, data_bytes + ClampRow(indices[i], data_rows) * row_bytes, row_bytes);
+    }
+  });
+}
+
+namespace {
+
+// Copies strided rows, with the common element-sized rows of a transposing
+// copy moved as single values rather than through memcpy.
+template <typename T>
+void CopyElementRows(char* dest, const char* src, size_t begin, size_t end, ssize_t dest_stride,
+                     ssize_t src_stride) {
+  for (size_t i = begin; i < end; ++i) {
+    T value;
+    std::memcpy(&value, src + static_cast<ssize_t>(i) * src_stride, sizeof(T));
+    std::memcpy(dest + static_cast<ssize_t>(i) * dest_stride, &value, sizeof(T));
+  }
+}
+
+}  // namespace
+
+void CopyRows(void* dest, const void* src, size_t rows, size_t row_bytes, ssize_t dest_stride, ssize_t src_stride,
+              uint32_t flags) {
+  // Copies smaller than this aren't worth handing to other threads.
+  const size_t kTaskBytes = 65536;
+  auto dest_bytes = static_cast<char*>(dest);
+  auto src_bytes = static_cast<const char*>(src);
+  if (rows == 1 && row_bytes > kTaskBytes) {
+    // A single large contiguous run: divide it into chunks of whole cache lines.
+    const size_t kChunkBytes = 64;
+    size_t chunks = (row_bytes + kChunkBytes - 1) / kChunkBytes;
+    Dispatch(chunks, kTaskBytes / kChunkBytes, flags & ~kPartitionAffinity, nullptr, [=](size_t begin, size_t end) {
+      size_t first = begin * kChunkBytes;
+      size_t last = std::min(end * kChunkBytes, row_bytes);
+      std::memcpy(dest_bytes + first, src_bytes + first, last - first);
+    });
+    return;
+  }
+  auto copy = [=](size_t begin, size_t end) {
+    switch (row_bytes) {
+      case 1:
+        CopyElementRows<uint8_t>(dest_bytes, src_bytes, begin, end, dest_stride, src_stride);
+        break;
+      case 2:
+        CopyElementRows<uint16_t>(dest_bytes, src_bytes, begin, end, dest_stride, src_stride);
+        break;
+      case 4:
+        CopyElementRows<uint32_t>(dest_bytes, src_bytes, begin, end, dest_stride, src_stride);
+        break;
+      case 8:
+        CopyElementRows<uint64_t>(dest_bytes, src_bytes, begin, end, dest_stride, src_stride);
+        break;
+      default:
+        for (size_t i = begin; i < end; ++i) {
+          std::memcpy(dest_bytes + static_cast<ssize_t>(i) * dest_stride,
+                      src_bytes + static_cast<ssize_t>(i) * src_stride, row_bytes);
+        }
+        break;
+    }
+  };
+  if (rows * row_bytes <= kTaskBytes) {
+    copy(0, rows);
+    return;
+  }
+  size_t grain = std::max<size_t>(1, kTaskBytes / std::max<size_t>(row_bytes, 1));
+  Dispatch(rows, grain, flags & ~kPartitionAffinity, nullptr, copy);
+}
+
+void ScatterAddRows(float* dest, const float* data, const int32_t* indices, size_t count, size_t dest_rows,
+                    size_t row_elems, uint32_t flags) {
+  // Keep each task's columns at least a cache line wide.
+  const size_t kTaskColumns = 16;
+  Dispatch(row_elems, kTaskColumns, flags & ~kPartitionAffinity, nullptr, [=](size_t begin, size_t end) {
+    for (size_t i = 0; i < count; ++i) {
+      float* dest_row = dest + ClampRow(indices[i], dest_rows) * row_elems;
+      const float* data_row = data + i * row_elems;
+      for (size_t j = begin; j < end; ++j) {
+        dest_row[j] += data_row[j];
+      }
+    }
+  });
+}
+
+namespace {
+
+const size_t kArenaAlignment = 64;
+const size_t kHugePageSize = 2 * 1024 * 1024;
+
+bool UseHugePages(size_t size) {
+#if defined(__linux__)
+  return size >= kHugePageSize;
+#else
+  return false;
+#endif
+}
+
+}  // namespace
+
+void* ArenaAlloc(size_t size, uint32_t flags, const std::vector<ArenaPlacement>& placements) {
+  void* arena = nullptr;
+  if (UseHugePages(size)) {
+#if defined(__linux__)
+    size_t bytes = (size + kHugePageSize - 1) & ~(kHugePageSize - 1);
+    arena = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (arena == MAP_FAILED) {
+      throw std::bad_alloc();
+    }
+    // This is advisory; if transparent huge pages are disabled the arena is
+    // simply backed by normal pages.
+    madvise(arena, bytes, MADV_HUGEPAGE);
+#endif
+  } else {
+    size_t bytes = (size + kArenaAlignment - 1) & ~(kArenaAlignment - 1);
+#if defined(_WIN32)
+    arena = _aligned_malloc(bytes, kArenaAlignment);
+#else
+    arena = aligned_alloc(kArenaAlignment, bytes);
+#endif
+    if (!arena) {
+      throw std::bad_alloc();
+    }
+  }
+  if (flags & kNumaArenas) {
+    // Bind the placed ranges first, so that touching the rest of the arena
+    // faults their pages in on the nodes they were bound to.
+    for (const auto& placement : placements) {
+      if (placement.offset < size) {
+        BindToNode(static_cast<char*>(arena) + placement.offset, std::min(placement.size, size - placement.offset),
+                   placement.node, flags);
+      }
+    }
+    FirstTouch(arena, size, flags);
+  }
+  return arena;
+}
+
+void ArenaFree(void* arena, size_t size) {
+  if (!arena) {
+    return;
+  }
+  if (UseHugePages(size)) {
+#if defined(__linux__)
+    munmap(arena, (size + kHugePageSize - 1) & ~(kHugePageSize - 1));
+#endif
+  } else {
+#if defined(_WIN32)
+    _aligned_free(arena);
+#else
+    free(arena);
+#endif
+  }
+}
+
+namespace {
+
+#if defined(__linux__)
+
+// A group of per-thread hardware counters which are read in one syscall.
+class PerfCounters {
+ public:
+  PerfCounters() {
+    const std::pair<HwCounter, uint64_t> events[] = {
+        {kHwCycles, PERF_COUNT_HW_CPU_CYCLES},
+        {kHwInstructions, PERF_COUNT_HW_INSTRUCTIONS},
+        {kHwCacheMisses, PERF_COUNT_HW_CACHE_MISSES},
+    };
+    for (const auto& event : events) {
+      perf_event_attr attr;
+      std::memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = event.second;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_GROUP;
+      int fd = syscall(__NR_perf_event_open, &attr, 0, -1, leader_, 0);
+      if (fd < 0) {
+        continue;
+      }
+      if (leader_ < 0) {
+        leader_ = fd;
+      }
+      fds_.push_back(fd);
+      slots_.push_back(event.first);
+    }
+    if (leader_ < 0) {
+      IVLOG(1, "Hardware performance counters are unavailable");
+    }
+  }
+
+  ~PerfCounters() {
+    for (int fd : fds_) {
+      close(fd);
+    }
+  }
+
+  void Read(int64_t* values) {
+    if (leader_ < 0) {
+      return;
+    }
+    uint64_t buf[1 + kHwCounterCount];
+    auto bytes = read(leader_, buf, sizeof(buf));
+    if (bytes < static_cast<ssize_t>(sizeof(uint64_t))) {
+      return;
+    }
+    for (size_t i = 0; i < buf[0] && i < slots_.size(); ++i) {
+      values[slots_[i]] = buf[1 + i];
+    }
+  }
+
+ private:
+  int leader_ = -1;
+  std::vector<int> fds_;
+  std::vector<HwCounter> slots_;
+};
+
+#endif  // __linux__
+
+}  // namespace
+
+void AccumulateHwCounters(int64_t* totals, int64_t sign) {
+  int64_t values[kHwCounterCount] = {0};
+#if defined(__linux__)
+  thread_local PerfCounters counters;
+  counters.Read(values);
+#endif
+  values[kHwWallNanos] =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+          .count();
+  for (int i = 0; i < kHwCounterCount; ++i) {
+    __atomic_fetch_add(&totals[i], sign * values[i], __ATOMIC_RELAXED);
+  }
+}
+
+ArenaPool::~ArenaPool() {
+  for (void* arena : free_) {
+    ArenaFree(arena, size_);
+  }
+}
+
+std::shared_ptr<void> ArenaPool::Acquire() {
+  if (!size_) {
+    return nullptr;
+  }
+  void* arena = nullptr;
+  {
+    std::lock_guard<std::mutex> lock{mu_};
+    if (!free_.empty()) {
+      arena = free_.back();
+      free_.pop_back();
+    }
+  }
+  if (!arena) {
+    arena = ArenaAlloc(size_, flags_, placements_);
+  }
+  return std::shared_ptr<void>(arena, [this](void* arena) {
+    std::lock_guard<std::mutex> lock{mu_};
+    free_.push_back(arena);
+  });
+}
+
+void Invoke(void (*entrypoint)(void*), const std::vector<void*>& args, ArenaPool* arenas) {
+  auto arena = arenas->Acquire();
+  std::vector<void*> argv;
+  argv.reserve(args.size() + 1);
+  argv.insert(argv.end(), args.begin(), args.end());
+  argv.push_back(arena.get());
+  entrypoint(argv.data());
+}
+
+template <typename T>
+void* Addr(T ptr) {
+  return reinterpret_cast<void*>(ptr);
+}
+
+const std::map<std::string, void*>& Symbols() {
+  static const std::map<std::string, void*> symbols{
+      {"__gnu_h2f_ieee", Addr(h2f)},
+      {"__gnu_f2h_ieee", Addr(f2h)},
+      {"___extendhfsf2", Addr(h2f)},
+      {"___truncsfhf2", Addr(f2h)},
+      {"_libxsmm_dmmdispatch", Addr(libxsmm_dmmdispatch)},
+      {"_libxsmm_smmdispatch", Addr(libxsmm_smmdispatch)},
+      {"_libxsmm_wimmdispatch", Addr(libxsmm_wimmdispatch)},
+      {"_prng_step", Addr(prng_step)},
+      {"_RunTimeLogEntry", Addr(RunTimeLogEntry)},  // For debugging
+      {"_XSMMRTCaller", Addr(XSMMRTCaller)},
+      {"_XSMMReduceRTCaller", Addr(XSMMReduceRTCaller)},
+      {"_libxsmm_smmdispatch_reducebatch", Addr(libxsmm_smmdispatch_reducebatch)},
+      {"_ParallelFor", Addr(ParallelFor)},
+      {"_ParallelTasks", Addr(ParallelTasks)},
+      {"_GatherRows", Addr(GatherRows)},
+      {"_CopyRows", Addr(CopyRows)},
+      {"_ScatterAddRows", Addr(ScatterAddRows)},
+      {"_AccumulateHwCounters", Addr(AccumulateHwCounters)},
+      {"libxsmm_dmmdispatch", Addr(libxsmm_dmmdispatch)},
+      {"libxsmm_smmdispatch", Addr(libxsmm_smmdispatch)},
+      {"libxsmm_wimmdispatch", Addr(libxsmm_wimmdispatch)},
+      {"prng_step", Addr(prng_step)},
+      {"RunTimeLogEntry", Addr(RunTimeLogEntry)},  // For debugging
+      {"XSMMRTCaller", Addr(XSMMRTCaller)},
+      {"XSMMReduceRTCaller", Addr(XSMMReduceRTCaller)},
+      {"libxsmm_smmdispatch_reducebatch", Addr(libxsmm_smmdispatch_reducebatch)},
+      {"ParallelFor", Addr(ParallelFor)},
+      {"ParallelTasks", Addr(ParallelTasks)},
+      {"GatherRows", Addr(GatherRows)},
+      {"CopyRows", Addr(CopyRows)},
+      {"ScatterAddRows", Addr(ScatterAddRows)},
+      {"AccumulateHwCounters", Addr(AccumulateHwCounters)},
+  };
+  return symbols;
+}
+
+}  // namespace rt
+
+}  // namespace cpu
+}  // namespace targets
+}  // namespace tile
+}  // namespace vertexai
@@ -0,0 +1,171 @@
+// Copyright 2019, Intel Corp.
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <half.hpp>
+
+namespace vertexai {
+namespace tile {
+namespace targets {
+namespace cpu {
+namespace rt {
+
+// Implementations of support functions the tile backend will link against,
+// that we won't be able to resolve from system libraries. These have no
+// dependency on LLVM, so they can also back code compiled ahead of time.
+
+typedef void (*libxsmm_function)(const void* a, const void* b, void* c);
+typedef void (*libxsmm_reduce_function)(const void** a, const void** b, void* c, const unsigned long long* count);
+typedef void (*cpu_thread_block)(void** refs, ssize_t* inits, size_t range_begin, size_t range_end);
+
+// Scheduling flags passed from generated code to ParallelFor.
+// The low bits select the TBB partitioner; the rest select the executor.
+enum ParallelForFlags : uint32_t {
+  kPartitionAuto = 0,
+  kPartitionStatic = 1,
+  kPartitionAffinity = 2,
+  kPartitionMask = 3,
+  kNumaArenas = 1 << 2,  // Run each NUMA node's share of the range in its own arena
+  kPinThreads = 1 << 3,  // Pin each worker thread to a single core
+  // With kNumaArenas, a nonzero value in these bits is one more than the NUMA
+  // node the block was placed on; its whole range then runs in that node's
+  // arena instead of being split among the nodes.
+  kNumaNodeShift = 8,
+  kNumaNodeMask = 0xff << kNumaNodeShift,
+};
+
+float h2f(half_float::half n);
+half_float::half f2h(float n);
+void prng_step(uint32_t* in_state, uint32_t* out_state, float* buf, size_t count, size_t streams);
+void RunTimeLogEntry(char* str, char* extra, float address);
+void XSMMRTCaller(libxsmm_function func, const void* aPtr, const void* bPtr, void* cPtr);
+void XSMMReduceRTCaller(libxsmm_reduce_function func, const void** aPtrs, const void** bPtrs, void* cPtr,
+                        size_t count);
+void ParallelFor(void** refs, ssize_t* inits, size_t range_size, cpu_thread_block func, size_t grain_size,
+                 uint32_t flags);
+
+// Runs count independent blocks concurrently: block i is funcs[i] over its
+// whole range of ranges[i], given refs[i] and inits[i]. Each block's range is
+// divided among threads as well, so that a task group with one large member
+// doesn't serialize on it.
+void ParallelTasks(void*** refs, ssize_t** inits, cpu_thread_block* funcs, size_t* ranges, size_t count,
+                   uint32_t flags);
+
+// Gathers count rows of row_bytes bytes each: row i of dest is a copy of row
+// indices[i] of data, clamped to its data_rows rows. Rows are copied whole and
+// divided among threads.
+void GatherRows(void* dest, const void* data, const int32_t* indices, size_t count, size_t data_rows,
+                size_t row_bytes, uint32_t flags);
+
+// Copies rows rows of row_bytes bytes each from src to dest, where the rows
+// start dest_stride and src_stride bytes apart. Large copies are divided
+// among threads: by rows, or by byte ranges when there are too few rows.
+void CopyRows(void* dest, const void* src, size_t rows, size_t row_bytes, ssize_t dest_stride, ssize_t src_stride,
+              uint32_t flags);
+
+// Adds each of the count rows of data (row_elems floats each) into row
+// indices[i] of dest, clamped to its dest_rows rows. The columns are divided
+// among threads, so rows which share an index never race.
+void ScatterAddRows(float* dest, const float* data, const int32_t* indices, size_t count, size_t dest_rows,
+                    size_t row_elems, uint32_t flags);
+
+// Writes zeros over a freshly allocated buffer using the same division of
+// work as ParallelFor, so that under the NUMA executor each page is first
+// touched (and therefore placed) by the node that will most likely use it.
+void FirstTouch(void* buffer, size_t size, uint32_t flags);
+
+// A range of a program's arena holding a refinement which the scheduler
+// assigned to a NUMA node.
+struct ArenaPlacement {
+  uint64_t offset;
+  uint64_t size;
+  uint64_t node;
+};
+
+// Reads a table of placements as emitted by the compiler: a count, followed
+// by that many (offset, size, node) triples. A null table holds none.
+std::vector<ArenaPlacement> ReadArenaPlacements(const uint64_t* table);
+
+// Binds the pages wholly within a buffer to a NUMA node: via mbind where the
+// kernel supports it, and otherwise by first touching them from a thread of
+// the node's arena. Node numbers wrap around the nodes actually present.
+void BindToNode(void* buffer, size_t size, uint64_t node, uint32_t flags);
+
+// Allocates a scratch arena for a program. Large arenas are backed by
+// transparent huge pages where the OS supports them; with kNumaArenas, each
+// placed range is bound to its node, and the arena's remaining pages are
+// first touched by the nodes which will use them.
+void* ArenaAlloc(size_t size, uint32_t flags, const std::vector<ArenaPlacement>& placements = {});
+void ArenaFree(void* arena, size_t size);
+
+// The scratch arenas of one loaded program. Each invocation of the program
+// holds an arena of its own, so concurrent invocations never share scratch
+// space, while an arena released by one invocation is reused by the next
+// instead of being allocated again. Thread-safe.
+class ArenaPool {
+ public:
+  ArenaPool(size_t size, uint32_t flags, std::vector<ArenaPlacement> placements = {})
+      : size_(size), flags_(flags), placements_(std::move(placements)) {}
+  ~ArenaPool();
+
+  ArenaPool(const ArenaPool&) = delete;
+  ArenaPool& operator=(const ArenaPool&) = delete;
+
+  // Returns an arena which goes back to the pool when the last reference to
+  // it is dropped; null if the program needs no arena.
+  std::shared_ptr<void> Acquire();
+
+  size_t size() const { return size_; }
+
+ private:
+  size_t size_;
+  uint32_t flags_;
+  std::vector<ArenaPlacement> placements_;
+  std::mutex mu_;
+  std::vector<void*> free_;
+};
+
+// Calls a program's entrypoint with the bound parameter buffers, followed by
+// an arena from the program's pool; see Compiler::GenerateInvoker.
+void Invoke(void (*entrypoint)(void*), const std::vector<void*>& args, ArenaPool* arenas);
+
+// The slots of a block's hardware profile counters.
+enum HwCounter {
+  kHwCycles,
+  kHwInstructions,
+  kHwCacheMisses,  // Last-level cache misses
+  kHwWallNanos,
+  kHwCounterCount,
+};
+
+// Adds the calling thread's current counter readings, times sign, to each
+// slot of totals; generated code calls this with -1 on entry to a block and
+// +1 on exit. Counters come from perf_event_open on Linux; where they are
+// unavailable, only the wall clock slot advances.
+void AccumulateHwCounters(int64_t* totals, int64_t sign);
+
+// Returns the CPUs belonging to each NUMA node described by a sysfs node
+// directory (normally /sys/devices/system/node), in node order.  Where the
+// topology cannot be determined, all CPUs are reported as a single node.
+std::vector<std::vector<int>> NumaNodes(const std::string& sysfs_dir);
+
+// All of the runtime entrypoints generated code may reference, keyed by link
+// name; names are listed both with and without the leading underscore some
+// platforms' loaders expect.
+const std::map<std::string, void*>& Symbols();
+
+}  // namespace rt
+}  // namespace cpu
+}  // namespace targets
+}  // namespace tile
+}  // namespace vertexai
@@ -0,0 +1,39 @@
+// Copyright 2019, Intel Corporation
+
+#include <gmock/gmock.h>
+
+#include <boost/filesystem.hpp>
+
+#include "tile/targets/cpu/heatmap.h"
+
+using ::testing::ContainerEq;
+using ::testing::Eq;
+using ::testing::Ne;
+
+namespace vertexai {
+namespace tile {
+namespace targets {
+namespace cpu {
+namespace test {
+
+TEST(Heatmap, SaveLoad) {
+  Heatmap heatmap{
+      {std::make_tuple(2, 2, 2), 1.5},
+      {std::make_tuple(16, 4, 64), 42.25},
+  };
+  auto path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("%%%%%%%%.csv");
+  SaveHeatmap(heatmap, path);
+  EXPECT_THAT(LoadHeatmap(path), ContainerEq(heatmap));
+  boost::filesystem::remove(path);
+}
+
+TEST(Heatmap, HostCpuKey) {
+  EXPECT_THAT(HostCpuKey(), Ne(""));
+  EXPECT_THAT(HostCpuKey(), Eq(HostCpuKey()));
+}
+
+}  // namespace test
+}  // namespace cpu
+}  // namespace targets
+}  // namespace tile
+}  // namespace vertexai
@@ -2,6 +2,16 @@
 
 #include <gmock/gmock.h>
 #include <google/protobuf/text_format.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/MemoryBuffer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <thread>
+
+#include <boost/filesystem.hpp>
 
 #include "tile/codegen/tile.h"
 #include "tile/lang/gen_stripe.h"
@@ -9,6 +19,8 @@
 #include "tile/stripe/stripe.h"
 #include "tile/stripe/stripe.pb.h"
 #include "tile/targets/cpu/jit.h"
+#include "tile/targets/cpu/object_cache.h"
+#include "tile/targets/cpu/profile.h"
 
 namespace gp = google::protobuf;
 
@@ -339,6 +351,172 @@ TEST(Jit, JitMatMul) {
   EXPECT_THAT(bufC, ContainerEq(expected));
 }
 
+TEST(Jit, JitXSMMReduceMatchesLoops) {
+  // C[i, j] = +(A[i, k] * B[k, j]), with an XSMM kernel over 4-wide tiles of k
+  // run by an outer block over the remaining 600 tiles: more than fit in one
+  // batch-reduce call.
+  const size_t kI = 2;
+  const size_t kJ = 2;
+  const size_t kK = 2400;
+  stripe::proto::Block input_proto;
+  gp::TextFormat::ParseFromString(R"(
+    name: "main"
+    loc {}
+    refs [
+      {
+        key: "A"
+        value {
+          loc {}
+          attrs: { key: "user" value: {} }
+          dir: 1
+          interior_shape { type: FLOAT32 dims: {size:2 stride:2400} dims: {size:2400 stride:1} }
+          access [{}, {}]
+        }
+      },
+      {
+        key: "B"
+        value {
+          loc {}
+          attrs: { key: "user" value: {} }
+          dir: 1
+          interior_shape { type: FLOAT32 dims: {size:2400 stride:2} dims: {size:2 stride:1} }
+          access [{}, {}]
+        }
+      },
+      {
+        key: "C"
+        value {
+          loc {}
+          attrs: { key: "user" value: {} }
+          dir: 2
+          interior_shape { type: FLOAT32 dims: {size:2 stride:2} dims: {size:2 stride:1} }
+          access [{}, {}]
+        }
+      }
+    ]
+    stmts { block {
+      name: "reduce"
+      loc {}
+      idxs { name: "kb" range: 600 }
+      refs [
+        {
+          key: "A"
+          value {
+            loc {}
+            dir: 1
+            from: "A"
+            interior_shape { type: FLOAT32 dims: {size:2 stride:2400} dims: {size:4 stride:1} }
+            access [{}, {terms {key:"kb" value:4}}]
+          }
+        },
+        {
+          key: "B"
+          value {
+            loc {}
+            dir: 1
+            from: "B"
+            interior_shape { type: FLOAT32 dims: {size:4 stride:2} dims: {size:2 stride:1} }
+            access [{terms {key:"kb" value:4}}, {}]
+          }
+        },
+        {
+          key: "C"
+          value {
+            loc {}
+            dir: 2
+            from: "C"
+            agg_op: "add"
+            interior_shape { type: FLOAT32 dims: {size:2 stride:2} dims: {size:2 stride:1} }
+            access [{}, {}]
+          }
+        }
+      ]
+      stmts { block {
+        name: "kernel"
+        loc {}
+        idxs { name: "i" range: 2 }
+        idxs { name: "j" range: 2 }
+        idxs { name: "k" range: 4 }
+        refs [
+          {
+            key: "A"
+            value {
+              loc {}
+              attrs: { key: "A" value: {} }
+              dir: 1
+              from: "A"
+              interior_shape { type: FLOAT32 dims: {size:1 stride:2400} dims: {size:1 stride:1} }
+              access [{terms {key:"i" value:1}}, {terms {key:"k" value:1}}]
+            }
+          },
+          {
+            key: "B"
+            value {
+              loc {}
+              attrs: { key: "B" value: {} }
+              dir: 1
+              from: "B"
+              interior_shape { type: FLOAT32 dims: {size:1 stride:2} dims: {size:1 stride:1} }
+              access [{terms {key:"k" value:1}}, {terms {key:"j" value:1}}]
+            }
+          },
+          {
+            key: "C"
+            value {
+              loc {}
+              attrs: { key: "C" value: {} }
+              dir: 2
+              from: "C"
+              agg_op: "add"
+              interior_shape { type: FLOAT32 dims: {size:1 stride:2} dims: {size:1 stride:1} }
+              access [{terms {key:"i" value:1}}, {terms {key:"j" value:1}}]
+            }
+          }
+        ]
+        stmts { load { from:"A" into:"$A" } }
+        stmts { load { from:"B" into:"$B" } }
+        stmts { intrinsic { name:"mul" type:FLOAT32 inputs:"$A" inputs:"$B" outputs:"$C" } }
+        stmts { store { from:"$C" into:"C"} }
+      } }
+    } }
+  )",
+                                  &input_proto);
+  std::shared_ptr<stripe::Block> loops{stripe::FromProto(input_proto)};
+  std::shared_ptr<stripe::Block> xsmm = stripe::CloneBlock(*loops);
+  auto kernel = stripe::Block::Downcast(stripe::Block::Downcast(xsmm->stmts.front())->stmts.front());
+  kernel->set_tag("xsmm");
+  kernel->idxs[0].set_tag("stencil_n");
+  kernel->idxs[1].set_tag("stencil_m");
+  kernel->idxs[2].set_tag("stencil_k");
+
+  // Small integers keep every partial sum exact, whatever the summation order.
+  std::vector<float> A(kI * kK);
+  std::vector<float> B(kK * kJ);
+  for (size_t k = 0; k < kK; ++k) {
+    for (size_t i = 0; i < kI; ++i) {
+      A[i * kK + k] = (i + k) % 5;
+    }
+    for (size_t j = 0; j < kJ; ++j) {
+      B[k * kJ + j] = (2 * k + j) % 3;
+    }
+  }
+  std::vector<float> expected(kI * kJ);
+  for (size_t i = 0; i < kI; ++i) {
+    for (size_t j = 0; j < kJ; ++j) {
+      for (size_t k = 0; k < kK; ++k) {
+        expected[i * kJ + j] += A[i * kK + k] * B[k * kJ + j];
+      }
+    }
+  }
+
+  std::vector<float> C_loops(kI * kJ);
+  std::vector<float> C_xsmm(kI * kJ);
+  JitExecute(*loops, {{"A", A.data()}, {"B", B.data()}, {"C", C_loops.data()}});
+  JitExecute(*xsmm, {{"A", A.data()}, {"B", B.data()}, {"C", C_xsmm.data()}});
+  EXPECT_THAT(C_loops, ContainerEq(expected));
+  EXPECT_THAT(C_xsmm, ContainerEq(expected));
+}
+
 TEST(Jit, JitNestedAlloc) {
   stripe::proto::Block input_proto;
   gp::TextFormat::ParseFromString(R"(
@@ -1107,6 +1285,473 @@ TEST(Jit, JitSpecialZero) {
   EXPECT_THAT(b1[3], Eq(0));
 }
 
+TEST(Jit, JitSpecialCopy) {
+  stripe::proto::Block input_proto;
+  gp::TextFormat::ParseFromString(R"(
+    loc {}
+    refs [
+      {
+        key: "src"
+        value {
+          loc {}
+          attrs: { key: "user" value: {} }
+          dir: 1
+          interior_shape { type: INT32 dims: {size:2 stride:3} dims: {size:3 stride:1} }
+          access { }
+          access { }
+        }
+      },
+      {
+        key: "dst"
+        value {
+          loc {}
+          attrs: { key: "user" value: {} }
+          dir: 2
+          interior_shape { type: INT32 dims: {size:2 stride:1} dims: {size:3 stride:2} }
+          access { }
+          access { }
+        }
+      }
+    ]
+    stmts { special { name:"copy" inputs:"src" outputs:"dst" } }
+  )",
+                                  &input_proto);
+  std::shared_ptr<stripe::Block> block{stripe::FromProto(input_proto)};
+
+  std::vector<int32_t> src{1, 2, 3, 4, 5, 6};
+  std::vector<int32_t> dst(6);
+  std::vector<int32_t> expected{1, 4, 2, 5, 3, 6};
+  std::map<std::string, void*> buffers{{"src", src.data()}, {"dst", dst.data()}};
+  JitExecute(*block, buffers);
+
+  EXPECT_THAT(dst, ContainerEq(expected));
+}
+
+// Computes exp, log and tanh of each element of X with the FAST accuracy mode.
+void RunFastMath(std::vector<float> X, std::vector<float>* E, std::vector<float>* L, std::vector<float>* T) {
+  stripe::proto::Block input_proto;
+  gp::TextFormat::ParseFromString(R"(
+    loc {}
+    idxs { name: "i" range: 12 }
+    refs [
+      {
+        key: "X"
+        value {
+          loc {}
+          attrs: { key: "user" value: {} }
+          dir: 1
+          interior_shape { type: FLOAT32 dims: {size:12 stride:1} }
+          access { offset: 0 terms {key:"i" value:1} }
+        }
+      },
+      {
+        key: "E"
+        value {
+          loc {}
+          attrs: { key: "user" value: {} }
+          dir: 2
+          interior_shape { type: FLOAT32 dims: {size:12 stride:1} }
+          access { offset: 0 terms {key:"i" value:1} }
+        }
+      },
+      {
+        key: "L"
+        value {
+          loc {}
+          attrs: { key: "user" value: {} }
+          dir: 2
+          interior_shape { type: FLOAT32 dims: {size:12 stride:1} }
+          access { offset: 0 terms {key:"i" value:1} }
+        }
+      },
+      {
+        key: "T"
+        value {
+          loc {}
+          attrs: { key: "user" value: {} }
+          dir: 2
+          interior_shape { type: FLOAT32 dims: {size:12 stride:1} }
+          access { offset: 0 terms {key:"i" value:1} }
+        }
+      }
+    ]
+    stmts { load { from:"X" into:"$X" } }
+    stmts { intrinsic { name:"exp" type:FLOAT32 inputs:"$X" outputs:"$E" } }
+    stmts { store { from:"$E" into:"E"} }
+    stmts { intrinsic { name:"log" type:FLOAT32 inputs:"$X" outputs:"$L" } }
+    stmts { store { from:"$L" into:"L"} }
+    stmts { intrinsic { name:"tanh" type:FLOAT32 inputs:"$X" outputs:"$T" } }
+    stmts { store { from:"$T" into:"T"} }
+  )",
+                                  &input_proto);
+  std::shared_ptr<stripe::Block> block{stripe::FromProto(input_proto)};
+
+  // The block covers a fixed number of elements; pad with ones.
+  X.resize(12, 1.0f);
+  E->resize(X.size());
+  L->resize(X.size());
+  T->resize(X.size());
+  std::map<std::string, void*> buffers{{"X", X.data()}, {"E", E->data()}, {"L", L->data()}, {"T", T->data()}};
+  Config config;
+  config.math_accuracy = MathAccuracy::FAST;
+  JitExecute(*block, config, buffers);
+}
+
+// A tolerance of n units in the last place of expected, as a float.
+double Ulps(double expected, int n) {
+  float magnitude = std::fabs(static_cast<float>(expected));
+  return n * (std::nextafter(magnitude, std::numeric_limits<float>::infinity()) - magnitude);
+}
+
+TEST(Jit, JitFastMath) {
+  std::vector<float> X{0.001, 0.3, 0.7, 1.5, 7.25, 42.0};
+  std::vector<float> E, L, T;
+  RunFastMath(X, &E, &L, &T);
+
+  for (size_t i = 0; i < X.size(); ++i) {
+    EXPECT_NEAR(E[i], std::exp(X[i]), std::exp(X[i]) * 1e-6);
+    EXPECT_NEAR(L[i], std::log(X[i]), 1e-6);
+    EXPECT_NEAR(T[i], std::tanh(X[i]), 1e-6);
+  }
+}
+
+TEST(Jit, JitFastMathEdges) {
+  const float kMaxExp = 88.3762626647949f;  // exp's upper clamp, where x / ln(2) is 127.5
+  const float kInf = std::numeric_limits<float>::infinity();
+  const float kMin = std::numeric_limits<float>::min();
+  std::vector<float> E, L, T;
+
+  // exp near both clamps, and beyond them: large inputs saturate to a finite value rather than overflowing the
+  // exponent bits, and small ones flush to the smallest normal.
+  std::vector<float> X{kMaxExp, 88.37f, 88.0f, 100.0f, -87.0f, -87.3365447504f, -100.0f, 0.0f};
+  RunFastMath(X, &E, &L, &T);
+  for (size_t i = 0; i < 3; ++i) {
+    EXPECT_NEAR(E[i], std::exp(double{X[i]}), Ulps(std::exp(double{X[i]}), 4));
+  }
+  EXPECT_TRUE(std::isfinite(E[3]));
+  EXPECT_THAT(E[3], Eq(E[0]));
+  for (size_t i = 4; i < 7; ++i) {
+    EXPECT_NEAR(E[i], std::exp(X[i]), kMin);
+  }
+  EXPECT_THAT(E[7], Eq(1.0f));
+
+  // log of the extremes and the special cases, and either side of the mantissa split at sqrt(0.5).
+  X = {kMin, std::numeric_limits<float>::max(), 0.70710677f, 0.70710683f, 1.0f, kInf, 0.0f, -1.0f};
+  RunFastMath(X, &E, &L, &T);
+  for (size_t i = 0; i < 5; ++i) {
+    EXPECT_NEAR(L[i], std::log(double{X[i]}), Ulps(std::log(double{X[i]}), 4));
+  }
+  EXPECT_THAT(L[5], Eq(kInf));
+  EXPECT_THAT(L[6], Eq(-kInf));
+  EXPECT_TRUE(std::isnan(L[7]));
+
+  // tanh either side of the switch to the exp form at 0.625, and saturating, including where exp(2|x|) clamps.
+  X = {0.0f, 1e-7f, 0.6249f, 0.625f, -0.6251f, 9.0f, -20.0f, 50.0f, kInf, -kInf};
+  RunFastMath(X, &E, &L, &T);
+  for (size_t i = 0; i < X.size(); ++i) {
+    EXPECT_NEAR(T[i], std::tanh(double{X[i]}), Ulps(std::tanh(double{X[i]}), 4));
+  }
+}
+
+TEST(Jit, JitObjectCache) {
+  stripe::proto::Block input_proto;
+  gp::TextFormat::ParseFromString(R"(
+    loc {}
+    refs [
+      {
+        key: "b1"
+        value {
+          loc {}
+          attrs: { key: "user" value: {} }
+          dir: 3
+          interior_shape { type: FLOAT32 dims: {size:1 stride:1} }
+          access { }
+        }
+      },
+      {
+        key: "b2"
+        value {
+          loc {}
+          attrs: { key: "user" value: {} }
+          dir: 3
+          interior_shape { type: FLOAT32 dims: {size:1 stride:1} }
+          access { }
+        }
+      }
+    ]
+    stmts { load { from:"b1" into:"$1" } }
+    stmts { load { from:"b2" into:"$2" } }
+    stmts { intrinsic { name:"add" type:FLOAT32 inputs:"$1" inputs:"$2" outputs:"$3"} }
+    stmts { store { from:"$3" into:"b2"} }
+  )",
+                                  &input_proto);
+  std::shared_ptr<stripe::Block> block{stripe::FromProto(input_proto)};
+
+  auto dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+  Config config;
+  config.object_cache_dir = dir.string();
+  // Another version's objects are removed; anything else sharing the directory is left alone.
+  boost::filesystem::create_directories(dir / "v0-llvm1.0.0");
+  boost::filesystem::create_directories(dir / "notes");
+
+  // The first compilation populates the cache; the second loads from it.
+  for (int i = 0; i < 2; ++i) {
+    std::vector<float> b1{3.0};
+    std::vector<float> b2{2.0};
+    std::map<std::string, void*> buffers{{"b1", b1.data()}, {"b2", b2.data()}};
+    Native native;
+    native.compile(*block, config);
+    native.run(buffers);
+    EXPECT_THAT(b2[0], Eq(5.0));
+  }
+
+  size_t objects = 0;
+  for (auto& entry : boost::filesystem::recursive_directory_iterator(dir)) {
+    if (entry.path().extension() == ".o") {
+      objects++;
+    }
+  }
+  EXPECT_THAT(objects, Eq(1));
+  EXPECT_FALSE(boost::filesystem::exists(dir / "v0-llvm1.0.0"));
+  EXPECT_TRUE(boost::filesystem::exists(dir / "notes"));
+  boost::filesystem::remove_all(dir);
+}
+
+TEST(Jit, JitObjectCacheSkipsDeclarations) {
+  auto dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+  ObjectCache cache(dir, 1 << 20);
+  llvm::LLVMContext context;
+  llvm::MemoryBufferRef obj{"object", "object"};
+
+  // A module which only declares the program, as on a cache hit, must not replace the real object.
+  llvm::Module declared("declared", context);
+  cache.notifyObjectCompiled(&declared, obj);
+  EXPECT_FALSE(cache.Contains("declared"));
+
+  llvm::Module compiled("compiled", context);
+  llvm::Function::Create(llvm::FunctionType::get(llvm::Type::getVoidTy(context), false),
+                         llvm::Function::ExternalLinkage, "main", &compiled);
+  cache.notifyObjectCompiled(&compiled, obj);
+  EXPECT_TRUE(cache.Contains("compiled"));
+  cache.Remove("compiled");
+  EXPECT_FALSE(cache.Contains("compiled"));
+  boost::filesystem::remove_all(dir);
+}
+
+TEST(Jit, JitLazyCompile) {
+  lang::RunInfo runinfo;
+  runinfo.program_name = "matmul";
+  runinfo.code = "function (A[M, K], B[K, N]) -> (C) { C[m, n : M, N] = +(A[m, k] * B[k, n]); }";
+  runinfo.input_shapes.emplace("A", SimpleShape(DataType::FLOAT32, {3, 3}));
+  runinfo.input_shapes.emplace("B", SimpleShape(DataType::FLOAT32, {3, 3}));
+  runinfo.output_shapes.emplace("C", SimpleShape(DataType::FLOAT32, {3, 3}));
+  auto program = GenerateStripe(runinfo);
+
+  Config config;
+  config.lazy_compile = true;
+  config.compile_threads = 2;
+  Native native;
+  native.compile(*program->entry, config);
+
+  // Run twice: the first run compiles each kernel, the second reuses it.
+  for (int i = 0; i < 2; ++i) {
+    std::vector<float> bufA = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+    std::vector<float> bufB = {1, 0, 0, 0, 1, 0, 0, 0, 2};
+    std::vector<float> bufC(9, 0);
+    native.run({{"A", bufA.data()}, {"B", bufB.data()}, {"C", bufC.data()}});
+    EXPECT_THAT(bufC, ContainerEq(std::vector<float>{1, 2, 6, 4, 5, 12, 7, 8, 18}));
+  }
+}
+
+TEST(Jit, JitConcurrentRun) {
+  // Each row is spread across a placed temporary in the arena and summed back
+  // out of it, so runs sharing an arena would see one another's rows.
+  stripe::proto::Block input_proto;
+  gp::TextFormat::ParseFromString(R"(
+    loc {}
+    refs [
+      {
+        key: "X"
+        value {
+          loc {}
+          attrs: { key: "user" value: {} }
+          dir: 1
+          interior_shape { type: FLOAT32 dims: {size:256 stride:1} }
+          access [{}]
+        }
+      },
+      {
+        key: "Y"
+        value {
+          loc {}
+          attrs: { key: "user" value: {} }
+          dir: 2
+          interior_shape { type: FLOAT32 dims: {size:256 stride:1} }
+          access [{}]
+        }
+      }
+    ]
+    stmts { block {
+      name: "row"
+      idxs { name: "i" range: 256 }
+      refs [
+        {
+          key: "X"
+          value {
+            loc {}
+            dir: 1
+            from: "X"
+            interior_shape { type: FLOAT32 dims: {size:1 stride:1} }
+            access { terms {key:"i" value:1} }
+          }
+        },
+        {
+          key: "Y"
+          value {
+            loc {}
+            dir: 2
+            from: "Y"
+            agg_op: "add"
+            interior_shape { type: FLOAT32 dims: {size:1 stride:1} }
+            access { terms {key:"i" value:1} }
+          }
+        },
+        {
+          key: "T"
+          value {
+            dir: 0
+            offset: 0
+            interior_shape { type: FLOAT32 dims: {size:64 stride:1} }
+            access { }
+            attrs { key: "placed" value {} }
+          }
+        }
+      ]
+      stmts { block {
+        name: "spread"
+        idxs { name: "j" range: 64 }
+        refs [
+          {
+            key: "X"
+            value {
+              loc {}
+              dir: 1
+              from: "X"
+              interior_shape { type: FLOAT32 dims: {size:1 stride:1} }
+              access { }
+            }
+          },
+          {
+            key: "T"
+            value {
+              dir: 2
+              from: "T"
+              interior_shape { type: FLOAT32 dims: {size:1 stride:1} }
+              access { terms {key:"j" value:1} }
+            }
+          }
+        ]
+        stmts { load { from:"X" into:"$x" } }
+        stmts { store { from:"$x" into:"T"} }
+      } }
+      stmts { block {
+        name: "sum"
+        idxs { name: "j" range: 64 }
+        refs [
+          {
+            key: "T"
+            value {
+              dir: 1
+              from: "T"
+              interior_shape { type: FLOAT32 dims: {size:1 stride:1} }
+              access { terms {key:"j" value:1} }
+            }
+          },
+          {
+            key: "Y"
+            value {
+              loc {}
+              dir: 2
+              from: "Y"
+              agg_op: "add"
+              interior_shape { type: FLOAT32 dims: {size:1 stride:1} }
+              access { }
+            }
+          }
+        ]
+        stmts { load { from:"T" into:"$t" } }
+        stmts { store { from:"$t" into:"Y"} }
+      } }
+    } }
+  )",
+                                  &input_proto);
+  std::shared_ptr<stripe::Block> block{stripe::FromProto(input_proto)};
+
+  Native native;
+  native.compile(*block, Config{});
+
+  // Each thread binds its own buffers once, then runs the shared program.
+  std::vector<std::thread> threads;
+  std::vector<std::vector<float>> inputs(4);
+  std::vector<std::vector<float>> results(inputs.size());
+  for (size_t t = 0; t < inputs.size(); ++t) {
+    for (size_t i = 0; i < 256; ++i) {
+      inputs[t].push_back((t + 1) * (i % 7 + 1));
+    }
+  }
+  for (size_t t = 0; t < inputs.size(); ++t) {
+    threads.emplace_back([&, t] {
+      std::vector<float> bufX = inputs[t];
+      std::vector<float> bufY(bufX.size());
+      auto args = native.bind({{"X", bufX.data()}, {"Y", bufY.data()}});
+      for (int i = 0; i < 20; ++i) {
+        std::fill(bufY.begin(), bufY.end(), 0);
+        native.run(args);
+      }
+      results[t] = bufY;
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (size_t t = 0; t < inputs.size(); ++t) {
+    std::vector<float> expected;
+    for (float x : inputs[t]) {
+      expected.push_back(64 * x);
+    }
+    EXPECT_THAT(results[t], ContainerEq(expected));
+  }
+}
+
+TEST(Jit, JitProfileHwCounters) {
+  lang::RunInfo runinfo;
+  runinfo.program_name = "matmul";
+  runinfo.code = "function (A[M, K], B[K, N]) -> (C) { C[m, n : M, N] = +(A[m, k] * B[k, n]); }";
+  runinfo.input_shapes.emplace("A", SimpleShape(DataType::FLOAT32, {5, 5}));
+  runinfo.input_shapes.emplace("B", SimpleShape(DataType::FLOAT32, {5, 5}));
+  runinfo.output_shapes.emplace("C", SimpleShape(DataType::FLOAT32, {5, 5}));
+  auto program = GenerateStripe(runinfo);
+  auto main = program->entry;
+
+  // One multiply and one aggregating add for each point of the 5x5x5 space.
+  EXPECT_THAT(BlockFlops(*main), Eq(250));
+
+  std::vector<float> bufA(25, 1);
+  std::vector<float> bufB(25, 1);
+  std::vector<float> bufC(25, 0);
+  JitProfile(main.get(), {{"A", bufA.data()}, {"B", bufB.data()}, {"C", bufC.data()}});
+
+  auto main_block = stripe::Block::Downcast(main->stmts.front());
+  ASSERT_TRUE(main_block);
+  EXPECT_THAT(main_block->get_attr_int("execution_count"), Eq(1));
+  EXPECT_TRUE(main_block->has_attr("wall_ns"));
+  EXPECT_TRUE(main_block->has_attr("hw_cycles"));
+
+  std::stringstream report;
+  WriteRooflineReport(*main, &report, 100, 10);
+  EXPECT_NE(report.str().find(main_block->name), std::string::npos);
+}
+
 }  // namespace test
 }  // namespace cpu
 }  // namespace targets
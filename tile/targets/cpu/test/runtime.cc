@@ -0,0 +1,104 @@
+// Copyright 2020, Intel Corporation
+
+#include <gmock/gmock.h>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "tile/targets/cpu/runtime.h"
+
+using ::testing::ElementsAre;
+using ::testing::Eq;
+
+namespace vertexai {
+namespace tile {
+namespace targets {
+namespace cpu {
+namespace test {
+
+#if defined(__linux__)
+
+TEST(Runtime, NumaNodesListsSparseNodes) {
+  auto dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+  for (const auto& node : {std::make_pair("node0", "0-1\n"), std::make_pair("node2", "4,6-7\n")}) {
+    boost::filesystem::create_directories(dir / node.first);
+    std::ofstream{(dir / node.first / "cpulist").string()} << node.second;
+  }
+  std::ofstream{(dir / "possible").string()} << "0-2\n";
+  EXPECT_THAT(rt::NumaNodes(dir.string()), ElementsAre(ElementsAre(0, 1), ElementsAre(4, 6, 7)));
+  boost::filesystem::remove_all(dir);
+}
+
+void CountRange(void** refs, ssize_t* inits, size_t begin, size_t end) {
+  static_cast<std::atomic<size_t>*>(refs[0])->fetch_add(end - begin);
+}
+
+TEST(Runtime, PinningLeavesCallerAffinity) {
+  cpu_set_t before;
+  ASSERT_THAT(pthread_getaffinity_np(pthread_self(), sizeof(before), &before), Eq(0));
+  for (uint32_t flags : {uint32_t{rt::kPinThreads}, uint32_t{rt::kPinThreads | rt::kNumaArenas}}) {
+    std::atomic<size_t> count{0};
+    void* refs[] = {&count};
+    rt::ParallelFor(refs, nullptr, 1 << 16, CountRange, 1, flags);
+    EXPECT_THAT(count.load(), Eq(1 << 16));
+  }
+  cpu_set_t after;
+  ASSERT_THAT(pthread_getaffinity_np(pthread_self(), sizeof(after), &after), Eq(0));
+  EXPECT_TRUE(CPU_EQUAL(&before, &after));
+}
+
+#endif
+
+// The PRNG kernel from tile/lang/gen_special.cc, one stream at a time.
+void GenSpecialPrng(const std::vector<uint32_t>& in_state, std::vector<uint32_t>* out_state, std::vector<float>* out,
+                    size_t streams) {
+  for (size_t j = 0; j < streams; ++j) {
+    uint32_t s1 = in_state[j];
+    uint32_t s2 = in_state[j + streams];
+    uint32_t s3 = in_state[j + 2 * streams];
+    for (size_t i = j; i < out->size(); i += streams) {
+      s1 = (((s1 & 4294967294) << 12) ^ (((s1 << 13) ^ s1) >> 19));
+      s2 = (((s2 & 4294967288) << 4) ^ (((s2 << 2) ^ s2) >> 25));
+      s3 = (((s3 & 4294967280) << 17) ^ (((s3 << 3) ^ s3) >> 11));
+      (*out)[i] = static_cast<float>(s1 ^ s2 ^ s3) / 4294967296.0f;
+    }
+    (*out_state)[j] = s1;
+    (*out_state)[j + streams] = s2;
+    (*out_state)[j + 2 * streams] = s3;
+  }
+}
+
+TEST(Runtime, PrngMatchesGenSpecial) {
+  // A handful of streams with a ragged last row, and enough of both to take the parallel path.
+  for (auto size : {std::make_pair(size_t(5), size_t(23)), std::make_pair(size_t(40), size_t(1) << 17)}) {
+    size_t streams = size.first;
+    size_t count = size.second;
+    std::vector<uint32_t> in_state(3 * streams);
+    for (size_t i = 0; i < in_state.size(); ++i) {
+      in_state[i] = 0x9E3779B9u * (i + 1);
+    }
+    std::vector<uint32_t> expected_state(in_state.size());
+    std::vector<float> expected(count);
+    GenSpecialPrng(in_state, &expected_state, &expected, streams);
+    std::vector<uint32_t> out_state(in_state.size());
+    std::vector<float> out(count);
+    rt::prng_step(in_state.data(), out_state.data(), out.data(), count, streams);
+    EXPECT_THAT(out_state, Eq(expected_state));
+    EXPECT_THAT(out, Eq(expected));
+  }
+}
+
+}  // namespace test
+}  // namespace cpu
+}  // namespace targets
+}  // namespace tile
+}  // namespace vertexai
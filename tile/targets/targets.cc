@@ -1,13 +1,80 @@
 #include "tile/targets/targets.h"
 
-#include "base/config/config.h"
+#include <stdexcept>
+
+#include "base/util/env.h"
+#include "base/util/logging.h"
+#include "base/util/throw.h"
 #include "tile/targets/configs.h"
 
 namespace vertexai {
 namespace tile {
 namespace targets {
 
-codegen::proto::Configs GetConfigs() { return ParseConfig<codegen::proto::Configs>(kConfigs); }
+const codegen::proto::Configs& GetConfigs() {
+  // gencfg validates the target configs and embeds them as a serialized proto, so they're decoded directly (skipping
+  // the JSON attempt ParseConfig would make), and only once per process.
+  static const codegen::proto::Configs configs = [] {
+    codegen::proto::Configs parsed;
+    if (!parsed.ParseFromString(kConfigs)) {
+      throw_with_trace(std::runtime_error("Unable to parse the embedded target configs"));
+    }
+    return parsed;
+  }();
+  return configs;
+}
+
+codegen::proto::Config DeriveConfig(const codegen::proto::Config& config, const hal::proto::HardwareSettings& device) {
+  codegen::proto::Config derived = config;
+  for (auto& kvp : *derived.mutable_stages()) {
+    for (auto& pass : *kvp.second.mutable_passes()) {
+      if (pass.pass().Is<codegen::proto::SubgroupPass>()) {
+        codegen::proto::SubgroupPass options;
+        pass.pass().UnpackTo(&options);
+        if (device.mem_width()) {
+          options.set_cache_width(device.mem_width());
+        }
+        if (device.cache_size()) {
+          options.set_cache_size(device.cache_size());
+        }
+        pass.mutable_pass()->PackFrom(options);
+      } else if (pass.pass().Is<codegen::proto::AutotilePass>()) {
+        codegen::proto::AutotilePass options;
+        pass.pass().UnpackTo(&options);
+        if (device.mem_width() && options.cache_width()) {
+          options.set_cache_width(device.mem_width());
+        }
+        if (device.max_mem() && options.max_total_size()) {
+          options.set_max_total_size(device.max_mem());
+        }
+        if (device.compute_units() && options.has_min_count()) {
+          options.set_min_count(device.compute_units());
+        }
+        if (device.compute_units() && options.has_min_out_count()) {
+          options.set_min_out_count(device.compute_units());
+        }
+        pass.mutable_pass()->PackFrom(options);
+      } else {
+        continue;
+      }
+      IVLOG(2, "Derived pass " << pass.name() << " for the device");
+    }
+  }
+  return derived;
+}
+
+codegen::proto::Config GetConfig(const std::string& name, const hal::proto::HardwareSettings* device) {
+  const auto& configs = GetConfigs().configs();
+  auto it = configs.find(name);
+  if (it == configs.end()) {
+    throw_with_trace(std::runtime_error("Unknown target config: " + name));
+  }
+  static const bool derive = env::Get("PLAIDML_DERIVE_CONFIG") == "1";
+  if (derive && device) {
+    return DeriveConfig(it->second, *device);
+  }
+  return it->second;
+}
 
 }  // namespace targets
 }  // namespace tile
@@ -1,12 +1,26 @@
 #pragma once
 
+#include <string>
+
 #include "tile/codegen/codegen.pb.h"
+#include "tile/proto/hal.pb.h"
 
 namespace vertexai {
 namespace tile {
 namespace targets {
 
-codegen::proto::Configs GetConfigs();
+// Returns the configs of the built-in targets; they're parsed on first use and shared thereafter.
+const codegen::proto::Configs& GetConfigs();
+
+// Returns a copy of a config with its device-dependent limits derived from the properties a device reports, for
+// devices the config's parameters weren't written for: the cache line width and cache size of the SubgroupPass and
+// AutotilePass passes, the local memory limit (max_total_size) and compute unit counts (min_count, min_out_count) of
+// the AutotilePass passes which set them.  Properties the device doesn't report leave the configured limits alone.
+codegen::proto::Config DeriveConfig(const codegen::proto::Config& config, const hal::proto::HardwareSettings& device);
+
+// Returns the named built-in config; with PLAIDML_DERIVE_CONFIG=1, it's derived from the device's properties (see
+// DeriveConfig) when the device is supplied.
+codegen::proto::Config GetConfig(const std::string& name, const hal::proto::HardwareSettings* device = nullptr);
 
 }  // namespace targets
 }  // namespace tile
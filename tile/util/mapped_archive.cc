@@ -0,0 +1,145 @@
+// Copyright 2020, Intel Corporation
+
+#include "tile/util/mapped_archive.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <boost/format.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+namespace vertexai {
+namespace tile {
+namespace util {
+
+namespace {
+
+// The header is the magic number, the number of entries, and then each entry's name size, name, offset and size.
+// Offsets are from the start of the file.  All integers are little-endian uint64s.
+const char kMagic[8] = {'P', 'L', 'A', 'I', 'D', 'M', 'A', 'P'};
+
+uint64_t ReadU64(const uint8_t* base, std::size_t size, std::size_t* pos) {
+  if (size < *pos + sizeof(uint64_t)) {
+    throw std::runtime_error("Truncated mapped archive header");
+  }
+  uint64_t value;
+  std::memcpy(&value, base + *pos, sizeof(value));
+  *pos += sizeof(value);
+  return value;
+}
+
+void WriteU64(std::string* out, uint64_t value) {
+  out->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+}  // namespace
+
+struct MappedArchive::Mapping {
+  boost::interprocess::file_mapping file;
+  boost::interprocess::mapped_region region;
+};
+
+MappedArchive::MappedArchive(const boost::filesystem::path& path) : mapping_{std::make_unique<Mapping>()} {
+  namespace bip = boost::interprocess;
+  mapping_->file = bip::file_mapping(path.string().c_str(), bip::read_only);
+  mapping_->region = bip::mapped_region(mapping_->file, bip::read_only);
+  // Weights are touched in whatever order the program uses them; don't let the kernel read ahead of that.
+  mapping_->region.advise(bip::mapped_region::advice_random);
+
+  auto base = static_cast<const uint8_t*>(mapping_->region.get_address());
+  auto size = mapping_->region.get_size();
+  if (size < sizeof(kMagic) || std::memcmp(base, kMagic, sizeof(kMagic))) {
+    throw std::runtime_error(str(boost::format("Not a mapped archive: %1%") % path));
+  }
+  std::size_t pos = sizeof(kMagic);
+  auto count = ReadU64(base, size, &pos);
+  for (uint64_t i = 0; i < count; i++) {
+    auto name_size = ReadU64(base, size, &pos);
+    if (size < pos + name_size) {
+      throw std::runtime_error("Truncated mapped archive header");
+    }
+    std::string name(reinterpret_cast<const char*>(base + pos), name_size);
+    pos += name_size;
+    auto offset = ReadU64(base, size, &pos);
+    auto entry_size = ReadU64(base, size, &pos);
+    if (offset > size || size - offset < entry_size) {
+      throw std::runtime_error(str(boost::format("Mapped archive entry out of bounds: %1%") % name));
+    }
+    entries_[name] = Entry{base + offset, entry_size};
+  }
+}
+
+MappedArchive::~MappedArchive() = default;
+
+bool MappedArchive::IsMappedArchive(const boost::filesystem::path& path) {
+  std::ifstream file(path.string(), std::ios::binary);
+  char magic[sizeof(kMagic)];
+  return file.read(magic, sizeof(magic)) && !std::memcmp(magic, kMagic, sizeof(kMagic));
+}
+
+MappedArchive::Entry MappedArchive::Get(const std::string& name) const {
+  auto it = entries_.find(name);
+  if (it == entries_.end()) {
+    throw std::runtime_error("Could not locate file within mapped archive: " + name);
+  }
+  return it->second;
+}
+
+std::string MappedArchive::ReadString(const std::string& name) const {
+  auto entry = Get(name);
+  return std::string(reinterpret_cast<const char*>(entry.data), entry.size);
+}
+
+std::vector<std::string> MappedArchive::ListEntries() const {
+  std::vector<std::string> names;
+  for (const auto& kvp : entries_) {
+    names.push_back(kvp.first);
+  }
+  return names;
+}
+
+void MappedArchiveWriter::Add(const std::string& name, std::string payload, std::size_t aligned_offset) {
+  entries_.emplace_back(Pending{name, std::move(payload), aligned_offset});
+}
+
+void MappedArchiveWriter::Write(const boost::filesystem::path& path) const {
+  std::size_t header_size = sizeof(kMagic) + sizeof(uint64_t);
+  for (const auto& entry : entries_) {
+    header_size += 3 * sizeof(uint64_t) + entry.name.size();
+  }
+
+  std::vector<uint64_t> offsets;
+  std::size_t end = header_size;
+  for (const auto& entry : entries_) {
+    auto aligned = (end + entry.aligned_offset + kAlignment - 1) / kAlignment * kAlignment;
+    offsets.push_back(aligned - entry.aligned_offset);
+    end = offsets.back() + entry.payload.size();
+  }
+
+  std::string header(kMagic, sizeof(kMagic));
+  WriteU64(&header, entries_.size());
+  for (std::size_t i = 0; i < entries_.size(); i++) {
+    WriteU64(&header, entries_[i].name.size());
+    header += entries_[i].name;
+    WriteU64(&header, offsets[i]);
+    WriteU64(&header, entries_[i].payload.size());
+  }
+
+  std::ofstream file(path.string(), std::ios::binary | std::ios::trunc);
+  file.write(header.data(), header.size());
+  std::size_t pos = header.size();
+  for (std::size_t i = 0; i < entries_.size(); i++) {
+    file.write(std::string(offsets[i] - pos, '\0').data(), offsets[i] - pos);
+    file.write(entries_[i].payload.data(), entries_[i].payload.size());
+    pos = offsets[i] + entries_[i].payload.size();
+  }
+  if (!file) {
+    throw std::runtime_error(str(boost::format("Unable to write mapped archive: %1%") % path));
+  }
+}
+
+}  // namespace util
+}  // namespace tile
+}  // namespace vertexai
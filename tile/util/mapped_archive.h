@@ -0,0 +1,68 @@
+// Copyright 2020, Intel Corporation
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+namespace vertexai {
+namespace tile {
+namespace util {
+
+// A mapped archive is an uncompressed container of named entries, laid out so that it can be mmapped and its entries
+// used in place: the header holds a table of (name, offset, size), and each entry's payload is placed so that a chosen
+// offset within it lands on a page boundary.  Pages are only read from disk when an entry is first touched.
+class MappedArchive {
+ public:
+  struct Entry {
+    const uint8_t* data;
+    std::size_t size;
+  };
+
+  explicit MappedArchive(const boost::filesystem::path& path);
+  ~MappedArchive();
+
+  // Returns whether path starts with the mapped archive's magic number.
+  static bool IsMappedArchive(const boost::filesystem::path& path);
+
+  bool Exist(const std::string& name) const { return entries_.count(name) > 0; }
+  Entry Get(const std::string& name) const;
+  std::string ReadString(const std::string& name) const;
+
+  // Returns the entry names, in sorted order.
+  std::vector<std::string> ListEntries() const;
+
+ private:
+  struct Mapping;
+
+  std::unique_ptr<Mapping> mapping_;
+  std::map<std::string, Entry> entries_;
+};
+
+// Writes a mapped archive.  The payloads are buffered until Write, which lays them out.
+class MappedArchiveWriter {
+ public:
+  static constexpr std::size_t kAlignment = 4096;
+
+  // Adds an entry whose byte at aligned_offset is placed on a kAlignment boundary.
+  void Add(const std::string& name, std::string payload, std::size_t aligned_offset = 0);
+  void Write(const boost::filesystem::path& path) const;
+
+ private:
+  struct Pending {
+    std::string name;
+    std::string payload;
+    std::size_t aligned_offset;
+  };
+
+  std::vector<Pending> entries_;
+};
+
+}  // namespace util
+}  // namespace tile
+}  // namespace vertexai
@@ -3,6 +3,7 @@
 #include <google/protobuf/util/json_util.h>
 
 #include <algorithm>
+#include <cstring>
 #include <regex>
 #include <vector>
 
@@ -18,24 +19,47 @@ namespace util {
 
 namespace {
 
-std::shared_ptr<lang::TensorValue> ReadTensor(UnZipArchive* zip_file, const std::string& name) {
-  auto tensor_file = zip_file->OpenFile(name);
-
+// Tensor entries hold the size of the serialized shape, the shape, and then the tensor's bytes.
+TensorShape ParseShape(const void* entry, std::size_t size, std::size_t* data_offset) {
   uint64_t shape_size;
-  tensor_file.ReadInto(&shape_size, sizeof(shape_size));
-
-  std::string shape_buf(shape_size, '\0');
-  tensor_file.ReadInto(&shape_buf[0], shape_buf.size());
-
+  if (size < sizeof(shape_size)) {
+    throw std::runtime_error("Truncated tensor entry");
+  }
+  std::memcpy(&shape_size, entry, sizeof(shape_size));
   proto::TensorShape pb_shape;
-  pb_shape.ParseFromString(shape_buf);
-
-  auto tensor_shape = FromProto(pb_shape);
+  if (size - sizeof(shape_size) < shape_size ||
+      !pb_shape.ParseFromArray(static_cast<const char*>(entry) + sizeof(shape_size), shape_size)) {
+    throw std::runtime_error("Invalid tensor entry");
+  }
+  *data_offset = sizeof(shape_size) + shape_size;
+  return FromProto(pb_shape);
+}
 
+std::shared_ptr<lang::TensorValue> ReadTensor(UnZipArchive* archive, const std::shared_ptr<const MappedArchive>& mapped,
+                                              const std::string& name) {
   auto buffer = std::make_shared<SimpleBuffer>();
-  buffer->bytes.resize(tensor_shape.byte_size());
-  tensor_file.ReadInto(buffer->bytes.data(), buffer->bytes.size());
-
+  TensorShape tensor_shape;
+  if (mapped) {
+    auto entry = mapped->Get(name);
+    std::size_t data_offset;
+    tensor_shape = ParseShape(entry.data, entry.size, &data_offset);
+    if (entry.size - data_offset < tensor_shape.byte_size()) {
+      throw std::runtime_error("Truncated tensor entry: " + name);
+    }
+    buffer->mapping = mapped;
+    buffer->view = MappedArchive::Entry{entry.data + data_offset, tensor_shape.byte_size()};
+  } else {
+    auto tensor_file = archive->OpenFile(name);
+    uint64_t shape_size;
+    tensor_file.ReadInto(&shape_size, sizeof(shape_size));
+    std::string shape_buf(shape_size, '\0');
+    tensor_file.ReadInto(&shape_buf[0], shape_buf.size());
+    proto::TensorShape pb_shape;
+    pb_shape.ParseFromString(shape_buf);
+    tensor_shape = FromProto(pb_shape);
+    buffer->bytes.resize(tensor_shape.byte_size());
+    tensor_file.ReadInto(buffer->bytes.data(), buffer->bytes.size());
+  }
   return lang::TensorValue::make(buffer, tensor_shape, true);
 }
 
@@ -50,11 +74,23 @@ std::shared_ptr<lang::TensorValue> MakeTensor(const TensorShape& shape) {
 
 }  // namespace
 
-TileFile::TileFile(const boost::filesystem::path& path) : archive_(path.string()), path_(path) {}
+TileFile::TileFile(const boost::filesystem::path& path) : path_(path) {
+  if (MappedArchive::IsMappedArchive(path)) {
+    mapped_ = std::make_shared<MappedArchive>(path);
+  } else {
+    archive_ = std::make_unique<UnZipArchive>(path.string());
+  }
+}
+
+bool TileFile::Exist(const std::string& name) { return mapped_ ? mapped_->Exist(name) : archive_->Exist(name); }
+
+std::string TileFile::ReadString(const std::string& name) {
+  return mapped_ ? mapped_->ReadString(name) : archive_->OpenFile(name).ReadString();
+}
 
 lang::RunInfo TileFile::Load(const std::vector<std::shared_ptr<SimpleBuffer>>& inputs) {
   auto metadata = ReadMetadata();
-  auto code = archive_.OpenFile("code").ReadString();
+  auto code = ReadString("code");
 
   // This code was lifted from plaidml.cc/plaidml_load_function().
   lang::Parser parser;
@@ -72,10 +108,10 @@ lang::RunInfo TileFile::Load(const std::vector<std::shared_ptr<SimpleBuffer>>& i
   std::vector<std::shared_ptr<lang::TensorValue>> bound_inputs;
   for (const auto& input : dexified.inputs) {
     if (input.name[0] == '_') {
-      auto tensor = ReadTensor(&archive_, "data_" + input.name);
+      auto tensor = ReadTensor(archive_.get(), mapped_, "data_" + input.name);
       auto qparams_name = "qparams_" + input.name;
-      if (archive_.Exist(qparams_name)) {
-        tensor->attach_qparams(ReadTensor(&archive_, qparams_name));
+      if (Exist(qparams_name)) {
+        tensor->attach_qparams(ReadTensor(archive_.get(), mapped_, qparams_name));
       }
       bound_inputs.push_back(tensor);
     }
@@ -97,16 +133,16 @@ lang::RunInfo TileFile::Load(const std::vector<std::shared_ptr<SimpleBuffer>>& i
   for (size_t i = 0; i < num_inputs; i++) {
     std::string input_name = bound->input_name(i);
     auto shape = FromProto(metadata.inputs().at(input_name));
-    for (auto& dim : shape.dims) {
-      if (dim.size == 0) {
-        dim.size = 1;
+    for (size_t j = 0; j < shape.dims.size(); j++) {
+      if (shape.dims[j].size == 0) {
+        shape.dims.set_size(j, 1);
       }
     }
     if (i < inputs.size()) {
       const auto& buf = inputs.at(i);
-      if (buf->bytes.size() != shape.byte_size()) {
+      if (buf->size() != shape.byte_size()) {
         throw std::runtime_error(str(boost::format("Input buffer mismatch. Name: %s, Shape: %s, Size: %d") %
-                                     input_name % shape % buf->bytes.size()));
+                                     input_name % shape % buf->size()));
       }
       auto tensor = lang::TensorValue::make(buf, shape, false);
       applier.SetInput(input_name, tensor);
@@ -131,10 +167,9 @@ lang::RunInfo TileFile::Load(const std::vector<std::shared_ptr<SimpleBuffer>>& i
 }
 
 metadata::proto::Metadata TileFile::ReadMetadata() {
-  auto metadata_file = archive_.OpenFile("metadata");
   // This is a backwards compatiblity hack
   std::regex dims_re("dimensions");
-  auto metadata_coded = std::regex_replace(metadata_file.ReadString(), dims_re, "dims");
+  auto metadata_coded = std::regex_replace(ReadString("metadata"), dims_re, "dims");
   metadata::proto::Metadata metadata;
   if (!::google::protobuf::util::JsonStringToMessage(metadata_coded, &metadata).ok()) {
     throw std::runtime_error("Unable to parse benchmark metadata");
@@ -152,12 +187,36 @@ std::vector<float> TileFile::GetTensorFloatData(const metadata::proto::Tensor& t
   std::size_t size = d0.stride() * d0.size();
   result.resize(size);
 
-  auto tensor_file = archive_.OpenFile(tensor.filename());
-  tensor_file.ReadInto(result.data(), size * sizeof(float));
+  if (mapped_) {
+    auto entry = mapped_->Get(tensor.filename());
+    if (entry.size < size * sizeof(float)) {
+      throw std::runtime_error("Truncated tensor data: " + tensor.filename());
+    }
+    std::memcpy(result.data(), entry.data, size * sizeof(float));
+  } else {
+    auto tensor_file = archive_->OpenFile(tensor.filename());
+    tensor_file.ReadInto(result.data(), size * sizeof(float));
+  }
 
   return result;
 }
 
+void TileFile::WriteMapped(const boost::filesystem::path& path) {
+  if (mapped_) {
+    throw std::runtime_error("Tile file is already a mapped archive: " + path_.string());
+  }
+  MappedArchiveWriter writer;
+  for (const auto& name : archive_->ListFiles()) {
+    auto payload = ReadString(name);
+    std::size_t aligned_offset = 0;
+    if (name.rfind("data_", 0) == 0 || name.rfind("qparams_", 0) == 0) {
+      ParseShape(payload.data(), payload.size(), &aligned_offset);
+    }
+    writer.Add(name, std::move(payload), aligned_offset);
+  }
+  writer.Write(path);
+}
+
 }  // namespace util
 }  // namespace tile
 }  // namespace vertexai
@@ -9,15 +9,25 @@
 #include "base/util/zipfile.h"
 #include "tile/lang/runinfo.h"
 #include "tile/proto/metadata.pb.h"
+#include "tile/util/mapped_archive.h"
 
 namespace vertexai {
 namespace tile {
 namespace util {
 
+// A buffer's contents are either its own bytes, or a read-only view into a mapped tile file which the buffer keeps
+// alive.
 struct SimpleBuffer : lang::BufferBase {
   std::vector<uint8_t> bytes;
+  std::shared_ptr<const MappedArchive> mapping;
+  MappedArchive::Entry view{nullptr, 0};
+
+  const uint8_t* data() const { return mapping ? view.data : bytes.data(); }
+  std::size_t size() const { return mapping ? view.size : bytes.size(); }
 };
 
+// A tile file is either a zip archive, or a mapped archive (see MappedArchive) holding the same entries.  Tensors
+// loaded from a mapped archive aren't copied: their buffers view the mapping, and are paged in on first use.
 class TileFile {
  public:
   explicit TileFile(const boost::filesystem::path& path);
@@ -26,8 +36,15 @@ class TileFile {
   metadata::proto::Metadata ReadMetadata();
   std::vector<float> GetTensorFloatData(const metadata::proto::Tensor& tensor);
 
+  // Writes this file's entries as a mapped archive, with each tensor's data page-aligned.
+  void WriteMapped(const boost::filesystem::path& path);
+
  private:
-  UnZipArchive archive_;
+  bool Exist(const std::string& name);
+  std::string ReadString(const std::string& name);
+
+  std::unique_ptr<UnZipArchive> archive_;
+  std::shared_ptr<const MappedArchive> mapped_;
   boost::filesystem::path path_;
 };
 
@@ -111,7 +111,7 @@ int main(int argc, char* argv[]) {
       return 1;
     }
     if (args.count("verbose")) {
-      el::Loggers::setVerboseLevel(args["verbose"].as<int>());
+      SetVerbosity(args["verbose"].as<int>());
     }
     args.notify();
 
@@ -0,0 +1,137 @@
+// Copyright 2019, Intel Corporation
+
+// Measures the throughput of libxsmm's small GEMM kernels over a grid of
+// (M, N, K) tile shapes on the host, and writes the results as a heatmap the
+// CPU backend loads at startup (see HostHeatmap in tile/targets/cpu/heatmap.h)
+// or that the heatmap rule can bake into the build.
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+
+#include "base/util/logging.h"
+#include "base/util/throw.h"
+#include "libxsmm.h"  // NOLINT
+#include "tile/targets/cpu/heatmap.h"
+
+namespace fs = boost::filesystem;
+namespace po = boost::program_options;
+
+namespace vertexai {
+namespace tools {
+
+using tile::targets::cpu::Heatmap;
+
+double MeasureGflops(unsigned m, unsigned n, unsigned k, double min_seconds) {
+  // Leading dimensions as the CPU backend calls these kernels on blocked
+  // (tile-contiguous) data.
+  libxsmm_blasint lda = m;
+  libxsmm_blasint ldb = k;
+  libxsmm_blasint ldc = m;
+  float alpha = 1.0f;
+  float beta = 1.0f;
+  auto kernel = libxsmm_smmdispatch(m, n, k, &lda, &ldb, &ldc, &alpha, &beta, nullptr, nullptr);
+  if (!kernel) {
+    return 0;
+  }
+  std::vector<float> a(m * k, 1.0f);
+  std::vector<float> b(k * n, 1.0f);
+  std::vector<float> c(m * n, 0.0f);
+  // Warm up the caches, then double the batch until it runs long enough to
+  // time reliably.
+  kernel(a.data(), b.data(), c.data());
+  size_t iterations = 16;
+  for (;;) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+      kernel(a.data(), b.data(), c.data());
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    if (elapsed.count() >= min_seconds) {
+      return 2.0 * m * n * k * iterations / elapsed.count() / 1e9;
+    }
+    iterations *= 2;
+  }
+}
+
+void Calibrate(const po::variables_map& args) {
+  auto min_size = args["min"].as<unsigned>();
+  auto max_size = args["max"].as<unsigned>();
+  auto step = args["step"].as<unsigned>();
+  auto min_seconds = args["seconds"].as<double>();
+  if (!step || min_size > max_size) {
+    throw std::runtime_error("Invalid tile size range");
+  }
+  fs::path out;
+  if (args.count("out")) {
+    out = args["out"].as<fs::path>();
+  } else {
+    out = fs::path(args["out_dir"].as<fs::path>()) / (tile::targets::cpu::HostCpuKey() + ".csv");
+  }
+  libxsmm_init();
+  Heatmap heatmap;
+  for (unsigned m = min_size; m <= max_size; m += step) {
+    for (unsigned n = min_size; n <= max_size; n += step) {
+      for (unsigned k = min_size; k <= max_size; k += step) {
+        heatmap[std::make_tuple(m, n, k)] = MeasureGflops(m, n, k, min_seconds);
+      }
+    }
+    IVLOG(1, "Calibrated M=" << m);
+  }
+  libxsmm_finalize();
+  if (out.has_parent_path()) {
+    fs::create_directories(out.parent_path());
+  }
+  tile::targets::cpu::SaveHeatmap(heatmap, out);
+  std::cout << "Wrote " << heatmap.size() << " entries to " << out.string() << std::endl;
+}
+
+}  // namespace tools
+}  // namespace vertexai
+
+int main(int argc, char* argv[]) {
+  try {
+    START_EASYLOGGINGPP(argc, argv);
+
+    po::options_description opts{"Allowed options"};
+    opts.add_options()                                                                  //
+        ("help,h", "produce help message")                                                 //
+        ("verbose,v", po::value<int>()->default_value(0), "increase verbosity")            //
+        ("min", po::value<unsigned>()->default_value(2), "smallest tile dimension")        //
+        ("max", po::value<unsigned>()->default_value(100), "largest tile dimension")       //
+        ("step", po::value<unsigned>()->default_value(2), "tile dimension increment")      //
+        ("seconds", po::value<double>()->default_value(0.001), "minimum time per shape")  //
+        ("out_dir",                                                                        //
+         po::value<fs::path>()->default_value(fs::current_path()),                         //
+         "directory for <cpu>.csv, as searched via PLAIDML_CPU_HEATMAP_DIR")               //
+        ("out", po::value<fs::path>(), "explicit output path");
+
+    po::variables_map args;
+    po::store(po::parse_command_line(argc, argv, opts), args);
+    if (args.count("help")) {
+      std::cout << opts << std::endl;
+      return 1;
+    }
+    if (args.count("verbose")) {
+      SetVerbosity(args["verbose"].as<int>());
+    }
+    args.notify();
+
+    vertexai::tools::Calibrate(args);
+
+    return 0;
+  } catch (const std::exception& ex) {
+    std::cerr << "Caught unhandled exception: " << ex.what() << std::endl;
+    auto stacktrace = boost::get_error_info<traced>(ex);
+    if (stacktrace) {
+      std::cerr << *stacktrace << std::endl;
+    }
+    return -1;
+  } catch (...) {
+    std::cerr << "Caught unhandled exception" << std::endl;
+    return -1;
+  }
+}
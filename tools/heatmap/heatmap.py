@@ -17,7 +17,10 @@ if __name__ == "__main__":
     parser.add_argument('out')
     args = parser.parse_args()
 
-    with gzip.open(args.csv) as fp:
+    # Accept both the checked-in (gzipped) heatmaps and the plain CSV the
+    # calibrate tool writes.
+    opener = gzip.open if args.csv.endswith('.gz') else open
+    with opener(args.csv, 'rb') as fp:
         lines = fp.read().decode().splitlines()
     reader = csv.DictReader(lines)
     data = list(reader)